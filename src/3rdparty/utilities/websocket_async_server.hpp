@@ -328,15 +328,21 @@ private:
                         }
                     }
 
-                    // write message
+                    // write acknowledgement, then read the next message
                     d.state = 1;
                     d.ws.set_option(beast::websocket::message_type(beast::websocket::opcode::text));
-                    d.ws.write(boost::asio::buffer(std::string("OK!")));
+                    d.ws.async_write(boost::asio::buffer(ack()), d.strand.wrap(std::move(*this)));
                     return;
             }
         }
 
     private:
+        static const std::string& ack()
+        {
+            static const std::string ok("OK!");
+            return ok;
+        }
+
         void fail(std::string what, error_code ec)
         {
             auto& d = *d_;
@@ -0,0 +1,261 @@
+/*! -*-c++-*-
+  @file   acfdistill.cpp
+  @author David Hirvonen
+  @brief  Distill a smaller ACF soft cascade from an existing detector.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The teacher labels the windows of FDDB images and/or logged frames, every k-th image
+  is held out to compare the student with the teacher (time per image, recall of the
+  teacher detections and, with FDDB annotations, recall of the ground truth faces).
+
+*/
+
+#include "drishti/ml/AcfDistiller.h"
+#include "drishti/ml/ObjectDetector.h"
+#include "drishti/core/Logger.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/testlib/drishti_cli.h"
+
+#include "FDDB.h"
+#include "cxxopts.hpp"
+
+#include <acf/ACF.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace bfs = boost::filesystem;
+
+struct Sample
+{
+    std::string filename;
+    std::vector<cv::Rect> faces; // FDDB annotations (if any)
+};
+
+// FDDB ellipse to face roi (see fddbcrop.cpp):
+static cv::Rect ellipseToRoi(const std::vector<double>& e)
+{
+    cv::RotatedRect ellipse(cv::Point2d(e[3], e[4]), cv::Size2d(e[0] * 2.0, e[1] * 2.0), e[2] * 180.0 / M_PI);
+    const float r = ((ellipse.size.width + ellipse.size.height) * 0.25f) * 0.75f;
+    cv::Point2f v(std::cos(e[2]), std::sin(e[2])), c = ellipse.center + (v * ((0 < v.y) - (v.y < 0)) * ellipse.size.height * 0.2);
+    return { cv::Point(c) - cv::Point(r, r), cv::Point(c) + cv::Point(r, r) };
+}
+
+static float overlap(const cv::Rect& a, const cv::Rect& b)
+{
+    const float intersection = static_cast<float>((a & b).area());
+    return intersection / static_cast<float>(a.area() + b.area() - intersection);
+}
+
+// Number of reference boxes matched by a detection with IoU >= 0.5:
+static int countMatches(const std::vector<cv::Rect>& reference, const std::vector<cv::Rect>& detections)
+{
+    int count = 0;
+    for (const auto& r : reference)
+    {
+        count += std::any_of(detections.begin(), detections.end(), [&](const cv::Rect& d) { return overlap(r, d) >= 0.5f; });
+    }
+    return count;
+}
+
+// Channel pyramid in model storage order (see EyeDetector::getPyramid()):
+static void computePyramid(acf::Detector& detector, const cv::Mat3b& image, acf::Detector::Pyramid& P)
+{
+    cv::Mat3b rgb, It;
+    cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
+    if (!detector.getIsRowMajor())
+    {
+        cv::transpose(rgb, It);
+    }
+    else
+    {
+        It = rgb;
+    }
+
+    cv::Mat3f Itf;
+    It.convertTo(Itf, CV_32FC3, 1.0 / 255.0);
+    detector.setIsLuv(false);
+    detector.computePyramid(MatP(Itf), P);
+}
+
+// Detections (image coordinates) with the acf "maxg" suppression, returns the cascade time:
+static double detect(const drishti::ml::AcfCascade& cascade, const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects)
+{
+    std::vector<double> scores;
+    const auto start = std::chrono::high_resolution_clock::now();
+    cascade(P, objects, scores);
+    const auto stop = std::chrono::high_resolution_clock::now();
+
+    drishti::ml::ObjectDetector::suppress(objects, scores, 0.65, 0, true);
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-acf-distill");
+
+    std::string sTeacher, sOutput, sInput, sFddb, sFddbDir;
+    drishti::ml::AcfDistiller::Settings settings;
+    int holdout = 10;
+    unsigned int seed = 0;
+    int maxWindows = static_cast<int>(settings.maxWindows);
+
+    cxxopts::Options options("drishti-acf-distill", "Distill a smaller ACF soft cascade from a teacher detector");
+
+    // clang-format off
+    options.add_options()
+        ("t,teacher", "Teacher ACF model", cxxopts::value<std::string>(sTeacher))
+        ("o,output", "Student cascade (cpb)", cxxopts::value<std::string>(sOutput))
+        ("i,input", "Logged frames (image or list)", cxxopts::value<std::string>(sInput))
+        ("fddb", "FDDB ellipse list", cxxopts::value<std::string>(sFddb))
+        ("fddb-dir", "FDDB image directory", cxxopts::value<std::string>(sFddbDir))
+        ("trees", "Student trees", cxxopts::value<int>(settings.trees))
+        ("depth", "Student tree depth", cxxopts::value<int>(settings.depth))
+        ("recall", "Retained fraction of teacher windows", cxxopts::value<float>(settings.recall))
+        ("margin", "Teacher score margin for hard windows", cxxopts::value<float>(settings.margin))
+        ("negatives", "Random easy windows per image", cxxopts::value<int>(settings.negatives))
+        ("max-windows", "Maximum training windows", cxxopts::value<int>(maxWindows))
+        ("holdout", "Hold out every k-th image for evaluation", cxxopts::value<int>(holdout))
+        ("seed", "Random seed", cxxopts::value<unsigned int>(seed))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    auto parseResult = options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || parseResult.count("help"))
+    {
+        logger->info(options.help({ "" }));
+        return 0;
+    }
+
+    if (sTeacher.empty() || sOutput.empty() || (sInput.empty() && sFddb.empty()))
+    {
+        logger->error("Must specify a teacher, an output and training images");
+        return 1;
+    }
+
+    settings.maxWindows = static_cast<std::size_t>(std::max(maxWindows, 1));
+    settings.seed = seed;
+
+    std::vector<Sample> samples;
+    if (!sFddb.empty())
+    {
+        for (const auto& r : parseFDDB(sFddb))
+        {
+            Sample sample{ (bfs::path(sFddbDir) / r.filename).replace_extension(".jpg").string(), {} };
+            for (const auto& e : r.ellipses)
+            {
+                sample.faces.push_back(ellipseToRoi(e.first));
+            }
+            samples.push_back(sample);
+        }
+    }
+    if (!sInput.empty())
+    {
+        for (const auto& filename : drishti::cli::expand(sInput))
+        {
+            samples.push_back({ filename, {} });
+        }
+    }
+
+    acf::Detector teacher(sTeacher);
+    if (!teacher.good())
+    {
+        logger->error("Failed to load teacher {}", sTeacher);
+        return 1;
+    }
+
+    drishti::ml::AcfDistiller distiller(teacher, settings);
+
+    bool isFull = false; // maxWindows
+    std::vector<std::size_t> evaluation;
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        if ((holdout > 0) && ((i % holdout) == 0))
+        {
+            evaluation.push_back(i);
+            continue;
+        }
+        else if (isFull)
+        {
+            continue;
+        }
+
+        cv::Mat3b image = cv::imread(samples[i].filename, cv::IMREAD_COLOR);
+        if (image.empty())
+        {
+            logger->warn("Failed to read {}", samples[i].filename);
+            continue;
+        }
+
+        acf::Detector::Pyramid P;
+        computePyramid(teacher, image, P);
+        isFull = !distiller.add(P);
+    }
+
+    logger->info("Training on {} windows ({} accepted by the teacher)", distiller.size(), distiller.getAcceptedCount());
+    auto student = distiller.train();
+    save_cpb(sOutput, *student);
+
+    // Compare with the teacher on the held out images:
+    const drishti::ml::AcfCascade reference(teacher, student->getSimdStages());
+
+    double teacherTime = 0.0, studentTime = 0.0;
+    int images = 0, teacherCount = 0, teacherMatches = 0, truthCount = 0, teacherTruth = 0, studentTruth = 0;
+    for (const auto& i : evaluation)
+    {
+        cv::Mat3b image = cv::imread(samples[i].filename, cv::IMREAD_COLOR);
+        if (image.empty())
+        {
+            continue;
+        }
+
+        acf::Detector::Pyramid P;
+        computePyramid(teacher, image, P);
+
+        std::vector<cv::Rect> fromTeacher, fromStudent;
+        teacherTime += detect(reference, P, fromTeacher);
+        studentTime += detect(*student, P, fromStudent);
+
+        images++;
+        teacherCount += static_cast<int>(fromTeacher.size());
+        teacherMatches += countMatches(fromTeacher, fromStudent);
+        truthCount += static_cast<int>(samples[i].faces.size());
+        teacherTruth += countMatches(samples[i].faces, fromTeacher);
+        studentTruth += countMatches(samples[i].faces, fromStudent);
+    }
+
+    logger->info("Teacher: {} trees depth {}, student: {} trees depth {}", reference.getTrees().hs.size() / std::max(reference.getTrees().nodes, 1), reference.getTrees().depth, settings.trees, settings.depth);
+    if (images)
+    {
+        logger->info("Cascade time per image: teacher {} ms student {} ms", 1e3 * teacherTime / images, 1e3 * studentTime / images);
+        logger->info("Recall of teacher detections: {} ({}/{})", teacherCount ? float(teacherMatches) / teacherCount : 1.f, teacherMatches, teacherCount);
+    }
+    if (truthCount)
+    {
+        logger->info("Recall of FDDB faces: teacher {} student {}", float(teacherTruth) / truthCount, float(studentTruth) / truthCount);
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
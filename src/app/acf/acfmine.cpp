@@ -0,0 +1,183 @@
+/*! -*-c++-*-
+  @file   acfmine.cpp
+  @author David Hirvonen
+  @brief  Mine hard negatives of an ACF detector for retraining.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Face free images are streamed in batches, each worker thread computes the pyramids of
+  its share of the batch with its own detector instance and passes them to one shared
+  AcfNegativeMiner (see AcfNegativeMiner.h), so only a batch of images and the bounded
+  heap of hardest windows are in memory at any time.  The shard (cpb) holds the channel
+  features of the hardest windows, their scores and their source images.
+
+*/
+
+#include "drishti/ml/AcfNegativeMiner.h"
+#include "drishti/core/Logger.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/testlib/drishti_cli.h"
+
+#include "cxxopts.hpp"
+
+#include <acf/ACF.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+// Channel pyramid in model storage order (see acfdistill.cpp):
+static void computePyramid(acf::Detector& detector, const cv::Mat3b& image, acf::Detector::Pyramid& P)
+{
+    cv::Mat3b rgb, It;
+    cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
+    if (!detector.getIsRowMajor())
+    {
+        cv::transpose(rgb, It);
+    }
+    else
+    {
+        It = rgb;
+    }
+
+    cv::Mat3f Itf;
+    It.convertTo(Itf, CV_32FC3, 1.0 / 255.0);
+    detector.setIsLuv(false);
+    detector.computePyramid(MatP(Itf), P);
+}
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-acf-mine");
+
+    std::string sModel, sOutput, sInput, sList;
+    drishti::ml::AcfNegativeMiner::Settings settings;
+    int maxSamples = static_cast<int>(settings.maxSamples);
+    int threads = 0;
+    int batch = 256;
+    int width = 0;
+
+    cxxopts::Options options("drishti-acf-mine", "Mine hard negatives of an ACF detector");
+
+    // clang-format off
+    options.add_options()
+        ("m,model", "ACF model", cxxopts::value<std::string>(sModel))
+        ("i,input", "Negative images (image or list)", cxxopts::value<std::string>(sInput))
+        ("o,output", "Sample shard (cpb)", cxxopts::value<std::string>(sOutput))
+        ("l,list", "Optional list of the mined windows (image x y width height score)", cxxopts::value<std::string>(sList))
+        ("margin", "Keep windows scoring above the cascade threshold minus margin", cxxopts::value<float>(settings.margin))
+        ("per-image", "Hardest windows per image (0 == all)", cxxopts::value<int>(settings.perImage))
+        ("max-samples", "Hardest windows overall", cxxopts::value<int>(maxSamples))
+        ("overlap", "IoU of duplicate windows", cxxopts::value<float>(settings.overlap))
+        ("width", "Downscale wider images to this width (0 == off)", cxxopts::value<int>(width))
+        ("batch", "Images per batch", cxxopts::value<int>(batch))
+        ("t,threads", "Worker threads (0 == cores)", cxxopts::value<int>(threads))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    auto parseResult = options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || parseResult.count("help"))
+    {
+        logger->info(options.help({ "" }));
+        return 0;
+    }
+
+    if (sModel.empty() || sOutput.empty() || sInput.empty())
+    {
+        logger->error("Must specify a model, an output and negative images");
+        return 1;
+    }
+
+    settings.maxSamples = static_cast<std::size_t>(std::max(maxSamples, 1));
+    threads = (threads > 0) ? threads : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    batch = std::max(batch, threads);
+
+    const auto filenames = drishti::cli::expand(sInput);
+
+    // Detectors aren't shared between threads (pyramid options are mutable):
+    std::vector<std::unique_ptr<acf::Detector>> detectors;
+    for (int i = 0; i < threads; i++)
+    {
+        detectors.emplace_back(drishti::core::make_unique<acf::Detector>(sModel));
+        if (!detectors.back()->good())
+        {
+            logger->error("Failed to load model {}", sModel);
+            return 1;
+        }
+    }
+
+    drishti::ml::AcfNegativeMiner miner(*detectors.front(), settings);
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t first = 0; first < filenames.size(); first += batch)
+    {
+        const std::size_t last = std::min(first + batch, filenames.size());
+
+        // Thread t mines images first + t, first + t + threads, ...:
+        drishti::core::ParallelHomogeneousLambda harness = [&](int t) {
+            for (std::size_t i = first + t; i < last; i += threads)
+            {
+                cv::Mat3b image = cv::imread(filenames[i], cv::IMREAD_COLOR);
+                if (image.empty())
+                {
+                    logger->warn("Failed to read {}", filenames[i]);
+                    continue;
+                }
+                if ((width > 0) && (image.cols > width))
+                {
+                    cv::resize(image, image, { width, image.rows * width / image.cols }, 0.0, 0.0, cv::INTER_AREA);
+                }
+
+                acf::Detector::Pyramid P;
+                computePyramid(*detectors[t], image, P);
+                miner.add(static_cast<std::uint32_t>(i), P);
+            }
+        };
+
+        cv::parallel_for_({ 0, threads }, harness, threads);
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        logger->info("{}/{} images ({} images/s): {} windows above the threshold, {} kept (weakest score {})",
+            last, filenames.size(), static_cast<double>(last) / std::max(elapsed, 1e-6),
+            miner.getCandidateCount(), miner.size(), miner.getMinimumScore());
+    }
+
+    auto shard = miner.getShard();
+    save_cpb(sOutput, shard);
+    logger->info("Wrote {} windows ({} features each) from {} images to {}", shard.size(), shard.features, miner.getImageCount(), sOutput);
+
+    if (!sList.empty())
+    {
+        std::ofstream ofs(sList);
+        for (std::size_t i = 0; i < shard.size(); i++)
+        {
+            const auto& roi = shard.rois[i];
+            ofs << filenames[shard.images[i]] << " " << roi.x << " " << roi.y << " " << roi.width << " " << roi.height << " " << shard.scores[i] << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
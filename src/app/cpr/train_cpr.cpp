@@ -131,6 +131,7 @@ int gauze_main(int argc, char** argv)
     int T = 0; // # of stages
     int L = 4; // oversampling
     int F = 200;
+    int memoryLimit = 0; // MB
 
     // TODO: support generic ellipse regression (no iris assumption)
     const bool doIris = true;
@@ -157,6 +158,7 @@ int gauze_main(int argc, char** argv)
         ( "silent", "Disable logging entirely.", cxxopts::value<bool>(doSilent) )
         ( "pupil", "Train on pupil (else iris)", cxxopts::value<bool>(doPupil))
         ( "width", "Target width for training", cxxopts::value<int>(targetWidth))
+        ( "memory", "Approximate training matrix memory limit in MB (0 == unlimited)", cxxopts::value<int>(memoryLimit))
     
 #if defined(DRISHTI_USE_IMSHOW)        
         ( "window", "Do window", cxxopts::value<bool>(doWindow) )
@@ -314,6 +316,7 @@ int gauze_main(int argc, char** argv)
             // clang-on
             cpr.setViewer(viewer);
         }
+        cpr.setTrainingMemoryLimit(std::size_t(memoryLimit) << 20);
         cpr.cprTrain(train.samples.images, train.samples.ellipses[int(doPupil)], train.samples.H, cprPrm, true);
 
         // Dump the model:
@@ -334,12 +337,12 @@ int gauze_main(int argc, char** argv)
         for (int i = 0; i < test.samples.images.size(); i++)
         {
             drishti::rcpr::CPR::CPRResult result;
-            cpr.cprApplyTree(test.samples.images[i], *cpr.regModel, *(cpr.regModel->pStar), result);
+            cpr.cprApplyTree(test.samples.images[i], *cpr.regModel, drishti::rcpr::toPhi(*(cpr.regModel->pStar)), result);
 
             // Measure error at each stage:
             for (int t = 0; t < T; t++)
             {
-                errors[t] += drishti::rcpr::dist(*cprPrm.model, result.pAll[t], test.samples.ellipses[0][i]);
+                errors[t] += drishti::rcpr::dist(*cprPrm.model, drishti::rcpr::toVector1d(result.pAll[t]), test.samples.ellipses[0][i]);
             }
 
 #if defined(DRISHTI_USE_IMSHOW) && TRAIN_CPR_DEBUG_LOAD
@@ -457,8 +460,8 @@ void EllipseSamples::load(const std::string& filename, int targetWidth, const st
             const float scale = float(targetWidth) / I.cols;
             const cv::Matx33f S(cv::Matx33f::diag({ scale, scale, 1.f }));
 
-            ellipse1 = drishti::rcpr::ellipseToPhi(S * e1);
-            ellipse2 = drishti::rcpr::ellipseToPhi(S * e2);
+            ellipse1 = drishti::rcpr::toVector1d(drishti::rcpr::ellipseToPhi(S * e1));
+            ellipse2 = drishti::rcpr::toVector1d(drishti::rcpr::ellipseToPhi(S * e2));
 
             for (int j = 0; j < 5; j++)
             {
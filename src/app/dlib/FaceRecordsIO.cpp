@@ -0,0 +1,80 @@
+/*! -*-c++-*-
+  @file   FaceRecordsIO.cpp
+  @author David Hirvonen
+  @brief  Load record file shards (landmarks/FaceRecords.h) as dlib shape_predictor datasets.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "FaceRecordsIO.h"
+
+#include "landmarks/FaceRecords.h"
+#include "drishti/testlib/drishti_cli.h"
+
+#include <dlib/image_transforms/assign_image.h>
+#include <dlib/opencv/cv_image.h>
+
+#include <cmath>
+
+DRISHTI_BEGIN_NAMESPACE(drishti)
+DRISHTI_BEGIN_NAMESPACE(dlib)
+
+bool is_face_records(const std::string& filename)
+{
+    const auto shards = drishti::cli::expand(filename);
+    return !shards.empty() && FACE::FaceRecordReader::isRecordFile(shards.front());
+}
+
+bool load_face_records(
+    ::dlib::array<::dlib::array2d<uint8_t>>& images,
+    std::vector<std::vector<::dlib::full_object_detection>>& objects,
+    const std::string& filename,
+    bool skip_empty,
+    int threads)
+{
+    FACE::FaceRecordDataset dataset;
+    if (!is_face_records(filename) || !dataset.open(drishti::cli::expand(filename)))
+    {
+        return false;
+    }
+
+    // Decode into place, then compact (skipped records are left empty):
+    ::dlib::array<::dlib::array2d<uint8_t>> decoded;
+    decoded.resize(dataset.size());
+    std::vector<std::vector<::dlib::full_object_detection>> shapes(dataset.size());
+
+    dataset.parallel([&](std::size_t i, FACE::FaceRecord& record) {
+        if (record.image.empty() || (skip_empty && record.points.empty()))
+        {
+            return;
+        }
+
+        const cv::Rect roi = record.roi.area() ? record.roi : cv::Rect({ 0, 0 }, record.image.size());
+        std::vector<::dlib::point> points;
+        for (const auto& p : record.points)
+        {
+            points.emplace_back(std::lround(p.x), std::lround(p.y));
+        }
+
+        ::dlib::assign_image(decoded[i], ::dlib::cv_image<uint8_t>(record.image));
+        shapes[i] = { ::dlib::full_object_detection(::dlib::rectangle(roi.x, roi.y, roi.br().x - 1, roi.br().y - 1), points) };
+    },
+        cv::IMREAD_GRAYSCALE,
+        threads);
+
+    for (std::size_t i = 0; i < shapes.size(); i++)
+    {
+        if (!shapes[i].empty())
+        {
+            images.push_back(decoded[i]);
+            objects.push_back(std::move(shapes[i]));
+        }
+    }
+
+    return true;
+}
+
+DRISHTI_END_NAMESPACE(dlib)
+DRISHTI_END_NAMESPACE(drishti)
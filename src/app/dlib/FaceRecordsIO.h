@@ -0,0 +1,42 @@
+/*! -*-c++-*-
+  @file   FaceRecordsIO.h
+  @author David Hirvonen
+  @brief  Load record file shards (landmarks/FaceRecords.h) as dlib shape_predictor datasets.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_dlib_FaceRecordsIO_h__
+#define __drishti_dlib_FaceRecordsIO_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <dlib/array.h>
+#include <dlib/array2d.h>
+#include <dlib/image_processing/full_object_detection.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+DRISHTI_BEGIN_NAMESPACE(drishti)
+DRISHTI_BEGIN_NAMESPACE(dlib)
+
+// True for a record file or a list (*.txt) of record file shards:
+bool is_face_records(const std::string& filename);
+
+// Returns false if filename is neither a record file nor a list (*.txt) of record file shards.
+// Records are decoded in parallel (grayscale), one object per image in record order.
+bool load_face_records(
+    ::dlib::array<::dlib::array2d<uint8_t>>& images,
+    std::vector<std::vector<::dlib::full_object_detection>>& objects,
+    const std::string& filename,
+    bool skip_empty = true,
+    int threads = -1);
+
+DRISHTI_END_NAMESPACE(dlib)
+DRISHTI_END_NAMESPACE(drishti)
+
+#endif // __drishti_dlib_FaceRecordsIO_h__
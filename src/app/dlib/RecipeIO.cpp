@@ -35,6 +35,12 @@ void loadJSON(const std::string& filename, drishti::dlib::Recipe& recipe)
         
         // Per parameter weighting
         try { recipe.weights = json["weights"].get<std::map<std::string, float>>(); } catch(...) {}
+
+        // Per cascade level image octave
+        try { recipe.octaves = json["octaves"].get<std::vector<int>>(); } catch(...) {}
+
+        // Subset model parts
+        try { recipe.landmarks = json["landmarks"].get<std::vector<int>>(); } catch(...) {}
     }
     else
     {
@@ -69,6 +75,12 @@ void saveJSON(const std::string& filename, const drishti::dlib::Recipe& recipe)
         // Per parameter weighting
         try { json["weights"] = recipe.weights; } catch(...) {}
 
+        // Per cascade level image octave
+        json["octaves"] = recipe.octaves;
+
+        // Subset model parts
+        json["landmarks"] = recipe.landmarks;
+
         os << json.dump(4);
     }
     else
@@ -38,6 +38,12 @@ struct Recipe
     int width = 0;
     bool do_pca = true;
     std::vector<int> dimensions;
+
+    // Per cascade level image octave (0 == full resolution, 1 == half, ...):
+    std::vector<int> octaves;
+
+    // (optional) subset model, annotation parts to regress (empty == all parts):
+    std::vector<int> landmarks;
     
     // Sparse weights, assume 1.0 for all non missing entries:
     std::map<std::string,float> weights = { {"0", 1.0f}, {"8", 1.0f} };
@@ -16,6 +16,7 @@
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
 #include "drishti/core/string_utils.h"
 
 #include "landmarks/DlibXML.h"
@@ -263,7 +264,10 @@ int gauze_main(int argc, char** argv)
     }
     else
     {
-        cv::parallel_for_({ 0, static_cast<int>(filenames.size()) }, harness, std::max(threads, -1));
+        drishti::core::ParallelSettings settings;
+        settings.threads = threads;
+        settings.grain = 1;
+        drishti::core::parallelFor({ 0, static_cast<int>(filenames.size()) }, harness, settings);
     }
 
     if (number > 0)
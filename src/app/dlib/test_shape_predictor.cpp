@@ -24,11 +24,16 @@
 #include "drishti/core/Line.h"
 #include "drishti/core/string_utils.h"
 #include "drishti/ml/shape_predictor_archive.h"
+#include "drishti/ml/shape_predictor_trainer.h" // measure_tree_statistics(), prune_trees()
 #include "drishti/testlib/drishti_cli.h"
 
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
 
+#if defined(DRISHTI_BUILD_FACE)
+#  include "FaceRecordsIO.h"
+#endif
+
 #include "cxxopts.hpp"
 
 #include <iostream>
@@ -36,6 +41,19 @@
 std::vector<std::vector<double>>
 get_interocular_distances(const std::vector<std::vector<dlib::full_object_detection>>& objects);
 
+// Largest distance between any two landmarks (scale independent of the landmark layout):
+static double max_extent(const dlib::full_object_detection& det)
+{
+    double length = 0;
+    for(int i = 0; i < det.num_parts(); i++)
+        for(int j = i+1; j < det.num_parts(); j++)
+        {
+            length = std::max(double(dlib::length(det.part(i) - det.part(j))), length);
+        }
+
+    return length;
+}
+
 cv::Point cv_point(const dlib::point& p)
 {
     return cv::Point(p.x(), p.y());
@@ -66,6 +84,9 @@ int mine(int argc, char* argv[])
     bool doHelp = false;
     std::string sInput;
     std::string sModel;
+    std::string sQuantized;
+    std::string sPruned;
+    float keep = 0.5f;
 
     cxxopts::Options options("train_shape_predictor", "Command line interface for dlib shape_predictor training");
 
@@ -73,6 +94,9 @@ int mine(int argc, char* argv[])
     options.add_options()
         ( "input", "Input filename list", cxxopts::value<std::string>(sInput))
         ( "model", "Model filename", cxxopts::value<std::string>(sModel))
+        ( "quantize", "Write an 8-bit quantized model and report the accuracy loss", cxxopts::value<std::string>(sQuantized))
+        ( "prune", "Write a model with the least important trees of each level removed", cxxopts::value<std::string>(sPruned))
+        ( "keep", "Fraction of the trees kept in each level by --prune", cxxopts::value<float>(keep))
         ( "preview", "Use preview window", cxxopts::value<bool>(doPreview))
         ( "threads", "Use worker threads when possible", cxxopts::value<bool>(doThreads))
         ( "verbose", "Print verbose diagnostics", cxxopts::value<bool>(doVerbose))
@@ -152,47 +176,112 @@ int mine(int argc, char* argv[])
 #else
     std::vector<std::vector<dlib::full_object_detection> > faces_train;
     dlib::array<dlib::array2d<uint8_t>> images_train;
-    dlib::image_dataset_file source(sInput);
-    source.skip_empty_images();
-    load_image_dataset(images_train, faces_train, source);
 
-    double elapsed = 0.0;
-    for(int i = 0; i < images_train.size(); i++)
+#if defined(DRISHTI_BUILD_FACE)
+    // Record file shards (drishti-facecrop --pack) are decoded in parallel:
+    const bool doRecords = drishti::dlib::load_face_records(images_train, faces_train, sInput);
+#else
+    const bool doRecords = false;
+#endif
+    if(!doRecords)
     {
-        for(const auto &face : faces_train[i])
-        {
-            int64 tic = cv::getTickCount();
-            dlib::full_object_detection shape = sp(images_train[i], face.get_rect());
-            int64 toc = cv::getTickCount();
-            elapsed += (toc - tic) / cv::getTickFrequency();
+        dlib::image_dataset_file source(sInput);
+        source.skip_empty_images();
+        load_image_dataset(images_train, faces_train, source);
+    }
 
-            cv::Mat image;
-            if(doPreview)
+    // Mean landmark error normalized by the ground truth shape extent (see train_shape_predictor):
+    double elapsed = 0.0, error = 0.0;
+    auto evaluate = [&]()
+    {
+        elapsed = error = 0.0;
+        std::size_t count = 0;
+        for(int i = 0; i < images_train.size(); i++)
+        {
+            for(const auto &face : faces_train[i])
             {
-                image = dlib::toMat( images_train[i] );
-                cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
-                cv::rectangle(image, cv_rect(face.get_rect()), {0,255,0}, 1, 8);
-            }
+                int64 tic = cv::getTickCount();
+                dlib::full_object_detection shape = sp(images_train[i], face.get_rect());
+                int64 toc = cv::getTickCount();
+                elapsed += (toc - tic) / cv::getTickFrequency();
 
-            std::vector<cv::Point> points;
-            for(int j = 0; j < shape.num_parts(); j++)
-            {
-                points.push_back(cv_point(shape.part(j)));
+                const double extent = std::max(1.0, max_extent(face));
+                for(int j = 0; j < std::min(shape.num_parts(), face.num_parts()); j++)
+                {
+                    error += dlib::length(shape.part(j) - face.part(j)) / extent;
+                    count++;
+                }
 
+                cv::Mat image;
                 if(doPreview)
                 {
-                    cv::circle(image, points.back(), 2, {0,255,0}, -1, 8);
+                    image = dlib::toMat( images_train[i] );
+                    cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+                    cv::rectangle(image, cv_rect(face.get_rect()), {0,255,0}, 1, 8);
                 }
-            }
 
-            if(doPreview)
-            {
-                cv::imshow("image", image), cv::waitKey(0);
+                std::vector<cv::Point> points;
+                for(int j = 0; j < shape.num_parts(); j++)
+                {
+                    points.push_back(cv_point(shape.part(j)));
+
+                    if(doPreview)
+                    {
+                        cv::circle(image, points.back(), 2, {0,255,0}, -1, 8);
+                    }
+                }
+
+                if(doPreview)
+                {
+                    cv::imshow("image", image), cv::waitKey(0);
+                }
             }
         }
+        error /= std::max(count, std::size_t(1));
+    };
+
+    if(!sQuantized.empty())
+    {
+        sp.populate_f16(); // evaluate the runtime (compiled) representation
     }
 
+    evaluate();
     std::cout << "elapsed: " << elapsed << std::endl;
+    std::cout << "error: " << error << std::endl;
+
+    if(!sQuantized.empty())
+    {
+        const double reference = error, referenceElapsed = elapsed;
+
+        sp.quantize();
+        evaluate();
+        std::cout << "quantized elapsed: " << elapsed << " (" << (elapsed / std::max(referenceElapsed, 1e-9)) << "x)" << std::endl;
+        std::cout << "quantized error: " << error << " (loss " << (error - reference) << ")" << std::endl;
+
+        save_cpb(sQuantized, sp);
+    }
+
+#if !DRISHTI_BUILD_MIN_SIZE
+    if(!sPruned.empty())
+    {
+        // Tree importance is measured on the input (validation) set:
+        const drishti::ml::shape_predictor reference = sp;
+        const auto stats = drishti::ml::measure_tree_statistics(reference, images_train, faces_train, doThreads ? 8 : 1);
+        const double referenceError = error, referenceElapsed = elapsed;
+
+        // Accuracy/latency trade-off:
+        for(float fraction : { 0.75f, 0.5f, 0.25f, keep })
+        {
+            sp = reference;
+            drishti::ml::prune_trees(sp, stats, fraction);
+            evaluate();
+            std::cout << "keep " << fraction << " elapsed: " << elapsed << " (" << (elapsed / std::max(referenceElapsed, 1e-9)) << "x)"
+                      << " error: " << error << " (loss " << (error - referenceError) << ")" << std::endl;
+        }
+
+        save_cpb(sPruned, sp);
+    }
+#endif
 #endif
 
     return 0;
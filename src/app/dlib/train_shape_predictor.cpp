@@ -22,9 +22,11 @@
 #include <dlib/statistics/statistics.h>
 #include <dlib/image_processing/shape_predictor.h>
 #include <dlib/opencv/cv_image.h>
+#include <dlib/opencv/to_open_cv.h>
 #include <dlib/vectorstream.h>
 #include <dlib/serialize.h>
 #include <dlib/data_io/load_image_dataset.h>
+#include <dlib/image_io.h>
 
 #include "drishti/core/string_utils.h"
 #include "drishti/core/Line.h"
@@ -36,9 +38,20 @@
 
 #include "RecipeIO.h"
 
+#if defined(DRISHTI_BUILD_FACE)
+#  include "FaceRecordsIO.h"
+#endif
+
 #include "cxxopts.hpp"
 
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
 
 //#define _SP dlib
 #define _SP drishti::ml
@@ -59,6 +72,42 @@ get_interocular_distances(const std::vector<std::vector<dlib::full_object_detect
 using DlibImageArray = dlib::array<dlib::array2d<uint8_t>>;
 using DlibObjectSet = std::vector<std::vector<dlib::full_object_detection>>;
 
+// Training images that are decoded (and resized) on access, for datasets that don't fit in memory.
+// The feature cache trainer reads each image once per cascade.
+class DlibImageStream
+{
+public:
+    using value_type = dlib::matrix<uint8_t>; // copyable generic image
+
+    void push_back(const std::string& filename, float scale)
+    {
+        m_filenames.push_back(filename);
+        m_scales.push_back(scale);
+    }
+
+    std::size_t size() const { return m_filenames.size(); }
+
+    value_type operator[](std::size_t i) const
+    {
+        value_type image;
+        dlib::load_image(image, m_filenames[i]);
+        if (m_scales[i] != 1.f)
+        {
+            cv::Mat small;
+            cv::resize(dlib::toMat(image), small, {}, m_scales[i], m_scales[i], cv::INTER_LANCZOS4);
+            dlib::assign_image(image, dlib::cv_image<uint8_t>(small));
+        }
+        return image;
+    }
+
+protected:
+    std::vector<std::string> m_filenames;
+    std::vector<float> m_scales;
+};
+
+static void load_image_dataset_stream(DlibImageStream& images, DlibObjectSet& objects, const std::string& filename, int ellipse_count, int width);
+static void load_dataset(DlibImageArray& images, DlibObjectSet& objects, const std::string& filename, bool skip_empty);
+static void reduce_objects(std::vector<dlib::full_object_detection>& faces, int ellipse_count, float scale);
 static void reduce_images(DlibImageArray& images_train, DlibObjectSet& faces_train, int ellipse_count, int width);
 static void dump_thumbs(DlibImageArray& images_train, DlibObjectSet& faces_train, const std::string& dir, int ellipse_count);
 
@@ -98,6 +147,10 @@ int gauze_main(int argc, char* argv[])
     bool do_thumbs = false;
     bool do_verbose = false;
     bool do_silent = false;
+    bool do_cache = false;
+    bool do_stream = false;
+    bool do_evaluate = false;
+    float stop_delta = 0.f;
 
     drishti::dlib::Recipe recipe;
 
@@ -108,6 +161,7 @@ int gauze_main(int argc, char* argv[])
     std::string sRecipe;
     std::string sRecipeOut;
     std::string sOutput;
+    std::string sCheckpoint;
     
     cxxopts::Options options("train_shape_predictor", "Command line interface for dlib shape_predictor training");
 
@@ -124,6 +178,15 @@ int gauze_main(int argc, char* argv[])
         ( "recipe", "Cascaded pose regression training recipe", cxxopts::value<std::string>(sRecipe))
         ( "boilerplate", "Output boilerplate recipe file", cxxopts::value<std::string>(sRecipeOut))        
         
+        // Training memory and speed:
+        ( "cache", "Feature cache (uint8 SoA) with histogram split search", cxxopts::value<bool>(do_cache))
+        ( "stream", "Load training images from disk on access (implies --cache)", cxxopts::value<bool>(do_stream))
+
+        // Long training runs:
+        ( "checkpoint", "Checkpoint file written after each cascade (resumes if present)", cxxopts::value<std::string>(sCheckpoint))
+        ( "evaluate", "Evaluate each cascade level on the test set (in the background)", cxxopts::value<bool>(do_evaluate))
+        ( "stop-delta", "Stop when a level improves the test error by less than this (with --evaluate)", cxxopts::value<float>(stop_delta))
+
         ( "threads", "Use worker threads when possible", cxxopts::value<bool>(do_threads))
         ( "verbose", "Print verbose diagnostics", cxxopts::value<bool>(do_verbose))
         ( "silent", "Disable logging entirely", cxxopts::value<bool>(do_silent))
@@ -188,10 +251,31 @@ int gauze_main(int argc, char* argv[])
 
     dlib::array<dlib::array2d<uint8_t>> images_train, images_test;
     std::vector<std::vector<dlib::full_object_detection> > faces_train, faces_test;
+    DlibImageStream images_stream;
+
+#if defined(DRISHTI_BUILD_FACE)
+    if(do_stream && drishti::dlib::is_face_records(sTrain))
+    {
+        logger->warn("Record files are loaded in memory (ignoring --stream)");
+        do_stream = false;
+    }
+#endif
 
-    dlib::image_dataset_file source(sTrain);
-    source.skip_empty_images();
-    load_image_dataset(images_train, faces_train, source);
+    if(do_stream)
+    {
+        if(do_thumbs)
+        {
+            logger->error("Thumbnails are not supported for streamed images");
+            return 1;
+        }
+
+        // Downsampling is performed as images are loaded:
+        load_image_dataset_stream(images_stream, faces_train, sTrain, recipe.ellipse_count, recipe.width);
+    }
+    else
+    {
+        load_dataset(images_train, faces_train, sTrain, true);
+    }
     
     if(faces_train.empty())
     {
@@ -206,7 +290,7 @@ int gauze_main(int argc, char* argv[])
     }
 
     // Here we optionally downsample:
-    if(recipe.width > 0)
+    if(!do_stream && (recipe.width > 0))
     {
         reduce_images(images_train, faces_train, recipe.ellipse_count, recipe.width);
     }
@@ -240,6 +324,9 @@ int gauze_main(int argc, char* argv[])
     trainer.set_do_affine(recipe.do_affine);
     trainer.set_roi(roi);
     trainer.set_do_line_indexed(recipe.do_interpolate);
+    trainer.set_octaves(recipe.octaves); // coarse levels sample a downscaled image
+    trainer.set_landmarks(recipe.landmarks); // (optional) subset model
+    trainer.set_do_feature_cache(do_cache || do_stream); // one image read per cascade
     
     trainer.set_num_threads(8);
     
@@ -248,12 +335,58 @@ int gauze_main(int argc, char* argv[])
         trainer.be_verbose();
     }
 
-    int max_dim = faces_train[0][0].num_parts() * 2;
+    int max_dim = (recipe.landmarks.empty() ? faces_train[0][0].num_parts() : recipe.landmarks.size()) * 2;
     for(const auto &dim : recipe.dimensions)
     {
         CV_Assert(0 < dim && dim <= max_dim);
     }
 
+    // Levels are evaluated on the test set asynchronously while the next level trains:
+    if(do_evaluate && !sTest.empty())
+    {
+        load_dataset(images_test, faces_test, sTest, false);
+    }
+    
+    const auto test_iod = get_interocular_distances(faces_test);
+    std::deque<std::pair<unsigned long, std::future<double>>> evaluations;
+    double best_error = std::numeric_limits<double>::max();
+    bool do_stop = false;
+
+    // Log completed evaluations in order, and return true if the error has stopped improving:
+    auto poll_evaluations = [&](bool wait) {
+        while(!evaluations.empty() && (wait || (evaluations.front().second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)))
+        {
+            const auto levels = evaluations.front().first;
+            const double error = evaluations.front().second.get();
+            evaluations.pop_front();
+
+            logger->info("Cascade {} mean testing error: {}", levels, error);
+            if((stop_delta > 0.f) && ((best_error - error) < stop_delta))
+            {
+                logger->info("Cascade {} improvement is less than {}, stopping", levels, stop_delta);
+                do_stop = true;
+            }
+            best_error = std::min(best_error, error);
+        }
+        return do_stop;
+    };
+
+    if(!images_test.empty())
+    {
+        trainer.set_cascade_callback([&](unsigned long levels, const _SP::shape_predictor& sp) {
+            auto level_sp = std::make_shared<_SP::shape_predictor>(sp);
+            evaluations.emplace_back(levels, std::async(std::launch::async, [&, level_sp]() {
+                return test_shape_predictor(*level_sp, images_test, faces_test, test_iod, 0, 2);
+            }));
+            return !poll_evaluations(false);
+        });
+    }
+
+    if(!sCheckpoint.empty())
+    {
+        trainer.set_checkpoint(sCheckpoint);
+    }
+
     if(do_verbose)
     {
         logger->info("Begin training...");
@@ -266,12 +399,14 @@ int gauze_main(int argc, char* argv[])
     }
     
     //_SP::shape_predictor sp;
-    _SP::shape_predictor sp = trainer.train(images_train, faces_train, weights);
+    _SP::shape_predictor sp = do_stream ? trainer.train(images_stream, faces_train, weights) : trainer.train(images_train, faces_train, weights);
     if(do_verbose)
     {
         logger->info("Done training...");
     }
 
+    poll_evaluations(true);
+
     // Finally, we save the model to disk so we can use it later.
     //dlib::serialize( sModel.c_str() ) << sp;
 
@@ -289,7 +424,7 @@ int gauze_main(int argc, char* argv[])
     }
 
     auto train_iod = get_interocular_distances(faces_train);
-    double training_error = test_shape_predictor(sp, images_train, faces_train, train_iod);
+    double training_error = do_stream ? test_shape_predictor(sp, images_stream, faces_train, train_iod, 0, 8) : test_shape_predictor(sp, images_train, faces_train, train_iod, 0, 8);
     
     if(do_verbose)
     {
@@ -298,10 +433,13 @@ int gauze_main(int argc, char* argv[])
 
     if(!sTest.empty())
     {
-        load_image_dataset(images_test, faces_test, sTest);
+        if(images_test.empty())
+        {
+            load_dataset(images_test, faces_test, sTest, false);
+        }
         
-        auto test_iod = get_interocular_distances(faces_test);
-        float test_error = test_shape_predictor(sp, images_test, faces_test, test_iod);
+        const auto final_iod = get_interocular_distances(faces_test);
+        float test_error = test_shape_predictor(sp, images_test, faces_test, final_iod, 0, 8);
         
         if(do_verbose)
         {
@@ -425,6 +563,34 @@ static void reduce_int(dlib::rectangle &roi, float scale)
     reduce_int(roi.bottom(), scale);
 }
 
+static void reduce_objects(std::vector<dlib::full_object_detection>& faces, int ellipse_count, float scale)
+{
+    for(int j = 0; j < faces.size(); j++)
+    {
+        // reduce roi:
+        reduce_int(faces[j].get_rect(), scale);
+
+        const int end = faces[j].num_parts() - (ellipse_count * 5);
+        for(int k = 0; k < end; k++)
+        {
+            auto &part = faces[j].part(k);
+            reduce_int(part.x(), scale);
+            reduce_int(part.y(), scale);
+            CV_Assert(part.x() < 1000 && part.y() < 1000);
+        }
+
+        // Handle the ellipse data (optional):
+        for(int k = end; k < faces[j].num_parts(); k+= 5)
+        {
+            auto & obj = faces[j];
+            obj.part(k+0).x() *= scale;
+            obj.part(k+1).x() *= scale;
+            obj.part(k+2).x() *= scale;
+            obj.part(k+3).x() *= scale;
+        }
+    }
+}
+
 static void reduce_images(DlibImageArray &images_train, DlibObjectSet &faces_train, int ellipse_count, int width)
 {
     for(int i = 0; i < images_train.size(); i++)
@@ -436,31 +602,92 @@ static void reduce_images(DlibImageArray &images_train, DlibObjectSet &faces_tra
         cv::resize(image, small, {}, scale, scale, cv::INTER_LANCZOS4);
         dlib::assign_image(src, dlib::cv_image<uint8_t>(small));
 
-        for(int j = 0; j < faces_train[i].size(); j++)
-        {
-            // reduce roi:
-            reduce_int(faces_train[i][j].get_rect(), scale);
+        reduce_objects(faces_train[i], ellipse_count, scale);
+    }
+}
 
-            const int end = faces_train[i][j].num_parts() - (ellipse_count * 5);
-            for(int k = 0; k < end; k++)
+// Equivalent of load_image_dataset() with skip_empty_images() that reads the XML metadata only
+// (each image is decoded once here to compute the downsampling scale when width > 0):
+static void load_image_dataset_stream(DlibImageStream &images, DlibObjectSet &objects, const std::string &filename, int ellipse_count, int width)
+{
+    dlib::image_dataset_metadata::dataset data;
+    dlib::image_dataset_metadata::load_image_dataset_metadata(data, filename);
+
+    // Image paths are relative to the XML file:
+    const auto pos = filename.find_last_of("/\\");
+    const std::string dir = (pos == std::string::npos) ? std::string() : filename.substr(0, pos + 1);
+
+    // Parts are indexed by name in sorted order (as in load_image_dataset()):
+    std::map<std::string, int> parts;
+    for (const auto &image : data.images)
+    {
+        for (const auto &box : image.boxes)
+        {
+            for (const auto &part : box.parts)
             {
-                auto &part = faces_train[i][j].part(k);
-                reduce_int(part.x(), scale);
-                reduce_int(part.y(), scale);
-                CV_Assert(part.x() < 1000 && part.y() < 1000);
+                parts.emplace(part.first, 0);
             }
+        }
+    }
+    int index = 0;
+    for (auto &part : parts)
+    {
+        part.second = index++;
+    }
 
-            // Handle the ellipse data (optional):
-            for(int k = end; k < faces_train[i][j].num_parts(); k+= 5)
+    for (const auto &image : data.images)
+    {
+        std::vector<dlib::full_object_detection> faces;
+        for (const auto &box : image.boxes)
+        {
+            if (!box.ignore)
             {
-                auto & obj = faces_train[i][j];
-                obj.part(k+0).x() *= scale;
-                obj.part(k+1).x() *= scale;
-                obj.part(k+2).x() *= scale;
-                obj.part(k+3).x() *= scale;
+                std::vector<dlib::point> points(parts.size(), dlib::OBJECT_PART_NOT_PRESENT);
+                for (const auto &part : box.parts)
+                {
+                    points[parts[part.first]] = part.second;
+                }
+                faces.emplace_back(box.rect, points);
             }
         }
+
+        if (faces.empty())
+        {
+            continue;
+        }
+
+        const std::string path = (!image.filename.empty() && (image.filename[0] == '/')) ? image.filename : (dir + image.filename);
+
+        float scale = 1.f;
+        if (width > 0)
+        {
+            dlib::array2d<uint8_t> src;
+            dlib::load_image(src, path);
+            scale = float(width) / src.nc();
+            reduce_objects(faces, ellipse_count, scale);
+        }
+
+        images.push_back(path, scale);
+        objects.push_back(faces);
+    }
+}
+
+// Load dlib XML datasets or (with DRISHTI_BUILD_FACE) record files and shard lists from drishti-facecrop:
+static void load_dataset(DlibImageArray &images, DlibObjectSet &objects, const std::string &filename, bool skip_empty)
+{
+#if defined(DRISHTI_BUILD_FACE)
+    if (drishti::dlib::load_face_records(images, objects, filename, skip_empty))
+    {
+        return;
+    }
+#endif
+
+    dlib::image_dataset_file source(filename);
+    if (skip_empty)
+    {
+        source.skip_empty_images();
     }
+    load_image_dataset(images, objects, source);
 }
 
 static dlib::rectangle parse_roi(const std::string &str)
@@ -11,10 +11,12 @@
 // Local includes:
 #include "drishti/core/drishti_stdlib_string.h" // android workaround
 #include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/core/AppendSink.h"
 #include "drishti/core/LazyParallelResource.h"
 #include "drishti/core/Line.h"
 #include "drishti/core/Logger.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/padding.h"
 #include "drishti/core/string_utils.h"
@@ -34,7 +36,11 @@
 #include <cereal/archives/json.hpp>
 
 // System includes:
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <sstream>
+#include <thread>
 
 DRISHTI_BEGIN_NAMESPACE(drishti)
 DRISHTI_BEGIN_NAMESPACE(eye)
@@ -55,6 +61,52 @@ static bool writeAsJson(const std::string& filename, drishti::eye::EyeModel& eye
     return ofs.good();
 }
 
+/*
+ * Single line JSON record for line-delimited result files:
+ */
+
+static std::string toJsonLine(const std::string& filename, double elapsed, drishti::eye::EyeModel& eye)
+{
+    std::stringstream ss;
+    {
+        cereal::JSONOutputArchive oa(ss, cereal::JSONOutputArchive::Options::NoIndent());
+        using Archive = decltype(oa); // needed by macro
+        oa << GENERIC_NVP("filename", filename);
+        oa << GENERIC_NVP("elapsed", elapsed);
+        oa << GENERIC_NVP("eye", eye);
+    }
+    std::string line = ss.str();
+    line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
+    return line;
+}
+
+/*
+ * Combine the per shard outputs of a sharded run (base + ".<i>-of-<n>" + ext), returns false
+ * if only some of the shard files exist:
+ */
+
+static bool mergeShards(const std::string& base, const std::string& ext, int count, drishti::core::AppendSink::Format format, std::size_t& entries)
+{
+    std::vector<std::string> inputs;
+    for (int i = 0; i < count; i++)
+    {
+        drishti::cli::shard::Spec spec;
+        spec.index = i;
+        spec.count = count;
+        if (drishti::cli::file::exists(base + spec.suffix() + ext))
+        {
+            inputs.push_back(base + spec.suffix() + ext);
+        }
+    }
+
+    entries = 0;
+    if (!inputs.empty() && (static_cast<int>(inputs.size()) == count))
+    {
+        entries = drishti::core::AppendSink::merge(inputs, base + ext, format);
+    }
+    return inputs.empty() || (static_cast<int>(inputs.size()) == count);
+}
+
 /*
  * Invertible/cascadable preprocessing transformation class (eye specific):
  * 1) apply image transformation in constructor.
@@ -79,7 +131,7 @@ struct Padder : public Transform
     {
         if (!isGoodAspectRatio(input.size(), aspectRatio))
         {
-            tl = drishti::core::padToAspectRatio(input, image, aspectRatio, false);
+            tl = drishti::core::padToAspectRatio(input, image, aspectRatio, drishti::core::kPadReplicate);
         }
         else
         {
@@ -197,8 +249,10 @@ int gauze_main(int argc, char** argv)
     // ### Command line parsing ###
     // ############################
 
-    std::string sInput, sOutput, sModel, sPrewarp;
+    std::string sInput, sOutput, sModel, sPrewarp, sShard;
     int threads = -1;
+    int mergeCount = 0;
+    bool doResume = false;
     int stages = std::numeric_limits<int>::max();
     bool doJson = true;
     bool doAnnotation = false;
@@ -206,6 +260,8 @@ int gauze_main(int argc, char** argv)
     bool isLeft = false;
     bool doLabels = false;
     bool doVersion = false;
+    bool doSink = false;
+    bool doArchive = false;
 
     cv::Matx33f prewarp = cv::Matx33f::eye();
 
@@ -224,6 +280,11 @@ int gauze_main(int argc, char** argv)
         ("l,left", "Left eye inputs", cxxopts::value<bool>(isLeft))
         ("p,prewarp", "Prewarp", cxxopts::value<std::string>(sPrewarp))
         ("L,labels", "Generate label image", cxxopts::value<bool>(doLabels))
+        ("sink", "Append results to <output>/eye.jsonl (one JSON object per line)", cxxopts::value<bool>(doSink))
+        ("archive", "Append images to <output>/eye.tar", cxxopts::value<bool>(doArchive))
+        ("shard", "Process shard <index>/<count> of the input list (outputs are named eye.<index>-of-<count>.*)", cxxopts::value<std::string>(sShard))
+        ("resume", "Skip the inputs completed by an earlier run and append to its outputs", cxxopts::value<bool>(doResume))
+        ("merge", "Merge the sink and archive files of <n> shards in the output directory (then quit)", cxxopts::value<int>(mergeCount))
         ("version", "Report library version", cxxopts::value<bool>(doVersion))
         ("h,help", "Print help message");
     // clang-format on    
@@ -246,6 +307,33 @@ int gauze_main(int argc, char** argv)
     // ### Command line argument error checking ###
     // ############################################
 
+    if(mergeCount > 0)
+    {
+        const std::vector<std::pair<std::string, drishti::core::AppendSink::Format>> outputs
+        {
+            { ".jsonl", drishti::core::AppendSink::kLines },
+            { ".tar", drishti::core::AppendSink::kTar }
+        };
+        for(const auto &output : outputs)
+        {
+            std::size_t entries = 0;
+            if(!mergeShards(sOutput + "/eye", output.first, mergeCount, output.second, entries))
+            {
+                logger->error("Missing shards of {}/eye{}", sOutput, output.first);
+                return 1;
+            }
+            logger->info("Merged {} entries into {}/eye{}", entries, sOutput, output.first);
+        }
+        return 0;
+    }
+
+    drishti::cli::shard::Spec shard;
+    if(!sShard.empty() && !drishti::cli::shard::parse(sShard, shard))
+    {
+        logger->error("Invalid shard {} (expected <index>/<count>)", sShard);
+        return 1;
+    }
+
     // Be pedantic about input orientation to ensure correct results:
     if((parseResult["right"].count() + parseResult["left"].count()) != 1)
     {
@@ -328,8 +416,42 @@ int gauze_main(int argc, char** argv)
         logger->info("prewarp: {}", prewarp);
     }
 
-    const auto filenames = drishti::cli::expand(sInput);
-    
+    // Consolidated outputs, written by one background thread each (per shard).  An image is
+    // done once it is marked in every output it writes to:
+    const std::string sBase = sOutput + "/eye" + shard.suffix();
+    std::vector<drishti::core::AppendSink*> checkpoints;
+    std::vector<std::string> sCheckpoints;
+    auto open = [&](const std::string &ext, drishti::core::AppendSink::Format format)
+    {
+        auto output = drishti::core::make_unique<drishti::core::AppendSink>(sBase + ext, format, doResume);
+        checkpoints.push_back(output.get());
+        sCheckpoints.push_back(sBase + ext + ".done");
+        return output;
+    };
+
+    std::unique_ptr<drishti::core::AppendSink> sink, archive, progress;
+    if(doSink)
+    {
+        sink = open(".jsonl", drishti::core::AppendSink::kLines);
+    }
+    if(doArchive)
+    {
+        archive = open(".tar", drishti::core::AppendSink::kTar);
+    }
+    if(!(sink || archive))
+    {
+        progress = open(".progress", drishti::core::AppendSink::kLines); // marks only, images are written first
+    }
+    if(std::any_of(checkpoints.begin(), checkpoints.end(), [](const drishti::core::AppendSink *output) { return !output->good(); }))
+    {
+        logger->error("Unable to create output files in {}", sOutput);
+        return 1;
+    }
+
+    const auto manifest = drishti::cli::expand(sInput);
+    const auto filenames = drishti::cli::shard::select(manifest, shard, doResume ? drishti::cli::shard::completed(sCheckpoints) : std::set<std::string>());
+    logger->info("Shard {}/{}: {} of {} images", shard.index, shard.count, filenames.size(), manifest.size());
+
     // Allocate resource manager:
     using EyeModelEstimatorPtr = std::unique_ptr<drishti::eye::EyeModelEstimator>;
     drishti::core::LazyParallelResource<std::thread::id, EyeModelEstimatorPtr> manager = [&]()
@@ -337,6 +459,21 @@ int gauze_main(int argc, char** argv)
         return drishti::core::make_unique<drishti::eye::EyeModelEstimator>(sModel);
     };
     
+    // Write one image to the archive or to its own file (base has no extension):
+    auto writeImage = [&](const std::string &base, const std::string &suffix, const cv::Mat &image)
+    {
+        if(archive)
+        {
+            std::vector<uchar> bytes;
+            cv::imencode(".png", image, bytes);
+            archive->push(base + suffix, std::string(bytes.begin(), bytes.end()));
+        }
+        else
+        {
+            cv::imwrite(sOutput + "/" + base + suffix, image);
+        }
+    };
+
     std::size_t total = 0;
     
     // Parallel loop:
@@ -351,9 +488,11 @@ int gauze_main(int argc, char** argv)
         cv::Mat image = cv::imread(filenames[i], cv::IMREAD_COLOR);
         if(!image.empty())
         {
+            const auto tic = std::chrono::high_resolution_clock::now();
             drishti::eye::EyeModel eye;
             drishti::eye::fitEyeModel(*segmenter, image, eye, isRight, hasPrewarp ? &prewarp : nullptr);
             eye.refine();
+            const double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tic).count();
 
             if(!sOutput.empty())
             {
@@ -368,18 +507,22 @@ int gauze_main(int argc, char** argv)
                 {
                     cv::Mat canvas = image.clone();
                     eye.draw(canvas);
-                    cv::imwrite(filename + "_contours.png", canvas);
+                    writeImage(base, "_contours.png", canvas);
                 }
 
                 // Save part labels
                 if(doLabels)
                 {
                     cv::Mat labels = eye.labels(image.size());
-                    cv::imwrite(filename + "_labels.png", labels);
+                    writeImage(base, "_labels.png", labels);
                 }
 
                 // Save eye model results as xml:
-                if(doJson)
+                if(doJson && sink)
+                {
+                    sink->push(drishti::eye::toJsonLine(base, elapsed, eye));
+                }
+                else if(doJson)
                 {
                     if(!drishti::eye::writeAsJson(filename + ".json", eye))
                     {
@@ -387,6 +530,12 @@ int gauze_main(int argc, char** argv)
                     }
                 }
             }
+
+            // After all outputs of the image (see AppendSink::mark()):
+            for(auto *checkpoint : checkpoints)
+            {
+                checkpoint->mark(filenames[i]);
+            }
         }
     };
     
@@ -396,7 +545,28 @@ int gauze_main(int argc, char** argv)
     }
     else
     {
-        cv::parallel_for_({0,static_cast<int>(filenames.size())}, harness, std::max(threads, -1));
+        // Per image cost varies with the eye count, so claim one image at a time:
+        drishti::core::ParallelSettings settings;
+        settings.threads = threads;
+        settings.grain = 1;
+
+        // Load one estimator per worker concurrently, before the first batch:
+        const int workers = (threads > 0) ? threads : static_cast<int>(std::thread::hardware_concurrency());
+        manager.reserve(std::min(static_cast<int>(filenames.size()), std::max(workers, 1)));
+        drishti::core::parallelFor({0,static_cast<int>(filenames.size())}, harness, settings);
+    }
+
+    if(sink)
+    {
+        logger->info("Wrote {} results to {}.jsonl", sink->close(), sBase);
+    }
+    if(archive)
+    {
+        logger->info("Wrote {} images to {}.tar", archive->close(), sBase);
+    }
+    if(progress)
+    {
+        progress->close();
     }
 
     return 0;
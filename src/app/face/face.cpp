@@ -10,10 +10,12 @@
 
 // Local includes:
 #include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/AppendSink.h"
 #include "drishti/core/LazyParallelResource.h"
 #include "drishti/core/Line.h"
 #include "drishti/core/Logger.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/string_utils.h"
 #include "drishti/core/drishti_cv_cereal.h"
@@ -21,10 +23,12 @@
 #include "drishti/testlib/drishti_cli.h"
 #include "drishti/face/FaceDetector.h"
 #include "drishti/face/FaceDetectorFactoryJson.h"
+#include "drishti/face/FaceDetectorFactoryBundle.h"
 #include "drishti/face/gpu/FaceStabilizer.h"
 #include "drishti/geometry/motion.h"
 #include "drishti/ml/ObjectDetector.h"
 #include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/ml/ObjectDetectorACFTiled.h"
 
 #include "drishti/drishti_sdk.hpp" // for version from public SDK
 
@@ -37,21 +41,44 @@
 // clang-format on
 
 #include "videoio/VideoSourceCV.h"
+#include "videoio/VideoSourcePrefetch.h"
+#include "videoio/VideoSourceStills.h"
 
 // Package includes:
 #include "cxxopts.hpp"
 #include <opencv2/highgui.hpp>
 #include <cereal/archives/json.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
 using drishti::face::FaceSpecification;
 using LoggerPtr = std::shared_ptr<spdlog::logger>;
+using Frame = drishti::videoio::VideoSourceCV::Frame;
+using Faces = std::vector<drishti::face::FaceModel>;
+using FrameProcessor = std::function<void(const cv::Mat& image, Faces& faces)>;
+using FrameReporter = std::function<void(const std::string& input, const Frame& frame, const Faces& faces, double elapsed)>;
+using VideoSourcePtr = std::shared_ptr<drishti::videoio::VideoSourceCV>;
+using VideoFactory = std::function<VideoSourcePtr(const std::string& input)>;
 
 static cv::Mat
 cropEyes(const cv::Mat& image, const drishti::face::FaceModel& face, const cv::Size& size, float scale, bool annotate);
 static void initWindow(const std::string& name);
 static bool writeAsJson(const std::string& filename, const std::vector<drishti::face::FaceModel>& faces);
+static std::string toJsonLine(const std::string& filename, double elapsed, const std::vector<drishti::face::FaceModel>& faces);
 static void drawObjects(cv::Mat& canvas, const std::vector<drishti::face::FaceModel>& faces);
 static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description);
+static std::string getFrameName(const std::string& input, const Frame& frame);
+static bool mergeShards(const std::string& base, const std::string& ext, int count, drishti::core::AppendSink::Format format, std::size_t& entries);
+static void runStreams(const std::vector<std::string>& inputs, const VideoFactory& create, int workers, int depth, const FrameProcessor& process, const FrameReporter& report);
 
 // Resize input image to detection objects of minimum width
 // given an object detection window size. i.e.,
@@ -150,23 +177,37 @@ int gauze_main(int argc, char** argv)
     // ### Command line parsing ###
     // ############################
 
-    std::string sInput, sOutput;
+    std::vector<std::string> sInputs;
+    std::string sOutput, sShard;
     int threads = -1;
+    int mergeCount = 0;
+    bool doResume = false;
+    int depth = 8;
+    bool doStream = false;
+    int prefetch = 0;
+    int reduction = 1;
     bool doEyes = false;
     bool doPause = false;
     bool doDisplay = false;
     bool doAnnotation = false;
     bool doPositiveOnly = false;
     bool doVersion = false;
+    bool doSink = false;
+    bool doArchive = false;
     
     float scale = 1.0;
     double cascCal = 0.0;
     int minWidth = -1; // minimum object width
 
+    drishti::ml::ObjectDetectorACFTiled::Settings tiling;
+    tiling.tile = 0; // off
+    int tileThreads = 0;
+
     bool doInner = false;
+    bool doLite = false;
 
     // Use factory as container for CLI inputs:
-    std::string sFactory;
+    std::string sFactory, sBundle;
     auto factory = std::make_shared<drishti::face::FaceDetectorFactory>();
 
     float minZ = 0.1f, maxZ = 1.f;
@@ -175,13 +216,16 @@ int gauze_main(int argc, char** argv)
 
     // clang-format off
     options.add_options()
-        ("i,input", "Input file", cxxopts::value<std::string>(sInput))
+        ("i,input", "Input file (repeat for multiple files)", cxxopts::value<std::vector<std::string>>(sInputs))
         ("o,output", "Output directory", cxxopts::value<std::string>(sOutput))
     
         // Detection parameters:
         ("l,min", "Minimum object width (lower bound)", cxxopts::value<int>(minWidth))
         ("c,calibration", "Cascade calibration", cxxopts::value<double>(cascCal))
         ("s,scale", "Scale term for detection->regression mapping", cxxopts::value<float>(scale))
+        ("tile", "Detect large images in tiles of <n> pixels, all faces are kept (0 == off)", cxxopts::value<int>(tiling.tile))
+        ("tile-margin", "Tile context on each side in pixels (0 == 2x the detector window)", cxxopts::value<int>(tiling.margin))
+        ("tile-threads", "Detector instances per tiled image (0 == cores)", cxxopts::value<int>(tileThreads))
 
         // Clasifier and regressor models:
         ("D,detector", "Face detector model", cxxopts::value<std::string>(factory->sFaceDetector))
@@ -190,8 +234,10 @@ int gauze_main(int argc, char** argv)
         ("E,eye", "Eye model", cxxopts::value<std::string>(factory->sEyeRegressor))
     
         // ... factory can be used instead of D,M,R,E
-        ("F,factory", "Factory (json model zoo)", cxxopts::value<std::string>(sFactory))
+        ("F,factory", "Factory (json model zoo or model bundle)", cxxopts::value<std::string>(sFactory))
+        ("pack-bundle", "Pack the factory models into a single model bundle (then quit)", cxxopts::value<std::string>(sBundle))
         ("inner", "Inner face landmakrs", cxxopts::value<bool>(doInner))
+        ("lite", "Use the subset (eyes and nose) landmark model of the factory if it has one", cxxopts::value<bool>(doLite))
     
         // Output parameters:
         ("e,eyes", "Crop eyes", cxxopts::value<bool>(doEyes))
@@ -200,6 +246,15 @@ int gauze_main(int argc, char** argv)
         ("0,pause", "Pause display window", cxxopts::value<bool>(doPause))
         ("p,positive", "Limit output to positve examples", cxxopts::value<bool>(doPositiveOnly))
         ("t,threads", "Thread count", cxxopts::value<int>(threads))
+        ("sink", "Append results to <output>/faces.jsonl (one JSON object per line)", cxxopts::value<bool>(doSink))
+        ("archive", "Append images to <output>/faces.tar", cxxopts::value<bool>(doArchive))
+        ("shard", "Process shard <index>/<count> of the inputs (outputs are named faces.<index>-of-<count>.*)", cxxopts::value<std::string>(sShard))
+        ("resume", "Skip the inputs completed by an earlier run and append to its outputs", cxxopts::value<bool>(doResume))
+        ("merge", "Merge the sink and archive files of <n> shards in the output directory (then quit)", cxxopts::value<int>(mergeCount))
+        ("stream", "Streaming batch mode: sequential decode, pooled detection, all inputs at once", cxxopts::value<bool>(doStream))
+        ("depth", "Max decoded frames in flight per input (streaming)", cxxopts::value<int>(depth))
+        ("prefetch", "Decode frames ahead of detection (look-ahead window, 0 = off)", cxxopts::value<int>(prefetch))
+        ("reduce", "Decode stills at 1/n resolution: 1, 2, 4 or 8 (JPEG)", cxxopts::value<int>(reduction))
         ("version", "Report library version", cxxopts::value<bool>(doVersion))        
         ("h,help", "Print help message");
     // clang-format on
@@ -218,6 +273,16 @@ int gauze_main(int argc, char** argv)
         return 0;
     }    
 
+    if (!sBundle.empty())
+    {
+        if (!drishti::face::FaceDetectorFactoryBundle::pack(sFactory, sBundle))
+        {
+            logger->error("Failed to pack {} into {}", sFactory, sBundle);
+            return 1;
+        }
+        return 0;
+    }
+
     // ############################################
     // ### Command line argument error checking ###
     // ############################################
@@ -240,23 +305,58 @@ int gauze_main(int argc, char** argv)
         return 1;
     }
 
+    if (mergeCount > 0)
+    {
+        const std::vector<std::pair<std::string, drishti::core::AppendSink::Format>> outputs{
+            { ".jsonl", drishti::core::AppendSink::kLines },
+            { ".tar", drishti::core::AppendSink::kTar }
+        };
+        for (const auto& output : outputs)
+        {
+            std::size_t entries = 0;
+            if (!mergeShards(sOutput + "/faces", output.first, mergeCount, output.second, entries))
+            {
+                logger->error("Missing shards of {}/faces{}", sOutput, output.first);
+                return 1;
+            }
+            logger->info("Merged {} entries into {}/faces{}", entries, sOutput, output.first);
+        }
+        return 0;
+    }
+
+    drishti::cli::shard::Spec shard;
+    if (!sShard.empty() && !drishti::cli::shard::parse(sShard, shard))
+    {
+        logger->error("Invalid shard {} (expected <index>/<count>)", sShard);
+        return 1;
+    }
+
     // ### Input
-    if (sInput.empty())
+    if (sInputs.empty())
     {
         logger->error("Must specify input image or list of images");
         return 1;
     }
-    if (!drishti::cli::file::exists(sInput))
+    for (const auto& sInput : sInputs)
     {
-        logger->error("Specified input file does not exist or is not readable");
-        return 1;
+        if (!drishti::cli::file::exists(sInput))
+        {
+            logger->error("Specified input file {} does not exist or is not readable", sInput);
+            return 1;
+        }
     }
 
-    if (!sFactory.empty())
+    const bool isBundle = !sFactory.empty() && drishti::core::ModelBundle::isBundle(sFactory);
+    if (isBundle)
+    {
+        factory = std::make_shared<drishti::face::FaceDetectorFactoryBundle>(sFactory);
+    }
+    else if (!sFactory.empty())
     {
         factory = std::make_shared<drishti::face::FaceDetectorFactoryJson>(sFactory);
     }
     factory->inner = doInner;
+    factory->lite = doLite;
 
     // Check for valid models
     std::vector<std::pair<std::string, std::string>> config{
@@ -268,7 +368,7 @@ int gauze_main(int argc, char** argv)
 
     for (const auto& c : config)
     {
-        if (checkModel(logger, c.first, c.second))
+        if (!isBundle && checkModel(logger, c.first, c.second)) // bundle entries are verified on load
         {
             return 1;
         }
@@ -281,34 +381,54 @@ int gauze_main(int argc, char** argv)
     }
 #endif
 
-    auto video = drishti::videoio::VideoSourceCV::create(sInput);
-
     // Allocate resource manager:
     using FaceDetectorPtr = std::unique_ptr<drishti::face::FaceDetector>;
     drishti::core::LazyParallelResource<std::thread::id, FaceDetectorPtr> manager = [&]() {
 
         FaceDetectorPtr detector = drishti::core::make_unique<drishti::face::FaceDetector>(*factory);
 
+        // Cascade threhsold adjustment:
+        auto calibrate = [&](drishti::ml::ObjectDetectorACF& acf) {
+            if (cascCal != 0.f)
+            {
+                acf::Detector::Modify dflt;
+                dflt.cascThr = { "cascThr", -1.0 };
+                dflt.cascCal = { "cascCal", cascCal };
+                acf.getDetector()->acfModify(dflt);
+            }
+        };
+
         if (detector)
         {
             detector->setScaling(scale);
             detector->setLandmarkFormat( factory->inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);
-            
-            // Cofigure parameters:
-            detector->setDoNMS(true);
-            detector->setDoNMSGlobal(true);
 
             auto acf = dynamic_cast<drishti::ml::ObjectDetectorACF*>(detector->getDetector());
             if (acf && acf->good())
             {
-                // Cascade threhsold adjustment:
-                if (cascCal != 0.f)
+                calibrate(*acf);
+
+                // The tiles of one image are shared by several instances of the model:
+                if (tiling.tile > 0)
                 {
-                    acf::Detector::Modify dflt;
-                    dflt.cascThr = { "cascThr", -1.0 };
-                    dflt.cascCal = { "cascCal", cascCal };
-                    acf->getDetector()->acfModify(dflt);
+                    const int workers = (tileThreads > 0) ? tileThreads : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+                    std::vector<std::unique_ptr<drishti::ml::ObjectDetectorACF>> instances;
+                    for (int i = 0; i < workers; i++)
+                    {
+                        auto instance = factory->getFaceDetector();
+                        if (auto* tile = dynamic_cast<drishti::ml::ObjectDetectorACF*>(instance.get()))
+                        {
+                            calibrate(*tile);
+                            instance.release();
+                            instances.emplace_back(tile);
+                        }
+                    }
+                    detector->setDetector(drishti::core::make_unique<drishti::ml::ObjectDetectorACFTiled>(std::move(instances), tiling));
                 }
+
+                // Cofigure parameters (a tiled image keeps all faces):
+                detector->setDoNMS(true);
+                detector->setDoNMSGlobal(tiling.tile <= 0);
             }
             else
             {
@@ -319,102 +439,319 @@ int gauze_main(int argc, char** argv)
         return detector;
     };
 
-    std::size_t total = 0;
-
-    // Parallel loop:
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+    // Detection + regression for one BGR image (thread safe):
+    auto detect = [&](const cv::Mat& image, Faces& faces) {
         // Get thread specific segmenter lazily:
         auto& detector = manager[std::this_thread::get_id()];
         assert(detector);
 
-        // Load current image:
-        auto frame = (*video)(i);
-        const auto& image = frame.image;
+        cv::Mat Irgb;
+        cv::cvtColor(image, Irgb, cv::COLOR_BGR2RGB);
+
+        Resizer resizer(Irgb, detector->getWindowSize(), minWidth);
+
+        const auto& Hdr = resizer.getDetectorToRegressor();
+        (*detector)(resizer.getPlanar(), resizer.getPadded(), faces, Hdr);
 
-        if (!image.empty())
+        resizer(faces);
+    };
+
+    // Consolidated outputs, written by one background thread each (per shard).  An item is
+    // done once it is marked in every output:
+    const std::string sBase = sOutput + "/faces" + shard.suffix();
+    std::vector<drishti::core::AppendSink*> checkpoints;
+    std::vector<std::string> sCheckpoints;
+    auto open = [&](const std::string& ext, drishti::core::AppendSink::Format format) {
+        auto output = drishti::core::make_unique<drishti::core::AppendSink>(sBase + ext, format, doResume);
+        checkpoints.push_back(output.get());
+        sCheckpoints.push_back(sBase + ext + ".done");
+        return output;
+    };
+
+    std::unique_ptr<drishti::core::AppendSink> sink, archive, progress;
+    if (doSink)
+    {
+        sink = open(".jsonl", drishti::core::AppendSink::kLines);
+    }
+    if (doArchive)
+    {
+        archive = open(".tar", drishti::core::AppendSink::kTar);
+    }
+    if (!(sink || archive))
+    {
+        progress = open(".progress", drishti::core::AppendSink::kLines); // marks only, images are written first
+    }
+    if (std::any_of(checkpoints.begin(), checkpoints.end(), [](const drishti::core::AppendSink* output) { return !output->good(); }))
+    {
+        logger->error("Unable to create output files in {}", sOutput);
+        return 1;
+    }
+
+    // The images of list inputs are sharded individually, videos and single images as a whole:
+    std::vector<std::string> manifest;
+    std::map<std::string, std::string> owners; // image -> list
+    for (const auto& sInput : sInputs)
+    {
+        const auto items = drishti::cli::expand(sInput);
+        const bool isList = (items.size() != 1) || (items.front() != sInput);
+        for (const auto& item : items)
         {
-            cv::Mat Irgb;
-            cv::cvtColor(image, Irgb, cv::COLOR_BGR2RGB);
+            manifest.push_back(item);
+            if (isList)
+            {
+                owners[item] = sInput;
+            }
+        }
+    }
 
-            Resizer resizer(Irgb, detector->getWindowSize(), minWidth);
+    const auto selected = drishti::cli::shard::select(manifest, shard, doResume ? drishti::cli::shard::completed(sCheckpoints) : std::set<std::string>());
+    logger->info("Shard {}/{}: {} of {} inputs", shard.index, shard.count, selected.size(), manifest.size());
 
-            std::vector<drishti::face::FaceModel> faces;
-            const auto& Hdr = resizer.getDetectorToRegressor();
-            (*detector)(resizer.getPlanar(), resizer.getPadded(), faces, Hdr);
+    // Pending inputs in command line order, lists are reduced to their pending images:
+    std::map<std::string, std::vector<std::string>> lists;
+    std::set<std::string> pending;
+    for (const auto& item : selected)
+    {
+        const auto iter = owners.find(item);
+        if (iter != owners.end())
+        {
+            lists[iter->second].push_back(item);
+            pending.insert(iter->second);
+        }
+        else
+        {
+            pending.insert(item);
+        }
+    }
+    sInputs.erase(std::remove_if(sInputs.begin(), sInputs.end(), [&](const std::string& input) { return !pending.count(input); }), sInputs.end());
+
+    auto createSource = [&](const std::string& input) -> VideoSourcePtr {
+        const auto iter = lists.find(input);
+        if (iter != lists.end())
+        {
+            return std::make_shared<drishti::videoio::VideoSourceStills>(iter->second);
+        }
+        return drishti::videoio::VideoSourceCV::create(input);
+    };
+
+    // After all outputs of an item (see AppendSink::mark()):
+    auto mark = [&](const std::string& item) {
+        for (auto* checkpoint : checkpoints)
+        {
+            checkpoint->mark(item);
+        }
+    };
 
-            resizer(faces);
+    // Images of list inputs are done one at a time, other inputs once all frames are done:
+    auto markFrame = [&](const std::string& input, const Frame& frame) {
+        if (!frame.image.empty() && lists.count(input))
+        {
+            mark(frame.name);
+        }
+    };
 
-            if (!doPositiveOnly || (faces.size() > 0))
+    auto markInputs = [&](const std::vector<std::string>& inputs) {
+        for (const auto& input : inputs)
+        {
+            if (!lists.count(input))
             {
-                // Construct valid filename with no extension:
-                std::string base = drishti::core::basename(frame.name);
-                std::string filename = sOutput + "/" + base;
+                mark(input);
+            }
+        }
+    };
 
-                logger->info("{}/{} {} = {}", ++total, video->count(), filename, faces.size());
+    auto closeSinks = [&]() {
+        if (sink)
+        {
+            logger->info("Wrote {} results to {}.jsonl", sink->close(), sBase);
+        }
+        if (archive)
+        {
+            logger->info("Wrote {} images to {}.tar", archive->close(), sBase);
+        }
+        if (progress)
+        {
+            progress->close();
+        }
+    };
 
-                // Save detection results in JSON:
-                if (!writeAsJson(filename + ".json", faces))
-                {
-                    logger->error("Failed to write: {}.json", filename);
-                }
+    // Write one image to the archive or to its own file:
+    auto writeImage = [&](const std::string& filename, const cv::Mat& image) {
+        if (archive)
+        {
+            std::vector<uchar> bytes;
+            cv::imencode(".png", image, bytes);
+            archive->push(filename.substr(sOutput.size() + 1), std::string(bytes.begin(), bytes.end()));
+        }
+        else
+        {
+            cv::imwrite(filename, image);
+        }
+    };
+
+    // Write all outputs for one image, filename has no extension:
+    auto output = [&](const cv::Mat& image, const std::string& filename, const Faces& faces, double elapsed) {
+        // Save detection results in JSON:
+        if (sink)
+        {
+            sink->push(toJsonLine(filename.substr(sOutput.size() + 1), elapsed, faces));
+        }
+        else if (!writeAsJson(filename + ".json", faces))
+        {
+            logger->error("Failed to write: {}.json", filename);
+        }
 
 #if defined(DRISHTI_USE_IMSHOW)
-                int windowCount = 0;
-                drishti::core::scope_guard waiter = [&]() {
-                    if (windowCount > 0)
-                    {
-                        glfw::waitKey(doPause ? 0 : 1);
-                    }
-                };
+        int windowCount = 0;
+        drishti::core::scope_guard waiter = [&]() {
+            if (windowCount > 0)
+            {
+                glfw::waitKey(doPause ? 0 : 1);
+            }
+        };
 #endif
 
-                if (doEyes)
-                {
-                    for (int i = 0; i < faces.size(); i++)
-                    {
-                        cv::Mat eyes = cropEyes(image, faces[i], { 640, 240 }, 0.666f, doAnnotation);
+        if (doEyes)
+        {
+            for (int i = 0; i < faces.size(); i++)
+            {
+                cv::Mat eyes = cropEyes(image, faces[i], { 640, 240 }, 0.666f, doAnnotation);
 
-                        std::stringstream ss;
-                        ss << std::setfill('0') << std::setw(2) << i;
-                        cv::imwrite(filename + ss.str() + "_eyes.png", eyes);
+                std::stringstream ss;
+                ss << std::setfill('0') << std::setw(2) << i;
+                writeImage(filename + ss.str() + "_eyes.png", eyes);
 
 #if defined(DRISHTI_USE_IMSHOW)
-                        if (doDisplay)
-                        {
-                            windowCount++;
-                            glfw::imshow("eyes", eyes);
-                        }
-#endif
-                    }
+                if (doDisplay)
+                {
+                    windowCount++;
+                    glfw::imshow("eyes", eyes);
                 }
+#endif
+            }
+        }
 
-                if (doAnnotation)
-                {
-                    cv::Mat canvas = image.clone();
-                    drawObjects(canvas, faces);
-                    cv::imwrite(filename + "_faces.png", canvas);
+        if (doAnnotation)
+        {
+            cv::Mat canvas = image.clone();
+            drawObjects(canvas, faces);
+            writeImage(filename + "_faces.png", canvas);
 
 #if defined(DRISHTI_USE_IMSHOW)
-                    if (doDisplay)
-                    {
-                        windowCount++;
-                        glfw::imshow("face", canvas);
-                    }
-#endif
-                }
+            if (doDisplay)
+            {
+                windowCount++;
+                glfw::imshow("face", canvas);
             }
+#endif
         }
     };
 
-    if (threads == 1 || threads == 0 || doDisplay || !video->isRandomAccess())
+    if (doStream && !doDisplay)
     {
-        harness({ 0, static_cast<int>(video->count()) });
+        const int workers = (threads > 0) ? threads : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+        // Load one detector per worker concurrently, before the first frame:
+        manager.reserve(workers);
+
+        std::size_t total = 0; // reports are serialized per input only
+        std::mutex totalMutex;
+
+        auto report = [&](const std::string& input, const Frame& frame, const Faces& faces, double elapsed) {
+            if (!frame.image.empty() && (!doPositiveOnly || (faces.size() > 0)))
+            {
+                const std::string filename = sOutput + "/" + getFrameName(input, frame);
+
+                {
+                    std::lock_guard<std::mutex> lock(totalMutex);
+                    logger->info("{} {} = {}", ++total, filename, faces.size());
+                }
+
+                output(frame.image, filename, faces, elapsed);
+            }
+            markFrame(input, frame);
+        };
+
+        auto create = [&](const std::string& input) {
+            VideoSourcePtr video = createSource(input);
+            video->setReduction(reduction);
+            if (prefetch > 0)
+            {
+                video = std::make_shared<drishti::videoio::VideoSourcePrefetch>(video, prefetch);
+            }
+            return video;
+        };
+
+        runStreams(sInputs, create, workers, std::max(depth, 1), detect, report);
+        markInputs(sInputs);
+        closeSinks();
+        return 0;
     }
-    else
+
+    for (const auto& sInput : sInputs)
     {
-        cv::parallel_for_({ 0, static_cast<int>(video->count()) }, harness, std::max(threads, -1));
+        VideoSourcePtr video = createSource(sInput);
+        video->setReduction(reduction);
+
+        // The prefetcher expects increasing frame indices, i.e., the sequential loop:
+        const bool isSequential = (threads == 1 || threads == 0 || doDisplay || !video->isRandomAccess());
+        if (isSequential && (prefetch > 0))
+        {
+            video = std::make_shared<drishti::videoio::VideoSourcePrefetch>(video, prefetch);
+        }
+
+        std::size_t total = 0;
+
+        // Parallel loop:
+        drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+            // Load current image:
+            auto frame = (*video)(i);
+            const auto& image = frame.image;
+
+            if (!image.empty())
+            {
+                const auto tic = std::chrono::high_resolution_clock::now();
+                Faces faces;
+                detect(image, faces);
+                const double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tic).count();
+
+                if (!doPositiveOnly || (faces.size() > 0))
+                {
+                    // Construct valid filename with no extension:
+                    std::string filename = sOutput + "/" + getFrameName(sInput, frame);
+
+                    logger->info("{}/{} {} = {}", ++total, video->count(), filename, faces.size());
+
+                    output(image, filename, faces, elapsed);
+                }
+            }
+            markFrame(sInput, frame);
+        };
+
+        if (isSequential)
+        {
+            harness({ 0, static_cast<int>(video->count()) });
+        }
+        else
+        {
+            // Frames without faces return early, so claim one frame at a time:
+            drishti::core::ParallelSettings settings;
+            settings.threads = threads;
+            settings.grain = 1;
+
+            // Load one detector per worker concurrently, before the first batch:
+            if (manager.getMap().empty())
+            {
+                const int workers = (threads > 0) ? threads : static_cast<int>(std::thread::hardware_concurrency());
+                manager.reserve(std::min(static_cast<int>(video->count()), std::max(workers, 1)));
+            }
+            drishti::core::parallelFor({ 0, static_cast<int>(video->count()) }, harness, settings);
+        }
+        markInputs({ sInput });
     }
 
+    closeSinks();
+
     return 0;
 }
 
@@ -439,6 +776,187 @@ int main(int argc, char** argv)
 
 // utility:
 
+// Output name (no extension) for a frame, video frames are unnamed:
+static std::string
+getFrameName(const std::string& input, const Frame& frame)
+{
+    if (!frame.name.empty())
+    {
+        return drishti::core::basename(frame.name);
+    }
+
+    std::stringstream ss;
+    ss << drishti::core::basename(input) << "_" << std::setfill('0') << std::setw(6) << frame.index;
+    return ss.str();
+}
+
+// Combine the per shard outputs of a sharded run (base + ".<i>-of-<n>" + ext), returns false
+// if only some of the shard files exist:
+static bool
+mergeShards(const std::string& base, const std::string& ext, int count, drishti::core::AppendSink::Format format, std::size_t& entries)
+{
+    std::vector<std::string> inputs;
+    for (int i = 0; i < count; i++)
+    {
+        drishti::cli::shard::Spec spec;
+        spec.index = i;
+        spec.count = count;
+        if (drishti::cli::file::exists(base + spec.suffix() + ext))
+        {
+            inputs.push_back(base + spec.suffix() + ext);
+        }
+    }
+
+    entries = 0;
+    if (!inputs.empty() && (static_cast<int>(inputs.size()) == count))
+    {
+        entries = drishti::core::AppendSink::merge(inputs, base + ext, format);
+    }
+    return inputs.empty() || (static_cast<int>(inputs.size()) == count);
+}
+
+// Streaming batch mode:
+//
+// Each input is decoded sequentially (no seeking) on a dedicated thread into a window of at
+// most depth frames, detection and regression run on a pool of workers shared by all inputs,
+// and each input reports its frames in frame order as the head of its window completes.
+
+struct StreamJob
+{
+    Frame frame;
+    Faces faces;
+    double elapsed = 0.0; // detection + regression (seconds)
+    bool done = false;
+};
+
+struct Stream
+{
+    std::string input;
+    std::deque<std::shared_ptr<StreamJob>> window; // decoded frames in frame order
+    bool writing = false;                          // a worker is reporting the window head
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+static void
+drainStream(Stream& stream, StreamJob& job, const FrameReporter& report)
+{
+    std::unique_lock<std::mutex> lock(stream.mutex);
+    job.done = true;
+    if (stream.writing)
+    {
+        return; // the active writer will pick this one up
+    }
+
+    stream.writing = true;
+    while (!stream.window.empty() && stream.window.front()->done)
+    {
+        auto head = std::move(stream.window.front());
+        stream.window.pop_front();
+        lock.unlock();
+        stream.cv.notify_one(); // free a slot for the decoder
+
+        report(stream.input, head->frame, head->faces, head->elapsed);
+
+        lock.lock();
+    }
+    stream.writing = false;
+}
+
+static void
+runStreams(const std::vector<std::string>& inputs, const VideoFactory& create, int workers, int depth, const FrameProcessor& process, const FrameReporter& report)
+{
+    std::vector<std::unique_ptr<Stream>> streams;
+    for (const auto& input : inputs)
+    {
+        streams.push_back(drishti::core::make_unique<Stream>());
+        streams.back()->input = input;
+    }
+
+    // Work queue shared by all inputs:
+    std::deque<std::pair<Stream*, std::shared_ptr<StreamJob>>> queue;
+    std::size_t decoders = streams.size();
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    auto decode = [&](Stream& stream) {
+        auto video = create(stream.input);
+
+        // Sequential sources report an estimated count, so read them to the first empty frame:
+        const bool isRandomAccess = video->isRandomAccess();
+        for (std::size_t i = 0; !isRandomAccess || (i < video->count()); i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(stream.mutex);
+                stream.cv.wait(lock, [&]() { return stream.window.size() < static_cast<std::size_t>(depth); });
+            }
+
+            auto job = std::make_shared<StreamJob>();
+            job->frame = (*video)(static_cast<int>(i));
+            job->frame.index = i;
+            if (job->frame.image.empty() && !isRandomAccess)
+            {
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(stream.mutex);
+                stream.window.push_back(job);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.emplace_back(&stream, job);
+            }
+            cv.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decoders--;
+        }
+        cv.notify_all();
+    };
+
+    auto work = [&]() {
+        while (true)
+        {
+            std::pair<Stream*, std::shared_ptr<StreamJob>> item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() { return !queue.empty() || !decoders; });
+                if (queue.empty())
+                {
+                    return;
+                }
+                item = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            if (!item.second->frame.image.empty())
+            {
+                const auto tic = std::chrono::high_resolution_clock::now();
+                process(item.second->frame.image, item.second->faces);
+                item.second->elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tic).count();
+            }
+            drainStream(*item.first, *item.second, report);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto& stream : streams)
+    {
+        threads.emplace_back(decode, std::ref(*stream));
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        threads.emplace_back(work);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
 static bool
 checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description)
 {
@@ -486,6 +1004,23 @@ writeAsJson(const std::string& filename, const std::vector<drishti::face::FaceMo
     return ofs.good();
 }
 
+// Single line JSON record for line-delimited result files:
+static std::string
+toJsonLine(const std::string& filename, double elapsed, const std::vector<drishti::face::FaceModel>& faces)
+{
+    std::stringstream ss;
+    {
+        cereal::JSONOutputArchive oa(ss, cereal::JSONOutputArchive::Options::NoIndent());
+        using Archive = decltype(oa); // needed by macro
+        oa << GENERIC_NVP("filename", filename);
+        oa << GENERIC_NVP("elapsed", elapsed);
+        oa << GENERIC_NVP("faces", faces);
+    }
+    std::string line = ss.str();
+    line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
+    return line;
+}
+
 static void
 drawObjects(cv::Mat& canvas, const std::vector<drishti::face::FaceModel>& faces)
 {
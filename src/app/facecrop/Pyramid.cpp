@@ -10,6 +10,10 @@
 
 #include "Pyramid.h"
 
+#include "drishti/core/Parallel.h"
+
+#include <algorithm>
+
 bool gaussianPyramid(const cv::Mat& src, std::vector<cv::Mat>& result, int level)
 {
     result.clear();
@@ -102,3 +106,148 @@ cv::Mat blend(const cv::Mat& im1, const cv::Mat& im2, const cv::Mat& mask, int l
 
     return blended;
 }
+
+// dst = a + m * (b - a) + up, with a 1 or 3 channel mask m, in one pass over the level:
+template <typename T>
+static void blendLevel(const cv::Mat& a, const cv::Mat& b, const cv::Mat& m, const cv::Mat* up, cv::Mat& dst, float scale)
+{
+    const int channels = a.channels(), maskStep = (m.channels() == 1) ? 0 : 1;
+    for (int y = 0; y < a.rows; y++)
+    {
+        const float* pa = a.ptr<float>(y);
+        const float* pb = b.ptr<float>(y);
+        const float* pm = m.ptr<float>(y);
+        const float* pu = up ? up->ptr<float>(y) : nullptr;
+        T* pd = dst.ptr<T>(y);
+        for (int x = 0; x < a.cols; x++, pm += (maskStep ? channels : 1))
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                const int k = x * channels + c;
+                float value = pa[k] + pm[c * maskStep] * (pb[k] - pa[k]);
+                if (pu)
+                {
+                    value += pu[k];
+                }
+                pd[k] = cv::saturate_cast<T>(value * scale);
+            }
+        }
+    }
+}
+
+// Reduce and expand each level once, the laplacian is formed in place (src is level 0):
+static void laplacianPyramidInPlace(std::vector<cv::Mat>& lap, std::vector<cv::Mat>& up)
+{
+    for (std::size_t i = 0; (i + 1) < lap.size(); i++)
+    {
+        cv::pyrDown(lap[i], lap[i + 1], cv::Size((lap[i].cols + 1) / 2, (lap[i].rows + 1) / 2));
+        cv::pyrUp(lap[i + 1], up[i], lap[i].size());
+        cv::subtract(lap[i], up[i], lap[i]);
+    }
+}
+
+PyramidBlender::PyramidBlender(int level, bool doParallel)
+    : m_level(std::max(level, 0))
+    , m_doParallel(doParallel)
+{
+}
+
+PyramidBlender::Buffers& PyramidBlender::getBuffers(const cv::Size& size)
+{
+    // A few sizes are kept (e.g., alternating crop sizes), most recent first:
+    static const std::size_t kMaxSizes = 4;
+
+    auto iter = std::find_if(m_buffers.begin(), m_buffers.end(), [&](const std::pair<cv::Size, Buffers>& entry) {
+        return entry.first == size;
+    });
+    if (iter == m_buffers.end())
+    {
+        if (m_buffers.size() >= kMaxSizes)
+        {
+            m_buffers.pop_back();
+        }
+        Buffers buffers;
+        for (auto* levels : { &buffers.lap1, &buffers.lap2, &buffers.gaussian, &buffers.up1, &buffers.up2 })
+        {
+            levels->resize(m_level + 1);
+        }
+        m_buffers.emplace(m_buffers.begin(), size, std::move(buffers));
+    }
+    else if (iter != m_buffers.begin())
+    {
+        std::rotate(m_buffers.begin(), iter, iter + 1);
+    }
+    return m_buffers.front().second;
+}
+
+bool PyramidBlender::operator()(const cv::Mat& im1, const cv::Mat& im2, const cv::Mat& mask, cv::Mat& result)
+{
+    if (im1.empty() || (im1.size() != im2.size()) || (im1.size() != mask.size()))
+    {
+        return false;
+    }
+    CV_Assert((im1.type() == CV_8UC3) && (im2.type() == CV_8UC3));
+    CV_Assert((mask.type() == CV_8UC1) || (mask.type() == CV_8UC3));
+
+    Buffers& buffers = getBuffers(im1.size());
+
+    // The three pyramids are independent (create() reuses the level buffers):
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        switch (i)
+        {
+            case 0:
+                im1.convertTo(buffers.lap1[0], CV_32FC3, 1.0 / 255.0);
+                laplacianPyramidInPlace(buffers.lap1, buffers.up1);
+                break;
+            case 1:
+                im2.convertTo(buffers.lap2[0], CV_32FC3, 1.0 / 255.0);
+                laplacianPyramidInPlace(buffers.lap2, buffers.up2);
+                break;
+            case 2:
+                mask.convertTo(buffers.gaussian[0], CV_32FC(mask.channels()), 1.0 / 255.0);
+                for (int j = 0; j < m_level; j++)
+                {
+                    const cv::Mat& src = buffers.gaussian[j];
+                    cv::pyrDown(src, buffers.gaussian[j + 1], cv::Size((src.cols + 1) / 2, (src.rows + 1) / 2));
+                }
+                break;
+        }
+    };
+
+    if (m_doParallel)
+    {
+        cv::parallel_for_({ 0, 3 }, harness);
+    }
+    else
+    {
+        harness({ 0, 3 });
+    }
+
+    // Blend and collapse in one pass per level (from coarse to fine), lap1 is overwritten:
+    auto& lap1 = buffers.lap1;
+    auto& lap2 = buffers.lap2;
+    auto& gaussian = buffers.gaussian;
+    auto& up = buffers.up1;
+
+    blendLevel<float>(lap1[m_level], lap2[m_level], gaussian[m_level], nullptr, lap1[m_level], 1.f);
+    for (int i = m_level - 1; i >= 0; i--)
+    {
+        cv::pyrUp(lap1[i + 1], up[i], lap1[i].size());
+        if (i > 0)
+        {
+            blendLevel<float>(lap1[i], lap2[i], gaussian[i], &up[i], lap1[i], 1.f);
+        }
+        else
+        {
+            result.create(im1.size(), CV_8UC3);
+            blendLevel<uint8_t>(lap1[0], lap2[0], gaussian[0], &up[0], result, 255.f);
+        }
+    }
+
+    if (m_level == 0)
+    {
+        lap1[0].convertTo(result, CV_8UC3, 255.0);
+    }
+
+    return true;
+}
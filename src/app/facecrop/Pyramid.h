@@ -14,10 +14,42 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <utility>
+#include <vector>
+
 // https://github.com/t-suzuki/laplacian_pyramid_blend_test/blob/master/lp_blend.cpp
 bool gaussianPyramid(const cv::Mat& src, std::vector<cv::Mat>& result, int level);
 bool laplacianPyramid(const cv::Mat& src, std::vector<cv::Mat>& result, int level);
 bool inverseLaplacianPyramid(std::vector<cv::Mat>& src, cv::Mat& result);
 cv::Mat blend(const cv::Mat& im1, const cv::Mat& im2, const cv::Mat& mask, int level);
 
+// Laplacian pyramid blending with level buffers that are reused across calls (one set per image
+// size), concurrent construction of the three pyramids and fused blend + expand passes.  An
+// instance isn't thread safe (use one per thread):
+class PyramidBlender
+{
+public:
+    explicit PyramidBlender(int level = 6, bool doParallel = true);
+
+    // Same as blend() (mask == 255 selects im2) with 8 bit (CV_8UC3) output, result may be im1.  The
+    // mask is CV_8UC1 or CV_8UC3:
+    bool operator()(const cv::Mat& im1, const cv::Mat& im2, const cv::Mat& mask, cv::Mat& result);
+
+    int getLevel() const { return m_level; }
+
+protected:
+    struct Buffers
+    {
+        std::vector<cv::Mat> lap1, lap2, gaussian; // level + 1 levels (lap1 is collapsed in place)
+        std::vector<cv::Mat> up1, up2;             // expand scratch per level
+    };
+
+    Buffers& getBuffers(const cv::Size& size);
+
+    int m_level = 6;
+    bool m_doParallel = true;
+
+    std::vector<std::pair<cv::Size, Buffers>> m_buffers; // most recent size first
+};
+
 #endif // __drishti_facecrop_Pyramid_h__
@@ -45,6 +45,7 @@
 #include "drishti/testlib/drishti_cli.h"
 #include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/face/Face.h" // for face model
+#include "drishti/face/FaceBulkIO.h"
 
 // clang-format off
 #if defined(DRISHTI_BUILD_EOS)
@@ -61,6 +62,7 @@
 #include "landmarks/DRISHTI.h"
 #include "landmarks/TWO.h"
 #include "landmarks/DlibXML.h"
+#include "landmarks/FaceRecords.h"
 
 #include "FaceSpecification.h"
 #include "FaceJitterer.h"
@@ -97,10 +99,12 @@ enum GroundTruthFormat
     DRISHTIFormat,
     LFPWFormat,
     TWOFormat,
+    CSVFormat,
+    JSONLFormat,
     RAWFormat
 };
 
-#define SUPPORTED_FORMATS "muct,fddb,helen,bioid,lfw,drishti,lfpw,two"
+#define SUPPORTED_FORMATS "muct,fddb,helen,bioid,lfw,drishti,lfpw,two,csv,jsonl"
 
 struct GroundTruth
 {
@@ -177,7 +181,7 @@ using ImageVec = std::vector<cv::Mat>;
 using FaceJittererMeanPtr = std::unique_ptr<FaceJittererMean>;
 using FaceResourceManager = drishti::core::LazyParallelResource<std::thread::id, FaceJittererMeanPtr>;
 static int saveNegatives(const FACE::Table& table, const std::string& sOutput, int sampleCount, int winSize, int threads, spdlog::logger& logger);
-static int saveInpaintedSamples(const FACE::Table& table, const std::string& sBackground, const std::string& sOutput, spdlog::logger& logger);
+static int saveInpaintedSamples(const FACE::Table& table, const std::string& sBackground, const std::string& sOutput, int threads, spdlog::logger& logger);
 static FaceWithLandmarks computeMeanFace(FaceResourceManager& manager);
 static void saveMeanFace(FaceResourceManager& manager, const FaceSpecification& faceSpec, const std::string& sImage, const std::string& sPoints, spdlog::logger& logger);
 static int saveDefaultConfigs(const std::string& sOutput, spdlog::logger& logger);
@@ -185,8 +189,19 @@ static void save(std::vector<FaceWithLandmarks>& faces, const cv::Rect& roi, con
 static void previewFaceWithLandmarks(cv::Mat& image, const std::vector<cv::Point2f>& landmarks);
 static GroundTruth parseInput(const std::string& sInput, const std::string& sFormat, const std::string& sDirectoryIn, const std::string& sExtension);
 static FACE::Table parseRAW(const std::string& sInput);
+static FACE::Table parseBulk(const std::string& sInput, bool isCsv);
 static int standardizeFaceData(const FACE::Table& table, const std::string& sOutput);
 
+// Dataset packing (see landmarks/FaceRecords.h):
+struct PackSettings
+{
+    float crop = 0.f;          // crop to the landmark bounding box scaled by this factor (0 == full image)
+    int width = 0;             // max image width (0 == full resolution)
+    int shardSize = 0;         // records per shard (0 == single file)
+    std::string codec = "png"; // png, jpg, raw or lz4
+};
+static int packFaceData(const FACE::Table& table, const std::string& sOutput, const PackSettings& settings, int threads, spdlog::logger& logger);
+
 #if defined(DRISHTI_BUILD_EOS)
 // Face pose estimation...
 using FaceMeshMapperPtr = std::unique_ptr<drishti::face::FaceMeshMapperEOSLandmark>;
@@ -208,6 +223,9 @@ int gauze_main(int argc, char* argv[])
     std::string sInput;
     std::string sFormat;
     std::string sPositives;
+    std::string sRecords;
+    std::string sPack;
+    PackSettings packSettings;
     std::string sNegatives;
     std::string sDirectory;
     std::string sExtension;
@@ -244,6 +262,7 @@ int gauze_main(int argc, char* argv[])
     options.add_options()
         ("i,input", "Input file", cxxopts::value<std::string>(sInput))
         ("p,positives", "Positives directory", cxxopts::value<std::string>(sPositives))
+        ("records", "Positives record file (streamed alternative to the positives directory)", cxxopts::value<std::string>(sRecords))
         ("f,format", "Format:" SUPPORTED_FORMATS, cxxopts::value<std::string>(sFormat))
         ("d,directory", "Base (d)irectory", cxxopts::value<std::string>(sDirectory))
         ("s,specification", "Face specification", cxxopts::value<std::string>(sFaceSpec))
@@ -268,6 +287,13 @@ int gauze_main(int argc, char* argv[])
         ("W,winsize", "Minimum window size", cxxopts::value<int>(winSize))
         ("B,background", "Background image list", cxxopts::value<std::string>(sBackground))
 
+        // Dataset packing:
+        ("pack", "Pack images and landmarks into record file shards (see --pack-*)", cxxopts::value<std::string>(sPack))
+        ("pack-crop", "Crop to the landmark bounding box scaled by this factor (0 == full image)", cxxopts::value<float>(packSettings.crop))
+        ("pack-width", "Max packed image width (0 == full resolution)", cxxopts::value<int>(packSettings.width))
+        ("pack-shard", "Records per shard (0 == single file)", cxxopts::value<int>(packSettings.shardSize))
+        ("pack-codec", "Image codec: png, jpg, raw or lz4", cxxopts::value<std::string>(packSettings.codec))
+
         // Output parameters:
         ("t,threads", "Thread count", cxxopts::value<int>(threads))
         ("h,help", "Print help message");
@@ -286,9 +312,9 @@ int gauze_main(int argc, char* argv[])
     // ############################################
 
     // ### Directory
-    if(sPositives.empty() && sNegatives.empty())
+    if(sPositives.empty() && sRecords.empty() && sNegatives.empty() && sPack.empty())
     {
-        logger->error("Must specify output directory (positives or negatives)");
+        logger->error("Must specify output directory (positives or negatives) or record file");
         return 1;
     }
 
@@ -367,12 +393,12 @@ int gauze_main(int argc, char* argv[])
     //::: Face normalization params :::
     //:::::::::::::::::::::::::::::::::
     FaceSpecification faceSpec;
-    if(sFaceSpec.empty())
+    if(sFaceSpec.empty() && sPack.empty()) // packing uses source image coordinates
     {
         logger->error("Error: must provide valid face specification");
         return -1;
     }
-    else
+    else if(!sFaceSpec.empty())
     {
         std::ifstream is(sFaceSpec);
         if(is)
@@ -414,6 +440,11 @@ int gauze_main(int argc, char* argv[])
         return standardizeFaceData(table, sStandardize);
     }
 
+    if(!sPack.empty())
+    {
+        return packFaceData(table, sPack, packSettings, threads, *logger);
+    }
+
     if(doBoilerplate)
     {
         if(int code = saveDefaultConfigs(sPositives, *logger) < 0)
@@ -422,7 +453,7 @@ int gauze_main(int argc, char* argv[])
         }
     }
 
-    if(sPositives.empty() && !sNegatives.empty() && !doInpaint)
+    if(sPositives.empty() && sRecords.empty() && !sNegatives.empty() && !doInpaint)
     {
         // ##########################
         // ### 3) NEGATIVES ONLY  ### >>> Sample random negative windows and quit <<<
@@ -435,7 +466,7 @@ int gauze_main(int argc, char* argv[])
         // ###################################
         // ### 4) NEGATIVES w/ INPAINTING  ###
         // ###################################
-        return saveInpaintedSamples(table, sBackground, sNegatives, *logger);
+        return saveInpaintedSamples(table, sBackground, sNegatives, threads, *logger);
     }
 
     // ... ELSE STANDARD POSITIVES AND/OR NEGATIVES ...
@@ -487,6 +518,20 @@ int gauze_main(int argc, char* argv[])
         return drishti::core::make_unique<FaceJittererMean>(table, faceSpec, jitterParams);
     };
 
+    // Jittered samples are pushed to a single writer thread (encoded by the workers):
+    std::unique_ptr<FACE::FaceRecordWriter> records;
+    if(!sRecords.empty())
+    {
+        records = drishti::core::make_unique<FACE::FaceRecordWriter>(sRecords);
+        if(!records->good())
+        {
+            logger->error("Unable to open record file {}", sRecords);
+            return 1;
+        }
+    }
+
+    const cv::Rect roi(cv::Point(faceSpec.border, faceSpec.border), faceSpec.size);
+
     // ####################
     // ### 1) POSITIVES ###
     // ####################
@@ -529,10 +574,17 @@ int gauze_main(int argc, char* argv[])
 
                 if(!sPositives.empty())
                 {
-                    cv::Rect roi(cv::Point(faceSpec.border, faceSpec.border), faceSpec.size);
                     save(faces, roi, sPositives, table.lines[i].filename, i);
                 }
 
+                if(records)
+                {
+                    for(const auto &f : faces)
+                    {
+                        records->push({ table.lines[i].filename, roi, f.landmarks, f.image });
+                    }
+                }
+
                 jitterer->updateMean(faces);
 
 #if defined(DRISHTI_USE_IMSHOW)
@@ -572,7 +624,15 @@ int gauze_main(int argc, char* argv[])
         cv::parallel_for_({0,static_cast<int>(table.lines.size())}, harness, std::max(threads, -1));
     }
 
-    saveMeanFace(manager, faceSpec, sPositives + "/mean.png", sPositives + "/mean", *logger);
+    if(records)
+    {
+        logger->info("Wrote {} records to {}", records->close(), sRecords);
+    }
+
+    if(!sPositives.empty())
+    {
+        saveMeanFace(manager, faceSpec, sPositives + "/mean.png", sPositives + "/mean", *logger);
+    }
 
     return 0;
 }
@@ -636,6 +696,14 @@ static GroundTruth parseInput(const std::string &sInput, const std::string &sFor
             gt.format = LFPWFormat;
             gt.table = parseLFPW(sInput);
             break;
+        case "csv"_hash :
+            gt.format = CSVFormat;
+            gt.table = parseBulk(sInput, true);
+            break;
+        case "jsonl"_hash :
+            gt.format = JSONLFormat;
+            gt.table = parseBulk(sInput, false);
+            break;
         case "raw"_hash :
             gt.table = parseRAW(sInput);
             gt.format = RAWFormat;
@@ -683,6 +751,37 @@ static FACE::Table parseRAW(const std::string &sInput)
     return table;
 }
 
+// Parallel parse (face/FaceBulkIO.h) with a binary cache next to the input for later runs:
+static FACE::Table parseBulk(const std::string &sInput, bool isCsv)
+{
+    drishti::face::BulkSettings settings;
+    settings.cache = sInput + ".drfc";
+
+    drishti::face::FaceDataset dataset;
+    if(isCsv)
+    {
+        drishti::face::loadFacesCsv(sInput, dataset, settings);
+    }
+    else
+    {
+        drishti::face::loadFacesJsonLines(sInput, dataset, settings);
+    }
+
+    FACE::Table table;
+    for(std::size_t i = 0; i < dataset.names.size(); i++)
+    {
+        for(const auto &face : dataset.faces[i])
+        {
+            FACE::record record;
+            record.filename = dataset.names[i];
+            record.points = face.points.value;
+            record.roi = face.roi.value;
+            table.lines.push_back(record);
+        }
+    }
+    return table;
+}
+
 static std::map<std::string, std::vector<std::array<cv::Point2f, 5>>> standardizeFaceData(const FACE::Table &table)
 {
     std::map<std::string, std::vector<std::array<cv::Point2f, 5>>> landmarks;
@@ -720,6 +819,86 @@ static int standardizeFaceData(const FACE::Table &table, const std::string &sOut
     return 0;
 }
 
+static int packFaceData(const FACE::Table &table, const std::string &sOutput, const PackSettings &settings, int threads, spdlog::logger &logger)
+{
+    FACE::FaceRecordWriter::Settings records;
+    records.shardSize = static_cast<std::size_t>(std::max(settings.shardSize, 0));
+    if(settings.codec == "raw")
+    {
+        records.codec = FACE::FaceRecordWriter::kRaw;
+    }
+    else if(settings.codec == "lz4")
+    {
+        records.codec = FACE::FaceRecordWriter::kLZ4;
+    }
+    else
+    {
+        records.extension = "." + settings.codec;
+    }
+
+    FACE::FaceRecordWriter writer(sOutput, records);
+    if(!writer.good())
+    {
+        logger.error("Unable to open record file {}", sOutput);
+        return 1;
+    }
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i)
+    {
+        const auto &r = table.lines[i];
+        if(r.points.empty())
+        {
+            return;
+        }
+
+        cv::Mat image = cv::imread(r.filename, cv::IMREAD_COLOR);
+        if(image.empty())
+        {
+            return;
+        }
+
+        std::vector<cv::Point2f> points = r.points;
+
+        cv::Rect crop({0,0}, image.size());
+        if(settings.crop > 0.f)
+        {
+            const cv::Rect roi = cv::boundingRect(points);
+            const cv::Point2f tl = roi.tl(), br = roi.br(), center = (br + tl) * 0.5f, diag = (br - tl) * (0.5f * settings.crop);
+            crop &= cv::Rect(center - diag, center + diag);
+            for(auto &p : points)
+            {
+                p -= cv::Point2f(crop.tl());
+            }
+        }
+
+        cv::Mat packed = image(crop);
+        if((settings.width > 0) && (packed.cols > settings.width))
+        {
+            const float scale = static_cast<float>(settings.width) / static_cast<float>(packed.cols);
+            cv::resize(packed, packed, {}, scale, scale, cv::INTER_AREA);
+            for(auto &p : points)
+            {
+                p *= scale;
+            }
+        }
+
+        writer.push({ r.filename, cv::boundingRect(points), points, packed });
+    };
+
+    if(threads == 1 || threads == 0)
+    {
+        harness({0,static_cast<int>(table.lines.size())});
+    }
+    else
+    {
+        cv::parallel_for_({0,static_cast<int>(table.lines.size())}, harness, std::max(threads, -1));
+    }
+
+    logger.info("Packed {} records to {}", writer.close(), sOutput);
+
+    return 0;
+}
+
 #if defined(DRISHTI_BUILD_EOS)
 
 
@@ -1049,7 +1228,7 @@ static int saveNegatives(const FACE::Table &table, const std::string &sOutput, i
     return 0;
 }
 
-static int saveInpaintedSamples(const FACE::Table &table, const std::string& sBackground, const std::string &sOutput, spdlog::logger &logger)
+static int saveInpaintedSamples(const FACE::Table &table, const std::string& sBackground, const std::string &sOutput, int threads, spdlog::logger &logger)
 {
     cv::RNG rng;
 
@@ -1065,50 +1244,71 @@ static int saveInpaintedSamples(const FACE::Table &table, const std::string& sBa
         }
     }
 
+    if(negatives.empty())
+    {
+        logger.error("No background images were found");
+        return 1;
+    }
+
+    // Each image is blended once for all of its faces:
     std::map< std::string, std::vector<const std::vector<cv::Point2f>*> > landmarks;
     for(const auto &r : table.lines)
     {
         landmarks[r.filename].push_back(&r.points);
     }
+    std::vector<decltype(landmarks)::const_iterator> images;
+    for(auto iter = landmarks.cbegin(); iter != landmarks.cend(); iter++)
+    {
+        images.push_back(iter);
+    }
+
+    // Level buffers are reused per thread (see PyramidBlender):
+    using BlenderPtr = std::shared_ptr<PyramidBlender>;
+    drishti::core::LazyParallelResource<std::thread::id, BlenderPtr> blenders([]() {
+        return std::make_shared<PyramidBlender>(6, false); // images are processed in parallel
+    });
 
     drishti::core::ParallelHomogeneousLambda harness = [&](int i)
     {
-        const auto &r = table.lines[i];
-        cv::Mat image = cv::imread(r.filename, cv::IMREAD_COLOR);
+        const auto &iter = images[i];
+        cv::Mat image = cv::imread(iter->first, cv::IMREAD_COLOR);
         if(!image.empty())
         {
-            logger.info("faceless:{}", r.filename);
+            logger.info("faceless:{}", iter->first);
+
+            cv::RNG rng(i + 1); // per image (the shared cv::RNG isn't thread safe)
 
             cv::Mat blended;
-            auto iter = landmarks.find(r.filename);
-            if(iter != landmarks.end())
+            for(const auto &p : iter->second)
             {
-                for(const auto &p : iter->second)
-                {
-                    const cv::Rect roi = cv::boundingRect(*p);
-                    const cv::Point2f tl = roi.tl(), br = roi.br(), center = (br + tl) * 0.5f;
-                    const cv::RotatedRect face(center, cv::Size2f(roi.width, roi.height*2.f), 0);
-                    cv::Mat mask(image.size(), CV_8UC3, cv::Scalar::all(0));
-                    cv::ellipse(mask, face, cv::Scalar::all(255), -1, 8);
+                const cv::Rect roi = cv::boundingRect(*p);
+                const cv::Point2f tl = roi.tl(), br = roi.br(), center = (br + tl) * 0.5f;
+                const cv::RotatedRect face(center, cv::Size2f(roi.width, roi.height*2.f), 0);
+                cv::Mat mask(image.size(), CV_8UC1, cv::Scalar::all(0));
+                cv::ellipse(mask, face, cv::Scalar::all(255), -1, 8);
 
-                    cv::Mat bg;
-                    cv::resize(negatives[rng.uniform(0, negatives.size())], bg, image.size(), 0, 0, cv::INTER_AREA);
+                cv::Mat bg;
+                cv::resize(negatives[rng.uniform(0, negatives.size())], bg, image.size(), 0, 0, cv::INTER_AREA);
 
-                    blended = blend(blended.empty() ? image : blended, bg, mask, 6);
-                    blended.convertTo(blended, CV_8UC3, 255.0);
-                }
+                (*blenders[std::this_thread::get_id()])(blended.empty() ? image : blended, bg, mask, blended);
             }
 
             if(!blended.empty())
             {
-                std::string base = drishti::core::basename(r.filename);
+                std::string base = drishti::core::basename(iter->first);
                 cv::imwrite(sOutput + "/" + base + "_faceless.png", blended);
             }
         }
     };
 
-    //cv::parallel_for_({0,static_cast<int>(table.lines.size()}, harness, std::max(threads, -1));
-    harness({0,static_cast<int>(table.lines.size())});
+    if(threads == 1 || threads == 0)
+    {
+        harness({0,static_cast<int>(images.size())});
+    }
+    else
+    {
+        cv::parallel_for_({0,static_cast<int>(images.size())}, harness, std::max(threads, -1));
+    }
 
     return 0;
 }
@@ -0,0 +1,447 @@
+/*! -*-c++-*-
+  @file   fddbeval.cpp
+  @author David Hirvonen
+  @brief  FDDB evaluation (discrete and continuous ROC) for ACF detectors.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The cascade runs once per image with the threshold removed (AcfCascade::trace()), and
+  the cached windows are filtered for each cascThr/cascCal pair of the sweep, so the
+  whole grid costs about as much as a single detection pass.  Detections are matched to
+  the annotated ellipses with the Hungarian algorithm, the discrete ROC counts matches
+  with overlap >= 0.5, the continuous ROC sums the overlaps (as in the FDDB protocol).
+
+*/
+
+#include "drishti/ml/AcfCascade.h"
+#include "drishti/ml/ObjectDetector.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/Logger.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/hungarian.h"
+#include "drishti/core/make_unique.h"
+
+#include "FDDB.h"
+#include "cxxopts.hpp"
+
+#include <acf/ACF.h>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace bfs = boost::filesystem;
+
+struct Ellipse
+{
+    double a, b, theta; // semi axes and orientation (radians)
+    cv::Point2d center;
+
+    bool contains(const cv::Point2d& p) const
+    {
+        const cv::Point2d d = p - center;
+        const double c = std::cos(theta), s = std::sin(theta);
+        const double x = (d.x * c + d.y * s) / a, y = (-d.x * s + d.y * c) / b;
+        return (x * x + y * y) <= 1.0;
+    }
+
+    cv::Rect2d bounds() const
+    {
+        const double c = std::cos(theta), s = std::sin(theta);
+        const double w = std::sqrt(a * a * c * c + b * b * s * s), h = std::sqrt(a * a * s * s + b * b * c * c);
+        return { center.x - w, center.y - h, w * 2.0, h * 2.0 };
+    }
+};
+
+// Cached cascade output for one image:
+struct Sample
+{
+    std::string filename;
+    std::vector<Ellipse> faces;
+    std::vector<cv::Rect> objects;
+    std::vector<drishti::ml::AcfCascade::Trace> traces;
+    bool good = false;
+};
+
+// One detection for the ROC: score and overlap with the matched face (0 if unmatched):
+using Detection = std::pair<double, double>;
+
+// Ellipse/rectangle overlap (intersection over union) sampled on a regular grid:
+static double overlap(const Ellipse& e, const cv::Rect& r, int n = 32)
+{
+    const cv::Rect2d box = e.bounds() | cv::Rect2d(r);
+    if (!(e.bounds() & cv::Rect2d(r)).area())
+    {
+        return 0.0;
+    }
+
+    const cv::Point2d step(box.width / n, box.height / n);
+    int inE = 0, inR = 0, inBoth = 0;
+    for (int y = 0; y < n; y++)
+    {
+        for (int x = 0; x < n; x++)
+        {
+            const cv::Point2d p(box.x + (x + 0.5) * step.x, box.y + (y + 0.5) * step.y);
+            const bool isE = e.contains(p), isR = cv::Rect2d(r).contains(p);
+            inE += isE;
+            inR += isR;
+            inBoth += (isE && isR);
+        }
+    }
+
+    const int total = inE + inR - inBoth;
+    return total ? double(inBoth) / double(total) : 0.0;
+}
+
+// Channel pyramid in model storage order (see acfdistill.cpp):
+static void computePyramid(acf::Detector& detector, const cv::Mat3b& image, acf::Detector::Pyramid& P)
+{
+    cv::Mat3b rgb, It;
+    cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
+    if (!detector.getIsRowMajor())
+    {
+        cv::transpose(rgb, It);
+    }
+    else
+    {
+        It = rgb;
+    }
+
+    cv::Mat3f Itf;
+    It.convertTo(Itf, CV_32FC3, 1.0 / 255.0);
+    detector.setIsLuv(false);
+    detector.computePyramid(MatP(Itf), P);
+}
+
+// Inclusive grid [lower, upper]:
+static std::vector<float> getGrid(float lower, float upper, float step)
+{
+    std::vector<float> values{ lower };
+    if (step > 0.f)
+    {
+        for (int i = 1; (lower + i * step) <= (upper + step * 1e-3f); i++)
+        {
+            values.push_back(lower + i * step);
+        }
+    }
+    return values;
+}
+
+// Detections for one sweep entry, with the acf "maxg" suppression, matched to the faces:
+static void evaluate(const Sample& sample, float cascThr, float cascCal, std::vector<Detection>& detections)
+{
+    std::vector<cv::Rect> objects;
+    std::vector<double> scores;
+    for (std::size_t i = 0; i < sample.traces.size(); i++)
+    {
+        const auto& t = sample.traces[i];
+        if ((t.minimum > cascThr) && ((t.h + cascCal) > cascThr))
+        {
+            objects.push_back(sample.objects[i]);
+            scores.push_back(t.h + cascCal);
+        }
+    }
+
+    drishti::ml::ObjectDetector::suppress(objects, scores, 0.65, 0, true);
+
+    std::unordered_map<int, int> direct, reverse;
+    if (!objects.empty() && !sample.faces.empty())
+    {
+        std::vector<std::vector<double>> cost(objects.size(), std::vector<double>(sample.faces.size(), 0.0));
+        for (std::size_t i = 0; i < objects.size(); i++)
+        {
+            for (std::size_t j = 0; j < sample.faces.size(); j++)
+            {
+                cost[i][j] = overlap(sample.faces[j], objects[i]);
+            }
+        }
+        drishti::core::MaximizeLinearAssignment(cost, direct, reverse);
+
+        for (std::size_t i = 0; i < objects.size(); i++)
+        {
+            const auto iter = direct.find(static_cast<int>(i));
+            const bool isMatch = (iter != direct.end()) && (iter->second < static_cast<int>(sample.faces.size()));
+            detections.emplace_back(scores[i], isMatch ? cost[i][iter->second] : 0.0);
+        }
+    }
+    else
+    {
+        for (const auto& s : scores)
+        {
+            detections.emplace_back(s, 0.0);
+        }
+    }
+}
+
+// ROC points { false positives, true positive rate } in decreasing score order:
+static std::vector<cv::Point2d> getROC(std::vector<Detection> detections, int faces, bool isContinuous)
+{
+    std::sort(detections.begin(), detections.end(), [](const Detection& a, const Detection& b) { return a.first > b.first; });
+
+    std::vector<cv::Point2d> roc;
+    double tp = 0.0, fp = 0.0;
+    for (std::size_t i = 0; i < detections.size(); i++)
+    {
+        const double o = detections[i].second;
+        if (isContinuous)
+        {
+            tp += o;
+            fp += (1.0 - o);
+        }
+        else
+        {
+            tp += (o >= 0.5) ? 1.0 : 0.0;
+            fp += (o >= 0.5) ? 0.0 : 1.0;
+        }
+
+        // One point per distinct score:
+        if (((i + 1) == detections.size()) || (detections[i + 1].first != detections[i].first))
+        {
+            roc.emplace_back(fp, faces ? tp / faces : 0.0);
+        }
+    }
+    return roc;
+}
+
+// Recall at the largest operating point with at most fp false positives:
+static double getRecall(const std::vector<cv::Point2d>& roc, double fp)
+{
+    double recall = 0.0;
+    for (const auto& p : roc)
+    {
+        if (p.x > fp)
+        {
+            break;
+        }
+        recall = p.y;
+    }
+    return recall;
+}
+
+static void writeROC(const std::string& filename, const std::vector<cv::Point2d>& roc)
+{
+    std::ofstream os(filename);
+    for (const auto& p : roc)
+    {
+        os << p.y << " " << p.x << "\n"; // FDDB {Disc,Cont}ROC.txt layout
+    }
+}
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-fddb-eval");
+
+    std::vector<std::string> sFolds;
+    std::string sModel, sImageDir, sOutput;
+    float thrMin = -1.f, thrMax = -1.f, thrStep = 0.f;
+    float calMin = 0.f, calMax = 0.f, calStep = 0.f;
+    int threads = -1;
+
+    cxxopts::Options options("drishti-fddb-eval", "FDDB ROC evaluation with cascade threshold sweeps");
+
+    // clang-format off
+    options.add_options()
+        ("i,input", "FDDB ellipse lists (one per fold)", cxxopts::value<std::vector<std::string>>(sFolds))
+        ("d,directory", "FDDB image directory", cxxopts::value<std::string>(sImageDir))
+        ("m,model", "ACF model", cxxopts::value<std::string>(sModel))
+        ("o,output", "Output directory (ROC files and summary)", cxxopts::value<std::string>(sOutput))
+        ("thr-min", "Smallest cascThr", cxxopts::value<float>(thrMin))
+        ("thr-max", "Largest cascThr", cxxopts::value<float>(thrMax))
+        ("thr-step", "cascThr step", cxxopts::value<float>(thrStep))
+        ("cal-min", "Smallest cascCal (added to the model)", cxxopts::value<float>(calMin))
+        ("cal-max", "Largest cascCal", cxxopts::value<float>(calMax))
+        ("cal-step", "cascCal step", cxxopts::value<float>(calStep))
+        ("t,threads", "Worker threads", cxxopts::value<int>(threads))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    auto parseResult = options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || parseResult.count("help"))
+    {
+        logger->info(options.help({ "" }));
+        return 0;
+    }
+
+    if (sModel.empty() || sFolds.empty())
+    {
+        logger->error("Must specify a model and FDDB ellipse lists");
+        return 1;
+    }
+
+    const std::vector<float> thresholds = getGrid(thrMin, std::max(thrMin, thrMax), thrStep);
+    const std::vector<float> calibrations = getGrid(calMin, std::max(calMin, calMax), calStep);
+    const float floor = thresholds.front();
+    const float finalFloor = floor - calibrations.back();
+
+    std::vector<Sample> samples;
+    for (const auto& fold : sFolds)
+    {
+        for (const auto& r : parseFDDB(fold))
+        {
+            Sample sample;
+            sample.filename = (bfs::path(sImageDir) / r.filename).replace_extension(".jpg").string();
+            for (const auto& e : r.ellipses)
+            {
+                const auto& v = e.first;
+                sample.faces.push_back({ v[0], v[1], v[2], { v[3], v[4] } });
+            }
+            samples.push_back(sample);
+        }
+    }
+
+    // One detector (pyramid + cascade) per worker:
+    struct Worker
+    {
+        explicit Worker(const std::string& filename)
+            : detector(filename)
+            , cascade(detector)
+        {
+        }
+
+        acf::Detector detector;
+        drishti::ml::AcfCascade cascade;
+    };
+
+    using WorkerPtr = std::unique_ptr<Worker>;
+    drishti::core::LazyParallelResource<std::thread::id, WorkerPtr> manager = [&]() {
+        return drishti::core::make_unique<Worker>(sModel);
+    };
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        auto& worker = manager[std::this_thread::get_id()];
+        auto& sample = samples[i];
+
+        cv::Mat3b image = cv::imread(sample.filename, cv::IMREAD_COLOR);
+        if (image.empty())
+        {
+            logger->warn("Failed to read {}", sample.filename);
+            return;
+        }
+
+        acf::Detector::Pyramid P;
+        computePyramid(worker->detector, image, P);
+        worker->cascade.trace(P, floor, finalFloor, sample.objects, sample.traces);
+        sample.good = true;
+    };
+
+    {
+        // Images differ in size and face count, so claim one image at a time:
+        drishti::core::ParallelSettings settings;
+        settings.threads = threads;
+        settings.grain = 1;
+        settings.progress = [&](int done, int total) {
+            if (((done % 100) == 0) || (done == total))
+            {
+                logger->info("Detection: {}/{}", done, total);
+            }
+        };
+
+        const int workers = (threads > 0) ? threads : static_cast<int>(std::thread::hardware_concurrency());
+        manager.reserve(std::min(static_cast<int>(samples.size()), std::max(workers, 1)));
+        drishti::core::parallelFor({ 0, static_cast<int>(samples.size()) }, harness, settings);
+    }
+
+    int faces = 0, images = 0;
+    for (const auto& s : samples)
+    {
+        faces += s.good ? static_cast<int>(s.faces.size()) : 0;
+        images += s.good;
+    }
+    logger->info("Evaluating {} images with {} faces", images, faces);
+
+    std::ofstream summary;
+    if (!sOutput.empty())
+    {
+        bfs::create_directories(sOutput);
+        summary.open((bfs::path(sOutput) / "summary.csv").string());
+        summary << "cascThr,cascCal,detections,disc@50,disc@100,disc@500,disc@1000,cont@100,cont@500\n";
+    }
+
+    // The sweep entries are independent (the matching dominates):
+    struct Entry
+    {
+        float cascThr, cascCal;
+        std::vector<cv::Point2d> disc, cont;
+        std::size_t count;
+    };
+
+    std::vector<Entry> entries;
+    for (const auto& t : thresholds)
+    {
+        for (const auto& c : calibrations)
+        {
+            entries.push_back({ t, c, {}, {}, 0 });
+        }
+    }
+
+    drishti::core::ParallelHomogeneousLambda sweep = [&](int i) {
+        auto& entry = entries[i];
+        std::vector<Detection> detections;
+        for (const auto& s : samples)
+        {
+            if (s.good)
+            {
+                evaluate(s, entry.cascThr, entry.cascCal, detections);
+            }
+        }
+        entry.count = detections.size();
+        entry.disc = getROC(detections, faces, false);
+        entry.cont = getROC(detections, faces, true);
+    };
+
+    drishti::core::ParallelSettings settings;
+    settings.threads = threads;
+    settings.grain = 1;
+    drishti::core::parallelFor({ 0, static_cast<int>(entries.size()) }, sweep, settings);
+
+    for (const auto& e : entries)
+    {
+        logger->info("cascThr {} cascCal {}: {} detections, recall @100 fp {} (disc) {} (cont)",
+            e.cascThr, e.cascCal, e.count, getRecall(e.disc, 100), getRecall(e.cont, 100));
+
+        if (summary.is_open())
+        {
+            summary << e.cascThr << "," << e.cascCal << "," << e.count;
+            for (const auto& fp : { 50, 100, 500, 1000 })
+            {
+                summary << "," << getRecall(e.disc, fp);
+            }
+            for (const auto& fp : { 100, 500 })
+            {
+                summary << "," << getRecall(e.cont, fp);
+            }
+            summary << "\n";
+
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(3) << "_" << e.cascThr << "_" << e.cascCal << ".txt";
+            writeROC((bfs::path(sOutput) / ("DiscROC" + ss.str())).string(), e.disc);
+            writeROC((bfs::path(sOutput) / ("ContROC" + ss.str())).string(), e.cont);
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
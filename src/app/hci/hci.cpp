@@ -14,11 +14,16 @@
 #include "drishti/core/drishti_stdlib_string.h" // android workaround
 #include "drishti/core/Semaphore.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/StageTracer.h"
 #include "drishti/hci/FaceFinderPainter.h"
 #include "drishti/hci/FaceMonitor.h"
 #include "drishti/testlib/drishti_cli.h"
 #include "drishti/face/FaceDetectorFactoryJson.h"
+#include "drishti/face/FaceDetectorFactoryBundle.h"
 #include "drishti/core/drishti_string_hash.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/graphics/GLTexture.h"
+#include "drishti/graphics/nv12.h"
 
 #include "drishti/drishti_sdk.hpp" // for version from public SDK
 
@@ -37,6 +42,11 @@
 
 #include <spdlog/fmt/ostr.h>
 
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
 using string_hash::operator"" _hash;
 
 // clang-format off
@@ -60,6 +70,21 @@ static void* void_ptr(const cv::Mat& image)
 
 static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description);
 static ogles_gpgpu::SwizzleProc::SwizzleKind getSwizzleKind(const std::string &sSwizzle);
+static drishti::hci::FaceFinder::Backpressure getBackpressure(const std::string& sBackpressure);
+static void report(LoggerPtr& logger, const drishti::hci::FaceFinder& detector, std::size_t frames, const std::string& sTrace);
+
+// Headless batch mode: several FaceFinder instances, each with its own offscreen context:
+struct HeadlessSettings
+{
+    std::vector<std::string> videos;
+    int instances = 1;
+    float fx = 0.f;
+    bool doCpu = false;
+    ogles_gpgpu::SwizzleProc::SwizzleKind swizzle = ogles_gpgpu::SwizzleProc::kSwizzleRGBA;
+    drishti::hci::FaceFinder::Backpressure backpressure = drishti::hci::FaceFinder::kBlock;
+};
+
+static int runHeadless(LoggerPtr& logger, std::shared_ptr<drishti::face::FaceDetectorFactory>& factory, const drishti::hci::FaceFinder::Settings& base, const HeadlessSettings& headless);
 
 // Simple FaceMonitor class to report face detection results over time.
 struct FaceMonitorLogger : public drishti::hci::FaceMonitor
@@ -183,10 +208,19 @@ int gauze_main(int argc, char** argv)
     bool doDebug = false;
     bool doCpu = false;
     bool doCvVideoCapture = false;
+    bool doNv12 = false;
     bool doVersion = false;    
+    bool doTrace = false;
+    bool doGpuTiming = false;
+    bool doRecord = false;
+    bool doHeadless = false;
+    int instances = 1;
+    float recordLatency = 0.f;
     int loops = 0;
+    float replayFps = 0.f;
+    float interval = 0.f;
     
-    std::string sInput, sOutput, sSwizzle = "rgba", sDimensions;
+    std::string sInput, sOutput, sSwizzle = "rgba", sDimensions, sBackpressure = "block";
 
     float resolution = 1.f;
     float fx = 0.f;
@@ -208,6 +242,7 @@ int gauze_main(int argc, char** argv)
 
         ("cv", "Use cv::VideoCapture for video", cxxopts::value<bool>(doCvVideoCapture))
         ("size", "cv::VideoCapture video dimensions: wxh", cxxopts::value<std::string>(sDimensions))        
+        ("nv12", "Decode to NV12 planes (hardware decoder format) and convert on the GPU", cxxopts::value<bool>(doNv12))
 
         ("swizzle", "Swizzle channel operation", cxxopts::value<std::string>(sSwizzle))
     
@@ -217,7 +252,21 @@ int gauze_main(int argc, char** argv)
         ("debug", "Provide debugging annotations", cxxopts::value<bool>(doDebug))
 #endif
         ("l,loops", "Loop the input video", cxxopts::value<int>(loops))
+
+        // Deterministic replay: frame n is stamped start + n / fps instead of the wall clock,
+        // so the detection interval (and reported results) don't depend on processing speed:
+        ("replay", "Replay frame rate for synthetic timestamps (0 == wall clock)", cxxopts::value<float>(replayFps))
+        ("interval", "Seconds between full detections (0 == every frame)", cxxopts::value<float>(interval))
+        ("backpressure", "Busy pipeline policy: block, newest or oldest (drop), last (reuse)", cxxopts::value<std::string>(sBackpressure))
+        ("trace", "Write a Chrome trace (chrome://tracing) to <output>/trace.json", cxxopts::value<bool>(doTrace))
+        ("gpu-timing", "Time the GPU stages with timer queries (see --trace)", cxxopts::value<bool>(doGpuTiming))
+        ("record", "Record clips around track losses to <output>/clip_<n>.txt (replay input)", cxxopts::value<bool>(doRecord))
+        ("record-latency", "Also record clips around frames slower than this (seconds)", cxxopts::value<float>(recordLatency))
     
+        // Headless throughput testing (no window, no vsync, input may be a list of videos):
+        ("headless", "Offscreen batch mode: run all input videos as fast as possible", cxxopts::value<bool>(doHeadless))
+        ("instances", "Concurrent FaceFinder instances (headless), each with its own context", cxxopts::value<int>(instances))
+
         // Generate a quicktime movie:
         ("m,movie", "Output quicktime movie", cxxopts::value<bool>(doMovie))
 
@@ -241,7 +290,7 @@ int gauze_main(int argc, char** argv)
         ("E,eye", "Eye model", cxxopts::value<std::string>(factory->sEyeRegressor))
 
         // ... factory can be used instead of D,M,R,E
-        ("F,factory", "Factory (json model zoo)", cxxopts::value<std::string>(sFactory))
+        ("F,factory", "Factory (json model zoo or model bundle)", cxxopts::value<std::string>(sFactory))
 
         ("version", "Report library version", cxxopts::value<bool>(doVersion))        
         ("h,help", "Print help message");
@@ -301,7 +350,12 @@ int gauze_main(int argc, char** argv)
         return 1;
     }
 
-    if (!sFactory.empty())
+    const bool isBundle = !sFactory.empty() && drishti::core::ModelBundle::isBundle(sFactory);
+    if (isBundle)
+    {
+        factory = std::make_shared<drishti::face::FaceDetectorFactoryBundle>(sFactory);
+    }
+    else if (!sFactory.empty())
     {
         factory = std::make_shared<drishti::face::FaceDetectorFactoryJson>(sFactory);
     }
@@ -325,12 +379,36 @@ int gauze_main(int argc, char** argv)
 
     for (const auto& c : config)
     {
-        if (checkModel(logger, c.first, c.second))
+        if (!isBundle && checkModel(logger, c.first, c.second)) // bundle entries are verified on load
         {
             return 1;
         }
     }
 
+    if (doHeadless)
+    {
+        // Same pipeline configuration as below, without rendering, recording or replay
+        // timestamps (one thread pool is shared by all instances):
+        settings.frameDelay = 2;
+        settings.doLandmarks = true;
+        settings.doFlow = false;
+        settings.doBlobs = false;
+        settings.threads = std::make_shared<tp::ThreadPool<>>();
+        settings.faceFinderInterval = interval;
+        settings.doSingleFace = true;
+        settings.doOptimizedPipeline = !doCpu;
+        settings.doGpuTiming = doGpuTiming;
+
+        HeadlessSettings headless;
+        headless.videos = drishti::cli::expand(sInput);
+        headless.instances = std::max(instances, 1);
+        headless.fx = fx;
+        headless.doCpu = doCpu;
+        headless.swizzle = getSwizzleKind(sSwizzle);
+        headless.backpressure = getBackpressure(sBackpressure);
+        return runHeadless(logger, factory, settings, headless);
+    }
+
     // In some glfw + avfoundation + os x combinations we can see the following system
     // error.  This may be behind us now!
     // ~~~~~
@@ -365,20 +443,24 @@ int gauze_main(int argc, char** argv)
         video = drishti::videoio::VideoSourceCV::create(sInput);
     }
                 
-    video->setOutputFormat(drishti::videoio::VideoSourceCV::ARGB); // be explicit, fail on error
+    // be explicit, fail on error
+    video->setOutputFormat(doNv12 ? drishti::videoio::VideoSourceCV::NV12 : drishti::videoio::VideoSourceCV::ARGB);
 
     // Retrieve first frame to configure sensor parameters:
     std::size_t counter = 0;
     auto frame = (*video)(counter);
     const cv::Size frameSize = frame.image.size();
 
+    // NV12 frames store the half resolution chroma plane below the luma plane:
+    const cv::Size videoSize(frameSize.width, doNv12 ? (frameSize.height * 2 / 3) : frameSize.height);
+
     if (frame.image.empty())
     {
         logger->info("No frames available in video");
         return -1;
     }
 
-    cv::Size windowSize = cv::Size2f(frameSize) * resolution;
+    cv::Size windowSize = cv::Size2f(videoSize) * resolution;
     opengl->resize(windowSize.width, windowSize.height);
 
     // Create configuration:
@@ -390,14 +472,33 @@ int gauze_main(int argc, char** argv)
     settings.doBlobs = false;
     settings.threads = std::make_shared<tp::ThreadPool<>>();
     settings.outputOrientation = 0;
-    settings.faceFinderInterval = 0.f;
+    settings.faceFinderInterval = interval;
+    if (doRecord)
+    {
+        drishti::hci::SessionRecorder::Settings recording;
+        recording.directory = sOutput;
+        recording.maxLatency = recordLatency;
+        settings.recorder = std::make_shared<drishti::hci::SessionRecorder>(recording);
+    }
     settings.renderFaces = true;          // *** rendering ***
     settings.renderPupils = true;         // *** rendering ***
     settings.renderCorners = false;       // *** rendering ***
     settings.renderEyesWidthRatio = 0.25f * opengl->getGeometry().sx; // *** rendering ***
     settings.doSingleFace = true;
     settings.doOptimizedPipeline = !doCpu;
+    settings.doGpuTiming = doGpuTiming;
     settings.ignoreLatestFramesInMonitor = true;
+
+    std::size_t frames = 0; // frames submitted to the FaceFinder
+    if (replayFps > 0.f)
+    {
+        using Clock = drishti::hci::FaceFinder::HighResolutionClock;
+        settings.clock = [&]()
+        {
+            const std::chrono::duration<double> elapsed(static_cast<double>(frames) / replayFps);
+            return Clock::time_point(std::chrono::duration_cast<Clock::duration>(elapsed));
+        };
+    }
  
     // The following parameters are set directly through the command line parser:
     //
@@ -409,8 +510,8 @@ int gauze_main(int argc, char** argv)
     //  settings.acfCalibration = ...;
 
     { // Add intrinsic camera parameters:
-        const cv::Point2f p(frame.image.cols / 2, frame.image.rows / 2);
-        drishti::sensor::SensorModel::Intrinsic params(p, fx, frame.image.size());
+        const cv::Point2f p(videoSize.width / 2, videoSize.height / 2);
+        drishti::sensor::SensorModel::Intrinsic params(p, fx, videoSize);
         settings.sensor = std::make_shared<drishti::sensor::SensorModel>(params);
     }
     
@@ -444,6 +545,7 @@ int gauze_main(int argc, char** argv)
     detector->setShowMotionAxes(doDebug);      // *** rendering ***
     detector->setShowDetectionScales(doDebug); // *** rendering ***
     detector->setDoCpuAcf(doCpu);
+    detector->setBackpressure(getBackpressure(sBackpressure));
     
     // Instantiate and register a samle FaceMonitor class to log tracking results
     // over time.  Here we setup a sample callback that will request just the
@@ -458,6 +560,18 @@ int gauze_main(int argc, char** argv)
     ogles_gpgpu::SwizzleProc swizzle(getSwizzleKind(sSwizzle));
     source.set(&swizzle);
 
+    // NV12 planes are uploaded as-is (no CPU conversion) and converted to RGBA on the GPU:
+    ogles_gpgpu::VideoSource nv12Source;
+    ogles_gpgpu::Nv12Proc nv12;
+    nv12Source.set(&nv12);
+    std::unique_ptr<ogles_gpgpu::GLTexture> luma, chroma;
+    if (doNv12)
+    {
+        const int width = videoSize.width, height = videoSize.height;
+        luma = drishti::core::make_unique<ogles_gpgpu::GLTexture>(width, height, GL_LUMINANCE, nullptr, GL_LUMINANCE);
+        chroma = drishti::core::make_unique<ogles_gpgpu::GLTexture>(width / 2, height / 2, GL_LUMINANCE_ALPHA, nullptr, GL_LUMINANCE_ALPHA);
+    }
+
     // Provide a default quicktime movie name for logging on Apple platforms.
     std::string filename = sOutput + "/movie.mov";
     if (drishti::cli::file::exists(filename))
@@ -471,7 +585,7 @@ int gauze_main(int argc, char** argv)
         sink = drishti::videoio::VideoSinkCV::create(filename, ".mov");
         if (sink)
         {
-            sink->setProperties({ frame.cols(), frame.rows() });
+            sink->setProperties({ videoSize.width, videoSize.height });
             sink->begin();
         }
     }
@@ -482,7 +596,7 @@ int gauze_main(int argc, char** argv)
     if (doWindow && opengl->hasDisplay())
     {
         display = std::make_shared<ogles_gpgpu::Disp>();
-        display->init(frame.image.cols, frame.image.rows, TEXTURE_FORMAT);
+        display->init(videoSize.width, videoSize.height, TEXTURE_FORMAT);
         display->setOutputRenderOrientation(ogles_gpgpu::RenderOrientationFlipped);
     }
 
@@ -534,19 +648,33 @@ int gauze_main(int argc, char** argv)
             return false;
         }
         
-        if (frame.image.channels() == 3)
+        logger->info("{}", cv::mean(frame.image));
+
+        GLuint texture0 = 0;
+        if (doNv12)
         {
-            cv::cvtColor(frame.image, frame.image, cv::COLOR_BGR2BGRA);
+            luma->update(frame.image.ptr());
+            chroma->update(frame.image.ptr(videoSize.height));
+            nv12.setChromaTexture(*chroma);
+            nv12Source({ { videoSize.width, videoSize.height }, nullptr, false, *luma, GL_LUMINANCE });
+            texture0 = nv12.getOutputTexId();
         }
+        else
+        {
+            if (frame.image.channels() == 3)
+            {
+                cv::cvtColor(frame.image, frame.image, cv::COLOR_BGR2BGRA);
+            }
 
-        CV_Assert(frame.image.channels() == 4);
+            CV_Assert(frame.image.channels() == 4);
 
-        logger->info("{}", cv::mean(frame.image));
+            // Perform texture swizzling:
+            source({ { frame.cols(), frame.rows() }, void_ptr(frame.image), true, 0, TEXTURE_FORMAT });
+            texture0 = swizzle.getOutputTexId();
+        }
 
-        // Perform texture swizzling:
-        source({ { frame.cols(), frame.rows() }, void_ptr(frame.image), true, 0, TEXTURE_FORMAT });
-        auto texture0 = swizzle.getOutputTexId();
-        auto texture1 = (*detector)({ { frame.cols(), frame.rows() }, nullptr, false, texture0, TEXTURE_FORMAT });
+        auto texture1 = (*detector)({ { videoSize.width, videoSize.height }, nullptr, false, texture0, TEXTURE_FORMAT });
+        frames++;
 
         // Convert to texture as one of GL_BGRA or GL_RGBA
         if (display)
@@ -574,6 +702,14 @@ int gauze_main(int argc, char** argv)
 
     (*opengl)(render);
 
+    report(logger, *detector, frames, doTrace ? (sOutput + "/trace.json") : std::string());
+
+    if (settings.recorder)
+    {
+        settings.recorder->flush();
+        logger->info("recorded clips: {} dropped frames: {}", settings.recorder->getClipCount(), settings.recorder->getDroppedFrameCount());
+    }
+
     if (sink)
     {
         drishti::core::Semaphore s(0);
@@ -583,6 +719,116 @@ int gauze_main(int argc, char** argv)
     return 0;
 }
 
+// Each worker thread creates its own hidden (offscreen) context, so there is no display
+// event queue and no vsync, and claims the next video until the list is exhausted.  The
+// detector models are loaded once per video (FaceFinder instances are per video size).
+static int runHeadless(LoggerPtr& logger, std::shared_ptr<drishti::face::FaceDetectorFactory>& factory, const drishti::hci::FaceFinder::Settings& base, const HeadlessSettings& headless)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct Result
+    {
+        std::size_t frames = 0;
+        std::size_t dropped = 0;
+        double seconds = 0.0;
+        bool good = false;
+    };
+
+    std::vector<Result> results(headless.videos.size());
+    std::atomic<std::size_t> next{ 0 };
+    std::mutex mutex; // context creation
+
+    auto worker = [&](int instance) {
+        std::shared_ptr<aglet::GLContext> opengl;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            opengl = aglet::GLContext::create(aglet::GLContext::kAuto, "", 640, 480);
+        }
+        (*opengl)(); // activate context (this thread)
+
+        ogles_gpgpu::VideoSource source;
+        ogles_gpgpu::SwizzleProc swizzle(headless.swizzle);
+        source.set(&swizzle);
+
+        for (std::size_t i = next++; i < headless.videos.size(); i = next++)
+        {
+            auto video = drishti::videoio::VideoSourceCV::create(headless.videos[i]);
+            video->setOutputFormat(drishti::videoio::VideoSourceCV::ARGB);
+
+            auto frame = (*video)(0);
+            if (frame.image.empty())
+            {
+                logger->warn("No frames available in video {}", headless.videos[i]);
+                continue;
+            }
+            const cv::Size videoSize = frame.image.size();
+
+            drishti::hci::FaceFinder::Settings settings = base;
+            settings.logger = drishti::core::Logger::create("test-drishti-hci-" + std::to_string(instance));
+            settings.recorder = nullptr; // clips from concurrent instances would collide
+            settings.renderFaces = false;
+            settings.renderPupils = false;
+            settings.renderCorners = false;
+            {
+                const cv::Point2f p(videoSize.width / 2, videoSize.height / 2);
+                drishti::sensor::SensorModel::Intrinsic params(p, headless.fx, videoSize);
+                settings.sensor = std::make_shared<drishti::sensor::SensorModel>(params);
+            }
+
+            auto detector = drishti::hci::FaceFinder::create(factory, settings, nullptr);
+            detector->setDoCpuAcf(headless.doCpu);
+            detector->setBackpressure(headless.backpressure);
+
+            auto& result = results[i];
+            const auto tic = Clock::now();
+            for (std::size_t counter = 1; !frame.image.empty() && (frame.image.size() == videoSize); frame = (*video)(counter++))
+            {
+                if (frame.image.channels() == 3)
+                {
+                    cv::cvtColor(frame.image, frame.image, cv::COLOR_BGR2BGRA);
+                }
+
+                source({ { videoSize.width, videoSize.height }, void_ptr(frame.image), true, 0, TEXTURE_FORMAT });
+                (*detector)({ { videoSize.width, videoSize.height }, nullptr, false, swizzle.getOutputTexId(), TEXTURE_FORMAT });
+                result.frames++;
+            }
+            glFinish();
+
+            result.seconds = std::chrono::duration<double>(Clock::now() - tic).count();
+            result.dropped = detector->getDroppedFrameCount();
+            result.good = true;
+
+            logger->info("[{}] {}: frames={} fps={} dropped={}", instance, headless.videos[i], result.frames, result.frames / std::max(result.seconds, 1e-6), result.dropped);
+        }
+    };
+
+    const auto tic = Clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < headless.instances; i++)
+    {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - tic).count();
+
+    std::size_t frames = 0, dropped = 0, videos = 0;
+    double busy = 0.0;
+    for (const auto& r : results)
+    {
+        frames += r.frames;
+        dropped += r.dropped;
+        busy += r.seconds;
+        videos += r.good;
+    }
+
+    logger->info("videos: {}/{} instances: {} frames: {} dropped: {}", videos, results.size(), headless.instances, frames, dropped);
+    logger->info("throughput: {} fps (wall {}s), per instance: {} fps", frames / std::max(elapsed, 1e-6), elapsed, frames / std::max(busy, 1e-6));
+    return (videos == results.size()) ? 0 : 1;
+}
+
 // utility:
 
 static bool checkModel(LoggerPtr& logger, const std::string& sModel, const std::string& description)
@@ -612,3 +858,53 @@ static ogles_gpgpu::SwizzleProc::SwizzleKind getSwizzleKind(const std::string &s
         default: throw std::runtime_error("Unsupported type specified in" + sSwizzle);
     }
 }
+
+static drishti::hci::FaceFinder::Backpressure getBackpressure(const std::string& sBackpressure)
+{
+    switch (string_hash::hash(sBackpressure))
+    {
+        case "block"_hash: return drishti::hci::FaceFinder::kBlock; break;
+        case "newest"_hash: return drishti::hci::FaceFinder::kDropNewest; break;
+        case "oldest"_hash: return drishti::hci::FaceFinder::kDropOldest; break;
+        case "last"_hash: return drishti::hci::FaceFinder::kReuseLast; break;
+        default: throw std::runtime_error("Unsupported backpressure policy " + sBackpressure);
+    }
+}
+
+// Summarize the retained tracer spans (the most recent StageTracer::getCapacity() spans):
+static void report(LoggerPtr& logger, const drishti::hci::FaceFinder& detector, std::size_t frames, const std::string& sTrace)
+{
+    using FaceFinder = drishti::hci::FaceFinder;
+
+    const auto& tracer = detector.getStageTracer();
+    const auto& names = tracer.getStageNames();
+    for (int i = 0; i < static_cast<int>(names.size()); i++)
+    {
+        const auto count = tracer.getSpans(i).size();
+        if (count)
+        {
+            logger->info("{}: n={} p50={}ms p95={}ms p99={}ms", names[i], count, tracer.p50(i) * 1e3, tracer.p95(i) * 1e3, tracer.p99(i) * 1e3);
+        }
+    }
+
+    logger->info("frames: {} dropped: {}", frames, detector.getDroppedFrameCount());
+
+    // Render thread (GPU submission + readback) vs CPU scene job stages:
+    const std::vector<int> gpu = { FaceFinder::kAcfRead, FaceFinder::kEyePatches, FaceFinder::kReadbackWait, FaceFinder::kPaint, FaceFinder::kFifoRender };
+    const std::vector<int> cpu = { FaceFinder::kFill, FaceFinder::kDetect, FaceFinder::kFaceRegression, FaceFinder::kEyeRegression, FaceFinder::kBlobExtraction };
+    const double both = tracer.overlap(gpu, cpu), total = tracer.overlap(cpu, cpu); // total: union of cpu spans
+    logger->info("gpu/cpu overlap: {}ms ({}% of cpu time)", both * 1e3, (total > 0.0) ? (100.0 * both / total) : 0.0);
+
+    if (!sTrace.empty())
+    {
+        std::ofstream os(sTrace);
+        if (os)
+        {
+            tracer.writeChromeTrace(os);
+        }
+        else
+        {
+            logger->error("Unable to write trace {}", sTrace);
+        }
+    }
+}
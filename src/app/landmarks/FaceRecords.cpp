@@ -0,0 +1,640 @@
+/*! -*-c++-*-
+  @file   FaceRecords.cpp
+  @author David Hirvonen
+  @brief  Compact (sharded) record files for face training and evaluation samples.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "landmarks/FaceRecords.h"
+#include "drishti/core/Parallel.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#if defined(DRISHTI_USE_LZ4)
+#  include <lz4.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// clang-format off
+#if !defined(_WIN32)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define DRISHTI_LANDMARKS_FACE_RECORDS_USE_MMAP 1
+#else
+#  define DRISHTI_LANDMARKS_FACE_RECORDS_USE_MMAP 0
+#endif
+// clang-format on
+
+DRISHTI_BEGIN_NAMESPACE(FACE)
+
+static const char kMagic[4] = { 'D', 'R', 'F', 'R' };
+static const char kIndexMagic[4] = { 'D', 'R', 'F', 'I' };
+static const std::uint32_t kVersion = 2; // 1: kEncoded only (no codec field)
+static const std::size_t kHeaderSize = 16;
+static const std::size_t kFooterSize = 20; // count, index offset, magic
+
+template <typename T>
+static void putLE(std::vector<char>& buffer, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+template <typename T>
+static T getLE(const char* data)
+{
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        value |= static_cast<T>(static_cast<std::uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+static void putFloat(std::vector<char>& buffer, float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putLE(buffer, bits);
+}
+
+static float getFloat(const char* data)
+{
+    const auto bits = getLE<std::uint32_t>(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Bounds checked reader for a single record:
+struct RecordParser
+{
+    RecordParser(const char* data, std::size_t size)
+        : data(data)
+        , size(size)
+    {
+    }
+
+    const char* take(std::size_t n)
+    {
+        if ((offset + n) > size)
+        {
+            return nullptr;
+        }
+        const char* result = data + offset;
+        offset += n;
+        return result;
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        const char* bytes = take(sizeof(T));
+        if (bytes)
+        {
+            value = getLE<T>(bytes);
+        }
+        return (bytes != nullptr);
+    }
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+    std::size_t offset = 0;
+};
+
+static void putImage(std::vector<char>& buffer, const cv::Mat& image, const FaceRecordWriter::Settings& settings)
+{
+    if (settings.codec == FaceRecordWriter::kEncoded)
+    {
+        std::vector<uchar> encoded;
+        if (!image.empty())
+        {
+            cv::imencode(settings.extension, image, encoded);
+        }
+        putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(encoded.size()));
+        buffer.insert(buffer.end(), encoded.begin(), encoded.end());
+        return;
+    }
+
+    const cv::Mat pixels = image.isContinuous() ? image : image.clone();
+    const auto size = pixels.total() * pixels.elemSize();
+    const char* data = reinterpret_cast<const char*>(pixels.data);
+
+    putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(pixels.rows));
+    putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(pixels.cols));
+    putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(pixels.type()));
+
+#if defined(DRISHTI_USE_LZ4)
+    if ((settings.codec == FaceRecordWriter::kLZ4) && size)
+    {
+        const std::size_t offset = buffer.size() + 4; // after the length
+        const int bound = LZ4_compressBound(static_cast<int>(size));
+        buffer.resize(offset + bound);
+        const int length = std::max(LZ4_compress_default(data, &buffer[offset], static_cast<int>(size), bound), 0);
+        buffer.resize(offset + length);
+        for (std::size_t i = 0; i < 4; i++)
+        {
+            buffer[offset - 4 + i] = static_cast<char>((length >> (8 * i)) & 0xff);
+        }
+        return;
+    }
+#endif
+
+    putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(size));
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+static bool getImage(RecordParser& parser, std::uint32_t codec, int flags, cv::Mat& image)
+{
+    image = cv::Mat();
+
+    if (codec == FaceRecordWriter::kEncoded)
+    {
+        std::uint32_t length = 0;
+        const char* encoded = nullptr;
+        if (!parser.read(length) || !(encoded = parser.take(length)))
+        {
+            return false;
+        }
+        if (length)
+        {
+            cv::Mat bytes(1, static_cast<int>(length), CV_8UC1, const_cast<char*>(encoded));
+            image = cv::imdecode(bytes, flags);
+        }
+        return true;
+    }
+
+    std::uint32_t rows = 0, cols = 0, type = 0, length = 0;
+    const char* data = nullptr;
+    if (!parser.read(rows) || !parser.read(cols) || !parser.read(type) || !parser.read(length) || !(data = parser.take(length)))
+    {
+        return false;
+    }
+
+    cv::Mat pixels(static_cast<int>(rows), static_cast<int>(cols), static_cast<int>(type));
+    const auto size = pixels.total() * pixels.elemSize();
+    if (!size)
+    {
+        return (length == 0);
+    }
+
+    if (codec == FaceRecordWriter::kLZ4)
+    {
+#if defined(DRISHTI_USE_LZ4)
+        const int result = LZ4_decompress_safe(data, reinterpret_cast<char*>(pixels.data), static_cast<int>(length), static_cast<int>(size));
+        if ((result < 0) || (static_cast<std::size_t>(result) != size))
+        {
+            return false;
+        }
+#else
+        return false; // built without LZ4 support
+#endif
+    }
+    else if (length == size)
+    {
+        std::memcpy(pixels.data, data, size);
+    }
+    else
+    {
+        return false;
+    }
+
+    // Match the cv::imdecode() flags used for encoded records:
+    if ((flags == cv::IMREAD_GRAYSCALE) && (pixels.channels() == 3))
+    {
+        cv::cvtColor(pixels, image, cv::COLOR_BGR2GRAY);
+    }
+    else if ((flags == cv::IMREAD_COLOR) && (pixels.channels() == 1))
+    {
+        cv::cvtColor(pixels, image, cv::COLOR_GRAY2BGR);
+    }
+    else
+    {
+        image = pixels;
+    }
+
+    return true;
+}
+
+// =========================== FaceRecordWriter ===========================
+
+FaceRecordWriter::FaceRecordWriter(const std::string& filename)
+    : FaceRecordWriter(filename, Settings())
+{
+}
+
+FaceRecordWriter::FaceRecordWriter(const std::string& filename, const Settings& settings)
+    : m_filename(filename)
+    , m_settings(settings)
+{
+    m_settings.capacity = std::max(m_settings.capacity, std::size_t(1));
+
+#if !defined(DRISHTI_USE_LZ4)
+    if (m_settings.codec == kLZ4)
+    {
+        m_settings.codec = kRaw;
+    }
+#endif
+
+    if ((m_good = openShard()))
+    {
+        m_thread = std::thread(&FaceRecordWriter::run, this);
+    }
+}
+
+FaceRecordWriter::~FaceRecordWriter()
+{
+    close();
+}
+
+bool FaceRecordWriter::openShard()
+{
+    std::string filename = m_filename;
+    if (m_settings.shardSize)
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "_%05d.drfr", static_cast<int>(m_shards.size()));
+        filename += suffix;
+    }
+
+    m_offsets.clear();
+    m_stream.open(filename, std::ios::binary);
+    if (!m_stream)
+    {
+        return false;
+    }
+    m_shards.push_back(filename);
+
+    std::vector<char> header(kMagic, kMagic + 4);
+    putLE<std::uint32_t>(header, kVersion);
+    putLE<std::uint32_t>(header, static_cast<std::uint32_t>(m_settings.codec));
+    header.resize(kHeaderSize, 0);
+    return static_cast<bool>(m_stream.write(header.data(), header.size()));
+}
+
+void FaceRecordWriter::finishShard()
+{
+    const std::uint64_t indexOffset = static_cast<std::uint64_t>(m_stream.tellp());
+    std::vector<char> index;
+    index.reserve(m_offsets.size() * 8 + kFooterSize);
+    for (const auto& offset : m_offsets)
+    {
+        putLE<std::uint64_t>(index, offset);
+    }
+    putLE<std::uint64_t>(index, m_offsets.size());
+    putLE<std::uint64_t>(index, indexOffset);
+    index.insert(index.end(), kIndexMagic, kIndexMagic + 4);
+    m_stream.write(index.data(), index.size());
+    m_stream.close();
+}
+
+void FaceRecordWriter::push(const FaceRecord& record)
+{
+    if (!m_good)
+    {
+        return;
+    }
+
+    std::vector<char> buffer;
+    buffer.reserve(4 + record.filename.size() + 20 + record.points.size() * 8 + 16 + record.image.total() * record.image.elemSize());
+    putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(record.filename.size()));
+    buffer.insert(buffer.end(), record.filename.begin(), record.filename.end());
+    for (const auto& value : { record.roi.x, record.roi.y, record.roi.width, record.roi.height })
+    {
+        putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(value));
+    }
+    putLE<std::uint32_t>(buffer, static_cast<std::uint32_t>(record.points.size()));
+    for (const auto& p : record.points)
+    {
+        putFloat(buffer, p.x);
+        putFloat(buffer, p.y);
+    }
+    putImage(buffer, record.image, m_settings);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_popped.wait(lock, [&]() { return m_done || (m_queue.size() < m_settings.capacity); });
+    if (!m_done)
+    {
+        m_queue.push_back(std::move(buffer));
+        m_pushed.notify_one();
+    }
+}
+
+void FaceRecordWriter::run()
+{
+    std::uint64_t offset = kHeaderSize;
+    while (true)
+    {
+        std::vector<char> buffer;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pushed.wait(lock, [&]() { return m_done || !m_queue.empty(); });
+            if (m_queue.empty())
+            {
+                break; // done and drained
+            }
+            buffer = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_popped.notify_one();
+        }
+
+        if (m_settings.shardSize && (m_offsets.size() == m_settings.shardSize))
+        {
+            finishShard();
+            if (!openShard())
+            {
+                break;
+            }
+            offset = kHeaderSize;
+        }
+
+        if (m_stream.write(buffer.data(), buffer.size()))
+        {
+            m_offsets.push_back(offset);
+            offset += buffer.size();
+            m_count++;
+        }
+    }
+}
+
+std::size_t FaceRecordWriter::close()
+{
+    if (!m_thread.joinable())
+    {
+        return m_count;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done = true;
+        m_pushed.notify_all();
+        m_popped.notify_all();
+    }
+    m_thread.join();
+
+    if (m_stream.is_open())
+    {
+        finishShard();
+    }
+
+    if (m_settings.shardSize)
+    {
+        // Shard list in the drishti::cli::expand() format:
+        std::ofstream os(m_filename + ".txt");
+        for (const auto& shard : m_shards)
+        {
+            os << shard << std::endl;
+        }
+    }
+
+    m_good = false;
+
+    return m_count;
+}
+
+// =========================== FaceRecordReader ===========================
+
+FaceRecordReader::FaceRecordReader(const std::string& filename)
+{
+    if (!isRecordFile(filename))
+    {
+        return;
+    }
+
+#if DRISHTI_LANDMARKS_FACE_RECORDS_USE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+        {
+            mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd); // the mapping holds its own reference
+
+        if (mapped != MAP_FAILED)
+        {
+            m_data = static_cast<const char*>(mapped);
+            m_size = static_cast<std::size_t>(info.st_size);
+        }
+    }
+#endif
+
+    if (!m_data)
+    {
+        m_stream.open(filename, std::ios::binary);
+        m_stream.seekg(0, std::ios::end);
+        m_size = m_stream ? static_cast<std::size_t>(m_stream.tellg()) : 0;
+    }
+
+    if (m_size < (kHeaderSize + kFooterSize))
+    {
+        return;
+    }
+
+    std::vector<char> buffer;
+    const char *header = nullptr, *footer = nullptr;
+    if (!read(0, kHeaderSize, buffer, header))
+    {
+        return;
+    }
+
+    const auto version = getLE<std::uint32_t>(header + 4);
+    m_codec = (version >= 2) ? getLE<std::uint32_t>(header + 8) : std::uint32_t(FaceRecordWriter::kEncoded);
+    if ((version > kVersion) || (m_codec > FaceRecordWriter::kLZ4))
+    {
+        return;
+    }
+
+    std::vector<char> footerBuffer;
+    if (!read(m_size - kFooterSize, kFooterSize, footerBuffer, footer) || std::memcmp(footer + 16, kIndexMagic, 4))
+    {
+        return;
+    }
+
+    const auto count = getLE<std::uint64_t>(footer);
+    m_end = getLE<std::uint64_t>(footer + 8);
+    if ((m_end < kHeaderSize) || ((m_end + count * 8 + kFooterSize) != m_size))
+    {
+        return;
+    }
+
+    const char* index = nullptr;
+    if (!read(m_end, count * 8, buffer, index))
+    {
+        return;
+    }
+
+    m_offsets.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        m_offsets[i] = getLE<std::uint64_t>(index + i * 8);
+        if ((m_offsets[i] < kHeaderSize) || (m_offsets[i] > m_end) || (i && (m_offsets[i] < m_offsets[i - 1])))
+        {
+            m_offsets.clear();
+            return;
+        }
+    }
+
+    m_good = true;
+}
+
+FaceRecordReader::~FaceRecordReader()
+{
+#if DRISHTI_LANDMARKS_FACE_RECORDS_USE_MMAP
+    if (m_data)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+}
+
+// Points data at the requested bytes (in place when mapped):
+bool FaceRecordReader::read(std::uint64_t offset, std::size_t size, std::vector<char>& buffer, const char*& data) const
+{
+    if ((offset + size) > m_size)
+    {
+        return false;
+    }
+
+    if (m_data)
+    {
+        data = m_data + offset;
+        return true;
+    }
+
+    buffer.resize(size);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stream.clear();
+    m_stream.seekg(offset);
+    data = buffer.data();
+    return static_cast<bool>(m_stream.read(buffer.data(), size));
+}
+
+bool FaceRecordReader::get(std::size_t index, FaceRecord& record, int flags) const
+{
+    if (!m_good || (index >= m_offsets.size()))
+    {
+        return false;
+    }
+
+    const std::uint64_t begin = m_offsets[index];
+    const std::uint64_t end = ((index + 1) < m_offsets.size()) ? m_offsets[index + 1] : m_end;
+
+    std::vector<char> buffer;
+    const char* data = nullptr;
+    if (!read(begin, end - begin, buffer, data))
+    {
+        return false;
+    }
+
+    // Decode outside of the stream lock so readers can run in parallel:
+    RecordParser parser(data, end - begin);
+
+    std::uint32_t length = 0;
+    const char* name = nullptr;
+    if (!parser.read(length) || !(name = parser.take(length)))
+    {
+        return false;
+    }
+    record.filename.assign(name, length);
+
+    std::uint32_t roi[4];
+    for (auto& value : roi)
+    {
+        if (!parser.read(value))
+        {
+            return false;
+        }
+    }
+    record.roi = { int(roi[0]), int(roi[1]), int(roi[2]), int(roi[3]) };
+
+    std::uint32_t count = 0;
+    const char* points = nullptr;
+    if (!parser.read(count) || !(points = parser.take(std::size_t(count) * 8)))
+    {
+        return false;
+    }
+    record.points.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        record.points[i] = { getFloat(points + i * 8), getFloat(points + i * 8 + 4) };
+    }
+
+    return getImage(parser, m_codec, flags, record.image);
+}
+
+bool FaceRecordReader::isRecordFile(const std::string& filename)
+{
+    char magic[4] = { 0 };
+    std::ifstream is(filename, std::ios::binary);
+    return is.read(magic, 4) && !std::memcmp(magic, kMagic, 4);
+}
+
+// =========================== FaceRecordDataset ===========================
+
+bool FaceRecordDataset::open(const std::vector<std::string>& filenames)
+{
+    m_shards.clear();
+    m_begin = { 0 };
+
+    for (const auto& filename : filenames)
+    {
+        std::unique_ptr<FaceRecordReader> shard(new FaceRecordReader(filename));
+        if (!shard->good())
+        {
+            m_shards.clear();
+            m_begin = { 0 };
+            return false;
+        }
+        m_begin.push_back(m_begin.back() + shard->size());
+        m_shards.push_back(std::move(shard));
+    }
+
+    return !m_shards.empty();
+}
+
+bool FaceRecordDataset::get(std::size_t index, FaceRecord& record, int flags) const
+{
+    if (index >= size())
+    {
+        return false;
+    }
+
+    const auto shard = static_cast<std::size_t>(std::upper_bound(m_begin.begin(), m_begin.end(), index) - m_begin.begin()) - 1;
+    return m_shards[shard]->get(index - m_begin[shard], record, flags);
+}
+
+void FaceRecordDataset::parallel(const Callback& callback, int flags, int threads) const
+{
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        FaceRecord record;
+        if (get(static_cast<std::size_t>(i), record, flags))
+        {
+            callback(static_cast<std::size_t>(i), record);
+        }
+    };
+
+    if (threads == 1 || threads == 0)
+    {
+        harness({ 0, static_cast<int>(size()) });
+    }
+    else
+    {
+        cv::parallel_for_({ 0, static_cast<int>(size()) }, harness, std::max(threads, -1));
+    }
+}
+
+DRISHTI_END_NAMESPACE(FACE)
@@ -0,0 +1,166 @@
+/*! -*-c++-*-
+  @file   FaceRecords.h
+  @author David Hirvonen
+  @brief  Compact (sharded) record files for face training and evaluation samples.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Layout (little-endian):
+
+    Header  : magic "DRFR", version, codec, reserved (16 bytes)
+    Records : { name, roi, points, image } per record
+    Index   : record offsets (uint64) followed by { count, index offset, magic "DRFI" }
+
+  Images are stored encoded (e.g., png), as raw pixels, or as LZ4 compressed raw pixels
+  (DRISHTI_USE_LZ4), where the raw codecs trade space for decoding speed.
+
+  Records are appended by a single writer thread, so any number of producer threads
+  (e.g., parallel jitter workers) can push samples without coordinating file I/O.
+  Images are encoded on the producer thread, and the index is written on close(),
+  so a truncated file (crashed producer) is rejected by the reader.  Large datasets
+  can be split into shards, with a "<prefix>.txt" shard list for FaceRecordDataset.
+
+*/
+
+#ifndef __drishti_landmarks_FaceRecords_h__
+#define __drishti_landmarks_FaceRecords_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+DRISHTI_BEGIN_NAMESPACE(FACE)
+
+struct FaceRecord
+{
+    std::string filename; // source image (or sample name)
+    cv::Rect roi;         // face region in image coordinates (optional)
+    std::vector<cv::Point2f> points;
+    cv::Mat image;
+};
+
+class FaceRecordWriter
+{
+public:
+    enum Codec
+    {
+        kEncoded, // cv::imencode() (see Settings::extension)
+        kRaw,     // uncompressed pixels
+        kLZ4      // LZ4 compressed pixels (kRaw without DRISHTI_USE_LZ4)
+    };
+
+    struct Settings
+    {
+        std::size_t capacity = 256;     // queued records before push() blocks
+        std::string extension = ".png"; // kEncoded format
+        Codec codec = kEncoded;
+        std::size_t shardSize = 0; // records per "<prefix>_%05d.drfr" shard (0 == single file)
+    };
+
+    explicit FaceRecordWriter(const std::string& filename);
+    FaceRecordWriter(const std::string& filename, const Settings& settings);
+    ~FaceRecordWriter();
+
+    FaceRecordWriter(const FaceRecordWriter&) = delete;
+    FaceRecordWriter& operator=(const FaceRecordWriter&) = delete;
+
+    bool good() const { return m_good; }
+
+    // Thread safe, the image is encoded on the calling thread:
+    void push(const FaceRecord& record);
+
+    // Drain the queue and write the index (and shard list), returns the record count:
+    std::size_t close();
+
+protected:
+    bool openShard();
+    void finishShard();
+    void run();
+
+    std::string m_filename;
+    Settings m_settings;
+    bool m_good = false;
+    bool m_done = false;
+
+    std::ofstream m_stream; // current shard
+    std::vector<std::uint64_t> m_offsets;
+    std::vector<std::string> m_shards;
+    std::size_t m_count = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_pushed;
+    std::condition_variable m_popped;
+    std::deque<std::vector<char>> m_queue;
+    std::thread m_thread;
+};
+
+class FaceRecordReader
+{
+public:
+    // Files are memory mapped where supported (concurrent get() calls don't lock):
+    explicit FaceRecordReader(const std::string& filename);
+    ~FaceRecordReader();
+
+    FaceRecordReader(const FaceRecordReader&) = delete;
+    FaceRecordReader& operator=(const FaceRecordReader&) = delete;
+
+    bool good() const { return m_good; }
+    std::size_t size() const { return m_offsets.size(); }
+
+    // Thread safe random access, returns false for corrupt records:
+    bool get(std::size_t index, FaceRecord& record, int flags = cv::IMREAD_COLOR) const;
+
+    // True if the file starts with the record file magic:
+    static bool isRecordFile(const std::string& filename);
+
+protected:
+    bool read(std::uint64_t offset, std::size_t size, std::vector<char>& buffer, const char*& data) const;
+
+    const char* m_data = nullptr; // mmap
+    std::size_t m_size = 0;
+    mutable std::mutex m_mutex; // stream
+    mutable std::ifstream m_stream;
+
+    std::uint32_t m_codec = FaceRecordWriter::kEncoded;
+    std::vector<std::uint64_t> m_offsets;
+    std::uint64_t m_end = 0; // start of the index
+    bool m_good = false;
+};
+
+// One or more shards with global indexing:
+class FaceRecordDataset
+{
+public:
+    using Callback = std::function<void(std::size_t index, FaceRecord& record)>;
+
+    // Returns false if any shard is missing or invalid:
+    bool open(const std::vector<std::string>& filenames);
+
+    std::size_t size() const { return m_begin.empty() ? 0 : m_begin.back(); }
+
+    bool get(std::size_t index, FaceRecord& record, int flags = cv::IMREAD_COLOR) const;
+
+    // Decode every (valid) record on threads worker threads, callback is called concurrently:
+    void parallel(const Callback& callback, int flags = cv::IMREAD_COLOR, int threads = -1) const;
+
+protected:
+    std::vector<std::unique_ptr<FaceRecordReader>> m_shards;
+    std::vector<std::size_t> m_begin{ 0 }; // first record index per shard (+ total)
+};
+
+DRISHTI_END_NAMESPACE(FACE)
+
+#endif // __drishti_landmarks_FaceRecords_h__
@@ -14,6 +14,7 @@ sugar_files(DRISHTI_LANDMARKS_LIB_SRCS
   BIOID.cpp
   DRISHTI.cpp
   FACE.cpp
+  FaceRecords.cpp
   HELEN.cpp
   LFW.cpp
   LFPW.cpp
@@ -25,6 +26,7 @@ sugar_files(DRISHTI_LANDMARKS_LIB_HDRS
   BIOID.h
   DRISHTI.h  
   FACE.h  
+  FaceRecords.h
   HELEN.h 
   LFW.h   
   LFPW.h   
@@ -16,12 +16,19 @@
 #include "drishti/ml/RegressionTreeEnsembleShapeEstimatorDEST.h"
 #include "drishti/ml/ObjectDetectorCV.h"
 #include "drishti/face/FaceDetector.h"
+#include "drishti/core/AppendSink.h"
+#include "drishti/core/LazyParallelResource.h"
 #include "drishti/core/Logger.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
 #include "drishti/core/string_utils.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/drishti_cv_cereal.h"
 #include "drishti/geometry/motion.h"
+#include "drishti/testlib/drishti_cli.h"
 
 #include "drishti/graphics/mesh.h"
+#include "drishti/graphics/isomap.h"
 
 // clang-format off
 #if defined(DRISHTI_USE_IMSHOW)
@@ -50,11 +57,19 @@
 
 #include "cxxopts.hpp"
 
+#include <cereal/archives/json.hpp>
+#include <cereal/types/vector.hpp>
+
 #include <iostream>
 #include <sstream>
 #include <numeric>
+#include <thread>
 
 using Landmarks = std::vector<cv::Point2f>;
+using FaceMeshMapperPtr = std::shared_ptr<drishti::face::FaceMeshMapper>;
+using FaceMeshContainerPtr = drishti::face::FaceMeshMapper::FaceMeshContainerPtr;
+using ObjectDetectorPtr = std::shared_ptr<drishti::ml::ObjectDetectorCV>;
+using ShapeEstimatorPtr = std::shared_ptr<drishti::ml::RegressionTreeEnsembleShapeEstimatorDEST>;
 
 static void* void_ptr(const cv::Mat& image)
 {
@@ -63,6 +78,21 @@ static void* void_ptr(const cv::Mat& image)
 
 static std::vector<float> parseVec3f(const std::string& R);
 static cv::Mat getImage(ogles_gpgpu::ProcInterface& proc, cv::Mat& frame);
+static bool findLandmarks(drishti::ml::ObjectDetectorCV& detector, drishti::ml::RegressionTreeEnsembleShapeEstimatorDEST& landmarker, const cv::Mat& input, cv::Rect& face, Landmarks& landmarks);
+static std::string toJsonLine(const std::string& filename, const cv::Rect& face, const Landmarks& landmarks, const FaceMeshContainerPtr& result);
+
+struct BatchSettings
+{
+    std::string sDetector;
+    std::string sRegressor;
+    std::string sFaceMeshMapperFactory;
+    std::string sOutput;
+    int width = 256;
+    int threads = -1;
+    bool doWarmStart = false; // sequential frames of one subject (video)
+};
+
+static int runBatch(const std::vector<std::string>& inputs, const BatchSettings& settings, drishti::core::Logger::Pointer& logger);
 
 struct Cursor
 {
@@ -116,6 +146,8 @@ int gauze_main(int argc, char* argv[])
     bool doWire = false;
     bool doClear = false;
     bool doCursor = false;
+    bool doBatch = false;
+    bool doWarmStart = false;
     int threads = -1;
     int width = 256;
 
@@ -137,6 +169,8 @@ int gauze_main(int argc, char* argv[])
         ("factory", "FaceMeshMapperFactory json file", cxxopts::value<std::string>(sFaceMeshMapperFactory))
         ("boilerplate", "FaceMeshMapperFactory boilerplate", cxxopts::value<std::string>(sBoilerplate))
 
+        ("batch", "Fit all images of the input list (results in <output>/pose.jsonl)", cxxopts::value<bool>(doBatch))
+        ("warm-start", "Batch input is a video: warm start each fit from the previous frame", cxxopts::value<bool>(doWarmStart))
         ("t,threads", "Thread count", cxxopts::value<int>(threads))
         ("h,help", "Print help message");
     // clang-format on
@@ -172,6 +206,26 @@ int gauze_main(int argc, char* argv[])
         return 1;
     }
 
+    if (sFaceMeshMapperFactory.empty() || sDetector.empty() || sRegressor.empty())
+    {
+        logger->error("Must specify a valid mesh factory input file, detector and regressor");
+        return 1;
+    }
+
+    const auto inputs = drishti::cli::expand(sInput);
+    if (doBatch || (inputs.size() > 1))
+    {
+        BatchSettings settings;
+        settings.sDetector = sDetector;
+        settings.sRegressor = sRegressor;
+        settings.sFaceMeshMapperFactory = sFaceMeshMapperFactory;
+        settings.sOutput = sOutput;
+        settings.width = width;
+        settings.threads = threads;
+        settings.doWarmStart = doWarmStart;
+        return runBatch(inputs, settings, logger);
+    }
+
     cv::Mat input = cv::imread(sInput);
     if (input.empty())
     {
@@ -182,67 +236,33 @@ int gauze_main(int argc, char* argv[])
     cv::resize(input, input, { width, input.rows * width / input.cols }, cv::INTER_CUBIC);
 
     // ########## FACE MESH LANDMARKER #########
-    if (sFaceMeshMapperFactory.empty())
-    {
-        logger->error("Must specify a valid mesh factory input file");
-        return 1;
-    }
     auto mapper = drishti::face::FaceMeshMapperFactory(sFaceMeshMapperFactory).create();
 
     // ######### DETECTOR ######################
-    if (sDetector.empty())
-    {
-        logger->error("Must specify detector file");
-        return 1;
-    }
     auto detector = std::make_shared<drishti::ml::ObjectDetectorCV>(sDetector);
     detector->setMinNeighbors(3);
 
     // ######### LANDMARKS ######################
-    if (sRegressor.empty())
-    {
-        logger->error("Must specify regressor file");
-        return 1;
-    }
     auto landmarker = std::make_shared<drishti::ml::RegressionTreeEnsembleShapeEstimatorDEST>(sRegressor);
     
     Landmarks landmarks;
     if (detector && landmarker)
     {
-        cv::Mat gray;
-        cv::extractChannel(input, gray, 1);
-
         cv::Rect face;
-
-        { // Detect largest face via OpenCV (used for DEST training):
-            std::vector<cv::Rect> faces;
-            (*detector)(gray, faces);
-            if (faces.size())
-            {
-                std::sort(begin(faces), end(faces), [](const cv::Rect& a, const cv::Rect& b) { return a.area() > b.area(); });
-                face = faces.front();
-            }
-            else
-            {
-                logger->info("No faces found");
-                return 0;
-            }
-        }
-
-        { // Get landmarks:
-            std::vector<bool> mask;
-            (*landmarker)(gray(face), landmarks, mask);
-            for (auto& p : landmarks)
-            {
-                p += cv::Point2f(face.x, face.y);
-            }
+        if (!findLandmarks(*detector, *landmarker, input, face, landmarks))
+        {
+            logger->info("No faces found");
+            return 0;
         }
 
         std::string sBase = drishti::core::basename(sInput);
 
         {
             auto result = (*mapper)(landmarks, input);
-            cv::Mat iso = result->extractTexture(input);
+            cv::Mat iso;
+#if !defined(DRISHTI_DO_GPU_TESTING)
+            iso = result->extractTexture(input);
+#endif
             cv::Point3f Reuler = result->getRotation();
 
             logger->info("rotation: {} {} {}", Reuler.x, Reuler.y, Reuler.z);
@@ -264,6 +284,13 @@ int gauze_main(int argc, char* argv[])
                 drishti::graphics::MeshTex mesh;
                 result->getFaceMesh(mesh);
 
+                { // Extract the isomap on the GPU:
+                    ogles_gpgpu::GLTexture image(frame.cols, frame.rows, TEXTURE_FORMAT, void_ptr(frame));
+                    ogles_gpgpu::IsomapExtractor extractor;
+                    extractor(mesh, result->getAffineCamera(), image, frame.size());
+                    extractor.getIsomap(iso, TEXTURE_FORMAT);
+                }
+
                 // Perform texture swizzling:
                 ogles_gpgpu::VideoSource source;
                 ogles_gpgpu::MeshProc warper(mesh, iso, doWire);
@@ -377,6 +404,179 @@ int main(int argc, char** argv)
     }
 }
 
+// Landmarks of the largest face found by the OpenCV detector (used for DEST training):
+static bool findLandmarks(drishti::ml::ObjectDetectorCV& detector, drishti::ml::RegressionTreeEnsembleShapeEstimatorDEST& landmarker, const cv::Mat& input, cv::Rect& face, Landmarks& landmarks)
+{
+    cv::Mat gray;
+    cv::extractChannel(input, gray, 1);
+
+    std::vector<cv::Rect> faces;
+    detector(gray, faces);
+    if (faces.empty())
+    {
+        return false;
+    }
+
+    face = *std::max_element(begin(faces), end(faces), [](const cv::Rect& a, const cv::Rect& b) { return a.area() < b.area(); });
+
+    std::vector<bool> mask;
+    landmarker(gray(face), landmarks, mask);
+    for (auto& p : landmarks)
+    {
+        p += cv::Point2f(face.x, face.y);
+    }
+    return true;
+}
+
+static std::string toJsonLine(const std::string& filename, const cv::Rect& face, const Landmarks& landmarks, const FaceMeshContainerPtr& result)
+{
+    std::stringstream ss;
+    {
+        cereal::JSONOutputArchive oa(ss, cereal::JSONOutputArchive::Options::NoIndent());
+        using Archive = decltype(oa); // needed by macro
+        oa << GENERIC_NVP("filename", filename);
+        if (result)
+        {
+            const cv::Point3f R = result->getRotation();
+            const cv::Vec4f Q = result->getQuaternion();
+            std::vector<float> rotation{ R.x, R.y, R.z }, quaternion{ Q[0], Q[1], Q[2], Q[3] };
+            cv::Rect roi = face;
+            Landmarks points = landmarks;
+            oa << GENERIC_NVP("roi", roi);
+            oa << GENERIC_NVP("rotation", rotation);
+            oa << GENERIC_NVP("quaternion", quaternion);
+            oa << GENERIC_NVP("landmarks", points);
+        }
+    }
+    std::string line = ss.str();
+    line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
+    return line;
+}
+
+// Batch fitting: the morphable model is loaded once and shared (read-only) by one mapper
+// clone per worker thread, the detector and landmark regressor are per thread, and
+// results are streamed to <output>/pose.jsonl as they complete.  With warm starts (video)
+// the landmarks are still found in parallel, but the fits run in frame order on a single
+// tracking mapper, so each one starts from the previous solution.
+static int runBatch(const std::vector<std::string>& inputs, const BatchSettings& settings, drishti::core::Logger::Pointer& logger)
+{
+    auto mapper = drishti::face::FaceMeshMapperFactory(settings.sFaceMeshMapperFactory).create();
+    if (settings.doWarmStart)
+    {
+        drishti::face::FaceMeshMapper::TrackingSettings tracking;
+        tracking.enabled = true;
+        mapper->setTracking(tracking);
+    }
+
+    drishti::core::AppendSink sink(settings.sOutput + "/pose.jsonl");
+    if (!sink.good())
+    {
+        logger->error("Failed to open {}/pose.jsonl", settings.sOutput);
+        return 1;
+    }
+
+    struct Worker
+    {
+        ObjectDetectorPtr detector;
+        ShapeEstimatorPtr landmarker;
+        FaceMeshMapperPtr mapper;
+    };
+
+    using WorkerPtr = std::unique_ptr<Worker>;
+    drishti::core::LazyParallelResource<std::thread::id, WorkerPtr> manager = [&]() {
+        auto worker = drishti::core::make_unique<Worker>();
+        worker->detector = std::make_shared<drishti::ml::ObjectDetectorCV>(settings.sDetector);
+        worker->detector->setMinNeighbors(3);
+        worker->landmarker = std::make_shared<drishti::ml::RegressionTreeEnsembleShapeEstimatorDEST>(settings.sRegressor);
+        if (!settings.doWarmStart)
+        {
+            worker->mapper = mapper->clone();
+            if (!worker->mapper)
+            {
+                worker->mapper = drishti::face::FaceMeshMapperFactory(settings.sFaceMeshMapperFactory).create();
+            }
+        }
+        return worker;
+    };
+
+    struct Frame
+    {
+        cv::Mat image;
+        cv::Rect face;
+        Landmarks landmarks;
+        bool good = false;
+    };
+
+    // Video: landmarks for a block of frames first, then the (sequential) fits:
+    const int block = settings.doWarmStart ? 256 : static_cast<int>(inputs.size());
+    std::vector<Frame> frames(settings.doWarmStart ? block : 0);
+    int first = 0;
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int j) {
+        const int i = first + j;
+        auto& worker = manager[std::this_thread::get_id()];
+
+        Frame frame;
+        frame.image = cv::imread(inputs[i]);
+        if (frame.image.empty())
+        {
+            logger->warn("Unable to read input file {}", inputs[i]);
+        }
+        else
+        {
+            cv::resize(frame.image, frame.image, { settings.width, frame.image.rows * settings.width / frame.image.cols }, cv::INTER_CUBIC);
+            frame.good = findLandmarks(*worker->detector, *worker->landmarker, frame.image, frame.face, frame.landmarks);
+        }
+
+        if (settings.doWarmStart)
+        {
+            frames[j] = std::move(frame);
+        }
+        else
+        {
+            auto result = frame.good ? (*worker->mapper)(frame.landmarks, frame.image) : nullptr;
+            sink.push(toJsonLine(inputs[i], frame.face, frame.landmarks, result));
+        }
+    };
+
+    // Images without faces return early, so claim one image at a time:
+    drishti::core::ParallelSettings parallel;
+    parallel.threads = settings.threads;
+    parallel.grain = 1;
+    parallel.progress = [&](int done, int) {
+        if (((done % 100) == 0) || (done == total))
+        {
+            logger->info("{}/{}", first + done, inputs.size());
+        }
+    };
+
+    for (; first < static_cast<int>(inputs.size()); first += block)
+    {
+        const int count = std::min(block, static_cast<int>(inputs.size()) - first);
+        drishti::core::parallelFor({ 0, count }, harness, parallel);
+
+        if (settings.doWarmStart)
+        {
+            for (int j = 0; j < count; j++)
+            {
+                FaceMeshContainerPtr result;
+                if (frames[j].good)
+                {
+                    result = (*mapper)(frames[j].landmarks, frames[j].image);
+                }
+                else
+                {
+                    mapper->reset(); // the subject may change across a gap
+                }
+                sink.push(toJsonLine(inputs[first + j], frames[j].face, frames[j].landmarks, result));
+            }
+        }
+    }
+
+    logger->info("Wrote {} results to {}/pose.jsonl", sink.close(), settings.sOutput);
+    return 0;
+}
+
 static cv::Mat getImage(ogles_gpgpu::ProcInterface& proc, cv::Mat& frame)
 {
     if (dynamic_cast<ogles_gpgpu::MemTransferOptimized*>(proc.getMemTransferObj()))
@@ -0,0 +1,511 @@
+/*! -*-c++-*-
+  @file   drishti_python.cpp
+  @author David Hirvonen
+  @brief  Python bindings for batch face and eye inference (NumPy in, structured NumPy out).
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  In process alternative to driving drishti-face and drishti-eye through image and JSON
+  files, e.g.:
+
+    import pydrishti
+    detector = pydrishti.FaceDetector("drishti_factory.json", min_width=64)
+    faces = detector.detect(images)                  # list of HxWx3 RGB arrays or one NxHxWx3 array
+    segmenter = pydrishti.EyeSegmenter("eye.cpb")
+    eyes = segmenter.segment(image, rois=boxes, is_right=flags)
+
+  Images are read in place through the buffer protocol: uint8 RGB with packed pixels and any
+  (positive) row stride, so slices of a larger array are not copied.  The GIL is released
+  during inference, and a batch runs on up to threads workers (<= 0 == all cores).  Results
+  are structured arrays, one record per face (with the index of its image) or per eye crop,
+  in input image coordinates.
+
+*/
+
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/ModelBundle.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FaceDetectorFactoryBundle.h"
+#include "drishti/face/FaceDetectorFactoryJson.h"
+
+#include <drishti/EyeSegmenter.hpp>
+#include <drishti/EyeSegmenterImpl.hpp> // convert()
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace py = pybind11;
+
+using drishti::face::FaceSpecification;
+
+static const int kMaxContour = 128;  // sdk::Eye::ArrayVec2f capacity
+static const int kMaxLandmarks = 68; // FaceSpecification::kibug68
+
+// ### Records ###
+
+struct EllipseRecord
+{
+    float center[2];
+    float size[2];
+    float angle;
+};
+
+struct EyeRecord
+{
+    std::int32_t status; // 0 == success
+    std::int32_t roi[4]; // x, y, width, height
+    float inner[2];
+    float outer[2];
+    EllipseRecord iris;
+    EllipseRecord pupil;
+    std::int32_t eyelidCount;
+    float eyelids[kMaxContour][2];
+    std::int32_t creaseCount;
+    float crease[kMaxContour][2];
+};
+
+struct FaceRecord
+{
+    std::int32_t image; // index in the batch
+    std::int32_t roi[4];
+    std::int32_t landmarkCount;
+    float landmarks[kMaxLandmarks][2];
+    std::int32_t eyeMode; // FaceDetector::EyeMode (-1 == none)
+    EyeRecord eyes[2];    // right, left (status 1 == no model)
+};
+
+static void fill(EllipseRecord& dst, const drishti::sdk::Eye::Ellipse& src)
+{
+    dst = {};
+    dst.center[0] = src.center[0];
+    dst.center[1] = src.center[1];
+    dst.size[0] = src.size.width;
+    dst.size[1] = src.size.height;
+    dst.angle = src.angle;
+}
+
+template <typename Contour>
+static std::int32_t fill(float dst[][2], const Contour& src)
+{
+    const int count = std::min(static_cast<int>(src.size()), kMaxContour);
+    for (int i = 0; i < count; i++)
+    {
+        dst[i][0] = src[i][0];
+        dst[i][1] = src[i][1];
+    }
+    return count;
+}
+
+static void fill(EyeRecord& dst, const drishti::sdk::Eye& eye, int status)
+{
+    dst = {};
+    dst.status = status;
+
+    const auto& roi = eye.getRoi();
+    dst.roi[0] = roi.x;
+    dst.roi[1] = roi.y;
+    dst.roi[2] = roi.width;
+    dst.roi[3] = roi.height;
+    dst.inner[0] = eye.getInnerCorner()[0];
+    dst.inner[1] = eye.getInnerCorner()[1];
+    dst.outer[0] = eye.getOuterCorner()[0];
+    dst.outer[1] = eye.getOuterCorner()[1];
+    fill(dst.iris, eye.getIris());
+    fill(dst.pupil, eye.getPupil());
+    dst.eyelidCount = fill(dst.eyelids, eye.getEyelids());
+    dst.creaseCount = fill(dst.crease, eye.getCrease());
+}
+
+static void fill(FaceRecord& dst, const drishti::face::FaceModel& face, int image)
+{
+    dst = {};
+    dst.image = image;
+
+    if (face.roi.has)
+    {
+        dst.roi[0] = face.roi->x;
+        dst.roi[1] = face.roi->y;
+        dst.roi[2] = face.roi->width;
+        dst.roi[3] = face.roi->height;
+    }
+
+    if (face.points.has)
+    {
+        dst.landmarkCount = std::min(static_cast<int>(face.points->size()), kMaxLandmarks);
+        for (int i = 0; i < dst.landmarkCount; i++)
+        {
+            dst.landmarks[i][0] = (*face.points)[i].x;
+            dst.landmarks[i][1] = (*face.points)[i].y;
+        }
+    }
+
+    dst.eyeMode = face.eyeMode.has ? *face.eyeMode : -1;
+
+    const drishti::core::Field<drishti::eye::EyeModel>* eyes[2] = { &face.eyeFullR, &face.eyeFullL };
+    for (int i = 0; i < 2; i++)
+    {
+        if (eyes[i]->has)
+        {
+            fill(dst.eyes[i], drishti::sdk::convert(eyes[i]->value), 0);
+        }
+        else
+        {
+            fill(dst.eyes[i], drishti::sdk::Eye(), 1);
+        }
+    }
+}
+
+// ### Input ###
+
+// RGB uint8 images viewed in place, the buffer views keep the arrays alive (and must be released
+// with the GIL held, i.e., after inference):
+class Images
+{
+public:
+    explicit Images(const py::object& images)
+    {
+        if (py::isinstance<py::buffer>(images))
+        {
+            add(py::reinterpret_borrow<py::buffer>(images).request(), true);
+        }
+        else
+        {
+            for (const auto& item : images)
+            {
+                if (!py::isinstance<py::buffer>(item))
+                {
+                    throw py::type_error("images: expected an array or a sequence of arrays");
+                }
+                add(py::reinterpret_borrow<py::buffer>(item).request(), false);
+            }
+        }
+    }
+
+    std::size_t size() const { return m_images.size(); }
+    const cv::Mat3b& operator[](std::size_t i) const { return m_images[i]; }
+
+protected:
+    void add(py::buffer_info info, bool isBatch)
+    {
+        const bool is4D = isBatch && (info.ndim == 4);
+        if ((info.format != py::format_descriptor<std::uint8_t>::format()) || ((info.ndim != 3) && !is4D))
+        {
+            throw std::invalid_argument("images: expected uint8 arrays with shape (H, W, 3) or (N, H, W, 3)");
+        }
+
+        const auto d = info.ndim - 3; // first image dimension
+        if ((info.shape[d + 2] != 3) || (info.strides[d + 2] != 1) || (info.strides[d + 1] != 3) || (info.strides[d] < (info.shape[d + 1] * 3)))
+        {
+            throw std::invalid_argument("images: pixels must be packed RGB with a positive row stride");
+        }
+
+        const int rows = static_cast<int>(info.shape[d]), cols = static_cast<int>(info.shape[d + 1]);
+        const auto step = static_cast<std::size_t>(info.strides[d]);
+        const auto count = is4D ? info.shape[0] : 1;
+        for (py::ssize_t i = 0; i < count; i++)
+        {
+            auto* data = static_cast<std::uint8_t*>(info.ptr) + (is4D ? (i * info.strides[0]) : 0);
+            m_images.emplace_back(rows, cols, reinterpret_cast<cv::Vec3b*>(data), step);
+        }
+        m_buffers.push_back(std::move(info));
+    }
+
+    std::vector<py::buffer_info> m_buffers;
+    std::vector<cv::Mat3b> m_images;
+};
+
+// Rethrow the first exception of a parallel loop (after the GIL is reacquired):
+class FirstError
+{
+public:
+    void set(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_error)
+        {
+            m_error = error;
+        }
+    }
+    void check() const
+    {
+        if (m_error)
+        {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+protected:
+    std::mutex m_mutex;
+    std::exception_ptr m_error;
+};
+
+// ### FaceDetector ###
+
+// One detector per worker thread (as in drishti-face), all created from one factory:
+class PyFaceDetector
+{
+public:
+    using FaceDetectorPtr = std::unique_ptr<drishti::face::FaceDetector>;
+    using Faces = std::vector<drishti::face::FaceModel>;
+
+    PyFaceDetector(const std::string& sFactory, int minWidth, bool inner, bool doEyes, bool doIris)
+        : m_minWidth(minWidth)
+        , m_doEyes(doEyes)
+        , m_doIris(doIris)
+        , m_manager([this]() { return create(); })
+    {
+        if (drishti::core::ModelBundle::isBundle(sFactory))
+        {
+            m_factory = std::make_shared<drishti::face::FaceDetectorFactoryBundle>(sFactory);
+        }
+        else
+        {
+            m_factory = std::make_shared<drishti::face::FaceDetectorFactoryJson>(sFactory);
+        }
+        m_factory->inner = inner;
+
+        // Load the models for the calling thread, so configuration errors surface here:
+        m_manager[std::this_thread::get_id()];
+    }
+
+    py::array detect(const py::object& images, int threads)
+    {
+        const Images input(images);
+        std::vector<Faces> faces(input.size());
+        FirstError error;
+        {
+            py::gil_scoped_release release;
+
+            const drishti::core::ParallelHomogeneousLambda harness([&](int i) {
+                try
+                {
+                    detect(*m_manager[std::this_thread::get_id()], input[i], faces[i]);
+                }
+                catch (...)
+                {
+                    error.set(std::current_exception());
+                }
+            });
+
+            if ((threads == 1) || (input.size() < 2))
+            {
+                harness({ 0, static_cast<int>(input.size()) });
+            }
+            else
+            {
+                // Images without faces return early, so claim one image at a time:
+                drishti::core::ParallelSettings settings;
+                settings.threads = threads;
+                settings.grain = 1;
+
+                // Load one detector per worker concurrently, before the first batch:
+                const int workers = (threads > 0) ? threads : static_cast<int>(std::thread::hardware_concurrency());
+                const auto wanted = static_cast<std::size_t>(std::min(static_cast<int>(input.size()), std::max(workers, 1)));
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex); // concurrent calls from python threads
+                    const auto allocated = std::max(m_allocated, m_manager.size());
+                    if (allocated < wanted)
+                    {
+                        m_manager.reserve(wanted - allocated);
+                        m_allocated = wanted;
+                    }
+                }
+                drishti::core::parallelFor({ 0, static_cast<int>(input.size()) }, harness, settings);
+            }
+        }
+        error.check();
+
+        std::size_t count = 0;
+        for (const auto& f : faces)
+        {
+            count += f.size();
+        }
+
+        py::array_t<FaceRecord> result(count);
+        auto* records = result.mutable_data();
+        for (std::size_t i = 0; i < faces.size(); i++)
+        {
+            for (const auto& face : faces[i])
+            {
+                fill(*records++, face, static_cast<int>(i));
+            }
+        }
+        return result;
+    }
+
+    int getMinWidth() const { return m_minWidth; }
+
+protected:
+    FaceDetectorPtr create()
+    {
+        auto detector = drishti::core::make_unique<drishti::face::FaceDetector>(*m_factory);
+        if (!detector->getDetector())
+        {
+            throw std::runtime_error("FaceDetector: unable to load the face detector");
+        }
+        detector->setLandmarkFormat(m_factory->inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);
+        detector->setDoNMS(true);
+        detector->setDoNMSGlobal(true);
+        detector->setDoEyeRefinement(m_doEyes);
+        detector->setDoIrisRefinement(m_doIris);
+        return detector;
+    }
+
+    // Detection at the minimum face width, regression at full resolution (see drishti-face):
+    void detect(drishti::face::FaceDetector& detector, const cv::Mat3b& image, Faces& faces) const
+    {
+        if (image.empty())
+        {
+            return;
+        }
+
+        float Sfd = 1.f; // full to detection
+        cv::Mat reduced = image;
+        if (m_minWidth > 0)
+        {
+            Sfd = static_cast<float>(detector.getWindowSize().width) / static_cast<float>(m_minWidth);
+            cv::resize(image, reduced, {}, Sfd, Sfd, (Sfd < 1.f) ? cv::INTER_AREA : cv::INTER_LINEAR);
+        }
+
+        cv::Mat green;
+        cv::extractChannel(image, green, 1);
+        const drishti::face::FaceDetector::PaddedImage Ib(green, { { 0, 0 }, green.size() });
+
+        cv::Mat It = reduced.t(), Itf;
+        It.convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+        const MatP Ip(Itf);
+
+        const float Sdr = 1.f / Sfd;
+        detector(Ip, Ib, faces, cv::Matx33f::diag({ Sdr, Sdr, 1.f }));
+    }
+
+    int m_minWidth = -1;
+    bool m_doEyes = true;
+    bool m_doIris = true;
+    std::shared_ptr<drishti::face::FaceDetectorFactory> m_factory;
+    std::mutex m_mutex;
+    std::size_t m_allocated = 1; // detectors (see reserve())
+    drishti::core::LazyParallelResource<std::thread::id, FaceDetectorPtr> m_manager;
+};
+
+// ### EyeSegmenter ###
+
+// Crops of images (one image per crop or one image for all crops), see sdk::EyeSegmenter::Crop:
+static py::array segment(drishti::sdk::EyeSegmenter& segmenter, const py::object& images, const py::object& rois, const py::object& isRight, int threads)
+{
+    const Images input(images);
+
+    std::size_t count = input.size();
+    using Boxes = py::array_t<std::int32_t, py::array::c_style | py::array::forcecast>;
+    using Flags = py::array_t<bool, py::array::c_style | py::array::forcecast>;
+
+    const bool hasRois = !rois.is_none(), hasFlags = !isRight.is_none();
+
+    Boxes boxes;
+    if (hasRois)
+    {
+        boxes = Boxes::ensure(rois);
+        if (!boxes || (boxes.ndim() != 2) || (boxes.shape(1) != 4))
+        {
+            throw std::invalid_argument("rois: expected an (N, 4) array of x, y, width, height");
+        }
+        count = static_cast<std::size_t>(boxes.shape(0));
+    }
+    if ((input.size() != count) && (input.size() != 1))
+    {
+        throw std::invalid_argument("images: expected one image or one image per roi");
+    }
+
+    Flags flags;
+    if (hasFlags)
+    {
+        flags = Flags::ensure(isRight);
+        if (!flags || ((flags.size() != static_cast<py::ssize_t>(count)) && (flags.size() != 1)))
+        {
+            throw std::invalid_argument("is_right: expected one flag or one flag per crop");
+        }
+    }
+
+    std::vector<drishti::sdk::EyeSegmenter::Crop> crops(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const auto& image = input[(input.size() == 1) ? 0 : i];
+        crops[i].image = drishti::sdk::Image3b(image.rows, image.cols, reinterpret_cast<drishti::sdk::Vec3b*>(image.data), image.step); // alias
+        if (hasRois)
+        {
+            const auto* roi = boxes.data(i, 0);
+            crops[i].roi = { roi[0], roi[1], roi[2], roi[3] };
+        }
+        if (hasFlags)
+        {
+            crops[i].isRight = flags.data()[(flags.size() == 1) ? 0 : i];
+        }
+    }
+
+    std::vector<drishti::sdk::Eye> eyes;
+    std::vector<int> status;
+    {
+        py::gil_scoped_release release;
+        segmenter(crops, eyes, status, threads);
+    }
+
+    py::array_t<EyeRecord> result(count);
+    auto* records = result.mutable_data();
+    for (std::size_t i = 0; i < count; i++)
+    {
+        fill(records[i], eyes[i], status[i]);
+    }
+    return result;
+}
+
+PYBIND11_MODULE(pydrishti, m)
+{
+    m.doc() = "Batch face and eye inference on NumPy arrays";
+
+    PYBIND11_NUMPY_DTYPE(EllipseRecord, center, size, angle);
+    PYBIND11_NUMPY_DTYPE_EX(EyeRecord, status, "status", roi, "roi", inner, "inner", outer, "outer", iris, "iris", pupil, "pupil", eyelidCount, "eyelid_count", eyelids, "eyelids", creaseCount, "crease_count", crease, "crease");
+    PYBIND11_NUMPY_DTYPE_EX(FaceRecord, image, "image", roi, "roi", landmarkCount, "landmark_count", landmarks, "landmarks", eyeMode, "eye_mode", eyes, "eyes");
+
+    py::class_<PyFaceDetector>(m, "FaceDetector")
+        .def(py::init<const std::string&, int, bool, bool, bool>(), py::arg("factory"), py::arg("min_width") = -1, py::arg("inner") = false, py::arg("eyes") = true, py::arg("iris") = true,
+            "Load the models from a JSON factory file or a model bundle")
+        .def("detect", &PyFaceDetector::detect, py::arg("images"), py::arg("threads") = -1,
+            "Detect faces in RGB uint8 images, returns one record per face (see dtype)")
+        .def_property_readonly("min_width", &PyFaceDetector::getMinWidth)
+        .def_property_readonly_static("dtype", [](py::object) { return py::dtype::of<FaceRecord>(); });
+
+    py::class_<drishti::sdk::EyeSegmenter>(m, "EyeSegmenter")
+        .def(py::init([](const std::string& filename) {
+            auto segmenter = drishti::core::make_unique<drishti::sdk::EyeSegmenter>(filename);
+            if (!segmenter->good())
+            {
+                throw std::runtime_error("EyeSegmenter: unable to load " + filename);
+            }
+            return segmenter;
+        }),
+            py::arg("filename"))
+        .def("segment", &segment, py::arg("images"), py::arg("rois") = py::none(), py::arg("is_right") = py::none(), py::arg("threads") = -1,
+            "Segment eye crops of RGB uint8 images, returns one record per crop (see dtype)")
+        .def_property("eyelid_inits", &drishti::sdk::EyeSegmenter::getEyelidInits, &drishti::sdk::EyeSegmenter::setEyelidInits)
+        .def_property("iris_inits", &drishti::sdk::EyeSegmenter::getIrisInits, &drishti::sdk::EyeSegmenter::setIrisInits)
+        .def_property_readonly("min_width", &drishti::sdk::EyeSegmenter::getMinWidth)
+        .def_property_readonly("aspect_ratio", &drishti::sdk::EyeSegmenter::getRequiredAspectRatio)
+        .def_property_readonly_static("dtype", [](py::object) { return py::dtype::of<EyeRecord>(); });
+}
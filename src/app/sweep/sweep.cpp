@@ -0,0 +1,711 @@
+/*! -*-c++-*-
+  @file   sweep.cpp
+  @author David Hirvonen
+  @brief  Accuracy versus latency sweep of the regression stage hints and eye model inits.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Face landmark and eye model regression are evaluated on a labeled landmark set (see
+  app/landmarks) for every combination of the face, eyelid and iris stage hints and the
+  eyelid and iris inits.  Face shapes are regressed once per image: each stage count
+  continues the cascade from the cached shape of the previous (smaller) count, so the
+  truncations cost no recomputation and their latencies are the cumulative segment times.
+  Eye crops are cut once around the labeled eyes, so face and eye configurations are
+  independent and every combination is scored from the cached results.  Eyelids are
+  scored against the labeled eye points and the (unlabeled) iris against the full cascade.
+  The accuracy and latency Pareto frontier is written as a DeviceProfile table (see
+  hci/DeviceProfile.h), where the regression limits scale the per face budget by the
+  regression speed of the device relative to this one.
+
+  FaceDetector::setInits() and EyeModelEstimator::setOptimizationLevel() have no effect
+  on these models, so they aren't swept.
+
+*/
+
+#include "drishti/core/drishti_stdlib_string.h" // android workaround
+#include "drishti/core/Logger.h"
+#include "drishti/core/Shape.h"
+#include "drishti/core/drishti_string_hash.h"
+#include "drishti/core/padding.h"
+#include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/face/FaceIO.h"
+#include "drishti/ml/ShapeEstimator.h"
+
+#include "landmarks/FACE.h"
+#include "landmarks/MUCT.h"
+#include "landmarks/HELEN.h"
+#include "landmarks/BIOID.h"
+#include "landmarks/LFW.h"
+#include "landmarks/LFPW.h"
+#include "landmarks/DRISHTI.h"
+#include "landmarks/TWO.h"
+
+#include "cxxopts.hpp"
+
+#include <nlohmann/json.hpp> // nlohman-json
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#define SUPPORTED_FORMATS "muct,helen,bioid,lfw,drishti,lfpw,two"
+
+// Eye crops relative to the inter-ocular distance (see FaceModel::getEyeRegions()):
+#define DRISHTI_SWEEP_EYE_CROP_SCALE 0.666f
+
+using HighResolutionClock = std::chrono::high_resolution_clock;
+using PointVec = std::vector<cv::Point2f>;
+
+struct Sample
+{
+    cv::Mat1b gray;
+    cv::Rect roi;                      // face regression roi
+    std::array<cv::Point2f, 5> truth;  // eyeR, eyeL, nose, mouthR, mouthL
+    float iod = 0.f;                   // inter-ocular distance
+
+    std::array<cv::Mat1b, 2> eyes;     // crops at the eye regressor width (right, left)
+    std::array<PointVec, 2> eyePoints; // labeled eye points in crop coordinates
+    std::array<float, 2> eyeIod{ { 0.f, 0.f } };
+};
+
+struct FaceResult
+{
+    int stages = 0;
+    double error = 0.0; // mean landmark error / iod
+    double ms = 0.0;    // per face
+};
+
+struct EyeResult
+{
+    int eyelidStages = 0, eyelidInits = 1, irisStages = 0, irisInits = 1;
+    double eyelidError = 0.0, irisError = 0.0; // per eye / iod
+    double ms = 0.0;                           // both eyes
+};
+
+struct Config
+{
+    const FaceResult* face;
+    const EyeResult* eye;
+
+    double error() const
+    {
+        return face->error + eye->eyelidError + eye->irisError;
+    }
+    double ms() const
+    {
+        return face->ms + eye->ms;
+    }
+};
+
+static double elapsed(const HighResolutionClock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(HighResolutionClock::now() - start).count();
+}
+
+static std::vector<int> parseList(const std::string& text)
+{
+    std::vector<int> values;
+    std::stringstream ss(text);
+    for (std::string token; std::getline(ss, token, ',');)
+    {
+        if (!token.empty())
+        {
+            values.push_back(std::stoi(token));
+        }
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+static cv::Point2f mean(const PointVec& points, const std::vector<int>& indices)
+{
+    cv::Point2f sum;
+    for (const auto& i : indices)
+    {
+        sum += points[i];
+    }
+    return sum * (1.f / static_cast<float>(std::max(indices.size(), std::size_t(1))));
+}
+
+using string_hash::operator"" _hash;
+static FACE::Table parseInput(const std::string& sInput, const std::string& sFormat, const std::string& sDirectoryIn, const std::string& sExtension)
+{
+    FACE::Table table;
+    switch (string_hash::hash(sFormat))
+    {
+        case "two"_hash:
+            table = parseTWO(sInput);
+            break;
+        case "drishti"_hash:
+            table = parseDRISHTI(sInput);
+            break;
+        case "lfw"_hash:
+            table = parseLFW(sInput);
+            break;
+        case "muct"_hash:
+            table = parseMUCT(sInput);
+            break;
+        case "helen"_hash:
+            table = parseHELEN(sInput);
+            break;
+        case "bioid"_hash:
+            table = parseBIOID(sInput);
+            break;
+        case "lfpw"_hash:
+            table = parseLFPW(sInput);
+            break;
+        default:
+            throw std::runtime_error("Unsupported format " + sFormat + " (" SUPPORTED_FORMATS ")");
+    }
+
+    std::string sDirectory = sDirectoryIn;
+    if (!sDirectory.empty() && (sDirectory.back() != '/'))
+    {
+        sDirectory += "/";
+    }
+    for (auto& l : table.lines)
+    {
+        l.filename = sDirectory + l.filename + (sExtension.empty() ? "" : ("." + sExtension));
+        std::replace(begin(l.filename), end(l.filename), '\\', '/');
+    }
+    return table;
+}
+
+// Face crop from the labeled landmarks (or the record roi), eye crops around the labeled eyes:
+static bool load(const FACE::Table& table, const FACE::record& record, float padding, int eyeWidth, Sample& sample)
+{
+    if (record.points.empty())
+    {
+        return false;
+    }
+    sample.gray = cv::imread(record.filename, cv::IMREAD_GRAYSCALE);
+    if (sample.gray.empty())
+    {
+        return false;
+    }
+
+    const auto& p = record.points;
+    sample.truth = { { mean(p, table.eyeR), mean(p, table.eyeL), mean(p, table.nose), mean(p, table.mouthR), mean(p, table.mouthL) } };
+    sample.iod = static_cast<float>(cv::norm(sample.truth[0] - sample.truth[1]));
+    if (sample.iod <= 0.f)
+    {
+        return false;
+    }
+
+    if (record.roi.area())
+    {
+        sample.roi = record.roi;
+    }
+    else
+    {
+        const cv::Rect2f box = cv::boundingRect(p);
+        const float width = std::max(box.width, box.height) * (1.f + 2.f * padding);
+        const cv::Point2f center(box.x + box.width * 0.5f, box.y + box.height * 0.5f);
+        sample.roi = cv::Rect(cv::Point(center - cv::Point2f(width, width) * 0.5f), cv::Size(width, width));
+    }
+
+    const std::array<const std::vector<int>*, 2> indices{ { &table.eyeR, &table.eyeL } };
+    const cv::Point2f diag = cv::Point2f(1.f, 3.f / 4.f) * sample.iod * DRISHTI_SWEEP_EYE_CROP_SCALE * 0.5f;
+    for (int i = 0; i < 2; i++)
+    {
+        const cv::Rect roi(cv::Point(sample.truth[i] - diag), cv::Point(sample.truth[i] + diag));
+
+        cv::Mat crop;
+        drishti::core::cropWithPadding(sample.gray, roi, crop, drishti::core::kPadConstant);
+
+        const float scale = (crop.cols > eyeWidth) ? static_cast<float>(eyeWidth) / static_cast<float>(crop.cols) : 1.f;
+        if (scale != 1.f)
+        {
+            cv::resize(crop, crop, {}, scale, scale, cv::INTER_AREA);
+        }
+        sample.eyes[i] = crop;
+        sample.eyeIod[i] = sample.iod * scale;
+        for (const auto& j : *indices[i])
+        {
+            sample.eyePoints[i].push_back((p[j] - cv::Point2f(roi.tl())) * scale);
+        }
+    }
+
+    return true;
+}
+
+// Smallest stage count that matches the full cascade (larger hints are the same model):
+static int getStageCount(drishti::ml::ShapeEstimator& estimator, const Sample& sample)
+{
+    const std::vector<drishti::ml::ShapeEstimator::BatchItem> items{ { sample.gray, sample.roi, {} } };
+
+    std::vector<PointVec> full, shapes;
+    estimator.estimateBatch(items, full);
+
+    drishti::ml::ShapeEstimator::Options options;
+    for (options.stages = 1; options.stages < 256; options.stages++)
+    {
+        estimator.estimateBatch(items, shapes, options);
+        if (shapes == full)
+        {
+            break;
+        }
+    }
+    return options.stages;
+}
+
+static double getFaceError(const Sample& sample, const PointVec& shape, drishti::face::FaceSpecification::Format format, const std::vector<int>& landmarks)
+{
+    drishti::core::Shape points(sample.roi, shape);
+    const auto face = drishti::face::shapeToFace(points, format, landmarks); // subset models score the points they regress
+
+    const std::array<drishti::core::Field<cv::Point2f>, 5> estimate{ { face.getEyeRightCenter(), face.getEyeLeftCenter(), face.noseTip, face.mouthCornerRight, face.mouthCornerLeft } };
+
+    double error = 0.0;
+    int count = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        if (estimate[i].has)
+        {
+            error += cv::norm(*estimate[i] - sample.truth[i]);
+            count++;
+        }
+    }
+    return count ? (error / (count * sample.iod)) : 1.0;
+}
+
+// Eyelid centroid and corners (either order) against the labeled eye points:
+static double getEyelidError(const drishti::eye::EyeModel& eye, const PointVec& truth, float iod)
+{
+    if (eye.eyelids.empty() || truth.size() < 2)
+    {
+        return 1.0;
+    }
+
+    std::pair<cv::Point2f, cv::Point2f> corners;
+    double width = -1.0;
+    for (const auto& a : truth)
+    {
+        for (const auto& b : truth)
+        {
+            if (cv::norm(a - b) > width)
+            {
+                width = cv::norm(a - b);
+                corners = { a, b };
+            }
+        }
+    }
+
+    const auto& outer = eye.getOuterCorner();
+    const auto& inner = eye.getInnerCorner();
+    const double cornerError = std::min(
+        cv::norm(outer - corners.first) + cv::norm(inner - corners.second),
+        cv::norm(outer - corners.second) + cv::norm(inner - corners.first));
+    const double centerError = cv::norm(drishti::core::centroid(eye.eyelids) - drishti::core::centroid(truth));
+    return (cornerError * 0.5 + centerError) * 0.5 / iod;
+}
+
+static std::vector<FaceResult> sweepFace(drishti::ml::ShapeEstimator& estimator, const std::vector<Sample>& samples, const std::vector<int>& stages, int repeat, drishti::face::FaceSpecification::Format format)
+{
+    using drishti::ml::ShapeEstimator;
+
+    std::vector<FaceResult> results(stages.size());
+    for (std::size_t i = 0; i < stages.size(); i++)
+    {
+        results[i].stages = stages[i];
+    }
+
+    // PCA models re-project the cached shape, so continuations wouldn't be exact:
+    const bool doContinue = !estimator.isPCA();
+    const auto landmarks = estimator.getLandmarks();
+
+    for (const auto& sample : samples)
+    {
+        PointVec init; // normalized by the roi size (see ShapeEstimator::BatchItem)
+        double total = 0.0;
+        for (std::size_t i = 0; i < stages.size(); i++)
+        {
+            ShapeEstimator::Options options;
+            options.first = (doContinue && i) ? stages[i - 1] : 0;
+            options.stages = stages[i];
+            options.convergenceEpsilon = 0.f;
+
+            const std::vector<ShapeEstimator::BatchItem> items{ { sample.gray, sample.roi, doContinue ? init : PointVec() } };
+
+            std::vector<PointVec> shapes;
+            double best = std::numeric_limits<double>::max();
+            for (int j = 0; j < repeat; j++)
+            {
+                const auto start = HighResolutionClock::now();
+                estimator.estimateBatch(items, shapes, options);
+                best = std::min(best, elapsed(start));
+            }
+            total = doContinue ? (total + best) : best;
+
+            PointVec shape = shapes.front();
+            init = shape;
+            for (auto& p : init)
+            {
+                p.x /= static_cast<float>(sample.roi.width);
+                p.y /= static_cast<float>(sample.roi.height);
+            }
+            for (auto& p : shape)
+            {
+                p += cv::Point2f(sample.roi.tl());
+            }
+
+            results[i].error += getFaceError(sample, shape, format, landmarks);
+            results[i].ms += total;
+        }
+    }
+
+    for (auto& result : results)
+    {
+        result.error /= static_cast<double>(samples.size());
+        result.ms /= static_cast<double>(samples.size());
+    }
+    return results;
+}
+
+static void runEyes(const drishti::eye::EyeModelEstimator& estimator, const Sample& sample, const EyeResult& config, int repeat, std::array<drishti::eye::EyeModel, 2>& eyes, double& ms)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        auto options = estimator.getOptions();
+        options.eyelidStages = config.eyelidStages;
+        options.eyelidInits = config.eyelidInits;
+        options.irisStages = config.irisStages;
+        options.irisInits = config.irisInits;
+        options.mirrored = (i == 1); // the left eye is sampled in place, in right eye cs
+
+        double best = std::numeric_limits<double>::max();
+        for (int j = 0; j < repeat; j++)
+        {
+            const auto start = HighResolutionClock::now();
+            estimator(sample.eyes[i], eyes[i], options);
+            best = std::min(best, elapsed(start));
+        }
+        ms += best;
+    }
+}
+
+static std::vector<EyeResult> sweepEyes(const drishti::eye::EyeModelEstimator& estimator, const std::vector<Sample>& samples, const std::vector<EyeResult>& configs, int repeat)
+{
+    // Iris reference: the most expensive configuration
+    EyeResult reference = configs.back();
+    for (const auto& config : configs)
+    {
+        reference.eyelidStages = std::max(reference.eyelidStages, config.eyelidStages);
+        reference.eyelidInits = std::max(reference.eyelidInits, config.eyelidInits);
+        reference.irisStages = std::max(reference.irisStages, config.irisStages);
+        reference.irisInits = std::max(reference.irisInits, config.irisInits);
+    }
+
+    std::vector<std::array<cv::Point2f, 2>> irises(samples.size());
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        std::array<drishti::eye::EyeModel, 2> eyes;
+        double ms = 0.0;
+        runEyes(estimator, samples[i], reference, 1, eyes, ms);
+        irises[i] = { { eyes[0].irisEllipse.center, eyes[1].irisEllipse.center } };
+    }
+
+    std::vector<EyeResult> results = configs;
+    for (auto& result : results)
+    {
+        for (std::size_t i = 0; i < samples.size(); i++)
+        {
+            std::array<drishti::eye::EyeModel, 2> eyes;
+            runEyes(estimator, samples[i], result, repeat, eyes, result.ms);
+            for (int j = 0; j < 2; j++)
+            {
+                result.eyelidError += getEyelidError(eyes[j], samples[i].eyePoints[j], samples[i].eyeIod[j]) * 0.5;
+                result.irisError += cv::norm(eyes[j].irisEllipse.center - irises[i][j]) * 0.5 / samples[i].eyeIod[j];
+            }
+        }
+        result.eyelidError /= static_cast<double>(samples.size());
+        result.irisError /= static_cast<double>(samples.size());
+        result.ms /= static_cast<double>(samples.size());
+    }
+    return results;
+}
+
+// One full face regression, timed as in DeviceProfile::measure():
+static double getRegressionTime(drishti::ml::ShapeEstimator& estimator, int repeat)
+{
+    cv::Mat1b crop(128, 128);
+    cv::randu(crop, 0, 255);
+
+    PointVec points;
+    drishti::ml::ShapeEstimator::BoolVec mask;
+    estimator(crop, points, mask);
+
+    std::vector<double> times;
+    for (int i = 0; i < std::max(repeat, 8); i++)
+    {
+        const auto start = HighResolutionClock::now();
+        estimator(crop, points, mask);
+        times.push_back(elapsed(start));
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+// Non-dominated configurations, from the most accurate (and slowest) to the fastest:
+static std::vector<Config> getFrontier(std::vector<Config> configs)
+{
+    std::sort(configs.begin(), configs.end(), [](const Config& a, const Config& b) {
+        return (a.ms() < b.ms()) || ((a.ms() == b.ms()) && (a.error() < b.error()));
+    });
+
+    std::vector<Config> frontier;
+    for (const auto& config : configs)
+    {
+        if (frontier.empty() || (config.error() < frontier.back().error()))
+        {
+            frontier.push_back(config);
+        }
+    }
+    std::reverse(frontier.begin(), frontier.end());
+    return frontier;
+}
+
+static nlohmann::json write(const Config& config)
+{
+    return {
+        { "face_stages", config.face->stages },
+        { "eyelid_stages", config.eye->eyelidStages },
+        { "eyelid_inits", config.eye->eyelidInits },
+        { "iris_stages", config.eye->irisStages },
+        { "iris_inits", config.eye->irisInits },
+        { "face_error", config.face->error },
+        { "eyelid_error", config.eye->eyelidError },
+        { "iris_error", config.eye->irisError },
+        { "error", config.error() },
+        { "ms", config.ms() }
+    };
+}
+
+int gauze_main(int argc, char** argv)
+{
+    const auto argumentCount = argc;
+
+    auto logger = drishti::core::Logger::create("drishti-sweep");
+
+    std::string sInput, sFormat, sDirectory, sExtension, sOutput;
+    std::string sFaceRegressor, sEyeRegressor, sDevice;
+    std::string sFaceStages = "2,4,6,8,10,12,14,16,20";
+    std::string sEyelidStages = "2,4,6,8,12,16";
+    std::string sIrisStages = "2,4,8,16";
+    std::string sEyelidInits = "1,3";
+    std::string sIrisInits = "1,3";
+    float padding = 0.25f;
+    int number = 0;
+    int repeat = 3;
+    double budget = 0.0;
+
+    cxxopts::Options options("drishti-sweep", "Accuracy versus latency sweep of the regression stage hints and inits");
+
+    // clang-format off
+    options.add_options()
+        ("i,input", "Labeled landmark file", cxxopts::value<std::string>(sInput))
+        ("f,format", "Format:" SUPPORTED_FORMATS, cxxopts::value<std::string>(sFormat))
+        ("d,directory", "Base (d)irectory", cxxopts::value<std::string>(sDirectory))
+        ("e,extension", "Image filename extensions", cxxopts::value<std::string>(sExtension))
+        ("n,number", "Number of images (0 == all)", cxxopts::value<int>(number))
+        ("r,regressor", "Face landmark regressor", cxxopts::value<std::string>(sFaceRegressor))
+        ("y,eye", "Eye model regressor", cxxopts::value<std::string>(sEyeRegressor))
+        ("padding", "Face crop padding (fraction of the landmark extent) without a record roi", cxxopts::value<float>(padding))
+        ("face-stages", "Face stage hints", cxxopts::value<std::string>(sFaceStages))
+        ("eyelid-stages", "Eyelid stage hints", cxxopts::value<std::string>(sEyelidStages))
+        ("iris-stages", "Iris stage hints", cxxopts::value<std::string>(sIrisStages))
+        ("eyelid-inits", "Eyelid inits", cxxopts::value<std::string>(sEyelidInits))
+        ("iris-inits", "Iris inits", cxxopts::value<std::string>(sIrisInits))
+        ("repeat", "Timed runs per measurement (fastest is kept)", cxxopts::value<int>(repeat))
+        ("budget", "Regression budget per face in ms on this device (0 == slowest frontier config)", cxxopts::value<double>(budget))
+        ("device", "Device name in the profile", cxxopts::value<std::string>(sDevice))
+        ("o,output", "Output JSON profile", cxxopts::value<std::string>(sOutput))
+        ("h,help", "Print help message");
+    // clang-format on
+
+    auto parseResult = options.parse(argc, argv);
+
+    if ((argumentCount <= 1) || parseResult.count("help"))
+    {
+        logger->info(options.help({ "" }));
+        return 0;
+    }
+
+    if (sInput.empty() || sFormat.empty() || sFaceRegressor.empty() || sEyeRegressor.empty() || sOutput.empty())
+    {
+        logger->error("Must specify a labeled input, a format, face and eye regressors and an output");
+        return 1;
+    }
+
+    repeat = std::max(repeat, 1);
+
+    drishti::face::FaceDetectorFactory factory("", sFaceRegressor, sEyeRegressor, "");
+    auto faceEstimator = factory.getFaceEstimator();
+    auto eyeEstimator = factory.getEyeEstimator();
+    if (!faceEstimator || !eyeEstimator || !eyeEstimator->good())
+    {
+        logger->error("Failed to load the regressors");
+        return 1;
+    }
+    using drishti::face::FaceSpecification;
+    const auto format = factory.isInner(*faceEstimator) ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68;
+
+    const auto table = parseInput(sInput, sFormat, sDirectory, sExtension);
+    if (table.eyeR.empty() || table.eyeL.empty() || table.nose.empty() || table.mouthR.empty() || table.mouthL.empty())
+    {
+        logger->error("The {} format doesn't label the eyes, nose and mouth", sFormat);
+        return 1;
+    }
+
+    // Images, crops and labels are loaded once for all configurations:
+    std::vector<Sample> samples;
+    const int eyeWidth = eyeEstimator->getOptions().targetWidth;
+    for (const auto& record : table.lines)
+    {
+        if ((number > 0) && (static_cast<int>(samples.size()) >= number))
+        {
+            break;
+        }
+        Sample sample;
+        if (load(table, record, padding, eyeWidth, sample))
+        {
+            samples.push_back(std::move(sample));
+        }
+        else
+        {
+            logger->warn("Skipping {}", record.filename);
+        }
+    }
+    if (samples.empty())
+    {
+        logger->error("No labeled images");
+        return 1;
+    }
+
+    // Stage hints past the model length repeat the full cascade:
+    const int faceStageCount = getStageCount(*faceEstimator, samples.front());
+    std::vector<int> faceStages;
+    for (const auto& stages : parseList(sFaceStages))
+    {
+        faceStages.push_back(std::min(std::max(stages, 1), faceStageCount));
+    }
+    faceStages.erase(std::unique(faceStages.begin(), faceStages.end()), faceStages.end());
+
+    std::vector<EyeResult> eyeConfigs;
+    for (const auto& eyelidStages : parseList(sEyelidStages))
+    {
+        for (const auto& eyelidInits : parseList(sEyelidInits))
+        {
+            for (const auto& irisStages : parseList(sIrisStages))
+            {
+                for (const auto& irisInits : parseList(sIrisInits))
+                {
+                    EyeResult config;
+                    config.eyelidStages = eyelidStages;
+                    config.eyelidInits = std::max(eyelidInits, 1);
+                    config.irisStages = irisStages;
+                    config.irisInits = std::max(irisInits, 1);
+                    eyeConfigs.push_back(config);
+                }
+            }
+        }
+    }
+    if (faceStages.empty() || eyeConfigs.empty())
+    {
+        logger->error("Empty sweep");
+        return 1;
+    }
+
+    logger->info("Sweeping {} face and {} eye configurations over {} images ({} face stages)", faceStages.size(), eyeConfigs.size(), samples.size(), faceStageCount);
+
+    const auto faceResults = sweepFace(*faceEstimator, samples, faceStages, repeat, format);
+    for (const auto& result : faceResults)
+    {
+        logger->info("face stages {}: error {} {} ms", result.stages, result.error, result.ms);
+    }
+
+    const auto eyeResults = sweepEyes(*eyeEstimator, samples, eyeConfigs, repeat);
+    for (const auto& result : eyeResults)
+    {
+        logger->info("eyelid stages {} inits {} iris stages {} inits {}: errors {} {} {} ms", result.eyelidStages, result.eyelidInits, result.irisStages, result.irisInits, result.eyelidError, result.irisError, result.ms);
+    }
+
+    std::vector<Config> configs;
+    for (const auto& face : faceResults)
+    {
+        for (const auto& eye : eyeResults)
+        {
+            configs.push_back({ &face, &eye });
+        }
+    }
+    const auto frontier = getFrontier(configs);
+
+    // Device regression limits: a device whose full face regression takes r ms runs a config
+    // measured at ms here in about ms * r / full, which fits the budget while r <= full * budget / ms:
+    const double full = getRegressionTime(*faceEstimator, repeat);
+    budget = (budget > 0.0) ? budget : frontier.front().ms();
+
+    nlohmann::json json;
+    json["device"] = sDevice;
+    json["images"] = samples.size();
+    json["face_stage_count"] = faceStageCount;
+    json["budget"] = budget;
+    json["regression"] = full;
+    for (const auto& config : configs)
+    {
+        json["configs"].push_back(write(config));
+    }
+    for (std::size_t i = 0; i < frontier.size(); i++)
+    {
+        const auto& config = frontier[i];
+        json["frontier"].push_back(write(config));
+
+        nlohmann::json row = {
+            { "name", "sweep-" + std::to_string(i) },
+            { "face_stages", config.face->stages },
+            { "eyelid_stages", config.eye->eyelidStages },
+            { "eyelid_inits", config.eye->eyelidInits },
+            { "iris_stages", config.eye->irisStages },
+            { "iris_inits", config.eye->irisInits }
+        };
+        if ((i + 1) < frontier.size()) // the last row is the fallback
+        {
+            row["limits"] = { { "regression", full * budget / config.ms() } };
+        }
+        json["profiles"].push_back(row);
+
+        logger->info("frontier {}: face {} eyelid {}x{} iris {}x{}: error {} {} ms", i, config.face->stages, config.eye->eyelidStages, config.eye->eyelidInits, config.eye->irisStages, config.eye->irisInits, config.error(), config.ms());
+    }
+
+    std::ofstream ofs(sOutput);
+    if (!ofs)
+    {
+        logger->error("Failed to open {}", sOutput);
+        return 1;
+    }
+    ofs << json.dump(2) << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return gauze_main(argc, argv);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -42,6 +42,7 @@ struct VideoSourceApple::Impl
         
     }
 
+    // Deferred to the first frame so that the decoder output format can follow setOutputFormat():
     void init()
     {
         NSString *path = [NSString stringWithUTF8String:filename.c_str()];
@@ -54,7 +55,33 @@ struct VideoSourceApple::Impl
         }
     
         AVURLAsset *videoAsset = [AVURLAsset assetWithURL:url];
-        sampleAccessor = [[MIMovieVideoSampleAccessor alloc] initWithMovie:videoAsset firstSampleTime:kCMTimeZero];
+
+        NSDictionary *videoSettings = nil; // default: 32ARGB
+        if (m_format == VideoSourceCV::NV12)
+        {
+            // Native (hardware) decoder output, no color conversion:
+            videoSettings = @{ (id)kCVPixelBufferPixelFormatTypeKey : @(kCVPixelFormatType_420YpCbCr8BiPlanarFullRange) };
+        }
+
+        sampleAccessor = [[MIMovieVideoSampleAccessor alloc] initWithMovie:videoAsset
+                                                           firstSampleTime:kCMTimeZero
+                                                                    tracks:nil
+                                                             videoSettings:videoSettings
+                                                          videoComposition:nil];
+    }
+
+    cv::Mat getNv12(CVImageBufferRef pixelBuffer)
+    {
+        int cols = CVPixelBufferGetWidth(pixelBuffer);
+        int rows = CVPixelBufferGetHeight(pixelBuffer);
+        cv::Mat nv12(rows * 3 / 2, cols, CV_8UC1);
+
+        unsigned char *luma = (unsigned char *)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 0);
+        unsigned char *chroma = (unsigned char *)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 1);
+        cv::Mat(rows, cols, CV_8UC1, luma, CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 0)).copyTo(nv12.rowRange(0, rows));
+        cv::Mat(rows / 2, cols, CV_8UC1, chroma, CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 1)).copyTo(nv12.rowRange(rows, nv12.rows));
+
+        return nv12;
     }
 
     cv::Mat getFrame(CMSampleBufferRef buffer)
@@ -63,6 +90,13 @@ struct VideoSourceApple::Impl
         
         // Begin processing:
         CVPixelBufferLockBaseAddress(pixelBuffer, 0);
+
+        if (m_format == VideoSourceCV::NV12)
+        {
+            cv::Mat nv12 = getNv12(pixelBuffer);
+            CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+            return nv12;
+        }
         
         //int format = CVPixelBufferGetPixelFormatType(pixelBuffer);
         
@@ -78,7 +112,7 @@ struct VideoSourceApple::Impl
             case VideoSourceCV::ANY:
             case VideoSourceCV::ARGB:
             {
-                image = argb;
+                image = argb.clone(); // the pixel buffer is released with the sample
                 break;
             }
             case VideoSourceCV::BGR:
@@ -101,11 +135,16 @@ struct VideoSourceApple::Impl
     
     cv::Mat operator()(int i)
     {
+        if (!sampleAccessor)
+        {
+            init();
+        }
+
         cv::Mat image;
         if(MICMSampleBuffer *sample = [sampleAccessor nextSampleBuffer])
         {
             CMSampleBufferRef buffer = [sample CMSampleBuffer];
-            image = getFrame(buffer).clone(); // TODO: support void(cv::Mat) delegate
+            image = getFrame(buffer); // frames own their pixels
             CMSampleBufferInvalidate(buffer);
             CFRelease(buffer);
             buffer = NULL;
@@ -119,14 +158,13 @@ struct VideoSourceApple::Impl
     
     cv::Mat m_frame; // assume sequential access
     VideoSourceCV::PixelFormat m_format = VideoSourceCV::ANY;
-    MIMovieVideoSampleAccessor *sampleAccessor;
+    MIMovieVideoSampleAccessor *sampleAccessor = nil;
     std::string filename;
 };
 
 VideoSourceApple::VideoSourceApple(const std::string &filename)
 {
     m_impl = drishti::core::make_unique<Impl>(filename);
-    m_impl->init();
 }
 
 VideoSourceApple::~VideoSourceApple()
@@ -21,6 +21,7 @@
 // clang-format on
 
 #include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
 
 #include <boost/filesystem.hpp>
 
@@ -71,8 +72,16 @@ public:
     {
         cv::Mat frame;
         video >> frame;
+        if ((format == NV12) && !frame.empty())
+        {
+            frame = toNv12(frame);
+        }
         return { frame, static_cast<std::size_t>(i) };
     }
+    void setOutputFormat(PixelFormat value) override
+    {
+        format = value;
+    }
     std::size_t count() const override
     {
         return static_cast<int>(video.get(cv::CAP_PROP_FRAME_COUNT));
@@ -82,7 +91,26 @@ public:
         return false;
     }
 protected:
+
+    // cv::VideoCapture decodes to BGR, so NV12 is a CPU conversion here:
+    static cv::Mat toNv12(const cv::Mat& bgr)
+    {
+        const cv::Size size(bgr.cols & ~1, bgr.rows & ~1), half(size.width / 2, size.height / 2);
+
+        cv::Mat i420, nv12(size.height * 3 / 2, size.width, CV_8UC1);
+        cv::cvtColor(bgr(cv::Rect({ 0, 0 }, size)), i420, cv::COLOR_BGR2YUV_I420);
+        i420.rowRange(0, size.height).copyTo(nv12.rowRange(0, size.height));
+
+        cv::Mat u(half, CV_8UC1, i420.ptr(size.height));
+        cv::Mat v(half, CV_8UC1, i420.ptr(size.height) + half.area());
+        cv::Mat uv(half, CV_8UC2, nv12.ptr(size.height));
+        cv::merge(std::vector<cv::Mat>{ u, v }, uv);
+
+        return nv12;
+    }
+
     cv::VideoCapture video;
+    PixelFormat format = ANY;
 };
 
 
@@ -60,6 +60,7 @@ public:
         RGB,
         BGR,
         ANY,
+        NV12, // Y plane followed by interleaved CbCr: (rows * 3/2) x cols CV_8UC1
     };
 
     VideoSourceCV() = default;
@@ -76,6 +77,9 @@ public:
     virtual bool isRandomAccess() const = 0;
     virtual void setOutputFormat(PixelFormat) {}
 
+    // Decode at 1/n resolution (n = 1, 2, 4 or 8) where the source supports it:
+    virtual void setReduction(int) {}
+
     static std::shared_ptr<VideoSourceCV> create(const std::string& filename);
     static std::shared_ptr<VideoSourceCV> createCV(const std::string& filename, const cv::Size &size);
 };
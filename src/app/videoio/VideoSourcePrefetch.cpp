@@ -0,0 +1,217 @@
+/*! -*-c++-*-
+ @file   videoio/VideoSourcePrefetch.cpp
+ @author David Hirvonen
+ @brief  Implementation of a prefetching (look-ahead) VideoSource decorator.
+ 
+ \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+ 
+ */
+
+#include "videoio/VideoSourcePrefetch.h"
+
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+class VideoSourcePrefetch::Impl
+{
+public:
+    Impl(std::shared_ptr<VideoSourceCV> source, int depth, int threads)
+        : m_source(std::move(source))
+        , m_depth(std::max(depth, 1))
+        , m_threads(m_source->isRandomAccess() ? std::max(threads, 1) : 1)
+    {
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_todoCv.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    Impl(const Impl&) = delete;
+    Impl(Impl&&) = delete;
+    Impl& operator=(const Impl&) = delete;
+    Impl& operator=(Impl&&) = delete;
+
+    VideoSourceCV::Frame operator()(int i)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_workers.empty())
+        {
+            for (int j = 0; j < m_threads; j++)
+            {
+                m_workers.emplace_back(&Impl::work, this);
+            }
+        }
+
+        const std::size_t index = (i < 0) ? m_next : static_cast<std::size_t>(i);
+        const std::size_t count = m_source->count();
+        if ((index >= count) || (!m_source->isRandomAccess() && (index < m_next)))
+        {
+            return {}; // sequential sources can't rewind
+        }
+
+        schedule(index, std::min(index + m_depth, count));
+
+        m_readyCv.wait(lock, [&]() { return m_ready.find(index) != m_ready.end(); });
+        auto frame = std::move(m_ready[index]);
+        m_ready.erase(index);
+        m_next = index + 1;
+
+        // Keep the queue full while the caller works on this frame:
+        schedule(m_next, std::min(m_next + m_depth, count));
+
+        return frame;
+    }
+
+    // Queue [begin, end) and drop frames the caller skipped (lock held):
+    void schedule(std::size_t begin, std::size_t end)
+    {
+        const bool isRandomAccess = m_source->isRandomAccess();
+
+        // Random access sources also drop anything beyond the window (e.g., after a jump back):
+        auto outside = [&](std::size_t j) { return (j < begin) || (isRandomAccess && (j >= end)); };
+        for (auto iter = m_ready.begin(); iter != m_ready.end();)
+        {
+            iter = outside(iter->first) ? m_ready.erase(iter) : std::next(iter);
+        }
+
+        if (isRandomAccess)
+        {
+            for (auto j : m_todo)
+            {
+                if (outside(j))
+                {
+                    m_pending.erase(j);
+                }
+            }
+            m_todo.erase(std::remove_if(m_todo.begin(), m_todo.end(), outside), m_todo.end());
+
+            for (std::size_t j = begin; j < end; j++)
+            {
+                if (!m_pending.count(j) && !m_ready.count(j))
+                {
+                    m_pending.insert(j);
+                    m_todo.push_back(j);
+                }
+            }
+        }
+        else
+        {
+            // Sequential sources can't seek, so every frame up to end is read in order:
+            for (std::size_t j = m_queued; j < end; j++)
+            {
+                m_pending.insert(j);
+                m_todo.push_back(j);
+            }
+            m_queued = std::max(m_queued, end);
+        }
+
+        m_todoCv.notify_all();
+    }
+
+    void work()
+    {
+        while (true)
+        {
+            std::size_t index = 0;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_todoCv.wait(lock, [&]() { return m_stop || !m_todo.empty(); });
+                if (m_stop)
+                {
+                    return;
+                }
+                index = m_todo.front();
+                m_todo.pop_front();
+            }
+
+            auto frame = (*m_source)(static_cast<int>(index));
+            frame.index = index;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_pending.erase(index))
+                {
+                    m_ready[index] = std::move(frame);
+                }
+            }
+            m_readyCv.notify_all();
+        }
+    }
+
+    std::shared_ptr<VideoSourceCV> m_source;
+    std::size_t m_depth = 8;
+    int m_threads = 1;
+
+    std::mutex m_mutex;
+    std::condition_variable m_todoCv;
+    std::condition_variable m_readyCv;
+    std::deque<std::size_t> m_todo;              // queued indices
+    std::set<std::size_t> m_pending;             // queued or decoding
+    std::map<std::size_t, VideoSourceCV::Frame> m_ready; // decoded
+    std::size_t m_next = 0;                      // index for operator()(-1)
+    std::size_t m_queued = 0;                    // sequential read position
+    bool m_stop = false;
+
+    std::vector<std::thread> m_workers;
+};
+
+VideoSourcePrefetch::VideoSourcePrefetch(std::shared_ptr<VideoSourceCV> source, int depth, int threads)
+{
+    m_impl = drishti::core::make_unique<Impl>(std::move(source), depth, threads);
+}
+
+VideoSourcePrefetch::~VideoSourcePrefetch() = default;
+
+VideoSourceCV::Frame VideoSourcePrefetch::operator()(int i)
+{
+    return (*m_impl)(i);
+}
+
+bool VideoSourcePrefetch::good() const
+{
+    return m_impl->m_source->good();
+}
+
+std::size_t VideoSourcePrefetch::count() const
+{
+    return m_impl->m_source->count();
+}
+
+bool VideoSourcePrefetch::isRandomAccess() const
+{
+    return m_impl->m_source->isRandomAccess();
+}
+
+void VideoSourcePrefetch::setOutputFormat(PixelFormat value)
+{
+    m_impl->m_source->setOutputFormat(value);
+}
+
+void VideoSourcePrefetch::setReduction(int value)
+{
+    m_impl->m_source->setReduction(value);
+}
+
+DRISHTI_VIDEOIO_NAMESPACE_END
@@ -0,0 +1,54 @@
+/*! -*-c++-*-
+ @file   videoio/VideoSourcePrefetch.h
+ @author David Hirvonen
+ @brief  Declaration of a prefetching (look-ahead) VideoSource decorator.
+ 
+ \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+ \license{This project is released under the 3 Clause BSD License.}
+
+ Frames [i, i + depth) are decoded in the background on each request for frame i.
+ Random access sources (image lists) are decoded on several threads and must support
+ concurrent reads, sequential sources (video) are read ahead in order on one thread.
+ Frames are expected to be requested with increasing indices, a jump simply discards
+ the current window.
+ 
+ */
+
+#ifndef __videoio_VideoSourcePrefetch_h__
+#define __videoio_VideoSourcePrefetch_h__
+
+#include "videoio/VideoSourceCV.h"
+#include "videoio/drishti_videoio.h"
+
+#include <memory>
+
+DRISHTI_VIDEOIO_NAMESPACE_BEGIN
+
+class VideoSourcePrefetch : public VideoSourceCV
+{
+public:
+    class Impl;
+
+    VideoSourcePrefetch(std::shared_ptr<VideoSourceCV> source, int depth = 8, int threads = 4);
+    ~VideoSourcePrefetch();
+
+    VideoSourcePrefetch(const VideoSourcePrefetch&) = delete;
+    VideoSourcePrefetch(VideoSourcePrefetch&&) = delete;
+    VideoSourcePrefetch& operator=(const VideoSourcePrefetch&) = delete;
+    VideoSourcePrefetch& operator=(VideoSourcePrefetch&&) = delete;
+
+    // Configure the source before the first frame is requested:
+    Frame operator()(int i = -1) override;
+    bool good() const override;
+    std::size_t count() const override;
+    bool isRandomAccess() const override;
+    void setOutputFormat(PixelFormat value) override;
+    void setReduction(int value) override;
+
+protected:
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_VIDEOIO_NAMESPACE_END
+
+#endif // __videoio_VideoSourcePrefetch_h__
@@ -16,21 +16,84 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
+
+#include <fstream>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 DRISHTI_VIDEOIO_NAMESPACE_BEGIN
 
+// Images are decoded into recycled buffers: a slot is free once the pool holds
+// the only reference to its pixels (i.e., the frame was released by the caller).
+class MatPool
+{
+public:
+    explicit MatPool(std::size_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    // Returns a free buffer (possibly empty) and its slot (-1 if the pool is exhausted):
+    cv::Mat acquire(int& slot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::size_t i = 0; i < m_buffers.size(); i++)
+        {
+            if (!m_busy[i] && isFree(m_buffers[i]))
+            {
+                m_busy[i] = true;
+                slot = static_cast<int>(i);
+                return m_buffers[i];
+            }
+        }
+
+        slot = -1;
+        if (m_buffers.size() < m_capacity)
+        {
+            slot = static_cast<int>(m_buffers.size());
+            m_buffers.emplace_back();
+            m_busy.push_back(true);
+        }
+        return {};
+    }
+
+    // Store the decoded image (which may have been reallocated) back in its slot:
+    void release(int slot, const cv::Mat& image)
+    {
+        if (slot >= 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_buffers[slot] = image;
+            m_busy[slot] = false;
+        }
+    }
+
+protected:
+    static bool isFree(const cv::Mat& image)
+    {
+        return !image.u || (CV_XADD(&image.u->refcount, 0) == 1);
+    }
+
+    std::size_t m_capacity = 0;
+    std::mutex m_mutex;
+    std::vector<cv::Mat> m_buffers;
+    std::vector<bool> m_busy;
+};
+
 class VideoSourceStills::Impl
 {
 public:
     explicit Impl(std::string  filename)
         : m_filename(std::move(filename))
+        , m_pool(kBuffers)
     {
         m_filenames = drishti::cli::expand(m_filename);
     }
 
     explicit Impl(std::vector<std::string>  filenames)
         : m_filenames(std::move(filenames))
+        , m_pool(kBuffers)
     {
     }
 
@@ -46,17 +109,70 @@ public:
         return m_filenames.size();
     }
 
+    // Thread safe, so a prefetcher can decode several files concurrently:
     VideoSourceCV::Frame operator()(int i = -1)
     {
     if (!((0 <= i) && (i < m_filenames.size())))
     {
       return {};
     }
-        return VideoSourceCV::Frame(cv::imread(m_filenames[i]), i, m_filenames[i]);
+        return VideoSourceCV::Frame(read(m_filenames[i]), i, m_filenames[i]);
     }
 
+    void setReduction(int value)
+    {
+        switch (value)
+        {
+            case 2:
+                m_flags = cv::IMREAD_REDUCED_COLOR_2;
+                break;
+            case 4:
+                m_flags = cv::IMREAD_REDUCED_COLOR_4;
+                break;
+            case 8:
+                m_flags = cv::IMREAD_REDUCED_COLOR_8;
+                break;
+            default:
+                m_flags = cv::IMREAD_COLOR;
+                break;
+        }
+    }
+
+    cv::Mat read(const std::string& filename)
+    {
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+        // Reuse the encoded stream buffer per thread:
+        static thread_local std::vector<uchar> bytes;
+#else
+        std::vector<uchar> bytes; // per call without C++11 thread_local
+#endif
+
+        std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+        if (!ifs)
+        {
+            return {};
+        }
+        bytes.resize(static_cast<std::size_t>(ifs.tellg()));
+        ifs.seekg(0);
+        if (bytes.empty() || !ifs.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+        {
+            return {};
+        }
+
+        int slot = -1;
+        cv::Mat image = m_pool.acquire(slot);
+        cv::imdecode(bytes, m_flags, &image);
+        m_pool.release(slot, image);
+
+        return image;
+    }
+
+    static constexpr std::size_t kBuffers = 32;
+
     std::string m_filename;
     std::vector<std::string> m_filenames;
+    int m_flags = cv::IMREAD_COLOR; // JPEG can decode at 1/2, 1/4 or 1/8 scale directly
+    MatPool m_pool;
 };
 
 VideoSourceStills::VideoSourceStills(const std::string& filename)
@@ -82,4 +198,9 @@ VideoSourceCV::Frame VideoSourceStills::operator()(int i)
     return (*m_impl)(i);
 }
 
+void VideoSourceStills::setReduction(int value)
+{
+    m_impl->setReduction(value);
+}
+
 DRISHTI_VIDEOIO_NAMESPACE_END
@@ -37,6 +37,7 @@ public:
     Frame operator()(int i = -1) override;
     std::size_t count() const override;
     bool isRandomAccess() const override { return true; }
+    void setReduction(int value) override;
 
 protected:
     std::unique_ptr<Impl> m_impl;
@@ -0,0 +1,105 @@
+/*! -*-c++-*-
+  @file   bench-drishti-hci.cpp
+  @author David Hirvonen
+  @brief  End to end FaceFinder frame time benchmarks (requires an OpenGL context).
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "bench-drishti.h"
+
+#if defined(DRISHTI_BENCHMARK_GPU)
+
+#include "aglet/GLContext.h"
+
+#include "drishti/hci/FaceFinder.h"
+#include "drishti/sensor/Sensor.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/Logger.h"
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#ifdef ANDROID
+#define DFLT_TEXTURE_FORMAT GL_RGBA
+#else
+#define DFLT_TEXTURE_FORMAT GL_BGRA
+#endif
+
+static std::shared_ptr<aglet::GLContext> getContext()
+{
+    static std::shared_ptr<aglet::GLContext> context = aglet::GLContext::create(aglet::GLContext::kAuto);
+    return context;
+}
+
+static std::unique_ptr<drishti::hci::FaceFinder> createFaceFinder(const cv::Size& size, bool doCpuAcf)
+{
+    auto factory = bench::createFactory();
+
+    drishti::hci::FaceFinder::Settings settings;
+    settings.logger = drishti::core::Logger::create("bench-drishti-hci");
+    settings.logger->set_level(spdlog::level::off);
+    settings.threads = std::make_shared<tp::ThreadPool<>>();
+    settings.doLandmarks = true;
+    settings.doSingleFace = true;
+    settings.minDetectionDistance = 0.1f;
+    settings.maxDetectionDistance = 0.5f;
+    settings.faceFinderInterval = 0.f; // detect on every frame
+    settings.history = 3;
+
+    const drishti::sensor::SensorModel::Intrinsic params({ size.width * 0.5f, size.height * 0.5f }, size.width, size);
+    settings.sensor = std::make_shared<drishti::sensor::SensorModel>(params);
+
+    auto finder = drishti::hci::FaceFinder::create(factory, settings, nullptr);
+    finder->setDoCpuAcf(doCpuAcf);
+    return finder;
+}
+
+// Steady state throughput (the async pipeline reports frame N-latency per call), arg: 1 == CPU ACF pyramid
+static void BM_FaceFinderFrame(benchmark::State& state)
+{
+    auto context = getContext();
+    (*context)();
+
+    cv::Mat image;
+    cv::cvtColor(bench::getFaceImage().image, image, cv::COLOR_BGR2BGRA);
+    auto finder = createFaceFinder(image.size(), state.range(0) != 0);
+
+    ogles_gpgpu::FrameInput frame({ image.cols, image.rows }, image.ptr(), true, 0, DFLT_TEXTURE_FORMAT);
+    for (int i = 0; i < 4; i++)
+    {
+        (*finder)(frame); // fill the pipeline + first detection (joins model loading)
+    }
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize((*finder)(frame));
+    }
+
+    state.SetLabel(bench::getModelName(sFaceDetector) + (state.range(0) ? " cpu-acf" : " gpu-acf"));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FaceFinderFrame)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Time to the first processed frame, including (overlapped) model loading:
+static void BM_FaceFinderInit(benchmark::State& state)
+{
+    auto context = getContext();
+    (*context)();
+
+    cv::Mat image;
+    cv::cvtColor(bench::getFaceImage().image, image, cv::COLOR_BGR2BGRA);
+    ogles_gpgpu::FrameInput frame({ image.cols, image.rows }, image.ptr(), true, 0, DFLT_TEXTURE_FORMAT);
+
+    for (auto _ : state)
+    {
+        auto finder = createFaceFinder(image.size(), false);
+        benchmark::DoNotOptimize((*finder)(frame));
+    }
+}
+BENCHMARK(BM_FaceFinderInit)->Unit(benchmark::kMillisecond);
+
+#endif // defined(DRISHTI_BENCHMARK_GPU)
@@ -0,0 +1,248 @@
+/*! -*-c++-*-
+  @file   bench-drishti-models.cpp
+  @author David Hirvonen
+  @brief  Model load, detection, regression and tracking benchmarks.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "bench-drishti.h"
+
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
+#include "drishti/ml/XGBooster.h"
+#include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/eye/IrisNormalizer.h"
+#include "drishti/face/FaceTracker.h"
+
+#include <acf/ACF.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+// ### Model load ###
+
+static void BM_LoadFaceDetector(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        drishti::ml::ObjectDetectorACF detector(sFaceDetector);
+        benchmark::DoNotOptimize(detector.good());
+    }
+    state.SetLabel(bench::getModelName(sFaceDetector));
+    state.counters["bytes"] = bench::getFileSize(sFaceDetector);
+}
+BENCHMARK(BM_LoadFaceDetector)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadFaceRegressor(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        drishti::ml::RegressionTreeEnsembleShapeEstimator regressor(sFaceRegressor);
+        benchmark::DoNotOptimize(regressor.getMeanShape().size());
+    }
+    state.SetLabel(bench::getModelName(sFaceRegressor));
+    state.counters["bytes"] = bench::getFileSize(sFaceRegressor);
+}
+BENCHMARK(BM_LoadFaceRegressor)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadEyeRegressor(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        drishti::eye::EyeModelEstimator regressor(sEyeRegressor);
+        benchmark::DoNotOptimize(regressor.good());
+    }
+    state.SetLabel(bench::getModelName(sEyeRegressor));
+    state.counters["bytes"] = bench::getFileSize(sEyeRegressor);
+}
+BENCHMARK(BM_LoadEyeRegressor)->Unit(benchmark::kMillisecond);
+
+// ### ACF ###
+
+static drishti::ml::ObjectDetectorACF& getFaceDetector()
+{
+    static drishti::ml::ObjectDetectorACF detector(sFaceDetector);
+    return detector;
+}
+
+static void BM_AcfPyramidCPU(benchmark::State& state)
+{
+    const auto& face = bench::getFaceImage();
+    auto* detector = getFaceDetector().getDetector();
+
+    acf::Detector::Pyramid P;
+    for (auto _ : state)
+    {
+        detector->computePyramid(face.Ip, P);
+        benchmark::DoNotOptimize(P.nScales);
+    }
+    state.SetLabel(bench::getModelName(sFaceDetector));
+    state.counters["scales"] = P.nScales;
+}
+BENCHMARK(BM_AcfPyramidCPU)->Unit(benchmark::kMillisecond);
+
+static void BM_AcfDetect(benchmark::State& state)
+{
+    const auto& face = bench::getFaceImage();
+    auto& detector = getFaceDetector();
+
+    std::vector<cv::Rect> objects;
+    std::vector<double> scores;
+    for (auto _ : state)
+    {
+        objects.clear();
+        scores.clear();
+        detector(face.Ip, objects, &scores);
+    }
+    state.SetLabel(bench::getModelName(sFaceDetector));
+    state.counters["objects"] = objects.size();
+}
+BENCHMARK(BM_AcfDetect)->Unit(benchmark::kMillisecond);
+
+// ### shape_predictor ###
+
+// Time and deviation from the full cascade (normalized by the roi width) for the first N levels:
+static void BM_FaceRegressorStages(benchmark::State& state)
+{
+    static drishti::ml::RegressionTreeEnsembleShapeEstimator regressor(sFaceRegressor);
+
+    const auto& face = bench::getFaceImage();
+    const cv::Rect roi = []() {
+        std::vector<cv::Rect> objects;
+        getFaceDetector()(bench::getFaceImage().Ip, objects);
+        CV_Assert(!objects.empty());
+        return objects.front();
+    }();
+
+    drishti::ml::ShapeEstimator::Point2fVec full, points;
+    drishti::ml::ShapeEstimator::BoolVec mask;
+    regressor.setStagesHint(std::numeric_limits<int>::max());
+    regressor(face.gray, roi, full, mask);
+
+    regressor.setStagesHint(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        regressor(face.gray, roi, points, mask);
+    }
+
+    double error = 0.0;
+    for (std::size_t i = 0; i < std::min(points.size(), full.size()); i++)
+    {
+        error += cv::norm(points[i] - full[i]);
+    }
+    state.SetLabel(bench::getModelName(sFaceRegressor));
+    state.counters["error"] = full.size() ? (error / (full.size() * roi.width)) : 0.0;
+}
+BENCHMARK(BM_FaceRegressorStages)->DenseRange(1, 16)->Unit(benchmark::kMicrosecond);
+
+// ### CPR (eye model) ###
+
+static void BM_EyeModel(benchmark::State& state)
+{
+    static drishti::eye::EyeModelEstimator regressor(sEyeRegressor);
+
+    const cv::Mat crop = bench::getEyeImage();
+    regressor.setDoPupil(state.range(0) != 0);
+    regressor.setEyelidInits(1);
+    regressor.setIrisInits(1);
+
+    drishti::eye::EyeModel eye;
+    for (auto _ : state)
+    {
+        regressor(crop, eye);
+    }
+    state.SetLabel(bench::getModelName(sEyeRegressor) + (state.range(0) ? " iris+pupil" : " iris"));
+}
+BENCHMARK(BM_EyeModel)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_IrisNormalizer(benchmark::State& state)
+{
+    drishti::eye::EyeModelEstimator regressor(sEyeRegressor);
+    const cv::Mat crop = bench::getEyeImage();
+
+    drishti::eye::EyeModel eye;
+    regressor(crop, eye);
+
+    const drishti::eye::IrisNormalizer normalizer;
+    const cv::Size size(256, 64);
+    drishti::eye::NormalizedIris code;
+    for (auto _ : state)
+    {
+        normalizer(crop, eye, size, code);
+    }
+}
+BENCHMARK(BM_IrisNormalizer)->Unit(benchmark::kMicrosecond);
+
+// ### XGBooster ###
+
+#if !DRISHTI_BUILD_MIN_SIZE
+// Batch prediction with a small booster fit to a synthetic function (rows per call = arg):
+static void BM_XGBoosterPredict(benchmark::State& state)
+{
+    const int features = 16;
+    static std::shared_ptr<drishti::ml::XGBooster> booster = [&]() {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+
+        MatrixType<float> X(1024, std::vector<float>(features));
+        std::vector<float> y;
+        for (auto& x : X)
+        {
+            std::generate(x.begin(), x.end(), [&]() { return uniform(rng); });
+            y.push_back(x[0] * x[1] + x[2]);
+        }
+
+        drishti::ml::XGBooster::Recipe recipe;
+        recipe.numberOfTrees = 128;
+        auto booster = std::make_shared<drishti::ml::XGBooster>(recipe);
+        booster->train(X, y);
+        return booster;
+    }();
+
+    cv::Mat1f X(static_cast<int>(state.range(0)), features);
+    cv::randu(X, -1.f, 1.f);
+    std::vector<float> predictions(X.rows);
+    for (auto _ : state)
+    {
+        (*booster)(X, predictions.data());
+    }
+    state.SetItemsProcessed(state.iterations() * X.rows);
+}
+BENCHMARK(BM_XGBoosterPredict)->Arg(1)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+#endif // !DRISHTI_BUILD_MIN_SIZE
+
+// ### FaceTracker ###
+
+// Tracker update for N faces jittered around a grid (faces per frame = arg):
+static void BM_FaceTrackerUpdate(benchmark::State& state)
+{
+    const int n = static_cast<int>(state.range(0));
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> jitter(0.f, 2.f);
+
+    drishti::face::FaceTracker tracker;
+    drishti::face::FaceTracker::FaceTrackVec tracks;
+    drishti::face::FaceTracker::FaceModelVec faces(n);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (int i = 0; i < n; i++)
+        {
+            const cv::Point2f tl((i % 4) * 160.f + jitter(rng), (i / 4) * 160.f + jitter(rng));
+            faces[i] = drishti::face::FaceModel(cv::Rect(tl, cv::Size(100, 100)));
+        }
+        state.ResumeTiming();
+
+        tracks.clear();
+        tracker(faces, tracks);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_FaceTrackerUpdate)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMicrosecond);
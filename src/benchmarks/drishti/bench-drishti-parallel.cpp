@@ -0,0 +1,205 @@
+/*! -*-c++-*-
+  @file   bench-drishti-parallel.cpp
+  @author David Hirvonen
+  @brief  Dispatch overhead benchmarks for the parallel loop backends.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The hot paths dispatch with plain loops, cv::parallel_for_ (shape_predictor, pupil search,
+  FaceDetector), tp::ThreadPool::process() (FaceFinder) and the core::parallelFor() and
+  core::WorkerGroup executors.  For each backend (first argument, see Backend):
+
+    BM_ParallelDispatch : round trip for one empty task per worker (dispatch latency)
+    BM_ParallelGrain    : 256 tasks of a fixed cost in microseconds (second argument), where
+                          overhead is the time per task in excess of the ideal speedup
+    BM_ParallelNested   : 8 outer tasks, each with an inner loop of 8 tasks of 10 microseconds
+
+  Grain size thresholds (e.g., parallel boosting and pupil search) are the task cost at which
+  the overhead of a backend becomes a small fraction of the task cost on the target device.
+
+*/
+
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/WorkerGroup.h"
+#include "drishti/core/Parallel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+enum Backend
+{
+    kSerial,       // plain loop
+    kOpenCV,       // cv::parallel_for_()
+    kThreadPool,   // tp::ThreadPool::process() with one future per task
+    kParallelFor,  // core::parallelFor() on the SDK pool (shared counter)
+    kWorkStealing, // core::parallelFor() with core::ParallelSettings
+    kWorkerGroup,  // core::WorkerGroup lanes (static partition)
+    kBackends
+};
+
+static const char* kBackendNames[kBackends] = { "serial", "cv::parallel_for_", "tp::ThreadPool", "core::parallelFor", "core::parallelFor(steal)", "core::WorkerGroup" };
+
+static int getWorkers()
+{
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+static drishti::core::WorkerGroup& getWorkerGroup()
+{
+    static drishti::core::WorkerGroup group(getWorkers());
+    return group;
+}
+
+// Busy wait, so the task cost doesn't depend on the scheduler wake up latency:
+static void spin(double microseconds)
+{
+    const auto stop = std::chrono::high_resolution_clock::now() + std::chrono::duration<double, std::micro>(microseconds);
+    while (std::chrono::high_resolution_clock::now() < stop)
+    {
+    }
+}
+
+// Run body(i) for i in [0, count) on the backend and block until complete:
+static void run(Backend backend, int count, const std::function<void(int)>& body)
+{
+    const cv::Range range(0, count);
+    const drishti::core::ParallelHomogeneousLambda loop([&](int i) { body(i); });
+    switch (backend)
+    {
+        case kSerial:
+            for (int i = 0; i < count; i++)
+            {
+                body(i);
+            }
+            break;
+
+        case kOpenCV:
+            cv::parallel_for_(range, loop);
+            break;
+
+        case kThreadPool:
+        {
+            auto* pool = drishti::core::ThreadPoolSource::getInstance();
+            std::vector<std::future<void>> results;
+            results.reserve(count);
+            for (int i = 0; i < count; i++)
+            {
+                results.emplace_back(pool->process([&body, i]() { body(i); }));
+            }
+            for (auto& result : results)
+            {
+                result.get();
+            }
+            break;
+        }
+
+        case kParallelFor:
+            drishti::core::parallelFor(range, loop, drishti::core::ThreadPoolSource::getInstance());
+            break;
+
+        case kWorkStealing:
+            drishti::core::parallelFor(range, loop, drishti::core::ParallelSettings{});
+            break;
+
+        case kWorkerGroup:
+        {
+            auto job = [&](int lane, drishti::core::SpinBarrier&) {
+                const int lanes = getWorkerGroup().size();
+                for (int i = lane; i < count; i += lanes)
+                {
+                    body(i);
+                }
+            };
+            if (!getWorkerGroup().tryRun(job))
+            {
+                for (int i = 0; i < count; i++) // busy (nested), as the callers fall back
+                {
+                    body(i);
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+static void BM_ParallelDispatch(benchmark::State& state)
+{
+    const auto backend = static_cast<Backend>(state.range(0));
+    const int count = getWorkers();
+    for (auto _ : state)
+    {
+        run(backend, count, [](int i) { benchmark::DoNotOptimize(i); });
+    }
+    state.SetLabel(kBackendNames[backend]);
+    state.counters["workers"] = count;
+}
+BENCHMARK(BM_ParallelDispatch)->DenseRange(0, kBackends - 1)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_ParallelGrain(benchmark::State& state)
+{
+    const auto backend = static_cast<Backend>(state.range(0));
+    const double grain = static_cast<double>(state.range(1)); // microseconds
+    const int count = 256;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (auto _ : state)
+    {
+        run(backend, count, [grain](int) { spin(grain); });
+    }
+    const auto stop = std::chrono::high_resolution_clock::now();
+
+    // Excess time per task w.r.t. a perfect speedup on the available workers:
+    const int workers = (backend == kSerial) ? 1 : std::min(getWorkers(), count);
+    const double elapsed = std::chrono::duration<double, std::micro>(stop - start).count() / std::max(static_cast<double>(state.iterations()), 1.0);
+    const double ideal = count * grain / workers;
+
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetLabel(kBackendNames[backend]);
+    state.counters["workers"] = workers;
+    state.counters["overhead"] = (elapsed - ideal) / count; // microseconds per task
+}
+
+static void getGrainArguments(benchmark::internal::Benchmark* benchmark)
+{
+    for (int backend = 0; backend < kBackends; backend++)
+    {
+        for (int grain : { 1, 10, 100 })
+        {
+            benchmark->Args({ backend, grain });
+        }
+    }
+}
+BENCHMARK(BM_ParallelGrain)->Apply(getGrainArguments)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_ParallelNested(benchmark::State& state)
+{
+    const auto backend = static_cast<Backend>(state.range(0));
+    if (backend == kThreadPool)
+    {
+        // Outer tasks that block on inner futures can occupy every pool thread:
+        state.SkipWithError("nested futures can deadlock the pool");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        run(backend, 8, [backend](int) {
+            run(backend, 8, [](int) { spin(10.0); });
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+    state.SetLabel(kBackendNames[backend]);
+}
+BENCHMARK(BM_ParallelNested)->DenseRange(0, kBackends - 1)->UseRealTime()->Unit(benchmark::kMicrosecond);
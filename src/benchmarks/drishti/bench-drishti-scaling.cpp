@@ -0,0 +1,181 @@
+/*! -*-c++-*-
+  @file   bench-drishti-scaling.cpp
+  @author David Hirvonen
+  @brief  Thread scaling benchmarks for the face and eye models.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Each thread owns an instance (as in app/face and app/eye, see core::LazyParallelResource)
+  and processes the same frame, so throughput (items_per_second, summed over the threads)
+  should scale with the thread count up to the core count.  Per thread counters (averaged
+  over the threads):
+
+    p99           : 99th percentile latency (milliseconds)
+    allocs        : heap allocations per item
+    alloc_bytes   : heap bytes allocated per item
+    thread_bytes  : heap bytes allocated by the instance (memory per thread)
+
+  The drishti_scaling_benchmarks target runs these with short runs, e.g., in sanitizer
+  (TSAN, ASAN) builds.
+
+*/
+
+#include "bench-drishti.h"
+
+#include "drishti/face/FaceDetector.h"
+#include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/core/make_unique.h"
+
+#include <drishti/EyeSegmenter.hpp>
+#include <drishti/drishti_cv.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// ### Allocation counting ###
+
+// Per thread counters, so the threads don't contend (or synchronize) in the allocator hook:
+static thread_local std::size_t sAllocations = 0;
+static thread_local std::size_t sAllocatedBytes = 0;
+
+void* operator new(std::size_t size)
+{
+    sAllocations++;
+    sAllocatedBytes += size;
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+// ### Harness ###
+
+static const int kMaxThreads = 16;
+static const std::size_t kMaxLatencies = 1 << 16;
+
+// Run one item per iteration on a per thread instance (create() is called on the benchmark thread):
+template <typename Create, typename Run>
+static void runScaling(benchmark::State& state, Create create, Run run)
+{
+    const std::size_t instanceBytes = sAllocatedBytes;
+    auto instance = create();
+    const double threadBytes = static_cast<double>(sAllocatedBytes - instanceBytes);
+
+    run(*instance); // warm up (lazy buffers)
+
+    std::vector<double> latencies;
+    latencies.reserve(kMaxLatencies); // no allocations in the loop
+
+    const std::size_t allocations = sAllocations, bytes = sAllocatedBytes;
+    for (auto _ : state)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        run(*instance);
+        const auto stop = std::chrono::high_resolution_clock::now();
+        if (latencies.size() < kMaxLatencies)
+        {
+            latencies.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+    }
+
+    const double items = std::max(static_cast<double>(state.iterations()), 1.0);
+    const double itemAllocations = static_cast<double>(sAllocations - allocations) / items;
+    const double itemBytes = static_cast<double>(sAllocatedBytes - bytes) / items;
+
+    double p99 = 0.0;
+    if (!latencies.empty())
+    {
+        const auto nth = latencies.begin() + (latencies.size() * 99) / 100;
+        std::nth_element(latencies.begin(), nth, latencies.end());
+        p99 = *nth;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["p99"] = benchmark::Counter(p99, benchmark::Counter::kAvgThreads);
+    state.counters["allocs"] = benchmark::Counter(itemAllocations, benchmark::Counter::kAvgThreads);
+    state.counters["alloc_bytes"] = benchmark::Counter(itemBytes, benchmark::Counter::kAvgThreads);
+    state.counters["thread_bytes"] = benchmark::Counter(threadBytes, benchmark::Counter::kAvgThreads);
+}
+
+// ### FaceDetector ###
+
+// ACF detection and landmark regression:
+static void BM_FaceDetectorScaling(benchmark::State& state)
+{
+    static auto factory = bench::createFactory(); // file names only, each detector loads the models
+
+    const auto& face = bench::getFaceImage();
+    const drishti::face::FaceDetector::PaddedImage Ib(face.gray);
+
+    std::vector<drishti::face::FaceModel> faces;
+    runScaling(
+        state,
+        [&]() { return drishti::core::make_unique<drishti::face::FaceDetector>(*factory); },
+        [&](drishti::face::FaceDetector& detector) {
+            faces.clear();
+            detector(face.Ip, Ib, faces);
+        });
+    state.SetLabel(bench::getModelName(sFaceDetector) + " " + bench::getModelName(sFaceRegressor));
+}
+BENCHMARK(BM_FaceDetectorScaling)->ThreadRange(1, kMaxThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// ### EyeModelEstimator ###
+
+// Clones share the read only regressors (see EyeModelEstimator::clone()), so thread_bytes is the
+// per thread state only:
+static void BM_EyeModelEstimatorScaling(benchmark::State& state)
+{
+    static const drishti::eye::EyeModelEstimator prototype(sEyeRegressor);
+
+    const cv::Mat crop = bench::getEyeImage();
+    drishti::eye::EyeModel eye;
+    runScaling(
+        state,
+        [&]() {
+            auto regressor = prototype.clone();
+            if (!regressor)
+            {
+                regressor = drishti::core::make_unique<drishti::eye::EyeModelEstimator>(sEyeRegressor);
+            }
+            regressor->setEyelidInits(1);
+            regressor->setIrisInits(1);
+            return regressor;
+        },
+        [&](drishti::eye::EyeModelEstimator& regressor) { regressor(crop, eye); });
+    state.SetLabel(bench::getModelName(sEyeRegressor));
+}
+BENCHMARK(BM_EyeModelEstimatorScaling)->ThreadRange(1, kMaxThreads)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// ### sdk::EyeSegmenter ###
+
+// Public API, one model load per thread:
+static void BM_EyeSegmenterScaling(benchmark::State& state)
+{
+    const cv::Mat3b crop = bench::getEyeImage();
+    const auto image = drishti::sdk::cvToDrishti<cv::Vec3b, drishti::sdk::Vec3b>(crop);
+
+    drishti::sdk::Eye eye;
+    runScaling(
+        state,
+        [&]() { return drishti::core::make_unique<drishti::sdk::EyeSegmenter>(sEyeRegressor); },
+        [&](drishti::sdk::EyeSegmenter& segmenter) { segmenter(image, eye, true); });
+    state.SetLabel(bench::getModelName(sEyeRegressor));
+}
+BENCHMARK(BM_EyeSegmenterScaling)->ThreadRange(1, kMaxThreads)->UseRealTime()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,99 @@
+/*! -*-c++-*-
+  @file   bench-drishti.cpp
+  @author David Hirvonen
+  @brief  Google benchmark suite for drishtisdk hot paths (size and speed).
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Usage: bench-drishti [--benchmark_*] <detector> <mean> <regressor> <eye> <eye_image> <face_image>
+
+  Use --benchmark_out=<file> --benchmark_out_format=json for machine readable results,
+  model names are reported in the benchmark labels.
+
+*/
+
+#include "bench-drishti.h"
+
+#include <benchmark/benchmark.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <fstream>
+#include <iostream>
+
+const char* sFaceDetector;
+const char* sFaceDetectorMean;
+const char* sFaceRegressor;
+const char* sEyeRegressor;
+const char* sEyeImageFilename;
+const char* sFaceImageFilename;
+
+namespace bench
+{
+const FaceImage& getFaceImage()
+{
+    static const FaceImage face = []() {
+        FaceImage face;
+        face.image = cv::imread(sFaceImageFilename, cv::IMREAD_COLOR);
+        CV_Assert(!face.image.empty());
+
+        cv::Mat Irgb, Itf;
+        cv::cvtColor(face.image, Irgb, cv::COLOR_BGR2RGB);
+        cv::Mat(Irgb.t()).convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+        face.Ip = MatP(Itf);
+
+        cv::extractChannel(face.image, face.gray, 1);
+        return face;
+    }();
+    return face;
+}
+
+cv::Mat getEyeImage()
+{
+    static const cv::Mat eye = []() {
+        cv::Mat image = cv::imread(sEyeImageFilename, cv::IMREAD_COLOR), resized;
+        CV_Assert(!image.empty());
+        cv::resize(image, resized, { 128, 96 }, 0, 0, cv::INTER_AREA);
+        return resized;
+    }();
+    return eye;
+}
+
+std::shared_ptr<drishti::face::FaceDetectorFactory> createFactory()
+{
+    return std::make_shared<drishti::face::FaceDetectorFactory>(sFaceDetector, sFaceRegressor, sEyeRegressor, sFaceDetectorMean);
+}
+
+std::string getModelName(const std::string& filename)
+{
+    return filename.substr(filename.find_last_of("/\\") + 1);
+}
+
+double getFileSize(const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+    return ifs ? static_cast<double>(ifs.tellg()) : 0.0;
+}
+} // namespace bench
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv); // consumes --benchmark_* arguments
+    if (argc != 7)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--benchmark_*] <detector> <mean> <regressor> <eye> <eye_image> <face_image>" << std::endl;
+        return 1;
+    }
+
+    sFaceDetector = argv[1];
+    sFaceDetectorMean = argv[2];
+    sFaceRegressor = argv[3];
+    sEyeRegressor = argv[4];
+    sEyeImageFilename = argv[5];
+    sFaceImageFilename = argv[6];
+
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
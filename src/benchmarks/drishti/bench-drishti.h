@@ -0,0 +1,49 @@
+/*! -*-c++-*-
+  @file   bench-drishti.h
+  @author David Hirvonen
+  @brief  Shared resources for the drishtisdk benchmarks.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_benchmarks_bench_drishti_h__
+#define __drishti_benchmarks_bench_drishti_h__
+
+#include "drishti/face/FaceDetectorFactory.h"
+
+#include <acf/MatP.h>
+
+#include <opencv2/core/core.hpp>
+
+#include <memory>
+#include <string>
+
+extern const char* sFaceDetector;
+extern const char* sFaceDetectorMean;
+extern const char* sFaceRegressor;
+extern const char* sEyeRegressor;
+extern const char* sEyeImageFilename;
+extern const char* sFaceImageFilename;
+
+namespace bench
+{
+// Test frame in the formats used by the detection and regression stages:
+struct FaceImage
+{
+    cv::Mat image; // BGR
+    MatP Ip;       // transposed planar RGB [0..1] for ACF
+    cv::Mat gray;  // green channel for regression
+};
+
+const FaceImage& getFaceImage();
+cv::Mat getEyeImage(); // 4:3 right eye crop (BGR)
+
+std::shared_ptr<drishti::face::FaceDetectorFactory> createFactory();
+
+std::string getModelName(const std::string& filename); // basename, for benchmark labels
+double getFileSize(const std::string& filename);       // bytes
+} // namespace bench
+
+#endif // __drishti_benchmarks_bench_drishti_h__
@@ -28,6 +28,10 @@ import android.util.Log;
 import android.util.Size;
 import android.view.Surface;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.FloatBuffer;
+
 // We will receive GLSurfaceView.Renderer events for the underlying Surface of
 // FaceFilterGLSurfaceView (GLSurfaceView) object to manage our own Surface
 // and SurfaceTexture mSTexture. Original Surface will not be used directly.
@@ -37,6 +41,17 @@ public class FaceFilterRenderer
 {
     private static String TAG = "ElucideyeFaceFilterRenderer";
 
+    // Called once per rendered frame on the render thread.  The buffer is a view of
+    // native storage (see facefilter::FaceResults for the float layout) that is only
+    // valid until the next frame, copy what must be kept.
+    public interface OnFacesListener
+    {
+        void onFaces(FloatBuffer results, int count);
+    }
+
+    private OnFacesListener mFacesListener;
+    private FloatBuffer mResults;
+
     private int[] hTex;
 
     private SurfaceTexture mSTexture;
@@ -67,6 +82,14 @@ public class FaceFilterRenderer
         setAssetManager(mFragment.getActivity().getAssets());
 
         loadAsset("drishti_assets", "drishti_assets.json");
+
+        // Allocated once, the native side updates it in place:
+        mResults = getResultsBuffer().order(ByteOrder.nativeOrder()).asFloatBuffer();
+    }
+
+    public void setOnFacesListener(OnFacesListener listener)
+    {
+        mFacesListener = listener;
     }
 
     // Scheduled from FaceFilterGLSurfaceView.onPause(). Executed from "render
@@ -85,7 +108,6 @@ public class FaceFilterRenderer
     @Override
     public void onDrawFrame(GL10 unused)
     {
-        Log.d(TAG, "onDrawFrame");
         if (!mGLInit)
         {
             return;
@@ -107,7 +129,11 @@ public class FaceFilterRenderer
 
         if (startDrawing)
         {
-            drawFrame(hTex[0]); // JNI
+            int count = drawFrame(hTex[0]); // JNI
+            if (mFacesListener != null)
+            {
+                mFacesListener.onFaces(mResults, count);
+            }
         }
     }
 
@@ -200,7 +226,8 @@ public class FaceFilterRenderer
         int cameraOrientation,
         float cameraFocalLength);
     private native void surfaceChanged(int width, int height);
-    private native void drawFrame(int texture);
+    private native int drawFrame(int texture);
+    private native ByteBuffer getResultsBuffer();
     private native void destroy();
 
     private native int allocTexture(int width, int height);
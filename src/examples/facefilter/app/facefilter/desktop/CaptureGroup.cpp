@@ -0,0 +1,125 @@
+/*!
+  @file   CaptureGroup.cpp
+  @brief  Threaded (latest frame wins) capture for one or more cameras.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+
+*/
+
+#include "CaptureGroup.h"
+
+#include <opencv2/imgproc.hpp> // for cv::cvtColor()
+
+#include <algorithm>
+#include <utility>
+
+CaptureGroup::CaptureGroup(std::vector<std::shared_ptr<cv::VideoCapture>> videos)
+{
+    for (auto& video : videos)
+    {
+        m_cameras.emplace_back(new Camera);
+        m_cameras.back()->video = std::move(video);
+    }
+
+    for (auto& camera : m_cameras)
+    {
+        auto* ptr = camera.get();
+        camera->thread = std::thread([this, ptr]() { capture(*ptr); });
+    }
+}
+
+CaptureGroup::~CaptureGroup()
+{
+    m_stop = true;
+    for (auto& camera : m_cameras)
+    {
+        if (camera->thread.joinable())
+        {
+            camera->thread.join();
+        }
+    }
+}
+
+double CaptureGroup::now()
+{
+    const auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::duration<double>>(time).count();
+}
+
+void CaptureGroup::capture(Camera& camera)
+{
+    cv::Mat raw;
+    std::uint64_t index = 0;
+    while (!m_stop)
+    {
+        if (!camera.video->read(raw) || raw.empty())
+        {
+            break;
+        }
+
+        auto& frame = camera.frames[camera.back];
+        frame.timestamp = now();
+        frame.index = index++;
+        switch (raw.channels())
+        {
+            case 1:
+                cv::cvtColor(raw, frame.image, cv::COLOR_GRAY2BGRA);
+                break;
+            case 3:
+                cv::cvtColor(raw, frame.image, cv::COLOR_BGR2BGRA);
+                break;
+            default:
+                raw.copyTo(frame.image);
+                break;
+        }
+
+        // Publish the back buffer, and take the previous shared buffer (unread if it was fresh):
+        const int previous = camera.shared.exchange(camera.back | kFresh, std::memory_order_acq_rel);
+        camera.back = previous & 3;
+        if (previous & kFresh)
+        {
+            camera.dropped++;
+        }
+
+        m_published++;
+        m_cv.notify_all();
+    }
+
+    camera.running = false;
+    m_published++;
+    m_cv.notify_all();
+}
+
+const CaptureGroup::Frame* CaptureGroup::latest(std::size_t i)
+{
+    auto& camera = *m_cameras[i];
+    if (!(camera.shared.load(std::memory_order_acquire) & kFresh))
+    {
+        return nullptr;
+    }
+
+    camera.front = camera.shared.exchange(camera.front, std::memory_order_acq_rel) & 3;
+    return &camera.frames[camera.front];
+}
+
+bool CaptureGroup::wait(const std::chrono::milliseconds& timeout)
+{
+    const auto isRunning = [this]() {
+        return std::any_of(m_cameras.begin(), m_cameras.end(), [](const std::unique_ptr<Camera>& camera) { return camera->running.load(); });
+    };
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const bool published = m_cv.wait_for(lock, timeout, [&]() { return m_published != m_seen; });
+    m_seen = m_published;
+    return published && isRunning();
+}
+
+bool CaptureGroup::isRunning(std::size_t i) const
+{
+    return m_cameras[i]->running;
+}
+
+std::uint64_t CaptureGroup::getDropped(std::size_t i) const
+{
+    return m_cameras[i]->dropped;
+}
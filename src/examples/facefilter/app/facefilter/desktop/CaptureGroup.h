@@ -0,0 +1,93 @@
+/*!
+  @file   CaptureGroup.h
+  @brief  Threaded (latest frame wins) capture for one or more cameras.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+
+  Each camera is read on its own thread, so cv::VideoCapture::read() latency doesn't add
+  to the render loop.  Frames are converted to BGRA on the capture thread and published
+  to a lock-free triple buffer per camera: the capture thread never waits for the render
+  loop, and the render loop always takes the freshest frame (older unread frames are
+  dropped and counted).
+
+*/
+
+#ifndef __facefilter_desktop_CaptureGroup_h__
+#define __facefilter_desktop_CaptureGroup_h__
+
+#include <opencv2/highgui.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CaptureGroup
+{
+public:
+    struct Frame
+    {
+        cv::Mat image;           // BGRA
+        double timestamp = -1.0; // capture time in seconds (steady clock)
+        std::uint64_t index = 0; // capture count for the camera
+    };
+
+    // Capture threads start immediately (the sources must be open):
+    explicit CaptureGroup(std::vector<std::shared_ptr<cv::VideoCapture>> videos);
+    ~CaptureGroup();
+
+    CaptureGroup(const CaptureGroup&) = delete;
+    CaptureGroup(CaptureGroup&&) = delete;
+    CaptureGroup& operator=(const CaptureGroup&) = delete;
+    CaptureGroup& operator=(CaptureGroup&&) = delete;
+
+    std::size_t size() const { return m_cameras.size(); }
+
+    // Freshest frame published since the last call for camera i (nullptr if there is none),
+    // valid until the next call for the same camera:
+    const Frame* latest(std::size_t i);
+
+    // Wait for a new frame from any camera, returns false on timeout or when all cameras stopped:
+    bool wait(const std::chrono::milliseconds& timeout);
+
+    // False once the camera stopped delivering frames:
+    bool isRunning(std::size_t i) const;
+
+    // Frames that were replaced before the render loop read them:
+    std::uint64_t getDropped(std::size_t i) const;
+
+    static double now();
+
+protected:
+    static constexpr int kFresh = 4; // set in the shared index when it holds an unread frame
+
+    struct Camera
+    {
+        std::shared_ptr<cv::VideoCapture> video;
+        std::array<Frame, 3> frames;
+        std::atomic<int> shared{ 1 }; // frames[shared & 3] is exchanged between the threads
+        int back = 2;                 // capture thread
+        int front = 0;                // render loop
+        std::atomic<bool> running{ true };
+        std::atomic<std::uint64_t> dropped{ 0 };
+        std::thread thread;
+    };
+
+    void capture(Camera& camera);
+
+    std::vector<std::unique_ptr<Camera>> m_cameras;
+    std::atomic<bool> m_stop{ false };
+
+    // Wake up for wait() only, frames are exchanged without the lock:
+    std::atomic<std::uint64_t> m_published{ 0 };
+    std::uint64_t m_seen = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+#endif // __facefilter_desktop_CaptureGroup_h__
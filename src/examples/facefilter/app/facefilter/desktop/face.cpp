@@ -10,6 +10,16 @@
     --config=${DHT_REPO}/config/logitech_c615.json \
     --preview
 
+  Cameras (a device index, or a comma separated list of indices) are read on capture
+  threads and the freshest frame of each camera is processed (see CaptureGroup), video
+  files and image lists are read synchronously so that every frame is processed:
+
+  drishti-face-test \
+    --input=0,1 \
+    --models=${SOME_PATH_VAR}/drishti-assets/drishti_assets_big.json \
+    --config=${DHT_REPO}/config/logitech_c615.json \
+    --preview
+
 */
 
 // Need std:: extensions for android targets
@@ -31,6 +41,7 @@
 #include <facefilter/renderer/FaceTrackerFactoryJson.h>
 #include <facefilter/renderer/Context.h> // facefilter::Application
 #include "VideoCaptureList.h"
+#include "CaptureGroup.h"
 
 #include "drishti/drishti_sdk.hpp" // for version from public SDK
 
@@ -48,6 +59,7 @@
 #include <iomanip>
 
 #include <facefilter/Exception.hpp>
+#include <facefilter/make_unique.h>
 
 #ifdef ANDROID
 #    define DFLT_TEXTURE_FORMAT GL_RGBA
@@ -72,7 +84,24 @@ static void to_json(const std::string& filename, const Params& params);
 
 using FaceResources = drishti::sdk::FaceTracker::Resources;
 static std::shared_ptr<cv::VideoCapture> create(const std::string& filename);
+static std::vector<int> getCameras(const std::string& input);
 static std::shared_ptr<spdlog::logger> createLogger(const char* name);
+// Device indices for "0" or "0,1,..." (empty for other inputs):
+static std::vector<int> getCameras(const std::string& input)
+{
+    std::vector<int> cameras;
+    std::stringstream ss(input);
+    for (std::string token; std::getline(ss, token, ',');)
+    {
+        if (token.empty() || (token.find_first_not_of("0123456789") != std::string::npos))
+        {
+            return {};
+        }
+        cameras.push_back(std::stoi(token));
+    }
+    return cameras;
+}
+
 static cv::Size getSize(const cv::VideoCapture& video);
 
 int main(int argc, char** argv)
@@ -82,6 +111,8 @@ int main(int argc, char** argv)
     const auto argumentCount = argc;
 
     bool doPreview = false;
+    bool doDecoupled = false;
+    float trackingRate = 0.f;
     std::string sInput, sModels, sConfig;
 
 #if defined(DRISHTI_HAVE_LOCALECONV)
@@ -108,6 +139,8 @@ int main(int argc, char** argv)
 
         // behavior:
         ("p,preview", "Preview window", cxxopts::value<bool>(doPreview))
+        ("decoupled", "Display every frame, track at the sustainable rate", cxxopts::value<bool>(doDecoupled))
+        ("tracking-rate", "Upper bound for the decoupled tracking rate (fps)", cxxopts::value<float>(trackingRate))
 
         ("version", "Report library version", cxxopts::value<bool>(doVersion))
         ;
@@ -163,35 +196,49 @@ int main(int argc, char** argv)
     }
 
     // :::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
-    // Allocate a video source and get the video frame dimensions:
+    // Allocate the video sources and get the video frame dimensions:
     // :::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-    std::shared_ptr<cv::VideoCapture> video = create(sInput);
-    if (!(video && video->isOpened()))
+    const std::vector<int> cameras = getCameras(sInput);
+    std::vector<std::shared_ptr<cv::VideoCapture>> videos;
+    if (cameras.empty())
     {
-        logger->error("Failed to create video source for {}", sInput);
-        return 1;
+        videos.push_back(create(sInput));
     }
-
-    video->set(cv::CAP_PROP_FRAME_WIDTH, params.videoWidth);
-    video->set(cv::CAP_PROP_FRAME_HEIGHT, params.videoHeight);
-
-    cv::Size size = getSize(*video);
-    if (size.area() == 0)
+    for (const auto& camera : cameras)
     {
-        logger->error("Failed to read a frame from device {}", sInput);
-        return 1;
+        videos.push_back(create(std::to_string(camera)));
     }
 
-    if ((size.width != params.videoWidth) || (size.height != params.videoHeight))
+    cv::Size size;
+    for (auto& video : videos)
     {
-        logger->error(
-            "Failed to read a video frame with requested dimensions, received {}x{} expected {}x{}",
-            size.width,
-            size.height,
-            params.videoWidth,
-            params.videoHeight);
-        return 1;
+        if (!(video && video->isOpened()))
+        {
+            logger->error("Failed to create video source for {}", sInput);
+            return 1;
+        }
+
+        video->set(cv::CAP_PROP_FRAME_WIDTH, params.videoWidth);
+        video->set(cv::CAP_PROP_FRAME_HEIGHT, params.videoHeight);
+
+        size = getSize(*video);
+        if (size.area() == 0)
+        {
+            logger->error("Failed to read a frame from device {}", sInput);
+            return 1;
+        }
+
+        if ((size.width != params.videoWidth) || (size.height != params.videoHeight))
+        {
+            logger->error(
+                "Failed to read a video frame with requested dimensions, received {}x{} expected {}x{}",
+                size.width,
+                size.height,
+                params.videoWidth,
+                params.videoHeight);
+            return 1;
+        }
     }
 
     // :::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -219,22 +266,22 @@ int main(int argc, char** argv)
     const auto tic = std::chrono::high_resolution_clock::now();
     std::size_t index = 0;
 
-    facefilter::Application app;
-    app.loadAsset("drishti_assets", sModels.c_str());
-    app.initDisplay(size.width, size.height);
-    const int cameraRotation = 0; // TODO (???)
-    app.initCamera(size.width, size.height, cameraRotation, params.focalLength);
-
-    std::function<bool()> process = [&]() {
-        cv::Mat image;
-        (*video) >> image;
-
-        if (image.empty())
+    // One pipeline per camera:
+    std::vector<std::unique_ptr<facefilter::Application>> apps;
+    for (std::size_t i = 0; i < videos.size(); i++)
+    {
+        apps.push_back(facefilter::make_unique<facefilter::Application>());
+        apps.back()->loadAsset("drishti_assets", sModels.c_str());
+        apps.back()->initDisplay(size.width, size.height);
+        const int cameraRotation = 0; // desktop captures and videos are delivered upright
+        apps.back()->initCamera(size.width, size.height, cameraRotation, params.focalLength);
+        if (doDecoupled)
         {
-            logger->error("Unable to read image {}", sInput);
-            return false;
+            apps.back()->setFramePacing(facefilter::Renderer::kDecoupled, trackingRate);
         }
+    }
 
+    auto draw = [&](facefilter::Application& app, cv::Mat& image, double timestamp) {
         //  cv::imwrite("c:/tmp/frame.png", image); // 1920 / fx =  26 / 20; fx = 1920 * 20/26
 
         if (size.area() && (size != image.size()))
@@ -242,18 +289,13 @@ int main(int argc, char** argv)
             logger->error("Frame dimensions must be consistent: {}{}", size.width, size.height);
         }
 
-        if (image.channels() == 3)
-        {
-            cv::cvtColor(image, image, cv::COLOR_BGR2BGRA);
-        }
-
         if (doPreview)
         { // Update window properties (if used):
             auto& win = glContext->getGeometry();
             app.setPreviewGeometry(win.tx, win.ty, win.sx, win.sy);
         }
 
-        app.drawFrame(image.ptr(), true, DFLT_TEXTURE_FORMAT);
+        app.drawFrame(image.ptr(), true, DFLT_TEXTURE_FORMAT, timestamp);
 
         { // Comnpute simple/global FPS
             const auto toc = std::chrono::high_resolution_clock::now();
@@ -261,13 +303,65 @@ int main(int argc, char** argv)
             const double fps = static_cast<double>(index + 1) / elapsed;
             logger->info("Frame: {} fps = {}", index++, fps);
         }
+    };
 
+    // Cameras: process the freshest frame of each camera without blocking on capture.  The
+    // preview shows camera 0, which is drawn last:
+    std::unique_ptr<CaptureGroup> capture;
+    if (!cameras.empty())
+    {
+        capture = facefilter::make_unique<CaptureGroup>(videos);
+    }
+
+    std::function<bool()> process = [&]() {
+        if (capture)
+        {
+            capture->wait(std::chrono::milliseconds(100));
+
+            bool isRunning = false;
+            for (std::size_t i = capture->size(); i-- > 0;)
+            {
+                if (const auto* frame = capture->latest(i))
+                {
+                    cv::Mat image = frame->image; // valid until the next latest(i) call
+                    draw(*apps[i], image, frame->timestamp);
+                }
+                isRunning |= capture->isRunning(i);
+            }
+
+            if (!isRunning)
+            {
+                logger->error("Unable to read image {}", sInput);
+                return false;
+            }
+            return true;
+        }
+
+        cv::Mat image;
+        (*videos.front()) >> image;
+
+        if (image.empty())
+        {
+            logger->error("Unable to read image {}", sInput);
+            return false;
+        }
+
+        if (image.channels() == 3)
+        {
+            cv::cvtColor(image, image, cv::COLOR_BGR2BGRA);
+        }
+
+        draw(*apps.front(), image, -1.0);
         return true;
     };
 
     (*glContext)(process);
 
-    app.destroy();
+    capture.reset(); // join the capture threads
+    for (auto& app : apps)
+    {
+        app->destroy();
+    }
 
     return 0;
 }
@@ -306,6 +400,22 @@ static std::shared_ptr<cv::VideoCapture> create(const std::string& filename)
     }
 }
 
+// Device indices for "0" or "0,1,..." (empty for other inputs):
+static std::vector<int> getCameras(const std::string& input)
+{
+    std::vector<int> cameras;
+    std::stringstream ss(input);
+    for (std::string token; std::getline(ss, token, ',');)
+    {
+        if (token.empty() || (token.find_first_not_of("0123456789") != std::string::npos))
+        {
+            return {};
+        }
+        cameras.push_back(std::stoi(token));
+    }
+    return cameras;
+}
+
 static cv::Size getSize(const cv::VideoCapture& video)
 {
     return {
@@ -121,6 +121,12 @@ class FaceFilterViewController: GLKViewController, AVCaptureVideoDataOutputSampl
     private var _session: AVCaptureSession!
     private var _videoTextureCache: CVOpenGLESTextureCache?
 
+    // Camera frames are passed to the renderer as pixel buffers, which maps the Y and CbCr
+    // planes in place (FaceFilterRender_drawPixelBuffer), otherwise they are converted to
+    // an RGBA texture here first:
+    private let _useZeroCopyInput = true
+    private var _pixelBuffer: CVPixelBuffer?
+
     private var _cameraRotation: Int32 = 90
     private var _cameraFocalLength: Float = 0.0
 
@@ -234,6 +240,8 @@ class FaceFilterViewController: GLKViewController, AVCaptureVideoDataOutputSampl
         // void * classPtr, void(*callback)(void *)
         FaceFilterRender_registerCallback(rawSelf, simpleCallback)
 
+        FaceFilterRender_setGLContext(bridge(_context))
+
         FaceFilterRender_cameraCreated(_videoDimensions.width, _videoDimensions.height, _cameraRotation, _cameraFocalLength)
 
         do
@@ -304,6 +312,13 @@ class FaceFilterViewController: GLKViewController, AVCaptureVideoDataOutputSampl
 
         let pixelBuffer = CMSampleBufferGetImageBuffer(sampleBuffer)!
 
+        if _useZeroCopyInput
+        {
+            _pixelBuffer = pixelBuffer
+            _hasFrame = true
+            return
+        }
+
         checkGLError()
 
         guard let videoTextureCache = _videoTextureCache else
@@ -640,7 +655,14 @@ class FaceFilterViewController: GLKViewController, AVCaptureVideoDataOutputSampl
         if _hasFrame
         {
             // NSLog("Running on %@ thread", Thread.current)
-            FaceFilterRender_drawFrame(_textureOutput)
+            if let pixelBuffer = _pixelBuffer
+            {
+                FaceFilterRender_drawPixelBuffer(Unmanaged.passUnretained(pixelBuffer).toOpaque())
+            }
+            else
+            {
+                FaceFilterRender_drawFrame(_textureOutput)
+            }
         }
     }
  
@@ -31,14 +31,26 @@ Java_com_elucideye_facefilter_FaceFilterRenderer_loadAsset(JNIEnv* env, jobject
     LOGI("setAssets w/ %s %s", name_, path_);
 
     g_app.loadAsset(name_, path_);
+
+    env->ReleaseStringUTFChars(name, name_);
+    env->ReleaseStringUTFChars(path, path_);
 }
 
-extern "C" JNIEXPORT void JNICALL
+extern "C" JNIEXPORT jint JNICALL
 Java_com_elucideye_facefilter_FaceFilterRenderer_drawFrame(JNIEnv* env, jobject thiz, jint texture)
 {
-    LOGI("drawFrame %d", texture);
-
     g_app.drawFrame(texture);
+
+    return g_app.getResults().count();
+}
+
+// The face results are exchanged through one direct buffer over the native storage (see
+// facefilter::FaceResults for the float layout), which is updated in place by drawFrame():
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_elucideye_facefilter_FaceFilterRenderer_getResultsBuffer(JNIEnv* env, jobject thiz)
+{
+    auto& results = g_app.getResults();
+    return env->NewDirectByteBuffer(results.data(), static_cast<jlong>(results.size() * sizeof(float)));
 }
 
 extern "C" JNIEXPORT void JNICALL
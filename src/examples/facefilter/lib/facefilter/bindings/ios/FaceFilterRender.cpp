@@ -9,12 +9,89 @@
 #include <facefilter/renderer/Context.h>
 #include <facefilter/renderer/Renderer.h>
 #include <facefilter/renderer/facefilter_renderer.h>
+#include <facefilter/make_unique.h>
+
+#include <ogles_gpgpu/platform/opengl/gl_includes.h>
+
+#include <CoreVideo/CoreVideo.h>
 
 #include <iostream>
 #include <memory>
 
 facefilter::Application g_app;
 
+// Camera frames are mapped through a CVOpenGLESTextureCache: the Y and CbCr planes of the
+// IOSurface backed pixel buffer are used as GL textures in place (no CPU copy), and the
+// tracker converts them to RGBA in its first GPU pass (see VideoFrame::nv12()).
+class PixelBufferTextures
+{
+public:
+    PixelBufferTextures() = default;
+    ~PixelBufferTextures()
+    {
+        release();
+        if (m_cache)
+        {
+            CFRelease(m_cache);
+        }
+    }
+
+    PixelBufferTextures(const PixelBufferTextures&) = delete;
+    PixelBufferTextures& operator=(const PixelBufferTextures&) = delete;
+
+    bool map(CVPixelBufferRef pixelBuffer, void* context)
+    {
+        if (!m_cache && (CVOpenGLESTextureCacheCreate(kCFAllocatorDefault, nullptr, static_cast<CVEAGLContext>(context), nullptr, &m_cache) != kCVReturnSuccess))
+        {
+            return false;
+        }
+
+        // Textures of the previous frame are returned to the cache:
+        release();
+        CVOpenGLESTextureCacheFlush(m_cache, 0);
+
+        const GLenum formats[2] = { GL_LUMINANCE, GL_LUMINANCE_ALPHA };
+        for (int i = 0; i < 2; i++)
+        {
+            const auto width = static_cast<GLsizei>(CVPixelBufferGetWidthOfPlane(pixelBuffer, i));
+            const auto height = static_cast<GLsizei>(CVPixelBufferGetHeightOfPlane(pixelBuffer, i));
+            if (CVOpenGLESTextureCacheCreateTextureFromImage(kCFAllocatorDefault, m_cache, pixelBuffer, nullptr, GL_TEXTURE_2D, formats[i], width, height, formats[i], GL_UNSIGNED_BYTE, i, &m_textures[i]) != kCVReturnSuccess)
+            {
+                return false;
+            }
+
+            glBindTexture(CVOpenGLESTextureGetTarget(m_textures[i]), CVOpenGLESTextureGetName(m_textures[i]));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return true;
+    }
+
+    GLuint getLuma() const { return CVOpenGLESTextureGetName(m_textures[0]); }
+    GLuint getChroma() const { return CVOpenGLESTextureGetName(m_textures[1]); }
+
+protected:
+    void release()
+    {
+        for (auto& texture : m_textures)
+        {
+            if (texture)
+            {
+                CFRelease(texture);
+                texture = nullptr;
+            }
+        }
+    }
+
+    CVOpenGLESTextureCacheRef m_cache = nullptr;
+    CVOpenGLESTextureRef m_textures[2] = { nullptr, nullptr };
+};
+
+static std::unique_ptr<PixelBufferTextures> g_textures;
+
 #ifdef __cplusplus
 FACEFILTER_EXTERN_C_BEGIN
 #endif
@@ -29,6 +106,19 @@ void FaceFilterRender_drawFrame(uint32_t texture)
     g_app.drawFrame(texture);
 }
 
+void FaceFilterRender_drawPixelBuffer(void* pixelBuffer)
+{
+    if (!g_textures)
+    {
+        g_textures = facefilter::make_unique<PixelBufferTextures>();
+    }
+
+    if (g_textures->map(static_cast<CVPixelBufferRef>(pixelBuffer), g_app.getGLContext()))
+    {
+        g_app.drawFrame(g_textures->getLuma(), g_textures->getChroma());
+    }
+}
+
 void FaceFilterRender_surfaceChanged(int width, int height)
 {
     g_app.initDisplay(width, height);
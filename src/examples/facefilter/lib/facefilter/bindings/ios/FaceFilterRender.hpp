@@ -11,6 +11,7 @@ FACEFILTER_EXTERN_C_BEGIN
 
 void FaceFilterRender_loadAsset(const char* key, const char* url);
 void FaceFilterRender_drawFrame(uint32_t texture);
+void FaceFilterRender_drawPixelBuffer(void* pixelBuffer); // CVPixelBufferRef (420YpCbCr8BiPlanarFullRange)
 void FaceFilterRender_surfaceChanged(int width, int height);
 void FaceFilterRender_surfaceCreated(int width, int height);
 void FaceFilterRender_cameraCreated(int width, int height, int rotation, float focalLength);
@@ -55,6 +55,11 @@ const std::string& Application::getAsset(const char* key)
     return m_assets;
 }
 
+FaceResults& Application::getResults()
+{
+    return m_results;
+}
+
 void Application::setAssetManager(void* assetManager)
 {
     m_assetManager = assetManager;
@@ -80,6 +85,10 @@ void Application::initContext(void* context)
 
 void Application::drawFrame(std::uint32_t texId)
 {
+    if (m_framePacing == Renderer::kLockstep)
+    {
+        m_results.clear(); // decoupled results are extrapolated between tracking results
+    }
     if (m_renderer)
     {
         m_renderer->setTexture(texId);
@@ -87,7 +96,20 @@ void Application::drawFrame(std::uint32_t texId)
     }
 }
 
-void Application::drawFrame(void* ptr, bool useRawPixels, std::uint32_t type)
+void Application::drawFrame(std::uint32_t lumaTexId, std::uint32_t chromaTexId)
+{
+    if (m_framePacing == Renderer::kLockstep)
+    {
+        m_results.clear();
+    }
+    if (m_renderer)
+    {
+        m_renderer->setTextures(lumaTexId, chromaTexId);
+        m_renderer->render();
+    }
+}
+
+void Application::drawFrame(void* ptr, bool useRawPixels, std::uint32_t type, double timestamp)
 {
     if (!m_video)
     {
@@ -98,6 +120,10 @@ void Application::drawFrame(void* ptr, bool useRawPixels, std::uint32_t type)
     }
     (*m_video)({ { m_cameraWidth, m_cameraHeight }, ptr, false, 0, type });
 
+    if (m_renderer)
+    {
+        m_renderer->setTimestamp(timestamp);
+    }
     drawFrame(m_gray->getOutputTexId());
 }
 
@@ -175,6 +201,8 @@ void Application::initPipeline()
         {
             m_renderer->registerSetDisplayBufferCallback(setDisplayBufferCallback);
         }
+
+        m_renderer->setFramePacing(m_framePacing, m_trackingRate);
     }
 }
 
@@ -183,6 +211,21 @@ void Application::setGLContext(void* context)
     m_context = context;
 }
 
+void* Application::getGLContext()
+{
+    return m_context;
+}
+
+void Application::setFramePacing(Renderer::FramePacing pacing, float trackingRate)
+{
+    m_framePacing = pacing;
+    m_trackingRate = trackingRate;
+    if (m_renderer)
+    {
+        m_renderer->setFramePacing(pacing, trackingRate);
+    }
+}
+
 // Note: This must come after initPipeline (obviously)
 void Application::registerSetDisplayBufferCallback(const std::function<void()>& callback)
 {
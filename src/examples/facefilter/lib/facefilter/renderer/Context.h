@@ -11,6 +11,7 @@
 
 #include <facefilter/facefilter.h>
 #include <facefilter/renderer/Renderer.h>
+#include <facefilter/renderer/FaceResults.h>
 
 #include <memory>
 #include <functional>
@@ -46,20 +47,28 @@ public:
     void setAssetManager(void* assetManager);
     void loadAsset(const char* key, const char* filename);
     void drawFrame(std::uint32_t texId);
-    void drawFrame(void* ptr, bool useRawPixels, std::uint32_t type);
+    void drawFrame(void* ptr, bool useRawPixels, std::uint32_t type, double timestamp = -1.0);
+    void drawFrame(std::uint32_t lumaTexId, std::uint32_t chromaTexId); // NV12 planes
     void initContext(void* context);
     void initCamera(int width, int height, int rotation, float focalLength);
     void initDisplay(int width, int height);
     void setPreviewGeometry(float tx, float ty, float sx, float sy);
     void destroy();
     void setGLContext(void* context);
+    void* getGLContext();
     void registerSetDisplayBufferCallback(const std::function<void()>& callback);
 
+    // See Renderer::FramePacing (can be set before the pipeline is created):
+    void setFramePacing(Renderer::FramePacing pacing, float trackingRate = 0.f);
+
     std::shared_ptr<spdlog::logger>& getLogger();
 
     const std::string& getAsset(const char* key = "drishti_assets");
     void* getAssetManager();
 
+    // Faces of the last drawFrame() call (stable storage, see FaceResults):
+    FaceResults& getResults();
+
 protected:
     void initPipeline();
 
@@ -80,6 +89,11 @@ protected:
 
     std::string m_assets;
 
+    Renderer::FramePacing m_framePacing = Renderer::kLockstep;
+    float m_trackingRate = 0.f;
+
+    FaceResults m_results;
+
 #if defined(__ANDROID__)
     JNIEnv* m_JNIEnv{nullptr};
     jobject m_jobject;
@@ -0,0 +1,146 @@
+/*! -*-c++-*-
+  @file  FaceResults.cpp
+  @brief Implementation of a preallocated flat face result buffer for language bindings.
+
+  \copyright Copyright 2017-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+*/
+
+#include <facefilter/renderer/FaceResults.h>
+
+#include <algorithm>
+#include <chrono>
+
+BEGIN_FACEFILTER_NAMESPACE
+
+static float* write(float* dst, const drishti::sdk::Recti& roi)
+{
+    *dst++ = static_cast<float>(roi.x);
+    *dst++ = static_cast<float>(roi.y);
+    *dst++ = static_cast<float>(roi.width);
+    *dst++ = static_cast<float>(roi.height);
+    return dst;
+}
+
+static float* write(float* dst, const drishti::sdk::Eye::Ellipse& e)
+{
+    *dst++ = e.center[0];
+    *dst++ = e.center[1];
+    *dst++ = e.size.width;
+    *dst++ = e.size.height;
+    *dst++ = e.angle;
+    return dst;
+}
+
+static void write(float* dst, const drishti::sdk::Eye& eye)
+{
+    write(dst + FaceResults::kEyeRoi, eye.getRoi());
+    write(dst + FaceResults::kEyeIris, eye.getIris());
+    write(dst + FaceResults::kEyePupil, eye.getPupil());
+    std::copy_n(&eye.getInnerCorner()[0], 2, dst + FaceResults::kEyeInner);
+    std::copy_n(&eye.getOuterCorner()[0], 2, dst + FaceResults::kEyeOuter);
+}
+
+FaceResults::FaceResults()
+    : m_data(kHeaderSize + kMaxFaces * kFaceSize, 0.f)
+    , m_latest(m_data.size(), 0.f)
+    , m_previous(m_data.size(), 0.f)
+{
+    m_data[kFaceStride] = static_cast<float>(kFaceSize);
+}
+
+void FaceResults::update(const drishti_face_tracker_result_t& result, double timestamp)
+{
+    if (m_start < 0.0)
+    {
+        m_start = timestamp;
+    }
+
+    const auto& faces = result.faceModels;
+    const int count = std::min(static_cast<int>(faces.size()), static_cast<int>(kMaxFaces));
+
+    m_data[kCount] = static_cast<float>(count);
+    m_data[kFrame] = static_cast<float>(m_frame++ & 0xffffff);
+    m_data[kTime] = static_cast<float>(timestamp - m_start);
+
+    for (int i = 0; i < count; i++)
+    {
+        const auto& face = faces[i];
+        float* dst = m_data.data() + kHeaderSize + i * kFaceSize;
+
+        write(dst + kFaceRoi, face.roi);
+        std::copy_n(&face.position[0], 3, dst + kFacePosition);
+
+        dst[kFaceGazeCount] = static_cast<float>(face.gaze.size());
+        for (int j = 0; j < static_cast<int>(face.gaze.size()); j++)
+        {
+            std::copy_n(&face.gaze[j][0], 3, dst + kFaceGaze + j * 3);
+        }
+
+        for (int j = 0; j < std::min(static_cast<int>(face.eyes.size()), 2); j++)
+        {
+            write(dst + kFaceEyes + j * kEyeSize, face.eyes[j]);
+        }
+
+        const int landmarks = std::min(static_cast<int>(face.landmarks.size()), static_cast<int>(kMaxLandmarks));
+        dst[kFaceLandmarkCount] = static_cast<float>(landmarks);
+        for (int j = 0; j < landmarks; j++)
+        {
+            std::copy_n(&face.landmarks[j][0], 2, dst + kFaceLandmarks + j * 2);
+        }
+    }
+
+    m_previous.swap(m_latest);
+    std::copy(m_data.begin(), m_data.end(), m_latest.begin());
+    m_previousTime = m_latestTime;
+    m_latestTime = timestamp;
+    m_arrival = now();
+}
+
+void FaceResults::predict(double time, double horizon)
+{
+    if (m_latestTime < 0.0)
+    {
+        return;
+    }
+
+    std::copy(m_latest.begin(), m_latest.end(), m_data.begin());
+
+    const double interval = m_latestTime - m_previousTime;
+    const double ahead = std::min(std::max(time - m_arrival, 0.0), horizon);
+    if ((m_previousTime < 0.0) || (interval <= 0.0) || (ahead <= 0.0))
+    {
+        return;
+    }
+
+    // Faces are matched by index, and only faces with the same layout in both results move:
+    const auto alpha = static_cast<float>(ahead / interval);
+    const int count = static_cast<int>(std::min(m_latest[kCount], m_previous[kCount]));
+    for (int i = 0; i < count; i++)
+    {
+        const std::size_t offset = kHeaderSize + i * kFaceSize;
+        const float* latest = m_latest.data() + offset;
+        const float* previous = m_previous.data() + offset;
+        if ((latest[kFaceGazeCount] != previous[kFaceGazeCount]) || (latest[kFaceLandmarkCount] != previous[kFaceLandmarkCount]))
+        {
+            continue;
+        }
+
+        float* dst = m_data.data() + offset;
+        for (int j = 0; j < kFaceSize; j++)
+        {
+            if ((j != kFaceGazeCount) && (j != kFaceLandmarkCount))
+            {
+                dst[j] = latest[j] + (latest[j] - previous[j]) * alpha;
+            }
+        }
+    }
+}
+
+double FaceResults::now()
+{
+    const auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::duration<double>>(time).count();
+}
+
+END_FACEFILTER_NAMESPACE
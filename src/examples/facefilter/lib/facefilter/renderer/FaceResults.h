@@ -0,0 +1,95 @@
+/*! -*-c++-*-
+  @file  FaceResults.h
+  @brief Declaration of a preallocated flat face result buffer for language bindings.
+
+  \copyright Copyright 2017-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Face tracker results are written once per frame into a fixed float array that is
+  allocated up front, so bindings can share it without per frame allocations (e.g.,
+  a direct java.nio.ByteBuffer on Android).  The layout is described by the offsets
+  below (in floats), and must be mirrored by the consumer.
+
+  When tracking runs at a lower rate than the display (see Renderer::kDecoupled), predict()
+  extrapolates the geometry of the last two results with a constant velocity, so overlays
+  drawn from the buffer move smoothly between tracking results.
+*/
+
+#ifndef __facefilter_renderer_FaceResults_h__
+#define __facefilter_renderer_FaceResults_h__
+
+#include <facefilter/facefilter.h>
+#include <drishti/FaceTracker.hpp>
+
+#include <cstdint>
+#include <vector>
+
+BEGIN_FACEFILTER_NAMESPACE
+
+class FaceResults
+{
+public:
+    enum Layout
+    {
+        // Header:
+        kCount = 0,      // number of valid faces
+        kFrame = 1,      // frame counter (modulo 2^24)
+        kTime = 2,       // seconds since the first frame
+        kFaceStride = 3, // kFaceSize
+        kHeaderSize = 4,
+
+        // Eye (relative to the eye start):
+        kEyeRoi = 0,      // x, y, width, height
+        kEyeIris = 4,     // cx, cy, width, height, angle
+        kEyePupil = 9,    // cx, cy, width, height, angle
+        kEyeInner = 14,   // x, y
+        kEyeOuter = 16,   // x, y
+        kEyeSize = 18,
+
+        // Face (relative to the face start):
+        kFaceRoi = 0,                     // x, y, width, height
+        kFacePosition = 4,                // x, y, z (meters)
+        kFaceGazeCount = 7,               // 0 or 2
+        kFaceGaze = 8,                    // right xyz, left xyz
+        kFaceEyes = 14,                   // right, left eye
+        kFaceLandmarkCount = 14 + 2 * 18, // number of valid landmarks
+        kFaceLandmarks = kFaceLandmarkCount + 1,
+        kMaxLandmarks = 128,
+        kFaceSize = kFaceLandmarks + 2 * kMaxLandmarks,
+
+        kMaxFaces = 2
+    };
+
+    FaceResults();
+
+    void update(const drishti_face_tracker_result_t& result, double timestamp);
+    void clear() { m_data[kCount] = 0.f; }
+
+    // Rewrite the buffer with the latest result extrapolated to time (see now()), for at most
+    // horizon seconds after the result arrived:
+    void predict(double time, double horizon = 0.1);
+
+    // Results received since construction:
+    std::uint32_t frames() const { return m_frame; }
+
+    // Steady clock time in seconds:
+    static double now();
+
+    float* data() { return m_data.data(); }
+    std::size_t size() const { return m_data.size(); } // floats
+    int count() const { return static_cast<int>(m_data[kCount]); }
+
+protected:
+    std::vector<float> m_data; // never reallocated
+    std::uint32_t m_frame = 0;
+    double m_start = -1.0;
+
+    // The last two results for predict(), with their timestamps and the latest arrival time:
+    std::vector<float> m_latest, m_previous;
+    double m_latestTime = -1.0, m_previousTime = -1.0;
+    double m_arrival = -1.0;
+};
+
+END_FACEFILTER_NAMESPACE
+
+#endif // __facefilter_renderer_FaceResults_h__
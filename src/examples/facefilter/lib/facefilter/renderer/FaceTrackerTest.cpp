@@ -27,6 +27,8 @@ struct FaceTrackTest::Impl
     ~Impl() = default;
 
     // CUSTOM user fields
+
+    FaceResults* results = nullptr;
 };
 
 // See: https://github.com/elucideye/drishti/blob/master/src/lib/drishti/drishti/ut/test-FaceTracker.cpp
@@ -37,6 +39,11 @@ FaceTrackTest::FaceTrackTest(std::shared_ptr<spdlog::logger>& logger, const std:
 
 FaceTrackTest::~FaceTrackTest() = default;
 
+void FaceTrackTest::setResults(FaceResults* results)
+{
+    m_impl->results = results;
+}
+
 int FaceTrackTest::callback(drishti_face_tracker_results_t& results)
 {
     //m_impl->logger->info("callback: Received results");
@@ -56,6 +63,11 @@ FaceTrackTest::trigger(const drishti_face_tracker_result_t& faces, double timest
     //m_impl->logger->info("trigger: Received results at time {}}", timestamp);
 
     // User provided face monitor would go here.
+
+    if (m_impl->results)
+    {
+        m_impl->results->update(faces, timestamp);
+    }
     
     return // formulate a frame request based on input faces
     {
@@ -10,6 +10,7 @@
 #define __facefilter_renderer_FaceTrackerTest_h__
 
 #include <facefilter/facefilter.h>
+#include <facefilter/renderer/FaceResults.h>
 #include <drishti/FaceTracker.hpp>
 #include <drishti/drishti_cv.hpp>
 
@@ -50,6 +51,9 @@ public:
     static drishti_request_t triggerFunc(void* context, const drishti_face_tracker_result_t& faces, double timestamp, std::uint32_t tex);
     // }
 
+    // Publish the per frame face models to a shared (preallocated) buffer:
+    void setResults(FaceResults* results);
+
     // Define the public callback table:
     drishti_face_tracker_t table{
         this,
@@ -10,6 +10,7 @@
 #include <facefilter/renderer/FaceTrackerTest.h>
 #include <facefilter/renderer/FaceTrackerFactoryJson.h>
 #include <facefilter/renderer/Context.h> // Application
+#include <facefilter/renderer/FaceResults.h>
 #include <facefilter/renderer/fill.h> // fill mode logic
 #include <facefilter/make_unique.h>
 
@@ -95,6 +96,7 @@ struct Renderer::Impl
         );
 
         m_callbacks = facefilter::make_unique<FaceTrackTest>(getLogger(), "/tmp"); // path?
+        m_callbacks->setResults(&m_Application.getResults());
 
         // Configure the face tracker parameters:
         drishti::sdk::Vec2f p(frameSize.width / 2, frameSize.height / 2);
@@ -117,6 +119,9 @@ struct Renderer::Impl
         context.setDoOptimizedPipeline(true);                // configure optimized pipeline
         context.setGLContext(glContext);
 
+        // NV12 camera planes are converted by the tracker in the camera orientation (see render()):
+        context.setOrientationCallback([this]() { return chromaTexId ? rotation : 0; });
+
         m_tracker = facefilter::make_unique<drishti::sdk::FaceTracker>(&context, m_factory->factory);
         if (!m_tracker)
         {
@@ -129,16 +134,91 @@ struct Renderer::Impl
 
     void render()
     {
-        gray.process(texId, 1, inputTextureTarget);
+        const double now = FaceResults::now();
+        updateRates(now);
 
-        if(m_tracker)
+        if (!m_tracker)
+        {
+            gray.process(texId, 1, inputTextureTarget); // display is chained
+            return;
+        }
+
+        const double frameTimestamp = getTimestamp();
+        if (isTrackingDue(now))
+        {
+            drishti::sdk::VideoFrame frame;
+            if (chromaTexId)
+            {
+                // Camera planes are used in place, the tracker makes the frame upright:
+                frame = drishti::sdk::VideoFrame::nv12({ frameSize.width, frameSize.height }, texId, chromaTexId);
+            }
+            else
+            {
+                gray.process(texId, 1, inputTextureTarget);
+                frame = drishti::sdk::VideoFrame({frameSize.width,frameSize.height}, nullptr, false, gray.getOutputTexId(), TEXTURE_FORMAT);
+            }
+            frame.timestamp = frameTimestamp;
+            outputTex = (*m_tracker)(frame);
+            lastTracked = now;
+        }
+
+        if (pacing == Renderer::kDecoupled)
+        {
+            m_Application.getResults().predict(now);
+        }
+        disp.process(outputTex, 1, GL_TEXTURE_2D);
+    }
+
+    // Decoupled frames are submitted at most at trackingRate, and the tracker skips frames
+    // while its CPU stages are busy (kDropNewest), returning the latest completed output:
+    bool isTrackingDue(double now) const
+    {
+        return (pacing == Renderer::kLockstep) || !outputTex || (trackingRate <= 0.f) || ((now - lastTracked) >= (1.0 / trackingRate));
+    }
+
+    void setFramePacing(Renderer::FramePacing value, float rate)
+    {
+        pacing = value;
+        trackingRate = rate;
+        if (m_tracker)
+        {
+            using FaceTracker = drishti::sdk::FaceTracker;
+            m_tracker->setBackpressure((pacing == Renderer::kDecoupled) ? FaceTracker::kDropNewest : FaceTracker::kBlock);
+        }
+    }
+
+    // Achieved display and tracking (result) rates, updated and logged once per second:
+    void updateRates(double now)
+    {
+        const auto results = m_Application.getResults().frames();
+        if (rateStart < 0.0)
         {
-            drishti::sdk::VideoFrame frame({frameSize.width,frameSize.height}, nullptr, false, gray.getOutputTexId(), TEXTURE_FORMAT);
-            auto outputTex = (*m_tracker)(frame);
-            disp.process(outputTex, 1, GL_TEXTURE_2D);
+            rateStart = now;
+            rateResults = results;
+        }
+
+        displayFrames++;
+        const double elapsed = now - rateStart;
+        if (elapsed >= 1.0)
+        {
+            rates.display = static_cast<float>(displayFrames / elapsed);
+            rates.tracking = static_cast<float>((results - rateResults) / elapsed);
+            getLogger()->info("display: {} fps tracking: {} fps", rates.display, rates.tracking);
+
+            rateStart = now;
+            rateResults = results;
+            displayFrames = 0;
         }
     }
 
+    // The timestamp applies to one frame:
+    double getTimestamp()
+    {
+        const double result = timestamp;
+        timestamp = -1.0;
+        return result;
+    }
+
     void setPreviewGeometry(float tx, float ty, float sx, float sy)
     {
         disp.setOffset(tx, ty);
@@ -159,10 +239,23 @@ struct Renderer::Impl
     int rotation = 0;
     cv::Size displaySize;
     std::uint32_t texId = 999;
+    std::uint32_t chromaTexId = 0; // NV12 input (texId is the luma plane)
+    double timestamp = -1.0;
     GLenum inputTextureTarget = GL_TEXTURE_2D;
 
     std::function<void()> setDisplayBuffer;
 
+    // Frame pacing:
+    Renderer::FramePacing pacing = Renderer::kLockstep;
+    float trackingRate = 0.f;
+    double lastTracked = -1.0;
+    GLuint outputTex = 0; // latest tracker output
+
+    Renderer::Rates rates;
+    double rateStart = -1.0;
+    std::uint32_t rateResults = 0;
+    int displayFrames = 0;
+
     ogles_gpgpu::GrayscaleProc gray;
     ogles_gpgpu::Disp disp;
 
@@ -216,6 +309,16 @@ void Renderer::setTexture(std::uint32_t texId)
     if(m_impl)
     {
         m_impl->texId = texId;
+        m_impl->chromaTexId = 0;
+    }
+}
+
+void Renderer::setTextures(std::uint32_t lumaTexId, std::uint32_t chromaTexId)
+{
+    if(m_impl)
+    {
+        m_impl->texId = lumaTexId;
+        m_impl->chromaTexId = chromaTexId;
     }
 }
 
@@ -227,6 +330,32 @@ void Renderer::setInputTextureTarget(GLenum textureTaret)
     }
 }
 
+void Renderer::setTimestamp(double timestamp)
+{
+    if(m_impl)
+    {
+        m_impl->timestamp = timestamp;
+    }
+}
+
+void Renderer::setFramePacing(FramePacing pacing, float trackingRate)
+{
+    if(m_impl)
+    {
+        m_impl->setFramePacing(pacing, trackingRate);
+    }
+}
+
+Renderer::FramePacing Renderer::getFramePacing() const
+{
+    return m_impl ? m_impl->pacing : kLockstep;
+}
+
+Renderer::Rates Renderer::getRates() const
+{
+    return m_impl ? m_impl->rates : Rates();
+}
+
 void Renderer::registerSetDisplayBufferCallback(const std::function<void()> &callback)
 {
     if(m_impl)
@@ -24,6 +24,23 @@ struct Application;
 class Renderer
 {
 public:
+    // kLockstep tracks every frame before it is displayed (lowest latency, but a slow tracking
+    // frame delays the display).  kDecoupled displays every frame with the latest completed
+    // tracker output and results extrapolated to the display time (see FaceResults::predict()),
+    // and the tracker skips frames while it is busy, so it runs at its sustainable rate:
+    enum FramePacing
+    {
+        kLockstep,
+        kDecoupled
+    };
+
+    // Achieved rates in frames per second (updated once per second):
+    struct Rates
+    {
+        float display = 0.f;
+        float tracking = 0.f; // tracking results
+    };
+
     Renderer(
         void* glContext,
         const cv::Size& frameSize,
@@ -43,9 +60,21 @@ public:
     void setPreviewGeometry(float tx, float ty, float sx, float sy);
     void render();
     void setTexture(std::uint32_t texId);
+
+    // Two plane YUV 4:2:0 (NV12) camera frame: GL_LUMINANCE Y and GL_LUMINANCE_ALPHA CbCr
+    // textures in the camera orientation (e.g., mapped with CVOpenGLESTextureCache):
+    void setTextures(std::uint32_t lumaTexId, std::uint32_t chromaTexId);
     void setInputTextureTarget(GLenum textureTaret);
+
+    // Capture time of the next frame in seconds on a monotonic clock (see VideoFrame::timestamp):
+    void setTimestamp(double timestamp);
     void registerSetDisplayBufferCallback(const std::function<void()>& callback);
 
+    // The tracking rate is an upper bound for kDecoupled (0 == as fast as the tracker runs):
+    void setFramePacing(FramePacing pacing, float trackingRate = 0.f);
+    FramePacing getFramePacing() const;
+    Rates getRates() const;
+
 protected:
     struct Impl;
     std::shared_ptr<Impl> m_impl;
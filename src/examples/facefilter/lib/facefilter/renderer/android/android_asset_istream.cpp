@@ -24,6 +24,9 @@
 #include <cassert>
 #include "facefilter/renderer/android/android_asset_istream.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 BEGIN_NAMESPACE_ANDROID
 BEGIN_NAMESPACE_INTERNAL
 
@@ -120,104 +123,87 @@ private:
     std::vector<char> buffer;
 };
 
-struct map_asset_istreambuf : public std::streambuf
+// Reads a contiguous read only region in place (a memory mapped asset or an asset buffer):
+// the region is the get area, so bulk reads are a single memcpy into the destination.
+struct memory_asset_istreambuf : public std::streambuf
 {
-
-    map_asset_istreambuf(asset_type&& asset, const char* start, size_t size)
-        : asset(std::forward<asset_type>(asset))
-        , start(start)
-        , end(start + size)
-        , current(start)
+    memory_asset_istreambuf(std::shared_ptr<const void> owner, const char* start, size_t size)
+        : owner(std::move(owner))
     {
+        char* const begin = const_cast<char*>(start); // never written (no put area)
+        setg(begin, begin, begin + size);
     }
 
-    virtual ~map_asset_istreambuf() {}
+    virtual ~memory_asset_istreambuf() {}
 
-    // https://stackoverflow.com/a/46069245
     std::streampos seekoff(std::streamoff off,
         std::ios_base::seekdir way, std::ios_base::openmode which) override
     {
-        if (way == std::ios_base::cur)
-            current = current + off;
-        else if (way == std::ios_base::end)
-            current = end + off;
-        else if (way == std::ios_base::beg)
-            current = start + off;
-        return (current - start);
-    }
-
-    // https://stackoverflow.com/a/46069245
-    std::streampos seekpos(std::streampos sp, std::ios_base::openmode which) override
-    {
-        return seekoff(sp - pos_type(off_type(0)), std::ios_base::beg, which);
-    }
-
-    int sync() override
-    {
-        return std::streambuf::sync();
-    }
-
-    /////
-
-    std::streamsize showmanyc() override
-    {
-        return end - current;
-    }
-
-    std::streamsize xsgetn(char* s, std::streamsize n) override
-    {
-        std::streamsize total = 0;
-        while (current != end && n--)
+        char* position = nullptr;
+        switch (way)
+        {
+            case std::ios_base::beg:
+                position = eback() + off;
+                break;
+            case std::ios_base::cur:
+                position = gptr() + off;
+                break;
+            case std::ios_base::end:
+                position = egptr() + off;
+                break;
+            default:
+                break;
+        }
+        if (!(which & std::ios_base::in) || (position < eback()) || (position > egptr()))
         {
-            *s++ = *current++;
-            total++;
+            return std::streampos(std::streamoff(-1));
         }
-        return total;
+        setg(eback(), position, egptr());
+        return std::streampos(position - eback());
     }
 
-    std::streambuf::int_type underflow() override
+    std::streampos seekpos(std::streampos sp, std::ios_base::openmode which) override
     {
-        return current < end
-            ? traits_type::to_int_type(*current)
-            : traits_type::eof();
+        return seekoff(std::streamoff(sp), std::ios_base::beg, which);
     }
 
-    std::streambuf::int_type uflow() override
-    {
-        return current < end
-            ? traits_type::to_int_type(*current++)
-            : traits_type::eof();
-    }
+private:
+    std::shared_ptr<const void> owner; // keeps the mapping (or the asset) alive
+};
 
-    int pbackfail(int ch = EOF) override
+// Uncompressed (stored) assets are mapped directly from the APK: the pages are clean and
+// file backed, so they are shared and can be evicted instead of adding to the heap.
+static std::unique_ptr<std::streambuf> map_asset_istreambuf(AAsset* asset)
+{
+    off64_t offset = 0, length = 0;
+    const int fd = AAsset_openFileDescriptor64(asset, &offset, &length);
+    if (fd < 0)
     {
-        if (current == start || (ch != traits_type::eof() && ch != current[-1]))
-            return traits_type::eof();
-
-        return traits_type::to_int_type(*--current);
+        return nullptr; // compressed
     }
 
-    std::streamsize xsputn(const char_type* s, std::streamsize n) override
-    {
-        return traits_type::eof();
-    };
+    // The mapping must start on a page boundary:
+    const off64_t page = sysconf(_SC_PAGESIZE);
+    const off64_t base = offset - (offset % page);
+    const size_t delta = static_cast<size_t>(offset - base);
+    const size_t size = static_cast<size_t>(length) + delta;
 
-    int_type overflow(std::streambuf::int_type ch) override
+    void* mapped = (length > 0) ? mmap64(nullptr, size, PROT_READ, MAP_SHARED, fd, base) : MAP_FAILED;
+    close(fd); // the mapping holds its own reference
+    if (mapped == MAP_FAILED)
     {
-        return traits_type::eof();
+        return nullptr;
     }
 
-private:
-    asset_type asset;
-    const char *const start, *const end;
-    const char* current;
-};
+    std::shared_ptr<const void> owner(mapped, [size](void* data) { munmap(data, size); });
+    return std::unique_ptr<std::streambuf>(new memory_asset_istreambuf(owner, static_cast<const char*>(mapped) + delta, static_cast<size_t>(length)));
+}
 
 std::unique_ptr<std::streambuf> make_asset_istreambuf(AAssetManager* mgr,
     const char* filename)
 {
     asset_type asset(
-        AAssetManager_open(mgr, filename, AASSET_MODE_STREAMING),
+        AAssetManager_open(mgr, filename, AASSET_MODE_BUFFER),
         &AAsset_close);
     if (!asset.get())
     {
@@ -227,11 +213,24 @@ std::unique_ptr<std::streambuf> make_asset_istreambuf(AAssetManager* mgr,
         //VCC_PRINT("%s", string.c_str());
         throw std::runtime_error(std::move(string));
     }
+
+    // 1) mmap of the APK region (the asset is closed here)
+    if (auto streambuf = map_asset_istreambuf(asset.get()))
+    {
+        return streambuf;
+    }
+
+    // 2) the asset buffer (decompressed once by the asset manager, owned by the asset)
     const char* const buffer((const char*)AAsset_getBuffer(asset.get()));
-    return std::unique_ptr<std::streambuf>(buffer
-            ? (std::streambuf*)new map_asset_istreambuf(std::move(asset), buffer,
-                  AAsset_getLength(asset.get()))
-            : (std::streambuf*)new stream_asset_istreambuf(std::move(asset)));
+    if (buffer)
+    {
+        const size_t size = static_cast<size_t>(AAsset_getLength64(asset.get()));
+        std::shared_ptr<const void> owner(asset.release(), &AAsset_close);
+        return std::unique_ptr<std::streambuf>(new memory_asset_istreambuf(owner, buffer, size));
+    }
+
+    // 3) buffered reads
+    return std::unique_ptr<std::streambuf>(new stream_asset_istreambuf(std::move(asset)));
 }
 
 END_NAMESPACE_INTERNAL
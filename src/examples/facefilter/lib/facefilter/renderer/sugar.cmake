@@ -15,6 +15,7 @@ sugar_files(
     fill.cpp
 
     ### drishti ###
+    FaceResults.cpp
     FaceTrackerFactoryJson.cpp
     FaceTrackerTest.cpp
 )
@@ -26,6 +27,7 @@ sugar_files(
     fill.h
 
     ### drishti ###
+    FaceResults.h
     FaceTrackerFactoryJson.h
     FaceTrackerTest.h
 )
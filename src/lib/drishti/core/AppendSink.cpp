@@ -0,0 +1,392 @@
+/*! -*-c++-*-
+  @file   AppendSink.cpp
+  @author David Hirvonen
+  @brief  Implementation of a single writer, append only output file for batch results.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/AppendSink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+// clang-format off
+#if !defined(_WIN32)
+#  include <unistd.h>
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static const std::size_t kBlock = 512;
+
+// Producers notify without the lock, so a missed wakeup costs at most one interval:
+static const std::chrono::milliseconds kInterval(20);
+
+static void putOctal(char* field, std::size_t size, std::uint64_t value)
+{
+    std::snprintf(field, size, "%0*llo", static_cast<int>(size - 1), static_cast<unsigned long long>(value));
+}
+
+// ustar header, long names are split into prefix + name at a '/' (or truncated):
+static void putTarHeader(std::vector<char>& buffer, const std::string& filename, std::size_t size, std::time_t time)
+{
+    char header[kBlock];
+    std::memset(header, 0, sizeof(header));
+
+    std::string name = filename, prefix;
+    if (name.size() > 100)
+    {
+        const auto pos = name.find('/', name.size() - 100 - 1);
+        if ((pos != std::string::npos) && (pos <= 155))
+        {
+            prefix = name.substr(0, pos);
+            name = name.substr(pos + 1);
+        }
+        else
+        {
+            name = name.substr(name.size() - 100);
+        }
+    }
+
+    std::memcpy(header + 0, name.data(), std::min(name.size(), std::size_t(100)));
+    putOctal(header + 100, 8, 0644);  // mode
+    putOctal(header + 108, 8, 0);     // uid
+    putOctal(header + 116, 8, 0);     // gid
+    putOctal(header + 124, 12, size); // size
+    putOctal(header + 136, 12, static_cast<std::uint64_t>(time));
+    std::memset(header + 148, ' ', 8); // checksum (computed with spaces)
+    header[156] = '0';                 // regular file
+    std::memcpy(header + 257, "ustar", 6);
+    std::memcpy(header + 263, "00", 2);
+    std::memcpy(header + 345, prefix.data(), std::min(prefix.size(), std::size_t(155)));
+
+    unsigned int checksum = 0;
+    for (const auto& c : header)
+    {
+        checksum += static_cast<unsigned char>(c);
+    }
+    std::snprintf(header + 148, 8, "%06o", checksum);
+    header[155] = ' ';
+
+    buffer.insert(buffer.end(), header, header + kBlock);
+}
+
+static std::size_t getFileSize(std::ifstream& is)
+{
+    is.seekg(0, std::ios::end);
+    const auto size = static_cast<std::size_t>(is.tellg());
+    is.seekg(0, std::ios::beg);
+    return size;
+}
+
+// Keep the first size bytes of an existing file:
+static bool truncateFile(const std::string& filename, std::size_t size)
+{
+    std::ifstream is(filename, std::ios::binary);
+    if (!is || (getFileSize(is) == size))
+    {
+        return true; // missing (created on open) or already valid
+    }
+
+#if !defined(_WIN32)
+    is.close();
+    return ::truncate(filename.c_str(), static_cast<off_t>(size)) == 0;
+#else
+    std::vector<char> buffer(size);
+    is.read(buffer.data(), buffer.size());
+    is.close();
+    std::ofstream os(filename, std::ios::binary);
+    os.write(buffer.data(), buffer.size());
+    return os.good();
+#endif
+}
+
+static std::uint64_t getOctal(const char* field, std::size_t size)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; (i < size) && (field[i] >= '0') && (field[i] <= '7'); i++)
+    {
+        value = (value * 8) + static_cast<std::uint64_t>(field[i] - '0');
+    }
+    return value;
+}
+
+AppendSink::AppendSink(const std::string& filename, Format format, bool append)
+    : m_filename(filename)
+    , m_format(format)
+{
+    const std::string marks = filename + ".done";
+    if (append)
+    {
+        // Drop a torn entry or mark (and the end of archive marker) of an interrupted run:
+        if (!truncateFile(filename, getValidSize(filename, format)) || !truncateFile(marks, getValidSize(marks, kLines)))
+        {
+            return;
+        }
+        m_stream.open(filename, std::ios::binary | std::ios::app);
+    }
+    else
+    {
+        std::remove(marks.c_str());
+        m_stream.open(filename, std::ios::binary);
+    }
+
+    if ((m_good = static_cast<bool>(m_stream)))
+    {
+        m_thread = std::thread(&AppendSink::run, this);
+    }
+}
+
+AppendSink::~AppendSink()
+{
+    close();
+}
+
+void AppendSink::push(std::string payload)
+{
+    push({}, std::move(payload));
+}
+
+void AppendSink::push(const std::string& name, std::string payload)
+{
+    if (!m_good)
+    {
+        return;
+    }
+
+    auto* entry = new Entry;
+    entry->name = name;
+    entry->payload = std::move(payload);
+    publish(entry);
+}
+
+void AppendSink::mark(std::string name)
+{
+    if (!m_good)
+    {
+        return;
+    }
+
+    auto* entry = new Entry;
+    entry->name = std::move(name);
+    entry->isMark = true;
+    publish(entry);
+}
+
+void AppendSink::publish(Entry* entry)
+{
+    // The entry belongs to the consumer once published, so don't read entry->next afterwards:
+    Entry* head = m_head.load(std::memory_order_relaxed);
+    do
+    {
+        entry->next = head;
+    } while (!m_head.compare_exchange_weak(head, entry, std::memory_order_release, std::memory_order_relaxed));
+
+    if (head == nullptr)
+    {
+        m_pushed.notify_one(); // first entry of a batch
+    }
+}
+
+void AppendSink::run()
+{
+    while (true)
+    {
+        const bool done = m_done.load();
+
+        // The consumer takes the whole list, so there is no ABA hazard:
+        if (Entry* entries = m_head.exchange(nullptr, std::memory_order_acquire))
+        {
+            // Reverse to push order:
+            Entry* oldest = nullptr;
+            while (entries)
+            {
+                Entry* next = entries->next;
+                entries->next = oldest;
+                oldest = entries;
+                entries = next;
+            }
+            write(oldest);
+        }
+        else if (done)
+        {
+            break; // done and drained
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pushed.wait_for(lock, kInterval, [&]() { return m_done.load() || (m_head.load() != nullptr); });
+        }
+    }
+}
+
+void AppendSink::write(Entry* entries)
+{
+    const std::time_t now = std::time(nullptr);
+
+    std::vector<char> buffer;
+    std::string marks;
+    for (Entry* entry = entries; entry;)
+    {
+        const auto& payload = entry->payload;
+        if (entry->isMark)
+        {
+            marks += entry->name;
+            marks += '\n';
+        }
+        else if (m_format == kTar)
+        {
+            putTarHeader(buffer, entry->name, payload.size(), now);
+            buffer.insert(buffer.end(), payload.begin(), payload.end());
+            buffer.resize(((buffer.size() + kBlock - 1) / kBlock) * kBlock, 0);
+        }
+        else
+        {
+            buffer.insert(buffer.end(), payload.begin(), payload.end());
+            buffer.push_back('\n');
+        }
+        m_count += entry->isMark ? 0 : 1;
+
+        Entry* next = entry->next;
+        delete entry;
+        entry = next;
+    }
+
+    m_stream.write(buffer.data(), buffer.size());
+
+    // Marks follow the entries of the batch:
+    if (!marks.empty())
+    {
+        m_stream.flush();
+        if (!m_marks.is_open())
+        {
+            m_marks.open(m_filename + ".done", std::ios::binary | std::ios::app);
+        }
+        m_marks.write(marks.data(), marks.size());
+        m_marks.flush();
+    }
+}
+
+std::size_t AppendSink::close()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_pushed.notify_all();
+        m_thread.join();
+
+        if (m_format == kTar)
+        {
+            std::vector<char> trailer(kBlock * 2, 0); // end of archive
+            m_stream.write(trailer.data(), trailer.size());
+        }
+        m_stream.close();
+        if (m_marks.is_open())
+        {
+            m_marks.close();
+        }
+        m_good = false;
+    }
+
+    return m_count;
+}
+
+std::size_t AppendSink::getValidSize(const std::string& filename, Format format, std::size_t* count)
+{
+    std::size_t entries = 0, valid = 0;
+
+    std::ifstream is(filename, std::ios::binary);
+    if (is)
+    {
+        const std::size_t size = getFileSize(is);
+        if (format == kTar)
+        {
+            // Walk the headers up to the end of archive marker or a torn entry:
+            char header[kBlock];
+            while (is.read(header, kBlock) && std::any_of(header, header + kBlock, [](char c) { return c != 0; }))
+            {
+                const std::size_t end = valid + kBlock + ((getOctal(header + 124, 12) + kBlock - 1) / kBlock) * kBlock;
+                if (end > size)
+                {
+                    break;
+                }
+                valid = end;
+                entries++;
+                is.seekg(static_cast<std::streamoff>(valid), std::ios::beg);
+            }
+        }
+        else
+        {
+            // Up to the last new line:
+            std::vector<char> buffer(1 << 20);
+            for (std::size_t offset = 0; offset < size;)
+            {
+                is.read(buffer.data(), buffer.size());
+                const auto n = static_cast<std::size_t>(is.gcount());
+                if (n == 0)
+                {
+                    break;
+                }
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    if (buffer[i] == '\n')
+                    {
+                        valid = offset + i + 1;
+                        entries++;
+                    }
+                }
+                offset += n;
+            }
+        }
+    }
+
+    if (count)
+    {
+        *count = entries;
+    }
+    return valid;
+}
+
+std::size_t AppendSink::merge(const std::vector<std::string>& inputs, const std::string& output, Format format)
+{
+    std::ofstream os(output, std::ios::binary);
+
+    std::size_t total = 0;
+    std::vector<char> buffer(1 << 20);
+    for (const auto& input : inputs)
+    {
+        std::size_t count = 0;
+        std::size_t remaining = getValidSize(input, format, &count);
+        total += count;
+
+        std::ifstream is(input, std::ios::binary);
+        while (is && (remaining > 0))
+        {
+            is.read(buffer.data(), std::min(remaining, buffer.size()));
+            const auto n = static_cast<std::size_t>(is.gcount());
+            os.write(buffer.data(), n);
+            remaining -= n;
+        }
+    }
+
+    if (format == kTar)
+    {
+        std::vector<char> trailer(kBlock * 2, 0); // end of archive
+        os.write(trailer.data(), trailer.size());
+    }
+
+    return total;
+}
+
+DRISHTI_CORE_NAMESPACE_END
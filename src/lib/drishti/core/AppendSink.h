@@ -0,0 +1,109 @@
+/*! -*-c++-*-
+  @file   AppendSink.h
+  @author David Hirvonen
+  @brief  Declaration of a single writer, append only output file for batch results.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Batch tools produce one small result (and optionally a few images) per input, and
+  writing each one to its own file from every worker thread is dominated by file
+  creation and small writes.  Workers push entries onto a lock-free (multi-producer)
+  list instead, and a background thread takes the whole list at once and appends it
+  as one batched write, either as line-delimited text (e.g., one JSON object per line)
+  or as a POSIX (ustar) tar archive of named blobs (e.g., encoded png images).
+
+  Long (sharded) runs are resumable: an existing file can be appended to, and completion
+  marks are written to a companion <filename>.done file by the same writer, only after the
+  entries pushed before them, so a mark never refers to a result that was lost in a crash
+  (the results of unmarked items may be repeated by a resumed run).  Per shard files are
+  combined with merge().
+
+*/
+
+#ifndef __drishti_core_AppendSink_h__
+#define __drishti_core_AppendSink_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class AppendSink
+{
+public:
+    enum Format
+    {
+        kLines, // payload + '\n' per entry (names are ignored)
+        kTar    // one regular file per entry
+    };
+
+    // Append keeps the complete entries of an existing file (a torn last entry and the end of
+    // archive marker are removed), otherwise the file and its completion marks are replaced:
+    AppendSink(const std::string& filename, Format format = kLines, bool append = false);
+    ~AppendSink();
+
+    AppendSink(const AppendSink&) = delete;
+    AppendSink(AppendSink&&) = delete;
+    AppendSink& operator=(const AppendSink&) = delete;
+    AppendSink& operator=(AppendSink&&) = delete;
+
+    bool good() const { return m_good; }
+
+    // Thread safe and lock-free, entries from one thread are written in push order:
+    void push(std::string payload);
+    void push(const std::string& name, std::string payload);
+
+    // Completion mark (one line of <filename>.done), written after the entries that the calling
+    // thread pushed before it (thread safe):
+    void mark(std::string name);
+
+    // Size in bytes of the complete entries of a file (0 for a missing file):
+    static std::size_t getValidSize(const std::string& filename, Format format, std::size_t* count = nullptr);
+
+    // Concatenate the complete entries of several files (e.g., per shard outputs) into a new
+    // file, returns the number of entries:
+    static std::size_t merge(const std::vector<std::string>& inputs, const std::string& output, Format format = kLines);
+
+    // Drain the queue and close the file, returns the number of entries written:
+    std::size_t close();
+
+protected:
+    struct Entry
+    {
+        std::string name;
+        std::string payload;
+        bool isMark = false;
+        Entry* next = nullptr;
+    };
+
+    void run();
+    void write(Entry* entries); // oldest first
+    void publish(Entry* entry);
+
+    std::string m_filename;
+    std::ofstream m_stream;
+    std::ofstream m_marks; // <filename>.done, opened by the writer on the first mark
+    Format m_format = kLines;
+    bool m_good = false;
+
+    std::atomic<Entry*> m_head{ nullptr }; // newest first
+    std::atomic<bool> m_done{ false };
+    std::size_t m_count = 0;
+
+    std::mutex m_mutex; // wakeup only
+    std::condition_variable m_pushed;
+    std::thread m_thread;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_AppendSink_h__
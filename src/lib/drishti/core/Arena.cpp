@@ -0,0 +1,264 @@
+/*! -*-c++-*-
+  @file   Arena.cpp
+  @author David Hirvonen
+  @brief  Implementation of a frame scoped monotonic arena and allocator adapters.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+Arena::Arena(std::size_t blockSize)
+    : m_blockSize(blockSize)
+{
+}
+
+Arena::~Arena()
+{
+    free();
+}
+
+void* Arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    bytes = std::max(bytes, std::size_t(1));
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (!m_blocks.empty())
+        {
+            const auto& block = m_blocks.back();
+            const auto base = reinterpret_cast<std::uintptr_t>(block.data);
+            const auto head = base + m_offset;
+            const auto aligned = (head + alignment - 1) & ~std::uintptr_t(alignment - 1);
+            if ((aligned + bytes) <= (base + block.size))
+            {
+                m_used += (aligned + bytes) - head;
+                m_offset = (aligned + bytes) - base;
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+        grow(bytes + alignment);
+    }
+
+    throw std::bad_alloc();
+}
+
+void Arena::grow(std::size_t bytes)
+{
+    Block block;
+    block.size = std::max(bytes, m_blockSize);
+    block.data = new unsigned char[block.size];
+    m_blocks.push_back(block);
+    m_offset = 0;
+    m_capacity += block.size;
+    m_allocations++;
+}
+
+void Arena::free()
+{
+    for (auto& block : m_blocks)
+    {
+        delete[] block.data;
+    }
+    m_blocks.clear();
+    m_offset = 0;
+    m_capacity = 0;
+}
+
+bool Arena::reset()
+{
+    if (m_live > 0)
+    {
+        return false;
+    }
+
+    if (m_blocks.size() > 1)
+    {
+        // Replace the overflow blocks with one block that holds the whole frame:
+        const std::size_t capacity = m_capacity;
+        free();
+        grow(capacity);
+    }
+
+    m_offset = 0;
+    m_used = 0;
+    return true;
+}
+
+// ### FrameArena ###
+
+static FrameArena*& getCurrent()
+{
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+    static thread_local FrameArena* current = nullptr;
+    return current;
+#else
+    // Per thread slots (std::map nodes are stable, each slot is only used by its thread):
+    static std::mutex mutex;
+    static std::map<std::thread::id, FrameArena*> current;
+    std::lock_guard<std::mutex> lock(mutex);
+    return current[std::this_thread::get_id()];
+#endif
+}
+
+FrameArena::FrameArena(std::size_t blockSize)
+    : m_arenas([blockSize]() { return std::unique_ptr<Arena>(new Arena(blockSize)); })
+{
+}
+
+Arena& FrameArena::local()
+{
+    return *m_arenas[std::this_thread::get_id()];
+}
+
+bool FrameArena::reset()
+{
+    bool status = true;
+    std::unique_lock<std::mutex> lock(m_arenas.m_mutex);
+    for (auto& arena : m_arenas.getMap())
+    {
+        status &= arena.second->reset();
+    }
+    return status;
+}
+
+std::size_t FrameArena::getCapacity()
+{
+    std::size_t capacity = 0;
+    std::unique_lock<std::mutex> lock(m_arenas.m_mutex);
+    for (auto& arena : m_arenas.getMap())
+    {
+        capacity += arena.second->getCapacity();
+    }
+    return capacity;
+}
+
+FrameArena* FrameArena::current()
+{
+    return getCurrent();
+}
+
+FrameArena::Scope::Scope(FrameArena* arena)
+    : m_previous(getCurrent())
+{
+    getCurrent() = arena;
+}
+
+FrameArena::Scope::~Scope()
+{
+    getCurrent() = m_previous;
+}
+
+Arena* currentArena()
+{
+    FrameArena* frame = getCurrent();
+    return frame ? &frame->local() : nullptr;
+}
+
+// ### ArenaMatAllocator ###
+
+static const std::size_t kMatAlignment = 64; // cv::fastMalloc() alignment
+
+cv::UMatData* ArenaMatAllocator::allocate(int dims, const int* sizes, int type, void* data0, size_t* step, int /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const
+{
+    // Step and size logic follow cv::StdMatAllocator:
+    std::size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--)
+    {
+        if (step)
+        {
+            if (data0 && step[i] != CV_AUTOSTEP)
+            {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            }
+            else
+            {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    cv::UMatData* u = nullptr;
+    Arena* arena = data0 ? nullptr : currentArena();
+    if (arena)
+    {
+        u = new (arena->allocate(sizeof(cv::UMatData), alignof(cv::UMatData))) cv::UMatData(this);
+        u->data = u->origdata = static_cast<uchar*>(arena->allocate(total, kMatAlignment));
+        u->userdata = arena;
+        arena->retain();
+    }
+    else
+    {
+        u = new cv::UMatData(this);
+        u->data = u->origdata = data0 ? static_cast<uchar*>(data0) : static_cast<uchar*>(cv::fastMalloc(total));
+        if (data0)
+        {
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        }
+    }
+    u->size = total;
+    return u;
+}
+
+bool ArenaMatAllocator::allocate(cv::UMatData* u, int /*accessFlags*/, cv::UMatUsageFlags /*usageFlags*/) const
+{
+    return (u != nullptr);
+}
+
+void ArenaMatAllocator::deallocate(cv::UMatData* u) const
+{
+    if (!u)
+    {
+        return;
+    }
+
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+
+    if (auto* arena = static_cast<Arena*>(u->userdata))
+    {
+        u->~UMatData(); // storage is reclaimed by Arena::reset()
+        arena->release();
+        return;
+    }
+
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED))
+    {
+        cv::fastFree(u->origdata);
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+cv::MatAllocator* ArenaMatAllocator::getInstance()
+{
+    static ArenaMatAllocator allocator;
+    return &allocator;
+}
+
+cv::Mat arenaMat()
+{
+    cv::Mat image;
+    image.allocator = ArenaMatAllocator::getInstance();
+    return image;
+}
+
+cv::Mat arenaMat(const cv::Size& size, int type)
+{
+    cv::Mat image = arenaMat();
+    image.create(size, type);
+    return image;
+}
+
+DRISHTI_CORE_NAMESPACE_END
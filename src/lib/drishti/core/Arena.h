@@ -0,0 +1,189 @@
+/*! -*-c++-*-
+  @file   Arena.h
+  @author David Hirvonen
+  @brief  Declaration of a frame scoped monotonic arena and allocator adapters.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Temporaries in the per frame path (crops, resized planes, hypothesis lists, ...) are
+  short lived and sized the same from one frame to the next, so they are bump allocated
+  from an Arena and released all at once when the frame completes.  reset() rewinds the
+  arena and consolidates any overflow blocks into a single block of the high water size,
+  so steady state frames make no general heap allocations.
+
+  A FrameArena holds one Arena per thread.  The job that owns a frame installs it with a
+  FrameArena::Scope (worker lanes install the same FrameArena), code in the frame path
+  allocates from currentArena() through ArenaAllocator<T> (std::pmr style) or
+  ArenaMatAllocator (cv::MatAllocator), and the owner calls reset() after the frame.
+  Both adapters fall back to the heap when no arena is installed, so the same code runs
+  outside of a frame.  cv::Mat headers keep their arena alive: reset() is skipped (and
+  returns false) while any arena backed cv::Mat is still referenced.  Containers using
+  ArenaAllocator<T> must not outlive the frame.
+
+*/
+
+#ifndef __drishti_core_Arena_h__
+#define __drishti_core_Arena_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/LazyParallelResource.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class Arena
+{
+public:
+    explicit Arena(std::size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+    void deallocate(void*, std::size_t, std::size_t = 0) {} // monotonic (see reset())
+
+    // Reference counted owners (cv::Mat) pin the arena until they are released:
+    void retain() { ++m_live; }
+    void release() { --m_live; }
+
+    // Rewind to a single block (no-op returning false while any owner is live):
+    bool reset();
+
+    std::size_t getUsed() const { return m_used; }
+    std::size_t getCapacity() const { return m_capacity; }
+    std::size_t getBlockAllocations() const { return m_allocations; } // heap allocations (total)
+    int getLive() const { return m_live; }
+
+protected:
+    struct Block
+    {
+        unsigned char* data = nullptr;
+        std::size_t size = 0;
+    };
+
+    void grow(std::size_t bytes);
+    void free();
+
+    std::vector<Block> m_blocks;
+    std::size_t m_blockSize = 0;
+    std::size_t m_offset = 0; // in m_blocks.back()
+    std::size_t m_used = 0;
+    std::atomic<std::size_t> m_capacity{ 0 }; // read by memory probes
+    std::size_t m_allocations = 0;
+    std::atomic<int> m_live{ 0 };
+};
+
+class FrameArena
+{
+public:
+    explicit FrameArena(std::size_t blockSize = 64 * 1024);
+
+    // Arena for the calling thread (allocated on first use):
+    Arena& local();
+
+    // Reset the arenas of all threads, call when no frame is in flight:
+    bool reset();
+
+    std::size_t getCapacity();
+
+    // Installs an arena for the calling thread (nullptr for none), restoring the previous on exit:
+    class Scope
+    {
+    public:
+        explicit Scope(FrameArena* arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    protected:
+        FrameArena* m_previous = nullptr;
+    };
+
+    static FrameArena* current();
+
+protected:
+    LazyParallelResource<std::thread::id, std::unique_ptr<Arena>> m_arenas;
+};
+
+// Arena of the installed FrameArena for the calling thread (or nullptr):
+Arena* currentArena();
+
+template <typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator(Arena* arena = currentArena()) noexcept
+        : arena(arena)
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+        : arena(other.arena)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        if (arena)
+        {
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t /*n*/) noexcept
+    {
+        if (!arena)
+        {
+            ::operator delete(p);
+        }
+    }
+
+    Arena* arena = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.arena != b.arena;
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// cv::Mat data (and the UMatData header) are placed in currentArena() at allocation time:
+class ArenaMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, int accessflags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    static cv::MatAllocator* getInstance();
+};
+
+// Empty cv::Mat that allocates with ArenaMatAllocator, e.g., for use as an output argument:
+cv::Mat arenaMat();
+cv::Mat arenaMat(const cv::Size& size, int type);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_Arena_h__
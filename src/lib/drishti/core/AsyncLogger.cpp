@@ -0,0 +1,248 @@
+/*! -*-c++-*-
+  @file   AsyncLogger.cpp
+  @author David Hirvonen
+  @brief  Implementation of a deferred, allocation free front end for per-frame log records.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/AsyncLogger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static std::size_t nextPowerOfTwo(std::size_t n)
+{
+    std::size_t value = 1;
+    while (value < n)
+    {
+        value <<= 1;
+    }
+    return value;
+}
+
+AsyncLogger::AsyncLogger(Logger::Pointer logger)
+    : AsyncLogger(std::move(logger), Settings())
+{
+}
+
+AsyncLogger::AsyncLogger(Logger::Pointer logger, const Settings& settings)
+    : m_logger(std::move(logger))
+    , m_settings(settings)
+    , m_capacity(nextPowerOfTwo(std::max(settings.capacity, std::size_t(2))))
+    , m_slots(new Slot[m_capacity])
+    , m_categories(new Category[kMaxCategories])
+{
+    for (std::size_t i = 0; i < m_capacity; i++)
+    {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+}
+
+int AsyncLogger::addCategory(const std::string& name, int period)
+{
+    if (m_categoryCount >= kMaxCategories)
+    {
+        throw std::runtime_error("AsyncLogger: too many categories");
+    }
+
+    auto& category = m_categories[m_categoryCount];
+    category.name = name;
+    category.period.store(period, std::memory_order_relaxed);
+    return m_categoryCount++;
+}
+
+void AsyncLogger::setPeriod(int category, int period)
+{
+    if ((category >= 0) && (category < m_categoryCount))
+    {
+        m_categories[category].period.store(period, std::memory_order_relaxed);
+    }
+}
+
+bool AsyncLogger::sample(int category)
+{
+    if ((category < 0) || (category >= m_categoryCount))
+    {
+        return true; // uncategorized
+    }
+
+    auto& c = m_categories[category];
+    const int period = c.period.load(std::memory_order_relaxed);
+    return (period > 0) && ((c.count.fetch_add(1, std::memory_order_relaxed) % period) == 0);
+}
+
+// Bounded multi-producer queue (Vyukov), the slot sequence orders producers and the writer:
+bool AsyncLogger::push(const Record& record)
+{
+    std::uint64_t ticket = m_head.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot& slot = m_slots[ticket & (m_capacity - 1)];
+        const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::int64_t>(sequence - ticket);
+        if (difference == 0)
+        {
+            if (m_head.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+            {
+                slot.record = record;
+                slot.sequence.store(ticket + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed); // full
+            return false;
+        }
+        else
+        {
+            ticket = m_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool AsyncLogger::pop(Record& record)
+{
+    Slot& slot = m_slots[m_tail & (m_capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != (m_tail + 1))
+    {
+        return false;
+    }
+
+    record = slot.record;
+    slot.sequence.store(m_tail + m_capacity, std::memory_order_release);
+    m_tail++;
+    return true;
+}
+
+void AsyncLogger::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto request = ++m_flushRequests;
+    m_wakeup.notify_one();
+    m_flushed.wait(lock, [&]() { return m_flushes >= request; });
+}
+
+// Producers never notify (no syscalls on the hot path), the writer polls once per interval:
+void AsyncLogger::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wakeup.wait_for(lock, m_settings.interval, [&]() { return m_done || (m_flushes != m_flushRequests); });
+        const auto requests = m_flushRequests;
+        const bool done = m_done;
+
+        lock.unlock();
+        drain();
+        lock.lock();
+
+        m_flushes = requests;
+        m_flushed.notify_all();
+        if (done)
+        {
+            break;
+        }
+    }
+}
+
+void AsyncLogger::drain()
+{
+    Record record;
+    std::size_t count = 0;
+    while (pop(record))
+    {
+        if (m_logger)
+        {
+            m_logger->log(record.level, "{}", format(record));
+        }
+        count++;
+    }
+
+    if (count)
+    {
+        m_written.fetch_add(count, std::memory_order_relaxed);
+        if (m_logger)
+        {
+            m_logger->flush();
+        }
+    }
+}
+
+// Replace each "{...}" with the next field ("{{" and "}}" are literal braces), a format
+// spec containing 'f' prints reals in fixed notation:
+std::string AsyncLogger::format(const Record& record) const
+{
+    std::string line;
+    int index = 0;
+    for (const char* p = record.format; p && *p; p++)
+    {
+        if (((*p == '{') || (*p == '}')) && (p[1] == *p))
+        {
+            line.push_back(*p++);
+            continue;
+        }
+
+        if (*p != '{')
+        {
+            line.push_back(*p);
+            continue;
+        }
+
+        const char* end = p + 1;
+        bool isFixed = false;
+        for (; *end && (*end != '}'); end++)
+        {
+            isFixed |= (*end == 'f');
+        }
+
+        if (index < record.count)
+        {
+            const auto& field = record.fields[index++];
+
+            char buffer[64];
+            switch (field.type)
+            {
+                case Field::kInteger:
+                    std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(field.i));
+                    line += buffer;
+                    break;
+                case Field::kReal:
+                    std::snprintf(buffer, sizeof(buffer), isFixed ? "%f" : "%g", field.d);
+                    line += buffer;
+                    break;
+                case Field::kString:
+                    line += (field.s ? field.s : "");
+                    break;
+            }
+        }
+
+        if (!*end)
+        {
+            break;
+        }
+        p = end;
+    }
+
+    return line;
+}
+
+DRISHTI_CORE_NAMESPACE_END
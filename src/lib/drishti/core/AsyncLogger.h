@@ -0,0 +1,200 @@
+/*! -*-c++-*-
+  @file   AsyncLogger.h
+  @author David Hirvonen
+  @brief  Declaration of a deferred, allocation free front end for per-frame log records.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Per-frame diagnostics formatted on the calling thread and written through synchronous
+  sinks cost a few ms per frame.  Here a record is a static format string and up to
+  kMaxFields numeric (or static string) fields, copied into a preallocated ring without
+  locks or allocations.  A background thread formats the records and writes them to the
+  wrapped spdlog logger, then flushes it, once per interval.  Each record belongs to a
+  category (e.g., "gaze") that logs 1 of every N records, and records are dropped (and
+  counted) when the ring is full.  Timing belongs in the StageTracer, not here.
+
+*/
+
+#ifndef __drishti_core_AsyncLogger_h__
+#define __drishti_core_AsyncLogger_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/Logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class AsyncLogger
+{
+public:
+    static const int kMaxFields = 8;
+    static const int kMaxCategories = 32;
+
+    struct Settings
+    {
+        std::size_t capacity = 1024; // records, rounded up to the next power of two
+        std::chrono::milliseconds interval{ 100 };
+    };
+
+    AsyncLogger(Logger::Pointer logger, const Settings& settings);
+    explicit AsyncLogger(Logger::Pointer logger);
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger(AsyncLogger&&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(AsyncLogger&&) = delete;
+
+    // Register a category that logs 1 of every period records (0 == off), not thread safe
+    // with respect to log(), so add categories before logging starts:
+    int addCategory(const std::string& name, int period = 1);
+    void setPeriod(int category, int period); // thread safe
+
+    // Thread safe, lock free and allocation free.  The format string and string fields
+    // must outlive the record (i.e., literals).  Fields replace "{}" in order.  Returns
+    // false if the record was sampled out or dropped.
+    template <typename... Args>
+    bool log(spdlog::level::level_enum level, int category, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= kMaxFields, "AsyncLogger: too many fields");
+        if (!sample(category))
+        {
+            return false;
+        }
+
+        Record record;
+        record.level = level;
+        record.category = category;
+        record.format = format;
+        record.count = 0;
+        set(record, args...);
+        return push(record);
+    }
+
+    template <typename... Args>
+    bool info(int category, const char* format, const Args&... args)
+    {
+        return log(spdlog::level::info, category, format, args...);
+    }
+
+    // Write all pending records now (blocks until the writer thread is done):
+    void flush();
+
+    std::uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    std::uint64_t getWrittenCount() const { return m_written.load(std::memory_order_relaxed); }
+
+protected:
+    struct Field
+    {
+        enum Type
+        {
+            kInteger,
+            kReal,
+            kString
+        };
+
+        Type type = kInteger;
+        union
+        {
+            std::int64_t i;
+            double d;
+            const char* s;
+        };
+    };
+
+    struct Record
+    {
+        spdlog::level::level_enum level = spdlog::level::info;
+        int category = 0;
+        const char* format = nullptr;
+        int count = 0;
+        Field fields[kMaxFields];
+    };
+
+    struct Slot
+    {
+        std::atomic<std::uint64_t> sequence{ 0 }; // ticket: free, ticket + 1: full
+        Record record;
+    };
+
+    struct Category
+    {
+        std::string name;
+        std::atomic<int> period{ 1 };
+        std::atomic<std::uint64_t> count{ 0 };
+    };
+
+    static void set(Record&) {}
+
+    template <typename T, typename... Args>
+    static void set(Record& record, const T& value, const Args&... args)
+    {
+        Field& field = record.fields[record.count++];
+        assign(field, value);
+        set(record, args...);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type assign(Field& field, const T& value)
+    {
+        field.type = Field::kInteger;
+        field.i = static_cast<std::int64_t>(value);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type assign(Field& field, const T& value)
+    {
+        field.type = Field::kReal;
+        field.d = static_cast<double>(value);
+    }
+
+    static void assign(Field& field, const char* value)
+    {
+        field.type = Field::kString;
+        field.s = value;
+    }
+
+    bool sample(int category);
+    bool push(const Record& record);
+    bool pop(Record& record);
+
+    void run();
+    void drain();
+    std::string format(const Record& record) const;
+
+    Logger::Pointer m_logger;
+    Settings m_settings;
+
+    std::size_t m_capacity = 0;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<std::uint64_t> m_head{ 0 };
+    std::uint64_t m_tail = 0; // writer thread
+
+    std::unique_ptr<Category[]> m_categories;
+    int m_categoryCount = 0;
+
+    std::atomic<std::uint64_t> m_dropped{ 0 };
+    std::atomic<std::uint64_t> m_written{ 0 };
+
+    std::mutex m_mutex; // writer wakeup (flush and shutdown) only
+    std::condition_variable m_wakeup;
+    std::condition_variable m_flushed;
+    std::uint64_t m_flushRequests = 0;
+    std::uint64_t m_flushes = 0;
+    bool m_done = false;
+    std::thread m_thread; // last
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_AsyncLogger_h__
@@ -0,0 +1,347 @@
+/*! -*-c++-*-
+  @file   BatchQueue.h
+  @author David Hirvonen
+  @brief  Declaration of an asynchronous request queue with dynamic batching.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  In process service layer for batched models (e.g., face::FaceService): requests are
+  decoded (e.g., image decompression) on a small pool of decoder threads, and one batch
+  thread groups the decoded items into batches of at most Settings::maxBatch items.  A
+  partial batch runs once its oldest item has waited Settings::maxDelay, which bounds the
+  latency added by batching.  Admission control rejects requests while maxPending
+  requests are in flight (the future holds a BatchQueue::Rejected exception), so an
+  overloaded service fails fast instead of queueing without bound.
+
+*/
+
+#ifndef __drishti_core_BatchQueue_h__
+#define __drishti_core_BatchQueue_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+template <typename Request, typename Item, typename Result>
+class BatchQueue
+{
+public:
+    using Clock = std::chrono::high_resolution_clock;
+
+    // Decode one request (decoder threads, concurrently):
+    using Decoder = std::function<Item(Request& request)>;
+
+    // Process one batch, results[i] is the result for items[i] (batch thread):
+    using Processor = std::function<void(std::vector<Item>& items, std::vector<Result>& results)>;
+
+    struct Settings
+    {
+        std::size_t maxBatch = 8;
+        std::chrono::microseconds maxDelay{ 5000 }; // partial batch deadline (oldest decoded item)
+        std::size_t maxPending = 64;                // admitted requests in flight
+        int threads = 2;                            // decoder threads
+    };
+
+    // Stage latency in seconds:
+    struct Stage
+    {
+        std::size_t count = 0;
+        double total = 0.0;
+        double max = 0.0;
+
+        void add(double seconds)
+        {
+            count++;
+            total += seconds;
+            max = std::max(max, seconds);
+        }
+        double mean() const { return count ? (total / static_cast<double>(count)) : 0.0; }
+    };
+
+    struct Stats
+    {
+        std::size_t admitted = 0;
+        std::size_t rejected = 0; // admission control
+        std::size_t failed = 0;   // decoder or processor exceptions
+        std::size_t batches = 0;
+        std::size_t items = 0;
+
+        Stage decode;  // per request
+        Stage wait;    // decoded to batch start, per request
+        Stage batch;   // processing, per batch
+        Stage latency; // push() to result, per request
+
+        double getMeanBatchSize() const { return batches ? (static_cast<double>(items) / static_cast<double>(batches)) : 0.0; }
+    };
+
+    class Rejected : public std::runtime_error
+    {
+    public:
+        Rejected()
+            : std::runtime_error("BatchQueue: request rejected (overloaded)")
+        {
+        }
+    };
+
+    BatchQueue(Decoder decoder, Processor processor, const Settings& settings = {})
+        : m_decoder(std::move(decoder))
+        , m_processor(std::move(processor))
+        , m_settings(settings)
+    {
+        m_settings.maxBatch = std::max(m_settings.maxBatch, std::size_t(1));
+        for (int i = 0; i < std::max(m_settings.threads, 1); i++)
+        {
+            m_decoders.emplace_back([this]() { decode(); });
+        }
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    // Completes the admitted requests:
+    ~BatchQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+        m_requestsReady.notify_all();
+        m_itemsReady.notify_all();
+        for (auto& thread : m_decoders)
+        {
+            thread.join();
+        }
+        m_itemsReady.notify_all();
+        m_thread.join();
+    }
+
+    BatchQueue(const BatchQueue&) = delete;
+    BatchQueue(BatchQueue&&) = delete;
+    BatchQueue& operator=(const BatchQueue&) = delete;
+    BatchQueue& operator=(BatchQueue&&) = delete;
+
+    const Settings& getSettings() const { return m_settings; }
+
+    // Thread safe, the future holds the result, a Rejected exception or the decoder/processor exception:
+    std::future<Result> push(Request request)
+    {
+        std::unique_ptr<Job> job(new Job);
+        job->request = std::move(request);
+        job->arrival = Clock::now();
+        auto result = job->promise.get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_done || (m_pending >= m_settings.maxPending))
+            {
+                m_stats.rejected++;
+                job->promise.set_exception(std::make_exception_ptr(Rejected()));
+                return result;
+            }
+            m_pending++;
+            m_stats.admitted++;
+            m_requests.push_back(std::move(job));
+        }
+        m_requestsReady.notify_one();
+        return result;
+    }
+
+    std::size_t getPending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending;
+    }
+
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+protected:
+    struct Job
+    {
+        Request request;
+        Item item;
+        std::promise<Result> promise;
+        Clock::time_point arrival, decoded;
+    };
+    using JobPtr = std::unique_ptr<Job>;
+
+    static double seconds(const Clock::time_point& begin, const Clock::time_point& end)
+    {
+        return std::chrono::duration<double>(end - begin).count();
+    }
+
+    void fail(JobPtr& job, std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.failed++;
+            m_pending--;
+        }
+        job->promise.set_exception(error);
+    }
+
+    // Decoder threads:
+    void decode()
+    {
+        for (;;)
+        {
+            JobPtr job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_requestsReady.wait(lock, [this]() { return m_done || !m_requests.empty(); });
+                if (m_requests.empty())
+                {
+                    return; // done
+                }
+                job = std::move(m_requests.front());
+                m_requests.pop_front();
+                m_decoding++;
+            }
+
+            bool ok = true;
+            try
+            {
+                job->item = m_decoder(job->request);
+                job->request = Request(); // release the encoded data
+            }
+            catch (...)
+            {
+                ok = false;
+                fail(job, std::current_exception());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_decoding--;
+                if (ok)
+                {
+                    job->decoded = Clock::now();
+                    m_stats.decode.add(seconds(job->arrival, job->decoded));
+                    m_items.push_back(std::move(job));
+                }
+            }
+            m_itemsReady.notify_one();
+        }
+    }
+
+    // Batch thread:
+    void run()
+    {
+        std::vector<JobPtr> jobs;
+        std::vector<Item> items;
+        std::vector<Result> results;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                const auto isDrained = [this]() { return m_done && m_requests.empty() && !m_decoding; };
+                m_itemsReady.wait(lock, [&]() { return !m_items.empty() || isDrained(); });
+                if (m_items.empty())
+                {
+                    return; // done
+                }
+
+                // Wait for a full batch until the oldest item is due (no delay while draining):
+                const auto deadline = m_items.front()->decoded + m_settings.maxDelay;
+                m_itemsReady.wait_until(lock, deadline, [&]() { return (m_items.size() >= m_settings.maxBatch) || isDrained(); });
+
+                const std::size_t count = std::min(m_items.size(), m_settings.maxBatch);
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    jobs.push_back(std::move(m_items.front()));
+                    m_items.pop_front();
+                }
+            }
+
+            const auto start = Clock::now();
+            items.clear();
+            for (auto& job : jobs)
+            {
+                items.push_back(std::move(job->item));
+            }
+
+            std::exception_ptr error;
+            results.clear();
+            try
+            {
+                m_processor(items, results);
+                if (results.size() != items.size())
+                {
+                    throw std::runtime_error("BatchQueue: processor returned the wrong number of results");
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            const auto stop = Clock::now();
+
+            // Stats first, so they include a request once its result is available:
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.batches++;
+                m_stats.items += jobs.size();
+                m_stats.batch.add(seconds(start, stop));
+                for (const auto& job : jobs)
+                {
+                    m_stats.wait.add(seconds(job->decoded, start));
+                    m_stats.latency.add(seconds(job->arrival, stop));
+                }
+                if (error)
+                {
+                    m_stats.failed += jobs.size();
+                }
+                m_pending -= jobs.size();
+            }
+
+            for (std::size_t i = 0; i < jobs.size(); i++)
+            {
+                if (error)
+                {
+                    jobs[i]->promise.set_exception(error);
+                }
+                else
+                {
+                    jobs[i]->promise.set_value(std::move(results[i]));
+                }
+            }
+            jobs.clear();
+        }
+    }
+
+    Decoder m_decoder;
+    Processor m_processor;
+    Settings m_settings;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_requestsReady;
+    std::condition_variable m_itemsReady;
+    std::deque<JobPtr> m_requests; // admitted, not decoded
+    std::deque<JobPtr> m_items;    // decoded, not batched
+    std::size_t m_pending = 0;     // admitted, not complete
+    std::size_t m_decoding = 0;
+    bool m_done = false;
+    Stats m_stats;
+
+    std::vector<std::thread> m_decoders;
+    std::thread m_thread; // last
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_BatchQueue_h__
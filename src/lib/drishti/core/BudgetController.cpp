@@ -0,0 +1,185 @@
+/*! -*-c++-*-
+  @file   BudgetController.cpp
+  @author David Hirvonen
+  @brief  Implementation of an adaptive quality/latency controller driven by stage timings.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/BudgetController.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+BudgetController::BudgetController(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+void BudgetController::add(Knob knob)
+{
+    m_knobs.push_back(std::move(knob));
+    m_levels.push_back(0);
+}
+
+void BudgetController::setCost(std::vector<std::vector<int>> groups)
+{
+    m_groups = std::move(groups);
+}
+
+void BudgetController::set(int knob, int level)
+{
+    m_levels[knob] = level;
+    if (m_knobs[knob].apply)
+    {
+        m_knobs[knob].apply(level);
+    }
+}
+
+bool BudgetController::degrade(const std::vector<double>& shares)
+{
+    const int stageCount = static_cast<int>(shares.size());
+    for (int i = 0; i < static_cast<int>(m_knobs.size()); i++)
+    {
+        const auto& knob = m_knobs[i];
+        const bool helps = (knob.stage < 0) || (knob.stage >= stageCount) || (shares[knob.stage] >= m_settings.minShare);
+        if ((m_levels[i] < knob.levels) && helps)
+        {
+            set(i, m_levels[i] + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BudgetController::restore()
+{
+    for (int i = static_cast<int>(m_knobs.size()) - 1; i >= 0; i--)
+    {
+        if (m_levels[i] > 0)
+        {
+            set(i, m_levels[i] - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BudgetController::update(const StageTracer& tracer, std::uint64_t frame)
+{
+    if ((m_settings.target <= 0.0) || m_knobs.empty())
+    {
+        return false;
+    }
+
+    if (!m_started)
+    {
+        m_started = true;
+        m_since = frame;
+    }
+
+    if (++m_frames < std::max(m_settings.window, 1))
+    {
+        return false;
+    }
+    m_frames = 0;
+
+    // Stage -> cost groups (all stages are summed without groups):
+    const auto& names = tracer.getStageNames();
+    const int stageCount = static_cast<int>(names.size());
+    std::vector<std::vector<int>> membership(names.size());
+    for (int g = 0; g < static_cast<int>(m_groups.size()); g++)
+    {
+        for (const auto& stage : m_groups[g])
+        {
+            if ((stage >= 0) && (stage < stageCount))
+            {
+                membership[stage].push_back(g);
+            }
+        }
+    }
+    const std::size_t groupCount = std::max(m_groups.size(), std::size_t(1));
+
+    // Per frame { group costs, stage costs } for the frames completed with the current levels:
+    std::map<std::uint64_t, std::vector<double>> frames;
+    for (const auto& span : tracer.getSpans())
+    {
+        if ((span.frame < m_since) || (span.frame >= frame) || (span.stage < 0) || (span.stage >= stageCount))
+        {
+            continue;
+        }
+
+        auto& costs = frames[span.frame];
+        costs.resize(groupCount + names.size(), 0.0);
+        if (m_groups.empty())
+        {
+            costs[0] += span.duration;
+        }
+        for (const auto& g : membership[span.stage])
+        {
+            costs[g] += span.duration;
+        }
+        costs[groupCount + span.stage] += span.duration;
+    }
+
+    // Wait for a full window (e.g., after a change, or with a sparse tracer):
+    const auto window = static_cast<std::size_t>(std::max(m_settings.window, 1));
+    if (frames.size() < window)
+    {
+        return false;
+    }
+
+    // The most recent window of frames:
+    std::vector<double> costs, stages(names.size(), 0.0);
+    costs.reserve(window);
+    for (auto iter = std::prev(frames.end(), window); iter != frames.end(); iter++)
+    {
+        const auto& f = iter->second;
+        costs.push_back(*std::max_element(f.begin(), f.begin() + groupCount));
+        for (std::size_t i = 0; i < stages.size(); i++)
+        {
+            stages[i] += f[groupCount + i];
+        }
+    }
+
+    const double p = std::min(std::max(m_settings.percentile, 0.0), 1.0);
+    auto nth = costs.begin() + static_cast<std::size_t>(p * static_cast<double>(costs.size() - 1) + 0.5);
+    std::nth_element(costs.begin(), nth, costs.end());
+    m_cost = *nth;
+
+    // Stage share of the total frame cost:
+    double total = 0.0;
+    for (const auto& c : costs)
+    {
+        total += c;
+    }
+    for (auto& s : stages)
+    {
+        s = (total > 0.0) ? (s / total) : 0.0;
+    }
+
+    bool changed = false;
+    if (m_cost > m_settings.target)
+    {
+        changed = degrade(stages);
+    }
+    else if (m_cost < (m_settings.headroom * m_settings.target))
+    {
+        changed = restore();
+    }
+
+    if (changed)
+    {
+        m_since = frame;
+        m_changes++;
+    }
+
+    return changed;
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,98 @@
+/*! -*-c++-*-
+  @file   BudgetController.h
+  @author David Hirvonen
+  @brief  Declaration of an adaptive quality/latency controller driven by stage timings.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Pipelines expose static quality knobs (cascade stage hints, detection intervals, ...)
+  that are tuned for one device.  The controller closes the loop on a target frame time:
+  frame costs are read from a StageTracer, and when a cost percentile exceeds the target
+  the knobs are degraded one level at a time in priority order, then restored in reverse
+  order once there is headroom.  Each decision waits for a full window of frames measured
+  with the current settings, so quality degrades gracefully (e.g., thermal throttling)
+  instead of frames being dropped.
+
+*/
+
+#ifndef __drishti_core_BudgetController_h__
+#define __drishti_core_BudgetController_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/StageTracer.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class BudgetController
+{
+public:
+    struct Settings
+    {
+        double target = 0.0;      // frame time in seconds (0 == disabled)
+        double percentile = 0.9;  // frame cost percentile compared with the target
+        int window = 30;          // measured frames per decision
+        double headroom = 0.75;   // restore a level when the cost is below headroom * target
+        double minShare = 0.05;   // skip knobs whose stage costs less than this share of a frame
+    };
+
+    struct Knob
+    {
+        Knob() = default;
+        Knob(std::string name, int levels, std::function<void(int level)> apply, int stage = -1)
+            : name(std::move(name))
+            , levels(levels)
+            , apply(std::move(apply))
+            , stage(stage)
+        {
+        }
+
+        std::string name;
+        int levels = 1;                       // degraded levels (level 0 == full quality)
+        std::function<void(int level)> apply; // called on every level change
+        int stage = -1;                       // (optional) tracer stage the knob acts on
+    };
+
+    explicit BudgetController(const Settings& settings);
+
+    // Knobs are degraded in the order they are added (and restored in reverse order):
+    void add(Knob knob);
+
+    // The frame cost is the maximum over the groups of the summed stage durations per frame,
+    // e.g., { { main thread stage }, { worker stages ... } } for a pipelined frame:
+    void setCost(std::vector<std::vector<int>> groups);
+
+    // Call once per frame (knobs are applied on the calling thread), returns true on a change:
+    bool update(const StageTracer& tracer, std::uint64_t frame);
+
+    int getLevel(int knob) const { return m_levels[knob]; }
+    double getCost() const { return m_cost; } // latest measured cost percentile
+    std::size_t getChangeCount() const { return m_changes; }
+    const Settings& getSettings() const { return m_settings; }
+
+protected:
+    bool degrade(const std::vector<double>& shares);
+    bool restore();
+    void set(int knob, int level);
+
+    Settings m_settings;
+    std::vector<Knob> m_knobs;
+    std::vector<int> m_levels;
+    std::vector<std::vector<int>> m_groups;
+
+    std::uint64_t m_since = 0; // first frame measured with the current levels
+    bool m_started = false;
+    int m_frames = 0; // update() calls since the last evaluation
+    double m_cost = 0.0;
+    std::size_t m_changes = 0;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_BudgetController_h__
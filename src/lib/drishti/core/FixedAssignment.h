@@ -0,0 +1,308 @@
+/*! -*-c++-*-
+  @file   FixedAssignment.h
+  @author David Hirvonen
+  @brief  Declaration of a fixed capacity linear assignment solver.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  O(n^2 m) shortest augmenting path (Hungarian) solver with dual potentials for small
+  rectangular cost matrices (up to N x N).  All storage is inline, so construction and
+  solve() perform no heap allocations, which makes it suitable for per frame track
+  assignment.  Use MinimizeLinearAssignment() (hungarian.h) for larger problems.
+
+  Assignments are usually stable across frames, so solve() can be seeded with the previous
+  matching: prior pairs that are still row minima are kept with row minimum dual potentials,
+  and only the remaining rows are augmented (none when the prior is still optimal).  With
+  N <= 4 the problem is small enough for an exhaustive search over the (at most 24)
+  assignments, ties are resolved in favor of the prior.
+
+*/
+
+#ifndef __drishti_core_FixedAssignment_h__
+#define __drishti_core_FixedAssignment_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+template <typename T, int N>
+class FixedAssignment
+{
+public:
+    static constexpr int capacity = N;
+
+    // Returns false if the problem exceeds the fixed capacity:
+    bool resize(int rows, int cols)
+    {
+        if ((rows < 0) || (cols < 0) || (rows > N) || (cols > N))
+        {
+            return false;
+        }
+        m_rows = rows;
+        m_cols = cols;
+        return true;
+    }
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+
+    T& operator()(int i, int j) { return m_cost[i][j]; }
+    const T& operator()(int i, int j) const { return m_cost[i][j]; }
+
+    // Copy a row major rows x cols cost array (false if it exceeds the fixed capacity):
+    bool assign(const T* cost, int rows, int cols)
+    {
+        if (!resize(rows, cols))
+        {
+            return false;
+        }
+        for (int i = 0; i < rows; i++, cost += cols)
+        {
+            std::copy(cost, cost + cols, m_cost[i].begin());
+        }
+        return true;
+    }
+
+    // Minimum cost assignment, direct[i] is the column for row i (or -1), for rows() entries.
+    // Every row is assigned when rows() <= cols() (and vice versa).  Returns the assignment count.
+    int solve(int* direct)
+    {
+        return solve(direct, nullptr);
+    }
+
+    // Warm start from a prior assignment in the same format (e.g., the previous frame), entries
+    // past cols() and repeated columns are ignored:
+    int solve(int* direct, const int* prior)
+    {
+        m_augmentations = 0;
+        return (N <= 4) ? solveExhaustive(direct, prior) : solveHungarian(direct, prior);
+    }
+
+    // Augmenting paths computed by the last solve() (0 if the prior was optimal or N <= 4):
+    int getAugmentations() const { return m_augmentations; }
+
+protected:
+    int solveHungarian(int* direct, const int* prior)
+    {
+        std::fill(direct, direct + m_rows, -1);
+
+        // Rows must not outnumber columns, so solve wide problems on the transpose:
+        const bool transposed = (m_rows > m_cols);
+        const int n = transposed ? m_cols : m_rows;
+        const int m = transposed ? m_rows : m_cols;
+        auto cost = [&](int i, int j) { return transposed ? m_cost[j][i] : m_cost[i][j]; };
+
+        const T inf = std::numeric_limits<T>::max();
+
+        // 1-based indexing with column 0 as the virtual source:
+        std::array<T, N + 1> u{}, v{}, minv;
+        std::array<int, N + 1> p{}, way{};
+        std::array<bool, N + 1> used, matched{};
+
+        if (prior)
+        {
+            // Feasible duals (u = row minima, v = 0) with the tight prior pairs as a partial matching:
+            for (int i = 1; i <= n; i++)
+            {
+                u[i] = inf;
+                for (int j = 1; j <= m; j++)
+                {
+                    u[i] = std::min(u[i], cost(i - 1, j - 1));
+                }
+            }
+            for (int r = 0; r < m_rows; r++)
+            {
+                const int c = prior[r];
+                if ((c < 0) || (c >= m_cols))
+                {
+                    continue;
+                }
+                const int i = (transposed ? c : r) + 1, j = (transposed ? r : c) + 1;
+                if (!matched[i] && !p[j] && (cost(i - 1, j - 1) == u[i]))
+                {
+                    p[j] = i;
+                    matched[i] = true;
+                }
+            }
+        }
+
+        for (int i = 1; i <= n; i++)
+        {
+            if (matched[i])
+            {
+                continue;
+            }
+
+            m_augmentations++;
+            p[0] = i;
+            int j0 = 0;
+            std::fill(minv.begin(), minv.begin() + m + 1, inf);
+            std::fill(used.begin(), used.begin() + m + 1, false);
+            do
+            {
+                used[j0] = true;
+                const int i0 = p[j0];
+                T delta = inf;
+                int j1 = 0;
+                for (int j = 1; j <= m; j++)
+                {
+                    if (!used[j])
+                    {
+                        const T cur = cost(i0 - 1, j - 1) - u[i0] - v[j];
+                        if (cur < minv[j])
+                        {
+                            minv[j] = cur;
+                            way[j] = j0;
+                        }
+                        if (minv[j] < delta)
+                        {
+                            delta = minv[j];
+                            j1 = j;
+                        }
+                    }
+                }
+                for (int j = 0; j <= m; j++)
+                {
+                    if (used[j])
+                    {
+                        u[p[j]] += delta;
+                        v[j] -= delta;
+                    }
+                    else
+                    {
+                        minv[j] -= delta;
+                    }
+                }
+                j0 = j1;
+            } while (p[j0] != 0);
+
+            // Flip the augmenting path:
+            do
+            {
+                const int j1 = way[j0];
+                p[j0] = p[j1];
+                j0 = j1;
+            } while (j0);
+        }
+
+        int count = 0;
+        for (int j = 1; j <= m; j++)
+        {
+            if (p[j])
+            {
+                const int i = p[j] - 1, k = j - 1;
+                direct[transposed ? k : i] = transposed ? i : k;
+                count++;
+            }
+        }
+
+        return count;
+    }
+
+    int solveExhaustive(int* direct, const int* prior)
+    {
+        std::fill(direct, direct + m_rows, -1);
+
+        const bool transposed = (m_rows > m_cols);
+        const int n = transposed ? m_cols : m_rows;
+        const int m = transposed ? m_rows : m_cols;
+
+        std::array<int, N + 1> current{}, best{};
+        T bestCost = std::numeric_limits<T>::max();
+        bool hasBest = false;
+
+        if (prior)
+        {
+            // The prior is the incumbent if it is a complete assignment:
+            unsigned int mask = 0;
+            for (int r = 0; r < m_rows; r++)
+            {
+                const int c = prior[r];
+                if ((c >= 0) && (c < m_cols) && !(mask & (1u << c)))
+                {
+                    mask |= (1u << c);
+                    if (transposed)
+                    {
+                        best[c] = r;
+                    }
+                    else
+                    {
+                        best[r] = c;
+                    }
+                }
+            }
+
+            if (popcount(mask) == n)
+            {
+                bestCost = T(0);
+                for (int i = 0; i < n; i++)
+                {
+                    bestCost += cost(transposed, i, best[i]);
+                }
+                hasBest = true;
+            }
+        }
+
+        search(transposed, 0, n, m, 0u, T(0), current, best, bestCost, hasBest);
+
+        for (int i = 0; i < n; i++)
+        {
+            direct[transposed ? best[i] : i] = transposed ? i : best[i];
+        }
+
+        return n;
+    }
+
+    // Depth first search over the assignments of rows [i, n) to the unused columns:
+    void search(bool transposed, int i, int n, int m, unsigned int used, T total, std::array<int, N + 1>& current, std::array<int, N + 1>& best, T& bestCost, bool& hasBest) const
+    {
+        if (i == n)
+        {
+            if (!hasBest || (total < bestCost))
+            {
+                bestCost = total;
+                best = current;
+                hasBest = true;
+            }
+            return;
+        }
+
+        for (int j = 0; j < m; j++)
+        {
+            if (!(used & (1u << j)))
+            {
+                current[i] = j;
+                search(transposed, i + 1, n, m, used | (1u << j), total + cost(transposed, i, j), current, best, bestCost, hasBest);
+            }
+        }
+    }
+
+    T cost(bool transposed, int i, int j) const
+    {
+        return transposed ? m_cost[j][i] : m_cost[i][j];
+    }
+
+    static int popcount(unsigned int mask)
+    {
+        int count = 0;
+        for (; mask; mask &= (mask - 1))
+        {
+            count++;
+        }
+        return count;
+    }
+
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_augmentations = 0;
+    std::array<std::array<T, N>, N> m_cost;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_FixedAssignment_h__
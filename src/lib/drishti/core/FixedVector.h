@@ -0,0 +1,82 @@
+/*! -*-c++-*-
+  @file   FixedVector.h
+  @author David Hirvonen
+  @brief  Declaration of a fixed capacity vector with inline storage.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A std::vector like container for small per frame records: the elements live inside the
+  object (no heap allocations), and copies only touch the used prefix.
+
+*/
+
+#ifndef __drishti_core_FixedVector_h__
+#define __drishti_core_FixedVector_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+template <typename T, int N>
+class FixedVector
+{
+public:
+    static constexpr int capacity = N;
+
+    FixedVector() = default;
+    FixedVector(const FixedVector& src)
+        : m_size(src.m_size)
+    {
+        std::copy(src.begin(), src.end(), m_data.begin());
+    }
+    FixedVector& operator=(const FixedVector& src)
+    {
+        m_size = src.m_size;
+        std::copy(src.begin(), src.end(), m_data.begin());
+        return *this;
+    }
+
+    // Returns false (and leaves the container empty) if src exceeds the fixed capacity:
+    bool assign(const std::vector<T>& src)
+    {
+        if (src.size() > static_cast<std::size_t>(N))
+        {
+            m_size = 0;
+            return false;
+        }
+        m_size = static_cast<int>(src.size());
+        std::copy(src.begin(), src.end(), m_data.begin());
+        return true;
+    }
+
+    void copyTo(std::vector<T>& dst) const
+    {
+        dst.assign(begin(), end());
+    }
+
+    void clear() { m_size = 0; }
+    void resize(int size) { m_size = std::min(size, N); }
+    int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T& operator[](int i) { return m_data[i]; }
+    const T& operator[](int i) const { return m_data[i]; }
+
+    T* begin() { return m_data.data(); }
+    T* end() { return m_data.data() + m_size; }
+    const T* begin() const { return m_data.data(); }
+    const T* end() const { return m_data.data() + m_size; }
+
+protected:
+    std::array<T, N> m_data;
+    int m_size = 0;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_FixedVector_h__
@@ -0,0 +1,298 @@
+/*! -*-c++-*-
+  @file   FlatArchive.cpp
+  @author David Hirvonen
+  @brief  Implementation of a versioned, aligned, offset based (zero parse) model archive.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/FlatArchive.h"
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+// clang-format off
+#if !defined(_WIN32)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define DRISHTI_CORE_FLAT_ARCHIVE_USE_MMAP 1
+#else
+#  define DRISHTI_CORE_FLAT_ARCHIVE_USE_MMAP 0
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static const char kMagic[4] = { 'D', 'R', 'F', 'A' };
+static const std::size_t kHeaderSize = 16;
+static const std::size_t kNameSize = 32;
+static const std::size_t kSectionSize = kNameSize + 16;
+
+// Section data is used in place, so only little-endian hosts can load archives:
+static bool isLittleEndian()
+{
+    const std::uint16_t value = 1;
+    return *reinterpret_cast<const std::uint8_t*>(&value) == 1;
+}
+
+static std::size_t align(std::size_t offset)
+{
+    return (offset + FlatArchive::kAlignment - 1) & ~(FlatArchive::kAlignment - 1);
+}
+
+template <typename T>
+static void putLE(std::vector<char>& buffer, std::size_t offset, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        buffer[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+template <typename T>
+static T getLE(const char* data)
+{
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        value |= static_cast<T>(static_cast<std::uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+// ### FlatArchiveWriter ###
+
+void FlatArchiveWriter::add(const std::string& name, const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    m_sections.emplace_back(name, std::vector<char>(bytes, bytes + size));
+}
+
+bool FlatArchiveWriter::write(std::ostream& os) const
+{
+    const std::size_t table = kHeaderSize + m_sections.size() * kSectionSize;
+
+    // Assign section offsets:
+    std::vector<std::size_t> offsets;
+    std::size_t end = align(table);
+    for (const auto& section : m_sections)
+    {
+        if (section.first.empty() || (section.first.size() >= kNameSize))
+        {
+            return false;
+        }
+        offsets.push_back(end);
+        end = align(end + section.second.size());
+    }
+
+    std::vector<char> buffer(end, 0);
+    std::copy(std::begin(kMagic), std::end(kMagic), buffer.begin());
+    putLE<std::uint32_t>(buffer, 4, FlatArchive::kVersion);
+    putLE<std::uint32_t>(buffer, 8, static_cast<std::uint32_t>(m_sections.size()));
+
+    for (std::size_t i = 0; i < m_sections.size(); i++)
+    {
+        const auto& section = m_sections[i];
+        const std::size_t entry = kHeaderSize + i * kSectionSize;
+        std::copy(section.first.begin(), section.first.end(), buffer.begin() + entry);
+        putLE<std::uint64_t>(buffer, entry + kNameSize, offsets[i]);
+        putLE<std::uint64_t>(buffer, entry + kNameSize + 8, section.second.size());
+        std::copy(section.second.begin(), section.second.end(), buffer.begin() + offsets[i]);
+    }
+
+    os.write(buffer.data(), buffer.size());
+    return os.good();
+}
+
+bool FlatArchiveWriter::write(const std::string& filename) const
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    return ofs && write(ofs);
+}
+
+// ### FlatArchive ###
+
+class FlatArchive::Impl
+{
+public:
+    Impl() = default;
+    ~Impl()
+    {
+#if DRISHTI_CORE_FLAT_ARCHIVE_USE_MMAP
+        if (mapped)
+        {
+            munmap(mapped, size);
+        }
+#endif
+    }
+
+    Impl(const Impl&) = delete;
+    Impl(Impl&&) = delete;
+    Impl& operator=(const Impl&) = delete;
+    Impl& operator=(Impl&&) = delete;
+
+    // Validate the header and build the section table:
+    bool parse()
+    {
+        if (!isLittleEndian() || (size < kHeaderSize) || !std::equal(std::begin(kMagic), std::end(kMagic), data))
+        {
+            return false;
+        }
+
+        const auto version = getLE<std::uint32_t>(data + 4);
+        const auto count = getLE<std::uint32_t>(data + 8);
+        if ((version != FlatArchive::kVersion) || ((kHeaderSize + std::size_t(count) * kSectionSize) > size))
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const char* entry = data + kHeaderSize + i * kSectionSize;
+            const std::string name(entry, std::find(entry, entry + kNameSize, '\0'));
+            const auto offset = getLE<std::uint64_t>(entry + kNameSize);
+            const auto length = getLE<std::uint64_t>(entry + kNameSize + 8);
+            if ((offset % FlatArchive::kAlignment) || (offset > size) || (length > (size - offset)))
+            {
+                return false;
+            }
+            sections[name] = { data + offset, static_cast<std::size_t>(length) };
+        }
+
+        return true;
+    }
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    void* mapped = nullptr;            // mmap
+    std::vector<char> buffer;          // stream (data is aligned within)
+    std::shared_ptr<const void> owner; // view
+
+    std::map<std::string, std::pair<const char*, std::size_t>> sections;
+};
+
+FlatArchive::FlatArchive()
+    : m_impl(drishti::core::make_unique<Impl>())
+{
+}
+
+FlatArchive::~FlatArchive() = default;
+
+std::shared_ptr<FlatArchive> FlatArchive::map(const std::string& filename)
+{
+#if DRISHTI_CORE_FLAT_ARCHIVE_USE_MMAP
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+    {
+        mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd); // the mapping holds its own reference
+
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    auto archive = std::make_shared<FlatArchive>();
+    archive->m_impl->mapped = mapped;
+    archive->m_impl->data = static_cast<const char*>(mapped);
+    archive->m_impl->size = static_cast<std::size_t>(info.st_size);
+    return archive->m_impl->parse() ? archive : nullptr;
+#else
+    std::ifstream ifs(filename, std::ios::binary);
+    return ifs ? read(ifs) : nullptr;
+#endif
+}
+
+std::shared_ptr<FlatArchive> FlatArchive::read(std::istream& is)
+{
+    static const std::size_t kChunk = 1 << 16;
+
+    // Read after kAlignment bytes of headroom, so the data can be aligned in place:
+    auto archive = std::make_shared<FlatArchive>();
+    auto& impl = *archive->m_impl;
+    auto& buffer = impl.buffer;
+    buffer.resize(kAlignment);
+    while (is)
+    {
+        const std::size_t size = buffer.size();
+        buffer.resize(size + kChunk);
+        is.read(buffer.data() + size, kChunk);
+        buffer.resize(size + static_cast<std::size_t>(is.gcount()));
+    }
+
+    // Sections are aligned relative to the start of the archive:
+    const auto address = reinterpret_cast<std::uintptr_t>(buffer.data());
+    char* data = buffer.data() + (align(address) - address);
+    impl.size = buffer.size() - kAlignment;
+    std::memmove(data, buffer.data() + kAlignment, impl.size);
+
+    impl.data = data;
+    return impl.parse() ? archive : nullptr;
+}
+
+std::shared_ptr<FlatArchive> FlatArchive::view(const void* data, std::size_t size, std::shared_ptr<const void> owner)
+{
+    const auto address = reinterpret_cast<std::uintptr_t>(data);
+    if ((address % kAlignment) != 0)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        auto archive = std::make_shared<FlatArchive>();
+        auto& impl = *archive->m_impl;
+        impl.buffer.resize(size + kAlignment);
+        const auto base = reinterpret_cast<std::uintptr_t>(impl.buffer.data());
+        char* aligned = impl.buffer.data() + (align(base) - base);
+        std::copy(bytes, bytes + size, aligned);
+        impl.data = aligned;
+        impl.size = size;
+        return impl.parse() ? archive : nullptr;
+    }
+
+    auto archive = std::make_shared<FlatArchive>();
+    archive->m_impl->owner = std::move(owner);
+    archive->m_impl->data = static_cast<const char*>(data);
+    archive->m_impl->size = size;
+    return archive->m_impl->parse() ? archive : nullptr;
+}
+
+bool FlatArchive::isFlat(std::istream& is)
+{
+    char magic[sizeof(kMagic)] = {};
+    is.read(magic, sizeof(magic));
+    return is.good() && std::equal(std::begin(kMagic), std::end(kMagic), magic);
+}
+
+bool FlatArchive::has(const std::string& name) const
+{
+    return m_impl->sections.count(name) > 0;
+}
+
+const void* FlatArchive::get(const std::string& name, std::size_t& size) const
+{
+    auto iter = m_impl->sections.find(name);
+    if (iter == m_impl->sections.end())
+    {
+        size = 0;
+        return nullptr;
+    }
+    size = iter->second.second;
+    return iter->second.first;
+}
+
+DRISHTI_CORE_NAMESPACE_END
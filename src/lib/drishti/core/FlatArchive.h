@@ -0,0 +1,104 @@
+/*! -*-c++-*-
+  @file   FlatArchive.h
+  @author David Hirvonen
+  @brief  Declaration of a versioned, aligned, offset based (zero parse) model archive.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Layout (little-endian):
+
+    Header   : magic "DRFA", version, section count, reserved (16 bytes)
+    Sections : { name[32], offset, size } per section (48 bytes each)
+    Payload  : section data, each aligned to kAlignment bytes
+
+  Archives are memory mapped (or read once into an aligned buffer for streams), so
+  models can evaluate directly from the section data with no deserialization, and
+  the pages of a mapped file are shared by every process that loads it.  Memory that
+  is already mapped by the caller (e.g., an uncompressed Android asset) is used in
+  place with view().
+
+*/
+
+#ifndef __drishti_core_FlatArchive_h__
+#define __drishti_core_FlatArchive_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class FlatArchiveWriter
+{
+public:
+    // Copies size bytes, the name must be unique and shorter than 32 characters:
+    void add(const std::string& name, const void* data, std::size_t size);
+
+    template <typename T>
+    void add(const std::string& name, const std::vector<T>& values)
+    {
+        add(name, values.data(), values.size() * sizeof(T));
+    }
+
+    bool write(std::ostream& os) const;
+    bool write(const std::string& filename) const;
+
+protected:
+    std::vector<std::pair<std::string, std::vector<char>>> m_sections;
+};
+
+class FlatArchive
+{
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::size_t kAlignment = 64;
+
+    class Impl;
+
+    FlatArchive();
+    ~FlatArchive();
+
+    FlatArchive(const FlatArchive&) = delete;
+    FlatArchive(FlatArchive&&) = delete;
+    FlatArchive& operator=(const FlatArchive&) = delete;
+    FlatArchive& operator=(FlatArchive&&) = delete;
+
+    // Memory map a file (read only), returns nullptr for invalid archives:
+    static std::shared_ptr<FlatArchive> map(const std::string& filename);
+
+    // Read a stream once (no seeking) into an aligned buffer, returns nullptr for invalid archives:
+    static std::shared_ptr<FlatArchive> read(std::istream& is);
+
+    // Use size bytes owned by the caller in place, owner is retained for the lifetime of the
+    // archive (data that isn't kAlignment aligned is copied once), returns nullptr for invalid archives:
+    static std::shared_ptr<FlatArchive> view(const void* data, std::size_t size, std::shared_ptr<const void> owner = nullptr);
+
+    // True if the stream starts with the archive magic (consumes 4 bytes):
+    static bool isFlat(std::istream& is);
+
+    bool has(const std::string& name) const;
+
+    // Section data in place (nullptr if missing), valid for the lifetime of the archive:
+    const void* get(const std::string& name, std::size_t& size) const;
+
+    template <typename T>
+    const T* get(const std::string& name, std::size_t& count) const
+    {
+        std::size_t size = 0;
+        const void* data = get(name, size);
+        count = size / sizeof(T);
+        return ((size % sizeof(T)) == 0) ? static_cast<const T*>(data) : nullptr;
+    }
+
+protected:
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_FlatArchive_h__
@@ -12,6 +12,7 @@
 #define __drishti_core_ImageView_h__
 
 #include <opencv2/core.hpp> // for cv::Mat4b
+#include <memory>
 #include <utility>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
@@ -26,6 +27,10 @@ struct Texture
     }
     cv::Size size;           //! Teture dimensions in pixels
     std::uint32_t texId = 0; //! Identifier for the texture
+
+    //! (optional) Ownership of a pooled texture: texId stays valid (and unmodified) while
+    //! any copy of the lease is held, and returns to the pool when the last one is released.
+    std::shared_ptr<void> lease;
 };
 
 struct ImageView
@@ -36,8 +41,9 @@ struct ImageView
         , image(std::move(image))
     {
     }
-    Texture texture; //! Texture descriptor
-    cv::Mat4b image; //! Image descriptor
+    Texture texture;  //! Texture descriptor
+    cv::Mat4b image;  //! Image descriptor
+    cv::Mat1b planes; //! Planar image descriptor (gray or I420 with rows = height * 3/2)
 };
 
 DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,90 @@
+/*! -*-c++-*-
+  @file   LazyChannelImage.cpp
+  @author David Hirvonen
+  @brief  Implementation of a lazily evaluated (resized) channel image.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/LazyChannelImage.h"
+#include "drishti/core/Arena.h"
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+LazyChannelImage::LazyChannelImage(const cv::Mat& image, float scale, int interpolation)
+    : m_source(image)
+    , m_scale(scale)
+    , m_interpolation(interpolation)
+{
+    CV_Assert(image.channels() <= 4);
+}
+
+cv::Size LazyChannelImage::size() const
+{
+    if (m_scale == 1.f)
+    {
+        return m_source.size();
+    }
+    return { cvRound(m_source.cols * m_scale), cvRound(m_source.rows * m_scale) };
+}
+
+cv::Mat LazyChannelImage::render(const cv::Mat& plane) const
+{
+    if (m_scale == 1.f)
+    {
+        return plane;
+    }
+
+    cv::Mat resized = arenaMat(); // heap allocated outside of a frame (see FrameArena)
+    cv::resize(plane, resized, {}, m_scale, m_scale, m_interpolation);
+    return resized;
+}
+
+const cv::Mat& LazyChannelImage::channel(int index)
+{
+    if (m_source.channels() == 1)
+    {
+        return image();
+    }
+
+    CV_Assert(index >= 0 && index < m_source.channels());
+    cv::Mat& plane = m_channels[index];
+    if (plane.empty())
+    {
+        if (!m_image.empty())
+        {
+            plane = arenaMat();
+            cv::extractChannel(m_image, plane, index); // already rendered
+        }
+        else
+        {
+            cv::Mat source = arenaMat();
+            cv::extractChannel(m_source, source, index);
+            plane = render(source);
+        }
+    }
+    return plane;
+}
+
+const cv::Mat& LazyChannelImage::image()
+{
+    if (m_image.empty() && !m_source.empty())
+    {
+        m_image = render(m_source);
+    }
+    return m_image;
+}
+
+const cv::Mat& LazyChannelImage::derived(int key, const Generator& generator)
+{
+    auto iter = m_derived.find(key);
+    if (iter == m_derived.end())
+    {
+        iter = m_derived.emplace(key, generator(image())).first;
+    }
+    return iter->second;
+}
+
+DRISHTI_CORE_NAMESPACE_END
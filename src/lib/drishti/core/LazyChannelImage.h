@@ -0,0 +1,66 @@
+/*! -*-c++-*-
+  @file   LazyChannelImage.h
+  @author David Hirvonen
+  @brief  Declaration of a lazily evaluated (resized) channel image.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Wraps a source image and a scale factor; each channel plane (or derived image)
+  is rendered at the target resolution on first request and cached for reuse.
+  Channels are extracted from the source and resized as single planes, so
+  unused channels cost nothing.  Not thread safe (intended for per call use).
+
+*/
+
+#ifndef __drishti_core_LazyChannelImage_h__
+#define __drishti_core_LazyChannelImage_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <array>
+#include <functional>
+#include <map>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class LazyChannelImage
+{
+public:
+    using Generator = std::function<cv::Mat(const cv::Mat& image)>;
+
+    LazyChannelImage() = default;
+    LazyChannelImage(const cv::Mat& image, float scale = 1.f, int interpolation = cv::INTER_CUBIC);
+
+    // Channel plane at the target resolution (single channel sources return the image for any index):
+    const cv::Mat& channel(int index);
+
+    // Full (multi-channel) image at the target resolution:
+    const cv::Mat& image();
+
+    // Image derived from image() with the provided generator, cached by key:
+    const cv::Mat& derived(int key, const Generator& generator);
+
+    cv::Size size() const;
+    int channels() const { return m_source.channels(); }
+    float getScale() const { return m_scale; }
+    bool empty() const { return m_source.empty(); }
+
+protected:
+    cv::Mat render(const cv::Mat& plane) const;
+
+    cv::Mat m_source;
+    float m_scale = 1.f;
+    int m_interpolation = cv::INTER_CUBIC;
+
+    cv::Mat m_image;
+    std::array<cv::Mat, 4> m_channels;
+    std::map<int, cv::Mat> m_derived;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_LazyChannelImage_h__
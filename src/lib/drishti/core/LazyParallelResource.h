@@ -6,6 +6,19 @@
   \copyright Copyright 2014-2016 Elucideye, Inc. All rights reserved.
   \license{This project is released under the 3 Clause BSD License.}
 
+  Values are allocated on first access per key (typically std::this_thread::get_id()).
+  Each thread caches its most recent (resource, key) -> value lookup in thread local
+  storage, so repeated lookups from the same thread never lock (C++11 thread_local only,
+  see DRISHTI_HAVE_THREAD_LOCAL_STORAGE, else every lookup locks).  std::map nodes are
+  stable, so cached references remain valid as other threads insert.  reserve() can
+  pre-allocate values concurrently so that the first batch doesn't serialize on the
+  allocator (e.g., model loading).
+
+  The allocator runs outside of the lock, possibly on several threads at once (misses
+  from different threads and reserve()), so it must be thread-safe, e.g., construct
+  an independent value from read only settings or from a factory that locks its own
+  shared state (see face::FaceDetectorFactory).
+
 */
 
 #ifndef __drishti_core_LazyParallelResource_h__
@@ -13,9 +26,14 @@
 
 #include "drishti/core/drishti_core.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
@@ -25,10 +43,12 @@ struct LazyParallelResource
     template <class Callable>
     LazyParallelResource(Callable&& func)
         : m_alloc(std::forward<Callable>(func))
+        , m_id(nextId())
     {
     }
     LazyParallelResource(LazyParallelResource&& other) noexcept
         : m_alloc(std::move(other.m_alloc))
+        , m_id(nextId())
     {
         other.m_alloc = nullptr;
     }
@@ -41,21 +61,118 @@ struct LazyParallelResource
 
     virtual Value& operator[](const Key& key)
     {
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+        // Fast path: last lookup from this thread (no lock)
+        Cache& cache = getCache();
+        if (cache.value && (cache.id == m_id) && isEqual(cache.key, key))
+        {
+            return *cache.value;
+        }
+
+        Value& value = find(key);
+        cache.id = m_id;
+        cache.key = key;
+        cache.value = &value;
+        return value;
+#else
+        return find(key);
+#endif
+    }
+
+    // Allocate n values up front (concurrently), consumed by the first misses:
+    void reserve(std::size_t n)
+    {
+        std::vector<Value> values(n);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            threads.emplace_back([this, &values, i]() { values[i] = m_alloc(); });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
         std::unique_lock<std::mutex> lock(m_mutex);
-        auto iter = m_map.find(key);
-        if (iter == m_map.end())
+        for (auto& value : values)
         {
-            return m_map[key] = m_alloc();
+            m_spare.push_back(std::move(value));
         }
-        return iter->second;
     }
 
+    // Allocated values (excluding the reserve), safe with concurrent lookups:
+    std::size_t size()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_map.size();
+    }
+
+    // Unsynchronized access (e.g., after the parallel section):
     std::map<Key, Value>& getMap() { return m_map; }
     const std::map<Key, Value>& getMap() const { return m_map; }
 
     std::map<Key, Value> m_map;
     std::mutex m_mutex;
-    std::function<Value()> m_alloc; // default allocator
+    std::function<Value()> m_alloc; // default allocator (thread-safe, see above)
+
+protected:
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+    struct Cache
+    {
+        std::uint64_t id = 0;
+        Key key{};
+        Value* value = nullptr;
+    };
+
+    static Cache& getCache()
+    {
+        static thread_local Cache cache;
+        return cache;
+    }
+#endif
+
+    static std::uint64_t nextId()
+    {
+        static std::atomic<std::uint64_t> counter{ 0 };
+        return ++counter; // unique per instance (no address reuse aliasing)
+    }
+
+    static bool isEqual(const Key& a, const Key& b)
+    {
+        return !(a < b) && !(b < a);
+    }
+
+    Value& find(const Key& key)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto iter = m_map.find(key);
+            if (iter != m_map.end())
+            {
+                return iter->second;
+            }
+            if (!m_spare.empty())
+            {
+                Value& value = m_map[key] = std::move(m_spare.back());
+                m_spare.pop_back();
+                return value;
+            }
+        }
+
+        // Allocate outside of the lock so concurrent misses don't serialize:
+        Value value = m_alloc();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto iter = m_map.find(key);
+        if (iter == m_map.end())
+        {
+            iter = m_map.emplace(key, std::move(value)).first;
+        }
+        return iter->second;
+    }
+
+    std::vector<Value> m_spare; // pre-allocated values (see reserve())
+    std::uint64_t m_id = 0;
 };
 
 DRISHTI_CORE_NAMESPACE_END
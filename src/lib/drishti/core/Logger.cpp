@@ -22,18 +22,16 @@
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 std::mutex Logger::m_mutex;
-int Logger::m_count = 0;
+std::atomic<int> Logger::m_count{ 0 };
 
 int Logger::count()
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    return m_count;
+    return m_count.load(std::memory_order_relaxed);
 }
 
 int Logger::increment()
 {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    return m_count++;
+    return m_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 std::shared_ptr<spdlog::logger> Logger::create(const char* name)
@@ -16,6 +16,7 @@
 
 #include "drishti/core/drishti_core.h"
 
+#include <atomic>
 #include <mutex>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
@@ -31,8 +32,8 @@ public:
     static int increment();
 
 protected:
-    static std::mutex m_mutex;
-    static int m_count;
+    static std::mutex m_mutex; // create()
+    static std::atomic<int> m_count;
 };
 
 // Enable only one of these:
@@ -0,0 +1,127 @@
+/*! -*-c++-*-
+  @file   MemoryRegistry.cpp
+  @author David Hirvonen
+  @brief  Implementation of a process wide registry of memory usage by category.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/MemoryRegistry.h"
+
+#include <algorithm>
+#include <utility>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+MemoryRegistry::Registration::Registration(MemoryRegistry* registry, std::uint64_t id)
+    : m_registry(registry)
+    , m_id(id)
+{
+}
+
+MemoryRegistry::Registration::Registration(Registration&& other) noexcept
+    : m_registry(other.m_registry)
+    , m_id(other.m_id)
+{
+    other.m_registry = nullptr;
+}
+
+MemoryRegistry::Registration& MemoryRegistry::Registration::operator=(Registration&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        m_registry = other.m_registry;
+        m_id = other.m_id;
+        other.m_registry = nullptr;
+    }
+    return *this;
+}
+
+MemoryRegistry::Registration::~Registration()
+{
+    reset();
+}
+
+void MemoryRegistry::Registration::reset()
+{
+    if (m_registry)
+    {
+        m_registry->remove(m_id);
+        m_registry = nullptr;
+    }
+}
+
+MemoryRegistry& MemoryRegistry::get()
+{
+    static MemoryRegistry registry;
+    return registry;
+}
+
+MemoryRegistry::Registration MemoryRegistry::add(Category category, std::string name, Probe probe)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::uint64_t id = ++m_next;
+    m_sources[id] = { category, std::move(name), std::move(probe) };
+    return { this, id };
+}
+
+void MemoryRegistry::remove(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sources.erase(id);
+}
+
+std::vector<MemoryRegistry::Item> MemoryRegistry::report() const
+{
+    std::vector<Item> items;
+    {
+        // Probes are called with the lock held, so owners can't unregister concurrently:
+        std::lock_guard<std::mutex> lock(m_mutex);
+        items.reserve(m_sources.size());
+        for (const auto& source : m_sources)
+        {
+            Item item;
+            item.category = source.second.category;
+            item.name = source.second.name;
+            item.bytes = source.second.probe ? source.second.probe() : 0;
+            items.push_back(std::move(item));
+        }
+    }
+
+    std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return (a.category < b.category) || ((a.category == b.category) && (a.name < b.name));
+    });
+    return items;
+}
+
+std::array<std::size_t, MemoryRegistry::kCategoryCount> MemoryRegistry::totals() const
+{
+    std::array<std::size_t, kCategoryCount> totals{};
+    for (const auto& item : report())
+    {
+        totals[item.category] += item.bytes;
+    }
+    return totals;
+}
+
+const char* MemoryRegistry::getName(Category category)
+{
+    switch (category)
+    {
+        case kModel:
+            return "model";
+        case kTexture:
+            return "texture";
+        case kPool:
+            return "pool";
+        case kScratch:
+            return "scratch";
+        default:
+            return "unknown";
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,103 @@
+/*! -*-c++-*-
+  @file   MemoryRegistry.h
+  @author David Hirvonen
+  @brief  Declaration of a process wide registry of memory usage by category.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Models, GPU texture owners, pools and scratch allocators register a probe that returns
+  their current size in bytes.  A report evaluates every probe, so sizes are current
+  without any bookkeeping in the hot path.  Registrations are RAII handles owned by the
+  measured object (declared after the members the probe reads), so a probe never
+  outlives its data.  Probes may be called from any thread and must be cheap: owners
+  whose state is only safe to read on one thread (e.g., GL objects) publish a size to an
+  atomic on that thread and return it from the probe.
+
+*/
+
+#ifndef __drishti_core_MemoryRegistry_h__
+#define __drishti_core_MemoryRegistry_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class MemoryRegistry
+{
+public:
+    enum Category
+    {
+        kModel,   // model weights (heap)
+        kTexture, // GPU textures
+        kPool,    // recycled buffers
+        kScratch, // per frame or per thread workspaces
+        kCategoryCount
+    };
+
+    using Probe = std::function<std::size_t()>;
+
+    struct Item
+    {
+        Category category = kModel;
+        std::string name;
+        std::size_t bytes = 0;
+    };
+
+    // Removes the probe on destruction:
+    class Registration
+    {
+    public:
+        Registration() = default;
+        Registration(MemoryRegistry* registry, std::uint64_t id);
+        Registration(Registration&& other) noexcept;
+        Registration& operator=(Registration&& other) noexcept;
+        ~Registration();
+
+        Registration(const Registration&) = delete;
+        Registration& operator=(const Registration&) = delete;
+
+        void reset();
+
+    protected:
+        MemoryRegistry* m_registry = nullptr;
+        std::uint64_t m_id = 0;
+    };
+
+    static MemoryRegistry& get();
+
+    Registration add(Category category, std::string name, Probe probe);
+
+    // One item per probe, sorted by category and name:
+    std::vector<Item> report() const;
+
+    std::array<std::size_t, kCategoryCount> totals() const;
+
+    static const char* getName(Category category);
+
+protected:
+    void remove(std::uint64_t id);
+
+    struct Source
+    {
+        Category category;
+        std::string name;
+        Probe probe;
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<std::uint64_t, Source> m_sources;
+    std::uint64_t m_next = 0;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_MemoryRegistry_h__
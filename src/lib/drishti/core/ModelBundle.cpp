@@ -0,0 +1,339 @@
+/*! -*-c++-*-
+  @file   ModelBundle.cpp
+  @author David Hirvonen
+  @brief  Implementation of a single file, indexed model bundle (model zoo in one archive).
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/ModelBundle.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <streambuf>
+
+// clang-format off
+#if defined(DRISHTI_USE_LZ4)
+#  include <lz4.h>
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+const char* ModelBundle::kIndex = "bundle.index";
+
+static const std::size_t kNameSize = 32;
+static const std::size_t kRecordSize = kNameSize + 16;
+
+template <typename T>
+static void putLE(char* data, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        data[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+template <typename T>
+static T getLE(const char* data)
+{
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        value |= static_cast<T>(static_cast<std::uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+// Read only, seekable view of memory that is kept alive by owner:
+class BundleStream : public std::istream
+{
+public:
+    BundleStream(std::shared_ptr<const void> owner, const char* data, std::size_t size)
+        : std::istream(nullptr)
+        , m_owner(std::move(owner))
+        , m_buffer(data, size)
+    {
+        rdbuf(&m_buffer);
+    }
+
+protected:
+    class Buffer : public std::streambuf
+    {
+    public:
+        Buffer(const char* data, std::size_t size)
+        {
+            char* begin = const_cast<char*>(data); // never written (no put area)
+            setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+        {
+            if (!(which & std::ios_base::in))
+            {
+                return pos_type(off_type(-1));
+            }
+
+            off_type base = 0;
+            switch (dir)
+            {
+                case std::ios_base::beg:
+                    base = 0;
+                    break;
+                case std::ios_base::cur:
+                    base = gptr() - eback();
+                    break;
+                default:
+                    base = egptr() - eback();
+                    break;
+            }
+
+            const off_type pos = base + off;
+            if ((pos < 0) || (pos > (egptr() - eback())))
+            {
+                return pos_type(off_type(-1));
+            }
+            setg(eback(), eback() + pos, egptr());
+            return pos_type(pos);
+        }
+
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+        {
+            return seekoff(off_type(pos), std::ios_base::beg, which);
+        }
+    };
+
+    std::shared_ptr<const void> m_owner;
+    Buffer m_buffer;
+};
+
+// ### ModelBundle ###
+
+std::uint32_t ModelBundle::crc32(const void* data, std::size_t size, std::uint32_t crc)
+{
+    static const auto table = []() {
+        std::array<std::uint32_t, 256> values{ {} };
+        for (std::uint32_t i = 0; i < 256; i++)
+        {
+            std::uint32_t value = i;
+            for (int k = 0; k < 8; k++)
+            {
+                value = (value & 1) ? (0xedb88320u ^ (value >> 1)) : (value >> 1);
+            }
+            values[i] = value;
+        }
+        return values;
+    }();
+
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool ModelBundle::hasCompression(Compression compression)
+{
+    switch (compression)
+    {
+        case kStored:
+            return true;
+#if defined(DRISHTI_USE_LZ4)
+        case kLZ4:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+std::shared_ptr<ModelBundle> ModelBundle::map(const std::string& filename)
+{
+    auto bundle = std::make_shared<ModelBundle>();
+    bundle->m_archive = FlatArchive::map(filename);
+    return bundle->parse() ? bundle : nullptr;
+}
+
+std::shared_ptr<ModelBundle> ModelBundle::read(std::istream& is)
+{
+    auto bundle = std::make_shared<ModelBundle>();
+    bundle->m_archive = FlatArchive::read(is);
+    return bundle->parse() ? bundle : nullptr;
+}
+
+std::shared_ptr<ModelBundle> ModelBundle::view(const void* data, std::size_t size, std::shared_ptr<const void> owner)
+{
+    auto bundle = std::make_shared<ModelBundle>();
+    bundle->m_archive = FlatArchive::view(data, size, std::move(owner));
+    return bundle->parse() ? bundle : nullptr;
+}
+
+bool ModelBundle::isBundle(const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    return ifs && FlatArchive::isFlat(ifs) && map(filename); // flat models have no index
+}
+
+bool ModelBundle::parse()
+{
+    std::size_t size = 0;
+    const char* index = m_archive ? static_cast<const char*>(m_archive->get(kIndex, size)) : nullptr;
+    if (!index || (size % kRecordSize))
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < size / kRecordSize; i++)
+    {
+        const char* record = index + i * kRecordSize;
+
+        Entry entry;
+        entry.name.assign(record, std::find(record, record + kNameSize, '\0'));
+        entry.size = getLE<std::uint64_t>(record + kNameSize);
+        entry.crc32 = getLE<std::uint32_t>(record + kNameSize + 8);
+        entry.compression = static_cast<Compression>(getLE<std::uint32_t>(record + kNameSize + 12));
+        if (!m_archive->has(entry.name))
+        {
+            return false;
+        }
+        m_entries.push_back(std::move(entry));
+    }
+
+    return true;
+}
+
+const ModelBundle::Entry* ModelBundle::find(const std::string& name) const
+{
+    auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& entry) { return entry.name == name; });
+    return (iter != m_entries.end()) ? &(*iter) : nullptr;
+}
+
+std::shared_ptr<std::istream> ModelBundle::open(const std::string& name) const
+{
+    const Entry* entry = find(name);
+    if (!entry || !hasCompression(entry->compression))
+    {
+        return nullptr;
+    }
+
+    std::size_t size = 0;
+    const char* data = static_cast<const char*>(m_archive->get(name, size));
+
+    std::shared_ptr<const void> owner = m_archive;
+    if (entry->compression != kStored)
+    {
+#if defined(DRISHTI_USE_LZ4)
+        const auto limit = static_cast<std::uint64_t>(std::numeric_limits<int>::max());
+        if ((entry->size > limit) || (size > limit))
+        {
+            return nullptr;
+        }
+
+        auto decoded = std::make_shared<std::vector<char>>(static_cast<std::size_t>(entry->size));
+        const int length = LZ4_decompress_safe(data, decoded->data(), static_cast<int>(size), static_cast<int>(decoded->size()));
+        if (length != static_cast<int>(decoded->size()))
+        {
+            return nullptr;
+        }
+        data = decoded->data();
+        size = decoded->size();
+        owner = decoded;
+#endif
+    }
+
+    if ((size != entry->size) || (crc32(data, size) != entry->crc32))
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<BundleStream>(std::move(owner), data, size);
+}
+
+// ### ModelBundleWriter ###
+
+void ModelBundleWriter::add(const std::string& name, const void* data, std::size_t size, ModelBundle::Compression compression)
+{
+    ModelBundle::Entry entry;
+    entry.name = name;
+    entry.size = size;
+    entry.crc32 = ModelBundle::crc32(data, size);
+
+#if defined(DRISHTI_USE_LZ4)
+    if ((compression == ModelBundle::kLZ4) && (size <= static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE)))
+    {
+        std::vector<char> encoded(LZ4_compressBound(static_cast<int>(size)));
+        const int length = LZ4_compress_default(static_cast<const char*>(data), encoded.data(), static_cast<int>(size), static_cast<int>(encoded.size()));
+        if ((length > 0) && (static_cast<std::size_t>(length) < size))
+        {
+            entry.compression = ModelBundle::kLZ4;
+            m_archive.add(name, encoded.data(), static_cast<std::size_t>(length));
+            m_entries.push_back(std::move(entry));
+            return;
+        }
+    }
+#else
+    static_cast<void>(compression);
+#endif
+
+    m_archive.add(name, data, size);
+    m_entries.push_back(std::move(entry));
+}
+
+bool ModelBundleWriter::add(const std::string& name, std::istream& is, ModelBundle::Compression compression)
+{
+    std::vector<char> data{ std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>() };
+    if (is.bad())
+    {
+        return false;
+    }
+    add(name, data.data(), data.size(), compression);
+    return true;
+}
+
+bool ModelBundleWriter::addFile(const std::string& name, const std::string& filename, ModelBundle::Compression compression)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    return ifs && add(name, ifs, compression);
+}
+
+bool ModelBundleWriter::write(std::ostream& os) const
+{
+    std::set<std::string> names;
+    std::vector<char> index(m_entries.size() * kRecordSize, 0);
+    for (std::size_t i = 0; i < m_entries.size(); i++)
+    {
+        const auto& entry = m_entries[i];
+        if ((entry.name == ModelBundle::kIndex) || !names.insert(entry.name).second)
+        {
+            return false; // the archive rejects empty and long names
+        }
+
+        char* record = index.data() + i * kRecordSize;
+        std::copy(entry.name.begin(), entry.name.begin() + std::min(entry.name.size(), kNameSize), record);
+        putLE<std::uint64_t>(record + kNameSize, entry.size);
+        putLE<std::uint32_t>(record + kNameSize + 8, entry.crc32);
+        putLE<std::uint32_t>(record + kNameSize + 12, entry.compression);
+    }
+
+    FlatArchiveWriter archive = m_archive;
+    archive.add(ModelBundle::kIndex, index);
+    return archive.write(os);
+}
+
+bool ModelBundleWriter::write(const std::string& filename) const
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    return ofs && write(ofs);
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,110 @@
+/*! -*-c++-*-
+  @file   ModelBundle.h
+  @author David Hirvonen
+  @brief  Declaration of a single file, indexed model bundle (model zoo in one archive).
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A bundle is a FlatArchive with one section per model (the serialized model file,
+  stored or compressed) and an index section with one record per entry (little-endian):
+
+    { name[32], size (decoded), crc32 (decoded), compression } (48 bytes each)
+
+  so a model zoo is opened (or memory mapped) once, each entry is aligned, and entries
+  are verified and decoded independently when they are opened (e.g., concurrently from
+  FaceDetectorFactory::loadAsync()).  Stored entries are read in place.
+
+*/
+
+#ifndef __drishti_core_ModelBundle_h__
+#define __drishti_core_ModelBundle_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/FlatArchive.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class ModelBundle
+{
+public:
+    enum Compression : std::uint32_t
+    {
+        kStored = 0,
+        kLZ4 // requires DRISHTI_USE_LZ4
+    };
+
+    struct Entry
+    {
+        std::string name;
+        std::uint64_t size = 0; // decoded size
+        std::uint32_t crc32 = 0;
+        Compression compression = kStored;
+    };
+
+    static const char* kIndex; // index section name
+
+    ModelBundle() = default;
+
+    ModelBundle(const ModelBundle&) = delete;
+    ModelBundle(ModelBundle&&) = delete;
+    ModelBundle& operator=(const ModelBundle&) = delete;
+    ModelBundle& operator=(ModelBundle&&) = delete;
+
+    // See FlatArchive::map(), read() and view(), these return nullptr for invalid bundles:
+    static std::shared_ptr<ModelBundle> map(const std::string& filename);
+    static std::shared_ptr<ModelBundle> read(std::istream& is);
+    static std::shared_ptr<ModelBundle> view(const void* data, std::size_t size, std::shared_ptr<const void> owner = nullptr);
+
+    // True if the file is an archive with a bundle index:
+    static bool isBundle(const std::string& filename);
+
+    static bool hasCompression(Compression compression);
+
+    const std::vector<Entry>& getEntries() const { return m_entries; }
+    const Entry* find(const std::string& name) const;
+    bool has(const std::string& name) const { return find(name) != nullptr; }
+
+    // Seekable stream over the decoded entry, or nullptr if the entry is missing, can't be
+    // decoded or fails the checksum.  Stored entries are used in place, and each stream
+    // keeps the bundle alive, so entries can be opened concurrently:
+    std::shared_ptr<std::istream> open(const std::string& name) const;
+
+    // CRC-32 (IEEE 802.3), pass the previous value to continue a checksum:
+    static std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0);
+
+protected:
+    bool parse();
+
+    std::shared_ptr<FlatArchive> m_archive;
+    std::vector<Entry> m_entries;
+};
+
+class ModelBundleWriter
+{
+public:
+    // Copies size bytes, the name must be unique and shorter than 32 characters, and
+    // entries fall back to kStored when the compression isn't available (or doesn't help):
+    void add(const std::string& name, const void* data, std::size_t size, ModelBundle::Compression compression = ModelBundle::kStored);
+
+    // Adds the remaining stream contents (or a file), returns false if it can't be read:
+    bool add(const std::string& name, std::istream& is, ModelBundle::Compression compression = ModelBundle::kStored);
+    bool addFile(const std::string& name, const std::string& filename, ModelBundle::Compression compression = ModelBundle::kStored);
+
+    bool write(std::ostream& os) const;
+    bool write(const std::string& filename) const;
+
+protected:
+    FlatArchiveWriter m_archive;
+    std::vector<ModelBundle::Entry> m_entries;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_ModelBundle_h__
@@ -0,0 +1,117 @@
+/*! -*-c++-*-
+  @file   ModelStream.cpp
+  @author David Hirvonen
+  @brief  Implementation of a single pass (non seeking) model container reader.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/ModelStream.h"
+
+#include <algorithm>
+#include <iterator>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static const char kMagic[4] = { 'D', 'R', 'M', 'C' };
+static const std::uint32_t kMaxSections = 256;
+
+template <typename T>
+static bool readLE(std::istream& is, T& value)
+{
+    unsigned char bytes[sizeof(T)];
+    if (!is.read(reinterpret_cast<char*>(bytes), sizeof(T)))
+    {
+        return false;
+    }
+    value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        value |= static_cast<T>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+template <typename T>
+static void writeLE(std::ostream& os, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); i++)
+    {
+        os.put(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+ModelStream::ModelStream(std::istream& is)
+    : m_buffer(is.rdbuf())
+    , m_stream(&m_buffer)
+{
+    // Probe the magic, and replay it for bare streams:
+    char magic[sizeof(kMagic)] = {};
+    const auto count = static_cast<std::size_t>(is.rdbuf()->sgetn(magic, sizeof(magic)));
+    if ((count != sizeof(magic)) || !std::equal(std::begin(kMagic), std::end(kMagic), magic))
+    {
+        m_buffer.setPrefix(std::string(magic, count));
+        return;
+    }
+
+    std::uint32_t version = 0, type = 0, sections = 0;
+    if (!readLE(m_stream, version) || (version != kVersion) || !readLE(m_stream, type) || !readLE(m_stream, sections) || (sections > kMaxSections))
+    {
+        m_stream.setstate(std::ios::failbit); // unsupported container
+        return;
+    }
+
+    for (std::uint32_t i = 0; i < sections; i++)
+    {
+        std::uint32_t encoding = 0;
+        Section section;
+        if (!readLE(m_stream, encoding) || !readLE(m_stream, section.size))
+        {
+            m_stream.setstate(std::ios::failbit);
+            return;
+        }
+        section.encoding = static_cast<Encoding>(encoding);
+        m_sections.push_back(section);
+    }
+
+    m_hasContainer = true;
+    m_type = static_cast<Type>(type);
+}
+
+bool ModelStream::writeHeader(std::ostream& os, Type type, const std::vector<Section>& sections)
+{
+    os.write(kMagic, sizeof(kMagic));
+    writeLE<std::uint32_t>(os, kVersion);
+    writeLE<std::uint32_t>(os, type);
+    writeLE<std::uint32_t>(os, static_cast<std::uint32_t>(sections.size()));
+    for (const auto& section : sections)
+    {
+        writeLE<std::uint32_t>(os, section.encoding);
+        writeLE<std::uint64_t>(os, section.size);
+    }
+    return os.good();
+}
+
+// ### ReplayBuf ###
+
+ModelStream::ReplayBuf::int_type ModelStream::ReplayBuf::underflow()
+{
+    return (m_pos < m_prefix.size()) ? traits_type::to_int_type(m_prefix[m_pos]) : m_source->sgetc();
+}
+
+ModelStream::ReplayBuf::int_type ModelStream::ReplayBuf::uflow()
+{
+    return (m_pos < m_prefix.size()) ? traits_type::to_int_type(m_prefix[m_pos++]) : m_source->sbumpc();
+}
+
+std::streamsize ModelStream::ReplayBuf::xsgetn(char* s, std::streamsize n)
+{
+    const auto replay = static_cast<std::streamsize>(std::min(m_prefix.size() - m_pos, static_cast<std::size_t>(n)));
+    std::copy(m_prefix.begin() + m_pos, m_prefix.begin() + m_pos + replay, s);
+    m_pos += static_cast<std::size_t>(replay);
+    return replay + ((n > replay) ? m_source->sgetn(s + replay, n - replay) : 0);
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,119 @@
+/*! -*-c++-*-
+  @file   ModelStream.h
+  @author David Hirvonen
+  @brief  Declaration of a single pass (non seeking) model container reader.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Optional container header (little-endian):
+
+    magic "DRMC", version, model type, section count, { encoding, size } per section
+
+  followed by the section payloads in order.  The header is identified from the first
+  bytes of the stream in one forward read, and bare (legacy) cereal portable binary
+  streams are replayed to the decoder, so a model never needs seekg() and can be loaded
+  from compressed assets or network streams.
+
+*/
+
+#ifndef __drishti_core_ModelStream_h__
+#define __drishti_core_ModelStream_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class ModelStream
+{
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    enum Type : std::uint32_t
+    {
+        kUnknown = 0,
+        kObjectDetector,
+        kShapeEstimator,
+        kEyeModelEstimator,
+        kCPR,
+        kFaceModel,
+        kXGBooster
+    };
+
+    enum Encoding : std::uint32_t
+    {
+        kCPB = 0, // cereal::PortableBinaryArchive
+        kFlat     // core::FlatArchive
+    };
+
+    struct Section
+    {
+        Encoding encoding = kCPB;
+        std::uint64_t size = 0;
+    };
+
+    // Reads the container header if present (the stream is never rewound):
+    explicit ModelStream(std::istream& is);
+
+    ModelStream(const ModelStream&) = delete;
+    ModelStream(ModelStream&&) = delete;
+    ModelStream& operator=(const ModelStream&) = delete;
+    ModelStream& operator=(ModelStream&&) = delete;
+
+    bool hasContainer() const { return m_hasContainer; }
+    Type getType() const { return m_type; }
+    const std::vector<Section>& getSections() const { return m_sections; }
+
+    // Encoding of the first payload (bare streams are cereal portable binary):
+    Encoding getEncoding() const { return m_sections.empty() ? kCPB : m_sections.front().encoding; }
+
+    // Payload stream, positioned at the first section:
+    std::istream& get() { return m_stream; }
+
+    static bool writeHeader(std::ostream& os, Type type, const std::vector<Section>& sections);
+
+protected:
+    // Replays bytes consumed while probing, then reads the source directly (no buffering,
+    // so the source is never read past the end of the model):
+    class ReplayBuf : public std::streambuf
+    {
+    public:
+        explicit ReplayBuf(std::streambuf* source)
+            : m_source(source)
+        {
+        }
+
+        void setPrefix(std::string prefix)
+        {
+            m_prefix = std::move(prefix);
+            m_pos = 0;
+        }
+
+    protected:
+        int_type underflow() override;
+        int_type uflow() override;
+        std::streamsize xsgetn(char* s, std::streamsize n) override;
+
+        std::streambuf* m_source = nullptr;
+        std::string m_prefix;
+        std::size_t m_pos = 0;
+    };
+
+    ReplayBuf m_buffer;
+    std::istream m_stream;
+
+    bool m_hasContainer = false;
+    Type m_type = kUnknown;
+    std::vector<Section> m_sections;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_ModelStream_h__
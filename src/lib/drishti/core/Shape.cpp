@@ -14,8 +14,12 @@
 
 #include <unsupported/Eigen/Splines>
 
+#include <algorithm>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <tuple>
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
@@ -203,6 +207,79 @@ void upsample(const PointVec& controlPoints, PointVec& interpolatedPoints, int f
     }
 }
 
+static cv::Mat1f createSplineBasis(int n, int count, bool closed)
+{
+    using Spline1d = Eigen::Spline<double, 1>;
+
+    // Knot parameters of the (wrapped) control points:
+    const int length = n + int(closed);
+    Spline1d::KnotVectorType parameters(length);
+    for (int j = 0; j < length; j++)
+    {
+        parameters(j) = double(j) / double(closed ? n : (n - 1));
+    }
+
+    // The interpolant is linear in the control points: column j is the spline through e_j
+    const int degree = std::min(3, length - 1);
+    cv::Mat1f basis(count, n, 0.f);
+    for (int j = 0; j < n; j++)
+    {
+        Spline1d::ControlPointVectorType points = Spline1d::ControlPointVectorType::Zero(1, length);
+        points(0, j) = 1.0;
+        if (closed && (j == 0))
+        {
+            points(0, n) = 1.0;
+        }
+
+        const Spline1d spline = Eigen::SplineFitting<Spline1d>::Interpolate(points, degree, parameters);
+        for (int i = 0; i < count; i++)
+        {
+            const double u = closed ? (double(i) / count) : (double(i) / std::max(count - 1, 1));
+            basis(i, j) = static_cast<float>(spline(u)(0, 0));
+        }
+    }
+    return basis;
+}
+
+const cv::Mat1f& getSplineBasis(int n, int count, bool closed)
+{
+    static std::mutex mutex;
+    static std::map<std::tuple<int, int, bool>, cv::Mat1f> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& basis = cache[std::make_tuple(n, count, closed)];
+    if (basis.empty())
+    {
+        basis = createSplineBasis(n, count, closed);
+    }
+    return basis; // map nodes are stable, entries are never modified once created
+}
+
+void fitSplineUniform(const PointVec& controlPoints, PointVec& interpolatedPoints, int count, bool closed)
+{
+    if ((controlPoints.size() < 2) || (count < 1))
+    {
+        interpolatedPoints = controlPoints;
+        return;
+    }
+
+    if (&controlPoints == &interpolatedPoints)
+    {
+        const PointVec points = controlPoints;
+        fitSplineUniform(points, interpolatedPoints, count, closed);
+        return;
+    }
+
+    const int n = int(controlPoints.size());
+    const cv::Mat1f& basis = getSplineBasis(n, count, closed);
+
+    // ( count x n ) * ( n x 2 ) with x and y interleaved in the point buffers:
+    interpolatedPoints.resize(count);
+    cv::Mat1f P(n, 2, const_cast<float*>(&controlPoints.front().x));
+    cv::Mat1f Q(count, 2, &interpolatedPoints.front().x);
+    cv::gemm(basis, P, 1.0, cv::noArray(), 0.0, Q);
+}
+
 // These OpenCV functions must be in global namespace
 void write(cv::FileStorage& fs, const std::string&, const drishti::core::Shape& x)
 {
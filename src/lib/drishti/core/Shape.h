@@ -28,6 +28,15 @@ void fitSpline(const PointVec& controlPoints, PointVec& interpolatedPoints, int
 
 void upsample(const PointVec& controlPoints, PointVec& interpolatedPoints, int factor, bool closed);
 
+// Interpolating cubic spline with uniform parameters (control point j at u = j / n for closed
+// curves and u = j / (n - 1) for open curves).  Unlike the chord length parameterization of
+// fitSpline() the samples are a fixed linear combination of the control points, so the
+// (count x n) basis is computed once per (n, count, closed) and cached (thread safe), and each
+// fit is a single matrix product.  Closed curves are sampled at u = i / count and open curves
+// at u = i / (count - 1), including both end points.
+const cv::Mat1f& getSplineBasis(int n, int count, bool closed);
+void fitSplineUniform(const PointVec& controlPoints, PointVec& interpolatedPoints, int count, bool closed);
+
 template <typename T>
 inline cv::Point_<T> centroid(const std::vector<cv::Point_<T>>& contour, int n = std::numeric_limits<int>::max())
 {
@@ -0,0 +1,105 @@
+/*! -*-c++-*-
+  @file   SharedPool.h
+  @author David Hirvonen
+  @brief  Declaration of a recycling pool of shared objects.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  acquire() returns a std::shared_ptr<T> whose deleter hands the object back to the
+  pool when the last reference is released (from any thread), so objects with large
+  preallocated buffers can be recycled across frames.  Objects released after the pool
+  is destroyed (or cleared) are simply deleted.
+
+*/
+
+#ifndef __drishti_core_SharedPool_h__
+#define __drishti_core_SharedPool_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+template <typename T>
+class SharedPool
+{
+public:
+    using Allocator = std::function<std::unique_ptr<T>()>;
+
+    explicit SharedPool(Allocator alloc)
+        : m_state(std::make_shared<State>())
+    {
+        m_state->alloc = std::move(alloc);
+    }
+
+    // Recycle a free object, or allocate a new one:
+    std::shared_ptr<T> acquire()
+    {
+        std::unique_ptr<T> object;
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            if (!m_state->free.empty())
+            {
+                object = std::move(m_state->free.back());
+                m_state->free.pop_back();
+            }
+        }
+
+        if (!object)
+        {
+            object = m_state->alloc();
+            m_state->allocated++;
+        }
+
+        std::weak_ptr<State> state = m_state;
+        return std::shared_ptr<T>(object.release(), [state](T* ptr) {
+            std::unique_ptr<T> object(ptr);
+            if (auto pool = state.lock())
+            {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->free.push_back(std::move(object));
+            }
+        });
+    }
+
+    // Drop free objects, objects still in use are deleted when released:
+    void clear()
+    {
+        auto alloc = m_state->alloc;
+        m_state = std::make_shared<State>();
+        m_state->alloc = std::move(alloc);
+    }
+
+    std::size_t available() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->free.size();
+    }
+
+    // Objects allocated since construction (or the last clear()):
+    std::size_t allocated() const
+    {
+        return m_state->allocated;
+    }
+
+protected:
+    struct State
+    {
+        Allocator alloc;
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<T>> free;
+        std::atomic<std::size_t> allocated{ 0 };
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_SharedPool_h__
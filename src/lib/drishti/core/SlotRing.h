@@ -0,0 +1,199 @@
+/*! -*-c++-*-
+  @file   SlotRing.h
+  @author David Hirvonen
+  @brief  Declaration of a single producer ring of preallocated job slots.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A SlotRing hands items from one producer thread (e.g., the GL thread) to one
+  persistent worker thread that runs the same job on each item in submission order.
+  Slots are allocated once, and ownership of a slot moves between the two threads
+  through its atomic state (free -> submitted -> done -> free), so a frame costs no
+  allocation (no std::packaged_task or std::future) and the producer never waits for
+  a job unless it calls wait().  The mutex only parks the idle worker and is never
+  held while a job runs.
+
+*/
+
+#ifndef __drishti_core_SlotRing_h__
+#define __drishti_core_SlotRing_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+template <typename T>
+class SlotRing
+{
+public:
+    // Runs on the worker thread, exceptions are rethrown by get():
+    using Job = std::function<void(T& item)>;
+
+    SlotRing(std::size_t capacity, Job job)
+        : m_slots(std::max(capacity, std::size_t(1)))
+        , m_job(std::move(job))
+    {
+        m_thread = std::thread([this]() { loop(); });
+    }
+
+    // Submitted jobs run to completion before the worker exits:
+    ~SlotRing()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+    }
+
+    SlotRing(const SlotRing&) = delete;
+    SlotRing(SlotRing&&) = delete;
+    SlotRing& operator=(const SlotRing&) = delete;
+    SlotRing& operator=(SlotRing&&) = delete;
+
+    // ::: Producer thread only :::
+
+    // The next free slot (nullptr when all slots are in use), submitted by push():
+    T* acquire()
+    {
+        return (m_count < m_slots.size()) ? &slot(m_count).item : nullptr;
+    }
+
+    void push()
+    {
+        slot(m_count++).state.store(kSubmitted, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex); // the worker is either waiting or will see the slot
+        }
+        m_condition.notify_one();
+    }
+
+    // Submitted items that haven't been released by pop(), index 0 is the oldest:
+    std::size_t size() const { return m_count; }
+    std::size_t capacity() const { return m_slots.size(); }
+
+    bool isDone(std::size_t index) const
+    {
+        return slot(index).state.load(std::memory_order_acquire) == kDone;
+    }
+
+    void wait(std::size_t index) const
+    {
+        const Slot& s = slot(index);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&]() { return s.state.load(std::memory_order_acquire) == kDone; });
+    }
+
+    // Item of a completed job:
+    T& get(std::size_t index)
+    {
+        Slot& s = slot(index);
+        if (s.error)
+        {
+            std::exception_ptr error = s.error;
+            s.error = nullptr;
+            std::rethrow_exception(error);
+        }
+        return s.item;
+    }
+
+    // Item of a completed job, ignoring the job's exception (e.g., results that are discarded):
+    T& at(std::size_t index)
+    {
+        return slot(index).item;
+    }
+
+    // Release the oldest item (its job must be done), the slot is reused as is:
+    void pop()
+    {
+        slot(0).error = nullptr;
+        slot(0).state.store(kFree, std::memory_order_relaxed);
+        m_head = (m_head + 1) % m_slots.size();
+        m_count--;
+    }
+
+    void drain() const
+    {
+        if (m_count > 0)
+        {
+            wait(m_count - 1); // jobs complete in order
+        }
+    }
+
+protected:
+    enum State
+    {
+        kFree,
+        kSubmitted,
+        kDone
+    };
+
+    struct Slot
+    {
+        T item;
+        std::exception_ptr error;
+        std::atomic<int> state{ kFree };
+    };
+
+    Slot& slot(std::size_t index) { return m_slots[(m_head + index) % m_slots.size()]; }
+    const Slot& slot(std::size_t index) const { return m_slots[(m_head + index) % m_slots.size()]; }
+
+    void loop()
+    {
+        for (std::size_t next = 0;; next = (next + 1) % m_slots.size())
+        {
+            Slot& s = m_slots[next];
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [&]() { return m_stop || (s.state.load(std::memory_order_acquire) == kSubmitted); });
+                if (s.state.load(std::memory_order_acquire) != kSubmitted)
+                {
+                    return; // stopped with nothing left to run
+                }
+            }
+
+            try
+            {
+                m_job(s.item);
+            }
+            catch (...)
+            {
+                s.error = std::current_exception();
+            }
+
+            s.state.store(kDone, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+            }
+            m_done.notify_all();
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    std::size_t m_head = 0;  // oldest submitted slot (producer)
+    std::size_t m_count = 0; // submitted and not released (producer)
+
+    Job m_job;
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;    // worker: slot submitted or stop
+    mutable std::condition_variable m_done; // producer: slot done
+    bool m_stop = false;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_SlotRing_h__
@@ -0,0 +1,68 @@
+/*! -*-c++-*-
+  @file   SpinBarrier.h
+  @author David Hirvonen
+  @brief  Reusable spinning thread barrier from C++11 atomics.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_SpinBarrier_h__
+#define __drishti_core_SpinBarrier_h__ 1
+
+#include "drishti/core/drishti_core.h"
+
+#include <atomic>
+#include <thread>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// For short (microsecond) phases shared by threads that are already running,
+// i.e., lanes of a WorkerGroup.  Spins briefly and then yields.
+class SpinBarrier
+{
+public:
+    explicit SpinBarrier(int count)
+        : m_count(count)
+        , m_remaining(count)
+    {
+    }
+
+    void wait()
+    {
+        const unsigned int generation = m_generation.load(std::memory_order_acquire);
+        if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Last thread to arrive resets the count and releases the others:
+            m_remaining.store(m_count, std::memory_order_relaxed);
+            m_generation.fetch_add(1, std::memory_order_release);
+        }
+        else
+        {
+            for (int spins = 0; m_generation.load(std::memory_order_acquire) == generation; spins++)
+            {
+                if (spins >= kSpinCount)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    int size() const
+    {
+        return m_count;
+    }
+
+protected:
+    static const int kSpinCount = 1024;
+
+    const int m_count;
+    std::atomic<int> m_remaining;
+    std::atomic<unsigned int> m_generation{ 0 };
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_SpinBarrier_h__
@@ -0,0 +1,211 @@
+/*! -*-c++-*-
+  @file   StageTracer.cpp
+  @author David Hirvonen
+  @brief  Implementation of a lock-free per-frame stage span recorder.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/StageTracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+static std::size_t nextPowerOfTwo(std::size_t n)
+{
+    std::size_t value = 1;
+    while (value < n)
+    {
+        value <<= 1;
+    }
+    return value;
+}
+
+StageTracer::StageTracer(std::vector<std::string> stages, std::size_t capacity)
+    : m_stages(std::move(stages))
+    , m_capacity(nextPowerOfTwo(std::max(capacity, std::size_t(1))))
+    , m_slots(new Slot[m_capacity])
+    , m_epoch(HighResolutionClock::now())
+{
+}
+
+StageTracer::~StageTracer() = default;
+
+void StageTracer::record(int stage, std::uint64_t frame, double duration)
+{
+    record(stage, frame, duration, HighResolutionClock::now(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+void StageTracer::record(int stage, std::uint64_t frame, double duration, const TimePoint& stop, std::uint64_t thread)
+{
+    const double end = ScopeTimeLogger::timeDifference(stop, m_epoch);
+    const std::uint64_t ticket = m_head.fetch_add(1, std::memory_order_relaxed);
+
+    // Single writer per ticket (seqlock): mark the slot busy, write, then publish.
+    Slot& slot = m_slots[ticket & (m_capacity - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.stage.store(stage, std::memory_order_relaxed);
+    slot.frame.store(frame, std::memory_order_relaxed);
+    slot.thread.store(thread, std::memory_order_relaxed);
+    slot.start.store(end - duration, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    slot.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+ScopeTimeLogger StageTracer::scope(int stage, std::uint64_t frame)
+{
+    return ScopeTimeLogger([this, stage, frame](double elapsed) { record(stage, frame, elapsed); });
+}
+
+bool StageTracer::read(const Slot& slot, Span& span) const
+{
+    const std::uint64_t s1 = slot.sequence.load(std::memory_order_acquire);
+    if (s1 == 0)
+    {
+        return false;
+    }
+
+    span.stage = slot.stage.load(std::memory_order_relaxed);
+    span.frame = slot.frame.load(std::memory_order_relaxed);
+    span.thread = slot.thread.load(std::memory_order_relaxed);
+    span.start = slot.start.load(std::memory_order_relaxed);
+    span.duration = slot.duration.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (slot.sequence.load(std::memory_order_relaxed) == s1);
+}
+
+std::vector<StageTracer::Span> StageTracer::getSpans() const
+{
+    const std::uint64_t head = m_head.load(std::memory_order_acquire);
+    const std::uint64_t tail = (head > m_capacity) ? (head - m_capacity) : 0;
+
+    std::vector<Span> spans;
+    spans.reserve(head - tail);
+    for (std::uint64_t ticket = tail; ticket < head; ticket++)
+    {
+        const Slot& slot = m_slots[ticket & (m_capacity - 1)];
+
+        Span span;
+        if (read(slot, span) && (slot.sequence.load(std::memory_order_relaxed) == (ticket + 1)))
+        {
+            spans.push_back(span);
+        }
+    }
+    return spans;
+}
+
+std::vector<StageTracer::Span> StageTracer::getSpans(int stage) const
+{
+    auto spans = getSpans();
+    spans.erase(std::remove_if(spans.begin(), spans.end(), [stage](const Span& s) { return s.stage != stage; }), spans.end());
+    return spans;
+}
+
+double StageTracer::percentile(int stage, double p) const
+{
+    std::vector<double> values;
+    for (const auto& span : getSpans(stage))
+    {
+        values.push_back(span.duration);
+    }
+
+    if (values.empty())
+    {
+        return 0.0;
+    }
+
+    // Nearest rank:
+    const double rank = std::ceil(std::min(std::max(p, 0.0), 1.0) * static_cast<double>(values.size()));
+    const auto index = static_cast<std::size_t>(std::max(rank, 1.0)) - 1;
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+using Interval = std::pair<double, double>;
+
+// Sorted, disjoint union of the spans for the given stages:
+static std::vector<Interval> merge(const std::vector<StageTracer::Span>& spans, const std::vector<int>& stages)
+{
+    std::vector<Interval> intervals;
+    for (const auto& span : spans)
+    {
+        if (std::find(stages.begin(), stages.end(), span.stage) != stages.end())
+        {
+            intervals.emplace_back(span.start, span.start + span.duration);
+        }
+    }
+    std::sort(intervals.begin(), intervals.end());
+
+    std::vector<Interval> merged;
+    for (const auto& interval : intervals)
+    {
+        if (!merged.empty() && (interval.first <= merged.back().second))
+        {
+            merged.back().second = std::max(merged.back().second, interval.second);
+        }
+        else
+        {
+            merged.push_back(interval);
+        }
+    }
+    return merged;
+}
+
+double StageTracer::overlap(const std::vector<int>& a, const std::vector<int>& b) const
+{
+    const auto spans = getSpans();
+    const auto ia = merge(spans, a), ib = merge(spans, b);
+
+    double total = 0.0;
+    for (std::size_t i = 0, j = 0; (i < ia.size()) && (j < ib.size());)
+    {
+        total += std::max(0.0, std::min(ia[i].second, ib[j].second) - std::max(ia[i].first, ib[j].first));
+        if (ia[i].second < ib[j].second)
+        {
+            i++;
+        }
+        else
+        {
+            j++;
+        }
+    }
+    return total;
+}
+
+void StageTracer::writeChromeTrace(std::ostream& os) const
+{
+    // Map (large) thread hashes to small integer ids for the viewer:
+    std::map<std::uint64_t, int> threads;
+
+    os << "{\"traceEvents\":[";
+    const auto spans = getSpans();
+    for (std::size_t i = 0; i < spans.size(); i++)
+    {
+        const auto& span = spans[i];
+        const auto tid = threads.emplace(span.thread, static_cast<int>(threads.size())).first->second;
+        const bool hasName = (span.stage >= 0) && (span.stage < static_cast<int>(m_stages.size()));
+        const std::string name = hasName ? m_stages[span.stage] : std::to_string(span.stage);
+
+        os << (i ? "," : "") << '\n'
+           << "{\"name\":\"" << name << "\""
+           << ",\"cat\":\"drishti\",\"ph\":\"X\",\"pid\":0"
+           << ",\"tid\":" << tid
+           << ",\"ts\":" << static_cast<std::int64_t>(span.start * 1e6)
+           << ",\"dur\":" << static_cast<std::int64_t>(span.duration * 1e6)
+           << ",\"args\":{\"frame\":" << span.frame << "}}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+DRISHTI_CORE_NAMESPACE_END
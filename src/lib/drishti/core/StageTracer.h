@@ -0,0 +1,109 @@
+/*! -*-c++-*-
+  @file   StageTracer.h
+  @author David Hirvonen
+  @brief  Declaration of a lock-free per-frame stage span recorder.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A fixed capacity ring buffer of timing spans (stage, frame, thread, start, duration)
+  that can be written from any thread without locks.  Readers take a snapshot of the
+  most recent spans for percentile queries or Chrome trace (chrome://tracing) export.
+
+*/
+
+#ifndef __drishti_core_StageTracer_h__
+#define __drishti_core_StageTracer_h__
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/timing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class StageTracer
+{
+public:
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+    using TimePoint = HighResolutionClock::time_point;
+
+    struct Span
+    {
+        int stage = 0;
+        std::uint64_t frame = 0;
+        std::uint64_t thread = 0; // std::hash<std::thread::id>
+        double start = 0.0;       // seconds since tracer creation
+        double duration = 0.0;    // seconds
+    };
+
+    // Capacity is rounded up to the next power of two.
+    explicit StageTracer(std::vector<std::string> stages, std::size_t capacity = 4096);
+    ~StageTracer();
+
+    StageTracer(const StageTracer&) = delete;
+    StageTracer(StageTracer&&) = delete;
+    StageTracer& operator=(const StageTracer&) = delete;
+    StageTracer& operator=(StageTracer&&) = delete;
+
+    // Record a span of the given duration ending now (thread safe, lock free):
+    void record(int stage, std::uint64_t frame, double duration);
+
+    // Record a span that ended at stop on a given lane (e.g., GPU timer queries resolved
+    // frames later, see ogles_gpgpu::GpuTimer), thread is any id that doesn't collide with the
+    // std::hash<std::thread::id> values of the producer threads:
+    void record(int stage, std::uint64_t frame, double duration, const TimePoint& stop, std::uint64_t thread);
+
+    // Producer: records a span for the lifetime of the returned object.
+    ScopeTimeLogger scope(int stage, std::uint64_t frame);
+
+    // Snapshot of the retained spans, oldest first.
+    std::vector<Span> getSpans() const;
+    std::vector<Span> getSpans(int stage) const;
+
+    // Duration percentile in seconds for p in [0,1] (0.0 if there are no samples).
+    double percentile(int stage, double p) const;
+    double p50(int stage) const { return percentile(stage, 0.50); }
+    double p95(int stage) const { return percentile(stage, 0.95); }
+    double p99(int stage) const { return percentile(stage, 0.99); }
+
+    // Seconds during which any span from stages a and any span from stages b are both
+    // active (e.g., GPU frame processing on the main thread vs CPU scene jobs):
+    double overlap(const std::vector<int>& a, const std::vector<int>& b) const;
+
+    // Chrome trace event format ("X" complete events, microsecond units).
+    void writeChromeTrace(std::ostream& os) const;
+
+    const std::vector<std::string>& getStageNames() const { return m_stages; }
+    std::size_t getCapacity() const { return m_capacity; }
+    std::uint64_t getCount() const { return m_head.load(std::memory_order_relaxed); }
+
+protected:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> sequence{ 0 }; // 0 == empty or in progress, else ticket + 1
+        std::atomic<int> stage{ 0 };
+        std::atomic<std::uint64_t> frame{ 0 };
+        std::atomic<std::uint64_t> thread{ 0 };
+        std::atomic<double> start{ 0.0 };
+        std::atomic<double> duration{ 0.0 };
+    };
+
+    bool read(const Slot& slot, Span& span) const;
+
+    std::vector<std::string> m_stages;
+    std::size_t m_capacity = 0;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<std::uint64_t> m_head{ 0 };
+    TimePoint m_epoch;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_StageTracer_h__
@@ -0,0 +1,222 @@
+/*! -*-c++-*-
+  @file   TaskGraph.cpp
+  @author David Hirvonen
+  @brief  Implementation of a reusable dependency graph executor for the per frame CPU job.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/TaskGraph.h"
+#include "drishti/core/ThreadPool.h" // ThreadPoolSource
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+void TaskGraph::clear()
+{
+    for (int i = 0; i < m_size; i++)
+    {
+        auto& node = m_nodes[i];
+        node.task = nullptr; // release captures
+        node.predecessors = 0;
+        node.successors.clear();
+    }
+    m_size = 0;
+}
+
+int TaskGraph::add(Task task, float cost)
+{
+    if (m_size == static_cast<int>(m_nodes.size()))
+    {
+        m_nodes.emplace_back();
+    }
+
+    auto& node = m_nodes[m_size];
+    node.task = std::move(task);
+    node.cost = cost;
+    node.priority = cost;
+    return m_size++;
+}
+
+void TaskGraph::precede(int before, int after)
+{
+    if ((before < 0) || (before >= m_size) || (after < 0) || (after >= m_size) || (before == after))
+    {
+        throw std::logic_error("TaskGraph: invalid dependency");
+    }
+
+    m_nodes[before].successors.push_back(after);
+    m_nodes[after].predecessors++;
+}
+
+void TaskGraph::prioritize()
+{
+    // Kahn's algorithm, m_order is reused as the queue:
+    std::vector<int> pending(m_size);
+    m_order.clear();
+    for (int i = 0; i < m_size; i++)
+    {
+        pending[i] = m_nodes[i].predecessors;
+        if (!pending[i])
+        {
+            m_order.push_back(i);
+        }
+    }
+    for (std::size_t k = 0; k < m_order.size(); k++)
+    {
+        for (const auto& j : m_nodes[m_order[k]].successors)
+        {
+            if (!--pending[j])
+            {
+                m_order.push_back(j);
+            }
+        }
+    }
+    if (static_cast<int>(m_order.size()) != m_size)
+    {
+        throw std::logic_error("TaskGraph: cyclic dependency");
+    }
+
+    // Critical path to the end of the graph, in reverse topological order:
+    for (auto k = m_order.rbegin(); k != m_order.rend(); k++)
+    {
+        auto& node = m_nodes[*k];
+        float longest = 0.f;
+        for (const auto& j : node.successors)
+        {
+            longest = std::max(longest, m_nodes[j].priority);
+        }
+        node.priority = node.cost + longest;
+    }
+}
+
+void TaskGraph::run(tp::ThreadPool<>* pool, int threads)
+{
+    if (!m_size)
+    {
+        return;
+    }
+
+    prioritize();
+
+    struct State
+    {
+        std::vector<int> ready;   // max heap on priority
+        std::vector<int> pending; // unfinished predecessors
+        int done = 0;
+        int count = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+    state->count = m_size;
+    state->pending.resize(m_size);
+
+    // Most urgent first (ties in insertion order):
+    const auto& nodes = m_nodes;
+    auto less = [&nodes](int a, int b) {
+        return (nodes[a].priority < nodes[b].priority) || ((nodes[a].priority == nodes[b].priority) && (a > b));
+    };
+
+    for (int i = 0; i < m_size; i++)
+    {
+        state->pending[i] = m_nodes[i].predecessors;
+        if (!state->pending[i])
+        {
+            state->ready.push_back(i);
+        }
+    }
+    std::make_heap(state->ready.begin(), state->ready.end(), less);
+
+    // The graph is only accessed while tasks remain, so late helpers never touch it:
+    auto work = [state, less, &nodes]() {
+        auto pop = [&]() {
+            std::pop_heap(state->ready.begin(), state->ready.end(), less);
+            const int index = state->ready.back();
+            state->ready.pop_back();
+            return index;
+        };
+
+        int next = -1;
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (true)
+        {
+            if (next < 0)
+            {
+                state->cv.wait(lock, [&]() { return !state->ready.empty() || (state->done == state->count); });
+                if (state->ready.empty())
+                {
+                    return;
+                }
+                next = pop();
+            }
+
+            const bool skip = static_cast<bool>(state->error);
+            lock.unlock();
+            std::exception_ptr error;
+            if (!skip)
+            {
+                try
+                {
+                    nodes[next].task();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+            lock.lock();
+
+            if (error && !state->error)
+            {
+                state->error = error;
+            }
+            for (const auto& j : nodes[next].successors)
+            {
+                if (!--state->pending[j])
+                {
+                    state->ready.push_back(j);
+                    std::push_heap(state->ready.begin(), state->ready.end(), less);
+                }
+            }
+            state->done++;
+
+            // Continue with the most urgent ready task, the others are left for idle workers:
+            next = state->ready.empty() ? -1 : pop();
+            if (!state->ready.empty() || (state->done == state->count))
+            {
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    const int concurrency = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    const int workers = std::min((threads > 0) ? threads : concurrency, m_size);
+    if (workers > 1)
+    {
+        auto* threadPool = pool ? pool : ThreadPoolSource::getInstance();
+        for (int i = 1; i < workers; i++)
+        {
+            threadPool->process(work);
+        }
+    }
+
+    work(); // calling thread participates, returns when all tasks are complete
+
+    if (state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
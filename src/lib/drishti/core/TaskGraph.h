@@ -0,0 +1,90 @@
+/*! -*-c++-*-
+  @file   TaskGraph.h
+  @author David Hirvonen
+  @brief  Declaration of a reusable dependency graph executor for the per frame CPU job.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The CPU work of a frame is a small DAG (e.g., landmarks per face, then both eyes per
+  face, with one eye regressor instance per side).  Tasks are added with a relative cost
+  and ordered with precede(), and run() executes the graph on the SDK thread pool:
+
+    * ready tasks are taken in critical path order (the largest cost to the end of the graph)
+    * a worker that completes a task continues directly with its most urgent ready successor
+      (continuation), the remaining successors are left in the shared queue for idle workers
+    * the calling thread participates and helpers that start after the graph is finished
+      simply return, so run() can be called from a job already running on the same pool
+
+  clear() keeps the node storage, so a graph member can be rebuilt for every frame
+  without reallocating.
+
+*/
+
+#ifndef __drishti_core_TaskGraph_h__
+#define __drishti_core_TaskGraph_h__ 1
+
+#include "drishti/core/drishti_core.h"
+#include "thread_pool/thread_pool.hpp"
+
+#include <functional>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class TaskGraph
+{
+public:
+    using Task = std::function<void()>;
+
+    TaskGraph() = default;
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Remove all tasks (node storage is retained):
+    void clear();
+
+    // Returns the task index, cost is a relative estimate used for the critical path:
+    int add(Task task, float cost = 1.f);
+
+    // Task after doesn't start before task before has completed:
+    void precede(int before, int after);
+
+    // Run all tasks with (at most) threads workers including the caller (<= 0 == hardware
+    // concurrency) and block until complete.  The first exception thrown by a task is
+    // rethrown here, tasks that haven't started are skipped.  Throws std::logic_error for
+    // a cyclic graph.
+    void run(tp::ThreadPool<>* pool = nullptr, int threads = -1);
+
+    int size() const
+    {
+        return m_size;
+    }
+
+    // Critical path length from the task to the end of the graph (valid after run()):
+    float getPriority(int index) const
+    {
+        return m_nodes[index].priority;
+    }
+
+protected:
+    struct Node
+    {
+        Task task;
+        float cost = 1.f;
+        float priority = 0.f;
+        int predecessors = 0;
+        std::vector<int> successors;
+    };
+
+    void prioritize();
+
+    std::vector<Node> m_nodes; // [0, m_size) are in use
+    std::vector<int> m_order;  // topological order
+    int m_size = 0;
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_TaskGraph_h__
@@ -10,6 +10,15 @@
 
 #include "drishti/core/ThreadPool.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 ThreadPoolSource::FixedThreadPool* ThreadPoolSource::getInstance()
@@ -18,4 +27,188 @@ ThreadPoolSource::FixedThreadPool* ThreadPoolSource::getInstance()
     return &instance;
 }
 
+void parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, tp::ThreadPool<>* threads)
+{
+    const int count = range.end - range.start;
+    if (!threads)
+    {
+        cv::parallel_for_(range, body);
+        return;
+    }
+    if (count <= 1)
+    {
+        body(range);
+        return;
+    }
+
+    struct State
+    {
+        std::atomic<int> next{ 0 };
+        int done = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+
+    auto work = [state, count, &range, &body]() {
+        for (int k = state->next++; k < count; k = state->next++)
+        {
+            body({ range.start + k, range.start + k + 1 });
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->done == count)
+            {
+                state->cv.notify_one();
+            }
+        }
+    };
+
+    const int helpers = std::min(count, static_cast<int>(std::thread::hardware_concurrency())) - 1;
+    for (int i = 0; i < helpers; i++)
+    {
+        threads->process(work);
+    }
+
+    work(); // calling thread participates
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done == count; });
+}
+
+void parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, const ParallelSettings& settings)
+{
+    const int count = range.end - range.start;
+    const int concurrency = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    const int threads = (settings.threads > 0) ? settings.threads : concurrency;
+    const int grain = (settings.grain > 0) ? settings.grain : std::max(count / (threads * 16), 1);
+    const int workers = std::min(threads, (count + grain - 1) / grain);
+
+    if (count <= 0)
+    {
+        return;
+    }
+    if (workers <= 1)
+    {
+        body(range);
+        if (settings.progress)
+        {
+            settings.progress(count, count);
+        }
+        return;
+    }
+
+    // Remaining [begin, end) offsets per worker, owners take from the front and thieves from the back:
+    struct Block
+    {
+        int begin = 0;
+        int end = 0;
+        std::mutex mutex;
+    };
+
+    struct State
+    {
+        State(int workers)
+            : blocks(workers)
+        {
+        }
+
+        std::vector<Block> blocks;
+        int done = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>(workers);
+
+    for (int i = 0; i < workers; i++)
+    {
+        state->blocks[i].begin = static_cast<int>(static_cast<std::int64_t>(count) * i / workers);
+        state->blocks[i].end = static_cast<int>(static_cast<std::int64_t>(count) * (i + 1) / workers);
+    }
+
+    auto claim = [](Block& block, int grain, cv::Range& chunk) {
+        std::lock_guard<std::mutex> lock(block.mutex);
+        if (block.begin >= block.end)
+        {
+            return false;
+        }
+        chunk = { block.begin, std::min(block.begin + grain, block.end) };
+        block.begin = chunk.end;
+        return true;
+    };
+
+    auto steal = [state, workers, grain](int index) {
+        while (true)
+        {
+            // Pick the largest block, the size is re-checked when it is split:
+            int victim = -1, largest = 0;
+            for (int i = 1; i < workers; i++)
+            {
+                auto& block = state->blocks[(index + i) % workers];
+                std::lock_guard<std::mutex> lock(block.mutex);
+                if ((block.end - block.begin) > largest)
+                {
+                    largest = block.end - block.begin;
+                    victim = (index + i) % workers;
+                }
+            }
+            if (victim < 0)
+            {
+                return false; // all remaining work is claimed
+            }
+
+            int begin = 0, end = 0;
+            {
+                auto& block = state->blocks[victim];
+                std::lock_guard<std::mutex> lock(block.mutex);
+                const int remaining = block.end - block.begin;
+                if (remaining <= 0)
+                {
+                    continue; // taken in the meantime
+                }
+                end = block.end;
+                begin = block.end - ((remaining > grain) ? (remaining / 2) : remaining);
+                block.end = begin;
+            }
+
+            auto& block = state->blocks[index];
+            std::lock_guard<std::mutex> lock(block.mutex);
+            block.begin = begin;
+            block.end = end;
+            return true;
+        }
+    };
+
+    const auto& progress = settings.progress;
+    auto work = [state, steal, claim, count, grain, &range, &body, &progress](int index) {
+        cv::Range chunk;
+        while (claim(state->blocks[index], grain, chunk) || (steal(index) && claim(state->blocks[index], grain, chunk)))
+        {
+            body({ range.start + chunk.start, range.start + chunk.end });
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->done += chunk.end - chunk.start;
+            if (progress)
+            {
+                progress(state->done, count);
+            }
+            if (state->done == count)
+            {
+                state->cv.notify_one();
+            }
+        }
+    };
+
+    // Helpers that start after the loop is finished find nothing to claim and return:
+    auto* pool = settings.pool ? settings.pool : ThreadPoolSource::getInstance();
+    for (int i = 1; i < workers; i++)
+    {
+        pool->process([work, i]() { work(i); });
+    }
+
+    work(0); // calling thread participates
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done == count; });
+}
+
 DRISHTI_CORE_NAMESPACE_END
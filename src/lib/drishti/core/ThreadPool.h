@@ -14,6 +14,10 @@
 #include "drishti/core/drishti_core.h"
 #include "thread_pool/thread_pool.hpp"
 
+#include <opencv2/core/core.hpp>
+
+#include <functional>
+
 DRISHTI_CORE_NAMESPACE_BEGIN
 
 class ThreadPoolSource
@@ -33,6 +37,29 @@ public:
     ThreadPoolSource& operator=(ThreadPoolSource&&) = delete;
 };
 
+// Drop in replacement for cv::parallel_for_() that runs on the SDK thread pool (falls back to
+// cv::parallel_for_() when threads is null).  Indices are claimed from a shared counter and the
+// calling thread participates, so this can safely be called from a job already running on the
+// same pool: helpers that start late simply return.
+void parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, tp::ThreadPool<>* threads);
+
+struct ParallelSettings
+{
+    using Progress = std::function<void(int done, int total)>;
+
+    tp::ThreadPool<>* pool = nullptr; // (nullptr == ThreadPoolSource::getInstance())
+    int threads = -1;                 // workers including the caller (<= 0 == hardware concurrency)
+    int grain = 0;                    // indices per claim (0 == automatic)
+    Progress progress;                // called after each chunk (serialized, from worker threads)
+};
+
+// Work stealing loop for bodies with uneven per-index cost (e.g., one image per index).  The
+// range is split into one contiguous block per worker, each worker claims grain sized chunks
+// from the front of its own block, and idle workers steal the back half of the largest
+// remaining block, so nobody idles while work remains.  Blocks of workers that start late are
+// stolen by the others, so this is also safe to nest on the same pool.
+void parallelFor(const cv::Range& range, const cv::ParallelLoopBody& body, const ParallelSettings& settings);
+
 DRISHTI_CORE_NAMESPACE_END
 
 #endif // __drishti_core_ThreadPool_h__
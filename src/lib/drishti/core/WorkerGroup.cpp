@@ -0,0 +1,89 @@
+/*! -*-c++-*-
+  @file   WorkerGroup.cpp
+  @author David Hirvonen
+  @brief  Implementation of a fixed group of persistent worker lanes.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/WorkerGroup.h"
+
+#include <algorithm>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+WorkerGroup::WorkerGroup(int lanes)
+    : m_barrier(std::max(lanes, 1))
+{
+    for (int lane = 1; lane < m_barrier.size(); lane++)
+    {
+        m_threads.emplace_back([this, lane]() { loop(lane); });
+    }
+}
+
+WorkerGroup::~WorkerGroup()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+bool WorkerGroup::tryRun(const Job& job)
+{
+    std::unique_lock<std::mutex> busy(m_busy, std::try_to_lock);
+    if (!busy.owns_lock())
+    {
+        return false;
+    }
+
+    m_pending.store(static_cast<int>(m_threads.size()), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_generation++;
+    }
+    m_condition.notify_all();
+
+    job(0, m_barrier);
+
+    // Wait for the remaining lanes to leave the job before it goes out of scope:
+    while (m_pending.load(std::memory_order_acquire) > 0)
+    {
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+void WorkerGroup::loop(int lane)
+{
+    std::uint64_t generation = 0;
+    while (true)
+    {
+        const Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&]() { return m_stop || (m_generation != generation); });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+            job = m_job;
+        }
+
+        (*job)(lane, m_barrier);
+        m_pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,75 @@
+/*! -*-c++-*-
+  @file   WorkerGroup.h
+  @author David Hirvonen
+  @brief  Declaration of a fixed group of persistent worker lanes.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A WorkerGroup owns (size() - 1) threads that stay alive for the lifetime of
+  the group.  tryRun() executes a job on every lane (the calling thread is lane 0)
+  and the lanes can synchronize between phases of the job with the shared
+  SpinBarrier.  Unlike cv::parallel_for_, all lanes are guaranteed to run
+  concurrently, so barrier waits inside a job cannot deadlock.
+
+*/
+
+#ifndef __drishti_core_WorkerGroup_h__
+#define __drishti_core_WorkerGroup_h__ 1
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/SpinBarrier.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+class WorkerGroup
+{
+public:
+    // Job must not throw, since lanes synchronize on the barrier.
+    using Job = std::function<void(int lane, SpinBarrier& barrier)>;
+
+    explicit WorkerGroup(int lanes);
+    ~WorkerGroup();
+
+    WorkerGroup(const WorkerGroup&) = delete;
+    WorkerGroup(WorkerGroup&&) = delete;
+    WorkerGroup& operator=(const WorkerGroup&) = delete;
+    WorkerGroup& operator=(WorkerGroup&&) = delete;
+
+    // Run job on all lanes and block until complete.  Returns false without running
+    // the job if the group is already in use by another thread.
+    bool tryRun(const Job& job);
+
+    int size() const
+    {
+        return m_barrier.size();
+    }
+
+protected:
+    void loop(int lane);
+
+    SpinBarrier m_barrier;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_busy; // held for the duration of tryRun()
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::uint64_t m_generation = 0;
+    bool m_stop = false;
+    const Job* m_job = nullptr;
+
+    std::atomic<int> m_pending{ 0 };
+};
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_WorkerGroup_h__
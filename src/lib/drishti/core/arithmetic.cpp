@@ -9,19 +9,41 @@
 */
 
 #include "drishti/core/arithmetic.h"
+#include "drishti/core/cpu.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include "drishti/core/drishti_math.h"
 
 // clang-format off
-#if defined(__arm__) || defined(__arm64__)
+#if DRISHTI_CPU_NEON
 #  include <arm_neon.h>
 #  define DO_ARM_NEON 1
 #endif
 // clang-format on
 
+// clang-format off
+#if DRISHTI_CPU_X86
+#  include <immintrin.h>
+#  define DO_X86_SIMD 1 // SSE2, SSE4.1 and AVX2 kernels, selected at runtime (see hasSimd())
+#endif
+// clang-format on
+
 DRISHTI_CORE_NAMESPACE_BEGIN
 
+static std::atomic<bool> s_simdEnabled{ true };
+
+void setSimdEnabled(bool enabled)
+{
+    s_simdEnabled = enabled;
+}
+
+bool getSimdEnabled()
+{
+    return s_simdEnabled;
+}
+
 template <>
 float round(float x)
 {
@@ -57,13 +79,48 @@ void add32f_neon(const float* pa, const float* pb, float* pc, int n)
 }
 #endif
 
+#if DO_X86_SIMD
+DRISHTI_TARGET("sse2")
+void add32f_sse2(const float* pa, const float* pb, float* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        _mm_storeu_ps(pc + i, _mm_add_ps(_mm_loadu_ps(pa + i), _mm_loadu_ps(pb + i)));
+    }
+    add32f_c(pa + i, pb + i, pc + i, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+void add32f_avx2(const float* pa, const float* pb, float* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8)
+    {
+        _mm256_storeu_ps(pc + i, _mm256_add_ps(_mm256_loadu_ps(pa + i), _mm256_loadu_ps(pb + i)));
+    }
+    add32f_c(pa + i, pb + i, pc + i, n - i);
+}
+#endif
+
 void add32f(const float* pa, const float* pb, float* pc, int n)
 {
 #if DO_ARM_NEON
-    add32f_neon(pa, pb, pc, n);
-#else
-    add32f_c(pa, pb, pc, n);
+    if (hasSimd(kSimdNEON))
+    {
+        return add32f_neon(pa, pb, pc, n);
+    }
+#elif DO_X86_SIMD
+    if (hasSimd(kSimdAVX2))
+    {
+        return add32f_avx2(pa, pb, pc, n);
+    }
+    if (hasSimd(kSimdSSE2))
+    {
+        return add32f_sse2(pa, pb, pc, n);
+    }
 #endif
+    add32f_c(pa, pb, pc, n);
 }
 
 // ################# ADD 16S AND 32S ######################
@@ -91,13 +148,54 @@ void add16sAnd32s_neon(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
 }
 #endif
 
+#if DO_X86_SIMD
+DRISHTI_TARGET("sse2")
+void add16sAnd32s_sse2(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8)
+    {
+        // Sign extension: interleave with itself and shift the copy out
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pc + i + 0), _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + i + 0)), lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pc + i + 4), _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + i + 4)), hi));
+    }
+    add16sAnd32s_c(pa + i, pb + i, pc + i, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+void add16sAnd32s_avx2(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8)
+    {
+        const __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pc + i), _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa + i)), b));
+    }
+    add16sAnd32s_c(pa + i, pb + i, pc + i, n - i);
+}
+#endif
+
 void add16sAnd32s(const int32_t* pa, const int16_t* pb, int32_t* pc, int n)
 {
 #if DO_ARM_NEON
-    add16sAnd32s_neon(pa, pb, pc, n);
-#else
-    add16sAnd32s_c(pa, pb, pc, n);
+    if (hasSimd(kSimdNEON))
+    {
+        return add16sAnd32s_neon(pa, pb, pc, n);
+    }
+#elif DO_X86_SIMD
+    if (hasSimd(kSimdAVX2))
+    {
+        return add16sAnd32s_avx2(pa, pb, pc, n);
+    }
+    if (hasSimd(kSimdSSE2))
+    {
+        return add16sAnd32s_sse2(pa, pb, pc, n);
+    }
 #endif
+    add16sAnd32s_c(pa, pb, pc, n);
 }
 
 // ################# ADD 32S AND 32S ######################
@@ -129,13 +227,52 @@ void add16sAnd16s_neon(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
 }
 #endif
 
+#if DO_X86_SIMD
+DRISHTI_TARGET("sse2")
+void add16sAnd16s_sse2(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 8); i += 8)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pc + i), _mm_add_epi16(a, b));
+    }
+    add16sAnd16s_c(pa + i, pb + i, pc + i, n - i);
+}
+
+DRISHTI_TARGET("avx2")
+void add16sAnd16s_avx2(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
+{
+    int i = 0;
+    for (; i <= (n - 16); i += 16)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pc + i), _mm256_add_epi16(a, b));
+    }
+    add16sAnd16s_c(pa + i, pb + i, pc + i, n - i);
+}
+#endif
+
 void add16sAnd16s(const int16_t* pa, const int16_t* pb, int16_t* pc, int n)
 {
 #if DO_ARM_NEON
-    add16sAnd16s_neon(pa, pb, pc, n);
-#else
-    add16sAnd16s_c(pa, pb, pc, n);
+    if (hasSimd(kSimdNEON))
+    {
+        return add16sAnd16s_neon(pa, pb, pc, n);
+    }
+#elif DO_X86_SIMD
+    if (hasSimd(kSimdAVX2))
+    {
+        return add16sAnd16s_avx2(pa, pb, pc, n);
+    }
+    if (hasSimd(kSimdSSE2))
+    {
+        return add16sAnd16s_sse2(pa, pb, pc, n);
+    }
 #endif
+    add16sAnd16s_c(pa, pb, pc, n);
 }
 
 // See: http://stackoverflow.com/questions/17998257/arm-neon-assembly-and-floating-point-rounding
@@ -148,21 +285,50 @@ static const float32x4_t v32x4f_pos_half = { +0.5f, +0.5f, +0.5f, +0.5f };
 static const float32x4_t v32x4f_neg_half = { -0.5f, -0.5f, -0.5f, -0.5f };
 #endif
 
+#if DO_X86_SIMD
+// Truncation (as the scalar loop) with saturation, returns the number of converted values:
+DRISHTI_TARGET("sse2")
+int convertFixedPoint_sse2(const float* pa, int16_t* pb, int n, float scale)
+{
+    const __m128 step = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i <= (n - 8); i += 8)
+    {
+        const __m128i lower = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(pa + i + 0), step));
+        const __m128i upper = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(pa + i + 4), step));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pb + i), _mm_packs_epi32(lower, upper));
+    }
+    return i;
+}
+#endif
+
 void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction)
 {
     auto scale = float(1 << fraction);
 
     int i = 0;
 
+#if DO_X86_SIMD
+    if (hasSimd(kSimdSSE2))
+    {
+        i = convertFixedPoint_sse2(pa, pb, n, scale);
+        pa += i;
+        pb += i;
+    }
+#endif
+
 #if DO_ARM_NEON
-    float32x4_t step = vdupq_n_f32(scale);
-    for (; i <= (n - 8); i += 8, pa += 8, pb += 8)
+    if (hasSimd(kSimdNEON))
     {
-        float32x4_t lowerf = vmulq_f32(vld1q_f32(&pa[0]), step);
-        float32x4_t upperf = vmulq_f32(vld1q_f32(&pa[4]), step);
-        int16x4_t lower = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(lowerf, vbslq_f32(vcgtq_f32(lowerf, v32x4f_zero), v32x4f_pos_half, v32x4f_neg_half))));
-        int16x4_t upper = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(upperf, vbslq_f32(vcgtq_f32(upperf, v32x4f_zero), v32x4f_pos_half, v32x4f_neg_half))));
-        vst1q_s16(pb, vcombine_s16(lower, upper));
+        float32x4_t step = vdupq_n_f32(scale);
+        for (; i <= (n - 8); i += 8, pa += 8, pb += 8)
+        {
+            float32x4_t lowerf = vmulq_f32(vld1q_f32(&pa[0]), step);
+            float32x4_t upperf = vmulq_f32(vld1q_f32(&pa[4]), step);
+            int16x4_t lower = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(lowerf, vbslq_f32(vcgtq_f32(lowerf, v32x4f_zero), v32x4f_pos_half, v32x4f_neg_half))));
+            int16x4_t upper = vqmovn_s32(vcvtq_s32_f32(vaddq_f32(upperf, vbslq_f32(vcgtq_f32(upperf, v32x4f_zero), v32x4f_pos_half, v32x4f_neg_half))));
+            vst1q_s16(pb, vcombine_s16(lower, upper));
+        }
     }
 #endif
     // process % 8 pixels from SIMD branch or all pixels in case of C implementation
@@ -172,6 +338,164 @@ void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction)
     }
 }
 
+// ################# TRANSFORM AND GATHER 8U ######################
+
+// Note: All kernels evaluate the same sequence of single precision operations (no fused
+// multiply-add) and clamp before conversion, so the results are bit-identical.
+
+// clang-format off
+#if defined(__clang__)
+#  pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#  pragma GCC push_options
+#  pragma GCC optimize("fp-contract=off")
+#endif
+// clang-format on
+
+void transformAndGather8u_c(const uint8_t* image, int stride, int cols, int rows, const float* anchors, const float* deltas, const float* T, const float* H, float* values, int n, float outside = 0.f, int i = 0)
+{
+    const float lo = -1.f, hiX = float(cols), hiY = float(rows);
+    for (; i < n; i++)
+    {
+        float x = anchors[i * 2 + 0];
+        float y = anchors[i * 2 + 1];
+        if (deltas)
+        {
+            const float dx = deltas[i * 2 + 0];
+            const float dy = deltas[i * 2 + 1];
+            const float tx = (T[0] * dx) + (T[1] * dy);
+            const float ty = (T[2] * dx) + (T[3] * dy);
+            x = x + tx;
+            y = y + ty;
+        }
+
+        const float u = ((H[0] * x) + (H[1] * y)) + H[2];
+        const float v = ((H[3] * x) + (H[4] * y)) + H[5];
+        const int qx = int(std::floor(std::min(std::max(u + 0.5f, lo), hiX)));
+        const int qy = int(std::floor(std::min(std::max(v + 0.5f, lo), hiY)));
+        const bool inside = (qx >= 0) && (qx < cols) && (qy >= 0) && (qy < rows);
+        values[i] = inside ? float(image[qy * stride + qx]) : outside;
+    }
+}
+
+#if DO_ARM_NEON
+void transformAndGather8u_neon(const uint8_t* image, int stride, int cols, int rows, const float* anchors, const float* deltas, const float* T, const float* H, float* values, int n, float outside)
+{
+    const float32x4_t half = vdupq_n_f32(0.5f), lo = vdupq_n_f32(-1.f);
+    const float32x4_t hiX = vdupq_n_f32(float(cols)), hiY = vdupq_n_f32(float(rows));
+    const int32x4_t zero = vdupq_n_s32(0), one = vdupq_n_s32(1);
+    const int32x4_t colsv = vdupq_n_s32(cols), rowsv = vdupq_n_s32(rows);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        float32x4x2_t a = vld2q_f32(anchors + i * 2);
+        float32x4_t x = a.val[0], y = a.val[1];
+        if (deltas)
+        {
+            float32x4x2_t d = vld2q_f32(deltas + i * 2);
+            float32x4_t tx = vaddq_f32(vmulq_n_f32(d.val[0], T[0]), vmulq_n_f32(d.val[1], T[1]));
+            float32x4_t ty = vaddq_f32(vmulq_n_f32(d.val[0], T[2]), vmulq_n_f32(d.val[1], T[3]));
+            x = vaddq_f32(x, tx);
+            y = vaddq_f32(y, ty);
+        }
+
+        float32x4_t u = vaddq_f32(vaddq_f32(vmulq_n_f32(x, H[0]), vmulq_n_f32(y, H[1])), vdupq_n_f32(H[2]));
+        float32x4_t v = vaddq_f32(vaddq_f32(vmulq_n_f32(x, H[3]), vmulq_n_f32(y, H[4])), vdupq_n_f32(H[5]));
+        u = vminq_f32(vmaxq_f32(vaddq_f32(u, half), lo), hiX);
+        v = vminq_f32(vmaxq_f32(vaddq_f32(v, half), lo), hiY);
+
+        // floor() via truncation and correction for negative non-integral values:
+        int32x4_t qx = vcvtq_s32_f32(u), qy = vcvtq_s32_f32(v);
+        qx = vsubq_s32(qx, vandq_s32(vreinterpretq_s32_u32(vcgtq_f32(vcvtq_f32_s32(qx), u)), one));
+        qy = vsubq_s32(qy, vandq_s32(vreinterpretq_s32_u32(vcgtq_f32(vcvtq_f32_s32(qy), v)), one));
+
+        uint32x4_t inside = vandq_u32(vandq_u32(vcgeq_s32(qx, zero), vcltq_s32(qx, colsv)), vandq_u32(vcgeq_s32(qy, zero), vcltq_s32(qy, rowsv)));
+        int32x4_t offset = vandq_s32(vaddq_s32(vmulq_n_s32(qy, stride), qx), vreinterpretq_s32_u32(inside));
+
+        int32_t o[4];
+        uint32_t m[4];
+        vst1q_s32(o, offset);
+        vst1q_u32(m, inside);
+        for (int j = 0; j < 4; j++)
+        {
+            values[i + j] = m[j] ? float(image[o[j]]) : outside;
+        }
+    }
+    transformAndGather8u_c(image, stride, cols, rows, anchors, deltas, T, H, values, n, outside, i);
+}
+#endif
+
+#if DO_X86_SIMD
+DRISHTI_TARGET("sse4.1")
+void transformAndGather8u_sse(const uint8_t* image, int stride, int cols, int rows, const float* anchors, const float* deltas, const float* T, const float* H, float* values, int n, float outside)
+{
+    const __m128 half = _mm_set1_ps(0.5f), lo = _mm_set1_ps(-1.f);
+    const __m128 hiX = _mm_set1_ps(float(cols)), hiY = _mm_set1_ps(float(rows));
+    const __m128i minus1 = _mm_set1_epi32(-1);
+    const __m128i colsv = _mm_set1_epi32(cols), rowsv = _mm_set1_epi32(rows), stridev = _mm_set1_epi32(stride);
+
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        // Deinterleave {x0,y0,x1,y1}, {x2,y2,x3,y3}:
+        __m128 a0 = _mm_loadu_ps(anchors + i * 2 + 0), a1 = _mm_loadu_ps(anchors + i * 2 + 4);
+        __m128 x = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1));
+        if (deltas)
+        {
+            __m128 d0 = _mm_loadu_ps(deltas + i * 2 + 0), d1 = _mm_loadu_ps(deltas + i * 2 + 4);
+            __m128 dx = _mm_shuffle_ps(d0, d1, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 dy = _mm_shuffle_ps(d0, d1, _MM_SHUFFLE(3, 1, 3, 1));
+            __m128 tx = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(T[0]), dx), _mm_mul_ps(_mm_set1_ps(T[1]), dy));
+            __m128 ty = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(T[2]), dx), _mm_mul_ps(_mm_set1_ps(T[3]), dy));
+            x = _mm_add_ps(x, tx);
+            y = _mm_add_ps(y, ty);
+        }
+
+        __m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(H[0]), x), _mm_mul_ps(_mm_set1_ps(H[1]), y)), _mm_set1_ps(H[2]));
+        __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(H[3]), x), _mm_mul_ps(_mm_set1_ps(H[4]), y)), _mm_set1_ps(H[5]));
+        u = _mm_floor_ps(_mm_min_ps(_mm_max_ps(_mm_add_ps(u, half), lo), hiX));
+        v = _mm_floor_ps(_mm_min_ps(_mm_max_ps(_mm_add_ps(v, half), lo), hiY));
+
+        __m128i qx = _mm_cvttps_epi32(u), qy = _mm_cvttps_epi32(v);
+        __m128i inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(qx, minus1), _mm_cmplt_epi32(qx, colsv)), _mm_and_si128(_mm_cmpgt_epi32(qy, minus1), _mm_cmplt_epi32(qy, rowsv)));
+        __m128i offset = _mm_and_si128(_mm_add_epi32(_mm_mullo_epi32(qy, stridev), qx), inside);
+
+        alignas(16) int32_t o[4], m[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(o), offset);
+        _mm_store_si128(reinterpret_cast<__m128i*>(m), inside);
+        for (int j = 0; j < 4; j++)
+        {
+            values[i + j] = m[j] ? float(image[o[j]]) : outside;
+        }
+    }
+    transformAndGather8u_c(image, stride, cols, rows, anchors, deltas, T, H, values, n, outside, i);
+}
+#endif
+
+void transformAndGather8u(const uint8_t* image, int stride, int cols, int rows, const float* anchors, const float* deltas, const float* T, const float* H, float* values, int n, float outside)
+{
+#if DO_ARM_NEON
+    if (hasSimd(kSimdNEON))
+    {
+        return transformAndGather8u_neon(image, stride, cols, rows, anchors, deltas, T, H, values, n, outside);
+    }
+#elif DO_X86_SIMD
+    if (hasSimd(kSimdSSE41))
+    {
+        return transformAndGather8u_sse(image, stride, cols, rows, anchors, deltas, T, H, values, n, outside);
+    }
+#endif
+    transformAndGather8u_c(image, stride, cols, rows, anchors, deltas, T, H, values, n, outside);
+}
+
+// clang-format off
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC pop_options
+#endif
+// clang-format on
+
 void add16sAnd32s()
 {
 }
@@ -25,6 +25,26 @@ void add16sAnd32s(const int32_t* pa, const int16_t* pb, int32_t* pc, int n);
 void add32f(const float* pa, const float* pb, float* pc, int n);
 void convertFixedPoint(const float* pa, int16_t* pb, int n, int fraction);
 
+/*
+ * Transform n points to image coordinates and sample an 8 bit image (nearest neighbor):
+ *
+ *   p = anchors[i] + T * deltas[i]     (p = anchors[i] when deltas == nullptr)
+ *   q = floor(H * [p 1]' + 0.5)
+ *   values[i] = (q inside image) ? image(q.y, q.x) : outside
+ *
+ * anchors and deltas are interleaved {x,y} pairs, T is a row-major 2x2 matrix and H is
+ * a row-major 2x3 affine matrix.  The SIMD (NEON/SSE) kernels produce bit-identical
+ * results to the scalar kernel.
+ */
+void transformAndGather8u(
+    const uint8_t* image, int stride, int cols, int rows,
+    const float* anchors, const float* deltas, const float* T, const float* H,
+    float* values, int n, float outside = 0.f);
+
+// Runtime switch for the SIMD kernels above (default: enabled when available):
+void setSimdEnabled(bool enabled);
+bool getSimdEnabled();
+
 DRISHTI_CORE_NAMESPACE_END
 
 #endif
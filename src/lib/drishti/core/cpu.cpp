@@ -0,0 +1,134 @@
+/*! -*-c++-*-
+  @file   cpu.cpp
+  @author David Hirvonen
+  @brief  Implementation of runtime CPU feature detection for SIMD kernel dispatch.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/cpu.h"
+#include "drishti/core/arithmetic.h" // getSimdEnabled()
+
+#include <array>
+#include <cstdint>
+
+// clang-format off
+#if DRISHTI_CPU_X86
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+#if DRISHTI_CPU_NEON && defined(__arm__) && (defined(__linux__) || defined(__ANDROID__))
+#  include <sys/auxv.h>
+#  define DRISHTI_CPU_HWCAP 1
+#  ifndef HWCAP_NEON
+#    define HWCAP_NEON (1 << 12)
+#  endif
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+using CpuFeatures = std::array<bool, kSimdFeatureCount>;
+
+#if DRISHTI_CPU_X86
+static void cpuid(int leaf, std::uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, 0);
+    for (int i = 0; i < 4; i++)
+    {
+        regs[i] = static_cast<std::uint32_t>(r[i]);
+    }
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0, the register state enabled by the OS (requires OSXSAVE):
+static std::uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    std::uint32_t eax, edx;
+    __asm__ volatile(".byte 0x0f, 0x01, 0xd0" // xgetbv (no -mxsave needed)
+                     : "=a"(eax), "=d"(edx)
+                     : "c"(0));
+    return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static CpuFeatures detect()
+{
+    CpuFeatures features{ {} };
+
+#if DRISHTI_CPU_X86
+    std::uint32_t regs[4] = { 0, 0, 0, 0 }; // eax, ebx, ecx, edx
+    cpuid(0, regs);
+    const std::uint32_t maxLeaf = regs[0];
+    if (maxLeaf >= 1)
+    {
+        cpuid(1, regs);
+        features[kSimdSSE2] = (regs[3] >> 26) & 1;
+        features[kSimdSSE41] = (regs[2] >> 19) & 1;
+        features[kSimdPOPCNT] = (regs[2] >> 23) & 1;
+
+        const bool avx = ((regs[2] >> 27) & 1) && ((regs[2] >> 28) & 1); // OSXSAVE && AVX
+        if (avx && ((xgetbv0() & 0x6) == 0x6) && (maxLeaf >= 7))          // xmm and ymm state
+        {
+            cpuid(7, regs);
+            features[kSimdAVX2] = (regs[1] >> 5) & 1;
+        }
+    }
+#endif
+
+#if DRISHTI_CPU_NEON
+#if DRISHTI_CPU_HWCAP
+    features[kSimdNEON] = (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    features[kSimdNEON] = true; // AArch64 and iOS
+#endif
+#endif
+
+    return features;
+}
+
+bool hasCpuFeature(SimdFeature feature)
+{
+    static const CpuFeatures features = detect();
+    return (feature >= 0) && (feature < kSimdFeatureCount) && features[feature];
+}
+
+bool hasSimd(SimdFeature feature)
+{
+    return getSimdEnabled() && hasCpuFeature(feature);
+}
+
+const char* getSimdFeatureName(SimdFeature feature)
+{
+    switch (feature)
+    {
+        case kSimdSSE2:
+            return "sse2";
+        case kSimdSSE41:
+            return "sse4.1";
+        case kSimdPOPCNT:
+            return "popcnt";
+        case kSimdAVX2:
+            return "avx2";
+        case kSimdNEON:
+            return "neon";
+        default:
+            return "unknown";
+    }
+}
+
+DRISHTI_CORE_NAMESPACE_END
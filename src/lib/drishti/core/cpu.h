@@ -0,0 +1,65 @@
+/*! -*-c++-*-
+  @file   cpu.h
+  @author David Hirvonen
+  @brief  Declaration of runtime CPU feature detection for SIMD kernel dispatch.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  SIMD kernels are compiled for every instruction set the target architecture may have,
+  independent of the build flags, and selected per call with hasSimd().  On x86 the kernels
+  for extensions beyond the build baseline are annotated with DRISHTI_TARGET(), so a single
+  binary built for the baseline runs the SSE2, SSE4.1, POPCNT or AVX2 kernel on each CPU
+  (cpuid).  NEON is always present on AArch64 and iOS, and is checked with
+  getauxval(AT_HWCAP) on 32 bit ARM Linux/Android.
+
+*/
+
+#ifndef __drishti_core_cpu_h__
+#define __drishti_core_cpu_h__
+
+#include "drishti/core/drishti_core.h"
+
+// clang-format off
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define DRISHTI_CPU_X86 1
+#else
+#  define DRISHTI_CPU_X86 0
+#endif
+
+#if (defined(__arm__) || defined(__arm64__) || defined(__aarch64__)) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#  define DRISHTI_CPU_NEON 1
+#else
+#  define DRISHTI_CPU_NEON 0
+#endif
+
+#if DRISHTI_CPU_X86 && (defined(__GNUC__) || defined(__clang__))
+#  define DRISHTI_TARGET(x) __attribute__((target(x)))
+#else
+#  define DRISHTI_TARGET(x)
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+enum SimdFeature
+{
+    kSimdSSE2,
+    kSimdSSE41,
+    kSimdPOPCNT,
+    kSimdAVX2, // including OS support for the ymm state
+    kSimdNEON,
+    kSimdFeatureCount
+};
+
+// Detected once (thread safe), independent of setSimdEnabled():
+bool hasCpuFeature(SimdFeature feature);
+
+// The feature is present and SIMD kernels are enabled (see setSimdEnabled()):
+bool hasSimd(SimdFeature feature);
+
+const char* getSimdFeatureName(SimdFeature feature);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_cpu_h__
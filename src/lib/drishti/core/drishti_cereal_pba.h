@@ -3,6 +3,9 @@
   @author David Hirvonen
   @brief  Provides compatibility with boost::serialization Archive::is_loading::value
 
+  Streams are read in a single forward pass (see core::ModelStream), so archives can
+  be loaded from non seekable sources, with or without a model container header.
+
 */
 
 #ifndef __drishti_core_drishti_cereal_pba_h__
@@ -10,6 +13,7 @@
 
 #include "drishti/core/drishti_core.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/ModelStream.h"
 
 // http://uscilab.github.io/cereal/serialization_archives.html
 #include <cereal/cereal.hpp>
@@ -20,29 +24,27 @@
 
 #include <cassert>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 
+// Cheap check from the current position (no parsing or seeking): a portable binary
+// archive starts with its endianness flag, a model container with its magic.
 inline bool is_cpb(std::istream& is)
 {
-    bool ok = false;
-    is.seekg(0, std::ios_base::beg);
-    try
-    {
-        cereal::PortableBinaryInputArchive ia(is);
-        ok = true;
-    }
-    catch (...)
-    {
-    }
-
-    is.seekg(0, std::ios_base::beg);
-    is.clear();
-    return ok;
+    const auto c = is.peek();
+    return (c == 0) || (c == 1) || (c == 'D');
 }
 
 template <typename T>
 void load_cpb(std::istream& is, T& object)
 {
-    cereal::PortableBinaryInputArchive ia(is);
+    drishti::core::ModelStream stream(is);
+    if (!stream.get() || (stream.getEncoding() != drishti::core::ModelStream::kCPB))
+    {
+        throw std::runtime_error("load_cpb: unsupported model stream");
+    }
+
+    cereal::PortableBinaryInputArchive ia(stream.get());
     ia >> object;
 }
 
@@ -77,6 +79,19 @@ void save_cpb(std::ostream& os, T& object)
     oa << object;
 }
 
+// Write the archive with a model container header (readable by load_cpb()):
+template <typename T>
+void save_cpb(std::ostream& os, T& object, drishti::core::ModelStream::Type type)
+{
+    std::stringstream ss;
+    save_cpb(ss, object);
+
+    drishti::core::ModelStream::Section section;
+    section.size = static_cast<std::uint64_t>(ss.tellp());
+    drishti::core::ModelStream::writeHeader(os, type, { section });
+    os << ss.rdbuf();
+}
+
 template <typename T>
 void save_cpb(const std::string& filename, T& object)
 {
@@ -0,0 +1,173 @@
+/*! -*-c++-*-
+  @file   hessian.cpp
+  @author David Hirvonen
+  @brief  Implementation of an optimized Hessian determinant (blob) response.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/hessian.h"
+#include "drishti/core/cpu.h"
+
+#include <algorithm>
+
+// clang-format off
+#if DRISHTI_CPU_NEON
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+// clang-format on
+
+// clang-format off
+#if DRISHTI_CPU_X86
+#  include <immintrin.h>
+#  define DO_X86_SIMD 1 // SSE2 and AVX2 kernels, selected at runtime (see hasSimd())
+#endif
+// clang-format on
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+// The vector kernels evaluate the same expressions in the same order:
+void hessianBlob32f_c(const float* r0, const float* r1, const float* r2, uint8_t* out, int n, float scale)
+{
+    for (int x = 0; x < n; x++)
+    {
+        const float a = r0[x - 1], b = r0[x], c = r0[x + 1];
+        const float d = r1[x - 1], e = r1[x], f = r1[x + 1];
+        const float g = r2[x - 1], h = r2[x], i = r2[x + 1];
+
+        const float s0 = a + c, s1 = d + f, s2 = g + i;
+        const float ixx = ((s0 - (b + b)) + ((s1 - (e + e)) + (s1 - (e + e))) + (s2 - (h + h))) * (1.f / 16.f);
+        const float iyy = ((s0 + (b + b)) - ((s1 + (e + e)) + (s1 + (e + e))) + (s2 + (h + h))) * (1.f / 16.f);
+        const float ixy = ((a - c) - (g - i)) * 0.25f;
+
+        const float det = (ixx * iyy) - (ixy * ixy);
+        const float value = std::min(std::max(det * scale, 0.f), 255.f) + 0.5f;
+        out[x] = ((ixx + iyy) < 0.f) ? static_cast<uint8_t>(static_cast<int>(value)) : 0;
+    }
+}
+
+#if DO_ARM_NEON
+void hessianBlob32f_neon(const float* r0, const float* r1, const float* r2, uint8_t* out, int n, float scale)
+{
+    const float32x4_t k16 = vdupq_n_f32(1.f / 16.f), k4 = vdupq_n_f32(0.25f), kScale = vdupq_n_f32(scale);
+    const float32x4_t kZero = vdupq_n_f32(0.f), kMax = vdupq_n_f32(255.f), kHalf = vdupq_n_f32(0.5f);
+
+    int x = 0;
+    for (; x <= (n - 4); x += 4)
+    {
+        const float32x4_t a = vld1q_f32(r0 + x - 1), b = vld1q_f32(r0 + x), c = vld1q_f32(r0 + x + 1);
+        const float32x4_t d = vld1q_f32(r1 + x - 1), e = vld1q_f32(r1 + x), f = vld1q_f32(r1 + x + 1);
+        const float32x4_t g = vld1q_f32(r2 + x - 1), h = vld1q_f32(r2 + x), i = vld1q_f32(r2 + x + 1);
+
+        const float32x4_t s0 = vaddq_f32(a, c), s1 = vaddq_f32(d, f), s2 = vaddq_f32(g, i);
+        const float32x4_t b2 = vaddq_f32(b, b), e2 = vaddq_f32(e, e), h2 = vaddq_f32(h, h);
+        const float32x4_t dxx1 = vsubq_f32(s1, e2), dyy1 = vaddq_f32(s1, e2);
+        const float32x4_t ixx = vmulq_f32(vaddq_f32(vaddq_f32(vsubq_f32(s0, b2), vaddq_f32(dxx1, dxx1)), vsubq_f32(s2, h2)), k16);
+        const float32x4_t iyy = vmulq_f32(vaddq_f32(vsubq_f32(vaddq_f32(s0, b2), vaddq_f32(dyy1, dyy1)), vaddq_f32(s2, h2)), k16);
+        const float32x4_t ixy = vmulq_f32(vsubq_f32(vsubq_f32(a, c), vsubq_f32(g, i)), k4);
+
+        const float32x4_t det = vsubq_f32(vmulq_f32(ixx, iyy), vmulq_f32(ixy, ixy));
+        const float32x4_t value = vaddq_f32(vminq_f32(vmaxq_f32(vmulq_f32(det, kScale), kZero), kMax), kHalf);
+        const uint32x4_t mask = vcltq_f32(vaddq_f32(ixx, iyy), kZero);
+        const uint32x4_t result = vandq_u32(vcvtq_u32_f32(value), mask);
+
+        const uint16x4_t narrow = vmovn_u32(result);
+        const uint8x8_t bytes = vmovn_u16(vcombine_u16(narrow, narrow));
+        vst1_lane_u32(reinterpret_cast<uint32_t*>(out + x), vreinterpret_u32_u8(bytes), 0);
+    }
+    hessianBlob32f_c(r0 + x, r1 + x, r2 + x, out + x, n - x, scale);
+}
+#endif
+
+#if DO_X86_SIMD
+DRISHTI_TARGET("sse2")
+void hessianBlob32f_sse2(const float* r0, const float* r1, const float* r2, uint8_t* out, int n, float scale)
+{
+    const __m128 k16 = _mm_set1_ps(1.f / 16.f), k4 = _mm_set1_ps(0.25f), kScale = _mm_set1_ps(scale);
+    const __m128 kZero = _mm_setzero_ps(), kMax = _mm_set1_ps(255.f), kHalf = _mm_set1_ps(0.5f);
+
+    int x = 0;
+    for (; x <= (n - 4); x += 4)
+    {
+        const __m128 a = _mm_loadu_ps(r0 + x - 1), b = _mm_loadu_ps(r0 + x), c = _mm_loadu_ps(r0 + x + 1);
+        const __m128 d = _mm_loadu_ps(r1 + x - 1), e = _mm_loadu_ps(r1 + x), f = _mm_loadu_ps(r1 + x + 1);
+        const __m128 g = _mm_loadu_ps(r2 + x - 1), h = _mm_loadu_ps(r2 + x), i = _mm_loadu_ps(r2 + x + 1);
+
+        const __m128 s0 = _mm_add_ps(a, c), s1 = _mm_add_ps(d, f), s2 = _mm_add_ps(g, i);
+        const __m128 b2 = _mm_add_ps(b, b), e2 = _mm_add_ps(e, e), h2 = _mm_add_ps(h, h);
+        const __m128 dxx1 = _mm_sub_ps(s1, e2), dyy1 = _mm_add_ps(s1, e2);
+        const __m128 ixx = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_sub_ps(s0, b2), _mm_add_ps(dxx1, dxx1)), _mm_sub_ps(s2, h2)), k16);
+        const __m128 iyy = _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_add_ps(s0, b2), _mm_add_ps(dyy1, dyy1)), _mm_add_ps(s2, h2)), k16);
+        const __m128 ixy = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(a, c), _mm_sub_ps(g, i)), k4);
+
+        const __m128 det = _mm_sub_ps(_mm_mul_ps(ixx, iyy), _mm_mul_ps(ixy, ixy));
+        const __m128 value = _mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(det, kScale), kZero), kMax), kHalf);
+        const __m128i mask = _mm_castps_si128(_mm_cmplt_ps(_mm_add_ps(ixx, iyy), kZero));
+        const __m128i result = _mm_and_si128(_mm_cvttps_epi32(value), mask);
+
+        const __m128i words = _mm_packs_epi32(result, result);
+        const __m128i bytes = _mm_packus_epi16(words, words);
+        const int packed = _mm_cvtsi128_si32(bytes);
+        std::copy(reinterpret_cast<const uint8_t*>(&packed), reinterpret_cast<const uint8_t*>(&packed) + 4, out + x);
+    }
+    hessianBlob32f_c(r0 + x, r1 + x, r2 + x, out + x, n - x, scale);
+}
+
+DRISHTI_TARGET("avx2")
+void hessianBlob32f_avx2(const float* r0, const float* r1, const float* r2, uint8_t* out, int n, float scale)
+{
+    const __m256 k16 = _mm256_set1_ps(1.f / 16.f), k4 = _mm256_set1_ps(0.25f), kScale = _mm256_set1_ps(scale);
+    const __m256 kZero = _mm256_setzero_ps(), kMax = _mm256_set1_ps(255.f), kHalf = _mm256_set1_ps(0.5f);
+
+    int x = 0;
+    for (; x <= (n - 8); x += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(r0 + x - 1), b = _mm256_loadu_ps(r0 + x), c = _mm256_loadu_ps(r0 + x + 1);
+        const __m256 d = _mm256_loadu_ps(r1 + x - 1), e = _mm256_loadu_ps(r1 + x), f = _mm256_loadu_ps(r1 + x + 1);
+        const __m256 g = _mm256_loadu_ps(r2 + x - 1), h = _mm256_loadu_ps(r2 + x), i = _mm256_loadu_ps(r2 + x + 1);
+
+        const __m256 s0 = _mm256_add_ps(a, c), s1 = _mm256_add_ps(d, f), s2 = _mm256_add_ps(g, i);
+        const __m256 b2 = _mm256_add_ps(b, b), e2 = _mm256_add_ps(e, e), h2 = _mm256_add_ps(h, h);
+        const __m256 dxx1 = _mm256_sub_ps(s1, e2), dyy1 = _mm256_add_ps(s1, e2);
+        const __m256 ixx = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(s0, b2), _mm256_add_ps(dxx1, dxx1)), _mm256_sub_ps(s2, h2)), k16);
+        const __m256 iyy = _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_add_ps(s0, b2), _mm256_add_ps(dyy1, dyy1)), _mm256_add_ps(s2, h2)), k16);
+        const __m256 ixy = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(a, c), _mm256_sub_ps(g, i)), k4);
+
+        const __m256 det = _mm256_sub_ps(_mm256_mul_ps(ixx, iyy), _mm256_mul_ps(ixy, ixy));
+        const __m256 value = _mm256_add_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(det, kScale), kZero), kMax), kHalf);
+        const __m256i mask = _mm256_castps_si256(_mm256_cmp_ps(_mm256_add_ps(ixx, iyy), kZero, _CMP_LT_OQ));
+        const __m256i result = _mm256_and_si256(_mm256_cvttps_epi32(value), mask);
+
+        // 8 x 32 bit -> 8 x 8 bit (packs work per 128 bit lane):
+        const __m128i lo = _mm256_castsi256_si128(result), hi = _mm256_extracti128_si256(result, 1);
+        const __m128i words = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(words, words));
+    }
+    hessianBlob32f_c(r0 + x, r1 + x, r2 + x, out + x, n - x, scale);
+}
+#endif
+
+void hessianBlob32f(const float* r0, const float* r1, const float* r2, uint8_t* out, int n, float scale)
+{
+#if DO_ARM_NEON
+    if (hasSimd(kSimdNEON))
+    {
+        return hessianBlob32f_neon(r0, r1, r2, out, n, scale);
+    }
+#elif DO_X86_SIMD
+    if (hasSimd(kSimdAVX2))
+    {
+        return hessianBlob32f_avx2(r0, r1, r2, out, n, scale);
+    }
+    if (hasSimd(kSimdSSE2))
+    {
+        return hessianBlob32f_sse2(r0, r1, r2, out, n, scale);
+    }
+#endif
+    hessianBlob32f_c(r0, r1, r2, out, n, scale);
+}
+
+DRISHTI_CORE_NAMESPACE_END
@@ -0,0 +1,37 @@
+/*! -*-c++-*-
+  @file   hessian.h
+  @author David Hirvonen
+  @brief  Declaration of an optimized Hessian determinant (blob) response.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_core_hessian_h__
+#define __drishti_core_hessian_h__
+
+#include "drishti/core/drishti_core.h"
+
+#include <cstdint>
+
+DRISHTI_CORE_NAMESPACE_BEGIN
+
+/*
+ * Bright blob response for one row from three consecutive rows of a smoothed image, with
+ * the 3x3 Ixx, Iyy and Ixy kernels of ogles_gpgpu::HessianProc fused in a single pass:
+ *
+ *   Ixx = [ 1 -2  1 ; 2 -4  2 ;  1 -2  1 ] / 16
+ *   Iyy = [ 1  2  1 ;-2 -4 -2 ;  1  2  1 ] / 16
+ *   Ixy = [ 1  0 -1 ; 0  0  0 ; -1  0  1 ] / 4
+ *
+ *   out[x] = (Ixx + Iyy < 0) ? floor(min(max(scale * (Ixx * Iyy - Ixy^2), 0), 255) + 0.5) : 0
+ *
+ * for x in [0, n), where rows[x - 1] and rows[n] must be readable (the caller provides the
+ * border).  The SIMD (NEON/SSE2/AVX2) kernels produce bit-identical results to the scalar one.
+ */
+void hessianBlob32f(const float* r0, const float* r1, const float* r2, uint8_t* out, int n, float scale);
+
+DRISHTI_CORE_NAMESPACE_END
+
+#endif // __drishti_core_hessian_h__
@@ -8,7 +8,7 @@
 
 */
 
-#include "drishti/core/drishti_core.h"
+#include "drishti/core/padding.h"
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/photo.hpp>
@@ -17,7 +17,12 @@
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
-cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, bool inPaint)
+static PaddingMode getPaddingMode(bool inPaint)
+{
+    return inPaint ? kPadInpaint : kPadConstant;
+}
+
+cv::Point padImage(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, PaddingMode mode)
 {
     if (top <= 0 && bottom <= 0 && left <= 0 && right <= 0)
     {
@@ -25,19 +30,75 @@ cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int
         return cv::Point(0, 0);
     }
 
-    cv::Mat mask;
-    cv::copyMakeBorder(image, padded, std::max(top, 0), std::max(bottom, 0), std::max(left, 0), std::max(right, 0), cv::BORDER_CONSTANT);
-    mask = cv::Mat::zeros(padded.size(), CV_8UC1);
-    mask({ { std::max(left, 0), std::max(top, 0) }, image.size() }).setTo(255);
+    top = std::max(top, 0);
+    bottom = std::max(bottom, 0);
+    left = std::max(left, 0);
+    right = std::max(right, 0);
 
-    cv::Mat painted;
-    cv::inpaint(padded, mask, painted, std::min(image.cols, image.rows)/16.0, cv::INPAINT_TELEA);
-    cv::swap(padded, painted);
+    // Only pixels of image are used (not the parent of a submatrix):
+    switch (mode)
+    {
+        case kPadReplicate:
+            cv::copyMakeBorder(image, padded, top, bottom, left, right, cv::BORDER_REPLICATE | cv::BORDER_ISOLATED);
+            break;
+        case kPadReflect:
+            cv::copyMakeBorder(image, padded, top, bottom, left, right, cv::BORDER_REFLECT_101 | cv::BORDER_ISOLATED);
+            break;
+        case kPadMean:
+            cv::copyMakeBorder(image, padded, top, bottom, left, right, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED, cv::mean(image));
+            break;
+        case kPadConstant:
+            cv::copyMakeBorder(image, padded, top, bottom, left, right, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED, cv::Scalar::all(0));
+            break;
+        case kPadInpaint:
+        {
+            cv::Mat mask;
+            cv::copyMakeBorder(image, padded, top, bottom, left, right, cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+            mask = cv::Mat::zeros(padded.size(), CV_8UC1);
+            mask({ { left, top }, image.size() }).setTo(255);
+
+            cv::Mat painted;
+            cv::inpaint(padded, mask, painted, std::min(image.cols, image.rows) / 16.0, cv::INPAINT_TELEA);
+            cv::swap(padded, painted);
+            break;
+        }
+    }
 
     return cv::Point(left, top);
 }
 
+void cropWithPadding(const cv::Mat& image, const cv::Rect& roi, cv::Mat& crop, PaddingMode mode)
+{
+    const cv::Rect bounds = roi & cv::Rect({ 0, 0 }, image.size());
+    if (bounds == roi)
+    {
+        crop = image(roi); // shallow copy
+        return;
+    }
+
+    if (bounds.area() == 0)
+    {
+        crop.create(roi.size(), image.type());
+        crop.setTo(cv::Scalar::all(0));
+        return;
+    }
+
+    const int top = bounds.y - roi.y, left = bounds.x - roi.x;
+    const int bottom = roi.br().y - bounds.br().y, right = roi.br().x - bounds.br().x;
+    padImage(image(bounds), crop, top, bottom, left, right, (mode == kPadInpaint) ? kPadReplicate : mode);
+}
+
+cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, bool inPaint)
+{
+    return padImage(image, padded, top, bottom, left, right, getPaddingMode(inPaint));
+}
+
 cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, bool inPaint)
+{
+    return padToAspectRatio(image, padded, aspectRatio, getPaddingMode(inPaint));
+}
+
+cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, PaddingMode mode)
 {
     CV_Assert(image.channels() == 3);
 
@@ -55,10 +116,15 @@ cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectR
         right = padding - left;
     }
 
-    return padWithInpainting(image, padded, top, bottom, left, right, inPaint);
+    return padImage(image, padded, top, bottom, left, right, mode);
 }
 
 cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, bool inPaint)
+{
+    return padToWidthUsingAspectRatio(canvas, padded, width, aspectRatio, getPaddingMode(inPaint));
+}
+
+cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, PaddingMode mode)
 {
     int height = double(width) / aspectRatio;
     int top = 0, left = 0, bottom = 0, right = 0;
@@ -73,14 +139,14 @@ cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int
         int vPad = (height - canvas.rows);
         top = vPad / 2;
         bottom = vPad - top;
-        tl = padWithInpainting(canvas, padded, top, bottom, left, right, inPaint);
+        tl = padImage(canvas, padded, top, bottom, left, right, mode);
     }
     else
     {
         int vCrop = (canvas.rows - height);
         top = vCrop / 2;
         bottom = vCrop - top;
-        tl = padWithInpainting(canvas, padded, top, bottom, left, right, inPaint);
+        tl = padImage(canvas, padded, top, bottom, left, right, mode);
     }
 
     if (left < 0 || right < 0 || top < 0 || bottom < 0)
@@ -16,6 +16,26 @@
 
 DRISHTI_CORE_NAMESPACE_BEGIN
 
+// Border fill modes: all but kPadInpaint are a single pass (cv::copyMakeBorder) into the output,
+// which is only (re)allocated on a size or type mismatch, so they are suitable for per frame use.
+enum PaddingMode
+{
+    kPadConstant,  // zero
+    kPadReplicate, // edge pixels
+    kPadReflect,   // mirrored about the edge pixels
+    kPadMean,      // image mean
+    kPadInpaint    // cv::INPAINT_TELEA (slow: offline dataset generation only)
+};
+
+cv::Point padImage(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, PaddingMode mode);
+cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, PaddingMode mode);
+cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, PaddingMode mode);
+
+// Crop roi into a roi sized buffer, pixels outside the image are filled with mode (a shallow
+// copy is returned when roi is inside the image, kPadInpaint is treated as kPadReplicate):
+void cropWithPadding(const cv::Mat& image, const cv::Rect& roi, cv::Mat& crop, PaddingMode mode);
+
+// The inPaint flag selects kPadInpaint or kPadConstant:
 cv::Point padWithInpainting(const cv::Mat& image, cv::Mat& padded, int top, int bottom, int left, int right, bool inPaint = true);
 cv::Point padToAspectRatio(const cv::Mat& image, cv::Mat& padded, double aspectRatio, bool inPaint = true);
 cv::Point padToWidthUsingAspectRatio(const cv::Mat& canvas, cv::Mat& padded, int width, double aspectRatio, bool inPaint = true);
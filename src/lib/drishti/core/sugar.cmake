@@ -12,10 +12,23 @@ endif()
 include(sugar_files)
 
 sugar_files(DRISHTI_CORE_SRCS
+  AppendSink.cpp
+  Arena.cpp
+  AsyncLogger.cpp
+  BudgetController.cpp
+  FlatArchive.cpp
+  LazyChannelImage.cpp
   Logger.cpp
+  MemoryRegistry.cpp
+  ModelBundle.cpp
+  ModelStream.cpp
   Shape.cpp
+  StageTracer.cpp
+  WorkerGroup.cpp
   arithmetic.cpp
+  cpu.cpp
   drawing.cpp
+  hessian.cpp
   hungarian.cpp
   padding.cpp
   string_utils.cpp
@@ -23,19 +36,38 @@ sugar_files(DRISHTI_CORE_SRCS
 
 # For now make them all public
 sugar_files(DRISHTI_CORE_HDRS_PUBLIC
+  AppendSink.h
+  Arena.h
+  AsyncLogger.h
+  BatchQueue.h
+  BudgetController.h
   Field.h
+  FixedAssignment.h
+  FixedVector.h
   FixedField.h
+  FlatArchive.h
   ImageView.h
   IndentingOStreamBuffer.h
+  LazyChannelImage.h
   LazyParallelResource.h
   Line.h
   Logger.h
+  MemoryRegistry.h
+  ModelBundle.h
+  ModelStream.h
   Parallel.h
   Semaphore.h
   Shape.h
+  SharedPool.h
+  SlotRing.h
+  SpinBarrier.h
+  StageTracer.h
   ThrowAssert.h
+  WorkerGroup.h
   arithmetic.h
+  cpu.h
   drawing.h
+  hessian.h
   drishti_algorithm.h
   drishti_cereal_pba.h
   drishti_core.h
@@ -58,8 +90,8 @@ sugar_files(DRISHTI_CORE_HDRS_PUBLIC
 )
 
 if(DRISHTI_USE_THREAD_POOL_CPP)
-  sugar_files(DRISHTI_CORE_HDRS_PUBLIC ThreadPool.h)
-  sugar_files(DRISHTI_CORE_SRCS ThreadPool.cpp)  
+  sugar_files(DRISHTI_CORE_HDRS_PUBLIC TaskGraph.h ThreadPool.h)
+  sugar_files(DRISHTI_CORE_SRCS TaskGraph.cpp ThreadPool.cpp)
 endif()
 
 sugar_files(DRISHTI_CORE_UT
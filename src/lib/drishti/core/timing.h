@@ -39,8 +39,11 @@ public:
 
     ~ScopeTimeLogger()
     {
-        auto now = HighResolutionClock::now();
-        m_logger(timeDifference(now, m_tic));
+        if (m_logger) // moved-from instances are silent
+        {
+            auto now = HighResolutionClock::now();
+            m_logger(timeDifference(now, m_tic));
+        }
     }
 
     ScopeTimeLogger(const ScopeTimeLogger&) = delete;
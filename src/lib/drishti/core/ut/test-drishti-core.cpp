@@ -10,9 +10,53 @@
 
 #include <gtest/gtest.h>
 
+#include "drishti/core/AppendSink.h"
+#include "drishti/core/Arena.h"
+#include "drishti/core/AsyncLogger.h"
+#include "drishti/core/BatchQueue.h"
+#include "drishti/core/arithmetic.h"
+#include "drishti/core/cpu.h"
+#include "drishti/core/hessian.h"
 #include "drishti/core/hungarian.h"
+#include "drishti/core/FixedAssignment.h"
+#include "drishti/core/FlatArchive.h"
+#include "drishti/core/LazyChannelImage.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/SharedPool.h"
+#include "drishti/core/Shape.h"
+#include "drishti/core/SlotRing.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/core/MemoryRegistry.h"
+#include "drishti/core/ModelBundle.h"
+#include "drishti/core/ModelStream.h"
+#include "drishti/core/padding.h"
+#include "drishti/core/BudgetController.h"
+#include "drishti/core/StageTracer.h"
+#include "drishti/core/TaskGraph.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/WorkerGroup.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <spdlog/sinks/ostream_sink.h>
+
 // clang-format off
 #define BEGIN_EMPTY_NAMESPACE namespace {
 #define END_EMPTY_NAMESPACE }
@@ -55,4 +99,1104 @@ TEST(HungarianAssignment, hungarian) // NOLINT (TODO)
     }
 }
 
+TEST(FixedAssignment, hungarian) // NOLINT (TODO)
+{
+    cv::RNG rng(1);
+    for (int trial = 0; trial < 100; trial++)
+    {
+        const int rows = rng.uniform(1, 9), cols = rng.uniform(1, 9);
+
+        drishti::core::FixedAssignment<double, 8> assignment;
+        ASSERT_TRUE(assignment.resize(rows, cols));
+
+        std::vector<std::vector<double>> C(rows, std::vector<double>(cols));
+        for (int i = 0; i < rows; i++)
+        {
+            for (int j = 0; j < cols; j++)
+            {
+                assignment(i, j) = C[i][j] = rng.uniform(0.0, 1.0);
+            }
+        }
+
+        int direct[8];
+        ASSERT_EQ(assignment.solve(direct), std::min(rows, cols));
+
+        std::unordered_map<int, int> direct_assignment;
+        std::unordered_map<int, int> reverse_assignment;
+        drishti::core::MinimizeLinearAssignment(C, direct_assignment, reverse_assignment);
+
+        double cost = 0.0, reference = 0.0;
+        for (int i = 0; i < rows; i++)
+        {
+            cost += (direct[i] >= 0) ? C[i][direct[i]] : 0.0;
+        }
+        for (const auto& m : direct_assignment)
+        {
+            reference += C[m.first][m.second];
+        }
+        ASSERT_NEAR(cost, reference, 1e-9);
+    }
+
+    drishti::core::FixedAssignment<double, 8> assignment;
+    ASSERT_FALSE(assignment.resize(9, 1));
+}
+
+TEST(StageTracer, percentiles) // NOLINT (TODO)
+{
+    drishti::core::StageTracer tracer({ "a", "b" }, 100); // rounded up to 128
+    ASSERT_EQ(tracer.getCapacity(), 128);
+
+    for (int i = 1; i <= 100; i++)
+    {
+        tracer.record(0, i, static_cast<double>(i));
+    }
+    tracer.record(1, 0, 1.0);
+
+    ASSERT_EQ(tracer.getSpans(0).size(), 100);
+    ASSERT_DOUBLE_EQ(tracer.p50(0), 50.0);
+    ASSERT_DOUBLE_EQ(tracer.p95(0), 95.0);
+    ASSERT_DOUBLE_EQ(tracer.p99(0), 99.0);
+    ASSERT_DOUBLE_EQ(tracer.p50(1), 1.0);
+}
+
+TEST(AsyncLogger, sampleAndDrop) // NOLINT (TODO)
+{
+    std::stringstream ss;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(ss);
+    auto logger = std::make_shared<spdlog::logger>("test-async-logger", sink);
+    logger->set_pattern("%v");
+
+    drishti::core::AsyncLogger::Settings settings;
+    settings.capacity = 4;
+    settings.interval = std::chrono::hours(1); // flush() only
+    drishti::core::AsyncLogger async(logger, settings);
+
+    const int gaze = async.addCategory("gaze", 2);
+    for (int i = 0; i < 4; i++)
+    {
+        async.info(gaze, "GAZE: {} {:f} {}", i, 0.5, "ok");
+    }
+    async.flush();
+    ASSERT_EQ(ss.str(), "GAZE: 0 0.500000 ok\nGAZE: 2 0.500000 ok\n");
+
+    // The writer is idle until flush(), so the ring holds 4 of 6 records:
+    for (int i = 0; i < 6; i++)
+    {
+        async.info(-1, "{{{}}}", i);
+    }
+    async.flush();
+    ASSERT_EQ(async.getDroppedCount(), 2);
+    ASSERT_EQ(async.getWrittenCount(), 6);
+    ASSERT_NE(ss.str().find("{3}"), std::string::npos);
+}
+
+TEST(BudgetController, degradeAndRestore) // NOLINT (TODO)
+{
+    drishti::core::StageTracer tracer({ "frame", "eyes" });
+
+    drishti::core::BudgetController::Settings settings;
+    settings.target = 10.0;
+    settings.window = 4;
+    drishti::core::BudgetController controller(settings);
+
+    // Each eye level saves 4 "seconds" of a 4 + 4 * (2 - level) + 4 frame:
+    int eyes = 0, interval = 0;
+    controller.add({ "eyes", 2, [&](int level) { eyes = level; }, 1 });
+    controller.add({ "interval", 1, [&](int level) { interval = level; } });
+    controller.setCost({ { 0, 1 } });
+
+    std::uint64_t frame = 0;
+    double load = 1.0;
+    auto run = [&](int frames) {
+        for (int i = 0; i < frames; i++, frame++)
+        {
+            controller.update(tracer, frame); // decisions apply to this frame
+            tracer.record(0, frame, load * 4.0);
+            tracer.record(1, frame, load * (4.0 * (2 - eyes) + ((interval == 0) ? 4.0 : 0.0)));
+        }
+    };
+
+    run(16); // 16 -> 12 -> 8 (eyes first), then 8 is within [7.5, 10]
+    EXPECT_EQ(eyes, 2);
+    EXPECT_EQ(interval, 0);
+    EXPECT_EQ(controller.getChangeCount(), 2);
+
+    load = 0.5; // e.g., the device cools down
+    run(20);    // 4 -> 6 -> 8
+    EXPECT_EQ(eyes, 0);
+    EXPECT_EQ(controller.getChangeCount(), 4);
+}
+
+TEST(StageTracer, wrap) // NOLINT (TODO)
+{
+    drishti::core::StageTracer tracer({ "a" }, 16);
+    for (int i = 0; i < 40; i++)
+    {
+        tracer.record(0, i, 0.0);
+    }
+
+    const auto spans = tracer.getSpans();
+    ASSERT_EQ(spans.size(), 16);
+    ASSERT_EQ(spans.front().frame, 24);
+    ASSERT_EQ(spans.back().frame, 39);
+}
+
+TEST(StageTracer, overlap) // NOLINT (TODO)
+{
+    // Spans end at record() time, so a = [t-10, t], b = [t'-5, t'] and c = [t''-1, t''] with t ~ t' ~ t'':
+    drishti::core::StageTracer tracer({ "a", "b", "c" });
+    tracer.record(0, 0, 10.0);
+    tracer.record(1, 0, 5.0);
+    tracer.record(2, 0, 1.0);
+
+    ASSERT_NEAR(tracer.overlap({ 0 }, { 1 }), 5.0, 1e-2);
+    ASSERT_NEAR(tracer.overlap({ 1, 2 }, { 0 }), 5.0, 1e-2); // merged union
+    ASSERT_NEAR(tracer.overlap({ 0 }, {}), 0.0, 1e-6);
+}
+
+TEST(StageTracer, chrome) // NOLINT (TODO)
+{
+    drishti::core::StageTracer tracer({ "detect" });
+    {
+        auto span = tracer.scope(0, 7);
+    }
+
+    std::stringstream ss;
+    tracer.writeChromeTrace(ss);
+    ASSERT_NE(ss.str().find("\"name\":\"detect\""), std::string::npos);
+    ASSERT_NE(ss.str().find("\"frame\":7"), std::string::npos);
+}
+
+TEST(StageTracer, lane) // NOLINT (TODO)
+{
+    using Clock = drishti::core::StageTracer::HighResolutionClock;
+
+    drishti::core::StageTracer tracer({ "cpu", "gpu" });
+    tracer.record(0, 3, 0.5);
+
+    // A span resolved later, which ended 2 seconds in the past on its own lane:
+    const auto stop = Clock::now() - std::chrono::seconds(2);
+    tracer.record(1, 3, 1.0, stop, 42);
+
+    const auto spans = tracer.getSpans(1);
+    ASSERT_EQ(spans.size(), 1);
+    ASSERT_EQ(spans[0].thread, 42);
+    ASSERT_DOUBLE_EQ(spans[0].duration, 1.0);
+    ASSERT_LT(spans[0].start + spans[0].duration, tracer.getSpans(0)[0].start); // not at record() time
+    ASSERT_NEAR(tracer.overlap({ 0 }, { 1 }), 0.0, 1e-6);
+}
+
+TEST(arithmetic, transformAndGather8u) // NOLINT (TODO)
+{
+    const int cols = 37, rows = 23, stride = 40, n = 103;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coordinate(-0.25f, 1.25f), offset(-0.1f, 0.1f);
+
+    std::vector<uint8_t> image(stride * rows);
+    for (std::size_t i = 0; i < image.size(); i++)
+    {
+        image[i] = uint8_t(i * 7);
+    }
+
+    std::vector<float> anchors(n * 2), deltas(n * 2);
+    for (int i = 0; i < n * 2; i++)
+    {
+        anchors[i] = coordinate(rng);
+        deltas[i] = offset(rng);
+    }
+
+    const float T[4] = { 0.9f, -0.1f, 0.1f, 0.9f };
+    const float H[6] = { float(cols), 0.f, 0.f, 0.f, float(rows), 0.f };
+
+    for (const float* d : { static_cast<const float*>(nullptr), static_cast<const float*>(deltas.data()) })
+    {
+        std::vector<float> reference(n), values(n);
+
+        drishti::core::setSimdEnabled(false);
+        drishti::core::transformAndGather8u(image.data(), stride, cols, rows, anchors.data(), d, T, H, reference.data(), n);
+        drishti::core::setSimdEnabled(true);
+        drishti::core::transformAndGather8u(image.data(), stride, cols, rows, anchors.data(), d, T, H, values.data(), n);
+
+        for (int i = 0; i < n; i++)
+        {
+            ASSERT_EQ(reference[i], values[i]);
+        }
+
+        if (!d)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                const int x = int(std::floor(anchors[i * 2 + 0] * cols + 0.5f));
+                const int y = int(std::floor(anchors[i * 2 + 1] * rows + 0.5f));
+                const bool inside = (x >= 0) && (x < cols) && (y >= 0) && (y < rows);
+                ASSERT_EQ(reference[i], inside ? float(image[y * stride + x]) : 0.f);
+            }
+        }
+    }
+}
+
+// Runtime dispatched kernels match the scalar kernels (odd sizes exercise the tails):
+TEST(arithmetic, dispatch) // NOLINT (TODO)
+{
+    ASSERT_FALSE(drishti::core::hasCpuFeature(drishti::core::kSimdFeatureCount));
+
+    const int n = 37;
+    std::vector<float> fa(n), fb(n);
+    std::vector<int16_t> sa(n), sb(n);
+    std::vector<int32_t> ia(n);
+    for (int i = 0; i < n; i++)
+    {
+        fa[i] = float(i) * 0.37f - 5.f;
+        fb[i] = float(i) * 1.1f;
+        sa[i] = int16_t(i * 100 - 1000);
+        sb[i] = int16_t(-i * 7);
+        ia[i] = i * 1000 - 9;
+    }
+
+    std::vector<float> f32[2];
+    std::vector<int16_t> s16[2], fixed[2];
+    std::vector<int32_t> s32[2];
+    for (int k = 0; k < 2; k++)
+    {
+        f32[k].resize(n);
+        s16[k].resize(n);
+        s32[k].resize(n);
+        fixed[k].resize(n);
+
+        drishti::core::setSimdEnabled(k == 1);
+        drishti::core::add32f(fa.data(), fb.data(), f32[k].data(), n);
+        drishti::core::add16sAnd16s(sa.data(), sb.data(), s16[k].data(), n);
+        drishti::core::add16sAnd32s(ia.data(), sb.data(), s32[k].data(), n);
+        drishti::core::convertFixedPoint(fb.data(), fixed[k].data(), n, 4);
+    }
+    drishti::core::setSimdEnabled(true);
+
+    ASSERT_EQ(f32[0], f32[1]);
+    ASSERT_EQ(s16[0], s16[1]);
+    ASSERT_EQ(s32[0], s32[1]);
+#if !(defined(__arm__) || defined(__arm64__) || defined(__aarch64__))
+    ASSERT_EQ(fixed[0], fixed[1]); // NEON rounds to nearest
+#endif
+}
+
+// Bright blobs respond at the center only, and the SIMD kernels are bit-identical:
+TEST(hessian, blob) // NOLINT (TODO)
+{
+    const int cols = 37, rows = 3;
+    std::vector<float> image(rows * (cols + 2), 0.f);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    for (auto& value : image)
+    {
+        value = uniform(rng) * 0.1f;
+    }
+
+    // A small bright spot centered at x = 10 in the middle row:
+    const int stride = cols + 2;
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 9; x <= 13; x++)
+        {
+            const float dx = float(x - 11), dy = float(y - 1);
+            image[y * stride + x] += std::exp(-(dx * dx + dy * dy) * 0.5f);
+        }
+    }
+
+    std::array<std::vector<uint8_t>, 2> response;
+    for (int k = 0; k < 2; k++)
+    {
+        response[k].resize(cols);
+        drishti::core::setSimdEnabled(k == 1);
+        drishti::core::hessianBlob32f(&image[1], &image[stride + 1], &image[2 * stride + 1], response[k].data(), cols, 255.f * 4.f); // unsaturated
+    }
+    drishti::core::setSimdEnabled(true);
+
+    ASSERT_EQ(response[0], response[1]);
+    const auto peak = std::max_element(response[0].begin(), response[0].end());
+    EXPECT_EQ(std::distance(response[0].begin(), peak), 10);
+    EXPECT_GT(*peak, 0);
+}
+
+TEST(WorkerGroup, barrier) // NOLINT (TODO)
+{
+    const int lanes = 4, phases = 100;
+    drishti::core::WorkerGroup workers(lanes);
+    ASSERT_EQ(workers.size(), lanes);
+
+    for (int run = 0; run < 3; run++)
+    {
+        std::vector<int> values(lanes, 0);
+        std::vector<int> sums(phases, 0);
+        bool ok = workers.tryRun([&](int lane, drishti::core::SpinBarrier& barrier) {
+            for (int i = 0; i < phases; i++)
+            {
+                values[lane] = i + lane;
+                barrier.wait(); // all values written
+                if (lane == 0)
+                {
+                    for (const auto& v : values)
+                    {
+                        sums[i] += v;
+                    }
+                }
+                barrier.wait(); // all values read
+            }
+        });
+
+        ASSERT_TRUE(ok);
+        for (int i = 0; i < phases; i++)
+        {
+            ASSERT_EQ(sums[i], (i * lanes) + (lanes * (lanes - 1) / 2));
+        }
+    }
+}
+
+TEST(SlotRing, order) // NOLINT (TODO)
+{
+    std::atomic<int> calls{ 0 };
+    drishti::core::SlotRing<std::pair<int, int>> ring(3, [&](std::pair<int, int>& item) {
+        if (item.first < 0)
+        {
+            throw std::runtime_error("job");
+        }
+        item.second = calls++;
+    });
+    ASSERT_EQ(ring.capacity(), std::size_t(3));
+
+    int submitted = 0, released = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        // The producer never waits for a free slot:
+        while (auto* item = ring.acquire())
+        {
+            *item = { submitted++, -1 };
+            ring.push();
+        }
+        ASSERT_EQ(ring.size(), ring.capacity());
+
+        ring.wait(0);
+        ASSERT_TRUE(ring.isDone(0));
+        ASSERT_EQ(ring.get(0).first, released);
+        ASSERT_EQ(ring.get(0).second, released); // submission order
+        ring.pop();
+        released++;
+    }
+
+    ring.drain();
+    ASSERT_TRUE(ring.isDone(ring.size() - 1));
+
+    // Job exceptions are rethrown for the item:
+    while (ring.size())
+    {
+        ring.pop();
+    }
+    *ring.acquire() = { -1, -1 };
+    ring.push();
+    ring.wait(0);
+    EXPECT_THROW(ring.get(0), std::runtime_error);
+    ring.pop();
+    EXPECT_EQ(calls, submitted);
+}
+
+TEST(LazyChannelImage, channel) // NOLINT (TODO)
+{
+    cv::Mat3b image(48, 64);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    cv::Mat resized, planes[3];
+    cv::resize(image, resized, {}, 0.5, 0.5, cv::INTER_CUBIC);
+    cv::split(resized, planes);
+
+    drishti::core::LazyChannelImage lazy(image, 0.5f, cv::INTER_CUBIC);
+    ASSERT_EQ(lazy.size(), resized.size());
+    for (int i : { 2, 0 })
+    {
+        const cv::Mat& plane = lazy.channel(i);
+        ASSERT_EQ(plane.size(), resized.size());
+        EXPECT_EQ(cv::countNonZero(plane != planes[i]), 0);
+        EXPECT_EQ(plane.data, lazy.channel(i).data); // cached
+    }
+
+    int calls = 0;
+    auto gray = [&](const cv::Mat& I) {
+        calls++;
+        cv::Mat result;
+        cv::cvtColor(I, result, cv::COLOR_BGR2GRAY);
+        return result;
+    };
+    lazy.derived(0, gray);
+    lazy.derived(0, gray);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Arena, resetAndReuse) // NOLINT (TODO)
+{
+    drishti::core::Arena arena(1024);
+
+    // Overflow blocks are consolidated on reset:
+    for (int i = 0; i < 8; i++)
+    {
+        void* p = arena.allocate(500, 64);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, std::uintptr_t(0));
+    }
+    EXPECT_GT(arena.getBlockAllocations(), std::size_t(1));
+    EXPECT_TRUE(arena.reset());
+
+    // Steady state frames don't allocate:
+    const std::size_t allocations = arena.getBlockAllocations();
+    for (int frame = 0; frame < 4; frame++)
+    {
+        drishti::core::ArenaVector<int> values(&arena);
+        values.reserve(100);
+        for (int i = 0; i < 8; i++)
+        {
+            arena.allocate(400, 64);
+        }
+        EXPECT_TRUE(arena.reset());
+    }
+    EXPECT_EQ(arena.getBlockAllocations(), allocations);
+}
+
+TEST(Arena, matAllocator) // NOLINT (TODO)
+{
+    drishti::core::FrameArena frame(1024);
+
+    {
+        drishti::core::FrameArena::Scope scope(&frame);
+        ASSERT_EQ(drishti::core::FrameArena::current(), &frame);
+
+        cv::Mat1b image(32, 32);
+        cv::randu(image, 0, 255);
+
+        cv::Mat resized = drishti::core::arenaMat();
+        cv::resize(image, resized, {}, 2.0, 2.0, cv::INTER_LINEAR);
+        EXPECT_EQ(frame.local().getLive(), 1);
+        EXPECT_GE(frame.local().getUsed(), resized.total());
+
+        // A live cv::Mat pins the arena:
+        EXPECT_FALSE(frame.reset());
+        resized.release();
+        EXPECT_TRUE(frame.reset());
+
+        // Worker threads install the same frame:
+        std::thread worker([&]() {
+            drishti::core::FrameArena::Scope scope(&frame);
+            cv::Mat plane = drishti::core::arenaMat({ 16, 16 }, CV_8UC1);
+            EXPECT_EQ(frame.local().getLive(), 1);
+        });
+        worker.join();
+        EXPECT_EQ(frame.local().getLive(), 0);
+    }
+
+    // Heap fallback outside of a frame:
+    EXPECT_TRUE(drishti::core::FrameArena::current() == nullptr);
+    cv::Mat image = drishti::core::arenaMat({ 16, 16 }, CV_8UC1);
+    EXPECT_FALSE(image.empty());
+    EXPECT_TRUE(frame.reset());
+}
+
+TEST(MemoryRegistry, report) // NOLINT (TODO)
+{
+    using drishti::core::MemoryRegistry;
+    auto& registry = MemoryRegistry::get();
+    const auto before = registry.totals();
+
+    std::atomic<std::size_t> bytes{ 1024 };
+    {
+        auto texture = registry.add(MemoryRegistry::kTexture, "test", [&]() { return bytes.load(); });
+        auto model = registry.add(MemoryRegistry::kModel, "test", []() { return std::size_t(4096); });
+
+        // Probes are evaluated for each report:
+        bytes = 2048;
+        auto totals = registry.totals();
+        EXPECT_EQ(totals[MemoryRegistry::kTexture], before[MemoryRegistry::kTexture] + 2048);
+        EXPECT_EQ(totals[MemoryRegistry::kModel], before[MemoryRegistry::kModel] + 4096);
+
+        const auto items = registry.report();
+        auto iter = std::find_if(items.begin(), items.end(), [](const MemoryRegistry::Item& item) {
+            return (item.category == MemoryRegistry::kTexture) && (item.name == "test");
+        });
+        ASSERT_NE(iter, items.end());
+        EXPECT_EQ(iter->bytes, std::size_t(2048));
+
+        // Registrations are movable, the probe is removed once:
+        MemoryRegistry::Registration moved = std::move(texture);
+        texture.reset();
+        EXPECT_EQ(registry.totals()[MemoryRegistry::kTexture], before[MemoryRegistry::kTexture] + 2048);
+    }
+
+    EXPECT_EQ(registry.totals(), before);
+}
+
+TEST(SharedPool, recycle) // NOLINT (TODO)
+{
+    int allocations = 0;
+    drishti::core::SharedPool<std::vector<int>> pool([&]() {
+        allocations++;
+        return drishti::core::make_unique<std::vector<int>>(1024);
+    });
+
+    const std::vector<int>* address = nullptr;
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        address = a.get();
+        ASSERT_EQ(allocations, 2);
+    }
+    ASSERT_EQ(pool.available(), 2);
+
+    auto c = pool.acquire();
+    auto d = pool.acquire();
+    EXPECT_EQ(allocations, 2);
+    EXPECT_TRUE((c.get() == address) || (d.get() == address));
+
+    pool.clear();
+    c.reset(); // deleted, not recycled
+    EXPECT_EQ(pool.available(), 0);
+}
+
+TEST(LazyParallelResource, threads) // NOLINT (TODO)
+{
+    std::atomic<int> allocations{ 0 };
+    drishti::core::LazyParallelResource<std::thread::id, std::unique_ptr<int>> manager = [&]() {
+        return drishti::core::make_unique<int>(allocations++);
+    };
+
+    const int n = 4;
+    manager.reserve(n);
+    ASSERT_EQ(allocations, n);
+
+    std::vector<int*> values(n);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n; i++)
+    {
+        threads.emplace_back([&, i]() {
+            values[i] = manager[std::this_thread::get_id()].get();
+            for (int j = 0; j < 100; j++)
+            {
+                ASSERT_EQ(manager[std::this_thread::get_id()].get(), values[i]); // cached
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(allocations, n); // all served from the reserve
+    EXPECT_EQ(manager.getMap().size(), n);
+}
+
+TEST(ModelStream, container) // NOLINT (TODO)
+{
+    const std::string payload("\x01payload", 8);
+
+    { // bare stream: probed bytes are replayed
+        std::istringstream is(payload);
+        drishti::core::ModelStream stream(is);
+        EXPECT_FALSE(stream.hasContainer());
+        std::string result(payload.size(), ' ');
+        ASSERT_TRUE(stream.get().read(&result[0], payload.size()));
+        EXPECT_EQ(result, payload);
+    }
+
+    { // container header
+        drishti::core::ModelStream::Section section;
+        section.size = payload.size();
+
+        std::stringstream ss;
+        ASSERT_TRUE(drishti::core::ModelStream::writeHeader(ss, drishti::core::ModelStream::kCPR, { section }));
+        ss << payload;
+
+        drishti::core::ModelStream stream(ss);
+        ASSERT_TRUE(stream.hasContainer());
+        EXPECT_EQ(stream.getType(), drishti::core::ModelStream::kCPR);
+        ASSERT_EQ(stream.getSections().size(), 1);
+        EXPECT_EQ(stream.getSections().front().size, payload.size());
+        std::string result(payload.size(), ' ');
+        ASSERT_TRUE(stream.get().read(&result[0], payload.size()));
+        EXPECT_EQ(result, payload);
+    }
+}
+
+TEST(FlatArchive, view) // NOLINT (TODO)
+{
+    const std::vector<float> values = { 1.f, 2.f, 3.f };
+    drishti::core::FlatArchiveWriter writer;
+    writer.add("values", values);
+
+    std::stringstream ss;
+    ASSERT_TRUE(writer.write(ss));
+    const std::string bytes = ss.str();
+
+    // Aligned memory is used in place, and the owner is retained by the archive:
+    const std::size_t alignment = drishti::core::FlatArchive::kAlignment;
+    auto storage = std::make_shared<std::vector<char>>(bytes.size() + 2 * alignment);
+    const auto address = reinterpret_cast<std::uintptr_t>(storage->data());
+    char* aligned = storage->data() + ((alignment - (address % alignment)) % alignment);
+    std::copy(bytes.begin(), bytes.end(), aligned);
+
+    std::size_t count = 0;
+    auto archive = drishti::core::FlatArchive::view(aligned, bytes.size(), storage);
+    ASSERT_NE(archive, nullptr);
+    EXPECT_EQ(storage.use_count(), 2);
+    const float* data = archive->get<float>("values", count);
+    ASSERT_EQ(count, values.size());
+    EXPECT_GE(reinterpret_cast<const char*>(data), aligned);
+    EXPECT_LT(reinterpret_cast<const char*>(data), aligned + bytes.size());
+
+    // Unaligned memory is copied:
+    std::copy(bytes.begin(), bytes.end(), aligned + 1);
+    auto copy = drishti::core::FlatArchive::view(aligned + 1, bytes.size());
+    ASSERT_NE(copy, nullptr);
+    data = copy->get<float>("values", count);
+    ASSERT_EQ(count, values.size());
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(data) % alignment, 0);
+    EXPECT_TRUE(std::equal(values.begin(), values.end(), data));
+
+    std::istringstream is(bytes);
+    auto stream = drishti::core::FlatArchive::read(is);
+    ASSERT_NE(stream, nullptr);
+    data = stream->get<float>("values", count);
+    ASSERT_EQ(count, values.size());
+    EXPECT_TRUE(std::equal(values.begin(), values.end(), data));
+
+    EXPECT_EQ(drishti::core::FlatArchive::view(bytes.data(), 8), nullptr);
+}
+
+TEST(ModelBundle, entries) // NOLINT (TODO)
+{
+    EXPECT_EQ(drishti::core::ModelBundle::crc32("123456789", 9), 0xcbf43926);
+
+    const std::string detector(1000, 'd'), regressor = "model-payload";
+    drishti::core::ModelBundleWriter writer;
+    writer.add("face_detector", detector.data(), detector.size(), drishti::core::ModelBundle::kLZ4);
+    writer.add("face_landmark_regressor", regressor.data(), regressor.size());
+
+    std::stringstream ss;
+    ASSERT_TRUE(writer.write(ss));
+    const std::string bytes = ss.str();
+
+    std::istringstream is(bytes);
+    auto bundle = drishti::core::ModelBundle::read(is);
+    ASSERT_NE(bundle, nullptr);
+    ASSERT_EQ(bundle->getEntries().size(), 2);
+    EXPECT_FALSE(bundle->has("eye_model_regressor"));
+    EXPECT_EQ(bundle->open("eye_model_regressor"), nullptr);
+
+    // Entries are seekable and keep the bundle alive:
+    auto stream = bundle->open("face_detector");
+    ASSERT_NE(stream, nullptr);
+    bundle.reset();
+    const std::string contents{ std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>() };
+    EXPECT_EQ(contents, detector);
+    stream->clear();
+    stream->seekg(0, std::ios::beg);
+    EXPECT_EQ(stream->tellg(), std::streampos(0));
+
+    // Corrupt entries fail the checksum:
+    std::string corrupt = bytes;
+    corrupt[corrupt.find(regressor)] = 'R';
+    std::istringstream cs(corrupt);
+    auto damaged = drishti::core::ModelBundle::read(cs);
+    ASSERT_NE(damaged, nullptr);
+    EXPECT_EQ(damaged->open("face_landmark_regressor"), nullptr);
+
+    // Flat archives without an index aren't bundles:
+    drishti::core::FlatArchiveWriter archive;
+    archive.add("values", std::vector<float>{ 1.f });
+    std::stringstream as;
+    ASSERT_TRUE(archive.write(as));
+    EXPECT_EQ(drishti::core::ModelBundle::read(as), nullptr);
+}
+
+TEST(AppendSink, lines) // NOLINT (TODO)
+{
+    const std::string filename = "AppendSink.txt";
+    const int threads = 4, count = 1000;
+
+    {
+        drishti::core::AppendSink sink(filename);
+        ASSERT_TRUE(sink.good());
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; t++)
+        {
+            producers.emplace_back([&, t]() {
+                for (int i = 0; i < count; i++)
+                {
+                    sink.push(std::to_string(t * count + i));
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        EXPECT_EQ(sink.close(), std::size_t(threads * count));
+    }
+
+    // Every line is written once, in push order per producer:
+    std::vector<int> last(threads, -1);
+    std::ifstream is(filename);
+    std::string line;
+    int lines = 0;
+    while (std::getline(is, line))
+    {
+        const int value = std::stoi(line), t = value / count;
+        ASSERT_LT(t, threads);
+        EXPECT_GT(value % count, last[t]);
+        last[t] = value % count;
+        lines++;
+    }
+    EXPECT_EQ(lines, threads * count);
+
+    std::remove(filename.c_str());
+}
+
+TEST(AppendSink, resume) // NOLINT (TODO)
+{
+    const std::string filename = "AppendSinkResume.txt", merged = "AppendSinkMerged.txt";
+
+    {
+        drishti::core::AppendSink sink(filename);
+        sink.push("a");
+        sink.mark("a");
+        sink.push("b");
+        sink.mark("b");
+        EXPECT_EQ(sink.close(), std::size_t(2));
+    }
+
+    // An interrupted run leaves a torn line and a torn mark:
+    {
+        std::ofstream(filename, std::ios::app) << "c-torn";
+        std::ofstream(filename + ".done", std::ios::app) << "c";
+    }
+
+    std::size_t count = 0;
+    EXPECT_EQ(drishti::core::AppendSink::getValidSize(filename, drishti::core::AppendSink::kLines, &count), std::size_t(4));
+    EXPECT_EQ(count, std::size_t(2));
+
+    {
+        drishti::core::AppendSink sink(filename, drishti::core::AppendSink::kLines, true);
+        ASSERT_TRUE(sink.good());
+        sink.push("c");
+        sink.mark("c");
+        sink.close();
+    }
+
+    std::ifstream is(filename);
+    const std::string text((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(text, "a\nb\nc\n");
+
+    std::ifstream ms(filename + ".done");
+    const std::string marks((std::istreambuf_iterator<char>(ms)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(marks, "a\nb\nc\n");
+
+    EXPECT_EQ(drishti::core::AppendSink::merge({ filename, filename }, merged), std::size_t(6));
+
+    std::remove(filename.c_str());
+    std::remove((filename + ".done").c_str());
+    std::remove(merged.c_str());
+}
+
+TEST(AppendSink, tar) // NOLINT (TODO)
+{
+    const std::string filename = "AppendSink.tar";
+
+    for (const bool append : { false, true })
+    {
+        drishti::core::AppendSink sink(filename, drishti::core::AppendSink::kTar, append);
+        sink.push("image.png", std::string(700, 'x'));
+        sink.close();
+    }
+
+    // The end of archive marker of the first run is replaced by the second entry:
+    std::size_t count = 0;
+    EXPECT_EQ(drishti::core::AppendSink::getValidSize(filename, drishti::core::AppendSink::kTar, &count), std::size_t(2 * 3 * 512));
+    EXPECT_EQ(count, std::size_t(2));
+
+    std::ifstream is(filename, std::ios::binary | std::ios::ate);
+    EXPECT_EQ(static_cast<std::size_t>(is.tellg()), std::size_t(2 * 3 * 512 + 2 * 512));
+
+    std::remove(filename.c_str());
+}
+
+TEST(ParallelFor, stealing) // NOLINT (TODO)
+{
+    const int count = 1000;
+
+    // Uneven cost, all slow indices are in the first worker's block:
+    std::vector<std::atomic<int>> hits(count);
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        if (i < count / 8)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        hits[i]++;
+    };
+
+    int last = 0;
+    drishti::core::ParallelSettings settings;
+    settings.threads = 4;
+    settings.grain = 3;
+    settings.progress = [&](int done, int total) {
+        EXPECT_GT(done, last);
+        EXPECT_EQ(total, count);
+        last = done;
+    };
+    drishti::core::parallelFor({ 0, count }, harness, settings);
+
+    EXPECT_EQ(last, count);
+    for (const auto& hit : hits)
+    {
+        EXPECT_EQ(hit, 1);
+    }
+}
+
+TEST(TaskGraph, dependencies) // NOLINT (TODO)
+{
+    const int faces = 4;
+
+    // Landmarks -> eye crops -> one serialized chain per eye regressor:
+    drishti::core::TaskGraph graph;
+    for (int frame = 0; frame < 16; frame++)
+    {
+        std::atomic<int> clock{ 0 };
+        std::vector<int> stamps(faces * 4, -1);
+        std::array<int, 2> last{ { -1, -1 } };
+
+        graph.clear(); // reused across frames
+        for (int i = 0; i < faces; i++)
+        {
+            const int landmarks = graph.add([&, i]() { stamps[i * 4 + 0] = clock++; }, 2.f);
+            const int crops = graph.add([&, i]() { stamps[i * 4 + 1] = clock++; }, 0.1f);
+            graph.precede(landmarks, crops);
+            for (int lane = 0; lane < 2; lane++)
+            {
+                const int eye = graph.add([&, i, lane]() { stamps[i * 4 + 2 + lane] = clock++; }, 1.f);
+                graph.precede(crops, eye);
+                if (last[lane] >= 0)
+                {
+                    graph.precede(last[lane], eye);
+                }
+                last[lane] = eye;
+            }
+        }
+        graph.run(nullptr, (frame % 4) + 1);
+
+        EXPECT_EQ(clock, faces * 4);
+        for (int i = 0; i < faces; i++)
+        {
+            EXPECT_LT(stamps[i * 4 + 0], stamps[i * 4 + 1]);
+            EXPECT_LT(stamps[i * 4 + 1], stamps[i * 4 + 2]);
+            EXPECT_LT(stamps[i * 4 + 1], stamps[i * 4 + 3]);
+            if (i > 0)
+            {
+                EXPECT_LT(stamps[(i - 1) * 4 + 2], stamps[i * 4 + 2]);
+                EXPECT_LT(stamps[(i - 1) * 4 + 3], stamps[i * 4 + 3]);
+            }
+        }
+
+        // The first landmark task heads the longest chain:
+        EXPECT_GT(graph.getPriority(0), graph.getPriority(4));
+    }
+
+    // The first exception is rethrown and dependent tasks are skipped:
+    graph.clear();
+    bool skipped = true;
+    const int a = graph.add([]() { throw std::runtime_error("task"); });
+    const int b = graph.add([&]() { skipped = false; });
+    graph.precede(a, b);
+    EXPECT_THROW(graph.run(nullptr, 2), std::runtime_error);
+    EXPECT_TRUE(skipped);
+
+    graph.precede(b, a);
+    EXPECT_THROW(graph.run(), std::logic_error);
+}
+
+TEST(SplineBasis, interpolation) // NOLINT (TODO)
+{
+    // The uniform spline interpolates the control points at multiples of the upsampling factor:
+    const int n = 16, factor = 4;
+    std::vector<cv::Point2f> controlPoints(n);
+    for (int i = 0; i < n; i++)
+    {
+        const float theta = float(i) * 2.f * float(CV_PI) / float(n);
+        controlPoints[i] = cv::Point2f(std::cos(theta) * 40.f + 50.f, std::sin(theta) * 20.f + 50.f);
+    }
+
+    for (bool closed : { true, false })
+    {
+        const int count = closed ? (n * factor) : ((n - 1) * factor + 1);
+        std::vector<cv::Point2f> spline;
+        drishti::core::fitSplineUniform(controlPoints, spline, count, closed);
+        ASSERT_EQ(spline.size(), std::size_t(count));
+        for (int i = 0; i < n; i++)
+        {
+            EXPECT_LT(cv::norm(spline[i * factor] - controlPoints[i]), 1e-3);
+        }
+
+        // Cached (same basis instance) and partition of unity:
+        const cv::Mat1f& basis = drishti::core::getSplineBasis(n, count, closed);
+        EXPECT_EQ(&basis, &drishti::core::getSplineBasis(n, count, closed));
+        for (int i = 0; i < count; i++)
+        {
+            EXPECT_NEAR(cv::sum(basis.row(i))[0], 1.0, 1e-4);
+        }
+    }
+}
+
 END_EMPTY_NAMESPACE
+
+TEST(Padding, cropWithPadding) // NOLINT (TODO)
+{
+    cv::Mat1b image(32, 32);
+    cv::randu(image, 1, 255);
+
+    // Interior crops are shallow copies:
+    cv::Mat crop;
+    drishti::core::cropWithPadding(image, { 4, 4, 8, 8 }, crop, drishti::core::kPadReplicate);
+    EXPECT_EQ(crop.data, image(cv::Rect(4, 4, 8, 8)).data);
+
+    // Clipped crops preserve the requested size and geometry:
+    const cv::Rect roi(-4, 28, 8, 8);
+    for (auto mode : { drishti::core::kPadConstant, drishti::core::kPadReplicate, drishti::core::kPadReflect, drishti::core::kPadMean })
+    {
+        drishti::core::cropWithPadding(image, roi, crop, mode);
+        ASSERT_EQ(crop.size(), roi.size());
+        ASSERT_EQ(crop.type(), image.type());
+        EXPECT_EQ(cv::countNonZero(crop(cv::Rect(4, 0, 4, 4)) != image(cv::Rect(0, 28, 4, 4))), 0);
+    }
+
+    drishti::core::cropWithPadding(image, roi, crop, drishti::core::kPadReplicate);
+    EXPECT_EQ(crop.at<uchar>(7, 0), image(31, 0)); // bottom left corner
+    EXPECT_EQ(crop.at<uchar>(0, 0), image(28, 0));
+
+    drishti::core::cropWithPadding(image, roi, crop, drishti::core::kPadConstant);
+    EXPECT_EQ(crop.at<uchar>(7, 0), 0);
+}
+
+TEST(FixedAssignment, warmStart) // NOLINT (TODO)
+{
+    // Flat float costs: each row has a distinct minimum on the diagonal
+    const int n = 6;
+    std::vector<float> C(n * n);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            C[i * n + j] = (i == j) ? 0.f : float(1 + ((i + j) % 3));
+        }
+    }
+
+    drishti::core::FixedAssignment<float, 8> assignment;
+    ASSERT_TRUE(assignment.assign(C.data(), n, n));
+
+    int direct[8], prior[8];
+    ASSERT_EQ(assignment.solve(direct), n);
+    EXPECT_EQ(assignment.getAugmentations(), n);
+
+    // The previous matching is still optimal, so no augmenting paths are needed:
+    std::copy(direct, direct + n, prior);
+    ASSERT_EQ(assignment.solve(direct, prior), n);
+    EXPECT_EQ(assignment.getAugmentations(), 0);
+    for (int i = 0; i < n; i++)
+    {
+        EXPECT_EQ(direct[i], i);
+    }
+
+    // A stale prior (rows 0 and 1 swapped) is repaired:
+    std::swap(prior[0], prior[1]);
+    ASSERT_EQ(assignment.solve(direct, prior), n);
+    EXPECT_EQ(assignment.getAugmentations(), 2);
+    for (int i = 0; i < n; i++)
+    {
+        EXPECT_EQ(direct[i], i);
+    }
+
+    // Small problems (exhaustive search) resolve ties in favor of the prior:
+    drishti::core::FixedAssignment<float, 4> small;
+    const float ties[4] = { 1.f, 1.f, 1.f, 1.f };
+    ASSERT_TRUE(small.assign(ties, 2, 2));
+    const int swapped[2] = { 1, 0 };
+    ASSERT_EQ(small.solve(direct, swapped), 2);
+    EXPECT_EQ(direct[0], 1);
+    EXPECT_EQ(direct[1], 0);
+}
+
+TEST(BatchQueue, batching) // NOLINT (TODO)
+{
+    using Queue = drishti::core::BatchQueue<std::string, int, int>;
+
+    // Hold the batch thread in the first batch, so the next requests pile up:
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<std::size_t> sizes;
+
+    Queue::Settings settings;
+    settings.maxBatch = 4;
+    settings.maxDelay = std::chrono::milliseconds(10);
+    settings.maxPending = 6;
+    settings.threads = 2;
+
+    Queue queue(
+        [](std::string& request) {
+            if (request.empty())
+            {
+                throw std::runtime_error("empty request");
+            }
+            return std::stoi(request);
+        },
+        [&](std::vector<int>& items, std::vector<int>& results) {
+            released.wait();
+            sizes.push_back(items.size());
+            for (const auto& item : items)
+            {
+                results.push_back(item * 2);
+            }
+        },
+        settings);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 8; i++)
+    {
+        results.push_back(queue.push(std::to_string(i)));
+    }
+    auto failure = queue.push("");
+    release.set_value();
+
+    // Admission control: at most maxPending requests in flight:
+    int rejected = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        try
+        {
+            ASSERT_EQ(results[i].get(), i * 2);
+        }
+        catch (const Queue::Rejected&)
+        {
+            rejected++;
+        }
+    }
+    ASSERT_EQ(rejected, 2);
+    ASSERT_THROW(failure.get(), Queue::Rejected);
+
+    // A decoder exception fails only its own request:
+    auto error = queue.push("");
+    ASSERT_THROW(error.get(), std::runtime_error);
+    ASSERT_EQ(queue.push("21").get(), 42);
+
+    const auto stats = queue.getStats();
+    ASSERT_EQ(stats.admitted, 8);
+    ASSERT_EQ(stats.rejected, 3);
+    ASSERT_EQ(stats.failed, 1);
+    ASSERT_EQ(stats.items, 7);
+    ASSERT_EQ(queue.getPending(), 0);
+    for (const auto& size : sizes)
+    {
+        ASSERT_LE(size, settings.maxBatch);
+    }
+    ASSERT_GT(stats.getMeanBatchSize(), 1.0); // requests queued behind the first batch are grouped
+}
@@ -12,6 +12,8 @@
 #include <drishti/ContextImpl.h>
 #include <drishti/SensorImpl.h>
 
+#include <drishti/core/MemoryRegistry.h>
+
 #define DRISHTI_LOGGER_NAME "drishti"
 
 _DRISHTI_SDK_BEGIN
@@ -19,10 +21,23 @@ _DRISHTI_SDK_BEGIN
 Context::Impl::Impl(drishti::sdk::SensorModel& sensor)
     : sensor(sensor.getImpl()->sensor)
     , logger(drishti::core::Logger::create(DRISHTI_LOGGER_NAME))
-    , threads(std::make_shared<tp::ThreadPool<>>()) // thread-pool
 {
 }
 
+std::shared_ptr<tp::ThreadPool<>> Context::Impl::getThreads()
+{
+    if (!threads)
+    {
+        tp::ThreadPoolOptions options;
+        if (threadCount > 0)
+        {
+            options.setThreadCount(static_cast<std::size_t>(threadCount));
+        }
+        threads = std::make_shared<tp::ThreadPool<>>(options);
+    }
+    return threads;
+}
+
 Context::Context(drishti::sdk::SensorModel& sensor)
 {
     impl = drishti::core::make_unique<Impl>(sensor);
@@ -159,6 +174,53 @@ bool Context::getDoAnnotation() const
     return impl->doAnnotation;
 }
 
+std::shared_ptr<drishti::face::FaceDetectorFactory> Context::Impl::getFactory(const FactoryKey& key)
+{
+    std::lock_guard<std::mutex> lock(factoryMutex);
+    auto& entry = factories[key];
+    auto factory = entry.lock();
+    if (!factory)
+    {
+        auto stream = std::make_shared<drishti::face::FaceDetectorFactoryStream>();
+        stream->iFaceDetector = key[0];
+        stream->iFaceRegressor = key[1];
+        stream->iEyeRegressor = key[2];
+        stream->iFaceDetectorMean = key[3];
+        entry = factory = stream;
+    }
+    return factory;
+}
+
+void Context::setThreadCount(int count)
+{
+    impl->threadCount = count;
+}
+
+int Context::getThreadCount() const
+{
+    return impl->threadCount;
+}
+
+void Context::setPowerCallback(const PowerCallback& callback)
+{
+    impl->powerCallback = callback;
+}
+
+const Context::PowerCallback& Context::getPowerCallback() const
+{
+    return impl->powerCallback;
+}
+
+void Context::setOrientationCallback(const OrientationCallback& callback)
+{
+    impl->orientationCallback = callback;
+}
+
+const Context::OrientationCallback& Context::getOrientationCallback() const
+{
+    return impl->orientationCallback;
+}
+
 void Context::setGLContext(void *context)
 {
     impl->glContext = context;
@@ -169,4 +231,30 @@ void* Context::getGLContext() const
     return impl->glContext;
 }
 
+void Context::setShaderCache(const std::string& path)
+{
+    impl->shaderCache = path;
+}
+
+const std::string& Context::getShaderCache() const
+{
+    return impl->shaderCache;
+}
+
+std::vector<Context::MemoryUsage> Context::getMemoryReport() const
+{
+    using drishti::core::MemoryRegistry;
+
+    std::vector<MemoryUsage> report;
+    for (const auto& item : MemoryRegistry::get().report())
+    {
+        MemoryUsage usage;
+        usage.category = MemoryRegistry::getName(item.category);
+        usage.name = item.name;
+        usage.bytes = item.bytes;
+        report.push_back(usage);
+    }
+    return report;
+}
+
 _DRISHTI_SDK_END
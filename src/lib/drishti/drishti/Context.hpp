@@ -20,7 +20,11 @@
 #include <drishti/Image.hpp>
 #include <drishti/Sensor.hpp>
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 _DRISHTI_SDK_BEGIN
 
@@ -30,6 +34,27 @@ public:
 
     struct Impl;
 
+    // Platform thermal and battery state (e.g., ProcessInfo.thermalState, BatteryManager):
+    struct PowerState
+    {
+        float thermal = 0.f;  // 0 (nominal) ... 1 (critical)
+        float battery = 1.f;  // 0 (empty) ... 1 (full)
+        bool charging = true; // the battery level is ignored while charging
+    };
+
+    using PowerCallback = std::function<PowerState()>;
+
+    // Rotation in degrees (0, 90, 180 or 270) that makes camera frames upright:
+    using OrientationCallback = std::function<int()>;
+
+    // Memory reported by one owner (e.g., a model factory or a tracker's GPU pipeline):
+    struct MemoryUsage
+    {
+        std::string category; // "model", "texture", "pool" or "scratch"
+        std::string name;
+        std::size_t bytes = 0;
+    };
+
     explicit Context(drishti::sdk::SensorModel& sensor);
     ~Context();
 
@@ -78,9 +103,37 @@ public:
     void setDoAnnotation(bool flag);
     bool getDoAnnotation() const;
 
+    // Worker count for the thread pool shared by all trackers in this context (0 == number of cores).
+    // This must be set before the first FaceTracker is created.
+    void setThreadCount(int count);
+    int getThreadCount() const;
+
+    // Power mode: trackers adapt the detection interval, eye model rate and worker count to the
+    // reported state.  The callback is polled from a worker thread, so it must be thread safe and
+    // cheap.  This must be set before the first FaceTracker is created.
+    void setPowerCallback(const PowerCallback& callback);
+    const PowerCallback& getPowerCallback() const;
+
+    // Device orientation (e.g., from the platform rotation callback or gravity): trackers poll
+    // the callback once per frame on the submitting thread and detect in the upright frame
+    // without being recreated.  This must be set before the first FaceTracker is created.
+    void setOrientationCallback(const OrientationCallback& callback);
+    const OrientationCallback& getOrientationCallback() const;
+
     void setGLContext(void *context);
     void* getGLContext() const;
 
+    // Existing directory for shader program binaries (empty == none): trackers link programs
+    // from cached binaries, e.g., for a fast FaceTracker::resume() after the context was lost.
+    // This must be set before the first FaceTracker is created.
+    void setShaderCache(const std::string& path);
+    const std::string& getShaderCache() const;
+
+    // Current memory usage of all models and trackers in the process (e.g., for device tier
+    // decisions, or to log before an out of memory condition).  Texture sizes are updated once
+    // per frame, and serialized sizes are used for models.
+    std::vector<MemoryUsage> getMemoryReport() const;
+
 protected:
 
     std::unique_ptr<Impl> impl;
@@ -14,10 +14,15 @@
 #include <drishti/Context.hpp>
 
 #include <drishti/hci/FaceFinder.h>
+#include <drishti/face/FaceDetectorFactory.h>
 #include <drishti/core/make_unique.h>
 #include <drishti/core/Logger.h> // spdlog::logger
 #include <drishti/sensor/Sensor.h>
 
+#include <array>
+#include <map>
+#include <mutex>
+
 #include <thread_pool/thread_pool.hpp>
 
 #define DRISHTI_LOGGER_NAME "drishti"
@@ -32,6 +37,14 @@ struct Context::Impl
 {
     Impl(drishti::sdk::SensorModel& sensor);
 
+    // The pool is created on first use with threadCount workers and shared by all trackers:
+    std::shared_ptr<tp::ThreadPool<>> getThreads();
+
+    // Trackers created from the same model streams share one factory, so the (read only)
+    // regressor weights and mean face are loaded once per context instead of once per camera:
+    using FactoryKey = std::array<std::istream*, 4>; // { detector, face, eye, mean }
+    std::shared_ptr<drishti::face::FaceDetectorFactory> getFactory(const FactoryKey& key);
+
     bool doSingleFace = true;
     float minDetectionDistance = DEFAULT_MIN_DETECTION_DISTANCE;
     float maxDetectionDistance = DEFAULT_MAX_DETECTION_DISTANCE;
@@ -44,10 +57,16 @@ struct Context::Impl
     bool doOptimizedPipeline = false;
     bool doCpuAcf = false; // available only for non optimized pipeline
     bool doAnnotation = false;
+    int threadCount = 0; // 0 == std::thread::hardware_concurrency()
+    PowerCallback powerCallback;
+    OrientationCallback orientationCallback;
+    std::string shaderCache; // program binaries (see ogles_gpgpu::ProgramCache)
 
     std::shared_ptr<drishti::sensor::SensorModel> sensor;
     std::shared_ptr<spdlog::logger> logger;
     std::shared_ptr<tp::ThreadPool<>> threads;
+    std::map<FactoryKey, std::weak_ptr<drishti::face::FaceDetectorFactory>> factories;
+    std::mutex factoryMutex;
     void* glContext = nullptr;
 };
 
@@ -13,11 +13,13 @@
 #include <drishti/EyeDetector.hpp>
 #include <drishti/drishti_cv.hpp>
 #include <drishti/core/make_unique.h>
+#include <drishti/ml/AcfPyramidCache.h>
 
 #include <acf/ACF.h>
 
 #include <memory>
 #include <opencv2/core/core.hpp>
+#include <opencv2/imgproc.hpp>
 
 _DRISHTI_SDK_BEGIN
 
@@ -46,23 +48,109 @@ struct EyeDetector::Impl
         m_detector->acfModify(dflt);
     }
 
-    int operator()(const Image3b& image, std::vector<Rect>& objects)
+    int operator()(const Image3b& image, std::vector<Rect>& objects, std::int64_t frame)
     {
-        cv::Mat3b input = drishtiToCv<Vec3b, cv::Vec3b>(image);
         std::vector<cv::Rect> hits;
-        (*m_detector)(input, hits);
+        if (frame < 0)
+        {
+            cv::Mat3b input = drishtiToCv<Vec3b, cv::Vec3b>(image);
+            (*m_detector)(input, hits);
+        }
+        else
+        {
+            // Evaluate on the shared pyramid, mapping hits back to the input image:
+            const auto entry = getPyramid(image, frame);
+            auto P = *entry.P; // headers only
+            (*m_detector)(P, hits);
+            for (auto& hit : hits)
+            {
+                hit = scale(hit, 1.0f / entry.scale);
+            }
+        }
 
-        //std::cout << hits.size() << std::endl;
+        std::transform(hits.begin(), hits.end(), std::back_inserter(objects), cvToDrishti);
+
+        return objects.size();
+    }
+
+    int operator()(const Image3b& image, const std::vector<Rect>& faces, std::vector<Rect>& objects, std::int64_t frame)
+    {
+        const auto entry = getPyramid(image, frame);
+
+        std::vector<drishti::ml::AcfSearchRegion> regions;
+        for (const auto& face : faces)
+        {
+            drishti::ml::AcfSearchRegion region;
+            region.roi = scale({ face.x, face.y, face.width, face.height }, entry.scale);
+            region.minWidth = static_cast<float>(region.roi.width) * kMinEyeWidth;
+            region.maxWidth = static_cast<float>(region.roi.width) * kMaxEyeWidth;
+            region.maxLevels = kMaxEyeLevels;
+            regions.push_back(region);
+        }
+
+        std::vector<cv::Rect> hits;
+        std::vector<double> scores;
+        drishti::ml::detectAcfRegions(*m_detector, *entry.P, regions, hits, scores);
+        for (auto& hit : hits)
+        {
+            hit = scale(hit, 1.0f / entry.scale);
+        }
 
-        auto cvToDrishti = [](const cv::Rect& roi) {
-            return Rect(roi.x, roi.y, roi.width, roi.height);
-        };
         std::transform(hits.begin(), hits.end(), std::back_inserter(objects), cvToDrishti);
 
         return objects.size();
     }
 
+    drishti::ml::AcfPyramidCache::Entry getPyramid(const Image3b& image, std::int64_t frame)
+    {
+        auto compute = [&](acf::Detector::Pyramid& P) {
+            // RGB [0,1] in model storage order (see acf::Detector::computePyramid()):
+            cv::Mat3b input = drishtiToCv<Vec3b, cv::Vec3b>(image), It;
+            if (!m_detector->getIsRowMajor())
+            {
+                cv::transpose(input, It);
+            }
+            else
+            {
+                It = input;
+            }
+
+            cv::Mat3f Itf;
+            It.convertTo(Itf, CV_32FC3, 1.0 / 255.0);
+            m_detector->setIsLuv(false);
+            m_detector->computePyramid(MatP(Itf), P);
+            return 1.0f;
+        };
+
+        if (frame < 0)
+        {
+            auto P = std::make_shared<acf::Detector::Pyramid>();
+            drishti::ml::AcfPyramidCache::Entry entry;
+            entry.scale = compute(*P);
+            entry.P = P;
+            return entry;
+        }
+
+        return m_pyramids->acquire(drishti::ml::AcfPyramidCache::getKey(*m_detector, frame), compute);
+    }
+
+    static cv::Rect scale(const cv::Rect& roi, float s)
+    {
+        return { int(roi.x * s + 0.5f), int(roi.y * s + 0.5f), int(roi.width * s + 0.5f), int(roi.height * s + 0.5f) };
+    }
+
+    static Rect cvToDrishti(const cv::Rect& roi)
+    {
+        return Rect(roi.x, roi.y, roi.width, roi.height);
+    }
+
+    // Eye detection box widths relative to the face detection box width:
+    static constexpr float kMinEyeWidth = 0.2f;
+    static constexpr float kMaxEyeWidth = 0.5f;
+    static constexpr int kMaxEyeLevels = 4;
+
     std::unique_ptr<acf::Detector> m_detector;
+    std::unique_ptr<drishti::ml::AcfPyramidCache> m_pyramids = drishti::core::make_unique<drishti::ml::AcfPyramidCache>();
 };
 
 // ######### EyeDetector ############
@@ -73,9 +161,13 @@ EyeDetector::EyeDetector(const std::string& filename)
     m_impl = drishti::core::make_unique<Impl>(filename);
 }
 EyeDetector::~EyeDetector() = default;
-int EyeDetector::operator()(const Image3b& image, std::vector<Rect>& objects)
+int EyeDetector::operator()(const Image3b& image, std::vector<Rect>& objects, std::int64_t frame)
+{
+    return (*m_impl)(image, objects, frame);
+}
+int EyeDetector::operator()(const Image3b& image, const std::vector<Rect>& faces, std::vector<Rect>& objects, std::int64_t frame)
 {
-    return (*m_impl)(image, objects);
+    return (*m_impl)(image, faces, objects, frame);
 }
 
 _DRISHTI_SDK_END
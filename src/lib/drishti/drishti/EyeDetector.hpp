@@ -16,6 +16,7 @@
 #include <drishti/drishti_sdk.hpp>
 #include <drishti/Image.hpp>
 
+#include <cstdint> // int64_t
 #include <memory> // unique_ptr, shared_ptr
 #include <vector> // for eyelid contour
 
@@ -49,7 +50,12 @@ public:
     EyeDetector& operator=(const EyeDetector&) = delete;
     EyeDetector& operator=(EyeDetector&&) = delete;
 
-    int operator()(const Image3b& image, std::vector<Rect>& objects);
+    // Calls with the same (non negative) frame index share one ACF channel pyramid, e.g.,
+    // a full frame scan followed by a search inside face regions:
+    int operator()(const Image3b& image, std::vector<Rect>& objects, std::int64_t frame = -1);
+
+    // Search inside the face regions only, at the pyramid levels of plausible eye sizes:
+    int operator()(const Image3b& image, const std::vector<Rect>& faces, std::vector<Rect>& objects, std::int64_t frame = -1);
 
 protected:
     void init(const std::string& filename);
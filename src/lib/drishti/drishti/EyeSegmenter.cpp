@@ -80,6 +80,18 @@ int EyeSegmenter::operator()(const Image3b& image, Eye& eye, bool isRight)
     return status;
 }
 
+int EyeSegmenter::operator()(const std::vector<Crop>& crops, std::vector<Eye>& eyes, std::vector<int>& status, int threads)
+{
+    eyes.resize(crops.size());
+    status.resize(crops.size());
+    return (*this)(crops.data(), eyes.data(), status.data(), static_cast<int>(crops.size()), threads);
+}
+
+int EyeSegmenter::operator()(const Crop* crops, Eye* eyes, int* status, int count, int threads)
+{
+    return (*m_impl)(crops, eyes, status, count, threads);
+}
+
 Eye EyeSegmenter::getMeanEye(int width) const
 {
     return m_impl->getMeanEye(width);
@@ -174,4 +186,22 @@ int drishti_eye_segmenter_segment
 {
     return segmenter ? (*segmenter)(image, eye, isRight) : -1;
 }
+
+// clang-format off
+int drishti_eye_segmenter_segment_batch
+(
+    drishti::sdk::EyeSegmenter* segmenter,
+    const drishti::sdk::EyeSegmenter::Crop* crops,
+    drishti::sdk::Eye* eyes,
+    int* status,
+    int count,
+    int threads
+) // clang-format on
+{
+    if (!segmenter || ((count > 0) && (!crops || !eyes || !status)))
+    {
+        return -1;
+    }
+    return (*segmenter)(crops, eyes, status, count, threads);
+}
 DRISHTI_EXTERN_C_END
@@ -53,6 +53,32 @@ public:
     explicit operator bool() const;
 
     int operator()(const Image3b& image, Eye& eye, bool isRight);
+
+    // Batch input: an eye image (or a region of a larger image) and its handedness:
+    struct Crop
+    {
+        Crop()
+            : isRight(true)
+        {
+        }
+
+        Crop(const Image3b& image, const Recti& roi, bool isRight)
+            : image(image)
+            , roi(roi)
+            , isRight(isRight)
+        {
+        }
+
+        Image3b image;
+        Recti roi; // optional region of image (empty == full image)
+        bool isRight;
+    };
+
+    // Segment all crops on up to threads workers (<= 0 == all cores) with one status per crop, and
+    // returns the number of failures.  Models are in image coordinates with the roi set to the crop:
+    int operator()(const std::vector<Crop>& crops, std::vector<Eye>& eyes, std::vector<int>& status, int threads = -1);
+    int operator()(const Crop* crops, Eye* eyes, int* status, int count, int threads = -1);
+
     Eye getMeanEye(int width) const;
 
     void setEyelidInits(int count);
@@ -99,6 +125,17 @@ drishti_eye_segmenter_segment
     drishti::sdk::Eye& eye,
     bool isRight
 );
+
+DRISHTI_EXPORT int
+drishti_eye_segmenter_segment_batch
+(
+    drishti::sdk::EyeSegmenter* segmenter,
+    const drishti::sdk::EyeSegmenter::Crop* crops,
+    drishti::sdk::Eye* eyes,
+    int* status,
+    int count,
+    int threads
+);
 // clang-format on
 
 DRISHTI_EXTERN_C_END
@@ -15,6 +15,8 @@
 #include <drishti/eye/Eye.h> // internal sdk eye model
 #include <drishti/eye/EyeModelEstimator.h>
 #include <drishti/core/Logger.h>
+#include <drishti/core/Parallel.h>
+#include <drishti/core/ThreadPool.h>
 #include <drishti/core/make_unique.h>
 
 // OpenCV inlucdes must come before drishti_cv.hpp
@@ -22,6 +24,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <drishti/drishti_cv.hpp> // Must come after opencvx
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -81,30 +84,91 @@ int EyeSegmenter::Impl::operator()(const Image3b& image, Eye& eye, bool isRight)
 
     //const float aspectRatio  = float(image.cols) / image.rows;
 
-    try
-    {
-        // Create shallow copy of input image
-        cv::Mat3b I = drishtiToCv<Vec3b, cv::Vec3b>(image), If;
+    // Create shallow copy of input image
+    cv::Mat3b I = drishtiToCv<Vec3b, cv::Vec3b>(image);
+    status = segment(*m_eme, I, { { 0, 0 }, I.size() }, isRight, eye);
 
-        // If input is left eye, we flop and must allocate a new image:
-        if (!isRight)
-        {
-            cv::flip(I, If, 1);
-        }
-        else
+    core::Logger::increment();
+
+    return status;
+}
+
+int EyeSegmenter::Impl::operator()(const Crop* crops, Eye* eyes, int* status, int count, int threads)
+{
+    const int minWidth = getMinWidth();
+    const auto minHeight = int(float(getMinWidth()) / getRequiredAspectRatio() + 0.5f);
+
+    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
+        const auto& crop = crops[i];
+
+        // Shallow copy of the input image and the (clipped) region:
+        const cv::Mat3b I = drishtiToCv<Vec3b, cv::Vec3b>(crop.image);
+        const cv::Rect bounds({ 0, 0 }, I.size());
+        const cv::Rect roi = (crop.roi.width > 0 && crop.roi.height > 0) ? (drishtiToCv(crop.roi) & bounds) : bounds;
+
+        if (roi.width < minWidth || roi.height < minHeight)
         {
-            If = I;
+            status[i] = 1;
+            eyes[i] = {};
+            return;
         }
 
-        DRISHTI_EYE::EyeModel model;
-        status = (*m_eme)(If, model);
+        auto& workspace = getWorkspace();
+        status[i] = segment(workspace.eme ? *workspace.eme : *m_eme, I, roi, crop.isRight, eyes[i]);
+    };
 
-        if (!isRight)
+    if (!getWorkspace().eme)
+    {
+        harness({ 0, count }); // regressors can't be shared, so m_eme is used sequentially
+    }
+    else
+    {
+        // Per eye cost varies (e.g., closed eyes skip the iris), so claim one crop at a time:
+        drishti::core::ParallelSettings settings;
+        settings.threads = threads;
+        settings.grain = 1;
+        drishti::core::parallelFor({ 0, count }, harness, settings);
+    }
+
+    core::Logger::increment();
+
+    return static_cast<int>(std::count_if(status, status + count, [](int code) { return code != 0; }));
+}
+
+EyeSegmenter::Impl::Workspace& EyeSegmenter::Impl::getWorkspace()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_workspaces.find(std::this_thread::get_id());
+    if (iter == m_workspaces.end())
+    {
+        Workspace workspace;
+        workspace.eme = m_eme->clone();
+        iter = m_workspaces.emplace(std::this_thread::get_id(), std::move(workspace)).first;
+    }
+    return iter->second;
+}
+
+void EyeSegmenter::Impl::clearWorkspaces()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workspaces.clear(); // clones copy the settings
+}
+
+int EyeSegmenter::Impl::segment(const eye::EyeModelEstimator& eme, const cv::Mat3b& image, const cv::Rect& roi, bool isRight, Eye& eye) const
+{
+    int status = 0;
+
+    try
+    {
+        // Left eyes are sampled in place at mirrored coordinates (no flipped copy):
+        DRISHTI_EYE::EyeModel model;
+        status = eme(image(roi), model, !isRight);
+        model.refine();
+        if (roi.x || roi.y)
         {
-            model.flop(If.cols);
+            model += cv::Point2f(roi.tl()); // shift features to image coordinate system
         }
-        model.refine();
-        model.roi = cv::Rect({ 0, 0 }, If.size()); // default roi
+        model.roi = roi; // default roi
         eye = convert(model);
     }
     catch (...)
@@ -113,8 +177,6 @@ int EyeSegmenter::Impl::operator()(const Image3b& image, Eye& eye, bool isRight)
         status = 1;
     }
 
-    core::Logger::increment();
-
     return status;
 }
 
@@ -136,6 +198,7 @@ int EyeSegmenter::Impl::getIrisInits() const
 void EyeSegmenter::Impl::setIrisInits(int count)
 {
     m_eme->setIrisInits(count); // not reentrant when > 1
+    clearWorkspaces();
 }
 
 int EyeSegmenter::Impl::getEyelidInits() const
@@ -146,11 +209,13 @@ int EyeSegmenter::Impl::getEyelidInits() const
 void EyeSegmenter::Impl::setEyelidInits(int count)
 {
     m_eme->setEyelidInits(count); // not reentrant when > 1
+    clearWorkspaces();
 }
 
 void EyeSegmenter::Impl::setOptimizationLevel(int level)
 {
     m_eme->setOptimizationLevel(level);
+    clearWorkspaces();
 }
 
 // Static utility:
@@ -172,6 +237,7 @@ static std::string kindToHint(ArchiveKind kind)
     switch (kind)
     {
         case kCPB:
+        case kAuto: // format is detected from the stream
             return "hint.cpb";
         default:
             assert(0 && "Archive is not supported");
@@ -18,7 +18,13 @@
 #include <drishti/core/Logger.h>
 
 #include <drishti/eye/Eye.h>
-#include <drishti/drishti_cv.hpp>
+
+#include <opencv2/core/core.hpp>
+#include <drishti/drishti_cv.hpp> // Must come after opencv
+
+#include <map>
+#include <mutex>
+#include <thread>
 
 // clang-format off
 namespace drishti { namespace eye { class EyeModelEstimator; } };
@@ -40,6 +46,7 @@ public:
     Impl& operator=(Impl&&) = delete;
 
     int operator()(const Image3b& image, Eye& eye, bool isRight);
+    int operator()(const Crop* crops, Eye* eyes, int* status, int count, int threads);
 
     Eye getMeanEye(int width) const;
 
@@ -56,10 +63,22 @@ public:
     void setOptimizationLevel(int level);
 
 protected:
+    // Per thread estimator (sharing the regressors) for batch calls:
+    struct Workspace
+    {
+        std::unique_ptr<eye::EyeModelEstimator> eme;
+    };
+
     void init(std::istream& is, ArchiveKind);
+    Workspace& getWorkspace();
+    void clearWorkspaces();
+    int segment(const eye::EyeModelEstimator& eme, const cv::Mat3b& image, const cv::Rect& roi, bool isRight, Eye& eye) const;
 
     std::unique_ptr<eye::EyeModelEstimator> m_eme;
 
+    std::mutex m_mutex;                                // workspace allocation
+    std::map<std::thread::id, Workspace> m_workspaces; // cleared when the settings change
+
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
 
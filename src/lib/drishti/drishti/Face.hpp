@@ -48,6 +48,12 @@ struct DRISHTI_EXPORT Face
      * Estimated 3D position for point between the eyes.
      */
     drishti::sdk::Vec3f position{};
+
+    /**
+     * Unit gaze vectors for the subject's right and left eyes in camera coordinates
+     * (x right, y down, -z towards the camera), empty if gaze was not estimated.
+     */
+    drishti::sdk::Array<drishti::sdk::Vec3f, 2> gaze;
 };
 
 _DRISHTI_SDK_END
@@ -13,35 +13,81 @@
 
 #include <drishti/drishti_sdk.hpp>
 #include <drishti/drishti_cv.hpp>
+#include <drishti/FaceTracker.hpp>
 #include <drishti/EyeSegmenterImpl.hpp>
 
 #include <drishti/face/Face.h>
 #include <drishti/hci/FaceFinder.h>
+#include <drishti/core/SharedPool.h>
+#include <drishti/core/make_unique.h>
+
+#include <algorithm>
+#include <cstring>
 
 _DRISHTI_SDK_BEGIN
 
+// Convert the requested fields only (see drishti_face_field_t), the eyelid and crease splines dominate:
+inline void convert(const drishti::eye::EyeModel& model, std::uint32_t fields, drishti::sdk::Eye& e)
+{
+    if (fields & DRISHTI_FIELD_IRIS)
+    {
+        e.setIris(cvToDrishti(model.irisEllipse));
+    }
+    if (fields & DRISHTI_FIELD_PUPIL)
+    {
+        e.setPupil(cvToDrishti(model.pupilEllipse));
+    }
+    if (fields & DRISHTI_FIELD_CORNERS)
+    {
+        e.setCorners(cvToDrishti(model.getInnerCorner()), cvToDrishti(model.getOuterCorner()));
+    }
+    if (fields & DRISHTI_FIELD_EYE_ROI)
+    {
+        e.setRoi(cvToDrishti(model.roi.has ? *model.roi : cv::Rect()));
+    }
+    if (fields & DRISHTI_FIELD_EYELIDS)
+    {
+        e.setEyelids(drishti::sdk::cvToDrishti(model.eyelidsSpline));
+    }
+    if (fields & DRISHTI_FIELD_CREASE)
+    {
+        e.setCrease(drishti::sdk::cvToDrishti(model.creaseSpline));
+    }
+}
+
+static const std::uint32_t kEyeFields = DRISHTI_FIELD_IRIS | DRISHTI_FIELD_PUPIL | DRISHTI_FIELD_CORNERS | DRISHTI_FIELD_EYE_ROI | DRISHTI_FIELD_EYELIDS | DRISHTI_FIELD_CREASE;
+
 // Maintain lightweight inline conversions in private header for internal use
-inline drishti::sdk::Face convert(const drishti::face::FaceModel& model)
+inline drishti::sdk::Face convert(const drishti::face::FaceModel& model, std::uint32_t fields = DRISHTI_FIELD_ALL)
 {
     drishti::sdk::Face f;
 
-    if (model.eyeFullR.has && model.eyeFullL.has)
+    if (model.eyeFullR.has && model.eyeFullL.has && (fields & kEyeFields))
     {
         f.eyes.resize(2);
-        f.eyes[0] = drishti::sdk::convert(*model.eyeFullR);
-        f.eyes[1] = drishti::sdk::convert(*model.eyeFullL);
+        convert(*model.eyeFullR, fields, f.eyes[0]);
+        convert(*model.eyeFullL, fields, f.eyes[1]);
     }
 
-    if (model.points.has)
+    if (model.points.has && (fields & DRISHTI_FIELD_LANDMARKS))
     {
         f.landmarks = drishti::sdk::cvToDrishti(*model.points);
     }
 
-    if (model.eyesCenter.has)
+    if (model.eyesCenter.has && (fields & DRISHTI_FIELD_POSITION))
     {
         f.position = drishti::sdk::cvToDrishti(*model.eyesCenter);
     }
 
+    if (model.gaze.has && (fields & DRISHTI_FIELD_GAZE))
+    {
+        f.gaze.resize(2);
+        for (int i = 0; i < 2; i++)
+        {
+            f.gaze[i] = drishti::sdk::cvToDrishti(cv::Point3f(model.gaze->at(i)));
+        }
+    }
+
     return f;
 }
 
@@ -56,10 +102,105 @@ inline drishti::face::FaceModel convert(const drishti::sdk::Face& model)
     return f;
 }
 
+// Fill the flat (POD) result layout directly from the internal models:
+inline void convert(const cv::Rect& roi, float* dst)
+{
+    dst[0] = static_cast<float>(roi.x);
+    dst[1] = static_cast<float>(roi.y);
+    dst[2] = static_cast<float>(roi.width);
+    dst[3] = static_cast<float>(roi.height);
+}
+
+inline void convert(const drishti::eye::EyeModel& model, drishti_flat_eye_t& eye)
+{
+    const auto ellipse = [](const cv::RotatedRect& e, float* dst) {
+        dst[0] = e.center.x;
+        dst[1] = e.center.y;
+        dst[2] = e.size.width;
+        dst[3] = e.size.height;
+        dst[4] = e.angle;
+    };
+    const auto points = [](const std::vector<cv::Point2f>& src, float* dst, std::size_t limit) {
+        const std::size_t n = std::min(src.size(), limit);
+        std::memcpy(dst, src.data(), n * sizeof(cv::Point2f)); // interleaved (x, y)
+        return static_cast<uint32_t>(n);
+    };
+
+    const cv::Rect roi = model.roi.has ? *model.roi : cv::Rect();
+    const cv::Point2f inner = model.getInnerCorner(), outer = model.getOuterCorner();
+
+    convert(roi, eye.roi);
+    ellipse(model.irisEllipse, eye.iris);
+    ellipse(model.pupilEllipse, eye.pupil);
+    eye.innerCorner[0] = inner.x, eye.innerCorner[1] = inner.y;
+    eye.outerCorner[0] = outer.x, eye.outerCorner[1] = outer.y;
+    eye.eyelidCount = points(model.eyelidsSpline, eye.eyelids, DRISHTI_FLAT_MAX_EYELIDS);
+    eye.creaseCount = points(model.creaseSpline, eye.crease, DRISHTI_FLAT_MAX_CREASE);
+}
+
+inline void convert(const std::vector<drishti::face::FaceModel>& models, double time, drishti_flat_result_t& result)
+{
+    result.version = DRISHTI_FLAT_RESULT_VERSION;
+    result.size = sizeof(drishti_flat_result_t);
+    result.time = time;
+    result.faceCount = static_cast<uint32_t>(std::min(models.size(), std::size_t(DRISHTI_FLAT_MAX_FACES)));
+
+    for (uint32_t i = 0; i < result.faceCount; i++)
+    {
+        const auto& model = models[i];
+        auto& face = result.faces[i];
+
+        const cv::Rect roi = model.roi.has ? *model.roi : cv::Rect();
+        convert(roi, face.roi);
+        face.flags = 0;
+
+        if (model.eyeFullR.has && model.eyeFullL.has)
+        {
+            face.flags |= DRISHTI_FLAT_HAS_EYES;
+            convert(*model.eyeFullR, face.eyes[0]);
+            convert(*model.eyeFullL, face.eyes[1]);
+        }
+
+        if (model.eyesCenter.has)
+        {
+            face.flags |= DRISHTI_FLAT_HAS_POSITION;
+            face.position[0] = model.eyesCenter->x;
+            face.position[1] = model.eyesCenter->y;
+            face.position[2] = model.eyesCenter->z;
+        }
+
+        if (model.gaze.has)
+        {
+            face.flags |= DRISHTI_FLAT_HAS_GAZE;
+            for (int j = 0; j < 2; j++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    face.gaze[j][k] = model.gaze->at(j)[k];
+                }
+            }
+        }
+
+        face.landmarkCount = 0;
+        if (model.points.has)
+        {
+            const auto& landmarks = *model.points;
+            face.landmarkCount = static_cast<uint32_t>(std::min(landmarks.size(), std::size_t(DRISHTI_FLAT_MAX_LANDMARKS)));
+            std::memcpy(face.landmarks, landmarks.data(), face.landmarkCount * sizeof(cv::Point2f));
+        }
+    }
+}
+
 /**
  * FaceMonitorAdapter
  *
  * Provides an interface for converting drishti::hc::FaceMonitor output to the public extern "C" API
+ *
+ * The results passed to the user callback live in a pooled buffer that also holds references
+ * to the frame images, so the SDK images alias that memory without a copy.  A client can keep the
+ * results beyond the callback with retain(), and the buffer is recycled after the last release().
+ * Each SDK image also shares ownership of its pixels (see cvToDrishtiShared()), so a copy of an
+ * image stays valid after the results are released.
  */
 
 struct FaceMonitorAdapter : public drishti::hci::FaceMonitor
@@ -70,9 +211,10 @@ public:
     using Faces = std::vector<drishti::face::FaceModel>;
 
     explicit FaceMonitorAdapter(drishti_face_tracker_t& table, int n = std::numeric_limits<int>::max())
-        : m_start(HighResolutionClock::now())
-        , m_table(table)
+        : m_table(table)
         , m_n(n)
+        , m_pool([]() { return drishti::core::make_unique<Result>(); })
+        , m_flat(drishti::core::make_unique<drishti_flat_result_t>())
     {
     }
 
@@ -85,7 +227,7 @@ public:
 
     static Request convert(const drishti_request_t &request)
     {
-        return Request
+        Request result
         {
             request.n,
             request.getImage,
@@ -93,48 +235,97 @@ public:
             request.getFrames,
             request.getEyes
         };
+
+        result.format = static_cast<Request::Format>(request.format);
+        result.size = { request.width, request.height };
+        result.roi = { request.roi.x, request.roi.y, request.roi.width, request.roi.height };
+        return result;
     }
 
     Request request(const Faces& faces, const TimePoint& timeStamp, std::uint32_t texture) override
     {
+        // Frame timestamps may be capture times on a camera clock, so elapsed is relative to the first frame:
+        if (!m_hasStart)
+        {
+            m_start = timeStamp;
+            m_hasStart = true;
+        }
         double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(timeStamp - m_start).count();
+        if (m_table.flat)
+        {
+            drishti::sdk::convert(faces, elapsed, *m_flat);
+            m_table.flat(m_table.context, *m_flat);
+        }
+
+        // Fields requested for the previous frame (the client hasn't seen this one yet):
         drishti_face_tracker_result_t result;
-        convert(faces, result.faceModels);
-        return convert(m_table.update(m_table.context, result, elapsed, texture));
+        convert(faces, m_fields, result.faceModels);
+
+        const drishti_request_t request = m_table.update(m_table.context, result, elapsed, texture);
+        m_fields = request.fields ? request.fields : std::uint32_t(DRISHTI_FIELD_ALL);
+        return convert(request);
     }
 
     void grab(const std::vector<FaceImage>& frames, bool isInitialized) override
     {
-        drishti_face_tracker_results_t results(frames.size());
+        // The pooled result keeps a (shallow) reference to each frame, so the SDK images stay valid:
+        m_current = m_pool.acquire();
+        m_current->frames = frames;
 
-        for (size_t i = 0; i < frames.size(); i++)
+        auto& results = m_current->results;
+        results.resize(frames.size());
+        for (size_t i = 0; i < results.size(); i++)
         {
-            // Copy the full frame "face" image and metadata:
-            convert(frames[i].image, results[i].image);
-            convert(frames[i].faceModels, results[i].faceModels);
+            const auto& frame = m_current->frames[i];
+            results[i] = {}; // recycled buffer
+
+            // Alias the full frame "face" image and copy the metadata:
+            convert(frame.image, results[i].image);
+            convert(frame.faceModels, m_fields, results[i].faceModels);
 
-            // Copy the eye images and metadata:
-            convert(frames[i].eyes, results[i].eyes);
+            // Alias the eye images and copy the metadata:
+            convert(frame.eyes, results[i].eyes);
             results[i].eyeModels.resize(2);
             for (int j = 0; j < 2; j++)
             {
-                if (frames[i].eyeModels[j].eyelids.size())
+                if (frame.eyeModels[j].eyelids.size())
                 {
-                    results[i].eyeModels[j] = drishti::sdk::convert(frames[i].eyeModels[j]);
+                    drishti::sdk::convert(frame.eyeModels[j], m_fields, results[i].eyeModels[j]);
                 }
             }
         }
 
         m_table.callback(m_table.context, results);
+        m_current.reset(); // the buffer is recycled here unless the client retained it
+    }
+
+    // Returns a handle for results currently being reported by this adapter (or nullptr):
+    void* retain(const drishti_face_tracker_results_t& results)
+    {
+        if (m_current && (&m_current->results == &results))
+        {
+            return new std::shared_ptr<Result>(m_current);
+        }
+        return nullptr;
+    }
+
+    static void release(void* handle)
+    {
+        delete static_cast<std::shared_ptr<Result>*>(handle);
     }
 
 protected:
-    static void convert(const Faces& facesIn, drishti::sdk::Array<drishti::sdk::Face, 2>& facesOut)
+    struct Result
+    {
+        drishti_face_tracker_results_t results;
+        std::vector<FaceImage> frames; // owns the memory referenced by results
+    };
+    static void convert(const Faces& facesIn, std::uint32_t fields, drishti::sdk::Array<drishti::sdk::Face, 2>& facesOut)
     {
         facesOut.resize(std::min(facesOut.limit(), facesIn.size()));
         for (std::size_t i = 0; i < facesOut.size(); i++)
         {
-            facesOut[i] = drishti::sdk::convert(facesIn[i]);
+            facesOut[i] = drishti::sdk::convert(facesIn[i], fields);
         }
     }
 
@@ -148,13 +339,25 @@ protected:
         dst.texture = convert(src.texture);
         if (!src.image.empty())
         {
-            dst.image = cvToDrishti<cv::Vec4b, drishti::sdk::Vec4b>(src.image);
+            dst.image = cvToDrishtiShared<cv::Vec4b, drishti::sdk::Vec4b>(src.image);
+        }
+        if (!src.planes.empty())
+        {
+            dst.planes = cvToDrishtiShared<std::uint8_t, std::uint8_t>(src.planes);
         }
     }
 
-    TimePoint m_start;              //! Timestmap for the start of tracking
+    TimePoint m_start;              //! Timestamp of the first frame
+    bool m_hasStart = false;        //! m_start is set
     drishti_face_tracker_t m_table; //! Table of callbacks for face tracker output
     int m_n = 1;                    //! Number of frames to request for each callback
+
+    drishti::core::SharedPool<Result> m_pool; //! Recycled result buffers
+    std::shared_ptr<Result> m_current;        //! Result for the active callback
+
+    std::unique_ptr<drishti_flat_result_t> m_flat; //! Flat result for the optional callback
+
+    std::uint32_t m_fields = DRISHTI_FIELD_ALL; //! Face and eye model fields requested by the client
 };
 
 _DRISHTI_SDK_END
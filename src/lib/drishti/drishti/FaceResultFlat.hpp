@@ -0,0 +1,100 @@
+/**
+  @file   FaceResultFlat.hpp
+  @author David Hirvonen
+  @brief  Public flat (POD) face tracker result layout.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A fixed size, plain C view of the face and eye models for each frame.  The structs
+  contain no pointers or variable length containers, so C, Swift and JNI consumers can
+  memcpy or map a result directly.  Points are stored as interleaved (x, y) floats,
+  ellipses as (cx, cy, width, height, angle) and rectangles as (x, y, width, height).
+  Producers fill the version and size tags, which consumers should check before reading.
+*/
+
+#ifndef __drishti_drishti_FaceResultFlat_hpp__
+#define __drishti_drishti_FaceResultFlat_hpp__ 1
+
+#include <drishti/drishti_sdk.hpp>
+
+#include <stdint.h>
+#include <type_traits>
+
+#define DRISHTI_FLAT_RESULT_VERSION 1
+#define DRISHTI_FLAT_MAX_FACES 2
+#define DRISHTI_FLAT_MAX_LANDMARKS 128
+#define DRISHTI_FLAT_MAX_EYELIDS 64 // DRISHTI_EYE_CONTOUR_POINTS
+#define DRISHTI_FLAT_MAX_CREASE 16  // DRISHTI_EYE_CREASE_POINTS
+
+DRISHTI_EXTERN_C_BEGIN
+
+/**
+ * @brief Flags for the optional fields of a flat face.
+ */
+
+enum drishti_flat_face_flags
+{
+    DRISHTI_FLAT_HAS_EYES = 1,     //! eyes[] are valid
+    DRISHTI_FLAT_HAS_POSITION = 2, //! position is valid
+    DRISHTI_FLAT_HAS_GAZE = 4      //! gaze is valid
+};
+
+/**
+ * @brief A fixed size eye model.
+ */
+
+struct drishti_flat_eye
+{
+    float roi[4];
+    float iris[5];
+    float pupil[5];
+    float innerCorner[2];
+    float outerCorner[2];
+
+    uint32_t eyelidCount;                        //! valid points in eyelids
+    uint32_t creaseCount;                        //! valid points in crease
+    float eyelids[DRISHTI_FLAT_MAX_EYELIDS * 2]; //! closed eyelid contour
+    float crease[DRISHTI_FLAT_MAX_CREASE * 2];   //! open crease curve
+};
+
+using drishti_flat_eye_t = struct drishti_flat_eye;
+
+/**
+ * @brief A fixed size face model.
+ */
+
+struct drishti_flat_face
+{
+    float roi[4];
+    uint32_t flags;             //! drishti_flat_face_flags
+    float position[3];          //! point between the eyes (camera coordinates)
+    float gaze[2][3];           //! right, left unit gaze vectors
+    drishti_flat_eye_t eyes[2]; //! right, left eye models
+    uint32_t landmarkCount;     //! valid points in landmarks
+    float landmarks[DRISHTI_FLAT_MAX_LANDMARKS * 2];
+};
+
+using drishti_flat_face_t = struct drishti_flat_face;
+
+/**
+ * @brief Face models for one frame.
+ */
+
+struct drishti_flat_result
+{
+    uint32_t version; //! DRISHTI_FLAT_RESULT_VERSION
+    uint32_t size;    //! sizeof(drishti_flat_result_t)
+    double time;      //! acquisition time (seconds since the start of tracking)
+    uint32_t faceCount;
+    drishti_flat_face_t faces[DRISHTI_FLAT_MAX_FACES];
+};
+
+using drishti_flat_result_t = struct drishti_flat_result;
+
+DRISHTI_EXTERN_C_END
+
+static_assert(std::is_standard_layout<drishti_flat_result_t>::value, "drishti_flat_result_t must be standard layout");
+static_assert(std::is_trivially_copyable<drishti_flat_result_t>::value, "drishti_flat_result_t must be trivially copyable");
+
+#endif // __drishti_drishti_FaceResultFlat_hpp__
@@ -15,18 +15,40 @@
 
 #include <drishti/face/Face.h>
 #include <drishti/hci/FaceFinder.h>
+#if DRISHTI_HCI_WITH_PAINTER
 #include <drishti/hci/FaceFinderPainter.h>
+#endif
 #include <drishti/core/make_unique.h>
 #include <drishti/core/Logger.h>
+#include <drishti/graphics/GLTexture.h>
+#include <drishti/graphics/nv12.h>
+
+#include "ogles_gpgpu/common/proc/video.h"
+#include "ogles_gpgpu/common/proc/grayscale.h"
 
 #include <drishti/drishti_cv.hpp>
 
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <memory>
+#include <stdexcept>
+
+// clang-format off
+#if defined(GL_SYNC_GPU_COMMANDS_COMPLETE)
+#  define DRISHTI_SDK_HAS_FENCE 1
+#else
+#  define DRISHTI_SDK_HAS_FENCE 0
+#endif
+#if defined(GL_TEXTURE_EXTERNAL_OES) && defined(GL_OES_EGL_image)
+#  define DRISHTI_SDK_HAS_EGL_IMAGE 1
+#else
+#  define DRISHTI_SDK_HAS_EGL_IMAGE 0
+#endif
+// clang-format on
 
 _DRISHTI_SDK_BEGIN
 
@@ -45,6 +67,7 @@ struct FaceTracker::Impl
      */
 
     Impl(Context* manager, FaceTracker::Resources& resources)
+        : m_manager(manager)
     {
         Settings settings;
         settings.sensor = manager->get()->sensor;
@@ -59,8 +82,9 @@ struct FaceTracker::Impl
             settings.logger = drishti::core::Logger::create(resources.logger.c_str());
         }
 
-        settings.threads = std::make_shared<tp::ThreadPool<>>();
-        settings.outputOrientation = 0;
+        settings.threads = manager->get()->getThreads(); // shared by all trackers in the context
+        m_orientation = manager->getOrientationCallback();
+        settings.outputOrientation = m_orientation ? m_orientation() : 0;
         settings.frameDelay = 1;
         settings.doLandmarks = true;
         settings.doFlow = false;
@@ -75,30 +99,228 @@ struct FaceTracker::Impl
         settings.maxTrackMisses = manager->getMaxTrackMisses();
         settings.minFaceSeparation = manager->getMinFaceSeparation();
         settings.doOptimizedPipeline = manager->getDoOptimizedPipeline();
+        settings.shaderCache = manager->getShaderCache();
 
-        auto stream = std::make_shared<drishti::face::FaceDetectorFactoryStream>();
-        stream->iEyeRegressor = resources.sEyeRegressor;
-        stream->iFaceDetector = resources.sFaceDetector;
-        stream->iFaceRegressor = resources.sFaceRegressor;
-        stream->iFaceDetectorMean = resources.sFaceModel;
+        if (const auto power = manager->getPowerCallback())
+        {
+            settings.power = [power]() {
+                const Context::PowerState state = power();
+                drishti::hci::PowerPolicy::State result;
+                result.thermal = state.thermal;
+                result.battery = state.battery;
+                result.charging = state.charging;
+                return result;
+            };
+        }
 
-        std::shared_ptr<drishti::face::FaceDetectorFactory> factory = stream;
+        // Trackers for several cameras in one context share the models (and the thread pool):
+        std::shared_ptr<drishti::face::FaceDetectorFactory> factory = manager->get()->getFactory({ {
+            resources.sFaceDetector,
+            resources.sFaceRegressor,
+            resources.sEyeRegressor,
+            resources.sFaceModel
+        } });
 
+#if DRISHTI_HCI_WITH_PAINTER
         if (manager->getDoAnnotation())
         {
             m_faceFinder = drishti::hci::FaceFinderPainter::create(factory, settings, manager->get()->glContext);
         }
         else
-        {
+#endif
+        { // annotations are ignored without the painter (DRISHTI_HCI_WITH_PAINTER)
             m_faceFinder = drishti::hci::FaceFinder::create(factory, settings, manager->get()->glContext);
         }
 
         m_faceFinder->setDoCpuAcf(manager->getDoCpuACF());
+        initInputs();
+    }
+
+    ~Impl()
+    {
+        releaseInputs();
+    }
+
+    // Input converters (GL objects of the tracker context, see suspend()):
+    void initInputs()
+    {
+        m_nv12 = drishti::core::make_unique<ogles_gpgpu::Nv12Proc>();
+        m_nv12Source = drishti::core::make_unique<ogles_gpgpu::VideoSource>();
+        m_nv12Source->set(m_nv12.get());
+        m_external = drishti::core::make_unique<ogles_gpgpu::GrayscaleProc>();
+        m_external->setGrayscaleConvType(ogles_gpgpu::GRAYSCALE_INPUT_CONVERSION_NONE);
+        m_externalSize = {};
+    }
+
+    void releaseInputs()
+    {
+        if (m_eglTexture)
+        {
+            glDeleteTextures(1, &m_eglTexture);
+            m_eglTexture = 0;
+            m_eglImage = nullptr;
+        }
+        m_luma.reset();
+        m_chroma.reset();
+        m_nv12Source.reset();
+        m_nv12.reset();
+        m_external.reset();
+    }
+
+    void suspend()
+    {
+        if (!m_faceFinder->isSuspended())
+        {
+            m_faceFinder->suspend();
+            releaseInputs();
+        }
+    }
+
+    void resume()
+    {
+        if (m_faceFinder->isSuspended())
+        {
+            initInputs();
+            m_faceFinder->resume();
+        }
     }
 
     int operator()(const VideoFrame& frame)
     {
-        return (*m_faceFinder)(convert(frame));
+        // Distance band changes rebuild the detection pyramid plan (no-op when unchanged):
+        m_faceFinder->setDetectionDistance(m_manager->getMinDetectionDistance(), m_manager->getMaxDetectionDistance());
+        if (m_orientation)
+        {
+            m_faceFinder->setOrientation(m_orientation()); // no-op when unchanged
+        }
+        if (frame.timestamp >= 0.0)
+        {
+            using TimePoint = drishti::hci::FaceFinder::TimePoint;
+            const std::chrono::duration<double> time(frame.timestamp);
+            m_faceFinder->setCaptureTime(TimePoint(std::chrono::duration_cast<TimePoint::duration>(time)));
+        }
+
+        // Producer commands in a shared context complete before our first read (GPU side):
+        if (frame.fence)
+        {
+#if DRISHTI_SDK_HAS_FENCE
+            glWaitSync(static_cast<GLsync>(frame.fence), 0, GL_TIMEOUT_IGNORED);
+#else
+            glFinish();
+#endif
+        }
+
+        if (frame.isNv12())
+        {
+            return (*m_faceFinder)(convertNv12(frame));
+        }
+        return (*m_faceFinder)(frame.isExternal() ? convertExternal(frame) : convert(frame));
+    }
+
+    // External textures can't be sampled as GL_TEXTURE_2D by the FaceFinder pipeline, so they are
+    // rendered to an RGBA texture in one pass (the same pass an app would otherwise run in its
+    // own context, followed by a copy to the tracker context):
+    ogles_gpgpu::FrameInput convertExternal(const VideoFrame& frame)
+    {
+        const int width = frame.size[0], height = frame.size[1];
+
+        GLuint texture = frame.inputTexture;
+        GLenum target = frame.textureTarget;
+        if (frame.eglImage)
+        {
+#if DRISHTI_SDK_HAS_EGL_IMAGE
+            // Rebind only when the producer hands over a different image (e.g., a swapchain):
+            if (!m_eglTexture)
+            {
+                glGenTextures(1, &m_eglTexture);
+            }
+            if (frame.eglImage != m_eglImage)
+            {
+                glBindTexture(GL_TEXTURE_EXTERNAL_OES, m_eglTexture);
+                glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, static_cast<GLeglImageOES>(frame.eglImage));
+                glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+                m_eglImage = frame.eglImage;
+            }
+            texture = m_eglTexture;
+            target = GL_TEXTURE_EXTERNAL_OES;
+#else
+            throw std::runtime_error("FaceTracker: EGLImage input is not supported on this platform");
+#endif
+        }
+
+        if ((m_externalSize[0] != width) || (m_externalSize[1] != height))
+        {
+            m_external->prepare(width, height, 0, false);
+            m_externalSize = frame.size;
+        }
+        m_external->process(texture, 1, target);
+
+        return { { width, height }, nullptr, false, m_external->getOutputTexId(), GL_RGBA };
+    }
+
+    void* createFence()
+    {
+#if DRISHTI_SDK_HAS_FENCE
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush(); // visible to the other contexts
+        return fence;
+#else
+        return nullptr;
+#endif
+    }
+
+    // NV12 frames are converted to RGBA in one GPU pass, raw planes are uploaded as
+    // luminance textures (no CPU color conversion in the caller or here):
+    ogles_gpgpu::FrameInput convertNv12(const VideoFrame& frame)
+    {
+        const int width = frame.size[0], height = frame.size[1];
+
+        GLuint luma = frame.inputTexture, chroma = frame.chromaTexture;
+        if (frame.pixelBuffer && frame.chromaBuffer)
+        {
+            if (!m_luma || (m_luma->width != width) || (m_luma->height != height))
+            {
+                m_luma = drishti::core::make_unique<ogles_gpgpu::GLTexture>(width, height, GL_LUMINANCE, nullptr, GL_LUMINANCE);
+                m_chroma = drishti::core::make_unique<ogles_gpgpu::GLTexture>(width / 2, height / 2, GL_LUMINANCE_ALPHA, nullptr, GL_LUMINANCE_ALPHA);
+            }
+
+            m_luma->update(frame.pixelBuffer);
+            m_chroma->update(frame.chromaBuffer);
+            luma = *m_luma;
+            chroma = *m_chroma;
+        }
+
+        m_nv12->setChromaTexture(chroma);
+        (*m_nv12Source)({ { width, height }, nullptr, false, luma, GL_LUMINANCE });
+
+        return { { width, height }, nullptr, false, m_nv12->getOutputTexId(), GL_RGBA };
+    }
+
+    int submit(const VideoFrame& frame)
+    {
+        const auto dropped = m_faceFinder->getDroppedFrameCount();
+        (*this)(frame);
+        return static_cast<int>(m_faceFinder->getDroppedFrameCount() - dropped);
+    }
+
+    void setBackpressure(Backpressure policy)
+    {
+        switch (policy)
+        {
+            case kBlock:
+                m_faceFinder->setBackpressure(drishti::hci::FaceFinder::kBlock);
+                break;
+            case kDropNewest:
+                m_faceFinder->setBackpressure(drishti::hci::FaceFinder::kDropNewest);
+                break;
+            case kDropOldest:
+                m_faceFinder->setBackpressure(drishti::hci::FaceFinder::kDropOldest);
+                break;
+        }
     }
 
     void add(drishti_face_tracker_t& table)
@@ -108,9 +330,34 @@ struct FaceTracker::Impl
         m_callbacks.emplace_back(callback);
     }
 
+    void* retain(const drishti_face_tracker_results_t& results)
+    {
+        for (auto& callback : m_callbacks)
+        {
+            if (void* handle = callback->retain(results))
+            {
+                return handle;
+            }
+        }
+        return nullptr;
+    }
+
     std::vector<std::shared_ptr<FaceMonitorAdapter>> m_callbacks;
 
+    Context* m_manager = nullptr;
+    Context::OrientationCallback m_orientation;
     std::unique_ptr<drishti::hci::FaceFinder> m_faceFinder;
+
+    // NV12 input:
+    std::unique_ptr<ogles_gpgpu::VideoSource> m_nv12Source;
+    std::unique_ptr<ogles_gpgpu::Nv12Proc> m_nv12;
+    std::unique_ptr<ogles_gpgpu::GLTexture> m_luma, m_chroma;
+
+    // External (GL_TEXTURE_EXTERNAL_OES or EGLImage) input:
+    std::unique_ptr<ogles_gpgpu::GrayscaleProc> m_external; // RGBA pass through
+    Vec2i m_externalSize{};
+    GLuint m_eglTexture = 0;
+    void* m_eglImage = nullptr;
 };
 
 /*
@@ -122,6 +369,31 @@ int FaceTracker::operator()(const VideoFrame& image)
     return (*m_impl)(image);
 }
 
+int FaceTracker::submit(const VideoFrame& image)
+{
+    return m_impl->submit(image);
+}
+
+void* FaceTracker::createFence()
+{
+    return m_impl->createFence();
+}
+
+void FaceTracker::setBackpressure(Backpressure policy)
+{
+    m_impl->setBackpressure(policy);
+}
+
+void FaceTracker::suspend()
+{
+    m_impl->suspend();
+}
+
+void FaceTracker::resume()
+{
+    m_impl->resume();
+}
+
 FaceTracker::FaceTracker(Context* manager, Resources& factory)
 {
     m_impl = drishti::core::make_unique<Impl>(manager, factory);
@@ -150,6 +422,16 @@ void FaceTracker::add(drishti_face_tracker_t& table)
     m_impl->add(table);
 }
 
+void* FaceTracker::retain(const drishti_face_tracker_results_t& results)
+{
+    return m_impl->retain(results);
+}
+
+void FaceTracker::release(void* handle)
+{
+    FaceMonitorAdapter::release(handle);
+}
+
 // ### utility
 
 static ogles_gpgpu::FrameInput convert(const VideoFrame& frame)
@@ -209,6 +491,57 @@ drishti_face_tracker_callback
     return -1;
 }
 
+DRISHTI_EXPORT void*
+drishti_face_tracker_retain
+(
+    drishti::sdk::FaceTracker* tracker,
+    const drishti_face_tracker_results_t& results
+)
+{
+    if (tracker)
+    {
+        return tracker->retain(results);
+    }
+    return nullptr;
+}
+
+DRISHTI_EXPORT void
+drishti_face_tracker_release(drishti::sdk::FaceTracker* tracker, void* handle)
+{
+    if (tracker)
+    {
+        tracker->release(handle);
+    }
+}
+
+DRISHTI_EXPORT int
+drishti_face_tracker_submit(drishti::sdk::FaceTracker* tracker, const drishti::sdk::VideoFrame& image)
+{
+    if (tracker)
+    {
+        return tracker->submit(image);
+    }
+    return -1;
+}
+
+DRISHTI_EXPORT void
+drishti_face_tracker_suspend(drishti::sdk::FaceTracker* tracker)
+{
+    if (tracker)
+    {
+        tracker->suspend();
+    }
+}
+
+DRISHTI_EXPORT void
+drishti_face_tracker_resume(drishti::sdk::FaceTracker* tracker)
+{
+    if (tracker)
+    {
+        tracker->resume();
+    }
+}
+
 DRISHTI_EXPORT int
 drishti_face_tracker_track(drishti::sdk::FaceTracker* tracker, const drishti::sdk::VideoFrame& image)
 {
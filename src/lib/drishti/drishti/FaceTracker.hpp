@@ -16,6 +16,7 @@
 #include <drishti/drishti_constants.hpp> // DRISHTI_SDK_MAX_FACES
 #include <drishti/Image.hpp>
 #include <drishti/Face.hpp>
+#include <drishti/FaceResultFlat.hpp>
 #include <drishti/VideoFrame.hpp>
 #include <drishti/Context.hpp>
 
@@ -39,6 +40,11 @@ struct drishti_image_tex_t
      * A 32-bit RGBA image container class.
      */
     drishti::sdk::Image4b image;
+
+    /**
+     * An 8-bit gray or I420 image (Y plane followed by the U and V planes) for planar requests.
+     */
+    drishti::sdk::Image1b planes;
 };
 
 struct drishti_face_tracker_result_t
@@ -108,6 +114,44 @@ struct drishti_image
 
 using drishti_image_t = drishti_image;
 
+/**
+ * @brief Pixel formats for requested frame images.
+ */
+
+enum drishti_image_format
+{
+    DRISHTI_IMAGE_RGBA = 0, //! 32-bit RGBA (drishti_image_tex_t::image)
+    DRISHTI_IMAGE_GRAY,     //! 8-bit luma (drishti_image_tex_t::planes)
+    DRISHTI_IMAGE_I420      //! 8-bit Y, U, V planes with half resolution chroma (drishti_image_tex_t::planes)
+};
+
+using drishti_image_format_t = enum drishti_image_format;
+
+/**
+ * @brief Face and eye model fields reported to the callbacks (a bitmask, 0 == all fields).
+ *
+ * Fields that aren't requested are left empty (default) in the drishti::sdk::Face and
+ * drishti::sdk::Eye results, so the (per frame) conversion cost is only paid for the
+ * fields a client actually reads, e.g., DRISHTI_FIELD_IRIS | DRISHTI_FIELD_EYELIDS for
+ * iris centers and openness.
+ */
+
+enum drishti_face_field
+{
+    DRISHTI_FIELD_LANDMARKS = 1 << 0, //! Face landmarks
+    DRISHTI_FIELD_POSITION = 1 << 1,  //! 3D position between the eyes
+    DRISHTI_FIELD_GAZE = 1 << 2,      //! Gaze vectors
+    DRISHTI_FIELD_IRIS = 1 << 3,      //! Iris ellipses
+    DRISHTI_FIELD_PUPIL = 1 << 4,     //! Pupil ellipses
+    DRISHTI_FIELD_CORNERS = 1 << 5,   //! Eye corners
+    DRISHTI_FIELD_EYE_ROI = 1 << 6,   //! Eye regions
+    DRISHTI_FIELD_EYELIDS = 1 << 7,   //! Eyelid contours
+    DRISHTI_FIELD_CREASE = 1 << 8,    //! Crease contours
+    DRISHTI_FIELD_ALL = 0x1ff
+};
+
+using drishti_face_field_t = enum drishti_face_field;
+
 /**
  * @brief A "request" object specifying the # of frames to retrieve and
  * the desired format: (1) OpenGL texture or; (2) user memory.
@@ -140,6 +184,27 @@ struct drishti_request_t
      */
     bool getEyes;
 
+    /**
+     * Pixel format for frame images (converted on the GPU before readback).
+     */
+    drishti_image_format_t format;
+
+    /**
+     * Frame image width and height (0 == native, a single 0 preserves the aspect ratio).
+     */
+    int width, height;
+
+    /**
+     * Normalized frame crop, e.g., a face region (empty == full frame).
+     */
+    drishti::sdk::Rectf roi;
+
+    /**
+     * Face and eye model fields to report, a mask of <drishti_face_field_t> values (0 == all).
+     * The mask applies to the history returned for this request and to subsequent frames.
+     */
+    std::uint32_t fields;
+
 };
 
 /**
@@ -177,6 +242,19 @@ using drishti_face_tracker_callback_t = int (*)(void *, drishti_face_tracker_res
  */
 using drishti_face_tracker_update_t = drishti_request_t (*)(void *, const drishti_face_tracker_result_t &, double, std::uint32_t);
 
+/**
+ * @brief Returns the face models for the current frame in the flat (POD) layout.
+ *
+ * This optional callback is called for each frame before <update> with the same faces.
+ * The result is filled directly from the internal models and is only valid for the
+ * duration of the call.
+ *
+ * @param context Allocated context with internal library state.
+ * @param result Flat face models for the current frame (see FaceResultFlat.hpp).
+ * @return Error code (reserved).
+ */
+using drishti_face_tracker_flat_t = int (*)(void *, const drishti_flat_result_t &);
+
 /**
  * @brief Allocation routine.
  *
@@ -223,6 +301,11 @@ struct drishti_face_tracker
      * A callback for memory allocation.
      */
     drishti_face_tracker_allocator_t allocator;
+
+    /**
+     * An optional callback with the flat face models for each frame (may be null).
+     */
+    drishti_face_tracker_flat_t flat;
 };
 
 using drishti_face_tracker_t = struct drishti_face_tracker;
@@ -241,6 +324,9 @@ class DRISHTI_EXPORT FaceTracker
 public:
     // Maintain raw pointers as this code may need to interface with non-coypable istream sources.
     // The referenced streams must stay in scope for the scope of the construction.
+    // Trackers created in one Context with the same streams (e.g., one per camera) share
+    // a single copy of the regressor models, so the streams must also remain valid (and
+    // seekable) until the last of these trackers is constructed.
     struct Resources
     {
         std::istream* sFaceDetector{};
@@ -250,6 +336,16 @@ public:
         std::string logger; // logger name
     };
 
+    /**
+     * Policy for frames submitted while face regression for an earlier frame is still running.
+     */
+    enum Backpressure
+    {
+        kBlock,      //! Wait for the earlier frame (default).
+        kDropNewest, //! Drop the submitted frame.
+        kDropOldest  //! Track the submitted frame and drop the late results.
+    };
+
     /**
      * Constructor
      *
@@ -278,10 +374,54 @@ public:
     /**
      * Runs face tracking on a single input video frame.
      *
-     * @param image The input video frame object.
+     * @param image The input video frame object: an RGBA/BGRA texture or pixel buffer,
+     * two plane YUV (see VideoFrame::nv12()) or an external texture or EGLImage (see
+     * VideoFrame::external()), which are converted on the GPU.
      */
     int operator()(const VideoFrame& image);
 
+    /**
+     * Submit a single input video frame for tracking.
+     *
+     * The call returns once the GPU work for the frame is queued, and results for earlier
+     * frames are reported through the installed callbacks as the CPU stages complete.
+     * It only waits on CPU work for the kBlock policy.
+     *
+     * @param image The input video frame object.
+     * @return The number of frames (or late results) dropped by this call.
+     */
+    int submit(const VideoFrame& image);
+
+    /**
+     * Insert a fence after the GPU commands queued for the last input frame, so a producer
+     * in a shared context can reuse its texture (glWaitSync()) while tracking runs on the
+     * tracker's own GL thread.
+     *
+     * @return A GLsync owned by the caller (glDeleteSync()), or nullptr without fence support.
+     */
+    void* createFence();
+
+    /**
+     * Set the policy for frames submitted while the CPU stages are busy.
+     *
+     * @param policy The back-pressure policy.
+     */
+    void setBackpressure(Backpressure policy);
+
+    /**
+     * Release the OpenGL resources before the context is lost (e.g., Android onPause()),
+     * keeping the models, the face tracks and the last face regions.  Call it on the tracker's
+     * GL thread while the context is still current.  Frames are ignored until resume().
+     */
+    void suspend();
+
+    /**
+     * Rebuild the OpenGL resources in the current context after suspend() (programs are
+     * linked from binaries with Context::setShaderCache()), the first detection scans around
+     * the faces tracked before suspend().
+     */
+    void resume();
+
     /**
      * Return true if object was successfully allocated.
      */
@@ -299,6 +439,24 @@ public:
      */
     void add(drishti_face_tracker_t& table);
 
+    /**
+     * Keep the results reported to a <callback> (including the images) valid after it returns.
+     *
+     * The images alias internal buffers, so no copy is made.  This must be called from within
+     * the callback, and the buffers are recycled only after the handle is released.
+     *
+     * @param results The results passed to the active callback.
+     * @return A handle for release(), or nullptr if the results are not from an active callback.
+     */
+    void* retain(const drishti_face_tracker_results_t& results);
+
+    /**
+     * Release results previously retained with retain().
+     *
+     * @param handle The handle returned by retain() (may be called from any thread).
+     */
+    void release(void* handle);
+
 protected:
 
     struct Impl;
@@ -381,6 +539,72 @@ drishti_face_tracker_callback
     drishti_face_tracker_t& table
 );
 
+/**
+ * @brief Retain the results reported to a callback beyond the callback scope.
+ *
+ * The results (and images) remain valid without a copy until the handle is released.
+ *
+ * @param tracker The FaceTracker object
+ * @param results The results passed to the active callback.
+ * @param return A handle for drishti_face_tracker_release() (or nullptr on failure).
+ */
+
+DRISHTI_EXPORT void*
+drishti_face_tracker_retain
+(
+    drishti::sdk::FaceTracker* tracker,
+    const drishti_face_tracker_results_t& results
+);
+
+/**
+ * @brief Release results retained with drishti_face_tracker_retain().
+ *
+ * @param tracker The FaceTracker object
+ * @param handle The handle returned by drishti_face_tracker_retain().
+ */
+
+DRISHTI_EXPORT void
+drishti_face_tracker_release(drishti::sdk::FaceTracker* tracker, void* handle);
+
+/**
+ * @brief Submit a frame for face tracking without waiting on the CPU stages.
+ *
+ * @see drishti::sdk::FaceTracker::submit()
+ *
+ * @param tracker The FaceTracker object
+ * @param frame The video frame for face detection + tracking
+ * @param return The number of dropped frames, or -1 on error.
+ */
+
+DRISHTI_EXPORT int
+drishti_face_tracker_submit
+(
+    drishti::sdk::FaceTracker* tracker,
+    const drishti::sdk::VideoFrame& frame
+);
+
+/**
+ * @brief Release the OpenGL resources of a tracker (the tracks and models are kept).
+ *
+ * @see drishti::sdk::FaceTracker::suspend()
+ *
+ * @param tracker The FaceTracker object
+ */
+
+DRISHTI_EXPORT void
+drishti_face_tracker_suspend(drishti::sdk::FaceTracker* tracker);
+
+/**
+ * @brief Rebuild the OpenGL resources of a suspended tracker in the current context.
+ *
+ * @see drishti::sdk::FaceTracker::resume()
+ *
+ * @param tracker The FaceTracker object
+ */
+
+DRISHTI_EXPORT void
+drishti_face_tracker_resume(drishti::sdk::FaceTracker* tracker);
+
 DRISHTI_EXTERN_C_END
 
 #endif // __drishti_drishti_FaceTracker_hpp__
@@ -21,32 +21,31 @@ template <typename T>
 Image<T>::Image() = default;
 
 template <typename T>
-Image<T>::~Image()
-{
-    if (storage)
-    {
-        delete[] storage;
-    }
-    storage = data = nullptr;
-}
+Image<T>::~Image() = default;
 
 template <typename T>
-Image<T>::Image(const Image& src)
-    : rows(src.rows)
-    , cols(src.cols)
-    , storage(nullptr)
-    , data(src.data)
-    , stride(src.stride)
+Image<T>::Image(const Image& src) = default;
+
+template <typename T>
+Image<T>::Image(size_t rows, size_t cols, T* data, size_t stride, bool keep)
+    : rows(rows)
+    , cols(cols)
+    , data(data)
+    , stride(stride)
 {
+    if (keep)
+    {
+        owner = std::shared_ptr<T>(data, std::default_delete<T[]>());
+    }
 }
 
 template <typename T>
-Image<T>::Image(size_t rows, size_t cols, T* data, size_t stride, bool keep)
+Image<T>::Image(size_t rows, size_t cols, T* data, size_t stride, std::shared_ptr<void> owner)
     : rows(rows)
     , cols(cols)
-    , storage(keep ? data : nullptr)
     , data(data)
     , stride(stride)
+    , owner(std::move(owner))
 {
 }
 
@@ -55,7 +54,7 @@ Image<T> Image<T>::clone()
 {
     std::unique_ptr<T[]> d(new T[(rows * stride + sizeof(T) - 1) / sizeof(T)]);
     memcpy(d.get(), data, rows * stride);
-    Image<T> dst(rows, cols, d.release(), stride);
+    Image<T> dst(rows, cols, d.release(), stride, true);
     return dst;
 }
 
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <type_traits>
 #include <cstdlib>
+#include <memory>
 
 _DRISHTI_SDK_BEGIN
 
@@ -181,6 +182,11 @@ struct DRISHTI_EXPORT Texture
 
 /*
  * Image types
+ *
+ * An image either aliases memory owned by the caller, or shares ownership of
+ * its buffer through an opaque handle (any shared_ptr, e.g., with a custom
+ * deleter or a reference to a cv::Mat, see drishti_cv.hpp).  Copies share the
+ * handle, so the buffer lives as long as the last image that refers to it.
  */
 
 template <typename T>
@@ -189,7 +195,13 @@ class DRISHTI_EXPORT Image
 public:
     Image();
     Image(const Image& src);
+
+    // keep == true: take ownership of data allocated with new T[]
     Image(size_t rows, size_t cols, T* data, size_t stride, bool keep = false);
+
+    // Shared ownership: owner keeps data valid (zero copy)
+    Image(size_t rows, size_t cols, T* data, size_t stride, std::shared_ptr<void> owner);
+
     ~Image();
 
     Image(Image&&) noexcept = default;
@@ -213,13 +225,18 @@ public:
     {
         return reinterpret_cast<T2*>(data); // NOLINT (TODO)
     }
+    const std::shared_ptr<void>& getOwner() const
+    {
+        return owner;
+    }
     Image<T> clone();
 
 protected:
     size_t rows = 0;
     size_t cols = 0;
-    T *storage = nullptr, *data = nullptr;
+    T* data = nullptr;
     size_t stride = 0; // byte
+    std::shared_ptr<void> owner; // empty for aliased memory
 };
 
 using Image1b = Image<uint8_t>;
@@ -30,11 +30,73 @@ struct DRISHTI_EXPORT VideoFrame
     {
     }
 
+    /**
+     * Two plane YUV 4:2:0 (NV12) frame: full resolution Y and interleaved half resolution
+     * CbCr (Cb first), given either as raw pixels (tightly packed) or as GL_LUMINANCE and
+     * GL_LUMINANCE_ALPHA textures.
+     */
+    static VideoFrame nv12(const Vec2i& size, void* luma, void* chroma)
+    {
+        VideoFrame frame(size, luma, true, 0, 0);
+        frame.chromaBuffer = chroma;
+        return frame;
+    }
+
+    static VideoFrame nv12(const Vec2i& size, GLuint luma, GLuint chroma)
+    {
+        VideoFrame frame(size, nullptr, false, luma, 0);
+        frame.chromaTexture = chroma;
+        return frame;
+    }
+
+    /**
+     * Texture from the camera or another (shared) context, sampled in place: a
+     * GL_TEXTURE_EXTERNAL_OES texture (e.g., an Android SurfaceTexture) or an EGLImageKHR
+     * (e.g., from an AHardwareBuffer or a producer context), which the tracker binds to a
+     * texture in its own context.  Both are converted to RGBA in one GPU pass.
+     */
+    static VideoFrame external(const Vec2i& size, GLuint texture, GLenum target)
+    {
+        VideoFrame frame(size, nullptr, false, texture, 0);
+        frame.textureTarget = target;
+        return frame;
+    }
+
+    static VideoFrame external(const Vec2i& size, void* eglImage)
+    {
+        VideoFrame frame(size, nullptr, false, 0, 0);
+        frame.eglImage = eglImage;
+        return frame;
+    }
+
+    bool isNv12() const { return (chromaBuffer != nullptr) || (chromaTexture != 0); }
+    bool isExternal() const { return (eglImage != nullptr) || (textureTarget != GL_TEXTURE_2D); }
+
     Vec2i size{};
     void* pixelBuffer = nullptr;
     bool useRawPixels = false;
     GLuint inputTexture = 0;
     GLenum textureFormat = 0;
+
+    void* chromaBuffer = nullptr; // NV12: CbCr plane (pixelBuffer is the Y plane)
+    GLuint chromaTexture = 0;     // NV12: CbCr texture (inputTexture is the Y texture)
+
+    GLenum textureTarget = GL_TEXTURE_2D; // external: target of inputTexture
+    void* eglImage = nullptr;             // external: EGLImageKHR (inputTexture is unused)
+
+    /**
+     * (optional) GLsync created in a context shared with the tracker context after the producer
+     * commands that write the input texture.  The tracker waits for it on the GPU (glWaitSync()),
+     * so a producer on another thread doesn't need a glFinish(), the caller owns the fence.
+     */
+    void* fence = nullptr;
+
+    /**
+     * Camera capture time in seconds on a monotonic clock (e.g., the sample buffer presentation
+     * time or SurfaceTexture::getTimestamp() * 1e-9), reported with the results of this frame.
+     * Frames with a negative timestamp use the arrival time.
+     */
+    double timestamp = -1.0;
 };
 
 _DRISHTI_SDK_END
@@ -20,6 +20,7 @@
 #include <opencv2/core.hpp>
 
 #include <algorithm>
+#include <memory>
 
 _DRISHTI_SDK_BEGIN
 
@@ -35,6 +36,73 @@ Image<T2> cvToDrishti(const cv::Mat_<T1>& src)
     return Image<T2>(src.rows, src.cols, const_cast<T2*>(src.template ptr<T2>()), src.step[0]);
 }
 
+// Image (shared ownership)
+//
+// cvToDrishtiShared() returns an Image that holds a reference to the cv::Mat buffer, and
+// drishtiToCvShared() returns a cv::Mat that holds a reference to the Image owner (through
+// a MatAllocator whose UMatData carries the handle), so neither side needs a clone() to
+// outlive the other.  An Image without an owner is wrapped as an alias, as in drishtiToCv().
+
+class SharedImageAllocator : public cv::MatAllocator
+{
+public:
+    static SharedImageAllocator* get()
+    {
+        static SharedImageAllocator allocator;
+        return &allocator;
+    }
+
+    cv::UMatData* allocate(const std::shared_ptr<void>& owner, void* data, std::size_t size) const
+    {
+        auto* u = new cv::UMatData(this);
+        u->data = u->origdata = static_cast<uchar*>(data);
+        u->size = size;
+        u->userdata = new std::shared_ptr<void>(owner);
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+        return u;
+    }
+
+    cv::UMatData* allocate(int, const int*, int, void*, size_t*, int, cv::UMatUsageFlags) const override
+    {
+        return nullptr; // wrap only (see allocate() above)
+    }
+
+    bool allocate(cv::UMatData*, int, cv::UMatUsageFlags) const override
+    {
+        return false;
+    }
+
+    void deallocate(cv::UMatData* u) const override
+    {
+        if (u)
+        {
+            delete static_cast<std::shared_ptr<void>*>(u->userdata);
+            delete u;
+        }
+    }
+};
+
+template <typename T1, typename T2>
+Image<T2> cvToDrishtiShared(const cv::Mat_<T1>& src)
+{
+    auto owner = std::make_shared<cv::Mat_<T1>>(src); // reference, not a copy
+    return Image<T2>(src.rows, src.cols, const_cast<T2*>(src.template ptr<T2>()), src.step[0], owner);
+}
+
+template <typename T1, typename T2>
+cv::Mat_<T2> drishtiToCvShared(const Image<T1>& src)
+{
+    cv::Mat_<T2> dst = drishtiToCv<T1, T2>(src);
+    if (src.getOwner())
+    {
+        auto* data = const_cast<T2*>(src.template ptr<T2>());
+        dst.u = SharedImageAllocator::get()->allocate(src.getOwner(), data, src.getRows() * src.getStride());
+        dst.u->refcount = 1;
+        dst.allocator = SharedImageAllocator::get();
+    }
+    return dst;
+}
+
 // Rect
 
 template <typename T>
@@ -55,6 +55,7 @@ if(DRISHTI_BUILD_HCI)
   sugar_files(DRISHTI_DRISHTI_HDRS_PUBLIC
     Context.hpp
     Face.hpp
+    FaceResultFlat.hpp
     FaceTracker.hpp
     Sensor.hpp
     VideoFrame.hpp
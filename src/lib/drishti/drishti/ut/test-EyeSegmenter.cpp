@@ -218,6 +218,30 @@ protected:
     float m_scoreThreshold = 0.60;
 };
 
+/*
+ * Image interop
+ */
+
+TEST(Image, SharedOwnership) // NOLINT (TODO)
+{
+    drishti::sdk::Image3b image;
+    {
+        cv::Mat3b source(32, 16, cv::Vec3b(1, 2, 3));
+        image = drishti::sdk::cvToDrishtiShared<cv::Vec3b, drishti::sdk::Vec3b>(source);
+        ASSERT_EQ(image.ptr<cv::Vec3b>(), source.ptr<cv::Vec3b>()); // zero copy
+    }
+
+    // The image keeps the buffer alive, and the cv::Mat keeps the image owner alive:
+    cv::Mat3b mat;
+    {
+        drishti::sdk::Image3b copy = image;
+        image = {};
+        mat = drishti::sdk::drishtiToCvShared<drishti::sdk::Vec3b, cv::Vec3b>(copy);
+    }
+    ASSERT_EQ(mat.size(), cv::Size(16, 32));
+    ASSERT_EQ(mat(31, 15), cv::Vec3b(1, 2, 3));
+}
+
 /*
  * Basic class construction
  */
@@ -385,6 +409,36 @@ TEST_F(EyeSegmenterTest, ImageIsWhite) // NOLINT (TODO)
     checkValid(eye, entry.storage.size());
 }
 
+TEST_F(EyeSegmenterTest, ImageBatch) // NOLINT (TODO)
+{
+    // Each valid width as a right eye, and again as a left eye in a mirrored copy:
+    std::vector<cv::Mat> storage;
+    std::vector<drishti::sdk::EyeSegmenter::Crop> crops;
+    for (auto iter = getFirstValid(); iter != m_images.end(); iter++)
+    {
+        cv::Mat flipped;
+        cv::flip(iter->second.storage, flipped, 1);
+        storage.push_back(flipped);
+
+        crops.push_back({ iter->second.image, {}, true });
+        crops.push_back({ drishti::sdk::cvToDrishti<cv::Vec3b, drishti::sdk::Vec3b>(flipped), {}, false });
+    }
+
+    std::vector<drishti::sdk::Eye> eyes;
+    std::vector<int> status;
+    EXPECT_EQ((*m_eyeSegmenter)(crops, eyes, status), 0);
+    ASSERT_EQ(eyes.size(), crops.size());
+
+    for (int i = 0; i < crops.size(); i++)
+    {
+        // Batch results must match the single image API:
+        drishti::sdk::Eye eye;
+        int code = (*m_eyeSegmenter)(crops[i].image, eye, crops[i].isRight);
+        EXPECT_EQ(status[i], code);
+        EXPECT_GT(detectionScore(eyes[i], eye), 0.99f);
+    }
+}
+
 #if defined(DRISHTI_BUILD_C_INTERFACE)
 TEST_F(EyeSegmenterTest, ExternCInterface)
 {
@@ -25,6 +25,9 @@
 #include "drishti/geometry/Primitives.h"
 #include "drishti/geometry/motion.h"
 
+#include <algorithm>
+#include <cmath>
+
 // clang-format off
 #if !DRISHTI_BUILD_MIN_SIZE
 #  include <opencv2/highgui.hpp>
@@ -40,7 +43,6 @@ DRISHTI_EYE_NAMESPACE_BEGIN
 
 using PointVec = std::vector<cv::Point2f>;
 static std::vector<PointVec> ellipseToContours(const cv::RotatedRect& ellipse, const PointVec& eyelids = {});
-static void fillPolly(cv::Mat& image, const PointVec& polly, const cv::Scalar& value);
 
 EyeModel::EyeModel() = default;
 EyeModel::~EyeModel() = default;
@@ -87,8 +89,9 @@ void EyeModel::upsample(int eyelidFactor, int creaseFactor)
     roi = cv::boundingRect(eyelids);
     if (eyelids.size() > 2)
     {
+        // Control point i is sample i * eyelidFactor (see fitSplineUniform()):
         std::vector<cv::Point2f> spline;
-        core::upsample(eyelids, spline, eyelidFactor, true);
+        core::fitSplineUniform(eyelids, spline, int(eyelids.size()) * eyelidFactor, true);
         std::swap(eyelids, spline);
         cornerIndices[0] *= eyelidFactor;
         cornerIndices[1] *= eyelidFactor;
@@ -97,7 +100,7 @@ void EyeModel::upsample(int eyelidFactor, int creaseFactor)
     if (crease.size() > 2)
     {
         std::vector<cv::Point2f> spline;
-        core::upsample(crease, spline, creaseFactor, false);
+        core::fitSplineUniform(crease, spline, (int(crease.size()) - 1) * creaseFactor + 1, false);
         std::swap(crease, spline);
     }
 }
@@ -126,7 +129,7 @@ void EyeModel::refine(int eyelidPoints, int creasePoints)
     if (eyelids.size() > 2)
     {
         eyelidsSpline.clear();
-        fitSpline(eyelids, eyelidsSpline, eyelidPoints);
+        fitSplineUniform(eyelids, eyelidsSpline, eyelidPoints, true);
         if (!isValid(eyelids, eyelidsSpline, 1.25))
         {
             eyelidsSpline = eyelids;
@@ -138,7 +141,7 @@ void EyeModel::refine(int eyelidPoints, int creasePoints)
     if (crease.size() > 2)
     {
         creaseSpline.clear();
-        fitSpline(crease, creaseSpline, creasePoints, false);
+        fitSplineUniform(crease, creaseSpline, creasePoints, false);
         if (!isValid(crease, creaseSpline, 1.25f))
         {
             crease = creaseSpline;
@@ -225,52 +228,127 @@ void EyeModel::estimateIrisLandmarks(cv::Point2f& irisCenter, cv::Point2f& irisI
     }
 }
 
-cv::Mat EyeModel::irisMask(const cv::Size& size, bool removeEyelids) const
+// Interior [x0, x1] of an ellipse along image row y:
+static bool getEllipseSpan(const cv::RotatedRect& e, float y, float& x0, float& x1)
 {
-    cv::Mat1b mask(size, 0);
-    try
+    const float a = e.size.width * 0.5f, b = e.size.height * 0.5f;
+    if ((a <= 0.f) || (b <= 0.f))
     {
-        cv::ellipse(mask, irisEllipse, 255, -1, 4);
+        return false;
     }
-    catch (...)
+
+    // (u/a)^2 + (v/b)^2 <= 1 as a quadratic A*dx^2 + B*dx + C <= 0 in dx = x - cx:
+    const float theta = e.angle * static_cast<float>(CV_PI / 180.0), c = std::cos(theta), s = std::sin(theta);
+    const float ia = 1.f / (a * a), ib = 1.f / (b * b), dy = y - e.center.y;
+    const float A = c * c * ia + s * s * ib;
+    const float B = 2.f * dy * s * c * (ia - ib);
+    const float C = dy * dy * (s * s * ia + c * c * ib) - 1.f;
+    const float disc = B * B - 4.f * A * C;
+    if (disc < 0.f)
     {
+        return false;
     }
-    if (removeEyelids)
+
+    const float root = std::sqrt(disc);
+    x0 = e.center.x + (-B - root) / (2.f * A);
+    x1 = e.center.x + (-B + root) / (2.f * A);
+    return true;
+}
+
+// Sorted (even-odd) polygon crossings along image row y:
+static void getPolygonCrossings(const PointVec& polygon, float y, std::vector<float>& xs)
+{
+    xs.clear();
+    for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
     {
-        mask &= this->mask(size, false);
+        const cv::Point2f &p = polygon[j], &q = polygon[i];
+        if ((p.y <= y) != (q.y <= y))
+        {
+            xs.push_back(p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y));
+        }
     }
-    return mask;
+    std::sort(xs.begin(), xs.end());
 }
 
-cv::Mat EyeModel::labels(const cv::Size& size, std::uint8_t pupil, std::uint8_t iris, std::uint8_t sclera, int border) const
+void EyeModel::rasterize(cv::Mat1b& dst, const cv::Rect& roi, std::uint8_t pupil, std::uint8_t iris, std::uint8_t sclera, bool clipToEyelids, float irisScale) const
 {
-    if (size.area() == 0)
+    dst.create(roi.size());
+    if (roi.area() == 0)
     {
-        return cv::Mat1b();
+        return;
     }
 
     const auto& curve = eyelidsSpline.size() ? eyelidsSpline : eyelids;
 
-    // Eye mask:
-    cv::Mat1b eyeMask = cv::Mat1b::zeros(size);
-    fillPolly(eyeMask, curve, 255);
+    cv::RotatedRect irisRegion = irisEllipse;
+    irisRegion.size = irisRegion.size * irisScale;
 
-    // Iris mask:
-    cv::Mat1b irisMask = cv::Mat1b::zeros(size);
-    cv::ellipse(irisMask, irisEllipse, 255, -1);
+    // Pixel span [x0, x1] in roi coordinates, empty when x0 > x1:
+    const float xMin = static_cast<float>(roi.x), xMax = static_cast<float>(roi.x + roi.width - 1);
+    auto fill = [&](std::uint8_t* row, float x0, float x1, std::uint8_t value) {
+        const float a = std::max(std::ceil(x0), xMin), b = std::min(std::floor(x1), xMax);
+        if (a <= b)
+        {
+            std::fill(row + static_cast<int>(a - xMin), row + static_cast<int>(b - xMin) + 1, value);
+        }
+    };
+
+    std::vector<float> regions;
+    regions.reserve(8);
+    for (int y = 0; y < roi.height; y++)
+    {
+        auto* row = dst.ptr<std::uint8_t>(y);
+        std::fill(row, row + roi.width, 0);
 
-    // Pupil mask:
-    cv::Mat1b pupilMask = cv::Mat1b::zeros(size);
-    cv::ellipse(pupilMask, pupilEllipse, 255, -1);
+        const float yi = static_cast<float>(y + roi.y);
+        if (clipToEyelids)
+        {
+            if (curve.size() < 3)
+            {
+                continue;
+            }
+            getPolygonCrossings(curve, yi, regions);
+        }
+        else
+        {
+            regions = { xMin, xMax };
+        }
+
+        float i0 = 0.f, i1 = -1.f, p0 = 0.f, p1 = -1.f;
+        getEllipseSpan(irisRegion, yi, i0, i1);
+        if ((pupil != iris) && getEllipseSpan(pupilEllipse, yi, p0, p1))
+        {
+            p0 = std::max(p0, i0);
+            p1 = std::min(p1, i1);
+        }
+
+        for (std::size_t k = 0; (k + 1) < regions.size(); k += 2)
+        {
+            const float a = regions[k], b = regions[k + 1];
+            fill(row, a, b, sclera);
+            fill(row, std::max(a, i0), std::min(b, i1), iris);
+            fill(row, std::max(a, p0), std::min(b, p1), pupil);
+        }
+    }
+}
+
+cv::Mat EyeModel::irisMask(const cv::Size& size, bool removeEyelids) const
+{
+    cv::Mat1b mask;
+    rasterize(mask, { { 0, 0 }, size }, 255, 255, 0, removeEyelids);
+    return mask;
+}
 
-    cv::Mat1b labels = cv::Mat1b::zeros(size);
-    labels.setTo(sclera, eyeMask);
-    labels.setTo(iris, (eyeMask & irisMask));
-    if(pupil != iris)
+cv::Mat EyeModel::labels(const cv::Size& size, std::uint8_t pupil, std::uint8_t iris, std::uint8_t sclera, int border) const
+{
+    if (size.area() == 0)
     {
-        labels.setTo(pupil, (eyeMask & irisMask & pupilMask));
+        return cv::Mat1b();
     }
 
+    cv::Mat1b labels;
+    rasterize(labels, { { 0, 0 }, size }, pupil, iris, sclera);
+
     if(border)
     {
         const auto contours = getContours(true, false, false);
@@ -297,72 +375,112 @@ cv::Mat EyeModel::mask(const cv::Size& size, bool sclera, float irisScale) const
     const auto& curve = eyelidsSpline.size() ? eyelidsSpline : eyelids;
     if (curve.size())
     {
-        mask = cv::Mat1b::zeros(size);
-        fillPolly(mask, curve, 255);
-
-        if (sclera && irisEllipse.size.width)
-        {
-            cv::RotatedRect ellipse = irisEllipse;
-            ellipse.size = ellipse.size * irisScale;
-            try
-            {
-                cv::ellipse(mask, ellipse, 0, -1);
-            }
-            catch (...)
-            {
-            }
-        }
+        // The iris (and pupil) are removed for the sclera mask:
+        const std::uint8_t iris = sclera ? 0 : 255;
+        rasterize(mask, { { 0, 0 }, size }, iris, iris, 255, true, irisScale);
     }
 
     return mask;
 }
 
-std::vector<std::vector<cv::Point2f>> EyeModel::getContours(bool doPupil, bool doCrease, bool doCross) const
+static std::vector<PointVec> createContours(const EyeModel& eye, bool doPupil, bool doCrease, bool doCross)
 {
-    std::vector<std::vector<cv::Point2f>> contours;
+    std::vector<PointVec> contours;
 
-    contours.push_back(eyelidsSpline);
-    contours.back().push_back(eyelids.front()); // closed contour
+    contours.push_back(eye.eyelidsSpline);
+    contours.back().push_back(eye.eyelids.front()); // closed contour
 
-    if (irisEllipse.size.width)
+    if (eye.irisEllipse.size.width)
     {
-        auto segments = ellipseToContours(irisEllipse, eyelidsSpline);
+        auto segments = ellipseToContours(eye.irisEllipse, eye.eyelidsSpline);
         for (auto& s : segments)
         {
             contours.push_back(s);
         }
     }
 
-    if (pupilEllipse.size.width && doPupil)
+    if (eye.pupilEllipse.size.width && doPupil)
     {
-        auto segments = ellipseToContours(pupilEllipse, eyelidsSpline);
+        auto segments = ellipseToContours(eye.pupilEllipse, eye.eyelidsSpline);
         for (auto& s : segments)
         {
             contours.push_back(s);
         }
     }
 
-    if (creaseSpline.size() && doCrease)
+    if (eye.creaseSpline.size() && doCrease)
     {
-        contours.push_back(creaseSpline);
+        contours.push_back(eye.creaseSpline);
     }
 
-    if (irisCenter.has && doPupil && doCross)
+    if (eye.irisCenter.has && doPupil && doCross)
     {
-        std::vector<cv::Point2f> contour{ irisInner, irisCenter, irisOuter };
+        std::vector<cv::Point2f> contour{ eye.irisInner, eye.irisCenter, eye.irisOuter };
         contours.push_back(contour);
 
         // Add a cross hair:
-        cv::Point2f v = (*irisInner) - (*irisOuter);
+        cv::Point2f v = (*eye.irisInner) - (*eye.irisOuter);
         cv::Point2f n(v.y, -v.x);
         float diameter = cv::norm(v);
         n *= (1.0 / diameter);
-        contours.push_back({(*irisCenter) - (n * diameter * 0.25f), (*irisCenter) + (n * diameter * 0.25f)});
+        contours.push_back({(*eye.irisCenter) - (n * diameter * 0.25f), (*eye.irisCenter) + (n * diameter * 0.25f)});
     }
 
     return contours;
 }
 
+struct EyeModelContours
+{
+    struct Key
+    {
+        bool doPupil, doCrease, doCross;
+        PointVec eyelidsSpline;
+        cv::Point2f eyelidsFront;
+        cv::RotatedRect irisEllipse, pupilEllipse;
+        PointVec creaseSpline;
+        core::Field<cv::Point2f> irisCenter, irisInner, irisOuter;
+    };
+
+    Key key;
+    std::vector<PointVec> contours;
+};
+
+static bool isSame(const core::Field<cv::Point2f>& a, const core::Field<cv::Point2f>& b)
+{
+    return (a.has == b.has) && (!a.has || (a.value == b.value));
+}
+
+static bool isSame(const EyeModelContours::Key& a, const EyeModelContours::Key& b)
+{
+    return (a.doPupil == b.doPupil) && (a.doCrease == b.doCrease) && (a.doCross == b.doCross) &&
+        (a.eyelidsFront == b.eyelidsFront) &&
+        (a.irisEllipse == b.irisEllipse) &&
+        (a.pupilEllipse == b.pupilEllipse) &&
+        isSame(a.irisCenter, b.irisCenter) &&
+        isSame(a.irisInner, b.irisInner) &&
+        isSame(a.irisOuter, b.irisOuter) &&
+        (a.eyelidsSpline == b.eyelidsSpline) &&
+        (a.creaseSpline == b.creaseSpline);
+}
+
+std::vector<std::vector<cv::Point2f>> EyeModel::getContours(bool doPupil, bool doCrease, bool doCross) const
+{
+    // Comparing the inputs is cheap relative to the ellipse clipping (ellipseToContours()):
+    EyeModelContours::Key key{ doPupil, doCrease, doCross, eyelidsSpline, eyelids.front(), irisEllipse, pupilEllipse, creaseSpline, irisCenter, irisInner, irisOuter };
+
+    auto cached = std::atomic_load(&memo.contours);
+    if (cached && isSame(cached->key, key))
+    {
+        return cached->contours;
+    }
+
+    auto entry = std::make_shared<EyeModelContours>();
+    entry->contours = createContours(*this, doPupil, doCrease, doCross);
+    entry->key = std::move(key);
+    std::atomic_store(&memo.contours, std::shared_ptr<const EyeModelContours>(entry));
+    return entry->contours;
+}
+
 void EyeModel::flop(int width)
 {
     if (angle.has)
@@ -649,14 +767,6 @@ void read(const cv::FileNode& node, DRISHTI_EYE::EyeModel& x, const DRISHTI_EYE:
 
 // ==========
 
-static void fillPolly(cv::Mat& image, const PointVec& polly, const cv::Scalar& value)
-{
-    std::vector<std::vector<cv::Point>> contours(1);
-    contours[0].resize(polly.size());
-    std::copy(polly.begin(), polly.end(), contours[0].begin());
-    cv::fillPoly(image, contours, 255, 4);
-}
-
 // http://stackoverflow.com/a/23214219
 static int mod(int k, int n)
 {
@@ -18,6 +18,8 @@
 #include "drishti/core/Field.h"
 #include "drishti/geometry/Rectangle.h"
 
+#include <memory>
+
 #define DRISHTI_EYE_CONTOUR_POINTS 64
 #define DRISHTI_EYE_CREASE_POINTS 16
 
@@ -36,6 +38,19 @@ inline float radius(const cv::Vec3f& circle)
 }
 DRISHTI_END_NAMESPACE(circle)
 
+struct EyeModelContours; // see EyeModel::getContours()
+
+// Memo storage for derived EyeModel data: copies start empty, and entries are validated
+// against the current model inputs before use, so direct member mutation is always safe.
+struct EyeModelMemo
+{
+    EyeModelMemo() = default;
+    EyeModelMemo(const EyeModelMemo&) {}
+    EyeModelMemo& operator=(const EyeModelMemo&) { return *this; }
+
+    mutable std::shared_ptr<const EyeModelContours> contours; // atomic access
+};
+
 struct EyeModel
 {
     EyeModel();
@@ -82,7 +97,15 @@ struct EyeModel
     cv::Mat labels(const cv::Size& size, std::uint8_t pupil=127, std::uint8_t iris=127, std::uint8_t sclera=255, int border=0) const;
     cv::Mat irisMask(const cv::Size& size, bool removeEyelids = true) const;
 
-    // Support line drawing/contours (OpenGL friendly)
+    // Single pass scanline rasterization of the eye regions into a caller owned buffer, where
+    // dst(y, x) is the label of pixel (x + roi.x, y + roi.y) and dst is (re)allocated only when
+    // its size doesn't match roi.  Regions are computed analytically per row from the eyelid
+    // polygon (spline if present) and the (scaled) iris and pupil ellipses: 0 outside the eyelids,
+    // then sclera, iris and pupil.  The eyelid region is the whole roi when clipToEyelids is false.
+    void rasterize(cv::Mat1b& dst, const cv::Rect& roi, std::uint8_t pupil, std::uint8_t iris, std::uint8_t sclera, bool clipToEyelids = true, float irisScale = 1.f) const;
+
+    // Support line drawing/contours (OpenGL friendly), memoized until one of the inputs
+    // (eyelidsSpline, ellipses, creaseSpline, iris landmarks or the flags) changes:
     std::vector<std::vector<cv::Point2f>> getContours(bool doPupil = true, bool doCrease = true, bool doCross = true) const;
 
     static void normalizeEllipse(cv::RotatedRect& e);
@@ -153,6 +176,8 @@ struct EyeModel
     core::Field<cv::Point2f> irisCenter;
     core::Field<cv::Point2f> irisInner;
     core::Field<cv::Point2f> irisOuter;
+
+    EyeModelMemo memo; // not serialized
 };
 
 inline std::vector<std::vector<cv::Point2f>*> getEyeModelContours(EyeModel& dst)
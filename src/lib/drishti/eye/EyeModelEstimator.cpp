@@ -16,11 +16,14 @@
 
 #include "drishti/core/drishti_stdlib_string.h" // FIRST
 #include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/Arena.h"
+#include "drishti/core/LazyChannelImage.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
 #include "drishti/rcpr/CPR.h"
 
 #include <fstream>
+#include <limits>
 
 #define DRISHTI_EYE_USE_DARK_CHANNEL 0
 
@@ -29,7 +32,7 @@ DRISHTI_EYE_NAMESPACE_BEGIN
 #if DRISHTI_EYE_USE_DARK_CHANNEL
 static cv::Mat getDarkChannel(const cv::Mat& I);
 #endif
-static float resizeEye(const cv::Mat& src, cv::Mat& dst, float width);
+static float getEyeScale(const cv::Mat& src, float width, float tolerance);
 
 EyeModelEstimator::Impl::Impl()
 {
@@ -70,6 +73,32 @@ void EyeModelEstimator::Impl::init()
     m_eyeSpec = EyeModelSpecification::create(16, 9, true, true, true, true, true);
 }
 
+std::unique_ptr<EyeModelEstimator::Impl> EyeModelEstimator::Impl::clone() const
+{
+    auto impl = drishti::core::make_unique<Impl>();
+
+    impl->m_eyeSpec = m_eyeSpec;
+    impl->m_jitterIrisParams = m_jitterIrisParams;
+    impl->m_jitterEyelidParams = m_jitterEyelidParams;
+    impl->m_optimizationLevel = m_optimizationLevel;
+    impl->m_doVerbose = m_doVerbose;
+    impl->m_doMask = m_doMask;
+    impl->m_options = m_options;
+    impl->m_streamLogger = m_streamLogger;
+
+    using ShapeEstimatorPtr = std::unique_ptr<ml::ShapeEstimator>;
+    auto share = [](const ShapeEstimatorPtr& src, ShapeEstimatorPtr& dst) {
+        return !src || (dst = src->clone());
+    };
+
+    if (!share(m_eyeEstimator, impl->m_eyeEstimator) || !share(m_irisEstimator, impl->m_irisEstimator) || !share(m_pupilEstimator, impl->m_pupilEstimator))
+    {
+        return nullptr;
+    }
+
+    return impl;
+}
+
 void EyeModelEstimator::Impl::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
 {
     m_streamLogger = logger;
@@ -82,43 +111,131 @@ void EyeModelEstimator::Impl::setStreamLogger(std::shared_ptr<spdlog::logger>& l
 
 // Input: grayscale for contour regression
 // Red channel is closest to NIR for iris
-// TODO: Need a lazy image conversion type
+// Channels are rendered on first use (squinting eyes only need blue)
 
-int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) const
+bool EyeModelEstimator::Impl::isMirrorable() const
 {
-    cv::Mat I;
-    float scale = resizeEye(crop, I, m_targetWidth), scaleInv = (1.0 / scale);
+    auto isMirrorable = [](const std::unique_ptr<ml::ShapeEstimator>& estimator) {
+        return !estimator || estimator->isMirrorable();
+    };
+    return m_eyeEstimator && isMirrorable(m_eyeEstimator) && isMirrorable(m_irisEstimator) && isMirrorable(m_pupilEstimator);
+}
 
-    cv::Mat Ic[3]{ I }, dark, blue, red;
-    if (I.channels() == 3)
+int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye, const Options& options) const
+{
+    return estimate(crop, eye, options, nullptr);
+}
+
+int EyeModelEstimator::Impl::track(const cv::Mat& crop, const EyeModel& previous, EyeModel& eye, const Options& options) const
+{
+    const bool isValid = !previous.eyelids.empty() && (previous.irisEllipse.size.area() > 0.f);
+    return estimate(crop, eye, options, isValid ? &previous : nullptr);
+}
+
+ml::ShapeEstimator::Options EyeModelEstimator::Impl::getEyelidOptions(const Options& options)
+{
+    ml::ShapeEstimator::Options eyelidOptions;
+    eyelidOptions.mirrored = options.mirrored;
+    eyelidOptions.stages = options.eyelidStages;
+    return eyelidOptions;
+}
+
+ml::ShapeEstimator::Options EyeModelEstimator::Impl::getIrisOptions(const Options& options, bool isPupil)
+{
+    ml::ShapeEstimator::Options irisOptions;
+    irisOptions.mirrored = options.mirrored;
+    irisOptions.stages = isPupil ? -1 : options.irisStages; // the stage hint is iris only
+    irisOptions.convergenceEpsilon = options.irisConvergenceEpsilon;
+    irisOptions.convergenceStages = options.irisConvergenceStages;
+    return irisOptions;
+}
+
+// Mean eyelid point distance, or infinity if the contours don't correspond:
+static float getEyelidResidual(const EyeModel& a, const EyeModel& b)
+{
+    if (a.eyelids.empty() || (a.eyelids.size() != b.eyelids.size()))
     {
-        cv::split(I, Ic);
+        return std::numeric_limits<float>::infinity();
+    }
 
-#if DRISHTI_EYE_USE_DARK_CHANNEL
-        // Dark channel:
-        dark = getDarkChannel(I);
-#endif
-        blue = Ic[0];
-        red = Ic[2];
+    float residual = 0.f;
+    for (int i = 0; i < a.eyelids.size(); i++)
+    {
+        residual += static_cast<float>(cv::norm(a.eyelids[i] - b.eyelids[i]));
     }
-    else
+    return residual / static_cast<float>(a.eyelids.size());
+}
+
+int EyeModelEstimator::Impl::estimate(const cv::Mat& crop, EyeModel& eye, const Options& options, const EyeModel* prior) const
+{
+    const bool mirrored = options.mirrored;
+    if (mirrored && !isMirrorable())
     {
-        //dark = I;
-        blue = red = I;
+        cv::Mat flipped = core::arenaMat();
+        cv::flip(crop, flipped, 1);
+
+        EyeModel flippedPrior;
+        if (prior)
+        {
+            flippedPrior = *prior;
+            flippedPrior.flop(flipped.cols);
+        }
+
+        Options unmirrored = options;
+        unmirrored.mirrored = false;
+        int status = estimate(flipped, eye, unmirrored, prior ? &flippedPrior : nullptr);
+        eye.flop(flipped.cols);
+        return status;
+    }
+
+    float scale = getEyeScale(crop, options.targetWidth, options.targetTolerance), scaleInv = (1.0 / scale);
+    core::LazyChannelImage I(crop, scale, cv::INTER_CUBIC);
+
+    // Map the previous model to the working (flipped and scaled) coordinate system:
+    EyeModel warm;
+    if (prior)
+    {
+        warm = *prior;
+        if (mirrored)
+        {
+            warm.flop(crop.cols);
+        }
+        if (scale != 1.0f)
+        {
+            warm = warm * scale;
+        }
+        prior = &warm;
     }
 
+    const int blue = 0, red = 2; // single channel images return I for any index
+
+#if DRISHTI_EYE_USE_DARK_CHANNEL
+    // Dark channel:
+    auto dark = [&]() -> const cv::Mat& { return (I.channels() == 3) ? I.derived(0, getDarkChannel) : I.image(); };
+#endif
+
     // ######## Find the eyelids #########
-    segmentEyelids(blue, eye);
+    segmentEyelids(I.channel(blue), eye, options, prior);
 
-    if (m_doIndependentIrisAndPupil)
+    if (prior)
+    {
+        // Closing or drifting eyes are segmented from scratch:
+        const float residual = getEyelidResidual(eye, *prior) / static_cast<float>(I.image().cols);
+        if (!(residual < options.warmStartResidual) || !(eye.openness() > options.opennessThreshold))
+        {
+            return estimate(crop, eye, options, nullptr);
+        }
+    }
+
+    if (options.doIndependentIrisAndPupil)
     {
         float openness = 0.f;
-        if ((openness = eye.openness()) > m_opennessThrehsold)
+        if ((openness = eye.openness()) > options.opennessThreshold)
         {
             // ((((( Do iris estimate )))))
             if (m_irisEstimator)
             {
-                segmentIris(red, eye);
+                segmentIris(I.channel(red), eye, options, prior);
 
                 {
                     // If point-wise estimates match the iris regressor, then update our landmarks
@@ -133,9 +250,9 @@ int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) cons
                 eye.pupil = 0.f;
                 eye.pupilEllipse.center = eye.irisEllipse.center;
 
-                if (m_pupilEstimator && m_doPupil && eye.irisEllipse.size.area() > 0.f)
+                if (m_pupilEstimator && options.doPupil && eye.irisEllipse.size.area() > 0.f)
                 {
-                    segmentPupil(red, eye);
+                    segmentPupil(I.channel(red), eye, 128, options, prior);
                 }
             }
         }
@@ -153,7 +270,13 @@ int EyeModelEstimator::Impl::operator()(const cv::Mat& crop, EyeModel& eye) cons
         eye = eye * scaleInv;
     }
 
-    return 0;
+    // Map the model from the flipped (right eye) coordinate system back to the crop:
+    if (mirrored)
+    {
+        eye.flop(crop.cols);
+    }
+
+    return prior ? 1 : 0;
 }
 
 EyeModelEstimator::EyeModelEstimator()
@@ -181,6 +304,21 @@ void EyeModelEstimator::setDoIndependentIrisAndPupil(bool flag)
     m_impl->setDoIndependentIrisAndPupil(flag);
 }
 
+std::unique_ptr<EyeModelEstimator> EyeModelEstimator::clone() const
+{
+    std::unique_ptr<EyeModelEstimator> estimator;
+    if (m_impl)
+    {
+        if (auto impl = m_impl->clone())
+        {
+            estimator = drishti::core::make_unique<EyeModelEstimator>();
+            estimator->m_impl = std::move(impl);
+            estimator->m_streamLogger = m_streamLogger;
+        }
+    }
+    return estimator;
+}
+
 bool EyeModelEstimator::good() const
 {
     return static_cast<bool>(m_impl.get());
@@ -200,9 +338,56 @@ void EyeModelEstimator::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
     }
 }
 
+EyeModelEstimator::Options EyeModelEstimator::getOptions() const
+{
+    return m_impl->getOptions();
+}
+
+int EyeModelEstimator::operator()(const cv::Mat& crop, EyeModel& eye, const Options& options) const
+{
+    return (*m_impl)(crop, eye, options);
+}
+
+int EyeModelEstimator::track(const cv::Mat& crop, const EyeModel& previous, EyeModel& eye, const Options& options) const
+{
+    return m_impl->track(crop, previous, eye, options);
+}
+
 int EyeModelEstimator::operator()(const cv::Mat& crop, EyeModel& eye) const
 {
-    return (*m_impl)(crop, eye);
+    return (*m_impl)(crop, eye, m_impl->getOptions());
+}
+
+int EyeModelEstimator::operator()(const cv::Mat& crop, EyeModel& eye, bool mirrored) const
+{
+    Options options = m_impl->getOptions();
+    options.mirrored = mirrored;
+    return (*m_impl)(crop, eye, options);
+}
+
+int EyeModelEstimator::track(const cv::Mat& crop, const EyeModel& previous, EyeModel& eye, bool mirrored) const
+{
+    Options options = m_impl->getOptions();
+    options.mirrored = mirrored;
+    return m_impl->track(crop, previous, eye, options);
+}
+
+void EyeModelEstimator::setWarmStartStage(int stage)
+{
+    m_impl->setWarmStartStage(stage);
+}
+int EyeModelEstimator::getWarmStartStage() const
+{
+    return m_impl->getWarmStartStage();
+}
+
+void EyeModelEstimator::setWarmStartResidual(float residual)
+{
+    m_impl->setWarmStartResidual(residual);
+}
+float EyeModelEstimator::getWarmStartResidual() const
+{
+    return m_impl->getWarmStartResidual();
 }
 
 void EyeModelEstimator::normalize(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding) const
@@ -220,6 +405,16 @@ int EyeModelEstimator::getEyelidInits() const
     return m_impl->getEyelidInits();
 }
 
+void EyeModelEstimator::setEyelidPruneStage(int stage)
+{
+    m_impl->setEyelidPruneStage(stage);
+}
+
+int EyeModelEstimator::getEyelidPruneStage() const
+{
+    return m_impl->getEyelidPruneStage();
+}
+
 void EyeModelEstimator::setIrisInits(int n)
 {
     m_impl->setIrisInits(n);
@@ -257,6 +452,14 @@ bool EyeModelEstimator::getDoPupil() const
 {
     return m_impl->getDoPupil();
 }
+void EyeModelEstimator::setDoCoarseToFinePupil(bool flag)
+{
+    m_impl->setDoCoarseToFinePupil(flag);
+}
+bool EyeModelEstimator::getDoCoarseToFinePupil() const
+{
+    return m_impl->getDoCoarseToFinePupil();
+}
 
 void EyeModelEstimator::setDoVerbose(bool flag)
 {
@@ -313,19 +516,18 @@ int EyeModelEstimator::getIrisStagesHint() const
     return m_impl->getIrisStagesHint();
 }
 
-static float resizeEye(const cv::Mat& src, cv::Mat& dst, float width)
+void EyeModelEstimator::setIrisConvergenceHint(float epsilon, int stages)
 {
-    float scale = 1.f;
-    if (src.cols < width)
-    {
-        dst = src;
-    }
-    else
-    {
-        scale = float(width) / float(src.cols);
-        cv::resize(src, dst, {}, scale, scale, cv::INTER_CUBIC);
-    }
-    return scale;
+    m_impl->setIrisConvergenceHint(epsilon, stages);
+}
+float EyeModelEstimator::getIrisConvergenceEpsilon() const
+{
+    return m_impl->getIrisConvergenceEpsilon();
+}
+
+static float getEyeScale(const cv::Mat& src, float width, float tolerance)
+{
+    return (src.cols <= (width * (1.f + tolerance))) ? 1.f : (float(width) / float(src.cols));
 }
 
 #if DRISHTI_EYE_USE_DARK_CHANNEL
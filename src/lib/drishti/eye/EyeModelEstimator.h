@@ -48,10 +48,65 @@ public:
     bool good() const;
     operator bool() const;
 
+    // New estimator sharing the (read only) regressors with a copy of the current settings,
+    // or nullptr if one of the regressors can't be shared:
+    std::unique_ptr<EyeModelEstimator> clone() const;
+
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger);
 
+    // Per call settings, the setters below update the instance defaults (see getOptions()).
+    // Evaluation only reads the estimator and its regressors, so one instance can serve
+    // concurrent calls with different options, e.g., both eyes of a face:
+    struct Options
+    {
+        bool mirrored = false; // see operator()(crop, eye, mirrored)
+        int targetWidth = 256;
+        float targetTolerance = 0.f; // crops up to (1 + targetTolerance) * targetWidth are used as is
+
+        int eyelidInits = 1;
+        int eyelidPruneStage = 0;
+        int eyelidStages = -1; // (< 0 == setEyelidStagesHint())
+
+        int irisInits = 1;
+        int irisStages = -1;                 // (< 0 == setIrisStagesHint())
+        float irisConvergenceEpsilon = -1.f; // iris and pupil (< 0 == setIrisConvergenceHint())
+        int irisConvergenceStages = -1;
+        bool useHierarchy = true;
+
+        bool doPupil = true;
+        bool doCoarseToFinePupil = true;
+        bool doIndependentIrisAndPupil = true;
+        float opennessThreshold = 0.1f;
+
+        int warmStartStage = 4;
+        float warmStartResidual = 0.05f;
+    };
+
+    // Copy of the instance defaults:
+    Options getOptions() const;
+
+    int operator()(const cv::Mat& crop, EyeModel& eye, const Options& options) const;
+    int track(const cv::Mat& crop, const EyeModel& previous, EyeModel& eye, const Options& options) const;
+
     virtual int operator()(const cv::Mat& crop, EyeModel& eye) const;
 
+    // Left eye crops can be passed as is (mirrored == true): the right eye models sample the crop at
+    // mirrored coordinates (no flipped copy) and the model is returned in crop coordinates:
+    int operator()(const cv::Mat& crop, EyeModel& eye, bool mirrored) const;
+
+    // Tracking: every stage is initialized from the previous model (already mapped to this crop by the
+    // caller) and the coarse cascade stages are skipped, with a cold start if the eyelid fit closes or
+    // drifts from the previous model.  Returns 1 for warm starts and 0 for cold starts:
+    int track(const cv::Mat& crop, const EyeModel& previous, EyeModel& eye, bool mirrored = false) const;
+
+    // First cascade stage for warm starts (clamped to the length of each cascade):
+    void setWarmStartStage(int stage);
+    int getWarmStartStage() const;
+
+    // Mean eyelid point distance from the previous model (normalized by crop width) for warm starts:
+    void setWarmStartResidual(float residual);
+    float getWarmStartResidual() const;
+
     void setOpennessThreshold(float threshold);
     float getOpennessThreshold() const;
 
@@ -65,15 +120,27 @@ public:
     void setDoPupil(bool flag);
     bool getDoPupil() const;
 
+    // Pupil scale search: coarse hypotheses refined until consensus (true) or a full sweep (false):
+    void setDoCoarseToFinePupil(bool flag);
+    bool getDoCoarseToFinePupil() const;
+
     void setEyelidStagesHint(int stages);
     int getEyelidStagesHint() const;
 
     void setIrisStagesHint(int stages);
     int getIrisStagesHint() const;
 
+    // Iris and pupil cascades stop early once a stage moves the ellipse less than epsilon for K stages:
+    void setIrisConvergenceHint(float epsilon, int stages);
+    float getIrisConvergenceEpsilon() const;
+
     void setEyelidInits(int n);
     int getEyelidInits() const;
 
+    // Multiple eyelid inits: drop outliers after this many cascade stages (0 == never):
+    void setEyelidPruneStage(int stage);
+    int getEyelidPruneStage() const;
+
     void setIrisInits(int n);
     int getIrisInits() const;
 
@@ -29,8 +29,6 @@ DRISHTI_EYE_NAMESPACE_BEGIN
 
 using EllipseVec = std::vector<cv::RotatedRect>;
 
-#define EYE_OPENNESS_IRIS_THRESHOLD 0.10
-
 using DRISHTI_EYE::operator*;
 
 class EyeModelEstimator::Impl
@@ -51,6 +49,8 @@ public:
 
     void init();
 
+    std::unique_ptr<Impl> clone() const;
+
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger);
 
     void setEyelidStagesHint(int stages)
@@ -69,51 +69,110 @@ public:
     {
         return m_irisEstimator->getStagesHint();
     }
+    void setIrisConvergenceHint(float epsilon, int stages)
+    {
+        m_irisEstimator->setConvergenceHint(epsilon, stages);
+        if (m_pupilEstimator)
+        {
+            m_pupilEstimator->setConvergenceHint(epsilon, stages);
+        }
+    }
+    float getIrisConvergenceEpsilon() const
+    {
+        return m_irisEstimator->getConvergenceEpsilon();
+    }
     void setEyelidInits(int n)
     {
-        m_eyelidInits = n;
+        m_options.eyelidInits = n;
     }
     int getEyelidInits() const
     {
-        return m_eyelidInits;
+        return m_options.eyelidInits;
+    }
+
+    void setEyelidPruneStage(int stage)
+    {
+        m_options.eyelidPruneStage = stage;
+    }
+    int getEyelidPruneStage() const
+    {
+        return m_options.eyelidPruneStage;
     }
 
     void setIrisInits(int n)
     {
-        m_irisInits = n;
+        m_options.irisInits = n;
     }
     int getIrisInits() const
     {
-        return m_irisInits;
+        return m_options.irisInits;
     }
 
     void setTargetWidth(int width)
     {
-        m_targetWidth = width;
+        m_options.targetWidth = width;
     }
 
     void setDoPupil(bool flag)
     {
-        m_doPupil = flag;
+        m_options.doPupil = flag;
     }
     bool getDoPupil() const
     {
-        return m_doPupil;
+        return m_options.doPupil;
+    }
+
+    void setDoCoarseToFinePupil(bool flag)
+    {
+        m_options.doCoarseToFinePupil = flag;
+    }
+    bool getDoCoarseToFinePupil() const
+    {
+        return m_options.doCoarseToFinePupil;
     }
 
     void setOpennessThreshold(float threshold)
     {
-        m_opennessThrehsold = threshold;
+        m_options.opennessThreshold = threshold;
     }
     float getOpennessThreshold() const
     {
-        return m_opennessThrehsold;
+        return m_options.opennessThreshold;
+    }
+
+    void setWarmStartStage(int stage)
+    {
+        m_options.warmStartStage = stage;
+    }
+    int getWarmStartStage() const
+    {
+        return m_options.warmStartStage;
+    }
+
+    void setWarmStartResidual(float residual)
+    {
+        m_options.warmStartResidual = residual;
+    }
+    float getWarmStartResidual() const
+    {
+        return m_options.warmStartResidual;
+    }
+
+    const Options& getOptions() const
+    {
+        return m_options;
     }
 
     // Input: grayscale for contour regression
     // Red channel is closest to NIR for iris
-    // TODO: Need a lazy image conversion type
-    int operator()(const cv::Mat& crop, EyeModel& eye) const;
+    // Channels are rendered on first use (see core::LazyChannelImage)
+    // Mirrored crops (left eyes) are sampled in place and the model is returned in crop coordinates
+    int operator()(const cv::Mat& crop, EyeModel& eye, const Options& options) const;
+
+    // Warm start from the previous model (crop coordinates), returns 1 for warm and 0 for cold starts:
+    int track(const cv::Mat& crop, const EyeModel& previous, EyeModel& eye, const Options& options) const;
+
+    bool isMirrorable() const;
 
     void normalize(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding = 0) const
     {
@@ -163,20 +222,20 @@ public:
 
     bool getUseHierarchy() const
     {
-        return m_useHierarchy;
+        return m_options.useHierarchy;
     }
     void setUseHierarchy(bool flag)
     {
-        m_useHierarchy = flag;
+        m_options.useHierarchy = flag;
     }
 
     bool getDoIndependentIrisAndPupil() const
     {
-        return m_doIndependentIrisAndPupil;
+        return m_options.doIndependentIrisAndPupil;
     }
     void setDoIndependentIrisAndPupil(bool flag)
     {
-        m_doIndependentIrisAndPupil = flag;
+        m_options.doIndependentIrisAndPupil = flag;
     }
 
     void setOptimizationLevel(int level)
@@ -193,11 +252,20 @@ public:
     }
 
 private:
-    cv::RotatedRect estimateCentralIris(const cv::Mat& I, const cv::Mat& M, const EllipseVec& irses) const;
+    // Shared cold (prior == nullptr) and warm start estimation, prior is in crop coordinates:
+    int estimate(const cv::Mat& crop, EyeModel& eye, const Options& options, const EyeModel* prior) const;
+
+    // With options.mirrored == true, I is sampled as if it were flipped and eye is in the flipped coordinate system:
+    cv::RotatedRect estimateCentralIris(const cv::Mat& I, const cv::Mat& M, const EllipseVec& irses, const Options& options) const;
 
-    void segmentPupil(const cv::Mat& I, EyeModel& eye, int targetWidth = 128) const;
-    void segmentIris(const cv::Mat& I, EyeModel& eye) const;
-    void segmentEyelids(const cv::Mat& I, EyeModel& eye) const;
+    // A prior (working coordinates) replaces the jittered inits with a single warm start from options.warmStartStage:
+    void segmentPupil(const cv::Mat& I, EyeModel& eye, int targetWidth, const Options& options, const EyeModel* prior = nullptr) const;
+    void segmentIris(const cv::Mat& I, EyeModel& eye, const Options& options, const EyeModel* prior = nullptr) const;
+    void segmentEyelids(const cv::Mat& I, EyeModel& eye, const Options& options, const EyeModel* prior = nullptr) const;
+
+    // Per call regressor options (the regressors are shared, so nothing is set on them):
+    static ml::ShapeEstimator::Options getEyelidOptions(const Options& options);
+    static ml::ShapeEstimator::Options getIrisOptions(const Options& options, bool isPupil = false);
     void segmentEyelids_(const cv::Mat& I, EyeModel& eye) const; // deprecated (shape based jitter)
     std::vector<std::vector<cv::Point2f>> createInitialEyelidPoses() const;
 
@@ -208,17 +276,10 @@ protected:
     geometry::UniformSimilarityParams m_jitterEyelidParams;
 
     int m_optimizationLevel = 10;
-    int m_targetWidth = 256;
     bool m_doVerbose = false;
-    int m_eyelidInits = 1;
-    int m_irisInits = 1;
-
-    float m_opennessThrehsold = EYE_OPENNESS_IRIS_THRESHOLD;
-
     bool m_doMask = false;
-    bool m_useHierarchy = true;
-    bool m_doPupil = true;
-    bool m_doIndependentIrisAndPupil = true;
+
+    Options m_options; // defaults for calls without options
 
     std::unique_ptr<ml::ShapeEstimator> m_eyeEstimator;
     std::unique_ptr<ml::ShapeEstimator> m_irisEstimator;
@@ -38,24 +38,68 @@ static void drawEyes(const cv::Mat& I, const std::vector<EyeModel>& eyes, const
 static std::vector<EyeModel> shapesToEyes(const std::vector<PointVec>& shapes, const EyeModelSpecification& spec, const cv::Matx33f& S);
 #endif
 
-void EyeModelEstimator::Impl::segmentEyelids(const cv::Mat& I, EyeModel& eye) const
+void EyeModelEstimator::Impl::segmentEyelids(const cv::Mat& I, EyeModel& eye, const Options& options, const EyeModel* prior) const
 {
     PointVec mu = m_eyeEstimator->getMeanShape();
 
     cv::Rect roi({ 0, 0 }, I.size());
     std::vector<cv::Rect> rois = { roi };
-    if (m_eyelidInits > 1)
+    if ((options.eyelidInits > 1) && !prior)
     {
-        jitter(roi, m_jitterEyelidParams, rois, m_eyelidInits - 1);
+        jitter(roi, m_jitterEyelidParams, rois, options.eyelidInits - 1);
     }
 
     std::vector<PointVec> poses(rois.size(), mu);
 
     // Get the basic shape:
     std::vector<bool> mask; // occlusion mask
+    if (prior)
+    {
+        // Warm start: the previous shape (normalized by the roi) skips the coarse stages
+        std::vector<PointVec> pose{ eyeToShape(*prior, m_eyeSpec) };
+        for (auto& p : pose.front())
+        {
+            p = { p.x / float(roi.width), p.y / float(roi.height) };
+        }
+
+        auto eyelidOptions = getEyelidOptions(options);
+        eyelidOptions.first = options.warmStartStage;
+        if (m_eyeEstimator->estimate(I, {}, pose, eyelidOptions) >= 0)
+        {
+            eye = shapeToEye(pose.front(), m_eyeSpec);
+            return;
+        }
+    }
+
+    if (rois.size() > 1)
+    {
+        // The inits advance through the cascade together (one pass over the trees per stage):
+        auto eyelidOptions = getEyelidOptions(options);
+        eyelidOptions.rois = rois;
+        eyelidOptions.pruneStage = options.eyelidPruneStage;
+
+        std::vector<PointVec> batch = poses;
+        if (m_eyeEstimator->estimate(I, {}, batch, eyelidOptions) > 0)
+        {
+            poses.clear();
+            std::copy_if(batch.begin(), batch.end(), std::back_inserter(poses), [](const PointVec& pose) { return !pose.empty(); });
+            eye = shapeToEye(getMedianOfPoses(poses), m_eyeSpec);
+            return;
+        }
+    }
+
+    const auto eyelidOptions = getEyelidOptions(options);
     for (int i = 0; i < rois.size(); i++)
     {
-        (*m_eyeEstimator)(I(rois[i]), poses[i], mask);
+        // The flipped roi is read in place from the mirrored location:
+        const cv::Rect source = options.mirrored ? cv::Rect(I.cols - (rois[i].x + rois[i].width), rois[i].y, rois[i].width, rois[i].height) : rois[i];
+        std::vector<PointVec> pose{ poses[i] };
+        if (m_eyeEstimator->estimate(I(source), {}, pose, eyelidOptions) < 0)
+        {
+            (*m_eyeEstimator)(I(source), pose.front(), mask);
+        }
+        poses[i] = pose.front();
+
         cv::Point2f shift = rois[i].tl();
         for (auto& p : poses[i])
         {
@@ -65,7 +109,7 @@ void EyeModelEstimator::Impl::segmentEyelids(const cv::Mat& I, EyeModel& eye) co
 
     // Get median of poses:
     PointVec pose = (poses.size() > 1) ? getMedianOfPoses(poses) : poses[0];
-    eye = shapeToEye(poses[0], m_eyeSpec);
+    eye = shapeToEye(pose, m_eyeSpec);
 
 #if DRISHTI_EYE_DEBUG_INITS
     drawEyes(I, shapesToEyes(poses, m_eyeSpec, cv::Matx33f::eye()), "poses-out");
@@ -77,15 +121,15 @@ void EyeModelEstimator::Impl::segmentEyelids_(const cv::Mat& I, EyeModel& eye) c
     std::vector<PointVec> poses{ m_eyeEstimator->getMeanShape() };
 
     // Only try multiple inits for non-pca:
-    //const_cast<int&>(m_eyelidInits) = 5;
+    //const_cast<int&>(m_options.eyelidInits) = 5;
 
-    if (m_eyelidInits > 1)
+    if (m_options.eyelidInits > 1)
     {
         auto toShape = [&](const EyeModel& e) {
             return eyeToShape(e, m_eyeSpec);
         };
         std::vector<EyeModel> jittered;
-        jitter(shapeToEye(m_eyeEstimator->getMeanShape(), m_eyeSpec), m_jitterEyelidParams, jittered, m_eyelidInits - 1);
+        jitter(shapeToEye(m_eyeEstimator->getMeanShape(), m_eyeSpec), m_jitterEyelidParams, jittered, m_options.eyelidInits - 1);
         std::transform(jittered.begin(), jittered.end(), std::back_inserter(poses), toShape);
     }
 
@@ -13,6 +13,7 @@
 
 #include "drishti/eye/EyeModelEstimatorImpl.h"
 #include "drishti/rcpr/CPR.h"
+#include "drishti/geometry/EllipseBatch.h"
 #include "drishti/core/drishti_stdlib_string.h" // FIRST
 
 DRISHTI_EYE_NAMESPACE_BEGIN
@@ -31,7 +32,7 @@ static void drawIrisEstimates(const cv::Mat& I, const EllipseVec& irises, const
 
 static void jitter(cv::RNG& rng, const EyeModel& eye, const geometry::UniformSimilarityParams& params, EllipseVec& irises, int n);
 
-void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye) const
+void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye, const Options& options, const EyeModel* prior) const
 {
     // Find transformation mapping mean iris to our image:
     auto cpr = dynamic_cast<drishti::rcpr::CPR*>(m_irisEstimator.get());
@@ -46,32 +47,50 @@ void EyeModelEstimator::Impl::segmentIris(const cv::Mat& I, EyeModel& eye) const
     // Initial iris estimates:
     EllipseVec irises{ { eye.irisEllipse.center, eye.irisEllipse.size, cpr->getPStar().angle } };
 
+    if (prior)
+    {
+        // Warm start: a single hypothesis from the previous iris skips the coarse stages
+        auto irisOptions = getIrisOptions(options);
+        irisOptions.first = options.warmStartStage;
+
+        std::vector<std::vector<cv::Point2f>> points{ geometry::ellipseToPoints(prior->irisEllipse) };
+        if (m_irisEstimator->estimate(I, M, points, irisOptions) >= 0)
+        {
+            eye.iris = 0;
+            eye.irisEllipse = geometry::pointsToEllipse(points.front());
+            return;
+        }
+    }
+
     cv::RNG rng;
-    if (m_irisInits > 1)
+    if (options.irisInits > 1)
     {
-        jitter(rng, eye, m_jitterIrisParams, irises, m_irisInits - 1);
+        jitter(rng, eye, m_jitterIrisParams, irises, options.irisInits - 1);
     }
 
 #if DRISHTI_CPR_DEBUG_PHI_ESTIMATE
     drawIrisEstimates(I, irises, "iris-in");
 #endif
 
-    if (m_useHierarchy && irises.size() > 1)
+    if (options.useHierarchy && irises.size() > 1)
     {
-        eye.irisEllipse = estimateCentralIris(I, M, irises);
+        eye.irisEllipse = estimateCentralIris(I, M, irises, options);
     }
     else
     {
-        std::vector<bool> mask;
-        std::vector<cv::Point2f> points = geometry::ellipseToPoints(irises[0]);
-        (*m_irisEstimator)(I, M, points, mask);
+        std::vector<std::vector<cv::Point2f>> points{ geometry::ellipseToPoints(irises[0]) };
+        if (m_irisEstimator->estimate(I, M, points, getIrisOptions(options)) < 0)
+        {
+            std::vector<bool> mask;
+            (*m_irisEstimator)(I, M, points.front(), mask);
+        }
         eye.iris = 0;
-        eye.irisEllipse = geometry::pointsToEllipse(points);
+        eye.irisEllipse = geometry::pointsToEllipse(points.front());
     }
 }
 
 cv::RotatedRect
-EyeModelEstimator::Impl::estimateCentralIris(const cv::Mat& I, const cv::Mat& M, const EllipseVec& irises) const
+EyeModelEstimator::Impl::estimateCentralIris(const cv::Mat& I, const cv::Mat& M, const EllipseVec& irises, const Options& options) const
 {
 #if DRISHTI_CPR_DEBUG_PHI_ESTIMATE
     EllipseVec estimates;
@@ -79,35 +98,41 @@ EyeModelEstimator::Impl::estimateCentralIris(const cv::Mat& I, const cv::Mat& M,
 
     std::vector<rcpr::Vector1d> params(5, rcpr::Vector1d(irises.size()));
 
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
-        // Find iris:
-        std::vector<bool> mask;
-        std::vector<cv::Point2f> points = geometry::ellipseToPoints(irises[i]);
-        (*m_irisEstimator)(I, M, points, mask);
+    std::vector<std::vector<cv::Point2f>> hypotheses(irises.size());
+    for (int i = 0; i < irises.size(); i++)
+    {
+        hypotheses[i] = geometry::ellipseToPoints(irises[i]);
+    }
+
+    // Find iris (all hypotheses are evaluated in one batch per stage, nothing is set on the shared regressor):
+    if (m_irisEstimator->estimate(I, M, hypotheses, getIrisOptions(options)) < 0)
+    {
+        (*m_irisEstimator)(I, M, hypotheses);
+    }
 
-        rcpr::Vector1d phi = drishti::rcpr::ellipseToPhi(geometry::pointsToEllipse(points));
+    // Convert all hypotheses at once (interleaved phi):
+    geometry::EllipseBatch batch;
+    geometry::pointsToEllipses(hypotheses, batch);
+    std::vector<float> phis(batch.size() * 5);
+    geometry::ellipsesToPhi(batch, phis.data());
+    for (int i = 0; i < irises.size(); i++)
+    {
         for (int j = 0; j < 5; j++)
         {
-            params[j][i] = phi[j];
+            params[j][i] = phis[i * 5 + j];
         }
 
 #if DRISHTI_CPR_DEBUG_PHI_ESTIMATE
-        estimates.push_back(drishti::rcpr::phiToEllipse(phi));
+        estimates.push_back(batch[i]);
 #endif
-    };
-
-    m_irisEstimator->setDoPreview(true);
-
-    // XGBoost is not reentrant:
-    harness({ 0, int(irises.size()) });
-//cv::parallel_for_({0, int(irises.size())}, harness, 2);
+    }
 
 #if DRISHTI_CPR_DEBUG_PHI_ESTIMATE
     drawIrisEstimates(I, estimates, "iris-out");
 #endif
 
     // Find Mean
-    rcpr::Vector1d model(5);
+    rcpr::Phi model;
     for (int i = 0; i < 5; i++)
     {
         model[i] = geometry::median(params[i]);
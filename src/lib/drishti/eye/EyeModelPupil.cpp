@@ -14,13 +14,42 @@
 #include "drishti/eye/EyeModelEstimatorImpl.h"
 
 #include "drishti/rcpr/CPR.h"
+#include "drishti/core/Arena.h"
+
+#include <algorithm>
+#include <numeric>
 
 #define DEBUG_PUPIL 0
 
+// Coarse-to-fine pupil search parameters:
+#define DRISHTI_EYE_PUPIL_COARSE_HYPOTHESES 3
+#define DRISHTI_EYE_PUPIL_REFINE_HYPOTHESES 2
+#define DRISHTI_EYE_PUPIL_CONSENSUS 0.05f // rcpr::poseDistance() tolerance
+
 DRISHTI_EYE_NAMESPACE_BEGIN
 
-void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int targetWidth) const
+// Per parameter median of the estimates:
+static rcpr::Phi median(const std::vector<rcpr::Phi>& phis)
+{
+    rcpr::Phi model;
+    rcpr::Vector1d values(phis.size());
+    for (int i = 0; i < int(model.size()); i++)
+    {
+        for (int j = 0; j < phis.size(); j++)
+        {
+            values[j] = phis[j][i];
+        }
+        auto nth = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), nth, values.end());
+        model[i] = *nth;
+    }
+    return model;
+}
+
+void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int targetWidth, const Options& options, const EyeModel* prior) const
 {
+    const bool mirrored = options.mirrored;
+
     CV_Assert(eye.irisEllipse.size.width > 0);
 
     // Create a tight crop on the iris
@@ -29,28 +58,33 @@ void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int
     const cv::Point2f center = eye.irisEllipse.center;
     const cv::Rect roi(center - (diag * 1.0f), center + (diag * 1.0f));
 
-    cv::Mat crop;
+    cv::Mat crop = core::arenaMat(); // frame temporaries (see core::FrameArena)
     cv::Point2f tl = roi.tl();
-    const cv::Rect overlap = roi & cv::Rect({ 0, 0 }, I.size());
+
+    // The (unflipped) crop of a mirrored image is the mirror of the crop in the flipped image:
+    const cv::Rect source = mirrored ? cv::Rect(I.cols - (roi.x + roi.width), roi.y, roi.width, roi.height) : roi;
+    const cv::Rect overlap = source & cv::Rect({ 0, 0 }, I.size());
 
     if (overlap.area() == 0)
     {
         return;
     }
 
-    if (overlap != roi)
+    if (overlap != source)
     {
-        crop.create(roi.size(), I.type());
+        crop.create(source.size(), I.type());
         crop = cv::Scalar::all(0);
-        I(overlap).copyTo(crop(overlap - roi.tl()));
+        I(overlap).copyTo(crop(overlap - source.tl()));
     }
     else
     {
-        crop = I(roi);
+        crop = I(source);
     }
 
     const float scale = float(targetWidth) / crop.cols;
-    cv::resize(crop, crop, {}, scale, scale, cv::INTER_CUBIC);
+    cv::Mat resized = core::arenaMat();
+    cv::resize(crop, resized, {}, scale, scale, cv::INTER_CUBIC);
+    crop = resized;
 
     // =====================
     // Coarse iris estimate:
@@ -58,44 +92,91 @@ void EyeModelEstimator::Impl::segmentPupil(const cv::Mat& I, EyeModel& eye, int
     std::vector<cv::RotatedRect> pupils;
     const float minScale = radius * 1.f / 4.f;
     const float maxScale = radius * 1.f / 2.f;
-    for (float s = minScale; s <= maxScale; s *= 1.05f) // NOLINT (TODO)
+    if (prior && (prior->pupilEllipse.size.area() > 0.f))
     {
+        // Warm start: a single hypothesis at the previous pupil size (the center init is symmetric)
+        const float s = std::min(std::max(prior->pupilEllipse.size.width, minScale), maxScale);
         pupils.emplace_back(pupil.center, cv::Size2f(s, s) * scale, pupil.angle);
     }
+    else
+    {
+        prior = nullptr;
+        for (float s = minScale; s <= maxScale; s *= 1.05f) // NOLINT (TODO)
+        {
+            pupils.emplace_back(pupil.center, cv::Size2f(s, s) * scale, pupil.angle);
+        }
+    }
 
-    std::vector<rcpr::Vector1d> params(5, rcpr::Vector1d(pupils.size()));
-
-    drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
-        // Find pupil:
-        const auto& e = pupils[i];
+    auto pupilOptions = getIrisOptions(options, true);
+    pupilOptions.first = prior ? options.warmStartStage : 0;
+    pupilOptions.preview = DEBUG_PUPIL;
 
+    // Evaluate the selected scale hypotheses (in one batch per stage) and append the estimates:
+    std::vector<rcpr::Phi> phis;
+    std::vector<std::vector<cv::Point2f>> hypotheses;
+    auto evaluate = [&](const std::vector<int>& indices) {
         // TODO: currently override 2d point interface
-        std::vector<bool> mask;
-        std::vector<cv::Point2f> points = { e.center, { e.size.width, e.size.height } };
-        (*m_pupilEstimator)(crop, points, mask);
+        hypotheses.resize(indices.size());
+        for (int i = 0; i < indices.size(); i++)
+        {
+            const auto& e = pupils[indices[i]];
+            hypotheses[i] = { e.center, { e.size.width, e.size.height } };
+        }
 
-        rcpr::Vector1d phi = drishti::rcpr::ellipseToPhi(geometry::pointsToEllipse(points));
-        for (int j = 0; j < 5; j++)
+        // Find pupil:
+        if (m_pupilEstimator->estimate(crop, cv::Mat(), hypotheses, pupilOptions) < 0)
         {
-            params[j][i] = phi[j];
+            (*m_pupilEstimator)(crop, cv::Mat(), hypotheses);
+        }
+
+        for (const auto& h : hypotheses)
+        {
+            phis.push_back(drishti::rcpr::ellipseToPhi(geometry::pointsToEllipse(h)));
         }
     };
 
-#if DEBUG_PUPIL
-    m_pupilEstimator->setDoPreview(true);
-    harness({ 0, int(pupils.size()) });
-#else
-    m_pupilEstimator->setDoPreview(false);
-    cv::parallel_for_({ 0, int(pupils.size()) }, harness);
-#endif
+    std::vector<int> pending(pupils.size());
+    std::iota(pending.begin(), pending.end(), 0);
 
-    // Find Mean
-    rcpr::Vector1d model(5);
-    for (int i = 0; i < 5; i++)
+    rcpr::Phi model;
+    if (options.doCoarseToFinePupil && (pupils.size() > DRISHTI_EYE_PUPIL_COARSE_HYPOTHESES))
     {
-        auto nth = params[i].begin() + params[i].size() / 2;
-        std::nth_element(params[i].begin(), nth, params[i].end());
-        model[i] = *nth;
+        // Coarse: evenly spaced scales spanning the full range
+        std::vector<int> indices;
+        const int n = int(pupils.size()) - 1;
+        for (int i = 0; i < DRISHTI_EYE_PUPIL_COARSE_HYPOTHESES; i++)
+        {
+            indices.push_back(i * n / (DRISHTI_EYE_PUPIL_COARSE_HYPOTHESES - 1));
+        }
+
+        while (true)
+        {
+            for (const auto& i : indices)
+            {
+                pending.erase(std::find(pending.begin(), pending.end(), i));
+            }
+            evaluate(indices);
+
+            model = median(phis);
+            const bool agree = std::all_of(phis.begin(), phis.end(), [&](const rcpr::Phi& phi) {
+                return rcpr::poseDistance(model, phi) < DRISHTI_EYE_PUPIL_CONSENSUS;
+            });
+            if (agree || pending.empty())
+            {
+                break;
+            }
+
+            // Fine: the unevaluated scales closest to the emerging median size
+            const float width = rcpr::phiToEllipse(model).size.width;
+            auto distance = [&](int i) { return std::abs(pupils[i].size.width - width); };
+            std::sort(pending.begin(), pending.end(), [&](int a, int b) { return distance(a) < distance(b); });
+            indices.assign(pending.begin(), pending.begin() + std::min(int(pending.size()), DRISHTI_EYE_PUPIL_REFINE_HYPOTHESES));
+        }
+    }
+    else
+    {
+        evaluate(pending);
+        model = median(phis);
     }
 
     eye.pupilEllipse = rcpr::phiToEllipse(model);
@@ -0,0 +1,383 @@
+/*! -*-c++-*-
+  @file   IrisCode.cpp
+  @author David Hirvonen
+  @brief  Implementation of binary iris templates and a packed gallery for 1:N matching.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/eye/IrisCode.h"
+#include "drishti/core/arithmetic.h"
+#include "drishti/core/cpu.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/Parallel.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// clang-format off
+#if DRISHTI_CPU_NEON
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+// clang-format on
+
+// clang-format off
+#if defined(__x86_64__) || defined(_M_X64)
+#  include <nmmintrin.h>
+#  define DO_POPCNT 1 // runtime dispatch (see core::hasSimd())
+#endif
+// clang-format on
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+static const int kGalleryBlock = 4096; // templates per parallel job
+
+static int popcount64(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static int popcountScalar(std::uint64_t x)
+{
+    int count = 0;
+    for (; x; x &= (x - 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+#if DO_POPCNT
+DRISHTI_TARGET("popcnt")
+static int hammingDistance_popcnt(const std::uint64_t* codeA, const std::uint64_t* maskA, const std::uint64_t* codeB, const std::uint64_t* maskB, int words, int& bits)
+{
+    int difference = 0;
+    for (int i = 0; i < words; i++)
+    {
+        const std::uint64_t m = maskA[i] & maskB[i];
+        difference += static_cast<int>(_mm_popcnt_u64((codeA[i] ^ codeB[i]) & m));
+        bits += static_cast<int>(_mm_popcnt_u64(m));
+    }
+    return difference;
+}
+#endif
+
+float hammingDistance(const std::uint64_t* codeA, const std::uint64_t* maskA, const std::uint64_t* codeB, const std::uint64_t* maskB, int words, int& bits)
+{
+    int i = 0, difference = 0;
+    bits = 0;
+
+    if (core::getSimdEnabled())
+    {
+#if DO_ARM_NEON
+        if (core::hasSimd(core::kSimdNEON))
+        {
+            uint64x2_t d = vdupq_n_u64(0), n = vdupq_n_u64(0);
+            for (; i <= words - 2; i += 2)
+            {
+                const uint64x2_t m = vandq_u64(vld1q_u64(maskA + i), vld1q_u64(maskB + i));
+                const uint64x2_t x = vandq_u64(veorq_u64(vld1q_u64(codeA + i), vld1q_u64(codeB + i)), m);
+                d = vpadalq_u32(d, vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(x)))));
+                n = vpadalq_u32(n, vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(m)))));
+            }
+            difference = static_cast<int>(vgetq_lane_u64(d, 0) + vgetq_lane_u64(d, 1));
+            bits = static_cast<int>(vgetq_lane_u64(n, 0) + vgetq_lane_u64(n, 1));
+        }
+#elif DO_POPCNT
+        if (core::hasSimd(core::kSimdPOPCNT))
+        {
+            difference = hammingDistance_popcnt(codeA, maskA, codeB, maskB, words, bits);
+            i = words;
+        }
+#endif
+        for (; i < words; i++)
+        {
+            const std::uint64_t m = maskA[i] & maskB[i];
+            difference += popcount64((codeA[i] ^ codeB[i]) & m);
+            bits += popcount64(m);
+        }
+    }
+
+    for (; i < words; i++)
+    {
+        const std::uint64_t m = maskA[i] & maskB[i];
+        difference += popcountScalar((codeA[i] ^ codeB[i]) & m);
+        bits += popcountScalar(m);
+    }
+
+    return bits ? static_cast<float>(difference) / static_cast<float>(bits) : 1.f;
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Quadrature pair along the angular axis, the even filter has zero mean:
+static void createGabor(const IrisCode::Settings& settings, int width, cv::Mat1f& even, cv::Mat1f& odd)
+{
+    const int radius = std::min(static_cast<int>(std::ceil(settings.sigma * 3.f)), width / 2 - 1);
+    const float omega = static_cast<float>(2.0 * CV_PI) / settings.wavelength;
+
+    cv::Mat1f envelope(1, radius * 2 + 1);
+    even.create(1, radius * 2 + 1);
+    odd.create(1, radius * 2 + 1);
+    for (int x = -radius; x <= radius; x++)
+    {
+        envelope(x + radius) = std::exp(-0.5f * float(x * x) / (settings.sigma * settings.sigma));
+        even(x + radius) = envelope(x + radius) * std::cos(omega * float(x));
+        odd(x + radius) = envelope(x + radius) * std::sin(omega * float(x));
+    }
+    even -= envelope * (cv::sum(even)[0] / cv::sum(envelope)[0]);
+}
+
+IrisCode::IrisCode()
+{
+    code.fill(0);
+    mask.fill(0);
+}
+
+IrisCode::IrisCode(const NormalizedIris& iris, const Settings& settings)
+    : IrisCode()
+{
+    const cv::Size size(kAngles * 2, kRadii * 4);
+
+    cv::Mat gray = iris.getImage();
+    switch (gray.channels())
+    {
+        case 3:
+            cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+            break;
+        case 4:
+            cv::cvtColor(gray, gray, cv::COLOR_BGRA2GRAY);
+            break;
+    }
+
+    cv::Mat1f image, valid;
+    gray.convertTo(image, CV_32F, (gray.depth() == CV_8U) ? 1.0 / 255.0 : 1.0);
+    cv::resize(image, image, size, 0, 0, cv::INTER_AREA);
+
+    const cv::Mat irisMask = iris.getMask();
+    if (irisMask.empty())
+    {
+        valid = cv::Mat1f(size, 1.f);
+    }
+    else
+    {
+        cv::Mat(irisMask > 0).convertTo(valid, CV_32F, 1.0 / 255.0);
+        cv::resize(valid, valid, size, 0, 0, cv::INTER_AREA);
+    }
+
+    // Wrap the angular axis, so the response is circular (rotations are exact shifts):
+    cv::Mat1f even, odd, radial = cv::getGaussianKernel(int(std::ceil(settings.radialSigma * 3.f)) * 2 + 1, settings.radialSigma, CV_32F);
+    createGabor(settings, size.width, even, odd);
+
+    const int pad = even.cols / 2;
+    cv::Mat1f padded, re, im;
+    cv::copyMakeBorder(image, padded, 0, 0, pad, pad, cv::BORDER_WRAP);
+    cv::sepFilter2D(padded, re, CV_32F, even, radial, { -1, -1 }, 0.0, cv::BORDER_REFLECT_101);
+    cv::sepFilter2D(padded, im, CV_32F, odd, radial, { -1, -1 }, 0.0, cv::BORDER_REFLECT_101);
+
+    const float minMagnitude2 = settings.minMagnitude * settings.minMagnitude;
+    for (int r = 0; r < kRadii; r++)
+    {
+        const int y = r * 4 + 2;
+        for (int a = 0; a < kAngles; a++)
+        {
+            const int x = a * 2;
+            const float u = re(y, x + pad), v = im(y, x + pad);
+
+            // Fraction of valid pixels in the (2 x 4) cell of this sample:
+            const float coverage = cv::mean(valid({ x, r * 4, 2, 4 }))[0];
+
+            const int bit = a * 2;
+            std::uint64_t& c = code[r * kRowWords + bit / 64];
+            std::uint64_t& m = mask[r * kRowWords + bit / 64];
+            c |= (std::uint64_t(u >= 0.f) << (bit % 64)) | (std::uint64_t(v >= 0.f) << (bit % 64 + 1));
+            if ((coverage >= settings.coverage) && ((u * u + v * v) >= minMagnitude2))
+            {
+                m |= (std::uint64_t(3) << (bit % 64));
+            }
+        }
+    }
+}
+
+int IrisCode::count() const
+{
+    int bits = 0;
+    for (const auto& m : mask)
+    {
+        bits += popcount64(m);
+    }
+    return bits;
+}
+
+// A shift of s samples is a circular left shift of each (kRowWords * 64) bit row by 2 * s bits:
+void IrisCode::rotate(const std::uint64_t* src, std::uint64_t* dst, int shift)
+{
+    const int k = ((shift * 2) % (kRowWords * 64) + (kRowWords * 64)) % (kRowWords * 64);
+    const int ws = k / 64, bs = k % 64;
+    for (int r = 0; r < kRadii; r++)
+    {
+        const std::uint64_t* s = src + r * kRowWords;
+        std::uint64_t* d = dst + r * kRowWords;
+        for (int j = 0; j < kRowWords; j++)
+        {
+            const std::uint64_t hi = s[(j - ws + kRowWords) % kRowWords];
+            const std::uint64_t lo = s[(j - ws - 1 + 2 * kRowWords) % kRowWords];
+            d[j] = bs ? ((hi << bs) | (lo >> (64 - bs))) : hi;
+        }
+    }
+}
+
+IrisCode IrisCode::rotate(int shift) const
+{
+    IrisCode result;
+    rotate(code.data(), result.code.data(), shift);
+    rotate(mask.data(), result.mask.data(), shift);
+    return result;
+}
+
+float IrisCode::distance(const IrisCode& probe, const IrisCode& target, int maxShift, int* shift, int minBits)
+{
+    float best = 1.f;
+    IrisCode rotated;
+    for (int s = -maxShift; s <= maxShift; s++)
+    {
+        int bits = 0;
+        const IrisCode& p = s ? (rotated = probe.rotate(s)) : probe;
+        const float d = hammingDistance(p.code.data(), p.mask.data(), target.code.data(), target.mask.data(), kWords, bits);
+        if ((bits >= minBits) && (d < best))
+        {
+            best = d;
+            if (shift)
+            {
+                *shift = s;
+            }
+        }
+    }
+    return best;
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+void IrisGallery::reserve(std::size_t n)
+{
+    m_words.reserve(n * IrisCode::kWords * 2);
+    m_ids.reserve(n);
+}
+
+void IrisGallery::clear()
+{
+    m_words.clear();
+    m_ids.clear();
+}
+
+int IrisGallery::add(const IrisCode& code, int id)
+{
+    m_words.insert(m_words.end(), code.getCode().begin(), code.getCode().end());
+    m_words.insert(m_words.end(), code.getMask().begin(), code.getMask().end());
+    m_ids.push_back(id);
+    return static_cast<int>(m_ids.size()) - 1;
+}
+
+IrisCode IrisGallery::get(int index) const
+{
+    IrisCode code;
+    const std::uint64_t* words = m_words.data() + std::size_t(index) * IrisCode::kWords * 2;
+    std::copy(words, words + IrisCode::kWords, code.getCode().begin());
+    std::copy(words + IrisCode::kWords, words + IrisCode::kWords * 2, code.getMask().begin());
+    return code;
+}
+
+using Match = IrisGallery::Match;
+
+static bool isBetter(const Match& a, const Match& b)
+{
+    return (a.distance < b.distance) || ((a.distance == b.distance) && (a.index < b.index));
+}
+
+// Insert into a list of at most top matches sorted by distance:
+static void insert(std::vector<Match>& matches, const Match& match, int top)
+{
+    if ((static_cast<int>(matches.size()) < top) || isBetter(match, matches.back()))
+    {
+        matches.insert(std::upper_bound(matches.begin(), matches.end(), match, isBetter), match);
+        if (static_cast<int>(matches.size()) > top)
+        {
+            matches.pop_back();
+        }
+    }
+}
+
+std::vector<Match> IrisGallery::search(const IrisCode& probe, const SearchSettings& settings) const
+{
+    const int count = static_cast<int>(size());
+    const int top = std::max(settings.top, 1);
+    const int shifts = settings.maxShift * 2 + 1;
+
+    // Probe rotations, (code, mask) per shift:
+    std::vector<std::uint64_t> rotations(shifts * IrisCode::kWords * 2);
+    for (int s = 0; s < shifts; s++)
+    {
+        std::uint64_t* words = rotations.data() + s * IrisCode::kWords * 2;
+        IrisCode::rotate(probe.getCode().data(), words, s - settings.maxShift);
+        IrisCode::rotate(probe.getMask().data(), words + IrisCode::kWords, s - settings.maxShift);
+    }
+
+    const int blocks = (count + kGalleryBlock - 1) / kGalleryBlock;
+    std::vector<std::vector<Match>> results(blocks);
+    std::function<void(int)> body = [&](int b) {
+        auto& matches = results[b];
+        for (int i = b * kGalleryBlock, end = std::min(count, (b + 1) * kGalleryBlock); i < end; i++)
+        {
+            const std::uint64_t* target = m_words.data() + std::size_t(i) * IrisCode::kWords * 2;
+
+            Match best;
+            for (int s = 0; s < shifts; s++)
+            {
+                int bits = 0;
+                const std::uint64_t* p = rotations.data() + s * IrisCode::kWords * 2;
+                const float d = hammingDistance(p, p + IrisCode::kWords, target, target + IrisCode::kWords, IrisCode::kWords, bits);
+                if ((bits >= settings.minBits) && (d < best.distance))
+                {
+                    best.distance = d;
+                    best.shift = s - settings.maxShift;
+                }
+            }
+
+            if (best.distance < settings.threshold)
+            {
+                best.index = i;
+                best.id = m_ids[i];
+                insert(matches, best, top);
+            }
+        }
+    };
+
+    core::ParallelSettings parallel;
+    parallel.threads = settings.threads;
+    core::parallelFor({ 0, blocks }, core::ParallelHomogeneousLambda(body), parallel);
+
+    std::vector<Match> matches;
+    for (const auto& block : results)
+    {
+        for (const auto& match : block)
+        {
+            insert(matches, match, top);
+        }
+    }
+    return matches;
+}
+
+DRISHTI_EYE_NAMESPACE_END
@@ -0,0 +1,126 @@
+/*! -*-c++-*-
+  @file   IrisCode.h
+  @author David Hirvonen
+  @brief  Declaration of binary iris templates and a packed gallery for 1:N matching.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  An IrisCode is a fixed size (kRadii x kAngles) grid of 2 bit phase quadrants from an even/odd
+  (quadrature) Gabor filter pair applied along the angular axis of a NormalizedIris, plus a
+  validity mask taken from the NormalizedIris mask (EyeModel::irisMask() warped by the
+  IrisNormalizer) with weak filter responses removed.  Bits are packed in 64 bit words, one
+  row (kAngles samples) per kRowWords words, so a rotation of the eye is a circular shift of
+  each row, and two templates are compared with the masked fractional Hamming distance:
+
+    HD = popcount((codeA ^ codeB) & maskA & maskB) / popcount(maskA & maskB)
+
+  minimized over a range of rotations of the probe.
+
+*/
+
+#ifndef __drishti_eye_IrisCode_h__
+#define __drishti_eye_IrisCode_h__
+
+#include "drishti/eye/drishti_eye.h"
+#include "drishti/eye/NormalizedIris.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+DRISHTI_EYE_NAMESPACE_BEGIN
+
+class IrisCode
+{
+public:
+    static const int kAngles = 128;                // angular samples per row
+    static const int kRadii = 8;                   // radial rows
+    static const int kRowWords = kAngles * 2 / 64; // 2 bits per sample
+    static const int kWords = kRadii * kRowWords;  // 2048 bits
+    static const int kBits = kWords * 64;
+
+    using Words = std::array<std::uint64_t, kWords>;
+
+    struct Settings
+    {
+        float wavelength = 16.f;    // Gabor wavelength in pixels of the (2 * kAngles x 4 * kRadii) working image
+        float sigma = 7.f;          // Gabor envelope (angular)
+        float radialSigma = 1.5f;   // Gaussian smoothing (radial)
+        float coverage = 0.9f;      // minimum fraction of valid mask pixels per sample
+        float minMagnitude = 1e-3f; // responses below this (for a [0,1] image) are masked
+    };
+
+    IrisCode();
+    IrisCode(const NormalizedIris& iris, const Settings& settings = {});
+
+    const Words& getCode() const { return code; }
+    Words& getCode() { return code; }
+    const Words& getMask() const { return mask; }
+    Words& getMask() { return mask; }
+
+    // Number of valid bits:
+    int count() const;
+
+    // Matches the encoding of NormalizedIris::rotate() by shift * width / kAngles columns:
+    IrisCode rotate(int shift) const;
+
+    // Minimum distance over probe.rotate(s) for s in [-maxShift, maxShift] (1 if fewer than minBits are valid):
+    static float distance(const IrisCode& probe, const IrisCode& target, int maxShift = 0, int* shift = nullptr, int minBits = 256);
+
+    // Circular shift of each row of words by shift samples:
+    static void rotate(const std::uint64_t* src, std::uint64_t* dst, int shift);
+
+protected:
+    Words code;
+    Words mask;
+};
+
+// Masked fractional Hamming distance of two packed templates, bits receives popcount(maskA & maskB):
+float hammingDistance(const std::uint64_t* codeA, const std::uint64_t* maskA, const std::uint64_t* codeB, const std::uint64_t* maskB, int words, int& bits);
+
+// Templates are stored back to back as (code, mask) word blocks in one allocation, so a
+// search streams through memory (kWords * 16 bytes per template, 512 MB for 10^6 entries).
+// The probe rotations are computed once per search, and the gallery is split into blocks
+// that are searched in parallel, each keeping its own best matches.
+class IrisGallery
+{
+public:
+    struct Match
+    {
+        int index = -1;       // gallery index
+        int id = -1;          // user id from add()
+        float distance = 1.f; // Hamming distance
+        int shift = 0;        // best probe rotation
+    };
+
+    struct SearchSettings
+    {
+        int maxShift = 8;      // probe rotations in [-maxShift, maxShift]
+        int top = 1;           // number of matches returned
+        int minBits = 256;     // pairs with fewer jointly valid bits are rejected
+        float threshold = 1.f; // only matches with distance < threshold are returned
+        int threads = -1;      // (<= 0 == hardware concurrency)
+    };
+
+    void reserve(std::size_t n);
+    void clear();
+    std::size_t size() const { return m_ids.size(); }
+
+    // Returns the gallery index:
+    int add(const IrisCode& code, int id);
+
+    IrisCode get(int index) const;
+    int getId(int index) const { return m_ids[index]; }
+
+    // Best matches sorted by increasing distance:
+    std::vector<Match> search(const IrisCode& probe, const SearchSettings& settings = {}) const;
+
+protected:
+    std::vector<std::uint64_t> m_words;
+    std::vector<int> m_ids;
+};
+
+DRISHTI_EYE_NAMESPACE_END
+
+#endif // __drishti_eye_IrisCode_h__
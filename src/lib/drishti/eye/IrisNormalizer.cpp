@@ -14,6 +14,8 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 DRISHTI_EYE_NAMESPACE_BEGIN
@@ -99,4 +101,69 @@ void IrisNormalizer::operator()(const cv::Mat& crop, const EyeModel& eye, const
     warpIris(crop, mask, paddedSize, rayPixels, rayTexels, code, padding);
 }
 
+void IrisNormalizer::operator()(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, IrisRayCache& cache, int padding) const
+{
+    cv::Mat mask = eye.irisMask(crop.size());
+
+    auto entry = cache(eye, size, padding); // copy (warpIris() takes mutable rays)
+    warpIris(crop, mask, entry.paddedSize, entry.rayPixels, entry.rayTexels, code, padding);
+}
+
+// ::: IrisRayCache :::
+
+IrisRayCache::IrisRayCache(float quantum, std::size_t capacity)
+    : m_quantum(quantum)
+    , m_capacity(std::max(capacity, std::size_t(1)))
+{
+}
+
+const IrisRayCache::Entry& IrisRayCache::operator()(const EyeModel& eye, const cv::Size& size, int padding)
+{
+    const float quantum = std::max(m_quantum, 1e-3f);
+    const auto quantize = [&](float value) { return static_cast<int>(std::round(value / quantum)); };
+    const auto snap = [&](int value) { return static_cast<float>(value) * quantum; };
+
+    Key key; // [iris: cx, cy, w, h, angle][pupil: ...][width, height | padding]
+    const cv::RotatedRect* ellipses[2] = { &eye.irisEllipse, &eye.pupilEllipse };
+    for (int i = 0; i < 2; i++)
+    {
+        const auto& e = *ellipses[i];
+        key[i * 5 + 0] = quantize(e.center.x);
+        key[i * 5 + 1] = quantize(e.center.y);
+        key[i * 5 + 2] = quantize(e.size.width);
+        key[i * 5 + 3] = quantize(e.size.height);
+        key[i * 5 + 4] = quantize(e.angle);
+    }
+    key[10] = size.width;
+    key[11] = (size.height << 8) | (padding & 0xff);
+
+    auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& entry) { return entry.key == key; });
+    if (iter != m_entries.end())
+    {
+        std::rotate(m_entries.begin(), iter, iter + 1); // move to front
+        return m_entries.front();
+    }
+
+    // Compute rays for the quantized ellipses:
+    EyeModel snapped;
+    cv::RotatedRect* outputs[2] = { &snapped.irisEllipse, &snapped.pupilEllipse };
+    for (int i = 0; i < 2; i++)
+    {
+        *outputs[i] = cv::RotatedRect({ snap(key[i * 5 + 0]), snap(key[i * 5 + 1]) }, { snap(key[i * 5 + 2]), snap(key[i * 5 + 3]) }, snap(key[i * 5 + 4]));
+    }
+
+    if (m_entries.size() >= m_capacity)
+    {
+        m_entries.pop_back();
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.paddedSize = IrisNormalizer().createRays(snapped, size, entry.rayPixels, entry.rayTexels, padding);
+    m_entries.insert(m_entries.begin(), std::move(entry));
+    m_misses++;
+
+    return m_entries.front();
+}
+
 DRISHTI_EYE_NAMESPACE_END
@@ -21,6 +21,8 @@
 
 DRISHTI_EYE_NAMESPACE_BEGIN
 
+class IrisRayCache;
+
 class IrisNormalizer
 {
 public:
@@ -33,7 +35,43 @@ public:
     void warpIris(const cv::Mat& crop, const cv::Mat1b& mask, const cv::Size& paddedSize, Rays& rayPixels, Rays& rayTexels, NormalizedIris& code, int padding = 0) const;
     void operator()(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, int padding = 0) const;
 
+    // Same as above with rays from (and added to) the cache:
+    void operator()(const cv::Mat& crop, const EyeModel& eye, const cv::Size& size, NormalizedIris& code, IrisRayCache& cache, int padding = 0) const;
+
+protected:
+};
+
+// Small LRU cache of ellipso-polar rays keyed by quantized iris and pupil ellipses, so that rays
+// are only rebuilt when an ellipse moves by more than the quantum.  Rays are always computed from
+// the quantized ellipses, so the result doesn't depend on the cache state.  The GPU warp
+// (EllipsoPolarWarp) and the CPU warp (IrisNormalizer) share this sampling.  Not thread safe.
+class IrisRayCache
+{
+public:
+    using Key = std::array<int, 12>;
+
+    struct Entry
+    {
+        Key key;
+        cv::Size paddedSize;
+        IrisNormalizer::Rays rayPixels;
+        IrisNormalizer::Rays rayTexels;
+    };
+
+    // quantum: ellipse center/size quantization in pixels (angles in degrees)
+    IrisRayCache(float quantum = 0.25f, std::size_t capacity = 4);
+
+    const Entry& operator()(const EyeModel& eye, const cv::Size& size, int padding = 0);
+
+    std::size_t size() const { return m_entries.size(); }
+    std::size_t misses() const { return m_misses; }
+    void clear() { m_entries.clear(); }
+
 protected:
+    float m_quantum = 0.25f;
+    std::size_t m_capacity = 4;
+    std::size_t m_misses = 0;
+    std::vector<Entry> m_entries; // most recent first
 };
 
 DRISHTI_EYE_NAMESPACE_END
@@ -22,22 +22,42 @@ BEGIN_OGLES_GPGPU
  * Input eye models shall be in pixel coordinates associated with the input texture/FBO
  */
 
+// Eye models are normalized to texture coordinates [0..1] (see EyeFilter), so the quantum is
+// in texture units:
 EllipsoPolarWarp::EllipsoPolarWarp()
-= default;
+    : m_rays(1.f / 1024.f, 4)
+{
+}
 
 void EllipsoPolarWarp::renderIris(const DRISHTI_EYE::EyeModel& eye)
 {
     m_eye = m_eyeDelegate(); // get updated eye models:
 
-    DRISHTI_EYE::IrisNormalizer::Rays rayPixels, rayTexels;
-    DRISHTI_EYE::IrisNormalizer normalizer;
-
     // The ogles_gpgpu filter size is used to define the normalized iris dimensions:
     ogles_gpgpu::Size2d size(getOutFrameW(), getOutFrameH());
 
-    // We can use the provided rays as a GL_TRIANGLE_STRIP
-    normalizer.createRays(eye, { size.width, size.height }, rayPixels, rayTexels, 0);
+    // We can use the provided rays as a GL_TRIANGLE_STRIP (rebuilt only when the eye moves):
+    const auto& entry = m_rays(eye, { size.width, size.height }, 0);
+    if (!m_hasMesh || (entry.key != m_meshKey))
+    {
+        updateMesh(entry.rayPixels, entry.rayTexels);
+        m_meshKey = entry.key;
+        m_hasMesh = true;
+    }
+
+    // ====================================
+    // === virtual API rendering calls ====
+    // ====================================
+
+    filterRenderSetCoords();
+    Tools::checkGLErr(getProcName(), "render set coords");
 
+    filterRenderDraw();
+    Tools::checkGLErr(getProcName(), "render draw");
+}
+
+void EllipsoPolarWarp::updateMesh(const DRISHTI_EYE::IrisNormalizer::Rays& rayPixels, const DRISHTI_EYE::IrisNormalizer::Rays& rayTexels)
+{
     m_texels.resize(rayTexels.size() * 2);
     m_pixels.resize(rayPixels.size() * 2);
 
@@ -53,16 +73,6 @@ void EllipsoPolarWarp::renderIris(const DRISHTI_EYE::EyeModel& eye)
             m_texel = { q.x, q.y };
         }
     }
-
-    // ====================================
-    // === virtual API rendering calls ====
-    // ====================================
-
-    filterRenderSetCoords();
-    Tools::checkGLErr(getProcName(), "render set coords");
-
-    filterRenderDraw();
-    Tools::checkGLErr(getProcName(), "render draw");
 }
 
 void EllipsoPolarWarp::renderIrises()
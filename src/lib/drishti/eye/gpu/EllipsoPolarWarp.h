@@ -13,6 +13,7 @@
 
 #include "drishti/eye/gpu/TriangleStripWarp.h"
 #include "drishti/eye/gpu/EyeWarp.h"
+#include "drishti/eye/IrisNormalizer.h"
 
 #include <opencv2/core.hpp>
 #include <utility>
@@ -40,9 +41,13 @@ public:
 protected:
     void renderIrises();
     void renderIris(const DRISHTI_EYE::EyeModel& eye);
+    void updateMesh(const DRISHTI_EYE::IrisNormalizer::Rays& rayPixels, const DRISHTI_EYE::IrisNormalizer::Rays& rayTexels);
 
     EyeDelegate m_eyeDelegate;
     drishti::eye::EyeWarp m_eye;
+    drishti::eye::IrisRayCache m_rays; // rays for recent (quantized) eye models
+    drishti::eye::IrisRayCache::Key m_meshKey{};
+    bool m_hasMesh = false;
 };
 
 END_OGLES_GPGPU
@@ -20,6 +20,7 @@ sugar_files(DRISHTI_EYE_SRCS
   EyeModelEyelids.cpp
   EyeModelIris.cpp
   EyeModelPupil.cpp
+  IrisCode.cpp
   IrisNormalizer.cpp
   NormalizedIris.cpp
   )
@@ -30,6 +31,7 @@ sugar_files(DRISHTI_EYE_HDRS_PUBLIC
   EyeImpl.h
   EyeModelEstimator.h
   EyeModelEstimatorImpl.h
+  IrisCode.h
   IrisNormalizer.h
   NormalizedIris.h
   drishti_eye.h
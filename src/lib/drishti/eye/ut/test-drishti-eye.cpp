@@ -9,6 +9,9 @@
 */
 
 #include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/eye/IrisCode.h"
+#include "drishti/eye/IrisNormalizer.h"
+#include "drishti/core/arithmetic.h"
 #include "drishti/core/drishti_stdlib_string.h"
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
@@ -28,6 +31,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iomanip>
+#include <thread>
 
 // https://code.google.com/p/googletest/wiki/Primer
 
@@ -283,6 +287,60 @@ TEST_F(EyeModelEstimatorTest, ImageValid) // NOLINT (TODO)
     }
 }
 
+TEST_F(EyeModelEstimatorTest, ImageValidWithConvergence) // NOLINT (TODO)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    // Early exit iris/pupil cascades should preserve ground truth accuracy:
+    m_eyeSegmenter->setIrisConvergenceHint(0.005f, 2);
+    for (auto iter = m_images.lower_bound(128); iter != m_images.end(); iter++)
+    {
+        drishti::eye::EyeModel eye;
+        int code = (*m_eyeSegmenter)(iter->second.image, eye);
+        EXPECT_EQ(code, 0);
+
+        eye.refine();
+        checkValid(eye, iter->second.image.size());
+
+        const float scaleGroundTruthToCurrent = static_cast<float>(iter->second.image.cols) / static_cast<float>(m_targetWidth);
+        const float score = detectionScore(*m_eye, eye, iter->second.image.size(), scaleGroundTruthToCurrent);
+        ASSERT_GT(score, m_scoreThreshold);
+    }
+    m_eyeSegmenter->setIrisConvergenceHint(0.f, 2);
+}
+
+// Accuracy parity of the coarse-to-fine pupil search vs the full scale sweep:
+TEST_F(EyeModelEstimatorTest, PupilCoarseToFineParity) // NOLINT (TODO)
+{
+    if (!m_eye || !m_eyeSegmenter || !m_eyeSegmenter->getDoPupil())
+    {
+        return;
+    }
+
+    for (auto iter = m_images.lower_bound(128); iter != m_images.end(); iter++)
+    {
+        drishti::eye::EyeModel eyes[2];
+        for (int i = 0; i < 2; i++)
+        {
+            m_eyeSegmenter->setDoCoarseToFinePupil(i == 1);
+            int code = (*m_eyeSegmenter)(iter->second.image, eyes[i]);
+            EXPECT_EQ(code, 0);
+        }
+
+        const auto& sweep = eyes[0].pupilEllipse;
+        const auto& search = eyes[1].pupilEllipse;
+        const float tolerance = 0.1f * std::max(eyes[0].irisEllipse.size.width, 1.f);
+        EXPECT_LE(cv::norm(sweep.center - search.center), tolerance);
+        EXPECT_LE(std::abs(sweep.size.width - search.size.width), tolerance);
+        EXPECT_LE(std::abs(sweep.size.height - search.size.height), tolerance);
+    }
+
+    m_eyeSegmenter->setDoCoarseToFinePupil(true);
+}
+
 TEST_F(EyeModelEstimatorTest, IsRepeatable) // NOLINT (TODO)
 {
     if (!m_eye || !m_eyeSegmenter)
@@ -312,6 +370,99 @@ TEST_F(EyeModelEstimatorTest, IsRepeatable) // NOLINT (TODO)
     }
 }
 
+// Mirrored sampling of a flipped (left) eye must match the right eye estimate:
+TEST_F(EyeModelEstimatorTest, MirroredParity) // NOLINT (TODO)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    for (auto iter = m_images.lower_bound(128); iter != m_images.end(); iter++)
+    {
+        cv::Mat flipped;
+        cv::flip(iter->second.image, flipped, 1);
+
+        drishti::eye::EyeModel eyeR, eyeL;
+        EXPECT_EQ((*m_eyeSegmenter)(iter->second.image, eyeR), 0);
+        EXPECT_EQ((*m_eyeSegmenter)(flipped, eyeL, true), 0);
+
+        // Back to the right eye image coordinate system:
+        eyeL.flop(flipped.cols);
+        eyeR.refine();
+        eyeL.refine();
+        checkValid(eyeL, flipped.size());
+
+        const float tolerance = 0.05f * std::max(eyeR.irisEllipse.size.width, 1.f);
+        EXPECT_LE(cv::norm(eyeR.irisEllipse.center - eyeL.irisEllipse.center), tolerance);
+        EXPECT_GT(detectionScore(eyeR, eyeL, iter->second.image.size(), 1.f), 0.9f);
+    }
+}
+
+// One shared estimator evaluated from several threads with per call options matches serial calls:
+TEST_F(EyeModelEstimatorTest, ConcurrentOptions) // NOLINT (TODO)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    auto options = m_eyeSegmenter->getOptions();
+    options.irisInits = 4;
+
+    std::vector<cv::Mat> crops;
+    std::vector<drishti::eye::EyeModel> serial, concurrent;
+    for (auto iter = m_images.lower_bound(128); iter != m_images.end(); iter++)
+    {
+        crops.push_back(iter->second.image);
+        serial.emplace_back();
+        EXPECT_EQ((*m_eyeSegmenter)(crops.back(), serial.back(), options), 0);
+    }
+
+    concurrent.resize(crops.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < crops.size(); i++)
+    {
+        threads.emplace_back([&, i]() { (*m_eyeSegmenter)(crops[i], concurrent[i], options); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (std::size_t i = 0; i < crops.size(); i++)
+    {
+        serial[i].refine();
+        concurrent[i].refine();
+        EXPECT_TRUE(isEqual(serial[i], concurrent[i]));
+    }
+}
+
+// A converged model should warm start itself (static "motion") without drifting:
+TEST_F(EyeModelEstimatorTest, WarmStart) // NOLINT (TODO)
+{
+    if (!m_eye || !m_eyeSegmenter)
+    {
+        return;
+    }
+
+    for (auto iter = m_images.lower_bound(128); iter != m_images.end(); iter++)
+    {
+        drishti::eye::EyeModel cold, warm;
+        EXPECT_EQ((*m_eyeSegmenter)(iter->second.image, cold), 0);
+        const int status = m_eyeSegmenter->track(iter->second.image, cold, warm);
+        EXPECT_GE(status, 0);
+
+        warm.refine();
+        checkValid(warm, iter->second.image.size());
+        if (status == 1)
+        {
+            cold.refine();
+            EXPECT_GT(detectionScore(cold, warm, iter->second.image.size(), 1.f), 0.9f);
+        }
+    }
+}
+
 // Currently there is no internal quality check, but this is included for regression:
 TEST_F(EyeModelEstimatorTest, ImageIsBlack) // NOLINT (TODO)
 {
@@ -341,6 +492,142 @@ TEST_F(EyeModelEstimatorTest, ImageIsWhite) // NOLINT (TODO)
     checkValid(eye, entry.image.size());
 }
 
+TEST(IrisRayCache, QuantizedRays) // NOLINT (TODO)
+{
+    drishti::eye::EyeModel eye;
+    eye.irisEllipse = cv::RotatedRect({ 100.f, 100.f }, { 60.f, 58.f }, 10.f);
+    eye.pupilEllipse = cv::RotatedRect({ 101.f, 100.f }, { 20.f, 20.f }, 0.f);
+
+    const cv::Size size(64, 16);
+    drishti::eye::IrisRayCache cache(0.25f, 2);
+    const auto rays = cache(eye, size).rayPixels;
+    EXPECT_EQ(rays.size(), static_cast<std::size_t>(size.width));
+    EXPECT_EQ(cache.misses(), 1);
+
+    // Small motion (below the quantum) reuses the rays:
+    eye.irisEllipse.center.x += 0.05f;
+    EXPECT_EQ(cache(eye, size).rayPixels[0][1], rays[0][1]);
+    EXPECT_EQ(cache.misses(), 1);
+
+    // Rays match a direct computation for the (already quantized) ellipses:
+    eye.irisEllipse.center.x = 100.f;
+    drishti::eye::IrisNormalizer::Rays rayPixels, rayTexels;
+    drishti::eye::IrisNormalizer().createRays(eye, size, rayPixels, rayTexels);
+    for (std::size_t i = 0; i < rays.size(); i++)
+    {
+        EXPECT_LT(cv::norm(rays[i][0] - rayPixels[i][0]), 1e-3);
+        EXPECT_LT(cv::norm(rays[i][1] - rayPixels[i][1]), 1e-3);
+    }
+
+    // Larger motion adds an entry:
+    eye.irisEllipse.center.x += 1.f;
+    cache(eye, size);
+    EXPECT_EQ(cache.misses(), 2);
+    EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(EyeModel, ScanlineLabels) // NOLINT (TODO)
+{
+    drishti::eye::EyeModel eye;
+    std::vector<cv::Point> contour;
+    cv::ellipse2Poly({ 100, 60 }, { 80, 30 }, 0, 0, 360, 10, contour);
+    eye.eyelids.assign(contour.begin(), contour.end());
+    eye.irisEllipse = cv::RotatedRect({ 110.f, 60.f }, { 50.f, 50.f }, 0.f);
+    eye.pupilEllipse = cv::RotatedRect({ 110.f, 60.f }, { 20.f, 20.f }, 0.f);
+
+    const cv::Size size(200, 120);
+    const cv::Mat1b labels = eye.labels(size, 1, 2, 3);
+
+    // Reference: composited OpenCV fills
+    std::vector<std::vector<cv::Point>> polygon{ contour };
+    cv::Mat1b eyeMask(size, 0), irisMask(size, 0), pupilMask(size, 0);
+    cv::fillPoly(eyeMask, polygon, 255, 4);
+    cv::ellipse(irisMask, eye.irisEllipse, 255, -1);
+    cv::ellipse(pupilMask, eye.pupilEllipse, 255, -1);
+    cv::Mat1b expected(size, 0);
+    expected.setTo(3, eyeMask);
+    expected.setTo(2, eyeMask & irisMask);
+    expected.setTo(1, eyeMask & irisMask & pupilMask);
+
+    // Only boundary pixels may differ:
+    EXPECT_LT(cv::countNonZero(labels != expected), 0.05 * cv::countNonZero(expected));
+    EXPECT_EQ(labels(60, 110), 1);
+    EXPECT_EQ(labels(60, 130), 2);
+    EXPECT_EQ(labels(60, 40), 3);
+    EXPECT_EQ(labels(5, 5), 0);
+
+    // ROI rasterization into a caller buffer matches the full frame:
+    const cv::Rect roi(60, 40, 80, 40);
+    cv::Mat1b tile;
+    eye.rasterize(tile, roi, 1, 2, 3);
+    EXPECT_EQ(cv::countNonZero(tile != labels(roi)), 0);
+}
+
+static drishti::eye::NormalizedIris randomIris(const cv::Size& size, int seed)
+{
+    cv::RNG rng(seed);
+    cv::Mat1b image(size), mask(size, 255);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(image, image, { 5, 5 }, 1.5);
+    mask(cv::Rect(0, 0, size.width / 4, size.height / 2)) = 0; // eyelid
+    return drishti::eye::NormalizedIris(image, mask, { { 0, 0 }, size });
+}
+
+TEST(IrisCode, HammingSearch) // NOLINT (TODO)
+{
+    using drishti::eye::IrisCode;
+
+    const cv::Size size(IrisCode::kAngles * 2, IrisCode::kRadii * 4);
+    const auto iris = randomIris(size, 1);
+    const IrisCode code(iris);
+    EXPECT_GT(code.count(), IrisCode::kBits / 2);
+    EXPECT_LT(code.count(), IrisCode::kBits);
+
+    // Rotating the normalized iris by 6 columns (2 per sample) rotates the code by 3 samples:
+    const IrisCode rotated(iris.rotate(6));
+    EXPECT_EQ(rotated.getCode(), code.rotate(3).getCode());
+    EXPECT_EQ(rotated.getMask(), code.rotate(3).getMask());
+    EXPECT_EQ(code.rotate(3).rotate(-3).getCode(), code.getCode());
+
+    int shift = 0;
+    EXPECT_EQ(IrisCode::distance(rotated, code, 8, &shift), 0.f);
+    EXPECT_EQ(shift, -3);
+
+    // Unrelated irises are near 0.5:
+    const IrisCode other(randomIris(size, 2));
+    EXPECT_NEAR(IrisCode::distance(other, code), 0.5f, 0.1f);
+
+    // SIMD and scalar popcount agree:
+    int bits = 0, bitsScalar = 0;
+    const float d = drishti::eye::hammingDistance(other.getCode().data(), other.getMask().data(), code.getCode().data(), code.getMask().data(), IrisCode::kWords, bits);
+    drishti::core::setSimdEnabled(false);
+    const float dScalar = drishti::eye::hammingDistance(other.getCode().data(), other.getMask().data(), code.getCode().data(), code.getMask().data(), IrisCode::kWords, bitsScalar);
+    drishti::core::setSimdEnabled(true);
+    EXPECT_EQ(d, dScalar);
+    EXPECT_EQ(bits, bitsScalar);
+
+    // 1:N search finds the (rotated) probe:
+    drishti::eye::IrisGallery gallery;
+    for (int i = 0; i < 100; i++)
+    {
+        gallery.add((i == 50) ? code : IrisCode(randomIris(size, i + 100)), i * 10);
+    }
+    EXPECT_EQ(gallery.get(50).getCode(), code.getCode());
+
+    drishti::eye::IrisGallery::SearchSettings settings;
+    settings.top = 3;
+    const auto matches = gallery.search(rotated, settings);
+    ASSERT_EQ(matches.size(), std::size_t(3));
+    EXPECT_EQ(matches[0].index, 50);
+    EXPECT_EQ(matches[0].id, 500);
+    EXPECT_EQ(matches[0].shift, -3);
+    EXPECT_EQ(matches[0].distance, 0.f);
+    EXPECT_GT(matches[1].distance, 0.3f);
+
+    settings.threshold = 0.3f;
+    EXPECT_EQ(gallery.search(rotated, settings).size(), std::size_t(1));
+}
+
 // #######
 
 static cv::Mat scleraMask(const drishti::eye::EyeModel& eye, const cv::Size& size)
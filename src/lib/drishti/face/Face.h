@@ -16,6 +16,7 @@
 #include "drishti/eye/Eye.h"
 #include "drishti/geometry/Rectangle.h"
 
+#include <array>
 #include <cstdio>
 
 DRISHTI_FACE_NAMESPACE_BEGIN
@@ -98,6 +99,12 @@ struct FaceModel
 
     core::Field<cv::Point3f> eyesCenter;
 
+    // Unit gaze vectors { right, left } in camera coordinates (see hci::GazeEstimator):
+    core::Field<std::array<cv::Vec3f, 2>> gaze;
+
+    // Eye regression level for faces with eye regions (see FaceDetector::EyeMode):
+    core::Field<int> eyeMode;
+
     template <typename T>
     FaceModel& operator+=(const cv::Point_<T>& p)
     {
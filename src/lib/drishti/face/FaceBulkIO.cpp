@@ -0,0 +1,529 @@
+/*! -*-c++-*-
+  @file   FaceBulkIO.cpp
+  @author David Hirvonen
+  @brief  Implementation of parallel bulk loaders for face and eye landmark annotations.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceBulkIO.h"
+#include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/Parallel.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <cereal/archives/json.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <streambuf>
+
+#include <sys/stat.h>
+
+// clang-format off
+#if !defined(_WIN32)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  define DRISHTI_FACE_BULK_IO_USE_MMAP 1
+#else
+#  define DRISHTI_FACE_BULK_IO_USE_MMAP 0
+#endif
+// clang-format on
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+static const char kCacheMagic[] = "DRFC";
+static const std::uint32_t kCacheVersion = 1;
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Read only file contents (mapped where supported):
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& filename)
+    {
+#if DRISHTI_FACE_BULK_IO_USE_MMAP
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat info;
+            void* mapped = MAP_FAILED;
+            if ((fstat(fd, &info) == 0) && (info.st_size > 0))
+            {
+                mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            ::close(fd); // the mapping holds its own reference
+
+            if (mapped != MAP_FAILED)
+            {
+                m_mapped = mapped;
+                m_data = static_cast<const char*>(mapped);
+                m_size = static_cast<std::size_t>(info.st_size);
+                return;
+            }
+        }
+#endif
+
+        std::ifstream ifs(filename, std::ios::binary);
+        if (ifs)
+        {
+            m_buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+    }
+
+    ~MappedFile()
+    {
+#if DRISHTI_FACE_BULK_IO_USE_MMAP
+        if (m_mapped)
+        {
+            munmap(m_mapped, m_size);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    bool empty() const { return m_size == 0; }
+
+protected:
+    void* m_mapped = nullptr;
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::vector<char> m_buffer;
+};
+
+// Input stream over a memory range (no copy) for cereal:
+class MemoryBuffer : public std::streambuf
+{
+public:
+    MemoryBuffer(const char* begin, const char* end)
+    {
+        char* data = const_cast<char*>(begin); // read only
+        setg(data, data, data + (end - begin));
+    }
+};
+
+// Line ranges without the line terminator (empty lines are skipped):
+static std::vector<std::pair<const char*, const char*>> splitLines(const char* begin, const char* end)
+{
+    std::vector<std::pair<const char*, const char*>> lines;
+    while (begin < end)
+    {
+        const auto* next = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+        const char* stop = next ? next : end;
+        const char* last = ((stop > begin) && (stop[-1] == '\r')) ? (stop - 1) : stop;
+        if (last > begin)
+        {
+            lines.emplace_back(begin, last);
+        }
+        begin = stop + 1;
+    }
+    return lines;
+}
+
+static void parallel(int count, const std::function<void(int)>& body, int threads)
+{
+    core::ParallelSettings settings;
+    settings.threads = threads;
+    core::parallelFor({ 0, count }, core::ParallelHomogeneousLambda(body), settings);
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+static const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double power10(int exponent)
+{
+    const int e = std::abs(exponent);
+    const double scale = (e <= 22) ? kPow10[e] : std::pow(10.0, e);
+    return (exponent < 0) ? (1.0 / scale) : scale;
+}
+
+static bool isDigit(char c)
+{
+    return static_cast<unsigned>(c - '0') < 10u;
+}
+
+bool parseFloat(const char*& begin, const char* end, float& value)
+{
+    const char* p = begin;
+    while ((p < end) && ((*p == ' ') || (*p == '\t')))
+    {
+        p++;
+    }
+
+    bool negative = false;
+    if ((p < end) && ((*p == '-') || (*p == '+')))
+    {
+        negative = (*p++ == '-');
+    }
+
+    // Up to 17 significant digits are exact in the 64 bit mantissa:
+    static const std::uint64_t kLimit = 100000000000000000ull;
+    std::uint64_t mantissa = 0;
+    int exponent = 0, digits = 0;
+    for (; (p < end) && isDigit(*p); p++, digits++)
+    {
+        if (mantissa < kLimit)
+        {
+            mantissa = (mantissa * 10) + static_cast<std::uint64_t>(*p - '0');
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+    if ((p < end) && (*p == '.'))
+    {
+        for (p++; (p < end) && isDigit(*p); p++, digits++)
+        {
+            if (mantissa < kLimit)
+            {
+                mantissa = (mantissa * 10) + static_cast<std::uint64_t>(*p - '0');
+                exponent--;
+            }
+        }
+    }
+    if (!digits)
+    {
+        return false;
+    }
+
+    if ((p < end) && ((*p == 'e') || (*p == 'E')))
+    {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if ((q < end) && ((*q == '-') || (*q == '+')))
+        {
+            negativeExponent = (*q++ == '-');
+        }
+        if ((q < end) && isDigit(*q))
+        {
+            int e = 0;
+            for (; (q < end) && isDigit(*q); q++)
+            {
+                e = std::min((e * 10) + (*q - '0'), 1000);
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    const double result = static_cast<double>(mantissa) * power10(exponent);
+    value = static_cast<float>(negative ? -result : result);
+    begin = p;
+    return true;
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Source files are identified by name, size and modification time:
+struct SourceStamp
+{
+    std::string name;
+    std::uint64_t size = 0;
+    std::int64_t time = 0;
+
+    template <class Archive>
+    void serialize(Archive& ar)
+    {
+        ar(name, size, time);
+    }
+
+    bool operator==(const SourceStamp& other) const
+    {
+        return (name == other.name) && (size == other.size) && (time == other.time);
+    }
+};
+
+static std::vector<SourceStamp> getStamps(const std::vector<std::string>& filenames)
+{
+    std::vector<SourceStamp> stamps(filenames.size());
+    for (std::size_t i = 0; i < filenames.size(); i++)
+    {
+        struct stat info;
+        stamps[i].name = filenames[i];
+        if (stat(filenames[i].c_str(), &info) == 0)
+        {
+            stamps[i].size = static_cast<std::uint64_t>(info.st_size);
+            stamps[i].time = static_cast<std::int64_t>(info.st_mtime);
+        }
+    }
+    return stamps;
+}
+
+// Names are stored first (see loadCache() and saveCache()):
+template <class Archive>
+void serialize(Archive& ar, FaceDataset& dataset)
+{
+    ar(dataset.faces);
+}
+
+template <class Archive>
+void serialize(Archive& ar, EyeDataset& dataset)
+{
+    ar(dataset.eyes);
+}
+
+template <typename Dataset>
+static bool loadCache(const std::string& filename, const std::string& kind, const std::vector<SourceStamp>& stamps, Dataset& dataset)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs || filename.empty())
+    {
+        return false;
+    }
+
+    try
+    {
+        cereal::PortableBinaryInputArchive ia(ifs);
+
+        std::string magic, cachedKind;
+        std::uint32_t version = 0;
+        ia(magic, version, cachedKind);
+        if ((magic != kCacheMagic) || (version != kCacheVersion) || (cachedKind != kind))
+        {
+            return false;
+        }
+
+        std::vector<SourceStamp> cached;
+        ia(cached);
+        if (cached != stamps)
+        {
+            return false;
+        }
+
+        ia(dataset.names, dataset);
+        return true;
+    }
+    catch (...) // truncated or corrupt cache: reparse
+    {
+        return false;
+    }
+}
+
+template <typename Dataset>
+static void saveCache(const std::string& filename, const std::string& kind, const std::vector<SourceStamp>& stamps, const Dataset& dataset)
+{
+    if (filename.empty())
+    {
+        return;
+    }
+
+    std::ofstream ofs(filename, std::ios::binary);
+    if (ofs)
+    {
+        cereal::PortableBinaryOutputArchive oa(ofs);
+        oa(std::string(kCacheMagic), kCacheVersion, kind);
+        oa(stamps);
+        oa(dataset.names, dataset);
+    }
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+// Parse each file on a worker thread, failed files are removed in the final (ordered) pass:
+template <typename Dataset, typename Value, typename Parser>
+static bool loadFiles(const std::vector<std::string>& filenames, Dataset& dataset, std::vector<Value> Dataset::*values, const Parser& parser, const BulkSettings& settings)
+{
+    const auto count = static_cast<int>(filenames.size());
+    std::vector<Value> parsed(filenames.size());
+    std::vector<char> good(filenames.size(), 0);
+
+    parallel(count, [&](int i) {
+        MappedFile file(filenames[i]);
+        if (!file.empty())
+        {
+            MemoryBuffer buffer(file.begin(), file.end());
+            std::istream is(&buffer);
+            try
+            {
+                cereal::JSONInputArchive ia(is);
+                parser(ia, parsed[i]);
+                good[i] = 1;
+            }
+            catch (...) // e.g., cereal::Exception, rapidjson parse error
+            {
+            }
+        }
+    }, settings.threads);
+
+    dataset.names.clear();
+    (dataset.*values).clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (good[i])
+        {
+            dataset.names.push_back(filenames[i]);
+            (dataset.*values).push_back(std::move(parsed[i]));
+        }
+    }
+
+    return dataset.names.size() == filenames.size();
+}
+
+bool loadFacesJson(const std::vector<std::string>& filenames, FaceDataset& dataset, const BulkSettings& settings)
+{
+    const auto stamps = getStamps(filenames);
+    if (loadCache(settings.cache, "faces-json", stamps, dataset))
+    {
+        return true;
+    }
+
+    const auto parser = [](cereal::JSONInputArchive& ia, std::vector<FaceModel>& faces) {
+        using Archive = cereal::JSONInputArchive;
+        ia(GENERIC_NVP("faces", faces));
+    };
+
+    const bool good = loadFiles(filenames, dataset, &FaceDataset::faces, parser, settings);
+    saveCache(settings.cache, "faces-json", stamps, dataset);
+    return good;
+}
+
+bool loadEyesJson(const std::vector<std::string>& filenames, EyeDataset& dataset, const BulkSettings& settings)
+{
+    const auto stamps = getStamps(filenames);
+    if (loadCache(settings.cache, "eyes-json", stamps, dataset))
+    {
+        return true;
+    }
+
+    const auto parser = [](cereal::JSONInputArchive& ia, DRISHTI_EYE::EyeModel& eye) {
+        using Archive = cereal::JSONInputArchive;
+        ia(GENERIC_NVP("eye", eye));
+    };
+
+    const bool good = loadFiles(filenames, dataset, &EyeDataset::eyes, parser, settings);
+    saveCache(settings.cache, "eyes-json", stamps, dataset);
+    return good;
+}
+
+bool loadFacesJsonLines(const std::string& filename, FaceDataset& dataset, const BulkSettings& settings)
+{
+    const auto stamps = getStamps({ filename });
+    if (loadCache(settings.cache, "faces-jsonl", stamps, dataset))
+    {
+        return true;
+    }
+
+    MappedFile file(filename);
+    const auto lines = splitLines(file.begin(), file.end());
+
+    const auto count = static_cast<int>(lines.size());
+    std::vector<std::string> names(lines.size());
+    std::vector<std::vector<FaceModel>> faces(lines.size());
+    std::vector<char> good(lines.size(), 0);
+
+    parallel(count, [&](int i) {
+        MemoryBuffer buffer(lines[i].first, lines[i].second);
+        std::istream is(&buffer);
+        try
+        {
+            cereal::JSONInputArchive ia(is);
+            using Archive = decltype(ia);
+            ia(GENERIC_NVP("filename", names[i]));
+            ia(GENERIC_NVP("faces", faces[i]));
+            good[i] = 1;
+        }
+        catch (...)
+        {
+        }
+    }, settings.threads);
+
+    dataset.names.clear();
+    dataset.faces.clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (good[i])
+        {
+            dataset.names.push_back(std::move(names[i]));
+            dataset.faces.push_back(std::move(faces[i]));
+        }
+    }
+
+    saveCache(settings.cache, "faces-jsonl", stamps, dataset);
+    return !file.empty() && (dataset.names.size() == lines.size());
+}
+
+bool loadFacesCsv(const std::string& filename, FaceDataset& dataset, const BulkSettings& settings)
+{
+    const auto stamps = getStamps({ filename });
+    if (loadCache(settings.cache, "faces-csv", stamps, dataset))
+    {
+        return true;
+    }
+
+    MappedFile file(filename);
+    auto lines = splitLines(file.begin(), file.end());
+
+    // A first row without a number in the second column is a header:
+    if (!lines.empty())
+    {
+        const char* comma = std::find(lines.front().first, lines.front().second, ',');
+        float value = 0.f;
+        if ((comma == lines.front().second) || !parseFloat(++comma, lines.front().second, value))
+        {
+            lines.erase(lines.begin());
+        }
+    }
+
+    const auto count = static_cast<int>(lines.size());
+    dataset.names.assign(lines.size(), {});
+    dataset.faces.assign(lines.size(), std::vector<FaceModel>(1));
+    std::atomic<int> failures{ 0 };
+
+    parallel(count, [&](int i) {
+        const char* p = lines[i].first;
+        const char* end = lines[i].second;
+        const char* comma = std::find(p, end, ',');
+        dataset.names[i].assign(p, comma);
+
+        std::vector<cv::Point2f> points;
+        points.reserve(static_cast<std::size_t>(end - comma) / 8);
+        for (p = comma; p < end;)
+        {
+            cv::Point2f point;
+            if (!parseFloat(++p, end, point.x) || (p == end) || (*p != ',') || !parseFloat(++p, end, point.y))
+            {
+                failures++;
+                break;
+            }
+            points.push_back(point);
+            while ((p < end) && (*p != ','))
+            {
+                p++; // trailing whitespace
+            }
+        }
+
+        auto& face = dataset.faces[i].front();
+        face.roi = points.empty() ? cv::Rect() : cv::boundingRect(points);
+        face.points = points;
+    }, settings.threads);
+
+    saveCache(settings.cache, "faces-csv", stamps, dataset);
+    return !file.empty() && (failures == 0);
+}
+
+DRISHTI_FACE_NAMESPACE_END
@@ -0,0 +1,66 @@
+/*! -*-c++-*-
+  @file   FaceBulkIO.h
+  @author David Hirvonen
+  @brief  Declaration of parallel bulk loaders for face and eye landmark annotations.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Loading tens of thousands of annotation files one at a time (open, stream, parse) is I/O
+  and parse bound.  These loaders memory map each input (where supported) and parse files
+  (or lines) concurrently, with a hand written number parser for CSV input.  When a cache
+  filename is given, the parsed dataset is stored in a compact binary archive on the first
+  load, and later loads read the archive instead, as long as every source file still has
+  the same size and modification time.
+
+  Supported formats:
+
+    JSON       : one cereal archive per file, e.g., { "faces" : [...] } (drishti-face) or
+                 { "eye" : {...} } (drishti-eye)
+    JSON lines : one { "filename", "faces" } record per line (drishti-face --sink)
+    CSV        : name,x0,y0,x1,y1,... with one face per row (a header row is skipped)
+
+*/
+
+#ifndef __drishti_face_FaceBulkIO_h__
+#define __drishti_face_FaceBulkIO_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/eye/Eye.h"
+
+#include <string>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+struct BulkSettings
+{
+    int threads = -1;  // parser threads (<= 0 == hardware concurrency)
+    std::string cache; // binary cache filename (empty == no cache)
+};
+
+struct FaceDataset
+{
+    std::vector<std::string> names;            // source file, "filename" field or first CSV column
+    std::vector<std::vector<FaceModel>> faces; // per name
+};
+
+struct EyeDataset
+{
+    std::vector<std::string> names;
+    std::vector<DRISHTI_EYE::EyeModel> eyes;
+};
+
+// Files that fail to parse are skipped (the return value is false if any were skipped):
+bool loadFacesJson(const std::vector<std::string>& filenames, FaceDataset& dataset, const BulkSettings& settings = {});
+bool loadFacesJsonLines(const std::string& filename, FaceDataset& dataset, const BulkSettings& settings = {});
+bool loadFacesCsv(const std::string& filename, FaceDataset& dataset, const BulkSettings& settings = {});
+bool loadEyesJson(const std::vector<std::string>& filenames, EyeDataset& dataset, const BulkSettings& settings = {});
+
+// Locale independent float parser used for CSV input, returns false if no number was found:
+bool parseFloat(const char*& begin, const char* end, float& value);
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceBulkIO_h__
@@ -0,0 +1,121 @@
+/*! -*-c++-*-
+  @file   drishti/face/FaceCameraRig.cpp
+  @author David Hirvonen
+  @brief  Implementation of a multi-camera face ROI propagation coordinator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceCameraRig.h"
+
+#include <algorithm>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// SensorModel camera coordinates are x left, y up (see Intrinsic::getDepth()):
+static const cv::Matx33f F = cv::Matx33f::diag({ -1.f, -1.f, 1.f });
+
+FaceCameraRig::FaceCameraRig(std::vector<sensor::SensorModel> cameras, const Settings& settings)
+    : m_cameras(std::move(cameras))
+    , m_frames(m_cameras.size(), 0)
+    , m_settings(settings)
+{
+}
+
+cv::Point3f FaceCameraRig::transform(const cv::Point3f& point, int from, int to) const
+{
+    // rig = Ri^T * (Xi - ti), Xj = Rj * rig + tj:
+    const auto& Ei = m_cameras[from].extrinsic();
+    const auto& Ej = m_cameras[to].extrinsic();
+    const cv::Vec3f rig = Ei.R.t() * (cv::Vec3f(point.x, point.y, point.z) - Ei.t);
+    const cv::Vec3f Xj = Ej.R * rig + Ej.t;
+    return { Xj[0], Xj[1], Xj[2] };
+}
+
+cv::Matx33f FaceCameraRig::getHomography(int from, int to, float zMeters) const
+{
+    const auto& Ei = m_cameras[from].extrinsic();
+    const auto& Ej = m_cameras[to].extrinsic();
+    const cv::Matx33f R = Ej.R * Ei.R.t();
+    const cv::Vec3f t = Ej.t - R * Ei.t;
+
+    // Plane n^T X = z with n = (0,0,1): H = Kj * F * (R + t * n^T / z) * F * Ki^-1
+    cv::Matx33f G = R;
+    for (int i = 0; i < 3; i++)
+    {
+        G(i, 2) += t[i] / zMeters;
+    }
+
+    const cv::Matx33f Kinv = m_cameras[from].intrinsic().getK().inv();
+    cv::Matx33f H = m_cameras[to].intrinsic().getK() * F * G * F * Kinv;
+    return H * (1.f / H(2, 2));
+}
+
+void FaceCameraRig::project(const std::vector<FaceModel>& faces, int from, int to, std::vector<FaceModel>& seeds) const
+{
+    seeds.clear();
+
+    const cv::Rect bounds({ 0, 0 }, m_cameras[to].intrinsic().getSize());
+    for (const auto& face : faces)
+    {
+        if (!face.eyesCenter.has || !face.roi.has || (face.eyesCenter->z <= 0.f))
+        {
+            continue;
+        }
+
+        const cv::Point3f center = transform(*face.eyesCenter, from, to);
+        if (center.z <= 0.f)
+        {
+            continue;
+        }
+
+        FaceModel seed = getHomography(from, to, face.eyesCenter->z) * face;
+        seed.eyesCenter = center;
+
+        const cv::Rect roi = *seed.roi;
+        const float overlap = static_cast<float>((roi & bounds).area()) / static_cast<float>(std::max(roi.area(), 1));
+        if (overlap < m_settings.minOverlap)
+        {
+            continue;
+        }
+        seed.roi = roi & bounds;
+        seeds.push_back(seed);
+    }
+}
+
+bool FaceCameraRig::isDetection(int camera, bool hasSeeds)
+{
+    int& frames = m_frames[camera];
+    if (!hasSeeds || (frames + 1) >= std::max(m_settings.detectionInterval, 1))
+    {
+        frames = 0;
+        return true;
+    }
+    frames++;
+    return false;
+}
+
+void FaceCameraRig::operator()(FaceDetector& detector, int to, const MatP& I, const FaceDetector::PaddedImage& Ib, const std::vector<FaceModel>& faces, int from, std::vector<FaceModel>& result, const cv::Matx33f& Hdr, const cv::Matx33f& Hfr)
+{
+    result.clear();
+
+    std::vector<FaceModel> seeds;
+    if (from != to)
+    {
+        project(faces, from, to, seeds);
+    }
+
+    if (isDetection(to, !seeds.empty()))
+    {
+        detector(I, Ib, result, Hdr);
+    }
+    else
+    {
+        detector.refine(Ib, seeds, Hfr, false);
+        result = std::move(seeds);
+    }
+}
+
+DRISHTI_FACE_NAMESPACE_END
@@ -0,0 +1,72 @@
+/*! -*-c++-*-
+  @file   drishti/face/FaceCameraRig.h
+  @author David Hirvonen
+  @brief  Declaration of a multi-camera face ROI propagation coordinator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Faces tracked in one calibrated camera (with FaceModel::eyesCenter from the iris based
+  depth, see FaceModelEstimator) are mapped to the image planes of the other cameras through
+  the fronto-parallel plane at the face depth.  The secondary cameras use them as seeds for
+  landmark regression (FaceDetector::refine()) and run a full detection only every
+  Settings::detectionInterval frames, or when there are no seeds.
+
+*/
+
+#ifndef __drishti_face_FaceCameraRig_h__
+#define __drishti_face_FaceCameraRig_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/face/FaceDetector.h"
+#include "drishti/sensor/Sensor.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+class FaceCameraRig
+{
+public:
+    struct Settings
+    {
+        int detectionInterval = 30; // frames between full detections per secondary camera
+        float minOverlap = 0.5f;    // minimum fraction of a projected roi inside the target image
+    };
+
+    FaceCameraRig(std::vector<sensor::SensorModel> cameras, const Settings& settings = {});
+
+    std::size_t size() const { return m_cameras.size(); }
+    const sensor::SensorModel& getCamera(int i) const { return m_cameras[i]; }
+    const Settings& getSettings() const { return m_settings; }
+
+    // Map a point (meters) from the coordinates of camera `from` to camera `to`:
+    cv::Point3f transform(const cv::Point3f& point, int from, int to) const;
+
+    // Image to image homography induced by the fronto-parallel plane at depth zMeters in `from`:
+    cv::Matx33f getHomography(int from, int to, float zMeters) const;
+
+    // Project the faces of camera `from` to camera `to`, faces without depth, behind camera `to`
+    // or mostly outside of its image are skipped:
+    void project(const std::vector<FaceModel>& faces, int from, int to, std::vector<FaceModel>& seeds) const;
+
+    // Advance the detection schedule of a camera, true if it should run a full detection:
+    bool isDetection(int camera, bool hasSeeds);
+
+    // Faces for camera `to` from the (full resolution) faces of camera `from`, either by detection
+    // or by seeded regression, in the regression image coordinates as for FaceDetector, where Hdr
+    // and Hfr map the detection and full resolution images to the regression image:
+    void operator()(FaceDetector& detector, int to, const MatP& I, const FaceDetector::PaddedImage& Ib, const std::vector<FaceModel>& faces, int from, std::vector<FaceModel>& result, const cv::Matx33f& Hdr = EYE, const cv::Matx33f& Hfr = EYE);
+
+protected:
+    std::vector<sensor::SensorModel> m_cameras;
+    std::vector<int> m_frames; // frames since the last full detection per camera
+    Settings m_settings;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceCameraRig_h__
@@ -9,9 +9,12 @@
 */
 
 #include "drishti/core/drishti_core.h"
+#include "drishti/core/Arena.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/timing.h"
 #include "drishti/core/Parallel.h"
+#include "drishti/core/TaskGraph.h"
+#include "drishti/core/ThreadPool.h"
 #include "drishti/face/FaceDetector.h"
 #include "drishti/face/FaceIO.h"
 #include "drishti/geometry/Primitives.h"
@@ -25,7 +28,16 @@
 
 #include <acf/ACF.h> // ACF detection
 
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <functional>
+#include <limits>
+#include <mutex>
 
 #include <utility>
 
@@ -50,6 +62,13 @@ public:
         create(resources);
     }
 
+    Impl(FaceDetectorFactory::Models& models)
+    {
+        m_detector = models.detector.get();
+        m_pendingRegressor = std::move(models.faceEstimator);
+        m_pendingEyeRegressor = std::move(models.eyeEstimators);
+    }
+
     ~Impl() = default;
 
     Impl(const Impl&) = delete;
@@ -61,6 +80,7 @@ public:
     {
         m_detector = resources.getFaceDetector();
         m_regressor = resources.getFaceEstimator();
+        bindRegressionBackend();
         m_eyeRegressor.resize(2);
         for (int i = 0; i < 2; i++)
         {
@@ -68,6 +88,124 @@ public:
         }
     }
 
+    // Wait for regressors loaded in the background (rethrows load errors):
+    void join()
+    {
+        if (m_pendingRegressor.valid())
+        {
+            m_regressor = m_pendingRegressor.get();
+            bindRegressionBackend();
+            m_eyeRegressor.resize(2);
+            for (int i = 0; i < 2; i++)
+            {
+                m_eyeRegressor[i] = m_pendingEyeRegressor[i].get();
+            }
+            if (m_hasFaceDetectorMean && m_regressor)
+            {
+                m_Hrd = getAffineMotionFromRegressorToDetector(*m_regressor);
+            }
+        }
+    }
+
+    bool isReady() const
+    {
+        return !m_pendingRegressor.valid();
+    }
+
+    bool swapModels(FaceDetectorFactory::Models& models)
+    {
+        std::lock_guard<std::mutex> lock(m_swapMutex);
+        if (m_swapRegressor.valid() || !models.faceEstimator.valid())
+        {
+            return false;
+        }
+        m_swapRegressor = std::move(models.faceEstimator);
+        m_swapEyeRegressor = std::move(models.eyeEstimators);
+        return true;
+    }
+
+    bool isSwapPending() const
+    {
+        std::lock_guard<std::mutex> lock(m_swapMutex);
+        return m_swapRegressor.valid();
+    }
+
+    int getModelGeneration() const
+    {
+        return m_modelGeneration;
+    }
+
+    // Install a pending swap once all of its models are loaded (see swapModels()), called
+    // before the regressors are used, so refineFace() sees one set of models per call:
+    void installModels()
+    {
+        std::lock_guard<std::mutex> lock(m_swapMutex);
+        if (!m_swapRegressor.valid())
+        {
+            return;
+        }
+
+        const auto isLoaded = [](const std::future<std::unique_ptr<DRISHTI_EYE::EyeModelEstimator>>& model) {
+            return !model.valid() || (model.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        };
+        if ((m_swapRegressor.wait_for(std::chrono::seconds(0)) != std::future_status::ready) || !isLoaded(m_swapEyeRegressor[0]) || !isLoaded(m_swapEyeRegressor[1]))
+        {
+            return;
+        }
+
+        std::shared_ptr<drishti::ml::ShapeEstimator> regressor;
+        std::vector<std::shared_ptr<DRISHTI_EYE::EyeModelEstimator>> eyeRegressor(2);
+        try
+        {
+            regressor = m_swapRegressor.get();
+            for (int i = 0; i < 2; i++)
+            {
+                if (m_swapEyeRegressor[i].valid())
+                {
+                    eyeRegressor[i] = m_swapEyeRegressor[i].get();
+                }
+            }
+        }
+        catch (...)
+        {
+            m_swapEyeRegressor = {}; // keep the current models
+            return;
+        }
+
+        // Landmark consumers expect the current format (see setLandmarkFormat()):
+        if (!regressor || (m_regressor && ((regressor->getMeanShape().size() != m_regressor->getMeanShape().size()) || (regressor->getLandmarks() != m_regressor->getLandmarks()))))
+        {
+            return;
+        }
+
+        if (m_regressor)
+        {
+            regressor->setStagesHint(m_regressor->getStagesHint());
+        }
+        m_regressor = std::move(regressor);
+        bindRegressionBackend();
+        if (m_hasFaceDetectorMean)
+        {
+            m_Hrd = getAffineMotionFromRegressorToDetector(*m_regressor);
+        }
+
+        // Eye regressors are replaced as a pair:
+        if (eyeRegressor[0] && eyeRegressor[1])
+        {
+            for (int i = 0; (i < 2) && (i < m_eyeRegressor.size()); i++)
+            {
+                if (m_eyeRegressor[i])
+                {
+                    eyeRegressor[i]->setEyelidStagesHint(m_eyeRegressor[i]->getEyelidStagesHint());
+                    eyeRegressor[i]->setIrisStagesHint(m_eyeRegressor[i]->getIrisStagesHint());
+                }
+            }
+            m_eyeRegressor = std::move(eyeRegressor);
+        }
+
+        m_modelGeneration++;
+    }
+
     void setLandmarkFormat(FaceSpecification::Format format)
     {
         m_landmarkFormat = format;
@@ -110,134 +248,330 @@ public:
         }
     }
 
+    /*
+     * The landmarks of all faces are one ShapeEstimator::estimateBatch() call per frame, so the
+     * regressor backend decides how the batch is evaluated (worker threads, SIMD or GPU), and the
+     * eyes are one task graph per call (see core::TaskGraph): the eye crops of each face are
+     * followed by the right and left eye regressions of that face only.  The eye regressors are
+     * reentrant (per call options, per thread workspaces), so every (face, eye) task can run on
+     * its own worker.
+     */
     void refineFace(const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H, bool isDetection)
     {
-        // Find the landmarks:
+        join();
+        installModels();
+
+        const auto tic = Clock::now();
+
+        // Map and verify, then regress all faces in one batch:
         if (m_regressor)
         {
-            std::vector<dsdkc::Shape> shapes(faces.size());
-            std::transform(faces.begin(), faces.end(), shapes.begin(), [](const FaceModel& face) {
+            LandmarkJobs landmarks;
+            landmarks.shapes.resize(faces.size());
+            std::transform(faces.begin(), faces.end(), landmarks.shapes.begin(), [](const FaceModel& face) {
                 return dsdkc::Shape(face.roi);
             });
-            findLandmarks(Ib, shapes, H, isDetection);
-            shapesToFaces(shapes, faces);
+            prepareLandmarks(Ib, H, isDetection, landmarks);
+            regressLandmarks(landmarks);
+            shapesToFaces(landmarks.shapes, faces);
         }
 
-        if (m_eyeRegressor.size() && m_eyeRegressor[0] && m_eyeRegressor[1] && m_doEyeRefinement && faces.size())
+        const bool doEyes = m_eyeRegressor.size() && m_eyeRegressor[0] && m_eyeRegressor[1] && m_doEyeRefinement && faces.size();
+
+        std::vector<EyeJob> jobs(doEyes ? faces.size() : 0);
+        std::vector<EyeModelPair> eyes(jobs.size());
+        StageSpan landmarkSpan, eyeSpan;
+        landmarkSpan.add(tic, Clock::now());
+
+        // Workers allocate frame temporaries from the caller's arena (see core::FrameArena):
+        drishti::core::FrameArena* arena = drishti::core::FrameArena::current();
+        auto add = [&](std::function<void()> task, float cost) {
+            return m_graph.add([arena, task]() {
+                drishti::core::FrameArena::Scope scope(arena);
+                task();
+            }, cost);
+        };
+
+        // Relative costs for the critical path:
+        const float cropCost = 0.1f, eyeCost = 1.f;
+
+        m_graph.clear();
+        for (int i = 0; i < faces.size(); i++)
         {
-            for (auto& f : faces)
+            if (doEyes)
             {
-                DRISHTI_EYE::EyeModel eyeR, eyeL;
-                segmentEyes(Ib.Ib, f, eyeR, eyeL);
-                if (eyeR.eyelids.size())
-                {
-                    f.eyeFullR = eyeR;
-                    f.eyeRightCenter = core::centroid(eyeR.eyelids);
-                }
-                if (eyeL.eyelids.size())
+                const int crops = add([&, i]() { prepareEyes(Ib, faces[i], jobs[i], eyes[i]); }, cropCost);
+
+                for (int lane = 0; lane < 2; lane++)
                 {
-                    f.eyeFullL = eyeL;
-                    f.eyeLeftCenter = core::centroid(eyeL.eyelids);
+                    const int eye = add([&, i, lane]() {
+                        if (jobs[i].valid)
+                        {
+                            const auto start = Clock::now();
+                            regressEye(lane, jobs[i], eyes[i][lane]);
+                            eyeSpan.add(start, Clock::now());
+                        }
+                    }, eyeCost);
+                    m_graph.precede(crops, eye);
                 }
             }
         }
+
+        // At most m_threadCount workers (0 == no limit), the SDK pool is used without a shared pool:
+        if (m_threadCount == 1)
+        {
+            m_graph.run(nullptr, 1);
+        }
+        else
+        {
+            m_graph.run(m_threads.get(), (m_threadCount > 1) ? m_threadCount : -1);
+        }
+        m_graph.clear(); // release the captures
+
+        if (m_regressor && m_regressionTimeLogger)
+        {
+            m_regressionTimeLogger(landmarkSpan.elapsed());
+        }
+        if (m_eyeRegressionTimeLogger && eyeSpan.valid())
+        {
+            m_eyeRegressionTimeLogger(eyeSpan.elapsed());
+        }
+
+        for (int i = 0; i < jobs.size(); i++)
+        {
+            if (jobs[i].valid)
+            {
+                finishEyes(jobs[i], eyes[i], faces[i]);
+            }
+        }
     }
 
     using RectPair = std::array<cv::Rect, 2>;
     using MatPair = std::array<cv::Mat, 2>;
-    static void extractCrops(const cv::Mat& Ib, const RectPair& eyes, const cv::Rect& bounds, MatPair& crops)
+    using ScalePair = std::array<float, 2>;
+
+    // Crops are sampled at the eye regressor target width in a single resample (or none when the
+    // region is already near the target), scales map the crops back to Ib:
+    static void extractCrops(const cv::Mat& Ib, const RectPair& eyes, MatPair& crops, ScalePair& scales, core::PaddingMode mode, int targetWidth)
     {
         for (int i = 0; i < 2; i++)
         {
-            cv::Rect roi = eyes[i] & bounds;
-            if (roi == eyes[i])
+            // Shallow copy, or a crop preserving padded copy in rare case of clipping:
+            cv::Mat crop = core::arenaMat();
+            core::cropWithPadding(Ib, eyes[i], crop, mode);
+
+            scales[i] = 1.f;
+            if ((targetWidth > 0) && (crop.cols > (targetWidth * (1.f + DRISHTI_FACE_DETECTOR_EYE_CROP_TOLERANCE))))
             {
-                crops[i] = Ib(roi); // shallow copy
+                const int targetHeight = std::max(1, static_cast<int>(static_cast<float>(crop.rows * targetWidth) / crop.cols + 0.5f));
+                crops[i] = core::arenaMat();
+                cv::resize(crop, crops[i], { targetWidth, targetHeight }, 0, 0, cv::INTER_AREA);
+                scales[i] = static_cast<float>(crop.cols) / static_cast<float>(targetWidth);
             }
             else
             {
-                // We use a crop preserving deep copy in rare case of clipping
-                crops[i].create(eyes[i].size(), CV_8UC1);
-                crops[i].setTo(0);
-                Ib(roi).copyTo(crops[i](roi - eyes[i].tl()));
+                crops[i] = crop;
             }
         }
     }
 
-    void segmentEyes(const cv::Mat1b& Ib, FaceModel& face, DRISHTI_EYE::EyeModel& eyeR, DRISHTI_EYE::EyeModel& eyeL)
+    using EyeModelPair = std::array<DRISHTI_EYE::EyeModel, 2>;
+
+    static float intersectionOverUnion(const cv::Rect2f& a, const cv::Rect2f& b)
     {
-        cv::Rect2f roiR, roiL;
-        bool hasEyes = face.getEyeRegions(roiR, roiL, 0.666);
-        if (hasEyes && roiR.area() && roiL.area())
+        const float intersection = (a & b).area();
+        return (intersection > 0.f) ? (intersection / (a.area() + b.area() - intersection)) : 0.f;
+    }
+
+    // Find a pre-rendered eye pair that covers both requested regions:
+    static const EyePatches* findEyePatches(const std::vector<EyePatches>& patches, const cv::Rect2f& roiR, const cv::Rect2f& roiL)
+    {
+        const float threshold = 0.5f;
+        for (const auto& p : patches)
         {
-            // clang-format off
-            drishti::core::ScopeTimeLogger scopeTimeLogger = [this](double elapsed)
+            if (!p.images[0].empty() && !p.images[1].empty() && (intersectionOverUnion(p.rois[0], roiR) > threshold) && (intersectionOverUnion(p.rois[1], roiL) > threshold))
             {
-                if (m_eyeRegressionTimeLogger)
-                {
-                    m_eyeRegressionTimeLogger(elapsed);
-                }
-            };
-            // clang-format on
+                return &p;
+            }
+        }
+        return nullptr;
+    }
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    // First start to last completion of the tasks of a stage (stages overlap in the graph):
+    struct StageSpan
+    {
+        void add(const Clock::time_point& start, const Clock::time_point& stop)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            begin = std::min(begin, start);
+            end = std::max(end, stop);
+        }
+        bool valid() const
+        {
+            return end >= begin;
+        }
+        double elapsed() const
+        {
+            return valid() ? drishti::core::ScopeTimeLogger::timeDifference(end, begin) : 0.0;
+        }
 
-            MatPair crops;
-            RectPair eyes = { { roiR, roiL } };
-            extractCrops(Ib, eyes, { { 0, 0 }, Ib.size() }, crops);
+        std::mutex mutex;
+        Clock::time_point begin = Clock::time_point::max();
+        Clock::time_point end = Clock::time_point::min();
+    };
 
-            cv::Mat flipped;
-            cv::flip(crops[1], flipped, 1); // Flip left eye to right eye cs
-            crops[1] = flipped;
+    struct EyeJob
+    {
+        MatPair crops;
+        RectPair eyes;
+        std::array<cv::Point2f, 2> origins; // crop origin in Ib
+        ScalePair scales{ { 1.f, 1.f } };    // crop to Ib scale
+        bool mirrored = false;              // left eye crop is unflipped (mirrored sampling)
+        bool iris = true;                   // kEyeFull
+        bool valid = false;
+    };
+
+    // Eye mode (reported in FaceModel::eyeMode) and crops for one face with landmarks
+    // (job.valid == false to skip the eyes):
+    void prepareEyes(const PaddedImage& image, FaceModel& face, EyeJob& job, EyeModelPair& result)
+    {
+        face.eyeMode = core::Field<int>(); // tracked faces carry the mode of the last update
 
-            cv::Point2f v = geometry::centroid<float, float>(roiR) - geometry::centroid<float, float>(roiL);
-            float theta = std::atan2(v.y, v.x);
-            eyeR.angle = theta;
-            eyeL.angle = (-theta);
+        cv::Rect2f roiR, roiL;
+        bool hasEyes = face.getEyeRegions(roiR, roiL, DRISHTI_FACE_DETECTOR_EYE_CROP_SCALE);
+        if (!(hasEyes && roiR.area() && roiL.area()))
+        {
+            return;
+        }
 
-            std::array<DRISHTI_EYE::EyeModel*, 2> results{ { &eyeR, &eyeL } };
-            for (int i = 0; i < 2; i++)
-            {
-                m_eyeRegressor[i]->setDoIndependentIrisAndPupil(m_doIrisRefinement);
-                m_eyeRegressor[i]->setEyelidInits(1);
-                m_eyeRegressor[i]->setIrisInits(1);
-            }
+        EyeMode mode = kEyeFull;
+        if (m_doEyeResolution)
+        {
+            // Distance from the eye separation in pixels (see FaceModelEstimator):
+            const float ipd = face.getInterPupillaryDistance();
+            const float f = m_eyeResolution.focalLength;
+            const float distance = ((f > 0.f) && (ipd > 0.f)) ? (f * DRISHTI_FACE_DETECTOR_IPD / ipd) : 0.f;
+            mode = getEyeMode(m_eyeResolution, std::min(roiR.width, roiL.width), distance);
+        }
+        if ((mode != kEyeSkip) && m_eyeModeCallback)
+        {
+            std::lock_guard<std::mutex> lock(m_eyeModeMutex); // the callback is serialized
+            mode = std::max(mode, m_eyeModeCallback(face));
+        }
+        face.eyeMode = static_cast<int>(mode);
+        if (mode == kEyeSkip)
+        {
+            return;
+        }
+
+        job.valid = true;
+        job.iris = (mode == kEyeFull);
+
+        if (const auto* patches = findEyePatches(image.eyes, roiR, roiL))
+        {
+            // Ready to regress: already cropped, flipped and resized
+            job.crops = patches->images;
+            job.eyes = { { patches->rois[0], patches->rois[1] } };
+            job.origins = { { patches->rois[0].tl(), patches->rois[1].tl() } };
+            job.scales[0] = job.scales[1] = patches->rois[0].width / static_cast<float>(patches->images[0].cols);
+        }
+        else
+        {
+            // Both lanes share the target width (see EyeModelEstimator::setTargetWidth()):
+            const int targetWidth = m_eyeRegressor[0]->getOptions().targetWidth;
+
+            const cv::Mat1b Ib = image.Ib;
+            job.eyes = { { roiR, roiL } };
+            job.origins = { { job.eyes[0].tl(), job.eyes[1].tl() } };
+            extractCrops(Ib, job.eyes, job.crops, job.scales, m_eyeCropPadding, targetWidth);
+            job.mirrored = true; // the left eye is sampled in place, in right eye cs
+        }
 
-            drishti::core::ParallelHomogeneousLambda harness = [&](int i) {
-                (*m_eyeRegressor[i])(crops[i], *results[i]);
-            };
+        cv::Point2f v = geometry::centroid<float, float>(roiR) - geometry::centroid<float, float>(roiL);
+        float theta = std::atan2(v.y, v.x);
+        result[0].angle = theta;
+        result[1].angle = (-theta);
+    }
+
+    // Per call options, so concurrent eye tasks only read the regressors:
+    void regressEye(int lane, const EyeJob& job, DRISHTI_EYE::EyeModel& eye)
+    {
+        auto options = m_eyeRegressor[lane]->getOptions();
+        options.eyelidInits = m_eyelidInits;
+        options.irisInits = m_irisInits;
+        options.targetTolerance = DRISHTI_FACE_DETECTOR_EYE_CROP_TOLERANCE; // crops are sampled near the target
+        options.doIndependentIrisAndPupil = m_doIrisRefinement && job.iris;
+        options.mirrored = (lane == 1) && job.mirrored;
+        (*m_eyeRegressor[lane])(job.crops[lane], eye, options);
+    }
 
-            //harness({0, 2});
-            cv::parallel_for_({ 0, 2 }, harness, 2);
+    // Map both eye models from the crops to Ib and attach them to the face:
+    static void finishEyes(const EyeJob& job, EyeModelPair& eyes, FaceModel& f)
+    {
+        auto& eyeR = eyes[0];
+        auto& eyeL = eyes[1];
+        if (!job.mirrored)
+        {
+            eyeL.flop(job.crops[1].cols); // pre-rendered patches are flipped
+        }
+        if (job.scales[0] != 1.f)
+        {
+            eyeR *= job.scales[0];
+        }
+        if (job.scales[1] != 1.f)
+        {
+            eyeL *= job.scales[1];
+        }
+        eyeL += job.origins[1]; // shift features to image coordinate system
+        eyeR += job.origins[0];
+        eyeR.roi = job.eyes[0];
+        eyeL.roi = job.eyes[1];
 
-            eyeL.flop(crops[1].cols);
-            eyeL += eyes[1].tl(); // shift features to image coordinate system
-            eyeR += eyes[0].tl();
-            eyeR.roi = eyes[0];
-            eyeL.roi = eyes[1];
+        if (eyeR.eyelids.size())
+        {
+            f.eyeFullR = eyeR;
+            f.eyeRightCenter = core::centroid(eyeR.eyelids);
+        }
+        if (eyeL.eyelids.size())
+        {
+            f.eyeFullL = eyeL;
+            f.eyeLeftCenter = core::centroid(eyeL.eyelids);
         }
     }
 
-    void findLandmarks(const PaddedImage& Ib, std::vector<dsdkc::Shape>& shapes, const cv::Matx33f& Hdr_, bool isDetection)
+    struct LandmarkJobs
     {
-        // Scope based eye segmentation timer:
+        std::vector<dsdkc::Shape> shapes;
+        std::vector<drishti::ml::ShapeEstimator::BatchItem> items; // one (image, roi, init) per shape
+        bool isWarm = false; // items start from verified partial shapes
+    };
 
-        // clang-format off
-        drishti::core::ScopeTimeLogger scopeTimeLogger = [this](double elapsed)
+    static void appendPoints(dsdkc::Shape& shape, const std::vector<cv::Point2f>& points)
+    {
+        shape.contour.reserve(shape.contour.size() + points.size());
+        for (const auto& p : points)
         {
-            if (m_regressionTimeLogger)
-            {
-                m_regressionTimeLogger(elapsed);
-            }
-        };
-        // clang-format on
+            const cv::Point q = p + cv::Point2f(shape.roi.tl());
+            shape.contour.emplace_back(q.x, q.y, 0);
+        }
+    }
+
+    // Map the shape ROIs to the regression image and verify detections (see regressLandmarks()):
+    void prepareLandmarks(const PaddedImage& Ib, const cv::Matx33f& Hdr_, bool isDetection, LandmarkJobs& jobs)
+    {
+        auto& shapes = jobs.shapes;
+        auto& items = jobs.items;
 
         const cv::Mat gray = Ib.Ib;
         CV_Assert(gray.type() == CV_8UC1);
 
-        const cv::Rect fullBounds({ 0, 0 }, Ib.Ib.size());
-        const cv::Rect bounds = Ib.roi.area() ? Ib.roi : fullBounds;
-
-        for (auto & shape : shapes)
+        items.resize(shapes.size());
+        for (int i = 0; i < shapes.size(); i++)
         {
+            auto& shape = shapes[i];
+
             // Detection rectangles may have a geometry (w.r.t. face features) that is incompatible with the
             // ROI geometry used for training the face landmark regressor.  In cases where we aim to refine
             // such raw detection rectangles, we must map them onto faces in the landmark regression image
@@ -264,44 +598,119 @@ public:
             // Crop the image such that the ROI to pixel geometry is preserved.  For most cases this is
             // a simple shallow copy/view, but in cases where the border is clipped, then we will effectively
             // perform border padding to achieve this goal.  This make our prediction ROI closest to the ROI
-            // used during training and ensures our cascaded pose regression has the best chance of success.
-            cv::Mat crop = geometryPreservingCrop(shape.roi, gray);
+            // used during training and ensures our cascaded pose regression has the best chance of success
+            // (see ShapeEstimator::getCrop()).
+            items[i].image = gray;
+            items[i].roi = shape.roi;
+        }
 
-            std::vector<bool> mask;
-            std::vector<cv::Point2f> points;
-            (*m_regressor)(crop, points, mask);
-            for (const auto& p : points)
+        // Verify detections after a few stages, the survivors continue from their partial shapes:
+        jobs.isWarm = false;
+        if (isDetection && (m_verification.stages > 0) && m_regressor->isMirrorable() && !shapes.empty())
+        {
+            verifyLandmarks(shapes, items);
+            jobs.isWarm = true;
+        }
+    }
+
+    // All faces in one batch: the regressor is const and reentrant, so the backend may regress the
+    // faces concurrently (see getBatchExecutor()), or offload the batch (see setRegressionBackend()):
+    void regressLandmarks(LandmarkJobs& jobs)
+    {
+        if (jobs.shapes.empty())
+        {
+            return;
+        }
+
+        drishti::ml::ShapeEstimator::Options options;
+        if (jobs.isWarm)
+        {
+            if (m_verification.stages >= m_regressor->getStagesHint())
             {
-                const cv::Point q = p + cv::Point2f(shape.roi.tl());
-                shape.contour.emplace_back(q.x, q.y, 0);
+                for (int i = 0; i < jobs.shapes.size(); i++)
+                {
+                    auto points = jobs.items[i].init;
+                    unnormalizePoints(points, jobs.items[i].roi.size());
+                    appendPoints(jobs.shapes[i], points);
+                }
+                return;
             }
+            options.first = m_verification.stages;
+        }
+
+        std::vector<std::vector<cv::Point2f>> points;
+        m_regressor->estimateBatch(jobs.items, points, options, getBatchExecutor());
+        for (int i = 0; i < jobs.shapes.size(); i++)
+        {
+            appendPoints(jobs.shapes[i], points[i]);
         }
     }
 
-    static cv::Rect scaleRoi(const cv::Rect& roi, float scale)
+    // Run the first m_verification.stages stages for all faces and drop (shape, item) pairs with a
+    // partial shape that isn't similar to the mean shape.  The partial shapes of the survivors are
+    // stored in the items normalized by the roi size (i.e., ready for a warm start):
+    void verifyLandmarks(std::vector<dsdkc::Shape>& shapes, std::vector<drishti::ml::ShapeEstimator::BatchItem>& items)
     {
-        cv::Point2f tl(roi.tl()), br(roi.br()), center((tl + br) * 0.5f), diag(br - center);
-        return cv::Rect(center - (diag * scale), center + (diag * scale));
+        const std::vector<cv::Point2f> mu = m_regressor->getMeanShape();
+
+        drishti::ml::ShapeEstimator::Options options;
+        options.stages = m_verification.stages;
+
+        std::vector<std::vector<cv::Point2f>> partial;
+        m_regressor->estimateBatch(items, partial, options, getBatchExecutor());
+
+        std::vector<float> residuals(shapes.size(), std::numeric_limits<float>::max());
+        for (std::size_t i = 0; i < shapes.size(); i++)
+        {
+            auto& p = partial[i];
+            if (p.size() >= 3)
+            {
+                const float sx = 1.f / float(items[i].roi.width), sy = 1.f / float(items[i].roi.height);
+                for (auto& q : p)
+                {
+                    q = { q.x * sx, q.y * sy };
+                }
+
+                // Both point sets are normalized in place, so the rmse is scale invariant:
+                const int n = int(std::min(p.size(), mu.size()));
+                std::vector<cv::Point2f> p0(mu.begin(), mu.begin() + n), p1(p.begin(), p.begin() + n);
+                transformation::estimateGlobMotionLeastSquaresSimilarity(n, p0.data(), p1.data(), &residuals[i]);
+            }
+        }
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < shapes.size(); i++)
+        {
+            if (residuals[i] <= m_verification.threshold)
+            {
+                shapes[count] = std::move(shapes[i]);
+                items[count] = items[i];
+                items[count].init = std::move(partial[i]);
+                count++;
+            }
+        }
+
+        m_verificationCandidates += shapes.size();
+        m_verificationRejected += (shapes.size() - count);
+
+        shapes.resize(count);
+        items.resize(count);
     }
 
-    // Return requested light weight copy if roi is contained in frame bounds,
-    // else perform a deep copy that preseves the crop geometry via border
-    // padding.  This ensures that landmark regression has the best chance of
-    // success.
-    static cv::Mat geometryPreservingCrop(const cv::Rect& roi, const cv::Mat& gray)
+    static void unnormalizePoints(std::vector<cv::Point2f>& points, const cv::Size& size)
     {
-        const cv::Rect bounds({ 0, 0 }, gray.size());
-        const cv::Rect clipped = roi & bounds;
-        cv::Mat crop = gray(clipped);
-        if (clipped.size() != roi.size())
+        for (auto& p : points)
         {
-            cv::Mat padded(roi.size(), gray.type(), cv::Scalar::all(0));
-            crop.copyTo(padded(clipped - roi.tl()));
-            cv::swap(crop, padded);
+            p = { p.x * float(size.width), p.y * float(size.height) };
         }
-        return crop;
     }
-    
+
+    static cv::Rect scaleRoi(const cv::Rect& roi, float scale)
+    {
+        cv::Point2f tl(roi.tl()), br(roi.br()), center((tl + br) * 0.5f), diag(br - center);
+        return cv::Rect(center - (diag * scale), center + (diag * scale));
+    }
+
     // This comment block describes how we map rectangles from face detections
     // to recangles with an appropriate geometry to start the landmark
     // regression process.
@@ -409,10 +818,10 @@ public:
     void shapesToFaces(std::vector<dsdkc::Shape>& shapes, std::vector<FaceModel>& faces)
     {
         faces.clear();
+        const auto landmarks = m_regressor ? m_regressor->getLandmarks() : std::vector<int>();
         for (auto& s : shapes)
         {
-            FaceModel f;
-            faces.push_back(shapeToFace(s, m_landmarkFormat));
+            faces.push_back(shapeToFace(s, m_landmarkFormat, landmarks));
         }
     }
 
@@ -425,18 +834,20 @@ public:
             shape.contour.emplace_back(roi.x + p.x * roi.width, roi.y + p.y * roi.height, 0);
         }
 
-        DRISHTI_FACE::FaceModel face = shapeToFace(shape, m_landmarkFormat);
+        DRISHTI_FACE::FaceModel face = shapeToFace(shape, m_landmarkFormat, regressor.getLandmarks());
 
         return face;
     }
 
-    FaceModel getMeanShape(const cv::Size2f& size) const
+    FaceModel getMeanShape(const cv::Size2f& size)
     {
+        join();
         return getMeanShape(*m_regressor, cv::Rect2f({ 0.f, 0.f }, size));
     }
 
-    FaceModel getMeanShape(const cv::Rect2f& roi) const
+    FaceModel getMeanShape(const cv::Rect2f& roi)
     {
+        join();
         return getMeanShape(*m_regressor, roi);
     }
 
@@ -453,7 +864,8 @@ public:
     void setFaceDetectorMean(const FaceModel& mu)
     {
         m_faceDetectorMean = mu;
-        if (m_regressor)
+        m_hasFaceDetectorMean = true;
+        if (m_regressor) // else deferred to join()
         {
             m_Hrd = getAffineMotionFromRegressorToDetector(*m_regressor);
         }
@@ -476,10 +888,22 @@ public:
     {
         m_doEyeRefinement = flag;
     }
+    void setEyeCropPadding(core::PaddingMode mode)
+    {
+        m_eyeCropPadding = mode;
+    }
     void setInits(int inits)
     {
         m_inits = inits;
     }
+    void setEyelidInits(int inits)
+    {
+        m_eyelidInits = std::max(inits, 1);
+    }
+    void setIrisInits(int inits)
+    {
+        m_irisInits = std::max(inits, 1);
+    }
     void setDoNMS(bool doNMS)
     {
         m_detector->setDoNonMaximaSuppression(doNMS);
@@ -508,10 +932,106 @@ public:
     {
         m_eyeRegressionTimeLogger = std::move(logger);
     }
+    void setEyeResolution(const EyeResolution& resolution)
+    {
+        m_eyeResolution = resolution;
+        m_doEyeResolution = true;
+    }
+
+    void setEyeModeCallback(EyeModeCallback callback)
+    {
+        m_eyeModeCallback = std::move(callback);
+    }
     void setEyeCropper(EyeCropper& cropper)
     {
         m_eyeCropper = cropper;
     }
+    void setThreadPool(std::shared_ptr<tp::ThreadPool<>> threads)
+    {
+        m_threads = std::move(threads);
+    }
+    void setThreadCount(int count)
+    {
+        m_threadCount = count;
+    }
+    void setRegressionBackend(std::shared_ptr<drishti::ml::RTEShapeEstimator::Backend> backend)
+    {
+        m_regressionBackend = backend;
+        bindRegressionBackend();
+    }
+
+    // The backend is installed in the landmark regressor, which may be loaded later (see join()):
+    void bindRegressionBackend()
+    {
+        if (auto* regressor = dynamic_cast<drishti::ml::RTEShapeEstimator*>(m_regressor.get()))
+        {
+            regressor->setBackend(m_regressionBackend);
+        }
+    }
+    void setVerification(const Verification& verification)
+    {
+        m_verification = verification;
+    }
+    VerificationStats getVerificationStats() const
+    {
+        VerificationStats stats;
+        stats.candidates = m_verificationCandidates;
+        stats.rejected = m_verificationRejected;
+        return stats;
+    }
+    int getThreadCount() const
+    {
+        return m_threadCount;
+    }
+
+    // Workers allocate frame temporaries from the caller's arena (see core::FrameArena):
+    struct ArenaLoopBody : public cv::ParallelLoopBody
+    {
+        ArenaLoopBody(const cv::ParallelLoopBody& body)
+            : body(body)
+            , arena(drishti::core::FrameArena::current())
+        {
+        }
+
+        void operator()(const cv::Range& range) const override
+        {
+            drishti::core::FrameArena::Scope scope(arena);
+            body(range);
+        }
+
+        const cv::ParallelLoopBody& body;
+        drishti::core::FrameArena* arena = nullptr;
+    };
+
+    // Parallel regression with (at most) m_threadCount workers:
+    void dispatch(const cv::Range& range, const cv::ParallelLoopBody& lanes)
+    {
+        const ArenaLoopBody body(lanes);
+        if (m_threadCount == 1)
+        {
+            body(range);
+        }
+        else if ((m_threadCount > 1) && m_threads)
+        {
+            drishti::core::ParallelSettings settings;
+            settings.pool = m_threads.get();
+            settings.threads = m_threadCount;
+            settings.grain = 1;
+            drishti::core::parallelFor(range, body, settings);
+        }
+        else
+        {
+            drishti::core::parallelFor(range, body, m_threads.get());
+        }
+    }
+
+    // Batch regression on the same workers (see ShapeEstimator::estimateBatch()):
+    drishti::ml::ShapeEstimator::BatchExecutor getBatchExecutor()
+    {
+        return [this](int n, const std::function<void(int)>& job) {
+            dispatch({ 0, n }, drishti::core::ParallelHomogeneousLambda(job));
+        };
+    }
 
     void setUprightImage(const cv::Mat& Ib)
     {
@@ -524,13 +1044,20 @@ public:
 
     void setFaceStagesHint(int stages)
     {
+        join();
         if (m_regressor)
         {
             m_regressor->setStagesHint(stages);
         }
     }
+    int getFaceStagesHint()
+    {
+        join();
+        return m_regressor ? m_regressor->getStagesHint() : 0;
+    }
     void setEyelidStagesHint(int stages)
     {
+        join();
         for (auto& regressor : m_eyeRegressor)
         {
             regressor->setEyelidStagesHint(stages);
@@ -538,6 +1065,7 @@ public:
     }
     void setIrisStagesHint(int stages)
     {
+        join();
         for (auto& regressor : m_eyeRegressor)
         {
             regressor->setIrisStagesHint(stages);
@@ -549,27 +1077,59 @@ public:
         return m_detector.get();
     }
 
+    void setDetector(std::unique_ptr<drishti::ml::ObjectDetector> detector)
+    {
+        m_detector = std::move(detector);
+    }
+
 protected:
     FaceSpecification::Format m_landmarkFormat = FaceSpecification::kibug68;
 
     cv::Mat m_Ib;
     bool m_doIrisRefinement = true;
     bool m_doEyeRefinement = true;
+    core::PaddingMode m_eyeCropPadding = core::kPadConstant;
     bool m_doNMSGlobal = false;
     int m_inits = 1;
+    int m_eyelidInits = 1;
+    int m_irisInits = 1;
     float m_scaling = 1.0;
 
     FaceModel m_faceDetectorMean;
+    bool m_hasFaceDetectorMean = false;
     cv::Matx33f m_Hrd = cv::Matx33f::eye();
 
     TimeLoggerType m_detectionTimeLogger;
     TimeLoggerType m_regressionTimeLogger;
     TimeLoggerType m_eyeRegressionTimeLogger;
+    EyeModeCallback m_eyeModeCallback;
+    EyeResolution m_eyeResolution;
+    bool m_doEyeResolution = false;
+    std::mutex m_eyeModeMutex;
     std::unique_ptr<drishti::ml::ObjectDetector> m_detector;
-    std::unique_ptr<drishti::ml::ShapeEstimator> m_regressor;
-    std::vector<std::unique_ptr<DRISHTI_EYE::EyeModelEstimator>> m_eyeRegressor;
+    std::shared_ptr<drishti::ml::ShapeEstimator> m_regressor;
+    std::vector<std::shared_ptr<DRISHTI_EYE::EyeModelEstimator>> m_eyeRegressor;
+
+    // Regressors still loading (see FaceDetectorFactory::loadAsync()):
+    std::future<std::unique_ptr<drishti::ml::ShapeEstimator>> m_pendingRegressor;
+    std::array<std::future<std::unique_ptr<DRISHTI_EYE::EyeModelEstimator>>, 2> m_pendingEyeRegressor;
+
+    // Replacement regressors (see swapModels()), the previous ones are released with the last reference:
+    mutable std::mutex m_swapMutex;
+    std::future<std::unique_ptr<drishti::ml::ShapeEstimator>> m_swapRegressor;
+    std::array<std::future<std::unique_ptr<DRISHTI_EYE::EyeModelEstimator>>, 2> m_swapEyeRegressor;
+    std::atomic<int> m_modelGeneration{ 0 };
 
     EyeCropper m_eyeCropper;
+    std::shared_ptr<tp::ThreadPool<>> m_threads; // (optional)
+    int m_threadCount = 0;                       // 0 == no limit
+    drishti::core::TaskGraph m_graph;            // rebuilt by each refineFace() call
+
+    std::shared_ptr<drishti::ml::RTEShapeEstimator::Backend> m_regressionBackend; // (optional)
+
+    Verification m_verification;
+    std::atomic<std::size_t> m_verificationCandidates{ 0 };
+    std::atomic<std::size_t> m_verificationRejected{ 0 };
 };
 
 // ((((((((((((( API )))))))))))))
@@ -579,6 +1139,36 @@ FaceDetector::FaceDetector(FaceDetectorFactory& resources)
 {
 }
 
+FaceDetector::FaceDetector(FaceDetectorFactory::Models& models)
+    : m_impl(drishti::core::make_unique<Impl>(models))
+{
+}
+
+void FaceDetector::join()
+{
+    m_impl->join();
+}
+
+bool FaceDetector::swapModels(FaceDetectorFactory::Models& models)
+{
+    return m_impl->swapModels(models);
+}
+
+bool FaceDetector::isSwapPending() const
+{
+    return m_impl->isSwapPending();
+}
+
+int FaceDetector::getModelGeneration() const
+{
+    return m_impl->getModelGeneration();
+}
+
+bool FaceDetector::isReady() const
+{
+    return m_impl->isReady();
+}
+
 FaceDetector::~FaceDetector() = default;
 
 std::vector<cv::Point2f> FaceDetector::getFeatures() const
@@ -592,6 +1182,10 @@ void FaceDetector::setDoIrisRefinement(bool flag)
 {
     m_impl->setDoIrisRefinement(flag);
 }
+void FaceDetector::setEyeCropPadding(core::PaddingMode mode)
+{
+    m_impl->setEyeCropPadding(mode);
+}
 void FaceDetector::setDoEyeRefinement(bool flag)
 {
     m_impl->setDoEyeRefinement(flag);
@@ -600,6 +1194,14 @@ void FaceDetector::setInits(int inits)
 {
     m_impl->setInits(inits);
 }
+void FaceDetector::setEyelidInits(int inits)
+{
+    m_impl->setEyelidInits(inits);
+}
+void FaceDetector::setIrisInits(int inits)
+{
+    m_impl->setIrisInits(inits);
+}
 void FaceDetector::setDoNMS(bool doNMS)
 {
     m_impl->setDoNMS(doNMS);
@@ -621,6 +1223,11 @@ drishti::ml::ObjectDetector* FaceDetector::getDetector()
     return m_impl->getDetector();
 }
 
+void FaceDetector::setDetector(std::unique_ptr<drishti::ml::ObjectDetector> detector)
+{
+    m_impl->setDetector(std::move(detector));
+}
+
 void FaceDetector::setLandmarkFormat(FaceSpecification::Format format)
 {
     m_impl->setLandmarkFormat(format);
@@ -687,10 +1294,59 @@ void FaceDetector::setEyeRegressionTimeLogger(TimeLoggerType logger)
 {
     m_impl->setEyeRegressionTimeLogger(std::move(logger));
 }
+void FaceDetector::setEyeResolution(const EyeResolution& resolution)
+{
+    m_impl->setEyeResolution(resolution);
+}
+
+FaceDetector::EyeMode FaceDetector::getEyeMode(const EyeResolution& resolution, float eyeWidth, float distance)
+{
+    if ((eyeWidth < resolution.minEyelidWidth) || ((resolution.maxEyelidDistance > 0.f) && (distance > resolution.maxEyelidDistance)))
+    {
+        return kEyeSkip;
+    }
+    if ((eyeWidth < resolution.minFullWidth) || ((resolution.maxFullDistance > 0.f) && (distance > resolution.maxFullDistance)))
+    {
+        return kEyeEyelids;
+    }
+    return kEyeFull;
+}
+
+void FaceDetector::setEyeModeCallback(EyeModeCallback callback)
+{
+    m_impl->setEyeModeCallback(std::move(callback));
+}
 void FaceDetector::setEyeCropper(EyeCropper& cropper)
 {
     m_impl->setEyeCropper(cropper);
 }
+void FaceDetector::setThreadPool(std::shared_ptr<tp::ThreadPool<>> threads)
+{
+    m_impl->setThreadPool(std::move(threads));
+}
+
+void FaceDetector::setThreadCount(int count)
+{
+    m_impl->setThreadCount(count);
+}
+
+int FaceDetector::getThreadCount() const
+{
+    return m_impl->getThreadCount();
+}
+
+void FaceDetector::setRegressionBackend(std::shared_ptr<drishti::ml::RTEShapeEstimator::Backend> backend)
+{
+    m_impl->setRegressionBackend(backend);
+}
+void FaceDetector::setVerification(const Verification& verification)
+{
+    m_impl->setVerification(verification);
+}
+FaceDetector::VerificationStats FaceDetector::getVerificationStats() const
+{
+    return m_impl->getVerificationStats();
+}
 void FaceDetector::setScaling(float scale)
 {
     m_impl->setScaling(scale);
@@ -715,11 +1371,21 @@ void FaceDetector::setFaceStagesHint(int stages)
     m_impl->setFaceStagesHint(stages);
 }
 
+int FaceDetector::getFaceStagesHint() const
+{
+    return m_impl->getFaceStagesHint();
+}
+
 void FaceDetector::setEyelidStagesHint(int stages)
 {
     m_impl->setEyelidStagesHint(stages);
 }
 
+void FaceDetector::setIrisStagesHint(int stages)
+{
+    m_impl->setIrisStagesHint(stages);
+}
+
 // utility
 
 // Map from normalized coordinate system to input ROI
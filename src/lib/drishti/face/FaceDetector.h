@@ -14,10 +14,13 @@
 #include "drishti/face/drishti_face.h"
 #include "drishti/face/FaceDetectorFactory.h"
 #include "drishti/core/Shape.h"
+#include "drishti/core/padding.h"
 #include "drishti/face/Face.h"
 #include "drishti/face/FaceIO.h"
+#include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
 
 #include "acf/MatP.h"
+#include "thread_pool/thread_pool.hpp" // tp::ThreadPool<>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/objdetect/objdetect.hpp>
@@ -42,9 +45,32 @@ DRISHTI_FACE_NAMESPACE_BEGIN
 
 #define EYE cv::Matx33f::eye()
 
+// Eye crop size relative to the inter-ocular distance (see FaceModel::getEyeRegions()):
+#define DRISHTI_FACE_DETECTOR_EYE_CROP_SCALE 0.666f
+
+// Eye crops within this fraction of the eye regressor target width are not resampled:
+#define DRISHTI_FACE_DETECTOR_EYE_CROP_TOLERANCE 0.1f
+
+// Mean interpupillary distance in meters (see FaceModelEstimator):
+#define DRISHTI_FACE_DETECTOR_IPD 0.064f
+
 class FaceDetector
 {
 public:
+    // Pre-rendered eye pair (e.g., GPU warp + readback) ready for eye model regression:
+    struct EyePatches
+    {
+        std::array<cv::Mat, 2> images; // { right, left }, left eye already flipped to the right eye cs
+        std::array<cv::Rect2f, 2> rois; // source regions in regression image coordinates
+    };
+
+    // Region of the regression image (e.g., GPU readback of the padded face regions only):
+    struct ImageTile
+    {
+        cv::Mat image;
+        cv::Rect roi; // tile region in regression image coordinates
+    };
+
     struct PaddedImage
     {
         PaddedImage() = default;
@@ -67,16 +93,61 @@ public:
         }
         cv::Mat Ib;
         cv::Rect roi;
+        std::vector<EyePatches> eyes; // optional: used in place of crops from Ib when they overlap
     };
 
     using EyeCropper = std::function<std::array<cv::Mat, 2>(const cv::Point2f& L, const cv::Point2f& R)>;
     using MatLoggerType = std::function<int (const cv::Mat &, const std::string &)>;
     using TimeLoggerType = std::function<void (double)>;
 
+    // Per face eye regression level (e.g., blink and head pose gating, see hci::EyeGate):
+    enum EyeMode
+    {
+        kEyeFull,    // eyelids, iris and pupil (see setDoIrisRefinement())
+        kEyeEyelids, // eyelids only
+        kEyeSkip     // no eye models
+    };
+    using EyeModeCallback = std::function<EyeMode(const FaceModel& face)>;
+
+    // Eye regression level by resolution, before the EyeModeCallback (the more restrictive level
+    // wins): faces with eye crops (see FaceModel::getEyeRegions()) narrower than minFullWidth
+    // regression image pixels get eyelids only, narrower than minEyelidWidth no eye models.  With
+    // a focal length (regression image pixels) the distance is estimated from the eye separation
+    // (as in FaceModelEstimator) and checked against the (optional) distance limits in meters:
+    struct EyeResolution
+    {
+        float minFullWidth = 32.f; // sdk::EyeSegmenter::getMinWidth()
+        float minEyelidWidth = 16.f;
+        float focalLength = 0.f;       // 0 == no distance limits
+        float maxFullDistance = 0.f;   // 0 == off
+        float maxEyelidDistance = 0.f; // 0 == off
+    };
+    static EyeMode getEyeMode(const EyeResolution& resolution, float eyeWidth, float distance);
+
+    // Early rejection of false positive detections: the first `stages` face landmark stages run
+    // for every detection, and faces whose partial shape is far from a similarity transformed
+    // mean shape (normalized rmse above threshold) are dropped before the remaining stages and
+    // the eye models (stages <= 0 == off, tracked faces are never verified):
+    struct Verification
+    {
+        int stages = 0;
+        float threshold = 0.2f;
+    };
+
+    struct VerificationStats
+    {
+        std::size_t candidates = 0; // verified detections
+        std::size_t rejected = 0;
+    };
+
     class Impl;
     using Landmarks = std::vector<cv::Point2f>;
 
     explicit FaceDetector(FaceDetectorFactory& Resources);
+
+    // Waits for the object detector only, regressors are joined on first use (or join()).
+    // The mean face future is left for the caller (see setFaceDetectorMean()):
+    explicit FaceDetector(FaceDetectorFactory::Models& models);
     ~FaceDetector();
 
     FaceDetector(const FaceDetector&) = delete;
@@ -86,6 +157,19 @@ public:
 
     void setLandmarkFormat(FaceSpecification::Format format);
 
+    void join();          // wait for background model loading (rethrows load errors)
+    bool isReady() const; // all models are loaded
+
+    // Replace the landmark and eye regressors (e.g., a pruned model under thermal pressure)
+    // without a new detector: the models are installed by the first refine() call after all of
+    // them are loaded, and a call in progress finishes with the previous models.  Stage hints
+    // carry over, and a swap that fails to load (or changes the landmark count) keeps the
+    // current models.  The detector and mean face futures are ignored.  Thread safe, returns
+    // false while a previous swap is pending:
+    bool swapModels(FaceDetectorFactory::Models& models);
+    bool isSwapPending() const;
+    int getModelGeneration() const; // installed swaps
+
     virtual void operator()(const MatP& I, const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H = EYE);
     virtual void setFaceDetectorMean(const FaceModel& mu);
     virtual const FaceModel& getFaceDetectorMean() const;
@@ -97,6 +181,10 @@ public:
     // TODO: Add this for detector modification (cascThr, etc), but eventually make limited public API
     drishti::ml::ObjectDetector* getDetector();
 
+    // Replace the object detector, e.g., with a tiled detector for very large stills (see
+    // ml::ObjectDetectorACFTiled), call this before the detection settings (e.g., setDoNMS()):
+    void setDetector(std::unique_ptr<drishti::ml::ObjectDetector> detector);
+
     virtual std::vector<cv::Point2f> getFeatures() const;
 
     FaceModel getMeanShape(const cv::Size2f& size) const;
@@ -106,21 +194,46 @@ public:
     cv::Size getWindowSize() const;
 
     void setFaceStagesHint(int stages);
+    int getFaceStagesHint() const;
     void setFace2StagesHint(int stages);
     void setEyelidStagesHint(int stages);
     void setIrisStagesHint(int stages);
 
     void setDoIrisRefinement(bool flag);
     void setDoEyeRefinement(bool flag);
+    void setEyeCropPadding(core::PaddingMode mode); // fill for clipped eye crops (default: kPadConstant)
     void setInits(int inits);
+    void setEyelidInits(int inits); // eye model hypotheses (default: 1)
+    void setIrisInits(int inits);
     void setDoNMS(bool doNMS);
     void setDoNMSGlobal(bool flag);
     void setDetectionTimeLogger(TimeLoggerType logger);
     void setRegressionTimeLogger(TimeLoggerType logger);
     void setEyeRegressionTimeLogger(TimeLoggerType logger);
+
+    // Called once per face with the regressed landmarks before eye segmentation (serialized,
+    // possibly from a worker thread):
+    void setEyeModeCallback(EyeModeCallback callback);
+    void setEyeResolution(const EyeResolution& resolution); // off by default
     void setLogger(const MatLoggerType& logger);
     void setHrd(const cv::Matx33f& Hrd); // regression face => detection face
     void setEyeCropper(EyeCropper& cropper);
+
+    // Run the per call task graph of landmark and eye regression on a shared pool (the SDK pool
+    // otherwise, see core::TaskGraph):
+    void setThreadPool(std::shared_ptr<tp::ThreadPool<>> threads);
+
+    // Regression workers including the caller (0 == no limit, 1 == serial), e.g., under thermal pressure:
+    void setThreadCount(int count);
+    int getThreadCount() const;
+
+    // Face landmarks for all faces in one batch on the calling thread (e.g., on the GPU with the
+    // GL context current), with a fallback to the CPU regressor if the backend declines:
+    void setRegressionBackend(std::shared_ptr<drishti::ml::RTEShapeEstimator::Backend> backend);
+
+    void setVerification(const Verification& verification);
+    VerificationStats getVerificationStats() const;
+
     void paint(cv::Mat& frame);
 
     virtual void detect(const MatP& I, std::vector<FaceModel>& faces);
@@ -11,6 +11,7 @@
 #include "drishti/face/FaceDetectorAndTracker.h"
 #include "drishti/face/FaceDetectorAndTrackerImpl.h"
 #include "drishti/face/FaceDetectorAndTrackerNN.h"
+#include "drishti/face/FaceDetectorAndTrackerMotion.h"
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
@@ -22,6 +23,12 @@ FaceDetectorAndTracker::FaceDetectorAndTracker(FaceDetectorFactory& resources)
     m_pImpl = std::make_shared<TrackerNN>();
 }
 
+FaceDetectorAndTracker::FaceDetectorAndTracker(FaceDetectorFactory::Models& models)
+    : FaceDetector(models)
+{
+    m_pImpl = std::make_shared<TrackerNN>();
+}
+
 std::vector<cv::Point2f> FaceDetectorAndTracker::getFeatures() const
 {
     return m_pImpl->getFeatures();
@@ -36,6 +43,38 @@ double FaceDetectorAndTracker::getMaxTrackAge() const
     return m_pImpl->getMaxTrackAge();
 }
 
+void FaceDetectorAndTracker::setDoMotionTracking(bool flag)
+{
+    if (flag != getDoMotionTracking())
+    {
+        const double age = m_pImpl->getMaxTrackAge();
+        if (flag)
+        {
+            m_pImpl = std::make_shared<TrackerMotion>();
+        }
+        else
+        {
+            m_pImpl = std::make_shared<TrackerNN>();
+        }
+        m_pImpl->setMaxTrackAge(age);
+    }
+}
+
+bool FaceDetectorAndTracker::getDoMotionTracking() const
+{
+    return dynamic_cast<TrackerMotion*>(m_pImpl.get()) != nullptr;
+}
+
+void FaceDetectorAndTracker::addMotion(const geometry::MotionCorrespondences& correspondences)
+{
+    m_pImpl->addMotion(correspondences);
+}
+
+void FaceDetectorAndTracker::addMotion(const cv::Matx33f& H)
+{
+    m_pImpl->addMotion(H);
+}
+
 void FaceDetectorAndTracker::operator()(const MatP& I, const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H)
 {
     if (!m_pImpl->hasTracks() || (m_pImpl->trackAge() > m_pImpl->getMaxTrackAge()))
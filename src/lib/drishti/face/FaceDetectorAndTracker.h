@@ -12,6 +12,7 @@
 #define __drishti_face_FaceDetectorAndTracker_h__
 
 #include "drishti/face/FaceDetector.h"
+#include "drishti/geometry/GlobalMotion.h"
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
@@ -20,12 +21,22 @@ class FaceDetectorAndTracker : public FaceDetector
 public:
     class TrackImpl;
     FaceDetectorAndTracker(FaceDetectorFactory& resources);
+    FaceDetectorAndTracker(FaceDetectorFactory::Models& models);
     void operator()(const MatP& I, const PaddedImage& Ib, std::vector<FaceModel>& faces, const cv::Matx33f& H) override;
     std::vector<cv::Point2f> getFeatures() const override;
 
     void setMaxTrackAge(double age);
     double getMaxTrackAge() const;
 
+    // Follow the face with the supplied frame to frame motion instead of the image (TrackerMotion):
+    void setDoMotionTracking(bool flag);
+    bool getDoMotionTracking() const;
+
+    // Motion from the previous frame to the next one in face coordinates, e.g. a GPU flow readback
+    // or a geometry::SimilarityMotionEstimator result, to be consumed by the next operator() call:
+    void addMotion(const geometry::MotionCorrespondences& correspondences);
+    void addMotion(const cv::Matx33f& H);
+
 protected:
     std::shared_ptr<TrackImpl> m_pImpl; // make_unique fails
 };
@@ -49,6 +49,10 @@ public:
 
     virtual std::vector<cv::Point2f> getFeatures() const = 0;
 
+    // Frame to frame motion for the next update(), ignored by image based trackers:
+    virtual void addMotion(const geometry::MotionCorrespondences& correspondences) {}
+    virtual void addMotion(const cv::Matx33f& H) {}
+
     double trackAge() const
     {
         auto tic = std::chrono::system_clock::now();
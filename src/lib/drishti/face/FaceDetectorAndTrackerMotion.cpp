@@ -0,0 +1,128 @@
+/*! -*-c++-*-
+  @file   FaceDetectorAndTrackerMotion.cpp
+  @author David Hirvonen
+  @brief  A motion driven (image free) face tracking variant.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceDetectorAndTrackerMotion.h"
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+TrackerMotion::TrackerMotion() = default;
+
+TrackerMotion::TrackerMotion(const Settings& settings)
+    : m_settings(settings)
+    , m_estimator(settings.motion)
+{
+}
+
+TrackerMotion::~TrackerMotion() = default;
+
+std::vector<cv::Point2f> TrackerMotion::getFeatures() const
+{
+    return m_features;
+}
+
+void TrackerMotion::initialize(const cv::Mat1b& image, const FaceModel& face)
+{
+    TrackImpl::initialize(image, face);
+
+    m_motion = cv::Matx33f::eye();
+    m_hasMotion = false;
+    m_isLost = false;
+    m_missedFrames = 0;
+    m_features.clear();
+}
+
+void TrackerMotion::reset()
+{
+    TrackImpl::reset();
+    m_motion = cv::Matx33f::eye();
+    m_hasMotion = false;
+}
+
+void TrackerMotion::addMotion(const cv::Matx33f& H)
+{
+    m_motion = H * m_motion;
+    m_hasMotion = true;
+}
+
+void TrackerMotion::addMotion(const geometry::MotionCorrespondences& correspondences)
+{
+    if (!m_isInitialized || !m_face.roi.has)
+    {
+        return;
+    }
+
+    // Motion is composed with the pending motion, so the face is at its predicted position:
+    const cv::Rect2f roi = m_motion * cv::Rect2f(m_face.roi.value);
+    const cv::Point2f pad(roi.width * m_settings.padding, roi.height * m_settings.padding);
+    const cv::Rect2f search(roi.tl() - pad, roi.br() + pad);
+
+    geometry::MotionCorrespondences local;
+    for (std::size_t i = 0; i < correspondences.size(); i++)
+    {
+        const cv::Point3f p = m_motion * cv::Point3f(correspondences.x0[i], correspondences.y0[i], 1.f);
+        if (search.contains({ p.x, p.y }))
+        {
+            local.push_back({ correspondences.x0[i], correspondences.y0[i] }, { correspondences.x1[i], correspondences.y1[i] }, correspondences.weights[i]);
+        }
+    }
+
+    auto motion = m_estimator(local);
+    if (!motion.valid)
+    {
+        motion = m_estimator(correspondences); // camera motion
+    }
+
+    if (!motion.valid)
+    {
+        m_isLost = true;
+        return;
+    }
+
+    m_features.clear();
+    for (std::size_t i = 0; i < local.size(); i++)
+    {
+        m_features.emplace_back(local.x1[i], local.y1[i]);
+    }
+
+    addMotion(motion.H);
+}
+
+bool TrackerMotion::update(const cv::Mat1b& image, FaceModel& face)
+{
+    if (m_isLost)
+    {
+        return false;
+    }
+
+    if (m_hasMotion)
+    {
+        m_face = m_motion * m_face;
+        m_motion = cv::Matx33f::eye();
+        m_hasMotion = false;
+        m_missedFrames = 0;
+    }
+    else if (++m_missedFrames > m_settings.maxMissedFrames)
+    {
+        return false;
+    }
+
+    // Only the image geometry is used here:
+    const cv::Rect roi = m_face.roi.value;
+    const float visible = static_cast<float>((roi & cv::Rect({ 0, 0 }, image.size())).area());
+    if (!roi.area() || (visible < static_cast<float>(roi.area()) * m_settings.minVisibleRatio))
+    {
+        return false;
+    }
+
+    face = m_face;
+    return true;
+}
+
+DRISHTI_FACE_NAMESPACE_END
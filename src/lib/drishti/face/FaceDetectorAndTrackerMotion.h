@@ -0,0 +1,68 @@
+/*! -*-c++-*-
+  @file   FaceDetectorAndTrackerMotion.h
+  @author David Hirvonen
+  @brief  Declaration of a motion driven (image free) FaceDetectorAndTracker variant.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The face model is propagated with externally supplied frame to frame motion, such as
+  a readback of the GPU flow grid or the global (camera) motion estimate, so updates
+  never read the CPU image.  Flow correspondences inside the (padded) face region give
+  a local similarity, and the global motion of all correspondences is used when the face
+  region has too little support.
+
+*/
+
+#include "drishti/face/FaceDetectorAndTrackerImpl.h"
+
+#ifndef __drishti_face_FaceDetectorAndTrackerMotion_h__
+#define __drishti_face_FaceDetectorAndTrackerMotion_h__ 1
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+class TrackerMotion : public FaceDetectorAndTracker::TrackImpl
+{
+public:
+    struct Settings
+    {
+        geometry::SimilarityMotionEstimator::Settings motion;
+        float padding = 0.25f;       // face region padding for local correspondences (roi fraction)
+        int maxMissedFrames = 2;     // consecutive updates without motion before the track is dropped
+        float minVisibleRatio = 0.5f; // roi fraction that must remain in the image
+    };
+
+    TrackerMotion();
+    explicit TrackerMotion(const Settings& settings);
+    ~TrackerMotion();
+
+    TrackerMotion(const TrackerMotion&) = delete;
+    TrackerMotion(TrackerMotion&&) = delete;
+    TrackerMotion& operator=(const TrackerMotion&) = delete;
+    TrackerMotion& operator=(TrackerMotion&&) = delete;
+
+    void initialize(const cv::Mat1b& image, const FaceModel& face) override;
+    bool update(const cv::Mat1b& image, FaceModel& face) override;
+    void reset() override;
+    std::vector<cv::Point2f> getFeatures() const override;
+
+    void addMotion(const geometry::MotionCorrespondences& correspondences) override;
+    void addMotion(const cv::Matx33f& H) override;
+
+protected:
+    void initializeWithRegions(const cv::Mat1b& image, const std::vector<cv::Rect>& regions) override {}
+
+    Settings m_settings;
+    geometry::SimilarityMotionEstimator m_estimator;
+
+    cv::Matx33f m_motion = cv::Matx33f::eye(); // accumulated since the last update()
+    bool m_hasMotion = false;
+    bool m_isLost = false; // motion estimation failed
+    int m_missedFrames = 0;
+
+    std::vector<cv::Point2f> m_features; // local flow support (current frame)
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceDetectorAndTrackerMotion_h__
@@ -18,28 +18,103 @@ DRISHTI_FACE_NAMESPACE_BEGIN
 drishti::face::FaceModel loadFaceModel(std::istream& is);
 drishti::face::FaceModel loadFaceModel(const std::string& filename);
 
+static std::size_t getFileSize(const std::string& filename)
+{
+    std::ifstream is(filename, std::ios::binary | std::ios::ate);
+    const auto size = is ? is.tellg() : std::istream::pos_type(-1);
+    return (size != std::istream::pos_type(-1)) ? static_cast<std::size_t>(size) : 0;
+}
+
+// Bytes consumed from a rewound stream (0 for non seekable sources):
+static std::size_t getStreamBytes(std::istream& is)
+{
+    const auto pos = is.tellg();
+    return (pos != std::istream::pos_type(-1)) ? static_cast<std::size_t>(pos) : 0;
+}
+
+// The detector is counted once, although each getFaceDetector() call returns a new copy:
+FaceDetectorFactory::Cache::Cache()
+    : memoryUsage(core::MemoryRegistry::get().add(core::MemoryRegistry::kModel, "FaceDetectorFactory", [this]() {
+        return detectorBytes + faceBytes + eyeBytes;
+    }))
+{
+}
+
 /*
  * FaceDetectorFactor (string)
  */
 
 std::unique_ptr<ml::ObjectDetector> FaceDetectorFactory::getFaceDetector()
 {
+    m_cache->detectorBytes = getFileSize(sFaceDetector);
     return core::make_unique<drishti::ml::ObjectDetectorACF>(sFaceDetector);
 }
 
 std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactory::getFaceEstimator()
 {
-    std::unique_ptr<ml::ShapeEstimator> ptr = core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(sFaceRegressor);
-    inner = isInner(*ptr);
-    return ptr;
+    std::lock_guard<std::mutex> lock(m_cache->faceMutex);
+    if (!m_cache->faceEstimator)
+    {
+        m_cache->faceEstimator = loadFaceEstimator();
+        inner = isInner(*m_cache->faceEstimator);
+    }
+
+    auto ptr = m_cache->faceEstimator->clone();
+    return ptr ? std::move(ptr) : loadFaceEstimator();
 }
 
 std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactory::getEyeEstimator()
 {
+    std::lock_guard<std::mutex> lock(m_cache->eyeMutex);
+    if (!m_cache->eyeEstimator)
+    {
+        m_cache->eyeEstimator = loadEyeEstimator();
+    }
+
+    auto ptr = m_cache->eyeEstimator->clone();
+    return ptr ? std::move(ptr) : loadEyeEstimator();
+}
+
+std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactory::loadFaceEstimator()
+{
+    m_cache->faceBytes = getFileSize(getFaceRegressorName());
+    return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(getFaceRegressorName());
+}
+
+std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactory::loadEyeEstimator()
+{
+    m_cache->eyeBytes = getFileSize(sEyeRegressor);
     return core::make_unique<eye::EyeModelEstimator>(sEyeRegressor);
 }
 
 face::FaceModel FaceDetectorFactory::getMeanFace()
+{
+    std::lock_guard<std::mutex> lock(m_cache->meanMutex);
+    if (!m_cache->meanFace)
+    {
+        m_cache->meanFace = std::make_shared<face::FaceModel>(loadMeanFace());
+    }
+    return *m_cache->meanFace;
+}
+
+FaceDetectorFactory::Models FaceDetectorFactory::loadAsync(tp::ThreadPool<>& threads, bool doDetector)
+{
+    // The second eye estimator waits for the first one and clones the shared prototype:
+    Models models;
+    if (doDetector)
+    {
+        models.detector = threads.process([this]() { return getFaceDetector(); });
+    }
+    models.faceEstimator = threads.process([this]() { return getFaceEstimator(); });
+    for (auto& eyeEstimator : models.eyeEstimators)
+    {
+        eyeEstimator = threads.process([this]() { return getEyeEstimator(); });
+    }
+    models.meanFace = threads.process([this]() { return getMeanFace(); });
+    return models;
+}
+
+face::FaceModel FaceDetectorFactory::loadMeanFace()
 {
     face::FaceModel faceDetectorMean;
     if (!sFaceDetectorMean.empty())
@@ -51,8 +126,14 @@ face::FaceModel FaceDetectorFactory::getMeanFace()
 
 // Here we rely on heuristics for inner/outer designation.  This logic is safe for the
 // current implementatino but would need to be updated as new model types are added.
+// Subset models keep the configured designation (their indices follow the annotation).
 bool FaceDetectorFactory::isInner(drishti::ml::ShapeEstimator &estimator)
 {
+    if (!estimator.getLandmarks().empty())
+    {
+        return inner;
+    }
+
     switch(estimator.getMeanShape().size())
     {
         case 68: return false;
@@ -70,28 +151,50 @@ bool FaceDetectorFactory::isInner()
  * FaceDetectorFactorStream (std::istream)
  */
 
+// Only reused streams are rewound (the first load of each model never seeks, so
+// non seekable sources are supported):
+static void rewind(std::istream& is)
+{
+    is.clear();
+    const auto pos = is.tellg();
+    if (pos != std::istream::pos_type(-1) && pos != std::istream::pos_type(0))
+    {
+        is.seekg(0, std::ios::beg);
+    }
+    is.clear();
+}
+
 std::unique_ptr<ml::ObjectDetector> FaceDetectorFactoryStream::getFaceDetector()
 {
-    return drishti::core::make_unique<ml::ObjectDetectorACF>(*iFaceDetector);
+    rewind(*iFaceDetector);
+    auto detector = drishti::core::make_unique<ml::ObjectDetectorACF>(*iFaceDetector);
+    m_cache->detectorBytes = getStreamBytes(*iFaceDetector);
+    return std::move(detector);
 }
 
-std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactoryStream::getFaceEstimator()
+std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactoryStream::loadFaceEstimator()
 {
-    std::unique_ptr<ml::ShapeEstimator> ptr = core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(*iFaceRegressor);
-    inner = isInner(*ptr);
-    return ptr;
+    rewind(*iFaceRegressor);
+    auto estimator = core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(*iFaceRegressor);
+    m_cache->faceBytes = getStreamBytes(*iFaceRegressor);
+    return std::move(estimator);
 }
 
-std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactoryStream::getEyeEstimator()
+std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactoryStream::loadEyeEstimator()
 {
-    iEyeRegressor->clear();
-    iEyeRegressor->seekg(0, std::ios::beg);
-    return core::make_unique<eye::EyeModelEstimator>(*iEyeRegressor, sEyeRegressor);
+    rewind(*iEyeRegressor);
+    auto estimator = core::make_unique<eye::EyeModelEstimator>(*iEyeRegressor, sEyeRegressor);
+    m_cache->eyeBytes = getStreamBytes(*iEyeRegressor);
+    return std::move(estimator);
 }
 
-face::FaceModel FaceDetectorFactoryStream::getMeanFace()
+face::FaceModel FaceDetectorFactoryStream::loadMeanFace()
 {
     face::FaceModel faceDetectorMean;
+    if (iFaceDetectorMean)
+    {
+        rewind(*iFaceDetectorMean);
+    }
     if (iFaceDetectorMean && *iFaceDetectorMean)
     {
         faceDetectorMean = loadFaceModel(*iFaceDetectorMean);
@@ -109,6 +212,7 @@ std::ostream& operator<<(std::ostream& os, const FaceDetectorFactory& factory)
         << "{\n"
         << "  faceDetector " << factory.sFaceDetector << "\n"
         << "  faceRegressor " << factory.sFaceRegressor << "\n"
+        << "  faceRegressorLite " << (factory.lite ? factory.sFaceRegressorLite : std::string()) << "\n"
         << "  eyeRegressor " << factory.sEyeRegressor << "\n"
         << "  faceDetectorMean " << factory.sFaceDetectorMean << "\n"
         << "}";
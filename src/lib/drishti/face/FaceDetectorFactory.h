@@ -13,8 +13,15 @@
 
 #include "drishti/face/drishti_face.h"
 #include "drishti/face/Face.h"
+#include "drishti/core/MemoryRegistry.h"
 
+#include "thread_pool/thread_pool.hpp" // tp::ThreadPool<>
+
+#include <array>
+#include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -47,9 +54,26 @@ public:
     }
     
     virtual std::unique_ptr<drishti::ml::ObjectDetector> getFaceDetector();
+
+    // Regressors are loaded once (thread safe), and each call returns a new instance that
+    // shares the read only model weights (e.g., for per thread FaceDetector instances):
     virtual std::unique_ptr<drishti::ml::ShapeEstimator> getFaceEstimator();
     virtual std::unique_ptr<drishti::eye::EyeModelEstimator> getEyeEstimator();
-    virtual drishti::face::FaceModel getMeanFace();
+    virtual drishti::face::FaceModel getMeanFace(); // loaded once
+
+    // Models decoded concurrently in the background (see loadAsync()):
+    struct Models
+    {
+        std::future<std::unique_ptr<drishti::ml::ObjectDetector>> detector;
+        std::future<std::unique_ptr<drishti::ml::ShapeEstimator>> faceEstimator;
+        std::array<std::future<std::unique_ptr<drishti::eye::EyeModelEstimator>>, 2> eyeEstimators;
+        std::future<drishti::face::FaceModel> meanFace;
+    };
+
+    // Submit all model loads to the pool and return immediately.  The factory must outlive
+    // the returned futures, and isInner() is only valid once faceEstimator is ready.  The
+    // detector can be skipped (invalid future), e.g., for a regressor swap:
+    Models loadAsync(tp::ThreadPool<>& threads, bool doDetector = true);
 
     virtual bool isInner(drishti::ml::ShapeEstimator &estimator);
     virtual bool isInner();
@@ -58,10 +82,42 @@ public:
     std::string sFaceRegressor;
     std::string sEyeRegressor;
     std::string sFaceDetectorMean;
-    
+    std::string sFaceRegressorLite; // (optional) subset model: eye and nose points only
+
     bool inner = false;
 
+    // Landmark-lite mode: load sFaceRegressorLite instead of sFaceRegressor when there is one,
+    // i.e., when no consumer needs the full contour (set before the first load):
+    bool lite = false;
+
     std::map<std::string, std::string> sModelBindings;
+
+protected:
+    const std::string& getFaceRegressorName() const
+    {
+        return (lite && !sFaceRegressorLite.empty()) ? sFaceRegressorLite : sFaceRegressor;
+    }
+
+    // Full model deserialization (called once per factory, or when sharing isn't supported):
+    virtual std::unique_ptr<drishti::ml::ShapeEstimator> loadFaceEstimator();
+    virtual std::unique_ptr<drishti::eye::EyeModelEstimator> loadEyeEstimator();
+    virtual drishti::face::FaceModel loadMeanFace();
+
+    // Prototypes are shared by copies of the factory (and all consumers of a shared factory):
+    struct Cache
+    {
+        Cache();
+
+        std::mutex faceMutex, eyeMutex, meanMutex; // per model, so they can load concurrently
+        std::shared_ptr<drishti::ml::ShapeEstimator> faceEstimator;
+        std::shared_ptr<drishti::eye::EyeModelEstimator> eyeEstimator;
+        std::shared_ptr<drishti::face::FaceModel> meanFace;
+
+        // Serialized model sizes (a proxy for the decoded weights), reported as core::MemoryRegistry::kModel:
+        std::atomic<std::size_t> detectorBytes{ 0 }, faceBytes{ 0 }, eyeBytes{ 0 };
+        core::MemoryRegistry::Registration memoryUsage;
+    };
+    std::shared_ptr<Cache> m_cache = std::make_shared<Cache>();
 };
 
 class FaceDetectorFactoryStream : public FaceDetectorFactory
@@ -82,15 +138,18 @@ public:
     {
     }
 
+    // Streams are rewound for each call, so a factory can be shared by several consumers:
     std::unique_ptr<drishti::ml::ObjectDetector> getFaceDetector() override;
-    std::unique_ptr<drishti::ml::ShapeEstimator> getFaceEstimator() override;
-    std::unique_ptr<drishti::eye::EyeModelEstimator> getEyeEstimator() override;
-    drishti::face::FaceModel getMeanFace() override;
 
     std::istream* iFaceDetector = nullptr;
     std::istream* iFaceRegressor = nullptr;
     std::istream* iEyeRegressor = nullptr;
     std::istream* iFaceDetectorMean = nullptr;
+
+protected:
+    std::unique_ptr<drishti::ml::ShapeEstimator> loadFaceEstimator() override;
+    std::unique_ptr<drishti::eye::EyeModelEstimator> loadEyeEstimator() override;
+    drishti::face::FaceModel loadMeanFace() override;
 };
 
 std::ostream& operator<<(std::ostream& os, const FaceDetectorFactory& factory);
@@ -0,0 +1,163 @@
+/*!
+  @file   face/FaceDetectorFactoryBundle.cpp
+  @author David Hirvonen
+  @brief  Utility class implementation for loading FaceDetectorFactory from a single model bundle.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+// Need std:: extensions for android targets
+#include "drishti/core/drishti_stdlib_string.h"
+
+#include "drishti/face/FaceDetectorFactoryBundle.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
+#include "drishti/eye/EyeModelEstimator.h"
+#include "drishti/core/make_unique.h"
+
+#include <nlohmann/json.hpp> // nlohman-json
+
+#include <boost/filesystem.hpp> // for portable path (de)construction
+
+#include <fstream>
+
+namespace bfs = boost::filesystem;
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+drishti::face::FaceModel loadFaceModel(std::istream& is);
+
+static std::string cat(const std::string& a, const std::string& b) { return a + b; }
+
+static const char* kBindings[] = { "face_detector", "eye_model_regressor", "face_landmark_regressor", "face_detector_mean", "face_landmark_regressor_lite" };
+
+FaceDetectorFactoryBundle::FaceDetectorFactoryBundle(const std::string& sBundle, const std::string& sVariant)
+    : FaceDetectorFactoryBundle(drishti::core::ModelBundle::map(sBundle), sVariant)
+{
+}
+
+FaceDetectorFactoryBundle::FaceDetectorFactoryBundle(std::shared_ptr<drishti::core::ModelBundle> bundle, const std::string& sVariant)
+    : m_bundle(std::move(bundle))
+    , m_variant(sVariant)
+{
+    if (!m_bundle)
+    {
+        throw std::runtime_error("FaceDetectorFactoryBundle::FaceDetectorFactoryBundle() invalid bundle");
+    }
+
+    // The entry names are used for reporting (e.g., operator<<):
+    std::vector<std::pair<const char*, std::string*>> bindings = {
+        { "face_detector", &sFaceDetector },
+        { "eye_model_regressor", &sEyeRegressor },
+        { "face_landmark_regressor", &sFaceRegressor },
+        { "face_detector_mean", &sFaceDetectorMean }
+    };
+
+    for (auto& binding : bindings)
+    {
+        (*binding.second) = resolve(binding.first);
+        if (!m_bundle->has(*binding.second) && (binding.second != &sFaceDetectorMean))
+        {
+            throw std::runtime_error(cat("FaceDetectorFactoryBundle::FaceDetectorFactoryBundle() missing ", binding.first));
+        }
+    }
+
+    // Optional subset landmark model (see FaceDetectorFactory::lite):
+    const std::string lite = resolve("face_landmark_regressor_lite");
+    if (m_bundle->has(lite))
+    {
+        sFaceRegressorLite = lite;
+    }
+}
+
+std::string FaceDetectorFactoryBundle::resolve(const std::string& binding) const
+{
+    const std::string name = m_variant.empty() ? binding : (m_variant + "/" + binding);
+    return m_bundle->has(name) ? name : binding;
+}
+
+std::shared_ptr<std::istream> FaceDetectorFactoryBundle::open(const std::string& name) const
+{
+    auto is = m_bundle->open(name);
+    if (!is)
+    {
+        throw std::runtime_error(cat("FaceDetectorFactoryBundle::open() failed to decode ", name));
+    }
+    return is;
+}
+
+std::unique_ptr<ml::ObjectDetector> FaceDetectorFactoryBundle::getFaceDetector()
+{
+    auto is = open(sFaceDetector);
+    m_cache->detectorBytes = m_bundle->find(sFaceDetector)->size;
+    return core::make_unique<ml::ObjectDetectorACF>(*is);
+}
+
+std::unique_ptr<ml::ShapeEstimator> FaceDetectorFactoryBundle::loadFaceEstimator()
+{
+    auto is = open(getFaceRegressorName());
+    m_cache->faceBytes = m_bundle->find(getFaceRegressorName())->size;
+    return core::make_unique<ml::RegressionTreeEnsembleShapeEstimator>(*is);
+}
+
+std::unique_ptr<eye::EyeModelEstimator> FaceDetectorFactoryBundle::loadEyeEstimator()
+{
+    auto is = open(sEyeRegressor);
+    m_cache->eyeBytes = m_bundle->find(sEyeRegressor)->size;
+    return core::make_unique<eye::EyeModelEstimator>(*is, sEyeRegressor);
+}
+
+face::FaceModel FaceDetectorFactoryBundle::loadMeanFace()
+{
+    face::FaceModel faceDetectorMean;
+    if (m_bundle->has(sFaceDetectorMean))
+    {
+        faceDetectorMean = loadFaceModel(*open(sFaceDetectorMean));
+    }
+    return faceDetectorMean;
+}
+
+bool FaceDetectorFactoryBundle::pack(const std::string& sModels, const std::string& sBundle, drishti::core::ModelBundle::Compression compression)
+{
+    std::ifstream ifs(sModels);
+    if (!ifs)
+    {
+        return false;
+    }
+
+    nlohmann::json json;
+    ifs >> json;
+
+    // Default bindings, followed by the variant overrides:
+    std::vector<std::pair<std::string, const nlohmann::json*>> sources = { { "", &json } };
+    if (json.count("variants"))
+    {
+        for (auto iter = json["variants"].begin(); iter != json["variants"].end(); iter++)
+        {
+            sources.emplace_back(iter.key() + "/", &iter.value());
+        }
+    }
+
+    drishti::core::ModelBundleWriter writer;
+    const auto path = bfs::path(sModels).parent_path();
+    for (const auto& source : sources)
+    {
+        for (const auto& binding : kBindings)
+        {
+            if (source.second->count(binding))
+            {
+                const auto filename = path / source.second->at(binding).get<std::string>();
+                if (!writer.addFile(source.first + binding, filename.string(), compression))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return writer.write(sBundle);
+}
+
+DRISHTI_FACE_NAMESPACE_END
@@ -0,0 +1,58 @@
+/*!
+  @file   FaceDetectorFactoryBundle.h
+  @author David Hirvonen
+  @brief  Utility class declaration for loading FaceDetectorFactory from a single model bundle.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+*/
+
+#ifndef __drishti_face_FaceDetectorFactoryBundle_h__
+#define __drishti_face_FaceDetectorFactoryBundle_h__
+
+#include <drishti/face/FaceDetectorFactory.h>
+#include <drishti/core/ModelBundle.h>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Bindings are resolved from the bundle index (see core::ModelBundle): entries are named
+// after the FaceDetectorFactoryJson bindings ("face_detector", "face_landmark_regressor",
+// "eye_model_regressor", "face_detector_mean" and the optional "face_landmark_regressor_lite"),
+// and variant entries are prefixed with the variant name (e.g., "small/face_detector").  A
+// missing variant entry uses the default.
+//
+// Each load opens its own entry stream (no shared stream state), so the models are
+// verified and decoded concurrently by loadAsync().
+class FaceDetectorFactoryBundle : public FaceDetectorFactory
+{
+public:
+    explicit FaceDetectorFactoryBundle(const std::string& sBundle, const std::string& sVariant = {});
+    explicit FaceDetectorFactoryBundle(std::shared_ptr<drishti::core::ModelBundle> bundle, const std::string& sVariant = {});
+
+    std::unique_ptr<drishti::ml::ObjectDetector> getFaceDetector() override;
+
+    // Pack the models referenced by a JSON descriptor (including variants) into one bundle:
+    static bool pack(const std::string& sModels, const std::string& sBundle, drishti::core::ModelBundle::Compression compression = drishti::core::ModelBundle::kStored);
+
+protected:
+    std::unique_ptr<drishti::ml::ShapeEstimator> loadFaceEstimator() override;
+    std::unique_ptr<drishti::eye::EyeModelEstimator> loadEyeEstimator() override;
+    drishti::face::FaceModel loadMeanFace() override;
+
+    // Entry name for the binding (the variant entry when present):
+    std::string resolve(const std::string& binding) const;
+
+    // Throws std::runtime_error for missing or corrupt entries:
+    std::shared_ptr<std::istream> open(const std::string& name) const;
+
+    std::shared_ptr<drishti::core::ModelBundle> m_bundle;
+    std::string m_variant;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceDetectorFactoryBundle_h__
@@ -23,7 +23,7 @@ DRISHTI_FACE_NAMESPACE_BEGIN
 
 static std::string cat(const std::string& a, const std::string& b) { return a + b; }
 
-FaceDetectorFactoryJson::FaceDetectorFactoryJson(const std::string& sModels)
+FaceDetectorFactoryJson::FaceDetectorFactoryJson(const std::string& sModels, const std::string& sVariant)
 {
     std::ifstream ifs(sModels);
     if (!ifs)
@@ -41,17 +41,32 @@ FaceDetectorFactoryJson::FaceDetectorFactoryJson(const std::string& sModels)
         { "face_detector_mean", &sFaceDetectorMean }
     };
 
+    const nlohmann::json* variant = nullptr;
+    if (!sVariant.empty() && json.count("variants") && json["variants"].count(sVariant))
+    {
+        variant = &json["variants"][sVariant];
+    }
+
     // Get the directory name:
     auto path = bfs::path(sModels);
     for (auto& binding : bindings)
     {
-        auto filename = path.parent_path() / json[binding.first].get<std::string>();
+        const auto& source = (variant && variant->count(binding.first)) ? *variant : json;
+        auto filename = path.parent_path() / source.at(binding.first).get<std::string>();
         (*binding.second) = filename.string();
         if (binding.second->empty())
         {
             throw std::runtime_error(cat("FaceDetectorFactoryJson::FaceDetectorFactoryJson()", binding.first));
         }
     }
+
+    // Optional subset landmark model (see FaceDetectorFactory::lite):
+    static const char* kLite = "face_landmark_regressor_lite";
+    const auto& source = (variant && variant->count(kLite)) ? *variant : json;
+    if (source.count(kLite))
+    {
+        sFaceRegressorLite = (path.parent_path() / source.at(kLite).get<std::string>()).string();
+    }
 }
 
 DRISHTI_FACE_NAMESPACE_END
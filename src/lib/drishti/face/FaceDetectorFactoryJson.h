@@ -17,10 +17,15 @@
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
+// An optional "variants" object maps a variant name (e.g., "pruned" or "small", see
+// hci::DeviceProfile) to bindings that replace the default ones; an unknown or empty
+// variant uses the defaults:
+//
+// { "face_detector" : "...", ..., "variants" : { "small" : { "face_detector" : "..." } } }
 class FaceDetectorFactoryJson : public FaceDetectorFactory
 {
 public:
-    FaceDetectorFactoryJson(const std::string& sModels);
+    FaceDetectorFactoryJson(const std::string& sModels, const std::string& sVariant = {});
 };
 
 DRISHTI_FACE_NAMESPACE_END
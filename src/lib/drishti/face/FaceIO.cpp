@@ -13,6 +13,7 @@
 #include "drishti/core/Shape.h"
 #include "drishti/geometry/Primitives.h"
 
+#include <map>
 #include <numeric>
 
 #include <opencv2/highgui.hpp>
@@ -34,18 +35,26 @@ static cv::Point2f maxPointX(std::vector<cv::Point2f>& points)
     });
 }
 
+// Features of missing groups (subset models) are left unset:
 static void fill(FaceModel& face)
 {
     // Estimate centers for normalization:
-    face.eyeRightCenter = drishti::core::centroid(face.eyeRight);
-    face.eyeLeftCenter = drishti::core::centroid(face.eyeLeft);
-    face.noseTip = drishti::core::centroid(face.nose);
+    if (face.eyeRight.size() && face.eyeLeft.size())
+    {
+        face.eyeRightCenter = drishti::core::centroid(face.eyeRight);
+        face.eyeLeftCenter = drishti::core::centroid(face.eyeLeft);
+
+        face.eyeRightInner = maxPointX(face.eyeRight);
+        face.eyeLeftInner = minPointX(face.eyeLeft);
 
-    face.eyeRightInner = maxPointX(face.eyeRight);
-    face.eyeLeftInner = minPointX(face.eyeLeft);
+        face.eyeRightOuter = minPointX(face.eyeRight);
+        face.eyeLeftOuter = maxPointX(face.eyeRight);
+    }
 
-    face.eyeRightOuter = minPointX(face.eyeRight);
-    face.eyeLeftOuter = maxPointX(face.eyeRight);
+    if (face.nose.size())
+    {
+        face.noseTip = drishti::core::centroid(face.nose);
+    }
 
     if (face.mouthOuter.size())
     {
@@ -118,8 +127,27 @@ FaceSpecification FaceSpecification::create(Format format)
     return spec;
 }
 
-FaceModel shapeToFace(drishti::core::Shape& shape, const FaceSpecification& spec, bool relative = true)
+FaceSpecification::IntVec FaceSpecification::getLiteLandmarks(Format format)
+{
+    const FaceSpecification spec = create(format);
+
+    IntVec landmarks;
+    for (const auto* group : { &spec.eyeR, &spec.eyeL, &spec.nose })
+    {
+        landmarks.insert(landmarks.end(), group->begin(), group->end());
+    }
+    return landmarks;
+}
+
+// Subset models regress points[k] for annotation point landmarks[k] (empty == all points):
+FaceModel shapeToFace(drishti::core::Shape& shape, const FaceSpecification& spec, bool relative = true, const std::vector<int>& landmarks = {})
 {
+    std::map<int, int> positions;
+    for (int k = 0; k < landmarks.size(); k++)
+    {
+        positions[landmarks[k]] = k;
+    }
+
     auto points = shape.getPoints();
 
     FaceModel face;
@@ -148,6 +176,11 @@ FaceModel shapeToFace(drishti::core::Shape& shape, const FaceSpecification& spec
             for (const auto& i : *o.first)
             {
                 int index = relative ? (i - start1 + total) : i;
+                if (!positions.empty())
+                {
+                    const auto iter = positions.find(index);
+                    index = (iter != positions.end()) ? iter->second : int(points.size());
+                }
                 if (index < points.size())
                 {
                     const auto& p = points[index];
@@ -163,7 +196,7 @@ FaceModel shapeToFace(drishti::core::Shape& shape, const FaceSpecification& spec
     return face;
 }
 
-FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind)
+FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind, const std::vector<int>& landmarks)
 {
     auto points = shape.getPoints();
 
@@ -173,7 +206,7 @@ FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kin
 
     // TODO: review relative
     FaceSpecification spec = FaceSpecification::create(kind);
-    return shapeToFace(shape, spec, false); //(kind == FaceSpecification::kHELEN));
+    return shapeToFace(shape, spec, false, landmarks); //(kind == FaceSpecification::kHELEN));
 }
 
 DRISHTI_FACE_NAMESPACE_END
@@ -48,9 +48,14 @@ struct FaceSpecification
     IntVec noseFull;
 
     static FaceSpecification create(Format format);
+
+    // Annotation points used for eye crops, tracking and stabilization (eye corners and
+    // centers, nose tip), e.g., for training a subset model (see shape_predictor_trainer):
+    static IntVec getLiteLandmarks(Format format);
 };
 
-FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind = FaceSpecification::kibug68);
+// Subset models (see ShapeEstimator::getLandmarks()) fill the features of the regressed points only:
+FaceModel shapeToFace(drishti::core::Shape& shape, FaceSpecification::Format kind = FaceSpecification::kibug68, const std::vector<int>& landmarks = {});
 
 DRISHTI_FACE_NAMESPACE_END
 
@@ -48,7 +48,8 @@ public:
     virtual void setRotation(const cv::Point3f &R) {}
     virtual cv::Vec4f getQuaternion() const = 0;
     virtual void setQuaternion(const cv::Vec4f &Q) {}
-    virtual cv::Mat extractTexture(const cv::Mat& image) = 0;
+    virtual cv::Mat extractTexture(const cv::Mat& image) = 0; // CPU (see graphics::IsomapExtractor)
+    virtual cv::Matx34f getAffineCamera() const = 0;          // mesh vertices to image pixels
     virtual void serialize(const std::string &filename) = 0;
     virtual void drawWireFrame(cv::Mat &iso) = 0;    
     virtual void drawWireFrameOnIso(cv::Mat &iso) = 0;
@@ -59,10 +60,28 @@ class FaceMeshMapper
 public:
     using FaceMeshContainerPtr = std::shared_ptr<FaceMeshContainer>;
 
+    // Sequential frames of one subject: full (warm started) fits are run until the identity
+    // coefficients converge, after which they are held fixed and only the pose (and expression)
+    // is re-solved from the previous solution in a few linear iterations.
+    struct TrackingSettings
+    {
+        bool enabled = false;
+        int iterations = 3;       // pose/expression iterations per frame with a fixed identity
+        int maxIdentityFits = 10; // full fits before the identity is fixed (at the latest)
+        float tolerance = 0.01f;  // relative identity coefficient change for convergence
+    };
+
     FaceMeshMapper() = default;
     ~FaceMeshMapper() = default;
     virtual FaceMeshContainerPtr operator()(const std::vector<cv::Point2f>& landmarks, const cv::Mat& image) = 0;
     virtual FaceMeshContainerPtr operator()(const FaceModel& face, const cv::Mat& image) = 0;
+
+    virtual void setTracking(const TrackingSettings& settings) {}
+    virtual void reset() {} // start over with a new subject (tracking mode)
+
+    // New mapper that shares the (read-only) model data, with its own fitting state,
+    // e.g., one per worker thread.  Returns nullptr if the mapper can't be shared.
+    virtual std::shared_ptr<FaceMeshMapper> clone() const { return nullptr; }
 };
 
 DRISHTI_FACE_NAMESPACE_END
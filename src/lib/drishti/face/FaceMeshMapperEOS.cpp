@@ -20,6 +20,8 @@
 
 #include <glm/glm.hpp>
 
+#include <cmath>
+
 DRISHTI_FACE_NAMESPACE_BEGIN
 
 struct GLMTransform
@@ -61,7 +63,7 @@ cv::Matx44f FaceMeshContainerEOS::getModelViewProjection() const
 
 void FaceMeshContainerEOS::getFaceMesh(drishti::graphics::MeshTex &dest) const
 {
-    dest = { mesh.vertices, mesh.texcoords, mesh.tvi };
+    dest = { mesh->vertices, mesh->texcoords, mesh->tvi };
 }
 
 cv::Point3f FaceMeshContainerEOS::getRotation() const
@@ -102,7 +104,15 @@ cv::Mat FaceMeshContainerEOS::extractTexture(const cv::Mat& image)
     const auto interpolation = eos::render::TextureInterpolation::Bilinear;
 
     // Extract the texture from the image using given mesh and camera parameters:
-    return eos::render::extract_texture(mesh, affine_from_ortho, image, false, interpolation);
+    return eos::render::extract_texture(*mesh, affine_from_ortho, image, false, interpolation);
+}
+
+cv::Matx34f FaceMeshContainerEOS::getAffineCamera() const
+{
+    cv::Matx34f A;
+    cv::Mat header(3, 4, CV_32F, A.val); // shares A
+    affine_from_ortho.convertTo(header, CV_32F);
+    return A;
 }
 
 eos::core::LandmarkCollection<cv::Vec2f> convertLandmarks(const std::vector<cv::Point2f>& points)
@@ -120,6 +130,53 @@ eos::core::LandmarkCollection<cv::Vec2f> convertLandmarks(const std::vector<cv::
     return landmarks;
 }
 
+void updateMesh(std::shared_ptr<eos::core::Mesh>& mesh, const cv::Mat& shape)
+{
+    if (mesh.use_count() > 1)
+    {
+        mesh = std::make_shared<eos::core::Mesh>(*mesh);
+    }
+
+    const int count = shape.rows / 3;
+    mesh->vertices.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        mesh->vertices[i] = { shape.at<float>(i * 3 + 0), shape.at<float>(i * 3 + 1), shape.at<float>(i * 3 + 2), 1.f };
+    }
+}
+
+bool IdentityTracker::update(const std::vector<float>& values, const FaceMeshMapper::TrackingSettings& settings)
+{
+    if (!fixed)
+    {
+        double change = 0.0, norm = 0.0;
+        if (coefficients.size() == values.size())
+        {
+            for (int i = 0; i < values.size(); i++)
+            {
+                change += (values[i] - coefficients[i]) * (values[i] - coefficients[i]);
+                norm += values[i] * values[i];
+            }
+        }
+        else
+        {
+            change = norm = 1.0;
+        }
+
+        coefficients = values;
+        fits++;
+        fixed = (std::sqrt(change) <= (settings.tolerance * std::sqrt(norm))) || (fits >= settings.maxIdentityFits);
+    }
+    return fixed;
+}
+
+void IdentityTracker::reset()
+{
+    coefficients.clear();
+    fits = 0;
+    fixed = false;
+}
+
 static cv::Point2f interpolate(const cv::Point2f& p, const cv::Point2f& q, float f)
 {
     return p + (q - p) * f;
@@ -189,28 +246,24 @@ void draw_wireframe(cv::Mat& image, const eos::core::Mesh& mesh, GLMTransform& t
 void FaceMeshContainerEOS::serialize(const std::string& filename)
 {
     // Save the mesh as textured obj:
-    eos::core::write_textured_obj(mesh, filename);
+    eos::core::write_textured_obj(*mesh, filename);
 }
 
 void FaceMeshContainerEOS::drawWireFrameOnIso(cv::Mat& iso)
 {
-    for (auto& p : mesh.texcoords)
-    {
-        p[0] *= iso.cols;
-        p[1] *= iso.rows;
-    }
-
-    for (int i = 0; i < mesh.tvi.size(); i++)
+    // Scale the texture coordinates locally (the mesh may be shared with the mapper):
+    const cv::Point2f scale(iso.cols, iso.rows);
+    for (int i = 0; i < mesh->tvi.size(); i++)
     {
-        const auto& t = mesh.tvi[i];
+        const auto& t = mesh->tvi[i];
 
-        const auto& p0 = mesh.texcoords[t[0]];
-        const auto& p1 = mesh.texcoords[t[1]];
-        const auto& p2 = mesh.texcoords[t[2]];
+        const auto& p0 = mesh->texcoords[t[0]];
+        const auto& p1 = mesh->texcoords[t[1]];
+        const auto& p2 = mesh->texcoords[t[2]];
 
-        cv::Point2f v0(p0[0], p0[1]);
-        cv::Point2f v1(p1[0], p1[1]);
-        cv::Point2f v2(p2[0], p2[1]);
+        cv::Point2f v0(p0[0] * scale.x, p0[1] * scale.y);
+        cv::Point2f v1(p1[0] * scale.x, p1[1] * scale.y);
+        cv::Point2f v2(p2[0] * scale.x, p2[1] * scale.y);
 
         cv::line(iso, v0, v1, { 0, 255, 0 }, 1, 8);
         cv::line(iso, v1, v2, { 0, 255, 0 }, 1, 8);
@@ -222,7 +275,7 @@ void FaceMeshContainerEOS::drawWireFrame(cv::Mat& iso)
 {
     auto viewport = eos::fitting::get_opencv_viewport(iso.cols, iso.rows);
     GLMTransform transform{ rendering_params.get_modelview(), rendering_params.get_projection(), viewport };
-    draw_wireframe(iso, mesh, transform);
+    draw_wireframe(iso, *mesh, transform);
 }
 
 DRISHTI_FACE_NAMESPACE_END
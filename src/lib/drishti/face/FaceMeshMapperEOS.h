@@ -32,7 +32,14 @@ public:
     using RenderingParameters = eos::fitting::RenderingParameters;
     
     FaceMeshContainerEOS(const Mesh &mesh, const RenderingParameters &params, const cv::Mat &affine)
-        : mesh(mesh)
+        : mesh(std::make_shared<Mesh>(mesh))
+        , rendering_params(params)
+        , affine_from_ortho(affine)
+    {}
+
+    // Share the mapper's mesh buffer (see updateMesh()):
+    FaceMeshContainerEOS(std::shared_ptr<const Mesh> mesh, const RenderingParameters &params, const cv::Mat &affine)
+        : mesh(std::move(mesh))
         , rendering_params(params)
         , affine_from_ortho(affine)
     {}
@@ -47,13 +54,14 @@ public:
     virtual cv::Vec4f getQuaternion() const;
     virtual void setQuaternion(const cv::Vec4f &Q);
     virtual cv::Mat extractTexture(const cv::Mat& image);
+    virtual cv::Matx34f getAffineCamera() const;
     virtual void serialize(const std::string &filename);
     virtual void drawWireFrame(cv::Mat &iso);
     virtual void drawWireFrameOnIso(cv::Mat &iso);
     
 protected:
     
-    eos::core::Mesh mesh;
+    std::shared_ptr<const eos::core::Mesh> mesh;
     eos::fitting::RenderingParameters rendering_params;
     cv::Mat affine_from_ortho; // affine_from_ortho
 };
@@ -61,6 +69,22 @@ protected:
 eos::core::LandmarkCollection<cv::Vec2f> convertLandmarks(const std::vector<cv::Point2f>& points);
 eos::core::LandmarkCollection<cv::Vec2f> extractLandmarks(const FaceModel& face);
 
+// Write a shape instance (3N x 1) to the mesh vertices in place, the mesh is only copied
+// while a previously returned container still holds it:
+void updateMesh(std::shared_ptr<eos::core::Mesh>& mesh, const cv::Mat& shape);
+
+// Identity (PCA shape coefficients) convergence for the tracking mode:
+struct IdentityTracker
+{
+    // Returns true when the identity is fixed:
+    bool update(const std::vector<float>& coefficients, const FaceMeshMapper::TrackingSettings& settings);
+    void reset();
+
+    std::vector<float> coefficients;
+    int fits = 0;
+    bool fixed = false;
+};
+
 DRISHTI_FACE_NAMESPACE_END
 
 #endif // __drishti_face_FaceMeshMapperEOS_h__
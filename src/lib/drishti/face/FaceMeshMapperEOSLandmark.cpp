@@ -19,6 +19,7 @@
 #include "eos/render/utils.hpp"
 #include "eos/fitting/nonlinear_camera_estimation.hpp"
 #include "eos/fitting/linear_shape_fitting.hpp"
+#include "eos/fitting/orthographic_camera_estimation_linear.hpp"
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
@@ -27,20 +28,42 @@ struct FaceMeshMapperEOSLandmark::Impl
     using LandmarkSet = eos::core::LandmarkCollection<cv::Vec2f>;
     using FaceMeshContainerPtr = std::shared_ptr<FaceMeshContainer>;
 
+    // Read-only after loading (shared by clones):
+    struct Model
+    {
+        Model(const std::string& modelfile, const std::string& mappingsfile)
+        {
+            morphable_model = eos::morphablemodel::load_model(modelfile);
+            landmark_mapper = mappingsfile.empty() ? eos::core::LandmarkMapper() : eos::core::LandmarkMapper(mappingsfile);
+        }
+
+        eos::morphablemodel::MorphableModel morphable_model;
+        eos::core::LandmarkMapper landmark_mapper;
+    };
+
     Impl(const std::string& modelfile, const std::string& mappingsfile)
+        : model(std::make_shared<Model>(modelfile, mappingsfile))
+    {
+    }
+
+    Impl(const std::shared_ptr<const Model>& model)
+        : model(model)
     {
-        morphable_model = eos::morphablemodel::load_model(modelfile);
-        landmark_mapper = mappingsfile.empty() ? eos::core::LandmarkMapper() : eos::core::LandmarkMapper(mappingsfile);
     }
 
     auto operator()(const LandmarkSet& landmarks, const cv::Mat& image) -> FaceMeshContainerPtr
     {
+        const auto& morphable_model = model->morphable_model;
+        const auto& landmark_mapper = model->landmark_mapper;
+
         // These will be the final 2D and 3D points used for the fitting:
         std::vector<cv::Vec4f> model_points; // the points in the 3D shape model
         std::vector<int> vertex_indices;     // their vertex indices
         std::vector<cv::Vec2f> image_points; // the corresponding 2D landmark points
 
         // Sub-select all the landmarks which we have a mapping for (i.e. that are defined in the 3DMM):
+        // The fixed identity replaces the mean shape in tracking mode:
+        const bool fixed = tracking.enabled && identity.fixed && mesh;
         for (int i = 0; i < landmarks.size(); ++i)
         {
             auto converted_name = landmark_mapper.convert(landmarks[i].name);
@@ -50,12 +73,29 @@ struct FaceMeshMapperEOSLandmark::Impl
                 continue;
             }
             int vertex_idx = std::stoi(converted_name.get());
-            auto vertex = morphable_model.get_shape_model().get_mean_at_point(vertex_idx);
-            model_points.emplace_back(cv::Vec4f(vertex.x(), vertex.y(), vertex.z(), 1.0f));
+            if (fixed)
+            {
+                const auto& vertex = mesh->vertices[vertex_idx];
+                model_points.emplace_back(cv::Vec4f(vertex[0], vertex[1], vertex[2], 1.0f));
+            }
+            else
+            {
+                auto vertex = morphable_model.get_shape_model().get_mean_at_point(vertex_idx);
+                model_points.emplace_back(cv::Vec4f(vertex.x(), vertex.y(), vertex.z(), 1.0f));
+            }
             vertex_indices.emplace_back(vertex_idx);
             image_points.emplace_back(landmarks[i].coordinates);
         }
 
+        if (fixed)
+        {
+            // Pose only (closed form), the mesh vertices are unchanged:
+            const auto ortho = eos::fitting::estimate_orthographic_projection_linear(image_points, model_points, true, image.rows);
+            const eos::fitting::RenderingParameters rendering_params(ortho, image.cols, image.rows);
+            auto affine_from_ortho = get_3x4_affine_camera_matrix(rendering_params, image.cols, image.rows);
+            return std::make_shared<FaceMeshContainerEOS>(mesh, rendering_params, affine_from_ortho);
+        }
+
         // Estimate the camera (pose) from the 2D - 3D point correspondences
         auto rendering_params = eos::fitting::estimate_orthographic_camera(image_points, model_points, image.cols, image.rows);
 
@@ -64,8 +104,23 @@ struct FaceMeshMapperEOSLandmark::Impl
         // Estimate the shape coefficients by fitting the shape to the landmarks:
         auto fitted_coeffs = eos::fitting::fit_shape_to_landmarks_linear(morphable_model, affine_from_ortho, image_points, vertex_indices);
 
-        // Obtain the full mesh with the estimated coefficients:
-        auto mesh = morphable_model.draw_sample(fitted_coeffs, std::vector<float>());
+        if (!tracking.enabled)
+        {
+            // Obtain the full mesh with the estimated coefficients:
+            auto mesh = morphable_model.draw_sample(fitted_coeffs, std::vector<float>());
+            return std::make_shared<FaceMeshContainerEOS>(mesh, rendering_params, affine_from_ortho);
+        }
+
+        // Tracking: update the identity estimate and reuse the mesh buffer:
+        identity.update(fitted_coeffs, tracking);
+        if (!mesh)
+        {
+            mesh = std::make_shared<eos::core::Mesh>(morphable_model.draw_sample(fitted_coeffs, std::vector<float>()));
+        }
+        else
+        {
+            updateMesh(mesh, morphable_model.get_shape_model().draw_sample(fitted_coeffs));
+        }
 
         return std::make_shared<FaceMeshContainerEOS>(mesh, rendering_params, affine_from_ortho);
     }
@@ -75,8 +130,17 @@ struct FaceMeshMapperEOSLandmark::Impl
         return (*this)(extractLandmarks(face), image);
     }
 
-    eos::morphablemodel::MorphableModel morphable_model;
-    eos::core::LandmarkMapper landmark_mapper;
+    void reset()
+    {
+        identity.reset();
+        mesh.reset();
+    }
+
+    std::shared_ptr<const Model> model;
+
+    FaceMeshMapper::TrackingSettings tracking;
+    IdentityTracker identity;
+    std::shared_ptr<eos::core::Mesh> mesh; // tracking mode buffer
 };
 
 FaceMeshMapperEOSLandmark::FaceMeshMapperEOSLandmark(const std::string& modelfile, const std::string& mappingsfile)
@@ -94,4 +158,23 @@ auto FaceMeshMapperEOSLandmark::operator()(const DRISHTI_FACE::FaceModel& face,
     return (*m_pImpl)(face, image);
 }
 
+void FaceMeshMapperEOSLandmark::setTracking(const TrackingSettings& settings)
+{
+    m_pImpl->tracking = settings;
+    m_pImpl->reset();
+}
+
+void FaceMeshMapperEOSLandmark::reset()
+{
+    m_pImpl->reset();
+}
+
+std::shared_ptr<FaceMeshMapper> FaceMeshMapperEOSLandmark::clone() const
+{
+    std::shared_ptr<FaceMeshMapperEOSLandmark> mapper(new FaceMeshMapperEOSLandmark);
+    mapper->m_pImpl = std::make_shared<Impl>(m_pImpl->model);
+    mapper->m_pImpl->tracking = m_pImpl->tracking;
+    return mapper;
+}
+
 DRISHTI_FACE_NAMESPACE_END
@@ -21,11 +21,14 @@
 #include "eos/morphablemodel/MorphableModel.hpp"
 #include "eos/morphablemodel/Blendshape.hpp"
 #include "eos/fitting/fitting.hpp"
+#include "eos/fitting/blendshape_fitting.hpp"
 #include "eos/fitting/nonlinear_camera_estimation.hpp"
+#include "eos/fitting/orthographic_camera_estimation_linear.hpp"
 #include "eos/render/utils.hpp"
 
 #include "opencv2/core.hpp"
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -37,18 +40,53 @@ struct FaceMeshMapperEOSLandmarkContour::Impl
     using LandmarkSet = eos::core::LandmarkCollection<cv::Vec2f>;
     using FaceMeshContainerPtr = std::shared_ptr<FaceMeshContainer>;
 
+    // Read-only after loading (shared by clones):
+    struct Model
+    {
+        Model(const FaceMeshMapperEOSLandmarkContour::Assets& assets)
+        {
+            morphable_model = eos::morphablemodel::load_model(assets.model);
+            landmark_mapper = assets.mappings.empty() ? eos::core::LandmarkMapper() : eos::core::LandmarkMapper(assets.mappings);
+            blendshapes = eos::morphablemodel::load_blendshapes(assets.blendshapes);
+            model_contour = assets.contour.empty() ? eos::fitting::ModelContour() : eos::fitting::ModelContour::load(assets.contour);
+            ibug_contour = eos::fitting::ContourLandmarks::load(assets.mappings);
+            edge_topology = eos::morphablemodel::load_edge_topology(assets.edgetopology);
+            blendshapes_matrix = eos::morphablemodel::to_matrix(blendshapes);
+        }
+
+        eos::morphablemodel::MorphableModel morphable_model;
+        eos::core::LandmarkMapper landmark_mapper;
+        std::vector<eos::morphablemodel::Blendshape> blendshapes;
+        eos::fitting::ModelContour model_contour;
+        eos::fitting::ContourLandmarks ibug_contour;
+        eos::morphablemodel::EdgeTopology edge_topology;
+        cv::Mat blendshapes_matrix;
+    };
+
     Impl(const FaceMeshMapperEOSLandmarkContour::Assets& assets)
+        : Impl(std::make_shared<Model>(assets))
+    {
+    }
+
+    Impl(const std::shared_ptr<const Model>& model)
+        : model(model)
+        , morphable_model(model->morphable_model)
+        , landmark_mapper(model->landmark_mapper)
+        , blendshapes(model->blendshapes)
+        , model_contour(model->model_contour)
+        , ibug_contour(model->ibug_contour)
+        , edge_topology(model->edge_topology)
+        , blendshapes_matrix(model->blendshapes_matrix)
     {
-        morphable_model = eos::morphablemodel::load_model(assets.model);
-        landmark_mapper = assets.mappings.empty() ? eos::core::LandmarkMapper() : eos::core::LandmarkMapper(assets.mappings);
-        blendshapes = eos::morphablemodel::load_blendshapes(assets.blendshapes);
-        model_contour = assets.contour.empty() ? eos::fitting::ModelContour() : eos::fitting::ModelContour::load(assets.contour);
-        ibug_contour = eos::fitting::ContourLandmarks::load(assets.mappings);
-        edge_topology = eos::morphablemodel::load_edge_topology(assets.edgetopology);
     }
 
     auto operator()(const LandmarkSet& landmarks, const cv::Mat& image) -> FaceMeshContainerPtr
     {
+        if (tracking.enabled)
+        {
+            return track(landmarks, image);
+        }
+
         // Fit the model, get back a mesh and the pose:
         eos::core::Mesh mesh;
         eos::fitting::RenderingParameters rendering_params;
@@ -73,12 +111,100 @@ struct FaceMeshMapperEOSLandmarkContour::Impl
         return (*this)(extractLandmarks(face), image);
     }
 
-    eos::morphablemodel::MorphableModel morphable_model;
-    eos::core::LandmarkMapper landmark_mapper;
-    std::vector<eos::morphablemodel::Blendshape> blendshapes;
-    eos::fitting::ModelContour model_contour;
-    eos::fitting::ContourLandmarks ibug_contour;
-    eos::morphablemodel::EdgeTopology edge_topology;
+    auto track(const LandmarkSet& landmarks, const cv::Mat& image) -> FaceMeshContainerPtr
+    {
+        if (!identity.fixed || !mesh)
+        {
+            // Full fit, warm started from the previous solution:
+            std::vector<cv::Vec2f> fitted_image_points;
+            eos::core::Mesh fitted;
+            std::tie(fitted, rendering_params) = eos::fitting::fit_shape_and_pose(
+                morphable_model,
+                blendshapes,
+                landmarks,
+                landmark_mapper,
+                image.cols,
+                image.rows,
+                edge_topology,
+                ibug_contour,
+                model_contour,
+                identity.fits ? tracking.iterations : 50, boost::none, 30.0f,
+                identity.fits ? boost::optional<eos::fitting::RenderingParameters>(rendering_params) : boost::none,
+                shape_coefficients,
+                blendshape_coefficients,
+                fitted_image_points);
+
+            if (identity.update(shape_coefficients, tracking))
+            {
+                shape = morphable_model.get_shape_model().draw_sample(shape_coefficients);
+            }
+            mesh = std::make_shared<eos::core::Mesh>(std::move(fitted));
+        }
+        else
+        {
+            // Fixed identity: alternate pose and expression from the previous solution (no contour search):
+            std::vector<int> vertex_indices;
+            std::vector<cv::Vec2f> image_points;
+            for (const auto& landmark : landmarks)
+            {
+                auto converted_name = landmark_mapper.convert(landmark.name);
+                if (converted_name)
+                {
+                    vertex_indices.emplace_back(std::stoi(converted_name.get()));
+                    image_points.emplace_back(landmark.coordinates);
+                }
+            }
+
+            cv::Mat instance;
+            std::vector<cv::Vec4f> model_points(vertex_indices.size());
+            for (int k = 0; k < std::max(tracking.iterations, 1); k++)
+            {
+                instance = shape + blendshapes_matrix * cv::Mat(blendshape_coefficients);
+                for (int i = 0; i < vertex_indices.size(); i++)
+                {
+                    const int j = vertex_indices[i] * 3;
+                    model_points[i] = { instance.at<float>(j + 0), instance.at<float>(j + 1), instance.at<float>(j + 2), 1.f };
+                }
+
+                const auto ortho = eos::fitting::estimate_orthographic_projection_linear(image_points, model_points, true, image.rows);
+                rendering_params = eos::fitting::RenderingParameters(ortho, image.cols, image.rows);
+                const cv::Mat affine = eos::fitting::get_3x4_affine_camera_matrix(rendering_params, image.cols, image.rows);
+                blendshape_coefficients = eos::fitting::fit_blendshapes_to_landmarks_nnls(blendshapes, shape, affine, image_points, vertex_indices);
+            }
+
+            updateMesh(mesh, shape + blendshapes_matrix * cv::Mat(blendshape_coefficients));
+        }
+
+        cv::Mat affine_from_ortho = eos::fitting::get_3x4_affine_camera_matrix(rendering_params, image.cols, image.rows);
+        return std::make_shared<FaceMeshContainerEOS>(mesh, rendering_params, affine_from_ortho);
+    }
+
+    void reset()
+    {
+        identity.reset();
+        mesh.reset();
+        shape = cv::Mat();
+        shape_coefficients.clear();
+        blendshape_coefficients.clear();
+    }
+
+    std::shared_ptr<const Model> model;
+    const eos::morphablemodel::MorphableModel& morphable_model;
+    const eos::core::LandmarkMapper& landmark_mapper;
+    const std::vector<eos::morphablemodel::Blendshape>& blendshapes;
+    const eos::fitting::ModelContour& model_contour;
+    const eos::fitting::ContourLandmarks& ibug_contour;
+    const eos::morphablemodel::EdgeTopology& edge_topology;
+    const cv::Mat& blendshapes_matrix;
+
+    // Tracking mode state:
+    FaceMeshMapper::TrackingSettings tracking;
+    IdentityTracker identity;
+    std::shared_ptr<eos::core::Mesh> mesh;
+    eos::fitting::RenderingParameters rendering_params;
+    cv::Mat shape; // fixed identity instance
+    std::vector<float> shape_coefficients;
+    std::vector<float> blendshape_coefficients;
 };
 
 FaceMeshMapperEOSLandmarkContour::FaceMeshMapperEOSLandmarkContour(const Assets& assets)
@@ -96,4 +222,23 @@ auto FaceMeshMapperEOSLandmarkContour::operator()(const FaceModel& face, const c
     return (*m_pImpl)(face, image);
 }
 
+void FaceMeshMapperEOSLandmarkContour::setTracking(const TrackingSettings& settings)
+{
+    m_pImpl->tracking = settings;
+    m_pImpl->reset();
+}
+
+void FaceMeshMapperEOSLandmarkContour::reset()
+{
+    m_pImpl->reset();
+}
+
+std::shared_ptr<FaceMeshMapper> FaceMeshMapperEOSLandmarkContour::clone() const
+{
+    std::shared_ptr<FaceMeshMapperEOSLandmarkContour> mapper(new FaceMeshMapperEOSLandmarkContour);
+    mapper->m_pImpl = std::make_shared<Impl>(m_pImpl->model);
+    mapper->m_pImpl->tracking = m_pImpl->tracking;
+    return mapper;
+}
+
 DRISHTI_FACE_NAMESPACE_END
@@ -54,8 +54,15 @@ public:
     virtual FaceMeshContainerPtr operator()(const std::vector<cv::Point2f>& landmarks, const cv::Mat& image);
     virtual FaceMeshContainerPtr operator()(const FaceModel& face, const cv::Mat& image);
 
+    virtual void setTracking(const TrackingSettings& settings);
+    virtual void reset();
+
+    virtual std::shared_ptr<FaceMeshMapper> clone() const;
+
 protected:
     
+    FaceMeshMapperEOSLandmarkContour() = default;
+
     struct Impl;
     std::shared_ptr<Impl> m_pImpl;
 };
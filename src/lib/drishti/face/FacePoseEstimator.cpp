@@ -0,0 +1,232 @@
+/*! -*-c++-*-
+  @file   FacePoseEstimator.cpp
+  @author David Hirvonen
+  @brief  Implementation of a lightweight head pose estimator for sparse 2D face landmarks.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FacePoseEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Mean face (eye distance units, origin at the eye midpoint) for the FacePoseEstimator::Points2d order:
+static const FacePoseEstimator::Points3d kTemplate{ {
+    { -0.50f, 0.00f, 0.00f },  // eye center (image left)
+    { +0.50f, 0.00f, 0.00f },  // eye center (image right)
+    { +0.00f, 0.60f, -0.25f }, // nose (nostril centroid)
+    { -0.40f, 1.05f, -0.05f }, // mouth corner (image left)
+    { +0.40f, 1.05f, -0.05f }  // mouth corner (image right)
+} };
+
+static const float kDegrees = static_cast<float>(180.0 / CV_PI);
+
+// Rotation by the axis angle vector w (Rodrigues formula):
+static cv::Matx33d expRotation(const cv::Vec3d& w)
+{
+    const double theta = cv::norm(w);
+    const cv::Matx33d W(0.0, -w[2], w[1], w[2], 0.0, -w[0], -w[1], w[0], 0.0);
+    if (theta < 1e-12)
+    {
+        return cv::Matx33d::eye() + W;
+    }
+    const double a = std::sin(theta) / theta, b = (1.0 - std::cos(theta)) / (theta * theta);
+    return cv::Matx33d::eye() + (W * a) + (W * W * b);
+}
+
+// Small angle rotation vector of M = R * Rp' (the prior residual):
+static cv::Vec3d vee(const cv::Matx33d& M)
+{
+    return cv::Vec3d(M(2, 1) - M(1, 2), M(0, 2) - M(2, 0), M(1, 0) - M(0, 1)) * 0.5;
+}
+
+cv::Point3f FacePoseEstimator::Pose::getEuler() const
+{
+    // R = Rz(roll) * Ry(yaw) * Rx(pitch)
+    const float yaw = std::asin(std::min(std::max(-R(2, 0), -1.f), 1.f));
+    const float pitch = std::atan2(R(2, 1), R(2, 2));
+    const float roll = std::atan2(R(1, 0), R(0, 0));
+    return cv::Point3f(pitch, yaw, roll) * kDegrees;
+}
+
+cv::Point2f FacePoseEstimator::Pose::project(const cv::Point3f& X) const
+{
+    const cv::Point3f q = R * X;
+    return cv::Point2f(q.x, q.y) * scale + translation;
+}
+
+FacePoseEstimator::FacePoseEstimator(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+const FacePoseEstimator::Points3d& FacePoseEstimator::getTemplate()
+{
+    return kTemplate;
+}
+
+cv::Matx33f FacePoseEstimator::fromEuler(const cv::Point3f& euler)
+{
+    const cv::Point3f a = euler * (1.f / kDegrees);
+    const float cx = std::cos(a.x), sx = std::sin(a.x);
+    const float cy = std::cos(a.y), sy = std::sin(a.y);
+    const float cz = std::cos(a.z), sz = std::sin(a.z);
+    const cv::Matx33f Rx(1.f, 0.f, 0.f, 0.f, cx, -sx, 0.f, sx, cx);
+    const cv::Matx33f Ry(cy, 0.f, sy, 0.f, 1.f, 0.f, -sy, 0.f, cy);
+    const cv::Matx33f Rz(cz, -sz, 0.f, sz, cz, 0.f, 0.f, 0.f, 1.f);
+    return Rz * Ry * Rx;
+}
+
+bool FacePoseEstimator::getPoints(const FaceModel& face, Points2d& points)
+{
+    const bool hasEyes = (face.eyeRightCenter.has || !face.eyeRight.empty()) && (face.eyeLeftCenter.has || !face.eyeLeft.empty());
+    if (!hasEyes || !face.noseTip.has || !face.mouthCornerLeft.has || !face.mouthCornerRight.has)
+    {
+        return false;
+    }
+
+    points[0] = face.getEyeRightCenter();
+    points[1] = face.getEyeLeftCenter();
+    points[2] = face.noseTip.value;
+
+    // Order the mouth corners along the eye axis (the mouth corner names are format dependent):
+    const cv::Point2f e1 = points[1] - points[0];
+    const cv::Point2f& m0 = face.mouthCornerRight.value, &m1 = face.mouthCornerLeft.value;
+    const bool ordered = (m0.dot(e1) <= m1.dot(e1));
+    points[3] = ordered ? m0 : m1;
+    points[4] = ordered ? m1 : m0;
+    return true;
+}
+
+auto FacePoseEstimator::operator()(const FaceModel& face, const Pose* prior) const -> Pose
+{
+    Points2d points;
+    return getPoints(face, points) ? (*this)(points, prior) : Pose();
+}
+
+auto FacePoseEstimator::operator()(const Points2d& pixels, const Pose* prior) const -> Pose
+{
+    Pose pose;
+
+    // Normalize to eye distance units (well conditioned, scale ~= 1):
+    const cv::Point2f center = (pixels[0] + pixels[1]) * 0.5f;
+    const auto distance = static_cast<float>(cv::norm(pixels[1] - pixels[0]));
+    if (distance <= 0.f)
+    {
+        return pose;
+    }
+
+    std::array<cv::Vec2d, kPoints> p;
+    std::array<cv::Vec3d, kPoints> X;
+    for (int i = 0; i < kPoints; i++)
+    {
+        const cv::Point2f q = (pixels[i] - center) * (1.f / distance);
+        p[i] = { q.x, q.y };
+        X[i] = { kTemplate[i].x, kTemplate[i].y, kTemplate[i].z };
+    }
+
+    cv::Matx33d R = cv::Matx33d::eye(), Rp = cv::Matx33d::eye();
+    double s = 1.0;
+    cv::Vec2d t;
+
+    const bool hasPrior = prior && prior->valid;
+    if (hasPrior)
+    {
+        // Warm start: the previous rotation, with the scale and translation in closed form:
+        R = Rp = prior->R;
+        cv::Vec2d qc, pc;
+        std::array<cv::Vec2d, kPoints> q;
+        for (int i = 0; i < kPoints; i++)
+        {
+            const cv::Vec3d qi = R * X[i];
+            q[i] = { qi[0], qi[1] };
+            qc += q[i] * (1.0 / kPoints);
+            pc += p[i] * (1.0 / kPoints);
+        }
+        double qq = 0.0, qp = 0.0;
+        for (int i = 0; i < kPoints; i++)
+        {
+            qq += (q[i] - qc).dot(q[i] - qc);
+            qp += (q[i] - qc).dot(p[i] - pc);
+        }
+        s = (qq > 0.0) ? (qp / qq) : 1.0;
+        t = pc - qc * s;
+    }
+    else
+    {
+        // Closed form: linear affine camera [ P | t ] and the nearest scaled rotation:
+        cv::Matx44d AtA = cv::Matx44d::zeros();
+        cv::Matx<double, 4, 2> Atb = cv::Matx<double, 4, 2>::zeros();
+        for (int i = 0; i < kPoints; i++)
+        {
+            const cv::Vec4d a(X[i][0], X[i][1], X[i][2], 1.0);
+            AtA += a * a.t();
+            Atb += a * cv::Matx12d(p[i][0], p[i][1]);
+        }
+        const cv::Matx<double, 4, 2> P = AtA.solve(Atb, cv::DECOMP_SVD);
+
+        cv::Mat M = (cv::Mat_<double>(2, 3) << P(0, 0), P(1, 0), P(2, 0), P(0, 1), P(1, 1), P(2, 1));
+        cv::SVD svd(M);
+        const cv::Mat1d Q = svd.u * svd.vt; // orthonormal rows
+        const cv::Vec3d r1(Q(0, 0), Q(0, 1), Q(0, 2)), r2(Q(1, 0), Q(1, 1), Q(1, 2)), r3 = r1.cross(r2);
+        R = cv::Matx33d(r1[0], r1[1], r1[2], r2[0], r2[1], r2[2], r3[0], r3[1], r3[2]);
+        s = (svd.w.at<double>(0) + svd.w.at<double>(1)) * 0.5;
+        t = { P(3, 0), P(3, 1) };
+    }
+
+    // Gauss-Newton on { w, s, t } with R <- exp(w) * R:
+    const double lambda = hasPrior ? (m_settings.prior * kPoints) : 0.0;
+    for (int k = 0; k < m_settings.iterations; k++)
+    {
+        cv::Matx66d JtJ = cv::Matx66d::zeros();
+        cv::Vec6d Jtr;
+        for (int i = 0; i < kPoints; i++)
+        {
+            const cv::Vec3d q = R * X[i];
+            const cv::Vec2d r = cv::Vec2d(q[0], q[1]) * s + t - p[i];
+            const cv::Vec6d jx(0.0, q[2] * s, -q[1] * s, q[0], 1.0, 0.0);
+            const cv::Vec6d jy(-q[2] * s, 0.0, q[0] * s, q[1], 0.0, 1.0);
+            JtJ += (jx * jx.t()) + (jy * jy.t());
+            Jtr += (jx * r[0]) + (jy * r[1]);
+        }
+
+        if (hasPrior)
+        {
+            const cv::Vec3d e = vee(R * Rp.t());
+            for (int j = 0; j < 3; j++)
+            {
+                JtJ(j, j) += lambda;
+                Jtr[j] += lambda * e[j];
+            }
+        }
+
+        const cv::Vec6d delta = JtJ.solve(-Jtr, cv::DECOMP_CHOLESKY);
+        R = expRotation({ delta[0], delta[1], delta[2] }) * R;
+        s += delta[3];
+        t += cv::Vec2d(delta[4], delta[5]);
+    }
+
+    double error = 0.0;
+    for (int i = 0; i < kPoints; i++)
+    {
+        const cv::Vec3d q = R * X[i];
+        const cv::Vec2d r = cv::Vec2d(q[0], q[1]) * s + t - p[i];
+        error += r.dot(r);
+    }
+
+    // Back to pixels:
+    pose.R = R;
+    pose.scale = static_cast<float>(s) * distance;
+    pose.translation = center + cv::Point2f(t[0], t[1]) * distance;
+    pose.error = static_cast<float>(std::sqrt(error / kPoints));
+    pose.valid = std::isfinite(pose.error) && (s > 0.0) && (pose.error <= m_settings.maxError);
+
+    return pose;
+}
+
+DRISHTI_FACE_NAMESPACE_END
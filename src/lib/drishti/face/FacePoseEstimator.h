@@ -0,0 +1,78 @@
+/*! -*-c++-*-
+  @file   FacePoseEstimator.h
+  @author David Hirvonen
+  @brief  Declaration of a lightweight head pose estimator for sparse 2D face landmarks.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Head pose from the sparse face landmarks (eye centers, nose and mouth corners) without
+  a morphable model: a rigid 3D template is fit with a scaled orthographic (weak perspective)
+  camera.  The pose is initialized in closed form from a linear affine camera (or from the
+  previous pose) and refined with a few Gauss-Newton iterations, with an optional temporal
+  prior on the rotation for tracked faces.  See FaceMeshMapper for dense (EOS) fitting.
+
+  Coordinate system: x right, y down (image), z away from the camera, with R == identity
+  for a frontal face.
+
+*/
+
+#ifndef __drishti_face_FacePoseEstimator_h__
+#define __drishti_face_FacePoseEstimator_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+
+#include <opencv2/core.hpp>
+
+#include <array>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+class FacePoseEstimator
+{
+public:
+    static const int kPoints = 5; // eyeRightCenter, eyeLeftCenter, noseTip, mouth corners (image left, right)
+
+    using Points2d = std::array<cv::Point2f, kPoints>;
+    using Points3d = std::array<cv::Point3f, kPoints>;
+
+    struct Settings
+    {
+        int iterations = 4;      // Gauss-Newton iterations
+        float prior = 0.05f;     // rotation prior weight (per point, eye distance units)
+        float maxError = 0.15f;  // rms reprojection error (eye distance units) for a valid pose
+    };
+
+    struct Pose
+    {
+        cv::Matx33f R = cv::Matx33f::eye();
+        float scale = 0.f;       // pixels per template unit (eye distance)
+        cv::Point2f translation; // image position of the template origin (eye midpoint)
+        float error = 0.f;       // rms reprojection error (eye distance units)
+        bool valid = false;
+
+        cv::Point3f getEuler() const; // degrees: pitch, yaw, roll (see FaceMeshContainer::getRotation())
+        cv::Point2f project(const cv::Point3f& X) const;
+    };
+
+    FacePoseEstimator() = default;
+    explicit FacePoseEstimator(const Settings& settings);
+
+    // Faces without the sparse landmarks return an invalid pose, prior is the previous pose of the same track:
+    Pose operator()(const FaceModel& face, const Pose* prior = nullptr) const;
+    Pose operator()(const Points2d& points, const Pose* prior = nullptr) const;
+
+    static bool getPoints(const FaceModel& face, Points2d& points);
+    static const Points3d& getTemplate();
+    static cv::Matx33f fromEuler(const cv::Point3f& euler); // degrees, see Pose::getEuler()
+
+    const Settings& getSettings() const { return m_settings; }
+
+protected:
+    Settings m_settings;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FacePoseEstimator_h__
@@ -0,0 +1,343 @@
+/*! -*-c++-*-
+  @file   FaceRecord.cpp
+  @author David Hirvonen
+  @brief  Implementation of a compact, fixed layout face record for per frame processing.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceRecord.h"
+#include "drishti/geometry/Ellipse.h"
+#include "drishti/geometry/Rectangle.h"
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+using drishti::geometry::operator*;
+
+static void apply(const cv::Matx33f& H, cv::Point2f& p)
+{
+    cv::Point3f q = H * cv::Point3f(p.x, p.y, 1.f);
+    p = { q.x / q.z, q.y / q.z };
+}
+
+template <typename Container>
+static void apply(const cv::Matx33f& H, Container& points)
+{
+    for (auto& p : points)
+    {
+        apply(H, p);
+    }
+}
+
+template <typename T>
+static void setField(core::Field<T>& field, bool has, const T& value)
+{
+    field.has = has;
+    field.value = value;
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+bool EyeRecord::assign(const DRISHTI_EYE::EyeModel& eye)
+{
+    mask = 0;
+    mask |= eye.angle.has ? kAngle : 0;
+    mask |= eye.roi.has ? kRoi : 0;
+    mask |= eye.innerCorner.has ? kInnerCorner : 0;
+    mask |= eye.outerCorner.has ? kOuterCorner : 0;
+    mask |= eye.irisCenter.has ? kIrisCenter : 0;
+    mask |= eye.irisInner.has ? kIrisInner : 0;
+    mask |= eye.irisOuter.has ? kIrisOuter : 0;
+
+    angle = eye.angle.value;
+    roi = eye.roi.value;
+    pupil = eye.pupil;
+    iris = eye.iris;
+    irisEllipse = eye.irisEllipse;
+    pupilEllipse = eye.pupilEllipse;
+    cornerIndices = { { eye.cornerIndices[0], eye.cornerIndices[1] } };
+    innerCorner = eye.innerCorner.value;
+    outerCorner = eye.outerCorner.value;
+    irisCenter = eye.irisCenter.value;
+    irisInner = eye.irisInner.value;
+    irisOuter = eye.irisOuter.value;
+
+    bool fits = eyelids.assign(eye.eyelids);
+    fits &= eyelidsSpline.assign(eye.eyelidsSpline);
+    fits &= crease.assign(eye.crease);
+    fits &= creaseSpline.assign(eye.creaseSpline);
+    return fits;
+}
+
+void EyeRecord::copyTo(DRISHTI_EYE::EyeModel& eye) const
+{
+    setField(eye.angle, has(kAngle), angle);
+    setField(eye.roi, has(kRoi), roi);
+    eye.pupil = pupil;
+    eye.iris = iris;
+    eye.irisEllipse = irisEllipse;
+    eye.pupilEllipse = pupilEllipse;
+    eye.cornerIndices[0] = cornerIndices[0];
+    eye.cornerIndices[1] = cornerIndices[1];
+    setField(eye.innerCorner, has(kInnerCorner), innerCorner);
+    setField(eye.outerCorner, has(kOuterCorner), outerCorner);
+    setField(eye.irisCenter, has(kIrisCenter), irisCenter);
+    setField(eye.irisInner, has(kIrisInner), irisInner);
+    setField(eye.irisOuter, has(kIrisOuter), irisOuter);
+
+    eyelids.copyTo(eye.eyelids);
+    eyelidsSpline.copyTo(eye.eyelidsSpline);
+    crease.copyTo(eye.crease);
+    creaseSpline.copyTo(eye.creaseSpline);
+}
+
+void EyeRecord::transform(const cv::Matx33f& H)
+{
+    if (has(kRoi))
+    {
+        roi = H * roi;
+    }
+
+    if (has(kIrisCenter))
+    {
+        for (auto* p : { &irisCenter, &irisInner, &irisOuter })
+        {
+            apply(H, *p);
+        }
+    }
+
+    apply(H, eyelids);
+    apply(H, eyelidsSpline);
+    apply(H, crease);
+    apply(H, creaseSpline);
+
+    for (auto* e : { &irisEllipse, &pupilEllipse })
+    {
+        if (e->size.area())
+        {
+            *e = H * *e;
+        }
+    }
+
+    for (auto* c : { &pupil, &iris })
+    {
+        if ((*c)[2])
+        {
+            *c = H * *c;
+        }
+    }
+}
+
+// ::::::::::::::::::::::::::::::::::::::::::::::::
+
+// In FaceRecord::Landmark order:
+template <typename Face>
+static auto getLandmarks(Face& face) -> std::array<decltype(&face.noseTip), FaceRecord::kLandmarkCount>
+{
+    return { {
+        &face.eyeLeftInner,
+        &face.eyeLeftOuter,
+        &face.eyeLeftCenter,
+        &face.eyebrowLeftInner,
+        &face.eyebrowLeftOuter,
+        &face.eyeRightInner,
+        &face.eyeRightOuter,
+        &face.eyeRightCenter,
+        &face.eyebrowRightInner,
+        &face.eyebrowRightOuter,
+        &face.noseTip,
+        &face.noseNostrilLeft,
+        &face.noseNostrilRight,
+        &face.mouthCornerRight,
+        &face.mouthCornerLeft
+    } };
+}
+
+// In FaceRecord::Contour order:
+template <typename Face>
+static auto getContours(Face& face) -> std::array<decltype(&face.nose), FaceRecord::kContourCount>
+{
+    return { {
+        &face.points.value,
+        &face.eyeLeft,
+        &face.eyebrowLeft,
+        &face.eyeRight,
+        &face.eyebrowRight,
+        &face.nose,
+        &face.noseFull,
+        &face.mouthOuter,
+        &face.mouth,
+        &face.mouthInner,
+        &face.sideLeft,
+        &face.sideRight
+    } };
+}
+
+FaceRecord::FaceRecord(const FaceModel& face)
+{
+    assign(face);
+}
+
+void FaceRecord::assign(const FaceModel& face)
+{
+    mask = 0;
+    overflow.reset();
+
+    const auto fields = getLandmarks(face);
+    for (int i = 0; i < kLandmarkCount; i++)
+    {
+        mask |= fields[i]->has ? (1u << i) : 0u;
+        landmarks[i] = fields[i]->value;
+    }
+
+    mask |= face.roi.has ? kRoi : 0;
+    mask |= face.points.has ? kPoints : 0;
+    mask |= face.eyesCenter.has ? kEyesCenter : 0;
+    mask |= face.gaze.has ? kGaze : 0;
+    roi = face.roi.value;
+    eyesCenter = face.eyesCenter.value;
+    gaze = face.gaze.value;
+
+    std::size_t total = 0;
+    const auto contours = getContours(face);
+    for (const auto& c : contours)
+    {
+        total += c->size();
+    }
+
+    bool fits = (total <= static_cast<std::size_t>(decltype(points)::capacity));
+    if (fits)
+    {
+        std::uint16_t offset = 0;
+        for (int i = 0; i < kContourCount; i++)
+        {
+            const auto count = static_cast<std::uint16_t>(contours[i]->size());
+            spans[i] = { offset, count };
+            std::copy(contours[i]->begin(), contours[i]->end(), points.begin() + offset);
+            offset += count;
+        }
+        points.resize(offset);
+    }
+    fits &= rois.assign(face.rois);
+
+    const core::Field<DRISHTI_EYE::EyeModel>* eyeFields[2] = { &face.eyeFullR, &face.eyeFullL };
+    const Flag eyeFlags[2] = { kEyeRight, kEyeLeft };
+    for (int i = 0; i < 2; i++)
+    {
+        if (eyeFields[i]->has)
+        {
+            mask |= eyeFlags[i];
+            fits &= eyes[i].assign(eyeFields[i]->value);
+        }
+    }
+
+    if (!fits)
+    {
+        overflow = std::make_shared<FaceModel>(face);
+        points.clear();
+        spans = {};
+        rois.clear();
+    }
+}
+
+void FaceRecord::copyTo(FaceModel& face) const
+{
+    if (overflow)
+    {
+        face = *overflow;
+        return;
+    }
+
+    const auto fields = getLandmarks(face);
+    for (int i = 0; i < kLandmarkCount; i++)
+    {
+        setField(*fields[i], has(static_cast<Landmark>(i)), landmarks[i]);
+    }
+
+    setField(face.roi, has(kRoi), roi);
+    setField(face.eyesCenter, has(kEyesCenter), eyesCenter);
+    setField(face.gaze, has(kGaze), gaze);
+
+    const auto contours = getContours(face);
+    for (int i = 0; i < kContourCount; i++)
+    {
+        contours[i]->assign(begin(static_cast<Contour>(i)), end(static_cast<Contour>(i)));
+    }
+    face.points.has = has(kPoints);
+    rois.copyTo(face.rois);
+
+    core::Field<DRISHTI_EYE::EyeModel>* eyeFields[2] = { &face.eyeFullR, &face.eyeFullL };
+    const Flag eyeFlags[2] = { kEyeRight, kEyeLeft };
+    for (int i = 0; i < 2; i++)
+    {
+        eyeFields[i]->has = has(eyeFlags[i]);
+        if (eyeFields[i]->has)
+        {
+            eyes[i].copyTo(eyeFields[i]->value);
+        }
+    }
+}
+
+FaceModel FaceRecord::toFaceModel() const
+{
+    FaceModel face;
+    copyTo(face);
+    return face;
+}
+
+void FaceRecord::transform(const cv::Matx33f& H)
+{
+    if (overflow)
+    {
+        if (overflow.use_count() > 1)
+        {
+            overflow = std::make_shared<FaceModel>(*overflow); // copy on write
+        }
+        *overflow = H * *overflow;
+    }
+
+    if (has(kPoints))
+    {
+        for (int i = spans[kPointsContour].first, n = i + spans[kPointsContour].second; i < n; i++)
+        {
+            apply(H, points[i]);
+        }
+    }
+
+    for (int i = 0; i < kLandmarkCount; i++)
+    {
+        if (has(static_cast<Landmark>(i)))
+        {
+            apply(H, landmarks[i]);
+        }
+    }
+
+    // As in operator*(), only the feature contours are transformed:
+    for (auto c : { kEyeLeftContour, kEyeRightContour, kNoseContour, kEyebrowLeftContour, kEyebrowRightContour, kMouthOuterContour, kMouthInnerContour })
+    {
+        for (int i = spans[c].first, n = i + spans[c].second; i < n; i++)
+        {
+            apply(H, points[i]);
+        }
+    }
+
+    roi = H * roi;
+    mask |= kRoi;
+
+    for (auto& r : rois)
+    {
+        r = H * r;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (has((i == 0) ? kEyeRight : kEyeLeft))
+        {
+            eyes[i].transform(H);
+        }
+    }
+}
+
+DRISHTI_FACE_NAMESPACE_END
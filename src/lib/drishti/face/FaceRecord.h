@@ -0,0 +1,157 @@
+/*! -*-c++-*-
+  @file   FaceRecord.h
+  @author David Hirvonen
+  @brief  Declaration of a compact, fixed layout face record for per frame processing.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  FaceModel is the API type: ~20 optional fields, each with its own flag, and a dozen
+  heap allocated contours (plus 4 per eye).  FaceRecord holds the same data with one
+  presence bitmask, the named landmarks in an array, and all contours in inline storage
+  (core::FixedVector), so copies don't allocate and only touch the used points.
+
+  Conversions are lossless for the fields that are set.  A face with more points than
+  the inline capacity is also kept as a shared FaceModel (see isInline()), so the record
+  still works, it is just slower.
+
+*/
+
+#ifndef __drishti_face_FaceRecord_h__
+#define __drishti_face_FaceRecord_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/core/FixedVector.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+struct EyeRecord
+{
+    enum Flag
+    {
+        kAngle = 1 << 0,
+        kRoi = 1 << 1,
+        kInnerCorner = 1 << 2,
+        kOuterCorner = 1 << 3,
+        kIrisCenter = 1 << 4,
+        kIrisInner = 1 << 5,
+        kIrisOuter = 1 << 6
+    };
+
+    // Returns false if a contour exceeds the inline capacity:
+    bool assign(const DRISHTI_EYE::EyeModel& eye);
+    void copyTo(DRISHTI_EYE::EyeModel& eye) const;
+
+    // Same result as operator*(cv::Matx33, EyeModel):
+    void transform(const cv::Matx33f& H);
+
+    bool has(Flag flag) const { return (mask & flag) != 0; }
+
+    std::uint32_t mask = 0;
+    float angle = 0.f;
+    cv::Rect roi;
+    cv::Vec3f pupil;
+    cv::Vec3f iris;
+    cv::RotatedRect irisEllipse;
+    cv::RotatedRect pupilEllipse;
+    std::array<int, 2> cornerIndices{ { 0, 8 } };
+    cv::Point2f innerCorner, outerCorner;
+    cv::Point2f irisCenter, irisInner, irisOuter;
+
+    core::FixedVector<cv::Point2f, 32> eyelids;
+    core::FixedVector<cv::Point2f, DRISHTI_EYE_CONTOUR_POINTS * 2> eyelidsSpline; // refine() + upsample()
+    core::FixedVector<cv::Point2f, 16> crease;
+    core::FixedVector<cv::Point2f, DRISHTI_EYE_CREASE_POINTS * 4> creaseSpline;
+};
+
+struct FaceRecord
+{
+    // Named landmarks (mask bits 0-14):
+    enum Landmark
+    {
+        kEyeLeftInner,
+        kEyeLeftOuter,
+        kEyeLeftCenter,
+        kEyebrowLeftInner,
+        kEyebrowLeftOuter,
+        kEyeRightInner,
+        kEyeRightOuter,
+        kEyeRightCenter,
+        kEyebrowRightInner,
+        kEyebrowRightOuter,
+        kNoseTip,
+        kNoseNostrilLeft,
+        kNoseNostrilRight,
+        kMouthCornerRight,
+        kMouthCornerLeft,
+        kLandmarkCount
+    };
+
+    enum Flag
+    {
+        kRoi = 1 << 15,
+        kPoints = 1 << 16,
+        kEyeRight = 1 << 17,
+        kEyeLeft = 1 << 18,
+        kEyesCenter = 1 << 19,
+        kGaze = 1 << 20
+    };
+
+    // Contours share one point buffer:
+    enum Contour
+    {
+        kPointsContour,
+        kEyeLeftContour,
+        kEyebrowLeftContour,
+        kEyeRightContour,
+        kEyebrowRightContour,
+        kNoseContour,
+        kNoseFullContour,
+        kMouthOuterContour,
+        kMouthContour,
+        kMouthInnerContour,
+        kSideLeftContour,
+        kSideRightContour,
+        kContourCount
+    };
+
+    FaceRecord() = default;
+    explicit FaceRecord(const FaceModel& face);
+
+    void assign(const FaceModel& face);
+    void copyTo(FaceModel& face) const;
+    FaceModel toFaceModel() const;
+
+    // Same result as operator*(cv::Matx33, FaceModel):
+    void transform(const cv::Matx33f& H);
+
+    bool has(Landmark landmark) const { return (mask & (1u << landmark)) != 0; }
+    bool has(Flag flag) const { return (mask & flag) != 0; }
+    bool isInline() const { return !overflow; }
+
+    const cv::Point2f* begin(Contour contour) const { return points.begin() + spans[contour].first; }
+    const cv::Point2f* end(Contour contour) const { return begin(contour) + spans[contour].second; }
+
+    std::uint32_t mask = 0;
+    cv::Rect roi;
+    std::array<cv::Point2f, kLandmarkCount> landmarks;
+    cv::Point3f eyesCenter;
+    std::array<cv::Vec3f, 2> gaze;
+    std::array<EyeRecord, 2> eyes; // { right, left }
+
+    std::array<std::pair<std::uint16_t, std::uint16_t>, kContourCount> spans{}; // { offset, count } in points
+    core::FixedVector<cv::Point2f, 256> points;
+    core::FixedVector<cv::Rect2d, 4> rois;
+
+    // Faces that exceed the inline capacity (copied on write by transform()):
+    std::shared_ptr<FaceModel> overflow;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceRecord_h__
@@ -0,0 +1,159 @@
+/*! -*-c++-*-
+  @file   drishti/face/FaceService.cpp
+  @author David Hirvonen
+  @brief  Implementation of an in process face (and eye) analysis service with dynamic batching.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceService.h"
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Detection and regression images for one request (see app/face):
+struct FaceService::Frame
+{
+    MatP planar;      // ACF detection image (transposed RGB planes)
+    cv::Mat1b green;  // regression image (full resolution)
+};
+
+FaceService::FaceService(FaceDetectorFactory& factory, const Settings& settings)
+    : m_settings(settings)
+    , m_detector(core::make_unique<FaceDetector>(factory))
+{
+    m_Sfd = static_cast<float>(m_detector->getWindowSize().width) / static_cast<float>(std::max(m_settings.minWidth, 1));
+
+    // clang-format off
+    m_queue = core::make_unique<Queue>(
+        [this](Image& image) { return decode(image); },
+        [this](std::vector<FramePtr>& frames, std::vector<Faces>& results) { process(frames, results); },
+        m_settings.batch
+    );
+    // clang-format on
+}
+
+FaceService::~FaceService() = default;
+
+std::future<FaceService::Faces> FaceService::operator()(Image image)
+{
+    return m_queue->push(std::move(image));
+}
+
+FaceService::Stats FaceService::getStats() const
+{
+    Stats stats;
+    stats.queue = m_queue->getStats();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.detection = m_detection;
+    stats.regression = m_regression;
+    return stats;
+}
+
+// Decoder threads:
+FaceService::FramePtr FaceService::decode(Image& image) const
+{
+    const cv::Mat bgr = cv::imdecode(image, cv::IMREAD_COLOR);
+    if (bgr.empty())
+    {
+        throw std::runtime_error("FaceService: unable to decode image");
+    }
+
+    auto frame = std::make_shared<Frame>();
+    cv::extractChannel(bgr, frame->green, 1);
+
+    cv::Mat rgb, reduced, Itf;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    cv::resize(rgb, reduced, {}, m_Sfd, m_Sfd, (m_Sfd < 1.f) ? cv::INTER_AREA : cv::INTER_LINEAR);
+    cv::Mat(reduced.t()).convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+    frame->planar = MatP(Itf);
+    return frame;
+}
+
+// Batch thread:
+void FaceService::process(std::vector<FramePtr>& frames, std::vector<Faces>& results)
+{
+    using Clock = Queue::Clock;
+
+    results.resize(frames.size());
+
+    // Detection per image, and the layout of the regression mosaic (images stacked vertically):
+    std::vector<int> origins(frames.size(), 0);
+    cv::Size size;
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+        const auto tic = Clock::now();
+        m_detector->detect(frames[i]->planar, results[i]);
+        const double elapsed = std::chrono::duration<double>(Clock::now() - tic).count();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_detection.add(elapsed);
+        }
+
+        origins[i] = size.height;
+        size.width = std::max(size.width, frames[i]->green.cols);
+        size.height += frames[i]->green.rows + m_settings.gap;
+    }
+
+    // Shift the detections of each image to its tile, the detection to regression mapping is a
+    // uniform scale, so this is a translation by the tile origin in detection pixels (rounded):
+    Faces faces;
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+        const int dy = static_cast<int>(static_cast<float>(origins[i]) * m_Sfd + 0.5f);
+        for (auto& face : results[i])
+        {
+            cv::Rect roi = *face.roi;
+            roi.y += dy;
+            face.roi = roi;
+            faces.push_back(face);
+        }
+    }
+
+    if (faces.empty())
+    {
+        return;
+    }
+
+    cv::Mat1b mosaic(size, 0);
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+        const cv::Mat1b& green = frames[i]->green;
+        green.copyTo(mosaic(cv::Rect({ 0, origins[i] }, green.size())));
+    }
+
+    // Face landmarks and eye models for the whole batch in one call:
+    const auto tic = Clock::now();
+    const FaceDetector::PaddedImage Ib(mosaic, { { 0, 0 }, mosaic.size() });
+    const float Sdr = 1.f / m_Sfd;
+    m_detector->refine(Ib, faces, cv::Matx33f::diag({ Sdr, Sdr, 1.f }), true);
+    const double elapsed = std::chrono::duration<double>(Clock::now() - tic).count();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_regression.add(elapsed);
+    }
+
+    // Assign the faces to their tiles (verification may drop faces, see FaceDetector::setVerification()):
+    for (auto& result : results)
+    {
+        result.clear();
+    }
+    for (const auto& face : faces)
+    {
+        const float y = static_cast<float>(face.roi->y) + static_cast<float>(face.roi->height) * 0.5f;
+        const auto tile = std::upper_bound(origins.begin(), origins.end(), static_cast<int>(y)) - origins.begin() - 1;
+        const auto i = static_cast<std::size_t>(std::max(tile, decltype(tile)(0)));
+        results[i].push_back(face - cv::Point2f(0.f, static_cast<float>(origins[i])));
+    }
+}
+
+DRISHTI_FACE_NAMESPACE_END
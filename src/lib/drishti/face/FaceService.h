@@ -0,0 +1,91 @@
+/*! -*-c++-*-
+  @file   drishti/face/FaceService.h
+  @author David Hirvonen
+  @brief  Declaration of an in process face (and eye) analysis service with dynamic batching.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Server side front end for FaceDetector, e.g., behind a websocket::async_server handler
+  (3rdparty/utilities): encoded images are decoded and resized on the decoder threads of a
+  core::BatchQueue, and the batch thread runs detection per image, then face landmark and
+  eye regression for all faces of the batch in one FaceDetector::refine() call on a
+  mosaic of the regression images.  Results are delivered through futures, in full
+  resolution image coordinates.
+
+*/
+
+#ifndef __drishti_face_FaceService_h__
+#define __drishti_face_FaceService_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/core/BatchQueue.h"
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+class FaceService
+{
+public:
+    using Faces = std::vector<FaceModel>;
+    using Image = std::vector<std::uint8_t>; // encoded (see cv::imdecode())
+
+    struct Frame;
+    using FramePtr = std::shared_ptr<Frame>;
+    using Queue = core::BatchQueue<Image, FramePtr, Faces>;
+
+    struct Settings
+    {
+        Queue::Settings batch;
+        int minWidth = 64; // minimum face width in pixels (sets the detection scale)
+        int gap = 32;      // rows between the regression images (eye crops stay within their image)
+    };
+
+    struct Stats
+    {
+        Queue::Stats queue;
+        Queue::Stage detection;  // per image
+        Queue::Stage regression; // per batch (landmarks and eyes)
+    };
+
+    FaceService(FaceDetectorFactory& factory, const Settings& settings = {});
+    ~FaceService(); // completes the admitted requests
+
+    FaceService(const FaceService&) = delete;
+    FaceService(FaceService&&) = delete;
+    FaceService& operator=(const FaceService&) = delete;
+    FaceService& operator=(FaceService&&) = delete;
+
+    // Configure before the first request (the detector runs on the batch thread):
+    FaceDetector& getDetector() { return *m_detector; }
+
+    // Thread safe, the future holds the faces or an exception (e.g., Queue::Rejected when overloaded):
+    std::future<Faces> operator()(Image image);
+
+    Stats getStats() const;
+
+protected:
+    FramePtr decode(Image& image) const;
+    void process(std::vector<FramePtr>& frames, std::vector<Faces>& results);
+
+    Settings m_settings;
+    std::unique_ptr<FaceDetector> m_detector;
+    float m_Sfd = 1.f; // full resolution to detection scale
+
+    mutable std::mutex m_mutex;
+    Queue::Stage m_detection, m_regression;
+
+    std::unique_ptr<Queue> m_queue; // last
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceService_h__
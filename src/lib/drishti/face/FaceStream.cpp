@@ -0,0 +1,675 @@
+/*! -*-c++-*-
+  @file   FaceStream.cpp
+  @author David Hirvonen
+  @brief  Implementation of a compact binary stream of per frame face models.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/FaceStream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+static const char kMagic[4] = { 'D', 'R', 'F', 'S' };
+static const char kIndexMagic[4] = { 'D', 'R', 'F', 'I' };
+static const std::size_t kFooterSize = 16; // u64 offset, u32 count, magic
+
+static const float kPixel = 64.f;   // image coordinates and sizes (1/64 pixel)
+static const float kFine = 65536.f; // angles (radians), unit vectors and metric positions
+
+enum FaceFlags
+{
+    kDelta = 1 << 0 // values are relative to the same face in the previous frame
+};
+
+// ((( varint )))
+
+static void putVarint(std::vector<std::uint8_t>& buffer, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+static void putZigzag(std::vector<std::uint8_t>& buffer, std::int64_t value)
+{
+    putVarint(buffer, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+static bool getVarint(const std::uint8_t*& ptr, const std::uint8_t* end, std::uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; (ptr < end) && (shift < 64); shift += 7)
+    {
+        const std::uint8_t byte = *ptr++;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool getZigzag(const std::uint8_t*& ptr, const std::uint8_t* end, std::int64_t& value)
+{
+    std::uint64_t bits = 0;
+    if (!getVarint(ptr, end, bits))
+    {
+        return false;
+    }
+    value = static_cast<std::int64_t>(bits >> 1) ^ -static_cast<std::int64_t>(bits & 1);
+    return true;
+}
+
+static bool getVarint(std::istream& is, std::uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        const int byte = is.get();
+        if (byte == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ((( quantized model traversal )))
+
+static std::int32_t quantize(double value, float scale)
+{
+    const double q = std::round(value * scale);
+    if (!(q == q)) // NaN
+    {
+        return 0;
+    }
+    const double limit = static_cast<double>(std::numeric_limits<std::int32_t>::max());
+    return static_cast<std::int32_t>(std::max(-limit, std::min(q, limit)));
+}
+
+struct FaceEncoder
+{
+    FaceCode& code;
+
+    bool flag(bool has)
+    {
+        code.layout.push_back(has ? 1 : 0);
+        return has;
+    }
+    void index(int i) { code.layout.push_back(i); }
+    template <typename Container>
+    void count(const Container& c)
+    {
+        code.layout.push_back(static_cast<std::int32_t>(c.size()));
+    }
+    void integer(int value) { code.values.push_back(value); }
+    template <typename T>
+    void scalar(const T& value, float scale)
+    {
+        code.values.push_back(quantize(static_cast<double>(value), scale));
+    }
+};
+
+struct FaceDecoder
+{
+    explicit FaceDecoder(const FaceCode& code)
+        : code(code)
+    {
+    }
+
+    const FaceCode& code;
+    std::size_t layout = 0;
+    std::size_t values = 0;
+    bool ok = true;
+
+    std::int32_t nextLayout()
+    {
+        ok &= (layout < code.layout.size());
+        return ok ? code.layout[layout++] : 0;
+    }
+    std::int32_t nextValue()
+    {
+        ok &= (values < code.values.size());
+        return ok ? code.values[values++] : 0;
+    }
+
+    bool flag(bool& has)
+    {
+        has = (nextLayout() != 0);
+        return has;
+    }
+    void index(int& i) { i = nextLayout(); }
+    template <typename Container>
+    void count(Container& c)
+    {
+        // Each element has at least one value:
+        const std::int32_t n = nextLayout();
+        ok &= (n >= 0) && (static_cast<std::size_t>(n) <= (code.values.size() - values));
+        c.resize(ok ? n : 0);
+    }
+    void integer(int& value) { value = nextValue(); }
+    template <typename T>
+    void scalar(T& value, float scale)
+    {
+        value = static_cast<T>(static_cast<double>(nextValue()) / scale);
+    }
+};
+
+template <typename Visitor, typename Point>
+static void visitPoint(Visitor& v, Point& p)
+{
+    v.scalar(p.x, kPixel);
+    v.scalar(p.y, kPixel);
+}
+
+template <typename Visitor, typename Contour>
+static void visitContour(Visitor& v, Contour& contour)
+{
+    v.count(contour);
+    for (auto& p : contour)
+    {
+        visitPoint(v, p);
+    }
+}
+
+template <typename Visitor, typename Rect>
+static void visitRect(Visitor& v, Rect& r)
+{
+    v.integer(r.x);
+    v.integer(r.y);
+    v.integer(r.width);
+    v.integer(r.height);
+}
+
+template <typename Visitor, typename Ellipse>
+static void visitEllipse(Visitor& v, Ellipse& e)
+{
+    visitPoint(v, e.center);
+    v.scalar(e.size.width, kPixel);
+    v.scalar(e.size.height, kPixel);
+    v.scalar(e.angle, kPixel); // degrees
+}
+
+template <typename Visitor, typename Circle>
+static void visitCircle(Visitor& v, Circle& c)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        v.scalar(c[i], kPixel);
+    }
+}
+
+template <typename Visitor, typename Eye>
+static void visitEye(Visitor& v, Eye& eye)
+{
+    if (v.flag(eye.angle.has))
+    {
+        v.scalar(eye.angle.value, kFine);
+    }
+    if (v.flag(eye.roi.has))
+    {
+        visitRect(v, eye.roi.value);
+    }
+    visitCircle(v, eye.pupil);
+    visitCircle(v, eye.iris);
+    visitEllipse(v, eye.irisEllipse);
+    visitEllipse(v, eye.pupilEllipse);
+    v.index(eye.cornerIndices[0]);
+    v.index(eye.cornerIndices[1]);
+
+    for (auto* contour : { &eye.eyelids, &eye.eyelidsSpline, &eye.crease, &eye.creaseSpline })
+    {
+        visitContour(v, *contour);
+    }
+    for (auto* point : { &eye.innerCorner, &eye.outerCorner, &eye.irisCenter, &eye.irisInner, &eye.irisOuter })
+    {
+        if (v.flag(point->has))
+        {
+            visitPoint(v, point->value);
+        }
+    }
+}
+
+// The traversal order is the schema (see FaceStreamWriter::kVersion):
+template <typename Visitor, typename Face>
+static void visitFace(Visitor& v, Face& face)
+{
+    if (v.flag(face.points.has))
+    {
+        visitContour(v, face.points.value);
+    }
+    if (v.flag(face.roi.has))
+    {
+        visitRect(v, face.roi.value);
+    }
+
+    // clang-format off
+    for (auto* point : {
+            &face.eyeLeftInner, &face.eyeLeftOuter, &face.eyeLeftCenter, &face.eyebrowLeftInner, &face.eyebrowLeftOuter,
+            &face.eyeRightInner, &face.eyeRightOuter, &face.eyeRightCenter, &face.eyebrowRightInner, &face.eyebrowRightOuter,
+            &face.noseTip, &face.noseNostrilLeft, &face.noseNostrilRight, &face.mouthCornerRight, &face.mouthCornerLeft })
+    // clang-format on
+    {
+        if (v.flag(point->has))
+        {
+            visitPoint(v, point->value);
+        }
+    }
+
+    for (auto* eye : { &face.eyeFullL, &face.eyeFullR })
+    {
+        if (v.flag(eye->has))
+        {
+            visitEye(v, eye->value);
+        }
+    }
+
+    // clang-format off
+    for (auto* contour : {
+            &face.eyeLeft, &face.eyebrowLeft, &face.eyeRight, &face.eyebrowRight, &face.nose, &face.noseFull,
+            &face.mouthOuter, &face.mouth, &face.mouthInner, &face.sideLeft, &face.sideRight })
+    // clang-format on
+    {
+        visitContour(v, *contour);
+    }
+
+    v.count(face.rois);
+    for (auto& roi : face.rois)
+    {
+        v.scalar(roi.x, kPixel);
+        v.scalar(roi.y, kPixel);
+        v.scalar(roi.width, kPixel);
+        v.scalar(roi.height, kPixel);
+    }
+
+    if (v.flag(face.eyesCenter.has))
+    {
+        v.scalar(face.eyesCenter.value.x, kFine);
+        v.scalar(face.eyesCenter.value.y, kFine);
+        v.scalar(face.eyesCenter.value.z, kFine);
+    }
+    if (v.flag(face.gaze.has))
+    {
+        for (auto& g : face.gaze.value)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                v.scalar(g[i], kFine);
+            }
+        }
+    }
+}
+
+void FaceCode::encode(const FaceModel& face)
+{
+    layout.clear();
+    values.clear();
+    FaceEncoder encoder{ *this };
+    visitFace(encoder, face);
+}
+
+bool FaceCode::decode(FaceModel& face) const
+{
+    face = FaceModel();
+    FaceDecoder decoder(*this);
+    visitFace(decoder, face);
+    return decoder.ok && (decoder.layout == layout.size()) && (decoder.values == values.size());
+}
+
+// ((( writer )))
+
+FaceStreamWriter::FaceStreamWriter(std::ostream& os, int keyframeInterval)
+    : m_os(os)
+    , m_keyframeInterval(std::max(keyframeInterval, 1))
+{
+    m_buffer.assign(kMagic, kMagic + sizeof(kMagic));
+    putVarint(m_buffer, kVersion);
+    putVarint(m_buffer, static_cast<std::uint64_t>(m_keyframeInterval));
+    m_os.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+    m_good = m_os.good();
+}
+
+FaceStreamWriter::~FaceStreamWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+bool FaceStreamWriter::write(const std::vector<FaceModel>& faces, std::int64_t timestamp)
+{
+    if (!m_good || m_closed)
+    {
+        return false;
+    }
+
+    const bool isKeyframe = (m_sizes.size() % m_keyframeInterval) == 0;
+
+    // Frame payload (after the size prefix):
+    m_buffer.clear();
+    putZigzag(m_buffer, isKeyframe ? timestamp : (timestamp - m_timestamp));
+    putVarint(m_buffer, faces.size());
+
+    if (m_current.size() < faces.size())
+    {
+        m_current.resize(faces.size());
+    }
+    for (std::size_t i = 0; i < faces.size(); i++)
+    {
+        FaceCode& code = m_current[i];
+        code.encode(faces[i]);
+
+        const FaceCode* reference = nullptr;
+        if (!isKeyframe && (i < m_previous.size()) && (m_previous[i].layout == code.layout))
+        {
+            reference = &m_previous[i];
+        }
+
+        putVarint(m_buffer, reference ? kDelta : 0);
+        putVarint(m_buffer, code.layout.size());
+        putVarint(m_buffer, code.values.size());
+        for (const auto& entry : code.layout)
+        {
+            putVarint(m_buffer, static_cast<std::uint32_t>(entry));
+        }
+        for (std::size_t j = 0; j < code.values.size(); j++)
+        {
+            const std::int64_t value = code.values[j];
+            putZigzag(m_buffer, reference ? (value - reference->values[j]) : value);
+        }
+    }
+
+    // The size prefix is written separately so the payload needn't move:
+    std::uint8_t prefix[10];
+    std::size_t length = 0;
+    for (std::uint64_t value = m_buffer.size(); length < sizeof(prefix); value >>= 7)
+    {
+        prefix[length++] = static_cast<std::uint8_t>((value & 0x7f) | ((value >= 0x80) ? 0x80 : 0));
+        if (value < 0x80)
+        {
+            break;
+        }
+    }
+    m_os.write(reinterpret_cast<const char*>(prefix), length);
+    m_os.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+    m_good = m_os.good();
+
+    // Faces past the end of this frame keep their buffers (for later frames) but aren't references:
+    std::swap(m_previous, m_current);
+    m_previous.resize(std::max(m_previous.size(), faces.size()));
+    for (std::size_t i = faces.size(); i < m_previous.size(); i++)
+    {
+        m_previous[i].layout.clear();
+    }
+
+    m_timestamp = timestamp;
+    m_sizes.push_back(length + m_buffer.size());
+    return m_good;
+}
+
+bool FaceStreamWriter::close()
+{
+    if (!m_good || m_closed)
+    {
+        return m_good;
+    }
+    m_closed = true;
+
+    const std::uint64_t offset = static_cast<std::uint64_t>(m_os.tellp());
+
+    m_buffer.clear();
+    for (const auto& size : m_sizes)
+    {
+        putVarint(m_buffer, size);
+    }
+
+    const std::uint32_t count = static_cast<std::uint32_t>(m_sizes.size());
+    for (int i = 0; i < 8; i++)
+    {
+        m_buffer.push_back(static_cast<std::uint8_t>(offset >> (i * 8)));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        m_buffer.push_back(static_cast<std::uint8_t>(count >> (i * 8)));
+    }
+    m_buffer.insert(m_buffer.end(), kIndexMagic, kIndexMagic + sizeof(kIndexMagic));
+
+    m_os.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+    m_os.flush();
+    m_good = m_os.good();
+    return m_good;
+}
+
+// ((( reader )))
+
+FaceStreamReader::FaceStreamReader(std::istream& is)
+    : m_is(is)
+{
+    char magic[sizeof(kMagic)] = {};
+    std::uint64_t version = 0, interval = 0;
+    if (!m_is.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) || !getVarint(m_is, version) || !getVarint(m_is, interval))
+    {
+        return;
+    }
+    if ((version == 0) || (version > FaceStreamWriter::kVersion) || (interval == 0))
+    {
+        return;
+    }
+    m_version = static_cast<int>(version);
+    m_keyframeInterval = static_cast<int>(interval);
+
+    const std::uint64_t begin = static_cast<std::uint64_t>(m_is.tellg());
+    m_is.seekg(0, std::ios::end);
+    const std::uint64_t end = static_cast<std::uint64_t>(m_is.tellg());
+
+    // Frame index (written by FaceStreamWriter::close()):
+    bool hasIndex = false;
+    if ((end - begin) >= kFooterSize)
+    {
+        std::uint8_t footer[kFooterSize];
+        m_is.seekg(end - kFooterSize);
+        if (m_is.read(reinterpret_cast<char*>(footer), kFooterSize) && !std::memcmp(footer + 12, kIndexMagic, sizeof(kIndexMagic)))
+        {
+            std::uint64_t offset = 0;
+            std::uint32_t count = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                offset |= static_cast<std::uint64_t>(footer[i]) << (i * 8);
+            }
+            for (int i = 0; i < 4; i++)
+            {
+                count |= static_cast<std::uint32_t>(footer[8 + i]) << (i * 8);
+            }
+
+            if ((offset >= begin) && (offset <= (end - kFooterSize)))
+            {
+                m_is.seekg(offset);
+                std::uint64_t position = begin;
+                for (std::uint32_t i = 0; i < count; i++)
+                {
+                    std::uint64_t size = 0;
+                    if (!getVarint(m_is, size) || ((position + size) > offset))
+                    {
+                        break;
+                    }
+                    m_offsets.push_back(position);
+                    m_sizes.push_back(size);
+                    position += size;
+                }
+                hasIndex = (m_offsets.size() == count);
+            }
+        }
+        m_is.clear();
+    }
+
+    if (!hasIndex)
+    {
+        // Scan the frame size prefixes (e.g., the writer wasn't closed):
+        m_offsets.clear();
+        m_sizes.clear();
+        m_is.seekg(begin);
+        for (std::uint64_t position = begin; position < end;)
+        {
+            std::uint64_t payload = 0;
+            if (!getVarint(m_is, payload))
+            {
+                break;
+            }
+            const std::uint64_t size = (static_cast<std::uint64_t>(m_is.tellg()) - position) + payload;
+            if ((position + size) > end)
+            {
+                break; // truncated frame
+            }
+            m_offsets.push_back(position);
+            m_sizes.push_back(size);
+            position += size;
+            m_is.seekg(position);
+        }
+        m_is.clear();
+    }
+
+    m_good = true;
+}
+
+bool FaceStreamReader::decodeFrame(std::size_t index)
+{
+    m_is.clear();
+    m_is.seekg(m_offsets[index]);
+    m_buffer.resize(m_sizes[index]);
+    if (!m_is.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size()))
+    {
+        return false;
+    }
+
+    const std::uint8_t* ptr = m_buffer.data();
+    const std::uint8_t* end = ptr + m_buffer.size();
+
+    std::uint64_t payload = 0, count = 0;
+    std::int64_t timestamp = 0;
+    if (!getVarint(ptr, end, payload) || !getZigzag(ptr, end, timestamp) || !getVarint(ptr, end, count))
+    {
+        return false;
+    }
+
+    const bool isKeyframe = (index % m_keyframeInterval) == 0;
+    m_timestamp = isKeyframe ? timestamp : (m_timestamp + timestamp);
+
+    std::swap(m_previous, m_current);
+    m_current.resize(std::max(m_current.size(), static_cast<std::size_t>(count)));
+    for (std::size_t i = 0; i < count; i++)
+    {
+        FaceCode& code = m_current[i];
+
+        std::uint64_t flags = 0, layouts = 0, values = 0;
+        if (!getVarint(ptr, end, flags) || !getVarint(ptr, end, layouts) || !getVarint(ptr, end, values))
+        {
+            return false;
+        }
+        if ((layouts + values) > static_cast<std::uint64_t>(end - ptr)) // at least one byte each
+        {
+            return false;
+        }
+
+        code.layout.resize(layouts);
+        for (auto& entry : code.layout)
+        {
+            std::uint64_t value = 0;
+            if (!getVarint(ptr, end, value))
+            {
+                return false;
+            }
+            entry = static_cast<std::int32_t>(value);
+        }
+
+        const FaceCode* reference = nullptr;
+        if (flags & kDelta)
+        {
+            if ((i >= m_previous.size()) || (m_previous[i].values.size() != values))
+            {
+                return false;
+            }
+            reference = &m_previous[i];
+        }
+
+        code.values.resize(values);
+        for (std::size_t j = 0; j < code.values.size(); j++)
+        {
+            std::int64_t value = 0;
+            if (!getZigzag(ptr, end, value))
+            {
+                return false;
+            }
+            code.values[j] = static_cast<std::int32_t>(reference ? (reference->values[j] + value) : value);
+        }
+    }
+
+    // Only the faces of this frame can be references for the next one:
+    for (std::size_t i = count; i < m_current.size(); i++)
+    {
+        m_current[i].values.clear();
+    }
+    m_faces = count;
+    return true;
+}
+
+bool FaceStreamReader::read(std::size_t index, std::vector<FaceModel>& faces, std::int64_t* timestamp)
+{
+    if (!m_good || (index >= m_offsets.size()))
+    {
+        return false;
+    }
+
+    // Decode from the keyframe unless this is the next frame:
+    std::size_t first = (index == m_next) ? index : (index - (index % m_keyframeInterval));
+    if ((index > m_next) && (m_next > first))
+    {
+        first = m_next; // the decoded state is past the keyframe
+    }
+
+    for (std::size_t i = first; i <= index; i++)
+    {
+        if (!decodeFrame(i))
+        {
+            m_next = 0;
+            return false;
+        }
+        m_next = i + 1;
+    }
+
+    faces.resize(m_faces);
+    for (std::size_t i = 0; i < m_faces; i++)
+    {
+        if (!m_current[i].decode(faces[i]))
+        {
+            return false;
+        }
+    }
+    if (timestamp)
+    {
+        *timestamp = m_timestamp;
+    }
+    return true;
+}
+
+DRISHTI_FACE_NAMESPACE_END
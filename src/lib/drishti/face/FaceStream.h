@@ -0,0 +1,117 @@
+/*! -*-c++-*-
+  @file   FaceStream.h
+  @author David Hirvonen
+  @brief  Declaration of a compact binary stream of per frame face models.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The cereal (JSON/XML) and cv::FileStorage formats write one document per model, which
+  is too large and too slow for per frame recording and telemetry.  FaceStreamWriter
+  appends one record per frame to a std::ostream: every FaceModel (including both
+  EyeModel instances) is quantized (1/64 pixel for image coordinates), and is delta encoded
+  with respect to the same face in the previous frame when the layout (fields and contour
+  sizes) matches, with zigzag varints for all values.  Every keyframeInterval frames are
+  self contained, and close() appends a frame index, so FaceStreamReader can seek to any
+  frame (a stream without an index, e.g., after a crash, is scanned once instead).
+
+  Layout (little endian):
+
+    "DRFS" varint(version) varint(keyframeInterval)
+    { varint(size) frame }*
+    { varint(size) }* u64(index offset) u32(frame count) "DRFI"
+
+    frame = zigzag(timestamp delta) varint(faces) { varint(flags) varint(layout count)
+            varint(value count) varint(layout)* zigzag(value or delta)* }*
+
+*/
+
+#ifndef __drishti_face_FaceStream_h__
+#define __drishti_face_FaceStream_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/face/Face.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+// Quantized face: presence flags, contour sizes and indices (layout) and the values:
+struct FaceCode
+{
+    std::vector<std::int32_t> layout;
+    std::vector<std::int32_t> values;
+
+    void encode(const FaceModel& face);
+    bool decode(FaceModel& face) const;
+};
+
+class FaceStreamWriter
+{
+public:
+    static const int kVersion = 1;
+
+    explicit FaceStreamWriter(std::ostream& os, int keyframeInterval = 30);
+    ~FaceStreamWriter();
+
+    FaceStreamWriter(const FaceStreamWriter&) = delete;
+    FaceStreamWriter& operator=(const FaceStreamWriter&) = delete;
+
+    bool good() const { return m_good; }
+
+    // Append one frame (the timestamp units are up to the caller, e.g., microseconds).  Buffers
+    // are reused, so there are no allocations once the largest frame has been seen:
+    bool write(const std::vector<FaceModel>& faces, std::int64_t timestamp = 0);
+
+    // Append the frame index (idempotent), the stream isn't closed:
+    bool close();
+
+    std::size_t size() const { return m_sizes.size(); }
+
+protected:
+    std::ostream& m_os;
+    int m_keyframeInterval = 30;
+    bool m_good = false;
+    bool m_closed = false;
+
+    std::int64_t m_timestamp = 0;
+    std::vector<FaceCode> m_previous, m_current;
+    std::vector<std::uint8_t> m_buffer;
+    std::vector<std::uint64_t> m_sizes; // frame record sizes (index)
+};
+
+class FaceStreamReader
+{
+public:
+    explicit FaceStreamReader(std::istream& is);
+
+    bool good() const { return m_good; }
+
+    std::size_t size() const { return m_offsets.size(); }
+
+    // Random access, sequential reads continue from the previous frame:
+    bool read(std::size_t index, std::vector<FaceModel>& faces, std::int64_t* timestamp = nullptr);
+
+protected:
+    bool decodeFrame(std::size_t index);
+
+    std::istream& m_is;
+    bool m_good = false;
+    int m_version = 0;
+    int m_keyframeInterval = 1;
+
+    std::vector<std::uint64_t> m_offsets; // frame record offsets
+    std::vector<std::uint64_t> m_sizes;
+
+    std::size_t m_next = 0; // frame after the decoded state
+    std::int64_t m_timestamp = 0;
+    std::size_t m_faces = 0; // faces in the decoded state
+    std::vector<FaceCode> m_previous, m_current;
+    std::vector<std::uint8_t> m_buffer;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_FaceStream_h__
@@ -9,8 +9,20 @@
 */
 
 #include "drishti/face/FaceTracker.h" // FaceModel.h
+#include "drishti/face/FaceRecord.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/hungarian.h"
+#include "drishti/core/FixedAssignment.h"
+#include "drishti/geometry/motion.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+// Tracks x detections handled by the allocation free assignment (see DRISHTI_SDK_MAX_FACES):
+#define DRISHTI_FACE_TRACKER_CAPACITY 8
 
 DRISHTI_FACE_NAMESPACE_BEGIN
 
@@ -20,40 +32,238 @@ struct FaceTracker::Impl
     using FaceTrackVec = std::vector<FaceTrack>;
     using FaceModelVec = std::vector<drishti::face::FaceModel>;
 
-    Impl(float costThreshold, std::size_t minTrackHits, std::size_t maxTrackMisses)
+    // Tracks are stored as compact records (no allocations per update or prediction), and
+    // converted to FaceModel for the output:
+    using TrackRecord = std::pair<FaceRecord, FaceTracker::TrackInfo>;
+    using TrackRecordVec = std::vector<TrackRecord>;
+
+    using Assignment = core::FixedAssignment<double, DRISHTI_FACE_TRACKER_CAPACITY>;
+
+    struct Motion
+    {
+        cv::Point2f point;
+        cv::Point2f delta;
+    };
+
+    Impl(float costThreshold, std::size_t minTrackHits, std::size_t maxTrackMisses, float motionGain)
         : m_costThreshold(costThreshold)
         , m_minTrackHits(minTrackHits)
         , m_maxTrackMisses(maxTrackMisses)
+        , m_motionGain(motionGain)
+    {
+        // Steady state updates reuse storage (new tracks can briefly double the count):
+        m_tracks.reserve(Assignment::capacity * 2);
+        m_direct.reserve(Assignment::capacity * 2);
+        m_prior.reserve(Assignment::capacity * 2);
+        m_hits.reserve(Assignment::capacity * 2);
+        m_assigned.reserve(Assignment::capacity);
+        m_motion.reserve(Assignment::capacity);
+        m_pending.reserve(Assignment::capacity);
+    }
+
+    static cv::Point2f center(const cv::Rect& roi)
+    {
+        return cv::Point2f(roi.x, roi.y) + cv::Point2f(roi.width, roi.height) * 0.5f;
+    }
+
+    void addMotion(const cv::Point2f& point, const cv::Point2f& delta)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_motion.push_back({ point, delta });
+    }
+
+    // Accumulated external motion measurement for a track (if any):
+    bool getMotion(const std::vector<Motion>& motion, const FaceRecord& face, cv::Point2f& delta) const
+    {
+        bool found = false;
+        const cv::Rect2f roi = face.roi;
+        for (const auto& m : motion)
+        {
+            if (roi.contains(m.point))
+            {
+                delta += m.delta;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // Zero mean, unit norm patch (empty if the roi is outside the image or uniform):
+    static cv::Mat1f computeSignature(const cv::Mat& image, const cv::Matx33f& H, const FaceModel& face, int width)
+    {
+        cv::Mat1f signature;
+        if (image.empty() || !face.roi.has || (width <= 0))
+        {
+            return signature;
+        }
+
+        const cv::Rect roi = (H * face.roi.value) & cv::Rect({ 0, 0 }, image.size());
+        if (roi.area() < 4)
+        {
+            return signature;
+        }
+
+        cv::Mat gray = image(roi), patch;
+        if (gray.channels() > 1)
+        {
+            cv::extractChannel(gray, gray, 1); // green
+        }
+        cv::resize(gray, patch, { width, width }, 0, 0, cv::INTER_AREA);
+        patch.convertTo(signature, CV_32F);
+
+        signature -= cv::mean(signature)[0];
+        const double norm = cv::norm(signature);
+        if (norm > 1e-6)
+        {
+            signature *= (1.0 / norm);
+        }
+        else
+        {
+            signature.release();
+        }
+
+        return signature;
+    }
+
+    static double intersectionOverUnion(const cv::Rect& a, const cv::Rect& b)
+    {
+        const double overlap = (a & b).area(), total = a.area() + b.area() - overlap;
+        return (total > 0.0) ? (overlap / total) : 0.0;
+    }
+
+    double distance(const FaceRecord& track, const FaceModel& face) const
+    {
+        return cv::norm(track.eyesCenter - *face.eyesCenter);
+    }
+
+    double cost(const TrackRecord& track, const FaceModel& face, int j) const
+    {
+        const auto& w = m_association;
+
+        double c = distance(track.first, face) / std::max(m_costThreshold, std::numeric_limits<float>::epsilon());
+        if (track.first.has(FaceRecord::kRoi) && face.roi.has)
+        {
+            const cv::Rect &a = track.first.roi, &b = face.roi;
+            if (w.iou > 0.f)
+            {
+                c += w.iou * (1.0 - intersectionOverUnion(a, b));
+            }
+            if ((w.scale > 0.f) && (a.width > 0) && (b.width > 0))
+            {
+                c += w.scale * std::abs(std::log(static_cast<double>(a.width) / static_cast<double>(b.width)));
+            }
+        }
+        if ((w.score > 0.f) && (j < static_cast<int>(m_scores.size())))
+        {
+            c += w.score / (1.0 + std::max(m_scores[j], 0.0));
+        }
+        if ((w.appearance > 0.f) && !track.second.signature.empty() && !m_signatures[j].empty())
+        {
+            c += w.appearance * 0.5 * (1.0 - track.second.signature.dot(m_signatures[j]));
+        }
+
+        return c;
+    }
+
+    void startTrack(const FaceModel& face, int j)
     {
+        m_tracks.emplace_back(FaceRecord(face), TrackInfo(m_id++));
+        m_tracks.back().second.signature = m_signatures[j];
+        m_tracks.back().second.detection = j;
     }
 
-    void update(const FaceModelVec& facesIn, FaceTrackVec& facesOut)
+    void measure(const FaceModelVec& facesIn, const Measurements* measurements)
     {
+        m_signatures.resize(facesIn.size());
+        m_scores.clear();
+        if (measurements)
+        {
+            m_scores = measurements->scores;
+        }
+
+        const bool doAppearance = measurements && !measurements->image.empty() && (m_association.appearance > 0.f);
+        for (std::size_t j = 0; j < facesIn.size(); j++)
+        {
+            m_signatures[j] = doAppearance ? computeSignature(measurements->image, measurements->H, facesIn[j], m_association.signatureWidth) : cv::Mat1f();
+        }
+    }
+
+    void updateVelocity(TrackInfo& info, const cv::Point2f& delta)
+    {
+        info.velocity = info.velocity * (1.f - m_motionGain) + delta * m_motionGain;
+    }
+
+    void predict(const std::vector<Motion>& motion, TrackRecord& track)
+    {
+        cv::Point2f delta;
+        if (getMotion(motion, track.first, delta))
+        {
+            updateVelocity(track.second, delta);
+        }
+        track.first.transform(transformation::translate(track.second.velocity));
+    }
+
+    void update(const FaceModelVec& facesIn, FaceTrackVec& facesOut, const Measurements* measurements = nullptr)
+    {
+        measure(facesIn, measurements);
+
+        auto& motion = m_pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            motion.clear();
+            std::swap(motion, m_motion);
+        }
+
         if (m_tracks.size() == 0)
         {
             // Initialize tracks:
-            for (const auto& f : facesIn)
+            for (std::size_t j = 0; j < facesIn.size(); j++)
             {
-                m_tracks.emplace_back(f, TrackInfo(m_id++));
+                startTrack(facesIn[j], j);
             }
         }
         else
         {
-            std::unordered_map<int, int> direct_assignment;
-            std::unordered_map<int, int> reverse_assignment;
-            std::vector<std::vector<double>> C;
+            const int rows = static_cast<int>(m_tracks.size()), cols = static_cast<int>(facesIn.size());
+            auto cost = [&](int i, int j) {
+                return this->cost(m_tracks[i], facesIn[j], j);
+            };
 
-            if (facesIn.size())
+            m_direct.assign(rows, -1);
+            if (cols)
             {
-                C = std::vector<std::vector<double>>(m_tracks.size(), std::vector<double>(facesIn.size()));
-                for (int i = 0; i < m_tracks.size(); i++)
+                if (m_assignment.resize(rows, cols))
                 {
-                    for (int j = 0; j < facesIn.size(); j++)
+                    // Fixed capacity fast path (no allocations), warm started from the last matching:
+                    m_prior.resize(rows);
+                    for (int i = 0; i < rows; i++)
                     {
-                        C[i][j] = cv::norm(*m_tracks[i].first.eyesCenter - *facesIn[j].eyesCenter);
+                        m_prior[i] = m_tracks[i].second.detection;
+                        for (int j = 0; j < cols; j++)
+                        {
+                            m_assignment(i, j) = cost(i, j);
+                        }
+                    }
+                    m_assignment.solve(m_direct.data(), m_prior.data());
+                }
+                else
+                {
+                    std::unordered_map<int, int> direct_assignment;
+                    std::unordered_map<int, int> reverse_assignment;
+                    std::vector<std::vector<double>> C(rows, std::vector<double>(cols));
+                    for (int i = 0; i < rows; i++)
+                    {
+                        for (int j = 0; j < cols; j++)
+                        {
+                            C[i][j] = cost(i, j);
+                        }
+                    }
+                    core::MinimizeLinearAssignment(C, direct_assignment, reverse_assignment);
+                    for (const auto& m : direct_assignment)
+                    {
+                        m_direct[m.first] = m.second;
                     }
                 }
-                core::MinimizeLinearAssignment(C, direct_assignment, reverse_assignment);
             }
 
             // For all valid assignments we will either
@@ -61,21 +271,41 @@ struct FaceTracker::Impl
             //  (2) extend an existing track
             // 
             // We will then start new tracks for all remaining unasigned detections:
-            std::vector<std::uint8_t> hits(m_tracks.size(), 0), assigned(facesIn.size(), 0);
-            for (const auto& m : direct_assignment)
+            auto& hits = m_hits;
+            auto& assigned = m_assigned;
+            hits.assign(rows, 0);
+            assigned.assign(cols, 0);
+            for (int i = 0; i < rows; i++)
             {
-                assigned[m.second] = 1;
+                const int j = m_direct[i];
+                if (j < 0)
+                {
+                    continue;
+                }
+
+                assigned[j] = 1;
 
                 // Create a new track, or update an old track:
-                if (C[m.first][m.second] > m_costThreshold)
+                if (distance(m_tracks[i].first, facesIn[j]) > m_costThreshold)
                 {
-                    m_tracks.emplace_back(facesIn[m.second], TrackInfo(m_id++));
+                    startTrack(facesIn[j], j);
                 }
                 else
                 {
-                    m_tracks[m.first].second.hit();
-                    m_tracks[m.first].first = facesIn[m.second];
-                    hits[m.first] = 1;
+                    auto& track = m_tracks[i];
+                    if (track.first.has(FaceRecord::kRoi) && facesIn[j].roi.has)
+                    {
+                        updateVelocity(track.second, center(facesIn[j].roi) - center(track.first.roi));
+                    }
+
+                    track.second.hit();
+                    track.second.detection = j;
+                    track.first.assign(facesIn[j]);
+                    if (!m_signatures[j].empty())
+                    {
+                        track.second.signature = m_signatures[j];
+                    }
+                    hits[i] = 1;
                 }
             }
 
@@ -84,6 +314,11 @@ struct FaceTracker::Impl
                 if (!hits[i])
                 {
                     m_tracks[i].second.miss();
+                    m_tracks[i].second.detection = -1;
+                    if (m_doPrediction && m_tracks[i].first.has(FaceRecord::kRoi))
+                    {
+                        predict(motion, m_tracks[i]);
+                    }
                 }
             }
 
@@ -92,34 +327,55 @@ struct FaceTracker::Impl
             {
                 if (!assigned[i])
                 {
-                    m_tracks.emplace_back(facesIn[i], TrackInfo(m_id++));
+                    startTrack(facesIn[i], i);
                 }
             }
             
             // Prune old tracks:
-            m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(), [this](const FaceTrack& track) {
+            m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(), [this](const TrackRecord& track) {
                 return (track.second.misses >= m_maxTrackMisses);
             }), m_tracks.end());
         }
 
         // Return subset of remaining mature tracks:
-        std::copy_if(m_tracks.begin(), m_tracks.end(), std::back_inserter(facesOut), [this](const FaceTrack& track) {
-            return (track.second.age > m_minTrackHits);
-        });
+        for (const auto& track : m_tracks)
+        {
+            if (track.second.age > m_minTrackHits)
+            {
+                facesOut.emplace_back(FaceModel(), track.second);
+                track.first.copyTo(facesOut.back().first);
+            }
+        }
     }
 
     float m_costThreshold = 0.15; // meters
     std::size_t m_minTrackHits = 3;
     std::size_t m_maxTrackMisses = 3;
+    float m_motionGain = 0.5f;
+    bool m_doPrediction = true;
 
     std::size_t m_id = 0;
 
-    FaceTrackVec m_tracks;
+    TrackRecordVec m_tracks;
+
+    Association m_association;
+
+    // Per frame scratch:
+    Assignment m_assignment;
+    std::vector<cv::Mat1f> m_signatures; // per detection
+    std::vector<double> m_scores;        // per detection (optional)
+    std::vector<int> m_direct; // track -> detection (or -1)
+    std::vector<int> m_prior;  // track -> last detection (or -1)
+    std::vector<std::uint8_t> m_hits, m_assigned;
+    std::vector<Motion> m_pending;
+
+    std::mutex m_mutex;
+    std::vector<Motion> m_motion; // external measurements since the last update
 };
 
-FaceTracker::FaceTracker(float costThreshold, std::size_t minTrackHits, std::size_t maxTrackMisses)
+FaceTracker::FaceTracker(float costThreshold, std::size_t minTrackHits, std::size_t maxTrackMisses, float motionGain)
 {
-    m_impl = drishti::core::make_unique<Impl>(costThreshold, minTrackHits, maxTrackMisses);
+    m_impl = drishti::core::make_unique<Impl>(costThreshold, minTrackHits, maxTrackMisses, motionGain);
 }
 
 FaceTracker::~FaceTracker() = default;
@@ -129,4 +385,34 @@ void FaceTracker::operator()(const FaceModelVec& facesIn, FaceTrackVec& facesOut
     m_impl->update(facesIn, facesOut);
 }
 
+void FaceTracker::operator()(const FaceModelVec& facesIn, FaceTrackVec& facesOut, const Measurements& measurements)
+{
+    m_impl->update(facesIn, facesOut, &measurements);
+}
+
+void FaceTracker::setAssociation(const Association& association)
+{
+    m_impl->m_association = association;
+}
+
+const FaceTracker::Association& FaceTracker::getAssociation() const
+{
+    return m_impl->m_association;
+}
+
+void FaceTracker::addMotion(const cv::Point2f& point, const cv::Point2f& delta)
+{
+    m_impl->addMotion(point, delta);
+}
+
+void FaceTracker::setDoPrediction(bool flag)
+{
+    m_impl->m_doPrediction = flag;
+}
+
+bool FaceTracker::getDoPrediction() const
+{
+    return m_impl->m_doPrediction;
+}
+
 DRISHTI_FACE_NAMESPACE_END
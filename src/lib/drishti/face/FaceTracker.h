@@ -50,6 +50,29 @@ public:
         std::size_t age = 0;
         std::size_t hits = 0;   // consecutive hits
         std::size_t misses = 0; // consecutive misses
+
+        cv::Point2f velocity; // smoothed roi motion (image pixels per update)
+        cv::Mat1f signature;  // appearance signature of the last assigned detection
+        int detection = -1;   // index of the last assigned detection (assignment warm start)
+    };
+
+    // Association cost: eyesCenter distance (normalized by costThreshold, which is still
+    // used for gating) plus weighted geometry, detection confidence and appearance terms:
+    struct Association
+    {
+        float iou = 0.5f;        // (1 - IoU) of the face rois
+        float scale = 0.5f;      // |log(width ratio)| of the face rois
+        float score = 0.25f;     // 1 / (1 + score) for the detection score
+        float appearance = 0.5f; // (1 - NCC) / 2 of the appearance signatures
+        int signatureWidth = 16; // appearance signature: signatureWidth^2 grayscale patch
+    };
+
+    // Optional per frame measurements for association:
+    struct Measurements
+    {
+        cv::Mat image;                      // grayscale (or BGR) image for appearance signatures
+        cv::Matx33f H = cv::Matx33f::eye(); // face -> image coordinates
+        std::vector<double> scores;         // detection scores (one per input face)
     };
 
     using FaceTrack = std::pair<drishti::face::FaceModel, TrackInfo>;
@@ -58,7 +81,7 @@ public:
 
     struct Impl;
 
-    explicit FaceTracker(float costThreshold = 0.15f, std::size_t minTrackHits = 3, std::size_t maxTrackMisses = 3);
+    explicit FaceTracker(float costThreshold = 0.15f, std::size_t minTrackHits = 3, std::size_t maxTrackMisses = 3, float motionGain = 0.5f);
     ~FaceTracker();
 
     FaceTracker(const FaceTracker&) = delete;
@@ -67,6 +90,19 @@ public:
     FaceTracker& operator=(FaceTracker&&) = delete;
 
     void operator()(const FaceModelVec& facesIn, FaceTrackVec& facesOut);
+    void operator()(const FaceModelVec& facesIn, FaceTrackVec& facesOut, const Measurements& measurements);
+
+    void setAssociation(const Association& association);
+    const Association& getAssociation() const;
+
+    // Tracks without a detection are propagated with a constant velocity model, where the
+    // velocity is an exponential average (motionGain) of the detection displacements and of
+    // external measurements (e.g., eye optical flow) accumulated since the last update.
+    // The measurement is assigned to the track whose roi contains point (thread safe):
+    void addMotion(const cv::Point2f& point, const cv::Point2f& delta);
+
+    void setDoPrediction(bool flag);
+    bool getDoPrediction() const;
 
 protected:
     std::unique_ptr<Impl> m_impl;
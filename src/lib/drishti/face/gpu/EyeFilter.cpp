@@ -13,6 +13,8 @@
 #include "drishti/eye/IrisNormalizer.h"
 #include "drishti/core/make_unique.h"
 #include "drishti/core/scope_guard.h"
+#include "drishti/graphics/temporal_binomial.h"
+#include "drishti/graphics/temporal_ring.h"
 
 #include "ogles_gpgpu/common/proc/transform.h"
 #include "ogles_gpgpu/common/proc/lowpass.h"
@@ -29,6 +31,9 @@ BEGIN_OGLES_GPGPU
 
 static void convert(const drishti::eye::EyeWarp& src, ogles_gpgpu::MappedTextureRegion& dst);
 
+// Binomial order for the fused modes (5 x 5 taps in 3 x 3 bilinear reads per frame):
+static const int kSpatialOrder = 4;
+
 EyeFilter::EyeFilter(const Size2d& sizeOut, Mode mode, float cutoff, int history)
     : m_history(history)
     , m_sizeOut(sizeOut)
@@ -69,6 +74,33 @@ EyeFilter::EyeFilter(const Size2d& sizeOut, Mode mode, float cutoff, int history
         }
         break;
 
+        case kMean3LowPass:
+        case kMean3Difference:
+        {
+            const auto output = (mode == kMean3LowPass) ? TemporalBinomialProc::kLowPass : TemporalBinomialProc::kDifference;
+            temporalProc = drishti::core::make_unique<TemporalBinomialProc>(kSpatialOrder, output);
+            temporalProc->setWeights({ 0.33f, 0.33f, 0.33f });
+            procPasses.push_back(temporalProc.get());
+
+            fifoProc->addWithDelay(temporalProc.get(), 0, 0);
+            fifoProc->addWithDelay(temporalProc.get(), 1, 1);
+            fifoProc->addWithDelay(temporalProc.get(), 2, 2);
+
+            lastProc = temporalProc.get();
+        }
+        break;
+
+        case kRing:
+        {
+            // One copy and one kernel pass per frame, independent of the history length:
+            ringProc = drishti::core::make_unique<TemporalRingProc>(history);
+            procPasses.push_back(ringProc.get());
+
+            transformProc.add(ringProc.get());
+            lastProc = ringProc.get();
+        }
+        break;
+
         case kNone:
         default:
         {
@@ -83,6 +115,14 @@ EyeFilter::~EyeFilter()
     procPasses.clear();
 }
 
+void EyeFilter::setTemporalKernel(const std::vector<float>& weights, float bias)
+{
+    if (ringProc)
+    {
+        ringProc->setKernel(weights, bias);
+    }
+}
+
 void EyeFilter::dump(std::vector<drishti::core::ImageView>& frames, std::vector<EyePair>& eyes, int n, bool getImage)
 {
     // FifoProc::operator[] will preserve temporal ordering
@@ -144,18 +184,33 @@ int EyeFilter::render(int position)
     drishti::face::FaceStabilizer stabilizer({ m_sizeOut.width, m_sizeOut.height });
     stabilizer.setDoAutoScaling(m_doAutoScaling);
 
-    if (m_faces.size())
+    // All eye pairs are rendered in a single pass (one scissored draw per eye):
+    const int count = std::min(static_cast<int>(m_faces.size()), m_maxFaces);
+    m_faceEyes.resize(count);
+    for (int k = 0; k < count; k++)
     {
-        // For now we display eyes from the first face:
-        m_eyes = stabilizer.renderEyes(m_faces[0], { getInFrameW(), getInFrameH() });
+        // Tile normalized coordinates -> atlas normalized coordinates:
+        const float rows = static_cast<float>(m_maxFaces);
+        const cv::Matx33f A = transformation::translate(0.f, (2.f * k + 1.f) / rows - 1.f) * transformation::scale(1.f, 1.f / rows);
+
+        auto& eyes = m_faceEyes[k];
+        eyes = stabilizer.renderEyes(m_faces[k], { getInFrameW(), getInFrameH() });
         for (int i = 0; i < 2; i++)
         {
+            eyes[i].H = A * eyes[i].H;
+            eyes[i].roi.y += static_cast<float>(k * m_sizeOut.height);
+
             MappedTextureRegion region;
-            convert(m_eyes[i], region);
+            convert(eyes[i], region);
             transformProc.addCrop(region); // will be cleared after render step
         }
     }
 
+    if (count)
+    {
+        m_eyes = m_faceEyes[0]; // primary face
+    }
+
     // Maintain eye history queue of size == 3
     m_eyeHistory.push_front(m_eyes);
     if (m_eyeHistory.size() > m_history)
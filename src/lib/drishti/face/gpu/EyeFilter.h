@@ -20,6 +20,8 @@ class LowPassFilterProc;
 class DiffProc;
 class FifoProc;
 class Fir3Proc;
+class TemporalBinomialProc;
+class TemporalRingProc;
 END_OGLES_GPGPU
 
 #include "drishti/face/gpu/FaceStabilizer.h"
@@ -32,6 +34,7 @@ END_OGLES_GPGPU
 
 #include <opencv2/core.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <deque>
 
@@ -50,6 +53,9 @@ public:
         kNone,
         kIirLowPass,
         kMean3,
+        kMean3LowPass,   // kMean3 + 2D binomial low pass, fused in one pass
+        kMean3Difference, // 0.5 + (current - kMean3LowPass), fused in one pass
+        kRing             // FIR over the last `history` frames (see setTemporalKernel())
     };
 
     EyeFilter(const Size2d& sizeOut, Mode mode, float cutoff, int history);
@@ -66,6 +72,15 @@ public:
         m_doAutoScaling = flag;
     }
 
+    // kRing: temporal weights (newest first) and bias, e.g., TemporalRingProc::difference():
+    void setTemporalKernel(const std::vector<float>& weights, float bias = 0.f);
+
+    // kRing: past eye atlas frames (nullptr in other modes):
+    TemporalRingProc* getRing() const
+    {
+        return ringProc.get();
+    }
+
     EyewWarpPair& getEyeWarps()
     {
         return m_eyes;
@@ -76,6 +91,30 @@ public:
         return m_eyes;
     }
 
+    // Eye pairs for up to maxFaces faces are rendered as sizeOut tiles stacked vertically
+    // (tile k at rows [k * height, (k + 1) * height)) in one output texture, so the output
+    // size should be set to getAtlasSize().  Each EyeWarp::H maps to the full atlas.
+    void setMaxFaces(int maxFaces)
+    {
+        m_maxFaces = std::max(maxFaces, 1);
+    }
+
+    int getMaxFaces() const
+    {
+        return m_maxFaces;
+    }
+
+    Size2d getAtlasSize() const
+    {
+        return { m_sizeOut.width, m_sizeOut.height * m_maxFaces };
+    }
+
+    // Eye warps for each face rendered in the last pass (getEyeWarps() == getFaceEyeWarps()[0]):
+    const std::vector<EyewWarpPair>& getFaceEyeWarps() const
+    {
+        return m_faceEyes;
+    }
+
     /**
      * Return the processors name.
      */
@@ -114,6 +153,9 @@ protected:
     EyewWarpPair m_eyes;
     std::deque<EyewWarpPair> m_eyeHistory;
 
+    int m_maxFaces = 1;
+    std::vector<EyewWarpPair> m_faceEyes;
+
     bool m_doAutoScaling = false;
 
     Size2d m_sizeOut;
@@ -123,6 +165,8 @@ protected:
     std::unique_ptr<FifoProc> fifoProc; // maintain buffer
     std::unique_ptr<LowPassFilterProc> lowPassProc;
     std::unique_ptr<Fir3Proc> mean3Proc;
+    std::unique_ptr<TemporalBinomialProc> temporalProc;
+    std::unique_ptr<TemporalRingProc> ringProc;
 
     ProcInterface* lastProc = nullptr;
     ProcInterface* firstProc = nullptr;
@@ -0,0 +1,160 @@
+/*! -*-c++-*-
+  @file   face/gpu/EyePatchFilter.cpp
+  @author David Hirvonen
+  @brief  Render packed eye pair patches on the GPU for eye model regression.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/EyePatchFilter.h"
+#include "drishti/geometry/motion.h"
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+BEGIN_OGLES_GPGPU
+
+static void convert(const cv::Rect& dst, const cv::Matx33f& H, ogles_gpgpu::MappedTextureRegion& region);
+
+EyePatchFilter::EyePatchFilter(int eyeWidth, int maxFaces)
+    : m_eyeSize(eyeWidth, (eyeWidth * 3) / 4) // FaceModel::getEyeRegions() aspect ratio
+    , m_maxFaces(std::max(maxFaces, 1))
+{
+    transformProc.setInterpolation(TransformProc::BICUBIC);
+    transformProc.setOutputSize(m_eyeSize.width * 2, m_eyeSize.height * m_maxFaces);
+}
+
+void EyePatchFilter::prepare(int inW, int inH)
+{
+    transformProc.prepare(inW, inH, GL_RGBA);
+}
+
+void EyePatchFilter::setAsyncReadback(bool flag, int depth)
+{
+    m_doAsync = flag;
+    m_depth = std::max(depth, 1);
+    m_ring.reset(); // created on the GL thread in render()
+    m_pending.clear();
+}
+
+void EyePatchFilter::addEyes(const RoiPair& rois)
+{
+    if (m_eyes.size() < m_maxFaces)
+    {
+        m_eyes.push_back(rois);
+    }
+}
+
+void EyePatchFilter::clearEyes()
+{
+    m_eyes.clear();
+}
+
+void EyePatchFilter::operator()(GLuint inputTexId, float Sti, std::vector<EyePatches>& patches)
+{
+    patches.clear();
+    while (m_pending.size())
+    {
+        fetch(patches); // drop stale async reads
+    }
+    if (render(inputTexId, Sti))
+    {
+        fetch(patches);
+    }
+}
+
+bool EyePatchFilter::render(GLuint inputTexId, float Sti)
+{
+    if (m_eyes.empty())
+    {
+        return false;
+    }
+
+    const cv::Size outSize(m_eyeSize.width * 2, m_eyeSize.height * m_maxFaces);
+    if (!m_ring)
+    {
+        m_ring = drishti::core::make_unique<PixelBufferRing>(outSize, m_doAsync ? m_depth : 1, m_doAsync);
+    }
+    if (m_ring->full())
+    {
+        m_eyes.clear();
+        return false; // caller hasn't consumed earlier reads
+    }
+
+    const cv::Matx33f No = transformation::normalize(outSize); // pixels to [-1.0 ... +1.0]
+
+    for (int i = 0; i < m_eyes.size(); i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            // Map the eye region onto its patch, mirroring the left eye:
+            const auto& roi = m_eyes[i][j];
+            const cv::Rect dst({ j * m_eyeSize.width, i * m_eyeSize.height }, m_eyeSize);
+            const float sx = float(m_eyeSize.width) / roi.width, sy = float(m_eyeSize.height) / roi.height;
+            const cv::Matx33f T = transformation::translate(-roi.x, -roi.y);
+            const cv::Matx33f S = transformation::scale((j == 0) ? sx : -sx, sy);
+            const cv::Matx33f D = transformation::translate(float(dst.x + ((j == 0) ? 0 : dst.width)), float(dst.y));
+
+            ogles_gpgpu::MappedTextureRegion region;
+            convert(dst, No * D * S * T, region);
+            transformProc.addCrop(region); // will be cleared after render step
+        }
+    }
+
+    transformProc.process(inputTexId, 1, GL_TEXTURE_2D);
+
+    // Single readback for all faces:
+    m_ring->push(transformProc.getOutputTexId());
+    m_pending.push_back({ m_eyes, Sti });
+    m_eyes.clear();
+    return true;
+}
+
+bool EyePatchFilter::fetch(std::vector<EyePatches>& patches, double* waitTime)
+{
+    patches.clear();
+    if (m_pending.empty() || !m_ring || !m_ring->pop(m_rgba, waitTime))
+    {
+        return false;
+    }
+
+    const Pending pending = std::move(m_pending.front());
+    m_pending.pop_front();
+
+    cv::cvtColor(m_rgba, m_gray, cv::COLOR_RGBA2GRAY);
+
+    patches.resize(pending.eyes.size());
+    for (int i = 0; i < pending.eyes.size(); i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            const auto& roi = pending.eyes[i][j];
+            const float Sti = pending.Sti;
+            patches[i].images[j] = m_gray({ { j * m_eyeSize.width, i * m_eyeSize.height }, m_eyeSize }).clone();
+            patches[i].rois[j] = { roi.x * Sti, roi.y * Sti, roi.width * Sti, roi.height * Sti };
+        }
+    }
+    return true;
+}
+
+// ############ UTILTIY ###############
+
+static void convert(const cv::Rect& dst, const cv::Matx33f& H, ogles_gpgpu::MappedTextureRegion& region)
+{
+    cv::Matx44f MVPt;
+    transformation::R3x3To4x4(H.t(), MVPt);
+    region.roi = Rect2d(dst.x, dst.y, dst.width, dst.height);
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            region.H.data[y][x] = MVPt(y, x);
+        }
+    }
+}
+
+END_OGLES_GPGPU
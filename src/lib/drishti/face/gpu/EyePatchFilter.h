@@ -0,0 +1,85 @@
+/*! -*-c++-*-
+  @file   face/gpu/EyePatchFilter.h
+  @author David Hirvonen
+  @brief  Render packed eye pair patches on the GPU for eye model regression.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Each face row holds { right, left } eye patches at a fixed width, with the left
+  eye mirrored to the right eye coordinate system, so the readback can be passed
+  to FaceDetector (see FaceDetector::PaddedImage::eyes) without CPU crop, flip
+  or resize.
+
+*/
+
+#ifndef __drishti_face_gpu_EyePatchFilter_h__
+#define __drishti_face_gpu_EyePatchFilter_h__
+
+#include "drishti/face/gpu/MultiTransformProc.h"
+#include "drishti/face/gpu/PixelBufferRing.h"
+#include "drishti/face/FaceDetector.h"
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+class EyePatchFilter
+{
+public:
+    using EyePatches = drishti::face::FaceDetector::EyePatches;
+    using RoiPair = std::array<cv::Rect2f, 2>;
+
+    EyePatchFilter(int eyeWidth, int maxFaces);
+
+    void prepare(int inW, int inH);
+
+    // Readback through a ring of PBOs (GL ES 3.0), so render() for frame n overlaps fetch() for n-1:
+    void setAsyncReadback(bool flag, int depth = 2);
+
+    // Eye regions { right, left } in input texture coordinates (at most maxFaces):
+    void addEyes(const RoiPair& rois);
+    void clearEyes();
+
+    // Render all eye pairs and read back single channel patches (rois are scaled by Sti: texture->image):
+    void operator()(GLuint inputTexId, float Sti, std::vector<EyePatches>& patches);
+
+    // Split form of operator(): render() queues a readback, fetch() returns the oldest one.
+    bool render(GLuint inputTexId, float Sti);
+    bool fetch(std::vector<EyePatches>& patches, double* waitTime = nullptr);
+    std::size_t pending() const { return m_pending.size(); }
+    bool isAsync() const { return m_doAsync; }
+
+    const cv::Size& getEyeSize() const { return m_eyeSize; }
+    int getMaxFaces() const { return m_maxFaces; }
+
+protected:
+    cv::Size m_eyeSize;
+    int m_maxFaces = 1;
+
+    struct Pending
+    {
+        std::vector<RoiPair> eyes;
+        float Sti; // texture->image scale of the queued render
+    };
+
+    std::vector<RoiPair> m_eyes;
+    std::deque<Pending> m_pending; // metadata for queued readbacks (oldest first)
+
+    bool m_doAsync = false;
+    int m_depth = 1;
+
+    MultiTransformProc transformProc;
+    std::unique_ptr<PixelBufferRing> m_ring;
+    cv::Mat4b m_rgba; // readback buffer (reused)
+    cv::Mat1b m_gray;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_face_gpu_EyePatchFilter_h__
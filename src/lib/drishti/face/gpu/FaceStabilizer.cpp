@@ -19,15 +19,24 @@ FaceStabilizer::FaceStabilizer(const cv::Size& sizeOut)
 {
 }
 
-cv::Matx33f FaceStabilizer::stabilize(const drishti::face::FaceModel& face, const cv::Size& sizeOut, float span)
+std::array<cv::Point2f, 2> FaceStabilizer::getEyeCenters(const drishti::face::FaceModel& face)
 {
-    using PointPair = std::array<cv::Point2f, 2>;
-
-    PointPair eyeCenters{ { face.eyeFullR->irisEllipse.center, face.eyeFullL->irisEllipse.center } };
+    std::array<cv::Point2f, 2> eyeCenters{ { face.eyeFullR->irisEllipse.center, face.eyeFullL->irisEllipse.center } };
     if (std::min(face.eyeFullR->openness(), face.eyeFullL->openness()) < 0.1f)
     {
         eyeCenters = { { core::centroid(face.eyeRight), core::centroid(face.eyeLeft) } };
     }
+    return eyeCenters;
+}
+
+cv::Matx33f FaceStabilizer::stabilize(const drishti::face::FaceModel& face, const cv::Size& sizeOut, float span)
+{
+    return stabilize(getEyeCenters(face), sizeOut, span);
+}
+
+cv::Matx33f FaceStabilizer::stabilize(const std::array<cv::Point2f, 2>& eyeCenters, const cv::Size& sizeOut, float span)
+{
+    using PointPair = std::array<cv::Point2f, 2>;
 
     // clang-format off
     const PointPair screenCenters
@@ -91,4 +100,43 @@ FaceStabilizer::renderEyes(const std::array<cv::Point2f, 2>& eyeCenters, const c
     return cropInfo;
 }
 
+// ::: FaceStabilizerFilter :::
+
+FaceStabilizerFilter::FaceStabilizerFilter(const cv::Size& sizeOut, float span, float gain)
+    : m_sizeOut(sizeOut)
+    , m_span(span)
+    , m_gain(std::min(std::max(gain, 0.f), 1.f))
+{
+}
+
+bool FaceStabilizerFilter::update(const drishti::face::FaceModel& face, const cv::Matx33f* motion)
+{
+    if (!face.points.has)
+    {
+        return m_has;
+    }
+
+    const auto eyeCenters = FaceStabilizer::getEyeCenters(face);
+    for (int i = 0; i < 2; i++)
+    {
+        if (m_has && motion)
+        {
+            const cv::Point3f q = (*motion) * cv::Point3f(m_eyeCenters[i].x, m_eyeCenters[i].y, 1.f);
+            m_eyeCenters[i] = { q.x, q.y };
+        }
+        m_eyeCenters[i] = m_has ? (m_eyeCenters[i] + (eyeCenters[i] - m_eyeCenters[i]) * m_gain) : eyeCenters[i];
+    }
+    m_has = true;
+
+    // Similarity in pixels -> texture coordinates:
+    const cv::Matx33f S = transformation::denormalize(m_sizeOut);
+    const cv::Matx33f H = FaceStabilizer::stabilize(m_eyeCenters, m_sizeOut, m_span);
+
+    cv::Matx44f MVP;
+    transformation::R3x3To4x4(S.inv() * H * S, MVP);
+    m_MVPt = MVP.t();
+
+    return true;
+}
+
 DRISHTI_FACE_NAMESPACE_END
@@ -36,6 +36,8 @@ public:
         m_autoScaling = flag;
     }
 
+    static std::array<cv::Point2f, 2> getEyeCenters(const drishti::face::FaceModel& face);
+    static cv::Matx33f stabilize(const std::array<cv::Point2f, 2>& eyeCenters, const cv::Size& sizeOut, float span);
     static cv::Matx33f stabilize(const drishti::face::FaceModel& face, const cv::Size& sizeOut, float span);
     std::array<eye::EyeWarp, 2> renderEyes(const drishti::face::FaceModel& face, const cv::Size& sizeIn) const;
     std::array<eye::EyeWarp, 2> renderEyes(const std::array<cv::Point2f, 2>& eyes, const cv::Size& sizeIn) const;
@@ -51,6 +53,33 @@ protected:
     cv::Size m_sizeOut;
 };
 
+// Temporal stabilization: eye centers are exponentially smoothed (gain 1 == no smoothing)
+// before the similarity is estimated, and the result is provided as a transposed 4x4 texture
+// transformation that can be uploaded as is (i.e., TransformProc::setTransformMatrix()).
+class FaceStabilizerFilter
+{
+public:
+    FaceStabilizerFilter(const cv::Size& sizeOut, float span = 0.33f, float gain = 0.5f);
+
+    // Returns false until the first face with landmarks is seen (previous state is kept otherwise).
+    // With the (optional) camera motion since the last update the smoothed state follows the
+    // camera, so that only the residual eye motion is smoothed (i.e., no lag during pans):
+    bool update(const drishti::face::FaceModel& face, const cv::Matx33f* motion = nullptr);
+    void reset() { m_has = false; }
+
+    bool has() const { return m_has; }
+    const cv::Matx44f& getTransformMatrix() const { return m_MVPt; }
+
+protected:
+    cv::Size m_sizeOut;
+    float m_span = 0.33f;
+    float m_gain = 0.5f;
+
+    bool m_has = false;
+    std::array<cv::Point2f, 2> m_eyeCenters;
+    cv::Matx44f m_MVPt = cv::Matx44f::eye();
+};
+
 DRISHTI_FACE_NAMESPACE_END
 
 #endif // __drishti_face_gpu_FaceStabilizer_h__
@@ -0,0 +1,139 @@
+/*! -*-c++-*-
+  @file   face/gpu/FaceTileFilter.cpp
+  @author David Hirvonen
+  @brief  Render padded face regions at regression resolution into a packed luma atlas.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/FaceTileFilter.h"
+#include "drishti/geometry/motion.h"
+
+#include <algorithm>
+#include <cmath>
+
+BEGIN_OGLES_GPGPU
+
+static void convert(const cv::Rect& dst, const cv::Matx33f& H, ogles_gpgpu::MappedTextureRegion& region);
+
+FaceTileFilter::FaceTileFilter(int tileWidth, int maxFaces, bool bgra)
+    : m_tileWidth(std::max(((tileWidth + 3) / 4) * 4, 4)) // luma packing: width % 4 == 0
+    , m_maxFaces(std::max(maxFaces, 1))
+    , atlasPack(CropPackProc::PLANE, bgra)
+    , framePack(CropPackProc::PLANE, bgra)
+{
+    transformProc.setOutputSize(m_tileWidth * m_maxFaces, m_tileWidth);
+}
+
+void FaceTileFilter::prepare(int inW, int inH)
+{
+    m_inputSize = { inW, inH };
+    transformProc.prepare(inW, inH, GL_RGBA);
+
+    const cv::Size atlasSize(m_tileWidth * m_maxFaces, m_tileWidth);
+    atlasPack.setImageSize(atlasSize.width, atlasSize.height);
+    atlasPack.prepare(atlasSize.width, atlasSize.height, GL_RGBA);
+}
+
+bool FaceTileFilter::addFace(const cv::Rect2f& roi, float Sti)
+{
+    // Snap to the regression image grid, so that tiles are pure translations of the full image:
+    const cv::Point tl(static_cast<int>(std::floor(roi.x * Sti)), static_cast<int>(std::floor(roi.y * Sti)));
+    const cv::Point br(static_cast<int>(std::ceil(roi.br().x * Sti)), static_cast<int>(std::ceil(roi.br().y * Sti)));
+    const cv::Size imageSize(cvRound(m_inputSize.width * Sti), cvRound(m_inputSize.height * Sti));
+    const cv::Rect tile = cv::Rect(tl, br) & cv::Rect({ 0, 0 }, imageSize);
+
+    if ((m_rois.size() >= m_maxFaces) || (tile.width > m_tileWidth) || (tile.height > m_tileWidth) || !tile.area())
+    {
+        return false;
+    }
+
+    m_rois.push_back(tile);
+    m_Sti = Sti;
+    return true;
+}
+
+void FaceTileFilter::clearFaces()
+{
+    m_rois.clear();
+}
+
+bool FaceTileFilter::operator()(GLuint inputTexId, std::vector<Tile>& tiles)
+{
+    tiles.clear();
+    if (m_rois.empty())
+    {
+        return false;
+    }
+
+    const cv::Size atlasSize(m_tileWidth * m_maxFaces, m_tileWidth);
+    const cv::Matx33f No = transformation::normalize(atlasSize); // pixels to [-1.0 ... +1.0]
+
+    for (int i = 0; i < m_rois.size(); i++)
+    {
+        // texture -> regression image -> tile:
+        const auto& roi = m_rois[i];
+        const cv::Rect dst({ i * m_tileWidth, 0 }, roi.size());
+        const cv::Matx33f S = transformation::scale(m_Sti, m_Sti);
+        const cv::Matx33f D = transformation::translate(float(dst.x - roi.x), float(dst.y - roi.y));
+
+        ogles_gpgpu::MappedTextureRegion region;
+        convert(dst, No * D * S, region);
+        transformProc.addCrop(region); // will be cleared after render step
+    }
+
+    transformProc.process(inputTexId, 1, GL_TEXTURE_2D);
+    atlasPack.process(transformProc.getOutputTexId(), 1, GL_TEXTURE_2D);
+
+    // A new atlas per call: the tiles are handed to (and owned by) the CPU scene job
+    cv::Mat1b atlas(atlasSize);
+    atlasPack.getResultData(atlas.data);
+
+    tiles.resize(m_rois.size());
+    for (int i = 0; i < m_rois.size(); i++)
+    {
+        tiles[i].image = atlas({ { i * m_tileWidth, 0 }, m_rois[i].size() });
+        tiles[i].roi = m_rois[i];
+    }
+
+    m_rois.clear();
+    return true;
+}
+
+void FaceTileFilter::operator()(GLuint inputTexId, const cv::Size& imageSize, cv::Mat1b& image)
+{
+    const cv::Size size(((imageSize.width + 3) / 4) * 4, imageSize.height);
+    if (m_frameSize != size)
+    {
+        framePack.setImageSize(size.width, size.height);
+        framePack.setRoi(0.f, 0.f, float(size.width) / float(imageSize.width), 1.f); // padding columns (if any) are clamped
+        framePack.prepare(m_inputSize.width, m_inputSize.height, GL_RGBA);
+        m_frameSize = size;
+    }
+
+    framePack.process(inputTexId, 1, GL_TEXTURE_2D);
+
+    cv::Mat1b frame(size);
+    framePack.getResultData(frame.data);
+    image = frame({ { 0, 0 }, imageSize });
+}
+
+// ############ UTILTIY ###############
+
+static void convert(const cv::Rect& dst, const cv::Matx33f& H, ogles_gpgpu::MappedTextureRegion& region)
+{
+    cv::Matx44f MVPt;
+    transformation::R3x3To4x4(H.t(), MVPt);
+    region.roi = Rect2d(dst.x, dst.y, dst.width, dst.height);
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            region.H.data[y][x] = MVPt(y, x);
+        }
+    }
+}
+
+END_OGLES_GPGPU
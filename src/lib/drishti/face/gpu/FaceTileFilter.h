@@ -0,0 +1,70 @@
+/*! -*-c++-*-
+  @file   face/gpu/FaceTileFilter.h
+  @author David Hirvonen
+  @brief  Render padded face regions at regression resolution into a packed luma atlas.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Face and eye regression only read pixels near the tracked faces, so the full upright
+  grayscale frame is replaced by one tile per face, sampled on the regression image grid
+  (integer offsets, so tile pixels match the full frame image exactly), with 4 pixels
+  packed per texel for a single byte per pixel readback.  The full frame is still rendered
+  (at the same resolution) for detection frames.
+
+*/
+
+#ifndef __drishti_face_gpu_FaceTileFilter_h__
+#define __drishti_face_gpu_FaceTileFilter_h__
+
+#include "drishti/face/gpu/MultiTransformProc.h"
+#include "drishti/graphics/crop_pack.h"
+#include "drishti/face/FaceDetector.h"
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+class FaceTileFilter
+{
+public:
+    using Tile = drishti::face::FaceDetector::ImageTile; // image: view of the readback atlas
+
+    FaceTileFilter(int tileWidth, int maxFaces, bool bgra);
+
+    void prepare(int inW, int inH);
+
+    // Padded face region in input texture coordinates (rois are scaled by Sti: texture->image),
+    // returns false if the region doesn't fit a tile (i.e., the full frame is needed):
+    bool addFace(const cv::Rect2f& roi, float Sti);
+    void clearFaces();
+    std::size_t size() const { return m_rois.size(); }
+
+    // Render all tiles with a single packed atlas readback (the rois are cleared):
+    bool operator()(GLuint inputTexId, std::vector<Tile>& tiles);
+
+    // Full frame at regression resolution (imageSize) for detection frames:
+    void operator()(GLuint inputTexId, const cv::Size& imageSize, cv::Mat1b& image);
+
+    int getTileWidth() const { return m_tileWidth; }
+    int getMaxFaces() const { return m_maxFaces; }
+
+protected:
+    int m_tileWidth = 256;
+    int m_maxFaces = 1;
+    cv::Size m_inputSize;
+
+    std::vector<cv::Rect> m_rois; // regression image coordinates
+    float m_Sti = 1.f;
+
+    MultiTransformProc transformProc; // tiles -> RGBA atlas
+    CropPackProc atlasPack;           // RGBA atlas -> packed luma
+    CropPackProc framePack;           // input -> packed luma (full frame)
+    cv::Size m_frameSize;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_face_gpu_FaceTileFilter_h__
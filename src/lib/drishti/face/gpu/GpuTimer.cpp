@@ -0,0 +1,244 @@
+/*! -*-c++-*-
+  @file   face/gpu/GpuTimer.cpp
+  @author David Hirvonen
+  @brief  Asynchronous GPU stage timing with timestamp queries.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/GpuTimer.h"
+
+#include <algorithm>
+#include <cstring>
+
+BEGIN_OGLES_GPGPU
+
+// GL ES exposes the same queries through GL_EXT_disjoint_timer_query:
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+#if defined(OGLES_GPGPU_OPENGLES)
+static void genQueries(GLsizei n, GLuint* ids) { glGenQueriesEXT(n, ids); }
+static void deleteQueries(GLsizei n, const GLuint* ids) { glDeleteQueriesEXT(n, ids); }
+static void queryCounter(GLuint id) { glQueryCounterEXT(id, GL_TIMESTAMP_EXT); }
+static bool isAvailable(GLuint id)
+{
+    GLuint available = 0;
+    glGetQueryObjectuivEXT(id, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    return (available != 0);
+}
+static std::uint64_t getResult(GLuint id)
+{
+    GLuint64 value = 0;
+    glGetQueryObjectui64vEXT(id, GL_QUERY_RESULT_EXT, &value);
+    return value;
+}
+static std::uint64_t getTimestamp()
+{
+    GLint64 value = 0;
+    glGetInteger64vEXT(GL_TIMESTAMP_EXT, &value);
+    return static_cast<std::uint64_t>(value);
+}
+static int getCounterBits()
+{
+    GLint bits = 0;
+    glGetQueryivEXT(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &bits);
+    return bits;
+}
+static bool isDisjoint()
+{
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint); // clears the flag
+    return (disjoint != 0);
+}
+static bool hasExtension()
+{
+    // The entry points can't be called on drivers without the extension:
+    const auto* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    return extensions && std::strstr(extensions, "GL_EXT_disjoint_timer_query");
+}
+#else
+static void genQueries(GLsizei n, GLuint* ids) { glGenQueries(n, ids); }
+static void deleteQueries(GLsizei n, const GLuint* ids) { glDeleteQueries(n, ids); }
+static void queryCounter(GLuint id) { glQueryCounter(id, GL_TIMESTAMP); }
+static bool isAvailable(GLuint id)
+{
+    GLuint available = 0;
+    glGetQueryObjectuiv(id, GL_QUERY_RESULT_AVAILABLE, &available);
+    return (available != 0);
+}
+static std::uint64_t getResult(GLuint id)
+{
+    GLuint64 value = 0;
+    glGetQueryObjectui64v(id, GL_QUERY_RESULT, &value);
+    return value;
+}
+static std::uint64_t getTimestamp()
+{
+    GLint64 value = 0;
+    glGetInteger64v(GL_TIMESTAMP, &value);
+    return static_cast<std::uint64_t>(value);
+}
+static int getCounterBits()
+{
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    return bits;
+}
+static bool isDisjoint()
+{
+    return false; // desktop timestamps are monotonic
+}
+static bool hasExtension()
+{
+    return true; // core since 3.3
+}
+#endif
+#endif // DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+
+GpuTimer::GpuTimer(std::size_t capacity)
+    : m_slots(std::max(capacity, std::size_t(1)))
+{
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+    m_good = hasExtension() && (getCounterBits() > 0);
+    if (m_good)
+    {
+        for (int i = static_cast<int>(m_slots.size()) - 1; i >= 0; i--)
+        {
+            genQueries(2, m_slots[i].queries);
+            m_free.push_back(i);
+        }
+        isDisjoint(); // reset
+        calibrate();
+        Tools::checkGLErr("GpuTimer", "GpuTimer() : genQueries()");
+    }
+#endif
+}
+
+GpuTimer::~GpuTimer()
+{
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+    for (auto& slot : m_slots)
+    {
+        if (slot.queries[0])
+        {
+            deleteQueries(2, slot.queries);
+        }
+    }
+#endif
+}
+
+GpuTimer::Scope GpuTimer::scope(int stage, std::uint64_t frame)
+{
+    return Scope(this, begin(stage, frame));
+}
+
+int GpuTimer::begin(int stage, std::uint64_t frame)
+{
+    if (!m_good)
+    {
+        return -1;
+    }
+    if (m_free.empty())
+    {
+        m_dropped++;
+        return -1;
+    }
+
+    const int index = m_free.back();
+    m_free.pop_back();
+
+    auto& slot = m_slots[index];
+    slot.stage = stage;
+    slot.frame = frame;
+    slot.isOpen = true;
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+    queryCounter(slot.queries[0]);
+#endif
+    m_pending.push_back(index);
+    return index;
+}
+
+void GpuTimer::end(int index)
+{
+    if (index < 0)
+    {
+        return;
+    }
+
+    auto& slot = m_slots[index];
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+    queryCounter(slot.queries[1]);
+#endif
+    slot.isOpen = false;
+}
+
+void GpuTimer::release(int index)
+{
+    m_slots[index].isOpen = false;
+    m_free.push_back(index);
+}
+
+void GpuTimer::calibrate()
+{
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+    m_gpuEpoch = getTimestamp();
+    m_cpuEpoch = HighResolutionClock::now();
+#endif
+}
+
+std::size_t GpuTimer::poll(std::vector<Span>& spans)
+{
+    std::size_t count = 0;
+#if DRISHTI_FACE_GPU_HAS_TIMER_QUERY
+    if (!m_good)
+    {
+        return count;
+    }
+
+    // Results of queries in flight during a disjoint event (e.g., a frequency change) are undefined:
+    if (isDisjoint())
+    {
+        while (!m_pending.empty() && !m_slots[m_pending.front()].isOpen)
+        {
+            release(m_pending.front());
+            m_pending.pop_front();
+            m_disjoint++;
+        }
+        calibrate();
+        return count;
+    }
+
+    const auto toCpu = [&](std::uint64_t gpu) {
+        const auto ns = static_cast<std::int64_t>(gpu) - static_cast<std::int64_t>(m_gpuEpoch);
+        return m_cpuEpoch + std::chrono::duration_cast<HighResolutionClock::duration>(std::chrono::nanoseconds(ns));
+    };
+
+    // The begin query was issued before the end query, so it is complete when the end query is:
+    while (!m_pending.empty())
+    {
+        auto& slot = m_slots[m_pending.front()];
+        if (slot.isOpen || !isAvailable(slot.queries[1]))
+        {
+            break;
+        }
+
+        const std::uint64_t t0 = getResult(slot.queries[0]), t1 = getResult(slot.queries[1]);
+
+        Span span;
+        span.stage = slot.stage;
+        span.frame = slot.frame;
+        span.start = toCpu(t0);
+        span.end = toCpu(std::max(t0, t1));
+        span.duration = static_cast<double>(std::max(t0, t1) - t0) * 1e-9;
+        spans.push_back(span);
+        count++;
+
+        release(m_pending.front());
+        m_pending.pop_front();
+    }
+#endif
+    return count;
+}
+
+END_OGLES_GPGPU
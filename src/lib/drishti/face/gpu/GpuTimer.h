@@ -0,0 +1,142 @@
+/*! -*-c++-*-
+  @file   face/gpu/GpuTimer.h
+  @author David Hirvonen
+  @brief  Asynchronous GPU stage timing with timestamp queries.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  scope() brackets the GL commands of a stage with two timestamp queries (GL_TIMESTAMP, or
+  GL_EXT_disjoint_timer_query on GL ES), and poll() collects the spans whose queries are
+  complete, typically a few frames later, without stalling the pipeline.  GPU timestamps
+  are mapped to the CPU clock with an offset measured at creation (and after a disjoint
+  event), so spans can be merged with CPU spans (e.g., core::StageTracer).  Contexts
+  without timer queries (e.g., iOS) are reported by good() and record nothing.
+
+*/
+
+#ifndef __drishti_face_gpu_GpuTimer_h__
+#define __drishti_face_gpu_GpuTimer_h__
+
+#include "ogles_gpgpu/common/common_includes.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// clang-format off
+#if defined(OGLES_GPGPU_OPENGLES)
+#  if defined(GL_EXT_disjoint_timer_query) && defined(GL_TIMESTAMP_EXT) && defined(GL_GLEXT_PROTOTYPES)
+#    define DRISHTI_FACE_GPU_HAS_TIMER_QUERY 1
+#  else
+#    define DRISHTI_FACE_GPU_HAS_TIMER_QUERY 0
+#  endif
+#else
+#  if defined(GL_TIMESTAMP)
+#    define DRISHTI_FACE_GPU_HAS_TIMER_QUERY 1
+#  else
+#    define DRISHTI_FACE_GPU_HAS_TIMER_QUERY 0
+#  endif
+#endif
+// clang-format on
+
+BEGIN_OGLES_GPGPU
+
+class GpuTimer
+{
+public:
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+    using TimePoint = HighResolutionClock::time_point;
+
+    struct Span
+    {
+        int stage = 0;
+        std::uint64_t frame = 0;
+        TimePoint start, end; // CPU clock
+        double duration = 0.0; // seconds
+    };
+
+    // Ends the span on destruction (move only):
+    class Scope
+    {
+    public:
+        Scope() = default;
+        Scope(GpuTimer* timer, int slot)
+            : m_timer(timer)
+            , m_slot(slot)
+        {
+        }
+        Scope(Scope&& other) noexcept
+            : m_timer(other.m_timer)
+            , m_slot(other.m_slot)
+        {
+            other.m_timer = nullptr;
+        }
+        Scope& operator=(Scope&&) = delete;
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope()
+        {
+            if (m_timer)
+            {
+                m_timer->end(m_slot);
+            }
+        }
+
+    protected:
+        GpuTimer* m_timer = nullptr;
+        int m_slot = -1;
+    };
+
+    // capacity: spans in flight, new spans are dropped while all of them are pending:
+    explicit GpuTimer(std::size_t capacity = 64);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer(GpuTimer&&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+    GpuTimer& operator=(GpuTimer&&) = delete;
+
+    // Timer queries are supported by the current context:
+    bool good() const { return m_good; }
+
+    // Time the GL commands issued during the lifetime of the returned object:
+    Scope scope(int stage, std::uint64_t frame);
+
+    // Append the completed spans (in begin order) without blocking, returns the count:
+    std::size_t poll(std::vector<Span>& spans);
+
+    std::size_t getPending() const { return m_pending.size(); }
+    std::size_t getDropped() const { return m_dropped; }   // spans not recorded (capacity)
+    std::size_t getDisjoint() const { return m_disjoint; } // spans discarded (disjoint events)
+
+protected:
+    struct Slot
+    {
+        GLuint queries[2] = { 0, 0 }; // begin, end
+        int stage = 0;
+        std::uint64_t frame = 0;
+        bool isOpen = false;
+    };
+
+    int begin(int stage, std::uint64_t frame);
+    void end(int slot);
+    void calibrate();
+    void release(int slot);
+
+    bool m_good = false;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_free;
+    std::deque<int> m_pending; // begin order
+
+    TimePoint m_cpuEpoch;       // CPU time at ...
+    std::uint64_t m_gpuEpoch{}; // ... this GPU time (nanoseconds)
+
+    std::size_t m_dropped = 0;
+    std::size_t m_disjoint = 0;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_face_gpu_GpuTimer_h__
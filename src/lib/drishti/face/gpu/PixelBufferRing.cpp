@@ -0,0 +1,151 @@
+/*! -*-c++-*-
+  @file   face/gpu/PixelBufferRing.cpp
+  @author David Hirvonen
+  @brief  Asynchronous texture readback through a ring of pixel buffer objects.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/PixelBufferRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+BEGIN_OGLES_GPGPU
+
+PixelBufferRing::PixelBufferRing(const cv::Size& size, int depth, bool doAsync)
+    : m_size(size)
+    , m_doAsync(doAsync && DRISHTI_FACE_GPU_HAS_PBO)
+    , m_slots(std::max(depth, 1))
+{
+    glGenFramebuffers(1, &m_fbo);
+
+#if DRISHTI_FACE_GPU_HAS_PBO
+    if (m_doAsync)
+    {
+        const auto bytes = static_cast<GLsizeiptr>(m_size.area() * 4);
+        for (auto& slot : m_slots)
+        {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        Tools::checkGLErr("PixelBufferRing", "PixelBufferRing() : glBufferData()");
+    }
+#endif
+}
+
+PixelBufferRing::~PixelBufferRing()
+{
+    for (auto& slot : m_slots)
+    {
+#if DRISHTI_FACE_GPU_HAS_PBO
+        if (slot.fence)
+        {
+            glDeleteSync(slot.fence);
+        }
+#endif
+        if (slot.pbo)
+        {
+            glDeleteBuffers(1, &slot.pbo);
+        }
+    }
+    if (m_fbo)
+    {
+        glDeleteFramebuffers(1, &m_fbo);
+    }
+}
+
+void PixelBufferRing::bindTexture(GLuint texId)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texId, 0);
+}
+
+bool PixelBufferRing::push(GLuint texId)
+{
+    if (full())
+    {
+        return false;
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    bindTexture(texId);
+
+    auto& slot = m_slots[m_next];
+#if DRISHTI_FACE_GPU_HAS_PBO
+    if (m_doAsync)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glReadPixels(0, 0, m_size.width, m_size.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    else
+#endif
+    {
+        slot.image.create(m_size);
+        glReadPixels(0, 0, m_size.width, m_size.height, GL_RGBA, GL_UNSIGNED_BYTE, slot.image.ptr());
+    }
+    Tools::checkGLErr("PixelBufferRing", "push() : glReadPixels()");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+    m_pending.push_back(m_next);
+    m_next = (m_next + 1) % static_cast<int>(m_slots.size());
+    return true;
+}
+
+bool PixelBufferRing::pop(cv::Mat4b& image, double* waitTime)
+{
+    if (empty())
+    {
+        return false;
+    }
+
+    auto& slot = m_slots[m_pending.front()];
+    m_pending.pop_front();
+
+    double elapsed = 0.0;
+#if DRISHTI_FACE_GPU_HAS_PBO
+    if (m_doAsync)
+    {
+        if (slot.fence)
+        {
+            const auto tic = std::chrono::high_resolution_clock::now();
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tic).count();
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+
+        const auto bytes = static_cast<GLsizeiptr>(m_size.area() * 4);
+        image.create(m_size);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (const auto* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT))
+        {
+            std::memcpy(image.ptr(), data, static_cast<std::size_t>(bytes));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    else
+#endif
+    {
+        image = slot.image;
+        slot.image = cv::Mat4b(); // hand over ownership
+    }
+
+    if (waitTime)
+    {
+        *waitTime = elapsed;
+    }
+    return true;
+}
+
+END_OGLES_GPGPU
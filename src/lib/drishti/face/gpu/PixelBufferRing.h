@@ -0,0 +1,82 @@
+/*! -*-c++-*-
+  @file   face/gpu/PixelBufferRing.h
+  @author David Hirvonen
+  @brief  Asynchronous texture readback through a ring of pixel buffer objects.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  push() queues a glReadPixels into the next pixel buffer object followed by a fence,
+  so the transfer overlaps subsequent GPU work; pop() maps the oldest buffer, waiting
+  on its fence only if the transfer is still in flight.  Devices without GL ES 3.0
+  (or builds without PBO/sync symbols) fall back to a synchronous read in push().
+
+*/
+
+#ifndef __drishti_face_gpu_PixelBufferRing_h__
+#define __drishti_face_gpu_PixelBufferRing_h__
+
+#include "ogles_gpgpu/common/common_includes.h"
+
+#include <opencv2/core.hpp>
+
+#include <deque>
+#include <vector>
+
+// clang-format off
+#if defined(GL_PIXEL_PACK_BUFFER) && defined(GL_SYNC_GPU_COMMANDS_COMPLETE)
+#  define DRISHTI_FACE_GPU_HAS_PBO 1
+#else
+#  define DRISHTI_FACE_GPU_HAS_PBO 0
+#endif
+// clang-format on
+
+BEGIN_OGLES_GPGPU
+
+class PixelBufferRing
+{
+public:
+    // depth: number of buffers in flight, doAsync: requires GL ES 3.0 (ignored otherwise)
+    PixelBufferRing(const cv::Size& size, int depth, bool doAsync);
+    ~PixelBufferRing();
+
+    PixelBufferRing(const PixelBufferRing&) = delete;
+    PixelBufferRing(PixelBufferRing&&) = delete;
+    PixelBufferRing& operator=(const PixelBufferRing&) = delete;
+    PixelBufferRing& operator=(PixelBufferRing&&) = delete;
+
+    // Queue a read of an RGBA texture (returns false if the ring is full):
+    bool push(GLuint texId);
+
+    // Retrieve the oldest read, waitTime is the fence wait in seconds (returns false if empty):
+    bool pop(cv::Mat4b& image, double* waitTime = nullptr);
+
+    bool isAsync() const { return m_doAsync; }
+    bool full() const { return m_pending.size() >= m_slots.size(); }
+    bool empty() const { return m_pending.empty(); }
+    std::size_t size() const { return m_pending.size(); }
+    const cv::Size& getSize() const { return m_size; }
+
+protected:
+    struct Slot
+    {
+        GLuint pbo = 0;
+#if DRISHTI_FACE_GPU_HAS_PBO
+        GLsync fence = nullptr;
+#endif
+        cv::Mat4b image; // synchronous fallback
+    };
+
+    void bindTexture(GLuint texId);
+
+    cv::Size m_size;
+    bool m_doAsync = false;
+    GLuint m_fbo = 0;
+    std::vector<Slot> m_slots;
+    std::deque<int> m_pending; // slot indices, oldest first
+    int m_next = 0;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_face_gpu_PixelBufferRing_h__
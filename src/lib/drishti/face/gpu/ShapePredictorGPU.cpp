@@ -0,0 +1,762 @@
+/*! -*-c++-*-
+  @file   face/gpu/ShapePredictorGPU.cpp
+  @author David Hirvonen
+  @brief  Implementation of a GPU backend for regression tree ensemble shape estimation.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/face/gpu/ShapePredictorGPU.h"
+#include "drishti/core/MemoryRegistry.h"
+#include "drishti/core/make_unique.h"
+#include "drishti/graphics/ProgramCache.h"
+#include "drishti/ml/shape_predictor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// clang-format off
+#if defined(GL_ES_VERSION_3_0) || (defined(GL_VERSION_3_3) && !defined(OGLES_GPGPU_OPENGLES))
+#  define DRISHTI_SHAPE_PREDICTOR_GPU 1
+#else
+#  define DRISHTI_SHAPE_PREDICTOR_GPU 0
+#endif
+// clang-format on
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+#if DRISHTI_SHAPE_PREDICTOR_GPU
+
+// Flattened (1D) model arrays are stored in rows of this width:
+static const int kFlatWidth = 2048;
+
+// Indices are stored as floats, which are exact below 2^24:
+static const std::size_t kMaxIndex = (std::size_t(1) << 24);
+
+// clang-format off
+#if defined(OGLES_GPGPU_OPENGLES)
+static const char* kVersion = "#version 300 es\nprecision highp float;\nprecision highp int;\nprecision highp sampler2D;\n";
+#else
+static const char* kVersion = "#version 330 core\n";
+#endif
+
+// Full screen triangle without vertex attributes:
+static const char* kVertexShader = OG_TO_STR(
+void main()
+{
+    vec2 p = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+});
+
+// Transform from the mean shape to the current shape of face n, as a row major 2x2 (see
+// find_tform_between_points()):
+static const char* kTransformShader = OG_TO_STR(
+uniform sampler2D shapes;
+uniform sampler2D initial;
+uniform int points;
+uniform int affine;
+out vec4 value;
+void main()
+{
+    int n = int(gl_FragCoord.y);
+    if (points < 2)
+    {
+        value = vec4(1.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    vec2 mf = vec2(0.0), mt = vec2(0.0);
+    for (int i = 0; i < points; i++)
+    {
+        mf += texelFetch(initial, ivec2(i, 0), 0).xy;
+        mt += texelFetch(shapes, ivec2(i, n), 0).xy;
+    }
+    mf /= float(points);
+    mt /= float(points);
+
+    float cxx = 0.0, cxy = 0.0, cyy = 0.0, dxx = 0.0, dxy = 0.0, dyx = 0.0, dyy = 0.0;
+    for (int i = 0; i < points; i++)
+    {
+        vec2 f = texelFetch(initial, ivec2(i, 0), 0).xy - mf;
+        vec2 t = texelFetch(shapes, ivec2(i, n), 0).xy - mt;
+        cxx += f.x * f.x;
+        cxy += f.x * f.y;
+        cyy += f.y * f.y;
+        dxx += t.x * f.x;
+        dxy += t.x * f.y;
+        dyx += t.y * f.x;
+        dyy += t.y * f.y;
+    }
+
+    value = vec4(1.0, 0.0, 0.0, 1.0);
+    if (affine != 0)
+    {
+        float det = cxx * cyy - cxy * cxy;
+        if (abs(det) > 1e-12)
+        {
+            value = vec4(dxx * cyy - dxy * cxy, dxy * cxx - dxx * cxy, dyx * cyy - dyy * cxy, dyy * cxx - dyx * cxy) / det;
+        }
+    }
+    else if ((cxx + cyy) > 0.0)
+    {
+        float a = (dxx + dyy) / (cxx + cyy), b = (dyx - dxy) / (cxx + cyy);
+        value = vec4(a, -b, b, a);
+    }
+});
+
+// Pose indexed feature f of face n, nearest neighbor lookup in the crop octave (0 outside):
+static const char* kFeatureShader = OG_TO_STR(
+uniform sampler2D shapes;
+uniform sampler2D tforms;
+uniform sampler2D features; // (anchor, dx, dy) x level
+uniform sampler2D faces;    // (H row 0, H row 1, bounds) x octave, per face
+uniform sampler2D atlas;
+uniform int level;
+uniform int octave;
+out vec4 value;
+void main()
+{
+    ivec2 ij = ivec2(gl_FragCoord.xy);
+    vec4 feature = texelFetch(features, ivec2(ij.x, level), 0);
+    vec2 s = texelFetch(shapes, ivec2(int(feature.x), ij.y), 0).xy;
+    vec4 T = texelFetch(tforms, ivec2(0, ij.y), 0);
+    vec2 p = s + vec2(dot(T.xy, feature.yz), dot(T.zw, feature.yz));
+
+    vec4 h0 = texelFetch(faces, ivec2(octave * 3 + 0, ij.y), 0);
+    vec4 h1 = texelFetch(faces, ivec2(octave * 3 + 1, ij.y), 0);
+    vec4 bounds = texelFetch(faces, ivec2(octave * 3 + 2, ij.y), 0);
+    vec2 q = floor(vec2(dot(h0.xy, p) + h0.z, dot(h1.xy, p) + h1.z) + 0.5);
+
+    float pixel = 0.0;
+    if (all(greaterThanEqual(q, vec2(0.0))) && all(lessThan(q, bounds.zw)))
+    {
+        pixel = floor(texelFetch(atlas, ivec2(q + bounds.xy), 0).r * 255.0 + 0.5);
+    }
+    value = vec4(pixel);
+});
+
+// Leaf row reached by tree t for face n (complete binary trees, see flat_forest::leaf()):
+static const char* kTreeShader = OG_TO_STR(
+uniform sampler2D trees;  // (split base, split count, leaf base) x level
+uniform sampler2D splits; // (idx1, idx2, thresh)
+uniform sampler2D values; // features x faces
+uniform int level;
+uniform int npd;
+uniform int width;
+out vec4 value;
+void main()
+{
+    ivec2 ij = ivec2(gl_FragCoord.xy);
+    vec4 tree = texelFetch(trees, ivec2(ij.x, level), 0);
+    int base = int(tree.x);
+    int count = int(tree.y);
+
+    int i = 0;
+    while (i < count)
+    {
+        int k = base + i;
+        vec4 split = texelFetch(splits, ivec2(k % width, k / width), 0);
+        float a = texelFetch(values, ivec2(int(split.x), ij.y), 0).r;
+        float b = texelFetch(values, ivec2(int(split.y), ij.y), 0).r;
+        float v = (npd != 0) ? ((a - b) / (a + b + 1e-6)) : (a - b);
+        i = (v > split.z) ? (2 * i + 1) : (2 * i + 2);
+    }
+    value = vec4(tree.z + float(i - count));
+});
+
+// Point j of face n plus the leaf updates of all trees at this level:
+static const char* kUpdateShader = OG_TO_STR(
+uniform sampler2D shapes;
+uniform sampler2D rows;   // trees x faces
+uniform sampler2D leaves; // (dx, dy) per leaf row and point
+uniform int trees;
+uniform int points;
+uniform int width;
+out vec4 value;
+void main()
+{
+    ivec2 ij = ivec2(gl_FragCoord.xy);
+    vec2 s = texelFetch(shapes, ij, 0).xy;
+    for (int t = 0; t < trees; t++)
+    {
+        int k = int(texelFetch(rows, ivec2(t, ij.y), 0).r) * points + ij.x;
+        s += texelFetch(leaves, ivec2(k % width, k / width), 0).xy;
+    }
+    value = vec4(s, 0.0, 1.0);
+});
+// clang-format on
+
+struct Texture
+{
+    Texture() = default;
+    ~Texture()
+    {
+        release();
+    }
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    void allocate(int w, int h, GLenum internal, GLenum format, GLenum type, const void* data, std::size_t pixelBytes)
+    {
+        if (!id)
+        {
+            glGenTextures(1, &id);
+        }
+        glBindTexture(GL_TEXTURE_2D, id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal, w, h, 0, format, type, data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        width = w;
+        height = h;
+        bytes = std::size_t(w) * std::size_t(h) * pixelBytes;
+    }
+
+    void release()
+    {
+        if (id)
+        {
+            glDeleteTextures(1, &id);
+            id = 0;
+        }
+        width = height = 0;
+        bytes = 0;
+    }
+
+    GLuint id = 0;
+    int width = 0;
+    int height = 0;
+    std::size_t bytes = 0;
+};
+
+// Float render target:
+struct Target
+{
+    Target() = default;
+    ~Target()
+    {
+        if (fbo)
+        {
+            glDeleteFramebuffers(1, &fbo);
+        }
+    }
+
+    Target(const Target&) = delete;
+    Target& operator=(const Target&) = delete;
+
+    bool allocate(int w, int h, GLenum internal, GLenum format, std::size_t pixelBytes)
+    {
+        texture.allocate(w, h, internal, format, GL_FLOAT, nullptr, pixelBytes);
+        if (!fbo)
+        {
+            glGenFramebuffers(1, &fbo);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id, 0);
+        return (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    }
+
+    Texture texture;
+    GLuint fbo = 0;
+};
+
+// Flattened (kFlatWidth wide) upload of 1D model arrays:
+static void upload(Texture& texture, std::vector<float>& data, int channels, GLenum internal, GLenum format)
+{
+    const std::size_t count = data.size() / channels;
+    const int rows = std::max(int((count + kFlatWidth - 1) / kFlatWidth), 1);
+    data.resize(std::size_t(rows) * kFlatWidth * channels, 0.f);
+    texture.allocate(kFlatWidth, rows, internal, format, GL_FLOAT, data.data(), sizeof(float) * channels);
+}
+
+struct ShapePredictorGPU::Impl
+{
+    Impl()
+    {
+        memoryUsage = core::MemoryRegistry::get().add(core::MemoryRegistry::kTexture, "ShapePredictorGPU", [this]() {
+            return bytes.load();
+        });
+    }
+
+    // Programs are built on first use (with the GL context current):
+    bool build()
+    {
+        if (!ready)
+        {
+            const std::string vsh = std::string(kVersion) + kVertexShader;
+            auto link = [&](ogles_gpgpu::Program& program, const char* fsh) {
+                try
+                {
+                    return program.buildFromSrc(vsh.c_str(), (std::string(kVersion) + fsh).c_str());
+                }
+                catch (const std::runtime_error&)
+                {
+                    return false; // e.g., an OpenGL ES 2 context, the caller falls back to the CPU
+                }
+            };
+            ready = link(transform, kTransformShader) && link(feature, kFeatureShader) && link(tree, kTreeShader) && link(update, kUpdateShader);
+            if (ready)
+            {
+                glGenVertexArrays(1, &vao);
+            }
+        }
+        return ready;
+    }
+
+    // Model textures are uploaded once per predictor:
+    bool load(const drishti::ml::shape_predictor& predictor)
+    {
+        if (model == &predictor)
+        {
+            return true;
+        }
+        model = nullptr;
+
+        using drishti::ml::impl::flat_forest;
+
+        levels = int(predictor.forests.size());
+        points = int(predictor.num_parts());
+        octaves = 1;
+        featureCounts.assign(levels, 0);
+        treeCounts.assign(levels, 0);
+        for (int l = 0; l < levels; l++)
+        {
+            featureCounts[l] = int(predictor.deltas[l].size());
+            treeCounts[l] = int(predictor.forests[l].size());
+            octaves = std::max(octaves, predictor.get_octave(l) + 1);
+        }
+        maxFeatures = *std::max_element(featureCounts.begin(), featureCounts.end());
+        maxTrees = *std::max_element(treeCounts.begin(), treeCounts.end());
+
+        std::vector<float> initial(points * 2);
+        std::copy(&predictor.initial_shape(0), &predictor.initial_shape(0) + initial.size(), initial.begin());
+
+        std::vector<float> features(std::size_t(maxFeatures) * levels * 4, 0.f);
+        std::vector<float> trees(std::size_t(maxTrees) * levels * 4, 0.f);
+        std::vector<float> splits, leaves;
+
+        std::size_t leafRows = 0;
+        for (int l = 0; l < levels; l++)
+        {
+            for (int f = 0; f < featureCounts[l]; f++)
+            {
+                float* feature = &features[(std::size_t(l) * maxFeatures + f) * 4];
+                feature[0] = float(predictor.anchor_idx[l][f]);
+                feature[1] = predictor.deltas[l][f].x();
+                feature[2] = predictor.deltas[l][f].y();
+            }
+
+            // Levels compiled at load time are reused (see shape_predictor::compile()):
+            flat_forest compiled;
+            const flat_forest* forest = predictor.isCompiled() ? &predictor.flat_forests[l] : nullptr;
+            if (!forest)
+            {
+                compiled.build(predictor.forests[l], predictor.isQuantized() ? predictor.leaf_scales[l] : 0.f);
+                forest = &compiled;
+            }
+
+            const std::size_t dim = std::size_t(forest->dim);
+            for (std::size_t t = 0; t < forest->size(); t++)
+            {
+                float* entry = &trees[(std::size_t(l) * maxTrees + t) * 4];
+                entry[0] = float(splits.size() / 4);
+                entry[1] = float(forest->split_offset[t + 1] - forest->split_offset[t]);
+                entry[2] = float(leafRows + forest->leaf_offset[t] / dim);
+            }
+
+            for (std::size_t i = 0; i < forest->split_idx1.size(); i++)
+            {
+                splits.insert(splits.end(), { float(forest->split_idx1[i]), float(forest->split_idx2[i]), forest->split_thresh[i], 0.f });
+            }
+
+            const std::size_t count = forest->leaf_offset.back();
+            for (std::size_t k = 0; k < count; k++)
+            {
+                leaves.push_back(forest->isQuantized() ? (float(forest->leaf_values_8[k]) * forest->leaf_scale) : forest->leaf_values[k]);
+            }
+            leafRows += count / dim;
+        }
+
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        const std::size_t flatRows = std::max(splits.size() / 4, leaves.size() / 2) / kFlatWidth + 1;
+        if ((std::max(maxFeatures, maxTrees) > maxSize) || (flatRows > std::size_t(maxSize)) || (leaves.size() / 2 >= kMaxIndex))
+        {
+            return false;
+        }
+
+        modelTextures.initial.allocate(points, 1, GL_RG32F, GL_RG, GL_FLOAT, initial.data(), sizeof(float) * 2);
+        modelTextures.features.allocate(maxFeatures, levels, GL_RGBA32F, GL_RGBA, GL_FLOAT, features.data(), sizeof(float) * 4);
+        modelTextures.trees.allocate(maxTrees, levels, GL_RGBA32F, GL_RGBA, GL_FLOAT, trees.data(), sizeof(float) * 4);
+        upload(modelTextures.splits, splits, 4, GL_RGBA32F, GL_RGBA);
+        upload(modelTextures.leaves, leaves, 2, GL_RG32F, GL_RG);
+
+        // Batch targets are sized for the new model on the next call:
+        capacity = 0;
+        model = &predictor;
+        return true;
+    }
+
+    // Work targets for n faces:
+    bool reserve(int n)
+    {
+        if (n <= capacity)
+        {
+            return true;
+        }
+
+        bool ok = true;
+        ok &= shapes[0].allocate(points, n, GL_RGBA32F, GL_RGBA, sizeof(float) * 4);
+        ok &= shapes[1].allocate(points, n, GL_RGBA32F, GL_RGBA, sizeof(float) * 4);
+        ok &= tforms.allocate(1, n, GL_RGBA32F, GL_RGBA, sizeof(float) * 4);
+        ok &= values.allocate(maxFeatures, n, GL_R32F, GL_RED, sizeof(float));
+        ok &= rows.allocate(maxTrees, n, GL_R32F, GL_RED, sizeof(float));
+        capacity = ok ? n : 0;
+        return ok;
+    }
+
+    // Crop octaves are stacked vertically in one 8 bit atlas, and each face gets the image
+    // transform (see scaling_tform()) and bounds of every octave:
+    bool pack(const std::vector<cv::Mat>& crops)
+    {
+        using namespace drishti::ml::impl;
+
+        struct Block
+        {
+            cv::Mat1b image;
+            int y;
+        };
+
+        std::vector<Block> blocks;
+        std::vector<float> faces(std::size_t(octaves) * 3 * 4 * crops.size(), 0.f);
+
+        int width = 1, height = 0;
+        for (std::size_t n = 0; n < crops.size(); n++)
+        {
+            const dlib::cv_image<unsigned char> image(crops[n]);
+            const dlib::rectangle rect(0, 0, crops[n].cols, crops[n].rows);
+
+            octave_pyramid pyramid;
+            for (int o = 0; o < octaves; o++)
+            {
+                const cv::Mat1b& level = pyramid.get(image, o);
+                const dlib::point_transform_affine H = scaling_tform(unnormalizing_tform(rect), octave_pyramid::scale(o));
+                const auto& m = H.get_m();
+                const auto& b = H.get_b();
+
+                float* face = &faces[((n * octaves) + o) * 3 * 4];
+                const float entries[12] = {
+                    float(m(0, 0)), float(m(0, 1)), float(b(0)), 0.f,
+                    float(m(1, 0)), float(m(1, 1)), float(b(1)), 0.f,
+                    0.f, float(height), float(level.cols), float(level.rows)
+                };
+                std::copy(entries, entries + 12, face);
+
+                blocks.push_back({ level.isContinuous() ? level : level.clone(), height });
+                width = std::max(width, level.cols);
+                height += level.rows;
+            }
+        }
+
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        if ((width > maxSize) || (height > maxSize))
+        {
+            return false;
+        }
+
+        if ((atlas.width != width) || (atlas.height < height))
+        {
+            atlas.allocate(width, height, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr, 1);
+        }
+        glBindTexture(GL_TEXTURE_2D, atlas.id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (const auto& block : blocks)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, block.y, block.image.cols, block.image.rows, GL_RED, GL_UNSIGNED_BYTE, block.image.ptr());
+        }
+
+        faceTexture.allocate(octaves * 3, int(crops.size()), GL_RGBA32F, GL_RGBA, GL_FLOAT, faces.data(), sizeof(float) * 4);
+        return true;
+    }
+
+    static void bind(int unit, const Texture& texture, const ogles_gpgpu::Program& program, const char* name)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        glUniform1i(program.getParam(ogles_gpgpu::UNIF, name), unit);
+    }
+
+    static void draw(const Target& target, int w, int h)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glViewport(0, 0, w, h);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    bool run(const drishti::ml::shape_predictor& predictor, const std::vector<cv::Mat>& crops, std::vector<std::vector<float>>& result, int stages)
+    {
+        const int n = int(crops.size());
+        if (!build() || !load(predictor) || !reserve(n) || !pack(crops))
+        {
+            return false;
+        }
+
+        std::vector<float> buffer(std::size_t(points) * n * 4, 0.f);
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < points; j++)
+            {
+                buffer[(std::size_t(i) * points + j) * 4 + 0] = result[i][j * 2 + 0];
+                buffer[(std::size_t(i) * points + j) * 4 + 1] = result[i][j * 2 + 1];
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, shapes[0].texture.id);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, points, n, GL_RGBA, GL_FLOAT, buffer.data());
+
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glBindVertexArray(vao);
+
+        const int flatWidth = kFlatWidth;
+        const int count = std::min(levels, std::max(stages, 0));
+        int current = 0;
+        for (int l = 0; l < count; l++)
+        {
+            transform.use();
+            bind(0, shapes[current].texture, transform, "shapes");
+            bind(1, modelTextures.initial, transform, "initial");
+            glUniform1i(transform.getParam(ogles_gpgpu::UNIF, "points"), points);
+            glUniform1i(transform.getParam(ogles_gpgpu::UNIF, "affine"), int(predictor.m_do_affine));
+            draw(tforms, 1, n);
+
+            feature.use();
+            bind(0, shapes[current].texture, feature, "shapes");
+            bind(1, tforms.texture, feature, "tforms");
+            bind(2, modelTextures.features, feature, "features");
+            bind(3, faceTexture, feature, "faces");
+            bind(4, atlas, feature, "atlas");
+            glUniform1i(feature.getParam(ogles_gpgpu::UNIF, "level"), l);
+            glUniform1i(feature.getParam(ogles_gpgpu::UNIF, "octave"), predictor.get_octave(l));
+            draw(values, featureCounts[l], n);
+
+            tree.use();
+            bind(0, modelTextures.trees, tree, "trees");
+            bind(1, modelTextures.splits, tree, "splits");
+            bind(2, values.texture, tree, "values");
+            glUniform1i(tree.getParam(ogles_gpgpu::UNIF, "level"), l);
+            glUniform1i(tree.getParam(ogles_gpgpu::UNIF, "npd"), int(predictor.m_npd));
+            glUniform1i(tree.getParam(ogles_gpgpu::UNIF, "width"), flatWidth);
+            draw(rows, treeCounts[l], n);
+
+            update.use();
+            bind(0, shapes[current].texture, update, "shapes");
+            bind(1, rows.texture, update, "rows");
+            bind(2, modelTextures.leaves, update, "leaves");
+            glUniform1i(update.getParam(ogles_gpgpu::UNIF, "trees"), treeCounts[l]);
+            glUniform1i(update.getParam(ogles_gpgpu::UNIF, "points"), points);
+            glUniform1i(update.getParam(ogles_gpgpu::UNIF, "width"), flatWidth);
+            draw(shapes[1 - current], points, n);
+            current = 1 - current;
+        }
+
+        // The only read back (points x faces):
+        glBindFramebuffer(GL_FRAMEBUFFER, shapes[current].fbo);
+        glReadPixels(0, 0, points, n, GL_RGBA, GL_FLOAT, buffer.data());
+        glBindVertexArray(0);
+
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < points; j++)
+            {
+                result[i][j * 2 + 0] = buffer[(std::size_t(i) * points + j) * 4 + 0];
+                result[i][j * 2 + 1] = buffer[(std::size_t(i) * points + j) * 4 + 1];
+            }
+        }
+
+        bytes = getTextureBytes();
+        return true;
+    }
+
+    std::size_t getTextureBytes() const
+    {
+        std::size_t total = atlas.bytes + faceTexture.bytes + tforms.texture.bytes + values.texture.bytes + rows.texture.bytes;
+        total += shapes[0].texture.bytes + shapes[1].texture.bytes;
+        total += modelTextures.initial.bytes + modelTextures.features.bytes + modelTextures.trees.bytes;
+        total += modelTextures.splits.bytes + modelTextures.leaves.bytes;
+        return total;
+    }
+
+    ~Impl()
+    {
+        if (vao)
+        {
+            glDeleteVertexArrays(1, &vao);
+        }
+    }
+
+    bool ready = false;
+    GLuint vao = 0;
+    ogles_gpgpu::Program transform, feature, tree, update;
+
+    // Model layout:
+    const drishti::ml::shape_predictor* model = nullptr;
+    int levels = 0;
+    int points = 0;
+    int octaves = 1;
+    int maxFeatures = 0;
+    int maxTrees = 0;
+    std::vector<int> featureCounts;
+    std::vector<int> treeCounts;
+
+    struct
+    {
+        Texture initial;  // mean shape (points x 1)
+        Texture features; // anchor and delta (features x levels)
+        Texture trees;    // split base, split count and leaf base (trees x levels)
+        Texture splits;   // idx1, idx2 and threshold (flattened)
+        Texture leaves;   // leaf updates per point (flattened)
+    } modelTextures;
+
+    // Batch:
+    int capacity = 0;
+    Texture atlas;
+    Texture faceTexture;
+    Target shapes[2];
+    Target tforms;
+    Target values;
+    Target rows;
+
+    std::atomic<std::size_t> bytes{ 0 };
+    core::MemoryRegistry::Registration memoryUsage;
+};
+
+ShapePredictorGPU::ShapePredictorGPU()
+    : m_impl(drishti::core::make_unique<Impl>())
+{
+}
+
+ShapePredictorGPU::~ShapePredictorGPU() = default;
+
+bool ShapePredictorGPU::isSupported()
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major); // GL_INVALID_ENUM in older contexts
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+#if defined(OGLES_GPGPU_OPENGLES)
+    if (major < 3)
+    {
+        return false;
+    }
+
+    // Float color attachments:
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const auto* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && (std::strcmp(name, "GL_EXT_color_buffer_float") == 0))
+        {
+            return true;
+        }
+    }
+    return false;
+#else
+    return (major > 3) || ((major == 3) && (minor >= 3));
+#endif
+}
+
+bool ShapePredictorGPU::isSupported(const drishti::ml::shape_predictor& predictor)
+{
+    if (predictor.m_pca || predictor.m_ellipse_count || !predictor.interpolated_features.empty() || predictor.forests.empty())
+    {
+        return false;
+    }
+
+    const std::size_t dim = predictor.initial_shape.size();
+    for (std::size_t l = 0; l < predictor.forests.size(); l++)
+    {
+        const auto& forest = predictor.forests[l];
+        if (forest.empty() || forest.front().leaf_values.empty() || (forest.front().leaf_values.front().size() != dim))
+        {
+            return false;
+        }
+        if ((l >= predictor.deltas.size()) || (l >= predictor.anchor_idx.size()) || predictor.deltas[l].empty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShapePredictorGPU::operator()(const drishti::ml::shape_predictor& predictor, const std::vector<cv::Mat>& crops, std::vector<std::vector<float>>& shapes, int stages)
+{
+    if (crops.empty() || !isSupported() || !isSupported(predictor))
+    {
+        return false;
+    }
+
+    // The pipeline's framebuffer and viewport are restored:
+    GLint fbo = 0, viewport[4] = { 0, 0, 0, 0 };
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    const bool ok = m_impl->run(predictor, crops, shapes, stages);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glActiveTexture(GL_TEXTURE0);
+    return ok;
+}
+
+std::size_t ShapePredictorGPU::getTextureBytes() const
+{
+    return m_impl->getTextureBytes();
+}
+
+#else // !DRISHTI_SHAPE_PREDICTOR_GPU
+
+// OpenGL ES 2 builds: every call falls back to the CPU regressor.
+
+struct ShapePredictorGPU::Impl
+{
+};
+
+ShapePredictorGPU::ShapePredictorGPU() = default;
+ShapePredictorGPU::~ShapePredictorGPU() = default;
+
+bool ShapePredictorGPU::isSupported()
+{
+    return false;
+}
+
+bool ShapePredictorGPU::isSupported(const drishti::ml::shape_predictor& predictor)
+{
+    return false;
+}
+
+bool ShapePredictorGPU::operator()(const drishti::ml::shape_predictor& predictor, const std::vector<cv::Mat>& crops, std::vector<std::vector<float>>& shapes, int stages)
+{
+    return false;
+}
+
+std::size_t ShapePredictorGPU::getTextureBytes() const
+{
+    return 0;
+}
+
+#endif // DRISHTI_SHAPE_PREDICTOR_GPU
+
+DRISHTI_FACE_NAMESPACE_END
@@ -0,0 +1,71 @@
+/*! -*-c++-*-
+  @file   face/gpu/ShapePredictorGPU.h
+  @author David Hirvonen
+  @brief  Declaration of a GPU backend for regression tree ensemble shape estimation.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Devices with weak CPUs spend most of the landmark time walking the regression forests.
+  This backend evaluates the cascade for all faces of a frame in fragment shader passes
+  (OpenGL ES 3 with EXT_color_buffer_float, or OpenGL 3.3): the flattened forests (see
+  shape_predictor::compile()), the pose indexed feature layout and the leaf updates are
+  uploaded once as float textures, and each cascade level runs four passes over a
+  (work item x face) target:
+
+  1) similarity transform from the mean shape to the current shape (1 x faces)
+  2) pose indexed features, gathered from an atlas of the crop octaves (features x faces)
+  3) tree traversal to a leaf row (trees x faces)
+  4) leaf accumulation into the next shape texture (points x faces)
+
+  Shapes stay on the GPU across levels (ping-pong float textures) and only the final
+  shapes are read back.  Results match the CPU path within float rounding (the CPU solves
+  the transform in double precision and sums int8 leaf codes before scaling).
+
+  Models with a PCA shape space, ellipses or line indexed features aren't supported and
+  the caller falls back to the CPU.  The GL context must be current for every call
+  (including destruction), so this is only used by the synchronous FaceFinder pipeline.
+
+*/
+
+#ifndef __drishti_face_gpu_ShapePredictorGPU_h__
+#define __drishti_face_gpu_ShapePredictorGPU_h__
+
+#include "drishti/face/drishti_face.h"
+#include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
+
+#include <opencv2/core.hpp>
+
+#include <memory>
+#include <vector>
+
+DRISHTI_FACE_NAMESPACE_BEGIN
+
+class ShapePredictorGPU : public drishti::ml::RTEShapeEstimator::Backend
+{
+public:
+    ShapePredictorGPU();
+    ~ShapePredictorGPU() override;
+
+    ShapePredictorGPU(const ShapePredictorGPU&) = delete;
+    ShapePredictorGPU& operator=(const ShapePredictorGPU&) = delete;
+
+    bool operator()(const drishti::ml::shape_predictor& predictor, const std::vector<cv::Mat>& crops, std::vector<std::vector<float>>& shapes, int stages) override;
+
+    // GLSL 3 and float render targets in the current context:
+    static bool isSupported();
+
+    // Anchor + delta features with a euclidean shape space:
+    static bool isSupported(const drishti::ml::shape_predictor& predictor);
+
+    // Model and work textures:
+    std::size_t getTextureBytes() const;
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_FACE_NAMESPACE_END
+
+#endif // __drishti_face_gpu_ShapePredictorGPU_h__
@@ -14,32 +14,48 @@ include(sugar_files)
 sugar_files(DRISHTI_FACE_SRCS
   Face.cpp
   FaceArchiveCereal.cpp  
+  FaceBulkIO.cpp
+  FaceCameraRig.cpp
   FaceDetector.cpp
   FaceDetectorAndTracker.cpp
   FaceDetectorAndTrackerImpl.cpp
+  FaceDetectorAndTrackerMotion.cpp
   FaceDetectorAndTrackerNN.cpp
   FaceDetectorFactory.cpp
   FaceDetectorFactoryCereal.cpp
+  FaceDetectorFactoryBundle.cpp
   FaceDetectorFactoryJson.cpp  
   FaceIO.cpp
   FaceMesh.cpp  
   FaceModelEstimator.cpp
+  FacePoseEstimator.cpp
+  FaceRecord.cpp
+  FaceService.cpp
+  FaceStream.cpp
   FaceTracker.cpp  
   face_util.cpp
   )
 
 sugar_files(DRISHTI_FACE_HDRS_PUBLIC
   Face.h
+  FaceBulkIO.h
+  FaceCameraRig.h
   FaceDetector.h
   FaceDetectorAndTracker.h
   FaceDetectorAndTrackerImpl.h
+  FaceDetectorAndTrackerMotion.h
   FaceDetectorAndTrackerNN.h
   FaceDetectorFactory.h
+  FaceDetectorFactoryBundle.h
   FaceDetectorFactoryJson.h  
   FaceIO.h
   FaceImpl.h  
   FaceMesh.h
   FaceModelEstimator.h
+  FacePoseEstimator.h
+  FaceRecord.h
+  FaceService.h
+  FaceStream.h
   FaceTracker.h
   drishti_face.h
   face_util.h
@@ -48,14 +64,24 @@ sugar_files(DRISHTI_FACE_HDRS_PUBLIC
 if(DRISHTI_BUILD_OGLES_GPGPU)
   sugar_Files(DRISHTI_FACE_HDRS_PUBLIC  
     gpu/EyeFilter.h
+    gpu/EyePatchFilter.h
     gpu/FaceStabilizer.h
+    gpu/FaceTileFilter.h
+    gpu/GpuTimer.h
     gpu/MultiTransformProc.h
+    gpu/PixelBufferRing.h
+    gpu/ShapePredictorGPU.h
     )
 
   sugar_files(DRISHTI_FACE_SRCS  
     gpu/EyeFilter.cpp
+    gpu/EyePatchFilter.cpp
     gpu/FaceStabilizer.cpp
+    gpu/FaceTileFilter.cpp
+    gpu/GpuTimer.cpp
     gpu/MultiTransformProc.cpp
+    gpu/PixelBufferRing.cpp
+    gpu/ShapePredictorGPU.cpp
     )
 endif()
 
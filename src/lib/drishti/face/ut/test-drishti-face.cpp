@@ -13,10 +13,23 @@
 */
 
 #include "drishti/face/FaceDetectorAndTracker.h"
+#include "drishti/face/FaceDetectorAndTrackerMotion.h"
+#include "drishti/face/FaceTracker.h"
+#include "drishti/face/FacePoseEstimator.h"
+#include "drishti/face/FaceRecord.h"
+#include "drishti/face/FaceBulkIO.h"
+#include "drishti/face/FaceCameraRig.h"
+#include "drishti/face/FaceIO.h"
+#include "drishti/face/FaceStream.h"
+#include "drishti/geometry/motion.h"
 #include "drishti/core/Logger.h"
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 // clang-format off
 #define BEGIN_EMPTY_NAMESPACE namespace {
 #define END_EMPTY_NAMESPACE }
@@ -110,6 +123,70 @@ TEST_F(FaceDetectorTest, FaceDetector) // NOLINT (TODO)
     ASSERT_EQ(faces.size(), 1);
 }
 
+TEST_F(FaceDetectorTest, swapModels) // NOLINT (TODO)
+{
+    // Same model files, new instances (a second factory doesn't share the decoded models):
+    drishti::face::FaceDetectorFactory replacement(sFaceDetector, sFaceRegressor, sEyeRegressor, sFaceDetectorMean);
+
+    tp::ThreadPool<> threads(2);
+    auto models = replacement.loadAsync(threads, false);
+    ASSERT_FALSE(models.detector.valid());
+    models.faceEstimator.wait();
+    models.eyeEstimators[0].wait();
+    models.eyeEstimators[1].wait();
+
+    m_detector->setFaceStagesHint(5);
+    ASSERT_TRUE(m_detector->swapModels(models));
+    EXPECT_TRUE(m_detector->isSwapPending());
+
+    auto pending = replacement.loadAsync(threads, false);
+    EXPECT_FALSE(m_detector->swapModels(pending)); // one swap at a time
+    pending.faceEstimator.wait();
+    pending.eyeEstimators[0].wait();
+    pending.eyeEstimators[1].wait();
+
+    // Installed by the next call, with the current stage hints:
+    std::vector<drishti::face::FaceModel> faces;
+    (*m_detector)(Ip, Ib, faces, cv::Matx33f::eye());
+    ASSERT_EQ(faces.size(), 1);
+    EXPECT_FALSE(m_detector->isSwapPending());
+    EXPECT_EQ(m_detector->getModelGeneration(), 1);
+    EXPECT_EQ(m_detector->getFaceStagesHint(), 5);
+}
+
+TEST_F(FaceDetectorTest, eyeBatch) // NOLINT (TODO)
+{
+    std::vector<drishti::face::FaceModel> detections;
+    (*m_detector)(Ip, Ib, detections, cv::Matx33f::eye());
+    ASSERT_EQ(detections.size(), 1);
+
+    // Many faces x both eyes are independent tasks on the shared pool, and must match a serial update:
+    const std::vector<drishti::face::FaceModel> faces(8, detections.front());
+
+    drishti::face::FaceDetector detector(*m_factory);
+    detector.setEyelidInits(1); // no jittered (random) hypotheses
+    detector.setThreadCount(1);
+    std::vector<drishti::face::FaceModel> expected = faces;
+    detector.refine(Ib, expected, cv::Matx33f::eye(), false);
+
+    detector.setThreadPool(std::make_shared<tp::ThreadPool<>>(4));
+    detector.setThreadCount(0);
+    std::vector<drishti::face::FaceModel> actual = faces;
+    detector.refine(Ib, actual, cv::Matx33f::eye(), false);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); i++)
+    {
+        ASSERT_EQ(actual[i].eyeFullR.has, expected[i].eyeFullR.has);
+        ASSERT_EQ(actual[i].eyeFullL.has, expected[i].eyeFullL.has);
+        if (expected[i].eyeFullR.has && expected[i].eyeFullL.has)
+        {
+            EXPECT_EQ(actual[i].eyeFullR->eyelids, expected[i].eyeFullR->eyelids);
+            EXPECT_EQ(actual[i].eyeFullL->eyelids, expected[i].eyeFullL->eyelids);
+        }
+    }
+}
+
 #if defined(DRISHTI_BUILD_EOS)
 TEST_F(FaceDetectorTest, FaceMeshMapper)
 {
@@ -121,4 +198,333 @@ TEST_F(FaceDetectorTest, FaceMeshMapper)
 }
 #endif
 
+TEST(FaceTracker, prediction) // NOLINT (TODO)
+{
+    drishti::face::FaceTracker tracker(0.15f, 0, 3, 0.5f);
+
+    auto face = [](int x) {
+        drishti::face::FaceModel f(cv::Rect(x, 100, 100, 100));
+        f.eyesCenter = cv::Point3f(0.f, 0.f, 0.5f);
+        return f;
+    };
+
+    // A 10 pixel step is smoothed to a 5 pixel/frame velocity:
+    drishti::face::FaceTracker::FaceTrackVec tracks;
+    tracker({ face(100) }, tracks);
+    tracker({ face(110) }, tracks);
+
+    // ... and then used to propagate the track when the detection is missed:
+    tracks.clear();
+    tracker({}, tracks);
+    ASSERT_EQ(tracks.size(), 1);
+    ASSERT_EQ(tracks[0].second.misses, 1);
+    ASSERT_EQ(tracks[0].first.roi->x, 115);
+}
+
+TEST(FaceRecord, conversion)
+{
+    drishti::face::FaceModel face(cv::Rect(100, 100, 100, 100));
+    face.eyesCenter = cv::Point3f(0.f, 0.f, 0.5f);
+    face.noseTip = cv::Point2f(150.f, 160.f);
+    face.points = std::vector<cv::Point2f>{ { 120.f, 130.f }, { 180.f, 130.f } };
+    face.eyeLeft = { { 170.f, 130.f }, { 190.f, 130.f } };
+    face.mouthOuter = { { 130.f, 180.f }, { 170.f, 180.f } };
+
+    drishti::eye::EyeModel eye;
+    eye.eyelids = { { 110.f, 130.f }, { 120.f, 125.f }, { 130.f, 130.f }, { 120.f, 135.f } };
+    eye.irisEllipse = cv::RotatedRect({ 120.f, 130.f }, { 8.f, 8.f }, 0.f);
+    eye.irisCenter = cv::Point2f(120.f, 130.f);
+    face.eyeFullR = eye;
+
+    // Round trip:
+    const drishti::face::FaceRecord record(face);
+    ASSERT_TRUE(record.isInline());
+    const auto copy = record.toFaceModel();
+    ASSERT_EQ(*copy.roi, *face.roi);
+    ASSERT_EQ(*copy.noseTip, *face.noseTip);
+    ASSERT_FALSE(copy.noseNostrilLeft.has);
+    ASSERT_EQ(*copy.points, *face.points);
+    ASSERT_EQ(copy.eyeLeft, face.eyeLeft);
+    ASSERT_EQ(copy.mouthOuter, face.mouthOuter);
+    ASSERT_TRUE(copy.eyeFullR.has);
+    ASSERT_FALSE(copy.eyeFullL.has);
+    ASSERT_EQ(copy.eyeFullR->eyelids, eye.eyelids);
+
+    // In place transformation matches the FaceModel operator:
+    const cv::Matx33f H = transformation::translate(5.f, -3.f);
+    auto moved = record;
+    moved.transform(H);
+    const auto expected = H * face, actual = moved.toFaceModel();
+    ASSERT_EQ(*actual.roi, *expected.roi);
+    ASSERT_EQ(*actual.noseTip, *expected.noseTip);
+    ASSERT_EQ(actual.eyeLeft, expected.eyeLeft);
+    ASSERT_EQ(actual.eyeFullR->eyelids, expected.eyeFullR->eyelids);
+    ASSERT_EQ(actual.eyeFullR->irisCenter.value, expected.eyeFullR->irisCenter.value);
+}
+
+TEST(FaceBulkIO, csv)
+{
+    const std::string filename = "test-drishti-face-bulk.csv", cache = filename + ".cache";
+    {
+        std::ofstream ofs(filename);
+        ofs << "name,x0,y0,x1,y1\n";
+        ofs << "a.png,10.5,20,30,-4e1\r\n";
+        ofs << "b.png, 1, 2 ,3,4\n";
+    }
+    std::remove(cache.c_str());
+
+    drishti::face::BulkSettings settings;
+    settings.cache = cache;
+    for (int pass = 0; pass < 2; pass++) // parse, then cache
+    {
+        drishti::face::FaceDataset dataset;
+        ASSERT_TRUE(drishti::face::loadFacesCsv(filename, dataset, settings));
+        ASSERT_EQ(dataset.names, (std::vector<std::string>{ "a.png", "b.png" }));
+        ASSERT_EQ(dataset.faces[0].front().points.value, (std::vector<cv::Point2f>{ { 10.5f, 20.f }, { 30.f, -40.f } }));
+        ASSERT_EQ(dataset.faces[1].front().points.value, (std::vector<cv::Point2f>{ { 1.f, 2.f }, { 3.f, 4.f } }));
+    }
+
+    std::remove(filename.c_str());
+    std::remove(cache.c_str());
+}
+
+TEST(FaceStream, roundtrip)
+{
+    // Small motion between frames, with a face entering the scene at frame 2:
+    std::vector<std::vector<drishti::face::FaceModel>> frames;
+    for (int i = 0; i < 8; i++)
+    {
+        std::vector<drishti::face::FaceModel> faces;
+        for (int j = 0; j < ((i < 2) ? 1 : 2); j++)
+        {
+            drishti::face::FaceModel face(cv::Rect(100 + i + j * 200, 100, 100, 100));
+            face.noseTip = cv::Point2f(150.25f + i * 0.5f, 160.f + j);
+            face.points = std::vector<cv::Point2f>{ { 120.f + i, 130.f }, { 180.f + i, 130.f } };
+            face.eyesCenter = cv::Point3f(0.01f, 0.02f, 0.5f - i * 0.001f);
+
+            drishti::eye::EyeModel eye;
+            eye.eyelids = { { 110.f + i, 130.f }, { 120.f, 125.f }, { 130.f, 130.f }, { 120.f, 135.f } };
+            eye.irisEllipse = cv::RotatedRect({ 120.f, 130.f + i * 0.1f }, { 8.f, 8.f }, 10.f);
+            face.eyeFullL = eye;
+            faces.push_back(face);
+        }
+        frames.push_back(faces);
+    }
+
+    std::stringstream ss;
+    std::vector<std::size_t> sizes;
+    std::size_t length = 0; // without the frame index
+    {
+        drishti::face::FaceStreamWriter writer(ss, 4);
+        for (std::size_t i = 0; i < frames.size(); i++)
+        {
+            const auto begin = ss.tellp();
+            ASSERT_TRUE(writer.write(frames[i], static_cast<std::int64_t>(i) * 33333));
+            sizes.push_back(static_cast<std::size_t>(ss.tellp() - begin));
+        }
+        length = static_cast<std::size_t>(ss.tellp());
+    }
+
+    // Delta frames are smaller than the keyframes with the same faces:
+    ASSERT_LT(sizes[3], sizes[4]);
+    ASSERT_LT(sizes[5], sizes[4]);
+
+    const std::string bytes = ss.str();
+    for (bool hasIndex : { true, false })
+    {
+        std::stringstream is(hasIndex ? bytes : bytes.substr(0, length));
+        drishti::face::FaceStreamReader reader(is);
+        ASSERT_TRUE(reader.good());
+        ASSERT_EQ(reader.size(), frames.size());
+
+        for (std::size_t i : { 6, 7, 1, 2, 3, 0, 5 }) // random and sequential access
+        {
+            std::vector<drishti::face::FaceModel> faces;
+            std::int64_t timestamp = 0;
+            ASSERT_TRUE(reader.read(i, faces, &timestamp));
+            ASSERT_EQ(timestamp, static_cast<std::int64_t>(i) * 33333);
+            ASSERT_EQ(faces.size(), frames[i].size());
+            for (std::size_t j = 0; j < faces.size(); j++)
+            {
+                const auto& a = faces[j];
+                const auto& b = frames[i][j];
+                ASSERT_EQ(*a.roi, *b.roi);
+                ASSERT_FALSE(a.noseNostrilLeft.has);
+                ASSERT_NEAR(a.noseTip->x, b.noseTip->x, 1.f / 128.f);
+                ASSERT_NEAR(a.points->back().x, b.points->back().x, 1.f / 128.f);
+                ASSERT_NEAR(a.eyesCenter->z, b.eyesCenter->z, 1e-4f);
+                ASSERT_TRUE(a.eyeFullL.has);
+                ASSERT_FALSE(a.eyeFullR.has);
+                ASSERT_EQ(a.eyeFullL->eyelids.size(), b.eyeFullL->eyelids.size());
+                ASSERT_NEAR(a.eyeFullL->eyelids[0].x, b.eyeFullL->eyelids[0].x, 1.f / 128.f);
+                ASSERT_NEAR(a.eyeFullL->irisEllipse.center.y, b.eyeFullL->irisEllipse.center.y, 1.f / 128.f);
+                ASSERT_NEAR(a.eyeFullL->irisEllipse.angle, b.eyeFullL->irisEllipse.angle, 1.f / 128.f);
+            }
+        }
+    }
+}
+
+TEST(TrackerMotion, update)
+{
+    const cv::Mat1b image(480, 640, uint8_t(0)); // only the size is used
+    drishti::face::TrackerMotion tracker;
+    tracker.initialize(image, drishti::face::FaceModel(cv::Rect(100, 100, 100, 100)));
+
+    // A translating flow grid moves the face:
+    drishti::geometry::MotionCorrespondences correspondences;
+    for (int y = 10; y < image.rows; y += 20)
+    {
+        for (int x = 10; x < image.cols; x += 20)
+        {
+            correspondences.push_back(cv::Point2f(x, y), cv::Point2f(x + 5, y + 3));
+        }
+    }
+
+    drishti::face::FaceModel face;
+    tracker.addMotion(correspondences);
+    ASSERT_TRUE(tracker.update(image, face));
+    ASSERT_EQ(face.roi->x, 105);
+    ASSERT_EQ(face.roi->y, 103);
+    ASSERT_FALSE(tracker.getFeatures().empty());
+
+    // The track is held for a few frames without motion, then dropped:
+    const int misses = drishti::face::TrackerMotion::Settings().maxMissedFrames;
+    for (int i = 0; i < misses; i++)
+    {
+        ASSERT_TRUE(tracker.update(image, face));
+    }
+    ASSERT_FALSE(tracker.update(image, face));
+}
+
+TEST(FacePoseEstimator, SyntheticPose) // NOLINT (TODO)
+{
+    using drishti::face::FacePoseEstimator;
+
+    // Project the template with a known pose:
+    FacePoseEstimator::Pose truth;
+    truth.R = FacePoseEstimator::fromEuler({ 10.f, -20.f, 5.f });
+    truth.scale = 80.f;
+    truth.translation = { 320.f, 240.f };
+
+    FacePoseEstimator::Points2d points;
+    for (int i = 0; i < FacePoseEstimator::kPoints; i++)
+    {
+        points[i] = truth.project(FacePoseEstimator::getTemplate()[i]);
+    }
+
+    FacePoseEstimator estimator;
+    const auto pose = estimator(points);
+    ASSERT_TRUE(pose.valid);
+    const cv::Point3f euler = pose.getEuler();
+    EXPECT_NEAR(euler.x, 10.f, 0.5f);
+    EXPECT_NEAR(euler.y, -20.f, 0.5f);
+    EXPECT_NEAR(euler.z, 5.f, 0.5f);
+    EXPECT_NEAR(pose.scale, truth.scale, 0.5f);
+
+    // Warm start from the previous pose (tracking):
+    const auto tracked = estimator(points, &pose);
+    ASSERT_TRUE(tracked.valid);
+    EXPECT_NEAR(tracked.getEuler().y, -20.f, 0.5f);
+}
+
 END_EMPTY_NAMESPACE
+
+TEST(FaceCameraRig, project)
+{
+    // Two cameras 10 cm apart along the rig x axis (left in the SensorModel coordinates):
+    const cv::Size size(640, 480);
+    const float f = 500.f;
+    const drishti::sensor::SensorModel::Intrinsic intrinsic({ 320.f, 240.f }, f, size);
+    std::vector<drishti::sensor::SensorModel> cameras{
+        { intrinsic, { cv::Matx33f::eye(), { 0.f, 0.f, 0.f } } },
+        { intrinsic, { cv::Matx33f::eye(), { 0.1f, 0.f, 0.f } } }
+    };
+
+    drishti::face::FaceCameraRig::Settings settings;
+    settings.detectionInterval = 4;
+    drishti::face::FaceCameraRig rig(cameras, settings);
+
+    const cv::Point3f center(0.f, 0.f, 0.5f);
+    const cv::Point3f P = rig.transform(center, 0, 1);
+    ASSERT_NEAR(P.x, 0.1f, 1e-6f);
+    const cv::Point3f Q = rig.transform(P, 1, 0);
+    ASSERT_NEAR(Q.x, center.x, 1e-6f);
+    ASSERT_NEAR(Q.z, center.z, 1e-6f);
+
+    drishti::face::FaceModel face;
+    face.roi = cv::Rect(270, 190, 100, 100);
+    face.noseTip = cv::Point2f(320.f, 240.f);
+    face.eyesCenter = center;
+
+    // A translation of t at depth z shifts the image by f * t / z (u decreases with x):
+    std::vector<drishti::face::FaceModel> seeds;
+    rig.project({ face }, 0, 1, seeds);
+    ASSERT_EQ(seeds.size(), 1);
+    ASSERT_NEAR(seeds[0].noseTip->x, 320.f - f * 0.1f / 0.5f, 1e-2f);
+    ASSERT_NEAR(seeds[0].noseTip->y, 240.f, 1e-2f);
+    ASSERT_NEAR(seeds[0].eyesCenter->x, 0.1f, 1e-6f);
+    ASSERT_EQ(seeds[0].roi->width, 100);
+
+    const cv::Point2f p = cameras[1].intrinsic().project(*seeds[0].eyesCenter);
+    ASSERT_NEAR(p.x, seeds[0].noseTip->x, 1e-2f);
+
+    // Faces without depth or mostly outside of the target image are skipped:
+    face.eyesCenter = {};
+    rig.project({ face }, 0, 1, seeds);
+    ASSERT_TRUE(seeds.empty());
+    face.eyesCenter = center;
+    face.roi = cv::Rect(0, 190, 100, 100);
+    rig.project({ face }, 0, 1, seeds);
+    ASSERT_TRUE(seeds.empty());
+
+    // Full detection without seeds and every detectionInterval frames otherwise:
+    ASSERT_TRUE(rig.isDetection(1, false));
+    ASSERT_FALSE(rig.isDetection(1, true));
+    ASSERT_FALSE(rig.isDetection(1, true));
+    ASSERT_FALSE(rig.isDetection(1, true));
+    ASSERT_TRUE(rig.isDetection(1, true));
+}
+
+TEST(FaceDetector, EyeResolution)
+{
+    using FaceDetector = drishti::face::FaceDetector;
+
+    FaceDetector::EyeResolution resolution;
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 64.f, 0.f), FaceDetector::kEyeFull);
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 24.f, 0.f), FaceDetector::kEyeEyelids);
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 8.f, 0.f), FaceDetector::kEyeSkip);
+
+    // Distance limits apply only when they are set:
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 64.f, 2.f), FaceDetector::kEyeFull);
+    resolution.maxFullDistance = 1.f;
+    resolution.maxEyelidDistance = 1.5f;
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 64.f, 0.5f), FaceDetector::kEyeFull);
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 64.f, 1.2f), FaceDetector::kEyeEyelids);
+    ASSERT_EQ(FaceDetector::getEyeMode(resolution, 64.f, 2.f), FaceDetector::kEyeSkip);
+}
+
+TEST(FaceIO, landmarkSubset)
+{
+    using drishti::face::FaceSpecification;
+
+    // A subset model regresses the lite points in this order:
+    const auto landmarks = FaceSpecification::getLiteLandmarks(FaceSpecification::kibug68);
+    ASSERT_EQ(landmarks.size(), 17);
+
+    drishti::core::Shape shape;
+    for (const auto& i : landmarks)
+    {
+        shape.contour.emplace_back(float(i), float(i % 7), 0);
+    }
+
+    const auto face = drishti::face::shapeToFace(shape, FaceSpecification::kibug68, landmarks);
+    ASSERT_EQ(face.eyeRight.size(), 6);
+    ASSERT_EQ(face.eyeLeft.size(), 6);
+    ASSERT_EQ(face.nose.size(), 5);
+    ASSERT_TRUE(face.mouthOuter.empty());
+    ASSERT_FALSE(face.mouthCornerLeft.has);
+    ASSERT_EQ(face.eyeRight.front().x, 36.f);
+    ASSERT_EQ(face.eyeLeft.back().x, 47.f);
+    ASSERT_EQ(*face.eyeRightInner, cv::Point2f(41.f, 41 % 7));
+    ASSERT_EQ(face.noseTip->x, 33.f);
+}
@@ -9,10 +9,13 @@
 */
 
 #include "drishti/geometry/Ellipse.h"
+#include "drishti/geometry/EllipseBatch.h"
 #include "drishti/core/drishti_core.h"
 #include "drishti/core/drishti_math.h"
 
 #include <opencv2/imgproc.hpp>
+
+#include <cmath>
 #include <iostream>
 
 DRISHTI_GEOMETRY_BEGIN
@@ -109,23 +112,17 @@ cv::RotatedRect phiToEllipse(const std::vector<float>& phi)
 // ===== from opencv/imgproc/drawing.cpp:
 
 /*
- constructs polygon that represents elliptic arc.
+ constructs polygon that represents elliptic arc (points are appended, delta in degrees).
  */
 void ellipse2Poly(const cv::RotatedRect& ellipse, float delta, std::vector<cv::Point2f>& points)
 {
-    delta *= M_PI / 180.0f;
-    float theta = ellipse.angle * M_PI / 180.0f;
-    const float b = ellipse.size.height / 2.f;
-    const float a = ellipse.size.width / 2.f;
-    const float cos_theta = std::cos(theta);
-    const float sin_theta = std::sin(theta);
-    for (float t = 0.0; t < 2.f * M_PI; t += delta)
-    {
-        const float cos_t = std::cos(t);
-        const float sin_t = std::sin(t);
-        cv::Point2f p(a * cos_t * cos_theta - b * sin_t * sin_theta, a * cos_t * sin_theta + b * sin_t * cos_theta);
-        points.push_back(ellipse.center + p);
-    }
+    const int count = (delta > 0.f) ? static_cast<int>(std::ceil(360.0 / delta - 1e-6)) : 0;
+
+    EllipseBatch batch;
+    batch.push_back(ellipse);
+    std::vector<cv::Point2f> contour;
+    ellipsesToPoly(batch, count, contour);
+    points.insert(points.end(), contour.begin(), contour.end());
 }
 
 DRISHTI_GEOMETRY_END
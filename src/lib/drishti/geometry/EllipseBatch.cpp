@@ -0,0 +1,274 @@
+/*! -*-c++-*-
+  @file   EllipseBatch.cpp
+  @author David Hirvonen
+  @brief  Implementation of batched (structure of arrays) ellipse geometry kernels.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/geometry/EllipseBatch.h"
+#include "drishti/core/cpu.h" // hasSimd()
+
+#include <algorithm>
+#include <cmath>
+
+// clang-format off
+#if DRISHTI_CPU_NEON
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+// clang-format on
+
+// clang-format off
+#if DRISHTI_CPU_X86
+#  include <immintrin.h>
+#  define DO_SSE4_1 1 // runtime dispatch (see core::hasSimd())
+#endif
+// clang-format on
+
+DRISHTI_GEOMETRY_BEGIN
+
+static const float kRadians = static_cast<float>(CV_PI / 180.0);
+
+EllipseBatch::EllipseBatch(const std::vector<cv::RotatedRect>& ellipses)
+{
+    resize(ellipses.size());
+    for (std::size_t i = 0; i < ellipses.size(); i++)
+    {
+        set(i, ellipses[i]);
+    }
+}
+
+void EllipseBatch::resize(std::size_t n)
+{
+    for (auto* v : { &cx, &cy, &width, &height, &angle })
+    {
+        v->resize(n);
+    }
+}
+
+void EllipseBatch::push_back(const cv::RotatedRect& e)
+{
+    resize(size() + 1);
+    set(size() - 1, e);
+}
+
+void EllipseBatch::set(std::size_t i, const cv::RotatedRect& e)
+{
+    cx[i] = e.center.x;
+    cy[i] = e.center.y;
+    width[i] = e.size.width;
+    height[i] = e.size.height;
+    angle[i] = e.angle;
+}
+
+cv::RotatedRect EllipseBatch::operator[](std::size_t i) const
+{
+    return { { cx[i], cy[i] }, { width[i], height[i] }, angle[i] };
+}
+
+// ################# PHI ######################
+
+void ellipsesToPhi(const EllipseBatch& ellipses, float* phi)
+{
+    const std::size_t n = ellipses.size();
+    for (std::size_t i = 0; i < n; i++, phi += 5)
+    {
+        const float scale = std::log2(ellipses.width[i]);
+        phi[0] = ellipses.cx[i];
+        phi[1] = ellipses.cy[i];
+        phi[2] = ellipses.angle[i] * kRadians;
+        phi[3] = scale;
+        phi[4] = std::log2(ellipses.height[i]) - scale;
+    }
+}
+
+void phiToEllipses(const float* phi, std::size_t n, EllipseBatch& ellipses)
+{
+    ellipses.resize(n);
+    for (std::size_t i = 0; i < n; i++, phi += 5)
+    {
+        const float width = std::exp2(phi[3]);
+        ellipses.cx[i] = phi[0];
+        ellipses.cy[i] = phi[1];
+        ellipses.angle[i] = phi[2] / kRadians;
+        ellipses.width[i] = width;
+        ellipses.height[i] = std::exp2(phi[4]) * width;
+    }
+}
+
+void pointsToEllipses(const std::vector<std::vector<cv::Point2f>>& points, EllipseBatch& ellipses)
+{
+    ellipses.resize(points.size());
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        const auto& p = points[i];
+        ellipses.cx[i] = p[0].x;
+        ellipses.cy[i] = p[1].x;
+        ellipses.width[i] = p[2].x;
+        ellipses.height[i] = p[3].x;
+        ellipses.angle[i] = p[4].x;
+    }
+}
+
+// ################# CONICS ######################
+
+void ellipsesToConics(const EllipseBatch& ellipses, std::array<std::vector<float>, 6>& conics)
+{
+    const std::size_t n = ellipses.size();
+    for (auto& c : conics)
+    {
+        c.resize(n);
+    }
+
+    float *pAo = conics[0].data(), *pAx = conics[1].data(), *pAy = conics[2].data();
+    float *pAxx = conics[3].data(), *pAyy = conics[4].data(), *pAxy = conics[5].data();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const float cx = ellipses.cx[i], cy = ellipses.cy[i];
+        const float rx = ellipses.width[i] * 0.5f, ry = ellipses.height[i] * 0.5f;
+        const float theta = -ellipses.angle[i] * kRadians; // cv::Rect rotation wrt Y
+
+        // CONIC_CEN2PAR (see conicCen2Par()):
+        const float Rx = ((rx > 0.f) - (rx < 0.f)) / (rx * rx);
+        const float Ry = ((ry > 0.f) - (ry < 0.f)) / (ry * ry);
+        const float cost = std::cos(theta), sint = std::sin(theta);
+        const float cost2 = cost * cost, sint2 = sint * sint, sin2t = 2.f * sint * cost;
+        const float u = cx * sint + cy * cost, v = cx * cost - cy * sint;
+
+        pAxx[i] = cost2 * Rx + sint2 * Ry;
+        pAxy[i] = sin2t * (Ry - Rx);
+        pAyy[i] = Rx * sint2 + Ry * cost2;
+        pAx[i] = sin2t * (Rx - Ry) * cy - 2.f * cx * (Ry * sint2 + Rx * cost2);
+        pAy[i] = sin2t * (Rx - Ry) * cx - 2.f * cy * (Ry * cost2 + Rx * sint2);
+        pAo[i] = Ry * u * u + Rx * v * v - 1.f;
+    }
+}
+
+// ################# TRANSFORM ######################
+
+void transformEllipses(const cv::Matx23f& H, const EllipseBatch& src, EllipseBatch& dst)
+{
+    const std::size_t n = src.size();
+    dst.resize(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const float theta = src.angle[i] * kRadians, c = std::cos(theta), s = std::sin(theta);
+        const float a = src.width[i] * 0.5f, b = src.height[i] * 0.5f;
+        const float cx = src.cx[i], cy = src.cy[i];
+
+        // Images of the (scaled) width and height axes, S = H * R * diag(a, b) = [ u v ]:
+        const float ux = (H(0, 0) * c + H(0, 1) * s) * a, uy = (H(1, 0) * c + H(1, 1) * s) * a;
+        const float vx = (H(0, 1) * c - H(0, 0) * s) * b, vy = (H(1, 1) * c - H(1, 0) * s) * b;
+
+        // Eigen decomposition of S * S' (closed form 2x2):
+        const float p = ux * ux + vx * vx, q = ux * uy + vx * vy, r = uy * uy + vy * vy;
+        const float m = (p + r) * 0.5f, d = std::sqrt((p - r) * (p - r) * 0.25f + q * q);
+        const float l1 = m + d, l2 = std::max(m - d, 0.f);
+        const float phi = 0.5f * std::atan2(2.f * q, p - r), e1x = std::cos(phi), e1y = std::sin(phi);
+
+        // The width axis is the principal axis closest to the image of the source width axis:
+        const float d1 = e1x * ux + e1y * uy, d2 = e1x * uy - e1y * ux;
+        const bool major = std::abs(d1) >= std::abs(d2);
+        const float sign = ((major ? d1 : d2) < 0.f) ? -1.f : 1.f;
+        const float dx = (major ? e1x : -e1y) * sign, dy = (major ? e1y : e1x) * sign;
+
+        dst.cx[i] = H(0, 0) * cx + H(0, 1) * cy + H(0, 2);
+        dst.cy[i] = H(1, 0) * cx + H(1, 1) * cy + H(1, 2);
+        dst.width[i] = 2.f * std::sqrt(major ? l1 : l2);
+        dst.height[i] = 2.f * std::sqrt(major ? l2 : l1);
+        dst.angle[i] = std::atan2(dy, dx) / kRadians;
+    }
+}
+
+// ################# POLY ######################
+
+// x[j] = cx + A * ct[j] + B * st[j], y[j] = cy + C * ct[j] + D * st[j] (interleaved)
+static void ellipseToPoly_c(const float* ct, const float* st, int count, const float* R, float* xy)
+{
+    for (int j = 0; j < count; j++, xy += 2)
+    {
+        xy[0] = R[0] + (R[2] * ct[j] + R[3] * st[j]);
+        xy[1] = R[1] + (R[4] * ct[j] + R[5] * st[j]);
+    }
+}
+
+#if DO_ARM_NEON
+static void ellipseToPoly_neon(const float* ct, const float* st, int count, const float* R, float* xy)
+{
+    const float32x4_t cx = vdupq_n_f32(R[0]), cy = vdupq_n_f32(R[1]);
+    int j = 0;
+    for (; j <= (count - 4); j += 4, xy += 8)
+    {
+        const float32x4_t c = vld1q_f32(ct + j), s = vld1q_f32(st + j);
+        float32x4x2_t p;
+        p.val[0] = vaddq_f32(cx, vaddq_f32(vmulq_n_f32(c, R[2]), vmulq_n_f32(s, R[3])));
+        p.val[1] = vaddq_f32(cy, vaddq_f32(vmulq_n_f32(c, R[4]), vmulq_n_f32(s, R[5])));
+        vst2q_f32(xy, p);
+    }
+    ellipseToPoly_c(ct + j, st + j, count - j, R, xy);
+}
+#endif
+
+#if DO_SSE4_1
+DRISHTI_TARGET("sse2")
+static void ellipseToPoly_sse(const float* ct, const float* st, int count, const float* R, float* xy)
+{
+    const __m128 cx = _mm_set1_ps(R[0]), cy = _mm_set1_ps(R[1]);
+    const __m128 A = _mm_set1_ps(R[2]), B = _mm_set1_ps(R[3]), C = _mm_set1_ps(R[4]), D = _mm_set1_ps(R[5]);
+    int j = 0;
+    for (; j <= (count - 4); j += 4, xy += 8)
+    {
+        const __m128 c = _mm_loadu_ps(ct + j), s = _mm_loadu_ps(st + j);
+        const __m128 x = _mm_add_ps(cx, _mm_add_ps(_mm_mul_ps(c, A), _mm_mul_ps(s, B)));
+        const __m128 y = _mm_add_ps(cy, _mm_add_ps(_mm_mul_ps(c, C), _mm_mul_ps(s, D)));
+        _mm_storeu_ps(xy + 0, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(xy + 4, _mm_unpackhi_ps(x, y));
+    }
+    ellipseToPoly_c(ct + j, st + j, count - j, R, xy);
+}
+#endif
+
+void ellipsesToPoly(const EllipseBatch& ellipses, int count, std::vector<cv::Point2f>& points)
+{
+    count = std::max(count, 0);
+    points.resize(ellipses.size() * count);
+    if (points.empty())
+    {
+        return;
+    }
+
+    // One trigonometric table for the whole batch:
+    std::vector<float> ct(count), st(count);
+    const double step = 2.0 * CV_PI / count;
+    for (int j = 0; j < count; j++)
+    {
+        ct[j] = static_cast<float>(std::cos(step * j));
+        st[j] = static_cast<float>(std::sin(step * j));
+    }
+
+    auto kernel = &ellipseToPoly_c;
+#if DO_ARM_NEON
+    if (core::hasSimd(core::kSimdNEON))
+    {
+        kernel = &ellipseToPoly_neon;
+    }
+#elif DO_SSE4_1
+    if (core::hasSimd(core::kSimdSSE2))
+    {
+        kernel = &ellipseToPoly_sse;
+    }
+#endif
+
+    for (std::size_t i = 0; i < ellipses.size(); i++)
+    {
+        const float theta = ellipses.angle[i] * kRadians, c = std::cos(theta), s = std::sin(theta);
+        const float a = ellipses.width[i] * 0.5f, b = ellipses.height[i] * 0.5f;
+        const float R[6] = { ellipses.cx[i], ellipses.cy[i], a * c, -b * s, a * s, b * c };
+        kernel(ct.data(), st.data(), count, R, &points[i * count].x);
+    }
+}
+
+DRISHTI_GEOMETRY_END
@@ -0,0 +1,68 @@
+/*! -*-c++-*-
+  @file   EllipseBatch.h
+  @author David Hirvonen
+  @brief  Declaration of batched (structure of arrays) ellipse geometry kernels.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The scalar ellipse utilities (ellipseToPhi(), conicCen2Par(), operator*(Matx33, RotatedRect),
+  ellipse2Poly(), ...) convert one ellipse at a time, typically through a temporary
+  std::vector<float>.  The kernels here operate on N ellipses stored as parallel arrays
+  (cv::RotatedRect conventions: full axis lengths, angle in degrees), write to caller owned
+  buffers, and share trigonometric tables across the batch.  Polygon sampling uses NEON/SSE
+  kernels when available (see core::setSimdEnabled()).
+
+*/
+
+#ifndef __drishti_geometry_EllipseBatch_h__
+#define __drishti_geometry_EllipseBatch_h__
+
+#include "drishti/geometry/drishti_geometry.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <array>
+#include <vector>
+
+DRISHTI_GEOMETRY_BEGIN
+
+struct EllipseBatch
+{
+    EllipseBatch() = default;
+    explicit EllipseBatch(const std::vector<cv::RotatedRect>& ellipses);
+
+    std::size_t size() const { return cx.size(); }
+    bool empty() const { return cx.empty(); }
+    void resize(std::size_t n);
+    void clear() { resize(0); }
+
+    void push_back(const cv::RotatedRect& e);
+    void set(std::size_t i, const cv::RotatedRect& e);
+    cv::RotatedRect operator[](std::size_t i) const;
+
+    std::vector<float> cx, cy, width, height, angle;
+};
+
+// phi = { cx, cy, angle (radians), log2(width), log2(height / width) } per ellipse, interleaved
+// n x 5 (see ellipseToPhi() and phiToEllipse()):
+void ellipsesToPhi(const EllipseBatch& ellipses, float* phi);
+void phiToEllipses(const float* phi, std::size_t n, EllipseBatch& ellipses);
+
+// CPR point vectors (5 values per ellipse stored in cv::Point2f::x, see pointsToEllipse()):
+void pointsToEllipses(const std::vector<std::vector<cv::Point2f>>& points, EllipseBatch& ellipses);
+
+// Conic coefficients { Ao, Ax, Ay, Axx, Ayy, Axy } (see conicCen2Par()), one array per coefficient:
+void ellipsesToConics(const EllipseBatch& ellipses, std::array<std::vector<float>, 6>& conics);
+
+// Affine transformation (closed form), the transformed width axis follows the image of the
+// source width axis (see operator*(Matx33, RotatedRect)), src and dst may be the same batch:
+void transformEllipses(const cv::Matx23f& H, const EllipseBatch& src, EllipseBatch& dst);
+
+// Sample count points per ellipse at uniform parameter steps starting at t = 0, the points
+// for ellipse i are stored in [i * count, (i + 1) * count) (see ellipse2Poly()):
+void ellipsesToPoly(const EllipseBatch& ellipses, int count, std::vector<cv::Point2f>& points);
+
+DRISHTI_GEOMETRY_END
+
+#endif // __drishti_geometry_EllipseBatch_h__
@@ -0,0 +1,274 @@
+/*! -*-c++-*-
+  @file   GlobalMotion.cpp
+  @author David Hirvonen
+  @brief  Implementation of a robust two frame similarity motion estimator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/geometry/GlobalMotion.h"
+#include "drishti/core/cpu.h" // hasSimd()
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+
+// clang-format off
+#if DRISHTI_CPU_NEON
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+// clang-format on
+
+// clang-format off
+#if DRISHTI_CPU_X86
+#  include <immintrin.h>
+#  define DO_SSE4_1 1 // runtime dispatch (see core::hasSimd())
+#endif
+// clang-format on
+
+DRISHTI_GEOMETRY_BEGIN
+
+// Similarity parameters m = { a, b, tx, ty }:  x1 = a * x0 - b * y0 + tx, y1 = b * x0 + a * y0 + ty
+using Similarity = std::array<float, 4>;
+
+void MotionCorrespondences::clear()
+{
+    for (auto* v : { &x0, &y0, &x1, &y1, &weights })
+    {
+        v->clear();
+    }
+}
+
+void MotionCorrespondences::reserve(std::size_t n)
+{
+    for (auto* v : { &x0, &y0, &x1, &y1, &weights })
+    {
+        v->reserve(n);
+    }
+}
+
+void MotionCorrespondences::push_back(const cv::Point2f& p0, const cv::Point2f& p1, float weight)
+{
+    x0.push_back(p0.x);
+    y0.push_back(p0.y);
+    x1.push_back(p1.x);
+    y1.push_back(p1.y);
+    weights.push_back(weight);
+}
+
+// ################# RESIDUALS ######################
+
+static void residuals_c(const float* x0, const float* y0, const float* x1, const float* y1, int n, const Similarity& m, float* r2)
+{
+    for (int i = 0; i < n; i++)
+    {
+        const float dx = m[0] * x0[i] - m[1] * y0[i] + m[2] - x1[i];
+        const float dy = m[1] * x0[i] + m[0] * y0[i] + m[3] - y1[i];
+        r2[i] = dx * dx + dy * dy;
+    }
+}
+
+#if DO_ARM_NEON
+static void residuals_neon(const float* x0, const float* y0, const float* x1, const float* y1, int n, const Similarity& m, float* r2)
+{
+    const float32x4_t tx = vdupq_n_f32(m[2]), ty = vdupq_n_f32(m[3]);
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        const float32x4_t x = vld1q_f32(x0 + i), y = vld1q_f32(y0 + i);
+        const float32x4_t dx = vsubq_f32(vaddq_f32(tx, vsubq_f32(vmulq_n_f32(x, m[0]), vmulq_n_f32(y, m[1]))), vld1q_f32(x1 + i));
+        const float32x4_t dy = vsubq_f32(vaddq_f32(ty, vaddq_f32(vmulq_n_f32(x, m[1]), vmulq_n_f32(y, m[0]))), vld1q_f32(y1 + i));
+        vst1q_f32(r2 + i, vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)));
+    }
+    residuals_c(x0 + i, y0 + i, x1 + i, y1 + i, n - i, m, r2 + i);
+}
+#endif
+
+#if DO_SSE4_1
+DRISHTI_TARGET("sse2")
+static void residuals_sse(const float* x0, const float* y0, const float* x1, const float* y1, int n, const Similarity& m, float* r2)
+{
+    const __m128 a = _mm_set1_ps(m[0]), b = _mm_set1_ps(m[1]), tx = _mm_set1_ps(m[2]), ty = _mm_set1_ps(m[3]);
+    int i = 0;
+    for (; i <= (n - 4); i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(x0 + i), y = _mm_loadu_ps(y0 + i);
+        const __m128 dx = _mm_sub_ps(_mm_add_ps(tx, _mm_sub_ps(_mm_mul_ps(x, a), _mm_mul_ps(y, b))), _mm_loadu_ps(x1 + i));
+        const __m128 dy = _mm_sub_ps(_mm_add_ps(ty, _mm_add_ps(_mm_mul_ps(x, b), _mm_mul_ps(y, a))), _mm_loadu_ps(y1 + i));
+        _mm_storeu_ps(r2 + i, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    }
+    residuals_c(x0 + i, y0 + i, x1 + i, y1 + i, n - i, m, r2 + i);
+}
+#endif
+
+static void residuals(const MotionCorrespondences& c, const Similarity& m, std::vector<float>& r2)
+{
+    auto kernel = &residuals_c;
+#if DO_ARM_NEON
+    if (core::hasSimd(core::kSimdNEON))
+    {
+        kernel = &residuals_neon;
+    }
+#elif DO_SSE4_1
+    if (core::hasSimd(core::kSimdSSE2))
+    {
+        kernel = &residuals_sse;
+    }
+#endif
+
+    r2.resize(c.size());
+    kernel(c.x0.data(), c.y0.data(), c.x1.data(), c.y1.data(), static_cast<int>(c.size()), m, r2.data());
+}
+
+// ################# SOLVER ######################
+
+// Closed form weighted least squares similarity (centered), false for degenerate sets:
+static bool fitSimilarity(const float* x0, const float* y0, const float* x1, const float* y1, const float* w, int n, Similarity& m)
+{
+    double W = 0.0, cx0 = 0.0, cy0 = 0.0, cx1 = 0.0, cy1 = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        W += w[i];
+        cx0 += w[i] * x0[i];
+        cy0 += w[i] * y0[i];
+        cx1 += w[i] * x1[i];
+        cy1 += w[i] * y1[i];
+    }
+    if (W <= 0.0)
+    {
+        return false;
+    }
+    cx0 /= W;
+    cy0 /= W;
+    cx1 /= W;
+    cy1 /= W;
+
+    double S = 0.0, A = 0.0, B = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        const double u0 = x0[i] - cx0, v0 = y0[i] - cy0, u1 = x1[i] - cx1, v1 = y1[i] - cy1;
+        S += w[i] * (u0 * u0 + v0 * v0);
+        A += w[i] * (u0 * u1 + v0 * v1);
+        B += w[i] * (u0 * v1 - v0 * u1);
+    }
+    if (S <= 1e-6 * W)
+    {
+        return false;
+    }
+
+    const double a = A / S, b = B / S;
+    m = { { float(a), float(b), float(cx1 - (a * cx0 - b * cy0)), float(cy1 - (b * cx0 + a * cy0)) } };
+    return true;
+}
+
+static bool fitSimilarity(const MotionCorrespondences& c, const std::vector<float>& w, Similarity& m)
+{
+    return fitSimilarity(c.x0.data(), c.y0.data(), c.x1.data(), c.y1.data(), w.data(), static_cast<int>(c.size()), m);
+}
+
+SimilarityMotionEstimator::SimilarityMotionEstimator(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+SimilarityMotion SimilarityMotionEstimator::operator()(const MotionCorrespondences& c) const
+{
+    SimilarityMotion motion;
+
+    const int n = static_cast<int>(c.size());
+    const float t2 = m_settings.threshold * m_settings.threshold;
+
+    std::vector<int> candidates;
+    candidates.reserve(n);
+    float total = 0.f;
+    for (int i = 0; i < n; i++)
+    {
+        if (c.weights[i] > 0.f)
+        {
+            candidates.push_back(i);
+            total += c.weights[i];
+        }
+    }
+    if (static_cast<int>(candidates.size()) < std::max(m_settings.minInliers, 2))
+    {
+        return motion;
+    }
+
+    // RANSAC (MSAC score) over two point samples:
+    std::minstd_rand rng(m_settings.seed);
+    std::uniform_int_distribution<int> uniform(0, static_cast<int>(candidates.size()) - 1);
+    std::vector<float> r2;
+    Similarity best{ { 1.f, 0.f, 0.f, 0.f } };
+    double bestScore = std::numeric_limits<double>::max();
+    for (int k = 0; k < m_settings.iterations; k++)
+    {
+        const int i = candidates[uniform(rng)], j = candidates[uniform(rng)];
+        const float x0[2] = { c.x0[i], c.x0[j] }, y0[2] = { c.y0[i], c.y0[j] };
+        const float x1[2] = { c.x1[i], c.x1[j] }, y1[2] = { c.y1[i], c.y1[j] };
+        const float w[2] = { 1.f, 1.f };
+
+        Similarity m;
+        if ((i == j) || !fitSimilarity(x0, y0, x1, y1, w, 2, m))
+        {
+            continue;
+        }
+
+        residuals(c, m, r2);
+        double score = 0.0;
+        for (int q : candidates)
+        {
+            score += c.weights[q] * std::min(r2[q], t2);
+        }
+        if (score < bestScore)
+        {
+            bestScore = score;
+            best = m;
+        }
+    }
+
+    // IRLS (Huber weights, zero beyond 3x threshold) from the RANSAC consensus:
+    std::vector<float> weights(n);
+    residuals(c, best, r2);
+    for (int k = 0; k < m_settings.refinements; k++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const float r = std::sqrt(r2[i]);
+            const float huber = (r <= m_settings.threshold) ? 1.f : ((r <= 3.f * m_settings.threshold) ? (m_settings.threshold / r) : 0.f);
+            weights[i] = c.weights[i] * huber;
+        }
+
+        Similarity m;
+        if (!fitSimilarity(c, weights, m))
+        {
+            break;
+        }
+        best = m;
+        residuals(c, best, r2);
+    }
+
+    float inlierWeight = 0.f;
+    double error = 0.0;
+    for (int i : candidates)
+    {
+        if (r2[i] <= t2)
+        {
+            motion.inliers++;
+            inlierWeight += c.weights[i];
+            error += r2[i];
+        }
+    }
+
+    motion.H = cv::Matx33f(best[0], -best[1], best[2], best[1], best[0], best[3], 0.f, 0.f, 1.f);
+    motion.rmse = motion.inliers ? static_cast<float>(std::sqrt(error / motion.inliers)) : 0.f;
+    motion.valid = (motion.inliers >= m_settings.minInliers) && (inlierWeight >= (m_settings.minInlierRatio * total));
+
+    return motion;
+}
+
+DRISHTI_GEOMETRY_END
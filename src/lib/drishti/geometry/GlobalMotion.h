@@ -0,0 +1,77 @@
+/*! -*-c++-*-
+  @file   GlobalMotion.h
+  @author David Hirvonen
+  @brief  Declaration of a robust two frame similarity motion estimator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Global (camera) motion from sparse weighted correspondences, e.g., a readback of GPU
+  optical flow sampled on a fixed grid.  Outliers from independently moving objects (faces)
+  are rejected with RANSAC over two point minimal samples (MSAC scoring), and the consensus
+  is refined with a few IRLS iterations (Huber weights).  Each step is a closed form weighted
+  similarity, and residuals are evaluated over the whole set with NEON/SSE kernels when
+  available (see core::setSimdEnabled()).  See estimateGlobMotionLeastSquaresSimilarity()
+  for the (non robust) least squares solution.
+
+*/
+
+#ifndef __drishti_geometry_GlobalMotion_h__
+#define __drishti_geometry_GlobalMotion_h__
+
+#include "drishti/geometry/drishti_geometry.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+DRISHTI_GEOMETRY_BEGIN
+
+// Correspondences as parallel arrays: point i moves from (x0, y0) to (x1, y1)
+struct MotionCorrespondences
+{
+    std::size_t size() const { return x0.size(); }
+    bool empty() const { return x0.empty(); }
+    void clear();
+    void reserve(std::size_t n);
+    void push_back(const cv::Point2f& p0, const cv::Point2f& p1, float weight = 1.f);
+
+    std::vector<float> x0, y0, x1, y1, weights;
+};
+
+struct SimilarityMotion
+{
+    cv::Matx33f H = cv::Matx33f::eye(); // points0 -> points1
+    int inliers = 0;
+    float rmse = 0.f; // inlier rms residual (pixels)
+    bool valid = false;
+};
+
+class SimilarityMotionEstimator
+{
+public:
+    struct Settings
+    {
+        int iterations = 64;         // RANSAC samples
+        float threshold = 2.f;       // inlier residual (pixels)
+        int refinements = 3;         // IRLS iterations
+        int minInliers = 8;          // for a valid motion
+        float minInlierRatio = 0.3f; // of the (weighted) correspondences
+        std::uint32_t seed = 1;      // deterministic sampling
+    };
+
+    SimilarityMotionEstimator() = default;
+    explicit SimilarityMotionEstimator(const Settings& settings);
+
+    SimilarityMotion operator()(const MotionCorrespondences& correspondences) const;
+
+    const Settings& getSettings() const { return m_settings; }
+
+protected:
+    Settings m_settings;
+};
+
+DRISHTI_GEOMETRY_END
+
+#endif // __drishti_geometry_GlobalMotion_h__
@@ -14,7 +14,9 @@ include(sugar_files)
 sugar_files(DRISHTI_GEOMETRY_SRCS
   DynamicObject.cpp
   Ellipse.cpp
+  EllipseBatch.cpp
   EllipseSerializer.cpp
+  GlobalMotion.cpp
   Primitives.cpp
   Rectangle.cpp
   conicCen2Par.cpp
@@ -27,7 +29,9 @@ sugar_files(DRISHTI_GEOMETRY_HDRS_PUBLIC
   Cylinder.h
   DynamicObject.h  
   Ellipse.h
+  EllipseBatch.h
   EllipseSerializer.h
+  GlobalMotion.h
   Mesh3D.h
   Primitives.h
   Rectangle.h
@@ -11,6 +11,8 @@
 #include <gtest/gtest.h>
 
 #include "drishti/geometry/Ellipse.h"
+#include "drishti/geometry/EllipseBatch.h"
+#include "drishti/geometry/GlobalMotion.h"
 #include "drishti/geometry/intersectConicLine.h"
 
 TEST(Ellipse, EllipseLineIntersection2) // NOLINT (TODO)
@@ -35,3 +37,96 @@ TEST(Ellipse, EllipseLineIntersection2) // NOLINT (TODO)
 
     // assertions on order, etc
 }
+
+TEST(EllipseBatch, MatchesScalar) // NOLINT (TODO)
+{
+    const std::vector<cv::RotatedRect> ellipses{
+        { { 50.f, 40.f }, { 30.f, 12.f }, 30.f },
+        { { 10.f, 20.f }, { 8.f, 16.f }, 135.f },
+        { { -5.f, 7.f }, { 20.f, 20.f }, 0.f }
+    };
+    drishti::geometry::EllipseBatch batch(ellipses);
+
+    std::vector<float> phis(batch.size() * 5);
+    drishti::geometry::ellipsesToPhi(batch, phis.data());
+
+    std::array<std::vector<float>, 6> conics;
+    drishti::geometry::ellipsesToConics(batch, conics);
+
+    std::vector<cv::Point2f> points;
+    drishti::geometry::ellipsesToPoly(batch, 36, points);
+    ASSERT_EQ(points.size(), ellipses.size() * 36);
+
+    for (int i = 0; i < ellipses.size(); i++)
+    {
+        const auto phi = drishti::geometry::ellipseToPhi(ellipses[i]);
+        const auto par = drishti::geometry::conicCen2Par(ellipses[i]);
+        for (int j = 0; j < 5; j++)
+        {
+            EXPECT_NEAR(phis[i * 5 + j], phi[j], 1e-4f);
+        }
+        for (int j = 0; j < 6; j++)
+        {
+            EXPECT_NEAR(conics[j][i], par[j], 1e-3 * std::max(std::abs(par[j]), 1.0));
+        }
+
+        std::vector<cv::Point2f> contour;
+        drishti::geometry::ellipse2Poly(ellipses[i], 10.f, contour);
+        ASSERT_EQ(contour.size(), 36);
+        for (int j = 0; j < 36; j++)
+        {
+            EXPECT_NEAR(cv::norm(contour[j] - points[i * 36 + j]), 0.0, 1e-3);
+        }
+    }
+}
+
+TEST(EllipseBatch, AffineTransform) // NOLINT (TODO)
+{
+    const cv::RotatedRect e({ 50.f, 40.f }, { 30.f, 12.f }, 30.f);
+    const cv::Matx23f H(1.3f, 0.4f, 10.f, -0.2f, 0.8f, -5.f);
+
+    drishti::geometry::EllipseBatch batch(std::vector<cv::RotatedRect>{ e });
+    drishti::geometry::transformEllipses(H, batch, batch);
+    const cv::RotatedRect e2 = batch[0];
+
+    // Every transformed contour point lies on the transformed ellipse:
+    std::vector<cv::Point2f> contour;
+    drishti::geometry::ellipse2Poly(e, 10.f, contour);
+    const float theta = e2.angle * static_cast<float>(CV_PI / 180.0);
+    for (const auto& p : contour)
+    {
+        const cv::Vec2f h = H * cv::Vec3f(p.x, p.y, 1.f);
+        const cv::Point2f q = cv::Point2f(h[0], h[1]) - e2.center;
+        const float u = q.x * std::cos(theta) + q.y * std::sin(theta), v = -q.x * std::sin(theta) + q.y * std::cos(theta);
+        EXPECT_NEAR((u * u) / (e2.size.width * e2.size.width * 0.25f) + (v * v) / (e2.size.height * e2.size.height * 0.25f), 1.f, 1e-3f);
+    }
+}
+
+TEST(SimilarityMotionEstimator, RobustToOutliers) // NOLINT (TODO)
+{
+    // Camera motion with a third of the correspondences on an independently moving object:
+    const float scale = 1.02f, theta = 0.03f, a = scale * std::cos(theta), b = scale * std::sin(theta);
+    const cv::Point2f t(5.f, -3.f);
+
+    cv::RNG rng(1);
+    drishti::geometry::MotionCorrespondences correspondences;
+    for (int i = 0; i < 200; i++)
+    {
+        const cv::Point2f p(rng.uniform(0.f, 640.f), rng.uniform(0.f, 480.f));
+        cv::Point2f q(a * p.x - b * p.y + t.x, b * p.x + a * p.y + t.y);
+        q += cv::Point2f(rng.gaussian(0.25), rng.gaussian(0.25));
+        if ((i % 3) == 0)
+        {
+            q += cv::Point2f(20.f, -15.f);
+        }
+        correspondences.push_back(p, q);
+    }
+
+    const auto motion = drishti::geometry::SimilarityMotionEstimator()(correspondences);
+    ASSERT_TRUE(motion.valid);
+    EXPECT_GE(motion.inliers, 120);
+    EXPECT_NEAR(motion.H(0, 0), a, 1e-3);
+    EXPECT_NEAR(motion.H(1, 0), b, 1e-3);
+    EXPECT_NEAR(motion.H(0, 2), t.x, 0.25);
+    EXPECT_NEAR(motion.H(1, 2), t.y, 0.25);
+}
@@ -17,7 +17,10 @@ BEGIN_OGLES_GPGPU
 
 struct GLTexture
 {
-    GLTexture(std::size_t width, std::size_t height, GLenum texType, void* data)
+    GLTexture(std::size_t width, std::size_t height, GLenum texType, void* data, GLenum internalFormat = GL_RGBA)
+        : width(width)
+        , height(height)
+        , texType(texType)
     {
         glGenTextures(1, &texId);
         glBindTexture(GL_TEXTURE_2D, texId);
@@ -26,7 +29,16 @@ struct GLTexture
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, texType, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, texType, GL_UNSIGNED_BYTE, data);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Replace the texture contents (same size and format) without reallocating:
+    void update(const void* data)
+    {
+        glBindTexture(GL_TEXTURE_2D, texId);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, texType, GL_UNSIGNED_BYTE, data);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
@@ -46,6 +58,9 @@ struct GLTexture
     }
 
     GLuint texId{};
+    std::size_t width = 0;
+    std::size_t height = 0;
+    GLenum texType = GL_RGBA;
 };
 
 END_OGLES_GPGPU
@@ -44,7 +44,7 @@ LineShader::LineShader(VertexBuffer  vertices)
     , MVP(glm::mat4())
 {
     // Compile utility line shader:
-    shader = std::make_shared<Shader>();
+    shader = std::make_shared<Program>();
     if (!shader->buildFromSrc(vshaderColorSrc, fshaderColorSrc))
     {
         throw std::runtime_error("LineShader: shader error");
@@ -12,6 +12,7 @@
 #define __drishti_graphics_LineShader_h__
 
 #include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+#include "drishti/graphics/ProgramCache.h"
 #include <glm/glm.hpp>
 
 #include <array>
@@ -38,7 +39,7 @@ public:
     void setModelViewProjection(const glm::mat4& mvp);
 
 protected:
-    std::shared_ptr<Shader> shader;
+    std::shared_ptr<Program> shader;
 
     static const char* vshaderColorSrc;
     static const char* fshaderColorSrc;
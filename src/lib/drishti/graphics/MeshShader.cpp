@@ -10,6 +10,7 @@
 
 #include "drishti/graphics/MeshShader.h"
 
+#include <limits>
 #include <utility>
 
 // clang-format off
@@ -37,6 +38,21 @@ const char * MeshShader::vshaderMeshSrc = OG_TO_STR
  );
 // clang-format on
 
+// clang-format off
+const char * MeshShader::vshaderIsomapSrc = OG_TO_STR
+(
+ attribute vec4 aPos;
+ attribute vec2 aTexCoord;
+ varying vec2 vTexCoord;
+ uniform mat4 transformMatrix;
+ void main()
+ {
+    gl_Position = vec4(aTexCoord * 2.0 - 1.0, 0.0, 1.0);
+    vTexCoord = (transformMatrix * vec4(aPos.xyz, 1.0)).xy;
+ }
+ );
+// clang-format on
+
 // clang-format off
 const char * MeshShader::fshaderMeshSrc =
 #if defined(OGLES_GPGPU_OPENGLES)
@@ -53,17 +69,68 @@ const char * MeshShader::fshaderMeshSrc =
 // clang-format on
 
 MeshShader::MeshShader(const cv::Mat& iso, VertexBuffer  vertices, CoordBuffer  coords)
-    : texture(iso.cols, iso.rows, TEXTURE_FORMAT, const_cast<void*>(iso.ptr<void>()))
+    : texture(new GLTexture(iso.cols, iso.rows, TEXTURE_FORMAT, const_cast<void*>(iso.ptr<void>())))
     , texUnit(1)
     , texTarget(GL_TEXTURE_2D)
     , vertices(std::move(vertices))
     , coords(std::move(coords))
+{
+    build(vshaderMeshSrc);
+}
+
+MeshShader::MeshShader(const drishti::graphics::MeshTex& mesh, Mode mode)
+    : texUnit(1)
+    , texTarget(GL_TEXTURE_2D)
+    , vertexCount(mesh.vertices.size())
+    , indexCount(mesh.tvi.size() * 3)
+{
+    if (vertexCount > std::numeric_limits<GLushort>::max())
+    {
+        throw std::runtime_error("MeshShader: too many vertices for 16 bit indices");
+    }
+
+    build((mode == kIsomap) ? vshaderIsomapSrc : vshaderMeshSrc);
+
+    std::vector<GLushort> indices;
+    indices.reserve(indexCount);
+    for (const auto& t : mesh.tvi)
+    {
+        indices.insert(indices.end(), { GLushort(t[0]), GLushort(t[1]), GLushort(t[2]) });
+    }
+
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &coordBuffer);
+    glGenBuffers(1, &indexBuffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec4), mesh.vertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec2), mesh.texcoords.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+MeshShader::~MeshShader()
+{
+    for (auto* buffer : { &vertexBuffer, &coordBuffer, &indexBuffer })
+    {
+        if (*buffer)
+        {
+            glDeleteBuffers(1, buffer);
+        }
+    }
+}
+
+void MeshShader::build(const char* vshader)
 {
     MVP = glm::mat4();
 
     // Compile utility shader:
-    shader = std::make_shared<Shader>();
-    if (!shader->buildFromSrc(vshaderMeshSrc, fshaderMeshSrc))
+    shader = std::make_shared<Program>();
+    if (!shader->buildFromSrc(vshader, fshaderMeshSrc))
     {
         throw std::runtime_error("MeshShader: shader error");
     }
@@ -84,6 +151,49 @@ void MeshShader::setModelViewProjection(const glm::mat4& mvp)
     MVP = mvp;
 }
 
+void MeshShader::setVertices(const VertexBuffer& vertices)
+{
+    assert(vertices.size() == vertexCount);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(glm::vec4), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshShader::setCoords(const CoordBuffer& coords)
+{
+    assert(coords.size() == vertexCount);
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(glm::vec2), coords.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshShader::draw(GLuint texId, int outFrameW, int outFrameH)
+{
+    assert(indexBuffer);
+
+    shader->use();
+
+    glActiveTexture(GL_TEXTURE0 + texUnit);
+    glBindTexture(texTarget, texId);
+    glUniform1i(shParamUInputTex, texUnit);
+    glUniformMatrix4fv(shParamUMVP, 1, 0, (GLfloat*)&MVP[0][0]);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(shParamAPos);
+    glVertexAttribPointer(shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+    glEnableVertexAttribArray(shParamATexCoord);
+    glVertexAttribPointer(shParamATexCoord, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_SHORT, nullptr);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableVertexAttribArray(shParamAPos);
+    glDisableVertexAttribArray(shParamATexCoord);
+}
+
 void MeshShader::draw(int outFrameW, int outFrameH)
 {
     shader->use();
@@ -94,7 +204,7 @@ void MeshShader::draw(int outFrameW, int outFrameH)
 
     // set input texture
     glActiveTexture(GL_TEXTURE0 + texUnit);
-    glBindTexture(texTarget, texture.texId); // bind input texture
+    glBindTexture(texTarget, texture->texId); // bind input texture
     glUniform1i(shParamUInputTex, texUnit);
     glUniformMatrix4fv(shParamUMVP, 1, 0, (GLfloat*)&MVP[0][0]);
     glEnableVertexAttribArray(shParamAPos);
@@ -6,12 +6,20 @@
   \copyright Copyright 2017 Elucideye, Inc. All rights reserved.
   \license{This project is released under the 3 Clause BSD License.}
 
+  The indexed constructor keeps the mesh in GPU buffers (vertices and texture coordinates
+  are updated in place, the triangle indices are uploaded once), and draws either the
+  textured mesh (kRender) or its isomap (kIsomap): each triangle is rasterized at its
+  texture coordinates and samples the input image where the transform (e.g., the affine
+  camera, see IsomapExtractor) projects its vertices.
+
 */
 
 #ifndef __drishti_graphics_MeshShader_h__
 #define __drishti_graphics_MeshShader_h__
 
 #include "drishti/graphics/GLTexture.h"
+#include "drishti/graphics/meshtex.h"
+#include "drishti/graphics/ProgramCache.h"
 
 #include <ogles_gpgpu/common/proc/base/filterprocbase.h>
 #include <opencv2/core.hpp>
@@ -27,21 +35,45 @@ public:
     using VertexBuffer = std::vector<glm::vec4>;
     using CoordBuffer = std::vector<glm::vec2>;
 
+    enum Mode
+    {
+        kRender, // gl_Position = MVP * vertex, sample the texture at the texture coordinates
+        kIsomap  // gl_Position = texture coordinates, sample the texture at (MVP * vertex).xy
+    };
+
     MeshShader(const cv::Mat& iso, VertexBuffer  vertices, CoordBuffer  coords);
 
+    // Indexed mesh in GPU buffers (fewer than 65536 vertices), textured in draw(texId, ...):
+    MeshShader(const drishti::graphics::MeshTex& mesh, Mode mode);
+    ~MeshShader();
+
+    MeshShader(const MeshShader&) = delete;
+    MeshShader& operator=(const MeshShader&) = delete;
+
     static const char* getProcName();
 
     void setModelViewProjection(const glm::mat4& mvp);
 
+    // Same topology, new vertex positions or texture coordinates (indexed mesh):
+    void setVertices(const VertexBuffer& vertices);
+    void setCoords(const CoordBuffer& coords);
+
+    std::size_t getVertexCount() const { return vertexCount; }
+    std::size_t getTriangleCount() const { return indexCount / 3; }
+
     void draw(int outFrameW, int outFrameH);
+    void draw(GLuint texId, int outFrameW, int outFrameH);
 
 protected:
-    std::shared_ptr<Shader> shader;
+    void build(const char* vshader);
+
+    std::shared_ptr<Program> shader;
 
     static const char* vshaderMeshSrc;
+    static const char* vshaderIsomapSrc;
     static const char* fshaderMeshSrc;
 
-    GLTexture texture;
+    std::unique_ptr<GLTexture> texture;
     GLuint texUnit;
     GLuint texTarget;
 
@@ -53,6 +85,13 @@ protected:
     VertexBuffer vertices;
     CoordBuffer coords;
 
+    // Indexed mesh:
+    GLuint vertexBuffer = 0;
+    GLuint coordBuffer = 0;
+    GLuint indexBuffer = 0;
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+
     glm::mat4 MVP;
 };
 
@@ -0,0 +1,346 @@
+/*! -*-c++-*-
+  @file   ProgramCache.cpp
+  @author David Hirvonen
+  @brief  Implementation of a persistent cache of linked GLSL program binaries.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/ProgramCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// clang-format off
+#if defined(GL_PROGRAM_BINARY_LENGTH)
+#  define DRISHTI_GL_PROGRAM_BINARY 1 // OpenGL ES 3, OpenGL 4.1
+#elif defined(GL_PROGRAM_BINARY_LENGTH_OES) && defined(GL_GLEXT_PROTOTYPES)
+#  define DRISHTI_GL_PROGRAM_BINARY 1 // GL_OES_get_program_binary
+#  define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+#  define GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#  define glGetProgramBinary glGetProgramBinaryOES
+#  define glProgramBinary glProgramBinaryOES
+#else
+#  define DRISHTI_GL_PROGRAM_BINARY 0
+#endif
+// clang-format on
+
+BEGIN_OGLES_GPGPU
+
+struct ProgramBinaryHeader
+{
+    std::uint32_t magic = 0x42505244; // "DRPB"
+    std::uint32_t format = 0;
+    std::uint32_t length = 0;
+    std::uint32_t reserved = 0;
+};
+
+static std::uint64_t fnv1a(const char* str, std::uint64_t hash = 0xcbf29ce484222325ULL)
+{
+    for (; str && *str; str++)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*str)) * 0x100000001b3ULL;
+    }
+    return (hash ^ 0xff) * 0x100000001b3ULL; // separator
+}
+
+static const char* getString(GLenum name)
+{
+    const auto* str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? str : "";
+}
+
+static void clearErrors()
+{
+    for (int i = 0; (i < 16) && (glGetError() != GL_NO_ERROR); i++)
+    {
+    }
+}
+
+static GLuint compile(GLenum type, const char* src)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status)
+    {
+        GLchar log[1024] = { 0 };
+        glGetShaderInfoLog(shader, sizeof(log) - 1, nullptr, log);
+        glDeleteShader(shader);
+        throw std::runtime_error(std::string("ProgramCache: shader compile error: ") + log);
+    }
+    return shader;
+}
+
+ProgramCache::ProgramCache(std::string directory)
+    : m_directory(std::move(directory))
+{
+}
+
+bool ProgramCache::isSupported()
+{
+#if DRISHTI_GL_PROGRAM_BINARY
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return (formats > 0);
+#else
+    return false;
+#endif
+}
+
+static std::shared_ptr<ProgramCache>& getCacheInstance()
+{
+    static std::shared_ptr<ProgramCache> cache;
+    return cache;
+}
+
+static std::mutex& getCacheMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+void ProgramCache::setInstance(std::shared_ptr<ProgramCache> cache)
+{
+    std::lock_guard<std::mutex> lock(getCacheMutex());
+    getCacheInstance() = std::move(cache);
+}
+
+std::shared_ptr<ProgramCache> ProgramCache::getInstance()
+{
+    std::lock_guard<std::mutex> lock(getCacheMutex());
+    return getCacheInstance();
+}
+
+GLuint ProgramCache::compileAndLink(const char* vshSrc, const char* fshSrc, bool retrievable)
+{
+    GLuint vsh = compile(GL_VERTEX_SHADER, vshSrc);
+    GLuint fsh = 0;
+    try
+    {
+        fsh = compile(GL_FRAGMENT_SHADER, fshSrc);
+    }
+    catch (...)
+    {
+        glDeleteShader(vsh);
+        throw;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vsh);
+    glAttachShader(program, fsh);
+
+#if defined(GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+    if (retrievable)
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+#else
+    static_cast<void>(retrievable);
+#endif
+
+    glLinkProgram(program);
+
+    // The program keeps the compiled stages:
+    glDetachShader(program, vsh);
+    glDetachShader(program, fsh);
+    glDeleteShader(vsh);
+    glDeleteShader(fsh);
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status)
+    {
+        GLchar log[1024] = { 0 };
+        glGetProgramInfoLog(program, sizeof(log) - 1, nullptr, log);
+        glDeleteProgram(program);
+        throw std::runtime_error(std::string("ProgramCache: program link error: ") + log);
+    }
+
+    return program;
+}
+
+std::string ProgramCache::getFilename(const char* vshSrc, const char* fshSrc) const
+{
+    // Driver updates invalidate the binaries:
+    std::uint64_t key = fnv1a(vshSrc);
+    key = fnv1a(fshSrc, key);
+    key = fnv1a(getString(GL_VENDOR), key);
+    key = fnv1a(getString(GL_RENDERER), key);
+    key = fnv1a(getString(GL_VERSION), key);
+
+    std::stringstream ss;
+    ss << m_directory << "/program_" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return ss.str();
+}
+
+GLuint ProgramCache::load(const std::string& filename) const
+{
+#if DRISHTI_GL_PROGRAM_BINARY
+    std::ifstream is(filename, std::ios::binary);
+    if (!is)
+    {
+        return 0;
+    }
+
+    ProgramBinaryHeader header, expected;
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!is || (header.magic != expected.magic) || (header.length == 0))
+    {
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    is.read(binary.data(), binary.size());
+    if (!is)
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), GLsizei(binary.size()));
+
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status)
+    {
+        // e.g., a format the driver no longer accepts:
+        glDeleteProgram(program);
+        clearErrors();
+        return 0;
+    }
+
+    return program;
+#else
+    return 0;
+#endif
+}
+
+bool ProgramCache::store(GLuint program, const std::string& filename) const
+{
+#if DRISHTI_GL_PROGRAM_BINARY
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+    {
+        clearErrors();
+        return false;
+    }
+    header.format = format;
+    header.length = std::uint32_t(written);
+
+    // Write and rename, so a concurrent (or interrupted) launch never reads a partial file:
+    const std::string tmp = filename + ".tmp";
+    {
+        std::ofstream os(tmp, std::ios::binary);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(binary.data(), written);
+        if (!os)
+        {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    return (std::rename(tmp.c_str(), filename.c_str()) == 0);
+#else
+    return false;
+#endif
+}
+
+GLuint ProgramCache::build(const char* vshSrc, const char* fshSrc, bool* cached)
+{
+    if (cached)
+    {
+        *cached = false;
+    }
+
+    if (!isSupported())
+    {
+        m_misses++;
+        return compileAndLink(vshSrc, fshSrc);
+    }
+
+    const std::string filename = getFilename(vshSrc, fshSrc);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (GLuint program = load(filename))
+    {
+        m_hits++;
+        if (cached)
+        {
+            *cached = true;
+        }
+        return program;
+    }
+
+    m_misses++;
+    GLuint program = compileAndLink(vshSrc, fshSrc, true);
+    if (program)
+    {
+        store(program, filename);
+    }
+    return program;
+}
+
+// ### Program ###
+
+Program::~Program()
+{
+    if (programId)
+    {
+        glDeleteProgram(programId);
+    }
+}
+
+bool Program::buildFromSrc(const char* vshSrc, const char* fshSrc)
+{
+    if (programId)
+    {
+        glDeleteProgram(programId);
+        programId = 0;
+    }
+
+    cached = false;
+    if (auto cache = ProgramCache::getInstance())
+    {
+        programId = cache->build(vshSrc, fshSrc, &cached);
+    }
+    else
+    {
+        programId = ProgramCache::compileAndLink(vshSrc, fshSrc);
+    }
+    return (programId != 0);
+}
+
+void Program::use()
+{
+    glUseProgram(programId);
+}
+
+GLint Program::getParam(ShaderParamType type, const char* name) const
+{
+    return (type == ATTR) ? glGetAttribLocation(programId, name) : glGetUniformLocation(programId, name);
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,93 @@
+/*! -*-c++-*-
+  @file   ProgramCache.h
+  @author David Hirvonen
+  @brief  Declaration of a persistent cache of linked GLSL program binaries.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Compiling and linking GLSL programs can take hundreds of milliseconds at startup on
+  some mobile drivers.  Linked programs are stored with glGetProgramBinary() (OpenGL ES 3,
+  OpenGL 4.1 or GL_OES_get_program_binary) in an application provided directory, keyed by
+  a hash of the shader sources and the driver strings (GL_VENDOR, GL_RENDERER and
+  GL_VERSION), so later launches load the binary with glProgramBinary() instead.  Any
+  failure (no binary formats, a missing or stale file, a driver that rejects the binary)
+  falls back to compiling the sources, and a rejected binary is replaced.
+
+  Program is a drop in replacement for ogles_gpgpu::Shader (buildFromSrc(), use() and
+  getParam()) that goes through the installed cache (see ProgramCache::setInstance()).
+
+*/
+
+#ifndef __drishti_graphics_ProgramCache_h__
+#define __drishti_graphics_ProgramCache_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+BEGIN_OGLES_GPGPU
+
+class ProgramCache
+{
+public:
+    explicit ProgramCache(std::string directory); // existing, writable directory
+
+    // Linked program for the sources, cached receives true if loaded from a binary.  Compile and
+    // link errors throw std::runtime_error with the driver's info log:
+    GLuint build(const char* vshSrc, const char* fshSrc, bool* cached = nullptr);
+
+    const std::string& getDirectory() const { return m_directory; }
+    std::size_t getHits() const { return m_hits; }
+    std::size_t getMisses() const { return m_misses; }
+
+    // Program binaries are supported by the current context:
+    static bool isSupported();
+
+    // Process wide cache used by Program (nullptr == compile only):
+    static void setInstance(std::shared_ptr<ProgramCache> cache);
+    static std::shared_ptr<ProgramCache> getInstance();
+
+    // Compile and link without the cache (throws on error, see build()):
+    static GLuint compileAndLink(const char* vshSrc, const char* fshSrc, bool retrievable = false);
+
+protected:
+    std::string getFilename(const char* vshSrc, const char* fshSrc) const;
+    GLuint load(const std::string& filename) const;
+    bool store(GLuint program, const std::string& filename) const;
+
+    std::string m_directory;
+    std::mutex m_mutex;
+    std::atomic<std::size_t> m_hits{ 0 };
+    std::atomic<std::size_t> m_misses{ 0 };
+};
+
+class Program
+{
+public:
+    Program() = default;
+    ~Program();
+
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    // Compile and link errors throw std::runtime_error (see ProgramCache::build()):
+    bool buildFromSrc(const char* vshSrc, const char* fshSrc);
+    void use();
+    GLint getParam(ShaderParamType type, const char* name) const;
+
+    GLuint getId() const { return programId; }
+    bool isCached() const { return cached; } // loaded from a program binary
+
+protected:
+    GLuint programId = 0;
+    bool cached = false;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_ProgramCache_h__
@@ -0,0 +1,130 @@
+/*! -*-c++-*-
+  @file   TexturePool.cpp
+  @author David Hirvonen
+  @brief  Implementation of a recycling pool of reference counted OpenGL textures.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/TexturePool.h"
+
+#include <algorithm>
+
+BEGIN_OGLES_GPGPU
+
+static std::size_t getBytes(const GLTexture& texture)
+{
+    return texture.width * texture.height * 4; // GL_RGBA
+}
+
+TexturePool::TexturePool(std::size_t maxFree)
+    : m_state(std::make_shared<State>())
+    , m_maxFree(maxFree)
+{
+}
+
+TexturePool::~TexturePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->free.clear();
+        m_state->expired.clear();
+    }
+    m_state.reset(); // outstanding leases are orphaned (see acquire())
+
+    if (m_fbo)
+    {
+        glDeleteFramebuffers(1, &m_fbo);
+    }
+}
+
+TexturePool::Lease TexturePool::acquire(const cv::Size& size)
+{
+    std::unique_ptr<GLTexture> texture;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        for (const auto& t : m_state->expired)
+        {
+            m_state->bytes -= getBytes(*t);
+        }
+        m_state->expired.clear(); // GL thread
+
+        auto& free = m_state->free;
+        auto iter = std::find_if(free.begin(), free.end(), [&](const std::unique_ptr<GLTexture>& t) {
+            return (t->width == static_cast<std::size_t>(size.width)) && (t->height == static_cast<std::size_t>(size.height));
+        });
+        if (iter != free.end())
+        {
+            texture = std::move(*iter);
+            free.erase(iter);
+        }
+    }
+
+    if (!texture)
+    {
+        texture.reset(new GLTexture(size.width, size.height, GL_RGBA, nullptr));
+        m_allocated++;
+        m_state->bytes += getBytes(*texture);
+    }
+
+    // The deleter only moves the texture (no GL calls), so a lease can be released from
+    // any thread.  If the pool is gone, the GL context may be too: the name is abandoned.
+    std::weak_ptr<State> state = m_state;
+    const std::size_t maxFree = m_maxFree;
+    return Lease(texture.release(), [state, maxFree](GLTexture* ptr) {
+        std::unique_ptr<GLTexture> texture(ptr);
+        if (auto pool = state.lock())
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            auto& list = (pool->free.size() < maxFree) ? pool->free : pool->expired;
+            list.push_back(std::move(texture));
+        }
+        else
+        {
+            texture->texId = 0; // glDeleteTextures() ignores 0
+        }
+    });
+}
+
+TexturePool::Lease TexturePool::copy(GLuint texId, const cv::Size& size)
+{
+    auto lease = acquire(size);
+
+    if (!m_fbo)
+    {
+        glGenFramebuffers(1, &m_fbo);
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texId, 0);
+
+    glBindTexture(GL_TEXTURE_2D, lease->texId);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size.width, size.height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    Tools::checkGLErr("TexturePool", "copy() : glCopyTexSubImage2D()");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+    return lease;
+}
+
+std::size_t TexturePool::getAllocatedCount() const
+{
+    return m_allocated;
+}
+
+std::size_t TexturePool::getAllocatedBytes() const
+{
+    return m_state->bytes;
+}
+
+std::size_t TexturePool::getAvailableCount() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->free.size();
+}
+
+END_OGLES_GPGPU
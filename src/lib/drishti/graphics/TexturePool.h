@@ -0,0 +1,73 @@
+/*! -*-c++-*-
+  @file   TexturePool.h
+  @author David Hirvonen
+  @brief  Declaration of a recycling pool of reference counted OpenGL textures.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  acquire() leases an RGBA texture as a std::shared_ptr<GLTexture>.  When the last
+  reference is released (from any thread, e.g., a FaceMonitor client) the texture is
+  handed back to the pool instead of being deleted, and a later acquire() of the same
+  size reuses it without glTexImage2D().  All GL calls happen in acquire(), copy() and
+  the destructor, which must be called from the thread that owns the GL context.
+
+*/
+
+#ifndef __drishti_graphics_TexturePool_h__
+#define __drishti_graphics_TexturePool_h__
+
+#include "drishti/graphics/drishti_graphics.h"
+#include "drishti/graphics/GLTexture.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+class TexturePool
+{
+public:
+    using Lease = std::shared_ptr<GLTexture>;
+
+    // Keep at most maxFree released textures, the rest are deleted in acquire():
+    explicit TexturePool(std::size_t maxFree = 8);
+    ~TexturePool();
+
+    TexturePool(const TexturePool&) = delete;
+    TexturePool(TexturePool&&) = delete;
+    TexturePool& operator=(const TexturePool&) = delete;
+    TexturePool& operator=(TexturePool&&) = delete;
+
+    // Recycle a released texture of the same size, or allocate a new one:
+    Lease acquire(const cv::Size& size);
+
+    // Copy a texture (e.g., a FIFO frame that will be overwritten) to a leased texture on the GPU:
+    Lease copy(GLuint texId, const cv::Size& size);
+
+    std::size_t getAllocatedCount() const; // textures created by the pool
+    std::size_t getAvailableCount() const; // released textures waiting for reuse
+    std::size_t getAllocatedBytes() const; // live textures (free and leased), any thread
+
+protected:
+    struct State
+    {
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<GLTexture>> free;
+        std::vector<std::unique_ptr<GLTexture>> expired; // over capacity, deleted on the GL thread
+        std::atomic<std::size_t> bytes{ 0 };
+    };
+
+    std::shared_ptr<State> m_state;
+    std::size_t m_maxFree = 8;
+    std::size_t m_allocated = 0;
+    GLuint m_fbo = 0;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_TexturePool_h__
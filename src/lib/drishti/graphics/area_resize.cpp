@@ -0,0 +1,67 @@
+/*! -*-c++-*-
+  @file   area_resize.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu shader for area (box filter) downscaling.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/area_resize.h"
+
+#include <algorithm>
+#include <cmath>
+
+BEGIN_OGLES_GPGPU
+
+void AreaResizeProc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamUBlock = shader->getParam(UNIF, "block");
+    shParamUTaps = shader->getParam(UNIF, "taps");
+}
+
+void AreaResizeProc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+
+    // Block size in texture coordinates, one bilinear tap per 2 texels (up to 8 per dimension):
+    const float bx = static_cast<float>(inFrameW) / static_cast<float>(std::max(outFrameW, 1));
+    const float by = static_cast<float>(inFrameH) / static_cast<float>(std::max(outFrameH, 1));
+    const float tx = std::min(std::max(std::ceil(bx * 0.5f), 1.f), 8.f);
+    const float ty = std::min(std::max(std::ceil(by * 0.5f), 1.f), 8.f);
+
+    glUniform2f(shParamUBlock, bx / static_cast<float>(inFrameW), by / static_cast<float>(inFrameH));
+    glUniform2f(shParamUTaps, tx, ty);
+}
+
+// clang-format off
+const char * AreaResizeProc::fshaderAreaResizeSrc = 
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform vec2 block;
+ uniform vec2 taps;
+ void main()
+ {
+     vec2 origin = vTexCoord - (block * 0.5);
+     vec2 delta = block / taps;
+     vec4 sum = vec4(0.0);
+     for (int y = 0; y < 8; y++)
+     {
+         if (float(y) >= taps.y) break;
+         for (int x = 0; x < 8; x++)
+         {
+             if (float(x) >= taps.x) break;
+             sum += texture2D(uInputTex, origin + (vec2(float(x), float(y)) + 0.5) * delta);
+         }
+     }
+     gl_FragColor = sum / (taps.x * taps.y);
+ });
+// clang-format on
+
+END_OGLES_GPGPU
@@ -0,0 +1,46 @@
+/*! -*-c++-*-
+  @file   area_resize.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu shader for area (box filter) downscaling.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_area_resize_h__
+#define __drishti_graphics_area_resize_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+// Each output pixel is the mean of the corresponding block of input texels, like cv::INTER_AREA.
+// Bilinear taps are placed between texel pairs, so one tap averages 2 x 2 texels and downscale
+// factors up to 16 per dimension are sampled with at most 8 x 8 taps.  A single bilinear (or
+// mip) lookup aliases fine detail beyond a factor of 2, which this avoids.
+class AreaResizeProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    AreaResizeProc() = default;
+    const char* getProcName() override
+    {
+        return "AreaResizeProc";
+    }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderAreaResizeSrc;
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    static const char* fshaderAreaResizeSrc; // fragment shader source
+    GLint shParamUBlock{};
+    GLint shParamUTaps{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_area_resize_h__
@@ -9,9 +9,82 @@
 */
 
 #include "drishti/graphics/binomial.h"
+#include "drishti/graphics/kernel_bank.h"
+
+#include <sstream>
+#include <vector>
 
 BEGIN_OGLES_GPGPU
 
+std::string getBinomialFunctionSource(int order, bool is2d)
+{
+    const auto& kernel = drishti::graphics::getBinomialKernel(order);
+
+    // Signed { offset, weight } samples of the 1D kernel:
+    std::vector<std::pair<float, float>> samples{ { 0.f, kernel.center } };
+    for (int i = 0; i < kernel.count; i++)
+    {
+        samples.emplace_back(-kernel.taps[i].offset, kernel.taps[i].weight);
+        samples.emplace_back(+kernel.taps[i].offset, kernel.taps[i].weight);
+    }
+
+    std::stringstream ss;
+    ss.precision(8);
+    ss << std::fixed;
+    ss << "vec4 binomial(sampler2D tex, vec2 tc, vec2 delta)\n{\n";
+    ss << "    vec4 sum = vec4(0.0);\n";
+    if (is2d)
+    {
+        for (const auto& y : samples)
+        {
+            for (const auto& x : samples)
+            {
+                ss << "    sum += texture2D(tex, tc + vec2(" << x.first << ", " << y.first << ") * delta) * " << (x.second * y.second) << ";\n";
+            }
+        }
+    }
+    else
+    {
+        for (const auto& x : samples)
+        {
+            ss << "    sum += texture2D(tex, tc + delta * " << x.first << ") * " << x.second << ";\n";
+        }
+    }
+    ss << "    return sum;\n}\n";
+    return ss.str();
+}
+
+BinomialSeparableProc::BinomialSeparableProc(int order, bool horizontal)
+    : horizontal(horizontal)
+{
+    std::stringstream ss;
+#if defined(OGLES_GPGPU_OPENGLES)
+    ss << "precision highp float;\n";
+#endif
+    ss << "varying vec2 vTexCoord;\n";
+    ss << "uniform sampler2D uInputTex;\n";
+    ss << "uniform vec2 delta;\n";
+    ss << getBinomialFunctionSource(order, false);
+    ss << "void main()\n{\n";
+    ss << "    gl_FragColor = binomial(uInputTex, vTexCoord, delta);\n";
+    ss << "}\n";
+    fshaderSrc = ss.str();
+}
+
+void BinomialSeparableProc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamUDelta = shader->getParam(UNIF, "delta");
+}
+
+void BinomialSeparableProc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+    const float dx = horizontal ? 1.f / static_cast<float>(inFrameW) : 0.f;
+    const float dy = horizontal ? 0.f : 1.f / static_cast<float>(inFrameH);
+    glUniform2f(shParamUDelta, dx, dy);
+}
+
 // clang-format off
 const char * BinomialProc::fshaderBinomialSrc = 
 #if defined(OGLES_GPGPU_OPENGLES)
@@ -12,6 +12,9 @@
 #define __drishti_graphics_binomial_h__
 
 #include "ogles_gpgpu/common/proc/filter3x3.h"
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include <string>
 
 BEGIN_OGLES_GPGPU
 
@@ -40,6 +43,37 @@ private:
     static const char* fshaderBinomialSrc; // fragment shader source
 };
 
+//======= Separable binomial =============
+
+// GLSL source for "vec4 binomial(sampler2D tex, vec2 tc, vec2 delta)": a binomial kernel of
+// the given order from drishti::graphics::getBinomialKernel(), using linear sampling.  The 1D
+// kernel is applied along delta, the 2D (outer product) kernel uses delta.x and delta.y.
+std::string getBinomialFunctionSource(int order, bool is2d);
+
+// One direction of a separable binomial filter, so a horizontal and a vertical proc give an
+// order 16 kernel in 2 * (1 + 2 * 4) texture reads, instead of 17 * 17 for a single pass.
+class BinomialSeparableProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    BinomialSeparableProc(int order, bool horizontal);
+    const char* getProcName() override
+    {
+        return "BinomialSeparableProc";
+    }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderSrc.c_str();
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    bool horizontal = true;
+    std::string fshaderSrc; // fragment shader source (generated)
+    GLint shParamUDelta{};
+};
+
 END_OGLES_GPGPU
 
 #endif //  __drishti_graphics_binomial_h__
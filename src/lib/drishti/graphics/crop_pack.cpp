@@ -0,0 +1,77 @@
+/*! -*-c++-*-
+  @file   crop_pack.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu shader for cropped, scaled and packed image readback.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/crop_pack.h"
+
+BEGIN_OGLES_GPGPU
+
+void CropPackProc::setImageSize(int width, int height)
+{
+    imageWidth = width;
+    setOutputSize((mode == PLANE) ? (width / 4) : width, height);
+}
+
+void CropPackProc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamURoi = shader->getParam(UNIF, "roi");
+    shParamUPlane = shader->getParam(UNIF, "plane");
+    shParamUWidth = shader->getParam(UNIF, "width");
+    shParamUPacking = shader->getParam(UNIF, "packing");
+    shParamUSwap = shader->getParam(UNIF, "swap");
+}
+
+void CropPackProc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+    glUniform4f(shParamURoi, roi[0], roi[1], roi[2], roi[3]);
+    glUniform4f(shParamUPlane, plane[0], plane[1], plane[2], plane[3]);
+    glUniform1f(shParamUWidth, static_cast<float>(imageWidth));
+    glUniform1f(shParamUPacking, (mode == PLANE) ? 4.f : 1.f);
+    glUniform1f(shParamUSwap, bgra ? 1.f : 0.f);
+}
+
+// clang-format off
+const char * CropPackProc::fshaderCropPackSrc = 
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform vec4 roi;
+ uniform vec4 plane;
+ uniform float width;
+ uniform float packing;
+ uniform float swap;
+
+ float sampleAt(float x)
+ {
+     vec2 uv = roi.xy + vec2(x / width, vTexCoord.y) * roi.zw;
+     return clamp(dot(texture2D(uInputTex, uv).rgb, plane.rgb) + plane.a, 0.0, 1.0);
+ }
+
+ void main()
+ {
+     if (packing < 2.0)
+     {
+         gl_FragColor = texture2D(uInputTex, roi.xy + vTexCoord * roi.zw);
+     }
+     else
+     {
+         // First of the 4 image pixels packed in this texel:
+         float x0 = floor(vTexCoord.x * width / 4.0) * 4.0;
+         vec4 p = vec4(sampleAt(x0 + 0.5), sampleAt(x0 + 1.5), sampleAt(x0 + 2.5), sampleAt(x0 + 3.5));
+         gl_FragColor = mix(p, p.zyxw, swap);
+     }
+ });
+// clang-format on
+
+END_OGLES_GPGPU
@@ -0,0 +1,90 @@
+/*! -*-c++-*-
+  @file   crop_pack.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu shader for cropped, scaled and packed image readback.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_crop_pack_h__
+#define __drishti_graphics_crop_pack_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include <array>
+
+BEGIN_OGLES_GPGPU
+
+// Resample a normalized region of interest of the input texture to a width x height image
+// and optionally convert it to a single 8 bit plane (e.g., Y, U or V) for cheap readback:
+//
+//   RGBA  : one input sample per output texel (output size: width x height)
+//   PLANE : dot(rgb, weights) + offset for 4 horizontally adjacent samples packed in
+//           each output texel (output size: width/4 x height, width % 4 == 0)
+//
+// Packed texels are written in readback byte order, so set bgra when the output is read
+// back as BGRA (i.e. a packed texel is 4 consecutive plane pixels in memory).
+class CropPackProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    enum Mode
+    {
+        RGBA,
+        PLANE
+    };
+
+    CropPackProc(Mode mode = RGBA, bool bgra = false)
+        : mode(mode)
+        , bgra(bgra)
+    {
+    }
+    const char* getProcName() override
+    {
+        return "CropPackProc";
+    }
+
+    // Normalized { x, y, width, height } in the input texture:
+    void setRoi(float x, float y, float width, float height)
+    {
+        roi = { { x, y, width, height } };
+    }
+
+    // Plane weights for RGB and a constant offset (PLANE mode), e.g., BT.601 luma:
+    void setPlane(float r, float g, float b, float offset)
+    {
+        plane = { { r, g, b, offset } };
+    }
+
+    // Output image size in pixels (before packing):
+    void setImageSize(int width, int height);
+
+    Mode getMode() const { return mode; }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderCropPackSrc;
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    static const char* fshaderCropPackSrc; // fragment shader source
+
+    Mode mode = RGBA;
+    bool bgra = false;
+    int imageWidth = 0;
+    std::array<float, 4> roi = { { 0.f, 0.f, 1.f, 1.f } };
+    std::array<float, 4> plane = { { 0.299f, 0.587f, 0.114f, 0.f } };
+
+    GLint shParamURoi{};
+    GLint shParamUPlane{};
+    GLint shParamUWidth{};
+    GLint shParamUPacking{};
+    GLint shParamUSwap{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_crop_pack_h__
@@ -0,0 +1,72 @@
+/*! -*-c++-*-
+  @file   flow_reduce.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu shader for block reduction of optical flow.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/flow_reduce.h"
+
+#include <algorithm>
+#include <cmath>
+
+BEGIN_OGLES_GPGPU
+
+void FlowReduceProc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamUThreshold = shader->getParam(UNIF, "threshold");
+    shParamUBlock = shader->getParam(UNIF, "block");
+    shParamUTaps = shader->getParam(UNIF, "taps");
+}
+
+void FlowReduceProc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+
+    // Block size in texture coordinates, sampled with up to 16 taps per dimension:
+    const float bx = static_cast<float>(inFrameW) / static_cast<float>(std::max(outFrameW, 1));
+    const float by = static_cast<float>(inFrameH) / static_cast<float>(std::max(outFrameH, 1));
+    const float tx = std::min(std::ceil(bx), 16.f), ty = std::min(std::ceil(by), 16.f);
+
+    glUniform1f(shParamUThreshold, threshold);
+    glUniform2f(shParamUBlock, bx / static_cast<float>(inFrameW), by / static_cast<float>(inFrameH));
+    glUniform2f(shParamUTaps, tx, ty);
+}
+
+// clang-format off
+const char * FlowReduceProc::fshaderFlowReduceSrc = 
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform float threshold;
+ uniform vec2 block;
+ uniform vec2 taps;
+ void main()
+ {
+     vec2 origin = vTexCoord - (block * 0.5);
+     vec2 delta = block / taps;
+     vec3 sum = vec3(0.0);
+     for (int y = 0; y < 16; y++)
+     {
+         if (float(y) >= taps.y) break;
+         for (int x = 0; x < 16; x++)
+         {
+             if (float(x) >= taps.x) break;
+             vec3 val = texture2D(uInputTex, origin + (vec2(float(x), float(y)) + 0.5) * delta).rgb;
+             float w = step(threshold + 0.000001, val.b) * val.b;
+             sum += vec3(val.rg * w, w);
+         }
+     }
+     vec2 flow = (sum.z > 0.0) ? (sum.xy / sum.z) : vec2(0.5);
+     gl_FragColor = vec4(flow, sum.z / (taps.x * taps.y), 1.0);
+ });
+// clang-format on
+
+END_OGLES_GPGPU
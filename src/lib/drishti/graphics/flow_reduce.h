@@ -0,0 +1,55 @@
+/*! -*-c++-*-
+  @file   flow_reduce.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu shader for block reduction of optical flow.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_flow_reduce_h__
+#define __drishti_graphics_flow_reduce_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+// Each output pixel is the weighted mean of the flow over the corresponding block of input
+// texels (up to 16 x 16 samples per block), using the FlowOptPipeline layout:
+//
+//   input : { r = dx, g = dy, b = weight (corner strength), a = * } (flow encoded as (d + 1) / 2)
+//   output: { r = mean dx, g = mean dy, b = mean weight, a = 1 }
+//
+// The output uses the input layout, so procs can be chained to reduce in stages (e.g.,
+// cells -> eye regions).  Weights <= threshold are ignored.
+class FlowReduceProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    FlowReduceProc(float threshold = 0.f)
+        : threshold(threshold)
+    {
+    }
+    const char* getProcName() override
+    {
+        return "FlowReduceProc";
+    }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderFlowReduceSrc;
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    static const char* fshaderFlowReduceSrc; // fragment shader source
+    float threshold = 0.f;
+    GLint shParamUThreshold{};
+    GLint shParamUBlock{};
+    GLint shParamUTaps{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_flow_reduce_h__
@@ -0,0 +1,94 @@
+/*! -*-c++-*-
+  @file   isomap.cpp
+  @author David Hirvonen
+  @brief  Implementation of GPU face mesh texture (isomap) extraction.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/isomap.h"
+
+BEGIN_OGLES_GPGPU
+
+IsomapExtractor::IsomapExtractor(int resolution)
+    : m_resolution(resolution)
+{
+}
+
+IsomapExtractor::~IsomapExtractor()
+{
+    if (m_fbo)
+    {
+        glDeleteFramebuffers(1, &m_fbo);
+    }
+}
+
+GLuint IsomapExtractor::operator()(const drishti::graphics::MeshTex& mesh, const cv::Matx34f& affine, GLuint texId, const cv::Size& size, bool doVertices)
+{
+    if (!output)
+    {
+        output.reset(new GLTexture(m_resolution, m_resolution, GL_RGBA, nullptr));
+        glGenFramebuffers(1, &m_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, output->texId, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Buffers are created once per topology, later frames only update them:
+    const Topology topology(mesh.vertices.size(), mesh.tvi.size());
+    auto& shader = m_shaders[topology];
+    if (!shader)
+    {
+        shader.reset(new MeshShader(mesh, MeshShader::kIsomap));
+    }
+    else if (doVertices)
+    {
+        shader->setVertices(mesh.vertices);
+    }
+
+    // Image pixels to texture coordinates (glm matrices are column major):
+    glm::mat4 T(0.f);
+    for (int x = 0; x < 4; x++)
+    {
+        T[x][0] = affine(0, x) / static_cast<float>(size.width);
+        T[x][1] = affine(1, x) / static_cast<float>(size.height);
+    }
+    T[3][3] = 1.f;
+    shader->setModelViewProjection(T);
+
+    GLint previous = 0, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_resolution, m_resolution);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    shader->draw(texId, m_resolution, m_resolution);
+    Tools::checkGLErr("IsomapExtractor", "draw()");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    return output->texId;
+}
+
+void IsomapExtractor::getIsomap(cv::Mat& isomap, GLenum format)
+{
+    isomap.create(m_resolution, m_resolution, CV_8UC4);
+    if (!output)
+    {
+        isomap = cv::Scalar::all(0);
+        return;
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_resolution, m_resolution, format, GL_UNSIGNED_BYTE, isomap.ptr());
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,64 @@
+/*! -*-c++-*-
+  @file   isomap.h
+  @author David Hirvonen
+  @brief  Declaration of GPU face mesh texture (isomap) extraction.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  GPU replacement for the CPU texture extraction (FaceMeshContainer::extractTexture()):
+  the mesh is rendered at its texture coordinates into a square texture, and each
+  fragment samples the input image texture where the affine camera projects the mesh.
+  One indexed MeshShader (GPU vertex, texture coordinate and index buffers) is cached per
+  mesh topology, so a new frame only uploads the vertices (if they changed) and the pose.
+  As with the CPU version (without a visibility test) occluded triangles are not masked.
+
+*/
+
+#ifndef __drishti_graphics_isomap_h__
+#define __drishti_graphics_isomap_h__
+
+#include "drishti/graphics/drishti_graphics.h"
+#include "drishti/graphics/GLTexture.h"
+#include "drishti/graphics/MeshShader.h"
+#include "drishti/graphics/meshtex.h"
+
+#include <opencv2/core.hpp>
+
+#include <map>
+#include <memory>
+#include <utility>
+
+BEGIN_OGLES_GPGPU
+
+class IsomapExtractor
+{
+public:
+    explicit IsomapExtractor(int resolution = 512);
+    ~IsomapExtractor();
+
+    IsomapExtractor(const IsomapExtractor&) = delete;
+    IsomapExtractor& operator=(const IsomapExtractor&) = delete;
+
+    // Render the isomap of an image texture, affine maps mesh vertices to image pixels
+    // (see FaceMeshContainer::getAffineCamera()), returns the isomap texture:
+    GLuint operator()(const drishti::graphics::MeshTex& mesh, const cv::Matx34f& affine, GLuint texId, const cv::Size& size, bool doVertices = true);
+
+    // Read back the last isomap (format: GL_RGBA, or GL_BGRA where supported):
+    void getIsomap(cv::Mat& isomap, GLenum format = GL_RGBA);
+
+    GLuint getOutputTexId() const { return output ? output->texId : 0; }
+    int getResolution() const { return m_resolution; }
+
+protected:
+    using Topology = std::pair<std::size_t, std::size_t>; // { vertices, triangles }
+
+    std::map<Topology, std::unique_ptr<MeshShader>> m_shaders;
+    std::unique_ptr<GLTexture> output;
+    GLuint m_fbo = 0;
+    int m_resolution = 512;
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_isomap_h__
@@ -0,0 +1,115 @@
+/*! -*-c++-*-
+  @file   kernel_bank.h
+  @author David Hirvonen (C++ implementation)
+  @brief Compile time binomial (Gaussian) kernels with linear sampling tap reduction.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A binomial kernel of (even) order n has n + 1 taps, weights C(n, k) / 2^n, and approximates
+  a Gaussian with sigma^2 = n / 4.  With bilinear filtering, two neighboring taps a and b
+  can be fetched with one texture read at the weighted offset (a * wa + b * wb) / (wa + wb),
+  so each side of the kernel needs ceil(n / 4) reads instead of n / 2.  This also holds in
+  2D for the separable (outer product) kernel, one read per pair of taps in each dimension.
+
+  The functions are C++11 constexpr, so the bank below is computed by the compiler.
+
+*/
+
+#ifndef __drishti_graphics_kernel_bank_h__
+#define __drishti_graphics_kernel_bank_h__
+
+#include "drishti/graphics/drishti_graphics.h"
+
+DRISHTI_GRAPHICS_BEGIN
+
+constexpr int kMaxBinomialOrder = 16;
+constexpr int kMaxLinearTaps = 4; // per side, for kMaxBinomialOrder
+
+constexpr double choose(int n, int k)
+{
+    return (k <= 0) ? 1.0 : choose(n, k - 1) * (n - k + 1) / k;
+}
+
+constexpr double binomialWeight(int n, int k)
+{
+    return (k < 0 || k > n) ? 0.0 : choose(n, k) / static_cast<double>(1u << n);
+}
+
+// Variance of the equivalent Gaussian (sigma^2):
+constexpr double binomialVariance(int n)
+{
+    return n / 4.0;
+}
+
+// Weight of the tap at signed offset from the kernel center:
+constexpr double binomialTap(int n, int offset)
+{
+    return binomialWeight(n, n / 2 + offset);
+}
+
+constexpr int linearTapCount(int n)
+{
+    return (n / 2 + 1) / 2;
+}
+
+// Side tap i merges the discrete taps at offsets 2i + 1 and 2i + 2:
+constexpr double linearWeight(int n, int i)
+{
+    return binomialTap(n, 2 * i + 1) + binomialTap(n, 2 * i + 2);
+}
+
+constexpr double linearOffset(int n, int i)
+{
+    return (linearWeight(n, i) > 0.0) ? (binomialTap(n, 2 * i + 1) * (2 * i + 1) + binomialTap(n, 2 * i + 2) * (2 * i + 2)) / linearWeight(n, i) : 0.0;
+}
+
+struct LinearTap
+{
+    float offset;
+    float weight;
+};
+
+// Kernel: center * x[0] + sum_i taps[i].weight * (x[-taps[i].offset] + x[+taps[i].offset])
+struct LinearKernel
+{
+    int order;
+    int count; // side taps in use
+    float center;
+    LinearTap taps[kMaxLinearTaps];
+};
+
+constexpr LinearTap makeLinearTap(int n, int i)
+{
+    return { static_cast<float>(linearOffset(n, i)), static_cast<float>(linearWeight(n, i)) };
+}
+
+constexpr LinearKernel makeLinearKernel(int n)
+{
+    return { n, linearTapCount(n), static_cast<float>(binomialTap(n, 0)), { makeLinearTap(n, 0), makeLinearTap(n, 1), makeLinearTap(n, 2), makeLinearTap(n, 3) } };
+}
+
+// Even orders 2 .. kMaxBinomialOrder, see getBinomialKernel():
+constexpr LinearKernel kBinomialKernels[] = {
+    makeLinearKernel(2),
+    makeLinearKernel(4),
+    makeLinearKernel(6),
+    makeLinearKernel(8),
+    makeLinearKernel(10),
+    makeLinearKernel(12),
+    makeLinearKernel(14),
+    makeLinearKernel(16)
+};
+
+// Odd orders are rounded up, the order is clamped to [2, kMaxBinomialOrder]:
+inline const LinearKernel& getBinomialKernel(int order)
+{
+    const int n = (order < 2) ? 2 : ((order > kMaxBinomialOrder) ? kMaxBinomialOrder : order);
+    return kBinomialKernels[(n + 1) / 2 - 1];
+}
+
+static_assert(linearTapCount(kMaxBinomialOrder) <= kMaxLinearTaps, "kMaxLinearTaps");
+
+DRISHTI_GRAPHICS_END
+
+#endif // __drishti_graphics_kernel_bank_h__
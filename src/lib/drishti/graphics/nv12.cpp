@@ -0,0 +1,50 @@
+/*! -*-c++-*-
+  @file   nv12.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu shader for two plane YUV 4:2:0 (NV12) to RGBA conversion.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/nv12.h"
+
+BEGIN_OGLES_GPGPU
+
+void Nv12Proc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamUChromaTex = shader->getParam(UNIF, "uChromaTex");
+}
+
+void Nv12Proc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, chromaTexture);
+    glUniform1i(shParamUChromaTex, 1);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// clang-format off
+const char * Nv12Proc::fshaderNv12Src = 
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform sampler2D uChromaTex;
+
+ void main()
+ {
+     float y = texture2D(uInputTex, vTexCoord).r;
+     vec2 uv = texture2D(uChromaTex, vTexCoord).ra - vec2(0.5, 0.5);
+     vec3 rgb = vec3(y + 1.402 * uv.y, y - 0.344136 * uv.x - 0.714136 * uv.y, y + 1.772 * uv.x);
+     gl_FragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+ });
+// clang-format on
+
+END_OGLES_GPGPU
@@ -0,0 +1,52 @@
+/*! -*-c++-*-
+  @file   nv12.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu shader for two plane YUV 4:2:0 (NV12) to RGBA conversion.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_nv12_h__
+#define __drishti_graphics_nv12_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+BEGIN_OGLES_GPGPU
+
+// The input texture is the full resolution luma plane (GL_LUMINANCE) and the interleaved
+// half resolution CbCr plane (GL_LUMINANCE_ALPHA: Cb == .r, Cr == .a) is bound to texture
+// unit 1 during rendering.  Output is full range BT.601 RGBA at the input size (by default).
+class Nv12Proc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    Nv12Proc() = default;
+
+    const char* getProcName() override
+    {
+        return "Nv12Proc";
+    }
+
+    void setChromaTexture(GLuint texture)
+    {
+        chromaTexture = texture;
+    }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderNv12Src;
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    static const char* fshaderNv12Src; // fragment shader source
+
+    GLuint chromaTexture = 0;
+    GLint shParamUChromaTex{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_nv12_h__
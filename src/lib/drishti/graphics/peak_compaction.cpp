@@ -0,0 +1,62 @@
+/*! -*-c++-*-
+  @file   peak_compaction.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu shader for compaction of sparse peak images.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/peak_compaction.h"
+
+BEGIN_OGLES_GPGPU
+
+void PeakCompactionProc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamUTexelSize = shader->getParam(UNIF, "texelSize");
+    shParamUCellSize = shader->getParam(UNIF, "cellSize");
+}
+
+void PeakCompactionProc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+    glUniform2f(shParamUTexelSize, 1.f / static_cast<float>(inFrameW), 1.f / static_cast<float>(inFrameH));
+    glUniform1f(shParamUCellSize, static_cast<float>(cellSize));
+}
+
+// clang-format off
+const char * PeakCompactionProc::fshaderPeakCompactionSrc = 
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform vec2 texelSize;
+ uniform float cellSize;
+ void main()
+ {
+     // Top left texel of this output cell:
+     vec2 origin = (floor(vTexCoord / (texelSize * cellSize)) * cellSize) * texelSize;
+     vec3 best = vec3(0.0);
+     for (int y = 0; y < 16; y++)
+     {
+         if (float(y) >= cellSize) break;
+         for (int x = 0; x < 16; x++)
+         {
+             if (float(x) >= cellSize) break;
+             vec2 offset = vec2(float(x), float(y)) + 0.5;
+             float value = texture2D(uInputTex, origin + offset * texelSize).a;
+             if (value > best.z)
+             {
+                 best = vec3(offset / cellSize, value);
+             }
+         }
+     }
+     gl_FragColor = vec4(best.x, best.y, best.x, best.z);
+ });
+// clang-format on
+
+END_OGLES_GPGPU
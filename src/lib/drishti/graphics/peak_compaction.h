@@ -0,0 +1,57 @@
+/*! -*-c++-*-
+  @file   peak_compaction.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu shader for compaction of sparse peak images.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_peak_compaction_h__
+#define __drishti_graphics_peak_compaction_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include <algorithm>
+
+BEGIN_OGLES_GPGPU
+
+// Reduce a sparse peak image (e.g., non-max suppression output with strength in alpha) to one
+// strongest peak per cellSize x cellSize cell (cellSize <= 16).  Each output pixel encodes:
+//
+//   { r = x, g = y, b = x, a = strength } with x, y = (offset + 0.5) / cellSize in the cell
+//
+// The layout is symmetric under r/b swaps, so it can be read back as RGBA or BGRA.
+class PeakCompactionProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    PeakCompactionProc(int cellSize = 4)
+        : cellSize(std::min(std::max(cellSize, 1), 16))
+    {
+        setOutputSize(1.f / static_cast<float>(this->cellSize));
+    }
+    const char* getProcName() override
+    {
+        return "PeakCompactionProc";
+    }
+
+    int getCellSize() const { return cellSize; }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderPeakCompactionSrc;
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    static const char* fshaderPeakCompactionSrc; // fragment shader source
+    int cellSize = 4;
+    GLint shParamUTexelSize{};
+    GLint shParamUCellSize{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_peak_compaction_h__
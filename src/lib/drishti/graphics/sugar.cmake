@@ -25,20 +25,41 @@ if(DRISHTI_BUILD_OGLES_GPGPU)
     DRISHTI_GRAPHICS_SRCS
     LineShader.cpp         
     MeshShader.cpp
+    ProgramCache.cpp
+    area_resize.cpp
     binomial.cpp
+    crop_pack.cpp
+    flow_reduce.cpp
+    isomap.cpp
     mesh.cpp 
     meshtex.cpp
+    nv12.cpp
+    peak_compaction.cpp
     saturation.cpp
+    temporal_binomial.cpp
+    temporal_ring.cpp
+    TexturePool.cpp
     )
   sugar_files(
     DRISHTI_GRAPHICS_HDRS_PUBLIC
     GLTexture.h    
     LineShader.h    
     MeshShader.h
+    ProgramCache.h
+    area_resize.h
     binomial.h
+    crop_pack.h
+    flow_reduce.h
+    isomap.h
+    kernel_bank.h
     mesh.h
     meshtex.h
+    nv12.h
+    peak_compaction.h
     saturation.h
+    temporal_binomial.h
+    temporal_ring.h
+    TexturePool.h
     )
 endif()
 
@@ -0,0 +1,62 @@
+/*! -*-c++-*-
+  @file   temporal_binomial.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu shader for fused temporal FIR and spatial low pass filtering.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/temporal_binomial.h"
+#include "drishti/graphics/binomial.h"
+
+#include <sstream>
+
+BEGIN_OGLES_GPGPU
+
+TemporalBinomialProc::TemporalBinomialProc(int order, Output output, float gain)
+    : gain(gain)
+{
+    std::stringstream ss;
+#if defined(OGLES_GPGPU_OPENGLES)
+    ss << "precision highp float;\n";
+#endif
+    ss << "varying vec2 textureCoordinate;\n";
+    ss << "uniform sampler2D inputImageTexture;\n";
+    ss << "uniform sampler2D inputImageTexture2;\n";
+    ss << "uniform sampler2D inputImageTexture3;\n";
+    ss << "uniform vec3 weights;\n";
+    ss << "uniform float alpha;\n";
+    ss << "uniform float beta;\n";
+    ss << "uniform float gain;\n";
+    ss << "uniform vec2 delta;\n";
+    ss << getBinomialFunctionSource(order, true);
+    ss << "void main()\n{\n";
+    ss << "    vec4 y = binomial(inputImageTexture, textureCoordinate, delta) * weights.x;\n";
+    ss << "    y += binomial(inputImageTexture2, textureCoordinate, delta) * weights.y;\n";
+    ss << "    y += binomial(inputImageTexture3, textureCoordinate, delta) * weights.z;\n";
+    if (output == kDifference)
+    {
+        ss << "    y = vec4(0.5) + (texture2D(inputImageTexture, textureCoordinate) - y) * gain;\n";
+    }
+    ss << "    gl_FragColor = vec4(clamp(y.rgb * alpha + beta, 0.0, 1.0), 1.0);\n";
+    ss << "}\n";
+    fshaderSrc = ss.str();
+}
+
+void TemporalBinomialProc::getUniforms()
+{
+    Fir3Proc::getUniforms();
+    shParamUDelta = shader->getParam(UNIF, "delta");
+    shParamUGain = shader->getParam(UNIF, "gain");
+}
+
+void TemporalBinomialProc::setUniforms()
+{
+    Fir3Proc::setUniforms();
+    glUniform2f(shParamUDelta, 1.f / static_cast<float>(inFrameW), 1.f / static_cast<float>(inFrameH));
+    glUniform1f(shParamUGain, gain);
+}
+
+END_OGLES_GPGPU
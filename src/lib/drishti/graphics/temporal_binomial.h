@@ -0,0 +1,61 @@
+/*! -*-c++-*-
+  @file   temporal_binomial.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu shader for fused temporal FIR and spatial low pass filtering.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_temporal_binomial_h__
+#define __drishti_graphics_temporal_binomial_h__
+
+#include "ogles_gpgpu/common/proc/fir3.h"
+
+#include <string>
+
+BEGIN_OGLES_GPGPU
+
+// A Fir3Proc (3 tap temporal FIR over FifoProc frames) that also applies a 2D binomial low pass
+// to each frame in the same pass (the filters are linear, so the order doesn't matter):
+//
+//   kLowPass    : y = sum_t weights[t] * B(x_t)
+//   kDifference : y = 0.5 + gain * (x_0 - sum_t weights[t] * B(x_t)), x_0 = first input
+//
+// The output is alpha * y + beta, as in Fir3Proc.  This replaces a Fir3Proc -> GaussOptProc
+// (-> DiffProc) chain, i.e., 2-3 full texture passes and intermediate FBOs, with one pass.
+class TemporalBinomialProc : public ogles_gpgpu::Fir3Proc
+{
+public:
+    enum Output
+    {
+        kLowPass,
+        kDifference
+    };
+
+    TemporalBinomialProc(int order = 4, Output output = kLowPass, float gain = 1.f);
+    const char* getProcName() override
+    {
+        return "TemporalBinomialProc";
+    }
+
+    void setGain(float value) { gain = value; }
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderSrc.c_str();
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    float gain = 1.f;
+    std::string fshaderSrc; // fragment shader source (generated)
+    GLint shParamUDelta{};
+    GLint shParamUGain{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_temporal_binomial_h__
@@ -0,0 +1,186 @@
+/*! -*-c++-*-
+  @file   temporal_ring.cpp
+  @author David Hirvonen (C++ implementation)
+  @brief Implementation of an ogles_gpgpu ring buffer of past frames with a temporal kernel.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/graphics/temporal_ring.h"
+
+#include <algorithm>
+#include <cmath>
+
+BEGIN_OGLES_GPGPU
+
+constexpr int TemporalRingProc::kMaxLength;
+
+TemporalRingProc::TemporalRingProc(int length)
+    : length(std::min(std::max(length, 1), kMaxLength))
+    , weights(mean(this->length))
+{
+}
+
+TemporalRingProc::~TemporalRingProc()
+{
+    if (readFbo)
+    {
+        glDeleteFramebuffers(1, &readFbo);
+    }
+}
+
+void TemporalRingProc::setKernel(const std::vector<float>& weights, float bias)
+{
+    this->weights = weights;
+    this->bias = bias;
+}
+
+std::vector<float> TemporalRingProc::mean(int length)
+{
+    return std::vector<float>(length, 1.f / static_cast<float>(std::max(length, 1)));
+}
+
+std::vector<float> TemporalRingProc::difference(int length)
+{
+    std::vector<float> weights(std::max(length, 2), -1.f / static_cast<float>(std::max(length - 1, 1)));
+    weights[0] = 1.f;
+    return weights;
+}
+
+std::vector<float> TemporalRingProc::exponential(int length, float alpha)
+{
+    std::vector<float> weights(length);
+    float sum = 0.f;
+    for (int k = 0; k < length; k++)
+    {
+        weights[k] = alpha * std::pow(1.f - alpha, static_cast<float>(k));
+        sum += weights[k];
+    }
+    for (auto& w : weights)
+    {
+        w /= sum;
+    }
+    return weights;
+}
+
+int TemporalRingProc::getSlot(int k) const
+{
+    const int j = std::min(k, std::max(count - 1, 0));
+    return (head - j + length) % length;
+}
+
+void TemporalRingProc::allocate()
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    const int frames = std::max(std::min(length, maxSize / std::max(inFrameH, 1)), 1);
+
+    if (!ring || (ring->width != static_cast<std::size_t>(inFrameW)) || (ring->height != static_cast<std::size_t>(inFrameH * frames)))
+    {
+        length = frames;
+        ring.reset(new GLTexture(inFrameW, inFrameH * length, GL_RGBA, nullptr));
+        count = 0;
+        head = -1;
+    }
+}
+
+void TemporalRingProc::push()
+{
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+    if (!readFbo)
+    {
+        glGenFramebuffers(1, &readFbo);
+    }
+
+    // Read from the input texture, write to the oldest slot:
+    head = (head + 1) % length;
+    glBindFramebuffer(GL_FRAMEBUFFER, readFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texId, 0);
+    glBindTexture(GL_TEXTURE_2D, ring->texId);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, head * inFrameH, 0, 0, inFrameW, inFrameH);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    Tools::checkGLErr(getProcName(), "push()");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+    count = std::min(count + 1, length);
+}
+
+int TemporalRingProc::render(int position)
+{
+    allocate();
+    push();
+
+    // The kernel samples the ring instead of the input:
+    const GLuint input = texId;
+    texId = ring->texId;
+    const int result = FilterProcBase::render(position);
+    texId = input;
+    return result;
+}
+
+void TemporalRingProc::getUniforms()
+{
+    FilterProcBase::getUniforms();
+    shParamUWeights = shader->getParam(UNIF, "weights");
+    shParamUOffsets = shader->getParam(UNIF, "offsets");
+    shParamUTaps = shader->getParam(UNIF, "taps");
+    shParamUScale = shader->getParam(UNIF, "scale");
+    shParamUBias = shader->getParam(UNIF, "bias");
+    shParamUHalfTexel = shader->getParam(UNIF, "halfTexel");
+}
+
+void TemporalRingProc::setUniforms()
+{
+    FilterProcBase::setUniforms();
+
+    const int taps = std::min(static_cast<int>(weights.size()), length);
+    float offsets[kMaxLength] = {};
+    for (int k = 0; k < taps; k++)
+    {
+        offsets[k] = static_cast<float>(getSlot(k)) / static_cast<float>(length);
+    }
+
+    glUniform1fv(shParamUWeights, taps, weights.data());
+    glUniform1fv(shParamUOffsets, taps, offsets);
+    glUniform1i(shParamUTaps, taps);
+    glUniform1f(shParamUScale, 1.f / static_cast<float>(length));
+    glUniform1f(shParamUBias, bias);
+    glUniform1f(shParamUHalfTexel, 0.5f / static_cast<float>(std::max(inFrameH, 1)));
+}
+
+// Frame coordinates are clamped to half a texel inside each slot, so bilinear
+// sampling never mixes in rows of the neighboring frames.
+
+// clang-format off
+const char * TemporalRingProc::fshaderTemporalRingSrc = 
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform sampler2D uInputTex;
+ uniform float weights[16];
+ uniform float offsets[16];
+ uniform int taps;
+ uniform float scale;
+ uniform float bias;
+ uniform float halfTexel;
+ void main()
+ {
+     float y = clamp(vTexCoord.y, halfTexel, 1.0 - halfTexel) * scale;
+     vec4 sum = vec4(0.0);
+     for (int k = 0; k < 16; k++)
+     {
+         if (k >= taps) break;
+         sum += texture2D(uInputTex, vec2(vTexCoord.x, y + offsets[k])) * weights[k];
+     }
+     gl_FragColor = vec4(clamp(sum.rgb + bias, 0.0, 1.0), 1.0);
+ });
+// clang-format on
+
+END_OGLES_GPGPU
@@ -0,0 +1,96 @@
+/*! -*-c++-*-
+  @file   temporal_ring.h
+  @author David Hirvonen (C++ implementation)
+  @brief Declaration of an ogles_gpgpu ring buffer of past frames with a temporal kernel.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#ifndef __drishti_graphics_temporal_ring_h__
+#define __drishti_graphics_temporal_ring_h__
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+
+#include "drishti/graphics/GLTexture.h"
+
+#include <memory>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+// Keep the last `length` input frames (length <= kMaxLength) in one atlas texture, with frames
+// stacked vertically, and output a temporal FIR over them in a single pass:
+//
+//   output = clamp(sum_k weights[k] * frame[k] + bias), frame[0] = newest
+//
+// Each render() copies the input into the oldest slot (glCopyTexSubImage2D, no extra pass),
+// so insertion is O(1) for any length, and the kernel reads the ring directly.  Until the
+// ring is full, taps past the oldest frame repeat the oldest frame.
+//
+// The atlas is a plain GL_TEXTURE_2D, so this works on GLES2 and GLES3.  Its height is
+// length * input height, so the length is clamped to fit in GL_MAX_TEXTURE_SIZE.
+class TemporalRingProc : public ogles_gpgpu::FilterProcBase
+{
+public:
+    static constexpr int kMaxLength = 16;
+
+    TemporalRingProc(int length);
+    ~TemporalRingProc() override;
+
+    const char* getProcName() override
+    {
+        return "TemporalRingProc";
+    }
+
+    // Weights in newest first order (extra taps are ignored):
+    void setKernel(const std::vector<float>& weights, float bias = 0.f);
+
+    // Common kernels:
+    static std::vector<float> mean(int length);
+    static std::vector<float> difference(int length); // newest - mean(rest), use bias 0.5
+    static std::vector<float> exponential(int length, float alpha);
+
+    int render(int position = 0) override;
+
+    // Ring access for readers of the raw history (e.g., flash analysis):
+    GLuint getRingTexId() const { return ring ? ring->texId : 0; }
+    int getLength() const { return length; }
+    int getCount() const { return count; }
+    int getSlot(int k) const; // atlas row (in frames) of frame k, 0 = newest
+
+private:
+    const char* getFragmentShaderSource() override
+    {
+        return fshaderTemporalRingSrc;
+    }
+    void getUniforms() override;
+    void setUniforms() override;
+
+    void allocate();
+    void push();
+
+    static const char* fshaderTemporalRingSrc; // fragment shader source
+
+    int length = 0;
+    int count = 0;
+    int head = -1; // slot of newest frame
+
+    std::vector<float> weights;
+    float bias = 0.f;
+
+    std::unique_ptr<GLTexture> ring;
+    GLuint readFbo = 0;
+
+    GLint shParamUWeights{};
+    GLint shParamUOffsets{};
+    GLint shParamUTaps{};
+    GLint shParamUScale{};
+    GLint shParamUBias{};
+    GLint shParamUHalfTexel{};
+};
+
+END_OGLES_GPGPU
+
+#endif // __drishti_graphics_temporal_ring_h__
@@ -0,0 +1,389 @@
+/*! -*-c++-*-
+  @file   AcfPyramidBuilder.cpp
+  @author David Hirvonen
+  @brief  Implementation of a multi-threaded CPU ACF pyramid builder.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/AcfPyramidBuilder.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+static void convTri(const cv::Mat1f& src, cv::Mat1f& dst, int r);
+static void gradient(const cv::Mat1f& I, cv::Mat1f& gx, cv::Mat1f& gy);
+
+AcfPyramidBuilder::AcfPyramidBuilder(const acf::Detector::Pyramid& layout, const Options& options)
+    : m_options(options)
+    , m_layout(layout)
+    , m_levels(layout.nScales)
+    , m_order(layout.nScales)
+    , m_cache(layout.nScales)
+    , m_dirty(layout.nScales)
+{
+    std::iota(m_order.begin(), m_order.end(), 0);
+    std::sort(m_order.begin(), m_order.end(), [&](int a, int b) {
+        return m_layout.data[a][0][0].size().area() > m_layout.data[b][0][0].size().area();
+    });
+}
+
+void AcfPyramidBuilder::operator()(const MatP& luv, acf::Detector::Pyramid& P, tp::ThreadPool<>* threads)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        const cv::Mat& plane = luv[i];
+        plane.convertTo(m_input[i], CV_32F, (plane.depth() == CV_8U) ? (1.0 / 255.0) : 1.0);
+    }
+
+    findChanges();
+
+    P = m_layout; // level sizes + scales (channel data is replaced below)
+
+    // Levels are claimed from a shared counter, largest first.  Helper jobs that start
+    // after all levels are claimed return without touching the pyramid.
+    struct State
+    {
+        std::atomic<int> next{ 0 };
+        int done = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+
+    const int count = static_cast<int>(m_order.size());
+    auto work = [this, state, count, &P]() {
+        for (int k = state->next++; k < count; k = state->next++)
+        {
+            update(m_order[k], P);
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->done == count)
+            {
+                state->cv.notify_one();
+            }
+        }
+    };
+
+    if (threads)
+    {
+        const int helpers = std::min(count, static_cast<int>(std::thread::hardware_concurrency())) - 1;
+        for (int i = 0; i < helpers; i++)
+        {
+            threads->process(work);
+        }
+    }
+
+    work(); // calling thread participates
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done == count; });
+}
+
+// Compare the input with the reference in blocks and select the channel tiles to recompute:
+void AcfPyramidBuilder::findChanges()
+{
+    const int block = m_options.changeBlock;
+    const cv::Size size = m_input[0].size();
+
+    m_changes = {};
+    if (block <= 0)
+    {
+        return;
+    }
+
+    const bool isFull = (m_reference[0].size() != size) || (++m_frames >= std::max(m_options.refreshPeriod, 1));
+    if (!isFull)
+    {
+        for (int y = 0; y < size.height; y += block)
+        {
+            for (int x = 0; x < size.width; x += block)
+            {
+                const cv::Rect roi = cv::Rect(x, y, block, block) & cv::Rect({ 0, 0 }, size);
+                double difference = 0.0;
+                for (int c = 0; c < 3; c++)
+                {
+                    difference += cv::norm(m_input[c](roi), m_reference[c](roi), cv::NORM_L1);
+                }
+                if (difference > (m_options.changeThreshold * 3.0 * roi.area()))
+                {
+                    m_changes.blocks.push_back(roi);
+                }
+            }
+        }
+
+        // Most of the frame changed (e.g., camera motion), a full update is cheaper:
+        const int count = ((size.width + block - 1) / block) * ((size.height + block - 1) / block);
+        m_changes.isFull = (m_changes.blocks.size() * 2) > static_cast<std::size_t>(count);
+    }
+
+    if (m_changes.isFull)
+    {
+        m_frames = 0;
+        m_changes.blocks.clear();
+        for (int c = 0; c < 3; c++)
+        {
+            m_input[c].copyTo(m_reference[c]);
+        }
+        return;
+    }
+
+    for (const auto& roi : m_changes.blocks)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            m_input[c](roi).copyTo(m_reference[c](roi));
+        }
+    }
+
+    // Cells within reach of a changed block, covered by tiles of about one block:
+    const int shrink = m_options.shrink;
+    const int halo = getHalo() + 1; // + resampling footprint
+    for (int i = 0; i < m_layout.nScales; i++)
+    {
+        m_dirty[i].clear();
+
+        const cv::Size cells = m_layout.data[i][0][0].size();
+        const double sx = static_cast<double>(cells.width * shrink) / size.width;
+        const double sy = static_cast<double>(cells.height * shrink) / size.height;
+
+        cv::Mat1b mask = cv::Mat1b::zeros(cells);
+        for (const auto& roi : m_changes.blocks)
+        {
+            const int x0 = static_cast<int>(std::floor(roi.x * sx / shrink)) - halo;
+            const int y0 = static_cast<int>(std::floor(roi.y * sy / shrink)) - halo;
+            const int x1 = static_cast<int>(std::ceil(roi.br().x * sx / shrink)) + halo;
+            const int y1 = static_cast<int>(std::ceil(roi.br().y * sy / shrink)) + halo;
+            mask(cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect({ 0, 0 }, cells)) = 255;
+        }
+
+        const int tile = std::max(static_cast<int>(block * sx / shrink + 0.5), 4);
+        for (int y = 0; y < cells.height; y += tile)
+        {
+            for (int x = 0; x < cells.width; x += tile)
+            {
+                const cv::Rect roi = cv::Rect(x, y, tile, tile) & cv::Rect({ 0, 0 }, cells);
+                if (cv::countNonZero(mask(roi)) > 0)
+                {
+                    m_dirty[i].push_back(roi);
+                }
+            }
+        }
+        m_changes.tiles += static_cast<int>(m_dirty[i].size());
+    }
+}
+
+// Channel cells depend on the input within the smoothing, gradient and normalization support:
+int AcfPyramidBuilder::getHalo() const
+{
+    const int shrink = m_options.shrink;
+    const int pixels = std::max(m_options.colorSmooth, 0) + 1 + std::max(m_options.normRadius, 0);
+    return (pixels + shrink - 1) / shrink + std::max(m_options.pyramidSmooth, 0);
+}
+
+void AcfPyramidBuilder::update(int index, acf::Detector::Pyramid& P)
+{
+    const bool isIncremental = (m_options.changeBlock > 0);
+    if (!isIncremental || m_changes.isFull || m_cache[index].get().empty())
+    {
+        MatP channels;
+        resample(index);
+        compute(index, { { 0, 0 }, m_layout.data[index][0][0].size() }, channels.get());
+        P.data[index][0] = channels;
+        if (isIncremental)
+        {
+            m_cache[index] = channels;
+        }
+        return;
+    }
+
+    if (m_dirty[index].empty())
+    {
+        P.data[index][0] = m_cache[index]; // shared, read only
+        return;
+    }
+
+    // Copy on write, earlier pyramids keep the cached planes:
+    MatP channels;
+    for (const auto& plane : m_cache[index].get())
+    {
+        channels.get().push_back(plane.clone());
+    }
+
+    // Each tile is recomputed with a halo, which is discarded:
+    resample(index);
+    const int halo = getHalo();
+    const cv::Rect bounds({ 0, 0 }, m_layout.data[index][0][0].size());
+    std::vector<cv::Mat> patch;
+    for (const auto& tile : m_dirty[index])
+    {
+        const cv::Rect roi = cv::Rect(tile.x - halo, tile.y - halo, tile.width + 2 * halo, tile.height + 2 * halo) & bounds;
+        compute(index, roi, patch);
+
+        const cv::Rect inner(tile.tl() - roi.tl(), tile.size());
+        for (std::size_t i = 0; i < patch.size(); i++)
+        {
+            patch[i](inner).copyTo(channels.get()[i](tile));
+        }
+    }
+
+    m_cache[index] = channels;
+    P.data[index][0] = channels;
+}
+
+// Full resolution LUV of one level:
+void AcfPyramidBuilder::resample(int index)
+{
+    const int shrink = m_options.shrink;
+    const cv::Size channelSize = m_layout.data[index][0][0].size();
+    const cv::Size size(channelSize.width * shrink, channelSize.height * shrink);
+
+    Level& level = m_levels[index];
+    for (int c = 0; c < 3; c++)
+    {
+        const int interpolation = (size.area() < m_input[c].size().area()) ? cv::INTER_AREA : cv::INTER_LINEAR;
+        cv::resize(m_input[c], level.luv[c], size, 0, 0, interpolation);
+    }
+}
+
+// Channels of a region of cells of one level (see resample()):
+void AcfPyramidBuilder::compute(int index, const cv::Rect& cells, std::vector<cv::Mat>& channels)
+{
+    const int shrink = m_options.shrink;
+    const int orientations = m_options.orientations;
+    const cv::Size channelSize = cells.size();
+    const cv::Size size(channelSize.width * shrink, channelSize.height * shrink);
+    const cv::Rect pixels(cells.x * shrink, cells.y * shrink, size.width, size.height);
+
+    Level& level = m_levels[index];
+
+    // (1) LUV: smooth, then keep the max gradient magnitude over color channels:
+    level.mag = cv::Mat1f::zeros(size);
+    level.ori = cv::Mat1f::zeros(size);
+    for (int c = 0; c < 3; c++)
+    {
+        // Regions are isolated (reflected borders), the halo of a tile absorbs the difference:
+        const cv::Mat1f luv = (pixels.size() == level.luv[c].size()) ? level.luv[c] : level.luv[c](pixels).clone();
+        convTri(luv, level.smooth[c], m_options.colorSmooth);
+        gradient(level.smooth[c], level.gx, level.gy);
+
+        for (int y = 0; y < size.height; y++)
+        {
+            const float* gx = level.gx[y];
+            const float* gy = level.gy[y];
+            float* mag = level.mag[y];
+            float* ori = level.ori[y];
+            for (int x = 0; x < size.width; x++)
+            {
+                const float m = std::sqrt(gx[x] * gx[x] + gy[x] * gy[x]);
+                if (m > mag[x])
+                {
+                    mag[x] = m;
+                    ori[x] = std::atan2(gy[x], gx[x]);
+                }
+            }
+        }
+    }
+
+    // (2) Gradient normalization: M / (S(M) + eps)
+    convTri(level.mag, level.norm, m_options.normRadius);
+    cv::divide(level.mag, level.norm + m_options.normConst, level.mag);
+
+    // (3) Hard binned orientation histograms (half circle) averaged over shrink x shrink cells:
+    std::vector<cv::Mat1f> hist(orientations);
+    for (auto& h : hist)
+    {
+        h = cv::Mat1f::zeros(channelSize);
+    }
+
+    const float cellNorm = 1.f / static_cast<float>(shrink * shrink);
+    const float binScale = static_cast<float>(orientations) / static_cast<float>(CV_PI);
+    for (int y = 0; y < size.height; y++)
+    {
+        const float* mag = level.mag[y];
+        const float* ori = level.ori[y];
+        for (int x = 0; x < size.width; x++)
+        {
+            const float o = (ori[x] < 0.f) ? (ori[x] + static_cast<float>(CV_PI)) : ori[x];
+            const int bin = std::min(static_cast<int>(o * binScale), orientations - 1);
+            hist[bin](y / shrink, x / shrink) += mag[x] * cellNorm;
+        }
+    }
+
+    // (4) Shrink color + magnitude (block average), then smooth all channels:
+    channels.resize(4 + orientations);
+    for (int c = 0; c < 3; c++)
+    {
+        cv::resize(level.smooth[c], channels[c], channelSize, 0, 0, cv::INTER_AREA);
+    }
+    cv::resize(level.mag, channels[3], channelSize, 0, 0, cv::INTER_AREA);
+    for (int i = 0; i < orientations; i++)
+    {
+        channels[4 + i] = hist[i];
+    }
+
+    for (auto& channel : channels)
+    {
+        cv::Mat1f smoothed;
+        convTri(channel, smoothed, m_options.pyramidSmooth);
+        channel = smoothed;
+    }
+}
+
+// Triangle filter of integer radius r (r == 1 => [1 2 1] / 4) with symmetric borders:
+static void convTri(const cv::Mat1f& src, cv::Mat1f& dst, int r)
+{
+    if (r <= 0)
+    {
+        if (dst.data != src.data)
+        {
+            src.copyTo(dst);
+        }
+        return;
+    }
+
+    cv::Mat1f kernel(1, 2 * r + 1);
+    for (int i = 0; i <= r; i++)
+    {
+        kernel(0, i) = kernel(0, 2 * r - i) = static_cast<float>(i + 1);
+    }
+    kernel *= 1.f / static_cast<float>((r + 1) * (r + 1));
+
+    cv::sepFilter2D(src, dst, CV_32F, kernel, kernel, { -1, -1 }, 0.0, cv::BORDER_REFLECT);
+}
+
+// Central differences (forward/backward differences along the border):
+static void gradient(const cv::Mat1f& I, cv::Mat1f& gx, cv::Mat1f& gy)
+{
+    gx.create(I.size());
+    gy.create(I.size());
+
+    const int w = I.cols, h = I.rows;
+    for (int y = 0; y < h; y++)
+    {
+        const int y0 = std::max(y - 1, 0), y1 = std::min(y + 1, h - 1);
+        const float sy = (y1 - y0) ? (1.f / static_cast<float>(y1 - y0)) : 0.f;
+        const float *row = I[y], *up = I[y0], *dn = I[y1];
+        float *dx = gx[y], *dy = gy[y];
+        for (int x = 0; x < w; x++)
+        {
+            const int x0 = std::max(x - 1, 0), x1 = std::min(x + 1, w - 1);
+            dx[x] = (x1 - x0) ? ((row[x1] - row[x0]) / static_cast<float>(x1 - x0)) : 0.f;
+            dy[x] = (dn[x] - up[x]) * sy;
+        }
+    }
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,103 @@
+/*! -*-c++-*-
+  @file   AcfPyramidBuilder.h
+  @author David Hirvonen
+  @brief  Declaration of a multi-threaded CPU ACF pyramid builder.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Computes the aggregate channel features (LUV, normalized gradient magnitude and
+  orientation histograms) for every level of a pyramid layout from a planar LUV image.
+  Levels are claimed largest first by the calling thread and by helper jobs posted to a
+  shared thread pool, so idle workers pick up the remaining levels as they free up.
+
+  Incremental mode (static cameras, Options::changeBlock > 0): the input is compared with
+  the input of the last update in blocks, and only the channel tiles within reach of the
+  changed blocks (the filter support) are recomputed, the other cells are copied from the
+  previous pyramid.  Tiles are recomputed with a halo, so they match a full update exactly,
+  and a full update every refreshPeriod frames bounds the drift of blocks that change
+  below the threshold.  Earlier pyramids are never modified (copy on write).
+
+*/
+
+#ifndef __drishti_hci_AcfPyramidBuilder_h__
+#define __drishti_hci_AcfPyramidBuilder_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <acf/ACF.h>                   // drishti::acf::Detector+Pyramid
+#include "thread_pool/thread_pool.hpp" // tp::ThreadPool<>
+
+#include <opencv2/core/core.hpp>
+
+#include <array>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class AcfPyramidBuilder
+{
+public:
+    // ACF channel parameters (Dollar et al. defaults):
+    struct Options
+    {
+        int shrink = 4;
+        int orientations = 6;
+        int colorSmooth = 1;      // convTri() radius for LUV
+        int normRadius = 5;       // convTri() radius for gradient normalization
+        float normConst = 0.005f; // gradient normalization constant
+        int pyramidSmooth = 1;    // convTri() radius for the shrunk channels
+
+        int changeBlock = 0;           // input pixels per change block (0 == full updates only)
+        float changeThreshold = 0.02f; // mean absolute LUV difference of a changed block
+        int refreshPeriod = 30;        // frames between full updates (incremental mode)
+    };
+
+    // Input blocks (layout orientation) that changed in the last call:
+    struct Changes
+    {
+        bool isFull = true;           // every level was recomputed (first frame, refresh, ...)
+        std::vector<cv::Rect> blocks; // changed blocks (partial update)
+        int tiles = 0;                // recomputed channel tiles over all levels (partial update)
+    };
+
+    // The layout provides level sizes and scales in storage (possibly transposed) order:
+    AcfPyramidBuilder(const acf::Detector::Pyramid& layout, const Options& options);
+
+    // Compute all levels from planar LUV input in layout orientation (CV_8U or CV_32F):
+    void operator()(const MatP& luv, acf::Detector::Pyramid& P, tp::ThreadPool<>* threads = nullptr);
+
+    const Options& getOptions() const { return m_options; }
+    const Changes& getChanges() const { return m_changes; }
+
+protected:
+    // Per level scratch buffers, reused across frames:
+    struct Level
+    {
+        std::array<cv::Mat1f, 3> luv, smooth;
+        cv::Mat1f gx, gy, mag, ori, norm;
+    };
+
+    void update(int index, acf::Detector::Pyramid& P);
+    void resample(int index);
+    void compute(int index, const cv::Rect& cells, std::vector<cv::Mat>& channels);
+    void findChanges();
+    int getHalo() const; // filter support in cells
+
+    Options m_options;
+    acf::Detector::Pyramid m_layout;
+    std::array<cv::Mat1f, 3> m_input;
+    std::vector<Level> m_levels;
+    std::vector<int> m_order; // largest level first
+
+    // Incremental mode:
+    Changes m_changes;
+    std::array<cv::Mat1f, 3> m_reference;     // input of the last update of each block
+    std::vector<MatP> m_cache;                // channels of the last update (read only)
+    std::vector<std::vector<cv::Rect>> m_dirty; // per level channel tiles to recompute
+    int m_frames = 0;                         // since the last full update
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_AcfPyramidBuilder_h__
@@ -0,0 +1,129 @@
+/*! -*-c++-*-
+  @file   BlobFilterCpu.cpp
+  @author David Hirvonen
+  @brief  Implementation of a CPU blob filter (eye reflections) for the headless engine.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/BlobFilterCpu.h"
+#include "drishti/core/hessian.h"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+// Source pixels around a region: 2 for the 5 tap smoothing, 1 for the Hessian and 1 for the NMS:
+static const int kBorder = 4;
+
+BlobFilterCpu::BlobFilterCpu(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+const cv::Mat4b& BlobFilterCpu::operator()(const cv::Mat1b& gray, const std::vector<cv::Rect>& rois)
+{
+    const int cell = std::max(m_settings.cellSize, 1);
+    m_peaks.create((gray.rows + cell - 1) / cell, (gray.cols + cell - 1) / cell);
+    m_peaks.setTo(cv::Scalar::all(0));
+
+    for (const auto& roi : rois)
+    {
+        filter(gray, roi);
+    }
+    return m_peaks;
+}
+
+void BlobFilterCpu::filter(const cv::Mat1b& gray, const cv::Rect& roi)
+{
+    const int cell = std::max(m_settings.cellSize, 1);
+
+    // Align the region to the peak cells:
+    const cv::Rect clipped = roi & cv::Rect({ 0, 0 }, gray.size());
+    if (clipped.area() <= 0)
+    {
+        return;
+    }
+    const int x0 = (clipped.x / cell) * cell, y0 = (clipped.y / cell) * cell;
+    const int x1 = std::min(((clipped.br().x + cell - 1) / cell) * cell, gray.cols);
+    const int y1 = std::min(((clipped.br().y + cell - 1) / cell) * cell, gray.rows);
+    const int width = x1 - x0, height = y1 - y0;
+
+    // Source region with a replicated border at the image edges:
+    const cv::Rect outer(x0 - kBorder, y0 - kBorder, width + 2 * kBorder, height + 2 * kBorder);
+    const cv::Rect inner = outer & cv::Rect({ 0, 0 }, gray.size());
+    cv::copyMakeBorder(gray(inner), m_padded, inner.y - outer.y, outer.br().y - inner.br().y, inner.x - outer.x, outer.br().x - inner.br().x, cv::BORDER_REPLICATE);
+
+    // Smoothed rows cover the response (with its NMS border) plus the Hessian border:
+    const int smoothWidth = width + 4;
+    m_vertical.create(1, m_padded.cols);
+    m_smooth.create(3, smoothWidth);
+    m_response.create(height + 2, width + 2);
+
+    const float norm = 1.f / (256.f * 255.f); // binomial [1 4 6 4 1]^2 and 8 bit -> [0,1]
+    auto smoothRow = [&](int j, float* dst) {
+        const uint8_t* p0 = m_padded.ptr<uint8_t>(j);
+        const uint8_t* p1 = m_padded.ptr<uint8_t>(j + 1);
+        const uint8_t* p2 = m_padded.ptr<uint8_t>(j + 2);
+        const uint8_t* p3 = m_padded.ptr<uint8_t>(j + 3);
+        const uint8_t* p4 = m_padded.ptr<uint8_t>(j + 4);
+        float* v = m_vertical.ptr<float>();
+        for (int k = 0; k < m_padded.cols; k++)
+        {
+            v[k] = static_cast<float>(p0[k] + 4 * (p1[k] + p3[k]) + 6 * p2[k] + p4[k]);
+        }
+        for (int k = 0; k < smoothWidth; k++)
+        {
+            dst[k] = (v[k] + 4.f * (v[k + 1] + v[k + 3]) + 6.f * v[k + 2] + v[k + 4]) * norm;
+        }
+    };
+
+    // Rolling window of three smoothed rows, one response row per smoothed row:
+    const float scale = m_settings.strength * 255.f;
+    smoothRow(0, m_smooth.ptr<float>(0));
+    smoothRow(1, m_smooth.ptr<float>(1));
+    for (int r = 0; r < m_response.rows; r++)
+    {
+        smoothRow(r + 2, m_smooth.ptr<float>((r + 2) % 3));
+        const float* s0 = m_smooth.ptr<float>(r % 3) + 1;
+        const float* s1 = m_smooth.ptr<float>((r + 1) % 3) + 1;
+        const float* s2 = m_smooth.ptr<float>((r + 2) % 3) + 1;
+        drishti::core::hessianBlob32f(s0, s1, s2, m_response.ptr<uint8_t>(r), m_response.cols, scale);
+    }
+
+    // 3x3 non-maximum suppression and the strongest peak per cell:
+    for (int cy = y0 / cell; cy < (y1 + cell - 1) / cell; cy++)
+    {
+        for (int cx = x0 / cell; cx < (x1 + cell - 1) / cell; cx++)
+        {
+            cv::Vec4b best(0, 0, 0, 0);
+            for (int y = cy * cell; y < std::min((cy + 1) * cell, y1); y++)
+            {
+                const uint8_t* above = m_response.ptr<uint8_t>(y - y0);
+                const uint8_t* row = m_response.ptr<uint8_t>(y - y0 + 1);
+                const uint8_t* below = m_response.ptr<uint8_t>(y - y0 + 2);
+                for (int x = cx * cell; x < std::min((cx + 1) * cell, x1); x++)
+                {
+                    const int k = x - x0 + 1;
+                    const uint8_t value = row[k];
+                    if ((value > best[3]) &&
+                        (value >= above[k - 1]) && (value >= above[k]) && (value >= above[k + 1]) &&
+                        (value >= row[k - 1]) && (value >= row[k + 1]) &&
+                        (value >= below[k - 1]) && (value >= below[k]) && (value >= below[k + 1]))
+                    {
+                        // Offsets are encoded as (i + 0.5) / cellSize:
+                        const auto encode = [cell](int i) { return cv::saturate_cast<uint8_t>((i + 0.5f) * 255.f / cell); };
+                        best = cv::Vec4b(encode(x - cx * cell), encode(y - cy * cell), 0, value);
+                    }
+                }
+            }
+            m_peaks(cy, cx) = best;
+        }
+    }
+}
+
+DRISHTI_HCI_NAMESPACE_END
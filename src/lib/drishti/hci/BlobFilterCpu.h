@@ -0,0 +1,61 @@
+/*! -*-c++-*-
+  @file   BlobFilterCpu.h
+  @author David Hirvonen
+  @brief  Declaration of a CPU blob filter (eye reflections) for the headless engine.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  CPU counterpart of ogles_gpgpu::BlobFilter: Gaussian smoothing, Hessian determinant
+  (see core::hessianBlob32f()), 3x3 non-maximum suppression and peak compaction, with the
+  same 8 bit limits and the same compact peak encoding, so the output is decoded with
+  EyeBlobJob::run(peaks, cellSize).  Only the regions of interest (e.g., the eyes) are
+  evaluated, row by row with a rolling window of smoothed rows, so the working set of a
+  region stays in cache.
+
+*/
+
+#ifndef __drishti_hci_BlobFilterCpu_h__
+#define __drishti_hci_BlobFilterCpu_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class BlobFilterCpu
+{
+public:
+    struct Settings
+    {
+        float strength = 2000.f; // Hessian gain (see ogles_gpgpu::HessianProc)
+        int cellSize = 4;        // one peak per cell (see ogles_gpgpu::PeakCompactionProc)
+    };
+
+    BlobFilterCpu() = default;
+    explicit BlobFilterCpu(const Settings& settings);
+
+    // Strongest peak per cell in { dx, dy, 0, strength } format (cells outside of the regions
+    // are empty), valid until the next call:
+    const cv::Mat4b& operator()(const cv::Mat1b& gray, const std::vector<cv::Rect>& rois);
+
+    int getCellSize() const { return m_settings.cellSize; }
+
+protected:
+    void filter(const cv::Mat1b& gray, const cv::Rect& roi);
+
+    Settings m_settings;
+
+    cv::Mat4b m_peaks;
+    cv::Mat1b m_padded;   // region with a replicated border
+    cv::Mat1f m_vertical; // vertically smoothed row
+    cv::Mat1f m_smooth;   // rolling window of smoothed rows (with a 1 pixel border)
+    cv::Mat1b m_response; // region response (with a 1 pixel border)
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_BlobFilterCpu_h__
@@ -0,0 +1,154 @@
+/*! -*-c++-*-
+  @file   DetectionScheduler.cpp
+  @author David Hirvonen
+  @brief  Implementation of a content adaptive ACF detection scheduler.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/DetectionScheduler.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+DetectionScheduler::DetectionScheduler(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+DetectionScheduler::Reason DetectionScheduler::operator()(double elapsed, double interval, double floor, bool hasDetection)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Reason reason = kNone;
+    if (!hasDetection)
+    {
+        reason = kInitial;
+    }
+    else if (elapsed > std::max(interval * ((m_tracks > 0) ? m_settings.maxScale : 1.0), floor))
+    {
+        reason = kInterval;
+    }
+    else if (elapsed > std::max(interval * m_settings.minScale, floor))
+    {
+        if (m_trackLoss)
+        {
+            reason = kTrackLoss;
+        }
+        else if (m_unstable)
+        {
+            reason = kUnstable;
+        }
+        else if (m_motion > m_settings.motionThreshold)
+        {
+            reason = kMotion;
+        }
+    }
+
+    m_stats.frames++;
+    m_stats.reasons[reason]++;
+    if (reason != kNone)
+    {
+        m_motion = 0.f;
+        m_trackLoss = m_unstable = false;
+    }
+    return reason;
+}
+
+void DetectionScheduler::update(const cv::Mat& image, const std::vector<face::FaceModel>& faces, bool isDetection)
+{
+    // Motion energy (empty for landmark tiles, which don't cover the scene):
+    cv::Mat1f thumbnail;
+    if (!image.empty() && (image.channels() == 1))
+    {
+        const int width = std::min(m_settings.thumbnailWidth, image.cols);
+        const int height = std::max(1, (image.rows * width) / image.cols);
+        cv::Mat small;
+        cv::resize(image, small, { width, height }, 0, 0, cv::INTER_AREA);
+        small.convertTo(thumbnail, CV_32F, (image.depth() == CV_8U) ? (1.0 / 255.0) : 1.0);
+    }
+
+    std::vector<std::pair<cv::Point2f, float>> current;
+    for (const auto& f : faces)
+    {
+        if (f.eyeLeftCenter.has && f.eyeRightCenter.has)
+        {
+            current.emplace_back((*f.eyeLeftCenter + *f.eyeRightCenter) * 0.5f, f.getInterPupillaryDistance());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!thumbnail.empty())
+    {
+        if (m_thumbnail.size() == thumbnail.size())
+        {
+            m_motion = std::max(m_motion, static_cast<float>(cv::norm(thumbnail, m_thumbnail, cv::NORM_L1) / thumbnail.total()));
+        }
+        m_thumbnail = thumbnail;
+    }
+
+    // Tracks are only lost between detections (detection frames may change the count freely):
+    const int tracks = static_cast<int>(faces.size());
+    m_trackLoss |= (!isDetection && (tracks < m_tracks));
+    m_tracks = tracks;
+
+    // Match faces to the previous frame by eye midpoint (faces are sorted by depth):
+    for (const auto& c : current)
+    {
+        for (const auto& p : m_faces)
+        {
+            if ((cv::norm(c.first - p.first) < p.second) && (p.second > 0.f))
+            {
+                m_unstable |= (std::abs(c.second - p.second) > (m_settings.maxScaleChange * p.second));
+                break;
+            }
+        }
+    }
+    m_faces = current;
+}
+
+void DetectionScheduler::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_thumbnail.release();
+    m_motion = 0.f;
+    m_tracks = 0;
+    m_trackLoss = m_unstable = false;
+    m_faces.clear();
+    m_stats = {};
+}
+
+DetectionScheduler::Stats DetectionScheduler::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+const char* DetectionScheduler::getName(Reason reason)
+{
+    switch (reason)
+    {
+        case kNone:
+            return "none";
+        case kInitial:
+            return "initial";
+        case kInterval:
+            return "interval";
+        case kMotion:
+            return "motion";
+        case kTrackLoss:
+            return "track_loss";
+        case kUnstable:
+            return "unstable";
+        default:
+            return "unknown";
+    }
+}
+
+DRISHTI_HCI_NAMESPACE_END
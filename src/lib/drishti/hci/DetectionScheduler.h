@@ -0,0 +1,98 @@
+/*! -*-c++-*-
+  @file   DetectionScheduler.h
+  @author David Hirvonen
+  @brief  Declaration of a content adaptive ACF detection scheduler.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A fixed detection interval runs the full ACF detection in static scenes with stable tracks,
+  and a new face waits for up to one interval before it is acquired.  The scheduler replaces
+  the interval test with cheap signals from the scene job (see update()):
+
+    kMotion    : mean absolute difference of a small thumbnail of the regression image
+    kTrackLoss : fewer tracked faces than after the previous frame
+    kUnstable  : a tracked face changed scale abruptly (regression drift)
+
+  Triggered detections are spaced by at least minScale * interval, and detection runs every
+  maxScale * interval with stable tracks (every interval when there are none).  Decisions
+  are counted per reason (see getStats()).
+
+*/
+
+#ifndef __drishti_hci_DetectionScheduler_h__
+#define __drishti_hci_DetectionScheduler_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/face/Face.h"
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class DetectionScheduler
+{
+public:
+    enum Reason
+    {
+        kNone,      // no detection
+        kInitial,   // first frame
+        kInterval,  // maximum interval elapsed
+        kMotion,    // scene motion energy
+        kTrackLoss, // tracked face count dropped
+        kUnstable,  // abrupt face scale change
+        kReasonCount
+    };
+
+    struct Settings
+    {
+        float minScale = 0.25f;        // triggered detections: at most every minScale * interval
+        float maxScale = 2.f;          // stable tracks: at least every maxScale * interval
+        float motionThreshold = 0.03f; // mean absolute thumbnail difference (intensity in [0,1])
+        float maxScaleChange = 0.15f;  // relative inter-pupillary distance change per frame
+        int thumbnailWidth = 32;
+    };
+
+    // Decisions since construction (or reset()):
+    struct Stats
+    {
+        std::size_t frames = 0;
+        std::array<std::size_t, kReasonCount> reasons{ {} };
+    };
+
+    DetectionScheduler() = default;
+    explicit DetectionScheduler(const Settings& settings);
+
+    // Decision for a new frame, elapsed is the time since the last detection and floor is a hard
+    // lower bound on the spacing (e.g., the power policy interval), all in seconds:
+    Reason operator()(double elapsed, double interval, double floor = 0.0, bool hasDetection = true);
+
+    // Signals from the latest scene job (regression image and final faces):
+    void update(const cv::Mat& image, const std::vector<face::FaceModel>& faces, bool isDetection);
+
+    void reset();
+    Stats getStats() const;
+    const Settings& getSettings() const { return m_settings; }
+
+    static const char* getName(Reason reason);
+
+protected:
+    Settings m_settings;
+
+    mutable std::mutex m_mutex;
+    cv::Mat1f m_thumbnail;
+    float m_motion = 0.f; // max since the last detection
+    int m_tracks = 0;
+    bool m_trackLoss = false;
+    bool m_unstable = false;
+    std::vector<std::pair<cv::Point2f, float>> m_faces; // (center, inter-pupillary distance)
+    Stats m_stats;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_DetectionScheduler_h__
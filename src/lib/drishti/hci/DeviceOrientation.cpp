@@ -0,0 +1,61 @@
+/*! -*-c++-*-
+  @file   DeviceOrientation.cpp
+  @author David Hirvonen
+  @brief  Implementation of a gravity based upright frame orientation filter.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/DeviceOrientation.h"
+
+#include <algorithm>
+#include <cmath>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+static int modulo(int a, int b)
+{
+    return ((a % b) + b) % b;
+}
+
+DeviceOrientation::DeviceOrientation(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+int DeviceOrientation::operator()(const cv::Vec3f& gravity)
+{
+    const float planar = std::sqrt(gravity[0] * gravity[0] + gravity[1] * gravity[1]);
+    const float total = static_cast<float>(cv::norm(gravity));
+    if ((total > 0.f) && (planar >= (m_settings.minTilt * total)))
+    {
+        // Upright: gravity points along -y, rotating the device counter clockwise turns it toward -x:
+        const float theta = std::atan2(-gravity[0], -gravity[1]) * static_cast<float>(180.0 / CV_PI);
+        const int rotation = modulo(static_cast<int>(std::round(theta / 90.f)) * 90, 360);
+
+        float delta = std::fmod(std::abs(theta - static_cast<float>(m_rotation)), 360.f);
+        delta = std::min(delta, 360.f - delta);
+        if (!m_hasRotation || (delta > (45.f + m_settings.hysteresis)))
+        {
+            m_rotation = rotation;
+            m_hasRotation = true;
+        }
+    }
+
+    return getOrientation();
+}
+
+int DeviceOrientation::getOrientation() const
+{
+    return modulo(m_settings.sensorOrientation + m_settings.direction * m_rotation, 360);
+}
+
+void DeviceOrientation::reset()
+{
+    m_rotation = 0;
+    m_hasRotation = false;
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,58 @@
+/*! -*-c++-*-
+  @file   DeviceOrientation.h
+  @author David Hirvonen
+  @brief  Declaration of a gravity based upright frame orientation filter.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Maps accelerometer gravity samples (device coordinates: x right, y up, z out of the
+  screen, as reported by CoreMotion and Android sensors) to the rotation that makes camera
+  frames upright, i.e., FaceFinder::Settings::outputOrientation.  The device rotation is
+  quantized to 90 degrees with hysteresis around the diagonals, and samples from a device
+  lying flat (little in-plane gravity) keep the last orientation.
+
+*/
+
+#ifndef __drishti_hci_DeviceOrientation_h__
+#define __drishti_hci_DeviceOrientation_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <opencv2/core.hpp>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class DeviceOrientation
+{
+public:
+    struct Settings
+    {
+        int sensorOrientation = 0; // outputOrientation for an upright (portrait) device
+        int direction = 1;         // +1 or -1: sign of the device rotation in the frame (camera mounting)
+        float hysteresis = 15.f;   // degrees past a diagonal before the orientation changes
+        float minTilt = 0.5f;      // minimum in-plane fraction of gravity
+    };
+
+    DeviceOrientation() = default;
+    explicit DeviceOrientation(const Settings& settings);
+
+    // Returns the upright frame rotation in degrees (0, 90, 180 or 270):
+    int operator()(const cv::Vec3f& gravity);
+
+    int getOrientation() const;
+
+    // Counter clockwise device rotation in degrees (0 == portrait):
+    int getRotation() const { return m_rotation; }
+
+    void reset();
+
+protected:
+    Settings m_settings;
+    int m_rotation = 0;
+    bool m_hasRotation = false;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_DeviceOrientation_h__
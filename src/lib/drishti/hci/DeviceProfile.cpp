@@ -0,0 +1,310 @@
+/*! -*-c++-*-
+  @file   DeviceProfile.cpp
+  @author David Hirvonen
+  @brief  Implementation of device tier model and pipeline profiles with first launch autotuning.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/DeviceProfile.h"
+#include "drishti/ml/ShapeEstimator.h"
+
+#include <nlohmann/json.hpp> // nlohman-json
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+using HighResolutionClock = std::chrono::high_resolution_clock;
+
+static double median(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return -1.0;
+    }
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+static double elapsed(const HighResolutionClock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(HighResolutionClock::now() - start).count();
+}
+
+// A measurement within the limit (unmeasured values and unset limits always pass):
+static bool within(double value, double limit)
+{
+    return (limit < 0.0) || (value < 0.0) || (value <= limit);
+}
+
+static void read(const nlohmann::json& json, DeviceProfile::Measurements& measurements)
+{
+    measurements.gpuAcf = json.value("gpu_acf", -1.0);
+    measurements.cpuAcf = json.value("cpu_acf", -1.0);
+    measurements.readback = json.value("readback", -1.0);
+    measurements.regression = json.value("regression", -1.0);
+}
+
+static nlohmann::json write(const DeviceProfile::Measurements& measurements)
+{
+    return {
+        { "gpu_acf", measurements.gpuAcf },
+        { "cpu_acf", measurements.cpuAcf },
+        { "readback", measurements.readback },
+        { "regression", measurements.regression }
+    };
+}
+
+void DeviceProfile::Profile::apply(FaceFinder::Settings& settings) const
+{
+    settings.doOptimizedPipeline = doOptimizedPipeline;
+    settings.faceFinderInterval = faceFinderInterval;
+    settings.doGpuRegression = doGpuRegression;
+    settings.faceStagesHint = faceStagesHint;
+    settings.eyelidStagesHint = eyelidStagesHint;
+    settings.irisStagesHint = irisStagesHint;
+    settings.eyelidInits = eyelidInits;
+    settings.irisInits = irisInits;
+    if (threads > 0)
+    {
+        tp::ThreadPoolOptions options;
+        options.setThreadCount(static_cast<std::size_t>(threads));
+        settings.threads = std::make_shared<tp::ThreadPool<>>(options);
+    }
+}
+
+DeviceProfile::Table DeviceProfile::load(std::istream& is)
+{
+    nlohmann::json json;
+    is >> json;
+
+    Table table;
+    for (const auto& row : json.at("profiles"))
+    {
+        Profile profile;
+        profile.name = row.at("name").get<std::string>();
+        profile.variant = row.value("variant", std::string());
+        if (row.count("limits"))
+        {
+            read(row["limits"], profile.limits);
+        }
+        profile.doOptimizedPipeline = row.value("optimized_pipeline", profile.doOptimizedPipeline);
+        if (row.count("cpu_acf"))
+        {
+            profile.doCpuAcf = row["cpu_acf"].get<bool>();
+            profile.autoAcf = false;
+        }
+        profile.doGpuRegression = row.value("gpu_regression", profile.doGpuRegression);
+        profile.faceFinderInterval = row.value("interval", profile.faceFinderInterval);
+        profile.threads = row.value("threads", profile.threads);
+        profile.faceStagesHint = row.value("face_stages", profile.faceStagesHint);
+        profile.eyelidStagesHint = row.value("eyelid_stages", profile.eyelidStagesHint);
+        profile.irisStagesHint = row.value("iris_stages", profile.irisStagesHint);
+        profile.eyelidInits = row.value("eyelid_inits", profile.eyelidInits);
+        profile.irisInits = row.value("iris_inits", profile.irisInits);
+        table.push_back(profile);
+    }
+
+    if (table.empty())
+    {
+        throw std::runtime_error("DeviceProfile::load() the profile table is empty");
+    }
+    return table;
+}
+
+DeviceProfile::Table DeviceProfile::load(const std::string& filename)
+{
+    std::ifstream is(filename);
+    if (!is)
+    {
+        throw std::runtime_error("DeviceProfile::load() failed to open " + filename);
+    }
+    return load(is);
+}
+
+DeviceProfile::Profile DeviceProfile::select(const Table& table, const Measurements& measurements)
+{
+    if (table.empty())
+    {
+        throw std::runtime_error("DeviceProfile::select() the profile table is empty");
+    }
+
+    // The CPU pyramid is only supported by the simple (synchronous) pipeline:
+    const bool cpuIsFaster = (measurements.cpuAcf >= 0.0) && (measurements.gpuAcf >= 0.0) && (measurements.cpuAcf < measurements.gpuAcf);
+    auto resolve = [&](const Profile& row) {
+        Profile profile = row;
+        if (profile.autoAcf)
+        {
+            profile.doCpuAcf = cpuIsFaster && !profile.doOptimizedPipeline;
+        }
+        return profile;
+    };
+
+    for (const auto& row : table)
+    {
+        const Profile profile = resolve(row);
+        const double frame = profile.doCpuAcf ? measurements.cpuAcf : measurements.gpuAcf;
+        const auto& limits = profile.limits;
+        if (within(frame, profile.doCpuAcf ? limits.cpuAcf : limits.gpuAcf) &&
+            within(measurements.readback, limits.readback) &&
+            within(measurements.regression, limits.regression))
+        {
+            return profile;
+        }
+    }
+
+    return resolve(table.back());
+}
+
+DeviceProfile::Measurements DeviceProfile::measure(
+    FaceFinder::FaceDetectorFactoryPtr& factory,
+    const FaceFinder::Settings& settings,
+    const FaceFinder::FrameInput& frame,
+    void* glContext,
+    int frames)
+{
+    Measurements measurements;
+    frames = std::max(frames, 1);
+
+    // Synchronous pipeline with detection on every frame, so each call measures one full frame:
+    FaceFinder::Settings config = settings;
+    config.doOptimizedPipeline = false;
+    config.faceFinderInterval = 0.f;
+    config.recorder.reset();
+    config.budget = {};
+
+    for (const bool doCpuAcf : { false, true })
+    {
+        auto finder = FaceFinder::create(factory, config, glContext);
+        finder->setDoCpuAcf(doCpuAcf);
+        for (int i = 0; i < 2; i++)
+        {
+            (*finder)(frame); // model loading, first use allocations and shader compilation
+        }
+
+        std::vector<double> times;
+        for (int i = 0; i < frames; i++)
+        {
+            const auto start = HighResolutionClock::now();
+            (*finder)(frame);
+            times.push_back(elapsed(start));
+        }
+
+        if (doCpuAcf)
+        {
+            measurements.cpuAcf = median(times);
+        }
+        else
+        {
+            measurements.gpuAcf = median(times);
+            const double readback = finder->getStageTracer().p50(FaceFinder::kAcfRead);
+            measurements.readback = (readback > 0.0) ? (readback * 1000.0) : -1.0;
+        }
+    }
+
+    // The benchmark frame may not contain a face, so the regression is timed on its own:
+    if (auto estimator = factory->getFaceEstimator())
+    {
+        cv::Mat1b crop(128, 128);
+        cv::randu(crop, 0, 255);
+
+        drishti::ml::ShapeEstimator::Point2fVec points;
+        drishti::ml::ShapeEstimator::BoolVec mask;
+        (*estimator)(crop, points, mask);
+
+        std::vector<double> times;
+        for (int i = 0; i < frames; i++)
+        {
+            const auto start = HighResolutionClock::now();
+            (*estimator)(crop, points, mask);
+            times.push_back(elapsed(start));
+        }
+        measurements.regression = median(times);
+    }
+
+    return measurements;
+}
+
+std::string DeviceProfile::getDeviceKey()
+{
+    auto getString = [](GLenum name) -> std::string {
+        const auto* str = reinterpret_cast<const char*>(glGetString(name));
+        return str ? str : "";
+    };
+
+    std::stringstream ss;
+    ss << getString(GL_VENDOR) << ";" << getString(GL_RENDERER) << ";" << getString(GL_VERSION) << ";" << std::thread::hardware_concurrency();
+    return ss.str();
+}
+
+bool DeviceProfile::loadMeasurements(const std::string& filename, const std::string& device, Measurements& measurements)
+{
+    std::ifstream is(filename);
+    if (!is)
+    {
+        return false;
+    }
+
+    try
+    {
+        nlohmann::json json;
+        is >> json;
+        if (json.value("device", std::string()) != device)
+        {
+            return false; // e.g., a restored backup from another device
+        }
+        read(json.at("measurements"), measurements);
+    }
+    catch (const std::exception&)
+    {
+        return false; // corrupt cache, measure again
+    }
+    return true;
+}
+
+bool DeviceProfile::saveMeasurements(const std::string& filename, const std::string& device, const Measurements& measurements)
+{
+    const nlohmann::json json = {
+        { "device", device },
+        { "measurements", write(measurements) }
+    };
+
+    std::ofstream os(filename);
+    os << json.dump(2);
+    return static_cast<bool>(os);
+}
+
+DeviceProfile::Profile DeviceProfile::autotune(
+    const Table& table,
+    const std::string& cache,
+    FaceFinder::FaceDetectorFactoryPtr& factory,
+    const FaceFinder::Settings& settings,
+    const FaceFinder::FrameInput& frame,
+    void* glContext)
+{
+    const std::string device = getDeviceKey();
+
+    Measurements measurements;
+    if (cache.empty() || !loadMeasurements(cache, device, measurements))
+    {
+        measurements = measure(factory, settings, frame, glContext);
+        if (!cache.empty())
+        {
+            saveMeasurements(cache, device, measurements);
+        }
+    }
+
+    return select(table, measurements);
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,114 @@
+/*! -*-c++-*-
+  @file   DeviceProfile.h
+  @author David Hirvonen
+  @brief  Declaration of device tier model and pipeline profiles with first launch autotuning.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Frame times differ by 5x across devices, so a single set of defaults is either too slow
+  on low end devices or wasteful on high end ones.  A short micro-benchmark (GPU ACF vs CPU
+  ACF frame time, the ACF channel readback and one landmark regression) runs on the first
+  launch, the measurements are cached per device, and a JSON profile table maps them to a
+  model variant (see FaceDetectorFactoryJson) and FaceFinder settings:
+
+  {
+    "profiles" : [
+      { "name" : "high", "variant" : "full", "limits" : { "gpu_acf" : 12, "regression" : 3 } },
+      { "name" : "mid", "variant" : "pruned", "limits" : { "gpu_acf" : 25 }, "interval" : 0.1, "face_stages" : 10, "iris_stages" : 8 },
+      { "name" : "low", "variant" : "small", "optimized_pipeline" : false, "gpu_regression" : true, "interval" : 0.25 }
+    ]
+  }
+
+  Rows are ordered from the most to the least demanding, the first row whose limits (in
+  milliseconds) hold is selected and the last row is the fallback.  Measurements (rather
+  than the selected row) are cached, so an updated table applies without a new benchmark.
+  Regression stage hints and eye model inits ("face_stages", "eyelid_stages", "iris_stages",
+  "eyelid_inits", "iris_inits") can be generated by drishti-sweep from a labeled set.
+
+*/
+
+#ifndef __drishti_hci_DeviceProfile_h__
+#define __drishti_hci_DeviceProfile_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/FaceFinder.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class DeviceProfile
+{
+public:
+    // Median times in milliseconds (< 0 == not measured):
+    struct Measurements
+    {
+        double gpuAcf = -1.0;     // frame time with GPU ACF channels
+        double cpuAcf = -1.0;     // frame time with a CPU ACF pyramid
+        double readback = -1.0;   // GPU ACF channel readback
+        double regression = -1.0; // one face landmark regression
+    };
+
+    struct Profile
+    {
+        std::string name;
+        std::string variant;      // model variant (empty == default models)
+        Measurements limits;      // slowest supported measurements (< 0 == any)
+        bool doOptimizedPipeline = true;
+        bool doCpuAcf = false;
+        bool autoAcf = true;          // choose the faster measured ACF path (overrides doCpuAcf)
+        bool doGpuRegression = false; // simple pipeline only (see FaceFinder::Settings)
+        float faceFinderInterval = 0.f;
+        int threads = 0;          // 0 == no limit
+
+        // Regression cost (0 == model defaults, see FaceFinder::Settings):
+        int faceStagesHint = 0;
+        int eyelidStagesHint = 0;
+        int irisStagesHint = 0;
+        int eyelidInits = 0;
+        int irisInits = 0;
+
+        // Apply the pipeline settings (the model variant is selected by the factory):
+        void apply(FaceFinder::Settings& settings) const;
+    };
+
+    using Table = std::vector<Profile>;
+
+    static Table load(std::istream& is);
+    static Table load(const std::string& filename);
+
+    // First row whose limits hold (the last row otherwise), with the ACF path resolved:
+    static Profile select(const Table& table, const Measurements& measurements);
+
+    // Run the benchmark on a representative frame, the GL context must be current.  Temporary
+    // FaceFinder instances are created from the settings with detection on every frame:
+    static Measurements measure(
+        FaceFinder::FaceDetectorFactoryPtr& factory,
+        const FaceFinder::Settings& settings,
+        const FaceFinder::FrameInput& frame,
+        void* glContext = nullptr,
+        int frames = 8);
+
+    // Renderer, GL version and core count (the GL context must be current):
+    static std::string getDeviceKey();
+
+    // Measurements cached for a device key (false on a missing file or another device):
+    static bool loadMeasurements(const std::string& filename, const std::string& device, Measurements& measurements);
+    static bool saveMeasurements(const std::string& filename, const std::string& device, const Measurements& measurements);
+
+    // Cached measurements for this device, or a new benchmark (stored in the cache):
+    static Profile autotune(
+        const Table& table,
+        const std::string& cache,
+        FaceFinder::FaceDetectorFactoryPtr& factory,
+        const FaceFinder::Settings& settings,
+        const FaceFinder::FrameInput& frame,
+        void* glContext = nullptr);
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_DeviceProfile_h__
@@ -11,6 +11,9 @@
 #include "drishti/hci/EyeBlob.h"
 #include "drishti/geometry/motion.h"
 
+#include <algorithm>
+#include <cmath>
+
 DRISHTI_HCI_NAMESPACE_BEGIN
 
 EyeBlobJob::EyeBlobJob(const cv::Size& size, const std::array<drishti::eye::EyeWarp, 2>& eyeWarps)
@@ -31,6 +34,34 @@ void EyeBlobJob::run()
     }
 }
 
+void EyeBlobJob::run(const cv::Mat4b& peaks, int cellSize)
+{
+    FeaturePoints points;
+    for (int y = 0; y < peaks.rows; y++)
+    {
+        for (int x = 0; x < peaks.cols; x++)
+        {
+            const cv::Vec4b& pixel = peaks(y, x);
+            if (pixel[3])
+            { // { x, y, x, strength } with offsets encoded as (i + 0.5) / cellSize:
+                const float dx = std::floor(static_cast<float>(pixel[0]) * cellSize / 255.f);
+                const float dy = std::floor(static_cast<float>(pixel[1]) * cellSize / 255.f);
+                const cv::Point2f p(static_cast<float>(x * cellSize) + dx, static_cast<float>(y * cellSize) + dy);
+                points.emplace_back(p, static_cast<float>(pixel[3]) / 255.f);
+            }
+        }
+    }
+
+    std::sort(points.begin(), points.end(), [](const FeaturePoint& pa, const FeaturePoint& pb) {
+        return (pa.radius > pb.radius);
+    });
+
+    for (int i = 0; i < 2; i++)
+    {
+        eyePoints[i] = getValidEyePoints(points, eyeWarps[i], filtered.size());
+    }
+}
+
 EyeBlobJob::FeaturePoints
 EyeBlobJob::getValidEyePoints(const FeaturePoints& points, const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size)
 {
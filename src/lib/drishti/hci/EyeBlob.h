@@ -24,6 +24,9 @@ struct EyeBlobJob
     FeaturePoints getValidEyePoints(const FeaturePoints& points, const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size);
     void run();
 
+    // Decode compacted peaks (see BlobFilter::getCompactPeaks()), one candidate per cell:
+    void run(const cv::Mat4b& peaks, int cellSize);
+
     cv::Mat4b filtered;
     cv::Mat1b alpha;
     const std::array<drishti::eye::EyeWarp, 2>& eyeWarps;
@@ -0,0 +1,216 @@
+/*! -*-c++-*-
+  @file   EyeGate.cpp
+  @author David Hirvonen
+  @brief  Implementation of a per track eye regression gate (blinks, closed eyes and head pose).
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/EyeGate.h"
+
+#include <algorithm>
+#include <limits>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+// Tracks without a matching face for this many frames are dropped:
+static const int kMaxMisses = 2;
+
+static cv::Point2f transform(const cv::Matx33f& H, const cv::Point2f& p)
+{
+    const cv::Point3f q = H * cv::Point3f(p.x, p.y, 1.f);
+    return { q.x / q.z, q.y / q.z };
+}
+
+static bool hasEyes(const face::FaceModel& face)
+{
+    return (face.eyeFullR.has && !face.eyeFullR->eyelids.empty()) || (face.eyeFullL.has && !face.eyeFullL->eyelids.empty());
+}
+
+EyeGate::EyeGate(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+EyeGate::Track* EyeGate::find(std::vector<Track>& tracks, const cv::Point2f& center, float distance)
+{
+    Track* best = nullptr;
+    float bestScore = std::numeric_limits<float>::max();
+    for (auto& track : tracks)
+    {
+        const float score = static_cast<float>(cv::norm(track.center - center)) / std::max(std::max(track.distance, distance), 1.f);
+        if ((score < m_settings.maxMatchDistance) && (score < bestScore))
+        {
+            best = &track;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+bool EyeGate::isAway(const GazeEstimator::GazeEstimate& gaze) const
+{
+    return (std::abs(gaze.relative.x) > m_settings.maxYaw) || (gaze.relative.y < m_settings.pitch[0]) || (gaze.relative.y > m_settings.pitch[1]);
+}
+
+bool EyeGate::isAway(const face::FacePoseEstimator::Pose& pose) const
+{
+    const cv::Point3f euler = pose.getEuler();
+    return (std::abs(euler.y) > m_settings.maxPoseYaw) || (euler.x < m_settings.posePitch[0]) || (euler.x > m_settings.posePitch[1]);
+}
+
+void EyeGate::setState(Track& track, State state)
+{
+    if (track.state != state)
+    {
+        if ((track.state == kOpen) && (state == kBlink))
+        {
+            m_stats.blinks++;
+        }
+        m_stats.transitions++;
+        track.state = state;
+        track.frames = 0;
+    }
+}
+
+EyeGate::Mode EyeGate::operator()(const face::FaceModel& face, const cv::Matx33f& H)
+{
+    const cv::Point2f pR = transform(H, face.getEyeRightCenter()), pL = transform(H, face.getEyeLeftCenter());
+    const cv::Point2f center = (pR + pL) * 0.5f;
+    const auto distance = static_cast<float>(cv::norm(pL - pR));
+
+    // The relative gaze and the pose rotation are similarity invariant, so H isn't needed here:
+    face::FacePoseEstimator::Points2d points;
+    const bool hasPose = face::FacePoseEstimator::getPoints(face, points);
+    bool away = !hasPose && face.noseTip.has && isAway(m_gaze(face));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Track* track = find(m_tracks, center, distance);
+    if (!track)
+    {
+        m_tracks.emplace_back();
+        track = &m_tracks.back();
+        track->center = center;
+        track->distance = distance;
+    }
+
+    if (hasPose)
+    {
+        track->pose = m_pose(points, &track->pose);
+        away = track->pose.valid && isAway(track->pose);
+    }
+
+    Mode mode = face::FaceDetector::kEyeFull;
+    if (away)
+    {
+        mode = face::FaceDetector::kEyeSkip;
+        m_stats.away++;
+    }
+    else
+    {
+        switch (track->state)
+        {
+            case kOpen:
+                mode = face::FaceDetector::kEyeFull;
+                break;
+            case kBlink:
+                mode = face::FaceDetector::kEyeEyelids;
+                break;
+            case kClosed:
+                mode = ((track->frames % std::max(m_settings.probeInterval, 1)) == 0) ? face::FaceDetector::kEyeEyelids : face::FaceDetector::kEyeSkip;
+                break;
+        }
+    }
+
+    switch (mode)
+    {
+        case face::FaceDetector::kEyeFull:
+            m_stats.full++;
+            break;
+        case face::FaceDetector::kEyeEyelids:
+            m_stats.eyelids++;
+            break;
+        case face::FaceDetector::kEyeSkip:
+            m_stats.skipped++;
+            break;
+    }
+
+    track->mode = mode;
+    return mode;
+}
+
+void EyeGate::update(const std::vector<face::FaceModel>& faces)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<bool> matched(m_tracks.size(), false);
+    for (const auto& face : faces)
+    {
+        const cv::Point2f pR = face.getEyeRightCenter(), pL = face.getEyeLeftCenter();
+        const cv::Point2f center = (pR + pL) * 0.5f;
+        const auto distance = static_cast<float>(cv::norm(pL - pR));
+
+        Track* track = find(m_tracks, center, distance);
+        if (!track || matched[track - m_tracks.data()])
+        {
+            continue; // not gated (e.g., no landmarks) or taken by a closer face
+        }
+
+        matched[track - m_tracks.data()] = true;
+        track->center = center;
+        track->distance = distance;
+        track->misses = 0;
+
+        // Skipped tracks carry stale (or no) eye models:
+        if ((track->mode != face::FaceDetector::kEyeSkip) && hasEyes(face))
+        {
+            const float openness = m_gaze(face).openness;
+            track->closed = (openness < m_settings.closeThreshold) ? (track->closed + 1) : 0;
+            if (openness > m_settings.openThreshold)
+            {
+                setState(*track, kOpen);
+            }
+            else if (openness < m_settings.closeThreshold)
+            {
+                if (track->state == kOpen)
+                {
+                    setState(*track, kBlink);
+                }
+                else if ((track->state == kBlink) && (track->closed >= m_settings.closedFrames))
+                {
+                    setState(*track, kClosed);
+                }
+            }
+        }
+
+        track->frames++;
+    }
+
+    // Age out the unmatched tracks:
+    for (int i = 0; i < matched.size(); i++)
+    {
+        if (!matched[i])
+        {
+            m_tracks[i].misses++;
+        }
+    }
+    m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(), [](const Track& track) { return track.misses > kMaxMisses; }), m_tracks.end());
+}
+
+void EyeGate::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tracks.clear();
+    m_stats = {};
+}
+
+EyeGate::Stats EyeGate::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,120 @@
+/*! -*-c++-*-
+  @file   EyeGate.h
+  @author David Hirvonen
+  @brief  Declaration of a per track eye regression gate (blinks, closed eyes and head pose).
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Eye model regression is the most expensive per face CPU stage, and most of it is wasted
+  while the eyes are closed or the head is turned away.  Each track keeps a small state
+  machine driven by the openness history and GazeEstimator:
+
+    kOpen   : full eye models (eyelids, iris and pupil)
+    kBlink  : eyelids only, so that the reopening is seen on the next frame
+    kClosed : eyelids only every probeInterval frames, no eye models in between
+
+  Faces with an extreme head pose are skipped in any state, the pose is estimated with
+  FacePoseEstimator (tracked, with a temporal prior) when the face has mouth corners, and
+  from the GazeEstimator landmark proxy otherwise.  Tracks return to
+  kOpen (full quality) as soon as a measured openness exceeds the open threshold.
+
+*/
+
+#ifndef __drishti_hci_EyeGate_h__
+#define __drishti_hci_EyeGate_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/GazeEstimator.h"
+#include "drishti/face/Face.h"
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FacePoseEstimator.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class EyeGate
+{
+public:
+    using Mode = face::FaceDetector::EyeMode;
+
+    enum State
+    {
+        kOpen,
+        kBlink,
+        kClosed
+    };
+
+    struct Settings
+    {
+        float closeThreshold = 0.10f;     // openness below which an eye is closing (blink onset)
+        float openThreshold = 0.15f;      // openness above which an eye is open again (hysteresis)
+        int closedFrames = 6;             // consecutive closed measurements before kClosed
+        int probeInterval = 4;            // kClosed eyelid probe interval (frames)
+        float maxYaw = 0.35f;             // |GazeEstimate::relative.x| limit
+        cv::Vec2f pitch = { 0.2f, 1.0f }; // GazeEstimate::relative.y range
+        float maxMatchDistance = 0.5f;    // track association: eye midpoint distance / eye distance
+        float maxPoseYaw = 35.f;               // |yaw| limit (degrees, FacePoseEstimator)
+        cv::Vec2f posePitch = { -25.f, 25.f }; // pitch range (degrees, FacePoseEstimator)
+    };
+
+    // Gating decisions since construction (or reset()):
+    struct Stats
+    {
+        std::size_t full = 0;
+        std::size_t eyelids = 0;
+        std::size_t skipped = 0;
+        std::size_t away = 0;        // subset of skipped (head pose)
+        std::size_t blinks = 0;      // kOpen -> kBlink transitions
+        std::size_t transitions = 0; // all state transitions
+    };
+
+    EyeGate() = default;
+    explicit EyeGate(const Settings& settings);
+
+    // Mode for a face with landmarks that is about to be segmented (see FaceDetector::setEyeModeCallback()),
+    // H maps the face to the coordinate system of the faces passed to update():
+    Mode operator()(const face::FaceModel& face, const cv::Matx33f& H = cv::Matx33f::eye());
+
+    // Advance the track states with the segmented faces (once per frame):
+    void update(const std::vector<face::FaceModel>& faces);
+
+    void reset();
+    Stats getStats() const;
+    const Settings& getSettings() const { return m_settings; }
+
+protected:
+    struct Track
+    {
+        cv::Point2f center;   // eye midpoint
+        float distance = 0.f; // eye distance
+        State state = kOpen;
+        Mode mode = face::FaceDetector::kEyeFull; // latest decision
+        int closed = 0;    // consecutive closed measurements
+        int frames = 0;    // frames in the current state
+        int misses = 0;
+        face::FacePoseEstimator::Pose pose; // prior for the next frame
+    };
+
+    Track* find(std::vector<Track>& tracks, const cv::Point2f& center, float distance);
+    bool isAway(const GazeEstimator::GazeEstimate& gaze) const;
+    bool isAway(const face::FacePoseEstimator::Pose& pose) const;
+    void setState(Track& track, State state);
+
+    Settings m_settings;
+    GazeEstimator m_gaze;
+    face::FacePoseEstimator m_pose;
+
+    mutable std::mutex m_mutex;
+    std::vector<Track> m_tracks;
+    Stats m_stats;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_EyeGate_h__
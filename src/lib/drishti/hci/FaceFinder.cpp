@@ -14,16 +14,30 @@
 #include "drishti/core/drishti_operators.h"      // cv::Size * float
 #include "drishti/core/make_unique.h"            // make_unique<>
 #include "drishti/core/timing.h"                 // ScopeTimeLogger
+#include "drishti/core/scope_guard.h"            // scope_guard
 #include "drishti/face/FaceDetectorAndTracker.h" // *
+#include "drishti/face/gpu/ShapePredictorGPU.h"  // GPU landmarks
 #include "drishti/geometry/Primitives.h"         // operator
 #include "drishti/geometry/motion.h"             // transformation::
+#if DRISHTI_HCI_WITH_BLOBS
 #include "drishti/hci/EyeBlob.h"                 // EyeBlobJob
+#endif
 #include "drishti/core/ImageView.h"
+#include "drishti/core/MemoryRegistry.h"
+#include "drishti/graphics/ProgramCache.h"
 #include "drishti/ml/ObjectDetector.h"
 #include "drishti/ml/ObjectDetectorACF.h"
 
+#include "ogles_gpgpu/common/gl/memtransfer_optimized.h"
+
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <limits>
 #include <deque>
+#include <numeric>
+#include <future>
+#include <iterator>
 
 #include <spdlog/fmt/ostr.h>
 
@@ -47,7 +61,9 @@ using drishti::core::operator*;
 DRISHTI_HCI_NAMESPACE_BEGIN
 
 static void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scores);
+static void prunePyramid(acf::Detector::Pyramid& P, const std::pair<double, double>& scales);
 static int getDetectionImageWidth(float, float, float, float, float);
+static void interpolateEyes(std::vector<face::FaceModel>& faces, std::vector<face::FaceModel>& history, const std::function<bool(const face::FaceModel&)>& isSkipped);
 
 #if DRISHTI_HCI_FACEFINDER_DEBUG_PYRAMIDS
 static cv::Mat draw(const acf::Detector::Pyramid& pyramid);
@@ -64,6 +80,29 @@ static ogles_gpgpu::Size2d convert(const cv::Size& size)
     return {size.width, size.height};
 }
 
+// Tightly packed output texels: platform optimized outputs (the iOS texture cache, backed by
+// an IOSurface) are mapped and copied row by row, otherwise the texture is read back with
+// glReadPixels:
+static void getResultData(ogles_gpgpu::ProcInterface& proc, std::uint8_t* dst)
+{
+    if (dynamic_cast<ogles_gpgpu::MemTransferOptimized*>(proc.getMemTransferObj()))
+    {
+        ogles_gpgpu::MemTransfer::FrameDelegate delegate = [&](const ogles_gpgpu::Size2d& size, const void* pixels, size_t bytesPerRow) {
+            const std::size_t rowBytes = static_cast<std::size_t>(size.width) * 4;
+            const auto* src = static_cast<const std::uint8_t*>(pixels);
+            for (int y = 0; y < size.height; y++, src += bytesPerRow, dst += rowBytes)
+            {
+                std::copy(src, src + rowBytes, dst);
+            }
+        };
+        proc.getResultData(delegate);
+    }
+    else
+    {
+        proc.getResultData(dst);
+    }
+}
+
 FaceFinder::FaceFinder(FaceDetectorFactoryPtr& factory, Settings& args, void* glContext)
 {
     impl = drishti::core::make_unique<Impl>(factory, args, glContext);
@@ -84,6 +123,33 @@ void FaceFinder::setImageLogger(const ImageLogger& logger)
     impl->imageLogger = logger;
 }
 
+void FaceFinder::setBackpressure(Backpressure policy)
+{
+    impl->backpressure = policy;
+}
+
+FaceFinder::Backpressure FaceFinder::getBackpressure() const
+{
+    return impl->backpressure;
+}
+
+bool FaceFinder::isBusy() const
+{
+    // Each runFast() call retrieves the oldest job once (pipelineDepth - 1) jobs are in flight:
+    const auto depth = impl->latency;
+    const auto jobs = impl->getSceneJobCount();
+    if (!impl->doOptimizedPipeline || (jobs == 0) || (jobs < static_cast<std::size_t>(depth - 1)))
+    {
+        return false;
+    }
+    return !impl->sceneRing->isDone(impl->abandonedScenes);
+}
+
+std::size_t FaceFinder::getDroppedFrameCount() const
+{
+    return impl->droppedFrames;
+}
+
 void FaceFinder::tryEnablePlatformOptimizations()
 {
     ogles_gpgpu::ACF::tryEnablePlatformOptimizations();
@@ -109,10 +175,20 @@ FaceFinder::~FaceFinder()
 {
     try
     {
-        if (impl && impl->scene.valid())
+        if (impl)
         {
-            // If this has already been retrieved it will throw
-            impl->scene.get(); // block on any abandoned calls
+            // Block on the CPU scene jobs (and abandoned ones) in flight:
+            impl->sceneRing.reset();
+
+            // Background model loads reference the factory:
+            if (impl->faceDetector && !impl->hasModels)
+            {
+                if (impl->meanFace.valid())
+                {
+                    impl->meanFace.wait();
+                }
+                impl->faceDetector->join();
+            }
         }
     }
     catch (std::exception &e)
@@ -130,8 +206,13 @@ FaceFinder::~FaceFinder()
 
 bool FaceFinder::needsDetection(const TimePoint& now) const
 {
-    double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - impl->objects.first).count();
-    return (elapsed > impl->faceFinderInterval);
+    double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - impl->detectionTime).count();
+    if (impl->detectionScheduler)
+    {
+        const double floor = impl->powerInterval.load();
+        return (*impl->detectionScheduler)(elapsed, impl->faceFinderInterval, floor, impl->hasDetection) != DetectionScheduler::kNone;
+    }
+    return !impl->hasDetection || (elapsed > std::max(impl->faceFinderInterval, impl->powerInterval.load()));
 }
 
 float FaceFinder::getMinDistance() const
@@ -144,6 +225,16 @@ float FaceFinder::getMaxDistance() const
     return impl->maxDistanceMeters;
 }
 
+void FaceFinder::setDetectionDistance(float minMeters, float maxMeters)
+{
+    if ((minMeters != impl->minDistanceMeters) || (maxMeters != impl->maxDistanceMeters))
+    {
+        impl->minDistanceMeters = minMeters;
+        impl->maxDistanceMeters = maxMeters;
+        impl->doPyramidUpdate = impl->hasInit;
+    }
+}
+
 void FaceFinder::setDoCpuAcf(bool flag)
 {
     impl->doCpuACF = flag;
@@ -154,6 +245,12 @@ bool FaceFinder::getDoCpuAcf() const
     return impl->doCpuACF;
 }
 
+void FaceFinder::setCaptureTime(const TimePoint& time)
+{
+    impl->captureTime = time;
+    impl->hasCaptureTime = true;
+}
+
 void FaceFinder::setFaceFinderInterval(double interval)
 {
     impl->faceFinderInterval = interval;
@@ -164,9 +261,39 @@ double FaceFinder::getFaceFinderInterval() const
     return impl->faceFinderInterval;
 }
 
-void FaceFinder::registerFaceMonitorCallback(FaceMonitor* callback)
+void FaceFinder::setDoIris(bool flag)
+{
+    impl->doIris = flag;
+}
+
+bool FaceFinder::getDoIris() const
+{
+    return impl->doIris;
+}
+
+void FaceFinder::setDoEyeFlow(bool flag)
+{
+    impl->doEyeFlow = flag;
+}
+
+bool FaceFinder::getDoEyeFlow() const
+{
+    return impl->doEyeFlow;
+}
+
+void FaceFinder::setDoBlobs(bool flag)
+{
+    impl->doBlobs = flag && DRISHTI_HCI_WITH_BLOBS;
+}
+
+bool FaceFinder::getDoBlobs() const
 {
-    impl->faceMonitorCallback.push_back(callback);
+    return impl->doBlobs;
+}
+
+void FaceFinder::registerFaceMonitorCallback(FaceMonitor* callback, const FaceMonitor::Schedule& schedule)
+{
+    impl->faceMonitorCallback.add(callback, schedule);
 }
 
 void FaceFinder::dumpEyes(ImageViews& frames, EyeModelPairs& eyes, int n, bool getImage)
@@ -174,11 +301,11 @@ void FaceFinder::dumpEyes(ImageViews& frames, EyeModelPairs& eyes, int n, bool g
     impl->eyeFilter->dump(frames, eyes, n, getImage);
 }
 
-void FaceFinder::dumpFaces(ImageViews& frames, int n, bool getImage, int skipFrames)
+void FaceFinder::dumpFaces(ImageViews& frames, const FaceMonitor::Request& request, int skipFrames)
 {
     const auto length = static_cast<int>(impl->fifo->getBufferCount());
     
-    frames.resize(std::min(static_cast<std::size_t>(n), static_cast<std::size_t>(length)));
+    frames.resize(std::min(static_cast<std::size_t>(request.n), static_cast<std::size_t>(length)));
     for (int i = 0, j = skipFrames; i < static_cast<int>(frames.size()); i++, j++)
     {
         // Reverse fifo for storage such that the largest timestamp comes first
@@ -188,11 +315,78 @@ void FaceFinder::dumpFaces(ImageViews& frames, int n, bool getImage, int skipFra
         // Always assign texture (no cost)
         frames[i].texture = { { size.width, size.height }, filter->getOutputTexId() };
         
-        if (getImage)
+        if (request.getImage)
+        {
+            if (request.isNative())
+            {
+                frames[i].image.create(size.height, size.width);
+                getResultData(*filter, frames[i].image.ptr<uint8_t>());
+            }
+            else
+            {
+                grabImage(filter, request, frames[i]);
+            }
+        }
+    }
+}
+
+// Crop, resample and convert a frame on the GPU so that only the requested pixels are read back.
+void FaceFinder::grabImage(ogles_gpgpu::ProcInterface* filter, const FaceMonitor::Request& request, core::ImageView& view)
+{
+    using CropPackProc = ogles_gpgpu::CropPackProc;
+
+    // BT.601 (full range) weights and offsets for the Y, U and V planes:
+    static const float kPlanes[3][4] = {
+        { +0.299f, +0.587f, +0.114f, 0.0f },
+        { -0.169f, -0.331f, +0.500f, 0.5f },
+        { +0.500f, -0.419f, -0.081f, 0.5f }
+    };
+
+    const auto frameSize = filter->getOutFrameSize();
+    const cv::Size inputSize(frameSize.width, frameSize.height);
+
+    const cv::Rect2f roi = request.getRoi();
+    const cv::Size roiSize(std::max(cvRound(roi.width * inputSize.width), 1), std::max(cvRound(roi.height * inputSize.height), 1));
+    const cv::Size size = request.getImageSize(roiSize);
+
+    const bool isPlanar = (request.format != FaceMonitor::Request::kRGBA);
+    const int count = (request.format == FaceMonitor::Request::kI420) ? 3 : 1;
+    if (isPlanar)
+    {
+        view.planes.create((count == 3) ? (size.height * 3 / 2) : size.height, size.width);
+    }
+    else
+    {
+        view.image.create(size);
+    }
+
+    std::uint8_t* dst = isPlanar ? view.planes.ptr<std::uint8_t>() : view.image.ptr<std::uint8_t>();
+    for (int i = 0; i < count; i++)
+    {
+        const auto mode = isPlanar ? CropPackProc::PLANE : CropPackProc::RGBA;
+        auto& proc = impl->grabProcs[i];
+        if (!proc || (proc->getMode() != mode))
+        {
+            proc = drishti::core::make_unique<CropPackProc>(mode, !TEXTURE_FORMAT_IS_RGBA);
+            impl->grabShapes[i] = {};
+        }
+
+        const cv::Size planeSize = i ? cv::Size(size.width / 2, size.height / 2) : size;
+        proc->setRoi(roi.x, roi.y, roi.width, roi.height);
+        proc->setPlane(kPlanes[i][0], kPlanes[i][1], kPlanes[i][2], kPlanes[i][3]);
+
+        // Reallocate the output only when the input or image size changes:
+        const std::pair<cv::Size, cv::Size> shape(inputSize, planeSize);
+        if (impl->grabShapes[i] != shape)
         {
-            frames[i].image.create(size.height, size.width);
-            filter->getResultData(frames[i].image.ptr<uint8_t>());
+            proc->setImageSize(planeSize.width, planeSize.height);
+            proc->prepare(inputSize.width, inputSize.height, GL_RGBA);
+            impl->grabShapes[i] = shape;
         }
+
+        proc->process(filter->getOutputTexId(), 1, GL_TEXTURE_2D);
+        getResultData(*proc, dst);
+        dst += isPlanar ? planeSize.area() : 0;
     }
 }
 
@@ -208,11 +402,57 @@ int FaceFinder::computeDetectionWidth(const cv::Size& inputSizeUp) const
         std::swap(winSize.width, winSize.height);
     }
     
-    const float faceWidthMeters = 0.12f; // reasonable constant
+    const float faceWidthMeters = DRISHTI_HCI_FACEFINDER_FACE_WIDTH_METERS; // reasonable constant
     const float fx = impl->sensor->intrinsic().m_fx;
     return getDetectionImageWidth(faceWidthMeters, fx, impl->maxDistanceMeters, winSize.width, inputSizeUp.width);
 }
 
+// Side effect: set detector minDs and impl->pyramidScales
+void FaceFinder::initPyramidPlan(const cv::Size& detectionSize)
+{
+    auto winSize = impl->detector->getWindowSize();
+    if(!impl->detector->getIsRowMajor())
+    {
+        std::swap(winSize.width, winSize.height);
+    }
+
+    // Face widths (detection image) at the far and near ends of the distance band:
+    const auto& intrinsic = impl->sensor->intrinsic();
+    const float Sfd = 1.0f / impl->ACFScale; // full->detection
+    const float widthFar = intrinsic.getObjectWidth(DRISHTI_HCI_FACEFINDER_FACE_WIDTH_METERS, impl->maxDistanceMeters) * Sfd;
+    const float widthNear = (impl->minDistanceMeters > 0.f) ? intrinsic.getObjectWidth(DRISHTI_HCI_FACEFINDER_FACE_WIDTH_METERS, impl->minDistanceMeters) * Sfd : 0.f;
+
+    // Allow one level of slack at each end of the band:
+    auto& pPyramid = impl->detector->opts.pPyramid;
+    const double step = std::pow(2.0, 1.0 / std::max(pPyramid->nPerOct.get(), 1));
+    const double minScale = (widthNear > 0.f) ? (winSize.width / widthNear) / step : 0.0;
+    const double maxScale = (winSize.width / widthFar) * step;
+    impl->pyramidScales = { minScale, maxScale };
+
+    // Coarse levels (near faces): raise the minimum level size so that levels smaller than
+    // the one at which a face at the minimum distance fills the window aren't computed at all.
+    if (impl->minDs.area() == 0)
+    {
+        impl->minDs = pPyramid->minDs.get();
+    }
+    cv::Size minDs = impl->minDs;
+    minDs.width = std::max(minDs.width, static_cast<int>(detectionSize.width * minScale));
+    minDs.height = std::max(minDs.height, static_cast<int>(detectionSize.height * minScale));
+    pPyramid->minDs.get() = minDs;
+
+    impl->logger->info("ACF pyramid plan: distance [{},{}] scale [{},{}] minDs {}x{}", impl->minDistanceMeters, impl->maxDistanceMeters, minScale, maxScale, minDs.width, minDs.height);
+}
+
+void FaceFinder::updatePyramidPlan()
+{
+    // CPU jobs in flight read the ACF scales, so let the last detect() finish first:
+    impl->waitForScenes();
+
+    initACF(impl->inputSizeUp);
+    impl->trackedObjects.clear(); // detection image coordinates changed, start with a full scan
+    impl->doPyramidUpdate = false;
+}
+
 // Side effect: set impl->pyramdSizes
 void FaceFinder::initACF(const cv::Size& inputSizeUp)
 {
@@ -225,8 +465,45 @@ void FaceFinder::initACF(const cv::Size& inputSizeUp)
     cv::Size detectionSize = inputSizeUp * (1.0f / impl->ACFScale);
     cv::Mat I(detectionSize.width, detectionSize.height, CV_32FC3, cv::Scalar::all(0));
 
+    // Only plan levels that can contain a face within the detection distance band:
+    impl->inputSizeUp = inputSizeUp;
+    initPyramidPlan(I.size());
+
     MatP Ip(I);
     impl->detector->computePyramid(Ip, impl->P);
+    prunePyramid(impl->P, impl->pyramidScales);
+    impl->acfBuilder.reset(); // rebuilt from the new layout on demand
+    impl->acfCompute.reset();
+
+    // Detection pyramids are recycled with planes preallocated for the fixed layout,
+    // so fill() can unpack the channel readback without reallocating each frame.
+    const auto layout = impl->P;
+    impl->pyramids = drishti::core::make_unique<core::SharedPool<acf::Detector::Pyramid>>([layout]() {
+        auto P = drishti::core::make_unique<acf::Detector::Pyramid>(layout);
+        for (auto& level : P->data)
+        {
+            for (auto& channels : level)
+            {
+                for (auto& plane : channels.get())
+                {
+                    plane = plane.clone();
+                }
+            }
+        }
+        return P;
+    });
+
+    impl->pyramidBytes = 0;
+    for (const auto& level : layout.data)
+    {
+        for (const auto& channels : level)
+        {
+            for (const auto& plane : channels.get())
+            {
+                impl->pyramidBytes += plane.total() * plane.elemSize();
+            }
+        }
+    }
     
     if(impl->P.nScales <= 0)
     {
@@ -260,10 +537,14 @@ void FaceFinder::initACF(const cv::Size& inputSizeUp)
     CV_Assert(featureKind != ogles_gpgpu::ACF::kUnknown);
 
     const ogles_gpgpu::Size2d size(inputSizeUp.width, inputSizeUp.height);
-    impl->acf = std::make_shared<ogles_gpgpu::ACF>(impl->glContext, size, sizes, featureKind, grayWidth, shrink);
-    impl->acf->setRotation(impl->outputOrientation);
+    // Landmark tiles replace the ACF grayscale output (and readback) at the same resolution:
+    impl->acf = std::make_shared<ogles_gpgpu::ACF>(impl->glContext, size, sizes, featureKind, impl->doLandmarkTiles ? 0 : grayWidth, shrink);
+    impl->acf->setRotation(impl->frontEnd ? 0 : impl->outputOrientation); // the front end frames are upright
     impl->acf->setLogger(impl->logger);
     impl->acf->setUsePBO((impl->glVersionMajor >= 3) && impl->usePBO);
+
+    impl->regressionScale = impl->doLandmarkTiles ? (static_cast<float>(grayWidth) / static_cast<float>(inputSizeUp.width)) : impl->acf->getGrayscaleScale();
+    impl->regressionSize = { cvRound(inputSizeUp.width * impl->regressionScale), cvRound(inputSizeUp.height * impl->regressionScale) };
 }
 
 // ### Fifo ###
@@ -272,30 +553,71 @@ void FaceFinder::initFIFO(const cv::Size& inputSize, std::size_t n)
     impl->fifo = std::make_shared<ogles_gpgpu::FifoProc>(n);
     impl->fifo->init(inputSize.width, inputSize.height, INT_MAX, false);
     impl->fifo->createFBOTex(false);
+
+    // Frames and eyes retained by FaceMonitor clients (one per listener and frame is typical),
+    // kept across orientation changes since clients may still hold textures from the pool:
+    if (!impl->texturePool)
+    {
+        impl->texturePool = drishti::core::make_unique<ogles_gpgpu::TexturePool>(n * 2);
+    }
 }
 
 void FaceFinder::initBlobFilter()
 {
+#if DRISHTI_HCI_WITH_BLOBS
     // ### Blobs ###
     assert(impl->eyeFilter.get());
     impl->blobFilter = drishti::core::make_unique<ogles_gpgpu::BlobFilter>();
     impl->blobFilter->init(128, 64, INT_MAX, false);
     impl->blobFilter->createFBOTex(false);
-
-    // ### Send eye images into the blob filter ###
-    impl->eyeFilter->getOutputFilter()->add(impl->blobFilter->getInputFilter());
+#endif
 }
 
 void FaceFinder::initIris(const cv::Size& size)
 {
     // ### Ellipsopolar warper ####
-    for (auto & i : impl->ellipsoPolar)
+    assert(impl->eyeFilter.get());
+    const auto atlasSize = impl->eyeFilter->getAtlasSize();
+    const cv::Matx33f N = transformation::scale(0.5, 0.5) * transformation::translate(1.f, 1.f);
+    for (int i = 0; i < 2; i++)
     {
-        i = std::make_shared<ogles_gpgpu::EllipsoPolarWarp>();
-        i->setOutputSize(size.width, size.height);
+        impl->ellipsoPolar[i] = std::make_shared<ogles_gpgpu::EllipsoPolarWarp>();
+        impl->ellipsoPolar[i]->setOutputSize(size.width, size.height);
+
+        // Add a callback to retrieve updated eye models automatically:
+        // clang-format off
+        std::function<drishti::eye::EyeWarp()> eyeDelegate = [&, N, i]()
+        {
+            auto eye = impl->eyeFilter->getEyeWarps()[i];
+            eye.eye = N * eye.H * eye.eye;
+            return eye;
+        };
+        // clang-format on
+        impl->ellipsoPolar[i]->addEyeDelegate(eyeDelegate);
+        impl->ellipsoPolar[i]->prepare(atlasSize.width, atlasSize.height, GL_RGBA);
     }
 }
 
+void FaceFinder::initEyePatches(const cv::Size& inputSizeUp)
+{
+    // ### Eye regressor input patches ###
+    const int maxFaces = impl->doSingleFace ? 1 : 2;
+    impl->eyePatchFilter = drishti::core::make_unique<ogles_gpgpu::EyePatchFilter>(impl->eyePatchWidth, maxFaces);
+    impl->eyePatchFilter->prepare(inputSizeUp.width, inputSizeUp.height);
+
+    // In the optimized pipeline, patches for frame n are read while frame n+1 is rendered:
+    const bool doAsync = impl->doOptimizedPipeline && (impl->glVersionMajor >= 3) && impl->usePBO;
+    impl->eyePatchFilter->setAsyncReadback(doAsync, 2);
+}
+
+void FaceFinder::initFaceTiles(const cv::Size& inputSizeUp)
+{
+    // ### Landmark regression tiles (replace the ACF grayscale readback) ###
+    const int maxFaces = impl->doSingleFace ? 1 : 2;
+    impl->faceTileFilter = drishti::core::make_unique<ogles_gpgpu::FaceTileFilter>(impl->landmarkTileWidth, maxFaces, !TEXTURE_FORMAT_IS_RGBA);
+    impl->faceTileFilter->prepare(inputSizeUp.width, inputSizeUp.height);
+}
+
 void FaceFinder::initEyeEnhancer(const cv::Size& inputSizeUp, const cv::Size& eyesSize)
 {
     // ### Eye enhancer ###
@@ -304,305 +626,933 @@ void FaceFinder::initEyeEnhancer(const cv::Size& inputSizeUp, const cv::Size& ey
 
     impl->eyeFilter = drishti::core::make_unique<ogles_gpgpu::EyeFilter>(convert(eyesSize), mode, cutoff, impl->history);
     impl->eyeFilter->setAutoScaling(impl->doEyesScaling);
-    impl->eyeFilter->setOutputSize(eyesSize.width, eyesSize.height);
+    impl->eyeFilter->setMaxFaces(impl->maxEyeFaces);
 
-    if (impl->doIris)
-    {
-        // Add a callback to retrieve updated eye models automatically:
-        cv::Matx33f N = transformation::scale(0.5, 0.5) * transformation::translate(1.f, 1.f);
-        for (int i = 0; i < 2; i++)
-        {
-            // clang-format off
-            std::function<drishti::eye::EyeWarp()> eyeDelegate = [&, N, i]()
-            {
-                auto eye = impl->eyeFilter->getEyeWarps()[i];
-                eye.eye = N * eye.H * eye.eye;
-                return eye;
-            };
-            // clang-format on
-            impl->ellipsoPolar[i]->addEyeDelegate(eyeDelegate);
-            impl->eyeFilter->add(impl->ellipsoPolar[i].get());
-        }
-    }
+    // Eye pairs for all faces are rendered into one atlas texture (one tile per face):
+    const auto atlasSize = impl->eyeFilter->getAtlasSize();
+    impl->eyeFilter->setOutputSize(atlasSize.width, atlasSize.height);
+
+    impl->eyeFilter->prepare(inputSizeUp.width, inputSizeUp.height, static_cast<GLenum>(GL_RGBA));
+}
 
-    if (impl->doEyeFlow)
-    { // optical flow for eyes:
-        impl->eyeFlow = drishti::core::make_unique<ogles_gpgpu::FlowOptPipeline>(0.004, 1.0, false);
+void FaceFinder::initEyeFlow()
+{
+    // ### Optical flow for eyes ###
+    assert(impl->eyeFilter.get());
+    const auto atlasSize = impl->eyeFilter->getAtlasSize();
+    impl->eyeFlow = drishti::core::make_unique<ogles_gpgpu::FlowOptPipeline>(0.004, 1.0, false);
 #if TEXTURE_FORMAT_IS_RGBA
-        impl->eyeFlowBgra = drishti::core::make_unique<ogles_gpgpu::SwizzleProc>();
-        impl->eyeFlow->add(impl->eyeFlowBgra.get());
-        impl->eyeFlowBgraInterface = impl->eyeFlowBgra.get();
+    impl->eyeFlowBgra = drishti::core::make_unique<ogles_gpgpu::SwizzleProc>();
+    impl->eyeFlow->add(impl->eyeFlowBgra.get());
+    impl->eyeFlowBgraInterface = impl->eyeFlowBgra.get();
 #else
-        impl->eyeFlowBgraInterface = impl->eyeFlow.get();
+    impl->eyeFlowBgraInterface = impl->eyeFlow.get();
 #endif
 
-        impl->eyeFilter->add(impl->eyeFlow.get());
+    if (impl->doEyeFlowReduction)
+    { // 8x8 cells (thresholded on corner strength) -> one pixel per eye per atlas tile:
+        impl->eyeFlowCells = drishti::core::make_unique<ogles_gpgpu::FlowReduceProc>(0.f);
+        impl->eyeFlowCells->setOutputSize(std::max(atlasSize.width / 8, 2), std::max(atlasSize.height / 8, impl->maxEyeFaces));
+        impl->eyeFlowRegions = drishti::core::make_unique<ogles_gpgpu::FlowReduceProc>(0.f);
+        impl->eyeFlowRegions->setOutputSize(2, impl->maxEyeFaces);
+        impl->eyeFlow->add(impl->eyeFlowCells.get());
+        impl->eyeFlowCells->add(impl->eyeFlowRegions.get());
     }
 
-    impl->eyeFilter->prepare(inputSizeUp.width, inputSizeUp.height, static_cast<GLenum>(GL_RGBA));
+    impl->eyeFlow->prepare(atlasSize.width, atlasSize.height, GL_RGBA);
 }
 
-void FaceFinder::initPainter(const cv::Size& /* inputSizeUp */)
+// Optional eye stages aren't subscribed to the eye filter (see updateEyes()), so they are
+// created on first use and released (with their textures and FBOs) as soon as they are disabled:
+void FaceFinder::updateEyeStages()
 {
-    impl->logger->info("Init painter");
-}
+    if (impl->doIris && !impl->ellipsoPolar[0])
+    {
+        initIris({ 640, 240 });
+    }
+    else if (!impl->doIris && impl->ellipsoPolar[0])
+    {
+        for (auto& warp : impl->ellipsoPolar)
+        {
+            warp.reset();
+        }
+    }
 
-void FaceFinder::initFaceFilters(const cv::Size& inputSizeUp)
-{
-    const auto outputRenderOrientation = ::ogles_gpgpu::degreesToOrientation(360 - impl->outputOrientation);
-    impl->rotater = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
-    impl->rotater->setOutputRenderOrientation(outputRenderOrientation);
+    if (impl->doEyeFlow && !impl->eyeFlow)
+    {
+        initEyeFlow();
+    }
+    else if (!impl->doEyeFlow && impl->eyeFlow)
+    {
+        impl->eyeFlow.reset();
+        impl->eyeFlowBgra.reset();
+        impl->eyeFlowCells.reset();
+        impl->eyeFlowRegions.reset();
+        impl->eyeFlowBgraInterface = nullptr;
+        impl->eyeFlowField.clear();
+    }
 
-    impl->warper = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
-    impl->warper->add(impl->rotater.get());
-    impl->warper->prepare(inputSizeUp.width, inputSizeUp.width, GL_RGBA);
+#if DRISHTI_HCI_WITH_BLOBS
+    if (impl->doBlobs && !impl->blobFilter)
+    {
+        initBlobFilter();
+    }
+    else if (!impl->doBlobs && impl->blobFilter)
+    {
+        impl->blobFilter.reset();
+        for (auto& points : impl->eyePoints)
+        {
+            points.clear();
+        }
+    }
+#endif
 }
 
-GLuint FaceFinder::stabilize(GLuint inputTexId, const cv::Size& inputSizeUp, const drishti::face::FaceModel& face)
+void FaceFinder::initGlobalMotion(const cv::Size& inputSizeUp)
 {
-    if (face.points.has)
-    {
-        const cv::Matx33f S = transformation::denormalize(inputSizeUp);
-        const cv::Matx33f Sinv = S.inv();
-        const cv::Matx33f H = drishti::face::FaceStabilizer::stabilize(face, inputSizeUp, 0.33);
-
-        cv::Matx44f MVP;
-        transformation::R3x3To4x4(Sinv * H * S, MVP);
-
-        ogles_gpgpu::Mat44f MVPt{};
-        cv::Mat(MVP.t()).copyTo(cv::Mat(4, 4, CV_32FC1, &MVPt.data[0][0]));
-        impl->warper->setTransformMatrix(MVPt);
-    }
+    // ### Global motion ###
+    // Flow at a reduced resolution, reduced to one weighted (dx, dy) vector per grid cell, so that
+    // only a globalMotionGrid sized texture is read back (see readGlobalMotion()):
+    const int width = std::max(std::min(impl->globalMotionWidth, inputSizeUp.width), 1);
+    const int height = std::max(cvRound(static_cast<float>(inputSizeUp.height * width) / static_cast<float>(inputSizeUp.width)), 1);
+
+    impl->sceneFlowInput = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
+    impl->sceneFlowInput->setOutputSize(width, height);
+    impl->sceneFlow = drishti::core::make_unique<ogles_gpgpu::FlowOptPipeline>(0.004, 1.0, false);
+    impl->sceneFlowGrid = drishti::core::make_unique<ogles_gpgpu::FlowReduceProc>(0.f);
+    impl->sceneFlowGrid->setOutputSize(std::max(impl->globalMotionGrid.width, 1), std::max(impl->globalMotionGrid.height, 1));
+
+    impl->sceneFlowInput->add(impl->sceneFlow.get());
+    impl->sceneFlow->add(impl->sceneFlowGrid.get());
+    impl->sceneFlowInput->prepare(inputSizeUp.width, inputSizeUp.height, GL_RGBA);
+}
 
-    impl->warper->process(inputTexId, 1, GL_TEXTURE_2D);
-    return impl->rotater->getOutputTexId();
+void FaceFinder::initPainter(const cv::Size& /* inputSizeUp */)
+{
+    impl->logger->info("Init painter");
 }
 
-void FaceFinder::init(const cv::Size& inputSize)
+void FaceFinder::releasePainter()
 {
-    //impl->logger->set_level(spdlog::level::err);
-    impl->doOptimizedPipeline &= static_cast<bool>(impl->threads);
-    impl->latency = impl->doOptimizedPipeline ? 2 : 0;
-    impl->start = HighResolutionClock::now();
+}
 
-    auto inputSizeUp = inputSize;
-    bool hasTranspose = ((impl->outputOrientation / 90) % 2);
-    if (hasTranspose)
+// Upright frame size dependent stages (see init(), updateOrientation() and resume()):
+void FaceFinder::initStages(const cv::Size& inputSizeUp)
+{
+    if (impl->workingScale < 1.f)
     {
-        std::swap(inputSizeUp.width, inputSizeUp.height);
+        initFrontEnd(impl->fullSizeUp, inputSizeUp); // before the ACF (input rotation)
     }
 
-    impl->faceEstimator = std::make_shared<drishti::face::FaceModelEstimator>(*impl->sensor);
+    impl->stabilizer = drishti::core::make_unique<drishti::face::FaceStabilizerFilter>(inputSizeUp, 0.33f, impl->stabilizationGain);
 
     // If we are runnign an optimized pipeline there will be some latency
     // as specified by "latency" in addition to the user specified history,
     // so we must allocate our full frame FIFO large enough to store both.
     const int fullHistory = impl->history + impl->latency;
-    
-    initColormap();
+
+    // The colormap, the stabilization filters (see stabilize()) and the optional eye stages
+    // (see updateEyeStages()) are created on first use:
+    releaseFaceFilters();
     initACF(inputSizeUp);                     // initialize ACF first (configure opengl platform extensions)
     initFIFO(inputSizeUp, fullHistory);       // keep last N frames
     initPainter(inputSizeUp);                 // {inputSizeUp.width/4, inputSizeUp.height/4}
-    initFaceFilters(inputSizeUp);             // gpu "filter" (effects)
+    initEyeEnhancer(inputSizeUp, impl->eyesSize);
 
-    if (impl->doIris)
+    if (impl->doGpuEyePatches && impl->doLandmarks)
     {
-        initIris({ 640, 240 });
+        initEyePatches(inputSizeUp);
     }
 
-    // Must initial eye filter before blobFilter:
-    initEyeEnhancer(inputSizeUp, impl->eyesSize);
+    if (impl->doLandmarkTiles)
+    {
+        initFaceTiles(inputSizeUp);
+    }
 
-    if (impl->doBlobs)
+    if (impl->doGlobalMotion)
     {
-        // Must initialize blobFilter after eye filter:
-        initBlobFilter();
+        initGlobalMotion(inputSizeUp);
     }
 }
 
-template <typename Container>
-void push_fifo(Container& container, const typename Container::value_type& value, int size)
+void FaceFinder::initFrontEnd(const cv::Size& fullSizeUp, const cv::Size& inputSizeUp)
 {
-    container.push_front(value);
-    if (container.size() > size)
+    // Camera frame -> upright (camera resolution) -> working resolution:
+    impl->frontEndUpright = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
+    impl->frontEndUpright->setOutputRenderOrientation(::ogles_gpgpu::degreesToOrientation(impl->outputOrientation));
+    impl->frontEnd = drishti::core::make_unique<ogles_gpgpu::AreaResizeProc>();
+    impl->frontEnd->setOutputSize(inputSizeUp.width, inputSizeUp.height);
+    impl->frontEndUpright->add(impl->frontEnd.get());
+    impl->frontEndSource = drishti::core::make_unique<ogles_gpgpu::VideoSource>();
+    impl->frontEndSource->set(impl->frontEndUpright.get());
+
+    // Frames n-N ... n for the eye warps (see getEyeTexture()):
+    impl->fullFifo = std::make_shared<ogles_gpgpu::FifoProc>(impl->latency + 1);
+    impl->fullFifo->init(fullSizeUp.width, fullSizeUp.height, INT_MAX, false);
+    impl->fullFifo->createFBOTex(false);
+}
+
+// The working resolution frame for the pipeline (upright, so the ACF doesn't rotate it):
+FaceFinder::FrameInput FaceFinder::downscale(const FrameInput& frame)
+{
+    (*impl->frontEndSource)(frame);
+
+    impl->fullFifo->useTexture(impl->frontEndUpright->getOutputTexId(), 1);
+    impl->fullFifo->render();
+
+    return { { impl->frontEnd->getOutFrameW(), impl->frontEnd->getOutFrameH() }, nullptr, false, impl->frontEnd->getOutputTexId(), GL_RGBA };
+}
+
+// Eye warps sample normalized coordinates, so the camera resolution frame from `age` frames
+// before the current one can replace a working resolution texture directly:
+GLuint FaceFinder::getEyeTexture(GLuint inputTexId, int age) const
+{
+    if (impl->fullFifo && (impl->fullFifo->getBufferCount() > 0))
     {
-        container.pop_back();
+        return (*impl->fullFifo)[modulo(-(age + 1), impl->fullFifo->getBufferCount())]->getOutputTexId();
     }
+    return inputTexId;
 }
 
-// ogles_gpgpu::VideoSource can support list of subscribers
-//
-//       +=> FIFO[1][0] == ACF ====>
-// VIDEO |       |
-//       +=======+======== FLOW ===>
+float FaceFinder::getWorkingScale() const
+{
+    return impl->workingScale;
+}
 
-std::pair<GLuint, ScenePrimitives> FaceFinder::runFast(const FrameInput& frame2, bool doDetection)
+void FaceFinder::setOrientation(int degrees)
 {
-    FrameInput frame1;
-    frame1.size = frame2.size;
+    impl->requestedOrientation = ((degrees % 360) + 360) % 360;
+}
 
-    ScenePrimitives scene2(impl->frameIndex), scene1, scene0, *outputScene = &scene2;
+int FaceFinder::getOrientation() const
+{
+    return impl->outputOrientation;
+}
 
-    if (impl->fifo->getBufferCount() > 0)
+void FaceFinder::setGravity(const cv::Vec3f& gravity)
+{
+    setOrientation(impl->deviceOrientation(gravity));
+}
+
+// Applied on the GL thread between frames.  A half turn keeps the upright frame size, so only
+// the ACF input rotation (and the display rotation) change.  A quarter turn swaps the upright
+// frame size: the pipeline is drained and the size dependent stages are rebuilt in place, so
+// the next frames run like the first frames after init().  Tracks restart in both cases.
+void FaceFinder::updateOrientation()
+{
+    const int orientation = impl->requestedOrientation.exchange(-1);
+    if ((orientation < 0) || (orientation == impl->outputOrientation) || !impl->acf || ((orientation % 90) != 0))
     {
-        core::ScopeTimeLogger preprocessTimeLogger = [this](double t) { impl->timerInfo.acfProcessingTime = t; };
+        return;
+    }
 
-        // read GPU results for frame n-1
+    // CPU jobs in flight update the tracks (and read the detection geometry):
+    impl->waitForScenes();
 
-        // Here we always trigger GPU pipeline reads
-        // to ensure upright + redeuced grayscale images will
-        // be available for regression, even if we won't be using ACF detection.
-        impl->acf->getChannels();
+    const bool hasTranspose = (((orientation - impl->outputOrientation) / 90) % 2) != 0;
+    impl->outputOrientation = orientation;
+    impl->logger->info("Orientation: {} degrees ({})", orientation, hasTranspose ? "rebuild" : "rotate");
 
-        if (impl->acf->getChannelStatus())
+    if (hasTranspose)
+    {
+        // Frames in the FIFO (and their scenes) have the previous size, finish jobs without output:
+        impl->abandonScenes();
+        impl->releaseAbandonedScenes();
+        impl->scenePrimitives.clear();
+
+        impl->fullSizeUp = { impl->fullSizeUp.height, impl->fullSizeUp.width };
+        initStages({ impl->inputSizeUp.height, impl->inputSizeUp.width });
+        updateMemoryUsage();
+    }
+    else
+    {
+        if (impl->frontEndUpright)
         {
-            // If the ACF textures were loaded in the last call, then we know
-            // that detections were requrested for the last frame, and we will
-            // populate an ACF pyramid for the detection step.
-            scene1.m_P = std::make_shared<decltype(impl->P)>();
-            fill(*scene1.m_P);
+            impl->frontEndUpright->setOutputRenderOrientation(::ogles_gpgpu::degreesToOrientation(orientation));
         }
-
-        // ### Grayscale image ###
-        if (impl->doLandmarks)
+        else
         {
-            scene1.image() = impl->acf->getGrayscale();
+            impl->acf->setRotation(orientation);
         }
+        releaseFaceFilters();       // recreated with the new display rotation (see stabilize())
+        initPainter(impl->inputSizeUp);
     }
 
-    // Start GPU pipeline for the current frame, immediately after we have
-    // retrieved results for the previous frame.
-    computeAcf(frame2, false, doDetection);
+    // Tracks are in the previous frame geometry, so start over with a full detection:
+    impl->trackedObjects.clear();
+    initFaceTracker();
+    if (impl->detectionScheduler)
+    {
+        impl->detectionScheduler->reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(impl->eyeTierMutex);
+        impl->eyeTierFaces.clear();
+    }
+    impl->hasDetection = false;
+}
+
+// GL object names are only valid in the context that created them, so the whole pipeline is
+// released here (context current, or already lost: the deletes are no-ops) rather than by
+// resume() in the new context.  CPU state (models, tracker, scheduler) is left untouched.
+void FaceFinder::suspend()
+{
+    if (impl->isSuspended || !impl->acf)
+    {
+        return;
+    }
+
+    // CPU jobs in flight update the tracks, so let them finish (results aren't reported):
+    impl->waitForScenes();
+    impl->abandonScenes();
+    impl->releaseAbandonedScenes();
+
+    // Last face regions (full resolution -> detection image) to seed the first detection:
+    if (!impl->scenePrimitives.empty())
+    {
+        const float Sfd = 1.0f / impl->ACFScale;
+        impl->trackedObjects.clear();
+        for (const auto& f : impl->scenePrimitives.front()->faces())
+        {
+            const cv::Rect roi = f.roi;
+            impl->trackedObjects.emplace_back(cv::Point(cv::Point2f(roi.tl()) * Sfd), cv::Size(cv::Size2f(roi.size()) * Sfd));
+        }
+    }
+    impl->scenePrimitives.clear();
+
+    if (impl->faceDetector)
+    {
+        impl->faceDetector->setRegressionBackend(nullptr); // ShapePredictorGPU
+    }
+
+    releasePainter();
+    releaseFaceFilters();
+    impl->frontEndSource.reset();
+    impl->frontEndUpright.reset();
+    impl->frontEnd.reset();
+    impl->fullFifo.reset();
+    impl->fifo.reset();
+    impl->texturePool.reset(); // leases still held by clients are dropped on return
+    for (auto& proc : impl->grabProcs)
+    {
+        proc.reset();
+    }
+    impl->grabShapes = {};
+    impl->faceTileFilter.reset();
+#if DRISHTI_HCI_WITH_BLOBS
+    impl->blobFilter.reset();
+#endif
+    impl->eyePatchFilter.reset();
+    impl->ellipsoPolar[0].reset();
+    impl->ellipsoPolar[1].reset();
+    impl->eyeFlow.reset();
+    impl->eyeFlowBgra.reset();
+    impl->eyeFlowCells.reset();
+    impl->eyeFlowRegions.reset();
+    impl->eyeFlowBgraInterface = nullptr;
+    impl->eyeFlowField.clear();
+    impl->eyeFilter.reset();
+    impl->sceneFlowInput.reset();
+    impl->sceneFlow.reset();
+    impl->sceneFlowGrid.reset();
+    impl->gpuTimer.reset();
+    impl->acfCompute.reset();
+    impl->acf.reset();
+    impl->outputTexture = 0;
+
+    impl->isSuspended = true;
+    updateMemoryUsage();
+    impl->logger->info("FaceFinder: suspended ({} tracked regions)", impl->trackedObjects.size());
+}
+
+// The frame size, the detection plan and the sensor model are known, so this is init() without
+// the model loading: the cost is the texture allocation plus program linking (binaries when
+// Settings::shaderCache is set).  The optional eye stages are recreated on first use.
+void FaceFinder::resume()
+{
+    if (!impl->isSuspended)
+    {
+        return;
+    }
+
+    const float acfScale = impl->ACFScale;
+    initStages(impl->inputSizeUp);
+
+    // The detection band may have changed in the meantime:
+    if (impl->ACFScale != acfScale)
+    {
+        const float s = acfScale / impl->ACFScale;
+        for (auto& roi : impl->trackedObjects)
+        {
+            roi = { cv::Point(cv::Point2f(roi.tl()) * s), cv::Size(cv::Size2f(roi.size()) * s) };
+        }
+    }
+
+    if (impl->doGpuTiming)
+    {
+        impl->gpuTimer = drishti::core::make_unique<ogles_gpgpu::GpuTimer>();
+        if (!impl->gpuTimer->good())
+        {
+            impl->gpuTimer.reset();
+        }
+    }
+
+    if (impl->doGpuRegression && impl->faceDetector && drishti::face::ShapePredictorGPU::isSupported())
+    {
+        impl->faceDetector->setRegressionBackend(std::make_shared<drishti::face::ShapePredictorGPU>());
+    }
+
+    impl->isSuspended = false;
+    updateMemoryUsage();
+
+    // Detect on the next frame, around the last known faces (the tracks are kept):
+    impl->resumeRois = !impl->trackedObjects.empty();
+    impl->roiScanCount = 0;
+    impl->hasDetection = false;
+    impl->logger->info("FaceFinder: resumed");
+}
+
+bool FaceFinder::isSuspended() const
+{
+    return impl->isSuspended;
+}
+
+void FaceFinder::initFaceFilters(const cv::Size& inputSizeUp)
+{
+    const auto outputRenderOrientation = ::ogles_gpgpu::degreesToOrientation(360 - impl->outputOrientation);
+    impl->rotater = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
+    impl->rotater->setOutputRenderOrientation(outputRenderOrientation);
+
+    impl->warper = drishti::core::make_unique<ogles_gpgpu::TransformProc>();
+    impl->warper->add(impl->rotater.get());
+    impl->warper->prepare(inputSizeUp.width, inputSizeUp.width, GL_RGBA);
+}
+
+void FaceFinder::releaseFaceFilters()
+{
+    impl->warper.reset();
+    impl->rotater.reset();
+}
+
+GLuint FaceFinder::stabilize(GLuint inputTexId, const cv::Size& inputSizeUp, const ScenePrimitives& scene)
+{
+    if (!impl->warper)
+    {
+        initFaceFilters(inputSizeUp); // first use
+    }
+
+    // The (smoothed) transformation is computed with the scene in detect():
+    if (scene.stabilization().has)
+    {
+        const cv::Matx44f& MVPt = scene.stabilization().value;
+
+        ogles_gpgpu::Mat44f transform{};
+        std::copy(MVPt.val, MVPt.val + 16, &transform.data[0][0]);
+        impl->warper->setTransformMatrix(transform);
+    }
+
+    impl->warper->process(inputTexId, 1, GL_TEXTURE_2D);
+    return impl->rotater->getOutputTexId();
+}
+
+void FaceFinder::init(const cv::Size& inputSize)
+{
+    //impl->logger->set_level(spdlog::level::err);
+
+    // Programs built below (and later) go through the binary cache:
+    if (!impl->shaderCache.empty())
+    {
+        ogles_gpgpu::ProgramCache::setInstance(std::make_shared<ogles_gpgpu::ProgramCache>(impl->shaderCache));
+    }
+
+    impl->doOptimizedPipeline &= static_cast<bool>(impl->threads);
+    impl->doLandmarkTiles &= (impl->doOptimizedPipeline && impl->doLandmarks);
+    impl->doGpuRegression &= (!impl->doOptimizedPipeline && impl->doLandmarks);
+    impl->doComputeAcf &= AcfComputeBuilder::isSupported();
+
+    if (impl->doGpuTiming)
+    {
+        impl->gpuTimer = drishti::core::make_unique<ogles_gpgpu::GpuTimer>();
+        if (!impl->gpuTimer->good())
+        {
+            impl->logger->warn("FaceFinder: GPU timer queries are not supported by this context");
+            impl->gpuTimer.reset();
+        }
+    }
+
+    // The texture FIFOs are sized for the pipeline depth, so a loaded device is only handled here:
+    impl->powerNominal.interval = impl->faceFinderInterval;
+    impl->powerNominal.pipelineDepth = impl->pipelineDepth;
+    if (impl->powerCallback)
+    {
+        impl->powerPlan = impl->powerPolicy(impl->powerCallback(), impl->powerNominal);
+        impl->pipelineDepth = impl->powerPlan.pipelineDepth;
+    }
+
+    impl->latency = impl->doOptimizedPipeline ? std::max(impl->pipelineDepth, 2) : 0;
+    impl->start = impl->clock ? impl->clock() : HighResolutionClock::now();
+
+    auto inputSizeUp = inputSize;
+    bool hasTranspose = ((impl->outputOrientation / 90) % 2);
+    if (hasTranspose)
+    {
+        std::swap(inputSizeUp.width, inputSizeUp.height);
+    }
+
+    // Working resolution: the detection plan and the face model use working pixels (the
+    // camera intrinsics are scaled), so only the front end sees camera resolution frames:
+    impl->fullSizeUp = inputSizeUp;
+    if ((impl->workingWidth > 0) && (impl->workingWidth < inputSizeUp.width))
+    {
+        impl->workingScale = static_cast<float>(impl->workingWidth) / static_cast<float>(inputSizeUp.width);
+        inputSizeUp = { impl->workingWidth, std::max(cvRound(inputSizeUp.height * impl->workingScale), 1) };
+
+        const float s = impl->workingScale;
+        auto intrinsic = impl->sensor->intrinsic();
+        intrinsic.m_fx = intrinsic.m_fx.get() * s;
+        intrinsic.m_c = intrinsic.m_c.get() * s;
+        intrinsic.setSize({ cvRound(intrinsic.getSize().width * s), cvRound(intrinsic.getSize().height * s) });
+        intrinsic.m_pixelSize = intrinsic.m_pixelSize.get() / s;
+        impl->sensor = std::make_shared<drishti::sensor::SensorModel>(intrinsic, impl->sensor->extrinsic());
+    }
+
+    impl->faceEstimator = std::make_shared<drishti::face::FaceModelEstimator>(*impl->sensor);
+    initStages(inputSizeUp);
+
+    if (impl->doEyeResolution && impl->faceDetector)
+    {
+        // Eyes are regressed in the regression image (working pixels scaled by regressionScale):
+        auto resolution = impl->eyeResolutionSettings;
+        resolution.focalLength = impl->sensor->intrinsic().getFocalLength() * impl->regressionScale;
+        impl->faceDetector->setEyeResolution(resolution);
+    }
+
+    if (impl->doGpuRegression && impl->faceDetector && drishti::face::ShapePredictorGPU::isSupported())
+    {
+        impl->faceDetector->setRegressionBackend(std::make_shared<drishti::face::ShapePredictorGPU>());
+    }
+
+    if (impl->doAdaptiveDetection)
+    {
+        impl->detectionScheduler = drishti::core::make_unique<DetectionScheduler>(impl->detectionSettings);
+    }
+
+    using core::MemoryRegistry;
+    auto& registry = MemoryRegistry::get();
+    impl->memoryUsage.clear();
+    impl->memoryUsage.push_back(registry.add(MemoryRegistry::kTexture, "FaceFinder", [this]() { return impl->textureBytes.load(); }));
+    impl->memoryUsage.push_back(registry.add(MemoryRegistry::kPool, "FaceFinder", [this]() { return impl->poolBytes.load(); }));
+    impl->memoryUsage.push_back(registry.add(MemoryRegistry::kScratch, "FaceFinder", [this]() { return impl->frameArena.getCapacity(); }));
+    updateMemoryUsage();
+}
+
+// GL objects (and the pools) are only measured on the GL thread, the totals are published
+// for MemoryRegistry probes.  Only the output textures of each stage are visible here (the
+// ACF pipeline and intermediate passes aren't), so the texture total is a lower bound.
+void FaceFinder::updateMemoryUsage()
+{
+    auto getBytes = [](ogles_gpgpu::ProcInterface* proc) -> std::size_t {
+        return proc ? std::size_t(proc->getOutFrameW()) * std::size_t(proc->getOutFrameH()) * 4 : 0;
+    };
+
+    std::size_t textureBytes = 0;
+    for (auto* fifo : { impl->fifo.get(), impl->fullFifo.get() })
+    {
+        for (int i = 0; fifo && (i < static_cast<int>(fifo->getBufferCount())); i++)
+        {
+            textureBytes += getBytes((*fifo)[i]);
+        }
+    }
+
+    ogles_gpgpu::ProcInterface* procs[] = {
+        impl->eyeFilter.get(),
+        impl->ellipsoPolar[0].get(),
+        impl->ellipsoPolar[1].get(),
+        impl->eyeFlow.get(),
+        impl->eyeFlowCells.get(),
+        impl->eyeFlowRegions.get(),
+#if DRISHTI_HCI_WITH_BLOBS
+        impl->blobFilter.get(),
+#endif
+        impl->sceneFlowInput.get(),
+        impl->sceneFlow.get(),
+        impl->sceneFlowGrid.get(),
+        impl->warper.get(),
+        impl->rotater.get(),
+        impl->frontEndUpright.get(),
+        impl->frontEnd.get()
+    };
+    for (auto* proc : procs)
+    {
+        textureBytes += getBytes(proc);
+    }
+    for (const auto& proc : impl->grabProcs)
+    {
+        textureBytes += getBytes(proc.get());
+    }
+    if (impl->texturePool)
+    {
+        textureBytes += impl->texturePool->getAllocatedBytes();
+    }
+    impl->textureBytes = textureBytes;
+
+    impl->poolBytes = impl->pyramids ? (impl->pyramids->allocated() * impl->pyramidBytes) : 0;
+}
+
+template <typename Container>
+void push_fifo(Container& container, typename Container::value_type value, int size)
+{
+    container.push_front(std::move(value));
+    if (container.size() > size)
+    {
+        container.pop_back();
+    }
+}
+
+// ogles_gpgpu::VideoSource can support list of subscribers
+//
+//       +=> FIFO[1][0] == ACF ====>
+// VIDEO |       |
+//       +=======+======== FLOW ===>
+
+std::pair<GLuint, ConstScenePrimitivesPtr> FaceFinder::runFast(const FrameInput& frame2, bool doDetection)
+{
+    FrameInput frame1;
+    frame1.size = frame2.size;
+
+    // Each scene is built once (by the GPU readback and the CPU job), then shared read only:
+    const auto frameIndex = impl->frameIndex;
+    ScenePrimitivesPtr scene2 = impl->scenePool.acquire(frameIndex);
+    ScenePrimitivesPtr scene1 = impl->scenePool.acquire(frameIndex ? (frameIndex - 1) : 0);
+    scene2->m_time = impl->frameTime(scene2->m_frameIndex);
+    scene1->m_time = impl->frameTime(scene1->m_frameIndex);
+    ScenePrimitivesPtr outputScene = scene2;
+
+    if (impl->fifo->getBufferCount() > 0)
+    {
+        // read GPU results for frame n-1
+
+        // Here we always trigger GPU pipeline reads
+        // to ensure upright + redeuced grayscale images will
+        // be available for regression, even if we won't be using ACF detection.
+        {
+            auto span = impl->tracer->scope(kAcfRead, scene1->m_frameIndex);
+            impl->acf->getChannels();
+        }
+
+        if (impl->sceneFlowGrid)
+        {
+            // Flow from frame n-2 to n-1 (processed in the last call):
+            auto span = impl->tracer->scope(kGlobalMotion, scene1->m_frameIndex);
+            readGlobalMotion(*scene1);
+        }
+
+        const bool hasChannels = impl->acf->getChannelStatus();
+        if (hasChannels)
+        {
+            // If the ACF textures were loaded in the last call, then we know
+            // that detections were requrested for the last frame, and we will
+            // populate an ACF pyramid for the detection step.
+            auto span = impl->tracer->scope(kFill, scene1->m_frameIndex);
+            scene1->m_P = impl->pyramids->acquire();
+            fill(*scene1->m_P);
+        }
+
+        // ### Grayscale image ###
+        if (impl->doLandmarks)
+        {
+            if (impl->faceTileFilter)
+            {
+                // Frame n-1 is still at the head of the FIFO:
+                renderFaceTiles((*impl->fifo)[modulo(-1, impl->fifo->getBufferCount())]->getOutputTexId(), *scene1, hasChannels);
+            }
+            else
+            {
+                scene1->image() = impl->acf->getGrayscale();
+            }
+
+            // ### Eye patches for frame n-1 ###
+            if (impl->eyePatchFilter && impl->eyePatchFilter->isAsync())
+            {
+                fetchEyePatches(*scene1); // queued in the last call
+            }
+            else
+            {
+                // Synchronous: frame n-1 is still at the head of the FIFO
+                renderEyePatches((*impl->fifo)[modulo(-1, impl->fifo->getBufferCount())]->getOutputTexId(), *scene1);
+            }
+        }
+    }
+
+    if (impl->doPyramidUpdate)
+    {
+        updatePyramidPlan(); // results for frame n-1 have been read from the current ACF
+    }
+
+    // Start GPU pipeline for the current frame, immediately after we have
+    // retrieved results for the previous frame.
+    computeAcf(frame2, false, doDetection);
     GLuint texture2 = impl->acf->first()->getOutputTexId(), texture0 = 0, outputTexture = texture2;
+    bool isReused = false; // (kReuseLast) no new scene for this frame
+
+    if (impl->sceneFlowInput)
+    {
+        auto gpu = gpuScope(kGpuFlow, frameIndex);
+        impl->sceneFlowInput->process(texture2, 1, GL_TEXTURE_2D); // read back in the next call
+    }
+
+    if (impl->doLandmarks && impl->eyePatchFilter && impl->eyePatchFilter->isAsync())
+    {
+        // Queue the eye patch readback for frame n behind the ACF shaders (fetched in the next call):
+        renderEyePatches(texture2, *scene2);
+    }
 
     if (impl->fifo->getBufferCount() > 0)
     {
-        if (impl->fifo->getBufferCount() >= 2)
+        // With a pipeline depth (latency) of N we keep N-1 CPU scene jobs in flight,
+        // so the oldest job normally corresponds to frame n-N, which is still in the FIFO.
+        const auto depth = impl->latency;
+        if (!impl->sceneRing)
         {
-            const int index = modulo(-2, impl->fifo->getBufferCount());
+            // Slots for the jobs in flight and for late jobs dropped by kDropOldest.  The face
+            // tracker and detector state are order dependent, and the single worker runs the
+            // jobs in frame order, so detect() calls never overlap.
+            impl->sceneRing = drishti::core::make_unique<Impl::SceneRing>(depth + 1, [this](Impl::SceneJob& job) {
+                detect(job.frame, *job.scene, job.scene->m_P != nullptr);
+                if (doAnnotations())
+                {
+                    // prepare line drawings for rendering while gpu is busy
+                    job.scene->draw(impl->renderFaces, impl->renderPupils, impl->renderCorners);
+                }
+            });
+        }
+        auto& ring = *impl->sceneRing;
 
-            // Retrieve CPU processing for frame n-2
-            scene0 = impl->scene.get();                        // scene n-2
-            texture0 = (*impl->fifo)[index]->getOutputTexId(); // texture n-2
-            updateEyes(texture0, scene0);                      // update the eye texture
-            
-            outputTexture = paint(scene0, texture0);
-            outputScene = &scene0;
+        // Release late jobs dropped in earlier calls once they complete:
+        impl->releaseAbandonedScenes();
+
+        bool doSubmit = true;
+        const bool isLate = isBusy();
+        if (isLate && (impl->backpressure == kDropOldest))
+        {
+            // Keep the job running (tracker state is order dependent) but don't wait for it:
+            impl->abandonedScenes++;
+            impl->droppedFrames++;
+            impl->isDropped = true;
+        }
+        else if (isLate && (impl->backpressure == kReuseLast))
+        {
+            // Don't wait: the late job is retrieved in a later call, and with all jobs still
+            // in flight the CPU can't take frame n-1 either:
+            doSubmit = false;
+            isReused = true;
         }
+        else if (impl->getSceneJobCount() >= static_cast<std::size_t>(depth - 1))
+        {
+            // Retrieve CPU processing for frame n-N (kBlock waits here):
+            ring.wait(impl->abandonedScenes);
+            impl->releaseAbandonedScenes();
+            ScenePrimitivesPtr scene0 = std::move(ring.get(0).scene); // scene n-N
+            ring.pop();
+
+            // Late results (kReuseLast) are painted while their frame is still in the FIFOs,
+            // otherwise only the tracker state is kept:
+            const int age = static_cast<int>(frameIndex - scene0->m_frameIndex);
+            if ((age <= static_cast<int>(impl->fifo->getBufferCount())) && (!impl->fullFifo || (age <= depth)))
+            {
+                texture0 = (*impl->fifo)[modulo(-age, impl->fifo->getBufferCount())]->getOutputTexId(); // texture n-N
+                updateEyes(getEyeTexture(texture0, age), *scene0); // update the eye texture
 
-        // Run CPU detection + regression for frame n-1
-        impl->scene = impl->threads->process([scene1, frame1, this]() {
-            ScenePrimitives sceneOut = scene1;
-            detect(frame1, sceneOut, scene1.m_P != nullptr);
-            if (doAnnotations())
+                auto span = impl->tracer->scope(kPaint, scene0->m_frameIndex);
+                outputTexture = paint(*scene0, texture0);
+                outputScene = std::move(scene0);
+            }
+            else
             {
-                // prepare line drawings for rendering while gpu is busy
-                sceneOut.draw(impl->renderFaces, impl->renderPupils, impl->renderCorners);
+                isReused = true;
             }
-            return sceneOut;
-        });
+        }
+
+        // Run CPU detection + regression for frame n-1 (the slots are preallocated, no task
+        // is allocated per frame).  A ring full of late jobs skips the frame instead of waiting.
+        Impl::SceneJob* job = doSubmit ? ring.acquire() : nullptr;
+        if (job)
+        {
+            job->frame = frame1;
+            job->scene = std::move(scene1);
+            ring.push();
+        }
+    }
+
+    if (isReused)
+    {
+        // Output the last scene again (no paint, no callbacks):
+        impl->droppedFrames++;
+        impl->isDropped = true;
+        if (impl->outputTexture)
+        {
+            outputTexture = impl->outputTexture;
+        }
     }
 
     // Maintain a history for last N textures and scenes.
-    // Note that with the current optimized pipeline (i.e., runFast) we introduce a latency of T=2
-    // so when we the texture for time T=2 to the OpenGL FIFO we wil push the most recent available
-    // scene for T-2 (T=0) to our scene buffer.
+    // Note that with the current optimized pipeline (i.e., runFast) we introduce a latency of T=N
+    // (Settings::pipelineDepth, default N=2) so when we add the texture for time T to the OpenGL FIFO
+    // we will push the most recent available scene for T-N to our scene buffer.
     //
     // IMAGE : { image[n-0], image[n-1], image[n-2] }
-    // SCENE : { __________, __________, scene[n-2], ... }
-    
-    // Add the current frame to FIFO
-    impl->fifo->useTexture(texture2, 1);
-    impl->fifo->render();
+    // SCENE : { __________, __________, scene[n-2], ... } (N=2)
+
+    {
+        // Add the current frame to FIFO
+        auto span = impl->tracer->scope(kFifoRender, frameIndex);
+        auto gpu = gpuScope(kGpuFifo, frameIndex);
+        impl->fifo->useTexture(texture2, 1);
+        impl->fifo->render();
+    }
 
     // Clear face motion estimate, update window
     impl->faceMotion = { 0.f, 0.f, 0.f };
-    push_fifo(impl->scenePrimitives, *outputScene, impl->history);
+    if (isReused && !impl->scenePrimitives.empty())
+    {
+        return std::make_pair(outputTexture, impl->scenePrimitives.front());
+    }
+    push_fifo(impl->scenePrimitives, outputScene, impl->history);
 
-    return std::make_pair(outputTexture, *outputScene);
+    return std::make_pair(outputTexture, ConstScenePrimitivesPtr(std::move(outputScene)));
 }
 
-std::pair<GLuint, ScenePrimitives> FaceFinder::runSimple(const FrameInput& frame1, bool doDetection)
+std::pair<GLuint, ConstScenePrimitivesPtr> FaceFinder::runSimple(const FrameInput& frame1, bool doDetection)
 {
     // Run GPU based processing on current thread and package results as a task for CPU
     // processing so that it will be available on the next frame.  This method will compute
     // ACF output using shaders on the GPU, and may optionally extract other GPU related
     // features.
-    ScenePrimitives scene1(impl->frameIndex), *outputScene = nullptr; // time: n+1 and n
+    ScenePrimitivesPtr outputScene = impl->scenePool.acquire(impl->frameIndex); // time: n+1 and n
+    outputScene->m_time = impl->frameTime(impl->frameIndex);
+    ScenePrimitives& scene1 = *outputScene;
+    if (impl->doPyramidUpdate)
+    {
+        updatePyramidPlan();
+    }
     preprocess(frame1, scene1, doDetection);
 
     // Initialize input texture with ACF upright texture:
     GLuint texture1 = impl->acf->first()->getOutputTexId(), outputTexture = 0;
 
+    if (impl->sceneFlowInput)
+    {
+        {
+            auto gpu = gpuScope(kGpuFlow, scene1.m_frameIndex);
+            impl->sceneFlowInput->process(texture1, 1, GL_TEXTURE_2D);
+        }
+        auto span = impl->tracer->scope(kGlobalMotion, scene1.m_frameIndex);
+        readGlobalMotion(scene1);
+    }
+
+    if (impl->doLandmarks)
+    {
+        renderEyePatches(texture1, scene1);
+    }
+
     detect(frame1, scene1, doDetection);
 
     if (doAnnotations())
     {
-        updateEyes(texture1, scene1);
+        updateEyes(getEyeTexture(texture1, 0), scene1);
 
         // Excplicit output variable configuration:
         scene1.draw(impl->renderFaces, impl->renderPupils, impl->renderCorners);
+
+        auto span = impl->tracer->scope(kPaint, scene1.m_frameIndex);
         outputTexture = paint(scene1, texture1); // was 1
-        outputScene = &scene1;
     }
     else
     {
         outputTexture = texture1;
-        outputScene = &scene1; // empty
     }
 
-    // Add the current frame to FIFO
-    impl->fifo->useTexture(texture1, 1);
-    impl->fifo->render();
+    {
+        // Add the current frame to FIFO
+        auto span = impl->tracer->scope(kFifoRender, scene1.m_frameIndex);
+        auto gpu = gpuScope(kGpuFifo, scene1.m_frameIndex);
+        impl->fifo->useTexture(texture1, 1);
+        impl->fifo->render();
+    }
 
     // Clear face motion estimate, update window:
     impl->faceMotion = { 0.f, 0.f, 0.f };
-    push_fifo(impl->scenePrimitives, *outputScene, impl->history);
+    push_fifo(impl->scenePrimitives, outputScene, impl->history);
 
-    return std::make_pair(outputTexture, *outputScene);
+    return std::make_pair(outputTexture, ConstScenePrimitivesPtr(std::move(outputScene)));
 }
 
 GLuint FaceFinder::operator()(const FrameInput& frame1)
 {
-    // clang-format off
-    std::string methodName = DRISHTI_LOCATION_SIMPLE;
-    core::ScopeTimeLogger faceFinderTimeLogger = [this, methodName](double elapsed)
+    core::ScopeTimeLogger faceFinderTimeLogger = impl->tracer->scope(kFrame, impl->frameIndex);
+
+    if ((impl->backpressure == kDropNewest) && isBusy())
     {
-        if (impl->logger)
-        {
-            impl->logger->info("TIMING:{} : {} full={}", methodName, impl->timerInfo, elapsed);
-        }
-    };
-    // clang-format on
+        impl->droppedFrames++;
+        return impl->outputTexture;
+    }
+
+    if (impl->isSuspended)
+    {
+        return 0; // see resume()
+    }
 
-    // Get current timestamp
-    const auto& now = faceFinderTimeLogger.getTime();
+    updateOrientation(); // (optional) pending setOrientation()
+    pollGpuTimer();      // (optional) GPU spans of earlier frames
+
+    // (optional) Working resolution front end:
+    const FrameInput frame = impl->frontEnd ? downscale(frame1) : frame1;
+
+    // Get current timestamp (the interval is measured between frames scheduled for detection,
+    // so that it doesn't depend on when the pipelined detection completes):
+    const auto now = impl->hasCaptureTime ? impl->captureTime : (impl->clock ? impl->clock() : faceFinderTimeLogger.getTime());
+    impl->hasCaptureTime = false;
+    impl->frameTime(impl->frameIndex) = now;
     const bool doDetection = needsDetection(now);
+    if (doDetection)
+    {
+        impl->detectionTime = now;
+        impl->hasDetection = true;
+    }
+    impl->isDropped = false;
+
+    const auto start = HighResolutionClock::now(); // frame latency (recorder)
 
     GLuint outputTexture = 0;
-    ScenePrimitives outputScene;
+    ConstScenePrimitivesPtr outputScene;
     if (impl->doOptimizedPipeline)
     {
-        std::tie(outputTexture, outputScene) = runFast(frame1, doDetection);
+        std::tie(outputTexture, outputScene) = runFast(frame, doDetection);
     }
     else
     {
-        std::tie(outputTexture, outputScene) = runSimple(frame1, doDetection);
+        std::tie(outputTexture, outputScene) = runSimple(frame, doDetection);
     }
 
-    if (impl->imageLogger && outputScene.faces().size() && !outputScene.image().empty())
+    if (impl->imageLogger && outputScene->faces().size() && !outputScene->image().empty())
     {
-        (impl->imageLogger)(outputScene.image());
+        (impl->imageLogger)(outputScene->image());
+    }
+
+    if (impl->recorder && !impl->isDropped)
+    {
+        const double latency = std::chrono::duration<double>(HighResolutionClock::now() - start).count();
+        (*impl->recorder)(*outputScene, outputScene->m_time, latency);
     }
 
     impl->frameIndex++; // increment frame index
 
     if (impl->scenePrimitives.size() >= 2)
     {
-        if (impl->scenePrimitives[0].faces().size() && impl->scenePrimitives[1].faces().size())
+        if (impl->scenePrimitives[0]->faces().size() && impl->scenePrimitives[1]->faces().size())
         {
-            const auto& face0 = impl->scenePrimitives[0].faces()[0];
-            const auto& face1 = impl->scenePrimitives[1].faces()[0];
+            const auto& face0 = impl->scenePrimitives[0]->faces()[0];
+            const auto& face1 = impl->scenePrimitives[1]->faces()[0];
             const cv::Point3f delta = (*face0.eyesCenter - *face1.eyesCenter);
             impl->faceMotion = delta; // active face motion
         }
@@ -610,13 +1560,19 @@ GLuint FaceFinder::operator()(const FrameInput& frame1)
 
     try
     {
-        notifyListeners(outputScene, now, impl->fifo->isFull(), outputTexture);
+        if (!impl->isDropped)
+        {
+            notifyListeners(*outputScene, outputScene->m_time, impl->fifo->isFull(), outputTexture);
+        }
     }
     catch (...)
     {
         // noop
     }
 
+    updateMemoryUsage();
+
+    impl->outputTexture = outputTexture;
     return outputTexture;
 }
 
@@ -646,20 +1602,17 @@ void FaceFinder::notifyListeners
     // NOTE: This must occur in the main OpenGL thread:
     std::vector<FaceMonitor::FaceImage> frames;
 
-    // Build a list of active requests:
-    std::vector<FaceMonitor::Request> requests(impl->faceMonitorCallback.size());
-
-    FaceMonitor::Request request{0,false,false,false,false};
-
-    // Check each listener's request() methods to see if any images are requested
-    // and format a request as the union of all individual requests:
-    for (int i = 0; i < impl->faceMonitorCallback.size(); i++)
+    // The history is updated on this thread, so the listener views need no copies or locks:
+    if (impl->faceHistory)
     {
-        auto& callback = impl->faceMonitorCallback[i];
-        requests[i] = callback->request(scene.faces(), now, tex);
-        request |= requests[i]; // accumulate requests
+        impl->faceHistory->update(scene.faces(), scene.tracks(), now, scene.m_frameIndex);
     }
 
+    // Check the request() method of each listener that is due (see FaceMonitor::Schedule)
+    // and format a request as the union of all individual requests, so the frames are
+    // read back once for all listeners:
+    FaceMonitor::Request request = impl->faceMonitorCallback.request(scene.faces(), now, tex, impl->faceHistory.get());
+
     // Clip request to available history.  The ignoreLatestFramesInMonitor
     // state flag is specific to the optimized pipeline (w/ built-in latency)
     // and indicates that the user is not interested in viewing the latest
@@ -709,7 +1662,7 @@ void FaceFinder::notifyListeners
         {
             // ### collect face images ###
             std::vector<core::ImageView> faces;
-            dumpFaces(faces, request.n, request.getImage, skipFrames);
+            dumpFaces(faces, request, skipFrames);
             if (faces.size() && request.getFrames)
             {
                 const int length = static_cast<int>(std::min(faces.size(), frames.size()));
@@ -719,7 +1672,7 @@ void FaceFinder::notifyListeners
                     if(i >= metadataOffset)
                     {
                         const int index = i - impl->latency;
-                        frames[i].faceModels = impl->scenePrimitives[index].faces();
+                        frames[i].faceModels = impl->scenePrimitives[index]->faces();
                     }
                 }
             }
@@ -743,18 +1696,26 @@ void FaceFinder::notifyListeners
         }
     }
 
-    // Pass down all of the populated face images pointers w/ associated models
-    for (int i = 0; i < impl->faceMonitorCallback.size(); i++)
+    // The FIFO textures are overwritten as frames arrive, so retained textures are GPU copies
+    // leased from the pool, and clients hold them for as long as they need:
+    if (request.retainTexture)
     {
-        if (requests[i].n)
-        {
-            impl->faceMonitorCallback[i]->grab(frames, isInit);
-        }
-        else
+        for (auto& frame : frames)
         {
-            impl->faceMonitorCallback[i]->grab({}, isInit);
+            for (auto* texture : { &frame.image.texture, &frame.eyes.texture })
+            {
+                if (texture->texId && (texture->size.area() > 0) && !texture->lease)
+                {
+                    auto lease = impl->texturePool->copy(texture->texId, texture->size);
+                    texture->texId = lease->texId;
+                    texture->lease = std::move(lease);
+                }
+            }
         }
     }
+
+    // Pass down all of the populated face images pointers w/ associated models
+    impl->faceMonitorCallback.grab(frames, isInit);
 }
 
 GLuint FaceFinder::paint(const ScenePrimitives& scene, GLuint inputTexture)
@@ -777,6 +1738,15 @@ void FaceFinder::initColormap()
     colorsU8C3.convertTo(impl->colors32FC3, CV_32FC3, 1.0 / 255.0);
 }
 
+const cv::Mat3f& FaceFinder::getColormap()
+{
+    if (impl->colors32FC3.empty())
+    {
+        initColormap();
+    }
+    return impl->colors32FC3;
+}
+
 void FaceFinder::computeAcf(const FrameInput& frame, bool doLuv, bool doDetection)
 {
     glDisable(GL_BLEND);
@@ -787,6 +1757,7 @@ void FaceFinder::computeAcf(const FrameInput& frame, bool doLuv, bool doDetectio
     impl->acf->setDoLuvTransfer(doLuv);
     impl->acf->setDoAcfTransfer(doDetection);
 
+    auto gpu = gpuScope(kGpuAcf, impl->frameIndex);
     (*impl->acf)(frame);
 }
 
@@ -812,7 +1783,7 @@ std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfGpu(const FrameInpu
 
         if (impl->acf->getChannelStatus())
         {
-            P = std::make_shared<decltype(impl->P)>();
+            P = impl->pyramids->acquire();
             fill(*P);
 
 #if DRISHTI_HCI_FACEFINDER_DEBUG_PYRAMIDS
@@ -831,7 +1802,7 @@ std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfGpu(const FrameInpu
 
 /*
  * Create LUV images in OpenGL ES and uses this as input for
- * CPU based ACF pyramid construction.
+ * CPU (or compute shader) based ACF pyramid construction.
  */
 
 std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfCpu(const FrameInput& frame, bool doDetection)
@@ -848,9 +1819,46 @@ std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfCpu(const FrameInpu
         P = std::make_shared<decltype(impl->P)>();
 
         MatP LUVp = impl->acf->getLuvPlanar();
-        impl->detector->setIsLuv(true);
-        impl->detector->setIsTranspose(true);
-        impl->detector->computePyramid(LUVp, *P);
+        if (impl->doComputeAcf)
+        {
+            if (!impl->acfCompute)
+            {
+                AcfComputeBuilder::Options options;
+                options.shrink = impl->detector->opts.pPyramid->pChns->shrink.get();
+                impl->acfCompute = drishti::core::make_unique<AcfComputeBuilder>(impl->P, options);
+            }
+            impl->doComputeAcf = (*impl->acfCompute)(LUVp, *P); // CPU from now on if the programs fail
+            if (!impl->doComputeAcf)
+            {
+                impl->logger->warn("ACF compute shaders are unavailable, using CPU pyramids: {}", impl->acfCompute->getError());
+            }
+        }
+
+        if (impl->doComputeAcf)
+        {
+            // Done (compute shaders)
+        }
+        else if (impl->threads)
+        {
+            // Spread the planned levels over the shared thread pool:
+            if (!impl->acfBuilder)
+            {
+                AcfPyramidBuilder::Options options;
+                options.shrink = impl->detector->opts.pPyramid->pChns->shrink.get();
+                options.changeBlock = impl->acfChangeBlock;
+                options.changeThreshold = impl->acfChangeThreshold;
+                options.refreshPeriod = impl->acfRefreshPeriod;
+                impl->acfBuilder = drishti::core::make_unique<AcfPyramidBuilder>(impl->P, options);
+            }
+            (*impl->acfBuilder)(LUVp, *P, impl->threads.get());
+        }
+        else
+        {
+            impl->detector->setIsLuv(true);
+            impl->detector->setIsTranspose(true);
+            impl->detector->computePyramid(LUVp, *P);
+            prunePyramid(*P, impl->pyramidScales);
+        }
 
 #if DRISHTI_HCI_FACEFINDER_DEBUG_PYRAMIDS
         std::string home = getenv("HOME");
@@ -871,24 +1879,40 @@ std::shared_ptr<acf::Detector::Pyramid> FaceFinder::createAcfCpu(const FrameInpu
 
 void FaceFinder::preprocess(const FrameInput& frame, ScenePrimitives& scene, bool doDetection)
 {
-    const auto tag = DRISHTI_LOCATION_SIMPLE;
-    std::stringstream ss;
-    core::ScopeTimeLogger scopeTimeLogger = [&](double t) { impl->logger->info("TIMING:{}{}total={}", tag, ss.str(), t); };
-
-    if (impl->doCpuACF)
     {
-        scene.m_P = createAcfCpu(frame, doDetection);
-    }
-    else
-    {
-        core::ScopeTimeLogger scopeTimeLogger = [&](double t) { ss << "acf=" << t << ";"; };
-        scene.m_P = createAcfGpu(frame, doDetection);
+        auto span = impl->tracer->scope(kAcfRead, scene.m_frameIndex);
+        bool isIncremental = false;
+        if (impl->doCpuACF || impl->doComputeAcf)
+        {
+            scene.m_P = createAcfCpu(frame, doDetection);
+            isIncremental = impl->acfBuilder && (impl->acfChangeBlock > 0) && !impl->doComputeAcf && impl->threads;
+        }
+        else
+        {
+            scene.m_P = createAcfGpu(frame, doDetection);
+        }
+
+        // Detections are reused until the incremental pyramid sees a change (see detectOnly()):
+        if (scene.m_P)
+        {
+            if (!isIncremental || impl->acfBuilder->getChanges().isFull || !impl->acfBuilder->getChanges().blocks.empty())
+            {
+                impl->acfChangeFrame = static_cast<std::int64_t>(scene.m_frameIndex);
+            }
+        }
+
+        if (impl->pyramidCache && scene.m_P)
+        {
+            ml::AcfPyramidCache::Entry entry;
+            entry.P = scene.m_P;
+            entry.scale = 1.0f / impl->ACFScale; // full resolution -> detection image
+            impl->pyramidCache->put(ml::AcfPyramidCache::getKey(*impl->detector, static_cast<std::int64_t>(scene.m_frameIndex)), entry);
+        }
     }
 
     // ### Grayscale image ###
     if (impl->doLandmarks)
     {
-        core::ScopeTimeLogger scopeTimeLogger = [&](double t) { ss << "gray=" << t << ";"; };
         scene.image() = impl->acf->getGrayscale();
     }
 }
@@ -904,26 +1928,71 @@ int FaceFinder::detectOnly(ScenePrimitives& scene, bool doDetection)
     // Check to see if detection was already computed
     if (doDetection)
     {
-        core::ScopeTimeLogger scopeTimeLogger = [this](double t) { impl->timerInfo.detectionTimeLogger(t); };
+        auto span = impl->tracer->scope(kDetect, scene.m_frameIndex);
         std::vector<double> scores;
-        (*impl->detector)(*scene.m_P, scene.objects(), &scores);
+
+        // Scan around existing tracks only, with a periodic full scan to pick up new faces:
+        const bool doRois = (impl->doRoiDetection || impl->resumeRois) && !impl->trackedObjects.empty() && (impl->roiScanCount < impl->roiFullScanInterval);
+        impl->resumeRois = false; // see resume()
+
+        // Static scene: the pyramid hasn't changed since the last detector call:
+        const bool isStatic = (impl->acfChangeBlock > 0) && (impl->objectsFrame >= 0) && (impl->acfChangeFrame <= impl->objectsFrame);
+        if (isStatic)
+        {
+            scene.objects() = impl->objects.second;
+            scores = impl->objectScores;
+        }
+        else if (doRois)
+        {
+            impl->roiScanCount++;
+            impl->objectsFrame = static_cast<std::int64_t>(scene.m_frameIndex);
+            detectRois(*scene.m_P, impl->trackedObjects, scene.objects(), scores);
+        }
+        else
+        {
+            impl->roiScanCount = 0;
+            impl->objectsFrame = static_cast<std::int64_t>(scene.m_frameIndex);
+            (*impl->detector)(*scene.m_P, scene.objects(), &scores);
+        }
+
         if (impl->doSingleFace)
         {
             chooseBest(scene.objects(), scores);
         }
         impl->objects = std::make_pair(HighResolutionClock::now(), scene.objects());
+        impl->objectScores = scene.scores() = scores;
     }
     else
     {
         scene.objects() = impl->objects.second;
+        scene.scores() = impl->objectScores;
     }
 
     return scene.objects().size();
 }
 
+int FaceFinder::detectRois(const acf::Detector::Pyramid& P, const std::vector<cv::Rect>& rois, std::vector<cv::Rect>& objects, std::vector<double>& scores)
+{
+    // Padded track regions, searched at the two levels nearest the track width:
+    std::vector<ml::AcfSearchRegion> regions;
+    for (const auto& roi : rois)
+    {
+        const int pad = static_cast<int>(static_cast<float>(roi.width) * impl->roiPadding + 0.5f);
+
+        ml::AcfSearchRegion region;
+        region.roi = { roi.x - pad, roi.y - pad, roi.width + pad * 2, roi.height + pad * 2 };
+        region.minWidth = region.maxWidth = static_cast<float>(roi.width);
+        region.maxLevels = 2;
+        regions.push_back(region);
+    }
+
+    // Overlapping search regions and adjacent levels can report the same face:
+    return ml::detectAcfRegions(*impl->detector, P, regions, objects, scores, 0.5);
+}
+
 void FaceFinder::scaleToFullResolution(std::vector<drishti::face::FaceModel>& faces)
 {
-    const float Srf = 1.0f / impl->acf->getGrayscaleScale();
+    const float Srf = 1.0f / impl->regressionScale;
     const cv::Matx33f Hrf = transformation::scale(Srf);
     for (auto& f : faces)
     {
@@ -943,13 +2012,35 @@ void FaceFinder::scaleToFullResolution(std::vector<drishti::face::FaceModel>& fa
 int FaceFinder::detect(const FrameInput& frame, ScenePrimitives& scene, bool doDetection)
 {
     //impl->logger->set_level(spdlog::level::off);
-    core::ScopeTimeLogger scopeTimeLogger = [this](double t) {
-        impl->logger->info("FULL_CPU_PATH: {}", t);
-    };
+    auto cpuPathSpan = impl->tracer->scope(kCpuPath, scene.m_frameIndex);
+
+    // Regression time loggers installed in init2() tag their spans with this frame:
+    impl->detectFrameIndex = scene.m_frameIndex;
+
+    // Frame temporaries (eye crops, resized planes, ...) are released together when detect() returns:
+    core::FrameArena::Scope arenaScope(&impl->frameArena);
+    core::scope_guard arenaReset = [&]() { impl->frameArena.reset(); };
+
+    if (!impl->hasModels)
+    {
+        initModels(); // first detection: wait for the regressors
+        initBudget();
+    }
+
+    // Knobs are applied here, between scene jobs (detect() calls are serialized):
+    if (impl->budget)
+    {
+        impl->budget->update(*impl->tracer, scene.m_frameIndex);
+    }
+    if (impl->powerCallback)
+    {
+        updatePower(scene.m_frameIndex);
+    }
 
     // Start with empty face detections:
     std::vector<drishti::face::FaceModel> faces;
     drishti::face::FaceDetector::PaddedImage Ib(scene.image(), { { 0, 0 }, scene.image().size() });
+    Ib.eyes = scene.eyePatches(); // GPU eye crops (if any) replace CPU crop + flip + resize
 
     if (impl->detector && (!doDetection || scene.m_P))
     {
@@ -968,9 +2059,9 @@ int FaceFinder::detect(const FrameInput& frame, ScenePrimitives& scene, bool doD
 
             //impl->imageLogger(gray);
             const bool isDetection = true;
-            const float Sdr = impl->ACFScale * impl->acf->getGrayscaleScale();
+            const float Sdr = impl->ACFScale * impl->regressionScale;
             const cv::Matx33f Hdr = transformation::scale(Sdr);
-            impl->faceDetector->setDoIrisRefinement(true);
+            impl->faceDetector->setDoIrisRefinement(impl->doIrisRefinement);
             impl->faceDetector->refine(Ib, faces, Hdr, isDetection);
 
             // Scale faces from regression to level 0.
@@ -992,14 +2083,38 @@ int FaceFinder::detect(const FrameInput& frame, ScenePrimitives& scene, bool doD
         //   2) refine the face model
         //   3) map back to the full resolution image
         
-        const float Sfr = impl->acf->getGrayscaleScale(); // full->regression
+        const float Sfr = impl->regressionScale; // full->regression
         const cv::Matx33f Hfr = transformation::scale(Sfr);
+
+        if (!scene.correspondences().empty())
+        {
+            scene.motion() = impl->motionEstimator(scene.correspondences());
+            if (scene.motion().valid && impl->doTrackPrediction)
+            {
+                // Camera motion at the previous face positions (assigned to the containing tracks):
+                const cv::Matx33f& H = scene.motion().H;
+                for (const auto& c : impl->motionAnchors)
+                {
+                    const cv::Point3f q = H * cv::Point3f(c.x, c.y, 1.f);
+                    impl->faceTracker->addMotion(c, cv::Point2f(q.x, q.y) - c);
+                }
+            }
+        }
+
         drishti::face::FaceTracker::FaceTrackVec tracksOut;
-        (*impl->faceTracker)(faces, tracksOut);
+        drishti::face::FaceTracker::Measurements measurements;
+        measurements.image = scene.image(); // regression resolution
+        measurements.H = Hfr;
+        if (scene.scores().size() == faces.size())
+        {
+            measurements.scores = scene.scores();
+        }
+        (*impl->faceTracker)(faces, tracksOut, measurements);
 
         // Clear the face vector and use this to store tracks that don't receive
         // detection assignments -- we will need to refine the landmarks separately
         faces.clear();
+        std::vector<std::size_t> predicted; // track identifiers of the faces to refine
         for (auto& f : tracksOut)
         {
             if (f.second.misses > 0)
@@ -1007,39 +2122,281 @@ int FaceFinder::detect(const FrameInput& frame, ScenePrimitives& scene, bool doD
                 // Here we map tracks that received no detection assignment to
                 // the regression image resolution for subsequent refinement.
                 faces.push_back(Hfr * f.first);
+                predicted.push_back(f.second.identifier);
             }
             else
             {
-                // Each track that was assigned to a detection will have valid
-                // landmarks and can simply be copied to the face vector.
-                scene.faces().emplace_back(f.first);
+                // Each track that was assigned to a detection will have valid
+                // landmarks and can simply be copied to the face vector.
+                scene.faces().emplace_back(f.first);
+                scene.tracks().push_back(f.second.identifier);
+            }
+        }
+
+        // Finally we run the landmark refinement at the operative resolution
+        // for all the unassigned tracks.
+        if(faces.size())
+        {
+            // Predicted tracks start near the solution, so fewer stages may suffice:
+            const int stagesHint = impl->faceDetector->getFaceStagesHint();
+            if (impl->doTrackPrediction && (impl->trackFaceStagesHint > 0))
+            {
+                impl->faceDetector->setFaceStagesHint(std::min(stagesHint, impl->trackFaceStagesHint));
+            }
+
+            if (scene.tiles().empty())
+            {
+                impl->faceDetector->refine(Ib, faces, cv::Matx33f::eye(), false);
+            }
+            else
+            {
+                refineTiles(scene, faces);
+            }
+            impl->faceDetector->setFaceStagesHint(stagesHint);
+            scaleToFullResolution(faces);
+            for (auto& f : faces) 
+            {
+                scene.faces().emplace_back(f);
+            }
+            scene.tracks().insert(scene.tracks().end(), predicted.begin(), predicted.end());
+        }
+
+        // Sort near to far (insertion sort for a few faces), with the track identifiers:
+        auto& sceneFaces = scene.faces();
+        auto& sceneTracks = scene.tracks();
+        if (sceneTracks.size() != sceneFaces.size())
+        {
+            sceneTracks.clear();
+        }
+        for (std::size_t i = 1; i < sceneFaces.size(); i++)
+        {
+            for (std::size_t j = i; (j > 0) && (sceneFaces[j].eyesCenter->z < sceneFaces[j - 1].eyesCenter->z); j--)
+            {
+                std::swap(sceneFaces[j], sceneFaces[j - 1]);
+                if (!sceneTracks.empty())
+                {
+                    std::swap(sceneTracks[j], sceneTracks[j - 1]);
+                }
+            }
+        }
+
+        if (impl->eyeGate)
+        {
+            impl->eyeGate->update(scene.faces());
+        }
+
+        if (impl->detectionScheduler)
+        {
+            impl->detectionScheduler->update(scene.tiles().empty() ? scene.image() : cv::Mat(), scene.faces(), doDetection);
+        }
+
+        if (impl->powerCallback || (impl->secondaryEyeStride > 1))
+        {
+            std::lock_guard<std::mutex> lock(impl->eyeTierMutex);
+            const auto& deferred = impl->eyeTierDeferred;
+            interpolateEyes(scene.faces(), impl->eyeHistory, [&](const face::FaceModel& f) {
+                const cv::Point2f c = (f.getEyeRightCenter() + f.getEyeLeftCenter()) * 0.5f;
+                const float tolerance = f.getInterPupillaryDistance() * 0.25f;
+                return impl->powerSkipEyes || std::any_of(deferred.begin(), deferred.end(), [&](const cv::Point2f& p) {
+                    return cv::norm(p - c) < tolerance;
+                });
+            });
+
+            impl->eyeTierDeferred.clear();
+            impl->eyeTierFaces.clear();
+            for (const auto& f : scene.faces())
+            {
+                impl->eyeTierFaces.push_back((f.getEyeRightCenter() + f.getEyeLeftCenter()) * 0.5f);
+            }
+        }
+
+        if (impl->gazeEstimator)
+        {
+            // Gaze for the final (full resolution) faces, delivered with them to the monitors:
+            for (auto& f : scene.faces())
+            {
+                const auto gaze = (*impl->gazeEstimator)(f);
+                if (gaze.hasEyes[0] && gaze.hasEyes[1])
+                {
+                    f.gaze = gaze.directions;
+                }
+            }
+        }
+    }
+
+    if (impl->doRoiDetection)
+    {
+        // Track regions for the next detection (full resolution -> detection image):
+        const float Sfd = 1.0f / impl->ACFScale;
+        impl->trackedObjects.clear();
+        for (const auto& f : scene.faces())
+        {
+            const cv::Rect roi = f.roi;
+            impl->trackedObjects.emplace_back(cv::Point(cv::Point2f(roi.tl()) * Sfd), cv::Size(cv::Size2f(roi.size()) * Sfd));
+        }
+    }
+
+    if (impl->doGlobalMotion)
+    {
+        impl->motionAnchors.clear();
+        for (const auto& f : scene.faces())
+        {
+            impl->motionAnchors.push_back((cv::Point2f(f.roi->tl()) + cv::Point2f(f.roi->br())) * 0.5f);
+        }
+    }
+
+    // Stabilization for the nearest face (detect() calls are serialized, see runFast()),
+    // following the camera motion when it is available:
+    const cv::Matx33f* motion = scene.motion().valid ? &scene.motion().H : nullptr;
+    if (impl->stabilizer && impl->stabilizer->update(scene.faces().size() ? scene.faces().front() : face::FaceModel(), motion))
+    {
+        scene.stabilization() = impl->stabilizer->getTransformMatrix();
+    }
+
+    // Return the pyramid to the pool (scenes are kept in the history):
+    scene.m_P.reset();
+
+    return 0;
+}
+
+void FaceFinder::renderEyePatches(GLuint inputTexId, ScenePrimitives& scene)
+{
+    // Eye regions are predicted from the most recent tracked faces (full resolution), and
+    // FaceDetector only uses a patch when it overlaps the region found for the current landmarks.
+    if (!impl->eyePatchFilter || impl->scenePrimitives.empty() || impl->scenePrimitives.front()->faces().empty())
+    {
+        return;
+    }
+
+    auto span = impl->tracer->scope(kEyePatches, scene.m_frameIndex);
+    for (const auto& f : impl->scenePrimitives.front()->faces())
+    {
+        cv::Rect2f roiR, roiL;
+        if (f.getEyeRegions(roiR, roiL, DRISHTI_FACE_DETECTOR_EYE_CROP_SCALE) && roiR.area() && roiL.area())
+        {
+            impl->eyePatchFilter->addEyes({ { roiR, roiL } });
+        }
+    }
+
+    const float Sfr = impl->regressionScale; // full->regression
+    auto gpu = gpuScope(kGpuEyePatches, scene.m_frameIndex);
+    if (impl->eyePatchFilter->isAsync())
+    {
+        impl->eyePatchFilter->render(inputTexId, Sfr);
+    }
+    else
+    {
+        (*impl->eyePatchFilter)(inputTexId, Sfr, scene.eyePatches());
+    }
+}
+
+// Tiles around the latest tracked faces between detections, the full frame otherwise:
+void FaceFinder::renderFaceTiles(GLuint inputTexId, ScenePrimitives& scene, bool isDetection)
+{
+    auto span = impl->tracer->scope(kFaceTiles, scene.m_frameIndex);
+
+    const float Sfr = impl->regressionScale; // full->regression
+    bool doTiles = !isDetection && !impl->scenePrimitives.empty() && !impl->scenePrimitives.front()->faces().empty();
+    if (doTiles)
+    {
+        for (const auto& f : impl->scenePrimitives.front()->faces())
+        {
+            const cv::Rect2f roi = f.roi.has ? cv::Rect2f(f.roi.value) : cv::Rect2f();
+            const float padding = impl->landmarkTilePadding * roi.width;
+            const cv::Rect2f padded(roi.x - padding, roi.y - padding, roi.width + padding * 2.f, roi.height + padding * 2.f);
+            if (!roi.area() || !impl->faceTileFilter->addFace(padded, Sfr))
+            {
+                doTiles = false;
+                break;
+            }
+        }
+    }
+
+    if (!(doTiles && (*impl->faceTileFilter)(inputTexId, scene.tiles())))
+    {
+        cv::Mat1b gray;
+        impl->faceTileFilter->clearFaces();
+        (*impl->faceTileFilter)(inputTexId, impl->regressionSize, gray);
+        scene.image() = gray;
+    }
+}
+
+// Each face is refined in tile coordinates within the tile it overlaps most (faces outside
+// the tiles keep the track prediction):
+void FaceFinder::refineTiles(const ScenePrimitives& scene, std::vector<drishti::face::FaceModel>& faces)
+{
+    const auto& tiles = scene.tiles();
+    std::vector<std::vector<int>> groups(tiles.size());
+    for (int i = 0; i < faces.size(); i++)
+    {
+        int best = -1, bestArea = 0;
+        for (int j = 0; j < tiles.size(); j++)
+        {
+            const int area = (faces[i].roi.value & tiles[j].roi).area();
+            if (area > bestArea)
+            {
+                best = j;
+                bestArea = area;
             }
         }
+        if (best >= 0)
+        {
+            groups[best].push_back(i);
+        }
+    }
 
-        // Finally we run the landmark refinement at the operative resolution
-        // for all the unassigned tracks.
-        if(faces.size())
+    for (int j = 0; j < tiles.size(); j++)
+    {
+        if (groups[j].empty())
         {
-            impl->faceDetector->refine(Ib, faces, cv::Matx33f::eye(), false);
-            scaleToFullResolution(faces);
-            for (auto& f : faces) 
+            continue;
+        }
+
+        const cv::Point2f tl(tiles[j].roi.tl());
+        drishti::face::FaceDetector::PaddedImage It(tiles[j].image, { { 0, 0 }, tiles[j].image.size() });
+        for (auto patches : scene.eyePatches())
+        {
+            for (auto& roi : patches.rois)
             {
-                scene.faces().emplace_back(f);
+                roi.x -= tl.x;
+                roi.y -= tl.y;
             }
+            It.eyes.push_back(patches);
         }
 
-        // Sort near to far:
-        std::sort(scene.faces().begin(), scene.faces().end(), [](const face::FaceModel& a, const face::FaceModel& b) {
-            return (a.eyesCenter->z < b.eyesCenter->z);
-        });
+        const cv::Matx33f Hrt = transformation::translate(-tl.x, -tl.y); // regression -> tile
+        std::vector<drishti::face::FaceModel> local;
+        for (const auto& i : groups[j])
+        {
+            local.push_back(Hrt * faces[i]);
+        }
+
+        impl->tileOffset = tiles[j].roi.tl();
+        impl->faceDetector->refine(It, local, cv::Matx33f::eye(), false);
+        impl->tileOffset = {};
+
+        const cv::Matx33f Htr = transformation::translate(tl.x, tl.y);
+        for (int k = 0; k < local.size(); k++)
+        {
+            faces[groups[j][k]] = Htr * local[k];
+        }
     }
+}
 
-    return 0;
+void FaceFinder::fetchEyePatches(ScenePrimitives& scene)
+{
+    double waitTime = 0.0;
+    if (impl->eyePatchFilter->fetch(scene.eyePatches(), &waitTime))
+    {
+        impl->tracer->record(kReadbackWait, scene.m_frameIndex, waitTime);
+    }
 }
 
 void FaceFinder::updateEyes(GLuint inputTexId, const ScenePrimitives& scene)
 {
-    core::ScopeTimeLogger updateEyesLoge = [this](double t) { impl->logger->info("FaceFinder::updateEyes={}", t); };
+    auto span = impl->tracer->scope(kUpdateEyes, scene.m_frameIndex);
+
+    updateEyeStages();
 
     if (scene.faces().size())
     {
@@ -1053,15 +2410,43 @@ void FaceFinder::updateEyes(GLuint inputTexId, const ScenePrimitives& scene)
         impl->eyeFilter->clearFaces();
     }
 
-    // Trigger eye enhancer, triggers blob filter:
-    impl->eyeFilter->process(inputTexId, 1, GL_TEXTURE_2D);
+    // Trigger eye enhancer, then the optional stages that read the eye atlas:
+    GLuint eyeTexId = 0;
+    {
+        auto gpu = gpuScope(kGpuEyeFilter, scene.m_frameIndex);
+        impl->eyeFilter->process(inputTexId, 1, GL_TEXTURE_2D);
+        eyeTexId = impl->eyeFilter->getOutputTexId();
+        for (auto& warp : impl->ellipsoPolar)
+        {
+            if (warp)
+            {
+                warp->process(eyeTexId, 1, GL_TEXTURE_2D);
+            }
+        }
+    }
+    if (impl->eyeFlow)
+    {
+        auto gpu = gpuScope(kGpuFlow, scene.m_frameIndex);
+        impl->eyeFlow->process(eyeTexId, 1, GL_TEXTURE_2D);
+    }
+#if DRISHTI_HCI_WITH_BLOBS
+    if (impl->blobFilter)
+    {
+        auto gpu = gpuScope(kGpuBlobs, scene.m_frameIndex);
+        impl->blobFilter->process(eyeTexId, 1, GL_TEXTURE_2D);
+    }
+#endif
     
     if (scene.faces().size())
     {
         // Limit to points on iris:
         const auto& eyeWarps = impl->eyeFilter->getEyeWarps();
 
-        if (impl->doEyeFlow)
+        if (impl->eyeFlowRegions)
+        {
+            updateEyeFlowRegions();
+        }
+        else if (impl->eyeFlowBgraInterface)
         { // Grab optical flow results:
             const auto flowSize = impl->eyeFlowBgraInterface->getOutFrameSize();
             cv::Mat4b ayxb(flowSize.height, flowSize.width);
@@ -1074,42 +2459,188 @@ void FaceFinder::updateEyes(GLuint inputTexId, const ScenePrimitives& scene)
             extractPoints(corners, features, 1.f);
 
             impl->eyeFlowField.clear();
-            if (features.size())
+            const auto& faceEyeWarps = impl->eyeFilter->getFaceEyeWarps();
+            if (features.size() && faceEyeWarps.size())
             {
-                cv::Matx33f Heye[2] = {
-                    eyeWarps[0].H.inv() * transformation::normalize(ayxb.size()),
-                    eyeWarps[1].H.inv() * transformation::normalize(ayxb.size())
-                };
+                // Eye pairs are stacked vertically (one tile per face), right eye on the left:
+                const cv::Matx33f No = transformation::normalize(ayxb.size());
+                const int tiles = impl->eyeFilter->getMaxFaces();
+                const int tileHeight = std::max(ayxb.rows / tiles, 1);
+
+                // Flow image -> full image for each eye:
+                std::vector<std::array<cv::Matx33f, 2>> Heye(faceEyeWarps.size());
+                for (std::size_t k = 0; k < faceEyeWarps.size(); k++)
+                {
+                    Heye[k] = { { faceEyeWarps[k][0].H.inv() * No, faceEyeWarps[k][1].H.inv() * No } };
+                }
 
                 std::vector<cv::Point2f> flow;
+                std::vector<std::vector<cv::Point2f>> points(faceEyeWarps.size()), motion(faceEyeWarps.size());
                 for (const auto& f : features)
                 {
+                    const int k = std::min(static_cast<int>(f.point.y) / tileHeight, tiles - 1);
+                    if (k >= static_cast<int>(faceEyeWarps.size()))
+                    {
+                        continue;
+                    }
+
                     // Extract flow:
                     const cv::Vec4b& pixel = ayxb(f.point.y, f.point.x);
                     cv::Point2f p(pixel[2], pixel[1]);
                     cv::Point2f d = (p * (2.0f / 255.0f)) - cv::Point2f(1.0f, 1.0f);
                     flow.push_back(d);
 
-                    cv::Point3f q3 = Heye[p.x > ayxb.cols / 2] * f.point;
+                    const cv::Matx33f& H = Heye[k][f.point.x > ayxb.cols / 2];
+                    cv::Point3f q3 = H * f.point;
                     cv::Point2f q2(q3.x / q3.z, q3.y / q3.z);
                     impl->eyeFlowField.emplace_back(q2.x, q2.y, d.x * 100.f, d.y * 100.f);
+
+                    // Flow vector in image coordinates (for track prediction):
+                    cv::Point3f r3 = H * cv::Point3f(f.point.x + d.x, f.point.y + d.y, 1.f);
+                    points[k].push_back(q2);
+                    motion[k].emplace_back(q2 - cv::Point2f(r3.x / r3.z, r3.y / r3.z));
+                }
+
+                if (flow.size())
+                {
+                    impl->eyeMotion = -drishti::geometry::pointMedian(flow);
+                }
+
+                if (impl->doTrackPrediction && impl->faceTracker)
+                {
+                    // One measurement per face tile:
+                    for (std::size_t k = 0; k < points.size(); k++)
+                    {
+                        if (points[k].size())
+                        {
+                            impl->faceTracker->addMotion(drishti::geometry::pointMedian(points[k]), drishti::geometry::pointMedian(motion[k]));
+                        }
+                    }
                 }
-                impl->eyeMotion = -drishti::geometry::pointMedian(flow);
             }
         }
 
+#if DRISHTI_HCI_WITH_BLOBS
         if (impl->blobFilter)
         { // Grab reflection points for eye tracking etc:
-            core::ScopeTimeLogger scopeTimeLogger = [this](double t) { this->impl->timerInfo.blobExtractionTimeLogger(t); };
+            auto span = impl->tracer->scope(kBlobExtraction, scene.m_frameIndex);
 
             const cv::Size filteredEyeSize(impl->blobFilter->getOutFrameW(), impl->blobFilter->getOutFrameH());
             EyeBlobJob single(filteredEyeSize, eyeWarps);
-            impl->blobFilter->getHessianPeaks()->getResultData(single.filtered.ptr());
-            single.run();
+
+            // Read back the strongest peak per cell instead of the full filtered image:
+            auto* peaks = impl->blobFilter->getCompactPeaks();
+            cv::Mat4b compact(peaks->getOutFrameH(), peaks->getOutFrameW());
+            peaks->getResultData(compact.ptr());
+            single.run(compact, impl->blobFilter->getPeakCellSize());
             impl->eyePoints = single.eyePoints;
 
             computeGazePoints();
         }
+#endif
+    }
+}
+
+// Read back the GPU reduced eye flow: one (dx, dy, weight) pixel per eye per atlas tile.
+void FaceFinder::updateEyeFlowRegions()
+{
+    cv::Mat4b regions(impl->eyeFlowRegions->getOutFrameH(), impl->eyeFlowRegions->getOutFrameW());
+    impl->eyeFlowRegions->getResultData(regions.ptr());
+
+    impl->eyeFlowField.clear();
+    const auto& faceEyeWarps = impl->eyeFilter->getFaceEyeWarps();
+    const auto flowSize = impl->eyeFlow->getOutFrameSize();
+    const cv::Matx33f No = transformation::normalize(cv::Size(flowSize.width, flowSize.height));
+    const float tileHeight = static_cast<float>(flowSize.height) / static_cast<float>(regions.rows);
+
+    float total = 0.f;
+    cv::Point2f flow;
+    const int tiles = std::min(static_cast<int>(faceEyeWarps.size()), regions.rows);
+    for (int k = 0; k < tiles; k++)
+    {
+        float weight = 0.f;
+        cv::Point2f center, motion;
+        for (int e = 0; e < std::min(regions.cols, 2); e++)
+        {
+            const cv::Vec4b& pixel = regions(k, e);
+#if TEXTURE_FORMAT_IS_RGBA
+            const cv::Point2f p(pixel[0], pixel[1]);
+            const float w = static_cast<float>(pixel[2]) / 255.f;
+#else
+            const cv::Point2f p(pixel[2], pixel[1]);
+            const float w = static_cast<float>(pixel[0]) / 255.f;
+#endif
+            if (w <= 0.f)
+            {
+                continue;
+            }
+
+            const cv::Point2f d = (p * (2.0f / 255.0f)) - cv::Point2f(1.0f, 1.0f);
+            const cv::Point2f c((static_cast<float>(e) + 0.5f) * flowSize.width / 2.f, (static_cast<float>(k) + 0.5f) * tileHeight);
+
+            // Region center and flow vector in image coordinates:
+            const cv::Matx33f H = faceEyeWarps[k][e].H.inv() * No;
+            const cv::Point3f q3 = H * cv::Point3f(c.x, c.y, 1.f);
+            const cv::Point3f r3 = H * cv::Point3f(c.x + d.x, c.y + d.y, 1.f);
+            const cv::Point2f q2(q3.x / q3.z, q3.y / q3.z);
+            impl->eyeFlowField.emplace_back(q2.x, q2.y, d.x * 100.f, d.y * 100.f);
+
+            center += q2 * w;
+            motion += (q2 - cv::Point2f(r3.x / r3.z, r3.y / r3.z)) * w;
+            weight += w;
+            flow += d * w;
+        }
+
+        if ((weight > 0.f) && impl->doTrackPrediction && impl->faceTracker)
+        {
+            impl->faceTracker->addMotion(center * (1.f / weight), motion * (1.f / weight));
+        }
+        total += weight;
+    }
+
+    if (total > 0.f)
+    {
+        impl->eyeMotion = -(flow * (1.f / total));
+    }
+}
+
+// Read back the GPU flow grid: one (dx, dy, weight) pixel per cell, stored as full resolution
+// correspondences between the previous and the current frame for the CPU solve in detect().
+void FaceFinder::readGlobalMotion(ScenePrimitives& scene)
+{
+    cv::Mat4b cells(impl->sceneFlowGrid->getOutFrameH(), impl->sceneFlowGrid->getOutFrameW());
+    impl->sceneFlowGrid->getResultData(cells.ptr());
+
+    const auto flowSize = impl->sceneFlow->getOutFrameSize();
+    const float cellWidth = static_cast<float>(flowSize.width) / static_cast<float>(cells.cols);
+    const float cellHeight = static_cast<float>(flowSize.height) / static_cast<float>(cells.rows);
+    const float scale = static_cast<float>(impl->inputSizeUp.width) / static_cast<float>(flowSize.width);
+
+    auto& correspondences = scene.correspondences();
+    correspondences.clear();
+    correspondences.reserve(cells.total());
+    for (int y = 0; y < cells.rows; y++)
+    {
+        for (int x = 0; x < cells.cols; x++)
+        {
+            const cv::Vec4b& pixel = cells(y, x);
+#if TEXTURE_FORMAT_IS_RGBA
+            const cv::Point2f p(pixel[0], pixel[1]);
+            const float w = static_cast<float>(pixel[2]) / 255.f;
+#else
+            const cv::Point2f p(pixel[2], pixel[1]);
+            const float w = static_cast<float>(pixel[0]) / 255.f;
+#endif
+            if (w <= 0.f)
+            {
+                continue;
+            }
+
+            // The flow points from the current frame to the previous one (see updateEyes()):
+            const cv::Point2f d = (p * (2.0f / 255.0f)) - cv::Point2f(1.0f, 1.0f);
+            const cv::Point2f c((static_cast<float>(x) + 0.5f) * cellWidth, (static_cast<float>(y) + 0.5f) * cellHeight);
+            correspondences.push_back((c + d) * scale, c * scale, w);
+        }
     }
 }
 
@@ -1147,19 +2678,187 @@ void FaceFinder::computeGazePoints()
     if (total > 0.f)
     {
         mu *= (1.0 / total);
-        impl->logger->info("GAZE: {:f}", mu);
+        impl->diagnostics->info(impl->gazeCategory, "GAZE: [{:f}, {:f}]", mu.x, mu.y);
     }
 }
 
-void FaceFinder::initTimeLoggers()
+void FaceFinder::initStageTracer()
 {
     // clang-format off
-    impl->timerInfo.init();
+    std::vector<std::string> stages
+    {
+        "frame", "acf", "fill", "detect", "face_regression", "eye_regression", "eye_patches", "readback_wait", "blobs", "paint", "fifo", "face_tiles", "global_motion",
+        "cpu_path", "update_eyes", "paint_faces", "paint_process",
+        "gpu_acf", "gpu_fifo", "gpu_eye_patches", "gpu_eye_filter", "gpu_flow", "gpu_blobs", "gpu_paint"
+    };
     // clang-format on
+
+    assert(stages.size() == kStageCount);
+    impl->tracer = drishti::core::make_unique<core::StageTracer>(stages, DRISHTI_HCI_FACEFINDER_TRACE_CAPACITY);
+}
+
+// GPU spans complete a few frames later and are merged into the tracer on their own lane:
+void FaceFinder::pollGpuTimer()
+{
+    if (!impl->gpuTimer)
+    {
+        return;
+    }
+
+    static const std::uint64_t kGpuLane = std::numeric_limits<std::uint64_t>::max();
+
+    impl->gpuSpans.clear();
+    impl->gpuTimer->poll(impl->gpuSpans);
+    for (const auto& span : impl->gpuSpans)
+    {
+        impl->tracer->record(span.stage, span.frame, span.duration, span.end, kGpuLane);
+    }
+}
+
+ogles_gpgpu::GpuTimer::Scope FaceFinder::gpuScope(StageKind stage, std::uint64_t frame)
+{
+    return impl->gpuTimer ? impl->gpuTimer->scope(stage, frame) : ogles_gpgpu::GpuTimer::Scope();
+}
+
+const core::StageTracer& FaceFinder::getStageTracer() const
+{
+    return *impl->tracer;
+}
+
+EyeGate::Stats FaceFinder::getEyeGateStats() const
+{
+    return impl->eyeGate ? impl->eyeGate->getStats() : EyeGate::Stats();
+}
+
+DetectionScheduler::Stats FaceFinder::getDetectionStats() const
+{
+    return impl->detectionScheduler ? impl->detectionScheduler->getStats() : DetectionScheduler::Stats();
+}
+
+// The replacement factory is kept until the next swap, since the pending loads refer to it
+// (see FaceDetectorFactory::loadAsync()), and a pending swap is never replaced:
+bool FaceFinder::swapModels(FaceDetectorFactoryPtr factory)
+{
+    std::lock_guard<std::mutex> lock(impl->swapMutex);
+    if (!factory || !impl->threads || !impl->faceDetector || impl->faceDetector->isSwapPending())
+    {
+        return false;
+    }
+
+    impl->logger->info("FaceFinder: swapping models {}", *factory);
+    auto models = factory->loadAsync(*impl->threads, false);
+    impl->swapFactory = std::move(factory);
+    return impl->faceDetector->swapModels(models);
+}
+
+int FaceFinder::getModelGeneration() const
+{
+    return impl->faceDetector ? impl->faceDetector->getModelGeneration() : 0;
+}
+
+drishti::face::FaceDetector::VerificationStats FaceFinder::getFaceVerificationStats() const
+{
+    return impl->faceDetector ? impl->faceDetector->getVerificationStats() : drishti::face::FaceDetector::VerificationStats();
+}
+
+const core::BudgetController* FaceFinder::getBudgetController() const
+{
+    return impl->budget.get();
+}
+
+float FaceFinder::getPowerPressure() const
+{
+    return impl->powerPressure;
+}
+
+GazeEstimator* FaceFinder::getGazeEstimator()
+{
+    return impl->gazeEstimator.get();
+}
+
+// Poll the platform state every pollInterval frames and apply the plan (from detect()):
+void FaceFinder::updatePower(std::uint64_t frameIndex)
+{
+    const auto poll = static_cast<std::uint64_t>(std::max(impl->powerPolicy.getSettings().pollInterval, 1));
+    if ((frameIndex % poll) == 0)
+    {
+        const auto plan = impl->powerPolicy(impl->powerCallback(), impl->powerNominal);
+        if (plan.threads != impl->powerPlan.threads)
+        {
+            impl->faceDetector->setThreadCount(plan.threads);
+        }
+        impl->powerPlan = plan;
+        impl->powerInterval = plan.interval;
+        impl->powerPressure = plan.pressure;
+    }
+
+    const auto stride = static_cast<std::uint64_t>(std::max(impl->powerPlan.eyeStride, 1));
+    impl->powerSkipEyes = (frameIndex % stride) != 0;
+}
+
+// Knobs in degradation order, level 0 restores the configured (static) setting:
+void FaceFinder::initBudget()
+{
+    if (impl->budgetSettings.target <= 0.0)
+    {
+        return;
+    }
+
+    const int levels = std::max(impl->budgetLevels, 1);
+    auto lerp = [levels](float full, float degraded, int level) {
+        return full + (degraded - full) * static_cast<float>(level) / static_cast<float>(levels);
+    };
+
+    auto budget = drishti::core::make_unique<core::BudgetController>(impl->budgetSettings);
+    auto* detector = impl->faceDetector.get();
+    auto* pImpl = impl.get();
+
+    // Stage hints are unbounded by default (full model length) or set by the device tier:
+    const cv::Vec2i iris = impl->budgetIrisStages, eyelids = impl->budgetEyelidStages;
+    const int irisStagesHint = (impl->irisStagesHint > 0) ? impl->irisStagesHint : std::numeric_limits<int>::max();
+    const int eyelidStagesHint = (impl->eyelidStagesHint > 0) ? impl->eyelidStagesHint : std::numeric_limits<int>::max();
+    budget->add({ "irisStages", levels, [=](int level) {
+        detector->setIrisStagesHint(level ? std::min(static_cast<int>(lerp(iris[0], iris[1], level) + 0.5f), irisStagesHint) : irisStagesHint);
+    }, kEyeRegression });
+    budget->add({ "eyelidStages", levels, [=](int level) {
+        detector->setEyelidStagesHint(level ? std::min(static_cast<int>(lerp(eyelids[0], eyelids[1], level) + 0.5f), eyelidStagesHint) : eyelidStagesHint);
+    }, kEyeRegression });
+
+    const cv::Vec2i track = impl->budgetTrackFaceStages;
+    const int trackFaceStagesHint = impl->trackFaceStagesHint;
+    budget->add({ "trackFaceStages", levels, [=](int level) {
+        pImpl->trackFaceStagesHint = level ? static_cast<int>(lerp(track[0], track[1], level) + 0.5f) : trackFaceStagesHint;
+    }, kFaceRegression });
+
+    const cv::Vec2f interval = impl->budgetInterval;
+    const double faceFinderInterval = impl->faceFinderInterval;
+    budget->add({ "interval", levels, [=](int level) {
+        pImpl->faceFinderInterval = level ? std::max(static_cast<double>(lerp(interval[0], interval[1], level)), faceFinderInterval) : faceFinderInterval;
+    }, kDetect });
+
+    budget->add({ "irisRefinement", 1, [=](int level) {
+        pImpl->doIrisRefinement = (level == 0);
+    }, kEyeRegression });
+
+    // The main thread (GPU) and the CPU scene job overlap in the optimized pipeline:
+    budget->setCost({ { kFrame }, { kFill, kDetect, kFaceRegression, kEyeRegression, kBlobExtraction } });
+
+    impl->budget = std::move(budget);
 }
 
 // #### init2 ####
 
+void FaceFinder::initFaceTracker()
+{
+    impl->faceTracker = core::make_unique<face::FaceTracker>(
+        impl->minFaceSeparation,
+        impl->minTrackHits,
+        impl->maxTrackMisses,
+        impl->trackMotionGain);
+    impl->faceTracker->setDoPrediction(impl->doTrackPrediction);
+    impl->faceTracker->setAssociation(impl->trackAssociation);
+}
+
 void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
 {
     using drishti::face::FaceSpecification;
@@ -1167,21 +2866,40 @@ void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
     impl->logger->info("FaceFinder::init2() {}", sBar);
     impl->logger->info("{}", resources);
 
-    initTimeLoggers();
+    initStageTracer();
+
+    impl->diagnostics = drishti::core::make_unique<core::AsyncLogger>(impl->logger);
+    impl->gazeCategory = impl->diagnostics->addCategory("gaze", impl->logPeriod);
+
+    // With a thread pool the regressors and mean face are decoded concurrently while the
+    // GPU pipeline is configured in init(), and are joined at the first detection.  The
+    // ACF detector is still needed up front to plan the pyramid in initACF().
+    resources.lite = impl->doLandmarkLite; // before the regressor is loaded
+
+    drishti::face::FaceDetectorFactory::Models models;
+    if (impl->threads)
+    {
+        models = resources.loadAsync(*impl->threads);
+    }
 
 #if DRISHTI_HCI_FACEFINDER_DO_TRACKING
     // Insntiate a face detector w/ a tracking component:
-    auto faceDetectorAndTracker = drishti::core::make_unique<drishti::face::FaceDetectorAndTracker>(resources);
+    auto faceDetectorAndTracker = impl->threads
+        ? drishti::core::make_unique<drishti::face::FaceDetectorAndTracker>(models)
+        : drishti::core::make_unique<drishti::face::FaceDetectorAndTracker>(resources);
     faceDetectorAndTracker->setMaxTrackAge(2.0);
     impl->faceDetector = std::move(faceDetectorAndTracker);
 #else
-    impl->faceDetector = drishti::core::make_unique<drishti::face::FaceDetector>(resources);
+    impl->faceDetector = impl->threads
+        ? drishti::core::make_unique<drishti::face::FaceDetector>(models)
+        : drishti::core::make_unique<drishti::face::FaceDetector>(resources);
 #endif
     
-    impl->faceDetector->setLandmarkFormat( impl->factory->inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);    
     impl->faceDetector->setDoNMSGlobal(impl->doSingleFace); // single detection only
     impl->faceDetector->setDoNMS(true);
     impl->faceDetector->setInits(1);
+    impl->faceDetector->setThreadPool(impl->threads); // share the scene job pool
+    impl->faceDetector->setVerification(impl->faceVerification);
 
     // Get weak ref to underlying ACF detector
     auto *detector = dynamic_cast<ml::ObjectDetectorACF *>(impl->faceDetector->getDetector());
@@ -1199,13 +2917,110 @@ void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
         }
     }
 
-    impl->faceDetector->setDetectionTimeLogger(impl->timerInfo.detectionTimeLogger);
-    impl->faceDetector->setRegressionTimeLogger(impl->timerInfo.regressionTimeLogger);
-    impl->faceDetector->setEyeRegressionTimeLogger(impl->timerInfo.eyeRegressionTimeLogger);
+    // clang-format off
+    auto* tracer = impl->tracer.get();
+    auto* frame = &impl->detectFrameIndex;
+    impl->faceDetector->setDetectionTimeLogger([tracer, frame](double t) { tracer->record(kDetect, *frame, t); });
+    impl->faceDetector->setRegressionTimeLogger([tracer, frame](double t) { tracer->record(kFaceRegression, *frame, t); });
+    impl->faceDetector->setEyeRegressionTimeLogger([tracer, frame](double t) { tracer->record(kEyeRegression, *frame, t); });
+    // clang-format on
+
+    if (impl->doEyeGating)
+    {
+        impl->eyeGate = drishti::core::make_unique<EyeGate>(impl->eyeGateSettings);
+    }
+
+    if (impl->doGaze)
+    {
+        impl->gazeEstimator = drishti::core::make_unique<GazeEstimator>(impl->gazeSettings);
+    }
+
+    if (impl->doFaceHistory)
+    {
+        impl->faceHistory = drishti::core::make_unique<FaceHistory>(impl->faceHistorySettings);
+    }
+
+    if (impl->eyeGate || impl->powerCallback || (impl->secondaryEyeStride > 1))
+    {
+        // Regression faces are gated against the full resolution tracks from the last update(),
+        // power mode frames between eye updates skip eye regression altogether:
+        auto* pImpl = impl.get();
+        impl->faceDetector->setEyeModeCallback([pImpl](const face::FaceModel& face) {
+            if (pImpl->powerSkipEyes)
+            {
+                return face::FaceDetector::kEyeSkip;
+            }
+
+            const cv::Point2f offset(pImpl->tileOffset); // tile -> regression image
+            const cv::Matx33f Hrf = transformation::scale(1.0f / pImpl->regressionScale) * transformation::translate(offset.x, offset.y);
+            if (pImpl->secondaryEyeStride > 1)
+            {
+                // Rank by the latest faces (near to far), new faces are treated as primary:
+                const cv::Point2f r = (face.getEyeRightCenter() + face.getEyeLeftCenter()) * 0.5f;
+                const cv::Point3f q = Hrf * cv::Point3f(r.x, r.y, 1.f);
+                const cv::Point2f c(q.x, q.y);
+                const float tolerance = face.getInterPupillaryDistance() * 0.5f / pImpl->regressionScale;
+
+                std::lock_guard<std::mutex> lock(pImpl->eyeTierMutex);
+                const auto& faces = pImpl->eyeTierFaces;
+                const auto iter = std::find_if(faces.begin(), faces.end(), [&](const cv::Point2f& p) { return cv::norm(p - c) < tolerance; });
+                const auto rank = static_cast<std::uint64_t>(iter - faces.begin());
+                if ((iter != faces.end()) && (rank > 0) && (((pImpl->detectFrameIndex + rank) % pImpl->secondaryEyeStride) != 0))
+                {
+                    pImpl->eyeTierDeferred.push_back(c);
+                    return face::FaceDetector::kEyeSkip;
+                }
+            }
+            if (!pImpl->eyeGate)
+            {
+                return face::FaceDetector::kEyeFull;
+            }
+            return (*pImpl->eyeGate)(face, Hrf);
+        });
+    }
+
+    initFaceTracker();
+
+    impl->hasModels = false;
+    impl->meanFace = std::move(models.meanFace);
+    if (!impl->threads)
+    {
+        initModels();
+    }
+}
+
+void FaceFinder::initModels()
+{
+    using drishti::face::FaceSpecification;
+
+    impl->faceDetector->join(); // the "inner" designation is known once the face regressor is loaded
+    impl->faceDetector->setLandmarkFormat(impl->factory->inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);
+
+    // Device tier regression cost (the regressors are loaded, so the hints don't block):
+    if (impl->faceStagesHint > 0)
+    {
+        impl->faceDetector->setFaceStagesHint(impl->faceStagesHint);
+    }
+    if (impl->eyelidStagesHint > 0)
+    {
+        impl->faceDetector->setEyelidStagesHint(impl->eyelidStagesHint);
+    }
+    if (impl->irisStagesHint > 0)
+    {
+        impl->faceDetector->setIrisStagesHint(impl->irisStagesHint);
+    }
+    if (impl->eyelidInits > 0)
+    {
+        impl->faceDetector->setEyelidInits(impl->eyelidInits);
+    }
+    if (impl->irisInits > 0)
+    {
+        impl->faceDetector->setIrisInits(impl->irisInits);
+    }
 
     {
         // FaceDetection mean:
-        drishti::face::FaceModel faceDetectorMean = impl->factory->getMeanFace();
+        drishti::face::FaceModel faceDetectorMean = impl->meanFace.valid() ? impl->meanFace.get() : impl->factory->getMeanFace();
 
         // We can change the regressor crop padding by doing a centered scaling of face features:
         if (impl->regressorCropScale > 0.f)
@@ -1233,27 +3048,7 @@ void FaceFinder::init2(drishti::face::FaceDetectorFactory& resources)
         impl->faceDetector->setFaceDetectorMean(faceDetectorMean);
     }
 
-    impl->faceTracker = core::make_unique<face::FaceTracker>(
-        impl->minFaceSeparation,
-        impl->minTrackHits,
-        impl->maxTrackMisses);
-}
-
-static void smooth(double& t0, double t1, double alpha = 0.95)
-{
-    t0 = (t0 != 0.0) ? t1 : ((t0 * alpha) + (t1 * (1.0 - alpha)));
-}
-
-void FaceFinder::TimerInfo::init()
-{
-    // clang-format off
-    detectionTimeLogger = [this](double seconds) { smooth(detectionTime, seconds); };
-    regressionTimeLogger = [this](double seconds) { smooth(regressionTime, seconds); };
-    eyeRegressionTimeLogger = [this](double seconds) { smooth(eyeRegressionTime, seconds); };
-    acfProcessingTimeLogger = [this](double seconds) { smooth(acfProcessingTime, seconds); };
-    blobExtractionTimeLogger = [this](double seconds) { smooth(blobExtractionTime, seconds); };
-    renderSceneTimeLogger = [this](double seconds) { smooth(renderSceneTime, seconds); };
-    // clang-format on
+    impl->hasModels = true;
 }
 
 // #### utilty: ####
@@ -1275,17 +3070,28 @@ static void chooseBest(std::vector<cv::Rect>& objects, std::vector<double>& scor
     }
 }
 
-std::ostream& operator<<(std::ostream& os, const FaceFinder::TimerInfo& info)
+// Drop levels outside the scale range (e.g., upsampled levels beyond the max distance):
+static void prunePyramid(acf::Detector::Pyramid& P, const std::pair<double, double>& scales)
 {
-    double total = info.detectionTime + info.regressionTime + info.eyeRegressionTime;
-    os << " acf+=" << info.acfProcessingTime
-       << " fd=" << info.detectionTime
-       << " fr=" << info.regressionTime
-       << " er=" << info.eyeRegressionTime
-       << " blob=" << info.blobExtractionTime
-       << " gl=" << info.renderSceneTime
-       << " total=" << total;
-    return os;
+    int n = 0;
+    for (int i = 0; i < P.nScales; i++)
+    {
+        if ((P.scales[i] >= scales.first) && (P.scales[i] <= scales.second))
+        {
+            P.data[n] = P.data[i];
+            P.scales[n] = P.scales[i];
+            P.scaleshw[n] = P.scaleshw[i];
+            n++;
+        }
+    }
+
+    if (n > 0) // never prune everything
+    {
+        P.nScales = n;
+        P.data.resize(n);
+        P.scales.resize(n);
+        P.scaleshw.resize(n);
+    }
 }
 
 static int
@@ -1338,4 +3144,49 @@ static void logPyramid(const std::string& filename, const acf::Detector::Pyramid
 }
 #endif // DRISHTI_HCI_FACEFINDER_DEBUG_PYRAMIDS
 
+static bool hasEyeModels(const face::FaceModel& face)
+{
+    return face.eyeFullR.has && face.eyeFullL.has && !face.eyeFullR->eyelids.empty() && !face.eyeFullL->eyelids.empty();
+}
+
+// Faces that skipped eye regression (power mode or secondary eye tiers) reuse the eye models of
+// the nearest face from the latest eye update, mapped with the two eye similarity motion between
+// the face models, and the history keeps the latest (measured or carried) models for each face:
+static void interpolateEyes(std::vector<face::FaceModel>& faces, std::vector<face::FaceModel>& history, const std::function<bool(const face::FaceModel&)>& isSkipped)
+{
+    for (auto& face : faces)
+    {
+        if (hasEyeModels(face) || !isSkipped(face))
+        {
+            continue;
+        }
+
+        const cv::Point2f pR = face.getEyeRightCenter(), pL = face.getEyeLeftCenter();
+        const float distance = std::max(static_cast<float>(cv::norm(pL - pR)), 1.f);
+
+        const face::FaceModel* best = nullptr;
+        float bestScore = 0.5f; // eye midpoint motion / eye distance
+        for (const auto& previous : history)
+        {
+            const cv::Point2f qR = previous.getEyeRightCenter(), qL = previous.getEyeLeftCenter();
+            const float score = static_cast<float>(cv::norm((pR + pL) - (qR + qL)) * 0.5) / distance;
+            if (score < bestScore)
+            {
+                best = &previous;
+                bestScore = score;
+            }
+        }
+
+        if (best)
+        {
+            const cv::Matx33f H = face::getSimilarityMotion(*best, face);
+            face.eyeFullR = H * best->eyeFullR.value;
+            face.eyeFullL = H * best->eyeFullL.value;
+        }
+    }
+
+    history.clear();
+    std::copy_if(faces.begin(), faces.end(), std::back_inserter(history), hasEyeModels);
+}
+
 DRISHTI_HCI_NAMESPACE_END
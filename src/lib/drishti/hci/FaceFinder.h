@@ -14,9 +14,21 @@
 #include "drishti/hci/drishti_hci.h"
 #include "drishti/hci/Scene.hpp"
 #include "drishti/hci/FaceMonitor.h"
+#include "drishti/hci/DetectionScheduler.h"
+#include "drishti/hci/DeviceOrientation.h"
+#include "drishti/hci/EyeGate.h"
+#include "drishti/hci/GazeEstimator.h"
+#include "drishti/hci/PowerPolicy.h"
+#include "drishti/hci/SessionRecorder.h"
 #include "drishti/face/Face.h"
+#include "drishti/face/FaceDetector.h"
 #include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/face/FaceTracker.h"
+#include "drishti/face/gpu/GpuTimer.h"
+#include "drishti/ml/AcfPyramidCache.h"
 #include "drishti/sensor/Sensor.h"
+#include "drishti/core/StageTracer.h"
+#include "drishti/core/BudgetController.h"
 
 #include <acf/GPUACF.h>
 #include <acf/ACF.h> // needed for pyramid
@@ -24,6 +36,7 @@
 #include "thread_pool/thread_pool.hpp"
 
 #include <memory>
+#include <string>
 
 #define DRISHTI_HCI_FACEFINDER_MIN_DISTANCE 0.1
 #define DRISHTI_HCI_FACEFINDER_MAX_DISTANCE 0.4
@@ -33,6 +46,10 @@
 #define DRISHTI_HCI_FACEFINDER_INTERVAL 0.1f
 #define DRISHTI_HCI_FACEFINDER_DO_ELLIPSO_POLAR 0
 #define DRISHTI_HCI_FACEFINDER_HISTORY 3
+#define DRISHTI_HCI_FACEFINDER_PIPELINE_DEPTH 2
+#define DRISHTI_HCI_FACEFINDER_TRACE_CAPACITY 4096
+#define DRISHTI_HCI_FACEFINDER_ROI_FULL_SCAN_INTERVAL 4
+#define DRISHTI_HCI_FACEFINDER_FACE_WIDTH_METERS 0.12f
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
@@ -44,26 +61,46 @@ public:
     using FrameInput = ogles_gpgpu::FrameInput;
     using FeaturePoints = std::vector<FeaturePoint>;
     using ImageLogger = std::function<void(const cv::Mat& image)>;
+    using Clock = std::function<TimePoint()>;
     using FaceDetectorFactoryPtr = std::shared_ptr<drishti::face::FaceDetectorFactory>;
 
-    struct TimerInfo
+    // Stages recorded by the hot-path tracer (see getStageTracer()):
+    enum StageKind
     {
-        double detectionTime = 0.0;
-        double regressionTime = 0.0;
-        double eyeRegressionTime = 0.0;
-        double acfProcessingTime = 0.0;
-        double blobExtractionTime = 0.0;
-        double renderSceneTime = 0.0;
-        std::function<void(double second)> detectionTimeLogger;
-        std::function<void(double second)> regressionTimeLogger;
-        std::function<void(double second)> eyeRegressionTimeLogger;
-        std::function<void(double second)> acfProcessingTimeLogger;
-        std::function<void(double second)> blobExtractionTimeLogger;
-        std::function<void(double second)> renderSceneTimeLogger;
-
-        void init();
-
-        friend std::ostream& operator<<(std::ostream& stream, const TimerInfo& info);
+        kFrame,           // full operator() call (main thread)
+        kAcfRead,         // GPU ACF channel read
+        kFill,            // ACF pyramid assembly
+        kDetect,          // ACF detection
+        kFaceRegression,  // face landmark regression
+        kEyeRegression,   // eye model regression
+        kEyePatches,      // GPU eye patch render + readback
+        kReadbackWait,    // GPU eye patch fence wait (async PBO readback)
+        kBlobExtraction,  // specular reflection extraction
+        kPaint,           // scene painting (annotations)
+        kFifoRender,      // full frame FIFO update
+        kFaceTiles,       // GPU landmark tiles (or full frame) render + readback
+        kGlobalMotion,    // GPU flow grid readback
+        kCpuPath,         // full detect() call (CPU scene job)
+        kUpdateEyes,      // GPU eye filter update
+        kPaintFaces,      // painter face and eye texture setup
+        kPaintProcess,    // painter render
+        kGpuAcf,          // GPU: ACF passes (Settings::doGpuTiming)
+        kGpuFifo,         // GPU: full frame FIFO update
+        kGpuEyePatches,   // GPU: eye patch warps
+        kGpuEyeFilter,    // GPU: eye enhancer and iris warps
+        kGpuFlow,         // GPU: global motion and eye optical flow
+        kGpuBlobs,        // GPU: blob filter
+        kGpuPaint,        // GPU: painter
+        kStageCount
+    };
+
+    // Policy for a new frame when the oldest CPU scene job is still running (optimized pipeline):
+    enum Backpressure
+    {
+        kBlock,      // wait for the job (default)
+        kDropNewest, // skip the new frame (no GPU work, no callbacks)
+        kDropOldest, // process the new frame and discard the late job's results
+        kReuseLast   // output the last scene again (no paint, no callbacks), the late job is painted later
     };
 
     struct Settings
@@ -72,14 +109,96 @@ public:
         std::shared_ptr<spdlog::logger> logger;
         std::shared_ptr<tp::ThreadPool<>> threads;
         ImageLogger imageLogger;
+
+        // (optional) Frame timestamp source for the detection interval and FaceMonitor
+        // callbacks, e.g., capture times for deterministic replay (default: wall clock):
+        Clock clock;
+
+        // (optional) Triggered recording of frames and scene state for offline profiling:
+        std::shared_ptr<SessionRecorder> recorder;
+
+        // Per-frame diagnostics (e.g., gaze) are logged from a background thread, 1 of every
+        // N frames (0 == off).  Stage timing is recorded in the tracer (getStageTracer()):
+        int logPeriod = 1;
+
+        // GPU execution time of the ogles_gpgpu stages (kGpu* stages, on their own tracer lane)
+        // from timer queries that are read back a few frames later, so the pipeline doesn't
+        // stall.  No-op on contexts without GL_TIMESTAMP or GL_EXT_disjoint_timer_query:
+        bool doGpuTiming = false;
+
+        // Rotation that makes camera frames upright, which can change during a session (see
+        // setOrientation() and setGravity(), the latter is filtered with deviceOrientation):
         int outputOrientation = 0;
+        DeviceOrientation::Settings deviceOrientation;
+
+        // High resolution cameras: upright frames are area downscaled once to this width (0 ==
+        // camera resolution) and all analysis stages (FIFO, ACF, landmarks, painter) run at the
+        // working resolution, in which faces are reported (see getWorkingScale()).  The last
+        // frames are kept at camera resolution for the eye warps only:
+        int workingWidth = 0;
+
         int frameDelay = 1;
         bool doLandmarks = true;
         bool doFlow = true;
         bool doBlobs = false;
+        bool doIris = false;    // ellipso-polar iris warps (FaceFinderPainter)
+        bool doEyeFlow = false; // eye optical flow (track prediction measurements)
         cv::Size eyesSize = { 480, 240 };
         bool doEyesScaling = true;
 
+        // Eye pairs for the nearest maxEyeFaces faces are rendered in one pass as eyesSize tiles
+        // of a single atlas texture (flow, blobs and iris warps use the first tile):
+        int maxEyeFaces = 1;
+
+        // Per face quality tiers (multiple faces): the nearest face gets eye models every frame and
+        // the others get landmarks every frame but eye models every secondaryEyeStride frames, in
+        // round robin order, with the latest models carried along by the face motion in between
+        // (0 or 1 == every face, every frame):
+        int secondaryEyeStride = 0;
+
+        // Reduce eye optical flow to one (dx, dy, weight) vector per eye on the GPU, so that
+        // only a 2 x maxEyeFaces texture is read back instead of the full flow field:
+        bool doEyeFlowReduction = false;
+
+        // Render eye regressor input patches on the GPU (around the latest tracked faces):
+        bool doGpuEyePatches = false;
+        int eyePatchWidth = 128;
+
+        // Read back padded tracked face regions (one regression resolution tile per face) instead
+        // of the full grayscale frame between detections (optimized pipeline only):
+        bool doLandmarkTiles = false;
+        int landmarkTileWidth = 384;      // regression image pixels (larger faces use the full frame)
+        float landmarkTilePadding = 0.5f; // fraction of the face width on each side
+
+        // Evaluate the face landmark forests for all faces in shader passes (OpenGL ES 3 with float
+        // render targets, see face::ShapePredictorGPU), for devices with weak CPUs.  Simple pipeline
+        // only (regression runs on the GL thread), unsupported models and contexts use the CPU:
+        bool doGpuRegression = false;
+
+        // Build the detection pyramid from the LUV transfer in compute shaders (OpenGL ES 3.1 or
+        // OpenGL 4.3, see AcfComputeBuilder) instead of on the CPU, other contexts use the CPU:
+        bool doComputeAcf = false;
+
+        // Static cameras (CPU pyramid on the thread pool, see setDoCpuAcf()): only the channel tiles
+        // near input blocks that changed since the last detection are recomputed, and detections
+        // are reused while nothing changes, with a full refresh every acfRefreshPeriod detection
+        // frames (see AcfPyramidBuilder::Options::changeBlock):
+        int acfChangeBlock = 0; // input pixels per block (0 == off)
+        float acfChangeThreshold = 0.02f;
+        int acfRefreshPeriod = 30;
+
+        // Global (camera) motion: sparse GPU flow for a globalMotionGrid of cells is read back as
+        // a compact correspondence list, and a robust similarity is solved in the CPU scene job
+        // (see ScenePrimitives::motion()) for track prediction and display stabilization:
+        bool doGlobalMotion = false;
+        cv::Size globalMotionGrid = { 16, 12 };
+        int globalMotionWidth = 256; // flow image width
+        drishti::geometry::SimilarityMotionEstimator::Settings globalMotion;
+
+        // Exponential smoothing of the stabilized display (1 == no smoothing), computed in the
+        // CPU scene job so that the render thread only uploads the transformation:
+        float stabilizationGain = 0.5f;
+
         // Detection parameters:
         bool doSingleFace = false;
         float minDetectionDistance = DRISHTI_HCI_FACEFINDER_MIN_DISTANCE;
@@ -88,17 +207,105 @@ public:
         float acfCalibration = 0.f;
         float regressorCropScale = 0.f;
 
+        // Regression cost per device tier (0 == model defaults), e.g., from a DeviceProfile row
+        // tuned offline for the accuracy and latency trade-off (see drishti-sweep):
+        int faceStagesHint = 0;
+        int eyelidStagesHint = 0;
+        int irisStagesHint = 0;
+        int eyelidInits = 0;
+        int irisInits = 0;
+
+        // Regress the subset landmark model of the factory when there is one (eye corners and
+        // centers, nose tip), for clients that don't need the full contour of the faces:
+        bool doLandmarkLite = false;
+
+        // Reject false positive detections after the first faceVerification.stages landmark
+        // stages, before the remaining stages and eye models (see getFaceVerificationStats()):
+        drishti::face::FaceDetector::Verification faceVerification;
+
+        // Tracking-aware detection: scan padded track regions at the 1-2 matching pyramid
+        // levels, with a full frame scan every roiFullScanInterval detections (and with no tracks):
+        bool doRoiDetection = false;
+        int roiFullScanInterval = DRISHTI_HCI_FACEFINDER_ROI_FULL_SCAN_INTERVAL;
+        float roiPadding = 0.5f; // fraction of track width
+
+        // (optional) Detection pyramids are published here, keyed by scene frame index, so that
+        // other ACF models with the same channel parameters (e.g., eyes) can reuse them:
+        std::shared_ptr<drishti::ml::AcfPyramidCache> pyramidCache;
+
         // Detection tracks:
         std::size_t minTrackHits = DRISHTI_HCI_FACEFINDER_MIN_TRACK_HITS;
         std::size_t maxTrackMisses = DRISHTI_HCI_FACEFINDER_MAX_TRACK_MISSES;
         float minFaceSeparation = DRISHTI_HCI_FACEFINDER_MIN_SEPARATION;
 
+        // Track prediction: tracks without a detection are propagated with a constant velocity
+        // model (eye flow is used as a measurement when doFlow is enabled) and refined with
+        // trackFaceStagesHint face regression stages (0 for all stages):
+        bool doTrackPrediction = true;
+        float trackMotionGain = 0.5f;
+        int trackFaceStagesHint = 0;
+
+        // Track association cost weights (geometry, detection score and appearance):
+        drishti::face::FaceTracker::Association trackAssociation;
+
+        // Per track eye gating: eyelids only during blinks, sparse eyelid probes for closed eyes
+        // and no eye regression for extreme head poses (see getEyeGateStats()):
+        bool doEyeGating = false;
+        EyeGate::Settings eyeGate;
+
+        // Eye regression level by eye crop width (regression image pixels) and distance, so far
+        // faces don't pay for eye models that are too coarse to use (see FaceModel::eyeMode and
+        // FaceDetector::EyeResolution, the focal length is taken from the sensor):
+        bool doEyeResolution = true;
+        drishti::face::FaceDetector::EyeResolution eyeResolution;
+
+        // Content adaptive detection: faceFinderInterval becomes the nominal interval, detection is
+        // triggered early by scene motion, lost tracks or unstable landmarks and deferred while
+        // tracks are stable (see DetectionScheduler and getDetectionStats()):
+        bool doAdaptiveDetection = false;
+        DetectionScheduler::Settings detectionScheduler;
+
+        // Per eye gaze vectors (FaceModel::gaze) for faces with eye models, computed in the CPU
+        // scene job (see getGazeEstimator() for the per user calibration):
+        bool doGaze = false;
+        GazeEstimator::Settings gaze;
+
+        // Per track face and eye history (bounded ring buffers) for FaceMonitor::update(), e.g.,
+        // for blink and saccade analysis without copying every request() (see FaceHistory):
+        bool doFaceHistory = false;
+        FaceHistory::Settings faceHistory;
+
+        // Adaptive quality (budget.target > 0 seconds): while the frame cost (main thread or CPU
+        // scene job) exceeds the target the knobs below are degraded in this order, and they are
+        // restored in reverse order with headroom (see getBudgetController()):
+        core::BudgetController::Settings budget;
+        int budgetLevels = 3;                        // levels per knob (iris refinement has one)
+        cv::Vec2i budgetIrisStages = { 16, 4 };      // { full, degraded } iris cascade stages
+        cv::Vec2i budgetEyelidStages = { 12, 4 };    // eyelid cascade stages
+        cv::Vec2i budgetTrackFaceStages = { 12, 4 }; // face stages for predicted tracks
+        cv::Vec2f budgetInterval = { DRISHTI_HCI_FACEFINDER_INTERVAL, 0.4f }; // detection interval (seconds)
+
+        // Power mode (with a power callback): the detection interval, the eye model rate (with
+        // interpolation between eye updates) and the regression worker count follow the platform
+        // thermal and battery state, polled from the CPU scene job (the pipeline depth is chosen
+        // once at initialization):
+        PowerPolicy::Callback power;
+        PowerPolicy::Settings powerPolicy;
+
         // OpengL parameters:
         int glVersionMajor = 2;
         int glVersionMinor = 0; // future use
         bool usePBO = false;
         bool doOptimizedPipeline = true;
 
+        // (optional) Existing directory for linked shader program binaries: the first launch
+        // stores them and later launches skip compilation (see ogles_gpgpu::ProgramCache):
+        std::string shaderCache;
+
+        // Optimized pipeline latency in frames (>= 2): GPU processing for frame n
+        // with (pipelineDepth - 1) CPU scene jobs in flight for frames n-1 ... n-pipelineDepth+1
+        int pipelineDepth = DRISHTI_HCI_FACEFINDER_PIPELINE_DEPTH;
+
         // Display parameters:
         bool renderFaces = true;
         bool renderPupils = true;
@@ -127,35 +334,121 @@ public:
 
     virtual GLuint operator()(const FrameInput& frame);
 
+    // Camera capture time of the next frame, carried through the pipeline with its scene to the
+    // detection schedule, the recorder and the FaceMonitor callbacks (default: Settings::clock,
+    // or the wall clock at the operator() call):
+    void setCaptureTime(const TimePoint& time);
+
+    // Upright frame rotation in degrees (see Settings::outputOrientation) for the next frames,
+    // e.g., from the platform rotation callback.  Half turns only change the ACF input rotation,
+    // quarter turns rebuild the frame size dependent GPU stages in place.  Tracks restart:
+    void setOrientation(int degrees);
+    int getOrientation() const;
+
+    // Working / camera resolution (see Settings::workingWidth):
+    float getWorkingScale() const;
+
+    // Accelerometer gravity in device coordinates, mapped to setOrientation() with hysteresis
+    // (call from one thread, see DeviceOrientation):
+    void setGravity(const cv::Vec3f& gravity);
+
     float getMaxDistance() const;
     float getMinDistance() const;
 
+    // Update the detection distance band, the ACF pyramid plan is rebuilt before the next frame:
+    void setDetectionDistance(float minMeters, float maxMeters);
+
     void setDoCpuAcf(bool flag);
     bool getDoCpuAcf() const;
 
+    // Optional eye stages are created (GL thread) on first use and their textures and FBOs are
+    // released when disabled, so the minimal tracking configuration allocates none of them:
+    void setDoIris(bool flag); // ellipso-polar iris warps
+    bool getDoIris() const;
+    void setDoEyeFlow(bool flag); // eye optical flow
+    bool getDoEyeFlow() const;
+    void setDoBlobs(bool flag); // eye reflections
+    bool getDoBlobs() const;
+
     void setFaceFinderInterval(double interval);
     double getFaceFinderInterval() const;
 
+    // Replace the landmark and eye regressors with the models of factory (e.g., a pruned
+    // variant under thermal pressure) without rebuilding the pipeline: the models are loaded
+    // on Settings::threads and installed at the start of a scene job once they are all ready,
+    // while the GPU stages, tracks and ACF detector are kept (see FaceDetector::swapModels()).
+    // Returns false without a thread pool, before initialize() or while a swap is pending:
+    bool swapModels(FaceDetectorFactoryPtr factory);
+    int getModelGeneration() const; // installed swaps
+
+    // Pause (e.g., app backgrounded) and resume on the GL thread: suspend() drains the CPU jobs
+    // and releases every GL object of the pipeline (call it while the context is still current),
+    // resume() rebuilds the stages at the known frame size in the current context, programs come
+    // from the binary cache when Settings::shaderCache is set.  The models, the tracks and the
+    // last face regions are kept, so the first detection after resume() scans around the faces
+    // seen before suspend().  Frames passed while suspended are ignored (returns 0):
+    void suspend();
+    void resume();
+    bool isSuspended() const;
+
+    void setBackpressure(Backpressure policy);
+    Backpressure getBackpressure() const;
+
+    // Returns true if the next frame would wait on a CPU scene job:
+    bool isBusy() const;
+
+    // Frames (kDropNewest), late scene results (kDropOldest) and repeated scenes (kReuseLast) so far:
+    std::size_t getDroppedFrameCount() const;
+
     void setBrightness(float value);
 
-    void registerFaceMonitorCallback(FaceMonitor* callback);
+    void registerFaceMonitorCallback(FaceMonitor* callback, const FaceMonitor::Schedule& schedule = {});
 
     virtual bool doAnnotations() const;
 
     void setImageLogger(const ImageLogger& logger);
 
+    // Per-stage timing spans (frame index + thread id) for percentiles and trace export:
+    const core::StageTracer& getStageTracer() const;
+
+    // Eye gating decisions so far (all zero without Settings::doEyeGating):
+    EyeGate::Stats getEyeGateStats() const;
+
+    // Detection decisions per trigger reason (all zero without Settings::doAdaptiveDetection):
+    DetectionScheduler::Stats getDetectionStats() const;
+
+    // Verified and rejected detections (all zero without Settings::faceVerification.stages):
+    drishti::face::FaceDetector::VerificationStats getFaceVerificationStats() const;
+
+    // Knob levels and the measured frame cost (nullptr without Settings::budget.target):
+    const core::BudgetController* getBudgetController() const;
+
+    // Latest power mode pressure in [0, 1] (0 without Settings::power):
+    float getPowerPressure() const;
+
+    // Gaze model and calibration (nullptr without Settings::doGaze):
+    GazeEstimator* getGazeEstimator();
+
 protected:
     using ImageViews = std::vector<core::ImageView>;
     using EyeModelPair = std::array<eye::EyeModel, 2>;
     using EyeModelPairs = std::vector<EyeModelPair>;
 
-    std::pair<GLuint, ScenePrimitives> runFast(const FrameInput& frame, bool doDetection);
-    std::pair<GLuint, ScenePrimitives> runSimple(const FrameInput& frame, bool doDetection);
+    std::pair<GLuint, ConstScenePrimitivesPtr> runFast(const FrameInput& frame, bool doDetection);
+    std::pair<GLuint, ConstScenePrimitivesPtr> runSimple(const FrameInput& frame, bool doDetection);
 
     bool needsDetection(const TimePoint& ts) const;
 
     void computeGazePoints();
+    void updateEyeFlowRegions();
+    void readGlobalMotion(ScenePrimitives& scene);
     void updateEyes(GLuint inputTexId, const ScenePrimitives& scene);
+    void initBudget();
+    void updatePower(std::uint64_t frameIndex);
+    void renderEyePatches(GLuint inputTexId, ScenePrimitives& scene);
+    void fetchEyePatches(ScenePrimitives& scene);
+    void renderFaceTiles(GLuint inputTexId, ScenePrimitives& scene, bool isDetection);
+    void refineTiles(const ScenePrimitives& scene, std::vector<drishti::face::FaceModel>& faces);
 
     void scaleToFullResolution(std::vector<drishti::face::FaceModel>& faces);
 
@@ -163,24 +456,46 @@ protected:
 
     virtual void init(const cv::Size& inputSize);
     virtual void initPainter(const cv::Size& inputSizeUp);
+    virtual void releasePainter(); // GL objects created by initPainter() (see suspend())
+    void initStages(const cv::Size& inputSizeUp);
+    void initFrontEnd(const cv::Size& fullSizeUp, const cv::Size& inputSizeUp);
+    FrameInput downscale(const FrameInput& frame);
+    GLuint getEyeTexture(GLuint inputTexId, int age) const;
+    void updateOrientation();
+    void initFaceTracker();
     void initFaceFilters(const cv::Size& inputSizeUp);
     void initACF(const cv::Size& inputSizeUp);
+    void initPyramidPlan(const cv::Size& detectionSize);
+    void updatePyramidPlan();
     void initFIFO(const cv::Size& inputSize, std::size_t n);
     void initBlobFilter();
     void initColormap(); // [0..359];
+    const cv::Mat3f& getColormap();
     void initEyeEnhancer(const cv::Size& inputSizeUp, const cv::Size& eyesSize);
+    void initEyeFlow();
     void initIris(const cv::Size& size);
-    void initTimeLoggers();
+    void updateEyeStages();
+    void releaseFaceFilters();
+    void updateMemoryUsage();
+    void initEyePatches(const cv::Size& inputSizeUp);
+    void initFaceTiles(const cv::Size& inputSizeUp);
+    void initGlobalMotion(const cv::Size& inputSizeUp);
+    void initStageTracer();
+    void pollGpuTimer();
+    ogles_gpgpu::GpuTimer::Scope gpuScope(StageKind stage, std::uint64_t frame);
     void init2(drishti::face::FaceDetectorFactory& resources);
+    void initModels(); // join background model loading (first detection)
 
     void dumpEyes(ImageViews& frames, EyeModelPairs& eyes, int n = 1, bool getImage = false);
-    void dumpFaces(ImageViews& frames, int n = 1, bool getImage = false, int skipFrames = 0);
+    void dumpFaces(ImageViews& frames, const FaceMonitor::Request& request, int skipFrames = 0);
+    void grabImage(ogles_gpgpu::ProcInterface* filter, const FaceMonitor::Request& request, core::ImageView& view);
     int detectOnly(ScenePrimitives& scene, bool doDetection);
+    int detectRois(const acf::Detector::Pyramid& P, const std::vector<cv::Rect>& rois, std::vector<cv::Rect>& objects, std::vector<double>& scores);
     virtual int detect(const FrameInput& frame, ScenePrimitives& scene, bool doDetection);
     virtual GLuint paint(const ScenePrimitives& scene, GLuint inputTexture);
     virtual void preprocess(const FrameInput& frame, ScenePrimitives& scene, bool needsDetection); // compute acf
 
-    GLuint stabilize(GLuint inputTexId, const cv::Size& inputSizeUp, const drishti::face::FaceModel& face);
+    GLuint stabilize(GLuint inputTexId, const cv::Size& inputSizeUp, const ScenePrimitives& scene);
     int computeDetectionWidth(const cv::Size& inputSizeUp) const;
     void computeAcf(const FrameInput& frame, bool doLuv, bool doDetection);
     std::shared_ptr<acf::Detector::Pyramid> createAcfGpu(const FrameInput& frame, bool doDetection);
@@ -191,8 +506,6 @@ protected:
     std::unique_ptr<Impl> impl;
 };
 
-std::ostream& operator<<(std::ostream& stream, const FaceFinder::TimerInfo& info);
-
 DRISHTI_HCI_NAMESPACE_END
 
 #endif // __drishti_hci_FaceFinder_h__
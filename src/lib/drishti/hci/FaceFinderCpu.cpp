@@ -0,0 +1,484 @@
+/*! -*-c++-*-
+  @file   FaceFinderCpu.cpp
+  @author David Hirvonen
+  @brief  Implementation of a headless (CPU only) face detection and tracking class.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/FaceFinderCpu.h"
+#include "drishti/hci/FaceMonitorDispatcher.h"
+#if DRISHTI_HCI_WITH_BLOBS
+#include "drishti/hci/BlobFilterCpu.h"
+#include "drishti/hci/EyeBlob.h"
+#endif
+#include "drishti/face/FaceDetector.h"
+#include "drishti/face/FaceModelEstimator.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+#include "drishti/geometry/motion.h" // transformation::
+#include "drishti/core/make_unique.h"
+#include "drishti/core/scope_guard.h"
+#include "drishti/core/Logger.h"
+
+#include <acf/ACF.h>
+#include <acf/MatP.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+static void grabImage(const cv::Mat3b& bgr, const FaceMonitor::Request& request, core::ImageView& view);
+
+struct FaceFinderCpu::Frame
+{
+    std::size_t index = 0;
+    TimePoint time;
+    cv::Mat3b image;                             // BGR (full resolution)
+    std::vector<drishti::face::FaceModel> faces; // full resolution
+    std::array<std::vector<FeaturePoint>, 2> eyePoints; // full resolution (nearest face)
+
+    // Prepared in parallel (released after tracking):
+    MatP planar;     // RGB, float, transposed (detection resolution)
+    cv::Mat1b gray;  // green channel (regression resolution)
+    float Sfd = 1.f; // full -> detection
+    float Sfr = 1.f; // full -> regression
+};
+
+struct FaceFinderCpu::Impl
+{
+    Impl(drishti::face::FaceDetectorFactory& factory, const Settings& settings)
+        : settings(settings)
+        , threads(settings.threads)
+        , logger(settings.logger ? settings.logger : drishti::core::Logger::create("drishti"))
+    {
+        using drishti::face::FaceSpecification;
+
+        detector = drishti::core::make_unique<drishti::face::FaceDetector>(factory);
+        detector->setLandmarkFormat(factory.inner ? FaceSpecification::kibug68_inner : FaceSpecification::kibug68);
+        detector->setDoNMSGlobal(settings.doSingleFace);
+        detector->setDoNMS(true);
+        detector->setInits(1);
+        detector->setDoEyeRefinement(settings.doEyes);
+        detector->setDoIrisRefinement(settings.doEyes);
+        detector->setThreadPool(threads);
+        detector->setFaceDetectorMean(factory.getMeanFace());
+
+        auto* acf = dynamic_cast<drishti::ml::ObjectDetectorACF*>(detector->getDetector());
+        if (acf && acf->good() && (settings.acfCalibration != 0.f))
+        {
+            acf::Detector::Modify dflt;
+            dflt.cascThr = { "cascThr", -1.0 };
+            dflt.cascCal = { "cascCal", settings.acfCalibration };
+            acf->getDetector()->acfModify(dflt);
+        }
+
+        if (acf && acf->good() && settings.doBatchedCascade)
+        {
+            acf->setDoBatchedCascade(true); // after acfModify()
+        }
+
+        if (settings.doEyes && settings.doEyeGating)
+        {
+            // track() sets Srf (regression -> full) before each refinement:
+            eyeGate = drishti::core::make_unique<EyeGate>(settings.eyeGate);
+            detector->setEyeModeCallback([this](const drishti::face::FaceModel& face) {
+                return (*eyeGate)(face, transformation::scale(Srf));
+            });
+        }
+
+#if DRISHTI_HCI_WITH_BLOBS
+        if (settings.doEyes && settings.doBlobs)
+        {
+            blobFilter = drishti::core::make_unique<BlobFilterCpu>();
+        }
+#endif
+
+        tracker = drishti::core::make_unique<drishti::face::FaceTracker>(
+            settings.minFaceSeparation,
+            settings.minTrackHits,
+            settings.maxTrackMisses,
+            settings.trackMotionGain);
+
+        winSize = detector->getWindowSize();
+    }
+
+    Settings settings;
+    std::shared_ptr<tp::ThreadPool<>> threads;
+    std::shared_ptr<spdlog::logger> logger;
+
+    std::unique_ptr<drishti::face::FaceDetector> detector;
+    std::unique_ptr<drishti::face::FaceTracker> tracker;
+    std::unique_ptr<EyeGate> eyeGate;
+    float Srf = 1.f; // current regression -> full resolution scale (eyeGate)
+#if DRISHTI_HCI_WITH_BLOBS
+    std::unique_ptr<BlobFilterCpu> blobFilter;
+#endif
+    std::unique_ptr<drishti::face::FaceModelEstimator> faceEstimator; // created for the first frame
+    cv::Size winSize;
+
+    std::deque<std::future<Frame>> jobs; // frames in flight (oldest first)
+    std::shared_future<void> order;      // completion of the most recent track()
+    std::deque<Frame> history;           // delivered frames (newest first)
+    FaceMonitorDispatcher callbacks;
+
+    std::size_t frameIndex = 0;
+    bool hasDetection = false;
+    TimePoint detectionTime;
+};
+
+FaceFinderCpu::FaceFinderCpu(drishti::face::FaceDetectorFactory& factory, const Settings& settings)
+    : impl(drishti::core::make_unique<Impl>(factory, settings))
+{
+}
+
+FaceFinderCpu::~FaceFinderCpu()
+{
+    try
+    {
+        // Block on any abandoned frames (oldest first):
+        for (auto& job : impl->jobs)
+        {
+            if (job.valid())
+            {
+                job.wait();
+            }
+        }
+    }
+    catch (...)
+    {
+    }
+}
+
+void FaceFinderCpu::registerFaceMonitorCallback(FaceMonitor* callback, const FaceMonitor::Schedule& schedule)
+{
+    impl->callbacks.add(callback, schedule);
+}
+
+std::size_t FaceFinderCpu::getFrameCount() const
+{
+    return impl->frameIndex;
+}
+
+EyeGate::Stats FaceFinderCpu::getEyeGateStats() const
+{
+    return impl->eyeGate ? impl->eyeGate->getStats() : EyeGate::Stats();
+}
+
+std::array<std::vector<FeaturePoint>, 2> FaceFinderCpu::getEyePoints() const
+{
+    return impl->history.empty() ? std::array<std::vector<FeaturePoint>, 2>() : impl->history.front().eyePoints;
+}
+
+bool FaceFinderCpu::needsDetection(const TimePoint& time)
+{
+    const double elapsed = std::chrono::duration<double>(time - impl->detectionTime).count();
+    if (!impl->hasDetection || (elapsed >= impl->settings.faceFinderInterval))
+    {
+        impl->hasDetection = true;
+        impl->detectionTime = time;
+        return true;
+    }
+    return false;
+}
+
+void FaceFinderCpu::operator()(const cv::Mat3b& image, const TimePoint& time)
+{
+    if (!impl->faceEstimator)
+    {
+        // Approximate (~53 degree horizontal field of view) camera model if none is provided:
+        const auto fx = static_cast<float>(image.cols);
+        const cv::Point2f center(static_cast<float>(image.cols) * 0.5f, static_cast<float>(image.rows) * 0.5f);
+        const sensor::SensorModel::Intrinsic intrinsic(center, fx, image.size());
+        const auto model = impl->settings.sensor ? *impl->settings.sensor : sensor::SensorModel(intrinsic);
+        impl->faceEstimator = drishti::core::make_unique<drishti::face::FaceModelEstimator>(model);
+    }
+
+    Frame frame;
+    frame.index = impl->frameIndex++;
+    frame.time = time;
+    frame.image = image.clone(); // decoders typically reuse the frame buffer
+
+    const bool doDetection = needsDetection(time);
+
+    // Detection, regression and tracking are order dependent, so each job waits for
+    // track() of the previous frame, while the image preparation overlaps freely.
+    auto done = std::make_shared<std::promise<void>>();
+    std::shared_future<void> previous = impl->order;
+    impl->order = done->get_future().share();
+
+    const Settings& settings = impl->settings;
+    const cv::Size winSize = impl->winSize;
+    auto job = [this, frame, doDetection, previous, done, &settings, winSize]() mutable {
+        {
+            // (1) Detection image: reduce so that minFaceWidth maps to the detector window:
+            cv::Mat3b reduced, rgb;
+            if (settings.minFaceWidth > 0)
+            {
+                frame.Sfd = static_cast<float>(winSize.width) / static_cast<float>(settings.minFaceWidth);
+                const int interpolation = (frame.Sfd < 1.f) ? cv::INTER_AREA : cv::INTER_LINEAR;
+                cv::resize(frame.image, reduced, {}, frame.Sfd, frame.Sfd, interpolation);
+            }
+            else
+            {
+                reduced = frame.image;
+            }
+            cv::cvtColor(reduced, rgb, cv::COLOR_BGR2RGB);
+
+            cv::Mat It = rgb.t(), Itf;
+            It.convertTo(Itf, CV_32FC3, 1.0f / 255.f);
+            frame.planar = MatP(Itf);
+
+            // (2) Regression image:
+            cv::Mat1b green;
+            cv::extractChannel(frame.image, green, 1);
+            if ((settings.landmarksWidth > 0) && (green.cols > settings.landmarksWidth))
+            {
+                frame.Sfr = static_cast<float>(settings.landmarksWidth) / static_cast<float>(green.cols);
+                cv::resize(green, frame.gray, {}, frame.Sfr, frame.Sfr, cv::INTER_AREA);
+            }
+            else
+            {
+                frame.gray = green;
+            }
+        }
+
+        {
+            core::scope_guard signal = [&]() { done->set_value(); };
+            if (previous.valid())
+            {
+                previous.wait();
+            }
+            track(frame, doDetection);
+        }
+
+        frame.planar = MatP();
+        frame.gray.release();
+        return frame;
+    };
+
+    if (impl->threads)
+    {
+        impl->jobs.emplace_back(impl->threads->process(job));
+    }
+    else
+    {
+        std::packaged_task<Frame()> task(job);
+        impl->jobs.emplace_back(task.get_future());
+        task();
+    }
+
+    while (impl->jobs.size() > static_cast<std::size_t>(std::max(settings.pipelineDepth, 1)))
+    {
+        Frame result = impl->jobs.front().get();
+        impl->jobs.pop_front();
+        notifyListeners(result);
+    }
+}
+
+void FaceFinderCpu::flush()
+{
+    while (!impl->jobs.empty())
+    {
+        Frame result = impl->jobs.front().get();
+        impl->jobs.pop_front();
+        notifyListeners(result);
+    }
+}
+
+// Mirrors FaceFinder::detect(): detections are refined and assigned to tracks, and tracks
+// without a detection (or all tracks between detection frames) are refined from the prediction.
+void FaceFinderCpu::track(Frame& frame, bool doDetection)
+{
+    using drishti::face::FaceModel;
+
+    const cv::Matx33f Hfr = transformation::scale(frame.Sfr); // full -> regression
+    const cv::Matx33f Hrf = transformation::scale(1.f / frame.Sfr);
+    impl->Srf = 1.f / frame.Sfr;
+    const cv::Matx33f Hdr = transformation::scale(frame.Sfr / frame.Sfd); // detection -> regression
+
+    auto toFullResolution = [&](std::vector<FaceModel>& faces) {
+        for (auto& f : faces)
+        {
+            f = Hrf * f;
+            if (f.eyeFullL.has && f.eyeFullR.has)
+            {
+                f.eyesCenter = (*impl->faceEstimator)(f);
+            }
+        }
+    };
+
+    const drishti::face::FaceDetector::PaddedImage Ib(frame.gray, { { 0, 0 }, frame.gray.size() });
+
+    std::vector<FaceModel> faces;
+    if (doDetection)
+    {
+        (*impl->detector)(frame.planar, Ib, faces, Hdr);
+        toFullResolution(faces);
+    }
+
+    drishti::face::FaceTracker::FaceTrackVec tracksOut;
+    drishti::face::FaceTracker::Measurements measurements;
+    measurements.image = frame.gray;
+    measurements.H = Hfr;
+    (*impl->tracker)(faces, tracksOut, measurements);
+
+    faces.clear();
+    for (auto& f : tracksOut)
+    {
+        if (f.second.misses > 0)
+        {
+            faces.push_back(Hfr * f.first); // refine at the regression resolution
+        }
+        else
+        {
+            frame.faces.emplace_back(f.first);
+        }
+    }
+
+    if (faces.size())
+    {
+        impl->detector->refine(Ib, faces, cv::Matx33f::eye(), false);
+        toFullResolution(faces);
+        std::copy(faces.begin(), faces.end(), std::back_inserter(frame.faces));
+    }
+
+    // Sort near to far:
+    std::sort(frame.faces.begin(), frame.faces.end(), [](const FaceModel& a, const FaceModel& b) {
+        return (a.eyesCenter->z < b.eyesCenter->z);
+    });
+
+    if (impl->eyeGate)
+    {
+        impl->eyeGate->update(frame.faces);
+    }
+
+#if DRISHTI_HCI_WITH_BLOBS
+    if (impl->blobFilter && !frame.faces.empty())
+    {
+        findBlobs(frame);
+    }
+#endif
+}
+
+#if DRISHTI_HCI_WITH_BLOBS
+// CPU counterpart of the FaceFinder eye reflection search: the blob filter is evaluated over the
+// iris regions of the regression image only, and the peaks are decoded with the GPU protocol
+// (identity eye warps, since there is no eye atlas here).
+void FaceFinderCpu::findBlobs(Frame& frame)
+{
+    const auto& face = frame.faces.front(); // nearest
+    if (!(face.eyeFullR.has && face.eyeFullL.has))
+    {
+        return;
+    }
+
+    const cv::Matx33f Hfr = transformation::scale(frame.Sfr);
+    const cv::Matx33f N = transformation::normalize(frame.gray.size());
+    const cv::Rect bounds({ 0, 0 }, frame.gray.size());
+
+    std::array<drishti::eye::EyeWarp, 2> eyeWarps;
+    std::vector<cv::Rect> rois;
+    const std::array<const drishti::eye::EyeModel*, 2> eyes = { { &face.eyeFullR.value, &face.eyeFullL.value } };
+    for (int i = 0; i < 2; i++)
+    {
+        const auto eye = Hfr * (*eyes[i]);
+        const cv::Rect roi = eye.irisEllipse.boundingRect() & bounds;
+        eyeWarps[i] = drishti::eye::EyeWarp(roi, N, eye);
+        if (roi.area() > 0)
+        {
+            rois.push_back(roi);
+        }
+    }
+
+    if (!rois.empty())
+    {
+        const cv::Mat4b& peaks = (*impl->blobFilter)(frame.gray, rois);
+
+        EyeBlobJob job(frame.gray.size(), eyeWarps);
+        job.run(peaks, impl->blobFilter->getCellSize());
+        for (int i = 0; i < 2; i++)
+        {
+            frame.eyePoints[i] = std::move(job.eyePoints[i]);
+            for (auto& p : frame.eyePoints[i])
+            {
+                p.point *= (1.f / frame.Sfr);
+            }
+        }
+    }
+}
+#endif // DRISHTI_HCI_WITH_BLOBS
+
+// Same protocol as FaceFinder::notifyListeners() without the GPU FIFO latency.
+void FaceFinderCpu::notifyListeners(const Frame& frame)
+{
+    impl->history.push_front(frame);
+    while (impl->history.size() > static_cast<std::size_t>(std::max(impl->settings.history, 1)))
+    {
+        impl->history.pop_back();
+    }
+
+    const FaceMonitor::Request request = impl->callbacks.request(frame.faces, frame.time, 0);
+
+    std::vector<FaceMonitor::FaceImage> frames(std::min(static_cast<std::size_t>(std::max(request.n, 0)), impl->history.size()));
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+        const auto& entry = impl->history[i];
+        frames[i].time = entry.time;
+        frames[i].faceModels = entry.faces;
+        if (request.getFrames && request.getImage)
+        {
+            grabImage(entry.image, request, frames[i].image);
+        }
+    }
+
+    const bool isInitialized = (impl->history.size() >= static_cast<std::size_t>(impl->settings.history));
+    impl->callbacks.grab(frames, isInitialized);
+}
+
+static void grabImage(const cv::Mat3b& bgr, const FaceMonitor::Request& request, core::ImageView& view)
+{
+    view.texture = {};
+
+    const cv::Rect2f roi = request.getRoi();
+    cv::Rect box(cvRound(roi.x * bgr.cols), cvRound(roi.y * bgr.rows), cvRound(roi.width * bgr.cols), cvRound(roi.height * bgr.rows));
+    box &= cv::Rect({ 0, 0 }, bgr.size());
+    if (box.area() <= 0)
+    {
+        box = { { 0, 0 }, bgr.size() };
+    }
+
+    const cv::Size size = request.getImageSize(box.size());
+    cv::Mat3b image;
+    if (box.size() != size)
+    {
+        const int interpolation = (size.area() < box.area()) ? cv::INTER_AREA : cv::INTER_LINEAR;
+        cv::resize(bgr(box), image, size, 0, 0, interpolation);
+    }
+    else
+    {
+        image = bgr(box);
+    }
+
+    switch (request.format)
+    {
+        case FaceMonitor::Request::kRGBA:
+            cv::cvtColor(image, view.image, cv::COLOR_BGR2RGBA);
+            break;
+        case FaceMonitor::Request::kGray:
+            cv::cvtColor(image, view.planes, cv::COLOR_BGR2GRAY);
+            break;
+        case FaceMonitor::Request::kI420:
+            cv::cvtColor(image, view.planes, cv::COLOR_BGR2YUV_I420);
+            break;
+    }
+}
+
+DRISHTI_HCI_NAMESPACE_END
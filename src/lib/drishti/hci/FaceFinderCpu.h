@@ -0,0 +1,116 @@
+/*! -*-c++-*-
+  @file   FaceFinderCpu.h
+  @author David Hirvonen
+  @brief  Headless (CPU only) face detection and tracking class.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A FaceFinder variant for server side processing of recorded video without a GPU.
+  Frames are prepared (resampling + planar detection image) concurrently on a thread
+  pool, while detection, regression and tracking run in frame order, and results are
+  reported through the same FaceMonitor callbacks as FaceFinder.  Several instances
+  (e.g., one per video file) can share a thread pool and a FaceDetectorFactory so that
+  the regressor models are loaded once.
+
+*/
+
+#ifndef __drishti_hci_FaceFinderCpu_h__
+#define __drishti_hci_FaceFinderCpu_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/FaceMonitor.h"
+#include "drishti/hci/EyeGate.h"
+#include "drishti/hci/Scene.hpp" // FeaturePoint
+#include "drishti/face/Face.h"
+#include "drishti/face/FaceDetectorFactory.h"
+#include "drishti/face/FaceTracker.h"
+#include "drishti/sensor/Sensor.h"
+
+#include "thread_pool/thread_pool.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+
+// clang-format off
+namespace spdlog { class logger; };
+// clang-format on
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class FaceFinderCpu
+{
+public:
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+    using TimePoint = HighResolutionClock::time_point;
+
+    struct Settings
+    {
+        std::shared_ptr<drishti::sensor::SensorModel> sensor; // (optional) default: fx = image width
+        std::shared_ptr<spdlog::logger> logger;
+        std::shared_ptr<tp::ThreadPool<>> threads; // (optional) may be shared by many instances
+
+        int minFaceWidth = 0;            // smallest face width in pixels (0 == detector window)
+        int landmarksWidth = 1024;       // max regression image width (0 == full resolution)
+        float faceFinderInterval = 0.f;  // seconds between full detections (0 == every frame)
+        float acfCalibration = 0.f;      // ACF cascade calibration
+        bool doBatchedCascade = false;   // SIMD soft cascade over window batches (see ml::AcfCascade)
+        bool doSingleFace = false;       // report the strongest detection only
+        bool doEyes = true;              // eye model regression
+        bool doEyeGating = false;        // per track blink and head pose gating (see FaceFinder)
+        EyeGate::Settings eyeGate;
+        bool doBlobs = false;            // eye reflections of the nearest face (see BlobFilterCpu)
+
+        int history = 3;                 // delivered frames available to FaceMonitor::grab()
+        int pipelineDepth = 4;           // max frames in flight
+
+        float minFaceSeparation = 0.15f; // track association threshold
+        int minTrackHits = 3;
+        int maxTrackMisses = 3;
+        float trackMotionGain = 0.5f;
+    };
+
+    FaceFinderCpu(drishti::face::FaceDetectorFactory& factory, const Settings& settings);
+    ~FaceFinderCpu();
+
+    FaceFinderCpu(const FaceFinderCpu&) = delete;
+    FaceFinderCpu(FaceFinderCpu&&) = delete;
+    FaceFinderCpu& operator=(const FaceFinderCpu&) = delete;
+    FaceFinderCpu& operator=(FaceFinderCpu&&) = delete;
+
+    // Submit a BGR frame (copied).  Results for earlier frames are reported to the
+    // FaceMonitor callbacks (in frame order, on the calling thread) as they complete:
+    void operator()(const cv::Mat3b& frame, const TimePoint& time);
+
+    // Report all frames in flight (e.g., at the end of a video):
+    void flush();
+
+    void registerFaceMonitorCallback(FaceMonitor* callback, const FaceMonitor::Schedule& schedule = {});
+
+    std::size_t getFrameCount() const; // frames submitted so far
+
+    EyeGate::Stats getEyeGateStats() const;
+
+    // Eye reflections { right, left } of the nearest face in the last reported frame (full resolution):
+    std::array<std::vector<FeaturePoint>, 2> getEyePoints() const;
+
+protected:
+    struct Frame;
+    struct Impl;
+
+    bool needsDetection(const TimePoint& time);
+    void track(Frame& frame, bool doDetection);
+#if DRISHTI_HCI_WITH_BLOBS
+    void findBlobs(Frame& frame);
+#endif
+    void notifyListeners(const Frame& frame);
+
+    std::unique_ptr<Impl> impl;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_FaceFinderCpu_h__
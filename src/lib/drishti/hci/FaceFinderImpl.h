@@ -13,17 +13,36 @@
 
 #include "drishti/hci/drishti_hci.h"
 
+#include "drishti/core/Arena.h"               // drishti::core::FrameArena
+#include "drishti/core/AsyncLogger.h"         // drishti::core::AsyncLogger
 #include "drishti/core/Logger.h"              // spdlog::logger
+#include "drishti/core/MemoryRegistry.h"      // drishti::core::MemoryRegistry
+#include "drishti/core/SharedPool.h"          // drishti::core::SharedPool
+#include "drishti/core/SlotRing.h"            // drishti::core::SlotRing
+#include "drishti/core/StageTracer.h"         // drishti::core::StageTracer
 #include "drishti/eye/gpu/EllipsoPolarWarp.h" // ogles_gpgpu::EllipsoPolarWarp
 #include "drishti/eye/gpu/EyeWarp.h"
 #include "drishti/face/gpu/EyeFilter.h"       // ogles_gpgpu::EyeFilter
+#include "drishti/face/gpu/FaceStabilizer.h"  // drishti::face::FaceStabilizerFilter
+#include "drishti/face/gpu/EyePatchFilter.h"  // ogles_gpgpu::EyePatchFilter
+#include "drishti/face/gpu/FaceTileFilter.h"  // ogles_gpgpu::FaceTileFilter
+#include "drishti/face/gpu/GpuTimer.h"        // ogles_gpgpu::GpuTimer
+#include "drishti/graphics/area_resize.h"     // ogles_gpgpu::AreaResizeProc
+#include "drishti/graphics/crop_pack.h"       // ogles_gpgpu::CropPackProc
+#include "drishti/graphics/flow_reduce.h"     // ogles_gpgpu::FlowReduceProc
+#include "drishti/graphics/TexturePool.h"     // ogles_gpgpu::TexturePool
 #include "drishti/face/FaceDetector.h"        // drishti::face::FaceDetector
 #include "drishti/face/FaceDetectorFactory.h" // drishti::face::FaceDetectorFactory
 #include "drishti/face/FaceModelEstimator.h"  // drishti::face::FaceModelEstimator
 #include "drishti/face/FaceTracker.h"         // drishti::face::FaceTracker
-#include "drishti/hci/FaceMonitor.h"          // FaceMonitor*
+#include "drishti/hci/AcfPyramidBuilder.h"    // AcfPyramidBuilder
+#include "drishti/hci/DeviceOrientation.h"    // DeviceOrientation
+#include "drishti/hci/FaceMonitorDispatcher.h" // FaceMonitorDispatcher
 #include "drishti/hci/Scene.hpp"              // ScenePrimitives
+#include "drishti/hci/gpu/AcfComputeBuilder.h" // AcfComputeBuilder
+#if DRISHTI_HCI_WITH_BLOBS
 #include "drishti/hci/gpu/BlobFilter.h"       // ogles_gpgpu::BlobFilter
+#endif
 #include "drishti/sensor/Sensor.h"            // drishti::sensor::SensorModel
 
 #include <acf/ACF.h>                          // drishti::acf::Detector+Pyramid
@@ -33,11 +52,16 @@
 #include "ogles_gpgpu/common/proc/flow.h"      // ogles_gpgpu::FlowOptPipeline
 #include "ogles_gpgpu/common/proc/fifo.h"      // ogles_gpgpu::FifoProc
 #include "ogles_gpgpu/common/proc/transform.h" // ogles_gpgpu::TransformProc
+#include "ogles_gpgpu/common/proc/video.h"     // ogles_gpgpu::VideoSource
 #include "thread_pool/thread_pool.hpp"         // tp::ThreadPool<>
 
+#include <array>  // std::array<>
+#include <atomic> // std::atomic<>
 #include <chrono> // std::chrono::high_resolution_clock::time_point
+#include <deque>  // std::deque
 #include <future> // future
 #include <memory> // std::shared_ptr
+#include <mutex>  // std::mutex
 #include <vector> // vector
 
 #define DRISHTI_HCI_FACEFINDER_LANDMARKS_WIDTH 1024
@@ -59,30 +83,87 @@ struct FaceFinder::Impl
         , sensor(args.sensor)
         , logger(args.logger)
         , threads(args.threads)
+        , clock(args.clock)
+        , recorder(args.recorder)
+        , logPeriod(args.logPeriod)
+        , doGpuTiming(args.doGpuTiming)
         , 
          outputOrientation(args.outputOrientation)
+        , deviceOrientation(args.deviceOrientation)
+        , workingWidth(args.workingWidth)
 
         // ACF and detection parameters:
-        , 
-         acfCalibration(args.acfCalibration)
+        , pyramidCache(args.pyramidCache)
+        , acfCalibration(args.acfCalibration)
         , doSingleFace(args.doSingleFace)
         , faceFinderInterval(args.faceFinderInterval)
+        , doRoiDetection(args.doRoiDetection)
+        , roiFullScanInterval(args.roiFullScanInterval)
+        , roiPadding(args.roiPadding)
         , minDistanceMeters(args.minDetectionDistance)
         , maxDistanceMeters(args.maxDetectionDistance)
         , minTrackHits(args.minTrackHits)
         , maxTrackMisses(args.maxTrackMisses)
         , minFaceSeparation(args.minFaceSeparation)
+        , doTrackPrediction(args.doTrackPrediction)
+        , trackMotionGain(args.trackMotionGain)
+        , trackFaceStagesHint(args.trackFaceStagesHint)
+        , faceStagesHint(args.faceStagesHint)
+        , eyelidStagesHint(args.eyelidStagesHint)
+        , irisStagesHint(args.irisStagesHint)
+        , eyelidInits(args.eyelidInits)
+        , irisInits(args.irisInits)
+        , doLandmarkLite(args.doLandmarkLite)
+        , trackAssociation(args.trackAssociation)
+        , doEyeGating(args.doEyeGating)
+        , eyeGateSettings(args.eyeGate)
+        , doEyeResolution(args.doEyeResolution)
+        , eyeResolutionSettings(args.eyeResolution)
+        , doAdaptiveDetection(args.doAdaptiveDetection)
+        , detectionSettings(args.detectionScheduler)
+        , doGaze(args.doGaze)
+        , gazeSettings(args.gaze)
+        , doFaceHistory(args.doFaceHistory)
+        , faceHistorySettings(args.faceHistory)
+        , budgetSettings(args.budget)
+        , budgetLevels(args.budgetLevels)
+        , budgetIrisStages(args.budgetIrisStages)
+        , budgetEyelidStages(args.budgetEyelidStages)
+        , budgetTrackFaceStages(args.budgetTrackFaceStages)
+        , budgetInterval(args.budgetInterval)
+        , powerCallback(args.power)
+        , powerPolicy(args.powerPolicy)
 
         // Face landmarks:
         , doLandmarks(args.doLandmarks)
         , landmarksWidth(DRISHTI_HCI_FACEFINDER_LANDMARKS_WIDTH)
         , regressorCropScale(args.regressorCropScale)
+        , faceVerification(args.faceVerification)
 
         // Eye parameters:
-        , doBlobs(args.doBlobs)
-        , 
-         eyesSize(args.eyesSize)
+        , doBlobs(args.doBlobs && DRISHTI_HCI_WITH_BLOBS)
+        , doIris(args.doIris)
+        , doEyeFlow(args.doEyeFlow)
+        , eyesSize(args.eyesSize)
         , doEyesScaling(args.doEyesScaling)
+        , maxEyeFaces(args.maxEyeFaces)
+        , secondaryEyeStride(args.secondaryEyeStride)
+        , doEyeFlowReduction(args.doEyeFlowReduction)
+        , stabilizationGain(args.stabilizationGain)
+        , doGpuEyePatches(args.doGpuEyePatches)
+        , eyePatchWidth(args.eyePatchWidth)
+        , doLandmarkTiles(args.doLandmarkTiles)
+        , landmarkTileWidth(args.landmarkTileWidth)
+        , landmarkTilePadding(args.landmarkTilePadding)
+        , doGpuRegression(args.doGpuRegression)
+        , doComputeAcf(args.doComputeAcf)
+        , acfChangeBlock(args.acfChangeBlock)
+        , acfChangeThreshold(args.acfChangeThreshold)
+        , acfRefreshPeriod(args.acfRefreshPeriod)
+        , doGlobalMotion(args.doGlobalMotion)
+        , globalMotionGrid(args.globalMotionGrid)
+        , globalMotionWidth(args.globalMotionWidth)
+        , motionEstimator(args.globalMotion)
 
         // Annotations:
         , renderFaces(args.renderFaces)
@@ -93,7 +174,9 @@ struct FaceFinder::Impl
         , glVersionMajor(args.glVersionMajor)
         , glVersionMinor(args.glVersionMinor)
         , usePBO(args.usePBO)
+        , shaderCache(args.shaderCache)
         , doOptimizedPipeline(args.doOptimizedPipeline)
+        , pipelineDepth(args.pipelineDepth)
         , history(args.history)
         , ignoreLatestFramesInMonitor(args.ignoreLatestFramesInMonitor)
     {
@@ -106,13 +189,27 @@ struct FaceFinder::Impl
     // :::::::::::::::::::::::
     void* glContext = nullptr;
     std::shared_ptr<drishti::face::FaceDetectorFactory> factory;
+    std::shared_ptr<drishti::face::FaceDetectorFactory> swapFactory; // (optional) see swapModels()
+    std::mutex swapMutex;
     std::shared_ptr<drishti::sensor::SensorModel> sensor;
     std::shared_ptr<spdlog::logger> logger;
     std::shared_ptr<tp::ThreadPool<>> threads;
-    std::vector<FaceMonitor*> faceMonitorCallback;
+    FaceMonitorDispatcher faceMonitorCallback;
     ImageLogger imageLogger;
+    Clock clock; // (optional) frame timestamps
+    TimePoint captureTime; // next frame (see setCaptureTime())
+    bool hasCaptureTime = false;
+    std::array<TimePoint, 16> frameTimes; // frame index -> timestamp (pipelined scenes, see frameTime())
+    std::shared_ptr<SessionRecorder> recorder; // (optional)
     TimePoint start;
-    TimerInfo timerInfo;
+    std::unique_ptr<core::StageTracer> tracer;
+    bool doGpuTiming = false;
+    std::unique_ptr<ogles_gpgpu::GpuTimer> gpuTimer; // (optional) GPU stage spans
+    std::vector<ogles_gpgpu::GpuTimer::Span> gpuSpans;
+    std::unique_ptr<core::AsyncLogger> diagnostics; // per-frame records (sampled)
+    int logPeriod = 1;
+    int gazeCategory = 0;
+    std::atomic<std::uint64_t> detectFrameIndex{ 0 }; // frame currently in detect()
 
     bool doAnnotations = true;
     bool hasInit = false;
@@ -120,13 +217,34 @@ struct FaceFinder::Impl
     uint64_t frameIndex = 0;
     cv::Mat3f colors32FC3; // map angles to colors
 
+    TimePoint& frameTime(uint64_t index)
+    {
+        return frameTimes[index % frameTimes.size()];
+    }
+
     // :::::::::::::::::::::::::::::::::::::::
     // ::: Input frame related parameters: :::
     // :::::::::::::::::::::::::::::::::::::::
 
     int outputOrientation = 0;
+    std::atomic<int> requestedOrientation{ -1 }; // applied between frames (see updateOrientation())
+    DeviceOrientation deviceOrientation;         // gravity => orientation (see setGravity())
+
+    // Working resolution front end (see Settings::workingWidth):
+    int workingWidth = 0;
+    float workingScale = 1.f;                                    // working / camera
+    cv::Size fullSizeUp;                                         // upright camera size
+    std::unique_ptr<ogles_gpgpu::VideoSource> frontEndSource;    // camera frame input
+    std::unique_ptr<ogles_gpgpu::TransformProc> frontEndUpright; // rotation (camera resolution)
+    std::unique_ptr<ogles_gpgpu::AreaResizeProc> frontEnd;       // area downscale
+    std::shared_ptr<ogles_gpgpu::FifoProc> fullFifo;             // camera resolution frames for eye warps
     float brightness = 1.f;
     std::shared_ptr<ogles_gpgpu::FifoProc> fifo; // store last N faces
+    std::unique_ptr<ogles_gpgpu::TexturePool> texturePool; // retained FaceMonitor textures
+
+    // (lazy) Converted frame readback: RGBA or Y, U and V planes
+    std::array<std::unique_ptr<ogles_gpgpu::CropPackProc>, 3> grabProcs;
+    std::array<std::pair<cv::Size, cv::Size>, 3> grabShapes; // prepared { input, image } sizes
 
     // :::::::::::::::::::::::::::::::::::::::
     // ::: ACF and detection parameters:   :::
@@ -138,24 +256,135 @@ struct FaceFinder::Impl
     float ACFScale = 2.0f;
     std::vector<cv::Size> pyramidSizes;
     acf::Detector::Pyramid P;
+    cv::Size inputSizeUp;                   // upright input size (for pyramid updates)
+    cv::Size minDs;                         // detector default minimum pyramid level size
+    std::pair<double, double> pyramidScales; // level scale range for the distance band
+    bool doPyramidUpdate = false;
+    std::unique_ptr<AcfPyramidBuilder> acfBuilder; // parallel CPU pyramid (doCpuACF)
+    std::unique_ptr<AcfComputeBuilder> acfCompute; // compute shader pyramid (doComputeAcf)
+    std::unique_ptr<core::SharedPool<acf::Detector::Pyramid>> pyramids; // recycled GPU detection pyramids
+    std::size_t pyramidBytes = 0;                                       // planes of one pooled pyramid
+    std::shared_ptr<drishti::ml::AcfPyramidCache> pyramidCache;          // (optional) shared with other ACF models
     std::shared_ptr<ogles_gpgpu::ACF> acf;
     float acfCalibration = 0.f;
 
     // Detection:
     bool doSingleFace = false;
     double faceFinderInterval = DRISHTI_HCI_FACEFINDER_INTERVAL;
+    bool doRoiDetection = false;
+    int roiFullScanInterval = DRISHTI_HCI_FACEFINDER_ROI_FULL_SCAN_INTERVAL;
+    float roiPadding = 0.5f;
+    int roiScanCount = 0;                   // ROI scans since the last full scan
+    std::vector<cv::Rect> trackedObjects; // detection image coordinates (written by detect())
     float minDistanceMeters = 0.f;
     float maxDistanceMeters = 10.0f;
     std::size_t minTrackHits = 3;
     std::size_t maxTrackMisses = 3;
     float minFaceSeparation = 0.15;
+    bool doTrackPrediction = true;
+    float trackMotionGain = 0.5f;
+    int trackFaceStagesHint = 0; // reduced regression for predicted tracks (0 == all)
+    int faceStagesHint = 0;      // device tier regression cost (0 == model defaults)
+    int eyelidStagesHint = 0;
+    int irisStagesHint = 0;
+    int eyelidInits = 0;
+    int irisInits = 0;
+    bool doLandmarkLite = false;
+    drishti::face::FaceTracker::Association trackAssociation;
+    bool doEyeGating = false;
+    EyeGate::Settings eyeGateSettings;
+    std::unique_ptr<EyeGate> eyeGate; // called from (and updated by) detect()
+    bool doEyeResolution = true;
+    drishti::face::FaceDetector::EyeResolution eyeResolutionSettings;
+    bool doGaze = false;
+    GazeEstimator::Settings gazeSettings;
+    std::unique_ptr<GazeEstimator> gazeEstimator; // called from detect()
+    bool doFaceHistory = false;
+    FaceHistory::Settings faceHistorySettings;
+    std::unique_ptr<FaceHistory> faceHistory; // updated by notifyListeners() (OpenGL thread)
+    bool doIrisRefinement = true;     // detections (budget knob)
+
+    core::BudgetController::Settings budgetSettings;
+    int budgetLevels = 3;
+    cv::Vec2i budgetIrisStages;
+    cv::Vec2i budgetEyelidStages;
+    cv::Vec2i budgetTrackFaceStages;
+    cv::Vec2f budgetInterval;
+    std::unique_ptr<core::BudgetController> budget; // updated (and applied) by detect()
+
+    PowerPolicy::Callback powerCallback;
+    PowerPolicy powerPolicy;
+    PowerPolicy::Plan powerNominal;               // configured plan (zero pressure)
+    PowerPolicy::Plan powerPlan;                  // detect() only
+    std::atomic<double> powerInterval{ 0.0 };     // minimum detection interval (read by needsDetection())
+    std::atomic<float> powerPressure{ 0.f };
+    bool powerSkipEyes = false;                   // no eye regression for the current detect() call
+    std::vector<drishti::face::FaceModel> eyeHistory; // latest faces with eye models (interpolation)
     std::unique_ptr<drishti::face::FaceDetector> faceDetector;
     std::unique_ptr<drishti::face::FaceTracker> faceTracker;
+    core::FrameArena frameArena; // detect() temporaries (reset when the frame completes)
+    std::future<drishti::face::FaceModel> meanFace; // loading in the background (see init2())
+    bool hasModels = false;                         // initModels() done
 
     acf::Detector* detector = nullptr; // weak ref
     std::pair<time_point, std::vector<cv::Rect>> objects;
-    std::future<ScenePrimitives> scene;
-    std::deque<ScenePrimitives> scenePrimitives; // stash
+    TimePoint detectionTime; // timestamp of the last frame scheduled for detection
+    bool hasDetection = false;
+    bool isSuspended = false; // GL objects released (see suspend())
+    bool resumeRois = false;  // first detection after resume() scans trackedObjects
+    bool doAdaptiveDetection = false;
+    DetectionScheduler::Settings detectionSettings;
+    std::unique_ptr<DetectionScheduler> detectionScheduler; // decisions in operator(), signals from detect()
+    std::vector<double> objectScores; // detection scores for objects
+    ScenePool scenePool;                                    // one scene object per frame, recycled
+    FaceFinder::Backpressure backpressure = FaceFinder::kBlock;
+    std::size_t droppedFrames = 0;
+    bool isDropped = false; // the current output scene was dropped (no callbacks)
+    GLuint outputTexture = 0; // last output texture (returned for dropped frames)
+
+    // CPU scene jobs (oldest first) run in frame order on one persistent worker, see runFast():
+    struct SceneJob
+    {
+        FaceFinder::FrameInput frame;
+        ScenePrimitivesPtr scene;
+    };
+    using SceneRing = core::SlotRing<SceneJob>;
+    std::unique_ptr<SceneRing> sceneRing;
+    std::size_t abandonedScenes = 0; // late jobs at the front of sceneRing dropped by kDropOldest
+
+    // Jobs in flight whose results will be retrieved:
+    std::size_t getSceneJobCount() const
+    {
+        return sceneRing ? (sceneRing->size() - abandonedScenes) : 0;
+    }
+
+    // Jobs complete in order, so the last one finishing covers detect() for every frame:
+    void waitForScenes() const
+    {
+        if (sceneRing)
+        {
+            sceneRing->drain();
+        }
+    }
+
+    // Discard the results of all jobs in flight (they still run, see releaseAbandonedScenes()):
+    void abandonScenes()
+    {
+        abandonedScenes = sceneRing ? sceneRing->size() : 0;
+    }
+
+    // Release abandoned jobs once they complete:
+    void releaseAbandonedScenes()
+    {
+        while ((abandonedScenes > 0) && sceneRing->isDone(0))
+        {
+            sceneRing->at(0).scene.reset(); // back to scenePool
+            sceneRing->pop();
+            abandonedScenes--;
+        }
+    }
+
+    std::deque<ConstScenePrimitivesPtr> scenePrimitives; // stash (shared, read only)
 
     // ::::::::::::::::::::::::::::::::::::::::
     // ::: Face landmark parameters 2d->3d: :::
@@ -163,6 +392,7 @@ struct FaceFinder::Impl
     bool doLandmarks = false;
     int landmarksWidth = 256;
     float regressorCropScale = 0.f;
+    drishti::face::FaceDetector::Verification faceVerification;
 
     // Camera model, etc:
     cv::Point3f faceMotion;
@@ -172,18 +402,62 @@ struct FaceFinder::Impl
     // ::: Eye parameters: :::
     // :::::::::::::::::::::::
 
-    bool doBlobs = false;
-    bool doIris = false;
-    bool doEyeFlow = false;
+    std::atomic<bool> doBlobs{ false }; // optional stages follow these (see updateEyeStages())
+    std::atomic<bool> doIris{ false };
+    std::atomic<bool> doEyeFlow{ false };
     cv::Size eyesSize = { 480, 240 };
     bool doEyesScaling = true;
-
+    int maxEyeFaces = 1; // eye atlas tiles
+
+    // Eye quality tiers (see Settings::secondaryEyeStride), the eye mode callback may run on
+    // regression workers:
+    int secondaryEyeStride = 0;
+    std::mutex eyeTierMutex;
+    std::vector<cv::Point2f> eyeTierFaces;    // eye midpoints of the latest faces, near to far (full resolution)
+    std::vector<cv::Point2f> eyeTierDeferred; // faces without eye regression in the current detect() call
+    bool doEyeFlowReduction = false;
+    bool doGpuEyePatches = false;
+    int eyePatchWidth = 128;
+    bool doLandmarkTiles = false;
+    int landmarkTileWidth = 384;
+    float landmarkTilePadding = 0.5f;
+    bool doGpuRegression = false;
+    bool doComputeAcf = false;
+    int acfChangeBlock = 0;      // incremental CPU pyramid (0 == off)
+    float acfChangeThreshold = 0.02f;
+    int acfRefreshPeriod = 30;
+    std::atomic<std::int64_t> acfChangeFrame{ -1 }; // last pyramid with changes (written by preprocess())
+    std::int64_t objectsFrame = -1;                  // scene frame of the last detector call
+
+    float regressionScale = 1.f; // full->regression (see initACF())
+    cv::Size regressionSize;     // full frame regression image size
+    cv::Point tileOffset;        // regression image -> current tile (detect() only)
+    std::unique_ptr<ogles_gpgpu::FaceTileFilter> faceTileFilter;
+
+#if DRISHTI_HCI_WITH_BLOBS
     std::unique_ptr<ogles_gpgpu::BlobFilter> blobFilter;
+#endif
+    std::unique_ptr<ogles_gpgpu::EyePatchFilter> eyePatchFilter;
     std::unique_ptr<ogles_gpgpu::EyeFilter> eyeFilter;
     std::shared_ptr<ogles_gpgpu::EllipsoPolarWarp> ellipsoPolar[2];
     std::unique_ptr<ogles_gpgpu::FlowOptPipeline> eyeFlow;
     std::unique_ptr<ogles_gpgpu::SwizzleProc> eyeFlowBgra; // (optional)
     ogles_gpgpu::ProcInterface* eyeFlowBgraInterface = nullptr;
+    std::unique_ptr<ogles_gpgpu::FlowReduceProc> eyeFlowCells;   // (optional)
+    std::unique_ptr<ogles_gpgpu::FlowReduceProc> eyeFlowRegions; // (optional) 2 x maxEyeFaces
+
+    float stabilizationGain = 0.5f;
+    std::unique_ptr<drishti::face::FaceStabilizerFilter> stabilizer; // updated by detect()
+
+    // Global motion (optional):
+    bool doGlobalMotion = false;
+    cv::Size globalMotionGrid = { 16, 12 };
+    int globalMotionWidth = 256;
+    std::unique_ptr<ogles_gpgpu::TransformProc> sceneFlowInput; // resize
+    std::unique_ptr<ogles_gpgpu::FlowOptPipeline> sceneFlow;
+    std::unique_ptr<ogles_gpgpu::FlowReduceProc> sceneFlowGrid; // globalMotionGrid
+    drishti::geometry::SimilarityMotionEstimator motionEstimator;
+    std::vector<cv::Point2f> motionAnchors; // face centers from the last detect() (full resolution)
 
     FeaturePoints gazePoints;
     std::array<FeaturePoints, 2> eyePoints;
@@ -202,7 +476,9 @@ struct FaceFinder::Impl
     int glVersionMajor = 2;
     int glVersionMinor = 0;
     bool usePBO = false;
+    std::string shaderCache; // program binary directory (empty == compile only)
     bool doOptimizedPipeline = true;
+    int pipelineDepth = 2;
     int history = 3; // frame history
     int latency = 2;
     
@@ -213,6 +489,13 @@ struct FaceFinder::Impl
     std::unique_ptr<ogles_gpgpu::TransformProc> rotater; // output frame rotation
     
     bool ignoreLatestFramesInMonitor = true;
+
+    // :::::::::::::::::::::::::
+    // ::: Memory accounting :::
+    // :::::::::::::::::::::::::
+    std::atomic<std::size_t> textureBytes{ 0 }; // published by updateMemoryUsage() (GL thread)
+    std::atomic<std::size_t> poolBytes{ 0 };
+    std::vector<core::MemoryRegistry::Registration> memoryUsage; // last: probes read the members above
 };
 
 DRISHTI_HCI_NAMESPACE_END
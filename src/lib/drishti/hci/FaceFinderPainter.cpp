@@ -12,7 +12,9 @@
 #include "drishti/hci/FaceFinderImpl.h"
 #include "drishti/hci/gpu/FacePainter.h"
 #include "drishti/hci/gpu/LineDrawing.hpp"
+#if DRISHTI_HCI_WITH_BLOBS
 #include "drishti/hci/gpu/BlobFilter.h"
+#endif
 #include "drishti/hci/gpu/GLCircle.h"
 #include "drishti/eye/gpu/EllipsoPolarWarp.h"
 #include "drishti/core/drishti_operators.h"
@@ -34,16 +36,6 @@
 using drishti::face::operator*;
 using drishti::core::operator*;
 
-struct MethodLog
-{
-    MethodLog(std::string  name)
-        : name(std::move(name))
-    {
-    }
-    std::string name;
-    std::stringstream ss;
-};
-
 DRISHTI_HCI_NAMESPACE_BEGIN
 
 static void getImage(ogles_gpgpu::ProcInterface& proc, FaceFinderPainter::FrameDelegate& callback)
@@ -220,6 +212,15 @@ void FaceFinderPainter::initPainter(const cv::Size& inputSizeUp)
     m_painter->prepare(inputSizeUp.width, inputSizeUp.height, GL_RGBA);
 }
 
+void FaceFinderPainter::releasePainter()
+{
+    m_painter.reset();
+    m_rotater.reset();
+#if DRISHTI_HCI_FACE_FINDER_PAINTER_SHOW_CIRCLE
+    m_circle.reset();
+#endif
+}
+
 template <typename Container>
 void cat(const Container& a, const Container& b, Container& c)
 {
@@ -230,13 +231,8 @@ void cat(const Container& a, const Container& b, Container& c)
 
 GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTexture)
 {
-    // clang-format on
-    MethodLog timeSummary(DRISHTI_LOCATION_SIMPLE);
-    core::ScopeTimeLogger paintLogger = [&](double ts) {
-        impl->logger->info("TIMING:{}={};{}", timeSummary.name, ts, timeSummary.ss.str());
-    };
-// clang-format off
-    
+    // clang-format off
+
 #if DRISHTI_HCI_FACE_FINDER_PAINTER_SHOW_CIRCLE
     {
         const auto toc = std::chrono::high_resolution_clock::now();
@@ -266,7 +262,7 @@ GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTextu
     
     if (scene.faces().size())
     {
-        core::ScopeTimeLogger faceTime = [&](double ts) { timeSummary.ss << "FACES=" << ts << ";"; };
+        auto span = impl->tracer->scope(kPaintFaces, scene.m_frameIndex);
         for (const auto& f : scene.faces())
         {
             m_painter->addFace(f);
@@ -290,7 +286,7 @@ GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTextu
             }
         }
         
-        if (impl->doIris && m_drawIris)
+        if (impl->ellipsoPolar[0] && m_drawIris)
         {
             //Draw the normalized iris (polar coordinates):
             for (int i = 0; i < 2; i++)
@@ -304,10 +300,12 @@ GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTextu
         rectanglesToDrawings(scene.objects() * impl->ACFScale, m_painter->getLineDrawings());
     }
 
-    if (impl->doBlobs)
+#if DRISHTI_HCI_WITH_BLOBS
+    if (impl->blobFilter)
     {
         m_painter->setBlobTexture(impl->blobFilter->getOutputTexId(), impl->blobFilter->getOutFrameSize());
     }
+#endif
     
     if (impl->doEyeFlow)
     {
@@ -318,7 +316,8 @@ GLuint FaceFinderPainter::filter(const ScenePrimitives& scene, GLuint inputTextu
     m_painter->setEyesWidthRatio(impl->renderEyesWidthRatio);
     
     {
-        core::ScopeTimeLogger processTime = [&](double ts) { timeSummary.ss << "PROCESS=" << ts << ";"; };
+        auto span = impl->tracer->scope(kPaintProcess, scene.m_frameIndex);
+        auto gpu = gpuScope(kGpuPaint, scene.m_frameIndex);
         m_painter->process(inputTexture, 1, GL_TEXTURE_2D);
     }
     
@@ -332,9 +331,11 @@ GLuint FaceFinderPainter::paint(const ScenePrimitives& scene, GLuint inputTextur
     // Here we can choose one of several display layouts or effects:
     switch(m_effect)
     {
-        case kStabilize : return stabilize(inputTexture, m_inputSizeUp, scene.faces().size() ? scene.faces()[0] : face::FaceModel());
+        case kStabilize : return stabilize(inputTexture, m_inputSizeUp, scene);
         case kWireframes :
-        default : return filter(scene, inputTexture);
+        default :
+            releaseFaceFilters(); // stabilization textures (if any)
+            return filter(scene, inputTexture);
     }
 }
 
@@ -67,6 +67,7 @@ public:
 
 protected:
     void initPainter(const cv::Size& inputSizeUp) override;
+    void releasePainter() override;
     GLuint paint(const ScenePrimitives& scene, GLuint inputTexture) override;
 
     GLuint filter(const ScenePrimitives& scene, GLuint inputTexture);
@@ -0,0 +1,205 @@
+/*! -*-c++-*-
+  @file   drishti/hci/FaceHistory.cpp
+  @author David Hirvonen
+  @brief  Implementation of a bounded per track face (and eye) history.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/FaceHistory.h"
+
+#include <algorithm>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+FaceHistory::FaceHistory(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+void FaceHistory::update(const std::vector<drishti::face::FaceModel>& faces, const std::vector<std::size_t>& tracks, const TimePoint& time, std::uint64_t frameIndex)
+{
+    if (tracks.size() == faces.size())
+    {
+        for (std::size_t i = 0; i < faces.size(); i++)
+        {
+            append(tracks[i], faces[i], time, frameIndex);
+        }
+    }
+
+    // Release the tracks with no samples within the depth (their buffers are kept):
+    for (std::size_t i = 0; i < m_tracks.size();)
+    {
+        expire(m_tracks[i], time);
+        if (m_tracks[i].count == 0)
+        {
+            m_free.push_back(std::move(m_tracks[i]));
+            m_tracks.erase(m_tracks.begin() + i);
+            m_identifiers.erase(m_identifiers.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void FaceHistory::append(std::size_t identifier, const drishti::face::FaceModel& face, const TimePoint& time, std::uint64_t frameIndex)
+{
+    const std::size_t capacity = static_cast<std::size_t>(std::max(m_settings.capacity, 1));
+
+    Track* track = find(identifier);
+    if (!track)
+    {
+        if (m_tracks.size() >= static_cast<std::size_t>(std::max(m_settings.maxTracks, 1)))
+        {
+            // Replace the least recently updated track:
+            const auto stale = std::min_element(m_tracks.begin(), m_tracks.end(), [](const Track& a, const Track& b) {
+                return a.last().time < b.last().time;
+            });
+            const auto index = std::distance(m_tracks.begin(), stale);
+            m_free.push_back(std::move(*stale));
+            m_tracks.erase(stale);
+            m_identifiers.erase(m_identifiers.begin() + index);
+        }
+
+        if (m_free.empty())
+        {
+            m_tracks.emplace_back();
+        }
+        else
+        {
+            m_tracks.push_back(std::move(m_free.back()));
+            m_free.pop_back();
+        }
+        m_identifiers.push_back(identifier);
+
+        track = &m_tracks.back();
+        track->identifier = identifier;
+        track->head = 0;
+        track->count = 0;
+    }
+    else if (track->last().time > time)
+    {
+        track->count = 0; // the clock went backwards
+    }
+
+    if (track->samples.size() != capacity)
+    {
+        track->samples.resize(capacity);
+        track->head = 0;
+        track->count = 0;
+    }
+
+    // Overwrite the oldest sample when the ring is full:
+    if (track->count == capacity)
+    {
+        track->head = (track->head + 1) % capacity;
+        track->count--;
+    }
+
+    Sample& sample = track->samples[(track->head + track->count) % capacity];
+    sample.time = time;
+    sample.frameIndex = frameIndex;
+    sample.face = face; // copy assignment reuses the vector capacity
+    track->count++;
+
+    expire(*track, time);
+}
+
+FaceHistory::View FaceHistory::query(std::size_t identifier) const
+{
+    const Track* track = find(identifier);
+    return track ? view(*track, 0, track->count) : View();
+}
+
+FaceHistory::View FaceHistory::query(std::size_t identifier, const TimePoint& begin, const TimePoint& end) const
+{
+    const Track* track = find(identifier);
+    if (!track || (end < begin))
+    {
+        return View();
+    }
+
+    // Samples are in time order, so [first, last) are the lower and upper bounds:
+    std::size_t first = 0, last = 0;
+    for (std::size_t n = track->count; n > 0;)
+    {
+        const std::size_t half = n / 2;
+        if (track->at(first + half).time < begin)
+        {
+            first += half + 1;
+            n -= half + 1;
+        }
+        else
+        {
+            n = half;
+        }
+    }
+    last = first;
+    for (std::size_t n = track->count - first; n > 0;)
+    {
+        const std::size_t half = n / 2;
+        if (end < track->at(last + half).time)
+        {
+            n = half;
+        }
+        else
+        {
+            last += half + 1;
+            n -= half + 1;
+        }
+    }
+    return view(*track, first, last);
+}
+
+void FaceHistory::clear()
+{
+    for (auto& track : m_tracks)
+    {
+        m_free.push_back(std::move(track));
+    }
+    m_tracks.clear();
+    m_identifiers.clear();
+}
+
+FaceHistory::Track* FaceHistory::find(std::size_t identifier)
+{
+    const auto iter = std::find(m_identifiers.begin(), m_identifiers.end(), identifier);
+    return (iter != m_identifiers.end()) ? &m_tracks[std::distance(m_identifiers.begin(), iter)] : nullptr;
+}
+
+const FaceHistory::Track* FaceHistory::find(std::size_t identifier) const
+{
+    const auto iter = std::find(m_identifiers.begin(), m_identifiers.end(), identifier);
+    return (iter != m_identifiers.end()) ? &m_tracks[std::distance(m_identifiers.begin(), iter)] : nullptr;
+}
+
+void FaceHistory::expire(Track& track, const TimePoint& time) const
+{
+    const auto depth = std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(m_settings.depth));
+    while (track.count && (track.at(0).time < (time - depth)))
+    {
+        track.head = (track.head + 1) % track.samples.size();
+        track.count--;
+    }
+}
+
+FaceHistory::View FaceHistory::view(const Track& track, std::size_t first, std::size_t last) const
+{
+    if (first >= last)
+    {
+        return View();
+    }
+
+    // Split the logical range [first, last) at the end of the ring buffer:
+    const std::size_t capacity = track.samples.size();
+    const std::size_t begin = (track.head + first) % capacity;
+    const std::size_t size = last - first;
+    const std::size_t firstSize = std::min(size, capacity - begin);
+    return View(&track.samples[begin], firstSize, track.samples.data(), size - firstSize);
+}
+
+DRISHTI_HCI_NAMESPACE_END
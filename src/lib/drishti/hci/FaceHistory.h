@@ -0,0 +1,158 @@
+/*! -*-c++-*-
+  @file   drishti/hci/FaceHistory.h
+  @author David Hirvonen
+  @brief  Declaration of a bounded per track face (and eye) history.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Each face track (see face::FaceTracker::TrackInfo::identifier) owns a ring of the last
+  Settings::capacity samples no older than Settings::depth seconds, for short term
+  analysis such as blinks and saccades.  Samples are assigned in place, so once the
+  rings are warm an append is O(1) with no allocations, and memory is bounded by
+  maxTracks * capacity face models.  Queries return views into the rings (no copies).
+
+*/
+
+#ifndef __drishti_hci_FaceHistory_h__
+#define __drishti_hci_FaceHistory_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/face/Face.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class FaceHistory
+{
+public:
+    using TimePoint = std::chrono::high_resolution_clock::time_point;
+
+    struct Settings
+    {
+        double depth = 2.0;  // seconds
+        int capacity = 64;   // samples per track
+        int maxTracks = 4;   // the least recently updated track is replaced
+    };
+
+    struct Sample
+    {
+        TimePoint time;
+        std::uint64_t frameIndex = 0;
+        drishti::face::FaceModel face; // full resolution, including the eye models
+    };
+
+    // Samples in time order (oldest first), i.e., the (at most two) ring segments:
+    class View
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Sample;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Sample*;
+            using reference = const Sample&;
+
+            const_iterator(const View* view, std::size_t index)
+                : m_view(view)
+                , m_index(index)
+            {
+            }
+            const Sample& operator*() const { return (*m_view)[m_index]; }
+            const Sample* operator->() const { return &(*m_view)[m_index]; }
+            const_iterator& operator++()
+            {
+                m_index++;
+                return *this;
+            }
+            bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+            bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+        protected:
+            const View* m_view = nullptr;
+            std::size_t m_index = 0;
+        };
+
+        View() = default;
+        View(const Sample* first, std::size_t firstSize, const Sample* second, std::size_t secondSize)
+            : m_first(first)
+            , m_second(second)
+            , m_firstSize(firstSize)
+            , m_secondSize(secondSize)
+        {
+        }
+
+        std::size_t size() const { return m_firstSize + m_secondSize; }
+        bool empty() const { return size() == 0; }
+
+        const Sample& operator[](std::size_t i) const
+        {
+            return (i < m_firstSize) ? m_first[i] : m_second[i - m_firstSize];
+        }
+        const Sample& front() const { return (*this)[0]; }
+        const Sample& back() const { return (*this)[size() - 1]; }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, size()); }
+
+    protected:
+        const Sample* m_first = nullptr;
+        const Sample* m_second = nullptr;
+        std::size_t m_firstSize = 0;
+        std::size_t m_secondSize = 0;
+    };
+
+    FaceHistory() = default;
+    explicit FaceHistory(const Settings& settings);
+
+    const Settings& getSettings() const { return m_settings; }
+
+    // Append the faces of one frame, where tracks[i] is the track of faces[i] (frames without
+    // track identifiers are skipped), and release the tracks that expired:
+    void update(const std::vector<drishti::face::FaceModel>& faces, const std::vector<std::size_t>& tracks, const TimePoint& time, std::uint64_t frameIndex);
+
+    // Append a single sample, a sample older than the last one restarts the track:
+    void append(std::size_t track, const drishti::face::FaceModel& face, const TimePoint& time, std::uint64_t frameIndex);
+
+    // Active track identifiers, most recently started last:
+    const std::vector<std::size_t>& getTracks() const { return m_identifiers; }
+
+    // Samples of a track within [begin, end] (empty for unknown tracks), valid until the next update:
+    View query(std::size_t track) const;
+    View query(std::size_t track, const TimePoint& begin, const TimePoint& end) const;
+
+    void clear();
+
+protected:
+    struct Track
+    {
+        std::size_t identifier = 0;
+        std::vector<Sample> samples; // ring
+        std::size_t head = 0;        // oldest sample
+        std::size_t count = 0;
+
+        const Sample& at(std::size_t i) const { return samples[(head + i) % samples.size()]; }
+        const Sample& last() const { return at(count - 1); }
+    };
+
+    Track* find(std::size_t identifier);
+    const Track* find(std::size_t identifier) const;
+    void expire(Track& track, const TimePoint& time) const;
+    View view(const Track& track, std::size_t first, std::size_t last) const;
+
+    Settings m_settings;
+    std::vector<Track> m_tracks;            // active tracks (insertion order)
+    std::vector<Track> m_free;              // released tracks (buffers are reused)
+    std::vector<std::size_t> m_identifiers; // see getTracks()
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_FaceHistory_h__
@@ -12,6 +12,7 @@
 #define __drishti_hci_FaceMonitor_h__
 
 #include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/FaceHistory.h"
 #include "drishti/face/Face.h"
 #include "drishti/eye/Eye.h"
 #include "drishti/core/ImageView.h" // Image and/or Texture
@@ -67,6 +68,14 @@ public:
 
     struct Request
     {
+        //! Pixel formats for images (Request::getImage):
+        enum Format
+        {
+            kRGBA, //! 32-bit color image (core::ImageView::image)
+            kGray, //! 8-bit (BT.601) luma plane (core::ImageView::planes)
+            kI420  //! 8-bit Y plane followed by U and V planes at half resolution (core::ImageView::planes)
+        };
+
         Request() = default;
         Request
         (
@@ -89,7 +98,54 @@ public:
         bool getTexture = false;  //! Request a texture (typically no overhead)
         bool getFrames = true;    //! Retrieve frame textures or images
         bool getEyes = true;      //! Retrieve eye textures or images
+        bool retainTexture = false; //! Textures are GPU copies the client may hold (core::Texture::lease)
+
+        // Frame images are resampled and converted on the GPU before readback:
+        Format format = kRGBA;    //! Pixel format for frame images
+        cv::Size size;            //! Frame image size (0 == native, a single 0 preserves the ROI aspect ratio)
+        cv::Rect2f roi;           //! Normalized frame crop, e.g., a face region (empty == full frame)
+
+        // Image size for a region of roiSize pixels, aligned for plane packing (4 pixels per texel):
+        cv::Size getImageSize(const cv::Size& roiSize) const
+        {
+            cv::Size result = size;
+            if (!result.width && !result.height)
+            {
+                result = roiSize;
+            }
+            else if (!result.height)
+            {
+                result.height = cvRound(static_cast<double>(result.width) * roiSize.height / roiSize.width);
+            }
+            else if (!result.width)
+            {
+                result.width = cvRound(static_cast<double>(result.height) * roiSize.width / roiSize.height);
+            }
+
+            const int align = (format == kI420) ? 8 : ((format == kGray) ? 4 : 1);
+            result.width = std::max(((result.width + align - 1) / align) * align, align);
+            result.height = std::max(result.height, 1);
+            if (format == kI420)
+            {
+                result.height = std::max((result.height + 1) & ~1, 2);
+            }
+            return result;
+        }
 
+        // Normalized crop clipped to the frame (the full frame when empty):
+        cv::Rect2f getRoi() const
+        {
+            const cv::Rect2f frame(0.f, 0.f, 1.f, 1.f);
+            const cv::Rect2f clipped = roi & frame;
+            return (clipped.area() > 0.f) ? clipped : frame;
+        }
+
+        bool isNative() const
+        {
+            return (format == kRGBA) && (size.width == 0) && (size.height == 0) && (roi.area() <= 0.f);
+        }
+
+        // Listeners typically agree on the image format; the first non-native format wins.
         Request& operator|=(const Request& src)
         {
             n = std::max(n, src.n);
@@ -97,10 +153,40 @@ public:
             getImage |= src.getImage;
             getFrames |= src.getFrames;
             getEyes |= src.getEyes;
+            retainTexture |= src.retainTexture;
+            if (isNative() && !src.isNative())
+            {
+                format = src.format;
+                size = src.size;
+                roi = src.roi;
+            }
             return (*this);
         }
     };
 
+    /**
+     * Per listener delivery options (see FaceFinder::registerFaceMonitorCallback()).
+     */
+    struct Schedule
+    {
+        //! Maximum callback rate in Hz (0 == every frame), frames in between skip both callbacks.
+        double maxRate = 0.0;
+
+        //! Call grab() on a dedicated dispatch thread instead of the (OpenGL) processing thread.
+        //! The frame images are shared with the readback and textures may be recycled by then.
+        //! A frame is dropped for this listener if its previous grab() is still running.
+        bool isAsync = false;
+    };
+
+    /**
+     * An optional callback with the recent faces and eyes of each track (see
+     * FaceFinder::Settings::doFaceHistory), called before request() on the same
+     * thread.  The views share the history buffers and are only valid until it returns.
+     * @param history the per track face history, up to and including the current frame
+     * @param timeStamp the acquisition timestamp for the frame
+     */
+    virtual void update(const FaceHistory& history, const TimePoint& timeStamp) {}
+
     /**
      * A user defined virtual method callback that should report the number
      * of frames that should be captured from teh FIFO buffer based on the 
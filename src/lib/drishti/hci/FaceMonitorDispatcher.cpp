@@ -0,0 +1,113 @@
+/*! -*-c++-*-
+  @file   drishti/hci/FaceMonitorDispatcher.cpp
+  @author David Hirvonen
+  @brief  Implementation of a FaceMonitor listener scheduler with coalesced requests.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/FaceMonitorDispatcher.h"
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+FaceMonitorDispatcher::FaceMonitorDispatcher() = default;
+
+FaceMonitorDispatcher::~FaceMonitorDispatcher()
+{
+    flush();
+}
+
+void FaceMonitorDispatcher::add(FaceMonitor* monitor, const FaceMonitor::Schedule& schedule)
+{
+    Listener listener;
+    listener.monitor = monitor;
+    listener.schedule = schedule;
+    m_listeners.push_back(std::move(listener));
+
+    if (schedule.isAsync && !m_thread)
+    {
+        tp::ThreadPoolOptions options;
+        options.setThreadCount(1); // callbacks are serialized
+        m_thread = drishti::core::make_unique<tp::ThreadPool<>>(options);
+    }
+}
+
+FaceMonitor::Request FaceMonitorDispatcher::request(const FaceMonitor::Faces& faces, const TimePoint& time, std::uint32_t tex, const FaceHistory* history)
+{
+    FaceMonitor::Request request{ 0, false, false, false, false };
+    for (auto& listener : m_listeners)
+    {
+        listener.isDue = true;
+        if ((listener.schedule.maxRate > 0.0) && listener.hasLast)
+        {
+            // Allow a small jitter so that a 5 Hz listener fires every 6th frame at 30 Hz:
+            const double period = 1.0 / listener.schedule.maxRate;
+            const double elapsed = std::chrono::duration<double>(time - listener.last).count();
+            listener.isDue = (elapsed >= (period * 0.95));
+        }
+
+        if (listener.isDue)
+        {
+            listener.last = time;
+            listener.hasLast = true;
+            if (history)
+            {
+                listener.monitor->update(*history, time);
+            }
+            listener.request = listener.monitor->request(faces, time, tex);
+            request |= listener.request;
+        }
+    }
+    return request;
+}
+
+void FaceMonitorDispatcher::grab(const std::vector<FaceMonitor::FaceImage>& frames, bool isInitialized)
+{
+    for (auto& listener : m_listeners)
+    {
+        if (!listener.isDue)
+        {
+            continue;
+        }
+        listener.isDue = false;
+
+        // Each listener receives the most recent frames it asked for from the shared readback:
+        const auto n = std::min(static_cast<std::size_t>(std::max(listener.request.n, 0)), frames.size());
+        std::vector<FaceMonitor::FaceImage> subset(frames.begin(), frames.begin() + n);
+
+        if (!listener.schedule.isAsync)
+        {
+            listener.monitor->grab(subset, isInitialized);
+            continue;
+        }
+
+        if (listener.pending.valid() && (listener.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+        {
+            m_dropped++; // the previous frame is still being processed
+            continue;
+        }
+
+        auto* monitor = listener.monitor;
+        listener.pending = m_thread->process([monitor, subset, isInitialized]() {
+            monitor->grab(subset, isInitialized);
+        });
+    }
+}
+
+void FaceMonitorDispatcher::flush()
+{
+    for (auto& listener : m_listeners)
+    {
+        if (listener.pending.valid())
+        {
+            listener.pending.wait();
+        }
+    }
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,76 @@
+/*! -*-c++-*-
+  @file   drishti/hci/FaceMonitorDispatcher.h
+  @author David Hirvonen
+  @brief  Declaration of a FaceMonitor listener scheduler with coalesced requests.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The requests of all listeners that are due at a frame are merged into one request, so
+  the frames are read back once and each listener receives the last n frames it asked for.
+  Listeners can be rate limited and can receive their frames on a dedicated thread, see
+  FaceMonitor::Schedule.
+
+*/
+
+#ifndef __drishti_hci_FaceMonitorDispatcher_h__
+#define __drishti_hci_FaceMonitorDispatcher_h__
+
+#include "drishti/hci/FaceMonitor.h"
+
+#include "thread_pool/thread_pool.hpp"
+
+#include <future>
+#include <memory>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class FaceMonitorDispatcher
+{
+public:
+    using TimePoint = FaceMonitor::TimePoint;
+
+    FaceMonitorDispatcher();
+    ~FaceMonitorDispatcher(); // waits for pending asynchronous callbacks
+
+    FaceMonitorDispatcher(const FaceMonitorDispatcher&) = delete;
+    FaceMonitorDispatcher(FaceMonitorDispatcher&&) = delete;
+    FaceMonitorDispatcher& operator=(const FaceMonitorDispatcher&) = delete;
+    FaceMonitorDispatcher& operator=(FaceMonitorDispatcher&&) = delete;
+
+    void add(FaceMonitor* monitor, const FaceMonitor::Schedule& schedule = {});
+    std::size_t size() const { return m_listeners.size(); }
+
+    // Call update() (with a history) and request() on the listeners that are due and return the
+    // union of their requests:
+    FaceMonitor::Request request(const FaceMonitor::Faces& faces, const TimePoint& time, std::uint32_t tex, const FaceHistory* history = nullptr);
+
+    // Deliver the frames read back for the last request() to the listeners that are due:
+    void grab(const std::vector<FaceMonitor::FaceImage>& frames, bool isInitialized);
+
+    // Wait for the pending asynchronous callbacks:
+    void flush();
+
+    std::size_t getDropped() const { return m_dropped; } // asynchronous deliveries skipped
+
+protected:
+    struct Listener
+    {
+        FaceMonitor* monitor = nullptr;
+        FaceMonitor::Schedule schedule;
+        FaceMonitor::Request request;
+        TimePoint last;
+        bool hasLast = false;
+        bool isDue = false;
+        std::future<void> pending;
+    };
+
+    std::vector<Listener> m_listeners;
+    std::unique_ptr<tp::ThreadPool<>> m_thread; // created with the first asynchronous listener
+    std::size_t m_dropped = 0;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_FaceMonitorDispatcher_h__
@@ -19,21 +19,37 @@
 #include <opencv2/video/video.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <mutex>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
+static float safeAsin(float value)
+{
+    return std::asin(std::min(std::max(value, -1.f), 1.f));
+}
+
 class GazeEstimator::Impl
 {
 public:
     using PointPair = GazeEstimator::GazeEstimate;
 
+    // Normal equations for the affine { yaw, pitch } correction: A = ([x 1]' [x 1])^-1 [x 1]' y
     struct GazeMeasurement
     {
+        cv::Matx33d XtX = cv::Matx33d::zeros();
+        cv::Matx<double, 3, 2> XtY = cv::Matx<double, 3, 2>::zeros();
+        std::size_t count = 0;
     };
 
-    Impl()
-    = default;
+    Impl() = default;
+    explicit Impl(const GazeEstimator::Settings& settings)
+        : m_settings(settings)
+    {
+    }
+
     void begin()
     {
     }
@@ -45,6 +61,7 @@ public:
 
     void reset()
     {
+        resetCalibration();
     }
 
     std::pair<face::FaceModel, cv::Matx33f> getNormalizedFace(const face::FaceModel& faceIn) const
@@ -57,13 +74,154 @@ public:
         return std::make_pair(face, H);
     }
 
+    // Coarse estimate from the face landmarks: the nose tip relative to the eye midpoint in an eye
+    // aligned frame, normalized by the eye distance (head pose dominated), and the mean eye openness:
     PointPair operator()(const face::FaceModel& faceIn)
     {
         PointPair gaze;
+
+        const cv::Point2f pR = faceIn.getEyeRightCenter(), pL = faceIn.getEyeLeftCenter();
+        const cv::Point2f v = pL - pR;
+        const float distance = static_cast<float>(cv::norm(v));
+        if (distance <= 0.f)
+        {
+            return gaze;
+        }
+
+        const cv::Point2f e1 = v * (1.f / distance), e2(-e1.y, e1.x);
+        if (faceIn.noseTip.has)
+        {
+            const cv::Point2f d = (faceIn.noseTip.value - ((pR + pL) * 0.5f)) * (1.f / distance);
+            gaze.relative = { d.dot(e1), d.dot(e2) };
+        }
+
+        int count = 0;
+        for (const auto* eye : { &faceIn.eyeFullR, &faceIn.eyeFullL })
+        {
+            if (eye->has && !eye->value.eyelids.empty())
+            {
+                gaze.openness += eye->value.openness();
+                count++;
+            }
+        }
+        if (count)
+        {
+            gaze.openness /= static_cast<float>(count);
+        }
+
+        // Head pose (zero without a nose tip):
+        const cv::Point2f head = faceIn.noseTip.has ? (gaze.relative - m_settings.headCenter) : cv::Point2f();
+        const cv::Point2f headAngles(safeAsin(head.x * m_settings.headGain), safeAsin(head.y * m_settings.headGain));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const float roll = std::atan2(e1.y, e1.x), cr = std::cos(roll), sr = std::sin(roll);
+        const core::Field<DRISHTI_EYE::EyeModel>* eyes[2] = { &faceIn.eyeFullR, &faceIn.eyeFullL };
+        for (int i = 0; i < 2; i++)
+        {
+            const auto& eye = *eyes[i];
+            if (!eye.has || (static_cast<int>(eye->eyelids.size()) <= std::max(eye->cornerIndices[0], eye->cornerIndices[1])) || (eye->irisEllipse.size.width <= 0.f))
+            {
+                continue;
+            }
+
+            // Iris displacement w.r.t. the corner midpoint (eye width units) in the eye aligned frame:
+            const cv::Point2f c0 = eye->getOuterCorner(), c1 = eye->getInnerCorner();
+            const float width = static_cast<float>(cv::norm(c1 - c0));
+            if (width <= 0.f)
+            {
+                continue;
+            }
+            const cv::Point2f d = (eye->irisEllipse.center - ((c0 + c1) * 0.5f)) * (1.f / width);
+            const cv::Point2f eyeAngles(safeAsin(d.dot(e1) * m_settings.eyeGain), safeAsin(d.dot(e2) * m_settings.eyeGain));
+
+            cv::Point2f angles = eyeAngles + headAngles;
+            if (m_isCalibrated)
+            {
+                const cv::Vec3d x(angles.x, angles.y, 1.0);
+                const cv::Vec2d y = m_correction.t() * x;
+                angles = { static_cast<float>(y[0]), static_cast<float>(y[1]) };
+            }
+
+            // Eye aligned frame -> camera (undo the roll):
+            const cv::Vec3f g(std::sin(angles.x) * std::cos(angles.y), std::sin(angles.y), -std::cos(angles.x) * std::cos(angles.y));
+            gaze.hasEyes[i] = true;
+            gaze.angles[i] = angles;
+            gaze.directions[i] = { g[0] * cr - g[1] * sr, g[0] * sr + g[1] * cr, g[2] };
+        }
+
         return gaze;
     }
 
+    void addCalibrationSample(const PointPair& estimate, const cv::Point2f& target)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < 2; i++)
+        {
+            if (estimate.hasEyes[i])
+            {
+                // Fit on the uncalibrated angles:
+                cv::Point2f angles = estimate.angles[i];
+                if (m_isCalibrated)
+                {
+                    angles = uncalibrate(angles);
+                }
+
+                const cv::Vec3d x(angles.x, angles.y, 1.0);
+                m_samples.XtX += x * x.t();
+                m_samples.XtY += x * cv::Matx12d(target.x, target.y);
+                m_samples.count++;
+            }
+        }
+    }
+
+    bool calibrate()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_samples.count < 3)
+        {
+            return false;
+        }
+
+        cv::Mat correction;
+        if (!cv::solve(cv::Mat(m_samples.XtX), cv::Mat(m_samples.XtY), correction, cv::DECOMP_CHOLESKY))
+        {
+            return false; // degenerate (e.g., a single fixation point)
+        }
+        m_correction = correction;
+        m_isCalibrated = true;
+        return true;
+    }
+
+    void resetCalibration()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_samples = {};
+        m_correction = cv::Matx<double, 3, 2>(1, 0, 0, 1, 0, 0);
+        m_isCalibrated = false;
+    }
+
+    bool isCalibrated() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_isCalibrated;
+    }
+
 protected:
+    // Inverse of the (affine) correction:
+    cv::Point2f uncalibrate(const cv::Point2f& angles) const
+    {
+        const cv::Matx22d A(m_correction(0, 0), m_correction(1, 0), m_correction(0, 1), m_correction(1, 1));
+        const cv::Vec2d b(m_correction(2, 0), m_correction(2, 1));
+        const cv::Vec2d x = A.inv() * (cv::Vec2d(angles.x, angles.y) - b);
+        return { static_cast<float>(x[0]), static_cast<float>(x[1]) };
+    }
+
+    GazeEstimator::Settings m_settings;
+
+    mutable std::mutex m_mutex;
+    GazeMeasurement m_samples;
+    cv::Matx<double, 3, 2> m_correction = cv::Matx<double, 3, 2>(1, 0, 0, 1, 0, 0);
+    bool m_isCalibrated = false;
 };
 
 // ### gaze ###
@@ -73,6 +231,11 @@ GazeEstimator::GazeEstimator()
     m_pImpl = std::make_shared<Impl>();
 }
 
+GazeEstimator::GazeEstimator(const Settings& settings)
+{
+    m_pImpl = std::make_shared<Impl>(settings);
+}
+
 void GazeEstimator::reset()
 {
     m_pImpl->reset();
@@ -93,4 +256,24 @@ GazeEstimator::GazeEstimate GazeEstimator::operator()(const face::FaceModel& fac
     return (*m_pImpl)(face);
 }
 
+void GazeEstimator::addCalibrationSample(const GazeEstimate& estimate, const cv::Point2f& target)
+{
+    m_pImpl->addCalibrationSample(estimate, target);
+}
+
+bool GazeEstimator::calibrate()
+{
+    return m_pImpl->calibrate();
+}
+
+void GazeEstimator::resetCalibration()
+{
+    m_pImpl->resetCalibration();
+}
+
+bool GazeEstimator::isCalibrated() const
+{
+    return m_pImpl->isCalibrated();
+}
+
 DRISHTI_HCI_NAMESPACE_END
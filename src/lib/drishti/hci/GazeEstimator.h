@@ -6,6 +6,12 @@
   \copyright Copyright 2014-2016 Elucideye, Inc. All rights reserved.
   \license{This project is released under the 3 Clause BSD License.}
 
+  Per eye gaze angles are the sum of an eye rotation, from the iris center displacement
+  w.r.t. the eye corners (eyeball radius ~ eye width / eyeGain), and a landmark head pose
+  (nose tip w.r.t. the eye midpoint), both measured in the eye aligned (roll free) frame.
+  A per user affine correction of the { yaw, pitch } angles is fit by incremental least
+  squares, so calibration and estimation are O(1) per frame.
+
 */
 
 #ifndef __drishti_hci_GazeEstimator_h__
@@ -15,6 +21,7 @@
 #include "drishti/face/Face.h"
 #include "drishti/sensor/Sensor.h"
 
+#include <array>
 #include <memory>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
@@ -39,16 +46,39 @@ public:
 
         cv::Point2f relative;
         float openness = 0.f;
+
+        // Per eye { right, left } gaze angles { yaw, pitch } (radians, calibrated) and unit gaze
+        // vectors in camera coordinates (x right, y down, -z towards the camera):
+        std::array<bool, 2> hasEyes = { { false, false } };
+        std::array<cv::Point2f, 2> angles;
+        std::array<cv::Vec3f, 2> directions;
+    };
+
+    struct Settings
+    {
+        float eyeGain = 2.4f;                   // eye width / eyeball radius
+        float headGain = 1.6f;                  // eye distance / nose tip depth
+        cv::Point2f headCenter = { 0.f, 0.6f }; // frontal GazeEstimate::relative
     };
 
     GazeEstimator();
+    explicit GazeEstimator(const Settings& settings);
 
     void reset();
     void begin();
     GazeEstimate end();
 
+    // Relative gaze (nose tip w.r.t. the eye midpoint, normalized by the eye distance), openness
+    // and the per eye gaze (for faces with eye models):
     GazeEstimate operator()(const face::FaceModel& face) const;
 
+    // Per user calibration: pair estimates with known { yaw, pitch } targets (e.g., fixation
+    // points), and fit the correction once there are enough samples (returns false otherwise):
+    void addCalibrationSample(const GazeEstimate& estimate, const cv::Point2f& target);
+    bool calibrate();
+    void resetCalibration();
+    bool isCalibrated() const;
+
 protected:
     std::shared_ptr<Impl> m_pImpl;
 };
@@ -0,0 +1,66 @@
+/*! -*-c++-*-
+  @file   PowerPolicy.cpp
+  @author David Hirvonen
+  @brief  Implementation of a thermal and battery aware processing plan for FaceFinder.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/PowerPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+static float clamp01(float value)
+{
+    return std::min(std::max(value, 0.f), 1.f);
+}
+
+PowerPolicy::PowerPolicy(const Settings& settings)
+    : m_settings(settings)
+{
+}
+
+float PowerPolicy::getPressure(const State& state) const
+{
+    float pressure = clamp01(state.thermal);
+    if (!state.charging && (m_settings.batteryLow > 0.f))
+    {
+        pressure = std::max(pressure, clamp01(1.f - state.battery / m_settings.batteryLow));
+    }
+
+    const int levels = std::max(m_settings.levels, 1);
+    return std::round(pressure * static_cast<float>(levels)) / static_cast<float>(levels);
+}
+
+PowerPolicy::Plan PowerPolicy::operator()(const State& state, const Plan& nominal) const
+{
+    Plan plan = nominal;
+    plan.pressure = getPressure(state);
+
+    const double interval = std::max(static_cast<double>(m_settings.interval), nominal.interval);
+    plan.interval = nominal.interval + (interval - nominal.interval) * plan.pressure;
+
+    const int eyeStride = std::max(m_settings.eyeStride, nominal.eyeStride);
+    plan.eyeStride = nominal.eyeStride + static_cast<int>(std::round(static_cast<float>(eyeStride - nominal.eyeStride) * plan.pressure));
+
+    if (plan.pressure >= 0.5f)
+    {
+        if (m_settings.threads > 0)
+        {
+            plan.threads = (nominal.threads > 0) ? std::min(nominal.threads, m_settings.threads) : m_settings.threads;
+        }
+        if (m_settings.pipelineDepth > 0)
+        {
+            plan.pipelineDepth = (nominal.pipelineDepth > 0) ? std::min(nominal.pipelineDepth, m_settings.pipelineDepth) : m_settings.pipelineDepth;
+        }
+    }
+
+    return plan;
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,75 @@
+/*! -*-c++-*-
+  @file   PowerPolicy.h
+  @author David Hirvonen
+  @brief  Declaration of a thermal and battery aware processing plan for FaceFinder.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Mobile devices throttle after a few minutes of full rate tracking.  The platform reports
+  a thermal level and the battery state, which are reduced to a single (quantized) pressure
+  in [0, 1] that scales the detection interval, the eye model rate and the regression worker
+  count between the configured (nominal) plan and the most conservative one.
+
+*/
+
+#ifndef __drishti_hci_PowerPolicy_h__
+#define __drishti_hci_PowerPolicy_h__
+
+#include "drishti/hci/drishti_hci.h"
+
+#include <functional>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class PowerPolicy
+{
+public:
+    // Platform signal, e.g., from ProcessInfo.thermalState or PowerManager:
+    struct State
+    {
+        float thermal = 0.f;  // 0 (nominal) ... 1 (critical)
+        float battery = 1.f;  // 0 (empty) ... 1 (full)
+        bool charging = true; // the battery level is ignored while charging
+    };
+
+    using Callback = std::function<State()>;
+
+    struct Settings
+    {
+        float batteryLow = 0.2f; // unplugged battery level where the pressure starts to ramp up
+        int levels = 4;          // pressure quantization (avoids plan changes on every reading)
+        float interval = 1.0f;   // detection interval (seconds) at full pressure
+        int eyeStride = 4;       // eye models every eyeStride frames at full pressure
+        int threads = 1;         // regression workers at (and above) half pressure, 0 == no limit
+        int pipelineDepth = 2;   // optimized pipeline depth for a loaded device (at initialization)
+        int pollInterval = 30;   // frames between callback calls
+    };
+
+    struct Plan
+    {
+        float pressure = 0.f;
+        double interval = 0.0; // detection interval (seconds)
+        int eyeStride = 1;     // 1 == eye models on every frame
+        int threads = 0;       // 0 == no limit
+        int pipelineDepth = 0;
+    };
+
+    PowerPolicy() = default;
+    explicit PowerPolicy(const Settings& settings);
+
+    // Quantized pressure: max(thermal, battery drain) in [0, 1]:
+    float getPressure(const State& state) const;
+
+    // Plan for a state, relative to the configured (zero pressure) plan:
+    Plan operator()(const State& state, const Plan& nominal) const;
+
+    const Settings& getSettings() const { return m_settings; }
+
+protected:
+    Settings m_settings;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_PowerPolicy_h__
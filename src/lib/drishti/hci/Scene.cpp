@@ -12,6 +12,48 @@
 
 DRISHTI_HCI_NAMESPACE_BEGIN
 
+ScenePool::ScenePool(std::size_t maxFree)
+    : m_state(std::make_shared<State>())
+    , m_maxFree(maxFree)
+{
+}
+
+ScenePrimitivesPtr ScenePool::acquire(uint64_t frameIndex)
+{
+    std::unique_ptr<ScenePrimitives> scene;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (!m_state->free.empty())
+        {
+            scene = std::move(m_state->free.back());
+            m_state->free.pop_back();
+        }
+    }
+
+    if (!scene)
+    {
+        scene.reset(new ScenePrimitives);
+        m_allocated++;
+    }
+    scene->m_frameIndex = frameIndex;
+
+    // Resources (image, pyramid, ...) are released as soon as the last reference is dropped:
+    std::weak_ptr<State> state = m_state;
+    const std::size_t maxFree = m_maxFree;
+    return ScenePrimitivesPtr(scene.release(), [state, maxFree](ScenePrimitives* ptr) {
+        std::unique_ptr<ScenePrimitives> scene(ptr);
+        scene->recycle(0);
+        if (auto pool = state.lock())
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            if (pool->free.size() < maxFree)
+            {
+                pool->free.push_back(std::move(scene));
+            }
+        }
+    });
+}
+
 void ScenePrimitives::draw(bool doFaces, bool doPupils, bool doCorners)
 {
     if (doCorners)
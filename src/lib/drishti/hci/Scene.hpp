@@ -13,12 +13,18 @@
 
 #include "drishti/hci/drishti_hci.h"
 #include "drishti/hci/gpu/LineDrawing.hpp"
+#include "drishti/core/Field.h"
 #include "drishti/face/Face.h"
+#include "drishti/face/FaceDetector.h"
+#include "drishti/geometry/GlobalMotion.h"
 
 #include <acf/ACF.h>
 
 #include <opencv2/core/core.hpp>
 
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 DRISHTI_HCI_NAMESPACE_BEGIN
@@ -61,6 +67,16 @@ struct ScenePrimitives
         return m_faces;
     }
 
+    // Track identifiers of the faces (see face::FaceTracker::TrackInfo), empty if unknown:
+    const std::vector<std::size_t>& tracks() const
+    {
+        return m_tracks;
+    }
+    std::vector<std::size_t>& tracks()
+    {
+        return m_tracks;
+    }
+
     const std::vector<cv::Rect>& objects() const
     {
         return m_objects;
@@ -70,6 +86,16 @@ struct ScenePrimitives
         return m_objects;
     }
 
+    // Detection scores (one per object):
+    const std::vector<double>& scores() const
+    {
+        return m_scores;
+    }
+    std::vector<double>& scores()
+    {
+        return m_scores;
+    }
+
     const std::vector<cv::Point2f>& corners() const
     {
         return m_corners;
@@ -108,12 +134,50 @@ struct ScenePrimitives
         return m_image;
     }
 
+    const std::vector<drishti::face::FaceDetector::EyePatches>& eyePatches() const
+    {
+        return m_eyePatches;
+    }
+    std::vector<drishti::face::FaceDetector::EyePatches>& eyePatches()
+    {
+        return m_eyePatches;
+    }
+
+    const std::vector<drishti::face::FaceDetector::ImageTile>& tiles() const
+    {
+        return m_tiles;
+    }
+    std::vector<drishti::face::FaceDetector::ImageTile>& tiles()
+    {
+        return m_tiles;
+    }
+
     void clear()
     {
         m_flow.clear();
         m_corners.clear();
         m_objects.clear();
+        m_scores.clear();
         m_faces.clear();
+        m_tracks.clear();
+        m_stabilization.clear();
+        m_correspondences.clear();
+        m_motion = {};
+    }
+
+    // Release everything for reuse by a new frame (see ScenePool), vectors keep their capacity:
+    void recycle(uint64_t frameIndex)
+    {
+        clear();
+        m_frameIndex = frameIndex;
+        m_image.release();
+        m_P.reset();
+        colors.clear();
+        m_eyePatches.clear();
+        m_tiles.clear();
+        m_drawings.clear();
+        m_eyeDrawings[0].clear();
+        m_eyeDrawings[1].clear();
     }
 
     const std::vector<ogles_gpgpu::LineDrawing>& getDrawings() const
@@ -125,22 +189,89 @@ struct ScenePrimitives
         return m_drawings;
     }
 
+    // Transposed texture transformation for the stabilized display (see FaceStabilizerFilter):
+    const drishti::core::Field<cv::Matx44f>& stabilization() const
+    {
+        return m_stabilization;
+    }
+    drishti::core::Field<cv::Matx44f>& stabilization()
+    {
+        return m_stabilization;
+    }
+
+    // Global (camera) motion from the previous frame, solved in detect() from the GPU flow grid
+    // correspondences (see FaceFinder::Settings::doGlobalMotion):
+    const drishti::geometry::MotionCorrespondences& correspondences() const
+    {
+        return m_correspondences;
+    }
+    drishti::geometry::MotionCorrespondences& correspondences()
+    {
+        return m_correspondences;
+    }
+    const drishti::geometry::SimilarityMotion& motion() const
+    {
+        return m_motion;
+    }
+    drishti::geometry::SimilarityMotion& motion()
+    {
+        return m_motion;
+    }
+
     void draw(bool doFaces = true, bool doPupils = true, bool doCorners = true);
 
     uint64_t m_frameIndex = 0;
+    std::chrono::high_resolution_clock::time_point m_time; // capture time (see FaceFinder::setCaptureTime())
     cv::Mat m_image;
 
     std::vector<cv::Vec4f> m_flow; // Temporary
     std::vector<cv::Point2f> m_corners;
     std::vector<cv::Rect> m_objects;
+    std::vector<double> m_scores;
     std::vector<drishti::face::FaceModel> m_faces;
+    std::vector<std::size_t> m_tracks; // parallel to m_faces
+    drishti::core::Field<cv::Matx44f> m_stabilization;
+    drishti::geometry::MotionCorrespondences m_correspondences; // previous -> current (full resolution)
+    drishti::geometry::SimilarityMotion m_motion;
     std::shared_ptr<acf::Detector::Pyramid> m_P;
+    std::vector<drishti::face::FaceDetector::EyePatches> m_eyePatches; // GPU eye crops (optional)
+    std::vector<drishti::face::FaceDetector::ImageTile> m_tiles;       // GPU face regions (replace m_image)
 
     // Drawing cache:
     std::vector<ogles_gpgpu::LineDrawing> m_drawings;
     std::vector<std::vector<cv::Point2f>> m_eyeDrawings[2];
 };
 
+// One scene is built per frame and then shared read only (e.g., by the FaceFinder history and
+// the listeners), so the pipeline passes pointers instead of copying the face models.  When the
+// last reference is released (from any thread) the object returns to the pool.
+using ScenePrimitivesPtr = std::shared_ptr<ScenePrimitives>;
+using ConstScenePrimitivesPtr = std::shared_ptr<const ScenePrimitives>;
+
+class ScenePool
+{
+public:
+    explicit ScenePool(std::size_t maxFree = 8);
+
+    ScenePool(const ScenePool&) = delete;
+    ScenePool& operator=(const ScenePool&) = delete;
+
+    ScenePrimitivesPtr acquire(uint64_t frameIndex);
+
+    std::size_t getAllocatedCount() const { return m_allocated; }
+
+protected:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ScenePrimitives>> free;
+    };
+
+    std::shared_ptr<State> m_state;
+    std::size_t m_maxFree = 8;
+    std::size_t m_allocated = 0;
+};
+
 void extractPoints(const cv::Mat1b& input, std::vector<FeaturePoint>& points, float flowScale);
 void pointsToCircles(const std::vector<FeaturePoint>& points, LineDrawingVec& circles, float width = 8.f);
 void pointsToCrosses(const std::vector<cv::Point2f>& points, LineDrawingVec& crosses, float width = 8.f);
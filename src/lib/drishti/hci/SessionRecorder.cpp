@@ -0,0 +1,178 @@
+/*! -*-c++-*-
+  @file   drishti/hci/SessionRecorder.cpp
+  @author David Hirvonen
+  @brief  Implementation of a triggered recorder for FaceFinder inputs and scene state.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/SessionRecorder.h"
+#include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <cereal/archives/json.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+SessionRecorder::SessionRecorder(const Settings& settings)
+    : m_settings(settings)
+{
+    tp::ThreadPoolOptions options;
+    options.setThreadCount(1); // frames are processed in order
+    m_thread = drishti::core::make_unique<tp::ThreadPool<>>(options);
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    flush();
+    if (m_remaining >= 0)
+    {
+        write(); // partial post trigger segment
+    }
+}
+
+void SessionRecorder::trigger()
+{
+    m_manual = true;
+}
+
+void SessionRecorder::flush()
+{
+    if (m_last.valid())
+    {
+        m_last.wait();
+    }
+}
+
+void SessionRecorder::operator()(const ScenePrimitives& scene, const TimePoint& time, double latency)
+{
+    if (scene.image().empty())
+    {
+        return;
+    }
+
+    if (m_pending >= m_settings.maxPending)
+    {
+        m_dropped++;
+        return;
+    }
+
+    if (!m_hasStart)
+    {
+        m_start = time;
+        m_hasStart = true;
+    }
+
+    Frame frame;
+    frame.index = scene.m_frameIndex;
+    frame.time = std::chrono::duration<double>(time - m_start).count();
+    frame.latency = latency;
+    frame.triggers = m_manual.exchange(false) ? kManual : 0;
+
+    // Shallow copies, the worker owns the references until the frame is encoded:
+    const cv::Mat image = scene.image();
+    const auto faces = scene.faces();
+    const auto objects = scene.objects();
+
+    m_pending++;
+    m_last = m_thread->process([this, image, faces, objects, frame]() {
+        process(image, faces, objects, frame);
+        m_pending--;
+    });
+}
+
+void SessionRecorder::process(const cv::Mat& image, const std::vector<drishti::face::FaceModel>& faces, const std::vector<cv::Rect>& objects, Frame frame)
+{
+    // Triggers:
+    if ((m_settings.maxLatency > 0.0) && (frame.latency > m_settings.maxLatency))
+    {
+        frame.triggers |= kLatency;
+    }
+    if (m_settings.doTrackLoss && m_hasFaces && faces.empty())
+    {
+        frame.triggers |= kTrackLoss;
+    }
+    m_hasFaces = !faces.empty();
+
+    std::vector<uchar> buffer;
+    cv::imencode(".jpg", image, buffer, { cv::IMWRITE_JPEG_QUALITY, m_settings.quality });
+    frame.jpeg.assign(buffer.begin(), buffer.end());
+
+    {
+        std::stringstream ss;
+        {
+            cereal::JSONOutputArchive oa(ss, cereal::JSONOutputArchive::Options::NoIndent());
+            oa(cereal::make_nvp("frame", frame.index));
+            oa(cereal::make_nvp("time", frame.time));
+            oa(cereal::make_nvp("latency", frame.latency));
+            oa(cereal::make_nvp("triggers", frame.triggers));
+            oa(cereal::make_nvp("objects", objects));
+            oa(cereal::make_nvp("faces", faces));
+        }
+        frame.scene = ss.str();
+        frame.scene.erase(std::remove(frame.scene.begin(), frame.scene.end(), '\n'), frame.scene.end());
+    }
+
+    m_ring.push_back(std::move(frame));
+
+    if (m_remaining < 0)
+    {
+        if (m_ring.back().triggers)
+        {
+            m_remaining = m_settings.postFrames;
+        }
+        else
+        {
+            while (m_ring.size() > static_cast<std::size_t>(std::max(m_settings.capacity, 1)))
+            {
+                m_ring.pop_front();
+            }
+        }
+    }
+    else
+    {
+        m_remaining--; // triggers during an active clip extend nothing
+    }
+
+    if (m_remaining == 0)
+    {
+        write();
+    }
+}
+
+void SessionRecorder::write()
+{
+    const std::size_t clip = m_clips++;
+
+    char prefix[32];
+    std::snprintf(prefix, sizeof(prefix), "/clip_%03d", static_cast<int>(clip));
+    const std::string base = m_settings.directory + prefix;
+
+    std::ofstream list(base + ".txt"), scenes(base + ".jsonl");
+    for (const auto& frame : m_ring)
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "_%06d.jpg", static_cast<int>(frame.index));
+        const std::string filename = base + suffix;
+
+        std::ofstream os(filename, std::ios::binary);
+        os.write(frame.jpeg.data(), static_cast<std::streamsize>(frame.jpeg.size()));
+        list << filename << "\n";
+        scenes << frame.scene << "\n";
+    }
+
+    m_ring.clear();
+    m_remaining = -1;
+}
+
+DRISHTI_HCI_NAMESPACE_END
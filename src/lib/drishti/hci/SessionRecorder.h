@@ -0,0 +1,119 @@
+/*! -*-c++-*-
+  @file   drishti/hci/SessionRecorder.h
+  @author David Hirvonen
+  @brief  Declaration of a triggered recorder for FaceFinder inputs and scene state.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The most recent frames are kept in a ring of JPEG images with the per frame scene state
+  (faces, detections and latency).  A trigger (a latency spike, a track loss or a manual
+  request) saves the ring plus a few following frames as a clip:
+
+    <directory>/clip_<n>.txt            : frame images, one per line (drishti-hci --input)
+    <directory>/clip_<n>.jsonl          : one JSON scene record per frame
+    <directory>/clip_<n>_<frame>.jpg    : frame images
+
+  Encoding, serialization and file output run on a dedicated background thread, the
+  caller only queues a (shared) image reference, and frames are dropped when the queue
+  is full.  Clips can be replayed with drishti-hci --input=clip_<n>.txt --replay=<fps>.
+
+*/
+
+#ifndef __drishti_hci_SessionRecorder_h__
+#define __drishti_hci_SessionRecorder_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/Scene.hpp"
+
+#include "thread_pool/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class SessionRecorder
+{
+public:
+    using HighResolutionClock = std::chrono::high_resolution_clock;
+    using TimePoint = HighResolutionClock::time_point;
+
+    enum Trigger
+    {
+        kLatency = 1,   // frame latency above Settings::maxLatency
+        kTrackLoss = 2, // all faces lost
+        kManual = 4     // trigger()
+    };
+
+    struct Settings
+    {
+        std::string directory;   // existing output directory
+        int capacity = 60;       // frames kept before a trigger
+        int postFrames = 30;     // frames recorded after a trigger
+        int quality = 85;        // JPEG quality
+        double maxLatency = 0.0; // latency trigger in seconds (0 == off)
+        bool doTrackLoss = true; // track loss trigger
+        int maxPending = 8;      // queued frames before new frames are dropped
+    };
+
+    explicit SessionRecorder(const Settings& settings);
+    ~SessionRecorder(); // writes the active clip (if any)
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder(SessionRecorder&&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(SessionRecorder&&) = delete;
+
+    // Record one frame (the scene image is shared, not copied), latency in seconds:
+    void operator()(const ScenePrimitives& scene, const TimePoint& time, double latency);
+
+    // Save a clip around the next recorded frame:
+    void trigger();
+
+    // Wait for the queued frames:
+    void flush();
+
+    std::size_t getClipCount() const { return m_clips; }
+    std::size_t getDroppedFrameCount() const { return m_dropped; }
+
+protected:
+    struct Frame
+    {
+        std::uint64_t index = 0;
+        double time = 0.0;
+        double latency = 0.0;
+        int triggers = 0;
+        std::string jpeg;
+        std::string scene; // JSON
+    };
+
+    void process(const cv::Mat& image, const std::vector<drishti::face::FaceModel>& faces, const std::vector<cv::Rect>& objects, Frame frame);
+    void write();
+
+    Settings m_settings;
+
+    // Worker thread state:
+    std::deque<Frame> m_ring;
+    int m_remaining = -1; // frames until the active clip is written (-1 == idle)
+    bool m_hasFaces = false;
+
+    TimePoint m_start;
+    bool m_hasStart = false;
+
+    std::atomic<bool> m_manual{ false };
+    std::atomic<int> m_pending{ 0 };
+    std::atomic<std::size_t> m_clips{ 0 };
+    std::atomic<std::size_t> m_dropped{ 0 };
+
+    std::unique_ptr<tp::ThreadPool<>> m_thread;
+    std::future<void> m_last; // most recent job
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_SessionRecorder_h__
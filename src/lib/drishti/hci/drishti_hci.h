@@ -14,6 +14,14 @@
 // clang-format off
 #define DRISHTI_HCI_NAMESPACE_BEGIN namespace drishti { namespace hci {
 #define DRISHTI_HCI_NAMESPACE_END } }
+
+// Optional stages, compiled in unless disabled by the build (see DRISHTI_HCI_WITH_* in CMakeLists.txt):
+#ifndef DRISHTI_HCI_WITH_PAINTER
+#  define DRISHTI_HCI_WITH_PAINTER 1 // FaceFinderPainter, gpu/FacePainter, gpu/GLPrinter
+#endif
+#ifndef DRISHTI_HCI_WITH_BLOBS
+#  define DRISHTI_HCI_WITH_BLOBS 1 // gpu/BlobFilter, BlobFilterCpu, EyeBlob
+#endif
 // clang-format on
 
 #endif
@@ -0,0 +1,705 @@
+/*! -*-c++-*-
+  @file   gpu/AcfComputeBuilder.cpp
+  @author David Hirvonen
+  @brief  Implementation of a compute shader ACF pyramid builder (OpenGL ES 3.1).
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/gpu/AcfComputeBuilder.h"
+#include "drishti/core/MemoryRegistry.h"
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// clang-format off
+#if defined(GL_ES_VERSION_3_1) || (defined(GL_VERSION_4_3) && !defined(OGLES_GPGPU_OPENGLES))
+#  define DRISHTI_ACF_COMPUTE 1
+#else
+#  define DRISHTI_ACF_COMPUTE 0
+#endif
+// clang-format on
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+#if DRISHTI_ACF_COMPUTE
+
+// Full resolution scratch planes (level planes are packed back to back in each plane):
+enum Plane
+{
+    kLuv = 0,     // resized, then smoothed LUV (3)
+    kLuvTmp = 3,  // horizontal pass of the color smoothing (3)
+    kMag = 6,     // max gradient magnitude over the color channels
+    kOri = 7,     // orientation of the max gradient
+    kMagTmp = 8,  // horizontal pass of the normalization filter
+    kMagNorm = 9, // normalized gradient magnitude
+    kPlaneCount
+};
+
+static const int kTile = 8; // local size (64 invocations, ES 3.1 guarantees 128)
+
+// clang-format off
+#if defined(OGLES_GPGPU_OPENGLES)
+static const char* kVersion = "#version 310 es\nprecision highp float;\nprecision highp int;\nprecision highp sampler2D;\n";
+#else
+static const char* kVersion = "#version 430 core\n";
+#endif
+
+// Level table: (width, height, full resolution offset, cell offset) in storage order:
+static const char* kCommon = OG_TO_STR(
+layout(local_size_x = 8, local_size_y = 8) in;
+layout(std430, binding = 0) readonly buffer Levels { ivec4 levels[]; };
+int mirror(int p, int size) // cv::BORDER_REFLECT
+{
+    p = (p < 0) ? (-p - 1) : p;
+    p = (p >= size) ? (2 * size - p - 1) : p;
+    return clamp(p, 0, size - 1);
+}
+ivec2 mirror(ivec2 p, ivec2 size)
+{
+    return ivec2(mirror(p.x, size.x), mirror(p.y, size.y));
+}
+);
+
+// (1) LUV resampled to each level (area averaging when shrinking, bilinear otherwise):
+static const char* kResizeShader = OG_TO_STR(
+layout(binding = 0) uniform sampler2D luv;
+layout(std430, binding = 2) writeonly buffer Dst { float dst[]; };
+uniform int planeStride;
+void main()
+{
+    ivec4 level = levels[gl_GlobalInvocationID.z];
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, level.xy)))
+    {
+        return;
+    }
+
+    ivec2 size = textureSize(luv, 0);
+    vec2 s = vec2(size) / vec2(level.xy);
+    vec3 value = vec3(0.0);
+    if ((level.x * level.y) < (size.x * size.y))
+    {
+        vec2 a = vec2(p) * s, b = a + s;
+        for (int y = int(floor(a.y)); y < int(ceil(b.y)); y++)
+        {
+            float wy = min(b.y, float(y + 1)) - max(a.y, float(y));
+            for (int x = int(floor(a.x)); x < int(ceil(b.x)); x++)
+            {
+                float wx = min(b.x, float(x + 1)) - max(a.x, float(x));
+                value += (wx * wy) * texelFetch(luv, min(ivec2(x, y), size - 1), 0).rgb;
+            }
+        }
+        value /= (s.x * s.y);
+    }
+    else
+    {
+        vec2 q = clamp((vec2(p) + 0.5) * s - 0.5, vec2(0.0), vec2(size - 1));
+        ivec2 q0 = ivec2(floor(q)), q1 = min(q0 + 1, size - 1);
+        vec2 f = q - vec2(q0);
+        vec3 top = mix(texelFetch(luv, q0, 0).rgb, texelFetch(luv, ivec2(q1.x, q0.y), 0).rgb, f.x);
+        vec3 bottom = mix(texelFetch(luv, ivec2(q0.x, q1.y), 0).rgb, texelFetch(luv, q1, 0).rgb, f.x);
+        value = mix(top, bottom, f.y);
+    }
+
+    int i = level.z + p.y * level.x + p.x;
+    dst[i] = value.r;
+    dst[planeStride + i] = value.g;
+    dst[planeStride * 2 + i] = value.b;
+});
+
+// Separable triangle filter (see convTri()), one direction per dispatch.  Full resolution
+// planes (srcFirst, dstFirst) or shrunk channel planes, z = level * planes + plane:
+static const char* kTriangleShader = OG_TO_STR(
+layout(std430, binding = 1) readonly buffer Src { float src[]; };
+layout(std430, binding = 2) writeonly buffer Dst { float dst[]; };
+layout(std430, binding = 3) readonly buffer Mag { float mag[]; };
+uniform int cells;
+uniform int shrink;
+uniform int planeStride;
+uniform int planes;
+uniform int srcFirst;
+uniform int dstFirst;
+uniform int radius;
+uniform ivec2 direction;
+uniform int normalize; // gradient normalization: dst = mag / (filtered + normConst)
+uniform int magFirst;
+uniform float normConst;
+void main()
+{
+    int z = int(gl_GlobalInvocationID.z);
+    ivec4 level = levels[z / planes];
+    int plane = z % planes;
+
+    ivec2 size = (cells != 0) ? (level.xy / shrink) : level.xy;
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, size)))
+    {
+        return;
+    }
+
+    int srcBase = (cells != 0) ? (level.w * planes + plane * size.x * size.y) : ((srcFirst + plane) * planeStride + level.z);
+    int dstBase = (cells != 0) ? srcBase : ((dstFirst + plane) * planeStride + level.z);
+
+    float sum = 0.0;
+    for (int k = -radius; k <= radius; k++)
+    {
+        ivec2 q = mirror(p + direction * k, size);
+        sum += float(radius + 1 - abs(k)) * src[srcBase + q.y * size.x + q.x];
+    }
+    sum /= float((radius + 1) * (radius + 1));
+
+    int i = p.y * size.x + p.x;
+    if (normalize != 0)
+    {
+        sum = mag[magFirst * planeStride + level.z + i] / (sum + normConst);
+    }
+    dst[dstBase + i] = sum;
+});
+
+// (2) Central difference gradients of the smoothed LUV planes on a shared tile (with a one
+// pixel apron), keeping the max magnitude over the color channels and its orientation:
+static const char* kGradientShader = OG_TO_STR(
+layout(std430, binding = 1) readonly buffer Src { float src[]; };
+layout(std430, binding = 2) writeonly buffer Dst { float dst[]; };
+uniform int planeStride;
+uniform int luvFirst;
+uniform int magFirst;
+shared float tile[3][10][10];
+void main()
+{
+    ivec4 level = levels[gl_GlobalInvocationID.z];
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * 8 - 1;
+    for (int k = int(gl_LocalInvocationIndex); k < 100; k += 64)
+    {
+        ivec2 q = clamp(origin + ivec2(k % 10, k / 10), ivec2(0), level.xy - 1);
+        int i = level.z + q.y * level.x + q.x;
+        for (int c = 0; c < 3; c++)
+        {
+            tile[c][k / 10][k % 10] = src[(luvFirst + c) * planeStride + i];
+        }
+    }
+    barrier();
+
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, level.xy)))
+    {
+        return;
+    }
+
+    // One sided differences at the borders (the apron is clamped):
+    ivec2 span = min(p + 1, level.xy - 1) - max(p - 1, ivec2(0));
+    vec2 scale = mix(vec2(0.0), vec2(1.0) / vec2(span), greaterThan(span, ivec2(0)));
+
+    ivec2 t = ivec2(gl_LocalInvocationID.xy) + 1;
+    float magnitude = 0.0, orientation = 0.0;
+    for (int c = 0; c < 3; c++)
+    {
+        float gx = (tile[c][t.y][t.x + 1] - tile[c][t.y][t.x - 1]) * scale.x;
+        float gy = (tile[c][t.y + 1][t.x] - tile[c][t.y - 1][t.x]) * scale.y;
+        float m = sqrt(gx * gx + gy * gy);
+        if (m > magnitude)
+        {
+            magnitude = m;
+            orientation = atan(gy, gx);
+        }
+    }
+
+    int i = level.z + p.y * level.x + p.x;
+    dst[magFirst * planeStride + i] = magnitude;
+    dst[(magFirst + 1) * planeStride + i] = orientation;
+});
+
+// (3) One invocation per shrink x shrink cell: block averaged LUV and magnitude, and hard
+// binned orientation histograms (half circle) in acf::Detector::Pyramid channel order:
+static const char* kCellShader = OG_TO_STR(
+layout(std430, binding = 1) readonly buffer Src { float src[]; };
+layout(std430, binding = 2) writeonly buffer Dst { float dst[]; };
+uniform int planeStride;
+uniform int luvFirst;
+uniform int magFirst;
+uniform int oriFirst;
+uniform int shrink;
+uniform int orientations;
+void main()
+{
+    ivec4 level = levels[gl_GlobalInvocationID.z];
+    ivec2 size = level.xy / shrink;
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, size)))
+    {
+        return;
+    }
+
+    const float pi = 3.14159265358979;
+    float binScale = float(orientations) / pi;
+
+    float hist[8];
+    for (int b = 0; b < 8; b++)
+    {
+        hist[b] = 0.0;
+    }
+
+    vec4 sum = vec4(0.0);
+    for (int y = p.y * shrink; y < (p.y + 1) * shrink; y++)
+    {
+        for (int x = p.x * shrink; x < (p.x + 1) * shrink; x++)
+        {
+            int i = level.z + y * level.x + x;
+            float m = src[magFirst * planeStride + i];
+            float o = src[oriFirst * planeStride + i];
+            o = (o < 0.0) ? (o + pi) : o;
+            hist[min(int(o * binScale), orientations - 1)] += m;
+            sum += vec4(src[luvFirst * planeStride + i], src[(luvFirst + 1) * planeStride + i], src[(luvFirst + 2) * planeStride + i], m);
+        }
+    }
+
+    float norm = 1.0 / float(shrink * shrink);
+    int area = size.x * size.y;
+    int i = level.w * (4 + orientations) + p.y * size.x + p.x;
+    for (int c = 0; c < 4; c++)
+    {
+        dst[i + c * area] = sum[c] * norm;
+    }
+    for (int b = 0; b < orientations; b++)
+    {
+        dst[i + (4 + b) * area] = hist[b] * norm;
+    }
+});
+// clang-format on
+
+static GLuint compile(const char* body)
+{
+    const std::string src = std::string(kVersion) + kCommon + body;
+    const char* str = src.c_str();
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &str, nullptr);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status)
+    {
+        GLchar log[1024] = { 0 };
+        glGetShaderInfoLog(shader, sizeof(log) - 1, nullptr, log);
+        glDeleteShader(shader);
+        throw std::runtime_error(std::string("AcfComputeBuilder: shader compile error: ") + log);
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDetachShader(program, shader);
+    glDeleteShader(shader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status)
+    {
+        GLchar log[1024] = { 0 };
+        glGetProgramInfoLog(program, sizeof(log) - 1, nullptr, log);
+        glDeleteProgram(program);
+        throw std::runtime_error(std::string("AcfComputeBuilder: program link error: ") + log);
+    }
+    return program;
+}
+
+struct AcfComputeBuilder::Impl
+{
+    enum Stage
+    {
+        kResize,
+        kTriangle,
+        kGradient,
+        kCells,
+        kStageCount
+    };
+
+    Impl(const acf::Detector::Pyramid& layout, const Options& options)
+        : options(options)
+        , layout(layout)
+    {
+        channels = 4 + options.orientations;
+        for (int i = 0; i < layout.nScales; i++)
+        {
+            const cv::Size size = layout.data[i][0][0].size();
+            const std::array<int, 4> entry = { { size.width * options.shrink, size.height * options.shrink, fullTotal, cellTotal } };
+            table.push_back(entry);
+            maxSize.width = std::max(maxSize.width, entry[0]);
+            maxSize.height = std::max(maxSize.height, entry[1]);
+            fullTotal += entry[0] * entry[1];
+            cellTotal += size.area();
+        }
+
+        memoryUsage = core::MemoryRegistry::get().add(core::MemoryRegistry::kTexture, "AcfComputeBuilder", [this]() {
+            return bytes.load();
+        });
+    }
+
+    ~Impl()
+    {
+        for (auto program : programs)
+        {
+            if (program)
+            {
+                glDeleteProgram(program);
+            }
+        }
+
+        const GLuint buffers[] = { levelBuffer, scratch, cells[0], cells[1] };
+        for (auto buffer : buffers)
+        {
+            if (buffer)
+            {
+                glDeleteBuffers(1, &buffer);
+            }
+        }
+
+        if (input)
+        {
+            glDeleteTextures(1, &input);
+        }
+    }
+
+    static GLuint allocate(GLsizeiptr size, const void* data)
+    {
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, (data ? GL_STATIC_DRAW : GL_DYNAMIC_COPY));
+        return buffer;
+    }
+
+    // Programs and buffers are created on first use (with the GL context current):
+    bool build()
+    {
+        if (!ready && !failed)
+        {
+            const char* shaders[kStageCount] = { kResizeShader, kTriangleShader, kGradientShader, kCellShader };
+            try
+            {
+                for (int i = 0; i < kStageCount; i++)
+                {
+                    programs[i] = compile(shaders[i]);
+                }
+            }
+            catch (const std::runtime_error& e)
+            {
+                error = e.what(); // the caller falls back to another builder (see getError())
+                failed = true;
+            }
+
+            if (!failed)
+            {
+                levelBuffer = allocate(GLsizeiptr(table.size() * sizeof(table[0])), table.data());
+                scratch = allocate(GLsizeiptr(sizeof(float)) * kPlaneCount * fullTotal, nullptr);
+                cells[0] = allocate(GLsizeiptr(sizeof(float)) * channels * cellTotal, nullptr);
+                cells[1] = allocate(GLsizeiptr(sizeof(float)) * channels * cellTotal, nullptr);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+                ready = true;
+            }
+            update();
+        }
+        return ready;
+    }
+
+    void update()
+    {
+        std::size_t total = sizeof(float) * (std::size_t(kPlaneCount) * fullTotal + std::size_t(2) * channels * cellTotal);
+        total += table.size() * sizeof(table[0]) + std::size_t(inputSize.area()) * 4;
+        bytes = ready ? total : 0;
+    }
+
+    // Planar LUV -> RGBA texture (8 bit, normalized in the shaders):
+    GLuint upload(const MatP& luv)
+    {
+        std::vector<cv::Mat> planes(4);
+        for (int i = 0; i < 3; i++)
+        {
+            luv[i].convertTo(planes[i], CV_8U, (luv[i].depth() == CV_8U) ? 1.0 : 255.0);
+        }
+        planes[3] = cv::Mat::zeros(planes[0].size(), CV_8UC1);
+
+        cv::Mat rgba;
+        cv::merge(planes, rgba);
+
+        if (!input)
+        {
+            glGenTextures(1, &input);
+        }
+        glBindTexture(GL_TEXTURE_2D, input);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (inputSize != rgba.size())
+        {
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, rgba.cols, rgba.rows);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            inputSize = rgba.size();
+            update();
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rgba.cols, rgba.rows, GL_RGBA, GL_UNSIGNED_BYTE, rgba.ptr());
+        return input;
+    }
+
+    void dispatch(const cv::Size& size, int depth)
+    {
+        glDispatchCompute((size.width + kTile - 1) / kTile, (size.height + kTile - 1) / kTile, depth);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void set(GLuint program, const char* name, int value)
+    {
+        glUniform1i(glGetUniformLocation(program, name), value);
+    }
+
+    // Full resolution (src, dst planes in the scratch buffer) or cell planes (src, dst buffers):
+    void triangle(bool isCell, GLuint src, GLuint dst, int srcFirst, int dstFirst, int planes, int radius, bool horizontal, bool normalize = false)
+    {
+        const GLuint program = programs[kTriangle];
+        glUseProgram(program);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, src);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, dst);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, scratch);
+        set(program, "cells", isCell);
+        set(program, "shrink", options.shrink);
+        set(program, "planeStride", fullTotal);
+        set(program, "planes", planes);
+        set(program, "srcFirst", srcFirst);
+        set(program, "dstFirst", dstFirst);
+        set(program, "radius", std::max(radius, 0));
+        glUniform2i(glGetUniformLocation(program, "direction"), int(horizontal), int(!horizontal));
+        set(program, "normalize", normalize);
+        set(program, "magFirst", kMag);
+        glUniform1f(glGetUniformLocation(program, "normConst"), options.normConst);
+
+        const cv::Size size = isCell ? cv::Size(maxSize.width / options.shrink, maxSize.height / options.shrink) : maxSize;
+        dispatch(size, int(table.size()) * planes);
+    }
+
+    bool run(GLuint luv, acf::Detector::Pyramid& P)
+    {
+        if (!build())
+        {
+            return false;
+        }
+
+        const int levels = int(table.size());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, levelBuffer);
+
+        // (1) Resample and smooth the color planes:
+        glUseProgram(programs[kResize]);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, luv);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, scratch);
+        set(programs[kResize], "planeStride", fullTotal);
+        dispatch(maxSize, levels);
+
+        triangle(false, scratch, scratch, kLuv, kLuvTmp, 3, options.colorSmooth, true);
+        triangle(false, scratch, scratch, kLuvTmp, kLuv, 3, options.colorSmooth, false);
+
+        // (2) Gradient magnitude and orientation, then M / (S(M) + eps):
+        glUseProgram(programs[kGradient]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scratch);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, scratch);
+        set(programs[kGradient], "planeStride", fullTotal);
+        set(programs[kGradient], "luvFirst", kLuv);
+        set(programs[kGradient], "magFirst", kMag);
+        dispatch(maxSize, levels);
+
+        triangle(false, scratch, scratch, kMag, kMagTmp, 1, options.normRadius, true);
+        triangle(false, scratch, scratch, kMagTmp, kMagNorm, 1, options.normRadius, false, true);
+
+        // (3) Shrink to channel cells:
+        glUseProgram(programs[kCells]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scratch);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, cells[0]);
+        set(programs[kCells], "planeStride", fullTotal);
+        set(programs[kCells], "luvFirst", kLuv);
+        set(programs[kCells], "magFirst", kMagNorm);
+        set(programs[kCells], "oriFirst", kOri);
+        set(programs[kCells], "shrink", options.shrink);
+        set(programs[kCells], "orientations", options.orientations);
+        dispatch({ maxSize.width / options.shrink, maxSize.height / options.shrink }, levels);
+
+        // (4) Smooth all channels:
+        triangle(true, cells[0], cells[1], 0, 0, channels, options.pyramidSmooth, true);
+        triangle(true, cells[1], cells[0], 0, 0, channels, options.pyramidSmooth, false);
+
+        glUseProgram(0);
+        return fill(P);
+    }
+
+    // The output is in pyramid order, so each plane is one contiguous copy:
+    bool fill(acf::Detector::Pyramid& P)
+    {
+        if (P.data.size() != layout.data.size())
+        {
+            P = layout;
+        }
+
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, cells[0]);
+        const auto length = GLsizeiptr(sizeof(float)) * channels * cellTotal;
+        const auto* data = static_cast<const float*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, length, GL_MAP_READ_BIT));
+        if (!data)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            return false;
+        }
+
+        for (std::size_t i = 0; i < table.size(); i++)
+        {
+            const cv::Size size = layout.data[i][0][0].size();
+            auto& planes = P.data[i][0].get();
+            planes.resize(channels);
+            for (int c = 0; c < channels; c++)
+            {
+                const float* plane = data + std::size_t(table[i][3]) * channels + std::size_t(c) * size.area();
+                if ((planes[c].size() != size) || (planes[c].type() != CV_32FC1) || !planes[c].isContinuous())
+                {
+                    planes[c].create(size, CV_32FC1);
+                }
+                std::memcpy(planes[c].ptr(), plane, sizeof(float) * size.area());
+            }
+        }
+
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return true;
+    }
+
+    Options options;
+    acf::Detector::Pyramid layout;
+    int channels = 0;
+    std::vector<std::array<int, 4>> table; // (width, height, full offset, cell offset)
+    cv::Size maxSize;
+    int fullTotal = 0; // full resolution pixels over all levels
+    int cellTotal = 0; // channel cells over all levels
+
+    bool ready = false;
+    bool failed = false;
+    std::string error;
+    std::array<GLuint, kStageCount> programs{ {} };
+    GLuint levelBuffer = 0;
+    GLuint scratch = 0;
+    GLuint cells[2] = { 0, 0 };
+    GLuint input = 0;
+    cv::Size inputSize;
+
+    std::atomic<std::size_t> bytes{ 0 };
+    core::MemoryRegistry::Registration memoryUsage;
+};
+
+AcfComputeBuilder::AcfComputeBuilder(const acf::Detector::Pyramid& layout, const Options& options)
+    : m_impl(drishti::core::make_unique<Impl>(layout, options))
+{
+}
+
+AcfComputeBuilder::~AcfComputeBuilder() = default;
+
+bool AcfComputeBuilder::operator()(const MatP& luv, acf::Detector::Pyramid& P)
+{
+    if (!m_impl->build())
+    {
+        return false;
+    }
+    return m_impl->run(m_impl->upload(luv), P);
+}
+
+bool AcfComputeBuilder::operator()(GLuint luv, acf::Detector::Pyramid& P)
+{
+    return m_impl->run(luv, P);
+}
+
+bool AcfComputeBuilder::isSupported()
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major); // GL_INVALID_ENUM in older contexts
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+#if defined(OGLES_GPGPU_OPENGLES)
+    return (major > 3) || ((major == 3) && (minor >= 1));
+#else
+    return (major > 4) || ((major == 4) && (minor >= 3));
+#endif
+}
+
+const AcfComputeBuilder::Options& AcfComputeBuilder::getOptions() const
+{
+    return m_impl->options;
+}
+
+const std::string& AcfComputeBuilder::getError() const
+{
+    return m_impl->error;
+}
+
+std::size_t AcfComputeBuilder::getBytes() const
+{
+    return m_impl->bytes;
+}
+
+#else // !DRISHTI_ACF_COMPUTE
+
+// OpenGL ES 2/3.0 builds: the caller uses the fragment shader or CPU pyramids.
+
+struct AcfComputeBuilder::Impl
+{
+    Options options;
+    std::string error;
+};
+
+AcfComputeBuilder::AcfComputeBuilder(const acf::Detector::Pyramid& layout, const Options& options)
+    : m_impl(drishti::core::make_unique<Impl>())
+{
+    m_impl->options = options;
+}
+
+AcfComputeBuilder::~AcfComputeBuilder() = default;
+
+bool AcfComputeBuilder::operator()(const MatP& luv, acf::Detector::Pyramid& P)
+{
+    return false;
+}
+
+bool AcfComputeBuilder::operator()(GLuint luv, acf::Detector::Pyramid& P)
+{
+    return false;
+}
+
+bool AcfComputeBuilder::isSupported()
+{
+    return false;
+}
+
+const AcfComputeBuilder::Options& AcfComputeBuilder::getOptions() const
+{
+    return m_impl->options;
+}
+
+const std::string& AcfComputeBuilder::getError() const
+{
+    return m_impl->error;
+}
+
+std::size_t AcfComputeBuilder::getBytes() const
+{
+    return 0;
+}
+
+#endif // DRISHTI_ACF_COMPUTE
+
+DRISHTI_HCI_NAMESPACE_END
@@ -0,0 +1,73 @@
+/*! -*-c++-*-
+  @file   gpu/AcfComputeBuilder.h
+  @author David Hirvonen
+  @brief  Declaration of a compute shader ACF pyramid builder (OpenGL ES 3.1).
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The same aggregate channel features as AcfPyramidBuilder (LUV, normalized gradient
+  magnitude and orientation histograms), computed for every level of a pyramid layout
+  in one chain of compute dispatches (OpenGL ES 3.1 or OpenGL 4.3).  Each dispatch covers
+  all levels (gl_GlobalInvocationID.z selects the level), the gradient stage works on
+  shared memory tiles and the histograms are accumulated per shrink x shrink cell by one
+  invocation, so there are no atomics.  Intermediate planes are 32 bit floats rather than
+  the 8 bit render targets of the fragment shader ACF (ogles_gpgpu::ACF), and the output
+  shader storage buffer holds the planes in acf::Detector::Pyramid order (level, channel,
+  row), so filling a pyramid is a single mapped copy.
+
+*/
+
+#ifndef __drishti_hci_gpu_AcfComputeBuilder_h__
+#define __drishti_hci_gpu_AcfComputeBuilder_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/AcfPyramidBuilder.h" // Options
+
+#include "ogles_gpgpu/common/proc/base/filterprocbase.h" // GL
+
+#include <acf/ACF.h>
+
+#include <memory>
+#include <string>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class AcfComputeBuilder
+{
+public:
+    using Options = AcfPyramidBuilder::Options;
+
+    // The layout provides level sizes in storage (possibly transposed) order:
+    AcfComputeBuilder(const acf::Detector::Pyramid& layout, const Options& options);
+    ~AcfComputeBuilder();
+
+    AcfComputeBuilder(const AcfComputeBuilder&) = delete;
+    AcfComputeBuilder& operator=(const AcfComputeBuilder&) = delete;
+
+    // Compute all levels from planar LUV input in layout orientation (CV_8U or CV_32F),
+    // false if the programs could not be built:
+    bool operator()(const MatP& luv, acf::Detector::Pyramid& P);
+
+    // As above, from a texture with LUV in the rgb channels (e.g., rendered on the GPU):
+    bool operator()(GLuint luv, acf::Detector::Pyramid& P);
+
+    // Compute shaders and storage buffers in the current context:
+    static bool isSupported();
+
+    const Options& getOptions() const;
+
+    // Shader compile or link log when the programs could not be built (empty otherwise):
+    const std::string& getError() const;
+
+    // Storage buffers and the input texture:
+    std::size_t getBytes() const;
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_gpu_AcfComputeBuilder_h__
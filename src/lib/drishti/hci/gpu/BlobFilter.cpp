@@ -10,6 +10,7 @@
 
 #include "drishti/hci/gpu/BlobFilter.h"
 #include "drishti/graphics/binomial.h"
+#include "drishti/graphics/peak_compaction.h"
 #include "drishti/graphics/saturation.h"
 
 #include "ogles_gpgpu/common/proc/hessian.h"
@@ -31,18 +32,21 @@ public:
         : smoothProc1(1)
         , hessianProc1(2000.0f, false)
         , saturationProc(1.0)
+        , peakProc(4)
     {
         nmsProc1.swizzle(1, 3); // in(2), out(3)
 
         smoothProc1.add(&saturationProc);
         saturationProc.add(&hessianProc1);
         hessianProc1.add(&nmsProc1);
+        nmsProc1.add(&peakProc);
     }
 
     ogles_gpgpu::GaussOptProc smoothProc1;
     ogles_gpgpu::HessianProc hessianProc1;
     ogles_gpgpu::NmsProc nmsProc1;
     ogles_gpgpu::SaturationProc saturationProc;
+    ogles_gpgpu::PeakCompactionProc peakProc;
 };
 
 BlobFilter::BlobFilter()
@@ -54,6 +58,7 @@ BlobFilter::BlobFilter()
     procPasses.push_back(&m_impl->hessianProc1);
     procPasses.push_back(&m_impl->nmsProc1);
     procPasses.push_back(&m_impl->saturationProc);
+    procPasses.push_back(&m_impl->peakProc);
 }
 
 BlobFilter::~BlobFilter()
@@ -76,6 +81,16 @@ ProcInterface* BlobFilter::getHessianPeaks() const
     return &m_impl->nmsProc1;
 }
 
+ProcInterface* BlobFilter::getCompactPeaks() const
+{
+    return &m_impl->peakProc;
+}
+
+int BlobFilter::getPeakCellSize() const
+{
+    return m_impl->peakProc.getCellSize();
+}
+
 ProcInterface* BlobFilter::getOutputFilter() const
 {
     return &m_impl->nmsProc1;
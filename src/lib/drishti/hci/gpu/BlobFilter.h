@@ -39,6 +39,10 @@ public:
     ProcInterface* getHessian() const;
     ProcInterface* getHessianPeaks() const;
 
+    // Strongest peak per getPeakCellSize() cell, see ogles_gpgpu::PeakCompactionProc:
+    ProcInterface* getCompactPeaks() const;
+    int getPeakCellSize() const;
+
     /**
      * Return the processor's name.
      */
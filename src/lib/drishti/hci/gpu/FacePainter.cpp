@@ -28,6 +28,9 @@
 using namespace std;
 using namespace ogles_gpgpu;
 
+BEGIN_OGLES_GPGPU
+
+// Line segments are accumulated per batch and submitted with a single draw call:
 struct DrawingSpec
 {
     DrawingSpec(int type)
@@ -39,6 +42,8 @@ struct DrawingSpec
     std::vector<cv::Point2f> points;
 };
 
+END_OGLES_GPGPU
+
 // =====
 
 // clang-format off
@@ -119,7 +124,13 @@ OG_TO_STR(
  });
 // clang-format on
 
-FacePainter::~FacePainter() = default;
+FacePainter::~FacePainter()
+{
+    if (m_lineVbo)
+    {
+        glDeleteBuffers(1, &m_lineVbo);
+    }
+}
 
 void FacePainter::getUniforms()
 {
@@ -148,10 +159,7 @@ FacePainter::FacePainter(int outputOrientation)
 
     setInterpolation(ogles_gpgpu::TransformProc::BILINEAR); // faster
 
-    // Font rendering:
-    m_printer = drishti::core::make_unique<GLPrinterShader>();
-
-    m_draw = std::make_shared<Shader>();
+    m_draw = std::make_shared<Program>();
 #if DRISHIT_HCI_FACEPAINTER_DO_COLOR
     bool compiled = m_draw->buildFromSrc(vshaderColorVaryingSrc, fshaderColorVaryingSrc); // NOLINT (TODO)
     m_drawShParamAColor = m_draw->getParam(ATTR, "color");
@@ -163,6 +171,9 @@ FacePainter::FacePainter(int outputOrientation)
     m_drawShParamAPosition = m_draw->getParam(ATTR, "position");
     m_drawShParamUMVP = m_draw->getParam(UNIF, "modelViewProjMatrix");
 
+    glGenBuffers(1, &m_lineVbo);
+    Tools::checkGLErr(getProcName(), "glGenBuffers()");
+
     m_eyeAttributes = { &m_eyePoints, 8.f /*override*/, { 1.0, 0.0, 1.0 } };
     m_eyeAttributes.flow = &m_eyeFlow;
 }
@@ -266,6 +277,11 @@ void FacePainter::renderDrawings()
         std::wstringstream wss;
         wss << position.z;
 
+        if (!m_printer)
+        { // Font rendering (created on first use):
+            m_printer = drishti::core::make_unique<GLPrinterShader>();
+        }
+
         m_printer->begin();
         const float scale = 10.f;
         const float sx = scale / static_cast<float>(outFrameW);
@@ -300,14 +316,37 @@ void FacePainter::renderDrawings()
     glViewport(0, 0, outFrameW, outFrameH);
     Tools::checkGLErr(getProcName(), "glViewport()");
 
-    glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, 0, 0, &lines.colors[0]);
-    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
+    drawLines(&lines.points[0].x, 2, &lines.colors[0][0], static_cast<GLsizei>(lines.points.size()));
+}
 
-    glVertexAttribPointer(m_drawShParamAPosition, 2, GL_FLOAT, 0, 0, &lines.points[0]);
+void FacePainter::drawLines(const GLfloat* points, int dims, const GLfloat* colors, GLsizei count)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    const auto pointBytes = static_cast<GLsizeiptr>(count * dims * sizeof(GLfloat));
+    const auto colorBytes = static_cast<GLsizeiptr>(count * 3 * sizeof(GLfloat));
+
+    // Orphan the previous contents so the upload doesn't stall on pending draws:
+    glBindBuffer(GL_ARRAY_BUFFER, m_lineVbo);
+    glBufferData(GL_ARRAY_BUFFER, pointBytes + colorBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, pointBytes, points);
+    glBufferSubData(GL_ARRAY_BUFFER, pointBytes, colorBytes, colors);
+    Tools::checkGLErr(getProcName(), "glBufferSubData()");
+
+    glEnableVertexAttribArray(m_drawShParamAPosition);
+    glVertexAttribPointer(m_drawShParamAPosition, dims, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(m_drawShParamAColor);
+    glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const GLvoid*>(pointBytes));
     Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
 
-    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.points.size()));
+    glDrawArrays(GL_LINES, 0, count);
     Tools::checkGLErr(getProcName(), "glDrawArrays()");
+
+    glDisableVertexAttribArray(m_drawShParamAColor);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void FacePainter::setAxes(const cv::Point3f& axes)
@@ -368,16 +407,18 @@ void FacePainter::renderAxes()
         glViewport(0, 0, outFrameW, outFrameH);
         Tools::checkGLErr(getProcName(), "glViewport()");
 
+        // All three axes in one batch (segments only, so drop any unpaired vertex):
+        std::vector<cv::Point3f> points, colors;
         for (int i = m_axes.size() - 1; i >= 0; i--)
         {
-            glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, 0, 0, &m_axesColors[i].front().x);
-            Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-            glVertexAttribPointer(m_drawShParamAPosition, 3, GL_FLOAT, 0, 0, &m_axes[i].front().x);
-            Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
+            const std::size_t count = m_axes[i].size() & ~std::size_t(1);
+            points.insert(points.end(), m_axes[i].begin(), m_axes[i].begin() + count);
+            colors.insert(colors.end(), m_axesColors[i].begin(), m_axesColors[i].begin() + count);
+        }
 
-            glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_axes[i].size()));
-            Tools::checkGLErr(getProcName(), "glDrawArrays()");
+        if (points.size())
+        {
+            drawLines(&points[0].x, 3, &colors[0].x, static_cast<GLsizei>(points.size()));
         }
     }
 }
@@ -393,9 +434,7 @@ void FacePainter::FacePainter::setUniforms()
 
 int FacePainter::FacePainter::render(int position)
 {
-    const std::string tag = DRISHTI_LOCATION_SIMPLE;
-    drishti::core::ScopeTimeLogger renderLogger = [&](double ts) { m_logger->info("TIMING:{}={}", tag, ts); };
-
+    // Timing: see FaceFinder::kPaintProcess
     OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, outFrameW, outFrameH);
 
     { // ... main render routine ...
@@ -514,14 +553,14 @@ drawFlow(const FacePainter::FlowField& flow, const cv::Vec3f& color, DrawingSpec
  * Heye : transformation from full frame to
  */
 
-void FacePainter::annotateEye(const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size, const EyeAttributes& attributes)
+void FacePainter::annotateEye(const drishti::eye::EyeWarp& eyeWarp, const EyeAttributes& attributes, DrawingSpec& lines)
 {
     //const std::string tag = DRISHTI_LOCATION_SIMPLE;
     //drishti::core::ScopeTimeLogger paintLogger = [&](double ts) { m_logger->info("TIMING: {} = {}", tag, ts); }
 
     auto contours = eyeWarp.getContours(false); //!m_eyePoints.size());
 
-    DrawingSpec lines(0);
+    const std::size_t begin = lines.points.size();
     for (auto& c : contours)
     {
         for (int i = 1; i < c.size(); i++)
@@ -544,21 +583,13 @@ void FacePainter::annotateEye(const drishti::eye::EyeWarp& eyeWarp, const cv::Si
         drawFlow(*attributes.flow, attributes.color, lines, 100.f);
     }
 
-    glLineWidth(2.0);
-    cv::Matx44f MVPt;
-    transformation::R3x3To4x4(eyeWarp.H.t(), MVPt);
-
-    glUniformMatrix4fv(m_drawShParamUMVP, 1, 0, (GLfloat*)&MVPt(0, 0));
-    Tools::checkGLErr(getProcName(), "FacePainter::renderEye() : glUniformMatrix4fv()");
-
-    glVertexAttribPointer(m_drawShParamAColor, 3, GL_FLOAT, 0, 0, &lines.colors[0]);
-    Tools::checkGLErr(getProcName(), "FacePainter::annotateEye() : glVertexAttribPointer()");
-
-    glVertexAttribPointer(m_drawShParamAPosition, 2, GL_FLOAT, 0, 0, &lines.points[0]);
-    Tools::checkGLErr(getProcName(), "FacePainter::annotateEye() : glVertexAttribPointer()");
-
-    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(lines.points.size()));
-    Tools::checkGLErr(getProcName(), "FacePainter::annotateEye() : glDrawArrays()");
+    // Apply the eye warp here so that both eyes can share one draw call:
+    for (std::size_t i = begin; i < lines.points.size(); i++)
+    {
+        const cv::Point2f& p = lines.points[i];
+        const cv::Point3f q = eyeWarp.H * cv::Point3f(p.x, p.y, 1.f);
+        lines.points[i] = { q.x / q.z, q.y / q.z };
+    }
 }
 
 // roi: eye roi in output frame
@@ -633,9 +664,19 @@ void FacePainter::annotateEyes(const EyePairInfo& eyes, const EyeAttributes& att
     const auto& roi = eyes.m_eyesInfo.roi;
     glScissor(roi.x, roi.y, roi.width, roi.height);
 
+    DrawingSpec lines(GL_LINES);
     for (const auto& eye : eyes.m_eyes)
     {
-        annotateEye(eye, { eyes.m_eyesInfo.size.width, eyes.m_eyesInfo.size.height }, attributes);
+        annotateEye(eye, attributes, lines);
+    }
+
+    if (lines.points.size())
+    {
+        glLineWidth(2.0);
+        const cv::Matx44f MVPt = cv::Matx44f::eye();
+        glUniformMatrix4fv(m_drawShParamUMVP, 1, 0, (GLfloat*)&MVPt(0, 0));
+        Tools::checkGLErr(getProcName(), "FacePainter::annotateEyes() : glUniformMatrix4fv()");
+        drawLines(&lines.points[0].x, 2, &lines.colors[0][0], static_cast<GLsizei>(lines.points.size()));
     }
     glDisable(GL_SCISSOR_TEST);
 }
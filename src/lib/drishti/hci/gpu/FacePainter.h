@@ -20,6 +20,7 @@
 #include "drishti/hci/Scene.hpp"
 #include "drishti/face/Face.h" // face model
 #include "drishti/geometry/Mesh3D.h"
+#include "drishti/graphics/ProgramCache.h" // ogles_gpgpu::Program
 
 #include "ogles_gpgpu/common/proc/transform.h"
 #include "ogles_gpgpu/common/common_includes.h"
@@ -36,6 +37,7 @@ namespace spdlog { class logger; }
 BEGIN_OGLES_GPGPU
 
 class GLPrinterShader;
+struct DrawingSpec;
 
 class FacePainter : public ogles_gpgpu::TransformProc
 {
@@ -278,7 +280,10 @@ private:
     void renderFaces();
     EyeWarpPair renderEyes(const drishti::face::FaceModel& face);
     void renderEye(const cv::Rect& roi, const cv::Matx33f& H, const DRISHTI_EYE::EyeModel& eye);
-    void annotateEye(const drishti::eye::EyeWarp& eyeWarp, const cv::Size& size, const EyeAttributes& attributes);
+    void annotateEye(const drishti::eye::EyeWarp& eyeWarp, const EyeAttributes& attributes, DrawingSpec& lines);
+
+    // Draw GL_LINES (points with dims coordinates + rgb colors) from the shared stream buffer:
+    void drawLines(const GLfloat* points, int dims, const GLfloat* colors, GLsizei count);
 
     virtual void renderDrawings();
     virtual void renderAxes();
@@ -335,11 +340,12 @@ private:
     std::unique_ptr<GLPrinterShader> m_printer;
 
     // #### Draw shader ####
-    std::shared_ptr<Shader> m_draw;
+    std::shared_ptr<Program> m_draw;
     GLint m_drawShParamAColor;
     GLint m_drawShParamAPosition;
     GLint m_drawShParamULineColor{};
     GLint m_drawShParamUMVP;
+    GLuint m_lineVbo = 0; // per frame line vertices (orphaned on each upload)
 
     // #### color stuff ###
     Vec3f m_colorRGB;
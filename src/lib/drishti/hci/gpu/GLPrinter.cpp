@@ -13,6 +13,9 @@
 #include "drishti/hci/gpu/VeraFont_16_2048.h"
 #include "drishti/core/make_unique.h" // add for <= c++11
 
+#include <unordered_map>
+#include <vector>
+
 // clang-format off
 #if defined(DRISHTI_OPENGL_ES3)
 #  define DRISHTI_GL_RED GL_RED
@@ -53,26 +56,33 @@ varying vec2 texCoords;
  });
 // clang-format on
 
-GLPrinterShader::GLPrinterShader()
+// Expand the zero run length encoded atlas (see VeraFont_16_2048.h):
+static std::vector<uint8_t> decodeAtlas(const texture_font_t& font)
 {
-    auto& font = Vera_16_2048;
+    std::vector<uint8_t> texels;
+    texels.reserve(font.tex_width * font.tex_height * font.tex_depth);
+    for (std::size_t i = 0; i < font.tex_rle_size; i++)
+    {
+        const uint8_t value = font.tex_rle[i];
+        if (value == 0 && (i + 1) < font.tex_rle_size)
+        {
+            texels.insert(texels.end(), std::size_t(font.tex_rle[++i]) + 1, uint8_t(0));
+        }
+        else
+        {
+            texels.push_back(value);
+        }
+    }
+    texels.resize(font.tex_width * font.tex_height * font.tex_depth, 0);
+    return texels;
+}
 
+GLPrinterShader::GLPrinterShader()
+{
     glGenBuffers(1, &m_vbo);
     Tools::checkGLErr(getProcName(), "glGenBuffers");
 
-    // Load our own texture
-    glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &m_texId);
-    glBindTexture(GL_TEXTURE_2D, m_texId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, DRISHTI_GL_RED, font.tex_width, font.tex_height, 0, DRISHTI_GL_RED, GL_UNSIGNED_BYTE, font.tex_data);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    Tools::checkGLErr(getProcName(), "texture init");
-
-    m_shader = drishti::core::make_unique<ogles_gpgpu::Shader>();
+    m_shader = drishti::core::make_unique<ogles_gpgpu::Program>();
     m_shader->buildFromSrc(vshaderPrinterSrc, fshaderPrinterSrc);
     m_shParamAPos = m_shader->getParam(ATTR, "position");
     m_shParamUInputTex = m_shader->getParam(UNIF, "tex");
@@ -81,12 +91,39 @@ GLPrinterShader::GLPrinterShader()
 
 GLPrinterShader::~GLPrinterShader()
 {
-    glDeleteTextures(1, &m_texId);
+    if (m_texId)
+    {
+        glDeleteTextures(1, &m_texId);
+    }
     glDeleteBuffers(1, &m_vbo);
 }
 
+// The atlas is decoded and uploaded the first time text is printed:
+void GLPrinterShader::loadTexture()
+{
+    auto& font = Vera_16_2048;
+    const std::vector<uint8_t> texels = decodeAtlas(font);
+
+    glActiveTexture(GL_TEXTURE0);
+    glGenTextures(1, &m_texId);
+    glBindTexture(GL_TEXTURE_2D, m_texId);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, DRISHTI_GL_RED, font.tex_width, font.tex_height, 0, DRISHTI_GL_RED, GL_UNSIGNED_BYTE, texels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    Tools::checkGLErr(getProcName(), "texture init");
+}
+
 void GLPrinterShader::begin()
 {
+    if (!m_texId)
+    {
+        loadTexture();
+    }
+
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -99,22 +136,38 @@ void GLPrinterShader::begin()
     glUniform1i(m_shParamUInputTex, 0); // set texture unit
 }
 
-void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float sx, float sy)
+// Glyph lookup by codepoint (built once from the font table):
+static const texture_glyph_t* findGlyph(wchar_t codepoint)
 {
     auto& font = Vera_16_2048;
 
-    for (wchar_t i : str)
-    {
-        //Find the glyph for the character we are looking for
-        texture_glyph_t* glyph = nullptr;
+    static const std::unordered_map<wchar_t, const texture_glyph_t*> glyphs = [&]() {
+        std::unordered_map<wchar_t, const texture_glyph_t*> table;
         for (int j = 0; j < font.glyphs_count; ++j)
         {
-            if (font.glyphs[j].codepoint == i)
-            {
-                glyph = &font.glyphs[j];
-                break;
-            }
+            table.emplace(static_cast<wchar_t>(font.glyphs[j].codepoint), &font.glyphs[j]);
         }
+        return table;
+    }();
+
+    const auto iter = glyphs.find(codepoint);
+    return (iter != glyphs.end()) ? iter->second : nullptr;
+}
+
+void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float sx, float sy)
+{
+    struct Vertex
+    {
+        float x, y, s, t;
+    };
+
+    // All glyph quads for the string are submitted with one draw call:
+    std::vector<Vertex> vertices;
+    vertices.reserve(str.size() * 6);
+
+    for (wchar_t i : str)
+    {
+        const texture_glyph_t* glyph = findGlyph(i);
         if (!glyph)
         {
             continue;
@@ -132,30 +185,34 @@ void GLPrinterShader::printAt(const std::wstring& str, float x, float y, float s
         float s1 = glyph->s1;
         float t1 = glyph->t1;
 
-        struct
-        {
-            float x, y, s, t;
-        } data[6] = {
-            { x0, y0, s0, t0 },
-            { x0, y1, s0, t1 },
-            { x1, y1, s1, t1 },
-            { x0, y0, s0, t0 },
-            { x1, y1, s1, t1 },
-            { x1, y0, s1, t0 }
-        };
-
-        glEnableVertexAttribArray(m_shParamAPos);
-        Tools::checkGLErr(getProcName(), "glEnableVertexAttribArray()");
-
-        glVertexAttribPointer(m_shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, &data[0].x);
-        Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        Tools::checkGLErr(getProcName(), "glDrawArrays()");
+        vertices.push_back({ x0, y0, s0, t0 });
+        vertices.push_back({ x0, y1, s0, t1 });
+        vertices.push_back({ x1, y1, s1, t1 });
+        vertices.push_back({ x0, y0, s0, t0 });
+        vertices.push_back({ x1, y1, s1, t1 });
+        vertices.push_back({ x1, y0, s1, t0 });
 
         x += (glyph->advance_x * sx);
         y += (glyph->advance_y * sy);
     }
+
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    // Vertices are streamed through m_vbo (bound in begin()):
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), &vertices[0].x, GL_STREAM_DRAW);
+    Tools::checkGLErr(getProcName(), "glBufferData()");
+
+    glEnableVertexAttribArray(m_shParamAPos);
+    Tools::checkGLErr(getProcName(), "glEnableVertexAttribArray()");
+
+    glVertexAttribPointer(m_shParamAPos, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+    Tools::checkGLErr(getProcName(), "glVertexAttribPointer()");
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+    Tools::checkGLErr(getProcName(), "glDrawArrays()");
 }
 
 void GLPrinterShader::end()
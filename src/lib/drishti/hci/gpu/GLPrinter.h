@@ -12,6 +12,7 @@
 #define OGLES_GPGPU_COMMON_GL_PRINTER_PROC
 
 #include "ogles_gpgpu/common/proc/base/filterprocbase.h"
+#include "drishti/graphics/ProgramCache.h" // ogles_gpgpu::Program
 
 #include <string>
 #include <memory>
@@ -35,11 +36,14 @@ public:
     void end();
     void printAt(const std::wstring& str, float x, float y, float sx, float sy);
 
+    // Font atlas is uploaded on first use (see begin()):
+    void loadTexture();
+
     GLuint m_texId{};
     GLuint m_vbo{}, m_vao{};
 
     // #### Draw shader ####
-    std::shared_ptr<Shader> m_shader;
+    std::shared_ptr<Program> m_shader;
     GLuint m_shParamAPos;
     GLuint m_shParamATexCoord{};
     GLuint m_shParamUInputTex;
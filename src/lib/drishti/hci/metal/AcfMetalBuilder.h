@@ -0,0 +1,64 @@
+/*! -*-c++-*-
+  @file   metal/AcfMetalBuilder.h
+  @author David Hirvonen
+  @brief  Declaration of a Metal ACF pyramid builder for iOS camera frames.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The Metal counterpart of AcfComputeBuilder: BGRA camera frames (CVPixelBufferRef) are
+  wrapped as textures through a CVMetalTextureCache (no copy), converted to LUV, and the
+  same resize, smoothing, gradient, histogram and channel smoothing stages run as compute
+  kernels over all levels of the pyramid layout in one command buffer.  The channel
+  buffer uses shared storage, so the pyramid planes are filled straight from GPU memory.
+
+  The interface is plain C++ (the pixel buffer and device are passed as opaque pointers),
+  so FaceFinder and the SDK can use it without Objective-C.
+
+*/
+
+#ifndef __drishti_hci_metal_AcfMetalBuilder_h__
+#define __drishti_hci_metal_AcfMetalBuilder_h__
+
+#include "drishti/hci/drishti_hci.h"
+#include "drishti/hci/AcfPyramidBuilder.h" // Options
+
+#include <acf/ACF.h>
+
+#include <memory>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+class AcfMetalBuilder
+{
+public:
+    using Options = AcfPyramidBuilder::Options;
+
+    // The layout provides level sizes in storage (possibly transposed) order, the device is an
+    // optional id<MTLDevice> (system default otherwise):
+    AcfMetalBuilder(const acf::Detector::Pyramid& layout, const Options& options, void* device = nullptr);
+    ~AcfMetalBuilder();
+
+    AcfMetalBuilder(const AcfMetalBuilder&) = delete;
+    AcfMetalBuilder& operator=(const AcfMetalBuilder&) = delete;
+
+    // Compute all levels from a kCVPixelFormatType_32BGRA CVPixelBufferRef, transposed when the
+    // layout is (see FaceFinder::initACF()), false for unsupported formats or kernel failures:
+    bool operator()(void* pixelBuffer, acf::Detector::Pyramid& P, bool doTranspose = true);
+
+    // A Metal device with compute support:
+    static bool isSupported();
+
+    const Options& getOptions() const;
+
+    // Shared buffers:
+    std::size_t getBytes() const;
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+DRISHTI_HCI_NAMESPACE_END
+
+#endif // __drishti_hci_metal_AcfMetalBuilder_h__
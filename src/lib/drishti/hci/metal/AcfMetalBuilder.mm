@@ -0,0 +1,576 @@
+/*! -*-c++-*-
+  @file   metal/AcfMetalBuilder.mm
+  @author David Hirvonen
+  @brief  Implementation of a Metal ACF pyramid builder for iOS camera frames.
+
+  \copyright Copyright 2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/hci/metal/AcfMetalBuilder.h"
+#include "drishti/core/MemoryRegistry.h"
+#include "drishti/core/make_unique.h"
+
+#import <CoreVideo/CoreVideo.h>
+#import <Metal/Metal.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+DRISHTI_HCI_NAMESPACE_BEGIN
+
+// Full resolution scratch planes (see AcfComputeBuilder.cpp):
+enum Plane
+{
+    kLuv = 0,     // resized, then smoothed LUV (3)
+    kLuvTmp = 3,  // horizontal pass of the color smoothing (3)
+    kMag = 6,     // max gradient magnitude over the color channels
+    kOri = 7,     // orientation of the max gradient
+    kMagTmp = 8,  // horizontal pass of the normalization filter
+    kMagNorm = 9, // normalized gradient magnitude
+    kPlaneCount
+};
+
+static const int kTile = 8;
+
+// Kernel arguments (scalars only, so the layout matches the shader struct):
+struct Params
+{
+    int planeStride = 0;
+    int planes = 1;
+    int srcFirst = 0;
+    int dstFirst = 0;
+    int radius = 0;
+    int dx = 0;
+    int dy = 0;
+    int cells = 0;
+    int shrink = 4;
+    int normalize = 0;
+    int magFirst = kMag;
+    int luvFirst = kLuv;
+    int oriFirst = kOri;
+    int orientations = 6;
+    int transpose = 0;
+    float normConst = 0.005f;
+};
+
+static const char* kKernels = R"(
+#include <metal_stdlib>
+using namespace metal;
+
+struct Params
+{
+    int planeStride, planes, srcFirst, dstFirst, radius, dx, dy, cells, shrink;
+    int normalize, magFirst, luvFirst, oriFirst, orientations, transpose;
+    float normConst;
+};
+
+static int mirror(int p, int size) // cv::BORDER_REFLECT
+{
+    p = (p < 0) ? (-p - 1) : p;
+    p = (p >= size) ? (2 * size - p - 1) : p;
+    return clamp(p, 0, size - 1);
+}
+
+// RGB -> LUV in [0,1] (acf::Detector conventions):
+kernel void luv(texture2d<float, access::read> rgb [[texture(0)]],
+                texture2d<float, access::write> dst [[texture(1)]],
+                constant Params& p [[buffer(0)]],
+                uint2 gid [[thread_position_in_grid]])
+{
+    if ((gid.x >= dst.get_width()) || (gid.y >= dst.get_height()))
+    {
+        return;
+    }
+
+    const float3 c = rgb.read(p.transpose ? gid.yx : gid).rgb;
+    const float3 xyz = float3x3(float3(0.430574, 0.222015, 0.020183),
+                                float3(0.341550, 0.706655, 0.129553),
+                                float3(0.178325, 0.071330, 0.939180)) * c;
+    const float l = (xyz.y > 0.008856) ? (116.0 * pow(xyz.y, 1.0 / 3.0) - 16.0) : (xyz.y * 903.3);
+    const float L = l / 270.0;
+    const float z = 1.0 / (xyz.x + 15.0 * xyz.y + 3.0 * xyz.z + 1e-35);
+    const float u = L * (52.0 * xyz.x * z - 13.0 * 0.197833) + 88.0 / 270.0;
+    const float v = L * (117.0 * xyz.y * z - 13.0 * 0.468331) + 134.0 / 270.0;
+    dst.write(float4(L, u, v, 0.0), gid);
+}
+
+// LUV resampled to each level (area averaging when shrinking, bilinear otherwise):
+kernel void resize(texture2d<float, access::read> luv [[texture(0)]],
+                   constant Params& p [[buffer(0)]],
+                   device const int4* levels [[buffer(1)]],
+                   device float* dst [[buffer(3)]],
+                   uint3 gid [[thread_position_in_grid]])
+{
+    const int4 level = levels[gid.z];
+    const int2 q = int2(gid.xy);
+    if ((q.x >= level.x) || (q.y >= level.y))
+    {
+        return;
+    }
+
+    const int2 size = int2(luv.get_width(), luv.get_height());
+    const float2 s = float2(size) / float2(level.xy);
+    float3 value = 0.0;
+    if ((level.x * level.y) < (size.x * size.y))
+    {
+        const float2 a = float2(q) * s, b = a + s;
+        for (int y = int(floor(a.y)); y < int(ceil(b.y)); y++)
+        {
+            const float wy = min(b.y, float(y + 1)) - max(a.y, float(y));
+            for (int x = int(floor(a.x)); x < int(ceil(b.x)); x++)
+            {
+                const float wx = min(b.x, float(x + 1)) - max(a.x, float(x));
+                value += (wx * wy) * luv.read(uint2(min(int2(x, y), size - 1))).rgb;
+            }
+        }
+        value /= (s.x * s.y);
+    }
+    else
+    {
+        const float2 r = clamp((float2(q) + 0.5) * s - 0.5, float2(0.0), float2(size - 1));
+        const int2 r0 = int2(floor(r)), r1 = min(r0 + 1, size - 1);
+        const float2 f = r - float2(r0);
+        const float3 top = mix(luv.read(uint2(r0)).rgb, luv.read(uint2(r1.x, r0.y)).rgb, f.x);
+        const float3 bottom = mix(luv.read(uint2(r0.x, r1.y)).rgb, luv.read(uint2(r1)).rgb, f.x);
+        value = mix(top, bottom, f.y);
+    }
+
+    const int i = level.z + q.y * level.x + q.x;
+    dst[i] = value.r;
+    dst[p.planeStride + i] = value.g;
+    dst[p.planeStride * 2 + i] = value.b;
+}
+
+// Separable triangle filter (see convTri()), one direction per dispatch:
+kernel void triangle(constant Params& p [[buffer(0)]],
+                     device const int4* levels [[buffer(1)]],
+                     device const float* src [[buffer(2)]],
+                     device float* dst [[buffer(3)]],
+                     device const float* mag [[buffer(4)]],
+                     uint3 gid [[thread_position_in_grid]])
+{
+    const int z = int(gid.z);
+    const int4 level = levels[z / p.planes];
+    const int plane = z % p.planes;
+
+    const int2 size = p.cells ? (level.xy / p.shrink) : level.xy;
+    const int2 q = int2(gid.xy);
+    if ((q.x >= size.x) || (q.y >= size.y))
+    {
+        return;
+    }
+
+    const int srcBase = p.cells ? (level.w * p.planes + plane * size.x * size.y) : ((p.srcFirst + plane) * p.planeStride + level.z);
+    const int dstBase = p.cells ? srcBase : ((p.dstFirst + plane) * p.planeStride + level.z);
+
+    float sum = 0.0;
+    for (int k = -p.radius; k <= p.radius; k++)
+    {
+        const int x = mirror(q.x + p.dx * k, size.x);
+        const int y = mirror(q.y + p.dy * k, size.y);
+        sum += float(p.radius + 1 - abs(k)) * src[srcBase + y * size.x + x];
+    }
+    sum /= float((p.radius + 1) * (p.radius + 1));
+
+    const int i = q.y * size.x + q.x;
+    if (p.normalize)
+    {
+        sum = mag[p.magFirst * p.planeStride + level.z + i] / (sum + p.normConst);
+    }
+    dst[dstBase + i] = sum;
+}
+
+// Central difference gradients on a threadgroup tile (one pixel apron), max over channels:
+kernel void gradient(constant Params& p [[buffer(0)]],
+                     device const int4* levels [[buffer(1)]],
+                     device const float* src [[buffer(2)]],
+                     device float* dst [[buffer(3)]],
+                     uint3 gid [[thread_position_in_grid]],
+                     uint3 group [[threadgroup_position_in_grid]],
+                     uint2 local [[thread_position_in_threadgroup]],
+                     uint index [[thread_index_in_threadgroup]])
+{
+    threadgroup float tile[3][10][10];
+
+    const int4 level = levels[gid.z];
+    const int2 origin = int2(group.xy) * 8 - 1;
+    for (int k = int(index); k < 100; k += 64)
+    {
+        const int2 q = clamp(origin + int2(k % 10, k / 10), int2(0), level.xy - 1);
+        const int i = level.z + q.y * level.x + q.x;
+        for (int c = 0; c < 3; c++)
+        {
+            tile[c][k / 10][k % 10] = src[(p.luvFirst + c) * p.planeStride + i];
+        }
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    const int2 q = int2(gid.xy);
+    if ((q.x >= level.x) || (q.y >= level.y))
+    {
+        return;
+    }
+
+    // One sided differences at the borders (the apron is clamped):
+    const int2 span = min(q + 1, level.xy - 1) - max(q - 1, int2(0));
+    const float sx = (span.x > 0) ? (1.0 / float(span.x)) : 0.0;
+    const float sy = (span.y > 0) ? (1.0 / float(span.y)) : 0.0;
+
+    const int2 t = int2(local) + 1;
+    float magnitude = 0.0, orientation = 0.0;
+    for (int c = 0; c < 3; c++)
+    {
+        const float gx = (tile[c][t.y][t.x + 1] - tile[c][t.y][t.x - 1]) * sx;
+        const float gy = (tile[c][t.y + 1][t.x] - tile[c][t.y - 1][t.x]) * sy;
+        const float m = sqrt(gx * gx + gy * gy);
+        if (m > magnitude)
+        {
+            magnitude = m;
+            orientation = atan2(gy, gx);
+        }
+    }
+
+    const int i = level.z + q.y * level.x + q.x;
+    dst[p.magFirst * p.planeStride + i] = magnitude;
+    dst[(p.magFirst + 1) * p.planeStride + i] = orientation;
+}
+
+// One thread per shrink x shrink cell, channels in acf::Detector::Pyramid order:
+kernel void cells(constant Params& p [[buffer(0)]],
+                  device const int4* levels [[buffer(1)]],
+                  device const float* src [[buffer(2)]],
+                  device float* dst [[buffer(3)]],
+                  uint3 gid [[thread_position_in_grid]])
+{
+    const int4 level = levels[gid.z];
+    const int2 size = level.xy / p.shrink;
+    const int2 q = int2(gid.xy);
+    if ((q.x >= size.x) || (q.y >= size.y))
+    {
+        return;
+    }
+
+    const float binScale = float(p.orientations) / M_PI_F;
+
+    float hist[8] = { 0.0 };
+    float4 sum = 0.0;
+    for (int y = q.y * p.shrink; y < (q.y + 1) * p.shrink; y++)
+    {
+        for (int x = q.x * p.shrink; x < (q.x + 1) * p.shrink; x++)
+        {
+            const int i = level.z + y * level.x + x;
+            const float m = src[p.magFirst * p.planeStride + i];
+            float o = src[p.oriFirst * p.planeStride + i];
+            o = (o < 0.0) ? (o + M_PI_F) : o;
+            hist[min(int(o * binScale), p.orientations - 1)] += m;
+            sum += float4(src[p.luvFirst * p.planeStride + i], src[(p.luvFirst + 1) * p.planeStride + i], src[(p.luvFirst + 2) * p.planeStride + i], m);
+        }
+    }
+
+    const float norm = 1.0 / float(p.shrink * p.shrink);
+    const int area = size.x * size.y;
+    const int i = level.w * (4 + p.orientations) + q.y * size.x + q.x;
+    for (int c = 0; c < 4; c++)
+    {
+        dst[i + c * area] = sum[c] * norm;
+    }
+    for (int b = 0; b < p.orientations; b++)
+    {
+        dst[i + (4 + b) * area] = hist[b] * norm;
+    }
+}
+)";
+
+struct AcfMetalBuilder::Impl
+{
+    Impl(const acf::Detector::Pyramid& layout, const Options& options, id<MTLDevice> device)
+        : options(options)
+        , layout(layout)
+        , device(device ? device : MTLCreateSystemDefaultDevice())
+    {
+        channels = 4 + options.orientations;
+        for (int i = 0; i < layout.nScales; i++)
+        {
+            const cv::Size size = layout.data[i][0][0].size();
+            const std::array<int, 4> entry = { { size.width * options.shrink, size.height * options.shrink, fullTotal, cellTotal } };
+            table.push_back(entry);
+            maxSize.width = std::max(maxSize.width, entry[0]);
+            maxSize.height = std::max(maxSize.height, entry[1]);
+            fullTotal += entry[0] * entry[1];
+            cellTotal += size.area();
+        }
+
+        memoryUsage = core::MemoryRegistry::get().add(core::MemoryRegistry::kTexture, "AcfMetalBuilder", [this]() {
+            return bytes.load();
+        });
+    }
+
+    ~Impl()
+    {
+        if (textureCache)
+        {
+            CFRelease(textureCache);
+        }
+    }
+
+    id<MTLComputePipelineState> pipeline(id<MTLLibrary> library, NSString* name)
+    {
+        NSError* error = nil;
+        id<MTLFunction> function = [library newFunctionWithName:name];
+        id<MTLComputePipelineState> state = function ? [device newComputePipelineStateWithFunction:function error:&error] : nil;
+        if (!state)
+        {
+            NSLog(@"AcfMetalBuilder: failed to create pipeline %@: %@", name, error);
+        }
+        return state;
+    }
+
+    // Pipelines and buffers are created on first use:
+    bool build()
+    {
+        if (!ready && !failed && device)
+        {
+            NSError* error = nil;
+            id<MTLLibrary> library = [device newLibraryWithSource:@(kKernels) options:nil error:&error];
+            if (!library)
+            {
+                NSLog(@"AcfMetalBuilder: failed to compile kernels: %@", error);
+                failed = true;
+                return false;
+            }
+
+            luv = pipeline(library, @"luv");
+            resize = pipeline(library, @"resize");
+            triangle = pipeline(library, @"triangle");
+            gradient = pipeline(library, @"gradient");
+            cells = pipeline(library, @"cells");
+            failed = !(luv && resize && triangle && gradient && cells);
+            failed |= (CVMetalTextureCacheCreate(kCFAllocatorDefault, nil, device, nil, &textureCache) != kCVReturnSuccess);
+            if (failed)
+            {
+                return false;
+            }
+
+            queue = [device newCommandQueue];
+            levelBuffer = [device newBufferWithBytes:table.data() length:(table.size() * sizeof(table[0])) options:MTLResourceStorageModeShared];
+            scratch = [device newBufferWithLength:(sizeof(float) * kPlaneCount * fullTotal) options:MTLResourceStorageModePrivate];
+            channelBuffers[0] = [device newBufferWithLength:(sizeof(float) * channels * cellTotal) options:MTLResourceStorageModeShared];
+            channelBuffers[1] = [device newBufferWithLength:(sizeof(float) * channels * cellTotal) options:MTLResourceStorageModePrivate];
+            ready = (queue && levelBuffer && scratch && channelBuffers[0] && channelBuffers[1]);
+            failed = !ready;
+            update();
+        }
+        return ready;
+    }
+
+    void update()
+    {
+        std::size_t total = sizeof(float) * (std::size_t(kPlaneCount) * fullTotal + std::size_t(2) * channels * cellTotal);
+        total += table.size() * sizeof(table[0]) + (luvTexture ? (std::size_t(luvTexture.width) * luvTexture.height * 8) : 0);
+        bytes = ready ? total : 0;
+    }
+
+    void dispatch(id<MTLComputeCommandEncoder> encoder, id<MTLComputePipelineState> state, const Params& params, const cv::Size& size, int depth)
+    {
+        [encoder setComputePipelineState:state];
+        [encoder setBytes:&params length:sizeof(params) atIndex:0];
+        [encoder setBuffer:levelBuffer offset:0 atIndex:1];
+        [encoder dispatchThreadgroups:MTLSizeMake((size.width + kTile - 1) / kTile, (size.height + kTile - 1) / kTile, depth)
+                threadsPerThreadgroup:MTLSizeMake(kTile, kTile, 1)];
+    }
+
+    // Full resolution planes (scratch) or cell planes (src, dst buffers):
+    void filter(id<MTLComputeCommandEncoder> encoder, bool isCell, id<MTLBuffer> src, id<MTLBuffer> dst, int srcFirst, int dstFirst, int planes, int radius, bool horizontal, bool normalize = false)
+    {
+        Params params = base();
+        params.cells = isCell;
+        params.planes = planes;
+        params.srcFirst = srcFirst;
+        params.dstFirst = dstFirst;
+        params.radius = std::max(radius, 0);
+        params.dx = int(horizontal);
+        params.dy = int(!horizontal);
+        params.normalize = normalize;
+
+        [encoder setBuffer:src offset:0 atIndex:2];
+        [encoder setBuffer:dst offset:0 atIndex:3];
+        [encoder setBuffer:scratch offset:0 atIndex:4];
+        const cv::Size size = isCell ? cv::Size(maxSize.width / options.shrink, maxSize.height / options.shrink) : maxSize;
+        dispatch(encoder, triangle, params, size, int(table.size()) * planes);
+    }
+
+    Params base() const
+    {
+        Params params;
+        params.planeStride = fullTotal;
+        params.shrink = options.shrink;
+        params.orientations = options.orientations;
+        params.normConst = options.normConst;
+        return params;
+    }
+
+    bool run(CVPixelBufferRef pixelBuffer, acf::Detector::Pyramid& P, bool doTranspose)
+    {
+        if (!pixelBuffer || (CVPixelBufferGetPixelFormatType(pixelBuffer) != kCVPixelFormatType_32BGRA) || !build())
+        {
+            return false;
+        }
+
+        // Camera frame -> texture (no copy):
+        const std::size_t width = CVPixelBufferGetWidth(pixelBuffer);
+        const std::size_t height = CVPixelBufferGetHeight(pixelBuffer);
+        CVMetalTextureRef frame = nullptr;
+        if (CVMetalTextureCacheCreateTextureFromImage(kCFAllocatorDefault, textureCache, pixelBuffer, nil, MTLPixelFormatBGRA8Unorm, width, height, 0, &frame) != kCVReturnSuccess)
+        {
+            return false;
+        }
+
+        const std::size_t luvWidth = doTranspose ? height : width;
+        const std::size_t luvHeight = doTranspose ? width : height;
+        if (!luvTexture || (luvTexture.width != luvWidth) || (luvTexture.height != luvHeight))
+        {
+            MTLTextureDescriptor* desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA16Float width:luvWidth height:luvHeight mipmapped:NO];
+            desc.usage = MTLTextureUsageShaderRead | MTLTextureUsageShaderWrite;
+            desc.storageMode = MTLStorageModePrivate;
+            luvTexture = [device newTextureWithDescriptor:desc];
+            update();
+        }
+
+        const int levels = int(table.size());
+        const cv::Size cellSize(maxSize.width / options.shrink, maxSize.height / options.shrink);
+
+        id<MTLCommandBuffer> commands = [queue commandBuffer];
+        id<MTLComputeCommandEncoder> encoder = [commands computeCommandEncoder]; // serial dispatch
+
+        // (1) LUV, resample and smooth the color planes:
+        Params params = base();
+        params.transpose = doTranspose;
+        [encoder setTexture:CVMetalTextureGetTexture(frame) atIndex:0];
+        [encoder setTexture:luvTexture atIndex:1];
+        dispatch(encoder, luv, params, { int(luvWidth), int(luvHeight) }, 1);
+
+        [encoder setTexture:luvTexture atIndex:0];
+        [encoder setBuffer:scratch offset:0 atIndex:3];
+        dispatch(encoder, resize, base(), maxSize, levels);
+
+        filter(encoder, false, scratch, scratch, kLuv, kLuvTmp, 3, options.colorSmooth, true);
+        filter(encoder, false, scratch, scratch, kLuvTmp, kLuv, 3, options.colorSmooth, false);
+
+        // (2) Gradient magnitude and orientation, then M / (S(M) + eps):
+        [encoder setBuffer:scratch offset:0 atIndex:2];
+        [encoder setBuffer:scratch offset:0 atIndex:3];
+        dispatch(encoder, gradient, base(), maxSize, levels);
+
+        filter(encoder, false, scratch, scratch, kMag, kMagTmp, 1, options.normRadius, true);
+        filter(encoder, false, scratch, scratch, kMagTmp, kMagNorm, 1, options.normRadius, false, true);
+
+        // (3) Shrink to channel cells, then smooth all channels (ending in the shared buffer):
+        params = base();
+        params.magFirst = kMagNorm;
+        [encoder setBuffer:scratch offset:0 atIndex:2];
+        [encoder setBuffer:channelBuffers[1] offset:0 atIndex:3];
+        dispatch(encoder, cells, params, cellSize, levels);
+
+        filter(encoder, true, channelBuffers[1], channelBuffers[0], 0, 0, channels, options.pyramidSmooth, true);
+        filter(encoder, true, channelBuffers[0], channelBuffers[1], 0, 0, channels, options.pyramidSmooth, false);
+        [encoder endEncoding];
+
+        // The final pass writes the private buffer, blit to the shared one:
+        id<MTLBlitCommandEncoder> blit = [commands blitCommandEncoder];
+        [blit copyFromBuffer:channelBuffers[1] sourceOffset:0 toBuffer:channelBuffers[0] destinationOffset:0 size:channelBuffers[0].length];
+        [blit endEncoding];
+
+        [commands commit];
+        [commands waitUntilCompleted];
+        CFRelease(frame);
+
+        if (commands.status != MTLCommandBufferStatusCompleted)
+        {
+            return false;
+        }
+        return fill(static_cast<const float*>(channelBuffers[0].contents), P);
+    }
+
+    bool fill(const float* data, acf::Detector::Pyramid& P)
+    {
+        if (P.data.size() != layout.data.size())
+        {
+            P = layout;
+        }
+
+        for (std::size_t i = 0; i < table.size(); i++)
+        {
+            const cv::Size size = layout.data[i][0][0].size();
+            auto& planes = P.data[i][0].get();
+            planes.resize(channels);
+            for (int c = 0; c < channels; c++)
+            {
+                const float* plane = data + std::size_t(table[i][3]) * channels + std::size_t(c) * size.area();
+                if ((planes[c].size() != size) || (planes[c].type() != CV_32FC1) || !planes[c].isContinuous())
+                {
+                    planes[c].create(size, CV_32FC1);
+                }
+                std::memcpy(planes[c].ptr(), plane, sizeof(float) * size.area());
+            }
+        }
+        return true;
+    }
+
+    Options options;
+    acf::Detector::Pyramid layout;
+    int channels = 0;
+    std::vector<std::array<int, 4>> table; // (width, height, full offset, cell offset)
+    cv::Size maxSize;
+    int fullTotal = 0;
+    int cellTotal = 0;
+
+    bool ready = false;
+    bool failed = false;
+    id<MTLDevice> device = nil;
+    id<MTLCommandQueue> queue = nil;
+    id<MTLComputePipelineState> luv = nil, resize = nil, triangle = nil, gradient = nil, cells = nil;
+    id<MTLBuffer> levelBuffer = nil, scratch = nil;
+    id<MTLBuffer> channelBuffers[2] = { nil, nil }; // shared output, private ping-pong
+    id<MTLTexture> luvTexture = nil;
+    CVMetalTextureCacheRef textureCache = nullptr;
+
+    std::atomic<std::size_t> bytes{ 0 };
+    core::MemoryRegistry::Registration memoryUsage;
+};
+
+AcfMetalBuilder::AcfMetalBuilder(const acf::Detector::Pyramid& layout, const Options& options, void* device)
+    : m_impl(drishti::core::make_unique<Impl>(layout, options, (__bridge id<MTLDevice>)device))
+{
+}
+
+AcfMetalBuilder::~AcfMetalBuilder() = default;
+
+bool AcfMetalBuilder::operator()(void* pixelBuffer, acf::Detector::Pyramid& P, bool doTranspose)
+{
+    @autoreleasepool
+    {
+        return m_impl->run(static_cast<CVPixelBufferRef>(pixelBuffer), P, doTranspose);
+    }
+}
+
+bool AcfMetalBuilder::isSupported()
+{
+    return MTLCreateSystemDefaultDevice() != nil;
+}
+
+const AcfMetalBuilder::Options& AcfMetalBuilder::getOptions() const
+{
+    return m_impl->options;
+}
+
+std::size_t AcfMetalBuilder::getBytes() const
+{
+    return m_impl->bytes;
+}
+
+DRISHTI_HCI_NAMESPACE_END
@@ -12,26 +12,62 @@ endif()
 include(sugar_files)
 
 sugar_files(DRISHTI_HCI_SRCS
-  EyeBlob.cpp
+  AcfPyramidBuilder.cpp
+  DetectionScheduler.cpp
+  DeviceOrientation.cpp
+  DeviceProfile.cpp
+  EyeGate.cpp
   FaceFinder.cpp
-  FaceFinderPainter.cpp
+  FaceFinderCpu.cpp
+  FaceHistory.cpp
+  FaceMonitorDispatcher.cpp
   GazeEstimator.cpp
+  PowerPolicy.cpp
   Scene.cpp
-  gpu/BlobFilter.cpp
-  gpu/FacePainter.cpp
-  gpu/GLCircle.cpp  
-  gpu/GLPrinter.cpp
-  gpu/LineDrawing.cpp
+  SessionRecorder.cpp
+  gpu/AcfComputeBuilder.cpp
   )
 
+# Annotations (see DRISHTI_HCI_WITH_PAINTER):
+if(DRISHTI_HCI_WITH_PAINTER)
+  sugar_files(DRISHTI_HCI_SRCS
+    FaceFinderPainter.cpp
+    gpu/FacePainter.cpp
+    gpu/GLCircle.cpp
+    gpu/GLPrinter.cpp
+    gpu/LineDrawing.cpp
+    )
+endif()
+
+# Eye reflections (see DRISHTI_HCI_WITH_BLOBS):
+if(DRISHTI_HCI_WITH_BLOBS)
+  sugar_files(DRISHTI_HCI_SRCS
+    BlobFilterCpu.cpp
+    EyeBlob.cpp
+    gpu/BlobFilter.cpp
+    )
+endif()
+
 sugar_files(DRISHTI_HCI_HDRS_PUBLIC
+  AcfPyramidBuilder.h
+  BlobFilterCpu.h
+  DetectionScheduler.h
+  DeviceOrientation.h
+  DeviceProfile.h
   EyeBlob.h
+  EyeGate.h
   FaceFinder.h
+  FaceFinderCpu.h
   FaceFinderImpl.h
   FaceFinderPainter.h
+  FaceHistory.h
   FaceMonitor.h
+  FaceMonitorDispatcher.h
   GazeEstimator.h
+  PowerPolicy.h
   Scene.hpp
+  SessionRecorder.h
+  gpu/AcfComputeBuilder.h
   gpu/BlobFilter.h
   gpu/FacePainter.h
   gpu/GLCircle.h
@@ -39,6 +75,16 @@ sugar_files(DRISHTI_HCI_HDRS_PUBLIC
   gpu/LineDrawing.hpp
   )
 
+if(IOS)
+  # Metal pyramid for camera frames (see metal/AcfMetalBuilder.h)
+  sugar_files(DRISHTI_HCI_SRCS
+    metal/AcfMetalBuilder.mm
+    )
+  sugar_files(DRISHTI_HCI_HDRS_PUBLIC
+    metal/AcfMetalBuilder.h
+    )
+endif()
+
 sugar_files(DRISHTI_HCI_UT
   ut/FaceMonitorHCITest.h
   ut/test-drishti-hci.cpp
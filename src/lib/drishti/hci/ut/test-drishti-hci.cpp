@@ -28,9 +28,26 @@ extern const char* sFaceImageFilename; // sImageFilename);
 #include <cereal/archives/portable_binary.hpp>
 #include <cereal/types/vector.hpp>
 
+#include "drishti/hci/AcfPyramidBuilder.h"
+#include "drishti/hci/BlobFilterCpu.h"
+#include "drishti/hci/DetectionScheduler.h"
+#include "drishti/hci/DeviceOrientation.h"
+#include "drishti/hci/DeviceProfile.h"
+#include "drishti/hci/EyeGate.h"
 #include "drishti/hci/FaceFinder.h"
+#include "drishti/hci/FaceHistory.h"
+#include "drishti/hci/FaceMonitorDispatcher.h"
+#include "drishti/hci/GazeEstimator.h"
+#include "drishti/hci/PowerPolicy.h"
+#include "drishti/hci/gpu/AcfComputeBuilder.h"
+#include "drishti/ml/AcfCascade.h"
+#include "drishti/ml/AcfNegativeMiner.h"
+#include "drishti/ml/AcfPyramidCache.h"
+#include "drishti/ml/ObjectDetector.h"
+#include "drishti/ml/ObjectDetectorACFTiled.h"
 #include "drishti/sensor/Sensor.h"
 #include "drishti/core/ThreadPool.h"
+#include "drishti/core/arithmetic.h"
 #include "drishti/core/Logger.h"
 
 #include "FaceMonitorHCITest.h"
@@ -42,9 +59,16 @@ extern const char* sFaceImageFilename; // sImageFilename);
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <numeric>
 #include <memory>
 #include <condition_variable>
+#include <cstdio>
+#include <atomic>
+#include <set>
+#include <sstream>
+#include <thread>
 
 #ifdef ANDROID
 #define DFLT_TEXTURE_FORMAT GL_RGBA
@@ -240,4 +264,891 @@ TEST_F(HCITest, RunTestGPUAsync) // NOLINT (TODO)
 }
 #endif // defined(DRISHTI_DO_GPU_TESTING)
 
+TEST(AcfPyramidBuilder, uniform) // NOLINT (TODO)
+{
+    using drishti::hci::AcfPyramidBuilder;
+
+    acf::Detector::Pyramid layout;
+    layout.nScales = 2;
+    layout.data = { { MatP(cv::Mat1f(16, 12)) }, { MatP(cv::Mat1f(8, 6)) } };
+    layout.scales = { 1.0, 0.5 };
+
+    AcfPyramidBuilder builder(layout, {});
+
+    // A constant LUV image has flat color channels and no gradients:
+    const cv::Mat3f image(64, 48, cv::Vec3f(0.5f, 0.25f, 0.75f));
+    acf::Detector::Pyramid P;
+    tp::ThreadPool<> threads;
+    builder(MatP(image), P, &threads);
+
+    ASSERT_EQ(P.nScales, layout.nScales);
+    for (int i = 0; i < P.nScales; i++)
+    {
+        const auto& channels = P.data[i][0].get();
+        ASSERT_EQ(channels.size(), 10);
+        for (int j = 0; j < channels.size(); j++)
+        {
+            ASSERT_EQ(channels[j].size(), layout.data[i][0][0].size());
+            const double expected = (j < 3) ? image(0, 0)[j] : 0.0;
+            EXPECT_NEAR(cv::mean(channels[j])[0], expected, 1e-5);
+        }
+    }
+}
+
+TEST(AcfPyramidBuilder, computePyramid) // NOLINT (TODO)
+{
+    using drishti::hci::AcfPyramidBuilder;
+
+    // Same configuration as the FaceFinder CPU fallback (planar LUV in storage order):
+    acf::Detector detector(sFaceDetector);
+    detector.setIsLuv(true);
+    detector.setIsTranspose(true);
+
+    // Smooth textured LUV content:
+    cv::Mat3f image(256, 192);
+    cv::randu(image, cv::Scalar::all(0.0), cv::Scalar::all(1.0));
+    cv::GaussianBlur(image, image, { 9, 9 }, 2.0);
+
+    acf::Detector::Pyramid expected, actual;
+    detector.computePyramid(MatP(image), expected);
+    ASSERT_GT(expected.nScales, 0);
+
+    AcfPyramidBuilder::Options options;
+    options.shrink = detector.opts.pPyramid->pChns->shrink.get();
+    tp::ThreadPool<> threads;
+    AcfPyramidBuilder(expected, options)(MatP(image), actual, &threads);
+    ASSERT_EQ(actual.nScales, expected.nScales);
+
+    // Skip the detector's padding, and allow for its approximated (power law) levels:
+    const cv::Size pad = detector.opts.pPyramid->pad.get();
+    const cv::Point border(pad.width / options.shrink, pad.height / options.shrink);
+    for (int i = 0; i < expected.nScales; i++)
+    {
+        const auto& a = actual.data[i][0].get();
+        const auto& b = expected.data[i][0].get();
+        ASSERT_EQ(a.size(), b.size());
+        for (int j = 0; j < a.size(); j++)
+        {
+            ASSERT_EQ(a[j].size(), b[j].size());
+            const cv::Rect roi(border, cv::Size(b[j].cols - border.x * 2, b[j].rows - border.y * 2));
+            if (roi.area() <= 0)
+            {
+                continue;
+            }
+
+            const cv::Mat1f ai = a[j](roi), bi = b[j](roi);
+            const double error = cv::norm(ai, bi, cv::NORM_L1) / bi.total();
+            EXPECT_LE(error, 0.1 * cv::norm(bi, cv::NORM_L1) / bi.total() + 1e-3) << "level " << i << " channel " << j;
+        }
+    }
+}
+
+TEST(AcfPyramidBuilder, incremental) // NOLINT (TODO)
+{
+    using drishti::hci::AcfPyramidBuilder;
+
+    acf::Detector::Pyramid layout;
+    layout.nScales = 3;
+    layout.data = { { MatP(cv::Mat1f(32, 24)) }, { MatP(cv::Mat1f(20, 15)) }, { MatP(cv::Mat1f(8, 6)) } };
+    layout.scales = { 1.0, 0.625, 0.25 };
+
+    AcfPyramidBuilder::Options options;
+    options.changeBlock = 16;
+    AcfPyramidBuilder incremental(layout, options), full(layout, {});
+
+    cv::Mat3f image(128, 96);
+    cv::randu(image, cv::Scalar::all(0.0), cv::Scalar::all(1.0));
+
+    tp::ThreadPool<> threads;
+    acf::Detector::Pyramid P0, P1, expected;
+    incremental(MatP(image), P0, &threads);
+    EXPECT_TRUE(incremental.getChanges().isFull);
+
+    // A static frame reuses every level:
+    incremental(MatP(image), P1, &threads);
+    EXPECT_FALSE(incremental.getChanges().isFull);
+    EXPECT_TRUE(incremental.getChanges().blocks.empty());
+    EXPECT_EQ(incremental.getChanges().tiles, 0);
+
+    // A small change recomputes the nearby tiles only, and matches a full update:
+    const cv::Mat3f before = image.clone();
+    cv::rectangle(image, { 40, 50, 16, 12 }, cv::Scalar::all(0.5), -1);
+    incremental(MatP(image), P1, &threads);
+    full(MatP(image), expected, &threads);
+    ASSERT_FALSE(incremental.getChanges().isFull);
+    EXPECT_EQ(incremental.getChanges().blocks.size(), 2);
+    EXPECT_GT(incremental.getChanges().tiles, 0);
+
+    for (int i = 0; i < layout.nScales; i++)
+    {
+        const auto& actual = P1.data[i][0].get();
+        const auto& reference = expected.data[i][0].get();
+        ASSERT_EQ(actual.size(), reference.size());
+        for (std::size_t j = 0; j < actual.size(); j++)
+        {
+            EXPECT_LE(cv::norm(actual[j], reference[j], cv::NORM_INF), 1e-5);
+        }
+    }
+
+    // Earlier pyramids are not modified:
+    AcfPyramidBuilder reference(layout, {});
+    reference(MatP(before), expected, &threads);
+    for (int i = 0; i < layout.nScales; i++)
+    {
+        for (std::size_t j = 0; j < expected.data[i][0].get().size(); j++)
+        {
+            EXPECT_LE(cv::norm(P0.data[i][0].get()[j], expected.data[i][0].get()[j], cv::NORM_INF), 1e-5);
+        }
+    }
+}
+
+#if defined(DRISHTI_DO_GPU_TESTING)
+TEST(AcfComputeBuilder, MatchesCpu) // NOLINT (TODO)
+{
+    using drishti::hci::AcfComputeBuilder;
+    using drishti::hci::AcfPyramidBuilder;
+
+    auto context = aglet::GLContext::create(aglet::GLContext::kAuto);
+    ASSERT_TRUE(context && (*context));
+    if (!AcfComputeBuilder::isSupported())
+    {
+        return; // OpenGL ES 3.0 or older desktop context
+    }
+
+    acf::Detector::Pyramid layout;
+    layout.nScales = 3;
+    layout.data = { { MatP(cv::Mat1f(32, 24)) }, { MatP(cv::Mat1f(20, 15)) }, { MatP(cv::Mat1f(8, 6)) } };
+    layout.scales = { 1.0, 0.625, 0.25 };
+
+    // Smooth 8 bit LUV content (both builders see the same quantized input):
+    cv::Mat3b image(128, 96);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(image, image, { 9, 9 }, 2.0);
+
+    acf::Detector::Pyramid expected, actual;
+    tp::ThreadPool<> threads;
+    AcfPyramidBuilder(layout, {})(MatP(image), expected, &threads);
+
+    AcfComputeBuilder builder(layout, {});
+    ASSERT_TRUE(builder(MatP(image), actual));
+    ASSERT_EQ(actual.nScales, layout.nScales);
+    EXPECT_GT(builder.getBytes(), 0);
+
+    for (int i = 0; i < actual.nScales; i++)
+    {
+        const auto& a = actual.data[i][0].get();
+        const auto& b = expected.data[i][0].get();
+        ASSERT_EQ(a.size(), b.size());
+        for (int j = 0; j < a.size(); j++)
+        {
+            ASSERT_EQ(a[j].size(), b[j].size());
+            EXPECT_LT(cv::norm(a[j], b[j], cv::NORM_L1) / a[j].total(), 1e-2);
+        }
+    }
+}
+#endif // defined(DRISHTI_DO_GPU_TESTING)
+
+TEST(AcfPyramidCache, acquire) // NOLINT (TODO)
+{
+    using drishti::ml::AcfPyramidCache;
+
+    AcfPyramidCache cache(2);
+
+    int count = 0;
+    auto compute = [&](acf::Detector::Pyramid& P) {
+        P.nScales = 1;
+        P.data = { { MatP(cv::Mat1f(8, 6, static_cast<float>(++count))) } };
+        P.scales = { 1.0 };
+        return 0.5f;
+    };
+
+    AcfPyramidCache::Key key;
+    key.frame = 0;
+
+    // A second model on the same frame reuses the first pyramid:
+    const auto a = cache.acquire(key, compute);
+    const auto b = cache.acquire(key, compute);
+    EXPECT_EQ(a.P, b.P);
+    EXPECT_EQ(b.scale, 0.5f);
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(cache.getHits(), 1);
+    EXPECT_EQ(cache.getMisses(), 1);
+
+    // Other channel parameters (or frames) get their own pyramid:
+    auto other = key;
+    other.shrink = 2;
+    EXPECT_NE(cache.acquire(other, compute).P, a.P);
+    EXPECT_EQ(count, 2);
+
+    // The least recently published pyramid is evicted:
+    auto next = key;
+    next.frame = 1;
+    AcfPyramidCache::Entry entry;
+    entry.P = std::make_shared<acf::Detector::Pyramid>();
+    cache.put(next, entry);
+    EXPECT_FALSE(cache.get(key, entry));
+    EXPECT_TRUE(cache.get(other, entry));
+    EXPECT_TRUE(cache.get(next, entry));
+}
+
+TEST(AcfCascade, simd) // NOLINT (TODO)
+{
+    using drishti::ml::AcfCascade;
+
+    // Random depth 2 cascade over a 16x16 window with 4x shrink (4x4 channel units):
+    cv::RNG rng(1);
+    AcfCascade::Geometry geometry;
+    geometry.modelDs = geometry.modelDsPad = { 16, 16 };
+    geometry.cascThr = -0.25f;
+
+    AcfCascade::Trees trees;
+    trees.depth = 2;
+    trees.nodes = 7;
+    for (int t = 0; t < 64; t++)
+    {
+        for (int k = 0; k < trees.nodes; k++)
+        {
+            trees.fids.push_back(rng.uniform(0, 10 * 4 * 4));
+            trees.thrs.push_back(rng.uniform(0.f, 1.f));
+            trees.child.push_back(0);
+            trees.hs.push_back(rng.uniform(-0.1f, 0.15f));
+        }
+    }
+
+    std::vector<cv::Mat> planes(10);
+    for (auto& plane : planes)
+    {
+        plane.create(33, 47, CV_32F);
+        rng.fill(plane, cv::RNG::UNIFORM, 0.f, 1.f);
+    }
+
+    AcfCascade cascade(trees, geometry, 8);
+
+    std::vector<AcfCascade::Window> simd, scalar;
+    drishti::core::setSimdEnabled(true);
+    cascade.scan(planes, simd);
+    drishti::core::setSimdEnabled(false);
+    cascade.scan(planes, scalar);
+    drishti::core::setSimdEnabled(true);
+
+    ASSERT_FALSE(scalar.empty());
+    ASSERT_EQ(simd.size(), scalar.size());
+    for (int i = 0; i < simd.size(); i++)
+    {
+        EXPECT_EQ(simd[i].u, scalar[i].u);
+        EXPECT_EQ(simd[i].v, scalar[i].v);
+        EXPECT_EQ(simd[i].h, scalar[i].h); // bit-identical
+    }
+}
+
+TEST(AcfNegativeMiner, HardestUnique) // NOLINT (TODO)
+{
+    using drishti::ml::AcfCascade;
+    using drishti::ml::AcfNegativeMiner;
+
+    // Random depth 2 cascade (see AcfCascade.simd) that accepts most windows:
+    cv::RNG rng(2);
+    AcfCascade::Geometry geometry;
+    geometry.modelDs = geometry.modelDsPad = { 16, 16 };
+    geometry.cascThr = -1.f;
+
+    AcfCascade::Trees trees;
+    trees.depth = 2;
+    trees.nodes = 7;
+    for (int t = 0; t < 16; t++)
+    {
+        for (int k = 0; k < trees.nodes; k++)
+        {
+            trees.fids.push_back(rng.uniform(0, 10 * 4 * 4));
+            trees.thrs.push_back(rng.uniform(0.f, 1.f));
+            trees.child.push_back(0);
+            trees.hs.push_back(rng.uniform(-0.05f, 0.1f));
+        }
+    }
+
+    AcfNegativeMiner::Settings settings;
+    settings.perImage = 4;
+    settings.maxSamples = 6;
+    settings.overlap = 0.5f;
+    AcfNegativeMiner miner(AcfCascade(trees, geometry), settings);
+
+    for (std::uint32_t image = 0; image < 3; image++)
+    {
+        MatP channels;
+        channels.get().resize(10);
+        for (auto& plane : channels.get())
+        {
+            plane.create(24, 32, CV_32F);
+            rng.fill(plane, cv::RNG::UNIFORM, 0.f, 1.f);
+        }
+
+        acf::Detector::Pyramid P;
+        P.nScales = 1;
+        P.data = { { channels } };
+        P.scales = { 1.0 };
+        P.scaleshw = { { 1.0, 1.0 } };
+        miner.add(image, P);
+    }
+
+    ASSERT_GT(miner.getCandidateCount(), settings.maxSamples);
+    EXPECT_EQ(miner.getImageCount(), 3);
+
+    // Bounded, hardest first, no duplicates within an image:
+    const auto shard = miner.getShard();
+    ASSERT_EQ(shard.size(), settings.maxSamples);
+    EXPECT_EQ(shard.features, 10 * 4 * 4);
+    EXPECT_EQ(shard.values.size(), shard.size() * shard.features);
+    EXPECT_TRUE(std::is_sorted(shard.scores.rbegin(), shard.scores.rend()));
+    EXPECT_EQ(shard.scores.back(), miner.getMinimumScore());
+    for (std::size_t i = 0; i < shard.size(); i++)
+    {
+        EXPECT_GT(shard.scores[i], geometry.cascThr);
+        EXPECT_LE(std::count(shard.images.begin(), shard.images.end(), shard.images[i]), settings.perImage);
+        for (std::size_t j = i + 1; j < shard.size(); j++)
+        {
+            if (shard.images[i] == shard.images[j])
+            {
+                const auto& a = shard.rois[i];
+                const auto& b = shard.rois[j];
+                const float intersection = static_cast<float>((a & b).area());
+                EXPECT_LE(intersection / static_cast<float>(a.area() + b.area() - intersection), settings.overlap);
+            }
+        }
+    }
+}
+
+TEST(ObjectDetector, suppress) // NOLINT (TODO)
+{
+    // Crowded detections over a wide range of sizes:
+    cv::RNG rng(2);
+    std::vector<cv::Rect> objects;
+    std::vector<double> scores;
+    for (int i = 0; i < 2000; i++)
+    {
+        const int size = rng.uniform(8, 200);
+        objects.emplace_back(rng.uniform(0, 1000), rng.uniform(0, 800), size, size + rng.uniform(-4, 4));
+        scores.push_back(rng.uniform(0.0, 1.0));
+    }
+
+    for (auto isMinArea : { false, true })
+    {
+        // Pairwise reference in descending score order:
+        std::vector<int> order(objects.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+        std::vector<cv::Rect> expected;
+        for (auto i : order)
+        {
+            const auto& a = objects[i];
+            const bool isDuplicate = std::any_of(expected.begin(), expected.end(), [&](const cv::Rect& b) {
+                const double intersection = (a & b).area();
+                const double denominator = isMinArea ? std::min(a.area(), b.area()) : (a.area() + b.area() - intersection);
+                return intersection > (0.5 * denominator);
+            });
+            if (!isDuplicate)
+            {
+                expected.push_back(a);
+            }
+        }
+
+        auto kept = objects;
+        auto keptScores = scores;
+        drishti::ml::ObjectDetector::suppress(kept, keptScores, 0.5, 0, isMinArea);
+        EXPECT_EQ(kept, expected);
+
+        // Early exit after the strongest detections:
+        kept = objects;
+        keptScores = scores;
+        drishti::ml::ObjectDetector::suppress(kept, keptScores, 0.5, 10, isMinArea);
+        ASSERT_EQ(kept.size(), 10);
+        EXPECT_TRUE(std::equal(kept.begin(), kept.end(), expected.begin()));
+    }
+}
+
+TEST(ObjectDetectorACFTiled, getTiles) // NOLINT (TODO)
+{
+    using drishti::ml::ObjectDetectorACFTiled;
+
+    const cv::Size size(1000, 700);
+    const int tile = 256, margin = 48;
+    const auto tiles = ObjectDetectorACFTiled::getTiles(size, tile, margin);
+    ASSERT_EQ(tiles.size(), 4 * 3);
+
+    // Cores partition the image, each tile is padded within the image:
+    int area = 0;
+    for (const auto& t : tiles)
+    {
+        area += t.core.area();
+        EXPECT_EQ(t.roi & t.core, t.core);
+        EXPECT_EQ(t.roi & cv::Rect({ 0, 0 }, size), t.roi);
+    }
+    EXPECT_EQ(area, size.area());
+
+    // Objects up to 2x the margin have one owner, which sees them whole:
+    cv::RNG rng(3);
+    for (int i = 0; i < 2000; i++)
+    {
+        const int width = rng.uniform(8, 2 * margin + 1);
+        const cv::Rect object(rng.uniform(0, size.width - width), rng.uniform(0, size.height - width), width, width);
+
+        int owners = 0;
+        for (const auto& t : tiles)
+        {
+            if (ObjectDetectorACFTiled::isOwner(t, object, 2 * margin))
+            {
+                owners++;
+                EXPECT_EQ(t.roi & object, object);
+            }
+        }
+        EXPECT_EQ(owners, 1);
+    }
+
+    // Larger objects are left for the coarse pass:
+    EXPECT_FALSE(ObjectDetectorACFTiled::isOwner(tiles.front(), { 0, 0, 2 * margin + 1, 2 * margin + 1 }, 2 * margin));
+    EXPECT_TRUE(ObjectDetectorACFTiled::isOwner(tiles.front(), { 0, 0, 2 * margin + 1, 2 * margin + 1 }, 0));
+}
+
+// Frontal face with elliptical eyelid contours, openness is (minor / major)^2:
+static drishti::face::FaceModel createGateFace(float aspect, float yaw = 0.f)
+{
+    drishti::face::FaceModel face;
+    face.eyeRightCenter = cv::Point2f(100.f, 100.f);
+    face.eyeLeftCenter = cv::Point2f(200.f, 100.f);
+    face.noseTip = cv::Point2f(150.f + yaw * 100.f, 160.f);
+
+    std::vector<cv::Point> contour;
+    cv::ellipse2Poly(cv::Point(0, 0), cv::Size(100, static_cast<int>(100.f * aspect)), 0, 0, 360, 10, contour);
+
+    drishti::eye::EyeModel eye;
+    eye.eyelids.assign(contour.begin(), contour.end());
+    face.eyeFullR = eye + face.eyeRightCenter.value;
+    face.eyeFullL = eye + face.eyeLeftCenter.value;
+    return face;
+}
+
+TEST(DetectionScheduler, Triggers) // NOLINT (TODO)
+{
+    using drishti::hci::DetectionScheduler;
+
+    DetectionScheduler scheduler;
+    const double interval = 1.0;
+
+    auto face = [](const cv::Point2f& center, float ipd) {
+        drishti::face::FaceModel f;
+        f.eyeLeftCenter = center - cv::Point2f(ipd * 0.5f, 0.f);
+        f.eyeRightCenter = center + cv::Point2f(ipd * 0.5f, 0.f);
+        return f;
+    };
+
+    cv::Mat1b image(120, 160, uint8_t(64));
+    EXPECT_EQ(scheduler(0.0, interval, 0.0, false), DetectionScheduler::kInitial);
+    scheduler.update(image, { face({ 80.f, 60.f }, 20.f) }, true);
+
+    // Stable tracks in a static scene defer detection beyond the nominal interval:
+    scheduler.update(image, { face({ 80.f, 60.f }, 20.f) }, false);
+    EXPECT_EQ(scheduler(1.5 * interval, interval), DetectionScheduler::kNone);
+    EXPECT_EQ(scheduler(2.5 * interval, interval), DetectionScheduler::kInterval);
+
+    // Motion triggers early, but not before the minimum spacing:
+    image(cv::Rect(0, 0, 80, 120)).setTo(192);
+    scheduler.update(image, { face({ 80.f, 60.f }, 20.f) }, false);
+    EXPECT_EQ(scheduler(0.1 * interval, interval), DetectionScheduler::kNone);
+    EXPECT_EQ(scheduler(0.3 * interval, interval), DetectionScheduler::kMotion);
+
+    // A power floor applies to triggered detections:
+    scheduler.update(image, {}, false);
+    EXPECT_EQ(scheduler(0.3 * interval, interval, 0.5), DetectionScheduler::kNone);
+    EXPECT_EQ(scheduler(0.6 * interval, interval, 0.5), DetectionScheduler::kTrackLoss);
+
+    // Abrupt scale change of a tracked face:
+    scheduler.update(image, { face({ 80.f, 60.f }, 20.f) }, true);
+    scheduler.update(image, { face({ 82.f, 60.f }, 30.f) }, false);
+    EXPECT_EQ(scheduler(0.3 * interval, interval), DetectionScheduler::kUnstable);
+
+    const auto stats = scheduler.getStats();
+    EXPECT_EQ(stats.frames, 8);
+    EXPECT_EQ(stats.reasons[DetectionScheduler::kNone], 3);
+    EXPECT_EQ(stats.reasons[DetectionScheduler::kMotion], 1);
+}
+
+TEST(DeviceOrientation, Hysteresis) // NOLINT (TODO)
+{
+    using drishti::hci::DeviceOrientation;
+
+    auto gravity = [](float degrees) {
+        const float theta = degrees * static_cast<float>(CV_PI / 180.0);
+        return cv::Vec3f(-9.81f * std::sin(theta), -9.81f * std::cos(theta), 0.f);
+    };
+
+    DeviceOrientation orientation;
+    EXPECT_EQ(orientation(gravity(0.f)), 0);
+    EXPECT_EQ(orientation(gravity(55.f)), 0); // within the hysteresis band
+    EXPECT_EQ(orientation(gravity(65.f)), 90);
+    EXPECT_EQ(orientation(gravity(-170.f)), 180);
+    EXPECT_EQ(orientation(cv::Vec3f(0.5f, 0.f, -9.8f)), 180); // flat
+
+    DeviceOrientation::Settings settings;
+    settings.sensorOrientation = 270;
+    settings.direction = -1;
+    DeviceOrientation mounted(settings);
+    EXPECT_EQ(mounted(gravity(0.f)), 270);
+    EXPECT_EQ(mounted(gravity(90.f)), 180);
+    EXPECT_EQ(mounted.getRotation(), 90);
+}
+
+TEST(EyeGate, BlinkStateMachine) // NOLINT (TODO)
+{
+    using drishti::face::FaceDetector;
+
+    drishti::hci::EyeGate::Settings settings;
+    settings.closedFrames = 3;
+    settings.probeInterval = 2;
+    drishti::hci::EyeGate gate(settings);
+
+    // Eyes are segmented at the requested level, skipped faces carry no eye models:
+    auto step = [&](float aspect, float yaw = 0.f) {
+        auto face = createGateFace(aspect, yaw);
+        const auto mode = gate(face);
+        if (mode == FaceDetector::kEyeSkip)
+        {
+            face.eyeFullR.has = false;
+            face.eyeFullL.has = false;
+        }
+        gate.update({ face });
+        return mode;
+    };
+
+    const float open = 0.5f, closed = 0.2f;
+    EXPECT_EQ(step(open), FaceDetector::kEyeFull);
+    EXPECT_EQ(step(closed), FaceDetector::kEyeFull);    // blink onset
+    EXPECT_EQ(step(closed), FaceDetector::kEyeEyelids); // kBlink
+    EXPECT_EQ(step(closed), FaceDetector::kEyeEyelids); // -> kClosed
+    EXPECT_EQ(step(closed), FaceDetector::kEyeSkip);
+    EXPECT_EQ(step(open), FaceDetector::kEyeEyelids); // probe sees the reopening
+    EXPECT_EQ(step(open), FaceDetector::kEyeFull);
+    EXPECT_EQ(step(open, 1.f), FaceDetector::kEyeSkip); // head turned away
+
+    const auto stats = gate.getStats();
+    EXPECT_EQ(stats.blinks, 1);
+    EXPECT_EQ(stats.away, 1);
+    EXPECT_EQ(stats.full + stats.eyelids + stats.skipped, 8);
+}
+
+#if DRISHTI_HCI_WITH_BLOBS
+TEST(BlobFilterCpu, CompactPeaks) // NOLINT (TODO)
+{
+    // Two specular reflections, the second one outside of the region of interest:
+    cv::Mat1b gray(64, 96, uint8_t(64));
+    gray(18, 21) = 255;
+    gray(40, 70) = 255;
+
+    drishti::hci::BlobFilterCpu filter;
+    const cv::Mat4b& peaks = filter(gray, { cv::Rect(8, 8, 32, 24) });
+    const int cell = filter.getCellSize();
+    ASSERT_EQ(peaks.size(), cv::Size(96 / cell, 64 / cell));
+
+    // Decoded with the GPU compact peak protocol (see EyeBlobJob::run()):
+    std::vector<cv::Point> points;
+    for (int y = 0; y < peaks.rows; y++)
+    {
+        for (int x = 0; x < peaks.cols; x++)
+        {
+            const cv::Vec4b& pixel = peaks(y, x);
+            if (pixel[3] > 64)
+            {
+                const int dx = static_cast<int>(std::floor(static_cast<float>(pixel[0]) * cell / 255.f));
+                const int dy = static_cast<int>(std::floor(static_cast<float>(pixel[1]) * cell / 255.f));
+                points.emplace_back(x * cell + dx, y * cell + dy);
+            }
+        }
+    }
+
+    ASSERT_EQ(points.size(), 1u);
+    EXPECT_EQ(points.front(), cv::Point(21, 18));
+}
+#endif // DRISHTI_HCI_WITH_BLOBS
+
+// Frontal face with 16 point eyelid contours (corners at 0 and 8) and iris centers offset by d:
+static drishti::face::FaceModel createGazeFace(const cv::Point2f& d)
+{
+    drishti::face::FaceModel face;
+    face.eyeRightCenter = cv::Point2f(100.f, 100.f);
+    face.eyeLeftCenter = cv::Point2f(200.f, 100.f);
+    face.noseTip = cv::Point2f(150.f, 160.f); // GazeEstimator::Settings::headCenter
+
+    drishti::eye::EyeModel eye;
+    for (int i = 0; i < 16; i++)
+    {
+        const float theta = static_cast<float>(CV_PI) * static_cast<float>(i) / 8.f;
+        eye.eyelids.emplace_back(20.f * std::cos(theta), 8.f * std::sin(theta));
+    }
+    eye.irisEllipse = cv::RotatedRect(d, { 10.f, 10.f }, 0.f);
+    face.eyeFullR = eye + face.eyeRightCenter.value;
+    face.eyeFullL = eye + face.eyeLeftCenter.value;
+    return face;
+}
+
+TEST(GazeEstimator, CalibratedGaze) // NOLINT (TODO)
+{
+    drishti::hci::GazeEstimator estimator;
+
+    // Frontal head, centered irises: looking at the camera
+    auto gaze = estimator(createGazeFace({ 0.f, 0.f }));
+    ASSERT_TRUE(gaze.hasEyes[0] && gaze.hasEyes[1]);
+    EXPECT_NEAR(gaze.directions[0][2], -1.f, 1e-5f);
+    EXPECT_NEAR(gaze.angles[1].x, 0.f, 1e-5f);
+
+    // Iris displacement (eye width units) rotates the gaze:
+    gaze = estimator(createGazeFace({ 4.f, 0.f }));
+    EXPECT_NEAR(gaze.angles[0].x, std::asin(0.1f * 2.4f), 1e-4f);
+    EXPECT_GT(gaze.directions[0][0], 0.f);
+
+    // Affine calibration from a few fixations:
+    ASSERT_FALSE(estimator.calibrate());
+    auto target = [](const cv::Point2f& a) { return cv::Point2f(a.x * 1.5f + 0.1f, a.y * 0.5f - 0.05f); };
+    for (const auto& d : { cv::Point2f(-4.f, -2.f), cv::Point2f(4.f, -2.f), cv::Point2f(0.f, 2.f), cv::Point2f(2.f, 0.f) })
+    {
+        const auto sample = estimator(createGazeFace(d));
+        estimator.addCalibrationSample(sample, target(sample.angles[0]));
+    }
+    ASSERT_TRUE(estimator.calibrate());
+
+    const auto raw = gaze.angles[0];
+    gaze = estimator(createGazeFace({ 4.f, 0.f }));
+    EXPECT_NEAR(gaze.angles[0].x, target(raw).x, 1e-4f);
+    EXPECT_NEAR(gaze.angles[0].y, target(raw).y, 1e-4f);
+}
+
+TEST(PowerPolicy, PressurePlan) // NOLINT (TODO)
+{
+    using drishti::hci::PowerPolicy;
+
+    PowerPolicy::Settings settings;
+    settings.interval = 1.0f;
+    settings.eyeStride = 4;
+    settings.threads = 1;
+    settings.pipelineDepth = 2;
+    PowerPolicy policy(settings);
+
+    PowerPolicy::Plan nominal;
+    nominal.interval = 0.2;
+    nominal.pipelineDepth = 3;
+
+    // Nominal device: the configured plan
+    PowerPolicy::State state;
+    auto plan = policy(state, nominal);
+    EXPECT_EQ(plan.pressure, 0.f);
+    EXPECT_DOUBLE_EQ(plan.interval, 0.2);
+    EXPECT_EQ(plan.eyeStride, 1);
+    EXPECT_EQ(plan.threads, 0);
+    EXPECT_EQ(plan.pipelineDepth, 3);
+
+    // The battery level only counts when unplugged:
+    state.battery = 0.05f;
+    EXPECT_EQ(policy.getPressure(state), 0.f);
+    state.charging = false;
+    EXPECT_FLOAT_EQ(policy.getPressure(state), 0.75f);
+
+    // Critical thermal state: the most conservative plan
+    state.thermal = 1.f;
+    plan = policy(state, nominal);
+    EXPECT_EQ(plan.pressure, 1.f);
+    EXPECT_DOUBLE_EQ(plan.interval, 1.0);
+    EXPECT_EQ(plan.eyeStride, 4);
+    EXPECT_EQ(plan.threads, 1);
+    EXPECT_EQ(plan.pipelineDepth, 2);
+}
+
+TEST(DeviceProfile, SelectTier) // NOLINT (TODO)
+{
+    using drishti::hci::DeviceProfile;
+
+    std::stringstream ss;
+    ss << R"({
+        "profiles" : [
+            { "name" : "high", "variant" : "full", "limits" : { "gpu_acf" : 12, "regression" : 3 } },
+            { "name" : "mid", "variant" : "pruned", "limits" : { "gpu_acf" : 25 }, "interval" : 0.1 },
+            { "name" : "low", "variant" : "small", "optimized_pipeline" : false, "interval" : 0.25 }
+        ]
+    })";
+    const auto table = DeviceProfile::load(ss);
+    ASSERT_EQ(table.size(), std::size_t(3));
+
+    DeviceProfile::Measurements measurements;
+    measurements.gpuAcf = 10.0;
+    measurements.cpuAcf = 30.0;
+    measurements.regression = 2.0;
+    EXPECT_EQ(DeviceProfile::select(table, measurements).name, "high");
+
+    // A slow regression drops a tier:
+    measurements.regression = 6.0;
+    auto profile = DeviceProfile::select(table, measurements);
+    EXPECT_EQ(profile.name, "mid");
+    EXPECT_EQ(profile.variant, "pruned");
+    EXPECT_FLOAT_EQ(profile.faceFinderInterval, 0.1f);
+    EXPECT_FALSE(profile.doCpuAcf);
+
+    // The last row is the fallback, and it uses the faster (CPU) ACF path:
+    measurements.gpuAcf = 60.0;
+    profile = DeviceProfile::select(table, measurements);
+    EXPECT_EQ(profile.name, "low");
+    EXPECT_FALSE(profile.doOptimizedPipeline);
+    EXPECT_TRUE(profile.doCpuAcf);
+
+    // Cached measurements are tied to the device:
+    const std::string filename = "device_profile.json";
+    ASSERT_TRUE(DeviceProfile::saveMeasurements(filename, "device", measurements));
+    DeviceProfile::Measurements cached;
+    EXPECT_FALSE(DeviceProfile::loadMeasurements(filename, "other", cached));
+    ASSERT_TRUE(DeviceProfile::loadMeasurements(filename, "device", cached));
+    EXPECT_DOUBLE_EQ(cached.gpuAcf, measurements.gpuAcf);
+    EXPECT_DOUBLE_EQ(cached.regression, measurements.regression);
+    EXPECT_LT(cached.readback, 0.0);
+    std::remove(filename.c_str());
+}
+
+TEST(FaceHistory, RingQuery) // NOLINT (TODO)
+{
+    using drishti::hci::FaceHistory;
+
+    FaceHistory::Settings settings;
+    settings.depth = 0.5;
+    settings.capacity = 8;
+    settings.maxTracks = 2;
+    FaceHistory history(settings);
+
+    // Two tracks at 30 Hz, the second one leaves the scene after 4 frames:
+    const auto start = FaceHistory::TimePoint();
+    const auto at = [&](int i) { return start + std::chrono::microseconds(i * 33333); };
+    for (int i = 0; i < 20; i++)
+    {
+        std::vector<drishti::face::FaceModel> faces(1);
+        std::vector<std::size_t> tracks = { 7 };
+        faces[0].noseTip = cv::Point2f(static_cast<float>(i), 0.f);
+        if (i < 4)
+        {
+            faces.emplace_back();
+            tracks.push_back(9);
+        }
+        history.update(faces, tracks, at(i), static_cast<std::uint64_t>(i));
+    }
+
+    // The ring wraps, and holds the most recent samples in time order:
+    const auto all = history.query(7);
+    ASSERT_EQ(all.size(), 8);
+    EXPECT_EQ(all.front().frameIndex, 12);
+    EXPECT_EQ(all.back().frameIndex, 19);
+    int expected = 12;
+    for (const auto& sample : all)
+    {
+        EXPECT_EQ(sample.face.noseTip->x, static_cast<float>(expected++));
+    }
+
+    // Time range queries are inclusive:
+    const auto range = history.query(7, at(14), at(16));
+    ASSERT_EQ(range.size(), 3);
+    EXPECT_EQ(range.front().frameIndex, 14);
+    EXPECT_EQ(range.back().frameIndex, 16);
+    EXPECT_TRUE(history.query(7, at(30), at(40)).empty());
+
+    // Tracks expire after the depth, and the number of tracks is bounded:
+    EXPECT_TRUE(history.query(9).empty());
+    EXPECT_EQ(history.getTracks(), std::vector<std::size_t>{ 7 });
+    for (std::size_t track : { 1, 2, 3 })
+    {
+        history.append(track, {}, at(20), 20);
+    }
+    EXPECT_EQ(history.getTracks().size(), 2);
+    EXPECT_TRUE(history.query(7).empty()); // least recently updated
+}
+
+TEST(FaceMonitor, RequestFormatUnion) // NOLINT (TODO)
+{
+    using Request = drishti::hci::FaceMonitor::Request;
+
+    Request native{ 2, true, false };
+    ASSERT_TRUE(native.isNative());
+
+    Request gray{ 1, true, false };
+    gray.format = Request::kGray;
+    gray.size = { 320, 0 };
+    ASSERT_FALSE(gray.isNative());
+
+    // The first non-native format is kept, frame counts are merged:
+    Request request = native;
+    request |= gray;
+    EXPECT_EQ(request.n, 2);
+    EXPECT_EQ(request.format, Request::kGray);
+    EXPECT_EQ(request.size, cv::Size(320, 0));
+
+    Request i420 = gray;
+    i420.format = Request::kI420;
+    request |= i420;
+    EXPECT_EQ(request.format, Request::kGray);
+}
+
+TEST(FaceMonitorDispatcher, Schedule) // NOLINT (TODO)
+{
+    using drishti::hci::FaceMonitor;
+
+    struct Listener : public FaceMonitor
+    {
+        explicit Listener(int n)
+            : n(n)
+        {
+        }
+        Request request(const Faces& faces, const TimePoint& timeStamp, std::uint32_t tex) override
+        {
+            requests++;
+            return { n, false, true };
+        }
+        void grab(const std::vector<FaceImage>& frames, bool isInitialized) override
+        {
+            grabs++;
+            frameCount += static_cast<int>(frames.size());
+            threads.insert(std::this_thread::get_id());
+        }
+        int n = 0;
+        std::atomic<int> requests{ 0 }, grabs{ 0 }, frameCount{ 0 };
+        std::set<std::thread::id> threads;
+    };
+
+    Listener display(1), analytics(3), recorder(2);
+    const auto start = FaceMonitor::HighResolutionClock::now();
+    const int frames = 30;
+    {
+        drishti::hci::FaceMonitorDispatcher dispatcher;
+        dispatcher.add(&display);
+
+        FaceMonitor::Schedule rate;
+        rate.maxRate = 5.0;
+        dispatcher.add(&analytics, rate);
+
+        FaceMonitor::Schedule async;
+        async.isAsync = true;
+        dispatcher.add(&recorder, async);
+
+        for (int i = 0; i < frames; i++)
+        {
+            const auto time = start + std::chrono::microseconds(i * 33333);
+            const auto request = dispatcher.request({}, time, 0);
+            EXPECT_EQ(request.n, ((i % 6) == 0) ? 3 : 2); // one merged readback
+            dispatcher.grab(std::vector<FaceMonitor::FaceImage>(request.n), true);
+            dispatcher.flush();
+        }
+    }
+
+    EXPECT_EQ(display.requests, frames);
+    EXPECT_EQ(display.frameCount, frames * 1);
+
+    EXPECT_EQ(analytics.requests, frames / 6);
+    EXPECT_EQ(analytics.grabs, frames / 6);
+    EXPECT_EQ(analytics.frameCount, (frames / 6) * 3);
+
+    EXPECT_EQ(recorder.grabs, frames);
+    EXPECT_EQ(recorder.threads.size(), 1);
+    EXPECT_EQ(recorder.threads.count(std::this_thread::get_id()), 0);
+}
+
 END_EMPTY_NAMESPACE
@@ -0,0 +1,427 @@
+/*! -*-c++-*-
+  @file   AcfCascade.cpp
+  @author David Hirvonen
+  @brief  Implementation of a batched ACF soft cascade evaluator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/AcfCascade.h"
+#include "drishti/core/cpu.h" // core::hasSimd()
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// clang-format off
+#if DRISHTI_CPU_NEON
+#  include <arm_neon.h>
+#  define DO_ARM_NEON 1
+#endif
+// clang-format on
+
+// clang-format off
+#if DRISHTI_CPU_X86
+#  include <immintrin.h>
+#  define DO_SSE4_1 1 // runtime dispatch (see core::hasSimd())
+#endif
+// clang-format on
+
+#if DO_ARM_NEON
+#  define DO_ACF_SIMD 1
+#  define ACF_SIMD_FEATURE core::kSimdNEON
+#elif DO_SSE4_1
+#  define DO_ACF_SIMD 1
+#  define ACF_SIMD_FEATURE core::kSimdSSE41
+#else
+#  define DO_ACF_SIMD 0
+#  define ACF_SIMD_FEATURE core::kSimdFeatureCount
+#endif
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+// Depth 2 trees (7 nodes) for 4 windows at once.  Rejected windows stop accumulating,
+// and the scan stops early when all 4 are rejected; the return value is the first tree
+// left for the survivors.
+#if DO_ARM_NEON
+static int scanDepth2_neon(const float* const* nodes, const float* thrs, const float* hs, int stages, float cascThr, const int* o, float* h, std::uint32_t* alive)
+{
+    float32x4_t hv = vdupq_n_f32(0.f);
+    uint32x4_t live = vdupq_n_u32(0xffffffff);
+    const float32x4_t thrv = vdupq_n_f32(cascThr);
+
+    int t = 0;
+    for (; t < stages; t++)
+    {
+        const float* const* nd = nodes + t * 7;
+        const float* th = thrs + t * 7;
+        const float* hh = hs + t * 7;
+
+        const float f0[4] = { nd[0][o[0]], nd[0][o[1]], nd[0][o[2]], nd[0][o[3]] };
+        const uint32x4_t m0 = vcltq_f32(vld1q_f32(f0), vdupq_n_f32(th[0])); // left: node 1
+
+        const float f1[4] = {
+            nd[vgetq_lane_u32(m0, 0) ? 1 : 2][o[0]],
+            nd[vgetq_lane_u32(m0, 1) ? 1 : 2][o[1]],
+            nd[vgetq_lane_u32(m0, 2) ? 1 : 2][o[2]],
+            nd[vgetq_lane_u32(m0, 3) ? 1 : 2][o[3]]
+        };
+        const float32x4_t t1 = vbslq_f32(m0, vdupq_n_f32(th[1]), vdupq_n_f32(th[2]));
+        const uint32x4_t m1 = vcltq_f32(vld1q_f32(f1), t1);
+
+        const float32x4_t hl = vbslq_f32(m1, vdupq_n_f32(hh[3]), vdupq_n_f32(hh[4]));
+        const float32x4_t hr = vbslq_f32(m1, vdupq_n_f32(hh[5]), vdupq_n_f32(hh[6]));
+        hv = vbslq_f32(live, vaddq_f32(hv, vbslq_f32(m0, hl, hr)), hv);
+        live = vandq_u32(live, vcgtq_f32(hv, thrv));
+
+        const uint32x2_t any = vorr_u32(vget_low_u32(live), vget_high_u32(live));
+        if (!(vget_lane_u32(any, 0) | vget_lane_u32(any, 1)))
+        {
+            break;
+        }
+    }
+
+    vst1q_f32(h, hv);
+    vst1q_u32(alive, live);
+    return t;
+}
+#endif
+
+#if DO_SSE4_1
+DRISHTI_TARGET("sse4.1")
+static int scanDepth2_sse(const float* const* nodes, const float* thrs, const float* hs, int stages, float cascThr, const int* o, float* h, std::uint32_t* alive)
+{
+    __m128 hv = _mm_setzero_ps();
+    __m128 live = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    const __m128 thrv = _mm_set1_ps(cascThr);
+
+    int t = 0;
+    for (; t < stages; t++)
+    {
+        const float* const* nd = nodes + t * 7;
+        const float* th = thrs + t * 7;
+        const float* hh = hs + t * 7;
+
+        const __m128 f0 = _mm_setr_ps(nd[0][o[0]], nd[0][o[1]], nd[0][o[2]], nd[0][o[3]]);
+        const __m128 m0 = _mm_cmplt_ps(f0, _mm_set1_ps(th[0])); // left: node 1
+
+        const int bits = _mm_movemask_ps(m0);
+        const __m128 f1 = _mm_setr_ps(
+            nd[(bits & 1) ? 1 : 2][o[0]],
+            nd[(bits & 2) ? 1 : 2][o[1]],
+            nd[(bits & 4) ? 1 : 2][o[2]],
+            nd[(bits & 8) ? 1 : 2][o[3]]);
+        const __m128 t1 = _mm_blendv_ps(_mm_set1_ps(th[2]), _mm_set1_ps(th[1]), m0);
+        const __m128 m1 = _mm_cmplt_ps(f1, t1);
+
+        const __m128 hl = _mm_blendv_ps(_mm_set1_ps(hh[4]), _mm_set1_ps(hh[3]), m1);
+        const __m128 hr = _mm_blendv_ps(_mm_set1_ps(hh[6]), _mm_set1_ps(hh[5]), m1);
+        hv = _mm_blendv_ps(hv, _mm_add_ps(hv, _mm_blendv_ps(hr, hl, m0)), live);
+        live = _mm_and_ps(live, _mm_cmpgt_ps(hv, thrv));
+
+        if (!_mm_movemask_ps(live))
+        {
+            break;
+        }
+    }
+
+    _mm_storeu_ps(h, hv);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(alive), _mm_castps_si128(live));
+    return t;
+}
+#endif
+
+AcfCascade::AcfCascade(acf::Detector& detector, int simdStages)
+    : m_simdStages(simdStages)
+{
+    // Trees are stored as (nodes x trees) matrices, thresholds include the cascCal offset
+    // of a preceding acfModify():
+    const auto& clf = detector.clf;
+    cv::Mat1i fids, child;
+    cv::Mat1f thrs, hs;
+    clf.fids.convertTo(fids, CV_32S);
+    clf.child.convertTo(child, CV_32S);
+    clf.thrs.convertTo(thrs, CV_32F);
+    clf.hs.convertTo(hs, CV_32F);
+
+    m_trees.depth = clf.treeDepth;
+    m_trees.nodes = fids.rows;
+    for (int t = 0; t < fids.cols; t++)
+    {
+        for (int k = 0; k < fids.rows; k++)
+        {
+            m_trees.fids.push_back(static_cast<std::uint32_t>(fids(k, t)));
+            m_trees.child.push_back(static_cast<std::uint32_t>(child(k, t)));
+            m_trees.thrs.push_back(thrs(k, t));
+            m_trees.hs.push_back(hs(k, t));
+        }
+    }
+
+    auto& opts = detector.opts;
+    m_geometry.modelDs = opts.modelDs.get();
+    m_geometry.modelDsPad = opts.modelDsPad.get();
+    m_geometry.pad = opts.pPyramid->pad.get();
+    m_geometry.shrink = opts.pPyramid->pChns->shrink.get();
+    m_geometry.stride = opts.stride.get();
+    m_geometry.cascThr = static_cast<float>(opts.cascThr.get());
+    m_geometry.isTranspose = !detector.getIsRowMajor();
+}
+
+AcfCascade::AcfCascade(const Trees& trees, const Geometry& geometry, int simdStages)
+    : m_trees(trees)
+    , m_geometry(geometry)
+    , m_simdStages(simdStages)
+{
+}
+
+int AcfCascade::operator()(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>& scores) const
+{
+    std::vector<Window> windows;
+    for (int i = 0; i < P.nScales; i++)
+    {
+        MatP level = P.data[i][0]; // headers only
+        scan(level.get(), windows);
+        for (const auto& w : windows)
+        {
+            objects.push_back(getObject(P, i, w.u, w.v));
+            scores.push_back(w.h);
+        }
+    }
+
+    return objects.size();
+}
+
+// Window (u, v) of pyramid level i in image coordinates:
+cv::Rect AcfCascade::getObject(const acf::Detector::Pyramid& P, int i, int u, int v) const
+{
+    const auto& g = m_geometry;
+    const cv::Point2d shift(
+        (g.modelDsPad.width - g.modelDs.width) * 0.5 - g.pad.width,
+        (g.modelDsPad.height - g.modelDs.height) * 0.5 - g.pad.height);
+
+    const cv::Size size(int(g.modelDs.width / P.scales[i] + 0.5), int(g.modelDs.height / P.scales[i] + 0.5));
+    const int c = g.isTranspose ? u : v;
+    const int r = g.isTranspose ? v : u;
+    const double x = (c * g.stride + shift.x) / P.scaleshw[i].width;
+    const double y = (r * g.stride + shift.y) / P.scaleshw[i].height;
+    return { int(x + 0.5), int(y + 0.5), size.width, size.height };
+}
+
+// Tree node feature pointers and window positions for one level:
+bool AcfCascade::getLayout(const std::vector<cv::Mat>& planes, Layout& layout) const
+{
+    const auto& g = m_geometry;
+    const int nTrees = static_cast<int>(m_trees.hs.size()) / std::max(m_trees.nodes, 1);
+    if (planes.empty() || !nTrees)
+    {
+        return false;
+    }
+
+    // Window size in storage order (rows x cols) in pixels and channel units:
+    const cv::Size winPx = g.isTranspose ? cv::Size(g.modelDsPad.height, g.modelDsPad.width) : g.modelDsPad;
+    const cv::Size win(winPx.width / g.shrink, winPx.height / g.shrink);
+
+    const cv::Size size = planes[0].size();
+    layout.step = static_cast<int>(planes[0].step1());
+    for (const auto& plane : planes)
+    {
+        CV_Assert((plane.type() == CV_32F) && (plane.size() == size) && (static_cast<int>(plane.step1()) == layout.step));
+    }
+
+    layout.nu = static_cast<int>(std::ceil(float(size.height * g.shrink - winPx.height + 1) / float(g.stride)));
+    layout.nv = static_cast<int>(std::ceil(float(size.width * g.shrink - winPx.width + 1) / float(g.stride)));
+    if ((layout.nu <= 0) || (layout.nv <= 0))
+    {
+        return false;
+    }
+
+    // Feature ids index the stacked channel planes of one window in storage order:
+    const int area = win.area();
+    layout.nodes.resize(m_trees.fids.size());
+    for (std::size_t k = 0; k < layout.nodes.size(); k++)
+    {
+        const int fid = static_cast<int>(m_trees.fids[k]);
+        const int z = fid / area, u = (fid % area) / win.width, v = (fid % area) % win.width;
+        CV_Assert(z < static_cast<int>(planes.size()));
+        layout.nodes[k] = planes[z].ptr<float>(u) + v;
+    }
+
+    layout.columns.resize(layout.nv);
+    for (int j = 0; j < layout.nv; j++)
+    {
+        layout.columns[j] = (j * g.stride) / g.shrink;
+    }
+    return true;
+}
+
+void AcfCascade::scan(const std::vector<cv::Mat>& planes, std::vector<Window>& windows) const
+{
+    windows.clear();
+
+    Layout layout;
+    if (!getLayout(planes, layout))
+    {
+        return;
+    }
+
+    const auto& g = m_geometry;
+    const int nTrees = static_cast<int>(m_trees.hs.size()) / m_trees.nodes;
+    const int nu = layout.nu, nv = layout.nv, step = layout.step;
+    const auto& nodes = layout.nodes;
+    const auto& columns = layout.columns;
+
+    // SIMD prefix for fixed depth 2 trees:
+    const bool doSimd = DO_ACF_SIMD && core::hasSimd(ACF_SIMD_FEATURE) && (m_trees.depth == 2) && (m_trees.nodes == 7) && (m_simdStages > 0);
+    const int stages = std::min(m_simdStages, nTrees);
+
+    std::vector<int> offsets(nv);
+    for (int i = 0; i < nu; i++)
+    {
+        const int row = ((i * g.stride) / g.shrink) * step;
+        for (int j = 0; j < nv; j++)
+        {
+            offsets[j] = row + columns[j];
+        }
+
+        int j = 0;
+#if DO_ACF_SIMD
+        if (doSimd)
+        {
+            for (; j <= (nv - 4); j += 4)
+            {
+                float h[4];
+                std::uint32_t alive[4];
+#if DO_ARM_NEON
+                const int t = scanDepth2_neon(nodes.data(), m_trees.thrs.data(), m_trees.hs.data(), stages, g.cascThr, &offsets[j], h, alive);
+#else
+                const int t = scanDepth2_sse(nodes.data(), m_trees.thrs.data(), m_trees.hs.data(), stages, g.cascThr, &offsets[j], h, alive);
+#endif
+                // Compact the survivors and finish them one at a time:
+                for (int k = 0; k < 4; k++)
+                {
+                    if (alive[k])
+                    {
+                        const float score = finish(nodes.data(), offsets[j + k], t, h[k]);
+                        if (score > g.cascThr)
+                        {
+                            windows.push_back({ i, j + k, score });
+                        }
+                    }
+                }
+            }
+        }
+#endif
+        for (; j < nv; j++)
+        {
+            const float score = finish(nodes.data(), offsets[j], 0, 0.f);
+            if (score > g.cascThr)
+            {
+                windows.push_back({ i, j, score });
+            }
+        }
+    }
+}
+
+void AcfCascade::trace(const std::vector<cv::Mat>& planes, float floor, float finalFloor, std::vector<Trace>& traces) const
+{
+    traces.clear();
+
+    Layout layout;
+    if (!getLayout(planes, layout))
+    {
+        return;
+    }
+
+    const int n = m_trees.nodes;
+    const int nTrees = static_cast<int>(m_trees.hs.size()) / n;
+    for (int i = 0; i < layout.nu; i++)
+    {
+        const int row = ((i * m_geometry.stride) / m_geometry.shrink) * layout.step;
+        for (int j = 0; j < layout.nv; j++)
+        {
+            const int offset = row + layout.columns[j];
+
+            float h = 0.f, minimum = std::numeric_limits<float>::max();
+            int t = 0;
+            for (; t < nTrees; t++)
+            {
+                h += m_trees.hs[t * n + getLeaf(layout.nodes.data() + t * n, offset, t)];
+                if (t == (nTrees - 1))
+                {
+                    break;
+                }
+                minimum = std::min(minimum, h);
+                if (h <= floor)
+                {
+                    break;
+                }
+            }
+
+            if ((t == (nTrees - 1)) && (h > finalFloor))
+            {
+                traces.push_back({ i, j, minimum, h });
+            }
+        }
+    }
+}
+
+int AcfCascade::trace(const acf::Detector::Pyramid& P, float floor, float finalFloor, std::vector<cv::Rect>& objects, std::vector<Trace>& traces) const
+{
+    std::vector<Trace> level;
+    for (int i = 0; i < P.nScales; i++)
+    {
+        MatP planes = P.data[i][0]; // headers only
+        trace(planes.get(), floor, finalFloor, level);
+        for (const auto& w : level)
+        {
+            objects.push_back(getObject(P, i, w.u, w.v));
+            traces.push_back(w);
+        }
+    }
+
+    return objects.size();
+}
+
+// Leaf index of tree t for one window:
+int AcfCascade::getLeaf(const float* const* nd, int offset, int t) const
+{
+    const int n = m_trees.nodes;
+    const float* th = m_trees.thrs.data() + t * n;
+    int k = 0;
+    if (m_trees.depth > 0)
+    {
+        for (int d = 0; d < m_trees.depth; d++)
+        {
+            k = (k * 2) + ((nd[k][offset] < th[k]) ? 1 : 2);
+        }
+    }
+    else
+    {
+        const std::uint32_t* child = m_trees.child.data() + t * n;
+        while (child[k])
+        {
+            k = static_cast<int>(child[k]) - ((nd[k][offset] < th[k]) ? 1 : 0);
+        }
+    }
+    return k;
+}
+
+// Evaluate trees [tree, nTrees) for one window (acfDetect1), stopping at the first rejection:
+float AcfCascade::finish(const float* const* nodes, int offset, int tree, float h) const
+{
+    const int n = m_trees.nodes;
+    const int nTrees = static_cast<int>(m_trees.hs.size()) / n;
+    for (int t = tree; t < nTrees; t++)
+    {
+        h += m_trees.hs[t * n + getLeaf(nodes + t * n, offset, t)];
+        if (h <= m_geometry.cascThr)
+        {
+            break;
+        }
+    }
+    return h;
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,122 @@
+/*! -*-c++-*-
+  @file   AcfCascade.h
+  @author David Hirvonen
+  @brief  Declaration of a batched ACF soft cascade evaluator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The boosted trees of an acf::Detector are flattened and evaluated over groups of
+  adjacent windows.  Most windows are rejected within the first few trees, so the first
+  simdStages trees of depth 2 cascades are evaluated 4 windows at a time (NEON/SSE);
+  the surviving windows are compacted and finish the cascade one at a time.  The SIMD
+  and scalar kernels perform the same single precision additions in the same order, so
+  they accept the same windows with bit-identical scores.
+
+*/
+
+#ifndef __drishti_ml_AcfCascade_h__
+#define __drishti_ml_AcfCascade_h__
+
+#include "drishti/ml/drishti_ml.h"
+
+#include <acf/ACF.h>
+
+#include <opencv2/core/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class AcfCascade
+{
+public:
+    // Trees in tree major order (node k of tree t is at t * nodes + k):
+    struct Trees
+    {
+        int depth = 2; // fixed depth (implicit binary tree), 0 for variable depth (child links)
+        int nodes = 0; // nodes per tree
+        std::vector<std::uint32_t> fids;
+        std::vector<float> thrs;
+        std::vector<std::uint32_t> child;
+        std::vector<float> hs;
+    };
+
+    // Detection window geometry in image orientation (pixels):
+    struct Geometry
+    {
+        cv::Size modelDs;
+        cv::Size modelDsPad;
+        cv::Size pad;
+        int shrink = 4;
+        int stride = 4;
+        float cascThr = -1.f;
+        bool isTranspose = false; // column major channel storage
+    };
+
+    // Accepted window: position in window steps along the storage rows and columns + score:
+    struct Window
+    {
+        int u, v;
+        float h;
+    };
+
+    // Unrejected window for threshold sweeps: the smallest partial sum before the last tree
+    // and the final score.  A cascade with cascThr T and an extra cascCal C (added to the last
+    // tree leaves, see acfModify()) accepts the window iff minimum > T and h + C > T:
+    struct Trace
+    {
+        int u, v;
+        float minimum;
+        float h;
+    };
+
+    AcfCascade() = default;
+    explicit AcfCascade(acf::Detector& detector, int simdStages = 16);
+    AcfCascade(const Trees& trees, const Geometry& geometry, int simdStages = 16);
+
+    // Scan every level, as acf::Detector::operator()(Pyramid) without suppression:
+    int operator()(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>& scores) const;
+
+    // Scan all windows of one level (CV_32F channel planes in storage order):
+    void scan(const std::vector<cv::Mat>& planes, std::vector<Window>& windows) const;
+
+    // Scan without the cascade threshold: windows are rejected at or below floor (before the
+    // last tree) and finalFloor (last tree), which must be <= the swept values:
+    void trace(const std::vector<cv::Mat>& planes, float floor, float finalFloor, std::vector<Trace>& traces) const;
+    int trace(const acf::Detector::Pyramid& P, float floor, float finalFloor, std::vector<cv::Rect>& objects, std::vector<Trace>& traces) const;
+
+    // Window (u, v) of pyramid level i in image coordinates:
+    cv::Rect getObject(const acf::Detector::Pyramid& P, int i, int u, int v) const;
+
+    void setSimdStages(int stages) { m_simdStages = stages; }
+    int getSimdStages() const { return m_simdStages; }
+
+    const Trees& getTrees() const { return m_trees; }
+    const Geometry& getGeometry() const { return m_geometry; }
+
+    // Standalone cascades (e.g., see AcfDistiller) are stored without the acf::Detector:
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int version);
+
+protected:
+    struct Layout
+    {
+        std::vector<const float*> nodes; // feature pointer per tree node (window origin)
+        std::vector<int> columns;        // channel column per window column
+        int nu = 0, nv = 0, step = 0;
+    };
+
+    bool getLayout(const std::vector<cv::Mat>& planes, Layout& layout) const;
+    int getLeaf(const float* const* nodes, int offset, int tree) const;
+    float finish(const float* const* nodes, int offset, int tree, float h) const;
+
+    Trees m_trees;
+    Geometry m_geometry;
+    int m_simdStages = 16;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_AcfCascade_h__
@@ -0,0 +1,51 @@
+/*! -*-c++-*-
+  @file   AcfCascadeArchiveCereal.cpp
+  @author David Hirvonen
+  @brief  Serialization of standalone ACF soft cascades.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/drishti_cv_cereal.h"
+
+#include "drishti/ml/AcfCascade.h"
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+template <class Archive>
+void AcfCascade::serialize(Archive& ar, const unsigned int version)
+{
+    ar& GENERIC_NVP("depth", m_trees.depth);
+    ar& GENERIC_NVP("nodes", m_trees.nodes);
+    ar& GENERIC_NVP("fids", m_trees.fids);
+    ar& GENERIC_NVP("thrs", m_trees.thrs);
+    ar& GENERIC_NVP("child", m_trees.child);
+    ar& GENERIC_NVP("hs", m_trees.hs);
+
+    ar& GENERIC_NVP("modelDs", m_geometry.modelDs);
+    ar& GENERIC_NVP("modelDsPad", m_geometry.modelDsPad);
+    ar& GENERIC_NVP("pad", m_geometry.pad);
+    ar& GENERIC_NVP("shrink", m_geometry.shrink);
+    ar& GENERIC_NVP("stride", m_geometry.stride);
+    ar& GENERIC_NVP("cascThr", m_geometry.cascThr);
+    ar& GENERIC_NVP("isTranspose", m_geometry.isTranspose);
+
+    ar& GENERIC_NVP("simdStages", m_simdStages);
+}
+
+// ##################################################################
+// #################### portable_binary_*archive ####################
+// ##################################################################
+
+using OArchive = cereal::PortableBinaryOutputArchive;
+template void AcfCascade::serialize<OArchive>(OArchive& ar, const unsigned int);
+
+using IArchive = cereal::PortableBinaryInputArchive;
+template void AcfCascade::serialize<IArchive>(IArchive& ar, const unsigned int);
+
+DRISHTI_ML_NAMESPACE_END
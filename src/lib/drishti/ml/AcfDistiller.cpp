@@ -0,0 +1,291 @@
+/*! -*-c++-*-
+  @file   AcfDistiller.cpp
+  @author David Hirvonen
+  @brief  Implementation of a soft label trainer for smaller ACF soft cascades.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/AcfDistiller.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+// splitmix64 (deterministic for a seed on every platform):
+static std::uint64_t nextRandom(std::uint64_t& state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Window size in channel units, in storage order (see AcfCascade::scan()):
+static cv::Size getWindowSize(const AcfCascade::Geometry& g)
+{
+    const cv::Size winPx = g.isTranspose ? cv::Size(g.modelDsPad.height, g.modelDsPad.width) : g.modelDsPad;
+    return { winPx.width / g.shrink, winPx.height / g.shrink };
+}
+
+AcfDistiller::AcfDistiller(acf::Detector& teacher, const Settings& settings)
+    : m_settings(settings)
+    , m_teacher(teacher, 0)
+    , m_state(settings.seed)
+{
+    auto geometry = m_teacher.getGeometry();
+    geometry.cascThr = -std::numeric_limits<float>::max();
+    m_teacherNoStop = AcfCascade(m_teacher.getTrees(), geometry, 0);
+}
+
+AcfDistiller::~AcfDistiller() = default;
+
+std::size_t AcfDistiller::getAcceptedCount() const
+{
+    return std::count(m_accepted.begin(), m_accepted.end(), 1);
+}
+
+bool AcfDistiller::add(const acf::Detector::Pyramid& P)
+{
+    const float lower = m_teacher.getGeometry().cascThr - m_settings.margin;
+    const int negatives = std::max(m_settings.negatives / std::max(P.nScales, 1), 1);
+
+    std::vector<AcfCascade::Window> windows, accepted;
+    for (int i = 0; (i < P.nScales) && (m_labels.size() < m_settings.maxWindows); i++)
+    {
+        MatP level = P.data[i][0]; // headers only
+        const std::vector<cv::Mat>& planes = level.get();
+        m_teacherNoStop.scan(planes, windows);
+        m_teacher.scan(planes, accepted);
+
+        // Both scans are in raster order:
+        std::vector<std::size_t> easy;
+        auto a = accepted.begin();
+        for (std::size_t j = 0; (j < windows.size()) && (m_labels.size() < m_settings.maxWindows); j++)
+        {
+            const auto& w = windows[j];
+            while ((a != accepted.end()) && std::make_pair(a->u, a->v) < std::make_pair(w.u, w.v))
+            {
+                a++;
+            }
+
+            const bool isAccepted = (a != accepted.end()) && (a->u == w.u) && (a->v == w.v);
+            if (isAccepted || (w.h > lower))
+            {
+                addWindow(planes, w, isAccepted);
+            }
+            else
+            {
+                easy.push_back(j);
+            }
+        }
+
+        for (int j = 0; (j < negatives) && !easy.empty() && (m_labels.size() < m_settings.maxWindows); j++)
+        {
+            const std::size_t k = nextRandom(m_state) % easy.size();
+            addWindow(planes, windows[easy[k]], false);
+            easy[k] = easy.back();
+            easy.pop_back();
+        }
+    }
+
+    return m_labels.size() < m_settings.maxWindows;
+}
+
+void AcfDistiller::addWindow(const std::vector<cv::Mat>& planes, const AcfCascade::Window& window, bool accepted)
+{
+    const auto& g = m_teacher.getGeometry();
+    const cv::Size win = getWindowSize(g);
+    const int area = win.area();
+    if (!m_features)
+    {
+        m_features = static_cast<int>(planes.size()) * area;
+    }
+    CV_Assert(m_features == static_cast<int>(planes.size()) * area);
+
+    // Feature ids index the stacked channel planes of one window (see AcfCascade::scan()):
+    const int row = (window.u * g.stride) / g.shrink;
+    const int col = (window.v * g.stride) / g.shrink;
+    for (int fid = 0; fid < m_features; fid++)
+    {
+        const int z = fid / area, u = (fid % area) / win.width, v = (fid % area) % win.width;
+        m_values.push_back(planes[z].ptr<float>(row + u)[col + v]);
+    }
+
+    // Far negatives only need to be rejected, their exact scores don't matter:
+    m_labels.push_back(std::max(window.h, m_teacher.getGeometry().cascThr - m_settings.margin));
+    m_accepted.push_back(accepted ? 1 : 0);
+}
+
+std::unique_ptr<AcfCascade> AcfDistiller::train()
+{
+    const int N = static_cast<int>(m_labels.size());
+    const int F = m_features;
+    const int bins = 256;
+    CV_Assert(N > 0);
+
+    // Feature major 8 bit bins over the range of each feature:
+    std::vector<float> lower(F, std::numeric_limits<float>::max()), step(F, 1.f);
+    std::vector<std::uint8_t> quantized(std::size_t(N) * F);
+    {
+        std::vector<float> upper(F, -std::numeric_limits<float>::max());
+        for (int n = 0; n < N; n++)
+        {
+            const float* x = &m_values[std::size_t(n) * F];
+            for (int f = 0; f < F; f++)
+            {
+                lower[f] = std::min(lower[f], x[f]);
+                upper[f] = std::max(upper[f], x[f]);
+            }
+        }
+
+        for (int f = 0; f < F; f++)
+        {
+            step[f] = (upper[f] > lower[f]) ? ((upper[f] - lower[f]) / bins) : 1.f;
+            for (int n = 0; n < N; n++)
+            {
+                const int bin = static_cast<int>((m_values[std::size_t(n) * F + f] - lower[f]) / step[f]);
+                quantized[std::size_t(f) * N + n] = static_cast<std::uint8_t>(std::min(std::max(bin, 0), bins - 1));
+            }
+        }
+    }
+
+    AcfCascade::Trees trees;
+    trees.depth = std::max(m_settings.depth, 1);
+    trees.nodes = (1 << (trees.depth + 1)) - 1;
+    const int internal = (1 << trees.depth) - 1;
+
+    std::vector<float> prediction(N, 0.f), residual(m_labels);
+    std::vector<float> minimum(N, std::numeric_limits<float>::max()); // smallest partial sum (soft cascade)
+    for (int t = 0; t < m_settings.trees; t++)
+    {
+        const std::size_t base = trees.hs.size();
+        trees.fids.resize(base + trees.nodes, 0);
+        trees.thrs.resize(base + trees.nodes, 0.f);
+        trees.child.resize(base + trees.nodes, 0);
+        trees.hs.resize(base + trees.nodes, 0.f);
+
+        std::vector<std::vector<int>> members(trees.nodes);
+        members[0].resize(N);
+        std::iota(members[0].begin(), members[0].end(), 0);
+
+        for (int k = 0; k < trees.nodes; k++)
+        {
+            const auto& index = members[k];
+
+            double sum = 0.0;
+            for (const auto& n : index)
+            {
+                sum += residual[n];
+            }
+            trees.hs[base + k] = index.empty() ? 0.f : static_cast<float>(m_settings.shrinkage * sum / index.size());
+
+            if (k >= internal)
+            {
+                continue; // leaf
+            }
+
+            // Best threshold bin for each random feature (left: value < threshold):
+            std::vector<int> candidates(m_settings.candidates);
+            for (auto& f : candidates)
+            {
+                f = static_cast<int>(nextRandom(m_state) % F);
+            }
+
+            std::vector<std::pair<double, int>> scores(candidates.size(), { -1.0, 0 });
+            if (index.size() > 1)
+            {
+                core::ParallelHomogeneousLambda harness = [&](int c) {
+                    std::vector<double> sums(bins, 0.0);
+                    std::vector<int> counts(bins, 0);
+                    const std::uint8_t* x = &quantized[std::size_t(candidates[c]) * N];
+                    for (const auto& n : index)
+                    {
+                        sums[x[n]] += residual[n];
+                        counts[x[n]]++;
+                    }
+
+                    double left = 0.0;
+                    int leftCount = 0;
+                    for (int b = 1; b < bins; b++)
+                    {
+                        left += sums[b - 1];
+                        leftCount += counts[b - 1];
+                        const int rightCount = static_cast<int>(index.size()) - leftCount;
+                        if (leftCount && rightCount && counts[b - 1])
+                        {
+                            const double right = sum - left;
+                            const double score = left * left / leftCount + right * right / rightCount;
+                            if (score > scores[c].first)
+                            {
+                                scores[c] = { score, b };
+                            }
+                        }
+                    }
+                };
+                cv::parallel_for_({ 0, static_cast<int>(candidates.size()) }, harness);
+            }
+
+            std::size_t best = 0;
+            for (std::size_t c = 1; c < scores.size(); c++)
+            {
+                if (scores[c].first > scores[best].first)
+                {
+                    best = c;
+                }
+            }
+
+            const int f = candidates[best];
+            const float threshold = (scores[best].first < 0.0) ? std::numeric_limits<float>::max() : (lower[f] + scores[best].second * step[f]);
+            trees.fids[base + k] = static_cast<std::uint32_t>(f);
+            trees.thrs[base + k] = threshold;
+            trees.child[base + k] = static_cast<std::uint32_t>(2 * k + 2); // left child is child - 1
+
+            // Route with the runtime comparison (not the bins):
+            for (const auto& n : index)
+            {
+                const bool isLeft = m_values[std::size_t(n) * F + f] < threshold;
+                members[isLeft ? (2 * k + 1) : (2 * k + 2)].push_back(n);
+            }
+        }
+
+        for (int k = internal; k < trees.nodes; k++)
+        {
+            for (const auto& n : members[k])
+            {
+                prediction[n] += trees.hs[base + k];
+                residual[n] = m_labels[n] - prediction[n];
+                minimum[n] = std::min(minimum[n], prediction[n]);
+            }
+        }
+    }
+
+    // A window survives the soft cascade if every partial sum is above the threshold:
+    AcfCascade::Geometry geometry = m_teacher.getGeometry();
+    std::vector<float> survivors;
+    for (int n = 0; n < N; n++)
+    {
+        if (m_accepted[n])
+        {
+            survivors.push_back(minimum[n]);
+        }
+    }
+    if (!survivors.empty())
+    {
+        std::sort(survivors.begin(), survivors.end());
+        const auto lost = static_cast<std::size_t>((1.f - m_settings.recall) * survivors.size());
+        const float value = survivors[std::min(lost, survivors.size() - 1)];
+        geometry.cascThr = std::nextafter(value, -std::numeric_limits<float>::max());
+    }
+
+    return drishti::core::make_unique<AcfCascade>(trees, geometry);
+}
+
+DRISHTI_ML_NAMESPACE_END
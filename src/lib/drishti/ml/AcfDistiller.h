@@ -0,0 +1,80 @@
+/*! -*-c++-*-
+  @file   AcfDistiller.h
+  @author David Hirvonen
+  @brief  Declaration of a soft label trainer for smaller ACF soft cascades.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  A student cascade with fewer (and/or shallower) trees is fit to the scores of an
+  existing detector (the teacher) on the channel features of the teacher's pyramids, so
+  no ground truth is needed and logged frames can be used as training data.  Every
+  window the teacher scores within a margin of its rejection threshold is kept (the
+  informative ones), plus a random sample of the easy negatives.  The student is boosted
+  with a squared loss on the (clamped) teacher scores, using 256 bin feature histograms,
+  and its rejection threshold is calibrated to keep a fraction of the windows that the
+  teacher accepts.  The student uses the teacher's window geometry and channels, and is
+  evaluated by AcfCascade (see ObjectDetectorACF::setCascade()).
+
+*/
+
+#ifndef __drishti_ml_AcfDistiller_h__
+#define __drishti_ml_AcfDistiller_h__
+
+#include "drishti/ml/drishti_ml.h"
+#include "drishti/ml/AcfCascade.h"
+
+#include <acf/ACF.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class AcfDistiller
+{
+public:
+    struct Settings
+    {
+        int trees = 128;              // student weak learners
+        int depth = 2;                // student tree depth
+        float shrinkage = 0.5f;       // learning rate
+        int candidates = 256;         // random features evaluated per split
+        float margin = 4.f;           // keep every window with a teacher score > cascThr - margin
+        int negatives = 256;          // random easier windows per pyramid
+        std::size_t maxWindows = 50000; // memory: maxWindows * features * 5 bytes
+        float recall = 0.995f;        // fraction of the teacher's accepted windows the student accepts
+        std::uint64_t seed = 0;
+    };
+
+    AcfDistiller(acf::Detector& teacher, const Settings& settings);
+    ~AcfDistiller();
+
+    // Label the windows of one pyramid (computed by the teacher) with the teacher scores,
+    // returns false when maxWindows have been collected:
+    bool add(const acf::Detector::Pyramid& P);
+
+    std::size_t size() const { return m_labels.size(); }
+    std::size_t getAcceptedCount() const;
+
+    // Fit the student and calibrate its rejection threshold:
+    std::unique_ptr<AcfCascade> train();
+
+protected:
+    void addWindow(const std::vector<cv::Mat>& planes, const AcfCascade::Window& window, bool accepted);
+
+    Settings m_settings;
+    AcfCascade m_teacher;        // teacher trees and rejection threshold
+    AcfCascade m_teacherNoStop;  // teacher trees without rejection (full scores)
+
+    int m_features = 0;              // channel values per window
+    std::vector<float> m_values;     // [window * m_features + fid]
+    std::vector<float> m_labels;     // teacher scores
+    std::vector<std::uint8_t> m_accepted; // windows that pass the teacher cascade
+    std::uint64_t m_state = 0;       // random number generator
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_AcfDistiller_h__
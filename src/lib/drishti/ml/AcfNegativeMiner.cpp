@@ -0,0 +1,185 @@
+/*! -*-c++-*-
+  @file   AcfNegativeMiner.cpp
+  @author David Hirvonen
+  @brief  Implementation of a hard negative miner for ACF detector retraining.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/AcfNegativeMiner.h"
+
+#include <algorithm>
+#include <limits>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+static float overlap(const cv::Rect& a, const cv::Rect& b)
+{
+    const float intersection = static_cast<float>((a & b).area());
+    return intersection / static_cast<float>(a.area() + b.area() - intersection);
+}
+
+AcfNegativeMiner::AcfNegativeMiner(acf::Detector& detector, const Settings& settings)
+    : AcfNegativeMiner(AcfCascade(detector, 0), settings)
+{
+}
+
+AcfNegativeMiner::AcfNegativeMiner(const AcfCascade& cascade, const Settings& settings)
+    : m_settings(settings)
+{
+    auto geometry = cascade.getGeometry();
+    geometry.cascThr -= std::max(settings.margin, 0.f);
+    m_cascade = AcfCascade(cascade.getTrees(), geometry);
+    m_heap.reserve(settings.maxSamples);
+}
+
+AcfNegativeMiner::~AcfNegativeMiner() = default;
+
+int AcfNegativeMiner::add(std::uint32_t image, const acf::Detector::Pyramid& P)
+{
+    // Scan every level without holding the lock:
+    std::vector<Candidate> candidates;
+    std::vector<AcfCascade::Window> windows;
+    for (int i = 0; i < P.nScales; i++)
+    {
+        MatP level = P.data[i][0]; // headers only
+        m_cascade.scan(level.get(), windows);
+        for (const auto& w : windows)
+        {
+            candidates.push_back({ i, w.u, w.v, w.h, m_cascade.getObject(P, i, w.u, w.v) });
+        }
+    }
+    const std::size_t found = candidates.size();
+
+    // Greedy de-duplication, hardest first:
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+    std::vector<Candidate> kept;
+    for (const auto& c : candidates)
+    {
+        if ((m_settings.perImage > 0) && (static_cast<int>(kept.size()) >= m_settings.perImage))
+        {
+            break;
+        }
+        if (std::none_of(kept.begin(), kept.end(), [&](const Candidate& k) { return overlap(k.roi, c.roi) > m_settings.overlap; }))
+        {
+            kept.push_back(c);
+        }
+    }
+
+    // Windows weaker than a full heap are skipped before their features are copied:
+    const float minimum = getMinimumScore();
+    std::vector<Sample> samples;
+    for (const auto& c : kept)
+    {
+        if (c.score > minimum)
+        {
+            MatP level = P.data[c.level][0];
+            samples.push_back({ c.score, image, c.roi, {} });
+            getFeatures(level.get(), c, samples.back().features);
+        }
+    }
+
+    // Min-heap, the weakest window is at the front:
+    const auto compare = [](const Sample& a, const Sample& b) { return a.score > b.score; };
+
+    int count = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_images++;
+    m_candidates += found;
+    for (auto& sample : samples)
+    {
+        if (m_heap.size() < m_settings.maxSamples)
+        {
+            m_heap.push_back(std::move(sample));
+            std::push_heap(m_heap.begin(), m_heap.end(), compare);
+            count++;
+        }
+        else if (!m_heap.empty() && (sample.score > m_heap.front().score))
+        {
+            std::pop_heap(m_heap.begin(), m_heap.end(), compare);
+            m_heap.back() = std::move(sample);
+            std::push_heap(m_heap.begin(), m_heap.end(), compare);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Feature ids index the stacked channel planes of one window (see AcfCascade::scan()):
+void AcfNegativeMiner::getFeatures(const std::vector<cv::Mat>& planes, const Candidate& candidate, std::vector<float>& features) const
+{
+    const auto& g = m_cascade.getGeometry();
+    const cv::Size winPx = g.isTranspose ? cv::Size(g.modelDsPad.height, g.modelDsPad.width) : g.modelDsPad;
+    const cv::Size win(winPx.width / g.shrink, winPx.height / g.shrink);
+    const int area = win.area();
+
+    const int row = (candidate.u * g.stride) / g.shrink;
+    const int col = (candidate.v * g.stride) / g.shrink;
+    features.resize(planes.size() * area);
+    for (std::size_t fid = 0; fid < features.size(); fid++)
+    {
+        const int z = static_cast<int>(fid) / area, u = (static_cast<int>(fid) % area) / win.width, v = (static_cast<int>(fid) % area) % win.width;
+        features[fid] = planes[z].ptr<float>(row + u)[col + v];
+    }
+}
+
+std::size_t AcfNegativeMiner::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_heap.size();
+}
+
+std::size_t AcfNegativeMiner::getImageCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_images;
+}
+
+std::size_t AcfNegativeMiner::getCandidateCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_candidates;
+}
+
+float AcfNegativeMiner::getMinimumScore() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ((m_heap.size() < m_settings.maxSamples) || m_heap.empty())
+    {
+        return -std::numeric_limits<float>::max();
+    }
+    return m_heap.front().score;
+}
+
+AcfNegativeMiner::Shard AcfNegativeMiner::getShard() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<const Sample*> order;
+    for (const auto& sample : m_heap)
+    {
+        order.push_back(&sample);
+    }
+    std::sort(order.begin(), order.end(), [](const Sample* a, const Sample* b) { return a->score > b->score; });
+
+    const auto& g = m_cascade.getGeometry();
+    Shard shard;
+    shard.modelDsPad = g.modelDsPad;
+    shard.shrink = g.shrink;
+    shard.isTranspose = g.isTranspose;
+    shard.features = order.empty() ? 0 : static_cast<int>(order.front()->features.size());
+    shard.values.reserve(order.size() * shard.features);
+    for (const auto* sample : order)
+    {
+        shard.values.insert(shard.values.end(), sample->features.begin(), sample->features.end());
+        shard.scores.push_back(sample->score);
+        shard.rois.push_back(sample->roi);
+        shard.images.push_back(sample->image);
+    }
+    return shard;
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,110 @@
+/*! -*-c++-*-
+  @file   AcfNegativeMiner.h
+  @author David Hirvonen
+  @brief  Declaration of a hard negative miner for ACF detector retraining.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  The cascade of an existing detector scans the pyramids of face free images and every
+  window it scores above its rejection threshold (less a margin) is a hard negative.  The
+  windows of one image are de-duplicated (greedy, by IoU) and the hardest perImage are
+  kept, then merged into a bounded min-heap of the hardest maxSamples windows overall, so
+  memory doesn't grow with the size of the negative set.  add() may be called from several
+  threads (one pyramid per call).  The channel features of each window are stored in the
+  feature order of the model trees (see AcfCascade::Trees::fids), so a shard can be passed
+  to the trainer without the images.
+
+*/
+
+#ifndef __drishti_ml_AcfNegativeMiner_h__
+#define __drishti_ml_AcfNegativeMiner_h__
+
+#include "drishti/ml/drishti_ml.h"
+#include "drishti/ml/AcfCascade.h"
+
+#include <acf/ACF.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class AcfNegativeMiner
+{
+public:
+    struct Settings
+    {
+        float margin = 0.f;               // keep windows with a score > cascThr - margin (0: false positives)
+        int perImage = 32;                // hardest windows per image after de-duplication (0: all)
+        std::size_t maxSamples = 20000;   // memory: maxSamples * features * 4 bytes
+        float overlap = 0.5f;             // IoU of a weaker duplicate window in the same image
+    };
+
+    // Hardest windows first (see getShard()):
+    struct Shard
+    {
+        cv::Size modelDsPad;          // window geometry (image orientation) ...
+        int shrink = 4;
+        bool isTranspose = false;     // ... and channel storage order of the model
+        int features = 0;             // channel values per window
+        std::vector<float> values;    // [sample * features + fid]
+        std::vector<float> scores;    // cascade scores
+        std::vector<cv::Rect> rois;   // image coordinates
+        std::vector<std::uint32_t> images; // caller's image indices
+
+        std::size_t size() const { return scores.size(); }
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version);
+    };
+
+    AcfNegativeMiner(acf::Detector& detector, const Settings& settings);
+    AcfNegativeMiner(const AcfCascade& cascade, const Settings& settings);
+    ~AcfNegativeMiner();
+
+    AcfNegativeMiner(const AcfNegativeMiner&) = delete;
+    AcfNegativeMiner& operator=(const AcfNegativeMiner&) = delete;
+
+    // Mine the pyramid (computed by the detector) of one negative image, returns the number
+    // of windows of this image that entered the heap (thread safe):
+    int add(std::uint32_t image, const acf::Detector::Pyramid& P);
+
+    std::size_t size() const;
+    std::size_t getImageCount() const;
+    std::size_t getCandidateCount() const; // windows above the threshold (before de-duplication)
+    float getMinimumScore() const;          // weakest window in a full heap
+
+    Shard getShard() const;
+
+protected:
+    struct Sample
+    {
+        float score;
+        std::uint32_t image;
+        cv::Rect roi;
+        std::vector<float> features;
+    };
+
+    struct Candidate
+    {
+        int level, u, v;
+        float score;
+        cv::Rect roi;
+    };
+
+    void getFeatures(const std::vector<cv::Mat>& planes, const Candidate& candidate, std::vector<float>& features) const;
+
+    Settings m_settings;
+    AcfCascade m_cascade; // rejection threshold lowered by the margin
+
+    mutable std::mutex m_mutex;
+    std::vector<Sample> m_heap; // min-heap on score (weakest window at the front)
+    std::size_t m_images = 0;
+    std::size_t m_candidates = 0;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_AcfNegativeMiner_h__
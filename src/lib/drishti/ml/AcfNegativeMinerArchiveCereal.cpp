@@ -0,0 +1,43 @@
+/*! -*-c++-*-
+  @file   AcfNegativeMinerArchiveCereal.cpp
+  @author David Hirvonen
+  @brief  Serialization of mined ACF negative sample shards.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/core/drishti_core.h"
+#include "drishti/core/drishti_stdlib_string.h"
+#include "drishti/core/drishti_cereal_pba.h"
+#include "drishti/core/drishti_cv_cereal.h"
+
+#include "drishti/ml/AcfNegativeMiner.h"
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+template <class Archive>
+void AcfNegativeMiner::Shard::serialize(Archive& ar, const unsigned int version)
+{
+    ar& GENERIC_NVP("modelDsPad", modelDsPad);
+    ar& GENERIC_NVP("shrink", shrink);
+    ar& GENERIC_NVP("isTranspose", isTranspose);
+    ar& GENERIC_NVP("features", features);
+    ar& GENERIC_NVP("values", values);
+    ar& GENERIC_NVP("scores", scores);
+    ar& GENERIC_NVP("rois", rois);
+    ar& GENERIC_NVP("images", images);
+}
+
+// ##################################################################
+// #################### portable_binary_*archive ####################
+// ##################################################################
+
+using OArchive = cereal::PortableBinaryOutputArchive;
+template void AcfNegativeMiner::Shard::serialize<OArchive>(OArchive& ar, const unsigned int);
+
+using IArchive = cereal::PortableBinaryInputArchive;
+template void AcfNegativeMiner::Shard::serialize<IArchive>(IArchive& ar, const unsigned int);
+
+DRISHTI_ML_NAMESPACE_END
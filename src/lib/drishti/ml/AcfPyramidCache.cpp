@@ -0,0 +1,218 @@
+/*! -*-c++-*-
+  @file   AcfPyramidCache.cpp
+  @author David Hirvonen
+  @brief  Implementation of a frame keyed ACF channel pyramid cache and ROI search.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/AcfPyramidCache.h"
+#include "drishti/ml/ObjectDetector.h" // ObjectDetector::suppress()
+
+#include <algorithm>
+#include <cmath>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+static std::vector<int> selectLevels(const acf::Detector::Pyramid& P, const AcfSearchRegion& region, float winWidth);
+
+AcfPyramidCache::AcfPyramidCache(std::size_t capacity)
+    : m_capacity(std::max(capacity, std::size_t(1)))
+{
+}
+
+AcfPyramidCache::Key AcfPyramidCache::getKey(acf::Detector& detector, std::int64_t frame)
+{
+    Key key;
+    key.frame = frame;
+    key.shrink = detector.opts.pPyramid->pChns->shrink.get();
+    key.nPerOct = detector.opts.pPyramid->nPerOct.get();
+    key.isTranspose = !detector.getIsRowMajor();
+    return key;
+}
+
+void AcfPyramidCache::put(const Key& key, const Entry& entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&](const std::pair<Key, Entry>& e) { return e.first == key; });
+    if (iter != m_entries.end())
+    {
+        m_entries.erase(iter);
+    }
+
+    m_entries.emplace_front(key, entry);
+    if (m_entries.size() > m_capacity)
+    {
+        m_entries.pop_back();
+    }
+}
+
+bool AcfPyramidCache::get(const Key& key, Entry& entry) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&](const std::pair<Key, Entry>& e) { return e.first == key; });
+    if (iter != m_entries.end())
+    {
+        entry = iter->second;
+        return true;
+    }
+    return false;
+}
+
+AcfPyramidCache::Entry AcfPyramidCache::acquire(const Key& key, const std::function<float(Pyramid& P)>& compute)
+{
+    Entry entry;
+    if (get(key, entry))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hits++;
+        return entry;
+    }
+
+    // Compute outside the lock, other frames and keys remain available meanwhile:
+    auto P = std::make_shared<Pyramid>();
+    entry.scale = compute(*P);
+    entry.P = P;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_misses++;
+        auto iter = std::find_if(m_entries.begin(), m_entries.end(), [&](const std::pair<Key, Entry>& e) { return e.first == key; });
+        if (iter != m_entries.end())
+        {
+            return iter->second; // a concurrent miss finished first
+        }
+    }
+
+    put(key, entry);
+    return entry;
+}
+
+void AcfPyramidCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+std::size_t AcfPyramidCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+std::size_t AcfPyramidCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_misses;
+}
+
+int detectAcfRegions(acf::Detector& detector, const acf::Detector::Pyramid& P, const std::vector<AcfSearchRegion>& regions, std::vector<cv::Rect>& objects, std::vector<double>& scores, double overlap)
+{
+    objects.clear();
+    scores.clear();
+
+    // Pyramid levels are stored in (shrunk) channel coordinates, possibly transposed:
+    const bool isRowMajor = detector.getIsRowMajor();
+    auto winSize = detector.getWindowSize();
+    if (!isRowMajor)
+    {
+        std::swap(winSize.width, winSize.height);
+    }
+
+    const int shrink = detector.opts.pPyramid->pChns->shrink.get();
+    for (const auto& region : regions)
+    {
+        const cv::Rect2f search(region.roi);
+        for (auto i : selectLevels(P, region, static_cast<float>(winSize.width)))
+        {
+            const float s = static_cast<float>(P.scales[i]) / static_cast<float>(shrink); // detection->channel
+
+            cv::Size levelSize = P.data[i][0][0].size();
+            if (!isRowMajor)
+            {
+                std::swap(levelSize.width, levelSize.height);
+            }
+
+            // The crop must contain at least one full detection window:
+            const cv::Size minSize(winSize.width / shrink + 1, winSize.height / shrink + 1);
+            const cv::Point2f c((search.x + search.width * 0.5f) * s, (search.y + search.height * 0.5f) * s);
+            const cv::Size size(std::max(int(search.width * s + 0.5f), minSize.width), std::max(int(search.height * s + 0.5f), minSize.height));
+            const cv::Rect crop = cv::Rect({ int(c.x) - size.width / 2, int(c.y) - size.height / 2 }, size) & cv::Rect({ 0, 0 }, levelSize);
+            if ((crop.width < minSize.width) || (crop.height < minSize.height))
+            {
+                continue;
+            }
+
+            const cv::Rect storage = isRowMajor ? crop : cv::Rect(crop.y, crop.x, crop.height, crop.width);
+
+            // Single level pyramid over the crop (cheap header copies, then small deep copies):
+            acf::Detector::Pyramid Q = P;
+            Q.nScales = 1;
+            Q.scales = { P.scales[i] };
+            Q.scaleshw = { P.scaleshw[i] };
+            Q.data = { P.data[i] };
+            for (auto& channels : Q.data[0])
+            {
+                for (auto& plane : channels.get())
+                {
+                    plane = plane(storage).clone();
+                }
+            }
+
+            std::vector<cv::Rect> found;
+            std::vector<double> foundScores;
+            detector(Q, found, &foundScores);
+
+            // Map crop relative detections back to the detection image:
+            const cv::Point offset(int(crop.x / s + 0.5f), int(crop.y / s + 0.5f));
+            for (int j = 0; j < found.size(); j++)
+            {
+                objects.push_back(found[j] + offset);
+                scores.push_back(foundScores[j]);
+            }
+        }
+    }
+
+    ObjectDetector::suppress(objects, scores, overlap);
+
+    return objects.size();
+}
+
+// Return the (up to) maxLevels levels at which objects in the width range fill the window:
+static std::vector<int> selectLevels(const acf::Detector::Pyramid& P, const AcfSearchRegion& region, float winWidth)
+{
+    const float width = std::sqrt(region.minWidth * region.maxWidth);
+
+    std::vector<std::pair<float, int>> errors;
+    for (int i = 0; i < P.nScales; i++)
+    {
+        errors.emplace_back(std::abs(std::log(width * static_cast<float>(P.scales[i]) / winWidth)), i);
+    }
+    std::sort(errors.begin(), errors.end());
+
+    std::vector<int> levels;
+    if (region.minWidth < region.maxWidth)
+    {
+        for (const auto& e : errors)
+        {
+            const float levelWidth = winWidth / static_cast<float>(P.scales[e.second]);
+            if ((levelWidth >= region.minWidth) && (levelWidth <= region.maxWidth) && (static_cast<int>(levels.size()) < region.maxLevels))
+            {
+                levels.push_back(e.second);
+            }
+        }
+    }
+
+    if (levels.empty())
+    {
+        for (int i = 0; i < std::min(region.maxLevels, static_cast<int>(errors.size())); i++)
+        {
+            levels.push_back(errors[i].second);
+        }
+    }
+    return levels;
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,103 @@
+/*! -*-c++-*-
+  @file   AcfPyramidCache.h
+  @author David Hirvonen
+  @brief  Declaration of a frame keyed ACF channel pyramid cache and ROI search.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Several ACF models (face, eye, ...) trained with the same channel parameters can be
+  evaluated on one pyramid.  The cache holds the pyramids of the most recent frames,
+  keyed by frame index and channel parameters, so that the first model to see a frame
+  computes (or publishes) the pyramid and the others reuse it.
+
+*/
+
+#ifndef __drishti_ml_AcfPyramidCache_h__
+#define __drishti_ml_AcfPyramidCache_h__
+
+#include "drishti/ml/drishti_ml.h"
+
+#include <acf/ACF.h>
+
+#include <opencv2/core/core.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class AcfPyramidCache
+{
+public:
+    using Pyramid = acf::Detector::Pyramid;
+
+    // Channel parameters that determine the pyramid contents and storage order:
+    struct Key
+    {
+        std::int64_t frame = -1;
+        int shrink = 4;
+        int nPerOct = 8;
+        bool isTranspose = false; // column major storage
+
+        bool operator==(const Key& other) const
+        {
+            return (frame == other.frame) && (shrink == other.shrink) && (nPerOct == other.nPerOct) && (isTranspose == other.isTranspose);
+        }
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<const Pyramid> P;
+        float scale = 1.f; // frame -> pyramid base image (e.g., a reduced detection image)
+    };
+
+    explicit AcfPyramidCache(std::size_t capacity = 2);
+
+    static Key getKey(acf::Detector& detector, std::int64_t frame);
+
+    // Publish a pyramid computed elsewhere (e.g., the GPU face detection pyramid):
+    void put(const Key& key, const Entry& entry);
+
+    bool get(const Key& key, Entry& entry) const;
+
+    // Return the cached pyramid or compute it on a miss (compute() returns the frame ->
+    // pyramid scale).  Concurrent misses for the same key may both compute, the first
+    // result is kept.
+    Entry acquire(const Key& key, const std::function<float(Pyramid& P)>& compute);
+
+    void clear();
+
+    std::size_t getHits() const;
+    std::size_t getMisses() const;
+
+protected:
+    std::size_t m_capacity = 2;
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+    std::deque<std::pair<Key, Entry>> m_entries; // most recent first
+    mutable std::mutex m_mutex;
+};
+
+// Search region in pyramid base image coordinates with the range of plausible object
+// (detection box) widths.  Up to maxLevels levels inside the range are evaluated, nearest
+// to the middle of the range first; a degenerate range selects the maxLevels nearest levels.
+struct AcfSearchRegion
+{
+    cv::Rect roi;
+    float minWidth = 0.f;
+    float maxWidth = 0.f;
+    int maxLevels = 2;
+};
+
+// Evaluate the detector on pyramid crops covering each region and suppress duplicates
+// reported by overlapping regions and adjacent levels:
+int detectAcfRegions(acf::Detector& detector, const acf::Detector::Pyramid& P, const std::vector<AcfSearchRegion>& regions, std::vector<cv::Rect>& objects, std::vector<double>& scores, double overlap = 0.5);
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_AcfPyramidCache_h__
@@ -36,6 +36,7 @@ using namespace std;
 #include "xgboost/src/learner/objective-inl.hpp"
 
 #include "drishti/core/Logger.h"
+#include "drishti/ml/TreeEnsemble.h"
 
 #include <random>
 #include <iostream>
@@ -143,6 +144,47 @@ DMatrixSimpleFromMat(const MatrixType<float>& data, bst_ulong nrow, bst_ulong nc
     return p_mat;
 }
 
+// Strided dense rows with an optional (nrow x ncol) selection mask (no intermediate copies):
+inline std::shared_ptr<DMatrixSimple>
+DMatrixSimpleFromMat(const float* data, bst_ulong nrow, bst_ulong ncol, bst_ulong stride, const uint8_t* mask, bst_ulong maskStride)
+{
+    std::shared_ptr<DMatrixSimple> p_mat = std::make_shared<DMatrixSimple>();
+    DMatrixSimple& mat = *p_mat;
+    mat.info.info.num_row = nrow;
+    mat.info.info.num_col = ncol;
+    mat.row_data_.reserve(mask ? 0 : (nrow * ncol));
+    mat.row_ptr_.reserve(nrow + 1);
+    for (bst_ulong i = 0; i < nrow; ++i, data += stride)
+    {
+        const uint8_t* valid = mask ? (mask + i * maskStride) : nullptr;
+
+        bst_ulong nelem = 0;
+        for (bst_ulong j = 0; j < ncol; ++j)
+        {
+            if (!valid || valid[j])
+            {
+                mat.row_data_.emplace_back(bst_uint(j), data[j]);
+                ++nelem;
+            }
+        }
+        mat.row_ptr_.push_back(mat.row_ptr_.back() + nelem);
+    }
+    return p_mat;
+}
+
+// Pointer-to-member access to the protected GBTree model (trees are not otherwise exposed):
+struct GBTreeAccess : public gbm::GBTree
+{
+    static const std::vector<tree::RegTree*>& getTrees(const gbm::GBTree& gbtree)
+    {
+        return gbtree.*(&GBTreeAccess::trees);
+    }
+    static const std::vector<int>& getTreeInfo(const gbm::GBTree& gbtree)
+    {
+        return gbtree.*(&GBTreeAccess::tree_info);
+    }
+};
+
 DRISHTI_BEGIN_NAMESPACE(wrapper)
 
 // booster wrapper class
@@ -235,6 +277,105 @@ public:
 #endif
     }
 
+    /*
+     * Dense, DMatrix free prediction for gbtree models with a single output group
+     * (i.e., CPR stage regressors).  Leaf values are summed in tree order as in
+     * GBTree::Pred, followed by base_score and the objective transform, so the
+     * results match Predict().  NaN features follow the default branch (missing).
+     * Returns false (without output) for models that require the generic path.
+     */
+    inline bool PredictDense(const float* data, bst_ulong nrow, bst_ulong ncol, bst_ulong stride, float* out) const
+    {
+        const auto* gbtree = dynamic_cast<const gbm::GBTree*>(gbm_);
+        const bool linear = (name_obj_ == "reg:linear");
+        const bool logistic = (name_obj_ == "binary:logistic");
+        if (!gbtree || !(linear || logistic))
+        {
+            return false;
+        }
+
+        const auto& trees = GBTreeAccess::getTrees(*gbtree);
+        const auto& info = GBTreeAccess::getTreeInfo(*gbtree);
+        if (std::any_of(info.begin(), info.end(), [](int group) { return group != 0; }))
+        {
+            return false;
+        }
+
+        for (bst_ulong i = 0; i < nrow; ++i, data += stride)
+        {
+            float psum = 0.0f;
+            for (const auto* tree : trees)
+            {
+                int nid = 0;
+                while (!(*tree)[nid].is_leaf())
+                {
+                    const auto& node = (*tree)[nid];
+                    const unsigned split = node.split_index();
+                    const float value = (split < ncol) ? data[split] : NAN;
+                    if (utils::CheckNAN(value))
+                    {
+                        nid = node.cdefault();
+                    }
+                    else
+                    {
+                        nid = (value < node.split_cond()) ? node.cleft() : node.cright();
+                    }
+                }
+                psum += (*tree)[nid].leaf_value();
+            }
+
+            const float margin = psum + mparam.base_score;
+            out[i] = logistic ? (1.0f / (1.0f + std::exp(-margin))) : margin;
+        }
+        return true;
+    }
+
+    // Convert supported models (see PredictDense) to the native fixed depth format:
+    inline bool Compile(drishti::ml::TreeEnsemble& ensemble) const
+    {
+        const auto* gbtree = dynamic_cast<const gbm::GBTree*>(gbm_);
+        const bool linear = (name_obj_ == "reg:linear");
+        const bool logistic = (name_obj_ == "binary:logistic");
+        if (!gbtree || !(linear || logistic))
+        {
+            return false;
+        }
+
+        const auto& info = GBTreeAccess::getTreeInfo(*gbtree);
+        if (std::any_of(info.begin(), info.end(), [](int group) { return group != 0; }))
+        {
+            return false;
+        }
+
+        std::vector<drishti::ml::TreeEnsemble::Tree> trees;
+        for (const auto* tree : GBTreeAccess::getTrees(*gbtree))
+        {
+            drishti::ml::TreeEnsemble::Tree nodes(tree->param.num_nodes);
+            for (int nid = 0; nid < tree->param.num_nodes; nid++)
+            {
+                const auto& node = (*tree)[nid];
+                auto& dst = nodes[nid];
+                dst.leaf = node.is_leaf();
+                if (dst.leaf)
+                {
+                    dst.value = node.leaf_value();
+                }
+                else
+                {
+                    dst.feature = int(node.split_index());
+                    dst.value = node.split_cond();
+                    dst.defaultLeft = node.default_left();
+                    dst.left = node.cleft();
+                    dst.right = node.cright();
+                }
+            }
+            trees.push_back(std::move(nodes));
+        }
+
+        const auto objective = logistic ? drishti::ml::TreeEnsemble::kLogistic : drishti::ml::TreeEnsemble::kLinear;
+        return ensemble.create(trees, mparam.base_score, objective);
+    }
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
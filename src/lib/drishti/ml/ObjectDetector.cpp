@@ -13,7 +13,9 @@
 #include "drishti/ml/drishti_ml.h"
 #include "drishti/ml/ObjectDetector.h"
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
@@ -58,4 +60,104 @@ void ObjectDetector::prune(std::vector<cv::Rect>& objects, std::vector<double>&
     }
 }
 
+void ObjectDetector::suppress(std::vector<cv::Rect>& objects, std::vector<double>& scores, double overlap, std::size_t maxCount, bool isMinArea)
+{
+    CV_Assert(objects.size() == scores.size());
+    if (objects.empty())
+    {
+        return;
+    }
+
+    const int n = static_cast<int>(objects.size());
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+    // Grid cells of the median detection size.  Kept detections are registered in every cell
+    // they cover, so overlapping detections always share at least one cell:
+    cv::Rect bounds = objects[0];
+    std::vector<int> sizes(n);
+    for (int i = 0; i < n; i++)
+    {
+        bounds |= objects[i];
+        sizes[i] = std::max(objects[i].width, objects[i].height);
+    }
+    std::nth_element(sizes.begin(), sizes.begin() + n / 2, sizes.end());
+
+    int cell = std::max(sizes[n / 2], 1), cols = 0, rows = 0;
+    for (;; cell *= 2)
+    {
+        cols = bounds.width / cell + 1;
+        rows = bounds.height / cell + 1;
+        if ((cols * rows) <= (64 * 64))
+        {
+            break;
+        }
+    }
+
+    std::vector<std::vector<int>> grid(cols * rows);
+    std::vector<int> visited(n, -1); // last candidate compared with each kept detection
+    std::vector<int> kept;
+
+    for (auto i : order)
+    {
+        const auto& a = objects[i];
+        const int x0 = (a.x - bounds.x) / cell, x1 = std::max(a.x + a.width - 1 - bounds.x, 0) / cell;
+        const int y0 = (a.y - bounds.y) / cell, y1 = std::max(a.y + a.height - 1 - bounds.y, 0) / cell;
+
+        bool isDuplicate = false;
+        for (int y = y0; (y <= y1) && !isDuplicate; y++)
+        {
+            for (int x = x0; (x <= x1) && !isDuplicate; x++)
+            {
+                for (auto j : grid[y * cols + x])
+                {
+                    if (visited[j] == i)
+                    {
+                        continue;
+                    }
+                    visited[j] = i;
+
+                    const auto& b = objects[j];
+                    const double intersection = (a & b).area();
+                    const double denominator = isMinArea ? std::min(a.area(), b.area()) : (a.area() + b.area() - intersection);
+                    if (intersection > (overlap * denominator))
+                    {
+                        isDuplicate = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!isDuplicate)
+        {
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    grid[y * cols + x].push_back(i);
+                }
+            }
+
+            kept.push_back(i);
+            if (maxCount && (kept.size() >= maxCount))
+            {
+                break;
+            }
+        }
+    }
+
+    std::vector<cv::Rect> objectsOut(kept.size());
+    std::vector<double> scoresOut(kept.size());
+    for (std::size_t k = 0; k < kept.size(); k++)
+    {
+        objectsOut[k] = objects[kept[k]];
+        scoresOut[k] = scores[kept[k]];
+    }
+
+    objects.swap(objectsOut);
+    scores.swap(scoresOut);
+}
+
 DRISHTI_ML_NAMESPACE_END
@@ -35,6 +35,16 @@ public:
     virtual bool getDoNonMaximaSuppression() const;
     virtual cv::Size getWindowSize() const = 0;
 
+    // Overlap threshold for the suppression below (used by detectors that run it themselves):
+    void setNmsOverlap(double overlap) { m_nmsOverlap = overlap; }
+    double getNmsOverlap() const { return m_nmsOverlap; }
+
+    // Greedy non maxima suppression in descending score order.  The overlap is measured as
+    // intersection over union (or over the smaller area with isMinArea).  Kept detections are
+    // bucketed in a uniform grid, so each candidate is only compared with the kept detections
+    // that share a cell, and the scan stops once maxCount detections are kept (0 == all).
+    static void suppress(std::vector<cv::Rect>& objects, std::vector<double>& scores, double overlap, std::size_t maxCount = 0, bool isMinArea = false);
+
     ObjectDetector() = default;
 
     ObjectDetector(const ObjectDetector&) = delete;
@@ -48,6 +58,7 @@ protected:
     bool m_doNms = false;
     double m_detectionScorePruneRatio = 0.0;
     size_t m_maxDetectionCount = 10;
+    double m_nmsOverlap = 0.65; // acf default
 };
 
 DRISHTI_ML_NAMESPACE_END
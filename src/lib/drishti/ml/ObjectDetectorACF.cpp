@@ -36,7 +36,40 @@ int ObjectDetectorACF::operator()(const cv::Mat& image, std::vector<cv::Rect>& o
 
 int ObjectDetectorACF::operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
 {
-    return (*m_impl)(image, objects, scores);
+    if (!m_cascade)
+    {
+        return (*m_impl)(image, objects, scores);
+    }
+
+    acf::Detector::Pyramid P;
+    m_impl->computePyramid(image, P);
+
+    std::vector<cv::Rect> found;
+    std::vector<double> foundScores;
+    (*m_cascade)(P, found, foundScores);
+    if (m_impl->getDoNonMaximaSuppression())
+    {
+        suppress(found, foundScores, m_nmsOverlap, m_maxDetectionCount, true); // acf "maxg" over the smaller area
+    }
+
+    objects.insert(objects.end(), found.begin(), found.end());
+    if (scores)
+    {
+        scores->insert(scores->end(), foundScores.begin(), foundScores.end());
+    }
+    return objects.size();
+}
+
+void ObjectDetectorACF::setDoBatchedCascade(bool flag, int simdStages)
+{
+    m_cascade = flag ? drishti::core::make_unique<AcfCascade>(*m_impl, simdStages) : nullptr;
+}
+
+void ObjectDetectorACF::setCascade(std::unique_ptr<AcfCascade> cascade)
+{
+    const auto& g = cascade->getGeometry();
+    CV_Assert((g.modelDsPad == m_impl->opts.modelDsPad.get()) && (g.shrink == m_impl->opts.pPyramid->pChns->shrink.get()));
+    m_cascade = std::move(cascade);
 }
 
 bool ObjectDetectorACF::good() const
@@ -12,6 +12,7 @@
 #define __drishti_ml_ObjectDetectorACF_h__
 
 #include "drishti/ml/ObjectDetector.h"
+#include "drishti/ml/AcfCascade.h"
 
 #include <acf/ACF.h>
 
@@ -42,11 +43,21 @@ public:
     void setDoNonMaximaSuppression(bool flag) override;
     bool getDoNonMaximaSuppression() const override;
 
+    // Planar input is scanned by the batched soft cascade evaluator (see AcfCascade).  The
+    // trees and thresholds are copied here, so call this after any acfModify():
+    void setDoBatchedCascade(bool flag, int simdStages = 16);
+    bool getDoBatchedCascade() const { return static_cast<bool>(m_cascade); }
+
+    // Replace the evaluated trees with a standalone cascade of the same window geometry (e.g.,
+    // a distilled student, see AcfDistiller), the detector still computes the channel pyramid:
+    void setCascade(std::unique_ptr<AcfCascade> cascade);
+
     acf::Detector* getDetector() const { return m_impl.get(); }
 
 protected:
 
     std::unique_ptr<acf::Detector> m_impl;
+    std::unique_ptr<AcfCascade> m_cascade;
 
 };
 
@@ -0,0 +1,136 @@
+/*! -*-c++-*-
+  @file   ObjectDetectorACFMulti.cpp
+  @author David Hirvonen
+  @brief  Internal multi-model ACF object detector implementation file.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/ObjectDetectorACFMulti.h"
+#include "drishti/ml/AcfPyramidCache.h" // AcfPyramidCache::getKey()
+#include "drishti/core/make_unique.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+static void sortByScore(std::vector<cv::Rect>& objects, std::vector<double>& scores)
+{
+    std::vector<int> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+    std::vector<cv::Rect> objectsOut;
+    std::vector<double> scoresOut;
+    for (auto i : order)
+    {
+        objectsOut.push_back(objects[i]);
+        scoresOut.push_back(scores[i]);
+    }
+
+    objects.swap(objectsOut);
+    scores.swap(scoresOut);
+}
+
+ObjectDetectorACFMulti::ObjectDetectorACFMulti() = default;
+
+ObjectDetectorACFMulti::~ObjectDetectorACFMulti() = default;
+
+int ObjectDetectorACFMulti::add(const std::string& filename, const acf::Detector::Modify* modify)
+{
+    auto detector = drishti::core::make_unique<acf::Detector>(filename);
+    return add(std::move(detector), modify);
+}
+
+int ObjectDetectorACFMulti::add(std::istream& is, const std::string& hint, const acf::Detector::Modify* modify)
+{
+    auto detector = drishti::core::make_unique<acf::Detector>(is, hint);
+    return add(std::move(detector), modify);
+}
+
+int ObjectDetectorACFMulti::add(std::unique_ptr<acf::Detector> detector, const acf::Detector::Modify* modify)
+{
+    if (!detector || !detector->good())
+    {
+        throw std::runtime_error("ObjectDetectorACFMulti: failed to load the ACF model");
+    }
+
+    // All models read the pyramid of the first one:
+    if (!m_models.empty() && !(AcfPyramidCache::getKey(*m_models.front(), 0) == AcfPyramidCache::getKey(*detector, 0)))
+    {
+        throw std::runtime_error("ObjectDetectorACFMulti: ACF models must share the channel parameters");
+    }
+
+    if (modify)
+    {
+        detector->acfModify(*modify);
+    }
+    detector->setDoNonMaximaSuppression(false); // see operator()
+
+    m_models.push_back(std::move(detector));
+    return static_cast<int>(m_models.size()) - 1;
+}
+
+void ObjectDetectorACFMulti::computePyramid(const MatP& image, acf::Detector::Pyramid& P)
+{
+    CV_Assert(!m_models.empty());
+    m_models.front()->computePyramid(image, P);
+}
+
+// The input is used as is (RGB or LUV in model storage order), as for the MatP overload:
+int ObjectDetectorACFMulti::operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    return (*this)(MatP(image), objects, scores);
+}
+
+int ObjectDetectorACFMulti::operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    acf::Detector::Pyramid P;
+    computePyramid(image, P);
+    return (*this)(P, objects, scores, nullptr);
+}
+
+int ObjectDetectorACFMulti::operator()(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>* scores, std::vector<int>* classes)
+{
+    acf::Detector::Pyramid Q = P; // headers only
+    for (int i = 0; i < static_cast<int>(m_models.size()); i++)
+    {
+        // Each model applies its own thresholds, the raw detections are suppressed per class:
+        std::vector<cv::Rect> sorted;
+        std::vector<double> sortedScores;
+        (*m_models[i])(Q, sorted, &sortedScores);
+        if (m_doNms)
+        {
+            suppress(sorted, sortedScores, m_nmsOverlap, m_maxDetectionCount, true);
+        }
+        else
+        {
+            sortByScore(sorted, sortedScores);
+        }
+        prune(sorted, sortedScores);
+
+        objects.insert(objects.end(), sorted.begin(), sorted.end());
+        if (scores)
+        {
+            scores->insert(scores->end(), sortedScores.begin(), sortedScores.end());
+        }
+        if (classes)
+        {
+            classes->insert(classes->end(), sorted.size(), i);
+        }
+    }
+
+    return objects.size();
+}
+
+cv::Size ObjectDetectorACFMulti::getWindowSize() const
+{
+    CV_Assert(!m_models.empty());
+    return m_models.front()->getWindowSize();
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,65 @@
+/*! -*-c++-*-
+  @file   ObjectDetectorACFMulti.h
+  @author David Hirvonen
+  @brief  Internal multi-model ACF object detector declaration file.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Several ACF models (e.g., frontal, profile and eye detectors) trained with the
+  same channel parameters are evaluated on one channel pyramid.  Each model keeps
+  its own thresholds (acfModify() cascThr/cascCal) and soft cascade rejection, and
+  the raw detections are suppressed (ObjectDetector::suppress()) and pruned per class
+  before they are merged.
+
+*/
+
+#ifndef __drishti_ml_ObjectDetectorACFMulti_h__
+#define __drishti_ml_ObjectDetectorACFMulti_h__
+
+#include "drishti/ml/ObjectDetector.h"
+
+#include <acf/ACF.h>
+
+#include <memory>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class ObjectDetectorACFMulti : public ObjectDetector
+{
+public:
+    ObjectDetectorACFMulti();
+    ~ObjectDetectorACFMulti() override;
+
+    ObjectDetectorACFMulti(const ObjectDetectorACFMulti&) = delete;
+    ObjectDetectorACFMulti(ObjectDetectorACFMulti&&) = delete;
+    ObjectDetectorACFMulti& operator=(const ObjectDetectorACFMulti&) = delete;
+    ObjectDetectorACFMulti& operator=(ObjectDetectorACFMulti&&) = delete;
+
+    // Add a model and return its class index.  The channel pyramid is computed with the
+    // parameters of the first model, later models must match them (std::runtime_error).
+    int add(const std::string& filename, const acf::Detector::Modify* modify = nullptr);
+    int add(std::istream& is, const std::string& hint = {}, const acf::Detector::Modify* modify = nullptr);
+    int add(std::unique_ptr<acf::Detector> detector, const acf::Detector::Modify* modify = nullptr);
+
+    int operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = nullptr) override;
+    int operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = nullptr) override;
+
+    // Evaluate all models on a precomputed pyramid, classes[i] is the model index of objects[i]:
+    int operator()(const acf::Detector::Pyramid& P, std::vector<cv::Rect>& objects, std::vector<double>* scores = nullptr, std::vector<int>* classes = nullptr);
+
+    void computePyramid(const MatP& image, acf::Detector::Pyramid& P);
+
+    cv::Size getWindowSize() const override; // first model
+
+    std::size_t size() const { return m_models.size(); }
+    acf::Detector* getDetector(int index) const { return m_models[index].get(); }
+
+protected:
+    std::vector<std::unique_ptr<acf::Detector>> m_models;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_ObjectDetectorACFMulti_h__
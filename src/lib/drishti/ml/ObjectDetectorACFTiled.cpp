@@ -0,0 +1,250 @@
+/*! -*-c++-*-
+  @file   ObjectDetectorACFTiled.cpp
+  @author David Hirvonen
+  @brief  Internal tiled parallel ACF object detector implementation file.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/ObjectDetectorACFTiled.h"
+#include "drishti/core/Parallel.h"
+#include "drishti/core/ThreadPool.h"
+#include "drishti/core/make_unique.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+static std::vector<std::unique_ptr<ObjectDetectorACF>> load(const std::string& filename, int threads)
+{
+    std::vector<std::unique_ptr<ObjectDetectorACF>> detectors;
+    for (int i = 0; i < std::max(threads, 1); i++)
+    {
+        detectors.emplace_back(drishti::core::make_unique<ObjectDetectorACF>(filename));
+    }
+    return detectors;
+}
+
+// Image <-> channel plane coordinates of a column major model:
+static cv::Rect transpose(const cv::Rect& roi)
+{
+    return { roi.y, roi.x, roi.height, roi.width };
+}
+
+ObjectDetectorACFTiled::ObjectDetectorACFTiled(std::vector<std::unique_ptr<ObjectDetectorACF>> detectors, const Settings& settings)
+    : m_settings(settings)
+    , m_detectors(std::move(detectors))
+{
+    if (m_detectors.empty() || std::any_of(m_detectors.begin(), m_detectors.end(), [](const std::unique_ptr<ObjectDetectorACF>& detector) { return !detector || !detector->good(); }))
+    {
+        throw std::runtime_error("ObjectDetectorACFTiled: failed to load the ACF model");
+    }
+
+    m_maxDetectionCount = 0; // all objects (e.g., group photos)
+    setDoNonMaximaSuppression(m_detectors.front()->getDoNonMaximaSuppression());
+}
+
+ObjectDetectorACFTiled::ObjectDetectorACFTiled(const std::string& filename, int threads, const Settings& settings)
+    : ObjectDetectorACFTiled(load(filename, threads), settings)
+{
+}
+
+ObjectDetectorACFTiled::~ObjectDetectorACFTiled() = default;
+
+std::vector<ObjectDetectorACFTiled::Tile> ObjectDetectorACFTiled::getTiles(const cv::Size& size, int tile, int margin)
+{
+    std::vector<Tile> tiles;
+    const cv::Rect bounds({ 0, 0 }, size);
+    tile = std::max(tile, 1);
+    for (int y = 0; y < bounds.height; y += tile)
+    {
+        for (int x = 0; x < bounds.width; x += tile)
+        {
+            const cv::Rect core = cv::Rect(x, y, tile, tile) & bounds;
+            const cv::Rect roi(core.x - margin, core.y - margin, core.width + 2 * margin, core.height + 2 * margin);
+            tiles.push_back({ core, roi & bounds });
+        }
+    }
+    return tiles;
+}
+
+bool ObjectDetectorACFTiled::isOwner(const Tile& tile, const cv::Rect& object, int maxSize)
+{
+    const cv::Point center(object.x + object.width / 2, object.y + object.height / 2);
+    return tile.core.contains(center) && ((maxSize <= 0) || (std::max(object.width, object.height) <= maxSize));
+}
+
+int ObjectDetectorACFTiled::getMargin() const
+{
+    const cv::Size win = getWindowSize();
+    return (m_settings.margin > 0) ? m_settings.margin : (2 * std::max(win.width, win.height));
+}
+
+// The input is RGB in image order (see acf::Detector), tiles are cropped as is:
+int ObjectDetectorACFTiled::operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    auto crop = [&](ObjectDetectorACF& detector, const cv::Rect& roi, std::vector<cv::Rect>& found, std::vector<double>& foundScores) {
+        detector(image(roi), found, &foundScores);
+    };
+
+    auto shrink = [&](ObjectDetectorACF& detector, double scale, std::vector<cv::Rect>& found, std::vector<double>& foundScores) {
+        cv::Mat reduced;
+        cv::resize(image, reduced, {}, scale, scale, cv::INTER_AREA);
+        detector(reduced, found, &foundScores);
+    };
+
+    return detect(image.size(), crop, shrink, objects, scores);
+}
+
+// The input is in model storage order, so the planes of a column major model are transposed:
+int ObjectDetectorACFTiled::operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    MatP I = image; // headers only
+    const std::vector<cv::Mat>& planes = I.get();
+    if (planes.empty())
+    {
+        return objects.size();
+    }
+
+    const bool isRowMajor = m_detectors.front()->getDetector()->getIsRowMajor();
+    const cv::Size size = isRowMajor ? planes.front().size() : cv::Size(planes.front().rows, planes.front().cols);
+
+    auto crop = [&](ObjectDetectorACF& detector, const cv::Rect& roi, std::vector<cv::Rect>& found, std::vector<double>& foundScores) {
+        const cv::Rect region = isRowMajor ? roi : transpose(roi);
+        if (region == cv::Rect({ 0, 0 }, planes.front().size()))
+        {
+            detector(image, found, &foundScores); // no copy
+            return;
+        }
+
+        std::vector<cv::Mat> tile;
+        for (const auto& plane : planes)
+        {
+            tile.push_back(plane(region));
+        }
+        cv::Mat merged;
+        cv::merge(tile, merged);
+        detector(MatP(merged), found, &foundScores);
+    };
+
+    auto shrink = [&](ObjectDetectorACF& detector, double scale, std::vector<cv::Rect>& found, std::vector<double>& foundScores) {
+        std::vector<cv::Mat> reduced(planes.size());
+        for (std::size_t i = 0; i < planes.size(); i++)
+        {
+            cv::resize(planes[i], reduced[i], {}, scale, scale, cv::INTER_AREA);
+        }
+        cv::Mat merged;
+        cv::merge(reduced, merged);
+        detector(MatP(merged), found, &foundScores);
+    };
+
+    return detect(size, crop, shrink, objects, scores);
+}
+
+int ObjectDetectorACFTiled::detect(const cv::Size& size, const Crop& crop, const Shrink& shrink, std::vector<cv::Rect>& objects, std::vector<double>* scores)
+{
+    const int margin = getMargin();
+    const int tile = std::max(m_settings.tile, 1);
+
+    std::vector<cv::Rect> merged;
+    std::vector<double> mergedScores;
+    if ((size.width <= (tile + 2 * margin)) && (size.height <= (tile + 2 * margin)))
+    {
+        crop(*m_detectors.front(), { { 0, 0 }, size }, merged, mergedScores);
+    }
+    else
+    {
+        // Tiles see objects up to 2x the margin whole, the coarse pass finds them at the window size:
+        const auto tiles = getTiles(size, tile, margin);
+        const cv::Size win = getWindowSize();
+        const double scale = static_cast<double>(std::max(win.width, win.height)) / static_cast<double>(2 * margin);
+        const bool doCoarse = m_settings.doCoarse && (scale < 1.0);
+        const int maxSize = doCoarse ? (2 * margin) : 0;
+
+        const int count = static_cast<int>(tiles.size()) + (doCoarse ? 1 : 0);
+        std::vector<std::vector<cv::Rect>> found(count);
+        std::vector<std::vector<double>> foundScores(count);
+
+        // Worker t owns detector t and claims the next tile (or the coarse pass) until none are left:
+        std::atomic<int> next{ 0 };
+        drishti::core::ParallelHomogeneousLambda harness = [&](int t) {
+            for (int k = next++; k < count; k = next++)
+            {
+                std::vector<cv::Rect> candidates;
+                std::vector<double> candidateScores;
+                if (k < static_cast<int>(tiles.size()))
+                {
+                    crop(*m_detectors[t], tiles[k].roi, candidates, candidateScores);
+                    for (std::size_t i = 0; i < candidates.size(); i++)
+                    {
+                        const cv::Rect object = candidates[i] + tiles[k].roi.tl();
+                        if (isOwner(tiles[k], object, maxSize))
+                        {
+                            found[k].push_back(object);
+                            foundScores[k].push_back(candidateScores[i]);
+                        }
+                    }
+                }
+                else
+                {
+                    shrink(*m_detectors[t], scale, candidates, candidateScores);
+                    for (std::size_t i = 0; i < candidates.size(); i++)
+                    {
+                        const auto& c = candidates[i];
+                        const cv::Rect object(cvRound(c.x / scale), cvRound(c.y / scale), cvRound(c.width / scale), cvRound(c.height / scale));
+                        if (std::max(object.width, object.height) > maxSize)
+                        {
+                            found[k].push_back(object);
+                            foundScores[k].push_back(candidateScores[i]);
+                        }
+                    }
+                }
+            }
+        };
+
+        drishti::core::ParallelSettings settings;
+        settings.threads = std::min(static_cast<int>(m_detectors.size()), count);
+        settings.grain = 1;
+        drishti::core::parallelFor({ 0, settings.threads }, harness, settings);
+
+        for (int k = 0; k < count; k++)
+        {
+            merged.insert(merged.end(), found[k].begin(), found[k].end());
+            mergedScores.insert(mergedScores.end(), foundScores[k].begin(), foundScores[k].end());
+        }
+
+        if (m_doNms)
+        {
+            suppress(merged, mergedScores, m_nmsOverlap, m_maxDetectionCount, true); // acf "maxg" over the smaller area
+        }
+    }
+
+    objects.insert(objects.end(), merged.begin(), merged.end());
+    if (scores)
+    {
+        scores->insert(scores->end(), mergedScores.begin(), mergedScores.end());
+    }
+    return objects.size();
+}
+
+void ObjectDetectorACFTiled::setDoNonMaximaSuppression(bool flag)
+{
+    m_doNms = flag;
+    for (auto& detector : m_detectors)
+    {
+        detector->setDoNonMaximaSuppression(flag);
+    }
+}
+
+cv::Size ObjectDetectorACFTiled::getWindowSize() const
+{
+    return m_detectors.front()->getWindowSize();
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,90 @@
+/*! -*-c++-*-
+  @file   ObjectDetectorACFTiled.h
+  @author David Hirvonen
+  @brief  Internal tiled parallel ACF object detector declaration file.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Very large stills (e.g., gigapixel group photos) are cut into a grid of tiles, each tile
+  is padded with a margin of context on every side, and the tiles are detected in parallel
+  with one detector instance per worker, so only one tile pyramid per worker is in memory
+  at any time.  A tile owns the detections centered in its core that fit in twice the
+  margin, i.e., the objects it sees whole, and larger objects are found by one extra pass
+  over the image downsampled so that they appear at the window size.  Each object has a
+  single owner, so the global suppression (ObjectDetector::suppress()) only resolves the
+  few duplicates near the coarse/tile size boundary.
+
+*/
+
+#ifndef __drishti_ml_ObjectDetectorACFTiled_h__
+#define __drishti_ml_ObjectDetectorACFTiled_h__
+
+#include "drishti/ml/ObjectDetector.h"
+#include "drishti/ml/ObjectDetectorACF.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class ObjectDetectorACFTiled : public ObjectDetector
+{
+public:
+    struct Settings
+    {
+        int tile = 1024;      // tile core width and height (pixels of the detection image)
+        int margin = 0;       // context on each side of the core (0: 2x the detector window)
+        bool doCoarse = true; // objects larger than 2x the margin (downsampled pass)
+    };
+
+    // Tile core and padded region (clipped to the image) in image coordinates:
+    struct Tile
+    {
+        cv::Rect core;
+        cv::Rect roi;
+    };
+
+    // One detector instance per worker (e.g., the same model loaded several times), the
+    // settings of the first one apply to all of them:
+    ObjectDetectorACFTiled(std::vector<std::unique_ptr<ObjectDetectorACF>> detectors, const Settings& settings);
+    ObjectDetectorACFTiled(const std::string& filename, int threads, const Settings& settings);
+    ~ObjectDetectorACFTiled() override;
+
+    ObjectDetectorACFTiled(const ObjectDetectorACFTiled&) = delete;
+    ObjectDetectorACFTiled(ObjectDetectorACFTiled&&) = delete;
+    ObjectDetectorACFTiled& operator=(const ObjectDetectorACFTiled&) = delete;
+    ObjectDetectorACFTiled& operator=(ObjectDetectorACFTiled&&) = delete;
+
+    // Images that fit in one padded tile are passed to the first detector as is:
+    int operator()(const cv::Mat& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = nullptr) override;
+    int operator()(const MatP& image, std::vector<cv::Rect>& objects, std::vector<double>* scores = nullptr) override;
+    cv::Size getWindowSize() const override;
+    void setDoNonMaximaSuppression(bool flag) override; // tiles and the merged detections
+
+    // Row major grid of tiles that covers an image (empty for an empty image):
+    static std::vector<Tile> getTiles(const cv::Size& size, int tile, int margin);
+
+    // A tile owns the detections centered in its core with a size <= maxSize (0: any):
+    static bool isOwner(const Tile& tile, const cv::Rect& object, int maxSize);
+
+    int getMargin() const;
+    std::size_t size() const { return m_detectors.size(); }
+    ObjectDetectorACF* getDetector(int index) const { return m_detectors[index].get(); }
+
+protected:
+    // Detect one region of the image, or the whole image downsampled by scale (in the
+    // coordinates of the region and of the downsampled image respectively):
+    using Crop = std::function<void(ObjectDetectorACF& detector, const cv::Rect& roi, std::vector<cv::Rect>& objects, std::vector<double>& scores)>;
+    using Shrink = std::function<void(ObjectDetectorACF& detector, double scale, std::vector<cv::Rect>& objects, std::vector<double>& scores)>;
+
+    int detect(const cv::Size& size, const Crop& crop, const Shrink& shrink, std::vector<cv::Rect>& objects, std::vector<double>* scores);
+
+    Settings m_settings;
+    std::vector<std::unique_ptr<ObjectDetectorACF>> m_detectors;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_ObjectDetectorACFTiled_h__
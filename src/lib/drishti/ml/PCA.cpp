@@ -13,6 +13,8 @@
 
 #include <Eigen/Dense>
 
+#include <algorithm>
+
 DRISHTI_ML_NAMESPACE_BEGIN
 
 // ########## Scaling params ############
@@ -127,6 +129,84 @@ void StandardizedPCA::init()
     {
         m_eT = m_pca->eigenvectors.t();
     }
+
+    // Fold the standardization and the PCA mean into the eigenvectors:
+    //   p = E * ((x - mu) / sigma - m)  = (E / sigma) * x - (E / sigma) * mu - E * m
+    //   x = (E' * p + m) * sigma + mu   = (E' * sigma) * p + (m * sigma + mu)
+    if (!m_pca->eigenvectors.empty() && !m_transform.sigma.empty())
+    {
+        cv::Mat1f E, mu, sigma, mean = cv::Mat1f::zeros(1, m_pca->eigenvectors.cols);
+        m_pca->eigenvectors.convertTo(E, CV_32F);
+        m_transform.mu.reshape(1, 1).convertTo(mu, CV_32F);
+        m_transform.sigma.reshape(1, 1).convertTo(sigma, CV_32F);
+        if (!m_pca->mean.empty())
+        {
+            m_pca->mean.reshape(1, 1).convertTo(mean, CV_32F);
+        }
+
+        m_projection = E / cv::repeat(sigma, E.rows, 1);
+        m_projectionBias = (m_projection * mu.t() + E * mean.t()).t();
+        m_backProjection = E.t().mul(cv::repeat(sigma.t(), 1, E.rows));
+        m_backProjectionBias = mean.mul(sigma) + mu;
+    }
+}
+
+void StandardizedPCA::project(const float* sample, float* projection, int n) const
+{
+    const int dim = m_projection.cols;
+    for (int j = 0; j < n; j++)
+    {
+        const float* w = m_projection.ptr<float>(j);
+        float value = 0.f;
+        for (int i = 0; i < dim; i++)
+        {
+            value += w[i] * sample[i];
+        }
+        projection[j] = value - m_projectionBias(0, j);
+    }
+}
+
+void StandardizedPCA::backProject(const float* projection, int n, float* sample) const
+{
+    // The first n components are the prefix of each (contiguous) row:
+    const float* bias = m_backProjectionBias.ptr<float>();
+    for (int i = 0; i < m_backProjection.rows; i++)
+    {
+        const float* v = m_backProjection.ptr<float>(i);
+        float value = bias[i];
+        for (int j = 0; j < n; j++)
+        {
+            value += v[j] * projection[j];
+        }
+        sample[i] = value;
+    }
+}
+
+void StandardizedPCA::project(const cv::Mat1f& samples, cv::Mat1f& projection, int n) const
+{
+    n = (n > 0) ? std::min(n, m_projection.rows) : m_projection.rows;
+    CV_Assert(samples.cols == m_projection.cols);
+    if (projection.rows != samples.rows || projection.cols != n)
+    {
+        projection.create(samples.rows, n);
+    }
+    for (int i = 0; i < samples.rows; i++)
+    {
+        project(samples.ptr<float>(i), projection.ptr<float>(i), n);
+    }
+}
+
+void StandardizedPCA::backProject(const cv::Mat1f& projection, cv::Mat1f& samples) const
+{
+    CV_Assert(projection.cols <= m_backProjection.cols);
+    if (samples.rows != projection.rows || samples.cols != m_backProjection.rows)
+    {
+        samples.create(projection.rows, m_backProjection.rows);
+    }
+    for (int i = 0; i < projection.rows; i++)
+    {
+        backProject(projection.ptr<float>(i), projection.cols, samples.ptr<float>(i));
+    }
 }
 
 cv::Mat StandardizedPCA::project(const cv::Mat& samples, int n) const
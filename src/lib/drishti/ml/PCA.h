@@ -60,6 +60,19 @@ public:
 
     cv::Mat project(const cv::Mat& data, int n = 0) const;
     cv::Mat backProject(const cv::Mat& projection) const;
+
+    // Allocation free kernels with the standardization folded into precomputed (scaled)
+    // eigenvectors: samples are rows of a batch, the first n components are used without
+    // slicing copies (n <= 0 : all), and the output is (re)allocated only on a size mismatch.
+    void project(const cv::Mat1f& samples, cv::Mat1f& projection, int n = 0) const;
+    void backProject(const cv::Mat1f& projection, cv::Mat1f& samples) const; // n = projection.cols
+
+    // Single sample variants on caller owned buffers (getDimension() and n elements):
+    void project(const float* sample, float* projection, int n) const;
+    void backProject(const float* projection, int n, float* sample) const;
+
+    int getDimension() const { return m_backProjection.rows; }  // sample length
+    int getProjectionDimension() const { return m_projection.rows; } // retained components
     const cv::Mat& getTransposedEigenvectors() const
     {
         return m_eT;
@@ -75,6 +88,11 @@ protected:
     std::unique_ptr<cv::PCA> m_pca;
 
     cv::Mat m_eT; // transposed eigenvectors
+
+    cv::Mat1f m_projection;         // ( K x D ) eigenvectors / sigma
+    cv::Mat1f m_projectionBias;     // ( 1 x K )
+    cv::Mat1f m_backProjection;     // ( D x K ) eigenvectors' * sigma
+    cv::Mat1f m_backProjectionBias; // ( 1 x D )
 };
 
 DRISHTI_ML_NAMESPACE_END
@@ -12,6 +12,7 @@
 
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/make_unique.h"
+#include "drishti/core/scope_guard.h"
 #include "drishti/ml/drishti_ml.h"
 #include "drishti/ml/shape_predictor_archive.h"
 
@@ -46,7 +47,8 @@ public:
         }
     }
 
-    int operator()(const cv::Mat& crop, std::vector<cv::Point2f>& points, std::vector<bool>& mask) const
+    // A negative stage count uses the instance hint (see setStagesHint()):
+    int operator()(const cv::Mat& crop, std::vector<cv::Point2f>& points, std::vector<bool>& mask, bool mirrored = false, int first = 0, int stages = -1) const
     {
         CV_Assert(crop.type() == CV_8UC1);
 
@@ -63,7 +65,7 @@ public:
         // Zero copy cv::Mat wrapper:
         auto img = dlib::cv_image<uint8_t>(crop);
         dlib::rectangle roi(0, 0, crop.cols, crop.rows);
-        dlib::full_object_detection shape = (*m_predictor)(img, roi, initial_shape, m_stagesHint);
+        dlib::full_object_detection shape = (*m_predictor)(img, roi, initial_shape, (stages >= 0) ? stages : m_stagesHint, mirrored, first);
 
         points.clear();
         points.reserve(initial_shape.size() / 2);
@@ -76,6 +78,84 @@ public:
         return int(points.size());
     }
 
+    // Batched hypotheses (see ShapeEstimator::Options), returns the number of hypotheses that weren't pruned:
+    int estimate(const cv::Mat& image, std::vector<std::vector<cv::Point2f>>& hypotheses, const ShapeEstimator::Options& options) const
+    {
+        CV_Assert(image.type() == CV_8UC1);
+        CV_Assert(options.rois.empty() || (options.rois.size() == hypotheses.size()));
+
+        auto& sp = *m_predictor;
+
+        std::vector<dlib::rectangle> rects;
+        std::vector<fshape> shapes;
+        for (std::size_t i = 0; i < hypotheses.size(); i++)
+        {
+            const cv::Rect roi = options.rois.empty() ? cv::Rect({ 0, 0 }, image.size()) : options.rois[i];
+            rects.emplace_back(roi.x, roi.y, roi.x + roi.width, roi.y + roi.height);
+
+            shapes.push_back(sp.initial_shape);
+            int paramCount = (hypotheses[i].size() * 2) - (sp.m_ellipse_count * 5);
+            if (paramCount == shapes.back().size())
+            {
+                packPointsInShape(hypotheses[i], sp.m_ellipse_count, &shapes.back()(0, 0));
+            }
+        }
+
+        _SHAPE_PREDICTOR::batch_options batch;
+        batch.stages = (options.stages >= 0) ? options.stages : m_stagesHint;
+        batch.mirrored = options.mirrored;
+        batch.first = options.first;
+        batch.prune_level = options.pruneStage;
+
+        // Zero copy cv::Mat wrapper:
+        auto img = dlib::cv_image<uint8_t>(image);
+        const auto detections = sp(img, rects, shapes, batch);
+
+        int count = 0;
+        for (std::size_t i = 0; i < hypotheses.size(); i++)
+        {
+            const auto& shape = detections[i];
+            hypotheses[i].clear();
+            for (int j = 0; j < shape.num_parts(); j++)
+            {
+                hypotheses[i].push_back(cv_point(shape.part(j)));
+            }
+            count += int(shape.num_parts() > 0);
+        }
+
+        return count;
+    }
+
+    bool estimateBatch(Backend& backend, const std::vector<cv::Mat>& crops, std::vector<std::vector<cv::Point2f>>& points) const
+    {
+        auto& sp = *m_predictor;
+
+        const float* mean = &sp.initial_shape(0);
+        std::vector<std::vector<float>> shapes(crops.size(), std::vector<float>(mean, mean + sp.initial_shape.size()));
+        if (!backend(sp, crops, shapes, m_stagesHint))
+        {
+            return false;
+        }
+
+        points.resize(crops.size());
+        for (std::size_t i = 0; i < crops.size(); i++)
+        {
+            fshape shape;
+            shape.set_size(shapes[i].size());
+            std::copy(shapes[i].begin(), shapes[i].end(), &shape(0));
+
+            const dlib::rectangle roi(0, 0, crops[i].cols, crops[i].rows);
+            const std::vector<dlib::point> parts = sp.to_parts(shape, roi);
+
+            points[i].clear();
+            for (const auto& p : parts)
+            {
+                points[i].push_back(cv_point(p));
+            }
+        }
+        return true;
+    }
+
     void setStagesHint(int stages)
     {
         m_stagesHint = stages;
@@ -97,6 +177,11 @@ public:
         return points;
     }
 
+    const std::vector<int>& getLandmarks() const
+    {
+        return m_predictor->landmarks;
+    }
+
     void dump(std::vector<float>& values, bool pca)
     {
         return m_predictor->getShapeUpdates(values, pca);
@@ -114,11 +199,21 @@ public:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
-        ar& m_predictor;
+        // Archived as a std::unique_ptr<> (format is unchanged), held as std::shared_ptr<> for clone():
+        std::unique_ptr<_SHAPE_PREDICTOR> predictor(Archive::is_loading::value ? nullptr : m_predictor.get());
+        core::scope_guard release = [&]() {
+            if (!Archive::is_loading::value)
+            {
+                predictor.release();
+            }
+        };
+
+        ar& predictor;
 
         if (Archive::is_loading::value)
         {
-            m_predictor->populate_f16();
+            predictor->populate_f16();
+            m_predictor = std::move(predictor);
         }
     }
 
@@ -130,7 +225,8 @@ public:
     int m_inits = 1;
     int m_stagesHint = std::numeric_limits<int>::max();
 
-    std::unique_ptr<_SHAPE_PREDICTOR> m_predictor;
+    std::shared_ptr<_SHAPE_PREDICTOR> m_predictor; // immutable after load (shared by clones)
+    std::shared_ptr<Backend> m_backend;            // (optional) see setBackend()
 
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
@@ -10,6 +10,8 @@
 
 #include "drishti/ml/RTEShapeEstimatorImpl.h"
 
+#include <algorithm>
+
 // C++ exception with description:
 // "Trying to save an unregistered polymorphic type (drishti::ml::RegressionTreeEnsembleShapeEstimator).
 // Make sure your type is registered with CEREAL_REGISTER_TYPE and that the archive you are using was
@@ -83,6 +85,42 @@ int RTEShapeEstimator::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec
     return 0;
 }
 
+int RTEShapeEstimator::estimate(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points, const Options& options) const
+{
+    if ((points.size() > 1) || !options.rois.empty())
+    {
+        return m_impl->estimate(I, points, options); // hypotheses advance through the cascade together
+    }
+
+    for (auto& p : points)
+    {
+        BoolVec mask;
+        (*m_impl)(I, p, mask, options.mirrored, options.first, options.stages);
+    }
+    return int(points.size());
+}
+
+int RTEShapeEstimator::estimateBatch(const std::vector<BatchItem>& items, std::vector<Point2fVec>& shapes, const Options& options, const BatchExecutor& executor) const
+{
+    const bool isCold = std::all_of(items.begin(), items.end(), [](const BatchItem& item) { return item.init.empty(); });
+    if (m_impl->m_backend && !items.empty() && isCold && !options.mirrored && (options.stages < 0))
+    {
+        std::vector<cv::Mat> crops(items.size());
+        std::transform(items.begin(), items.end(), crops.begin(), getCrop);
+        if (m_impl->estimateBatch(*m_impl->m_backend, crops, shapes))
+        {
+            return int(shapes.size());
+        }
+    }
+
+    return ShapeEstimator::estimateBatch(items, shapes, options, executor); // CPU fallback
+}
+
+void RTEShapeEstimator::setBackend(std::shared_ptr<Backend> backend)
+{
+    m_impl->m_backend = std::move(backend);
+}
+
 bool RTEShapeEstimator::isPCA() const
 {
     return m_impl->isPCA();
@@ -93,9 +131,32 @@ std::vector<cv::Point2f> RTEShapeEstimator::getMeanShape() const
     return m_impl->getMeanShape();
 }
 
+std::vector<int> RTEShapeEstimator::getLandmarks() const
+{
+    return m_impl->getLandmarks();
+}
+
 void RTEShapeEstimator::dump(std::vector<float>& values, bool pca)
 {
     return m_impl->dump(values, pca);
 }
 
+std::unique_ptr<ShapeEstimator> RTEShapeEstimator::clone() const
+{
+    if (!m_impl || !m_impl->m_predictor)
+    {
+        return nullptr;
+    }
+
+    auto estimator = drishti::core::make_unique<RTEShapeEstimator>();
+    estimator->m_impl = drishti::core::make_unique<Impl>();
+    estimator->m_impl->m_predictor = m_impl->m_predictor; // shared (const) regression trees
+    estimator->m_impl->m_inits = m_impl->m_inits;
+    estimator->m_impl->m_stagesHint = m_impl->m_stagesHint;
+    estimator->m_impl->m_streamLogger = m_impl->m_streamLogger;
+    estimator->m_impl->m_backend = m_impl->m_backend;
+    estimator->m_streamLogger = m_streamLogger;
+    return std::move(estimator);
+}
+
 DRISHTI_ML_NAMESPACE_END
@@ -21,12 +21,24 @@
 
 DRISHTI_ML_NAMESPACE_BEGIN
 
+class shape_predictor;
+
 // Consider occlusion estimation
 class RegressionTreeEnsembleShapeEstimator : public ShapeEstimator
 {
 public:
     class Impl;
 
+    // Optional evaluator for a batch of crops on the calling thread (e.g., on a GPU).  Shapes are
+    // in the normalized model frame (see shape_predictor::initial_shape), one per crop, and are
+    // updated in place.  Returns false for unsupported models or contexts (CPU fallback):
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+        virtual bool operator()(const shape_predictor& predictor, const std::vector<cv::Mat>& crops, std::vector<std::vector<float>>& shapes, int stages) = 0;
+    };
+
     RegressionTreeEnsembleShapeEstimator();
     explicit RegressionTreeEnsembleShapeEstimator(const std::string& filename);
     explicit RegressionTreeEnsembleShapeEstimator(std::istream& is, const std::string& hint = {});
@@ -40,7 +52,19 @@ public:
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger) override;
     int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const override;
     int operator()(const cv::Mat& I, Point2fVec& points, BoolVec& mask) const override;
+    int estimate(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points, const Options& options) const override;
+
+    // Cold started batches over the full cascade are offered to the backend first (see setBackend()):
+    int estimateBatch(const std::vector<BatchItem>& items, std::vector<Point2fVec>& shapes, const Options& options = {}, const BatchExecutor& executor = {}) const override;
+
+    // (Optional) batch evaluator, called on the estimateBatch() thread:
+    void setBackend(std::shared_ptr<Backend> backend);
+    bool isMirrorable() const override
+    {
+        return true;
+    }
     std::vector<cv::Point2f> getMeanShape() const override;
+    std::vector<int> getLandmarks() const override;
     void setDoPreview(bool flag) override {}
     bool isPCA() const override;
 
@@ -49,6 +73,8 @@ public:
 
     void dump(std::vector<float>& values, bool pca) override;
 
+    std::unique_ptr<ShapeEstimator> clone() const override;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version);
 
@@ -129,6 +129,28 @@ int RegressionTreeEnsembleShapeEstimatorDEST::operator()(const cv::Mat& I, const
     return 0;
 }
 
+// The DEST tracker isn't guaranteed to be reentrant, so the batch is evaluated on the calling
+// thread, and warm starts, mirroring and stage limits aren't supported (empty shapes):
+int RegressionTreeEnsembleShapeEstimatorDEST::estimateBatch(const std::vector<BatchItem>& items, std::vector<Point2fVec>& shapes, const Options& options, const BatchExecutor& executor) const
+{
+    shapes.assign(items.size(), {});
+    if (options.mirrored || (options.stages >= 0))
+    {
+        return 0;
+    }
+
+    int count = 0;
+    for (std::size_t i = 0; i < items.size(); i++)
+    {
+        if (items[i].init.empty())
+        {
+            shapes[i] = (*m_impl)(getCrop(items[i]));
+            count++;
+        }
+    }
+    return count;
+}
+
 bool RegressionTreeEnsembleShapeEstimatorDEST::isPCA() const
 {
     return false;
@@ -34,6 +34,7 @@ public:
 
     virtual int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const;
     virtual int operator()(const cv::Mat& I, Point2fVec& points, BoolVec& mask) const;
+    virtual int estimateBatch(const std::vector<BatchItem>& items, std::vector<Point2fVec>& shapes, const Options& options = {}, const BatchExecutor& executor = {}) const;
     virtual std::vector<cv::Point2f> getMeanShape() const;
     virtual void setDoPreview(bool flag) {}
     virtual bool isPCA() const;
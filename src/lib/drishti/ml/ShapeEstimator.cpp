@@ -19,6 +19,7 @@
 #include "drishti/core/Shape.h"
 #include "drishti/core/Logger.h"
 
+#include <algorithm>
 #include <deque>
 
 DRISHTI_ML_NAMESPACE_BEGIN
@@ -49,4 +50,78 @@ int ShapeEstimator::operator()(const cv::Mat& image, const cv::Rect& roi, Point2
     return n;
 }
 
+int ShapeEstimator::estimate(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points, const Options& options) const
+{
+    if (options.mirrored || (options.first > 0) || !options.rois.empty())
+    {
+        return -1;
+    }
+    return (*this)(I, M, points);
+}
+
+int ShapeEstimator::operator()(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points) const
+{
+    for (auto& p : points)
+    {
+        BoolVec mask;
+        (*this)(I, M, p, mask);
+    }
+    return int(points.size());
+}
+
+cv::Mat ShapeEstimator::getCrop(const BatchItem& item)
+{
+    const cv::Rect bounds({ 0, 0 }, item.image.size());
+    const cv::Rect roi = item.roi.area() ? item.roi : bounds;
+    const cv::Rect validRoi = roi & bounds;
+    cv::Mat crop = item.image(validRoi);
+    if (validRoi != roi)
+    {
+        cv::Mat padded(roi.size(), crop.type(), cv::Scalar::all(0));
+        crop.copyTo(padded(validRoi - roi.tl()));
+        cv::swap(crop, padded);
+    }
+    return crop;
+}
+
+int ShapeEstimator::estimateBatch(const std::vector<BatchItem>& items, std::vector<Point2fVec>& shapes, const Options& options, const BatchExecutor& executor) const
+{
+    shapes.assign(items.size(), {});
+
+    std::function<void(int)> job = [&](int i) {
+        const cv::Mat crop = getCrop(items[i]);
+        if (items[i].init.empty() && !options.mirrored && (options.stages < 0))
+        {
+            BoolVec mask;
+            (*this)(crop, shapes[i], mask);
+        }
+        else
+        {
+            Options single = options;
+            single.rois.clear();
+            single.first = items[i].init.empty() ? 0 : options.first;
+
+            std::vector<Point2fVec> points{ items[i].init };
+            if (estimate(crop, {}, points, single) > 0)
+            {
+                shapes[i] = std::move(points.front());
+            }
+        }
+    };
+
+    if (executor && (items.size() > 1))
+    {
+        executor(int(items.size()), job);
+    }
+    else
+    {
+        for (int i = 0; i < int(items.size()); i++)
+        {
+            job(i);
+        }
+    }
+
+    return int(std::count_if(shapes.begin(), shapes.end(), [](const Point2fVec& shape) { return !shape.empty(); }));
+}
+
 DRISHTI_ML_NAMESPACE_END
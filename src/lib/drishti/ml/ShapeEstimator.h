@@ -19,6 +19,7 @@
 
 #include <opencv2/core.hpp>
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -47,10 +48,83 @@ public:
     virtual int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const = 0;
     virtual int operator()(const cv::Mat& crop, Point2fVec& points, BoolVec& mask) const = 0;
     virtual int operator()(const cv::Mat& image, const cv::Rect& roi, Point2fVec& points, BoolVec& mask) const;
+
+    // Batch estimation from multiple initial hypotheses (each points[i] is updated in place):
+    virtual int operator()(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points) const;
+
+    // Per call options for estimate():
+    struct Options
+    {
+        // I is read as if it were flipped about the vertical axis (x -> cols - 1 - x), while the mask
+        // and all shapes are in the flipped coordinate system, e.g., a left eye regressed in place
+        // with a right eye model:
+        bool mirrored = false;
+
+        // First cascade stage, warm starts close to convergence (e.g., tracking) skip coarse stages:
+        int first = 0;
+
+        // Per hypothesis sampling roi in I (empty == all of I), shapes are returned in I coordinates:
+        std::vector<cv::Rect> rois;
+
+        // Multiple hypotheses: drop outliers (returned empty) after this many stages (0 == never):
+        int pruneStage = 0;
+
+        // Stage limit and early stopping for this call, negative values use the instance hints
+        // (see setStagesHint() and setConvergenceHint()):
+        int stages = -1;
+        float convergenceEpsilon = -1.f;
+        int convergenceStages = -1;
+
+        // Debug visualization for this call (setDoPreview() is the instance default):
+        bool preview = false;
+    };
+
+    // Batch estimation with options (hypotheses are updated in place), returns -1 if not supported.
+    // Estimation only reads the model, so concurrent calls with different options are safe:
+    virtual int estimate(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points, const Options& options) const;
+
+    int estimateMirrored(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points) const
+    {
+        Options options;
+        options.mirrored = true;
+        return estimate(I, M, points, options);
+    }
+
+    // One face for estimateBatch(), the shape is returned in roi coordinates:
+    struct BatchItem
+    {
+        cv::Mat image;   // CV_8UC1 view (e.g., the full regression image)
+        cv::Rect roi;    // sampling roi, may exceed the image bounds (empty == all of image)
+        Point2fVec init; // (optional) warm start normalized by the roi size (see Options::first)
+    };
+
+    // Runs job(i) for i in [0, n), e.g., on a thread pool (empty == serial on the calling thread):
+    using BatchExecutor = std::function<void(int n, const std::function<void(int)>& job)>;
+
+    // N faces in one call, shapes[i] is empty if items[i] failed, returns the number of shapes.
+    // Options::first applies to the warm started items and Options::rois is ignored.  Backends
+    // are free to parallelize (see BatchExecutor), vectorize or offload the whole batch:
+    virtual int estimateBatch(const std::vector<BatchItem>& items, std::vector<Point2fVec>& shapes, const Options& options = {}, const BatchExecutor& executor = {}) const;
+
+    // Geometry preserving (zero padded) crop of a batch item:
+    static cv::Mat getCrop(const BatchItem& item);
+
+    // True if estimate() supports all options (mirrored sampling and warm starts):
+    virtual bool isMirrorable() const
+    {
+        return false;
+    }
     virtual std::vector<cv::Point2f> getMeanShape() const
     {
         return std::vector<cv::Point2f>();
     }
+
+    // Subset models: annotation index of each regressed point (empty == the full shape):
+    virtual std::vector<int> getLandmarks() const
+    {
+        return std::vector<int>();
+    }
+    // Instance default for Options::preview (use Options for concurrent calls):
     virtual void setDoPreview(bool flag);
     virtual bool isPCA() const
     {
@@ -61,9 +135,21 @@ public:
     {
         return 0;
     }
+    virtual void setConvergenceHint(float epsilon, int stages) {}
+    virtual float getConvergenceEpsilon() const
+    {
+        return 0.f;
+    }
 
     virtual void dump(std::vector<float>& params, bool pca = false) {}
 
+    // New instance sharing the (read only) model weights, with a copy of the per instance
+    // settings, or nullptr if the variant doesn't support sharing:
+    virtual std::unique_ptr<ShapeEstimator> clone() const
+    {
+        return nullptr;
+    }
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version) {}
 
@@ -0,0 +1,233 @@
+/*! -*-c++-*-
+  @file   TreeEnsemble.cpp
+  @author David Hirvonen
+  @brief  Implementation of a compact fixed depth regression tree ensemble evaluator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+*/
+
+#include "drishti/ml/TreeEnsemble.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+static int getTreeDepth(const TreeEnsemble::Tree& tree, int index)
+{
+    const auto& node = tree[index];
+    return node.leaf ? 0 : (1 + std::max(getTreeDepth(tree, node.left), getTreeDepth(tree, node.right)));
+}
+
+bool TreeEnsemble::create(const std::vector<Tree>& trees, float baseScore, Objective objective)
+{
+    *this = {};
+
+    int depth = 0, maxFeature = -1;
+    for (const auto& tree : trees)
+    {
+        if (tree.empty())
+        {
+            return false;
+        }
+        depth = std::max(depth, getTreeDepth(tree, 0));
+        for (const auto& node : tree)
+        {
+            if (!node.leaf)
+            {
+                maxFeature = std::max(maxFeature, node.feature);
+            }
+        }
+    }
+
+    if (depth > DRISHTI_ML_TREE_ENSEMBLE_MAX_DEPTH || maxFeature > std::numeric_limits<std::uint16_t>::max())
+    {
+        return false;
+    }
+
+    const std::size_t splits = (std::size_t(1) << depth) - 1;
+    const std::size_t leaves = (std::size_t(1) << depth);
+
+    m_feature.resize(trees.size() * splits, 0);
+    m_threshold.resize(trees.size() * splits, 0.f);
+    m_defaultLeft.resize(trees.size() * splits, 0);
+    m_leaf.resize(trees.size() * leaves, 0.f);
+
+    for (std::size_t t = 0; t < trees.size(); t++)
+    {
+        const auto& tree = trees[t];
+
+        // Map tree node 'index' to position 'i' (heap order) of the complete tree, where
+        // a leaf at level d is replicated into the 2^(D-d) leaves below position i:
+        std::function<void(int, std::size_t, int)> fill = [&](int index, std::size_t i, int level) {
+            const auto& node = tree[index];
+            if (level == depth)
+            {
+                m_leaf[t * leaves + (i - splits)] = node.value;
+            }
+            else if (node.leaf)
+            {
+                // padding split: both children reach the same leaf value
+                fill(index, 2 * i + 1, level + 1);
+                fill(index, 2 * i + 2, level + 1);
+            }
+            else
+            {
+                m_feature[t * splits + i] = static_cast<std::uint16_t>(node.feature);
+                m_threshold[t * splits + i] = node.value;
+                m_defaultLeft[t * splits + i] = node.defaultLeft;
+                fill(node.left, 2 * i + 1, level + 1);
+                fill(node.right, 2 * i + 2, level + 1);
+            }
+        };
+        fill(0, 0, 0);
+    }
+
+    m_count = int(trees.size());
+    m_depth = depth;
+    m_maxFeature = maxFeature;
+    m_baseScore = baseScore;
+    m_objective = objective;
+    return true;
+}
+
+void TreeEnsemble::save(core::FlatArchiveWriter& archive, const std::string& prefix) const
+{
+    const std::int32_t header[5] = { m_count, m_depth, m_maxFeature, m_objective, 0 };
+    archive.add(prefix + ".header", header, sizeof(header));
+    archive.add(prefix + ".baseScore", &m_baseScore, sizeof(m_baseScore));
+
+    if (m_archive)
+    {
+        const std::size_t splits = std::size_t(m_count) * ((std::size_t(1) << m_depth) - 1);
+        const std::size_t leaves = std::size_t(m_count) * (std::size_t(1) << m_depth);
+        archive.add(prefix + ".feature", m_mapped.feature, splits * sizeof(std::uint16_t));
+        archive.add(prefix + ".threshold", m_mapped.threshold, splits * sizeof(float));
+        archive.add(prefix + ".defaultLeft", m_mapped.defaultLeft, splits * sizeof(std::uint8_t));
+        archive.add(prefix + ".leaf", m_mapped.leaf, leaves * sizeof(float));
+    }
+    else
+    {
+        archive.add(prefix + ".feature", m_feature);
+        archive.add(prefix + ".threshold", m_threshold);
+        archive.add(prefix + ".defaultLeft", m_defaultLeft);
+        archive.add(prefix + ".leaf", m_leaf);
+    }
+}
+
+bool TreeEnsemble::load(const std::shared_ptr<const core::FlatArchive>& archive, const std::string& prefix)
+{
+    *this = {};
+
+    std::size_t count = 0, baseScores = 0;
+    const auto* header = archive ? archive->get<std::int32_t>(prefix + ".header", count) : nullptr;
+    const auto* baseScore = archive ? archive->get<float>(prefix + ".baseScore", baseScores) : nullptr;
+    if (!header || (count != 5) || !baseScore || (baseScores != 1))
+    {
+        return false;
+    }
+
+    const int trees = header[0], depth = header[1];
+    if ((trees < 0) || (depth < 0) || (depth > DRISHTI_ML_TREE_ENSEMBLE_MAX_DEPTH))
+    {
+        return false;
+    }
+
+    const std::size_t splits = std::size_t(trees) * ((std::size_t(1) << depth) - 1);
+    const std::size_t leaves = std::size_t(trees) * (std::size_t(1) << depth);
+
+    Mapped mapped;
+    std::size_t sizes[4] = {};
+    mapped.feature = archive->get<std::uint16_t>(prefix + ".feature", sizes[0]);
+    mapped.threshold = archive->get<float>(prefix + ".threshold", sizes[1]);
+    mapped.defaultLeft = archive->get<std::uint8_t>(prefix + ".defaultLeft", sizes[2]);
+    mapped.leaf = archive->get<float>(prefix + ".leaf", sizes[3]);
+    if ((sizes[0] != splits) || (sizes[1] != splits) || (sizes[2] != splits) || (sizes[3] != leaves))
+    {
+        return false;
+    }
+
+    m_count = trees;
+    m_depth = depth;
+    m_maxFeature = header[2];
+    m_objective = header[3];
+    m_baseScore = *baseScore;
+    m_archive = archive;
+    m_mapped = mapped;
+    return true;
+}
+
+void TreeEnsemble::unmap()
+{
+    if (m_archive)
+    {
+        const std::size_t splits = std::size_t(m_count) * ((std::size_t(1) << m_depth) - 1);
+        const std::size_t leaves = std::size_t(m_count) * (std::size_t(1) << m_depth);
+        m_feature.assign(m_mapped.feature, m_mapped.feature + splits);
+        m_threshold.assign(m_mapped.threshold, m_mapped.threshold + splits);
+        m_defaultLeft.assign(m_mapped.defaultLeft, m_mapped.defaultLeft + splits);
+        m_leaf.assign(m_mapped.leaf, m_mapped.leaf + leaves);
+        m_archive = nullptr;
+        m_mapped = {};
+    }
+}
+
+float TreeEnsemble::operator()(const float* features) const
+{
+    float prediction = 0.f;
+    (*this)(features, 1, m_maxFeature + 1, 0, &prediction);
+    return prediction;
+}
+
+void TreeEnsemble::operator()(const float* data, int rows, int cols, int stride, float* predictions) const
+{
+    assert(cols > m_maxFeature);
+
+    const std::size_t splits = (std::size_t(1) << m_depth) - 1;
+    const std::size_t leaves = (std::size_t(1) << m_depth);
+
+    std::fill(predictions, predictions + rows, 0.f);
+
+    // Tree major order keeps each tree resident while it is applied to all rows.  Each row
+    // is still summed in tree order, then the bias and transform are applied (as in XGBoost).
+    const bool isMapped = (m_archive != nullptr);
+    const std::uint16_t* features0 = isMapped ? m_mapped.feature : m_feature.data();
+    const float* thresholds0 = isMapped ? m_mapped.threshold : m_threshold.data();
+    const std::uint8_t* defaultLefts0 = isMapped ? m_mapped.defaultLeft : m_defaultLeft.data();
+    const float* leaves0 = isMapped ? m_mapped.leaf : m_leaf.data();
+
+    for (int t = 0; t < m_count; t++)
+    {
+        const std::uint16_t* feature = features0 + t * splits;
+        const float* threshold = thresholds0 + t * splits;
+        const std::uint8_t* defaultLeft = defaultLefts0 + t * splits;
+        const float* leaf = leaves0 + t * leaves;
+
+        const float* features = data;
+        for (int r = 0; r < rows; r++, features += stride)
+        {
+            // (x < threshold) => left, NaN => default direction:
+            std::size_t i = 0;
+            for (int level = 0; level < m_depth; level++)
+            {
+                const float x = features[feature[i]];
+                const std::size_t right = defaultLeft[i] ? (x >= threshold[i]) : !(x < threshold[i]);
+                i = 2 * i + 1 + right;
+            }
+            predictions[r] += leaf[i - splits];
+        }
+    }
+
+    for (int r = 0; r < rows; r++)
+    {
+        const float margin = predictions[r] + m_baseScore;
+        predictions[r] = (m_objective == kLogistic) ? (1.0f / (1.0f + std::exp(-margin))) : margin;
+    }
+}
+
+DRISHTI_ML_NAMESPACE_END
@@ -0,0 +1,129 @@
+/*! -*-c++-*-
+  @file   TreeEnsemble.h
+  @author David Hirvonen
+  @brief  Declaration of a compact fixed depth regression tree ensemble evaluator.
+
+  \copyright Copyright 2014-2018 Elucideye, Inc. All rights reserved.
+  \license{This project is released under the 3 Clause BSD License.}
+
+  Gradient boosted trees (i.e., XGBoost gbtree models) are converted once into
+  complete binary trees of a common depth D.  Each tree is stored as (2^D - 1)
+  split nodes followed by 2^D leaves in contiguous arrays, so evaluation is a
+  fixed trip count loop with no runtime library on the hot path.  Shallow
+  leaves are replicated down to depth D.
+
+  The arrays can also be loaded from a memory mapped core::FlatArchive, in
+  which case the trees are evaluated in place (no deserialization).
+
+*/
+
+#ifndef __drishti_ml_TreeEnsemble_h__
+#define __drishti_ml_TreeEnsemble_h__
+
+#include "drishti/ml/drishti_ml.h"
+#include "drishti/core/FlatArchive.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define DRISHTI_ML_TREE_ENSEMBLE_MAX_DEPTH 12
+
+DRISHTI_ML_NAMESPACE_BEGIN
+
+class TreeEnsemble
+{
+public:
+    enum Objective
+    {
+        kLinear,  // reg:linear
+        kLogistic // binary:logistic
+    };
+
+    // Input node format (arbitrary binary tree, root at index 0):
+    struct Node
+    {
+        bool leaf = true;
+        int feature = 0;      // split feature index
+        float value = 0.f;    // split threshold (x < value => left) or leaf value
+        bool defaultLeft = false; // direction for missing (NaN) features
+        int left = -1;
+        int right = -1;
+    };
+    using Tree = std::vector<Node>;
+
+    TreeEnsemble() = default;
+
+    // Returns false (and leaves the ensemble empty) if a tree exceeds DRISHTI_ML_TREE_ENSEMBLE_MAX_DEPTH:
+    bool create(const std::vector<Tree>& trees, float baseScore, Objective objective);
+
+    // One prediction per row for rows of length cols (cols > getMaxFeature()):
+    void operator()(const float* data, int rows, int cols, int stride, float* predictions) const;
+    float operator()(const float* features) const;
+
+    bool empty() const
+    {
+        return m_count == 0;
+    }
+    int size() const
+    {
+        return m_count;
+    }
+    int getDepth() const
+    {
+        return m_depth;
+    }
+    int getMaxFeature() const
+    {
+        return m_maxFeature;
+    }
+
+    // Flat archive sections (prefix.*), load() references the archive data in place:
+    void save(core::FlatArchiveWriter& archive, const std::string& prefix) const;
+    bool load(const std::shared_ptr<const core::FlatArchive>& archive, const std::string& prefix);
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int version)
+    {
+        unmap(); // serialize owned arrays
+        ar& m_count;
+        ar& m_depth;
+        ar& m_maxFeature;
+        ar& m_baseScore;
+        ar& m_objective;
+        ar& m_feature;
+        ar& m_threshold;
+        ar& m_defaultLeft;
+        ar& m_leaf;
+    }
+
+protected:
+    void unmap(); // copy mapped arrays into the owned storage
+
+    int m_count = 0;
+    int m_depth = 0;
+    int m_maxFeature = -1;
+    float m_baseScore = 0.f;
+    int m_objective = kLinear;
+
+    std::vector<std::uint16_t> m_feature;    // [tree * (2^D - 1) + node]
+    std::vector<float> m_threshold;          // [tree * (2^D - 1) + node]
+    std::vector<std::uint8_t> m_defaultLeft; // [tree * (2^D - 1) + node]
+    std::vector<float> m_leaf;               // [tree * 2^D + leaf]
+
+    // Mapped arrays (when loaded from a flat archive), shared by copies:
+    struct Mapped
+    {
+        const std::uint16_t* feature = nullptr;
+        const float* threshold = nullptr;
+        const std::uint8_t* defaultLeft = nullptr;
+        const float* leaf = nullptr;
+    };
+    std::shared_ptr<const core::FlatArchive> m_archive;
+    Mapped m_mapped;
+};
+
+DRISHTI_ML_NAMESPACE_END
+
+#endif // __drishti_ml_TreeEnsemble_h__
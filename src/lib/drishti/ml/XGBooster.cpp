@@ -36,11 +36,16 @@ void XGBooster::setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
     }
 }
 
-float XGBooster::operator()(const std::vector<float>& features)
+float XGBooster::operator()(const std::vector<float>& features) const
 {
     return (*m_impl)(features);
 }
 
+void XGBooster::operator()(const cv::Mat1f& features, float* predictions) const
+{
+    (*m_impl)(features, predictions);
+}
+
 void XGBooster::train(const MatrixType<float>& features, const std::vector<float>& values, const MatrixType<uint8_t>& mask)
 {
 #if DRISHTI_BUILD_MIN_SIZE
@@ -50,6 +55,15 @@ void XGBooster::train(const MatrixType<float>& features, const std::vector<float
 #endif
 }
 
+void XGBooster::train(const cv::Mat1f& features, const std::vector<float>& values, const cv::Mat1b& mask)
+{
+#if DRISHTI_BUILD_MIN_SIZE
+    assert(false);
+#else
+    m_impl->train(features, values, mask);
+#endif
+}
+
 void XGBooster::read(const std::string& filename)
 {
 #if DRISHTI_BUILD_MIN_SIZE
@@ -67,4 +81,14 @@ void XGBooster::write(const std::string& filename) const
 #endif
 }
 
+bool XGBooster::map(const std::string& filename)
+{
+    return m_impl->map(filename);
+}
+
+bool XGBooster::writeFlat(const std::string& filename) const
+{
+    return m_impl->writeFlat(filename);
+}
+
 DRISHTI_ML_NAMESPACE_END
@@ -43,9 +43,16 @@ public:
     XGBooster();
     XGBooster(const Recipe& recipe);
     ~XGBooster();
-    float operator()(const std::vector<float>& features);
+    // Prediction is reentrant, so one (shared) booster can be evaluated from several threads:
+    float operator()(const std::vector<float>& features) const;
+
+    // Batch prediction: one output per row of features (N x F) written to predictions[0..N-1]
+    void operator()(const cv::Mat1f& features, float* predictions) const;
     void train(const MatrixType<float>& features, const std::vector<float>& values, const MatrixType<uint8_t>& mask = {});
 
+    // Contiguous (strided) N x F features with an optional N x F selection mask:
+    void train(const cv::Mat1f& features, const std::vector<float>& values, const cv::Mat1b& mask = {});
+
     XGBooster(const XGBooster&) = delete;
     XGBooster(XGBooster&&) = delete;
     XGBooster& operator=(const XGBooster&) = delete;
@@ -54,6 +61,10 @@ public:
     void read(const std::string& filename);
     void write(const std::string& filename) const;
 
+    // Compiled ensemble as a core::FlatArchive, map() evaluates it in place (no deserialization):
+    bool map(const std::string& filename);
+    bool writeFlat(const std::string& filename) const;
+
     // Boost serialization:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version);
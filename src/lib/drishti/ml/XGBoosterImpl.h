@@ -16,6 +16,8 @@
 #include "drishti/core/ThrowAssert.h"
 #include "drishti/ml/Booster.h"
 
+#include <mutex>
+
 DRISHTI_ML_NAMESPACE_BEGIN
 
 template <typename T>
@@ -82,20 +84,86 @@ public:
         }
     }
 
-    float operator()(const std::vector<float>& features)
+    float operator()(const std::vector<float>& features) const
     {
+        if (hasEnsemble(int(features.size())))
+        {
+            return m_ensemble(features.data());
+        }
+
+        float prediction = 0.f;
+        const auto cols = static_cast<bst_ulong>(features.size());
+        if (m_booster->PredictDense(features.data(), 1, cols, cols, &prediction))
+        {
+            return prediction;
+        }
+
         std::shared_ptr<DMatrixSimple> dTest = xgboost::DMatrixSimpleFromMat(&features[0], 1, features.size(), NAN);
         std::vector<float> predictions(1, 0.f);
-        m_booster->Predict(*dTest, false, &predictions);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_booster->Predict(*dTest, false, &predictions);
+        }
         return predictions.front();
     }
 
+    // Batch prediction for each row of an N x F matrix into caller owned storage:
+    void operator()(const cv::Mat1f& features, float* predictions) const
+    {
+        if (features.empty())
+        {
+            return;
+        }
+
+        if (hasEnsemble(features.cols))
+        {
+            return m_ensemble(features.ptr<float>(), features.rows, features.cols, int(features.step1()), predictions);
+        }
+
+        const auto rows = static_cast<bst_ulong>(features.rows);
+        const auto cols = static_cast<bst_ulong>(features.cols);
+        const auto stride = static_cast<bst_ulong>(features.step1());
+        if (!m_booster->PredictDense(features.ptr<float>(), rows, cols, stride, predictions))
+        {
+            // Generic path (one DMatrix for the whole batch):
+            cv::Mat1f dense = features.isContinuous() ? features : features.clone();
+            std::shared_ptr<DMatrixSimple> dTest = xgboost::DMatrixSimpleFromMat(dense.ptr<float>(), rows, cols, NAN);
+            std::vector<float> output;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_booster->Predict(*dTest, false, &output);
+            }
+            std::copy(output.begin(), output.end(), predictions);
+        }
+    }
+
     void train(const MatrixType<float>& features, const std::vector<float>& values, const MatrixType<uint8_t>& mask = {})
     {
 #if DRISHTI_BUILD_MIN_SIZE
         assert(false);
 #else
         std::shared_ptr<DMatrixSimple> dTrain = xgboost::DMatrixSimpleFromMat(features, features.size(), features[0].size(), mask);
+        train(dTrain, values);
+#endif
+    }
+
+    void train(const cv::Mat1f& features, const std::vector<float>& values, const cv::Mat1b& mask = {})
+    {
+#if DRISHTI_BUILD_MIN_SIZE
+        assert(false);
+#else
+        CV_Assert(mask.empty() || (mask.size() == features.size()));
+        const auto rows = static_cast<bst_ulong>(features.rows);
+        const auto cols = static_cast<bst_ulong>(features.cols);
+        const uint8_t* valid = mask.empty() ? nullptr : mask.ptr<uint8_t>();
+        std::shared_ptr<DMatrixSimple> dTrain = xgboost::DMatrixSimpleFromMat(features.ptr<float>(), rows, cols, features.step1(), valid, mask.step1());
+        train(dTrain, values);
+#endif
+    }
+
+#if !DRISHTI_BUILD_MIN_SIZE
+    void train(std::shared_ptr<DMatrixSimple>& dTrain, const std::vector<float>& values)
+    {
         dTrain->info.labels = values;
 
         std::vector<xgboost::learner::DMatrix*> dmats{ dTrain.get() };
@@ -107,8 +175,10 @@ public:
         {
             m_booster->UpdateOneIter(t, *dTrain);
         }
-#endif
+
+        compile();
     }
+#endif
 
     void read(const std::string& name)
     {
@@ -117,6 +187,7 @@ public:
 #else
         // normal XGBoost logging not needed with boost serialization
         m_booster->LoadModel(name.c_str());
+        compile();
 #endif
     }
 
@@ -129,11 +200,42 @@ public:
 #endif
     }
 
+    bool map(const std::string& name)
+    {
+        return m_ensemble.load(core::FlatArchive::map(name), "xgboost");
+    }
+
+    bool writeFlat(const std::string& name) const
+    {
+        core::FlatArchiveWriter archive;
+        m_ensemble.save(archive, "xgboost");
+        return !m_ensemble.empty() && archive.write(name);
+    }
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
         ar& m_recipe;
         ar& m_booster;
+
+        if (Archive::is_loading::value)
+        {
+            compile();
+        }
+    }
+
+    // Build the native evaluator, the xgboost runtime remains the fallback for unsupported models:
+    void compile()
+    {
+        if (!m_booster->Compile(m_ensemble))
+        {
+            m_ensemble = {};
+        }
+    }
+
+    bool hasEnsemble(int cols) const
+    {
+        return !m_ensemble.empty() && (cols > m_ensemble.getMaxFeature());
     }
 
     void setStreamLogger(std::shared_ptr<spdlog::logger>& logger)
@@ -148,6 +250,11 @@ public:
 protected:
     Recipe m_recipe;
     std::unique_ptr<xgboost::wrapper::Booster> m_booster;
+    TreeEnsemble m_ensemble; // compiled copy of m_booster
+
+    // The compiled ensemble and PredictDense() are reentrant, the xgboost runtime (thread local
+    // prediction buffers) is not, so the generic fallback is serialized:
+    mutable std::mutex m_mutex;
 
     std::shared_ptr<spdlog::logger> m_streamLogger;
 };
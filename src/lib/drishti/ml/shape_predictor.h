@@ -9,8 +9,10 @@
 #define DRISHTI_DLIB_DO_PCA_INTERNAL 1
 #define DRISHTI_DLIB_DO_HALF 1
 #define DRISHTI_DLIB_DO_NUMERIC_DEBUG 0
+#define DRISHTI_DLIB_DO_FLAT_FORESTS 1
 
 #include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
 
 // clang-format off
 #if DRISHTI_DLIB_DO_DEBUG_ELLIPSE
@@ -26,6 +28,7 @@
 
 #include <dlib/opencv.h>
 #include <dlib/opencv/cv_image.h>
+#include <dlib/array2d.h>
 #include <dlib/geometry/vector.h>
 #include <dlib/image_transforms/assign_image.h>
 #include <dlib/image_processing/full_object_detection.h>
@@ -43,14 +46,17 @@
 // DRISHTI_BUILD_REGRESSION_FIXED_POINT
 
 #define DRISHTI_BUILD_PARALLEL_BOOSTING 1
+#define DRISHTI_ML_MAX_BOOSTING_WORKERS 4
+#define DRISHTI_ML_MIN_TREES_PER_WORKER 64
 
 // clang-format off
 #if DRISHTI_BUILD_PARALLEL_BOOSTING
-#  include "drishti/core/Parallel.h"
+#  include "drishti/core/WorkerGroup.h"
 #endif
 // clang-format on
 
-#define FIXED_PRECISION 10
+#define FIXED_PRECISION 10     // default leaf fraction bits (see impl::calibrate_fixed_point())
+#define FIXED_PRECISION_MAX 14 // calibrated levels with small leaves
 
 // clang-format off
 #if defined(ANDROID)
@@ -70,7 +76,14 @@
 #include <opencv2/core/core.hpp>
 
 // STL
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <deque>
+#include <limits>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
 DRISHTI_ML_NAMESPACE_BEGIN
@@ -300,6 +313,40 @@ struct regression_tree
     std::vector<split_feature> splits;
     std::vector<fshape> leaf_values;
     std::vector<DVec16s> leaf_values_16;
+    std::vector<std::int8_t> leaf_values_8; // (optional) quantized leaves [leaf * dim + k], see shape_predictor::quantize()
+
+    // Quantize leaves with a shared (per cascade level) scale, leaf_values become the dequantized values:
+    void quantize(float scale)
+    {
+        leaf_values_8.clear();
+        for (auto& leaf : leaf_values)
+        {
+            for (long k = 0; k < leaf.size(); k++)
+            {
+                const float code = std::max(-127.f, std::min(127.f, std::round(leaf(k) / scale)));
+                leaf_values_8.push_back(static_cast<std::int8_t>(code));
+            }
+        }
+        dequantize(scale, leaf_values.size() ? int(leaf_values.front().size()) : 0);
+    }
+
+    // Restore leaf_values and leaf_values_16 from leaf_values_8:
+    void dequantize(float scale, int dim)
+    {
+        const std::size_t count = dim ? (leaf_values_8.size() / dim) : 0;
+        leaf_values.resize(count);
+        leaf_values_16.resize(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            leaf_values[i].set_size(dim);
+            leaf_values_16[i].set_size(dim);
+            for (int k = 0; k < dim; k++)
+            {
+                leaf_values[i](k) = float(leaf_values_8[i * dim + k]) * scale;
+            }
+            drishti::core::convertFixedPoint(&leaf_values[i](0), &leaf_values_16[i](0), dim, FIXED_PRECISION);
+        }
+    }
 
     inline const DVec16s& operator()(
         const std::vector<float>& feature_pixel_values,
@@ -420,6 +467,387 @@ struct regression_tree
 
 // ------------------------------------------------------------------------------------
 
+/*
+ * Fixed point format for one cascade level: the largest number of fraction bits (up to
+ * FIXED_PRECISION_MAX) for which every int16 leaf value, and the int32 sum of one leaf per
+ * tree, are representable.  leaf_values_16 is rebuilt with that format, and the largest
+ * leaf conversion error is returned in error (> 2^-fraction means saturation).
+ */
+inline int calibrate_fixed_point(std::vector<regression_tree>& trees, float* error = nullptr)
+{
+    float leaf_max = 0.f;
+    for (const auto& tree : trees)
+    {
+        for (const auto& leaf : tree.leaf_values)
+        {
+            leaf_max = std::max(leaf_max, leaf.size() ? float(dlib::max(dlib::abs(leaf))) : 0.f);
+        }
+    }
+
+    int fraction = FIXED_PRECISION;
+    if (leaf_max > 0.f)
+    {
+        const double sum_max = double(leaf_max) * double(std::max<std::size_t>(trees.size(), 1));
+        fraction = FIXED_PRECISION_MAX;
+        while ((fraction > 0) && ((double(leaf_max) * double(1 << fraction) > double(std::numeric_limits<std::int16_t>::max())) || (sum_max * double(1 << fraction) > double(std::numeric_limits<std::int32_t>::max()))))
+        {
+            fraction--;
+        }
+    }
+
+    float max_error = 0.f;
+    const float unit = 1.f / float(1 << fraction);
+    for (auto& tree : trees)
+    {
+        tree.leaf_values_16.resize(tree.leaf_values.size());
+        for (std::size_t i = 0; i < tree.leaf_values.size(); i++)
+        {
+            auto& leaf = tree.leaf_values[i];
+            auto& leaf16 = tree.leaf_values_16[i];
+            leaf16.set_size(leaf.size());
+            if (leaf.size())
+            {
+                drishti::core::convertFixedPoint(&leaf(0), &leaf16(0), int(leaf.size()), fraction);
+            }
+            for (long k = 0; k < leaf.size(); k++)
+            {
+                max_error = std::max(max_error, std::abs(leaf(k) - float(leaf16(k)) * unit));
+            }
+        }
+    }
+
+    if (error)
+    {
+        *error = max_error;
+    }
+    return fraction;
+}
+
+// ------------------------------------------------------------------------------------
+
+/*
+ * Compiled (flattened) representation of one cascade level.  All trees in the level
+ * are packed into contiguous structure-of-arrays storage so that evaluation walks
+ * a few linear arrays instead of chasing per-tree heap allocations:
+ *
+ *   split_idx1, split_idx2, split_thresh : [split_offset[t] + node]
+ *   leaf_values_16, leaf_values          : [leaf_offset[t] + leaf * dim + k]
+ *
+ * The fixed point (DVec16s) and floating point (fshape) leaf blobs mirror the
+ * regression_tree::leaf_values_16 and regression_tree::leaf_values members.  For
+ * quantized levels (leaf_scale > 0) only the int8 blob is stored:
+ *
+ *   leaf_values_8                        : [leaf_offset[t] + leaf * dim + k] * leaf_scale
+ *
+ * and the codes are summed in int32 before a single rescale per level (or block).
+ * Fixed point leaves have fraction bits (see calibrate_fixed_point()).
+ */
+struct flat_forest
+{
+    flat_forest() = default;
+    explicit flat_forest(const std::vector<regression_tree>& trees, float scale = 0.f, int fraction_ = FIXED_PRECISION)
+    {
+        build(trees, scale, fraction_);
+    }
+
+    void build(const std::vector<regression_tree>& trees, float scale = 0.f, int fraction_ = FIXED_PRECISION)
+    {
+        fraction = fraction_;
+        dim = trees.size() && trees.front().leaf_values.size() ? int(trees.front().leaf_values.front().size()) : 0;
+
+        std::size_t total_splits = 0, total_leaves = 0;
+        for (const auto& tree : trees)
+        {
+            total_splits += tree.splits.size();
+            total_leaves += tree.leaf_values.size();
+        }
+
+        split_idx1.clear();
+        split_idx2.clear();
+        split_thresh.clear();
+        leaf_values.clear();
+        leaf_values_16.clear();
+        leaf_values_8.clear();
+        split_offset.assign(1, 0);
+        leaf_offset.assign(1, 0);
+
+        const bool is_quantized = (scale > 0.f) && std::all_of(trees.begin(), trees.end(), [&](const regression_tree& tree) {
+            return tree.leaf_values_8.size() == (tree.leaf_values.size() * dim);
+        });
+        leaf_scale = is_quantized ? scale : 0.f;
+
+        split_idx1.reserve(total_splits);
+        split_idx2.reserve(total_splits);
+        split_thresh.reserve(total_splits);
+        if (is_quantized)
+        {
+            leaf_values_8.reserve(total_leaves * dim);
+        }
+        else
+        {
+            leaf_values.reserve(total_leaves * dim);
+            leaf_values_16.reserve(total_leaves * dim);
+        }
+
+        for (const auto& tree : trees)
+        {
+            for (const auto& node : tree.splits)
+            {
+                split_idx1.push_back(node.idx1);
+                split_idx2.push_back(node.idx2);
+                split_thresh.push_back(node.thresh);
+            }
+
+            split_offset.push_back(split_idx1.size());
+
+            if (is_quantized)
+            {
+                leaf_values_8.insert(leaf_values_8.end(), tree.leaf_values_8.begin(), tree.leaf_values_8.end());
+                leaf_offset.push_back(leaf_values_8.size());
+                continue;
+            }
+
+            const bool has_fixed = (tree.leaf_values_16.size() == tree.leaf_values.size());
+            for (std::size_t i = 0; i < tree.leaf_values.size(); i++)
+            {
+                const auto& leaf = tree.leaf_values[i];
+                assert(leaf.size() == dim);
+                leaf_values.insert(leaf_values.end(), &leaf(0), &leaf(0) + dim);
+                if (has_fixed)
+                {
+                    const auto& leaf16 = tree.leaf_values_16[i];
+                    leaf_values_16.insert(leaf_values_16.end(), &leaf16(0), &leaf16(0) + dim);
+                }
+                else
+                {
+                    leaf_values_16.resize(leaf_values_16.size() + dim);
+                    drishti::core::convertFixedPoint(&leaf(0), &leaf_values_16[leaf_values_16.size() - dim], dim, fraction);
+                }
+            }
+
+            leaf_offset.push_back(leaf_values.size());
+        }
+    }
+
+    bool isQuantized() const
+    {
+        return leaf_scale > 0.f;
+    }
+
+    // Sum of the int8 leaf codes for trees [begin, end), passed to consume(sums) from thread local scratch:
+    template <typename Consumer>
+    void sum_codes(const std::vector<float>& feature_pixel_values, std::size_t begin, std::size_t end, bool do_npd, Consumer&& consume) const
+    {
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+        static thread_local std::vector<std::int32_t> sums;
+#else
+        std::vector<std::int32_t> sums; // per call without C++11 thread_local
+#endif
+        sums.assign(dim, 0);
+
+        const float* values = feature_pixel_values.data();
+        for (std::size_t t = begin; t < end; t++)
+        {
+            const std::int8_t* code = &leaf_values_8[do_npd ? leaf<true>(t, values) : leaf<false>(t, values)];
+            for (int k = 0; k < dim; k++)
+            {
+                sums[k] += code[k];
+            }
+        }
+        consume(sums.data());
+    }
+
+    std::size_t size() const
+    {
+        return split_offset.size() - 1;
+    }
+
+    // Returns the offset of the first leaf element (in either blob) reached by tree t:
+    template <bool do_npd>
+    inline std::size_t leaf(std::size_t t, const float* feature_pixel_values) const
+    {
+        const std::size_t base = split_offset[t];
+        const std::size_t count = split_offset[t + 1] - base;
+        const std::uint16_t* idx1 = &split_idx1[base];
+        const std::uint16_t* idx2 = &split_idx2[base];
+        const float* thresh = &split_thresh[base];
+
+        unsigned long i = 0;
+        while (i < count)
+        {
+            const float a = feature_pixel_values[idx1[i]];
+            const float b = feature_pixel_values[idx2[i]];
+            const float value = do_npd ? compute_npd(a, b) : (a - b);
+            i = (value > thresh[i]) ? left_child(i) : right_child(i);
+        }
+        return leaf_offset[t] + (i - count) * dim;
+    }
+
+    // Fixed point accumulation of trees [begin, end) into accumulator (DVec16s or DVec32s):
+    template <typename FixedAccumulator>
+    void accumulate(const std::vector<float>& feature_pixel_values, std::size_t begin, std::size_t end, bool do_npd, FixedAccumulator& accumulator) const
+    {
+        if (!accumulator.size())
+        {
+            accumulator.set_size(dim);
+            accumulator = 0;
+        }
+
+        if (isQuantized())
+        {
+            const float gain = leaf_scale * float(1 << fraction);
+            sum_codes(feature_pixel_values, begin, end, do_npd, [&](const std::int32_t* sums) {
+                for (int k = 0; k < dim; k++)
+                {
+                    accumulator(k) += static_cast<typename FixedAccumulator::type>(std::lround(float(sums[k]) * gain));
+                }
+            });
+            return;
+        }
+
+        const float* values = feature_pixel_values.data();
+        for (std::size_t t = begin; t < end; t++)
+        {
+            add_leaf(accumulator, do_npd ? leaf<true>(t, values) : leaf<false>(t, values));
+        }
+    }
+
+    // Floating point accumulation of all trees into accumulator:
+    void accumulate(const std::vector<float>& feature_pixel_values, bool do_npd, fshape& accumulator) const
+    {
+        if (!accumulator.size())
+        {
+            accumulator.set_size(dim);
+            accumulator = 0.f;
+        }
+
+        if (isQuantized())
+        {
+            sum_codes(feature_pixel_values, 0, size(), do_npd, [&](const std::int32_t* sums) {
+                for (int k = 0; k < dim; k++)
+                {
+                    accumulator(k) += float(sums[k]) * leaf_scale;
+                }
+            });
+            return;
+        }
+
+        const float* values = feature_pixel_values.data();
+        for (std::size_t t = 0; t < size(); t++)
+        {
+            const float* delta = &leaf_values[do_npd ? leaf<true>(t, values) : leaf<false>(t, values)];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+            drishti::core::add32f(&accumulator(0), delta, &accumulator(0), dim);
+#else
+            for (int k = 0; k < dim; k++)
+            {
+                accumulator(k) += delta[k];
+            }
+#endif
+        }
+    }
+
+    // Tree major accumulation for a batch of feature vectors (e.g., jittered inits of the same image),
+    // each tree's splits and leaves are fetched once for the whole batch:
+    template <typename Accumulator>
+    void accumulate(const std::vector<const std::vector<float>*>& batch, bool do_npd, const std::vector<Accumulator*>& accumulators) const
+    {
+        assert(batch.size() == accumulators.size());
+        for (std::size_t b = 0; b < batch.size(); b++)
+        {
+            if (isQuantized())
+            {
+                accumulate(*batch[b], do_npd, *accumulators[b]); // code sums are per feature vector
+            }
+            else if (!accumulators[b]->size())
+            {
+                accumulators[b]->set_size(dim);
+                *accumulators[b] = 0;
+            }
+        }
+
+        if (isQuantized())
+        {
+            return;
+        }
+
+        for (std::size_t t = 0; t < size(); t++)
+        {
+            for (std::size_t b = 0; b < batch.size(); b++)
+            {
+                const float* values = batch[b]->data();
+                add_leaf(*accumulators[b], do_npd ? leaf<true>(t, values) : leaf<false>(t, values));
+            }
+        }
+    }
+
+    int dim = 0; // leaf vector length (shape or PCA dimension)
+
+    std::vector<std::uint16_t> split_idx1;
+    std::vector<std::uint16_t> split_idx2;
+    std::vector<float> split_thresh;
+    std::vector<std::size_t> split_offset; // size() + 1 entries
+
+    std::vector<std::int16_t> leaf_values_16;
+    std::vector<float> leaf_values;
+    std::vector<std::int8_t> leaf_values_8;
+    std::vector<std::size_t> leaf_offset; // size() + 1 entries
+    float leaf_scale = 0.f;               // int8 code scale (0 == not quantized)
+    int fraction = FIXED_PRECISION;       // leaf_values_16 fraction bits
+
+protected:
+    void accumulate(const std::vector<float>& feature_pixel_values, bool do_npd, DVec16s& accumulator) const
+    {
+        accumulate(feature_pixel_values, 0, size(), do_npd, accumulator);
+    }
+
+    void accumulate(const std::vector<float>& feature_pixel_values, bool do_npd, DVec32s& accumulator) const
+    {
+        accumulate(feature_pixel_values, 0, size(), do_npd, accumulator);
+    }
+
+    void add_leaf(fshape& accumulator, std::size_t offset) const
+    {
+        const float* delta = &leaf_values[offset];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+        drishti::core::add32f(&accumulator(0), delta, &accumulator(0), dim);
+#else
+        for (int k = 0; k < dim; k++)
+        {
+            accumulator(k) += delta[k];
+        }
+#endif
+    }
+
+    void add_leaf(DVec16s& accumulator, std::size_t offset) const
+    {
+        const std::int16_t* delta = &leaf_values_16[offset];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+        drishti::core::add16sAnd16s(&accumulator(0), delta, &accumulator(0), dim);
+#else
+        for (int k = 0; k < dim; k++)
+        {
+            accumulator(k) += delta[k];
+        }
+#endif
+    }
+
+    void add_leaf(DVec32s& accumulator, std::size_t offset) const
+    {
+        const std::int16_t* delta = &leaf_values_16[offset];
+#if DRISHTI_BUILD_REGRESSION_SIMD
+        drishti::core::add16sAnd32s(&accumulator(0), delta, &accumulator(0), dim);
+#else
+        for (int k = 0; k < dim; k++)
+        {
+            accumulator(k) += delta[k];
+        }
+#endif
+    }
+};
+
+// ------------------------------------------------------------------------------------
+
 inline dlib::vector<float, 2> location(
     const fshape& shape,
     unsigned long idx)
@@ -488,6 +916,71 @@ inline void create_shape_relative_encoding(
 
 // ------------------------------------------------------------------------------------
 
+// Least squares similarity (or affine) transform between the first num points of two packed
+// shapes { x0, y0, x1, y1, ... }.  In 2D the similarity solution has a closed form (Umeyama
+// without the SVD), so this is allocation free.  NumPoints > 0 fixes the point count at compile
+// time, so the reductions are unrolled for the deployed models (see find_tform_between_shapes()):
+template <int NumPoints>
+dlib::point_transform_affine find_tform_between_points(const float* from, const float* to, int num, bool do_affine)
+{
+    const int n = (NumPoints > 0) ? NumPoints : num;
+
+    double mf[2] = { 0.0, 0.0 }, mt[2] = { 0.0, 0.0 };
+    for (int i = 0; i < n; i++)
+    {
+        mf[0] += from[i * 2 + 0];
+        mf[1] += from[i * 2 + 1];
+        mt[0] += to[i * 2 + 0];
+        mt[1] += to[i * 2 + 1];
+    }
+    for (int k = 0; k < 2; k++)
+    {
+        mf[k] /= n;
+        mt[k] /= n;
+    }
+
+    // Second moments of the centered points: C = sum(f * f^T), D = sum(t * f^T)
+    double cxx = 0.0, cxy = 0.0, cyy = 0.0, dxx = 0.0, dxy = 0.0, dyx = 0.0, dyy = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        const double fx = from[i * 2 + 0] - mf[0], fy = from[i * 2 + 1] - mf[1];
+        const double tx = to[i * 2 + 0] - mt[0], ty = to[i * 2 + 1] - mt[1];
+        cxx += fx * fx;
+        cxy += fx * fy;
+        cyy += fy * fy;
+        dxx += tx * fx;
+        dxy += tx * fy;
+        dyx += ty * fx;
+        dyy += ty * fy;
+    }
+
+    dlib::matrix<double, 2, 2> m;
+    m = 1.0, 0.0, 0.0, 1.0;
+    if (do_affine)
+    {
+        // M = D * C^-1
+        const double det = cxx * cyy - cxy * cxy;
+        if (std::abs(det) > std::numeric_limits<double>::epsilon())
+        {
+            m = (dxx * cyy - dxy * cxy) / det, (dxy * cxx - dxx * cxy) / det,
+                (dyx * cyy - dyy * cxy) / det, (dyy * cxx - dyx * cxy) / det;
+        }
+    }
+    else
+    {
+        // M = [ a -b ; b a ]
+        const double norm = cxx + cyy;
+        if (norm > 0.0)
+        {
+            const double a = (dxx + dyy) / norm, b = (dyx - dxy) / norm;
+            m = a, -b, b, a;
+        }
+    }
+
+    const dlib::vector<double, 2> b(mt[0] - (m(0, 0) * mf[0] + m(0, 1) * mf[1]), mt[1] - (m(1, 0) * mf[0] + m(1, 1) * mf[1]));
+    return dlib::point_transform_affine(m, b);
+}
+
 inline dlib::point_transform_affine find_tform_between_shapes(
     const fshape& from_shape,
     const fshape& to_shape,
@@ -495,22 +988,26 @@ inline dlib::point_transform_affine find_tform_between_shapes(
     bool do_affine = false)
 {
     DLIB_ASSERT(from_shape.size() == to_shape.size() && ((from_shape.size() - (ellipse_count * 5)) % 2) == 0 && from_shape.size() > 0, "");
-    PointVecf from_points, to_points;
-    const unsigned long num = (from_shape.size() - (ellipse_count * 5)) / 2;
-    from_points.reserve(num);
-    to_points.reserve(num);
+    const int num = static_cast<int>((from_shape.size() - (ellipse_count * 5)) / 2);
     if (num == 1)
     {
         // Just use an identity transform if there is only one landmark.
         return {};
     }
 
-    for (unsigned long i = 0; i < num; ++i)
+    // Fixed kernels for the deployed face models (kibug68 and kibug68_inner), eye model point
+    // counts vary with the model and use the generic kernel:
+    const float* from = &from_shape(0);
+    const float* to = &to_shape(0);
+    switch (num)
     {
-        from_points.push_back(location(from_shape, i));
-        to_points.push_back(location(to_shape, i));
+        case 68:
+            return find_tform_between_points<68>(from, to, num, do_affine);
+        case 51:
+            return find_tform_between_points<51>(from, to, num, do_affine);
+        default:
+            return find_tform_between_points<0>(from, to, num, do_affine);
     }
-    return do_affine ? find_affine_transform(from_points, to_points) : find_similarity_transform(from_points, to_points);
 }
 
 // ------------------------------------------------------------------------------------
@@ -545,29 +1042,168 @@ inline dlib::point_transform_affine unnormalizing_tform(
 
 // ------------------------------------------------------------------------------------
 
+inline dlib::point_transform_affine mirroring_tform(
+    const dlib::point_transform_affine& tform,
+    long cols)
+/*!
+    ensures
+        - returns tform followed by a reflection about the vertical image axis
+          (x -> cols - 1 - x), i.e., pixel lookups read the image as cv::flip(img, 1)
+!*/
+{
+    dlib::matrix<double, 2, 2> m = tform.get_m();
+    dlib::vector<double, 2> b = tform.get_b();
+    m(0, 0) = -m(0, 0);
+    m(0, 1) = -m(0, 1);
+    b.x() = static_cast<double>(cols - 1) - b.x();
+    return dlib::point_transform_affine(m, b);
+}
+
+inline dlib::point_transform_affine scaling_tform(
+    const dlib::point_transform_affine& tform,
+    double scale)
+/*!
+    ensures
+        - returns tform followed by a mapping to an image downscaled by scale, with
+          pixel centers aligned as in cv::resize(), i.e., x -> (x + 0.5) * scale - 0.5
+!*/
+{
+    const double offset = 0.5 * scale - 0.5;
+    return dlib::point_transform_affine(tform.get_m() * scale, tform.get_b() * scale + dlib::vector<double, 2>(offset, offset));
+}
+
+// ------------------------------------------------------------------------------------
+
 template <typename image_type>
-void extract_feature_pixel_values(
-    const image_type& img_,
-    const dlib::rectangle& rect,
-    const fshape& current_shape,
-    const std::vector<InterpolatedFeature>& interpolated_features,
-    std::vector<float>& feature_pixel_values)
+using is_gray8u = std::is_same<typename dlib::image_traits<image_type>::pixel_type, unsigned char>;
+
+template <typename image_type>
+cv::Mat1b as_gray8u(const image_type& img, std::true_type)
 {
-    const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
-    const dlib::rectangle area = get_rect(img_);
-    dlib::const_image_view<image_type> img(img_);
-    feature_pixel_values.resize(interpolated_features.size());
-    for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
+    return dlib::toMat(const_cast<image_type&>(img)); // shallow
+}
+
+template <typename image_type>
+cv::Mat1b as_gray8u(const image_type& img, std::false_type)
+{
+    dlib::array2d<unsigned char> gray;
+    dlib::assign_image(gray, img);
+    return dlib::toMat(gray).clone();
+}
+
+// Lazy 2:1 grayscale pyramid for cascade levels that sample a downscaled image (see
+// shape_predictor::octaves).  Octave k is only built when a level asks for it:
+class octave_pyramid
+{
+public:
+    template <typename image_type>
+    const cv::Mat1b& get(const image_type& img, int octave)
     {
-        auto p = interpolate_feature_point(interpolated_features[i], current_shape);
-        dlib::point q = tform_to_img(p);
-        if (area.contains(q))
+        if (levels.empty())
         {
-            feature_pixel_values[i] = dlib::get_pixel_intensity(img[q.y()][q.x()]);
+            levels.push_back(as_gray8u(img, is_gray8u<image_type>()));
         }
-        else
+        while (static_cast<int>(levels.size()) <= octave)
         {
-            feature_pixel_values[i] = 0;
+            cv::Mat1b half;
+            const cv::Mat1b& last = levels.back();
+            cv::resize(last, half, { (last.cols + 1) / 2, (last.rows + 1) / 2 }, 0.0, 0.0, cv::INTER_AREA);
+            levels.push_back(half);
+        }
+        return levels[octave];
+    }
+
+    static float scale(int octave) { return 1.f / static_cast<float>(1 << octave); }
+
+protected:
+    std::vector<cv::Mat1b> levels; // levels[0] is the full resolution image
+};
+
+// ------------------------------------------------------------------------------------
+
+#if DRISHTI_BUILD_REGRESSION_SIMD
+// Vectorized transform + gather for 8 bit images (see drishti::core::transformAndGather8u),
+// returns false for other pixel types so the caller can fall back to the generic path.
+template <typename image_type>
+bool gather_feature_pixel_values(
+    const image_type& img_,
+    const dlib::point_transform_affine& tform_to_img,
+    const float* anchors,
+    int n,
+    const float* deltas,
+    const float* T,
+    std::vector<float>& feature_pixel_values,
+    std::true_type)
+{
+    const auto& m = tform_to_img.get_m();
+    const auto& b = tform_to_img.get_b();
+    const float H[6] = { float(m(0, 0)), float(m(0, 1)), float(b(0)), float(m(1, 0)), float(m(1, 1)), float(b(1)) };
+
+    const auto* image = static_cast<const std::uint8_t*>(dlib::image_data(img_));
+    const auto stride = static_cast<int>(dlib::width_step(img_));
+    const auto cols = static_cast<int>(dlib::num_columns(img_));
+    const auto rows = static_cast<int>(dlib::num_rows(img_));
+
+    feature_pixel_values.resize(n);
+    drishti::core::transformAndGather8u(image, stride, cols, rows, anchors, deltas, T, H, feature_pixel_values.data(), n);
+    return true;
+}
+
+template <typename image_type>
+bool gather_feature_pixel_values(const image_type&, const dlib::point_transform_affine&, const float*, int, const float*, const float*, std::vector<float>&, std::false_type)
+{
+    return false;
+}
+#endif // DRISHTI_BUILD_REGRESSION_SIMD
+
+template <typename image_type>
+void extract_feature_pixel_values(
+    const image_type& img_,
+    const dlib::rectangle& rect,
+    const fshape& current_shape,
+    const std::vector<InterpolatedFeature>& interpolated_features,
+    std::vector<float>& feature_pixel_values,
+    bool mirrored = false,
+    float scale = 1.f,
+    std::vector<float>* scratch = nullptr) // (optional) caller owned buffer for the SIMD path
+{
+    const dlib::point_transform_affine tform = scaling_tform(unnormalizing_tform(rect), scale);
+    const dlib::point_transform_affine tform_to_img = mirrored ? mirroring_tform(tform, dlib::num_columns(img_)) : tform;
+
+#if DRISHTI_BUILD_REGRESSION_SIMD
+    if (is_gray8u<image_type>::value)
+    {
+        std::vector<float> local;
+        std::vector<float>& points = scratch ? *scratch : local;
+        points.resize(interpolated_features.size() * 2);
+        for (std::size_t i = 0; i < interpolated_features.size(); ++i)
+        {
+            const auto p = interpolate_feature_point(interpolated_features[i], current_shape);
+            points[i * 2 + 0] = p.x();
+            points[i * 2 + 1] = p.y();
+        }
+
+        const auto n = static_cast<int>(interpolated_features.size());
+        if (gather_feature_pixel_values(img_, tform_to_img, points.data(), n, nullptr, nullptr, feature_pixel_values, is_gray8u<image_type>()))
+        {
+            return;
+        }
+    }
+#endif
+    const dlib::rectangle area = get_rect(img_);
+    dlib::const_image_view<image_type> img(img_);
+    feature_pixel_values.resize(interpolated_features.size());
+    for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
+    {
+        auto p = interpolate_feature_point(interpolated_features[i], current_shape);
+        dlib::point q = tform_to_img(p);
+        if (area.contains(q))
+        {
+            feature_pixel_values[i] = dlib::get_pixel_intensity(img[q.y()][q.x()]);
+        }
+        else
+        {
+            feature_pixel_values[i] = 0;
         }
     }
 }
@@ -582,7 +1218,10 @@ void extract_feature_pixel_values(
     const PointVecf& reference_pixel_deltas,
     std::vector<float>& feature_pixel_values,
     int ellipse_count = 0,
-    bool do_affine = false)
+    bool do_affine = false,
+    bool mirrored = false,
+    float scale = 1.f,
+    std::vector<float>* scratch = nullptr)
 /*!
     requires
         - image_type == an image object that implements the interface defined in
@@ -598,10 +1237,42 @@ void extract_feature_pixel_values(
               corresponds to the pixel identified by reference_pixel_anchor_idx[i]
               and reference_pixel_deltas[i] when the pixel is located relative to
               current_shape rather than reference_shape.
+        - if mirrored, pixels are read as if img_ were flipped about the vertical
+          axis (shapes remain in the flipped coordinate system)
+        - if scale < 1, img_ is the full resolution image downscaled by scale (rect and
+          shapes remain in full resolution coordinates)
+        - scratch (optional) is reused for the SIMD anchors and deltas (no allocation per call)
 !*/
 {
     const dlib::matrix<float, 2, 2> tform = dlib::matrix_cast<float>(find_tform_between_shapes(reference_shape, current_shape, ellipse_count, do_affine).get_m());
-    const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
+    const dlib::point_transform_affine tform_rect = scaling_tform(unnormalizing_tform(rect), scale);
+    const dlib::point_transform_affine tform_to_img = mirrored ? mirroring_tform(tform_rect, dlib::num_columns(img_)) : tform_rect;
+
+#if DRISHTI_BUILD_REGRESSION_SIMD && !DRISHTI_DLIB_DO_VISUALIZE_FEATURE_POINTS
+    if (is_gray8u<image_type>::value)
+    {
+        const auto n = reference_pixel_deltas.size();
+        std::vector<float> local;
+        std::vector<float>& points = scratch ? *scratch : local;
+        points.resize(n * 4);
+        float* anchors = points.data();
+        float* deltas = anchors + n * 2;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const auto p0 = location(current_shape, reference_pixel_anchor_idx[i]);
+            anchors[i * 2 + 0] = p0.x();
+            anchors[i * 2 + 1] = p0.y();
+            deltas[i * 2 + 0] = reference_pixel_deltas[i].x();
+            deltas[i * 2 + 1] = reference_pixel_deltas[i].y();
+        }
+
+        const float T[4] = { tform(0, 0), tform(0, 1), tform(1, 0), tform(1, 1) };
+        if (gather_feature_pixel_values(img_, tform_to_img, anchors, static_cast<int>(n), deltas, T, feature_pixel_values, is_gray8u<image_type>()))
+        {
+            return;
+        }
+    }
+#endif
 
     const dlib::rectangle area = get_rect(img_);
 
@@ -756,20 +1427,129 @@ public:
 
     void populate_f16()
     {
-        for (auto& f : forests)
+        calibrate_fixed_point();
+
+#if DRISHTI_DLIB_DO_FLAT_FORESTS
+        compile();
+#endif
+        configure_workers();
+    }
+
+    /*
+     * Select the number of boosting lanes (0 == automatic).  Parallel evaluation is
+     * only enabled when every lane gets a meaningful block of trees per cascade level,
+     * otherwise the synchronization costs more than it saves.
+     */
+    void configure_workers(int workers = 0)
+    {
+        m_workers.reset();
+        m_num_workers = 1;
+
+#if DRISHTI_BUILD_REGRESSION_FIXED_POINT && DRISHTI_BUILD_PARALLEL_BOOSTING
+        if (workers <= 0)
         {
-            for (auto& g : f)
+            std::size_t trees = 0;
+            for (const auto& f : forests)
             {
-                g.leaf_values_16.resize(g.leaf_values.size());
-                for (int i = 0; i < g.leaf_values.size(); i++)
+                trees += f.size();
+            }
+            const std::size_t trees_per_level = forests.size() ? (trees / forests.size()) : 0;
+            const int cores = std::max(1, int(std::thread::hardware_concurrency()));
+            workers = std::min({ cores, DRISHTI_ML_MAX_BOOSTING_WORKERS, int(trees_per_level / DRISHTI_ML_MIN_TREES_PER_WORKER) });
+        }
+
+        if (workers > 1)
+        {
+            m_num_workers = workers;
+            m_workers = std::make_shared<boosting_workers>(workers);
+        }
+#endif
+    }
+
+    /*
+     * Fixed point leaves are calibrated per cascade level from the leaf value ranges (see
+     * impl::calibrate_fixed_point()) and summed in int32, so the fixed point path is safe
+     * for full shape models as well as PCA models.  Levels with leaves that don't convert
+     * within one unit (2^-fraction) are reported, and return false.
+     */
+    bool calibrate_fixed_point()
+    {
+        bool valid = true;
+        fixed_fractions.assign(forests.size(), FIXED_PRECISION);
+        for (std::size_t i = 0; i < forests.size(); i++)
+        {
+            float error = 0.f;
+            fixed_fractions[i] = impl::calibrate_fixed_point(forests[i], &error);
+            if (error > (1.f / float(1 << fixed_fractions[i])))
+            {
+                valid = false;
+                if (m_streamLogger)
                 {
-                    auto& leaf = g.leaf_values[i];
-                    auto& leaf16 = g.leaf_values_16[i];
-                    leaf16.set_size(leaf.size());
-                    drishti::core::convertFixedPoint(&leaf(0, 0), &leaf16(0, 0), int(leaf.size()), FIXED_PRECISION);
+                    m_streamLogger->warn("shape_predictor: level {} fixed point error {} (fraction {})", i, error, fixed_fractions[i]);
                 }
             }
         }
+        return valid;
+    }
+
+    int get_fixed_fraction(std::size_t level) const
+    {
+        return (level < fixed_fractions.size()) ? fixed_fractions[level] : FIXED_PRECISION;
+    }
+
+    // Pack each cascade level into a contiguous (cache friendly) flat_forest:
+    void compile()
+    {
+        flat_forests.clear();
+        flat_forests.reserve(forests.size());
+        for (std::size_t i = 0; i < forests.size(); i++)
+        {
+            flat_forests.emplace_back(forests[i], isQuantized() ? leaf_scales[i] : 0.f, get_fixed_fraction(i));
+        }
+    }
+
+    /*
+     * Post training quantization: leaf deltas are stored as int8 codes with one scale
+     * per cascade level (max |delta| / 127), which also applies to PCA space leaves.
+     * The float and fixed point leaves are replaced by the dequantized values, so every
+     * evaluation path sees the same (quantized) model.
+     */
+    void quantize()
+    {
+        leaf_scales.assign(forests.size(), 0.f);
+        for (std::size_t i = 0; i < forests.size(); i++)
+        {
+            float range = 0.f;
+            for (const auto& tree : forests[i])
+            {
+                for (const auto& leaf : tree.leaf_values)
+                {
+                    range = std::max(range, float(dlib::max(dlib::abs(leaf))));
+                }
+            }
+
+            leaf_scales[i] = (range > 0.f) ? (range / 127.f) : 1.f;
+            for (auto& tree : forests[i])
+            {
+                tree.quantize(leaf_scales[i]);
+            }
+        }
+
+        calibrate_fixed_point(); // dequantized leaves
+
+#if DRISHTI_DLIB_DO_FLAT_FORESTS
+        compile();
+#endif
+    }
+
+    bool isQuantized() const
+    {
+        return !forests.empty() && (leaf_scales.size() == forests.size());
+    }
+
+    bool isCompiled() const
+    {
+        return !forests.empty() && (flat_forests.size() == forests.size());
     }
 
     shape_predictor(
@@ -808,7 +1588,6 @@ public:
             impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[i], anchor_idx[i], deltas[i]);
         }
 
-        m_num_workers = 4; //cv::getNumberOfCPUs();
     }
 
     unsigned long num_parts() const
@@ -816,25 +1595,40 @@ public:
         return initial_shape.size() / 2;
     }
 
-    static void project(drishti::ml::StandardizedPCA& pca, fshape& src, fshape& dst)
+    // In place on the shape buffers (see StandardizedPCA::project(const float*, float*, int)),
+    // shapes are only resized on a dimension change, so cascade levels don't allocate:
+    static void project(const drishti::ml::StandardizedPCA& pca, const fshape& src, fshape& dst)
     {
-        cv::Mat1f projection = pca.project(cv::Mat1f(1, src.size(), &src(0)));
-        dst.set_size(projection.cols, 1);
-        memcpy(&dst(0), projection.ptr<float>(0), sizeof(float) * projection.cols);
+        const int n = pca.getProjectionDimension();
+        if (dst.size() != n)
+        {
+            dst.set_size(n, 1);
+        }
+        pca.project(&src(0), &dst(0), n);
     }
 
-    static void back_project(drishti::ml::StandardizedPCA& pca, int n, fshape& src, fshape& dst)
+    // Back projection from the first n components:
+    static void back_project(const drishti::ml::StandardizedPCA& pca, int n, const fshape& src, fshape& dst)
     {
-        cv::Mat1f back_projection = pca.backProject(cv::Mat1f(1, n, &src(0)));
-        memcpy(&dst(0), back_projection.ptr<float>(), sizeof(float) * back_projection.cols);
+        if (dst.size() != pca.getDimension())
+        {
+            dst.set_size(pca.getDimension(), 1);
+        }
+        pca.backProject(&src(0), n, &dst(0));
     }
 
+    // With mirrored == true the image is sampled as if it were flipped about the vertical axis, so
+    // a right eye model can be applied to a left eye in place.  The rect and the shapes (including
+    // the returned detection) are in the flipped coordinate system.  Warm starts from a shape that
+    // is already close to convergence (e.g., tracking) can skip the coarse levels with first > 0:
     template <typename image_type>
     dlib::full_object_detection operator()(
         const image_type& img,
         const dlib::rectangle& rect,
         fshape starter_shape,
-        int stages = std::numeric_limits<int>::max()) const // early temrination
+        int stages = std::numeric_limits<int>::max(), // early temrination
+        bool mirrored = false,
+        int first = 0) const
     {
         using namespace impl;
 
@@ -848,10 +1642,15 @@ public:
             project(*m_pca, starter_shape, current_shape_full_);
         }
 
-        std::vector<float> feature_pixel_values;
+        const bool do_flat = isCompiled();
+
+        std::vector<float> feature_pixel_values, feature_scratch; // reused by every level
+        octave_pyramid pyramid;
         size_t forestCount = std::min(int(forests.size()), stages);
-        for (unsigned long iter = 0; iter < forestCount; ++iter)
-        {
+        const unsigned long firstLevel = static_cast<unsigned long>(std::max(std::min(first, int(forestCount) - 1), 0));
+
+        // Sample the pose indexed features for cascade level iter at the current shape estimate:
+        auto prepare = [&](unsigned long iter) {
             auto& cs_ = current_shape;
             auto& is_ = initial_shape; // this is used to map pose indexed features to current shape
 
@@ -863,71 +1662,133 @@ public:
                 back_project(*m_pca, current_pca_dim, current_shape_full_, cs_);
             }
 
-            if (interpolated_features.size())
+            const int octave = get_octave(iter);
+            if (octave > 0)
             {
-                extract_feature_pixel_values(img, rect, cs_, interpolated_features[iter], feature_pixel_values);
+                // Coarse levels sample a downscaled image (fewer cache lines per feature):
+                const dlib::cv_image<unsigned char> level(pyramid.get(img, octave));
+                extract_level_features(level, rect, cs_, iter, feature_pixel_values, mirrored, octave_pyramid::scale(octave), feature_scratch);
             }
             else
             {
-                extract_feature_pixel_values(img, rect, cs_, is_, anchor_idx[iter], deltas[iter], feature_pixel_values, m_ellipse_count, m_do_affine);
+                extract_level_features(img, rect, cs_, iter, feature_pixel_values, mirrored, 1.f, feature_scratch);
             }
-
-            fshape current_shape_;
-            auto& active_shape = do_pca ? current_shape_ : current_shape;
+        };
 
 #if DRISHTI_BUILD_REGRESSION_FIXED_POINT
-            // Fixed point is currently only working for PCA in most cases (check numerical overflow)
-            DVec16s shape_accumulator;
-#if DRISHTI_BUILD_PARALLEL_BOOSTING
+        // Calibrated int16 leaves with int32 sums (see calibrate_fixed_point()):
+        auto accumulate = [&](unsigned long iter, unsigned long begin, unsigned long end, DVec32s& shape_accumulator) {
+            if (do_flat)
             {
-                const unsigned long num = forests[iter].size();
-                const unsigned long block_size = std::max(1UL, (num + m_num_workers - 1) / m_num_workers);
-                std::vector<fshape> block_sums(m_num_workers);
-                std::vector<DVec16s> shape_accumulators(m_num_workers);
-                drishti::core::ParallelHomogeneousLambda harness = [&](int block) {
-                    const unsigned long block_begin = block * block_size;
-                    const unsigned long block_end = std::min(num, block_begin + block_size);
-                    for (unsigned long i = block_begin; i < block_end; ++i)
-                    {
-                        auto& f = forests[iter][i];
-                        add16sAnd16s(shape_accumulators[block], f(feature_pixel_values, Fixed(), m_npd), shape_accumulators[block]);
-                    }
-                };
-
-                //harness({0,static_cast<int>(num_workers)});
-                cv::parallel_for_({ 0, static_cast<int>(m_num_workers) }, harness);
-
-                for (auto& s : shape_accumulators)
-                {
-                    add16sAnd16s(shape_accumulator, s, shape_accumulator);
-                }
+                flat_forests[iter].accumulate(feature_pixel_values, begin, end, m_npd, shape_accumulator);
             }
-#else
-            for (auto& f : forests[iter])
+            else
             {
-                add16sAnd16s(shape_accumulator, f(feature_pixel_values, Fixed(), m_npd), shape_accumulator);
+                for (unsigned long i = begin; i < end; ++i)
+                {
+                    add16sAnd32s(shape_accumulator, forests[iter][i](feature_pixel_values, Fixed(), m_npd), shape_accumulator);
+                }
             }
-#endif
+        };
+
+        auto update = [&](unsigned long iter, const DVec32s& shape_accumulator) {
+            fshape current_shape_;
+            auto& active_shape = do_pca ? current_shape_ : current_shape;
 
             // fixed -> float
+            const float unit = 1.f / float(1 << get_fixed_fraction(iter));
             active_shape.set_size(shape_accumulator.size());
             for (int i = 0; i < shape_accumulator.size(); i++)
             {
-                active_shape(i) = float(shape_accumulator(i)) / float(1 << FIXED_PRECISION);
+                active_shape(i) = float(shape_accumulator(i)) * unit;
+            }
+
+            if (do_pca)
+            {
+                dlib::set_rowm(current_shape_full_, dlib::range(0, current_shape_.size() - 1)) += current_shape_;
             }
+        };
+
+        bool done = false;
+
+#if DRISHTI_BUILD_PARALLEL_BOOSTING
+        if (m_workers && forestCount)
+        {
+            // One dispatch for the whole cascade: each lane owns a fixed block of trees at
+            // every level, lane 0 also samples features and reduces the partial sums.
+            auto& accumulators = m_workers->accumulators;
+            done = m_workers->group.tryRun([&](int lane, drishti::core::SpinBarrier& barrier) {
+                const unsigned long lanes = accumulators.size();
+                auto& shape_accumulator = accumulators[lane];
+                for (unsigned long iter = firstLevel; iter < forestCount; ++iter)
+                {
+                    if (lane == 0)
+                    {
+                        prepare(iter);
+                    }
+                    barrier.wait(); // features for this level are ready
+
+                    const unsigned long num = forests[iter].size();
+                    const unsigned long block_size = (num + lanes - 1) / lanes;
+                    const unsigned long block_begin = std::min(num, lane * block_size);
+                    const unsigned long block_end = std::min(num, block_begin + block_size);
+
+                    const long dim = forests[iter][0].leaf_values[0].size();
+                    if (shape_accumulator.size() != dim)
+                    {
+                        shape_accumulator.set_size(dim);
+                    }
+                    shape_accumulator = 0;
+                    accumulate(iter, block_begin, block_end, shape_accumulator);
+                    barrier.wait(); // partial sums for this level are ready
+
+                    if (lane == 0)
+                    {
+                        for (unsigned long i = 1; i < lanes; i++)
+                        {
+                            shape_accumulator += accumulators[i];
+                        }
+                        update(iter, shape_accumulator);
+                    }
+                }
+            });
+        }
+#endif
+
+        // Serial evaluation (small forests, or the worker group is busy with another face):
+        for (unsigned long iter = firstLevel; !done && (iter < forestCount); ++iter)
+        {
+            prepare(iter);
+            DVec32s shape_accumulator;
+            accumulate(iter, 0, forests[iter].size(), shape_accumulator);
+            update(iter, shape_accumulator);
+        }
 
 #else  /* else don't DRISHTI_BUILD_REGRESSION_FIXED_POINT */
-            for (auto& f : forests[iter])
+        for (unsigned long iter = firstLevel; iter < forestCount; ++iter)
+        {
+            prepare(iter);
+
+            fshape current_shape_;
+            auto& active_shape = do_pca ? current_shape_ : current_shape;
+            if (do_flat)
             {
-                add32F(active_shape, f(feature_pixel_values, m_npd), active_shape);
+                flat_forests[iter].accumulate(feature_pixel_values, m_npd, active_shape);
+            }
+            else
+            {
+                for (auto& f : forests[iter])
+                {
+                    add32F(active_shape, f(feature_pixel_values, m_npd), active_shape);
+                }
             }
-#endif /* DRISHTI_BUILD_REGRESSION_FIXED_POINT */
 
             if (do_pca)
             {
                 dlib::set_rowm(current_shape_full_, dlib::range(0, current_shape_.size() - 1)) += current_shape_;
             }
         }
+#endif /* DRISHTI_BUILD_REGRESSION_FIXED_POINT */
 
         if (do_pca)
         {
@@ -937,6 +1798,42 @@ public:
         }
 
         // convert the current_shape into a full_object_detection
+        std::vector<dlib::point> parts = to_parts(current_shape, rect);
+
+#if DRISHTI_DLIB_DO_DEBUG_ELLIPSE
+        {
+            const auto point_length = int((current_shape.size() - (m_ellipse_count * 5)) / 2);
+
+            //  Convert image to opencv, then draw ellipse and shape:
+            cv::Mat image = dlib::toMat(const_cast<image_type&>(img));
+            cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+            for (int j = 0; j < point_length; j++)
+            {
+                cv::circle(image, cv::Point(parts[j].x(), parts[j].y()), 2, { 0, 255, 0 }, 1, 8);
+            }
+
+            for (int i = 0; i < ellipse_count; i++)
+            {
+                cv::RotatedRect e1;
+                e1.center.x = parts[point_length + 0].x();
+                e1.center.y = parts[point_length + 1].x();
+                e1.size.width = parts[point_length + 2].x();
+                e1.size.height = parts[point_length + 3].x();
+                e1.angle = parts[point_length + 4].x();
+
+                cv::ellipse(image, e1, { 0, 255, 0 }, 1, 8);
+            }
+            cv::imshow("image", image), cv::waitKey(0);
+        }
+#endif
+        return dlib::full_object_detection(rect, parts);
+    }
+
+    // Map a (euclidean) shape in normalized coordinates to rect, trailing ellipses in standard form:
+    std::vector<dlib::point> to_parts(const fshape& current_shape, const dlib::rectangle& rect) const
+    {
+        using namespace impl;
+
         const dlib::point_transform_affine tform_to_img = unnormalizing_tform(rect);
 
         auto point_length = int((current_shape.size() - (m_ellipse_count * 5)) / 2);
@@ -969,31 +1866,93 @@ public:
             parts[end + 4] = dlib::point(e2.angle, 0.f);
         }
 
-#if DRISHTI_DLIB_DO_DEBUG_ELLIPSE
+        return parts;
+    }
+
+    // Deactivate hypotheses far from the coordinate wise median shape (in image coordinates):
+    template <typename Hypothesis>
+    void prune(std::vector<Hypothesis>& hypotheses, const std::vector<dlib::rectangle>& rects, float factor) const
+    {
+        std::vector<std::size_t> active;
+        for (std::size_t i = 0; i < hypotheses.size(); i++)
         {
-            //  Convert image to opencv, then draw ellipse and shape:
-            cv::Mat image = dlib::toMat(const_cast<image_type&>(img));
-            cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+            if (hypotheses[i].active)
+            {
+                active.push_back(i);
+            }
+        }
+        if (active.size() < 3)
+        {
+            return; // no majority
+        }
+
+        const int point_length = int((initial_shape.size() - (m_ellipse_count * 5)) / 2);
+        std::vector<std::vector<fpoint>> points(active.size(), std::vector<fpoint>(point_length));
+        for (std::size_t i = 0; i < active.size(); i++)
+        {
+            const dlib::point_transform_affine tform_to_img = impl::unnormalizing_tform(rects[active[i]]);
             for (int j = 0; j < point_length; j++)
             {
-                cv::circle(image, cv::Point(parts[j].x(), parts[j].y()), 2, { 0, 255, 0 }, 1, 8);
+                points[i][j] = tform_to_img(impl::location(hypotheses[active[i]].shape, j));
             }
+        }
 
-            for (int i = 0; i < ellipse_count; i++)
+        auto median = [](std::vector<float>& values) {
+            std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+            return values[values.size() / 2];
+        };
+
+        std::vector<float> xs(active.size()), ys(active.size()), distances(active.size(), 0.f);
+        for (int j = 0; j < point_length; j++)
+        {
+            for (std::size_t i = 0; i < active.size(); i++)
             {
-                cv::RotatedRect e1;
-                e1.center.x = parts[point_length + 0].x();
-                e1.center.y = parts[point_length + 1].x();
-                e1.size.width = parts[point_length + 2].x();
-                e1.size.height = parts[point_length + 3].x();
-                e1.angle = parts[point_length + 4].x();
+                xs[i] = points[i][j].x();
+                ys[i] = points[i][j].y();
+            }
+            const fpoint center(median(xs), median(ys));
+            for (std::size_t i = 0; i < active.size(); i++)
+            {
+                distances[i] += dlib::length(points[i][j] - center);
+            }
+        }
 
-                cv::ellipse(image, e1, { 0, 255, 0 }, 1, 8);
+        std::vector<float> sorted = distances;
+        const float threshold = median(sorted) * factor;
+        for (std::size_t i = 0; i < active.size(); i++)
+        {
+            if ((threshold > 0.f) && (distances[i] > threshold))
+            {
+                hypotheses[active[i]].active = false;
             }
-            cv::imshow("image", image), cv::waitKey(0);
         }
-#endif
-        return dlib::full_object_detection(rect, parts);
+    }
+
+    // Image octave sampled by cascade level iter (0 == full resolution):
+    int get_octave(unsigned long iter) const
+    {
+        return (iter < octaves.size()) ? octaves[iter] : 0;
+    }
+
+    template <typename image_type>
+    void extract_level_features(
+        const image_type& img,
+        const dlib::rectangle& rect,
+        const fshape& current_shape,
+        unsigned long iter,
+        std::vector<float>& feature_pixel_values,
+        bool mirrored,
+        float scale,
+        std::vector<float>& scratch) const
+    {
+        if (interpolated_features.size())
+        {
+            impl::extract_feature_pixel_values(img, rect, current_shape, interpolated_features[iter], feature_pixel_values, mirrored, scale, &scratch);
+        }
+        else
+        {
+            impl::extract_feature_pixel_values(img, rect, current_shape, initial_shape, anchor_idx[iter], deltas[iter], feature_pixel_values, m_ellipse_count, m_do_affine, mirrored, scale, &scratch);
+        }
     }
 
     template <typename image_type>
@@ -1005,15 +1964,204 @@ public:
         return (*this)(img, rect, current_shape);
     }
 
+    struct batch_options
+    {
+        int stages = std::numeric_limits<int>::max(); // early termination
+        bool mirrored = false;
+        int first = 0;
+        int prune_level = 0;      // prune outlier hypotheses after this many levels (0 == never)
+        float prune_factor = 2.f; // outlier: distance to the median shape > prune_factor * median distance
+    };
+
+    // Batched evaluation of several hypotheses (e.g., jittered inits) of the same image, each with its
+    // own rect.  The hypotheses advance through the cascade together, so each level's trees are read
+    // once for all of them and the image pyramid is shared.  Pruned hypotheses are returned without
+    // parts.  See operator() above for mirrored and first.
+    template <typename image_type>
+    std::vector<dlib::full_object_detection> operator()(
+        const image_type& img,
+        const std::vector<dlib::rectangle>& rects,
+        const std::vector<fshape>& starter_shapes,
+        const batch_options& options) const
+    {
+        using namespace impl;
+
+        assert(rects.size() == starter_shapes.size());
+
+        struct hypothesis
+        {
+            fshape shape, shape_full; // shape_full for PCA mode
+            std::vector<float> feature_pixel_values;
+            bool active = true;
+        };
+
+        const bool do_pca = m_pca ? true : false;
+        const bool do_flat = isCompiled();
+
+        std::vector<hypothesis> hypotheses(rects.size());
+        for (std::size_t i = 0; i < hypotheses.size(); i++)
+        {
+            hypotheses[i].shape = starter_shapes[i];
+            if (do_pca)
+            {
+                project(*m_pca, starter_shapes[i], hypotheses[i].shape_full);
+            }
+        }
+
+        octave_pyramid pyramid;
+        const std::size_t forestCount = std::min(int(forests.size()), options.stages);
+        const unsigned long firstLevel = static_cast<unsigned long>(std::max(std::min(options.first, int(forestCount) - 1), 0));
+
+        std::vector<hypothesis*> active;
+        std::vector<const std::vector<float>*> batch;
+        std::vector<float> feature_scratch; // reused by every level and hypothesis
+        for (unsigned long iter = firstLevel; iter < forestCount; ++iter)
+        {
+            const int dim = int(forests[iter][0].leaf_values[0].size());
+
+            active.clear();
+            for (auto& h : hypotheses)
+            {
+                if (h.active)
+                {
+                    if (do_pca)
+                    {
+                        back_project(*m_pca, dim, h.shape_full, h.shape);
+                    }
+                    active.push_back(&h);
+                }
+            }
+
+            if ((options.prune_level > 0) && ((iter - firstLevel) == static_cast<unsigned long>(options.prune_level)))
+            {
+                prune(hypotheses, rects, options.prune_factor);
+                active.erase(std::remove_if(active.begin(), active.end(), [](const hypothesis* h) { return !h->active; }), active.end());
+            }
+
+            // Sample the pose indexed features for each hypothesis:
+            const int octave = get_octave(iter);
+            batch.clear();
+            for (auto* h : active)
+            {
+                const auto& rect = rects[h - hypotheses.data()];
+                if (octave > 0)
+                {
+                    const dlib::cv_image<unsigned char> level(pyramid.get(img, octave));
+                    extract_level_features(level, rect, h->shape, iter, h->feature_pixel_values, options.mirrored, octave_pyramid::scale(octave), feature_scratch);
+                }
+                else
+                {
+                    extract_level_features(img, rect, h->shape, iter, h->feature_pixel_values, options.mirrored, 1.f, feature_scratch);
+                }
+                batch.push_back(&h->feature_pixel_values);
+            }
+
+#if DRISHTI_BUILD_REGRESSION_FIXED_POINT
+            std::vector<DVec32s> sums(active.size());
+            std::vector<DVec32s*> accumulators(active.size());
+            for (std::size_t i = 0; i < active.size(); i++)
+            {
+                sums[i].set_size(dim);
+                sums[i] = 0;
+                accumulators[i] = &sums[i];
+            }
+
+            if (do_flat)
+            {
+                flat_forests[iter].accumulate(batch, m_npd, accumulators);
+            }
+            else
+            {
+                for (const auto& tree : forests[iter])
+                {
+                    for (std::size_t i = 0; i < active.size(); i++)
+                    {
+                        add16sAnd32s(sums[i], tree(*batch[i], Fixed(), m_npd), sums[i]);
+                    }
+                }
+            }
+
+            // fixed -> float (see operator() above)
+            const float unit = 1.f / float(1 << get_fixed_fraction(iter));
+            for (std::size_t i = 0; i < active.size(); i++)
+            {
+                fshape shape_;
+                auto& active_shape = do_pca ? shape_ : active[i]->shape;
+                active_shape.set_size(sums[i].size());
+                for (int k = 0; k < sums[i].size(); k++)
+                {
+                    active_shape(k) = float(sums[i](k)) * unit;
+                }
+                if (do_pca)
+                {
+                    dlib::set_rowm(active[i]->shape_full, dlib::range(0, shape_.size() - 1)) += shape_;
+                }
+            }
+#else
+            std::vector<fshape> sums(do_pca ? active.size() : 0);
+            std::vector<fshape*> accumulators(active.size());
+            for (std::size_t i = 0; i < active.size(); i++)
+            {
+                accumulators[i] = do_pca ? &sums[i] : &active[i]->shape;
+            }
+
+            if (do_flat)
+            {
+                flat_forests[iter].accumulate(batch, m_npd, accumulators);
+            }
+            else
+            {
+                for (const auto& tree : forests[iter])
+                {
+                    for (std::size_t i = 0; i < active.size(); i++)
+                    {
+                        add32F(*accumulators[i], tree(*batch[i], m_npd), *accumulators[i]);
+                    }
+                }
+            }
+
+            if (do_pca)
+            {
+                for (std::size_t i = 0; i < active.size(); i++)
+                {
+                    dlib::set_rowm(active[i]->shape_full, dlib::range(0, sums[i].size() - 1)) += sums[i];
+                }
+            }
+#endif
+        }
+
+        std::vector<dlib::full_object_detection> detections;
+        detections.reserve(hypotheses.size());
+        for (std::size_t i = 0; i < hypotheses.size(); i++)
+        {
+            auto& h = hypotheses[i];
+            if (!h.active)
+            {
+                detections.emplace_back(rects[i]);
+                continue;
+            }
+
+            if (do_pca)
+            {
+                // Convert the final model back to euclidean
+                back_project(*m_pca, int(forests.back()[0].leaf_values[0].size()), h.shape_full, h.shape);
+            }
+            detections.emplace_back(rects[i], to_parts(h.shape, rects[i]));
+        }
+        return detections;
+    }
+
     friend void serialize(const shape_predictor& item, std::ostream& out)
     {
 #if !DRISHTI_BUILD_MIN_SIZE
-        int version = 1;
+        int version = 3;
         dlib::serialize(version, out);
         dlib::serialize(item.initial_shape, out);
         dlib::serialize(item.forests, out);
         dlib::serialize(item.anchor_idx, out);
         dlib::serialize(item.deltas, out);
+        dlib::serialize(item.octaves, out);
+        dlib::serialize(item.landmarks, out);
 #endif // !DRISHTI_BUILD_MIN_SIZE
     }
     friend void deserialize(shape_predictor& item, std::istream& in)
@@ -1021,7 +2169,7 @@ public:
 #if !DRISHTI_BUILD_MIN_SIZE
         int version = 0;
         dlib::deserialize(version, in);
-        if (version != 1)
+        if ((version < 1) || (version > 3))
         {
             throw dlib::serialization_error("Unexpected version found while deserializing dlib::shape_predictor.");
         }
@@ -1029,6 +2177,16 @@ public:
         dlib::deserialize(item.forests, in);
         dlib::deserialize(item.anchor_idx, in);
         dlib::deserialize(item.deltas, in);
+        item.octaves.clear();
+        if (version >= 2)
+        {
+            dlib::deserialize(item.octaves, in);
+        }
+        item.landmarks.clear();
+        if (version >= 3)
+        {
+            dlib::deserialize(item.landmarks, in);
+        }
 #endif // !DRISHTI_BUILD_MIN_SIZE
     }
 
@@ -1039,11 +2197,22 @@ public:
 
     fshape initial_shape;
     std::vector<std::vector<impl::regression_tree>> forests;
+    std::vector<float> leaf_scales; // (optional) per level int8 leaf scale, see quantize()
+    std::vector<int> fixed_fractions; // per level leaf_values_16 fraction bits, see calibrate_fixed_point()
+
+    // Optional compiled (flattened) copy of forests, one entry per cascade level:
+    std::vector<impl::flat_forest> flat_forests;
 
     // Pose indexing relative to nearest landmark points:
     std::vector<std::vector<unsigned short>> anchor_idx;
     std::vector<PointVecf> deltas;
 
+    // (optional) per cascade level, features are sampled from a 1/2^octave image (missing == 0):
+    std::vector<int> octaves;
+
+    // (optional) subset model, annotation part index of each regressed point (empty == all):
+    std::vector<int> landmarks;
+
     // PCA reduction:
     std::shared_ptr<drishti::ml::StandardizedPCA> m_pca; // global pca
     int m_ellipse_count = 0;
@@ -1051,6 +2220,19 @@ public:
     bool m_do_affine = false;
     unsigned long m_num_workers = 1;
 
+    // Persistent boosting lanes, with per lane accumulators allocated once per predictor:
+    struct boosting_workers
+    {
+        explicit boosting_workers(int lanes)
+            : group(lanes)
+            , accumulators(lanes)
+        {
+        }
+        drishti::core::WorkerGroup group;
+        std::vector<DVec32s> accumulators;
+    };
+    std::shared_ptr<boosting_workers> m_workers;
+
     // Use interpolated "line indexed" features (stead of the relative encoding above):
     std::vector<std::vector<InterpolatedFeature>> interpolated_features;
 
@@ -118,19 +118,65 @@ void serialize(Archive& ar, drishti::ml::impl::regression_tree& g, const unsigne
     }
 }
 
+// Quantized forests (version 5): splits + int8 leaf codes, scaled per cascade level
+template <class Archive>
+void serialize_quantized(Archive& ar, std::vector<std::vector<RTType>>& forests, const std::vector<float>& scales)
+{
+    std::uint32_t levels = static_cast<std::uint32_t>(forests.size());
+    ar& levels;
+    drishti_throw_assert(levels == scales.size(), "Inconsistent quantized shape_predictor archive");
+    forests.resize(levels);
+
+    for (std::uint32_t i = 0; i < levels; i++)
+    {
+        std::uint32_t trees = static_cast<std::uint32_t>(forests[i].size());
+        ar& trees;
+        forests[i].resize(trees);
+
+        for (auto& g : forests[i])
+        {
+            std::uint32_t dim = g.leaf_values.size() ? static_cast<std::uint32_t>(g.leaf_values.front().size()) : 0;
+            ar& g.splits;
+            ar& g.leaf_values_8;
+            ar& dim;
+
+            if (Archive::is_loading::value)
+            {
+                g.dequantize(scales[i], int(dim));
+            }
+        }
+    }
+}
+
 template <class Archive>
 void serialize(Archive& ar, drishti::ml::shape_predictor& sp, const unsigned int version)
 {
-    drishti_throw_assert(version == 4, "Incorrect shape_predictor archive format, please update models");
+    drishti_throw_assert((version >= 4) && (version <= 7), "Incorrect shape_predictor archive format, please update models");
 
     drishti::ml::fshape& initial_shape = sp.initial_shape;
     std::vector<std::vector<RTType>>& forests = sp.forests;
     std::vector<std::vector<unsigned short>>& anchor_idx = sp.anchor_idx;
     std::vector<std::vector<Vec2Type>>& deltas = sp.deltas;
 
+    if (version >= 5)
+    {
+        ar& sp.leaf_scales; // empty == half precision leaves
+    }
+    else
+    {
+        sp.leaf_scales.clear();
+    }
+
     // Without forests a 2.3 MB compressed archive drops to 48K//
     ar& initial_shape;
-    ar& forests;
+    if (sp.leaf_scales.empty())
+    {
+        ar& forests;
+    }
+    else
+    {
+        serialize_quantized(ar, forests, sp.leaf_scales);
+    }
     ar& anchor_idx;
 
 #if DRISHTI_DLIB_DO_HALF
@@ -154,11 +200,29 @@ void serialize(Archive& ar, drishti::ml::shape_predictor& sp, const unsigned int
     ar& sp.m_do_affine;
     ar& sp.m_ellipse_count;
     ar& sp.interpolated_features;
+
+    if (version >= 6)
+    {
+        ar& sp.octaves; // empty == full resolution for all levels
+    }
+    else
+    {
+        sp.octaves.clear();
+    }
+
+    if (version >= 7)
+    {
+        ar& sp.landmarks; // empty == all parts
+    }
+    else
+    {
+        sp.landmarks.clear();
+    }
 }
 
 DRISHTI_END_NAMESPACE(cereal)
 
 #include <cereal/cereal.hpp>
-CEREAL_CLASS_VERSION(drishti::ml::shape_predictor, 4);
+CEREAL_CLASS_VERSION(drishti::ml::shape_predictor, 7);
 
 #endif /* shape_predictor_archive_h */
@@ -6,6 +6,12 @@
 
 #include "drishti/ml/shape_predictor.h"
 
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <numeric>
+
 // clang-format off
 #if !DRISHTI_BUILD_MIN_SIZE
 #  include <dlib/serialize.h>
@@ -23,6 +29,18 @@ class shape_predictor_trainer
     /*!
         This thing really only works with unsigned char or rgb_pixel images (since we assume the threshold
         should be in the range [-128,128]).
+
+        With set_do_feature_cache(true) the feature pool intensities for each cascade are stored once
+        in a feature major uint8 matrix (samples are referenced through an index permutation instead
+        of being swapped), and each split candidate is evaluated with a 256 bin histogram of the
+        pixel difference (or NPD), which selects the best threshold for the feature pair instead of
+        a random one.  The candidates for all nodes at the same tree depth are evaluated in parallel.
+        Images are only accessed once per cascade (grouped by image), so image_array can be a
+        container that loads images from disk on access (operator[] may return by value).
+
+        The histograms accumulate fixed point residuals, so the sums don't depend on the order
+        of the samples.  This allows data parallel training over several processes or nodes
+        (see set_shard()) with the same model as a single process.
     !*/
 public:
     shape_predictor_trainer()
@@ -217,9 +235,91 @@ public:
     void set_do_line_indexed(bool do_line_indexed) { _do_line_indexed = do_line_indexed; }
     bool get_do_line_indexed() const { return _do_line_indexed; }
 
+    void set_do_feature_cache(bool do_feature_cache) { _do_feature_cache = do_feature_cache; }
+    bool get_do_feature_cache() const { return _do_feature_cache; }
+
+    // Per cascade level image octave (e.g., { 2, 1, 1 } samples the first level from a 1/4 and the
+    // next two from a 1/2 resolution image), levels past the end use full resolution:
+    void set_octaves(const std::vector<int>& octaves) { _octaves = octaves; }
+    const std::vector<int>& get_octaves() const { return _octaves; }
+
+    // Subset model: regress only these parts of the annotations (e.g., the eye and nose points
+    // of a 68 point face), so the leaf vectors and the feature anchors only cover the points a
+    // consumer needs.  The indices are stored in the model (see shape_predictor::landmarks):
+    void set_landmarks(const std::vector<int>& landmarks) { _landmarks = landmarks; }
+    const std::vector<int>& get_landmarks() const { return _landmarks; }
+
+    // Write the training state after each cascade level, and resume from an existing checkpoint
+    // for the same training set and parameters (e.g., after a crash):
+    void set_checkpoint(const std::string& filename) { _checkpoint = filename; }
+    const std::string& get_checkpoint() const { return _checkpoint; }
+
+    // Called with a predictor for the completed levels after each cascade level, e.g., to
+    // evaluate it on held out data.  Return false to stop training (early stopping):
+    using cascade_callback = std::function<bool(unsigned long levels, const shape_predictor& sp)>;
+    void set_cascade_callback(const cascade_callback& callback) { _cascade_callback = callback; }
+
+    // Data parallel training over count processes (e.g., one per node): each process calls
+    // train() with the same annotations, parameters and seed, and only reads the images of its
+    // shard (image_idx % count == rank).  The feature cache is used, and the split histograms,
+    // residual sums and counts are summed with allreduce(), which must add the vectors of all
+    // processes element-wise in place (e.g., MPI_Allreduce(MPI_IN_PLACE, ..., MPI_INT64_T, MPI_SUM)).
+    // Every process returns the same model.  Histograms are bins * (dim + 1) values per split
+    // candidate, so shape space regression (set_dimensions()) keeps the messages small.
+    using allreduce_function = std::function<void(std::vector<std::int64_t>& values)>;
+    void set_shard(unsigned long rank, unsigned long count, const allreduce_function& allreduce)
+    {
+        DLIB_CASSERT(rank < count && (count == 1 || allreduce), "\t shape_predictor_trainer::set_shard()");
+        _shard_rank = rank;
+        _shard_count = count;
+        _allreduce = allreduce;
+    }
+    unsigned long get_shard_rank() const { return _shard_rank; }
+    unsigned long get_shard_count() const { return _shard_count; }
+
     void set_roi(const dlib::drectangle& roi) { _roi = roi; }
     const dlib::drectangle& get_roi() const { return _roi; }
 
+    // Shape vector in normalized (rect) coordinates, trailing ellipses as phi:
+    static fshape object_to_shape(
+        const dlib::full_object_detection& obj,
+        int ellipse_count = 0)
+    {
+        fshape shape(obj.num_parts() * 2 - (5 * ellipse_count));
+        const dlib::point_transform_affine tform_from_img = impl::normalizing_tform(obj.get_rect());
+
+        int end = int(obj.num_parts()) - (ellipse_count * 5);
+        for (unsigned long i = 0; i < end; ++i)
+        {
+            dlib::vector<float, 2> p = tform_from_img(obj.part(i));
+            shape(2 * i + 0) = p.x();
+            shape(2 * i + 1) = p.y();
+        }
+
+        // Normalize ellipse in homogeneous coordinates:
+        for (int i = end, j = 2 * end; i < (end + ellipse_count * 5); i += 5)
+        {
+            cv::RotatedRect e, e2;
+            e.center.x = obj.part(i + 0).x();
+            e.center.y = obj.part(i + 1).x();
+            e.size.width = obj.part(i + 2).x();
+            e.size.height = obj.part(i + 3).x();
+            e.angle = obj.part(i + 4).x();
+
+            const auto& m = tform_from_img.get_m();
+            const auto& b = tform_from_img.get_b();
+            cv::Matx33f H(m(0, 0), m(0, 1), b(0), m(1, 0), m(1, 1), b(1), 0, 0, 1);
+
+            std::vector<float> phi = geometry::ellipseToPhi(H * e);
+            for (int k = 0; k < phi.size(); k++, j++)
+            {
+                shape(j) = phi[k];
+            }
+        }
+
+        return shape;
+    }
+
     static void copyShape(const float* ptr, int n, fshape& shape, fshape& shape_full)
     {
         shape_full.set_size(n, 1);
@@ -267,8 +367,23 @@ public:
             "\t shape_predictor shape_predictor_trainer::train()"
                 << "\n\t You must give at least one full_object_detection if you want to train a shape model and it must have parts.");
 
+        // Subset models are trained on the selected parts (weights are keyed by part):
+        std::vector<std::vector<dlib::full_object_detection>> subset;
+        std::map<int, float> subset_weights;
+        if (!_landmarks.empty())
+        {
+            DLIB_CASSERT(_ellipse_count == 0, "\t shape_predictor shape_predictor_trainer::train() landmark subsets don't support ellipses");
+            select_landmarks(objects, weights, num_parts, subset, subset_weights);
+            num_parts = _landmarks.size();
+        }
+        const auto& parts = _landmarks.empty() ? objects : subset;
+        const auto& part_weights = _landmarks.empty() ? weights : subset_weights;
+
         rnd.set_seed(get_random_seed());
 
+        // Distributed training is only supported for the (order independent) histogram search:
+        const bool do_cache = _do_feature_cache || (_shard_count > 1);
+
         dlib::thread_pool tp(_num_threads > 1 ? _num_threads : 0);
 
         DLIB_CASSERT(!(_ellipse_count % 2), "\t currently limited to ellipse pairs"); // point representation limitations
@@ -277,7 +392,7 @@ public:
         bool is_ellipse_only = (_ellipse_count * 5) == (num_parts * 2); // really only works for ellipse pairs
 
         std::vector<training_sample> samples;
-        const fshape initial_shape = populate_training_sample_shapes(objects, samples, _ellipse_count);
+        const fshape initial_shape = populate_training_sample_shapes(parts, samples, _ellipse_count);
 
         std::vector<PointVecf> pixel_coordinates;
         std::vector<std::vector<InterpolatedFeature>> interpolated_features;
@@ -297,7 +412,7 @@ public:
         StandardizedPCAPtr pca;
         if (do_pca)
         {
-            pca = compute_pca(samples, num_dim, _dimensions, weights);
+            pca = compute_pca(samples, num_dim, _dimensions, part_weights);
         }
 
         unsigned long trees_fit_so_far = 0;
@@ -308,8 +423,20 @@ public:
         }
 
         std::vector<std::vector<impl::regression_tree>> forests(get_cascade_depth());
+
+        // The setup above is deterministic (seeded), a checkpoint restores the rest:
+        unsigned long first_cascade = 0;
+        if (!_checkpoint.empty() && load_checkpoint(_checkpoint, samples, forests, first_cascade))
+        {
+            trees_fit_so_far = first_cascade * get_num_trees_per_cascade_level();
+            if (_verbose)
+            {
+                std::cout << "Resuming from cascade " << first_cascade << std::endl;
+            }
+        }
+
         // Now start doing the actual training by filling in the forests
-        for (unsigned long cascade = 0; cascade < get_cascade_depth(); ++cascade)
+        for (unsigned long cascade = first_cascade; cascade < get_cascade_depth(); ++cascade)
         {
             int current_pca_dim = do_pca ? _dimensions[cascade] : num_dim;
 
@@ -335,35 +462,72 @@ public:
                 create_shape_relative_encoding(initial_shape, pixel_coordinates[cascade], anchor_idx, deltas, _ellipse_count);
             }
 
-            // First compute the feature_pixel_values for each training sample at this
-            // level of the cascade.
-
-            parallel_for(tp, 0, samples.size(), [&](unsigned long i) {
-                auto& s = samples[i];
-                auto& is = initial_shape;
-                const auto& cs = s.current_shape;
-                const auto& image = images[s.image_idx];
+            const std::vector<InterpolatedFeature>* features = _do_line_indexed ? &interpolated_features[cascade] : nullptr;
+            const int octave = (cascade < _octaves.size()) ? _octaves[cascade] : 0;
 
-                if (is_ellipse_only)
+            feature_cache cache;
+            if (do_cache)
+            {
+                // Samples are grouped by image (see populate_training_sample_shapes()), so each
+                // image is accessed (e.g., loaded) once per cascade:
+                std::vector<unsigned long> groups;
+                for (unsigned long i = 0; i < samples.size(); ++i)
                 {
-                    // TODO: Just use homography corresponding to first ellipse:
-                    assert(false);
+                    if (!i || (samples[i].image_idx != samples[i - 1].image_idx))
+                    {
+                        groups.push_back(i);
+                    }
                 }
-                else if (_do_line_indexed)
+                groups.push_back(samples.size());
+
+                cache.samples = samples.size();
+                cache.values.resize(cache.samples * get_feature_pool_size());
+                parallel_for(tp, 0, groups.size() - 1, [&](unsigned long g) {
+                    if (!is_local(samples[groups[g]]))
+                    {
+                        return; // another shard
+                    }
+
+                    const auto& image = images[samples[groups[g]].image_idx];
+
+                    impl::octave_pyramid pyramid; // downscaled once per image
+                    std::vector<float> values;
+                    for (unsigned long i = groups[g]; i < groups[g + 1]; ++i)
+                    {
+                        extract_sample_features(image, pyramid, octave, samples[i], initial_shape, features, anchor_idx, deltas, values);
+                        for (unsigned long j = 0; j < values.size(); ++j)
+                        {
+                            const float value = std::min(std::max(std::round(values[j]), 0.f), 255.f);
+                            cache.values[j * cache.samples + i] = static_cast<std::uint8_t>(value);
+                        }
+                    }
+                },
+                    1);
+            }
+            else
+            {
+                // First compute the feature_pixel_values for each training sample at this
+                // level of the cascade.
+
+                parallel_for(tp, 0, samples.size(), [&](unsigned long i) {
+                    auto& s = samples[i];
+                    impl::octave_pyramid pyramid;
+                    extract_sample_features(images[s.image_idx], pyramid, octave, s, initial_shape, features, anchor_idx, deltas, s.feature_pixel_values);
+                },
+                    1);
+            }
+
+            // Now start building the trees at this cascade level.
+            for (unsigned long i = 0; i < get_num_trees_per_cascade_level(); ++i)
+            {
+                if (do_cache)
                 {
-                    extract_feature_pixel_values(image, s.rect, cs, interpolated_features[cascade], s.feature_pixel_values);
+                    forests[cascade].push_back(make_regression_tree(tp, samples, cache, pixel_coordinates[cascade], _do_npd, do_pca));
                 }
                 else
                 {
-                    extract_feature_pixel_values(image, s.rect, cs, is, anchor_idx, deltas, s.feature_pixel_values, _ellipse_count, _do_affine);
+                    forests[cascade].push_back(make_regression_tree(tp, samples, pixel_coordinates[cascade], _do_npd, do_pca));
                 }
-            },
-                1);
-
-            // Now start building the trees at this cascade level.
-            for (unsigned long i = 0; i < get_num_trees_per_cascade_level(); ++i)
-            {
-                forests[cascade].push_back(make_regression_tree(tp, samples, pixel_coordinates[cascade], _do_npd, do_pca));
                 if (_verbose)
                 {
                     ++trees_fit_so_far;
@@ -375,6 +539,21 @@ public:
             {
                 update_shape_space_models(samples, current_pca_dim);
             }
+
+            if (!_checkpoint.empty())
+            {
+                save_checkpoint(_checkpoint, samples, forests, cascade + 1);
+            }
+
+            if (_cascade_callback)
+            {
+                std::vector<std::vector<impl::regression_tree>> completed(forests.begin(), forests.begin() + cascade + 1);
+                if (!_cascade_callback(cascade + 1, make_predictor(initial_shape, completed, interpolated_features, pixel_coordinates, pca)))
+                {
+                    forests.swap(completed);
+                    break;
+                }
+            }
         }
 
         if (_verbose)
@@ -382,54 +561,145 @@ public:
             std::cout << "Training complete                          " << std::endl;
         }
 
+        return make_predictor(initial_shape, forests, interpolated_features, pixel_coordinates, pca);
+    }
+
+private:
+    shape_predictor make_predictor(
+        const fshape& initial_shape,
+        const std::vector<std::vector<impl::regression_tree>>& forests,
+        const std::vector<std::vector<InterpolatedFeature>>& interpolated_features,
+        const std::vector<PointVecf>& pixel_coordinates,
+        StandardizedPCAPtr& pca) const
+    {
+        // The per level pixel tables must match the (possibly truncated) forests:
+        const auto levels = forests.size();
+
+        shape_predictor sp;
         if (interpolated_features.size())
         {
-            return shape_predictor(initial_shape, forests, interpolated_features, pca, _do_npd, _do_affine, _ellipse_count);
+            std::vector<std::vector<InterpolatedFeature>> features(interpolated_features.begin(), interpolated_features.begin() + levels);
+            sp = shape_predictor(initial_shape, forests, features, pca, _do_npd, _do_affine, _ellipse_count);
         }
         else
         {
-            return shape_predictor(initial_shape, forests, pixel_coordinates, pca, _do_npd, _do_affine, _ellipse_count);
+            std::vector<PointVecf> coordinates(pixel_coordinates.begin(), pixel_coordinates.begin() + levels);
+            sp = shape_predictor(initial_shape, forests, coordinates, pca, _do_npd, _do_affine, _ellipse_count);
         }
+        sp.octaves = _octaves;
+        sp.landmarks = _landmarks;
+        return sp;
     }
 
-private:
-    static fshape object_to_shape(
-        const dlib::full_object_detection& obj,
-        int ellipse_count = 0)
+    void select_landmarks(
+        const std::vector<std::vector<dlib::full_object_detection>>& objects,
+        const std::map<int, float>& weights,
+        unsigned long num_parts,
+        std::vector<std::vector<dlib::full_object_detection>>& subset,
+        std::map<int, float>& subset_weights) const
     {
-        fshape shape(obj.num_parts() * 2 - (5 * ellipse_count));
-        const dlib::point_transform_affine tform_from_img = impl::normalizing_tform(obj.get_rect());
-
-        int end = int(obj.num_parts()) - (ellipse_count * 5);
-        for (unsigned long i = 0; i < end; ++i)
+        for (std::size_t k = 0; k < _landmarks.size(); k++)
         {
-            dlib::vector<float, 2> p = tform_from_img(obj.part(i));
-            shape(2 * i + 0) = p.x();
-            shape(2 * i + 1) = p.y();
+            DLIB_CASSERT((_landmarks[k] >= 0) && (static_cast<unsigned long>(_landmarks[k]) < num_parts),
+                "\t shape_predictor shape_predictor_trainer::train()"
+                    << "\n\t Invalid landmark index " << _landmarks[k] << " for " << num_parts << " parts");
+
+            const auto iter = weights.find(_landmarks[k]);
+            if (iter != weights.end())
+            {
+                subset_weights[static_cast<int>(k)] = iter->second;
+            }
         }
 
-        // Normalize ellipse in homogeneous coordinates:
-        for (int i = end, j = 2 * end; i < (end + ellipse_count * 5); i += 5)
+        subset.resize(objects.size());
+        for (std::size_t i = 0; i < objects.size(); i++)
         {
-            cv::RotatedRect e, e2;
-            e.center.x = obj.part(i + 0).x();
-            e.center.y = obj.part(i + 1).x();
-            e.size.width = obj.part(i + 2).x();
-            e.size.height = obj.part(i + 3).x();
-            e.angle = obj.part(i + 4).x();
+            subset[i].clear();
+            for (const auto& obj : objects[i])
+            {
+                std::vector<dlib::point> points;
+                for (const auto& k : _landmarks)
+                {
+                    points.push_back(obj.part(k));
+                }
+                subset[i].emplace_back(obj.get_rect(), points);
+            }
+        }
+    }
 
-            const auto& m = tform_from_img.get_m();
-            const auto& b = tform_from_img.get_b();
-            cv::Matx33f H(m(0, 0), m(0, 1), b(0), m(1, 0), m(1, 1), b(1), 0, 0, 1);
+    // ::: Checkpoints (dlib serialization) :::
 
-            std::vector<float> phi = geometry::ellipseToPhi(H * e);
-            for (int k = 0; k < phi.size(); k++, j++)
+    static const int kCheckpointVersion = 1;
+
+    // Identifies the training set and the parameters that change the training state:
+    std::vector<double> checkpoint_key(const std::vector<training_sample>& samples) const
+    {
+        return {
+            double(samples.size()),
+            double(get_cascade_depth()),
+            double(get_tree_depth()),
+            double(get_num_trees_per_cascade_level()),
+            double(get_feature_pool_size()),
+            double(get_oversampling_amount()),
+            get_nu(),
+            get_lambda(),
+            double(_do_npd),
+            double(_do_feature_cache),
+            double(_shard_rank),
+            double(_shard_count),
+            double(_landmarks.size()),
+        };
+    }
+
+    void save_checkpoint(const std::string& filename, const std::vector<training_sample>& samples, const std::vector<std::vector<impl::regression_tree>>& forests, unsigned long cascades) const
+    {
+        // Write and rename, so a crash while writing leaves the previous checkpoint intact:
+        const std::string temp = filename + ".tmp";
+        {
+            std::ofstream os(temp, std::ios::binary);
+            dlib::serialize(int(kCheckpointVersion), os);
+            dlib::serialize(checkpoint_key(samples), os);
+            dlib::serialize(cascades, os);
+            dlib::serialize(std::vector<std::vector<impl::regression_tree>>(forests.begin(), forests.begin() + cascades), os);
+            dlib::serialize(samples, os);
+            dlib::serialize(rnd, os);
+            if (!os)
             {
-                shape(j) = phi[k];
+                throw std::runtime_error("shape_predictor_trainer: failed to write checkpoint " + temp);
             }
         }
+        std::remove(filename.c_str());
+        if (std::rename(temp.c_str(), filename.c_str()) != 0)
+        {
+            throw std::runtime_error("shape_predictor_trainer: failed to rename checkpoint " + temp);
+        }
+    }
 
-        return shape;
+    bool load_checkpoint(const std::string& filename, std::vector<training_sample>& samples, std::vector<std::vector<impl::regression_tree>>& forests, unsigned long& cascades) const
+    {
+        std::ifstream is(filename, std::ios::binary);
+        if (!is)
+        {
+            return false;
+        }
+
+        int version = 0;
+        std::vector<double> key;
+        dlib::deserialize(version, is);
+        dlib::deserialize(key, is);
+        if ((version != kCheckpointVersion) || (key != checkpoint_key(samples)))
+        {
+            throw std::runtime_error("shape_predictor_trainer: checkpoint " + filename + " doesn't match the training set or parameters");
+        }
+
+        std::vector<std::vector<impl::regression_tree>> completed;
+        dlib::deserialize(cascades, is);
+        dlib::deserialize(completed, is);
+        dlib::deserialize(samples, is);
+        dlib::deserialize(rnd, is);
+
+        std::copy(completed.begin(), completed.end(), forests.begin());
+        return true;
     }
 
     struct training_sample
@@ -476,8 +746,94 @@ private:
 
             diff_shape.swap(item.diff_shape);
         }
+
+        // Checkpoints (see save_checkpoint()), feature values and residuals are per cascade scratch:
+        friend void serialize(const training_sample& item, std::ostream& out)
+        {
+            dlib::serialize(item.image_idx, out);
+            dlib::serialize(item.rect, out);
+            dlib::serialize(item.target_shape, out);
+            dlib::serialize(item.target_shape_, out);
+            dlib::serialize(item.target_shape_full_, out);
+            dlib::serialize(item.current_shape, out);
+            dlib::serialize(item.current_shape_, out);
+            dlib::serialize(item.current_shape_full_, out);
+        }
+
+        friend void deserialize(training_sample& item, std::istream& in)
+        {
+            dlib::deserialize(item.image_idx, in);
+            dlib::deserialize(item.rect, in);
+            dlib::deserialize(item.target_shape, in);
+            dlib::deserialize(item.target_shape_, in);
+            dlib::deserialize(item.target_shape_full_, in);
+            dlib::deserialize(item.current_shape, in);
+            dlib::deserialize(item.current_shape_, in);
+            dlib::deserialize(item.current_shape_full_, in);
+        }
     };
 
+    // Feature major (SoA) pool intensities for one cascade: values[feature * samples + sample]
+    struct feature_cache
+    {
+        std::vector<std::uint8_t> values;
+        unsigned long samples = 0;
+
+        const std::uint8_t* row(unsigned long feature) const { return values.data() + feature * samples; }
+    };
+
+    struct split_score
+    {
+        double score = -1.0;
+        float thresh = 0.f;
+    };
+
+    using SampleRange = std::pair<unsigned long, unsigned long>;
+
+    template <typename image_type>
+    void extract_sample_features(
+        const image_type& image,
+        impl::octave_pyramid& pyramid,
+        int octave,
+        const training_sample& s,
+        const fshape& initial_shape,
+        const std::vector<InterpolatedFeature>* interpolated_features,
+        const std::vector<unsigned short>& anchor_idx,
+        const PointVecf& deltas,
+        std::vector<float>& feature_pixel_values) const
+    {
+        if (octave > 0)
+        {
+            const dlib::cv_image<unsigned char> level(pyramid.get(image, octave));
+            extract_sample_features(level, impl::octave_pyramid::scale(octave), s, initial_shape, interpolated_features, anchor_idx, deltas, feature_pixel_values);
+        }
+        else
+        {
+            extract_sample_features(image, 1.f, s, initial_shape, interpolated_features, anchor_idx, deltas, feature_pixel_values);
+        }
+    }
+
+    template <typename image_type>
+    void extract_sample_features(
+        const image_type& image,
+        float scale,
+        const training_sample& s,
+        const fshape& initial_shape,
+        const std::vector<InterpolatedFeature>* interpolated_features,
+        const std::vector<unsigned short>& anchor_idx,
+        const PointVecf& deltas,
+        std::vector<float>& feature_pixel_values) const
+    {
+        if (interpolated_features)
+        {
+            impl::extract_feature_pixel_values(image, s.rect, s.current_shape, *interpolated_features, feature_pixel_values, false, scale);
+        }
+        else
+        {
+            impl::extract_feature_pixel_values(image, s.rect, s.current_shape, initial_shape, anchor_idx, deltas, feature_pixel_values, _ellipse_count, _do_affine, false, scale);
+        }
+    }
+
     void update_shape_space_models(std::vector<training_sample>& samples, int current_pca_dim) const
     {
         auto current_range = dlib::range(0, current_pca_dim - 1);
@@ -712,6 +1068,356 @@ private:
         return tree;
     }
 
+    // ::: Feature cache + histogram split search (see set_do_feature_cache()) :::
+
+    // Residuals are fixed point (Q20), so sums are exact and independent of the order (and shard):
+    static const int kResidualBits = 20;
+    static const int kHistogramBins = 256;
+
+    bool is_local(const training_sample& sample) const
+    {
+        return (sample.image_idx % _shard_count) == _shard_rank;
+    }
+
+    void allreduce(std::vector<std::int64_t>& values) const
+    {
+        if (_shard_count > 1)
+        {
+            _allreduce(values);
+        }
+    }
+
+    static bool goes_left(const feature_cache& cache, const impl::split_feature& split, unsigned long sample, bool do_npd)
+    {
+        const float value1 = cache.row(split.idx1)[sample];
+        const float value2 = cache.row(split.idx2)[sample];
+        return (do_npd ? impl::compute_npd(value1, value2) : (value1 - value2)) > split.thresh;
+    }
+
+    // Sum of the residual rows for order[range.first ... range.second):
+    static void sum_residuals(
+        dlib::thread_pool& tp,
+        const std::vector<std::int32_t>& residuals,
+        long dim,
+        const std::vector<unsigned long>& order,
+        const SampleRange& range,
+        std::int64_t* sum)
+    {
+        const unsigned long num_workers = std::max(1UL, tp.num_threads_in_pool());
+        const unsigned long num = range.second - range.first;
+        const unsigned long block_size = std::max(1UL, (num + num_workers - 1) / num_workers);
+        std::vector<std::vector<std::int64_t>> block_sums(num_workers, std::vector<std::int64_t>(dim, 0));
+
+        parallel_for(tp, 0, num_workers, [&](unsigned long block) {
+            const unsigned long block_begin = range.first + std::min(num, block * block_size);
+            const unsigned long block_end = range.first + std::min(num, (block + 1) * block_size);
+            std::int64_t* block_sum = block_sums[block].data();
+            for (unsigned long j = block_begin; j < block_end; ++j)
+            {
+                const std::int32_t* r = &residuals[order[j] * dim];
+                for (long k = 0; k < dim; ++k)
+                {
+                    block_sum[k] += r[k];
+                }
+            }
+        },
+            1);
+
+        std::fill(sum, sum + dim, 0);
+        for (const auto& block_sum : block_sums)
+        {
+            for (long k = 0; k < dim; ++k)
+            {
+                sum[k] += block_sum[k];
+            }
+        }
+    }
+
+    // Histogram of the pixel difference (or NPD) for the feature pair, each bin holds the sample
+    // count followed by the residual sum, i.e., kHistogramBins * (dim + 1) values:
+    static void accumulate_histogram(
+        const feature_cache& cache,
+        const std::vector<std::int32_t>& residuals,
+        long dim,
+        const std::vector<unsigned long>& order,
+        const SampleRange& range,
+        const impl::split_feature& feat,
+        bool do_npd,
+        std::int64_t* histogram)
+    {
+        const std::uint8_t* values1 = cache.row(feat.idx1);
+        const std::uint8_t* values2 = cache.row(feat.idx2);
+        for (unsigned long j = range.first; j < range.second; ++j)
+        {
+            const unsigned long s = order[j];
+
+            int bin = 0;
+            if (do_npd)
+            {
+                const float npd = impl::compute_npd(static_cast<float>(values1[s]), static_cast<float>(values2[s]));
+                bin = std::min(std::max(static_cast<int>((npd + 1.f) * 128.f), 0), kHistogramBins - 1);
+            }
+            else
+            {
+                bin = (static_cast<int>(values1[s]) - static_cast<int>(values2[s]) + 255) >> 1;
+            }
+
+            std::int64_t* h = &histogram[bin * (dim + 1)];
+            const std::int32_t* r = &residuals[s * dim];
+            h[0]++;
+            for (long k = 0; k < dim; ++k)
+            {
+                h[k + 1] += r[k];
+            }
+        }
+    }
+
+    // Best threshold for the feature pair given the (reduced) histogram of the node with
+    // total samples and residual sum (samples with a value > thresh go left):
+    static split_score scan_histogram(
+        const std::int64_t* histogram,
+        long dim,
+        std::int64_t total,
+        const std::int64_t* sum,
+        const impl::split_feature& feat,
+        bool do_npd)
+    {
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+        static thread_local std::vector<std::int64_t> left;
+#else
+        std::vector<std::int64_t> left; // per call without C++11 thread_local
+#endif
+        left.assign(dim, 0);
+
+        // Scan the thresholds below each bin from the top:
+        split_score best;
+        best.thresh = feat.thresh;
+
+        std::int64_t left_cnt = 0;
+        for (int bin = kHistogramBins - 1; bin >= 0; --bin)
+        {
+            const std::int64_t* h = &histogram[bin * (dim + 1)];
+            if (!h[0])
+            {
+                continue;
+            }
+
+            for (long k = 0; k < dim; ++k)
+            {
+                left[k] += h[k + 1];
+            }
+            left_cnt += h[0];
+
+            const std::int64_t right_cnt = total - left_cnt;
+            if (bin && right_cnt)
+            {
+                double left_dot = 0.0, right_dot = 0.0;
+                for (long k = 0; k < dim; ++k)
+                {
+                    const double l = static_cast<double>(left[k]);
+                    const double r = static_cast<double>(sum[k] - left[k]);
+                    left_dot += l * l;
+                    right_dot += r * r;
+                }
+
+                const double score = left_dot / left_cnt + right_dot / right_cnt;
+                if (score > best.score)
+                {
+                    // Bin b holds differences { 2b-255, 2b-254 } (npd in [b/128 - 1, (b+1)/128 - 1)):
+                    best.score = score;
+                    best.thresh = do_npd ? (static_cast<float>(bin) / 128.f - 1.f) : (2.f * bin - 255.5f);
+                }
+            }
+        }
+
+        return best;
+    }
+
+    impl::regression_tree make_regression_tree(
+        dlib::thread_pool& tp,
+        std::vector<training_sample>& samples,
+        const feature_cache& cache,
+        const PointVecf& pixel_coordinates,
+        bool do_npd = false,
+        bool do_pca = false) const
+    {
+        using namespace impl;
+
+        const unsigned long num = samples.size();
+        const long dim = do_pca ? samples[0].target_shape_.size() : samples[0].target_shape.size();
+        const long stride = dim + 1; // count + residual sum
+        const float to_fixed = static_cast<float>(1 << kResidualBits);
+
+        // Contiguous fixed point residuals (sample major):
+        std::vector<std::int32_t> residuals(num * dim);
+        parallel_for(tp, 0, num, [&](unsigned long i) {
+            const fshape& target = do_pca ? samples[i].target_shape_ : samples[i].target_shape;
+            const fshape& current = do_pca ? samples[i].current_shape_ : samples[i].current_shape;
+            std::int32_t* r = &residuals[i * dim];
+            for (long k = 0; k < dim; ++k)
+            {
+                r[k] = static_cast<std::int32_t>(std::lround((target(k) - current(k)) * to_fixed));
+            }
+        },
+            1);
+
+        // The local samples are partitioned through an index permutation (the cache isn't reordered):
+        std::vector<unsigned long> order;
+        order.reserve(num);
+        for (unsigned long i = 0; i < num; ++i)
+        {
+            if (is_local(samples[i]))
+            {
+                order.push_back(i);
+            }
+        }
+
+        const unsigned long num_split_nodes = static_cast<unsigned long>(std::pow(2.0, (double)get_tree_depth()) - 1);
+        const unsigned long num_test_splits = get_num_test_splits();
+
+        // Local sample ranges, and the (global) count and residual sum of each node:
+        std::vector<SampleRange> ranges(num_split_nodes * 2 + 1);
+        std::vector<std::int64_t> stats((num_split_nodes * 2 + 1) * stride, 0);
+        ranges[0] = SampleRange(0, order.size());
+        stats[0] = order.size();
+        sum_residuals(tp, residuals, dim, order, ranges[0], &stats[1]);
+        {
+            std::vector<std::int64_t> root(stats.begin(), stats.begin() + stride);
+            allreduce(root);
+            std::copy(root.begin(), root.end(), stats.begin());
+        }
+
+        impl::regression_tree tree;
+
+        // Breadth first, one tree level at a time:
+        std::vector<std::int64_t> histograms;
+        for (unsigned long depth = 0; depth < get_tree_depth(); ++depth)
+        {
+            const unsigned long first = (1UL << depth) - 1, count = (1UL << depth);
+
+            std::vector<impl::split_feature> feats(count * num_test_splits);
+            for (auto& feat : feats)
+            {
+                feat = randomly_generate_split_feature(pixel_coordinates, do_npd);
+            }
+
+            // Parallel over nodes and candidates:
+            const long size = kHistogramBins * stride;
+            std::vector<split_score> scores(feats.size());
+            if (_shard_count > 1)
+            {
+                // One message per tree level with the histograms of all candidates:
+                histograms.assign(feats.size() * size, 0);
+                parallel_for(tp, 0, feats.size(), [&](unsigned long i) {
+                    const unsigned long node = first + i / num_test_splits;
+                    accumulate_histogram(cache, residuals, dim, order, ranges[node], feats[i], do_npd, &histograms[i * size]);
+                },
+                    1);
+
+                allreduce(histograms);
+
+                parallel_for(tp, 0, feats.size(), [&](unsigned long i) {
+                    const unsigned long node = first + i / num_test_splits;
+                    scores[i] = scan_histogram(&histograms[i * size], dim, stats[node * stride], &stats[node * stride + 1], feats[i], do_npd);
+                },
+                    1);
+            }
+            else
+            {
+                parallel_for(tp, 0, feats.size(), [&](unsigned long i) {
+#if DRISHTI_HAVE_THREAD_LOCAL_STORAGE
+                    static thread_local std::vector<std::int64_t> histogram;
+#else
+                    std::vector<std::int64_t> histogram; // per split without C++11 thread_local
+#endif
+                    histogram.assign(size, 0);
+
+                    const unsigned long node = first + i / num_test_splits;
+                    accumulate_histogram(cache, residuals, dim, order, ranges[node], feats[i], do_npd, histogram.data());
+                    scores[i] = scan_histogram(histogram.data(), dim, stats[node * stride], &stats[node * stride + 1], feats[i], do_npd);
+                },
+                    1);
+            }
+
+            std::vector<std::int64_t> left_stats(count * stride, 0);
+            for (unsigned long i = 0; i < count; ++i)
+            {
+                const unsigned long node = first + i;
+
+                unsigned long best = i * num_test_splits;
+                for (unsigned long j = best + 1; j < (i + 1) * num_test_splits; ++j)
+                {
+                    if (scores[j].score > scores[best].score)
+                    {
+                        best = j;
+                    }
+                }
+
+                impl::split_feature split = feats[best];
+                split.thresh = scores[best].thresh;
+                tree.splits.push_back(split);
+
+                const auto& range = ranges[node];
+                const auto begin = order.begin() + range.first, end = order.begin() + range.second;
+                const auto mid = std::partition(begin, end, [&](unsigned long s) { return goes_left(cache, split, s, do_npd); });
+
+                // The histogram bins approximate the NPD boundaries, so the sums follow the partition:
+                ranges[left_child(node)] = SampleRange(range.first, range.first + (mid - begin));
+                ranges[right_child(node)] = SampleRange(range.first + (mid - begin), range.second);
+                left_stats[i * stride] = mid - begin;
+                sum_residuals(tp, residuals, dim, order, ranges[left_child(node)], &left_stats[i * stride + 1]);
+            }
+
+            allreduce(left_stats);
+
+            for (unsigned long i = 0; i < count; ++i)
+            {
+                const unsigned long node = first + i;
+                const std::int64_t* parent = &stats[node * stride];
+                const std::int64_t* left = &left_stats[i * stride];
+                std::int64_t* l = &stats[left_child(node) * stride];
+                std::int64_t* r = &stats[right_child(node) * stride];
+                for (long k = 0; k < stride; ++k)
+                {
+                    l[k] = left[k];
+                    r[k] = parent[k] - left[k];
+                }
+            }
+        }
+
+        tree.leaf_values.resize(num_split_nodes + 1);
+        for (unsigned long i = 0; i < tree.leaf_values.size(); ++i)
+        {
+            const std::int64_t* leaf = &stats[(num_split_nodes + i) * stride];
+
+            tree.leaf_values[i] = dlib::zeros_matrix<float>(dim, 1);
+            if (leaf[0])
+            {
+                const double scale = get_nu() / (static_cast<double>(leaf[0]) * (1 << kResidualBits));
+                for (long k = 0; k < dim; ++k)
+                {
+                    tree.leaf_values[i](k) = static_cast<float>(leaf[k + 1] * scale);
+                }
+            }
+
+            // now adjust the current shape based on these predictions
+            const auto& range = ranges[num_split_nodes + i];
+            parallel_for(tp, range.first, range.second, [&](unsigned long j) {
+                if (do_pca)
+                {
+                    samples[order[j]].current_shape_ += tree.leaf_values[i];
+                }
+                else
+                {
+                    samples[order[j]].current_shape += tree.leaf_values[i];
+                }
+            },
+                1);
+        }
+
+        return tree;
+    }
+
     impl::split_feature randomly_generate_split_feature(
         const PointVecf& pixel_coordinates,
         bool do_npd = false) const
@@ -1071,6 +1777,14 @@ private:
     bool _do_npd = false;
     bool _do_affine = false;
     bool _do_line_indexed = false;
+    bool _do_feature_cache = false;
+    std::vector<int> _octaves;
+    std::vector<int> _landmarks; // empty == all parts
+    std::string _checkpoint;
+    cascade_callback _cascade_callback;
+    unsigned long _shard_rank = 0;
+    unsigned long _shard_count = 1;
+    allreduce_function _allreduce;
     dlib::drectangle _roi = { 0.f, 0.f, 0.f, 0.f };
 
     // experimental
@@ -1089,7 +1803,8 @@ double test_shape_predictor(
     const image_array& images,
     const std::vector<std::vector<dlib::full_object_detection>>& objects,
     const std::vector<std::vector<double>>& scales,
-    int ellipse_count = 0)
+    int ellipse_count = 0,
+    unsigned long num_threads = 1)
 {
 // make sure requires clause is not broken
 #ifdef ENABLE_ASSERTS
@@ -1102,7 +1817,7 @@ double test_shape_predictor(
     {
         for (unsigned long j = 0; j < objects[i].size(); ++j)
         {
-            DLIB_CASSERT(objects[i][j].num_parts() == sp.num_parts(),
+            DLIB_CASSERT(!sp.landmarks.empty() || (objects[i][j].num_parts() == sp.num_parts()),
                 "\t double test_shape_predictor()"
                     << "\n\t Invalid inputs were given to this function. "
                     << "\n\t objects[" << i << "][" << j << "].num_parts(): " << objects[i][j].num_parts()
@@ -1119,22 +1834,43 @@ double test_shape_predictor(
     }
 #endif
 
-    dlib::running_stats<double> rs;
+    // Flatten the detections so each one is evaluated independently (in parallel):
+    std::vector<std::pair<unsigned long, unsigned long>> indices;
     for (unsigned long i = 0; i < objects.size(); ++i)
     {
         for (unsigned long j = 0; j < objects[i].size(); ++j)
         {
-            // Just use a scale of 1 (i.e. no scale at all) if the caller didn't supply
-            // any scales.
-            const double scale = scales.size() == 0 ? 1 : scales[i][j];
+            indices.emplace_back(i, j);
+        }
+    }
 
-            dlib::full_object_detection det = sp(images[i], objects[i][j].get_rect());
+    std::vector<std::vector<double>> errors(indices.size());
+    dlib::thread_pool tp(num_threads > 1 ? num_threads : 0);
+    parallel_for(tp, 0, indices.size(), [&](unsigned long n) {
+        const unsigned long i = indices[n].first, j = indices[n].second;
 
-            for (unsigned long k = 0; k < det.num_parts(); ++k)
-            {
-                double score = length(det.part(k) - objects[i][j].part(k)) / scale;
-                rs.add(score);
-            }
+        // Just use a scale of 1 (i.e. no scale at all) if the caller didn't supply
+        // any scales.
+        const double scale = scales.size() == 0 ? 1 : scales[i][j];
+
+        dlib::full_object_detection det = sp(images[i], objects[i][j].get_rect());
+
+        errors[n].resize(det.num_parts());
+        for (unsigned long k = 0; k < det.num_parts(); ++k)
+        {
+            // Subset models are compared with the annotation points they regress:
+            const unsigned long part = sp.landmarks.empty() ? k : static_cast<unsigned long>(sp.landmarks[k]);
+            errors[n][k] = length(det.part(k) - objects[i][j].part(part)) / scale;
+        }
+    });
+
+    // Accumulate in the serial order so the result doesn't depend on num_threads:
+    dlib::running_stats<double> rs;
+    for (const auto& e : errors)
+    {
+        for (const auto& score : e)
+        {
+            rs.add(score);
         }
     }
     return rs.mean();
@@ -1145,10 +1881,231 @@ template <
 double test_shape_predictor(
     const shape_predictor& sp,
     const image_array& images,
-    const std::vector<std::vector<dlib::full_object_detection>>& objects)
+    const std::vector<std::vector<dlib::full_object_detection>>& objects,
+    unsigned long num_threads = 1)
 {
     std::vector<std::vector<double>> no_scales;
-    return test_shape_predictor(sp, images, objects, no_scales);
+    return test_shape_predictor(sp, images, objects, no_scales, 0, num_threads);
+}
+
+// ----------------------------------------------------------------------------------------
+
+// ::: Tree pruning for deployed models (finer grained than truncating cascade levels) :::
+
+struct tree_statistics
+{
+    // Per cascade level, in the level's regression space (PCA coefficients with shape space regression):
+    struct level
+    {
+        unsigned long trees = 0;
+        long dim = 0;
+        std::vector<unsigned short> leaves; // [sample * trees + tree] leaf reached by each validation sample
+        std::vector<float> residuals;       // [sample * dim + k] target - shape after the level
+        std::vector<double> gains;          // [tree] mean squared error increase if the tree is removed
+    };
+
+    unsigned long samples = 0;
+    std::vector<level> levels;
+};
+
+/*
+ * Evaluate the (float) cascade on validation data, recording the leaf reached in each tree.  The
+ * gain of a tree is the error increase at the end of its level if it were removed (the effect on
+ * the features of later levels is ignored): mean of 2 * r.d + d.d for the level residual r and
+ * the tree's delta d.
+ */
+template <typename image_array>
+tree_statistics measure_tree_statistics(
+    const shape_predictor& sp,
+    const image_array& images,
+    const std::vector<std::vector<dlib::full_object_detection>>& objects,
+    unsigned long num_threads = 1)
+{
+    std::vector<std::pair<unsigned long, unsigned long>> indices;
+    for (unsigned long i = 0; i < objects.size(); ++i)
+    {
+        for (unsigned long j = 0; j < objects[i].size(); ++j)
+        {
+            indices.emplace_back(i, j);
+        }
+    }
+
+    tree_statistics stats;
+    stats.samples = indices.size();
+    stats.levels.resize(sp.forests.size());
+    for (std::size_t iter = 0; iter < sp.forests.size(); iter++)
+    {
+        auto& level = stats.levels[iter];
+        level.trees = sp.forests[iter].size();
+        level.dim = sp.forests[iter][0].leaf_values[0].size();
+        level.leaves.resize(stats.samples * level.trees);
+        level.residuals.resize(stats.samples * level.dim);
+    }
+
+    const bool do_pca = sp.m_pca ? true : false;
+
+    dlib::thread_pool tp(num_threads > 1 ? num_threads : 0);
+    parallel_for(tp, 0, indices.size(), [&](unsigned long n) {
+        const auto& obj = objects[indices[n].first][indices[n].second];
+        const auto& img = images[indices[n].first];
+        const dlib::rectangle rect = obj.get_rect();
+
+        fshape target = shape_predictor_trainer::object_to_shape(obj, sp.m_ellipse_count), target_full_;
+        fshape current_shape = sp.initial_shape, current_shape_full_;
+        if (do_pca)
+        {
+            shape_predictor::project(*sp.m_pca, target, target_full_);
+            shape_predictor::project(*sp.m_pca, current_shape, current_shape_full_);
+        }
+
+        impl::octave_pyramid pyramid;
+        std::vector<float> feature_pixel_values, feature_scratch;
+        for (unsigned long iter = 0; iter < sp.forests.size(); ++iter)
+        {
+            auto& level = stats.levels[iter];
+            if (do_pca)
+            {
+                shape_predictor::back_project(*sp.m_pca, int(level.dim), current_shape_full_, current_shape);
+            }
+
+            const int octave = sp.get_octave(iter);
+            if (octave > 0)
+            {
+                const dlib::cv_image<unsigned char> image(pyramid.get(img, octave));
+                sp.extract_level_features(image, rect, current_shape, iter, feature_pixel_values, false, impl::octave_pyramid::scale(octave), feature_scratch);
+            }
+            else
+            {
+                sp.extract_level_features(img, rect, current_shape, iter, feature_pixel_values, false, 1.f, feature_scratch);
+            }
+
+            fshape delta = dlib::zeros_matrix<float>(level.dim, 1);
+            for (unsigned long t = 0; t < level.trees; ++t)
+            {
+                const auto& tree = sp.forests[iter][t];
+                const fshape& leaf = tree(feature_pixel_values, sp.m_npd);
+                level.leaves[n * level.trees + t] = static_cast<unsigned short>(&leaf - tree.leaf_values.data());
+                delta += leaf;
+            }
+
+            auto range = dlib::range(0, level.dim - 1);
+            if (do_pca)
+            {
+                dlib::set_rowm(current_shape_full_, range) += delta;
+            }
+            else
+            {
+                current_shape += delta;
+            }
+
+            const fshape residual = do_pca ? fshape(dlib::rowm(target_full_, range) - dlib::rowm(current_shape_full_, range)) : fshape(target - current_shape);
+            std::copy(residual.begin(), residual.end(), &level.residuals[n * level.dim]);
+        }
+    });
+
+    for (std::size_t iter = 0; iter < sp.forests.size(); iter++)
+    {
+        auto& level = stats.levels[iter];
+        level.gains.assign(level.trees, 0.0);
+        for (unsigned long t = 0; t < level.trees; ++t)
+        {
+            const auto& tree = sp.forests[iter][t];
+            for (unsigned long n = 0; n < stats.samples; ++n)
+            {
+                const fshape& d = tree.leaf_values[level.leaves[n * level.trees + t]];
+                const float* r = &level.residuals[n * level.dim];
+                for (long k = 0; k < level.dim; ++k)
+                {
+                    level.gains[t] += 2.0 * r[k] * d(k) + double(d(k)) * d(k);
+                }
+            }
+            level.gains[t] /= std::max(stats.samples, 1ul);
+        }
+    }
+
+    return stats;
+}
+
+/*
+ * Keep the ceil(keep * trees) trees with the largest gain in each level (at least one).  The deltas
+ * of the removed trees are merged into the leaves of the kept tree with the largest gain: each of
+ * its leaves receives the mean delta of the removed trees over the validation samples that reach
+ * it (the overall mean for leaves no sample reaches), which preserves the mean correction of the
+ * level.  The fixed point, quantized and compiled representations are rebuilt when present.
+ */
+inline void prune_trees(shape_predictor& sp, const tree_statistics& stats, float keep)
+{
+    const bool had16 = !sp.forests.empty() && !sp.forests[0].empty() && !sp.forests[0][0].leaf_values_16.empty();
+
+    for (std::size_t iter = 0; iter < sp.forests.size(); iter++)
+    {
+        const auto& level = stats.levels[iter];
+        auto& forest = sp.forests[iter];
+
+        const auto count = static_cast<unsigned long>(std::ceil(std::max(0.f, std::min(keep, 1.f)) * level.trees));
+        const unsigned long kept_count = std::max(count, 1ul);
+        if (kept_count >= level.trees)
+        {
+            continue;
+        }
+
+        std::vector<unsigned long> order(level.trees);
+        std::iota(order.begin(), order.end(), 0ul);
+        std::stable_sort(order.begin(), order.end(), [&](unsigned long a, unsigned long b) { return level.gains[a] > level.gains[b]; });
+
+        const unsigned long anchor = order[0];
+        const auto& anchor_leaves = forest[anchor].leaf_values;
+
+        // Sum of the removed deltas per anchor leaf (and overall):
+        std::vector<fshape> sums(anchor_leaves.size() + 1, dlib::zeros_matrix<float>(level.dim, 1));
+        std::vector<unsigned long> counts(anchor_leaves.size() + 1, 0);
+        for (unsigned long n = 0; n < stats.samples; ++n)
+        {
+            const unsigned short leaf = level.leaves[n * level.trees + anchor];
+            for (unsigned long i = kept_count; i < level.trees; ++i)
+            {
+                const unsigned long t = order[i];
+                const fshape& d = forest[t].leaf_values[level.leaves[n * level.trees + t]];
+                sums[leaf] += d;
+                sums.back() += d;
+            }
+            counts[leaf]++;
+            counts.back()++;
+        }
+
+        std::vector<impl::regression_tree> pruned;
+        std::sort(order.begin(), order.begin() + kept_count); // keep the original tree order
+        for (unsigned long i = 0; i < kept_count; ++i)
+        {
+            pruned.push_back(forest[order[i]]);
+            if (order[i] == anchor)
+            {
+                auto& tree = pruned.back();
+                for (std::size_t leaf = 0; leaf < tree.leaf_values.size(); leaf++)
+                {
+                    const std::size_t j = counts[leaf] ? leaf : counts.size() - 1;
+                    if (counts[j])
+                    {
+                        tree.leaf_values[leaf] += sums[j] / float(counts[j]);
+                    }
+                }
+            }
+        }
+        forest.swap(pruned);
+    }
+
+    if (sp.isQuantized())
+    {
+        sp.quantize(); // new int8 codes (and fixed point leaves)
+    }
+    else if (had16)
+    {
+        sp.populate_f16();
+    }
+    else if (!sp.flat_forests.empty())
+    {
+        sp.compile();
+    }
 }
 
 DRISHTI_ML_NAMESPACE_END
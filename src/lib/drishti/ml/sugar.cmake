@@ -17,6 +17,7 @@ sugar_files(DRISHTI_ML_SRCS
   RTEShapeEstimatorArchiveCereal.cpp  
   RegressionTreeEnsembleShapeEstimator.cpp
   ShapeEstimator.cpp
+  TreeEnsemble.cpp
   XGBooster.cpp
   XGBoosterIOArchiveCereal.cpp
   )
@@ -29,6 +30,7 @@ sugar_files(DRISHTI_ML_HDRS_PUBLIC
   RTEShapeEstimatorImpl.h
   RegressionTreeEnsembleShapeEstimator.h
   ShapeEstimator.h
+  TreeEnsemble.h
   XGBooster.h
   XGBoosterImpl.h  
   drishti_ml.h
@@ -38,13 +40,27 @@ sugar_files(DRISHTI_ML_HDRS_PUBLIC
 
 if(DRISHTI_BUILD_ACF)
   sugar_files(DRISHTI_ML_SRCS
+    AcfCascade.cpp
+    AcfCascadeArchiveCereal.cpp
+    AcfDistiller.cpp
+    AcfNegativeMiner.cpp
+    AcfNegativeMinerArchiveCereal.cpp
+    AcfPyramidCache.cpp
     ObjectDetector.cpp
     ObjectDetectorACF.cpp
+    ObjectDetectorACFMulti.cpp
+    ObjectDetectorACFTiled.cpp
   )
 
   sugar_files(DRISHTI_ML_HDRS_PUBLIC
+    AcfCascade.h
+    AcfDistiller.h
+    AcfNegativeMiner.h
+    AcfPyramidCache.h
     ObjectDetector.h
     ObjectDetectorACF.h
+    ObjectDetectorACFMulti.h
+    ObjectDetectorACFTiled.h
   )
 endif()
   
@@ -10,13 +10,25 @@
 
 #include <gtest/gtest.h>
 
+#include <dlib/array.h>
+
 #include "drishti/ml/RegressionTreeEnsembleShapeEstimator.h"
 #include "drishti/ml/XGBooster.h"
 #include "drishti/ml/PCA.h"
+#include "drishti/ml/TreeEnsemble.h"
+#include "drishti/ml/shape_predictor.h"
+#include "drishti/ml/shape_predictor_trainer.h"
 
 #include "drishti/core/drishti_stdlib_string.h"
 #include "drishti/core/drishti_cereal_pba.h"
 #include "drishti/core/drishti_cv_cereal.h"
+#include "drishti/core/FlatArchive.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 TEST(XGBooster, XGBoosterInit) // NOLINT (TODO)
 {
@@ -79,3 +91,609 @@ TEST(StandardizedPCA, gemm_transpose_non_continuous) // NOLINT (TODO)
         }
     }
 }
+
+TEST(StandardizedPCA, preallocated_kernels) // NOLINT (TODO)
+{
+    // Correlated samples (rank 4 + noise) with non uniform scales:
+    cv::RNG rng(1);
+    cv::Mat1f basis(4, 12), weights(64, 4), data(64, 12), noise(64, 12);
+    rng.fill(basis, cv::RNG::UNIFORM, -1.f, 1.f);
+    rng.fill(weights, cv::RNG::NORMAL, 0.f, 4.f);
+    rng.fill(noise, cv::RNG::NORMAL, 0.f, 0.01f);
+    data = weights * basis + noise;
+    for (int i = 0; i < data.cols; i++)
+    {
+        data.col(i) = data.col(i) * float(i + 1) + float(i);
+    }
+
+    drishti::ml::StandardizedPCA pca;
+    cv::Mat projection;
+    pca.compute(data, projection, 6);
+    ASSERT_EQ(pca.getDimension(), data.cols);
+    ASSERT_EQ(pca.getProjectionDimension(), 6);
+
+    for (int n : { 0, 3 })
+    {
+        const cv::Mat1f expected = pca.project(data, n);
+        cv::Mat1f coefficients;
+        pca.project(data, coefficients, n);
+        ASSERT_EQ(coefficients.size(), expected.size());
+        EXPECT_LT(cv::norm(coefficients, expected, cv::NORM_INF), 1e-3);
+
+        // Truncated back projection matches the reference, and the buffer is reused:
+        const cv::Mat1f reconstruction = pca.backProject(expected);
+        cv::Mat1f samples(data.rows, data.cols);
+        const float* buffer = samples.ptr<float>();
+        pca.backProject(coefficients, samples);
+        EXPECT_EQ(samples.ptr<float>(), buffer);
+        EXPECT_LT(cv::norm(samples, reconstruction, cv::NORM_INF), 1e-2);
+    }
+}
+
+TEST(shape_predictor, flat_forest) // NOLINT (TODO)
+{
+    using drishti::ml::impl::regression_tree;
+    using drishti::ml::impl::split_feature;
+
+    const int depth = 4, dim = 6, features = 32, trees = 16;
+
+    cv::RNG rng;
+    std::vector<regression_tree> forest(trees);
+    for (auto& tree : forest)
+    {
+        for (int i = 0; i < ((1 << depth) - 1); i++)
+        {
+            tree.splits.emplace_back(rng.uniform(0, features), rng.uniform(0, features), rng.uniform(-32.f, 32.f));
+        }
+        tree.leaf_values.resize(1 << depth);
+        tree.leaf_values_16.resize(1 << depth);
+        for (int i = 0; i < tree.leaf_values.size(); i++)
+        {
+            tree.leaf_values[i].set_size(dim);
+            for (int k = 0; k < dim; k++)
+            {
+                tree.leaf_values[i](k) = rng.uniform(-1.f, 1.f);
+            }
+            tree.leaf_values_16[i].set_size(dim);
+            drishti::core::convertFixedPoint(&tree.leaf_values[i](0), &tree.leaf_values_16[i](0), dim, FIXED_PRECISION);
+        }
+    }
+
+    const drishti::ml::impl::flat_forest flat(forest);
+    ASSERT_EQ(flat.size(), forest.size());
+    ASSERT_EQ(flat.dim, dim);
+
+    std::vector<float> values(features);
+    for (auto& v : values)
+    {
+        v = rng.uniform(0.f, 255.f);
+    }
+
+    for (bool npd : { false, true })
+    {
+        drishti::ml::fshape expected(dim), actual;
+        drishti::ml::DVec16s expected16(dim), actual16;
+        expected = 0.f;
+        expected16 = 0;
+        for (const auto& tree : forest)
+        {
+            expected += tree(values, npd);
+            expected16 += tree(values, drishti::ml::impl::Fixed(), npd);
+        }
+
+        flat.accumulate(values, npd, actual);
+        flat.accumulate(values, 0, flat.size(), npd, actual16);
+        for (int k = 0; k < dim; k++)
+        {
+            EXPECT_FLOAT_EQ(expected(k), actual(k));
+            EXPECT_EQ(expected16(k), actual16(k));
+        }
+
+        // Tree major batch (the same feature vector twice) must match:
+        drishti::ml::fshape batch[2];
+        drishti::ml::DVec16s batch16[2];
+        const std::vector<const std::vector<float>*> inputs{ &values, &values };
+        flat.accumulate(inputs, npd, std::vector<drishti::ml::fshape*>{ &batch[0], &batch[1] });
+        flat.accumulate(inputs, npd, std::vector<drishti::ml::DVec16s*>{ &batch16[0], &batch16[1] });
+        for (int b = 0; b < 2; b++)
+        {
+            for (int k = 0; k < dim; k++)
+            {
+                EXPECT_FLOAT_EQ(expected(k), batch[b](k));
+                EXPECT_EQ(expected16(k), batch16[b](k));
+            }
+        }
+    }
+}
+
+TEST(shape_predictor, fixed_point_calibration) // NOLINT (TODO)
+{
+    using drishti::ml::impl::regression_tree;
+    using drishti::ml::impl::split_feature;
+
+    const int depth = 3, dim = 4, features = 16, trees = 64;
+
+    // Full shape leaves (|leaf| up to 40) overflow int16 at FIXED_PRECISION:
+    for (float range : { 0.01f, 40.f })
+    {
+        cv::RNG rng;
+        std::vector<regression_tree> forest(trees);
+        for (auto& tree : forest)
+        {
+            for (int i = 0; i < ((1 << depth) - 1); i++)
+            {
+                tree.splits.emplace_back(rng.uniform(0, features), rng.uniform(0, features), rng.uniform(-32.f, 32.f));
+            }
+            tree.leaf_values.resize(1 << depth);
+            for (auto& leaf : tree.leaf_values)
+            {
+                leaf.set_size(dim);
+                for (int k = 0; k < dim; k++)
+                {
+                    leaf(k) = range; // worst case: every tree adds the maximum
+                }
+            }
+        }
+
+        float error = 0.f;
+        const int fraction = drishti::ml::impl::calibrate_fixed_point(forest, &error);
+        const float unit = 1.f / float(1 << fraction);
+        EXPECT_LE(error, unit);
+        if (range > 1.f)
+        {
+            EXPECT_LT(fraction, FIXED_PRECISION);
+        }
+        else
+        {
+            EXPECT_EQ(fraction, FIXED_PRECISION_MAX);
+        }
+
+        std::vector<float> values(features);
+        for (auto& v : values)
+        {
+            v = rng.uniform(0.f, 255.f);
+        }
+
+        const drishti::ml::impl::flat_forest flat(forest, 0.f, fraction);
+        drishti::ml::fshape expected(dim);
+        drishti::ml::DVec32s actual;
+        expected = 0.f;
+        for (const auto& tree : forest)
+        {
+            expected += tree(values, false);
+        }
+        flat.accumulate(values, 0, flat.size(), false, actual);
+        for (int k = 0; k < dim; k++)
+        {
+            EXPECT_NEAR(expected(k), float(actual(k)) * unit, float(trees) * unit);
+        }
+    }
+}
+
+TEST(shape_predictor, octave_features) // NOLINT (TODO)
+{
+    // Pose indexed features sampled from a downscaled gradient image should match full resolution:
+    cv::Mat1b image(48, 64);
+    for (int y = 0; y < image.rows; y++)
+    {
+        for (int x = 0; x < image.cols; x++)
+        {
+            image(y, x) = static_cast<std::uint8_t>(x + 2 * y);
+        }
+    }
+
+    drishti::ml::fshape shape(4);
+    shape = 0.2f, 0.3f, 0.7f, 0.6f;
+
+    cv::RNG rng;
+    std::vector<unsigned short> anchor_idx(32);
+    drishti::ml::PointVecf deltas(anchor_idx.size());
+    for (std::size_t i = 0; i < anchor_idx.size(); i++)
+    {
+        anchor_idx[i] = static_cast<unsigned short>(i % 2);
+        deltas[i] = drishti::ml::fpoint(rng.uniform(-0.1f, 0.1f), rng.uniform(-0.1f, 0.1f));
+    }
+
+    const dlib::rectangle rect(4, 4, 59, 43);
+    const dlib::cv_image<unsigned char> full(image);
+
+    std::vector<float> expected;
+    drishti::ml::impl::extract_feature_pixel_values(full, rect, shape, shape, anchor_idx, deltas, expected);
+
+    drishti::ml::impl::octave_pyramid pyramid;
+    for (int octave : { 1, 2 })
+    {
+        const dlib::cv_image<unsigned char> level(pyramid.get(full, octave));
+        ASSERT_EQ(level.nc(), image.cols >> octave);
+
+        std::vector<float> actual;
+        const float scale = drishti::ml::impl::octave_pyramid::scale(octave);
+        drishti::ml::impl::extract_feature_pixel_values(level, rect, shape, shape, anchor_idx, deltas, actual, 0, false, false, scale);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); i++)
+        {
+            EXPECT_NEAR(expected[i], actual[i], 3.f * static_cast<float>(1 << octave)); // rounding to the coarse grid
+        }
+    }
+}
+
+TEST(shape_predictor, fixed_tform_kernels) // NOLINT (TODO)
+{
+    // The closed form (and unrolled) kernels must match dlib's least squares solutions:
+    cv::RNG rng;
+    for (int num : { 68, 51, 7 })
+    {
+        drishti::ml::fshape from(num * 2), to(num * 2);
+        drishti::ml::PointVecf from_points(num), to_points(num);
+        for (int i = 0; i < num; i++)
+        {
+            from_points[i] = drishti::ml::fpoint(rng.uniform(0.f, 1.f), rng.uniform(0.f, 1.f));
+            to_points[i] = drishti::ml::fpoint(0.9f * from_points[i].x() - 0.2f * from_points[i].y() + 0.1f, 0.2f * from_points[i].x() + 0.9f * from_points[i].y() - 0.3f);
+            to_points[i] += drishti::ml::fpoint(rng.uniform(-0.01f, 0.01f), rng.uniform(-0.01f, 0.01f));
+            from(i * 2 + 0) = from_points[i].x();
+            from(i * 2 + 1) = from_points[i].y();
+            to(i * 2 + 0) = to_points[i].x();
+            to(i * 2 + 1) = to_points[i].y();
+        }
+
+        for (bool do_affine : { false, true })
+        {
+            const auto expected = do_affine ? dlib::find_affine_transform(from_points, to_points) : dlib::find_similarity_transform(from_points, to_points);
+            const auto actual = drishti::ml::impl::find_tform_between_shapes(from, to, 0, do_affine);
+            EXPECT_LT(dlib::max(dlib::abs(expected.get_m() - actual.get_m())), 1e-4);
+            EXPECT_LT(dlib::length(expected.get_b() - actual.get_b()), 1e-4);
+        }
+    }
+}
+
+#if !DRISHTI_BUILD_MIN_SIZE
+// Element-wise sum over count threads (stands in for MPI_Allreduce):
+struct ThreadAllreduce
+{
+    explicit ThreadAllreduce(int count)
+        : count(count)
+    {
+    }
+
+    void operator()(std::vector<std::int64_t>& values)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return !draining; });
+        if (!arrived)
+        {
+            sum.assign(values.size(), 0);
+        }
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            sum[i] += values[i];
+        }
+        if (++arrived == count)
+        {
+            draining = true;
+            cv.notify_all();
+        }
+        else
+        {
+            cv.wait(lock, [&]() { return draining; });
+        }
+
+        values = sum;
+        if (--arrived == 0)
+        {
+            draining = false;
+            cv.notify_all();
+        }
+    }
+
+    int count = 0;
+    int arrived = 0;
+    bool draining = false;
+    std::vector<std::int64_t> sum;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+// Random images, each with one 3 point shape:
+static void make_training_set(dlib::array<dlib::array2d<std::uint8_t>>& images, std::vector<std::vector<dlib::full_object_detection>>& objects)
+{
+    cv::RNG rng;
+    images.resize(8);
+    objects.resize(images.size());
+    for (std::size_t i = 0; i < images.size(); i++)
+    {
+        cv::Mat1b image(32, 32);
+        rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+        dlib::assign_image(images[i], dlib::cv_image<std::uint8_t>(image));
+
+        std::vector<dlib::point> parts;
+        for (int k = 0; k < 3; k++)
+        {
+            parts.emplace_back(rng.uniform(8, 24), rng.uniform(8, 24));
+        }
+        objects[i].emplace_back(dlib::rectangle(4, 4, 27, 27), parts);
+    }
+}
+
+TEST(shape_predictor_trainer, sharded_training) // NOLINT (TODO)
+{
+    // Training over 2 shards should produce the same model as a single process:
+    dlib::array<dlib::array2d<std::uint8_t>> images;
+    std::vector<std::vector<dlib::full_object_detection>> objects;
+    make_training_set(images, objects);
+
+    auto make_trainer = []() {
+        drishti::ml::shape_predictor_trainer trainer;
+        trainer.set_cascade_depth(2);
+        trainer.set_tree_depth(2);
+        trainer.set_num_trees_per_cascade_level(3);
+        trainer.set_oversampling_amount(4);
+        trainer.set_feature_pool_size(20);
+        trainer.set_num_test_splits(5);
+        trainer.set_do_feature_cache(true);
+        return trainer;
+    };
+
+    const auto expected = make_trainer().train(images, objects);
+
+    const int count = 2;
+    ThreadAllreduce allreduce(count);
+    std::vector<drishti::ml::shape_predictor> shards(count);
+    std::vector<std::thread> threads;
+    for (int rank = 0; rank < count; rank++)
+    {
+        threads.emplace_back([&, rank]() {
+            auto trainer = make_trainer();
+            trainer.set_shard(rank, count, std::ref(allreduce));
+            shards[rank] = trainer.train(images, objects);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const auto& actual : shards)
+    {
+        ASSERT_EQ(expected.forests.size(), actual.forests.size());
+        for (std::size_t i = 0; i < expected.forests.size(); i++)
+        {
+            ASSERT_EQ(expected.forests[i].size(), actual.forests[i].size());
+            for (std::size_t j = 0; j < expected.forests[i].size(); j++)
+            {
+                const auto& a = expected.forests[i][j];
+                const auto& b = actual.forests[i][j];
+                ASSERT_EQ(a.splits.size(), b.splits.size());
+                for (std::size_t k = 0; k < a.splits.size(); k++)
+                {
+                    EXPECT_EQ(a.splits[k].idx1, b.splits[k].idx1);
+                    EXPECT_EQ(a.splits[k].idx2, b.splits[k].idx2);
+                    EXPECT_EQ(a.splits[k].thresh, b.splits[k].thresh);
+                }
+                ASSERT_EQ(a.leaf_values.size(), b.leaf_values.size());
+                for (std::size_t k = 0; k < a.leaf_values.size(); k++)
+                {
+                    EXPECT_EQ(dlib::max(dlib::abs(a.leaf_values[k] - b.leaf_values[k])), 0.f);
+                }
+            }
+        }
+    }
+}
+
+TEST(shape_predictor_trainer, prune_trees) // NOLINT (TODO)
+{
+    dlib::array<dlib::array2d<std::uint8_t>> images;
+    std::vector<std::vector<dlib::full_object_detection>> objects;
+    make_training_set(images, objects);
+
+    drishti::ml::shape_predictor_trainer trainer;
+    trainer.set_cascade_depth(2);
+    trainer.set_tree_depth(2);
+    trainer.set_num_trees_per_cascade_level(8);
+    trainer.set_oversampling_amount(2);
+    trainer.set_feature_pool_size(20);
+    const auto sp = trainer.train(images, objects);
+
+    const auto stats = drishti::ml::measure_tree_statistics(sp, images, objects);
+    ASSERT_EQ(stats.samples, objects.size());
+    ASSERT_EQ(stats.levels.size(), sp.forests.size());
+
+    auto pruned = sp;
+    drishti::ml::prune_trees(pruned, stats, 0.25f);
+    for (const auto& forest : pruned.forests)
+    {
+        EXPECT_EQ(forest.size(), 2);
+    }
+
+    // The first level sees the same features, and the merged leaves preserve its mean correction:
+    const auto pruned_stats = drishti::ml::measure_tree_statistics(pruned, images, objects);
+    const auto& before = stats.levels[0];
+    const auto& after = pruned_stats.levels[0];
+    for (long k = 0; k < before.dim; k++)
+    {
+        double mean_before = 0.0, mean_after = 0.0;
+        for (unsigned long n = 0; n < stats.samples; n++)
+        {
+            mean_before += before.residuals[n * before.dim + k];
+            mean_after += after.residuals[n * after.dim + k];
+        }
+        EXPECT_NEAR(mean_before / stats.samples, mean_after / stats.samples, 1e-4);
+    }
+}
+
+TEST(shape_predictor_trainer, landmark_subset) // NOLINT (TODO)
+{
+    dlib::array<dlib::array2d<std::uint8_t>> images;
+    std::vector<std::vector<dlib::full_object_detection>> objects;
+    make_training_set(images, objects);
+
+    drishti::ml::shape_predictor_trainer trainer;
+    trainer.set_cascade_depth(2);
+    trainer.set_tree_depth(2);
+    trainer.set_num_trees_per_cascade_level(3);
+    trainer.set_oversampling_amount(2);
+    trainer.set_feature_pool_size(20);
+    trainer.set_landmarks({ 2, 0 });
+    const auto sp = trainer.train(images, objects);
+
+    // Leaves and feature anchors only cover the selected parts:
+    ASSERT_EQ(sp.num_parts(), 2);
+    ASSERT_EQ(sp.landmarks, std::vector<int>({ 2, 0 }));
+    for (const auto& forest : sp.forests)
+    {
+        for (const auto& tree : forest)
+        {
+            EXPECT_EQ(tree.leaf_values.front().size(), 4);
+        }
+    }
+    for (const auto& anchors : sp.anchor_idx)
+    {
+        for (const auto& anchor : anchors)
+        {
+            EXPECT_LT(anchor, 2);
+        }
+    }
+
+    // Scored against the annotation points they regress:
+    EXPECT_GE(drishti::ml::test_shape_predictor(sp, images, objects, {}), 0.0);
+
+    std::stringstream ss;
+    serialize(sp, ss);
+    drishti::ml::shape_predictor sp2;
+    deserialize(sp2, ss);
+    EXPECT_EQ(sp2.landmarks, sp.landmarks);
+}
+#endif // !DRISHTI_BUILD_MIN_SIZE
+
+TEST(TreeEnsemble, unbalanced) // NOLINT (TODO)
+{
+    using drishti::ml::TreeEnsemble;
+
+    // Unbalanced tree: f0 < 0.5 ? 1.0 : (f1 < 0.25 ? 2.0 : 3.0), missing f1 => left
+    auto split = [](int feature, float threshold, bool defaultLeft, int left, int right) {
+        TreeEnsemble::Node node;
+        node.leaf = false;
+        node.feature = feature;
+        node.value = threshold;
+        node.defaultLeft = defaultLeft;
+        node.left = left;
+        node.right = right;
+        return node;
+    };
+
+    TreeEnsemble::Tree tree(5);
+    tree[0] = split(0, 0.5f, false, 1, 2);
+    tree[1].value = 1.f;
+    tree[2] = split(1, 0.25f, true, 3, 4);
+    tree[3].value = 2.f;
+    tree[4].value = 3.f;
+
+    TreeEnsemble ensemble;
+    ASSERT_TRUE(ensemble.create({ tree, tree }, 0.5f, TreeEnsemble::kLinear));
+    ASSERT_EQ(ensemble.getDepth(), 2);
+    ASSERT_EQ(ensemble.getMaxFeature(), 1);
+
+    const std::vector<float> features = { 0.f, 0.f, 1.f, 0.f, 1.f, 1.f, 1.f, NAN };
+    std::vector<float> predictions(4);
+    ensemble(features.data(), 4, 2, 2, predictions.data());
+
+    EXPECT_FLOAT_EQ(predictions[0], 2.5f);
+    EXPECT_FLOAT_EQ(predictions[1], 4.5f);
+    EXPECT_FLOAT_EQ(predictions[2], 6.5f);
+    EXPECT_FLOAT_EQ(predictions[3], 4.5f);
+    EXPECT_EQ(predictions[2], ensemble(&features[4]));
+}
+
+TEST(TreeEnsemble, flat) // NOLINT (TODO)
+{
+    using drishti::ml::TreeEnsemble;
+
+    // f0 < 0.5 ? 1.0 : 2.0
+    TreeEnsemble::Tree tree(3);
+    tree[0].leaf = false;
+    tree[0].value = 0.5f;
+    tree[0].left = 1;
+    tree[0].right = 2;
+    tree[1].value = 1.f;
+    tree[2].value = 2.f;
+
+    TreeEnsemble ensemble;
+    ASSERT_TRUE(ensemble.create({ tree, tree, tree }, 0.25f, TreeEnsemble::kLinear));
+
+    drishti::core::FlatArchiveWriter writer;
+    ensemble.save(writer, "test");
+
+    std::stringstream ss;
+    ASSERT_TRUE(writer.write(ss));
+
+    TreeEnsemble mapped;
+    ASSERT_FALSE(mapped.load(nullptr, "test"));
+    ASSERT_TRUE(mapped.load(drishti::core::FlatArchive::read(ss), "test"));
+    ASSERT_EQ(mapped.size(), 3);
+
+    for (float x : { 0.f, 1.f })
+    {
+        EXPECT_FLOAT_EQ(mapped(&x), ensemble(&x));
+    }
+}
+
+// Minimal estimator for the batch protocol: one point at the brightest pixel of the crop.
+class BrightestPointEstimator : public drishti::ml::ShapeEstimator
+{
+public:
+    int operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const override
+    {
+        return 0;
+    }
+    int operator()(const cv::Mat& crop, Point2fVec& points, BoolVec& mask) const override
+    {
+        cv::Point p;
+        cv::minMaxLoc(crop, nullptr, nullptr, nullptr, &p);
+        points = { cv::Point2f(p) };
+        mask = { true };
+        return 1;
+    }
+};
+
+TEST(ShapeEstimator, estimateBatch) // NOLINT (TODO)
+{
+    using BatchItem = drishti::ml::ShapeEstimator::BatchItem;
+
+    cv::Mat1b image(48, 64, uint8_t(0));
+    image(20, 30) = 255;
+    image(2, 3) = 128;
+
+    // Shapes are in roi coordinates, clipped rois are zero padded and empty rois use the image:
+    const std::vector<BatchItem> items = {
+        { image, cv::Rect(20, 10, 20, 20), {} },
+        { image, cv::Rect(-5, -5, 20, 20), {} },
+        { image, cv::Rect(), {} }
+    };
+    const std::vector<cv::Point2f> expected = { { 10.f, 10.f }, { 8.f, 7.f }, { 30.f, 20.f } };
+
+    BrightestPointEstimator estimator;
+    std::vector<std::vector<cv::Point2f>> serial, parallel;
+    ASSERT_EQ(estimator.estimateBatch(items, serial), 3);
+
+    int calls = 0;
+    const drishti::ml::ShapeEstimator::BatchExecutor executor = [&](int n, const std::function<void(int)>& job) {
+        calls++;
+        for (int i = n - 1; i >= 0; i--)
+        {
+            job(i);
+        }
+    };
+    ASSERT_EQ(estimator.estimateBatch(items, parallel, {}, executor), 3);
+    EXPECT_EQ(calls, 1);
+
+    for (std::size_t i = 0; i < items.size(); i++)
+    {
+        ASSERT_EQ(serial[i].size(), 1u);
+        EXPECT_EQ(serial[i].front(), expected[i]);
+        EXPECT_EQ(parallel[i], serial[i]);
+    }
+
+    // The default implementation doesn't support mirrored sampling:
+    drishti::ml::ShapeEstimator::Options options;
+    options.mirrored = true;
+    EXPECT_EQ(estimator.estimateBatch(items, serial, options), 0);
+}
@@ -42,6 +42,20 @@ CPR::CPR(const char* filename)
 
 CPR::~CPR() = default;
 
+std::unique_ptr<drishti::ml::ShapeEstimator> CPR::clone() const
+{
+    auto cpr = drishti::core::make_unique<CPR>();
+    cpr->cprPrm = cprPrm;
+    cpr->regModel = regModel; // shallow copy of pDstr and the regressors
+    cpr->m_isMat = m_isMat;
+    cpr->m_doPreview = m_doPreview;
+    cpr->stagesHint = stagesHint;
+    cpr->convergenceEpsilon = convergenceEpsilon;
+    cpr->convergenceStages = convergenceStages;
+    cpr->m_streamLogger = m_streamLogger;
+    return std::move(cpr);
+}
+
 bool CPR::usesMask() const
 {
     bool flag = false;
@@ -90,11 +104,23 @@ static cv::RotatedRect pointsToEllipse(const std::vector<cv::Point2f>& points)
     return { { points[0].x, points[1].x }, { points[2].x, points[3].x }, points[4].x };
 }
 
-static Vector1d pointsToPhi(const std::vector<cv::Point2f>& points)
+static Phi pointsToPhi(const std::vector<cv::Point2f>& points)
 {
     return ellipseToPhi(pointsToEllipse(points));
 }
 
+static void resultToPoints(const CPR::CPRResult& result, std::vector<cv::Point2f>& points)
+{
+    cv::RotatedRect ellipse = phiToEllipse(result.p);
+    points = {
+        { ellipse.center.x, 0.f }, // tranpose center
+        { ellipse.center.y, 0.f },
+        { ellipse.size.width, 0.f }, // flip width and height
+        { ellipse.size.height, 0.f },
+        { ellipse.angle, 0.f }
+    };
+}
+
 int CPR::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, BoolVec& mask) const
 {
     CPRResult result;
@@ -117,24 +143,61 @@ int CPR::operator()(const cv::Mat& I, const cv::Mat& M, Point2fVec& points, Bool
     else
     {
         ImageMaskPair Is{ I, M };
-        Vector1d pStar = (points.size() == 5) ? pointsToPhi(points) : (*regModel->pStar);
+        Phi pStar = (points.size() == 5) ? pointsToPhi(points) : toPhi(*regModel->pStar);
         cprApplyTree(Is, *regModel, pStar, result, m_doPreview);
     }
 
-    if (result.p.size() == 5)
+    resultToPoints(result, points);
+
+    return 0;
+}
+
+int CPR::operator()(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points) const
+{
+    if (m_isMat)
     {
-        points.resize(5);
-        cv::RotatedRect ellipse = phiToEllipse(result.p);
-        points = {
-            { ellipse.center.x, 0.f }, // tranpose center
-            { ellipse.center.y, 0.f },
-            { ellipse.size.width, 0.f }, // flip width and height
-            { ellipse.size.height, 0.f },
-            { ellipse.angle, 0.f }
-        };
+        return drishti::ml::ShapeEstimator::operator()(I, M, points);
     }
 
-    return 0;
+    return estimate({ I, M }, points);
+}
+
+int CPR::estimate(const cv::Mat& I, const cv::Mat& M, std::vector<Point2fVec>& points, const Options& options) const
+{
+    if (m_isMat)
+    {
+        return drishti::ml::ShapeEstimator::estimate(I, M, points, options);
+    }
+
+    if (!options.rois.empty())
+    {
+        return -1;
+    }
+
+    ImageMaskPair Is{ I, M };
+    Is.setMirrored(options.mirrored);
+    return estimate(Is, points, options);
+}
+
+int CPR::estimate(const ImageMaskPair& Is, std::vector<Point2fVec>& points, const Options& options) const
+{
+    // Evaluate all hypotheses together, one batch prediction per stage and output:
+    auto& workspace = getWorkspace();
+    auto& pStars = workspace.pStars;
+    pStars.resize(points.size());
+    for (int i = 0; i < points.size(); i++)
+    {
+        pStars[i] = (points[i].size() == 5) ? pointsToPhi(points[i]) : toPhi(*regModel->pStar);
+    }
+
+    auto& results = workspace.results;
+    cprApplyTree(Is, *regModel, pStars, results, workspace, options);
+    for (int i = 0; i < points.size(); i++)
+    {
+        resultToPoints(results[i], points[i]);
+    }
+
+    return int(points.size());
 }
 
 int CPR::operator()(const cv::Mat& I, std::vector<cv::Point2f>& points, std::vector<bool>& mask) const
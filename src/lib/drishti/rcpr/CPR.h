@@ -33,13 +33,18 @@
 
 #include "drishti/core/Logger.h"
 #include "drishti/core/Field.h"
+#include "drishti/core/LazyParallelResource.h"
+#include "drishti/core/make_unique.h"
 #include "drishti/rcpr/ImageMaskPair.h"
 #include "drishti/rcpr/Vector1d.h"
 #include "drishti/rcpr/Recipe.h"
 #include "drishti/ml/ShapeEstimator.h"
 #include "drishti/ml/XGBooster.h"
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <thread>
 
 DRISHTI_RCPR_NAMESPACE_BEGIN
 
@@ -53,6 +58,20 @@ inline int PointVecSize(const PointVec& v)
 
 using Matx33Real = cv::Matx<RealType, 3, 3>;
 using Vector1d = std::vector<RealType>;
+
+// Ellipse pose { cx, cy, angle, log2(width), log2(height/width) } for evaluation (no allocation),
+// Vector1d is used for training and serialization:
+using Phi = std::array<RealType, 5>;
+inline Phi toPhi(const Vector1d& phi)
+{
+    CV_Assert(phi.size() == 5);
+    return { { phi[0], phi[1], phi[2], phi[3], phi[4] } };
+}
+inline Vector1d toVector1d(const Phi& phi)
+{
+    return Vector1d(phi.begin(), phi.end());
+}
+
 using ImageVec = std::vector<cv::Mat>;
 using IntVec = std::vector<int>;
 using ImageMaskPairVec = std::vector<ImageMaskPair>;
@@ -78,6 +97,12 @@ public:
 
     ~CPR() override;
 
+    // Approximate cap on the XGBoost training matrices held concurrently by cprTrain() (0 == unlimited):
+    void setTrainingMemoryLimit(std::size_t bytes)
+    {
+        m_trainingMemoryLimit = bytes;
+    }
+
     void setViewer(ViewFunc& viewer)
     {
         m_viewer = viewer;
@@ -114,6 +139,18 @@ public:
         return stagesHint;
     };
 
+    // Early exit: stop once poseDistance() per stage is below epsilon for K stages (epsilon <= 0 disables):
+    void setConvergenceHint(float epsilon, int stages) override
+    {
+        convergenceEpsilon = epsilon;
+        convergenceStages = std::max(stages, 1);
+    }
+
+    float getConvergenceEpsilon() const override
+    {
+        return convergenceEpsilon;
+    }
+
     struct Model // Currently used in both CprPrm and RegModel ???
     {
         struct Parts
@@ -230,12 +267,19 @@ public:
 
     struct CPRResult
     {
-        Vector1d p;
-        std::vector<Vector1d> pAll;
+        Phi p{ {} };
+        std::vector<Phi> pAll; // result at end of each applied stage
+        int stages = 0;             // number of stages applied
     };
 
     int operator()(const cv::Mat& I, const cv::Mat& M, PointVec& points, std::vector<bool>& mask) const override;
     int operator()(const cv::Mat& I, PointVec& points, std::vector<bool>& mask) const override;
+    int operator()(const cv::Mat& I, const cv::Mat& M, std::vector<PointVec>& points) const override;
+    int estimate(const cv::Mat& I, const cv::Mat& M, std::vector<PointVec>& points, const Options& options) const override;
+    bool isMirrorable() const override
+    {
+        return !m_isMat;
+    }
 
     struct FeaturesResult
     {
@@ -250,11 +294,40 @@ public:
     };
 
     int cprTrain(const ImageMaskPairVec& images, const EllipseVec& ellipses, const HVec& H, const CprPrm& cprPrm, bool doJitter = false);
-    int cprApplyTree(const cv::Mat& Is, const RegModel& regModel, const Vector1d& p, CPRResult& result, bool preview = false) const;
-    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Vector1d& p, CPRResult& result, bool preview = false) const;
+    int cprApplyTree(const cv::Mat& Is, const RegModel& regModel, const Phi& p, CPRResult& result, bool preview = false) const;
+    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Phi& p, CPRResult& result, bool preview = false) const;
+    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Phi>& p, std::vector<CPRResult>& results, bool preview = false) const;
+
+    // Buffers reused across cprApplyTree calls, sized for the model's largest feature count:
+    struct Workspace
+    {
+        cv::Mat1f features; // one row of features per hypothesis
+        Vector1d predictions;
+        std::vector<Phi> pDel;
+        std::vector<Phi> pStars;
+        std::vector<CPRResult> results;
+        std::vector<float> pixels; // gathered feature pixels (image and mask)
+        std::vector<int> active; // unconverged hypotheses
+        std::vector<int> still;  // consecutive stages below the convergence threshold
+
+        const RegModel* model = nullptr; // buffers are sized for this model (see reserve())
+        int hypotheses = 0;              // ... and this many hypotheses
+
+        void reserve(const RegModel& regModel, int hypotheses);
+    };
+
+    // All per call settings (first stage, stage limit, convergence, preview) come from options:
+    int cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Phi>& p, std::vector<CPRResult>& results, Workspace& workspace, const Options& options) const;
+
+    // Per thread workspace for const (concurrent) estimation:
+    Workspace& getWorkspace() const;
+    int estimate(const ImageMaskPair& Is, std::vector<PointVec>& points, const Options& options = {}) const;
 
     void setDoPreview(bool flag) override;
 
+    // The boosted regressors (std::shared_ptr<ml::XGBooster>) are shared, workspaces are not:
+    std::unique_ptr<drishti::ml::ShapeEstimator> clone() const override;
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version);
 
@@ -282,8 +355,15 @@ protected:
 #endif
 
     int stagesHint = std::numeric_limits<int>::max();
+    float convergenceEpsilon = 0.f;
+    int convergenceStages = 2;
 
     ViewFunc m_viewer;
+    std::size_t m_trainingMemoryLimit = 0;
+
+    mutable core::LazyParallelResource<std::thread::id, std::unique_ptr<Workspace>> m_workspaces = []() {
+        return drishti::core::make_unique<Workspace>();
+    };
 };
 
 // Alias:
@@ -291,14 +371,25 @@ using FtrData = CPR::RegModel::Regs::FtrData;
 
 int createModel(int type, CPR::Model& model);
 int featuresComp(const CPR::Model& model, const Vector1d& p, const ImageMaskPair& I, const FtrData& ftrData, CPR::FeaturesResult& result, bool useNPD = false);
+int featuresComp(const CPR::Model& model, const Vector1d& p, const ImageMaskPair& I, const FtrData& ftrData, CPR::FeaturesResult& result, std::vector<float>& pixels, bool useNPD = false);
+
+// Features (and optional 0/1 mask entries) for ftrData.xs->size() / 2 point pairs, pixels is scratch:
+int featuresComp(const CPR::Model& model, const Vector1d& p, const ImageMaskPair& I, const FtrData& ftrData, float* ftrs, std::uint8_t* ftrMask, std::vector<float>& pixels, bool useNPD = false);
+int featuresComp(const CPR::Model& model, const Phi& p, const ImageMaskPair& I, const FtrData& ftrData, float* ftrs, std::uint8_t* ftrMask, std::vector<float>& pixels, bool useNPD = false);
 int ftrsGen(const CPR::Model& model, const CPR::CprPrm::FtrPrm& ftrPrmIn, FtrData& ftrData, float lambda = 0.1f);
-Vector1d identity(const CPR::Model& model);
+Phi identity(const CPR::Model& model);
+Phi compose(const CPR::Model& mnodel, const Phi& phis0, const Phi& phis1);
 Vector1d compose(const CPR::Model& mnodel, const Vector1d& phis0, const Vector1d& phis1);
 Vector1d inverse(const CPR::Model& model, const Vector1d& phis0);
 Vector1d phisFrHs(const Matx33Real& Hs);
 Vector1d compPhiStar(const CPR::Model& mnodel, const EllipseVec& phis);
-Vector1d ellipseToPhi(const cv::RotatedRect& e);
+Phi ellipseToPhi(const cv::RotatedRect& e);
+cv::RotatedRect phiToEllipse(const Phi& phi);
 cv::RotatedRect phiToEllipse(const Vector1d& phi);
+
+// Largest change in center and axes (relative to the ellipse width) and angle (radians) between two poses:
+RealType poseDistance(const Phi& phi0, const Phi& phi1);
+Matx33Real phisToHs(const Phi& phis);
 Matx33Real phisToHs(const Vector1d& phis);
 double normAng(double ang, double rng);
 double dist(const CPR::Model& model, const Vector1d& phis0, const Vector1d& phis1);
@@ -48,6 +48,17 @@ public:
         return mask;
     }
 
+    // The image is sampled as if it were flipped about the vertical axis, the mask is not (it is
+    // rendered from a model in the flipped coordinate system):
+    bool isMirrored() const
+    {
+        return mirrored;
+    }
+    void setMirrored(bool flag)
+    {
+        mirrored = flag;
+    }
+
     operator cv::Mat()
     {
         return image; // legacy ImageVec compatibility
@@ -56,6 +67,7 @@ public:
 protected:
     cv::Mat image;
     cv::Mat mask;
+    bool mirrored = false;
 };
 
 DRISHTI_RCPR_NAMESPACE_END
@@ -11,10 +11,13 @@
 #include "drishti/rcpr/drishti_rcpr.h"
 #include "drishti/rcpr/CPR.h"
 
+#include "drishti/core/Arena.h"
 #include "drishti/core/timing.h"
 
 #include "drishti/geometry/Ellipse.h"
 
+#include <algorithm>
+
 #define DRISHTI_CPR_DO_DEBUG 0
 
 // clang-format off
@@ -39,80 +42,188 @@ std::ostream& operator<<(std::ostream& os, const cv::RotatedRect& e)
     return os;
 }
 
-int CPR::cprApplyTree(const cv::Mat& I, const RegModel& regModel, const Vector1d& pIn, CPRResult& result, bool doPreview) const
+int CPR::cprApplyTree(const cv::Mat& I, const RegModel& regModel, const Phi& pIn, CPRResult& result, bool doPreview) const
+{
+    // An empty mask is equivalent to (and cheaper than) an all ones mask in featuresComp():
+    return cprApplyTree(ImageMaskPair(I), regModel, pIn, result, doPreview);
+}
+
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const Phi& pIn, CPRResult& result, bool doPreview) const
+{
+    auto& workspace = getWorkspace();
+    workspace.pStars.resize(1);
+    workspace.pStars.front() = pIn;
+    Options options;
+    options.preview = doPreview;
+    int status = cprApplyTree(Is, regModel, workspace.pStars, workspace.results, workspace, options);
+    result = workspace.results.front();
+    return status;
+}
+
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Phi>& pIn, std::vector<CPRResult>& results, bool doPreview) const
+{
+    Options options;
+    options.preview = doPreview;
+    return cprApplyTree(Is, regModel, pIn, results, getWorkspace(), options);
+}
+
+CPR::Workspace& CPR::getWorkspace() const
+{
+    return *m_workspaces[std::this_thread::get_id()];
+}
+
+void CPR::Workspace::reserve(const RegModel& regModel, int hypotheses)
 {
-    cv::Mat1b mask = cv::Mat1b::ones(I.size());
-    return cprApplyTree(ImageMaskPair(I, mask), regModel, pIn, result, doPreview);
+    std::size_t count = 0; // largest point count over all stages
+    for (const auto& reg : *(regModel.regs))
+    {
+        count = std::max(count, reg->ftrData->xs->size());
+    }
+
+    features.create(hypotheses, int(count / 2));
+    predictions.reserve(hypotheses);
+    pDel.reserve(hypotheses);
+    pStars.reserve(hypotheses);
+    results.reserve(hypotheses);
+    active.reserve(hypotheses);
+    still.reserve(hypotheses);
+    pixels.reserve(count * 2); // image and mask samples
+
+    model = &regModel;
+    this->hypotheses = hypotheses;
 }
 
-int CPR::cprApplyTree(const ImageMaskPair& IsIn, const RegModel& regModel, const Vector1d& pIn, CPRResult& result, bool doPreview) const
+int CPR::cprApplyTree(const ImageMaskPair& Is, const RegModel& regModel, const std::vector<Phi>& pIn, std::vector<CPRResult>& results, Workspace& workspace, const Options& options) const
 {
-    const ImageMaskPair& Is = IsIn;
-    auto& p = result.p;
-    p = pIn;
+    const int n = int(pIn.size());
+
+    // Size the buffers for the largest stage up front, rather than growing them over the first calls:
+    if ((workspace.model != &regModel) || (workspace.hypotheses < n))
+    {
+        workspace.reserve(regModel, n);
+    }
+
+    // Per call settings, falling back to the instance hints (nothing here writes to *this):
+    const int first = options.first;
+    const int stagesLimit = (options.stages >= 0) ? options.stages : stagesHint;
+    const float epsilon = (options.convergenceEpsilon >= 0.f) ? options.convergenceEpsilon : convergenceEpsilon;
+    const int stillStages = (options.convergenceStages >= 0) ? options.convergenceStages : convergenceStages;
 
     // Apply each single stage regressor, starting from pose p:
     auto& model = *(regModel.model);
     auto T = *(regModel.T);
-    result.pAll.resize(T); // store result at end of each stage
+
+    // Hypotheses that have converged (see setConvergenceHint()) are dropped from the active set:
+    auto& active = workspace.active;
+    auto& still = workspace.still;
+    active.resize(n);
+    still.assign(n, 0);
+
+    results.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        active[i] = i;
+        results[i].p = pIn[i];
+        results[i].pAll.resize(T); // store result at end of each stage
+        results[i].stages = 0;
+    }
 
     // repeat the whole thing 2x
-    std::vector<int> stage;
+    core::ArenaVector<int> stage;
 
-    // Create a recipe for executing the stages:
-    for (int i = 0; i < std::min(stagesHint, int(T)); i++)
+    // Create a recipe for executing the stages (warm starts may skip the coarse stages):
+    const int last = std::min(stagesLimit, int(T));
+    for (int i = std::max(std::min(first, last - 1), 0); i < last; i++)
     {
         stage.push_back(i);
     }
 
+    // Buffers are reused across stages and calls, so steady state evaluation doesn't reallocate:
+    auto& features = workspace.features; // one row of features per hypothesis
+    auto& predictions = workspace.predictions; // one output dimension for all hypotheses
+    auto& pDel = workspace.pDel;
+    predictions.resize(n);
+    pDel.resize(n);
+
     for (const auto& t : stage)
     {
-        auto& reg = *(*(regModel.regs))[t];
-
-        FeaturesResult ftrResult;
-        featuresComp(model, p, Is, *(reg.ftrData), ftrResult);
+        if (active.empty())
+        {
+            break;
+        }
 
-        auto pDel = identity(model);
+        auto& reg = *(*(regModel.regs))[t];
+        const int m = int(active.size());
 
-        cv::Mat features;
-        cv::Mat(ftrResult.ftrs).reshape(1, 1).copyTo(features);
-        features.convertTo(features, CV_32F);
+        // Rows [0,m) hold the active hypotheses (full size allocation is retained):
+        features.create(n, int(reg.ftrData->xs->size() / 2)); // no-op for a matching size
+        for (int j = 0; j < m; j++)
+        {
+            featuresComp(model, results[active[j]].p, Is, *(reg.ftrData), features.ptr<float>(j), nullptr, workspace.pixels);
+            pDel[j] = identity(model);
+        }
 
+        // XGBOOST
+        const cv::Mat1f rows = features.rowRange(0, m);
+        for (auto& t : reg.xgbdt)
         {
-            // XGBOOST
-            std::vector<std::vector<float>> data(features.rows);
-            for (int i = 0; i < features.rows; i++)
+            (*t.second)(rows, predictions.data());
+            for (int j = 0; j < m; j++)
             {
-                data[i] = features.row(i);
+                pDel[j][t.first] = predictions[j];
             }
+        }
 
-            for (auto& t : reg.xgbdt)
+        int k = 0;
+        for (int j = 0; j < m; j++)
+        {
+            const int i = active[j];
+            auto& p = results[i].p;
+            auto q = compose(model, p, pDel[j]);
+
+            // Stop updating a hypothesis once it has moved less than epsilon for K consecutive stages:
+            const bool isStill = (epsilon > 0.f) && (poseDistance(p, q) < epsilon);
+            still[i] = isStill ? (still[i] + 1) : 0;
+
+            p = q;
+            results[i].pAll[t] = p; // store result for this stage
+            results[i].stages = t + 1;
+
+            if (still[i] < stillStages)
             {
-                pDel[t.first] = (*t.second)(data[0]);
+                active[k++] = i;
             }
         }
-
-        p = compose(model, p, pDel);
-        result.pAll[t] = p; // store result for this stage
+        active.resize(k);
 
 #if DRISHTI_CPR_DO_DEBUG && !HAS_XGBOOST
         // TODO: Legacy non xgboost
-        if (doPreview)
+        if (options.preview || m_doPreview)
         {
-            cv::Mat canvas;
-            cv::cvtColor(I, canvas, cv::COLOR_GRAY2BGR);
+            const auto& I = Is.getImage();
+            for (int i = 0; i < n; i++)
+            {
+                cv::Mat canvas;
+                cv::cvtColor(I, canvas, cv::COLOR_GRAY2BGR);
 
-            const auto e = phiToEllipse(p), eIn = phiToEllipse(pIn);
-            cv::ellipse(canvas, eIn, { 255, 0, 0 }, 1, 8);
-            cv::ellipse(canvas, e, { 0, 255, 0 }, 1, 8);
+                const auto e = phiToEllipse(results[i].p), eIn = phiToEllipse(pIn[i]);
+                cv::ellipse(canvas, eIn, { 255, 0, 0 }, 1, 8);
+                cv::ellipse(canvas, e, { 0, 255, 0 }, 1, 8);
 
-            drishti::geometry::Ellipse e2(e);
-            cv::line(canvas, e.center, e2.getMajorAxisPos(), { 0, 255, 0 }, 1, 8);
-            cv::imshow("I", canvas); // opt
-            cv::waitKey(0);
+                drishti::geometry::Ellipse e2(e);
+                cv::line(canvas, e.center, e2.getMajorAxisPos(), { 0, 255, 0 }, 1, 8);
+                cv::imshow("I", canvas); // opt
+                cv::waitKey(0);
+            }
         }
 #endif
     }
+
+    for (auto& result : results)
+    {
+        result.pAll.resize(result.stages);
+    }
+
     return 0;
 }
 
@@ -20,9 +20,6 @@
 #include "drishti/core/Parallel.h"
 #include "drishti/core/timing.h"
 
-typedef std::vector<float> T_VECTOR;
-typedef std::vector<T_VECTOR> T_MATRIX;
-
 // clang-format off
 #if DRISHTI_CPR_DO_FEATURE_DEBUG || DRISHTI_CPR_DO_PREVIEW_GT || DRISHTI_CPR_DO_PREVIEW_JITTER
 #  include <opencv2/highgui.hpp>
@@ -188,6 +185,17 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
 
     CV_Assert(T == cprPrm.cascadeRecipes.size());
 
+    // Contiguous feature, mask and target matrices are allocated once (for the largest
+    // feature pool) and reused as strided views for each stage:
+    int maxF = 0;
+    for (const auto& recipe : cprPrm.cascadeRecipes)
+    {
+        maxF = std::max(maxF, recipe.featurePoolSize);
+    }
+    cv::Mat1f featureBuffer(int(pCur.size()), maxF);
+    cv::Mat1b maskBuffer(int(pCur.size()), maxF);
+    cv::Mat1f values(int(pCur.size()), R);
+
     // Loop and gradually improve pCur
     for (int t = 0; t < T; t++)
     {
@@ -196,40 +204,41 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
         ftrPrm.radius = double(recipe.featureRadius);
         ftrPrm.F = double(recipe.featurePoolSize); // TODO revisit
 
-        MatrixType<uint8_t> mask(pCur.size());
-        cv::Mat features(int(pCur.size()), ftrPrm.F, CV_64F);
-        cv::Mat values(int(pCur.size()), R, CV_64F);
+        const int F = recipe.featurePoolSize;
+        cv::Mat1f features = featureBuffer.colRange(0, F);
+        cv::Mat1b mask = maskBuffer.colRange(0, F); // 1 == valid
 
         // Generate shared features 1x per stage
         CPR::RegModel::Regs::FtrData ftrData;
         ftrsGen({}, ftrPrm, ftrData, cprPrm.cascadeRecipes[t].lambda);
 
-        // For each model:
-        for (int i = 0; i < pCur.size(); i++)
         {
-            //% get target value for pose
-            Vector1d tar;
-            tar = inverse({}, pCur[i]); // pCur starts as pStar (mean model)
-            tar = compose({}, tar, pGt[i]);
-
-            //% generate and compute pose indexed features
-            CPR::FeaturesResult ftrResult;
-            featuresComp({}, pCur[i], Is[imgIds[i]], ftrData, ftrResult, recipe.useNPD);
-
-            // TODO: make decision about format, might be better to stick w/ std::vector<std::vector<T>>
-            mask[i] = ftrResult.ftrMask;
-            cv::Mat(ftrResult.ftrs).reshape(1, 1).copyTo(features.row(i));
-            cv::Mat(tar).reshape(1, 1).copyTo(values.row(i));
-        }
+            // Compute pose indexed features and targets in parallel batches, written in place:
+            const int batchSize = 256;
+            const int batches = (int(pCur.size()) + batchSize - 1) / batchSize;
+            std::function<void(int)> computeFeatures = [&](int b) {
+                std::vector<float> pixels; // reused for the batch
+
+                const int end = std::min(int(pCur.size()), (b + 1) * batchSize);
+                for (int i = b * batchSize; i < end; i++)
+                {
+                    //% get target value for pose
+                    Vector1d tar;
+                    tar = inverse({}, pCur[i]); // pCur starts as pStar (mean model)
+                    tar = compose({}, tar, pGt[i]);
+
+                    //% generate and compute pose indexed features (straight into the training rows)
+                    CV_Assert(int(ftrData.xs->size()) == (F * 2));
+                    featuresComp({}, pCur[i], Is[imgIds[i]], ftrData, features[i], mask[i], pixels, recipe.useNPD);
+                    for (int j = 0; j < R; j++)
+                    {
+                        values(i, j) = static_cast<float>(tar[j]);
+                    }
+                }
+            };
 
-        features.convertTo(features, CV_32F);
-        values.convertTo(values, CV_32F);
-        T_MATRIX features_(features.rows);
-        for (int i = 0; i < features.rows; i++)
-        {
-            // Fill in the feature matrix
-            T_VECTOR row = features.row(i);
-            features_[i] = row;
+            core::ParallelHomogeneousLambda harness(computeFeatures);
+            cv::parallel_for_({ 0, batches }, harness);
         }
 
         const size_t N = pCur.size();
@@ -260,11 +269,11 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
             // Estimate regressors
             std::mutex mutex;
             std::function<void(int)> trainRegressor = [&](int i) {
-                cv::Mat tmp = values.col(regressorToPhiIndex[i]);
-                tmp = tmp.t();
-
-                std::vector<std::vector<float>> data = features_;
-                std::vector<float> target = tmp;
+                std::vector<float> target(values.rows);
+                for (int j = 0; j < values.rows; j++)
+                {
+                    target[j] = values(j, regressorToPhiIndex[i]);
+                }
 
                 ml::XGBooster::Recipe params;
                 params.learningRate = recipe.learningRate;
@@ -272,21 +281,32 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
                 params.maxDepth = recipe.maxDepth;
                 params.featureSubsample = float(recipe.featureSampleSize) / recipe.featurePoolSize;
 
+                // All regressors share the (read only) stage features:
                 xgbdt[i] = std::make_shared<ml::XGBooster>(params);
-                xgbdt[i]->train(data, target, recipe.doMask ? mask : MatrixType<uint8_t>());
+                xgbdt[i]->train(features, target, recipe.doMask ? mask : cv::Mat1b());
 
-                predictions[i].resize(data.size());
-                for (int j = 0; j < data.size(); j++)
-                {
-                    predictions[i][j] = (*xgbdt[i])(data[j]);
-                }
+                predictions[i].resize(features.rows);
+                (*xgbdt[i])(features, predictions[i].data());
 
                 // Now we compose the models, and find parameter producing lowest error
                 m_streamLogger->info("done training stage {} param {}", t, i);
             };
 
+            // Each regressor builds its own XGBoost training matrix (index + value per feature),
+            // so limit the number trained concurrently to the memory budget:
+            const int regressors = int(regressorToPhiIndex.size());
+            const std::size_t regressorBytes = N * std::size_t(F) * 2 * sizeof(float);
+            int concurrency = regressors;
+            if (m_trainingMemoryLimit)
+            {
+                concurrency = std::max(1, std::min(regressors, int(m_trainingMemoryLimit / regressorBytes)));
+            }
+
             core::ParallelHomogeneousLambda harness(trainRegressor);
-            cv::parallel_for_({ 0, int(regressorToPhiIndex.size()) }, harness);
+            for (int begin = 0; begin < regressors; begin += concurrency)
+            {
+                cv::parallel_for_({ begin, std::min(begin + concurrency, regressors) }, harness);
+            }
         }
 
 #if DRISHTI_CPR_DO_FEATURE_DEBUG
@@ -308,7 +328,7 @@ int CPR::cprTrain(const ImageMaskPairVec& Is, const EllipseVec& pGtIn, const HVe
             std::function<void(int)> computeLoss = [&](int i) {
                 const auto& dims = phiSets[i];
                 double loss = 0.0;
-                Vector1d del = identity(model);
+                Vector1d del = toVector1d(identity(model));
                 for (int j = 0; j < N; j++)
                 {
                     for (int k = 0; k < dims.size(); k++)
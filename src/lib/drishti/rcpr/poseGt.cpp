@@ -11,18 +11,21 @@
 
 #include "drishti/core/drishti_core.h"
 #include "drishti/core/drishti_math.h"
+#include "drishti/core/arithmetic.h" // transformAndGather8u()
 #include "drishti/rcpr/CPR.h"
 
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #define DRISHTI_CPR_DO_FTR_DEBUG 0
 #define DRISHTI_CPR_DO_FEATURE_MASK 1
 #define DRISHTI_CPR_USE_FEATURE_SEPARATION_PRIOR 1
 
 DRISHTI_RCPR_NAMESPACE_BEGIN
 
-static Matx33Real getPose(const Vector1d& phi);
-static std::vector<cv::Point2f> xsToPoints(const Matx33Real& HS, const PointVec& xs);
+static Matx33Real getPose(const Phi& phi);
 
 // function part = createPart( parent, wts )
 // % Create single part for model (parent==0 implies root).
@@ -109,34 +112,74 @@ int createModel(int type, CPR::Model& model)
 using FtrData = CPR::RegModel::Regs::FtrData;
 using FtrResult = CPR::FeaturesResult;
 int featuresComp(const CPR::Model& model, const Vector1d& phi, const ImageMaskPair& Im, const FtrData& ftrData, FtrResult& result, bool useNPD)
+{
+    std::vector<float> pixels;
+    return featuresComp(model, phi, Im, ftrData, result, pixels, useNPD);
+}
+
+int featuresComp(const CPR::Model& model, const Vector1d& phi, const ImageMaskPair& Im, const FtrData& ftrData, FtrResult& result, std::vector<float>& pixels, bool useNPD)
+{
+    const int F = int(ftrData.xs->size() / 2);
+    result.ftrs.resize(F);
+    result.ftrMask.resize((DRISHTI_CPR_DO_FEATURE_MASK && !Im.getMask().empty()) ? F : 0);
+    return featuresComp(model, phi, Im, ftrData, result.ftrs.data(), result.ftrMask.empty() ? nullptr : result.ftrMask.data(), pixels, useNPD);
+}
+
+/*
+ * All feature points of a stage are mapped through the pose and sampled in one pass with
+ * the SIMD transform + gather kernel (see core::transformAndGather8u()): the unit circle
+ * offsets in ftrData.xs are already packed {x,y} floats, the pose is a 2x3 affine matrix
+ * (mirroring is folded into it), and points outside the image read the top left pixel as
+ * before.  The mask (if any) is gathered the same way, and the features are written to a
+ * row of the batched regressor input.
+ */
+int featuresComp(const CPR::Model& model, const Vector1d& phi, const ImageMaskPair& Im, const FtrData& ftrData, float* ftrs, std::uint8_t* ftrMask, std::vector<float>& pixels, bool useNPD)
+{
+    return featuresComp(model, toPhi(phi), Im, ftrData, ftrs, ftrMask, pixels, useNPD);
+}
+
+int featuresComp(const CPR::Model& model, const Phi& phi, const ImageMaskPair& Im, const FtrData& ftrData, float* ftrs, std::uint8_t* ftrMask, std::vector<float>& pixels, bool useNPD)
 {
     const auto& I = Im.getImage();
-    CV_Assert(I.channels() == 1);
+    CV_Assert(I.type() == CV_8UC1);
 
-    // compute image coordinates from xs adjusted for pose
-    Matx33Real HS = getPose(phi); // just single component model for now (don't need multiple parts)
     const auto& xs = *(ftrData.xs);
-    auto points = xsToPoints(HS, xs);
+    CV_Assert(!(xs.size() % 2));
+    const int n = int(xs.size()), F = n / 2;
+    if (!n)
+    {
+        return 0;
+    }
 
-    // Make sure we avoid out of bounds pixels, somewhat arbitrarily
-    // we can just set these to the top left corner.
-    for (auto& p : points)
+    // compute image coordinates from xs adjusted for pose
+    const Matx33Real HS = getPose(phi); // just single component model for now (don't need multiple parts)
+    const float H[6] = { float(HS(0, 0)), float(HS(0, 1)), float(HS(0, 2)), float(HS(1, 0)), float(HS(1, 1)), float(HS(1, 2)) };
+    const float* anchors = &xs.front().x;
+
+    // Mirrored images are read as if they were flipped about the vertical axis (no flipped copy):
+    const bool mirrored = Im.isMirrored();
+    const float Hm[6] = { -H[0], -H[1], float(I.cols - 1) - H[2], H[3], H[4], H[5] };
+
+    const auto& M = Im.getMask();
+    const bool hasMask = DRISHTI_CPR_DO_FEATURE_MASK && !M.empty();
+    pixels.resize(hasMask ? (n * 2) : n);
+    float* values = pixels.data();
+    float* masks = pixels.data() + n;
+
+    const float outside = float(I.at<std::uint8_t>(0, mirrored ? (I.cols - 1) : 0));
+    core::transformAndGather8u(I.ptr<std::uint8_t>(), int(I.step1()), I.cols, I.rows, anchors, nullptr, nullptr, mirrored ? Hm : H, values, n, outside);
+    if (hasMask)
     {
-        if (!cv::Rect({ 0, 0 }, I.size()).contains(p))
-        {
-            p = { 0.f, 0.f };
-        }
+        // The mask is rendered in the (flipped) model coordinate system, so it is never mirrored:
+        CV_Assert((M.type() == CV_8UC1) && (M.size() == I.size()));
+        core::transformAndGather8u(M.ptr<std::uint8_t>(), int(M.step1()), M.cols, M.rows, anchors, nullptr, nullptr, H, masks, n, float(M.at<std::uint8_t>(0, 0)));
     }
 
     // Compute features:
-    CV_Assert(!(points.size() % 2));
-    auto& ftrs = result.ftrs;
-
-    ftrs.resize(points.size() / 2);
-    for (int j = 0, i = 0; i < points.size(); j++, i += 2)
+    for (int j = 0, i = 0; j < F; j++, i += 2)
     {
-        double f1 = static_cast<double>(I.at<std::uint8_t>(points[i + 0])) / 255.0;
-        double f2 = static_cast<double>(I.at<std::uint8_t>(points[i + 1])) / 255.0;
+        double f1 = static_cast<double>(values[i + 0]) / 255.0;
+        double f2 = static_cast<double>(values[i + 1]) / 255.0;
 
         double d;
         if (useNPD) // possibly use functor (opt)
@@ -150,25 +193,22 @@ int featuresComp(const CPR::Model& model, const Vector1d& phi, const ImageMaskPa
             d = (f1 - f2);
         }
 
-        ftrs[j] = d;
+        ftrs[j] = static_cast<float>(d);
 
-#if DRISHTI_CPR_DO_FEATURE_MASK
         // Store occlusion estimate
-        auto& M = Im.getMask();
-        auto& mask = result.ftrMask;
-        if (!M.empty())
+        std::uint8_t valid = 1;
+        if (hasMask)
         {
-            uint8_t m1 = M.at<std::uint8_t>(points[i + 0]);
-            uint8_t m2 = M.at<std::uint8_t>(points[i + 1]);
-            uint8_t valid = m1 & m2;
-            mask.push_back(valid);
-
+            valid = static_cast<std::uint8_t>(masks[i + 0]) & static_cast<std::uint8_t>(masks[i + 1]);
             if (!valid)
             {
                 ftrs[j] = NAN; // xgboost special value
             }
         }
-#endif
+        if (ftrMask)
+        {
+            ftrMask[j] = valid;
+        }
     }
 
     return 0;
@@ -315,7 +355,7 @@ int ftrsGen(const CPR::Model& model, const CPR::CprPrm::FtrPrm& ftrPrmIn, FtrDat
     return 0;
 }
 
-static Matx33Real getPose(const Vector1d& phi)
+static Matx33Real getPose(const Phi& phi)
 {
     // Currently only 1 part is supported in parametric mode:
     double x, y, ang, scl, asp, c, s, t;
@@ -334,27 +374,40 @@ static Matx33Real getPose(const Vector1d& phi)
     return HS;
 }
 
-static std::vector<cv::Point2f> xsToPoints(const Matx33Real& HS, const PointVec& xs)
+// Fill the first 4 pose parameters {x, y, angle, scale} from a similarity transform:
+static void phisFrHs(const Matx33Real& Hs, RealType* phis)
 {
-    std::vector<cv::Point2f> points(xs.size());
-    for (int i = 0; i < points.size(); i++)
-    {
-        const auto q = HS * cv::Point3f(xs[i].x, xs[i].y, 1.f);
-        points[i] = { q.x, q.y }; // pure affine (i.e., no /z)
-    }
-    return points;
+    double a, ss, sc, s;
+    a = std::atan2(Hs(1, 0), Hs(0, 0));
+    ss = Hs(0, 0);
+    sc = Hs(0, 1);
+    s = core::logN(std::sqrt(sc * sc + ss * ss), 2.0);
+    phis[0] = static_cast<RealType>(Hs(0, 2));
+    phis[1] = static_cast<RealType>(Hs(1, 2));
+    phis[2] = static_cast<RealType>(a);
+    phis[3] = static_cast<RealType>(s);
+}
+
+static Matx33Real phisToHs(const RealType* phis)
+{
+    double sc = std::pow(2.0, phis[3]);
+    double c = std::cos(phis[2]) * sc;
+    double s = std::sin(phis[2]) * sc;
+    double x = phis[0];
+    double y = phis[1];
+    return Matx33Real(c, -s, x, s, c, y, 0, 0, 1);
 }
 
-Vector1d identity(const CPR::Model& model)
+Phi identity(const CPR::Model& model)
 {
-    return Vector1d(5, 0.0);
+    return Phi{ {} };
 }
 
-Vector1d compose(const CPR::Model& mnodel, const Vector1d& phis0, const Vector1d& phis1)
+Phi compose(const CPR::Model& mnodel, const Phi& phis0, const Phi& phis1)
 {
     bool isNew = true;
-    Vector1d phis(phis0.size(), 0);
-    for (int i = 0; i < phis0.size(); i++)
+    Phi phis;
+    for (int i = 0; i < int(phis.size()); i++)
     {
         phis[i] = phis0[i] + phis1[i];
         if (phis0[i] != RealType(0.0))
@@ -365,18 +418,19 @@ Vector1d compose(const CPR::Model& mnodel, const Vector1d& phis0, const Vector1d
 
     if (!isNew)
     {
-        Matx33Real H0 = phisToHs(phis0);
-        Matx33Real H1 = phisToHs(phis1);
-        Matx33Real H = H0 * H1;
-        Vector1d phis4 = phisFrHs(H);
-        phis4.push_back(phis.back());
-        std::swap(phis4, phis);
+        // Similarity for the first 4 parameters, the aspect ratio is additive:
+        phisFrHs(phisToHs(phis0) * phisToHs(phis1), phis.data());
     }
     phis[2] = normAng(phis[2], DRISHTI_CPR_ANGLE_RANGE);
 
     return phis;
 }
 
+Vector1d compose(const CPR::Model& mnodel, const Vector1d& phis0, const Vector1d& phis1)
+{
+    return toVector1d(compose(mnodel, toPhi(phis0), toPhi(phis1)));
+}
+
 // function phis = inverse( model, phis0 ) %#ok<INUSL>
 // % Compute inverse of phis0 so that phis0+phis1=phis1+phis0=identity.
 // [N,R]=size(phis0);
@@ -424,33 +478,20 @@ Vector1d inverse(const CPR::Model& mnodel, const Vector1d& phis0)
 
 Vector1d phisFrHs(const Matx33Real& Hs)
 {
-    double a, ss, sc, s, x, y;
-    a = std::atan2(Hs(1, 0), Hs(0, 0));
-    ss = Hs(0, 0);
-    sc = Hs(0, 1);
-    s = core::logN(std::sqrt(sc * sc + ss * ss), 2.0);
-    x = Hs(0, 2);
-    y = Hs(1, 2);
-    Vector1d phis{
-        static_cast<RealType>(x),
-        static_cast<RealType>(y),
-        static_cast<RealType>(a),
-        static_cast<RealType>(s),
-    };
+    Vector1d phis(4);
+    phisFrHs(Hs, phis.data());
     return phis;
 }
 
-Matx33Real phisToHs(const Vector1d& phis)
+Matx33Real phisToHs(const Phi& phis)
 {
-    double sc = std::pow(2.0, phis[3]);
-    double c = std::cos(phis[2]) * sc;
-    double s = std::sin(phis[2]) * sc;
-    double x = phis[0];
-    double y = phis[1];
-    Matx33Real Hs(c, -s, x, s, c, y, 0, 0, 1);
-    auto phis_ = phisFrHs(Hs);
+    return phisToHs(phis.data());
+}
 
-    return Hs;
+Matx33Real phisToHs(const Vector1d& phis)
+{
+    CV_Assert(phis.size() >= 4);
+    return phisToHs(phis.data());
 }
 
 //function phi = compPhiStar( model, phis ) %#ok<INUSL>
@@ -559,18 +600,23 @@ double dist(const CPR::Model& model, const Vector1d& phis0, const Vector1d& phis
     return ds / double(del.size());
 }
 
-Vector1d ellipseToPhi(const cv::RotatedRect& e)
+Phi ellipseToPhi(const cv::RotatedRect& e)
 {
     float cx = e.center.x;
     float cy = e.center.y;
     float angle = (e.angle) * M_PI / 180.0; // NOTE: -e.angle
     float scale = core::logN(e.size.width, 2.0f);
     float aspectRatio = core::logN(e.size.height / e.size.width, 2.0f);
-    return Vector1d{ cx, cy, angle, scale, aspectRatio };
+    return Phi{ { cx, cy, angle, scale, aspectRatio } };
 }
 
-// Note: This is for ellipse drawn in transposed image
 cv::RotatedRect phiToEllipse(const Vector1d& phi)
+{
+    return phiToEllipse(toPhi(phi));
+}
+
+// Note: This is for ellipse drawn in transposed image
+cv::RotatedRect phiToEllipse(const Phi& phi)
 {
     double width = std::pow(2.0, phi[3]);
     cv::Size2f size(width, std::pow(2.0, phi[4]) * width);
@@ -578,6 +624,23 @@ cv::RotatedRect phiToEllipse(const Vector1d& phi)
     return ellipse;
 }
 
+RealType poseDistance(const Phi& phi0, const Phi& phi1)
+{
+    // Sizes directly from phi (see phiToEllipse()), this runs per hypothesis and stage:
+    const double w0 = std::exp2(double(phi0[3])), w1 = std::exp2(double(phi1[3]));
+    const double h0 = std::exp2(double(phi0[4])) * w0, h1 = std::exp2(double(phi1[4])) * w1;
+    const double scale = std::max(w0, 1e-6);
+
+    double angle = std::abs(double(phi1[2]) - double(phi0[2]));
+    angle = std::fmod(angle, DRISHTI_CPR_ANGLE_RANGE);
+    angle = std::min(angle, DRISHTI_CPR_ANGLE_RANGE - angle);
+
+    const double center = std::hypot(double(phi1[0]) - double(phi0[0]), double(phi1[1]) - double(phi0[1])) / scale;
+    const double width = std::abs(w1 - w0) / scale;
+    const double height = std::abs(h1 - h0) / scale;
+    return RealType(std::max(std::max(center, angle), std::max(width, height)));
+}
+
 #if !DRISHTI_BUILD_MIN_SIZE
 void drawFeatures(cv::Mat& canvas, const PointVec& xs, const Vector1d& phi, const std::vector<int>& features, float scale)
 {
@@ -587,7 +650,7 @@ void drawFeatures(cv::Mat& canvas, const PointVec& xs, const Vector1d& phi, cons
         cv::resize(canvas, canvas, {}, scale, scale, cv::INTER_CUBIC);
     }
 
-    Matx33Real Hs = getPose(phi);
+    Matx33Real Hs = getPose(toPhi(phi));
 
     cv::RNG rng;
     rng.state = 100;
@@ -36,4 +36,14 @@ cv::Point3f SensorModel::Intrinsic::getDepth(const std::array<cv::Point2f, 2>& p
     return cv::Point3f(-(p.x - m_c->x) * Z / *m_fx, -(p.y - m_c->y) * Z / *m_fx, Z);
 }
 
+cv::Point2f SensorModel::Intrinsic::project(const cv::Point3f& point) const
+{
+    return { m_c->x - (*m_fx * point.x / point.z), m_c->y - (*m_fx * point.y / point.z) };
+}
+
+cv::Point3f SensorModel::Intrinsic::unproject(const cv::Point2f& pixel, float zMeters) const
+{
+    return { -(pixel.x - m_c->x) * zMeters / *m_fx, -(pixel.y - m_c->y) * zMeters / *m_fx, zMeters };
+}
+
 DRISHTI_SENSOR_NAMESPACE_END
@@ -37,12 +37,19 @@ public:
         Intrinsic(const cv::Point2f& c, float fx, const cv::Size& size);
         float getFocalLength() const { return m_fx; }
 
+        // Width in pixels of an object with known physical width at depth z (pinhole):
+        float getObjectWidth(float widthMeters, float zMeters) const { return (getFocalLength() * widthMeters) / zMeters; }
+
         const cv::Size& getSize() const { return *m_size; }
         void setSize(const cv::Size& size) { m_size = size; }
 
         cv::Matx33f getK() const;
         cv::Point3f getDepth(const std::array<cv::Point2f, 2>& pixels, float widthMeters) const;
 
+        // Pinhole projection with the getDepth() camera coordinates (x left, y up, z forward):
+        cv::Point2f project(const cv::Point3f& point) const;
+        cv::Point3f unproject(const cv::Point2f& pixel, float zMeters) const;
+
         // Sample parameters for iPhone 5s front facing "Photo" mode shown below:
         core::Field<cv::Size> m_size;   // = {640, 852};
         core::Field<cv::Point2f> m_c;   // = {320.f, 426.f};
@@ -50,7 +57,7 @@ public:
         core::Field<float> m_pixelSize; // = 0.0;
     };
 
-    // ### Extrinsic camera parameters:
+    // ### Extrinsic camera parameters, camera = R * rig + t (meters), e.g., for a multi-camera rig:
     struct Extrinsic
     {
         Extrinsic() = default;
@@ -58,7 +65,13 @@ public:
             : R(R)
         {
         }
-        cv::Matx33f R;
+        Extrinsic(const cv::Matx33f& R, const cv::Vec3f& t)
+            : R(R)
+            , t(t)
+        {
+        }
+        cv::Matx33f R = cv::Matx33f::eye();
+        cv::Vec3f t = { 0.f, 0.f, 0.f };
     };
 
     SensorModel() = default; // init with defaults
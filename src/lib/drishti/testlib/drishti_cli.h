@@ -25,7 +25,12 @@
 // clang-format on
 #endif
 
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
 #include <vector>
 #include <string>
 
@@ -76,6 +81,93 @@ expand(const std::string& filename, const std::string& ext = ".txt")
     return list;
 }
 
+// drishti::cli::shard::
+//
+// Deterministic partition of a manifest (e.g., the output of expand()) across processes: an
+// item belongs to shard (hash(item) % count), so every node selects its share from the same
+// manifest without coordination and the assignment doesn't depend on the manifest order.
+DRISHTI_BEGIN_NAMESPACE(shard) // namespace shard {
+
+struct Spec
+{
+    int index = 0;
+    int count = 1;
+
+    // File name tag for per shard outputs (empty for a single shard):
+    std::string suffix() const
+    {
+        return (count > 1) ? ("." + std::to_string(index) + "-of-" + std::to_string(count)) : std::string();
+    }
+};
+
+// "index/count", e.g., "3/16":
+inline bool parse(const std::string& text, Spec& spec)
+{
+    char slash = 0;
+    std::stringstream ss(text);
+    Spec result;
+    if ((ss >> result.index >> slash >> result.count) && (slash == '/') && (result.count > 0) && (0 <= result.index) && (result.index < result.count))
+    {
+        spec = result;
+        return true;
+    }
+    return false;
+}
+
+// 64 bit FNV-1a (stable across platforms and runs, unlike std::hash), the low bits of which
+// only depend on the low bits of the characters, so they are mixed before the modulus:
+inline std::uint64_t hash(const std::string& item)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    for (const auto& c : item)
+    {
+        h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdull;
+    h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+
+inline bool contains(const Spec& spec, const std::string& item)
+{
+    return (spec.count <= 1) || ((hash(item) % static_cast<std::uint64_t>(spec.count)) == static_cast<std::uint64_t>(spec.index));
+}
+
+// Items of the shard (in manifest order) that aren't done:
+inline std::vector<std::string> select(const std::vector<std::string>& items, const Spec& spec, const std::set<std::string>& done = {})
+{
+    std::vector<std::string> selected;
+    std::copy_if(items.begin(), items.end(), std::back_inserter(selected), [&](const std::string& item) {
+        return contains(spec, item) && !done.count(item);
+    });
+    return selected;
+}
+
+// Items listed (one per line) in all of the checkpoint files, a torn last line is ignored
+// and a missing file marks nothing as done:
+inline std::set<std::string> completed(const std::vector<std::string>& checkpoints)
+{
+    std::set<std::string> done;
+    for (std::size_t i = 0; i < checkpoints.size(); i++)
+    {
+        std::ifstream ifs(checkpoints[i], std::ios::binary);
+        const std::string text((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        std::set<std::string> items;
+        for (std::size_t begin = 0, end; (end = text.find('\n', begin)) != std::string::npos; begin = end + 1)
+        {
+            if (i == 0 || done.count(text.substr(begin, end - begin)))
+            {
+                items.insert(text.substr(begin, end - begin));
+            }
+        }
+        done.swap(items);
+    }
+    return done;
+}
+
+DRISHTI_END_NAMESPACE(shard) // }
+
 // drishti::cli::file::
 DRISHTI_BEGIN_NAMESPACE(file) // namespace file {
 inline bool exists(const std::string& filename)
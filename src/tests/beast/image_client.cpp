@@ -12,11 +12,60 @@
 
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "telemetry_sender.hpp"
 
 #include "cxxopts.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <thread>
+
+// Emulate the tracker output for one frame: a face in the image center with two eyes.
+static telemetry::Frame makeFrame(const cv::Mat& image, std::uint32_t index, double time, int quality)
+{
+    const cv::Rect face(image.cols / 4, image.rows / 4, image.cols / 2, image.rows / 2);
+    const cv::Rect eyes[2] = {
+        { face.x + face.width / 8, face.y + face.height / 4, face.width / 3, face.height / 6 },
+        { face.x + face.width * 13 / 24, face.y + face.height / 4, face.width / 3, face.height / 6 }
+    };
+
+    telemetry::Frame frame;
+    frame.index = index;
+    frame.time = time;
+
+    telemetry::Face result;
+    const cv::Rect* rois[3] = { &face, &eyes[0], &eyes[1] };
+    float* fields[3] = { result.roi, result.eyes[0], result.eyes[1] };
+    for (int i = 0; i < 3; i++)
+    {
+        fields[i][0] = rois[i]->x;
+        fields[i][1] = rois[i]->y;
+        fields[i][2] = rois[i]->width;
+        fields[i][3] = rois[i]->height;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        const cv::Point2f center = (eyes[i].tl() + eyes[i].br()) * 0.5f;
+        const float pupil[5] = { center.x, center.y, eyes[i].height / 3.f, eyes[i].height / 3.f, 0.f };
+        std::copy(pupil, pupil + 5, result.pupils[i]);
+    }
+    frame.faces.push_back(result);
+
+    const telemetry::Crop::Kind kinds[3] = { telemetry::Crop::kFace, telemetry::Crop::kEyeRight, telemetry::Crop::kEyeLeft };
+    for (int i = 0; i < 3; i++)
+    {
+        telemetry::Crop crop;
+        crop.kind = kinds[i];
+        cv::imencode(".jpg", image(*rois[i]), crop.data, { cv::IMWRITE_JPEG_QUALITY, quality });
+        frame.crops.push_back(std::move(crop));
+    }
+
+    return frame;
+}
 
 int gauze_main(int argc, char** argv)
 {
@@ -25,6 +74,12 @@ int gauze_main(int argc, char** argv)
     std::string sAddress = "127.0.0.1";
     std::string sPort = "6000";
     std::string sImage;
+    int frames = 0;
+    int quality = 90;
+    float fps = 30.f;
+    telemetry::sender<beast::websocket::stream<boost::asio::ip::tcp::socket&>>::options streaming;
+    int maxBatch = static_cast<int>(streaming.maxBatch);
+    int maxQueue = static_cast<int>(streaming.maxQueue);
 
     // clang-format off
     cxxopts::Options options("test-image-server", "Minimal image logging websocket server (beast)");
@@ -32,6 +87,11 @@ int gauze_main(int argc, char** argv)
         ("a,address", "Address", cxxopts::value<std::string>(sAddress))
         ("p,port", "Port", cxxopts::value<std::string>(sPort))
         ("i,image", "Image", cxxopts::value<std::string>(sImage))
+        ("f,frames", "Stream telemetry batches (results and crops) for this many frames", cxxopts::value<int>(frames))
+        ("fps", "Telemetry frame rate", cxxopts::value<float>(fps))
+        ("quality", "Telemetry crop jpeg quality", cxxopts::value<int>(quality))
+        ("batch", "Maximum frames per telemetry batch", cxxopts::value<int>(maxBatch))
+        ("queue", "Maximum pending telemetry frames (oldest are dropped)", cxxopts::value<int>(maxQueue))
         ("h,help", "Print help message");
     // clang-format on
 
@@ -72,6 +132,30 @@ int gauze_main(int argc, char** argv)
     beast::websocket::stream<boost::asio::ip::tcp::socket&> ws{ sock };
     ws.handshake(sAddress, "/");
 
+    if (frames > 0)
+    {
+        streaming.maxBatch = std::max(maxBatch, 1);
+        streaming.maxQueue = std::max(maxQueue, 1);
+
+        telemetry::sender<beast::websocket::stream<boost::asio::ip::tcp::socket&>> sender(ws, streaming);
+
+        const auto period = std::chrono::duration<double>(1.0 / std::max(fps, 1.f));
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            sender.push(makeFrame(image, i, std::chrono::duration<double>(now - start).count(), quality));
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * (i + 1)));
+        }
+        sender.close();
+
+        std::cout << "frames: " << sender.getSentCount() << " dropped: " << sender.getDroppedCount()
+                  << " batches: " << sender.getBatchCount() << " bytes: " << sender.getByteCount() << std::endl;
+
+        ws.close(beast::websocket::close_code::normal);
+        return 0;
+    }
+
     {
         std::vector<uint8_t> buffer;
         cv::imencode(".png", image, buffer);
@@ -6,6 +6,8 @@
 
 #include "drishti/core/drishti_stdlib_string.h" // must be first!!!
 #include "websocket_async_server.hpp"
+#include "telemetry.hpp"
+#include "drishti/core/AppendSink.h"
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/signal_set.hpp>
 
@@ -19,8 +21,131 @@
 
 #include "cxxopts.hpp"
 
+#include <algorithm>
+#include <condition_variable>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// Decode telemetry batches on a worker pool, results are appended as one fixed column
+// csv row per face and the crops as jpeg entries of a tar archive.
+class telemetry_writer
+{
+public:
+    telemetry_writer(const std::string& directory, std::size_t threads, std::size_t maxPending)
+        : results_(directory + "/results.csv")
+        , crops_(directory + "/crops.tar", drishti::core::AppendSink::kTar)
+        , work_(ios_)
+        , maxPending_(maxPending)
+    {
+        results_.push("frame,time,face,x,y,width,height,"
+                      "right_x,right_y,right_width,right_height,left_x,left_y,left_width,left_height,"
+                      "right_pupil_cx,right_pupil_cy,right_pupil_width,right_pupil_height,right_pupil_angle,"
+                      "left_pupil_cx,left_pupil_cy,left_pupil_width,left_pupil_height,left_pupil_angle");
+        for (std::size_t i = 0; i < threads; i++)
+        {
+            threads_.emplace_back([this] { ios_.run(); });
+        }
+    }
+
+    ~telemetry_writer()
+    {
+        work_ = boost::none;
+        for (auto& t : threads_)
+        {
+            t.join();
+        }
+        results_.close();
+        crops_.close();
+    }
+
+    bool good() const { return results_.good() && crops_.good(); }
+
+    // Blocks while maxPending batches are queued, which delays the acknowledgement (back pressure):
+    void push(std::vector<std::uint8_t> buffer)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [&] { return pending_ < maxPending_; });
+            pending_++;
+        }
+
+        auto batch = std::make_shared<std::vector<std::uint8_t>>(std::move(buffer));
+        ios_.post([this, batch]() {
+            try
+            {
+                write(telemetry::decode(batch->data(), batch->size()));
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_--;
+            }
+            done_.notify_one();
+        });
+    }
+
+private:
+    void write(const std::vector<telemetry::Frame>& frames)
+    {
+        for (const auto& frame : frames)
+        {
+            for (std::size_t i = 0; i < frame.faces.size(); i++)
+            {
+                const auto& face = frame.faces[i];
+
+                std::stringstream ss;
+                ss << frame.index << ',' << std::setprecision(9) << frame.time << ',' << i << std::setprecision(6);
+                for (const auto& value : face.roi)
+                {
+                    ss << ',' << value;
+                }
+                for (const auto& eye : face.eyes)
+                {
+                    for (const auto& value : eye)
+                    {
+                        ss << ',' << value;
+                    }
+                }
+                for (const auto& pupil : face.pupils)
+                {
+                    for (const auto& value : pupil)
+                    {
+                        ss << ',' << value;
+                    }
+                }
+                results_.push(ss.str());
+            }
+
+            for (std::size_t i = 0; i < frame.crops.size(); i++)
+            {
+                const auto& crop = frame.crops[i];
+
+                std::stringstream ss;
+                ss << "frame_" << std::setw(6) << std::setfill('0') << frame.index << "_" << i << "_" << telemetry::toString(crop.kind) << ".jpg";
+                crops_.push(ss.str(), std::string(crop.data.begin(), crop.data.end()));
+            }
+        }
+    }
+
+    drishti::core::AppendSink results_;
+    drishti::core::AppendSink crops_;
+
+    boost::asio::io_service ios_;
+    boost::optional<boost::asio::io_service::work> work_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::size_t pending_ = 0;
+    std::size_t maxPending_ = 0;
+};
 
 /// Block until SIGINT or SIGTERM is received.
 void sig_wait()
@@ -39,6 +164,8 @@ int gauze_main(int argc, char** argv)
     std::string sAddress = "127.0.0.1";
     std::uint16_t port = 6000;
     bool doWindow = false;
+    int threads = 2;
+    int maxPending = 4;
 
     // clang-format off
     cxxopts::Options options("test-image-server", "Minimal image logging websocket server (beast)");
@@ -47,6 +174,8 @@ int gauze_main(int argc, char** argv)
         ("p,port", "Port", cxxopts::value<std::uint16_t>(port))
         ("o,output", "Output directory", cxxopts::value<std::string>(sOutput))
         ("w,window", "Display images in window", cxxopts::value<bool>(doWindow))
+        ("t,threads", "Telemetry decoding threads", cxxopts::value<int>(threads))
+        ("pending", "Maximum pending telemetry batches (back pressure)", cxxopts::value<int>(maxPending))
         ("h,help", "Print help message");
     // clang-format on
 
@@ -75,6 +204,14 @@ int gauze_main(int argc, char** argv)
     pmd.server_enable = true;
     pmd.compLevel = 3;
 
+    // Outlives the server (handler):
+    telemetry_writer writer(sOutput, std::max(threads, 1), std::max(maxPending, 1));
+    if (!writer.good())
+    {
+        std::cerr << "Unable to create the telemetry output in " << sOutput << std::endl;
+        return -1;
+    }
+
     websocket::async_server s1{ &std::cout, 1 };
     s1.set_option(read_message_max{ 64 * 1024 * 1024 });
     s1.set_option(auto_fragment{ false });
@@ -87,6 +224,16 @@ int gauze_main(int argc, char** argv)
     // clang-format off
     websocket::async_server::streambuf_handler handler = [&](beast::streambuf& db)
     {
+        // Binary telemetry batches are copied out of the read buffer and decoded on the workers:
+        std::uint8_t magic[sizeof(telemetry::kMagic)];
+        if (telemetry::isBatch(magic, boost::asio::buffer_copy(boost::asio::buffer(magic), db.data())))
+        {
+            std::vector<std::uint8_t> buffer(db.size());
+            boost::asio::buffer_copy(boost::asio::buffer(buffer), db.data());
+            writer.push(std::move(buffer));
+            return 0;
+        }
+
         std::stringstream ss;
         ss << sOutput << "/frame_" << std::setw(4) << std::setfill('0') << counter++ << ".png";
 
@@ -0,0 +1,213 @@
+//
+// Binary telemetry batches for the websocket image server/client.
+//
+// A batch is one binary websocket message:
+//
+//   header: magic (uint32), version (uint16), frame count (uint16)
+//   frame:  index (uint32), time (double), face count (uint8), crop count (uint8)
+//           face: roi[4], eyes[2][4], pupils[2][5] (float)
+//           crop: kind (uint8), size (uint32), encoded image bytes
+//
+// Values are stored in host (little endian) byte order, the device and the
+// dashboard hosts of the field trials are all little endian.
+//
+
+#ifndef WEBSOCKET_TELEMETRY_HPP
+#define WEBSOCKET_TELEMETRY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace telemetry
+{
+
+static const std::uint32_t kMagic = 0x4d545244; // "DRTM"
+static const std::uint16_t kVersion = 1;
+
+struct Face
+{
+    float roi[4] = {};       // x, y, width, height
+    float eyes[2][4] = {};   // right, left eye roi
+    float pupils[2][5] = {}; // right, left pupil (cx, cy, width, height, angle)
+};
+
+struct Crop
+{
+    enum Kind : std::uint8_t
+    {
+        kFace,
+        kEyeRight,
+        kEyeLeft
+    };
+
+    Kind kind = kFace;
+    std::vector<std::uint8_t> data; // encoded (jpeg) image
+};
+
+struct Frame
+{
+    std::uint32_t index = 0;
+    double time = 0.0;
+    std::vector<Face> faces;
+    std::vector<Crop> crops;
+};
+
+inline bool isBatch(const std::uint8_t* data, std::size_t size)
+{
+    std::uint32_t magic = 0;
+    return (size >= sizeof(magic)) && (std::memcpy(&magic, data, sizeof(magic)), magic == kMagic);
+}
+
+class Writer
+{
+public:
+    explicit Writer(std::vector<std::uint8_t>& buffer)
+        : buffer_(buffer)
+    {
+    }
+
+    template <typename T>
+    void put(const T& value)
+    {
+        put(&value, sizeof(value));
+    }
+
+    void put(const void* data, std::size_t size)
+    {
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+private:
+    std::vector<std::uint8_t>& buffer_;
+};
+
+class Reader
+{
+public:
+    Reader(const std::uint8_t* data, std::size_t size)
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    template <typename T>
+    T get()
+    {
+        T value;
+        get(&value, sizeof(value));
+        return value;
+    }
+
+    void get(void* data, std::size_t size)
+    {
+        if (size > (size_ - offset_))
+        {
+            throw std::runtime_error("telemetry: truncated batch");
+        }
+        std::memcpy(data, data_ + offset_, size);
+        offset_ += size;
+    }
+
+    std::size_t remaining() const { return size_ - offset_; }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t offset_ = 0;
+};
+
+inline void encode(const std::vector<Frame>& frames, std::vector<std::uint8_t>& buffer)
+{
+    if (frames.size() > 0xffff)
+    {
+        throw std::runtime_error("telemetry: too many frames in batch");
+    }
+
+    Writer writer(buffer);
+    writer.put(kMagic);
+    writer.put(kVersion);
+    writer.put(static_cast<std::uint16_t>(frames.size()));
+    for (const auto& frame : frames)
+    {
+        if ((frame.faces.size() > 0xff) || (frame.crops.size() > 0xff))
+        {
+            throw std::runtime_error("telemetry: too many faces or crops in frame");
+        }
+
+        writer.put(frame.index);
+        writer.put(frame.time);
+        writer.put(static_cast<std::uint8_t>(frame.faces.size()));
+        writer.put(static_cast<std::uint8_t>(frame.crops.size()));
+        for (const auto& face : frame.faces)
+        {
+            writer.put(face); // POD floats
+        }
+        for (const auto& crop : frame.crops)
+        {
+            writer.put(static_cast<std::uint8_t>(crop.kind));
+            writer.put(static_cast<std::uint32_t>(crop.data.size()));
+            writer.put(crop.data.data(), crop.data.size());
+        }
+    }
+}
+
+inline std::vector<Frame> decode(const std::uint8_t* data, std::size_t size)
+{
+    Reader reader(data, size);
+    if (reader.get<std::uint32_t>() != kMagic)
+    {
+        throw std::runtime_error("telemetry: not a telemetry batch");
+    }
+    if (reader.get<std::uint16_t>() != kVersion)
+    {
+        throw std::runtime_error("telemetry: unsupported batch version");
+    }
+
+    std::vector<Frame> frames(reader.get<std::uint16_t>());
+    for (auto& frame : frames)
+    {
+        frame.index = reader.get<std::uint32_t>();
+        frame.time = reader.get<double>();
+        frame.faces.resize(reader.get<std::uint8_t>());
+        frame.crops.resize(reader.get<std::uint8_t>());
+        for (auto& face : frame.faces)
+        {
+            face = reader.get<Face>();
+        }
+        for (auto& crop : frame.crops)
+        {
+            crop.kind = static_cast<Crop::Kind>(reader.get<std::uint8_t>());
+            const auto length = reader.get<std::uint32_t>();
+            if (length > reader.remaining())
+            {
+                throw std::runtime_error("telemetry: truncated batch");
+            }
+            crop.data.resize(length);
+            reader.get(crop.data.data(), crop.data.size());
+        }
+    }
+
+    return frames;
+}
+
+inline const char* toString(Crop::Kind kind)
+{
+    switch (kind)
+    {
+        case Crop::kFace:
+            return "face";
+        case Crop::kEyeRight:
+            return "eye_right";
+        case Crop::kEyeLeft:
+            return "eye_left";
+    }
+    return "unknown";
+}
+
+} // telemetry
+
+#endif
@@ -0,0 +1,168 @@
+//
+// Batching telemetry sender for a beast websocket stream.
+//
+// Producers push() frames without blocking; a sender thread collects up to
+// maxBatch frames (or whatever arrived within maxDelay), encodes them as one
+// binary message and waits for the server acknowledgement before sending the
+// next batch.  At most one batch is in flight, so a slow link or a busy server
+// shows up as a growing queue, which is bounded: when maxQueue frames are
+// pending the oldest one is dropped (live dashboards want the newest data).
+//
+
+#ifndef WEBSOCKET_TELEMETRY_SENDER_HPP
+#define WEBSOCKET_TELEMETRY_SENDER_HPP
+
+#include "telemetry.hpp"
+
+#include <beast/core/streambuf.hpp>
+#include <beast/websocket.hpp>
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace telemetry
+{
+
+template <class Stream>
+class sender
+{
+public:
+    struct options
+    {
+        std::size_t maxBatch = 8;
+        std::size_t maxQueue = 32;
+        std::chrono::milliseconds maxDelay{ 100 };
+    };
+
+    sender(Stream& ws, const options& opts)
+        : ws_(ws)
+        , opts_(opts)
+        , thread_([this] { run(); })
+    {
+    }
+
+    sender(sender const&) = delete;
+    sender& operator=(sender const&) = delete;
+
+    ~sender()
+    {
+        close();
+    }
+
+    void push(Frame frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.size() >= opts_.maxQueue)
+            {
+                queue_.pop_front();
+                dropped_++;
+            }
+            queue_.push_back(std::move(frame));
+        }
+        pushed_.notify_one();
+    }
+
+    // Send the remaining frames and stop, rethrows a websocket error from the sender thread:
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        pushed_.notify_one();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+        if (error_)
+        {
+            auto error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::size_t getSentCount() const { return sent_; }
+    std::size_t getBatchCount() const { return batches_; }
+    std::size_t getByteCount() const { return bytes_; }
+    std::size_t getDroppedCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+private:
+    void run()
+    {
+        try
+        {
+            std::vector<Frame> batch;
+            std::vector<std::uint8_t> buffer;
+            while (take(batch))
+            {
+                buffer.clear();
+                encode(batch, buffer);
+
+                ws_.set_option(beast::websocket::message_type{ beast::websocket::opcode::binary });
+                ws_.write(boost::asio::buffer(buffer));
+
+                // Wait for the acknowledgement (back pressure):
+                beast::streambuf sb;
+                beast::websocket::opcode op;
+                ws_.read(op, sb);
+
+                sent_ += batch.size();
+                bytes_ += buffer.size();
+                batches_++;
+            }
+        }
+        catch (...)
+        {
+            error_ = std::current_exception();
+        }
+    }
+
+    // Take up to maxBatch frames, waiting at most maxDelay for a partial batch to fill:
+    bool take(std::vector<Frame>& batch)
+    {
+        batch.clear();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        pushed_.wait(lock, [&] { return done_ || !queue_.empty(); });
+        pushed_.wait_for(lock, opts_.maxDelay, [&] { return done_ || (queue_.size() >= opts_.maxBatch); });
+
+        while (!queue_.empty() && (batch.size() < opts_.maxBatch))
+        {
+            batch.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+
+        return !batch.empty();
+    }
+
+    Stream& ws_;
+    options opts_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable pushed_;
+    std::deque<Frame> queue_;
+    std::size_t dropped_ = 0;
+    bool done_ = false;
+
+    std::size_t sent_ = 0; // sender thread
+    std::size_t batches_ = 0;
+    std::size_t bytes_ = 0;
+    std::exception_ptr error_;
+
+    std::thread thread_; // last
+};
+
+} // telemetry
+
+#endif